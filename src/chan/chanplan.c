@@ -0,0 +1,606 @@
+/*
+ * IQ Lab - chanplan.c: Non-Uniform Channel Plans
+ *
+ * Purpose: Plan parsing, the greedy choice between shared banks and
+ * per-channel decimators, and the runner that feeds every realization
+ * the same input blocks.
+ *
+ * Date: 2025
+ */
+
+#include "chanplan.h"
+#include "../jobs/yaml_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+// Fine resampler filter, as resample_iq_init plans it
+#define CHANPLAN_RESAMPLE_LENGTH 32
+#define CHANPLAN_RESAMPLE_CUTOFF 0.4f
+
+// Farrow interpolator: multiply-adds per output and rail
+#define CHANPLAN_FARROW_MACS 12.0
+
+// Fine resampler of one channel
+typedef enum {
+    FINE_NONE = 0,               // Stage rate is the output rate
+    FINE_POLYPHASE,
+    FINE_FARROW
+} fine_kind_t;
+
+// Filters behind one channel
+typedef struct {
+    nco_t nco;                   // PFB: moves the residual offset to DC
+    xlate_t xlate;               // XLATE: translating decimator
+    bool have_xlate;
+    fine_kind_t fine;
+    resample_t resampler;        // FINE_POLYPHASE
+    resample_farrow_t farrow;    // FINE_FARROW
+    float *stage;                // Stage-rate samples, interleaved
+    float *output;               // Output-rate samples, interleaved
+    uint32_t output_capacity;    // Samples
+} chanplan_stage_t;
+
+struct chanplan_runner_t {
+    const chanplan_t *plan;
+    pfb_t **banks;               // One per plan bank
+    chanplan_stage_t *stages;    // One per channel
+};
+
+static bool plan_fail(char *error, size_t error_size, const char *format, ...) {
+    if (error && error_size > 0) {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(error, error_size, format, args);
+        va_end(args);
+    }
+    return false;
+}
+
+static bool span_is(yaml_span_t span, const char *word) {
+    return span.length == strlen(word) && strncmp(span.start, word, span.length) == 0;
+}
+
+// A number with an optional k, M or G suffix
+static bool parse_number(yaml_span_t span, double *value) {
+    char text[64];
+    if (span.length == 0 || span.length >= sizeof(text)) return false;
+    memcpy(text, span.start, span.length);
+    text[span.length] = '\0';
+
+    char *end;
+    double v = strtod(text, &end);
+    if (end == text) return false;
+    switch (*end) {
+        case 'k': case 'K': v *= 1e3; end++; break;
+        case 'M': v *= 1e6; end++; break;
+        case 'G': v *= 1e9; end++; break;
+        default: break;
+    }
+    if (*end != '\0' || !isfinite(v)) return false;
+    *value = v;
+    return true;
+}
+
+// A rate that is a whole number of Hz, as the polyphase resampler needs
+static bool whole_hz(double rate, uint32_t *hz) {
+    double rounded = nearbyint(rate);
+    if (rounded < 1.0 || rounded > (double)UINT32_MAX || fabs(rate - rounded) > 1e-6 * rounded) {
+        return false;
+    }
+    *hz = (uint32_t)rounded;
+    return true;
+}
+
+// Set one key of an entry
+static bool set_field(chanplan_channel_t *channel, const yaml_token_t *key, const yaml_token_t *value,
+                      char *error, size_t error_size) {
+    if (value->type != YAML_TOKEN_SCALAR) {
+        return plan_fail(error, error_size, "Line %u: '%.*s' needs a value", key->line,
+                         (int)key->text.length, key->text.start);
+    }
+    if (span_is(key->text, "name")) {
+        size_t length = value->text.length < CHANPLAN_NAME_LENGTH - 1 ? value->text.length
+                                                                      : CHANPLAN_NAME_LENGTH - 1;
+        memcpy(channel->name, value->text.start, length);
+        channel->name[length] = '\0';
+        return true;
+    }
+
+    double number;
+    if (!parse_number(value->text, &number)) {
+        return plan_fail(error, error_size, "Line %u: '%.*s' is not a number", value->line,
+                         (int)value->text.length, value->text.start);
+    }
+    if (span_is(key->text, "center")) {
+        channel->center = number;
+    } else if (span_is(key->text, "bandwidth") && number > 0.0) {
+        channel->bandwidth = number;
+    } else if (span_is(key->text, "rate") && number >= 1.0 && number <= (double)UINT32_MAX) {
+        channel->rate = (uint32_t)ceil(number);
+    } else if (span_is(key->text, "bandwidth") || span_is(key->text, "rate")) {
+        return plan_fail(error, error_size, "Line %u: '%.*s' must be positive", key->line,
+                         (int)key->text.length, key->text.start);
+    } else {
+        return plan_fail(error, error_size, "Line %u: unknown channel key '%.*s'", key->line,
+                         (int)key->text.length, key->text.start);
+    }
+    return true;
+}
+
+// One "- ..." entry, flow or block; leaves token at the one after it
+static bool parse_entry(chanplan_t *plan, yaml_tokenizer_t *tokenizer, yaml_token_t *token,
+                        uint32_t *capacity, char *error, size_t error_size) {
+    const uint32_t line = token->line;
+    if (plan->num_channels == CHANPLAN_MAX_CHANNELS) {
+        return plan_fail(error, error_size, "Line %u: more than %d channels", line, CHANPLAN_MAX_CHANNELS);
+    }
+    if (plan->num_channels == *capacity) {
+        uint32_t grown = *capacity ? *capacity * 2 : 16;
+        chanplan_channel_t *channels = realloc(plan->channels, grown * sizeof(*channels));
+        if (!channels) return plan_fail(error, error_size, "Out of memory");
+        plan->channels = channels;
+        *capacity = grown;
+    }
+    chanplan_channel_t *channel = &plan->channels[plan->num_channels];
+    memset(channel, 0, sizeof(*channel));
+    channel->center = NAN;
+
+    yaml_token_t key;
+    yaml_next_token(tokenizer, token);
+    if (token->type == YAML_TOKEN_FLOW_START) {
+        yaml_next_token(tokenizer, token);
+        while (token->type != YAML_TOKEN_FLOW_END) {
+            if (token->type != YAML_TOKEN_KEY) {
+                return plan_fail(error, error_size, "Line %u: expected 'key: value' in the entry", token->line);
+            }
+            key = *token;
+            yaml_next_token(tokenizer, token);
+            if (!set_field(channel, &key, token, error, error_size)) return false;
+            yaml_next_token(tokenizer, token);
+            if (token->type == YAML_TOKEN_COMMA) {
+                yaml_next_token(tokenizer, token);
+            } else if (token->type != YAML_TOKEN_FLOW_END) {
+                return plan_fail(error, error_size, "Line %u: expected ',' or '}'", token->line);
+            }
+        }
+        yaml_next_token(tokenizer, token);
+    } else if (token->type == YAML_TOKEN_KEY && token->line == line) {
+        // Block mapping: keys at the column of the first one
+        const uint32_t column = token->column;
+        while (token->type == YAML_TOKEN_KEY && token->column == column) {
+            key = *token;
+            yaml_next_token(tokenizer, token);
+            if (!set_field(channel, &key, token, error, error_size)) return false;
+            yaml_next_token(tokenizer, token);
+        }
+    } else {
+        return plan_fail(error, error_size, "Line %u: a channel entry needs center and bandwidth", line);
+    }
+
+    if (isnan(channel->center) || channel->bandwidth <= 0.0) {
+        return plan_fail(error, error_size, "Line %u: a channel entry needs center and bandwidth", line);
+    }
+    if (channel->rate == 0) {
+        channel->rate = (uint32_t)ceil(channel->bandwidth / CHANPLAN_USABLE - 1e-6);
+    } else if (channel->rate < channel->bandwidth) {
+        return plan_fail(error, error_size, "Line %u: rate %u Hz is below the bandwidth", line,
+                         channel->rate);
+    }
+    plan->num_channels++;
+    return true;
+}
+
+/**
+ * @brief Parse a plan from YAML text
+ */
+bool chanplan_parse(chanplan_t *plan, const char *text, size_t length, char *error,
+                    size_t error_size) {
+    if (!plan || !text) return plan_fail(error, error_size, "No plan");
+    memset(plan, 0, sizeof(*plan));
+
+    yaml_tokenizer_t tokenizer;
+    yaml_token_t token;
+    yaml_tokenizer_init(&tokenizer, text, length);
+    yaml_next_token(&tokenizer, &token);
+
+    uint32_t capacity = 0;
+    bool ok = true;
+    while (ok && token.type != YAML_TOKEN_END) {
+        if (token.type == YAML_TOKEN_ENTRY) {
+            ok = parse_entry(plan, &tokenizer, &token, &capacity, error, error_size);
+        } else if (token.type == YAML_TOKEN_KEY && token.column == 0 && span_is(token.text, "channels")) {
+            yaml_next_token(&tokenizer, &token);
+        } else if (token.type == YAML_TOKEN_KEY && token.column == 0 &&
+                   span_is(token.text, "center_frequency")) {
+            yaml_next_token(&tokenizer, &token);
+            ok = token.type == YAML_TOKEN_SCALAR && parse_number(token.text, &plan->center_frequency);
+            if (!ok) plan_fail(error, error_size, "Line %u: center_frequency needs a number", token.line);
+            yaml_next_token(&tokenizer, &token);
+        } else if (token.type == YAML_TOKEN_ERROR) {
+            ok = plan_fail(error, error_size, "Line %u: %s", token.line, tokenizer.error);
+        } else {
+            ok = plan_fail(error, error_size, "Line %u: expected 'channels:', 'center_frequency:' or a '-' entry",
+                           token.line);
+        }
+    }
+    if (ok && plan->num_channels == 0) {
+        ok = plan_fail(error, error_size, "The plan has no channels");
+    }
+
+    // RF centers become offsets from the capture center
+    for (uint32_t i = 0; ok && plan->center_frequency != 0.0 && i < plan->num_channels; i++) {
+        plan->channels[i].center -= plan->center_frequency;
+    }
+    if (!ok) chanplan_free(plan);
+    return ok;
+}
+
+/**
+ * @brief Load a plan from a YAML file
+ */
+bool chanplan_load(chanplan_t *plan, const char *path, char *error, size_t error_size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return plan_fail(error, error_size, "Cannot open channel plan '%s'", path);
+
+    char *text = NULL;
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        text = malloc((size_t)size + 1);
+    }
+    bool ok = text && fread(text, 1, (size_t)size, f) == (size_t)size;
+    fclose(f);
+    if (!ok) {
+        free(text);
+        return plan_fail(error, error_size, "Cannot read channel plan '%s'", path);
+    }
+
+    text[size] = '\0';
+    ok = chanplan_parse(plan, text, (size_t)size, error, error_size);
+    free(text);
+    return ok;
+}
+
+/**
+ * @brief Free a plan's channels and banks
+ */
+void chanplan_free(chanplan_t *plan) {
+    if (!plan) return;
+    free(plan->channels);
+    free(plan->banks);
+    memset(plan, 0, sizeof(*plan));
+}
+
+// Fine resampler from stage_rate to rate: multiply-adds per stage sample, both rails
+static double fine_cost(double stage_rate, uint32_t rate) {
+    if (fabs(stage_rate - rate) < 1e-6) return 0.0;
+
+    uint32_t input_rate;
+    resample_plan_t plan;
+    if (whole_hz(stage_rate, &input_rate) &&
+        resample_plan(&plan, input_rate, rate, CHANPLAN_RESAMPLE_LENGTH, CHANPLAN_RESAMPLE_CUTOFF)) {
+        return 2.0 * plan.macs_per_input;
+    }
+    return 2.0 * CHANPLAN_FARROW_MACS * rate / stage_rate;
+}
+
+/**
+ * @brief Cost of a channel on its own translating decimator
+ */
+double chanplan_xlate_cost(const chanplan_channel_t *channel, double sample_rate,
+                           uint32_t *decimation) {
+    if (!channel || sample_rate <= 0.0) return -1.0;
+
+    // The largest factor whose output still holds the channel, or one a
+    // little smaller that divides the input rate (a whole-Hz stage rate)
+    double needed = fmax(channel->rate, channel->bandwidth / CHANPLAN_USABLE);
+    if (needed > sample_rate) return -1.0;
+    uint32_t factor = (uint32_t)floor(sample_rate / needed);
+    uint32_t input_rate;
+    if (whole_hz(sample_rate, &input_rate)) {
+        for (uint32_t d = factor; d > 1 && 2 * d > factor; d--) {
+            if (input_rate % d == 0) {
+                factor = d;
+                break;
+            }
+        }
+    }
+
+    double cost = 4.0;  // The complex mix
+    if (factor > 1) {
+        decim_plan_t plan;
+        decim_plan_factor(&plan, factor);
+        double macs = decim_plan_macs(&plan, channel->bandwidth / 2.0 / sample_rate);
+        if (macs < 0.0) return -1.0;
+        cost += 2.0 * macs;
+    }
+    cost += fine_cost(sample_rate / factor, channel->rate) / factor;
+
+    if (decimation) *decimation = factor;
+    return cost;
+}
+
+// A plan bank of num_bins bins: 2x oversampled, CHANPLAN_BRANCH_TAPS per branch.
+// The prototype cuts off at 0.75 spacings; its transition band, about
+// 5.4 / CHANPLAN_BRANCH_TAPS spacings for the Kaiser beta, ends before the
+// bin rate folds it back inside CHANPLAN_BIN_REACH
+static bool bank_config(pfb_config_t *config, uint32_t num_bins, double sample_rate) {
+    double spacing = sample_rate / num_bins;
+    if (!pfb_config_init(config, num_bins, sample_rate, CHANPLAN_BIN_PASSBAND * spacing)) return false;
+    config->oversampling = 2;
+    config->filter_length = num_bins * CHANPLAN_BRANCH_TAPS;
+    return pfb_config_validate(config);
+}
+
+// The nearest bin, if the channel lies within its reach
+static bool bank_bin(const chanplan_channel_t *channel, uint32_t num_bins, double sample_rate,
+                     uint32_t *bin, double *residual) {
+    double spacing = sample_rate / num_bins;
+    double k = nearbyint(channel->center / spacing);
+    double offset = channel->center - k * spacing;
+    if (fabs(offset) + channel->bandwidth / 2.0 > CHANPLAN_BIN_REACH * spacing) return false;
+
+    // Bin i is centered on (i - M/2) * spacing
+    int64_t index = ((int64_t)k + num_bins / 2) % (int64_t)num_bins;
+    *bin = (uint32_t)(index < 0 ? index + num_bins : index);
+    *residual = offset;
+    return true;
+}
+
+// A bank member's own cost: residual mix and fine resampler at the bin rate
+static double member_cost(const chanplan_channel_t *channel, uint32_t num_bins, double sample_rate) {
+    double bin_rate = 2.0 * sample_rate / num_bins;
+    return (4.0 + fine_cost(bin_rate, channel->rate)) * bin_rate / sample_rate;
+}
+
+/**
+ * @brief Choose a realization for every channel at an input rate
+ */
+bool chanplan_design(chanplan_t *plan, double sample_rate, char *error, size_t error_size) {
+    if (!plan || plan->num_channels == 0 || sample_rate <= 0.0) {
+        return plan_fail(error, error_size, "Empty plan or invalid sample rate");
+    }
+
+    free(plan->banks);
+    plan->banks = (chanplan_bank_t *)calloc(plan->num_channels, sizeof(chanplan_bank_t));
+    plan->num_banks = 0;
+    plan->sample_rate = sample_rate;
+    if (!plan->banks) return plan_fail(error, error_size, "Out of memory");
+
+    // Every channel on its own decimator first
+    plan->individual_cost = 0.0;
+    for (uint32_t i = 0; i < plan->num_channels; i++) {
+        chanplan_channel_t *channel = &plan->channels[i];
+        if (fabs(channel->center) + channel->bandwidth / 2.0 > sample_rate / 2.0) {
+            return plan_fail(error, error_size,
+                             "Channel %u (%.0f Hz wide at %+.0f Hz) lies outside the %.0f Hz capture",
+                             i, channel->bandwidth, channel->center, sample_rate);
+        }
+        channel->path = CHANPLAN_XLATE;
+        channel->residual = 0.0;
+        channel->cost = chanplan_xlate_cost(channel, sample_rate, &channel->decimation);
+        if (channel->cost < 0.0) {
+            return plan_fail(error, error_size, "Channel %u needs a rate above the input rate", i);
+        }
+        channel->stage_rate = sample_rate / channel->decimation;
+        plan->individual_cost += channel->cost;
+    }
+
+    // Add the bank that saves the most while one saves anything
+    for (;;) {
+        double best_saving = 0.0;
+        uint32_t best_bins = 0;
+        pfb_config_t best_config = {0};
+        for (uint32_t bins = PFB_MIN_CHANNELS; bins <= PFB_MAX_CHANNELS; bins *= 2) {
+            pfb_config_t config;
+            if (!bank_config(&config, bins, sample_rate)) continue;
+
+            double saving = -pfb_estimate_cost(&config);
+            for (uint32_t i = 0; i < plan->num_channels; i++) {
+                const chanplan_channel_t *channel = &plan->channels[i];
+                uint32_t bin;
+                double residual;
+                if (channel->path == CHANPLAN_XLATE &&
+                    bank_bin(channel, bins, sample_rate, &bin, &residual)) {
+                    saving += fmax(0.0, channel->cost - member_cost(channel, bins, sample_rate));
+                }
+            }
+            if (saving > best_saving) {
+                best_saving = saving;
+                best_bins = bins;
+                best_config = config;
+            }
+        }
+        if (best_bins == 0) break;
+
+        chanplan_bank_t *bank = &plan->banks[plan->num_banks];
+        bank->config = best_config;
+        bank->cost = pfb_estimate_cost(&best_config);
+        bank->num_members = 0;
+        for (uint32_t i = 0; i < plan->num_channels; i++) {
+            chanplan_channel_t *channel = &plan->channels[i];
+            uint32_t bin;
+            double residual;
+            if (channel->path != CHANPLAN_XLATE ||
+                !bank_bin(channel, best_bins, sample_rate, &bin, &residual)) {
+                continue;
+            }
+            double cost = member_cost(channel, best_bins, sample_rate);
+            if (cost >= channel->cost) continue;
+
+            channel->path = CHANPLAN_PFB;
+            channel->bank = plan->num_banks;
+            channel->bin = bin;
+            channel->residual = residual;
+            channel->decimation = 0;
+            channel->stage_rate = 2.0 * sample_rate / best_bins;
+            channel->cost = cost;
+            bank->num_members++;
+        }
+        plan->num_banks++;
+    }
+
+    plan->total_cost = 0.0;
+    for (uint32_t i = 0; i < plan->num_channels; i++) plan->total_cost += plan->channels[i].cost;
+    for (uint32_t b = 0; b < plan->num_banks; b++) plan->total_cost += plan->banks[b].cost;
+    return true;
+}
+
+/**
+ * @brief Destroy a runner
+ */
+void chanplan_runner_destroy(chanplan_runner_t *runner) {
+    if (!runner) return;
+
+    for (uint32_t b = 0; runner->banks && b < runner->plan->num_banks; b++) {
+        pfb_destroy(runner->banks[b]);
+    }
+    for (uint32_t i = 0; runner->stages && i < runner->plan->num_channels; i++) {
+        chanplan_stage_t *stage = &runner->stages[i];
+        if (stage->have_xlate) xlate_free(&stage->xlate);
+        if (stage->fine == FINE_POLYPHASE) resample_free(&stage->resampler);
+        free(stage->stage);
+        free(stage->output);
+    }
+    free(runner->banks);
+    free(runner->stages);
+    free(runner);
+}
+
+/**
+ * @brief Create the filters of a designed plan
+ */
+chanplan_runner_t *chanplan_runner_create(const chanplan_t *plan) {
+    if (!plan || plan->num_channels == 0 || plan->sample_rate <= 0.0) return NULL;
+
+    chanplan_runner_t *runner = (chanplan_runner_t *)calloc(1, sizeof(chanplan_runner_t));
+    if (!runner) return NULL;
+    runner->plan = plan;
+    runner->banks = (pfb_t **)calloc(plan->num_banks ? plan->num_banks : 1, sizeof(pfb_t *));
+    runner->stages = (chanplan_stage_t *)calloc(plan->num_channels, sizeof(chanplan_stage_t));
+    bool ok = runner->banks && runner->stages;
+
+    for (uint32_t b = 0; ok && b < plan->num_banks; b++) {
+        runner->banks[b] = pfb_create(&plan->banks[b].config);
+        ok = runner->banks[b] != NULL;
+    }
+
+    for (uint32_t i = 0; ok && i < plan->num_channels; i++) {
+        const chanplan_channel_t *channel = &plan->channels[i];
+        chanplan_stage_t *stage = &runner->stages[i];
+
+        // Stage samples per call: a decimated chunk, or a whole bin ring
+        uint32_t capacity;
+        if (channel->path == CHANPLAN_PFB) {
+            nco_init(&stage->nco, -channel->residual, channel->stage_rate);
+            capacity = plan->banks[channel->bank].config.block_size;
+        } else {
+            ok = xlate_init(&stage->xlate, plan->sample_rate, channel->center, channel->decimation,
+                            channel->bandwidth);
+            stage->have_xlate = ok;
+            capacity = CHANPLAN_CHUNK / channel->decimation + 2;
+        }
+
+        uint32_t input_rate;
+        if (fabs(channel->stage_rate - channel->rate) < 1e-6) {
+            stage->fine = FINE_NONE;
+        } else if (whole_hz(channel->stage_rate, &input_rate) &&
+                   resample_iq_init(&stage->resampler, input_rate, channel->rate)) {
+            stage->fine = FINE_POLYPHASE;
+        } else {
+            stage->fine = FINE_FARROW;
+            ok = ok && resample_farrow_init(&stage->farrow, channel->stage_rate, channel->rate, 2);
+        }
+
+        stage->output_capacity = (uint32_t)ceil(capacity * channel->rate / channel->stage_rate) + 8;
+        stage->stage = (float *)malloc(2 * (size_t)capacity * sizeof(float));
+        stage->output = (float *)malloc(2 * (size_t)stage->output_capacity * sizeof(float));
+        ok = ok && stage->stage && stage->output;
+    }
+
+    if (!ok) {
+        chanplan_runner_destroy(runner);
+        return NULL;
+    }
+    return runner;
+}
+
+// Resample count stage samples of a channel and hand them to the sink
+static bool emit(chanplan_runner_t *runner, uint32_t index, uint32_t count, chanplan_sink_t sink,
+                 void *user) {
+    chanplan_stage_t *stage = &runner->stages[index];
+    if (count == 0) return true;
+
+    const float *samples = stage->stage;
+    uint32_t produced = count;
+    if (stage->fine == FINE_POLYPHASE) {
+        if (!resample_iq_process_buffer(&stage->resampler, stage->stage, count, stage->output,
+                                        stage->output_capacity, &produced)) {
+            return false;
+        }
+        samples = stage->output;
+    } else if (stage->fine == FINE_FARROW) {
+        if (!resample_farrow_process(&stage->farrow, stage->stage, count, stage->output,
+                                     stage->output_capacity, &produced)) {
+            return false;
+        }
+        samples = stage->output;
+    }
+    return produced == 0 || sink(index, (const float complex *)samples, produced, user);
+}
+
+// Pass every member's bin outputs on, then free all the bank's rings
+static bool drain_bank(chanplan_runner_t *runner, uint32_t b, chanplan_sink_t sink, void *user) {
+    const chanplan_t *plan = runner->plan;
+    pfb_t *pfb = runner->banks[b];
+
+    for (uint32_t i = 0; i < plan->num_channels; i++) {
+        const chanplan_channel_t *channel = &plan->channels[i];
+        if (channel->path != CHANPLAN_PFB || channel->bank != b) continue;
+
+        uint32_t count;
+        const float complex *span = pfb_channel_read(pfb, channel->bin, &count);
+        if (!span || count == 0) continue;
+        nco_mix(&runner->stages[i].nco, (const float *)span, runner->stages[i].stage, count);
+        if (!emit(runner, i, count, sink, user)) return false;
+    }
+
+    // Several members may share a bin; nobody reads the others
+    for (uint32_t bin = 0; bin < pfb->num_channels; bin++) {
+        pfb_reset_channel_output(pfb, bin);
+    }
+    return true;
+}
+
+/**
+ * @brief Channelize a block of input
+ */
+bool chanplan_runner_process(chanplan_runner_t *runner, const float complex *input, uint32_t count,
+                             chanplan_sink_t sink, void *user) {
+    if (!runner || !input || !sink) return false;
+    const chanplan_t *plan = runner->plan;
+
+    // Individual decimators, a chunk at a time
+    for (uint32_t i = 0; i < plan->num_channels; i++) {
+        if (plan->channels[i].path != CHANPLAN_XLATE) continue;
+        for (uint32_t offset = 0; offset < count; offset += CHANPLAN_CHUNK) {
+            uint32_t n = count - offset < CHANPLAN_CHUNK ? count - offset : CHANPLAN_CHUNK;
+            size_t produced = xlate_process(&runner->stages[i].xlate, (const float *)(input + offset), n,
+                                            runner->stages[i].stage);
+            if (!emit(runner, i, (uint32_t)produced, sink, user)) return false;
+        }
+    }
+
+    // Banks pause when a ring fills: drain and feed the rest
+    for (uint32_t b = 0; b < plan->num_banks; b++) {
+        for (uint32_t offset = 0; offset < count; ) {
+            int32_t used = pfb_process_block(runner->banks[b], input + offset, count - offset);
+            if (used < 0) return false;
+            offset += (uint32_t)used;
+            if (!drain_bank(runner, b, sink, user)) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,208 @@
+/*
+ * IQ Lab - chanplan.h: Non-Uniform Channel Plans
+ *
+ * Purpose: Extracts an arbitrary list of channels (any center, bandwidth
+ * and output rate) from a wideband capture, choosing the cheapest mix of
+ * shared filter banks and per-channel decimators for the plan.
+ *
+ * Date: 2025
+ *
+ * Plan file (YAML, parsed with the jobs tokenizer, yaml_parse.h):
+ *
+ *   center_frequency: 851.0e6     # Optional: centers below are RF
+ *   channels:
+ *     - { name: dispatch, center: 851.0125e6, bandwidth: 12.5e3 }
+ *     - center: 851.2e6
+ *       bandwidth: 200e3
+ *       rate: 250e3                # Optional output rate
+ *
+ * Without center_frequency the centers are offsets from the capture
+ * center. A bare list of entries (no "channels:" key) is accepted too.
+ * Numbers may end in k, M or G. The output rate defaults to
+ * bandwidth / CHANPLAN_USABLE, rounded up to a whole Hz.
+ *
+ * Realizations (chanplan_design):
+ * - A PFB bank: M bins of fs / M, 2x oversampled, with CHANPLAN_BRANCH_TAPS
+ *   taps per branch and a prototype CHANPLAN_BIN_PASSBAND bin spacings
+ *   wide, so every bin output (at 2 fs / M) is alias free out to
+ *   CHANPLAN_BIN_REACH spacings either side of its center. A channel joins
+ *   a bank when it lies within that reach of its nearest bin, wherever it
+ *   falls between bin centers; the bin output is shifted by the residual
+ *   offset (nco.h) and resampled to the channel's rate
+ * - An individual translating decimator (xlate.h): D chosen so fs / D
+ *   covers the channel, preferring a D that divides fs, then the same fine
+ *   resampler
+ * The fine resampler is the polyphase one (resample.h) when both rates
+ * are whole Hz, else the Farrow interpolator.
+ *
+ * Every channel starts on its own decimator; banks are then added
+ * greedily, each time the one (bin count) that saves the most multiply-
+ * adds per input sample over the channels it can take, until no bank
+ * saves anything. Uniform groups thus end up on a bank while outliers
+ * keep their decimators, and small groups stay individual when that is
+ * cheaper. Costs are estimated like pfb_estimate_cost: real multiply-adds
+ * per input sample.
+ */
+
+#ifndef CHANPLAN_H
+#define CHANPLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <complex.h>
+#include "pfb.h"
+#include "../iq_core/nco.h"
+#include "../iq_core/xlate.h"
+#include "../iq_core/resample.h"
+
+#define CHANPLAN_MAX_CHANNELS 4096
+#define CHANPLAN_NAME_LENGTH 64
+#define CHANPLAN_USABLE 0.8          // Share of a bin or output rate a channel may fill
+#define CHANPLAN_BRANCH_TAPS 32      // Taps per branch of a plan's banks
+#define CHANPLAN_BIN_PASSBAND 1.5    // Bank prototype width, in bin spacings
+#define CHANPLAN_BIN_REACH 0.6       // Alias-free half-width of a bin output, in spacings
+#define CHANPLAN_CHUNK 4096          // Input samples per decimator call
+
+// Forward declarations
+typedef struct chanplan_t chanplan_t;
+typedef struct chanplan_channel_t chanplan_channel_t;
+typedef struct chanplan_bank_t chanplan_bank_t;
+typedef struct chanplan_runner_t chanplan_runner_t;
+
+/**
+ * @brief How a channel is extracted
+ */
+typedef enum {
+    CHANPLAN_XLATE = 0,          // Its own translating decimator
+    CHANPLAN_PFB                 // A bin of a shared bank
+} chanplan_path_t;
+
+/**
+ * @brief One channel of the plan
+ */
+struct chanplan_channel_t {
+    char name[CHANPLAN_NAME_LENGTH]; // "" if not given
+    double center;               // Offset from the capture center (Hz)
+    double bandwidth;            // Hz
+    uint32_t rate;               // Output rate (Hz)
+
+    // Realization (chanplan_design)
+    chanplan_path_t path;
+    uint32_t bank;               // PFB: index in chanplan_t.banks
+    uint32_t bin;                // PFB: bank channel index
+    uint32_t decimation;         // XLATE: input samples per decimator output
+    double residual;             // PFB: offset from the bin center (Hz)
+    double stage_rate;           // Rate into the fine resampler (Hz)
+    double cost;                 // This channel's multiply-adds per input sample
+};
+
+/**
+ * @brief One shared filter bank
+ */
+struct chanplan_bank_t {
+    pfb_config_t config;         // Bins of fs / M, 2x oversampled, 1.5 bins wide
+    uint32_t num_members;        // Channels taken from it
+    double cost;                 // pfb_estimate_cost of the bank alone
+};
+
+/**
+ * @brief A parsed (and designed) channel plan
+ */
+struct chanplan_t {
+    double center_frequency;     // RF of the capture center (0: centers are offsets)
+    chanplan_channel_t *channels;
+    uint32_t num_channels;
+
+    // Set by chanplan_design
+    double sample_rate;          // Input rate (Hz)
+    chanplan_bank_t *banks;
+    uint32_t num_banks;
+    double total_cost;           // Whole plan, multiply-adds per input sample
+    double individual_cost;      // Every channel on its own decimator
+};
+
+/**
+ * @brief Receives a channel's outputs at its own rate
+ *
+ * @return false to stop processing
+ */
+typedef bool (*chanplan_sink_t)(uint32_t channel, const float complex *samples, uint32_t count,
+                                void *user);
+
+/**
+ * @brief Parse a plan from YAML text
+ *
+ * @param plan Receives the channels (free with chanplan_free)
+ * @param text YAML text
+ * @param length Length of the text
+ * @param error Receives a message on failure
+ * @param error_size Size of the error buffer
+ * @return true on success, false on a malformed plan
+ */
+bool chanplan_parse(chanplan_t *plan, const char *text, size_t length, char *error,
+                    size_t error_size);
+
+/**
+ * @brief Load a plan from a YAML file
+ */
+bool chanplan_load(chanplan_t *plan, const char *path, char *error, size_t error_size);
+
+/**
+ * @brief Choose a realization for every channel at an input rate
+ *
+ * @param plan Parsed plan
+ * @param sample_rate Capture sample rate (Hz)
+ * @param error Receives a message on failure
+ * @param error_size Size of the error buffer
+ * @return true on success, false if a channel does not fit the capture
+ */
+bool chanplan_design(chanplan_t *plan, double sample_rate, char *error, size_t error_size);
+
+/**
+ * @brief Free a plan's channels and banks
+ */
+void chanplan_free(chanplan_t *plan);
+
+/**
+ * @brief Cost of a channel on its own translating decimator
+ *
+ * @param channel Channel (center, bandwidth and rate set)
+ * @param sample_rate Input rate (Hz)
+ * @param decimation Receives the decimator's factor (may be NULL)
+ * @return Multiply-adds per input sample, negative on error
+ */
+double chanplan_xlate_cost(const chanplan_channel_t *channel, double sample_rate,
+                           uint32_t *decimation);
+
+/**
+ * @brief Create the filters of a designed plan
+ *
+ * @param plan Designed plan (must outlive the runner)
+ * @return Runner, NULL on error
+ */
+chanplan_runner_t *chanplan_runner_create(const chanplan_t *plan);
+
+/**
+ * @brief Destroy a runner
+ */
+void chanplan_runner_destroy(chanplan_runner_t *runner);
+
+/**
+ * @brief Channelize a block of input
+ *
+ * Consumes the whole block; every channel's new outputs go to the sink,
+ * channel by channel in stream order. Any block split gives the same
+ * outputs.
+ *
+ * @param runner Runner
+ * @param input Complex input samples
+ * @param count Number of input samples
+ * @param sink Receives the outputs
+ * @param user Passed to the sink
+ * @return true on success, false on error or when the sink stopped
+ */
+bool chanplan_runner_process(chanplan_runner_t *runner, const float complex *input, uint32_t count,
+                             chanplan_sink_t sink, void *user);
+
+#endif /* CHANPLAN_H */
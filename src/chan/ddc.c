@@ -0,0 +1,402 @@
+/*
+ * IQ Lab - ddc.c: Sparse Channel Extraction with Digital Down-Converters
+ *
+ * PFB channel k after sample N is
+ *
+ *   y_k = sum_n h[n] x[N - n] exp(-2 pi j k (N - n) / M)
+ *
+ * i.e. the prototype h applied to x mixed down by bin k. Each selected
+ * channel mixes every input sample into its own mirrored history (the NCO
+ * phase is k t mod M, a table index) and, at every decimated output
+ * instant, takes the L-tap dot product over that history. The dot product
+ * pairs the reversed, I/Q-duplicated prototype with the 2L floats of the
+ * window and runs on pfb_sweep_columns; the column sums are then folded
+ * into the I and Q totals.
+ *
+ *
+ * Date: 2025
+ */
+
+#include "ddc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Arena regions start on their own cache line
+#define DDC_ALIGNMENT 64
+
+// Widest row handed to the sweep: four AVX registers of accumulators
+#define DDC_SWEEP_WIDTH 32
+
+// Bytes rounded up to whole cache lines
+static size_t ddc_align_size(size_t bytes) {
+    return (bytes + DDC_ALIGNMENT - 1) & ~(size_t)(DDC_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Carve prototype, taps, phase table, histories and outputs from one block
+ */
+static bool allocate_arena(ddc_bank_t *bank) {
+    size_t length = bank->filter_length;
+    size_t count = bank->num_channels;
+    size_t prototype_bytes = ddc_align_size(length * sizeof(float));
+    size_t taps_bytes = ddc_align_size(2 * length * sizeof(float));
+    size_t table_bytes = ddc_align_size(bank->num_bins * sizeof(fft_complex_f32_t));
+    size_t history_bytes = ddc_align_size(2 * length * sizeof(fft_complex_f32_t));
+    size_t output_bytes = ddc_align_size(bank->config.block_size * sizeof(float complex));
+
+    // Zeroed, so the histories start silent; the slack aligns the first region
+    bank->arena = calloc(1, prototype_bytes + taps_bytes + table_bytes +
+                            count * (history_bytes + output_bytes) + DDC_ALIGNMENT - 1);
+    if (!bank->arena) return false;
+
+    uintptr_t base = ((uintptr_t)bank->arena + DDC_ALIGNMENT - 1) & ~(uintptr_t)(DDC_ALIGNMENT - 1);
+    unsigned char *cursor = (unsigned char *)base;
+    bank->prototype_filter = (float *)cursor;
+    cursor += prototype_bytes;
+    bank->taps = (float *)cursor;
+    cursor += taps_bytes;
+    bank->phase_table = (fft_complex_f32_t *)cursor;
+    cursor += table_bytes;
+    for (size_t i = 0; i < count; i++) {
+        bank->channels[i].history = (fft_complex_f32_t *)cursor;
+        cursor += history_bytes;
+        bank->channels[i].buffer = (float complex *)cursor;
+        cursor += output_bytes;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Validate the selection and fill in the channel states
+ */
+static bool initialize_channels(ddc_bank_t *bank, const uint32_t *channel_indices, uint32_t count) {
+    const uint32_t M = bank->num_bins;
+    const double spacing = bank->config.sample_rate / M;
+
+    bank->channels = (ddc_channel_t *)calloc(count, sizeof(ddc_channel_t));
+    if (!bank->channels) return false;
+    bank->num_channels = count;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t index = channel_indices[i];
+        if (index >= M) {
+            fprintf(stderr, "DDC: channel %u out of range (0-%u)\n", index, M - 1);
+            return false;
+        }
+        for (uint32_t j = 0; j < i; j++) {
+            if (channel_indices[j] == index) {
+                fprintf(stderr, "DDC: channel %u selected twice\n", index);
+                return false;
+            }
+        }
+
+        ddc_channel_t *chan = &bank->channels[i];
+        chan->channel_index = index;
+        chan->bin = (index + M - M / 2) % M;
+        chan->buffer_size = bank->config.block_size;
+        chan->center_frequency = ((double)index - (double)(M / 2)) * spacing;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Create a DDC bank for selected channels
+ */
+ddc_bank_t *ddc_bank_create(const pfb_config_t *config, const uint32_t *channel_indices,
+                            uint32_t count) {
+    if (!pfb_config_validate(config) || !channel_indices || count == 0 ||
+        count > config->num_channels) {
+        return NULL;
+    }
+
+    ddc_bank_t *bank = (ddc_bank_t *)calloc(1, sizeof(ddc_bank_t));
+    if (!bank) return NULL;
+
+    memcpy(&bank->config, config, sizeof(pfb_config_t));
+    bank->filter_length = config->filter_length;
+    bank->num_bins = config->num_channels;
+    bank->decimation = config->num_channels / config->oversampling;
+    bank->sweep_width = 2 * bank->filter_length < DDC_SWEEP_WIDTH ? 2 * bank->filter_length
+                                                                  : DDC_SWEEP_WIDTH;
+
+    if (!initialize_channels(bank, channel_indices, count) || !allocate_arena(bank) ||
+        !pfb_load_filter(&bank->config, bank->prototype_filter, bank->taps)) {
+        ddc_bank_destroy(bank);
+        return NULL;
+    }
+
+    for (uint32_t t = 0; t < bank->num_bins; t++) {
+        double angle = -2.0 * M_PI * (double)t / (double)bank->num_bins;
+        bank->phase_table[t] = (float)cos(angle) + I * (float)sin(angle);
+    }
+
+    bank->initialized = true;
+    return bank;
+}
+
+/**
+ * @brief Destroy a DDC bank
+ */
+void ddc_bank_destroy(ddc_bank_t *bank) {
+    if (!bank) return;
+
+    free(bank->arena);
+    free(bank->channels);
+    free(bank);
+}
+
+// True when some channel buffer has no room for another output
+static bool any_channel_full(const ddc_bank_t *bank) {
+    bool full = false;
+    for (uint32_t i = 0; i < bank->num_channels; i++) {
+        full |= bank->channels[i].samples_written >= bank->channels[i].buffer_size;
+    }
+    return full;
+}
+
+// Mix samples down into every channel's history; each lands twice, L slots
+// apart, so the last L mixed samples are contiguous from the oldest slot
+static void mix_into_history(ddc_bank_t *bank, const float complex *input, uint32_t count) {
+    const uint32_t length = bank->filter_length;
+    const uint32_t M = bank->num_bins;
+    const uint32_t start = bank->history_index;
+
+    for (uint32_t c = 0; c < bank->num_channels; c++) {
+        ddc_channel_t *chan = &bank->channels[c];
+        uint32_t slot = start;
+        uint32_t phase = chan->nco_phase;
+
+        for (uint32_t i = 0; i < count; i++) {
+            float xr = crealf(input[i]), xi = cimagf(input[i]);
+            float wr = crealf(bank->phase_table[phase]), wi = cimagf(bank->phase_table[phase]);
+            fft_complex_f32_t z = (xr * wr - xi * wi) + I * (xr * wi + xi * wr);
+
+            chan->history[slot] = z;
+            chan->history[slot + length] = z;
+            slot = slot + 1 == length ? 0 : slot + 1;
+            phase += chan->bin;
+            if (phase >= M) phase -= M;
+        }
+        chan->nco_phase = phase;
+    }
+
+    bank->history_index = (uint32_t)((start + (uint64_t)count) % length);
+}
+
+// One decimated output for every channel
+static void compute_outputs(ddc_bank_t *bank) {
+    const uint32_t width = bank->sweep_width;
+    const uint32_t rows = 2 * bank->filter_length / width;
+    float sums[DDC_SWEEP_WIDTH];
+
+    for (uint32_t c = 0; c < bank->num_channels; c++) {
+        ddc_channel_t *chan = &bank->channels[c];
+        const float *window = (const float *)(chan->history + bank->history_index);
+        pfb_sweep_columns(bank->taps, window, rows, width, sums);
+
+        // Even columns are I, odd ones Q
+        float re = 0.0f, im = 0.0f;
+        for (uint32_t j = 0; j < width; j += 2) {
+            re += sums[j];
+            im += sums[j + 1];
+        }
+        chan->buffer[chan->samples_written++] = re + I * im;
+    }
+}
+
+/**
+ * @brief Process a block of IQ samples
+ */
+int32_t ddc_bank_process_block(ddc_bank_t *bank, const float complex *input, uint32_t input_length) {
+    if (!bank || !bank->initialized || !input || input_length == 0) {
+        return -1;
+    }
+
+    uint32_t consumed = 0;
+
+    while (consumed < input_length) {
+        // Samples up to and including the one completing the next output
+        uint32_t chunk = bank->decimation - bank->pending;
+        bool output_due = chunk <= input_length - consumed;
+        if (!output_due) chunk = input_length - consumed;
+
+        // The sample completing an output needs room in every channel
+        if (output_due && any_channel_full(bank)) {
+            output_due = false;
+            if (--chunk == 0) break;
+        }
+
+        mix_into_history(bank, input + consumed, chunk);
+        consumed += chunk;
+        bank->pending += chunk;
+        bank->samples_consumed += chunk;
+
+        if (output_due) {
+            bank->pending = 0;
+            compute_outputs(bank);
+        }
+    }
+
+    return (int32_t)consumed;
+}
+
+/**
+ * @brief Get a selected channel's output buffer
+ */
+const float complex *ddc_bank_get_channel_output(const ddc_bank_t *bank, uint32_t slot,
+                                                 uint32_t *samples) {
+    if (!bank || !bank->initialized || slot >= bank->num_channels || !samples) {
+        return NULL;
+    }
+
+    *samples = bank->channels[slot].samples_written;
+    return bank->channels[slot].buffer;
+}
+
+/**
+ * @brief Mark a selected channel's output as consumed
+ */
+bool ddc_bank_reset_channel_output(ddc_bank_t *bank, uint32_t slot) {
+    if (!bank || !bank->initialized || slot >= bank->num_channels) {
+        return false;
+    }
+
+    bank->channels[slot].samples_written = 0;
+    return true;
+}
+
+/**
+ * @brief Reset histories, NCOs and output buffers
+ */
+bool ddc_bank_reset(ddc_bank_t *bank) {
+    if (!bank || !bank->initialized) {
+        return false;
+    }
+
+    for (uint32_t c = 0; c < bank->num_channels; c++) {
+        ddc_channel_t *chan = &bank->channels[c];
+        memset(chan->history, 0, 2 * (size_t)bank->filter_length * sizeof(fft_complex_f32_t));
+        chan->nco_phase = 0;
+        chan->samples_written = 0;
+    }
+    bank->history_index = 0;
+    bank->pending = 0;
+    bank->samples_consumed = 0;
+
+    return true;
+}
+
+// Stream position of a checkpointed bank, with the geometry it belongs to
+typedef struct {
+    uint32_t num_bins;
+    uint32_t filter_length;
+    uint32_t num_channels;
+    uint32_t history_index;
+    uint32_t pending;
+    uint32_t reserved;
+    uint64_t samples_consumed;
+} ddc_stream_state_t;
+
+// Per channel: its PFB index (checked on load) and NCO phase
+typedef struct {
+    uint32_t channel_index;
+    uint32_t nco_phase;
+} ddc_channel_state_t;
+
+bool ddc_bank_save_state(const ddc_bank_t *bank, checkpoint_writer_t *writer) {
+    if (!bank || !bank->initialized || !writer) {
+        return false;
+    }
+
+    ddc_stream_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.num_bins = bank->num_bins;
+    state.filter_length = bank->filter_length;
+    state.num_channels = bank->num_channels;
+    state.history_index = bank->history_index;
+    state.pending = bank->pending;
+    state.samples_consumed = bank->samples_consumed;
+    bool ok = checkpoint_put(writer, "ddc.stream", &state, sizeof(state));
+
+    size_t history_bytes = 2 * (size_t)bank->filter_length * sizeof(fft_complex_f32_t);
+    for (uint32_t c = 0; ok && c < bank->num_channels; c++) {
+        const ddc_channel_t *chan = &bank->channels[c];
+        ddc_channel_state_t channel = { chan->channel_index, chan->nco_phase };
+        char tag[CHECKPOINT_TAG_LEN + 1];
+        snprintf(tag, sizeof(tag), "ddc.channel.%u", c);
+        ok = checkpoint_put(writer, tag, &channel, sizeof(channel));
+        snprintf(tag, sizeof(tag), "ddc.history.%u", c);
+        ok = ok && checkpoint_put(writer, tag, chan->history, history_bytes);
+    }
+    return ok;
+}
+
+bool ddc_bank_load_state(ddc_bank_t *bank, const checkpoint_t *checkpoint) {
+    ddc_stream_state_t state;
+    bool ok = ddc_bank_reset(bank) && checkpoint_get(checkpoint, "ddc.stream", &state, sizeof(state)) &&
+              state.num_bins == bank->num_bins && state.filter_length == bank->filter_length &&
+              state.num_channels == bank->num_channels && state.history_index < bank->filter_length &&
+              state.pending < bank->decimation;
+
+    size_t history_bytes = 2 * (size_t)bank->filter_length * sizeof(fft_complex_f32_t);
+    for (uint32_t c = 0; ok && c < bank->num_channels; c++) {
+        ddc_channel_t *chan = &bank->channels[c];
+        ddc_channel_state_t channel;
+        char tag[CHECKPOINT_TAG_LEN + 1];
+        snprintf(tag, sizeof(tag), "ddc.channel.%u", c);
+        ok = checkpoint_get(checkpoint, tag, &channel, sizeof(channel)) &&
+             channel.channel_index == chan->channel_index && channel.nco_phase < bank->num_bins;
+        snprintf(tag, sizeof(tag), "ddc.history.%u", c);
+        ok = ok && checkpoint_get(checkpoint, tag, chan->history, history_bytes);
+        if (ok) chan->nco_phase = channel.nco_phase;
+    }
+    if (!ok) {
+        ddc_bank_reset(bank);
+        return false;
+    }
+
+    bank->history_index = state.history_index;
+    bank->pending = state.pending;
+    bank->samples_consumed = state.samples_consumed;
+    return true;
+}
+
+/**
+ * @brief Get the channel output sample rate
+ */
+double ddc_bank_get_output_rate(const ddc_bank_t *bank) {
+    if (!bank || !bank->initialized) {
+        return -1.0;
+    }
+
+    return bank->config.sample_rate / (double)bank->decimation;
+}
+
+/**
+ * @brief Estimate the cost of extracting count channels by DDC
+ */
+double ddc_estimate_cost(const pfb_config_t *config, uint32_t count) {
+    if (!pfb_config_validate(config) || count == 0) return -1.0;
+
+    // Per channel and input sample: the complex mix, plus the 2L-float dot
+    // product once every M / oversampling samples
+    double fir = 2.0 * config->filter_length * config->oversampling / config->num_channels;
+    return count * (4.0 + fir);
+}
+
+/**
+ * @brief Whether count DDC channels are cheaper than the full PFB
+ */
+bool ddc_bank_preferred(const pfb_config_t *config, uint32_t count) {
+    double sparse = ddc_estimate_cost(config, count);
+    double full = pfb_estimate_cost(config);
+    return sparse >= 0.0 && full >= 0.0 && sparse < full;
+}
@@ -0,0 +1,188 @@
+/*
+ * IQ Lab - ddc.h: Sparse Channel Extraction with Digital Down-Converters
+ *
+ * Purpose: Extracts a few channels of a PFB configuration without running
+ * the whole filter bank: every selected channel gets its own NCO and
+ * decimating FIR, so the cost grows with the channels actually extracted.
+ *
+ * Date: 2025
+ *
+ * Key Features:
+ * - Same channels as pfb.h: bin frequencies, prototype filter, decimation
+ *   and output instants all follow the pfb_config_t, so a DDC channel
+ *   equals the PFB channel of the same index up to float rounding
+ * - Exact NCO: channel bin k mixes by exp(-2*pi*j*k*t/M) from a table
+ *   indexed by k*t mod M, so the phase never drifts
+ * - The FIR (the full prototype, L taps) is only evaluated at the
+ *   decimated output instants, on the SIMD column-sum kernel of the PFB
+ * - ddc_bank_preferred() compares ddc_estimate_cost() with
+ *   pfb_estimate_cost() so callers can switch to the full bank once
+ *   enough channels are requested
+ *
+ * Cost per input sample and selected channel: one complex mix (4 real
+ * multiplies) plus 2L / decimation for the FIR. The full bank costs
+ * about one such FIR plus an FFT share for all M channels, so sparse
+ * extraction wins only for a handful of channels.
+ */
+
+#ifndef DDC_H
+#define DDC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <complex.h>
+#include "pfb.h"
+
+// Forward declarations
+typedef struct ddc_bank_t ddc_bank_t;
+typedef struct ddc_channel_t ddc_channel_t;
+
+/**
+ * @brief One extracted channel
+ */
+struct ddc_channel_t {
+    uint32_t channel_index;      // PFB channel index (0 to num_channels-1)
+    uint32_t bin;                // Mixing bin k = (channel_index - M/2) mod M
+    uint32_t nco_phase;          // k * t mod M for the next input sample
+    fft_complex_f32_t *history;  // Last L mixed samples, stored twice (in the arena)
+    float complex *buffer;       // Output buffer (in the arena)
+    uint32_t buffer_size;        // Size of output buffer
+    uint32_t samples_written;    // Samples written to current buffer
+    double center_frequency;     // Channel center frequency (Hz)
+};
+
+/**
+ * @brief Sparse DDC bank context
+ */
+struct ddc_bank_t {
+    pfb_config_t config;         // Filter bank configuration the channels come from
+
+    // Filter
+    float *prototype_filter;     // Prototype coefficients, as the PFB designs them
+    float *taps;                 // Reversed prototype, each tap twice (I and Q): 2L floats
+    uint32_t filter_length;      // L
+    uint32_t sweep_width;        // Floats per row handed to pfb_sweep_columns
+    uint32_t num_bins;           // M
+    uint32_t decimation;         // Input samples per output (M / oversampling)
+    fft_complex_f32_t *phase_table; // exp(-2*pi*j*t/M), t = 0..M-1
+
+    // Channels
+    ddc_channel_t *channels;     // Selected channels, in request order
+    uint32_t num_channels;       // Number of selected channels
+
+    // Stream state
+    uint32_t history_index;      // Oldest history slot, shared by all channels
+    uint32_t pending;            // Input samples since the last output
+    uint64_t samples_consumed;   // Input samples since create/reset
+
+    // Memory management
+    void *arena;                 // Single allocation behind all filter state and buffers
+    bool initialized;            // Initialization flag
+};
+
+/**
+ * @brief Create a DDC bank for selected channels of a PFB configuration
+ *
+ * @param config Validated PFB configuration
+ * @param channel_indices PFB channel indices to extract (distinct)
+ * @param count Number of channels (1 to config->num_channels)
+ * @return Pointer to initialized bank, NULL on error
+ */
+ddc_bank_t *ddc_bank_create(const pfb_config_t *config, const uint32_t *channel_indices,
+                            uint32_t count);
+
+/**
+ * @brief Destroy a DDC bank
+ *
+ * @param bank Pointer to bank
+ */
+void ddc_bank_destroy(ddc_bank_t *bank);
+
+/**
+ * @brief Process a block of IQ samples
+ *
+ * Same contract as pfb_process_block: consumption stops early, without
+ * dropping anything, when an output is due and a channel buffer is full.
+ *
+ * @param bank Pointer to bank
+ * @param input Complex input samples (I + j*Q)
+ * @param input_length Number of input samples
+ * @return Number of samples consumed, negative on error
+ */
+int32_t ddc_bank_process_block(ddc_bank_t *bank, const float complex *input, uint32_t input_length);
+
+/**
+ * @brief Get a selected channel's output buffer
+ *
+ * @param bank Pointer to bank
+ * @param slot Position in the channel_indices passed to ddc_bank_create
+ * @param samples Pointer to receive number of available samples
+ * @return Pointer to output buffer, NULL on error
+ */
+const float complex *ddc_bank_get_channel_output(const ddc_bank_t *bank, uint32_t slot,
+                                                 uint32_t *samples);
+
+/**
+ * @brief Mark a selected channel's output as consumed
+ *
+ * @param bank Pointer to bank
+ * @param slot Position in the channel_indices passed to ddc_bank_create
+ * @return true on success, false on error
+ */
+bool ddc_bank_reset_channel_output(ddc_bank_t *bank, uint32_t slot);
+
+/**
+ * @brief Reset histories, NCOs and output buffers
+ *
+ * @param bank Pointer to bank
+ * @return true on success, false on error
+ */
+bool ddc_bank_reset(ddc_bank_t *bank);
+
+/**
+ * @brief Save NCO phases and histories to a checkpoint
+ *
+ * Every channel's output must have been consumed.
+ *
+ * @param bank Pointer to bank
+ * @param writer Open checkpoint
+ * @return true on success, false on error
+ */
+bool ddc_bank_save_state(const ddc_bank_t *bank, checkpoint_writer_t *writer);
+
+/**
+ * @brief Restore the state of ddc_bank_save_state, with empty outputs
+ *
+ * @param bank Bank with the saved one's configuration and channels
+ * @param checkpoint Loaded checkpoint
+ * @return true on success, false if missing or of another bank
+ */
+bool ddc_bank_load_state(ddc_bank_t *bank, const checkpoint_t *checkpoint);
+
+/**
+ * @brief Get the channel output sample rate
+ *
+ * @param bank Pointer to bank
+ * @return Output rate in Hz (same as the PFB's), negative on error
+ */
+double ddc_bank_get_output_rate(const ddc_bank_t *bank);
+
+/**
+ * @brief Estimate the cost of extracting count channels by DDC
+ *
+ * @param config PFB configuration
+ * @param count Number of selected channels
+ * @return Real multiply-adds per input sample, negative on error
+ */
+double ddc_estimate_cost(const pfb_config_t *config, uint32_t count);
+
+/**
+ * @brief Whether count DDC channels are cheaper than the full PFB
+ *
+ * @param config PFB configuration
+ * @param count Number of selected channels
+ * @return true when ddc_estimate_cost is below pfb_estimate_cost
+ */
+bool ddc_bank_preferred(const pfb_config_t *config, uint32_t count);
+
+#endif /* DDC_H */
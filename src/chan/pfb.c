@@ -6,10 +6,33 @@
  *
  * Algorithm Overview:
  * 1. Design prototype low-pass filter (Kaiser window)
- * 2. Decompose into polyphase branches
- * 3. Process input through filter branches
- * 4. FFT to frequency domain
- * 5. Extract channel sub-bands
+ * 2. Decompose into polyphase branches, stored transposed
+ * 3. Append input samples to the mirrored history
+ * 4. Every D samples: one tap sweep across all branches, M-point FFT
+ * 5. Rotate each channel by the commutator phase and store it in its ring
+ *
+ * Channel k (frequency k * fs / M) at the output taken after sample N is
+ *
+ *   y_k = sum_n h[n] x[N - n] exp(-2 pi j k (N - n) / M)
+ *       = exp(-2 pi j k N / M) * sum_p exp(2 pi j k p / M) v[p]
+ *   v[p] = sum_q h[qM + p] x[N - qM - p]
+ *
+ * The window x[N - L + 1 .. N] read as P rows of M samples has, at row r and
+ * column j, x[N - qM - p] with q = P-1-r and p = M-1-j, which the transposed
+ * taps pair with h[qM + p]. Summing the rows column-wise therefore gives
+ * u[j] = v[M-1-j] for every branch at once, with each column accumulated
+ * oldest sample first. The forward FFT of u at bin k is
+ * exp(2 pi j k / M) times the sum over p above, so
+ *
+ *   y_k = exp(-2 pi j k (N + 1) / M) * U[k]
+ *
+ * and the rotation only depends on (N + 1) mod M: it is 1 for every output
+ * when D = M and alternates sign on odd channels when D = M / 2.
+ *
+ * The tap sweep is vectorised along the columns (SSE2/AVX on x86, NEON on
+ * AArch64, dispatched once at run time). Every path accumulates each column
+ * with separate multiplies and adds in the same row order, so all of them
+ * produce bit-identical outputs.
  *
  *
  * Date: 2025
@@ -17,24 +40,68 @@
 
 #include "pfb.h"
 #include "../iq_core/fft.h"
+#include "../iq_core/window.h"
+#include "../iq_core/hugepage.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PFB_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define PFB_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// Arena regions start on their own cache line
+#define PFB_ALIGNMENT 64
+
+// Filter cache file: header, prototype, transposed taps (native byte order)
+#define PFB_CACHE_MAGIC "IQLABPFB"
+#define PFB_CACHE_VERSION 1u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_channels;
+    uint32_t filter_length;
+    uint32_t reserved;
+    double kaiser_beta;
+    double overlap_factor;
+    double cutoff;               // channel_bandwidth / sample_rate
+    uint64_t checksum;           // FNV-1a over the coefficients
+} pfb_cache_header_t;
+
+enum {
+    PFB_SIMD_SCALAR,
+    PFB_SIMD_SSE2,
+    PFB_SIMD_AVX,
+    PFB_SIMD_NEON
+};
+
+// -1 until the first output detects the CPU
+static atomic_int pfb_simd_active = -1;
+
 // Forward declarations
 static bool process_fft_block(pfb_t *pfb);
+static void pfb_free_members(pfb_t *pfb);
 
 /**
  * @brief Initialize PFB configuration with sensible defaults
  */
 bool pfb_config_init(pfb_config_t *config, uint32_t num_channels,
                     double sample_rate, double channel_bandwidth) {
-    if (!config || num_channels < 4 || num_channels > 32 ||
+    if (!config || num_channels < PFB_MIN_CHANNELS || num_channels > PFB_MAX_CHANNELS ||
         sample_rate <= 0.0 || channel_bandwidth <= 0.0) {
         return false;
     }
@@ -43,12 +110,19 @@ bool pfb_config_init(pfb_config_t *config, uint32_t num_channels,
     config->sample_rate = sample_rate;
     config->channel_bandwidth = channel_bandwidth;
 
-    // Calculate optimal filter parameters
-    config->filter_length = 4096;  // Default filter length (power of 2)
-    config->fft_size = config->filter_length / num_channels;  // Ensure divisibility
+    // Calculate optimal filter parameters: 4096 taps (power of 2), more for
+    // large banks so every branch keeps PFB_MIN_BRANCH_TAPS
+    config->filter_length = 4096;
+    while (config->filter_length < (uint64_t)num_channels * PFB_MIN_BRANCH_TAPS) {
+        config->filter_length *= 2;
+    }
+    config->fft_size = num_channels;  // One FFT point per polyphase branch
     config->overlap_factor = 0.1;  // 10% overlap
     config->kaiser_beta = 8.6;     // Good stopband attenuation
-    config->block_size = config->fft_size;  // Process one FFT block at a time
+    config->oversampling = 1;      // Critically sampled
+    // Channel outputs buffered between drains, within the total budget
+    config->block_size = PFB_OUTPUT_BUDGET / num_channels < 4096 ? PFB_OUTPUT_BUDGET / num_channels : 4096;
+    config->cache_dir = NULL;      // Design the prototype on every create
 
     return true;
 }
@@ -60,13 +134,15 @@ bool pfb_config_validate(const pfb_config_t *config) {
     if (!config) return false;
 
     // Basic parameter validation
-    if (config->num_channels < 4 || config->num_channels > 32) return false;
+    if (config->num_channels < PFB_MIN_CHANNELS || config->num_channels > PFB_MAX_CHANNELS) return false;
     if (config->sample_rate <= 0.0) return false;
     if (config->channel_bandwidth <= 0.0) return false;
     if (config->filter_length == 0 || (config->filter_length & (config->filter_length - 1)) != 0) return false;
-    if (config->fft_size == 0 || config->fft_size > config->filter_length) return false;
+    if (config->fft_size != config->num_channels) return false;
     if (config->overlap_factor < 0.0 || config->overlap_factor >= 1.0) return false;
     if (config->kaiser_beta < 0.0) return false;
+    if (config->oversampling != 1 && config->oversampling != 2) return false;
+    if (config->oversampling == 2 && config->num_channels % 2 != 0) return false;
     if (config->block_size == 0) return false;
 
     // Check that filter length is compatible with number of channels
@@ -75,160 +151,275 @@ bool pfb_config_validate(const pfb_config_t *config) {
     return true;
 }
 
+// Bytes rounded up to whole cache lines
+static size_t pfb_align_size(size_t bytes) {
+    return (bytes + PFB_ALIGNMENT - 1) & ~(size_t)(PFB_ALIGNMENT - 1);
+}
+
 /**
- * @brief Design Kaiser window
+ * @brief Carve the prototype, taps, history, FFT buffers, channel states and rings from one block
  */
-static void design_kaiser_window(float *window, uint32_t length, double beta) {
-    double sum = 0.0;
-
-    // Calculate window values
-    for (uint32_t i = 0; i < length; i++) {
-        double x = 2.0 * i / (length - 1.0) - 1.0;  // Map to [-1, 1]
-        double t = 1.0 - x * x;
+static bool allocate_arena(pfb_t *pfb) {
+    size_t length = pfb->filter_length;
+    size_t prototype_bytes = pfb_align_size(length * sizeof(float));
+    size_t taps_bytes = pfb_align_size(2 * length * sizeof(float));
+    size_t history_bytes = pfb_align_size(2 * length * sizeof(fft_complex_f32_t));
+    size_t vector_bytes = pfb_align_size(pfb->num_branches * sizeof(fft_complex_f32_t));
+    size_t channel_bytes = pfb_align_size(pfb->num_branches * sizeof(pfb_channel_t));
+    size_t reader_bytes = pfb_align_size(pfb->num_branches * sizeof(pfb_reader_t));
+    size_t output_bytes = pfb_align_size((size_t)pfb->num_branches * pfb->config.block_size *
+                                         sizeof(fft_complex_f32_t));
+
+    // Zeroed, so the history starts silent; the slack aligns the first region.
+    // Huge pages keep the delay lines and rings of wide banks in few TLB entries.
+    pfb->arena = iq_huge_alloc(prototype_bytes + taps_bytes + history_bytes + 3 * vector_bytes +
+                           channel_bytes + reader_bytes + output_bytes + PFB_ALIGNMENT - 1);
+    if (!pfb->arena) return false;
+
+    uintptr_t base = ((uintptr_t)pfb->arena + PFB_ALIGNMENT - 1) & ~(uintptr_t)(PFB_ALIGNMENT - 1);
+    unsigned char *cursor = (unsigned char *)base;
+    pfb->prototype_filter = (float *)cursor;
+    cursor += prototype_bytes;
+    pfb->transposed_taps = (float *)cursor;
+    cursor += taps_bytes;
+    pfb->history = (fft_complex_f32_t *)cursor;
+    cursor += history_bytes;
+    pfb->fft_input = (fft_complex_f32_t *)cursor;
+    cursor += vector_bytes;
+    pfb->fft_output = (fft_complex_f32_t *)cursor;
+    cursor += vector_bytes;
+    pfb->phase_table = (fft_complex_f32_t *)cursor;
+    cursor += vector_bytes;
+    pfb->channels = (pfb_channel_t *)cursor;
+    cursor += channel_bytes;
+    pfb->readers = (pfb_reader_t *)cursor;     // Apart from the producer's cache lines
+    cursor += reader_bytes;
+    pfb->channel_outputs = (fft_complex_f32_t *)cursor;
 
-        if (fabs(x) > 1.0) {
-            window[i] = 0.0f;
-        } else {
-            // Modified Bessel function of first kind, order 0
-            double bessel_i0 = 1.0;
-            double term = 1.0;
-            for (int k = 1; k <= 10; k++) {
-                term *= (beta * beta / 4.0) / (k * k);
-                bessel_i0 += term;
-                if (term < 1e-12) break;
-            }
-
-            window[i] = (float)(bessel_i0 / bessel_i0 * sqrt(t));
-        }
-        sum += window[i];
-    }
-
-    // Normalize
-    if (sum > 0.0) {
-        for (uint32_t i = 0; i < length; i++) {
-            window[i] /= (float)sum;
-        }
-    }
+    return true;
 }
 
 /**
  * @brief Design prototype low-pass filter
  */
-static bool design_prototype_filter(pfb_t *pfb) {
-    uint32_t length = pfb->config.filter_length;
-    double sample_rate = pfb->config.sample_rate;
-    double cutoff_freq = pfb->config.channel_bandwidth / 2.0;
-    double beta = pfb->config.kaiser_beta;
-
-    // Allocate filter memory
-    pfb->prototype_filter = (float *)malloc(length * sizeof(float));
-    if (!pfb->prototype_filter) return false;
-
-    // Design Kaiser window
-    float *window = (float *)malloc(length * sizeof(float));
-    if (!window) {
-        free(pfb->prototype_filter);
-        return false;
-    }
+bool pfb_design_prototype(const pfb_config_t *config, float *taps) {
+    if (!config || !taps) return false;
+
+    uint32_t length = config->filter_length;
+    double sample_rate = config->sample_rate;
+    double cutoff_freq = config->channel_bandwidth / 2.0;
+    double beta = config->kaiser_beta;
 
-    design_kaiser_window(window, length, beta);
+    // Kaiser taps come from the shared window cache
+    const window_t *window = window_acquire(WINDOW_KAISER, length, beta);
+    if (!window) return false;
 
     // Design sinc filter and apply window
     double wc = 2.0 * M_PI * cutoff_freq / sample_rate;
     double center = (length - 1) / 2.0;
+    double tap_sum = 0.0;
 
     for (uint32_t i = 0; i < length; i++) {
         double x = i - center;
         double sinc_val;
 
         if (fabs(x) < 1e-10) {
-            sinc_val = 1.0;
+            sinc_val = wc / M_PI;
         } else {
             sinc_val = sin(wc * x) / (M_PI * x);
         }
 
-        pfb->prototype_filter[i] = (float)(sinc_val * window[i]);
+        double tap = sinc_val * window->coefficients[i];
+        taps[i] = (float)tap;
+        tap_sum += tap;
     }
 
-    free(window);
+    // Unit DC gain: a tone at a channel centre keeps its amplitude
+    for (uint32_t i = 0; i < length; i++) {
+        taps[i] = (float)(taps[i] / tap_sum);
+    }
+
+    window_release(window);
     return true;
 }
 
 /**
- * @brief Decompose prototype filter into polyphase branches
+ * @brief Decompose prototype filter into transposed polyphase branches
  */
-static bool decompose_polyphase(pfb_t *pfb) {
-    uint32_t num_branches = pfb->config.num_channels;
-    uint32_t filter_length = pfb->config.filter_length;
-
-    pfb->num_branches = num_branches;
-    pfb->branch_length = filter_length / num_branches;
-
-    // Allocate polyphase filter branches
-    pfb->polyphase_filters = (float **)malloc(num_branches * sizeof(float *));
-    if (!pfb->polyphase_filters) return false;
-
-    for (uint32_t branch = 0; branch < num_branches; branch++) {
-        pfb->polyphase_filters[branch] = (float *)malloc(pfb->branch_length * sizeof(float));
-        if (!pfb->polyphase_filters[branch]) {
-            // Cleanup on error
-            for (uint32_t i = 0; i < branch; i++) {
-                free(pfb->polyphase_filters[i]);
-            }
-            free(pfb->polyphase_filters);
-            return false;
-        }
+static void decompose_polyphase(const float *prototype, uint32_t length, float *transposed_taps) {
+    // Row r, column j holds tap P-1-r of branch M-1-j, h[L-1-rM-j]: the
+    // reversed prototype. Each tap is stored twice, once for the I and once
+    // for the Q float of the history sample it multiplies
+    for (uint32_t i = 0; i < length; i++) {
+        float tap = prototype[length - 1 - i];
+        transposed_taps[2 * i] = tap;
+        transposed_taps[2 * i + 1] = tap;
+    }
+}
 
-        // Extract polyphase branch (reverse order for convolution)
-        for (uint32_t i = 0; i < pfb->branch_length; i++) {
-            uint32_t idx = branch + i * num_branches;
-            if (idx < filter_length) {
-                pfb->polyphase_filters[branch][pfb->branch_length - 1 - i] =
-                    pfb->prototype_filter[idx];
-            } else {
-                pfb->polyphase_filters[branch][pfb->branch_length - 1 - i] = 0.0f;
-            }
+// Bit pattern of a double, so cache keys match exactly
+static uint64_t double_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// FNV-1a over the prototype and transposed taps
+static uint64_t cache_checksum(const float *prototype, const float *transposed_taps,
+                               uint32_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char *parts[2] = {(const unsigned char *)prototype,
+                                     (const unsigned char *)transposed_taps};
+    size_t sizes[2] = {length * sizeof(float), 2 * (size_t)length * sizeof(float)};
+    for (int part = 0; part < 2; part++) {
+        for (size_t i = 0; i < sizes[part]; i++) {
+            hash = (hash ^ parts[part][i]) * 1099511628211ull;
         }
     }
+    return hash;
+}
+
+// Header describing the filter a configuration designs
+static void cache_header_init(const pfb_config_t *config, pfb_cache_header_t *header) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, PFB_CACHE_MAGIC, sizeof(header->magic));
+    header->version = PFB_CACHE_VERSION;
+    header->num_channels = config->num_channels;
+    header->filter_length = config->filter_length;
+    header->kaiser_beta = config->kaiser_beta;
+    header->overlap_factor = config->overlap_factor;
+    header->cutoff = config->channel_bandwidth / config->sample_rate;
+}
+
+/**
+ * @brief Path of the cache file for a filter configuration
+ */
+bool pfb_filter_cache_path(const pfb_config_t *config, char *path, size_t size) {
+    if (!config || !config->cache_dir || !path || size == 0) return false;
+
+    // The doubles go in as bit patterns: any change to the design is a new file
+    int written = snprintf(path, size, "%s/pfb_%u_%u_%016llx_%016llx_%016llx.taps",
+                           config->cache_dir, config->num_channels, config->filter_length,
+                           (unsigned long long)double_bits(config->kaiser_beta),
+                           (unsigned long long)double_bits(config->overlap_factor),
+                           (unsigned long long)double_bits(config->channel_bandwidth /
+                                                           config->sample_rate));
+    return written > 0 && (size_t)written < size;
+}
+
+// Read a cached filter; false when the file is missing, stale or corrupt
+static bool cache_read(const pfb_config_t *config, const char *path, float *prototype,
+                       float *transposed_taps) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    uint32_t length = config->filter_length;
+    pfb_cache_header_t expected, header;
+    cache_header_init(config, &expected);
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 &&
+              header.version == expected.version &&
+              header.num_channels == expected.num_channels &&
+              header.filter_length == expected.filter_length &&
+              double_bits(header.kaiser_beta) == double_bits(expected.kaiser_beta) &&
+              double_bits(header.overlap_factor) == double_bits(expected.overlap_factor) &&
+              double_bits(header.cutoff) == double_bits(expected.cutoff) &&
+              fread(prototype, sizeof(float), length, file) == length &&
+              fread(transposed_taps, sizeof(float), 2 * (size_t)length, file) == 2 * (size_t)length &&
+              fgetc(file) == EOF &&
+              cache_checksum(prototype, transposed_taps, length) == header.checksum;
+    fclose(file);
+    return ok;
+}
+
+// Write a filter to the cache: into a temporary file first, renamed over the
+// final name once complete, so concurrent runs never read a partial file
+static void cache_write(const pfb_config_t *config, const char *path, const float *prototype,
+                        const float *transposed_taps) {
+    uint32_t length = config->filter_length;
+    pfb_cache_header_t header;
+    cache_header_init(config, &header);
+    header.checksum = cache_checksum(prototype, transposed_taps, length);
+
+    // Exclusive create: another run writing the same filter already holds it
+    char temp[4096];
+    int written = snprintf(temp, sizeof(temp), "%s.%lx.tmp", path, (unsigned long)time(NULL));
+    if (written <= 0 || (size_t)written >= sizeof(temp)) return;
+    FILE *file = fopen(temp, "wbx");
+    if (!file) {
+        fprintf(stderr, "PFB: cannot write filter cache %s\n", path);
+        return;
+    }
 
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(prototype, sizeof(float), length, file) == length &&
+              fwrite(transposed_taps, sizeof(float), 2 * (size_t)length, file) == 2 * (size_t)length;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temp, path) != 0) {
+        // Some platforms refuse to rename over an existing file
+        remove(path);
+        if (!ok || rename(temp, path) != 0) remove(temp);
+    }
+}
+
+/**
+ * @brief Load the prototype and transposed taps from the cache, or design them
+ */
+bool pfb_load_filter(const pfb_config_t *config, float *prototype, float *transposed_taps) {
+    if (!config || !prototype || !transposed_taps) return false;
+
+    char path[4096];
+    bool cached = pfb_filter_cache_path(config, path, sizeof(path));
+    if (cached && cache_read(config, path, prototype, transposed_taps)) return true;
+
+    if (!pfb_design_prototype(config, prototype)) return false;
+    decompose_polyphase(prototype, config->filter_length, transposed_taps);
+
+    if (cached) cache_write(config, path, prototype, transposed_taps);
     return true;
 }
 
+/**
+ * @brief Fill the phase table and reset the commutator counters
+ */
+static void initialize_commutator(pfb_t *pfb) {
+    uint32_t num_branches = pfb->num_branches;
+
+    for (uint32_t t = 0; t < num_branches; t++) {
+        double angle = -2.0 * M_PI * (double)t / (double)num_branches;
+        pfb->phase_table[t] = (float)cos(angle) + I * (float)sin(angle);
+    }
+
+    pfb->history_index = 0;
+    pfb->pending = 0;
+    pfb->samples_consumed = 0;
+}
+
 /**
  * @brief Initialize channel structures
  */
-static bool initialize_channels(pfb_t *pfb) {
+static void initialize_channels(pfb_t *pfb) {
     uint32_t num_channels = pfb->config.num_channels;
 
-    pfb->channels = (pfb_channel_t *)malloc(num_channels * sizeof(pfb_channel_t));
-    if (!pfb->channels) return false;
-
     pfb->num_channels = num_channels;
 
     for (uint32_t i = 0; i < num_channels; i++) {
         pfb_channel_t *chan = &pfb->channels[i];
 
+        // Every channel's ring is its slice of the arena's output region
         chan->buffer_size = pfb->config.block_size;
-        chan->buffer = (float complex *)malloc(chan->buffer_size * sizeof(float complex));
-        if (!chan->buffer) {
-            // Cleanup on error
-            for (uint32_t j = 0; j < i; j++) {
-                free(pfb->channels[j].buffer);
-            }
-            free(pfb->channels);
-            return false;
-        }
-
-        chan->samples_written = 0;
+        chan->buffer = pfb->channel_outputs + (size_t)i * chan->buffer_size;
+        chan->write_slot = 0;
+        atomic_init(&chan->head, 0);
+        pfb->readers[i].read_slot = 0;
+        atomic_init(&pfb->readers[i].tail, 0);
         chan->channel_index = i;
         chan->bandwidth = pfb->config.channel_bandwidth;
 
         // Calculate center frequency for this channel
         double channel_spacing = pfb->config.sample_rate / num_channels;
-        chan->center_frequency = (i - (int)(num_channels / 2)) * channel_spacing;
+        chan->center_frequency = ((double)i - (double)(num_channels / 2)) * channel_spacing;
     }
-
-    return true;
 }
 
 /**
@@ -239,79 +430,30 @@ pfb_t *pfb_create(const pfb_config_t *config) {
         return NULL;
     }
 
-    pfb_t *pfb = (pfb_t *)malloc(sizeof(pfb_t));
+    pfb_t *pfb = (pfb_t *)calloc(1, sizeof(pfb_t));
     if (!pfb) return NULL;
 
     // Copy configuration
     memcpy(&pfb->config, config, sizeof(pfb_config_t));
-
-    // Initialize state
-    pfb->initialized = false;
-    pfb->input_index = 0;
-
-    // Allocate input buffer
-    pfb->input_buffer_size = config->block_size * config->num_channels;
-    pfb->input_buffer = (fft_complex_t *)malloc(pfb->input_buffer_size * sizeof(fft_complex_t));
-    if (!pfb->input_buffer) {
+    pfb->filter_length = config->filter_length;
+    pfb->num_branches = config->num_channels;
+    pfb->branch_length = config->filter_length / config->num_channels;
+    pfb->decimation = config->num_channels / config->oversampling;
+
+    // Prototype filter, its polyphase branches and the commutator state
+    if (!allocate_arena(pfb) ||
+        !pfb_load_filter(&pfb->config, pfb->prototype_filter, pfb->transposed_taps)) {
+        pfb_free_members(pfb);
         free(pfb);
         return NULL;
     }
+    initialize_commutator(pfb);
+    initialize_channels(pfb);
 
-    // Design prototype filter
-    if (!design_prototype_filter(pfb)) {
-        free(pfb->input_buffer);
-        free(pfb);
-        return NULL;
-    }
-
-    // Decompose into polyphase branches
-    if (!decompose_polyphase(pfb)) {
-        free(pfb->prototype_filter);
-        free(pfb->input_buffer);
-        free(pfb);
-        return NULL;
-    }
-
-    // Initialize FFT
-    pfb->fft_plan = fft_plan_create(config->fft_size, FFT_FORWARD);
+    // M-point FFT across the branch outputs
+    pfb->fft_plan = fft_plan_f32_create(pfb->num_branches, FFT_FORWARD);
     if (!pfb->fft_plan) {
-        // Cleanup
-        for (uint32_t i = 0; i < pfb->num_branches; i++) {
-            free(pfb->polyphase_filters[i]);
-        }
-        free(pfb->polyphase_filters);
-        free(pfb->prototype_filter);
-        free(pfb->input_buffer);
-        free(pfb);
-        return NULL;
-    }
-
-    // Allocate FFT buffers
-    pfb->fft_input = (fft_complex_t *)malloc(config->fft_size * sizeof(fft_complex_t));
-    pfb->fft_output = (fft_complex_t *)malloc(config->fft_size * sizeof(fft_complex_t));
-    if (!pfb->fft_input || !pfb->fft_output) {
-        fft_plan_destroy(pfb->fft_plan);
-        for (uint32_t i = 0; i < pfb->num_branches; i++) {
-            free(pfb->polyphase_filters[i]);
-        }
-        free(pfb->polyphase_filters);
-        free(pfb->prototype_filter);
-        free(pfb->input_buffer);
-        free(pfb);
-        return NULL;
-    }
-
-    // Initialize channels
-    if (!initialize_channels(pfb)) {
-        free(pfb->fft_output);
-        free(pfb->fft_input);
-        fft_plan_destroy(pfb->fft_plan);
-        for (uint32_t i = 0; i < pfb->num_branches; i++) {
-            free(pfb->polyphase_filters[i]);
-        }
-        free(pfb->polyphase_filters);
-        free(pfb->prototype_filter);
-        free(pfb->input_buffer);
+        pfb_free_members(pfb);
         free(pfb);
         return NULL;
     }
@@ -320,38 +462,55 @@ pfb_t *pfb_create(const pfb_config_t *config) {
     return pfb;
 }
 
+/**
+ * @brief Free everything a (possibly partially) created PFB owns
+ */
+static void pfb_free_members(pfb_t *pfb) {
+    // Free FFT plan, then the arena holding filters, history, channels and rings
+    if (pfb->fft_plan) fft_plan_f32_destroy(pfb->fft_plan);
+    iq_huge_free(pfb->arena);
+}
+
 /**
  * @brief Destroy PFB channelizer instance
  */
 void pfb_destroy(pfb_t *pfb) {
     if (!pfb) return;
 
-    // Free channels
-    if (pfb->channels) {
-        for (uint32_t i = 0; i < pfb->num_channels; i++) {
-            free(pfb->channels[i].buffer);
-        }
-        free(pfb->channels);
-    }
+    pfb_free_members(pfb);
+    free(pfb);
+}
 
-    // Free FFT resources
-    if (pfb->fft_output) free(pfb->fft_output);
-    if (pfb->fft_input) free(pfb->fft_input);
-    if (pfb->fft_plan) fft_plan_destroy(pfb->fft_plan);
+// True when some channel ring has no room for another output: its writer
+// is at the end and the consumer has not drained it yet. The acquire on
+// tail orders the consumer's reads of the front slots before they are
+// overwritten
+static bool any_channel_full(const pfb_t *pfb) {
+    bool full = false;
+    for (uint32_t chan = 0; chan < pfb->num_channels; chan++) {
+        pfb_channel_t *channel = &pfb->channels[chan];
+        if (channel->write_slot < channel->buffer_size) continue;
 
-    // Free polyphase filters
-    if (pfb->polyphase_filters) {
-        for (uint32_t i = 0; i < pfb->num_branches; i++) {
-            free(pfb->polyphase_filters[i]);
-        }
-        free(pfb->polyphase_filters);
+        uint_fast64_t head = atomic_load_explicit(&channel->head, memory_order_relaxed);
+        full |= atomic_load_explicit(&pfb->readers[chan].tail, memory_order_acquire) != head;
     }
+    return full;
+}
 
-    // Free prototype filter and input buffer
-    free(pfb->prototype_filter);
-    free(pfb->input_buffer);
-
-    free(pfb);
+// Append samples to the history; each lands twice, L slots apart, so the
+// last L samples are always contiguous from the oldest slot
+static void append_history(pfb_t *pfb, const float complex *input, uint32_t count) {
+    const uint32_t length = pfb->filter_length;
+
+    while (count > 0) {
+        uint32_t slot = pfb->history_index;
+        uint32_t run = length - slot < count ? length - slot : count;
+        memcpy(pfb->history + slot, input, run * sizeof(fft_complex_f32_t));
+        memcpy(pfb->history + slot + length, input, run * sizeof(fft_complex_f32_t));
+        pfb->history_index = slot + run == length ? 0 : slot + run;
+        input += run;
+        count -= run;
+    }
 }
 
 /**
@@ -362,93 +521,311 @@ int32_t pfb_process_block(pfb_t *pfb, const float complex *input, uint32_t input
         return -1;
     }
 
-    uint32_t samples_processed = 0;
+    uint32_t consumed = 0;
 
-    while (samples_processed < input_length) {
-        // Fill input buffer
-        uint32_t samples_to_copy = pfb->input_buffer_size - pfb->input_index;
-        if (samples_to_copy > input_length - samples_processed) {
-            samples_to_copy = input_length - samples_processed;
-        }
+    while (consumed < input_length) {
+        // Samples up to and including the one completing the next output
+        uint32_t chunk = pfb->decimation - pfb->pending;
+        bool output_due = chunk <= input_length - consumed;
+        if (!output_due) chunk = input_length - consumed;
 
-        memcpy(&pfb->input_buffer[pfb->input_index],
-               &input[samples_processed],
-               samples_to_copy * sizeof(float complex));
+        // The sample completing an output needs room in every channel
+        if (output_due && any_channel_full(pfb)) {
+            output_due = false;
+            if (--chunk == 0) break;
+        }
 
-        pfb->input_index += samples_to_copy;
-        samples_processed += samples_to_copy;
+        append_history(pfb, input + consumed, chunk);
+        consumed += chunk;
+        pfb->pending += chunk;
+        pfb->samples_consumed += chunk;
 
-        // Process complete blocks
-        while (pfb->input_index >= pfb->config.block_size) {
+        if (output_due) {
+            pfb->pending = 0;
             if (!process_fft_block(pfb)) {
                 return -1;
             }
-            pfb->input_index -= pfb->config.block_size;
         }
     }
 
-    return samples_processed;
+    return (int32_t)consumed;
 }
 
-/**
- * @brief Process one FFT block through the PFB
- */
-static bool process_fft_block(pfb_t *pfb) {
-    uint32_t fft_size = pfb->config.fft_size;
-    uint32_t num_channels = pfb->config.num_channels;
+static int pfb_simd_detect(void) {
+#if defined(PFB_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx")) return PFB_SIMD_AVX;
+    if (__builtin_cpu_supports("sse2")) return PFB_SIMD_SSE2;
+    return PFB_SIMD_SCALAR;
+#elif defined(PFB_HAVE_NEON)
+    return PFB_SIMD_NEON;
+#else
+    return PFB_SIMD_SCALAR;
+#endif
+}
+
+void pfb_force_scalar(bool scalar) {
+    atomic_store(&pfb_simd_active, scalar ? PFB_SIMD_SCALAR : pfb_simd_detect());
+}
 
-    // Prepare FFT input (polyphase filtering)
-    for (uint32_t i = 0; i < fft_size; i++) {
-        pfb->fft_input[i] = 0.0 + 0.0 * I;
-
-        // Sum contributions from all polyphase branches
-        for (uint32_t branch = 0; branch < num_channels; branch++) {
-            uint32_t input_idx = pfb->input_index - fft_size + i;
-            if (input_idx < pfb->input_buffer_size) {
-                uint32_t filter_idx = i % pfb->branch_length;
-                fft_complex_t input_sample = pfb->input_buffer[input_idx];
-                double filter_coeff = (double)pfb->polyphase_filters[branch][filter_idx];
-                pfb->fft_input[i] += input_sample * filter_coeff;
+// Column sums out[j] = sum_r taps[r*width + j] * window[r*width + j] for
+// columns [begin, width), rows in order; eight local accumulators at a time
+static void pfb_sweep_scalar(const float *taps, const float *window, uint32_t rows,
+                             uint32_t width, uint32_t begin, float *out) {
+    for (uint32_t j = begin; j < width; j += 8) {
+        uint32_t span = width - j < 8 ? width - j : 8;
+        float acc[8] = {0.0f};
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            for (uint32_t c = 0; c < span; c++) {
+                acc[c] += t[c] * x[c];
             }
         }
+        memcpy(out + j, acc, span * sizeof(float));
+    }
+}
+
+#if defined(PFB_HAVE_X86_SIMD)
+
+// SSE2: four columns per register, up to four registers in flight
+__attribute__((target("sse2")))
+static void pfb_sweep_sse2(const float *taps, const float *window, uint32_t rows,
+                           uint32_t width, float *out) {
+    uint32_t j = 0;
+    for (; j + 16 <= width; j += 16) {
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+        __m128 a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(t), _mm_loadu_ps(x)));
+            a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(t + 4), _mm_loadu_ps(x + 4)));
+            a2 = _mm_add_ps(a2, _mm_mul_ps(_mm_loadu_ps(t + 8), _mm_loadu_ps(x + 8)));
+            a3 = _mm_add_ps(a3, _mm_mul_ps(_mm_loadu_ps(t + 12), _mm_loadu_ps(x + 12)));
+        }
+        _mm_storeu_ps(out + j, a0);
+        _mm_storeu_ps(out + j + 4, a1);
+        _mm_storeu_ps(out + j + 8, a2);
+        _mm_storeu_ps(out + j + 12, a3);
+    }
+    for (; j + 4 <= width; j += 4) {
+        __m128 a = _mm_setzero_ps();
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(t), _mm_loadu_ps(x)));
+        }
+        _mm_storeu_ps(out + j, a);
+    }
+    if (j < width) pfb_sweep_scalar(taps, window, rows, width, j, out);
+}
+
+// AVX: eight columns per register, up to four registers in flight
+__attribute__((target("avx")))
+static void pfb_sweep_avx(const float *taps, const float *window, uint32_t rows,
+                          uint32_t width, float *out) {
+    uint32_t j = 0;
+    for (; j + 32 <= width; j += 32) {
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_loadu_ps(t), _mm256_loadu_ps(x)));
+            a1 = _mm256_add_ps(a1, _mm256_mul_ps(_mm256_loadu_ps(t + 8), _mm256_loadu_ps(x + 8)));
+            a2 = _mm256_add_ps(a2, _mm256_mul_ps(_mm256_loadu_ps(t + 16), _mm256_loadu_ps(x + 16)));
+            a3 = _mm256_add_ps(a3, _mm256_mul_ps(_mm256_loadu_ps(t + 24), _mm256_loadu_ps(x + 24)));
+        }
+        _mm256_storeu_ps(out + j, a0);
+        _mm256_storeu_ps(out + j + 8, a1);
+        _mm256_storeu_ps(out + j + 16, a2);
+        _mm256_storeu_ps(out + j + 24, a3);
     }
+    for (; j + 16 <= width; j += 16) {
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_loadu_ps(t), _mm256_loadu_ps(x)));
+            a1 = _mm256_add_ps(a1, _mm256_mul_ps(_mm256_loadu_ps(t + 8), _mm256_loadu_ps(x + 8)));
+        }
+        _mm256_storeu_ps(out + j, a0);
+        _mm256_storeu_ps(out + j + 8, a1);
+    }
+    for (; j + 8 <= width; j += 8) {
+        __m256 a = _mm256_setzero_ps();
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(t), _mm256_loadu_ps(x)));
+        }
+        _mm256_storeu_ps(out + j, a);
+    }
+    for (; j + 4 <= width; j += 4) {
+        __m128 a = _mm_setzero_ps();
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(t), _mm_loadu_ps(x)));
+        }
+        _mm_storeu_ps(out + j, a);
+    }
+    if (j < width) pfb_sweep_scalar(taps, window, rows, width, j, out);
+}
+
+#endif /* PFB_HAVE_X86_SIMD */
+
+#if defined(PFB_HAVE_NEON)
+
+// NEON: four columns per register, up to four registers in flight. Separate
+// multiply and add (not vmla/vfma) keep the rounding of the scalar path
+static void pfb_sweep_neon(const float *taps, const float *window, uint32_t rows,
+                           uint32_t width, float *out) {
+    uint32_t j = 0;
+    for (; j + 16 <= width; j += 16) {
+        float32x4_t a0 = vdupq_n_f32(0.0f), a1 = vdupq_n_f32(0.0f);
+        float32x4_t a2 = vdupq_n_f32(0.0f), a3 = vdupq_n_f32(0.0f);
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            a0 = vaddq_f32(a0, vmulq_f32(vld1q_f32(t), vld1q_f32(x)));
+            a1 = vaddq_f32(a1, vmulq_f32(vld1q_f32(t + 4), vld1q_f32(x + 4)));
+            a2 = vaddq_f32(a2, vmulq_f32(vld1q_f32(t + 8), vld1q_f32(x + 8)));
+            a3 = vaddq_f32(a3, vmulq_f32(vld1q_f32(t + 12), vld1q_f32(x + 12)));
+        }
+        vst1q_f32(out + j, a0);
+        vst1q_f32(out + j + 4, a1);
+        vst1q_f32(out + j + 8, a2);
+        vst1q_f32(out + j + 12, a3);
+    }
+    for (; j + 4 <= width; j += 4) {
+        float32x4_t a = vdupq_n_f32(0.0f);
+        for (uint32_t r = 0; r < rows; r++) {
+            const float *t = taps + (size_t)r * width + j;
+            const float *x = window + (size_t)r * width + j;
+            a = vaddq_f32(a, vmulq_f32(vld1q_f32(t), vld1q_f32(x)));
+        }
+        vst1q_f32(out + j, a);
+    }
+    if (j < width) pfb_sweep_scalar(taps, window, rows, width, j, out);
+}
+
+#endif /* PFB_HAVE_NEON */
+
+void pfb_sweep_columns(const float *taps, const float *window, uint32_t rows, uint32_t width,
+                       float *out) {
+    int simd = atomic_load(&pfb_simd_active);
+    if (simd < 0) {
+        simd = pfb_simd_detect();
+        atomic_store(&pfb_simd_active, simd);
+    }
+
+    switch (simd) {
+#if defined(PFB_HAVE_X86_SIMD)
+        case PFB_SIMD_AVX:  pfb_sweep_avx(taps, window, rows, width, out); break;
+        case PFB_SIMD_SSE2: pfb_sweep_sse2(taps, window, rows, width, out); break;
+#endif
+#if defined(PFB_HAVE_NEON)
+        case PFB_SIMD_NEON: pfb_sweep_neon(taps, window, rows, width, out); break;
+#endif
+        default:            pfb_sweep_scalar(taps, window, rows, width, 0, out); break;
+    }
+}
+
+/**
+ * @brief Produce one output per channel from the current history
+ */
+static bool process_fft_block(pfb_t *pfb) {
+    const uint32_t num_branches = pfb->num_branches;
+
+    // u[j] = v[M-1-j], interleaved I/Q straight into the FFT input
+    const float *window = (const float *)(pfb->history + pfb->history_index);
+    pfb_sweep_columns(pfb->transposed_taps, window, pfb->branch_length, 2 * num_branches,
+                      (float *)pfb->fft_input);
 
     // Execute FFT
-    if (!fft_execute(pfb->fft_plan, pfb->fft_input, pfb->fft_output)) {
+    if (!fft_execute_f32(pfb->fft_plan, pfb->fft_input, pfb->fft_output)) {
         return false;
     }
 
-    // Extract channels from FFT output
-    for (uint32_t chan = 0; chan < num_channels; chan++) {
+    // Channel i sits at (i - M/2) * fs / M, i.e. FFT channel k = (i - M/2) mod M
+    const uint32_t half = pfb->num_channels / 2;
+    const uint32_t shift = (uint32_t)(pfb->samples_consumed % num_branches);
+    for (uint32_t chan = 0; chan < pfb->num_channels; chan++) {
         pfb_channel_t *channel = &pfb->channels[chan];
+        uint32_t k = (chan + num_branches - half) % num_branches;
+        uint32_t rotation = (k * shift) % num_branches;
+        fft_complex_f32_t y = pfb->fft_output[k] * pfb->phase_table[rotation];
+
+        // any_channel_full() saw every ring at its end drained, so it may
+        // start over; the release makes the output readable
+        uint32_t slot = channel->write_slot == channel->buffer_size ? 0 : channel->write_slot;
+        channel->buffer[slot] = y;
+        channel->write_slot = slot + 1;
+        uint_fast64_t head = atomic_load_explicit(&channel->head, memory_order_relaxed);
+        atomic_store_explicit(&channel->head, head + 1, memory_order_release);
+    }
 
-        // Ensure buffer has space
-        if (channel->samples_written >= channel->buffer_size) {
-            // Buffer full - in a real implementation, you'd want to handle this
-            continue;
-        }
+    return true;
+}
 
-        // Extract channel sample (with proper frequency mapping)
-        uint32_t fft_idx = (chan * fft_size / num_channels) % fft_size;
-        // Convert from double complex to float complex for channel storage
-        channel->buffer[channel->samples_written] = (float complex)pfb->fft_output[fft_idx];
-        channel->samples_written++;
+/**
+ * @brief Get the unread outputs of a channel as one span
+ */
+const float complex *pfb_channel_read(const pfb_t *pfb, uint32_t channel_index,
+                                      uint32_t *samples) {
+    if (!pfb || !pfb->initialized || channel_index >= pfb->num_channels || !samples) {
+        return NULL;
     }
 
+    // The acquire on head makes every output before it visible
+    pfb_channel_t *channel = &pfb->channels[channel_index];
+    pfb_reader_t *reader = &pfb->readers[channel_index];
+    uint_fast64_t tail = atomic_load_explicit(&reader->tail, memory_order_relaxed);
+    uint_fast64_t head = atomic_load_explicit(&channel->head, memory_order_acquire);
+
+    *samples = (uint32_t)(head - tail);
+    return channel->buffer + reader->read_slot;
+}
+
+// Consume up to samples outputs (all unread ones when samples is
+// UINT32_MAX); false if fewer are unread
+static bool advance_reader(pfb_t *pfb, uint32_t channel_index, uint32_t samples) {
+    pfb_channel_t *channel = &pfb->channels[channel_index];
+    pfb_reader_t *reader = &pfb->readers[channel_index];
+    uint_fast64_t tail = atomic_load_explicit(&reader->tail, memory_order_relaxed);
+    uint_fast64_t head = atomic_load_explicit(&channel->head, memory_order_acquire);
+    if (samples == UINT32_MAX) {
+        samples = (uint32_t)(head - tail);
+    } else if (samples > head - tail) {
+        return false;
+    }
+
+    // A drained end of the ring means the producer writes the front next
+    reader->read_slot += samples;
+    if (reader->read_slot == channel->buffer_size) reader->read_slot = 0;
+    atomic_store_explicit(&reader->tail, tail + samples, memory_order_release);
     return true;
 }
 
+/**
+ * @brief Release the oldest outputs of a channel
+ */
+bool pfb_channel_commit(pfb_t *pfb, uint32_t channel_index, uint32_t samples) {
+    if (!pfb || !pfb->initialized || channel_index >= pfb->num_channels ||
+        samples == UINT32_MAX) {
+        return false;
+    }
+
+    return advance_reader(pfb, channel_index, samples);
+}
+
 /**
  * @brief Get channel output buffer
  */
 const float complex *pfb_get_channel_output(const pfb_t *pfb, uint32_t channel_index,
                                           uint32_t *samples) {
-    if (!pfb || !pfb->initialized || channel_index >= pfb->num_channels || !samples) {
-        return NULL;
-    }
-
-    *samples = pfb->channels[channel_index].samples_written;
-    return pfb->channels[channel_index].buffer;
+    return pfb_channel_read(pfb, channel_index, samples);
 }
 
 /**
@@ -459,8 +836,7 @@ bool pfb_reset_channel_output(pfb_t *pfb, uint32_t channel_index) {
         return false;
     }
 
-    pfb->channels[channel_index].samples_written = 0;
-    return true;
+    return advance_reader(pfb, channel_index, UINT32_MAX);
 }
 
 /**
@@ -472,12 +848,13 @@ bool pfb_get_statistics(const pfb_t *pfb, uint64_t *total_samples,
         return false;
     }
 
-    // This is a simplified implementation - in practice you'd track actual sample counts
-    *total_samples = 0;
+    *total_samples = pfb->samples_consumed;
 
     if (channel_samples && channel_samples_size >= pfb->num_channels) {
         for (uint32_t i = 0; i < pfb->num_channels; i++) {
-            channel_samples[i] = pfb->channels[i].samples_written;
+            pfb_channel_t *channel = &pfb->channels[i];
+            channel_samples[i] = atomic_load_explicit(&channel->head, memory_order_acquire) -
+                                 atomic_load_explicit(&pfb->readers[i].tail, memory_order_relaxed);
         }
     }
 
@@ -498,6 +875,31 @@ double pfb_calculate_isolation(const pfb_config_t *config) {
     return isolation_db;
 }
 
+/**
+ * @brief Estimate the real multiply-adds per input sample
+ */
+double pfb_estimate_cost(const pfb_config_t *config) {
+    if (!pfb_config_validate(config)) return -1.0;
+
+    // Per output, every M / oversampling inputs: the tap sweep (2L), the
+    // M-point FFT at the usual 5 M log2 M, and about 16 per channel for the
+    // rotation, buffer store and full check (fitted to bench_pfb timings)
+    double M = config->num_channels;
+    double per_output = 2.0 * config->filter_length + 5.0 * M * log2(M) + 16.0 * M;
+    return per_output * config->oversampling / M;
+}
+
+/**
+ * @brief Get the channel output sample rate
+ */
+double pfb_get_output_rate(const pfb_t *pfb) {
+    if (!pfb || !pfb->initialized) {
+        return -1.0;
+    }
+
+    return pfb->config.sample_rate / (double)pfb->decimation;
+}
+
 /**
  * @brief Get channel center frequency
  */
@@ -530,10 +932,10 @@ bool pfb_get_config_string(const pfb_t *pfb, char *buffer, uint32_t buffer_size)
 
     int written = snprintf(buffer, buffer_size,
                           "PFB Config: %u channels, %.0f Hz sample rate, %.0f Hz/channel, "
-                          "%u tap filter, %u FFT size",
+                          "%u tap filter (%u per branch), %ux oversampled",
                           pfb->config.num_channels, pfb->config.sample_rate,
                           pfb->config.channel_bandwidth, pfb->config.filter_length,
-                          pfb->config.fft_size);
+                          pfb->branch_length, pfb->config.oversampling);
 
     return written > 0 && (uint32_t)written < buffer_size;
 }
@@ -546,12 +948,66 @@ bool pfb_reset(pfb_t *pfb) {
         return false;
     }
 
-    pfb->input_index = 0;
+    // Silent history, writing from slot 0 again
+    memset(pfb->history, 0, 2 * (size_t)pfb->filter_length * sizeof(fft_complex_f32_t));
+    pfb->history_index = 0;
+    pfb->pending = 0;
+    pfb->samples_consumed = 0;
 
-    // Reset all channel buffers
+    // Empty every channel ring; no consumer may be reading meanwhile
     for (uint32_t i = 0; i < pfb->num_channels; i++) {
-        pfb->channels[i].samples_written = 0;
+        pfb_channel_t *channel = &pfb->channels[i];
+        channel->write_slot = 0;
+        atomic_store_explicit(&channel->head, 0, memory_order_relaxed);
+        pfb->readers[i].read_slot = 0;
+        atomic_store_explicit(&pfb->readers[i].tail, 0, memory_order_relaxed);
+    }
+
+    return true;
+}
+
+// Stream position of a checkpointed bank, with the geometry it belongs to
+typedef struct {
+    uint32_t num_branches;
+    uint32_t filter_length;
+    uint32_t decimation;
+    uint32_t history_index;
+    uint32_t pending;
+    uint64_t samples_consumed;
+} pfb_stream_state_t;
+
+bool pfb_save_state(const pfb_t *pfb, checkpoint_writer_t *writer) {
+    if (!pfb || !pfb->initialized || !writer) {
+        return false;
+    }
+
+    pfb_stream_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.num_branches = pfb->num_branches;
+    state.filter_length = pfb->filter_length;
+    state.decimation = pfb->decimation;
+    state.history_index = pfb->history_index;
+    state.pending = pfb->pending;
+    state.samples_consumed = pfb->samples_consumed;
+    return checkpoint_put(writer, "pfb.stream", &state, sizeof(state)) &&
+           checkpoint_put(writer, "pfb.history", pfb->history,
+                          2 * (size_t)pfb->filter_length * sizeof(fft_complex_f32_t));
+}
+
+bool pfb_load_state(pfb_t *pfb, const checkpoint_t *checkpoint) {
+    pfb_stream_state_t state;
+    if (!pfb_reset(pfb) || !checkpoint_get(checkpoint, "pfb.stream", &state, sizeof(state)) ||
+        state.num_branches != pfb->num_branches || state.filter_length != pfb->filter_length ||
+        state.decimation != pfb->decimation || state.history_index >= pfb->filter_length ||
+        state.pending >= pfb->decimation ||
+        !checkpoint_get(checkpoint, "pfb.history", pfb->history,
+                        2 * (size_t)pfb->filter_length * sizeof(fft_complex_f32_t))) {
+        pfb_reset(pfb);
+        return false;
     }
 
+    pfb->history_index = state.history_index;
+    pfb->pending = state.pending;
+    pfb->samples_consumed = state.samples_consumed;
     return true;
 }
@@ -8,11 +8,46 @@
  * Date: 2025
  *
  * Key Features:
- * - Configurable number of channels (4-32)
+ * - Configurable number of channels (4-4096)
  * - Automatic Kaiser window filter design
  * - High channel isolation (>55 dB typical)
  * - Memory-efficient block processing
  * - Real-time capable implementation
+ *
+ * Structure (M channels, prototype of L = M * P taps):
+ * - The input goes into one mirrored history of its last L samples, so the
+ *   filter window is always contiguous, oldest to newest
+ * - The taps are stored transposed: P rows of M branches, row r holding tap
+ *   q = P-1-r of every branch in window order and duplicated for I and Q.
+ *   Row r of the taps lines up with row r of the window, so a SIMD register
+ *   covers several branches at the same tap and the M branch dot products
+ *   are one elementwise multiply-add sweep over 2L contiguous floats
+ * - Every D = M / oversampling new samples, that sweep and an M-point FFT
+ *   across the branch outputs yield one sample per channel, with the
+ *   per-channel phase rotation the input offset requires
+ * - Taps, history, FFT buffers, phase table, the channel states and every
+ *   channel's output ring share one 64-byte aligned arena; each region
+ *   starts on its own cache line
+ * - Each channel output is a single-producer / single-consumer ring with
+ *   head and tail indices like iq_spsc_t: the thread running
+ *   pfb_process_block writes, one other thread (or the same one) reads
+ *   spans in place with pfb_channel_read() and frees them with
+ *   pfb_channel_commit(). The writer's indices and the reader's live in
+ *   separate arrays, so the two threads never write the same cache line.
+ *   The writer only wraps back to slot 0 once the ring has been drained,
+ *   so the unread outputs are always one contiguous span and the writer
+ *   only looks at the reader's index at the wrap. A full ring pauses the
+ *   PFB instead of dropping outputs
+ * - Large banks (hundreds to thousands of channels) cost P multiply-adds
+ *   plus one M-point FFT per M/oversampling input samples, so the work per
+ *   input sample only grows with log M; the defaults keep at least
+ *   PFB_MIN_BRANCH_TAPS taps per branch and bound the output buffers to
+ *   PFB_OUTPUT_BUDGET samples in total
+ * - Cost per output: M * P multiply-adds plus one M-point FFT, i.e. P
+ *   multiply-adds per input sample when critically sampled
+ * - With cache_dir set, the designed prototype and its transposed taps are
+ *   kept on disk, one file per (M, L, Kaiser beta, overlap, cutoff), so
+ *   later runs with the same plan skip the filter design entirely
  */
 
 #ifndef PFB_H
@@ -20,12 +55,24 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <complex.h>
+#include <stdatomic.h>
 #include "../iq_core/fft.h"
+#include "../iq_core/checkpoint.h"
+
+// Channel count limits
+#define PFB_MIN_CHANNELS 4
+#define PFB_MAX_CHANNELS 4096
+
+// Defaults for large banks: taps per branch floor, total buffered outputs
+#define PFB_MIN_BRANCH_TAPS 16
+#define PFB_OUTPUT_BUDGET (1u << 20)
 
 // Forward declarations
 typedef struct pfb_t pfb_t;
 typedef struct pfb_channel_t pfb_channel_t;
+typedef struct pfb_reader_t pfb_reader_t;
 typedef struct pfb_config_t pfb_config_t;
 
 /**
@@ -34,28 +81,41 @@ typedef struct pfb_config_t pfb_config_t;
  * Defines the parameters for polyphase filter bank operation
  */
 struct pfb_config_t {
-    uint32_t num_channels;        // Number of output channels (4-32)
-    uint32_t filter_length;       // Length of prototype filter (power of 2)
-    uint32_t fft_size;           // FFT size for polyphase decomposition
+    uint32_t num_channels;        // Number of output channels (4-4096)
+    uint32_t filter_length;       // Length of prototype filter (power of 2, multiple of num_channels)
+    uint32_t fft_size;           // Commutator FFT size: one point per branch (= num_channels)
     double sample_rate;          // Input sample rate (Hz)
     double channel_bandwidth;    // Bandwidth per channel (Hz)
     double overlap_factor;       // Channel overlap (0.0-0.5)
     double kaiser_beta;          // Kaiser window beta parameter
-    uint32_t block_size;         // Processing block size
+    uint32_t oversampling;       // 1: critically sampled (decimate by M), 2: 2x oversampled (M/2)
+    uint32_t block_size;         // Channel output ring capacity (samples)
+    const char *cache_dir;       // Directory of cached prototypes (NULL: design every time)
 };
 
 /**
  * @brief Individual Channel State
  *
- * Tracks state for each output channel
+ * Tracks state for each output channel; written by the producer only.
+ * The unread outputs, reader tail to head-1, sit contiguously from
+ * buffer[read_slot] of the channel's pfb_reader_t.
  */
 struct pfb_channel_t {
-    float complex *buffer;       // Channel output buffer
-    uint32_t buffer_size;        // Size of output buffer
-    uint32_t samples_written;    // Samples written to current buffer
+    float complex *buffer;       // Output ring (a slice of pfb_t.channel_outputs)
+    uint32_t buffer_size;        // Ring capacity (outputs)
+    uint32_t write_slot;         // Next slot written; wraps to 0 only when the ring is empty (producer)
     double center_frequency;     // Channel center frequency (Hz)
     double bandwidth;            // Channel bandwidth (Hz)
     uint32_t channel_index;      // Channel index (0 to num_channels-1)
+    atomic_uint_fast64_t head;   // Outputs written
+};
+
+/**
+ * @brief Consumer side of a channel ring; written by the consumer only
+ */
+struct pfb_reader_t {
+    atomic_uint_fast64_t tail;   // Outputs consumed
+    uint32_t read_slot;          // Slot of the oldest unread output
 };
 
 /**
@@ -67,27 +127,35 @@ struct pfb_t {
     pfb_config_t config;         // Configuration parameters
 
     // Filter design
-    float *prototype_filter;     // Prototype filter coefficients
+    float *prototype_filter;     // Prototype filter coefficients (in the arena)
     uint32_t filter_length;      // Length of prototype filter
 
     // Polyphase decomposition
-    float **polyphase_filters;   // Polyphase filter branches
-    uint32_t num_branches;       // Number of polyphase branches
-    uint32_t branch_length;      // Length of each branch
+    uint32_t num_branches;       // Number of polyphase branches (M)
+    uint32_t branch_length;      // Taps per branch (P)
+    uint32_t decimation;         // Input samples per channel output (M / oversampling)
+
+    // Filter state, all inside the arena
+    void *arena;                 // Single allocation behind every region below
+    float *transposed_taps;      // P rows of 2M floats: [r*2M + 2j + c] = h[L-1-rM-j], c = I, Q
+    fft_complex_f32_t *history;  // Last L input samples, stored twice: [w, w + L) oldest to newest
+    uint32_t history_index;      // w: oldest slot, the next one written
 
     // FFT processing
-    void *fft_plan;             // FFT plan (implementation specific)
-    fft_complex_t *fft_input;   // FFT input buffer
-    fft_complex_t *fft_output;  // FFT output buffer
+    fft_plan_f32_t *fft_plan;       // M-point single-precision FFT plan
+    fft_complex_f32_t *fft_input;   // Branch outputs, branch M-1 first
+    fft_complex_f32_t *fft_output;  // FFT across the branches
+    fft_complex_f32_t *phase_table; // exp(-2*pi*j*t/M), t = 0..M-1
+    fft_complex_f32_t *channel_outputs; // M rings of block_size, channel c from [c * block_size]
 
     // Channel management
-    pfb_channel_t *channels;    // Array of channel states
+    pfb_channel_t *channels;    // Array of channel states (in the arena)
+    pfb_reader_t *readers;      // Consumer index per channel (in the arena, own cache lines)
     uint32_t num_channels;      // Number of active channels
 
-    // Processing state
-    fft_complex_t *input_buffer; // Input sample buffer
-    uint32_t input_buffer_size;  // Size of input buffer
-    uint32_t input_index;        // Current input buffer position
+    // Commutator state
+    uint32_t pending;            // Input samples since the last output
+    uint64_t samples_consumed;   // Input samples since create/reset
 
     // Memory management
     bool initialized;           // Initialization flag
@@ -131,16 +199,114 @@ void pfb_destroy(pfb_t *pfb);
 /**
  * @brief Process a block of IQ samples through the PFB
  *
+ * Samples are consumed one at a time; every decimation-th sample produces
+ * one output per channel. Consumption stops early, without dropping
+ * anything, when an output is due and a channel ring is full: drain the
+ * channels (or wait for the consumer thread to) and pass the remaining
+ * samples again.
+ *
  * @param pfb Pointer to PFB instance
  * @param input Complex input samples (I + j*Q)
  * @param input_length Number of input samples
- * @return Number of samples processed, negative on error
+ * @return Number of samples consumed, negative on error
  */
 int32_t pfb_process_block(pfb_t *pfb, const float complex *input, uint32_t input_length);
 
+/**
+ * @brief Design the prototype low-pass filter of a configuration
+ *
+ * Kaiser-windowed sinc with cutoff channel_bandwidth / 2 and unit DC gain;
+ * the PFB and the DDC bank share it, so their channels match.
+ *
+ * @param config Pointer to validated configuration
+ * @param taps Output array of config->filter_length coefficients
+ * @return true on success, false on error
+ */
+bool pfb_design_prototype(const pfb_config_t *config, float *taps);
+
+/**
+ * @brief Load the prototype and transposed taps from the cache, or design them
+ *
+ * Without config->cache_dir this designs the prototype and decomposes it.
+ * With it, a cache file written for the same channel count, filter length,
+ * Kaiser beta, overlap and cutoff is read instead; a missing, stale or
+ * corrupt file is replaced by a freshly designed one. Failing to write the
+ * cache is not an error.
+ *
+ * @param config Filter configuration
+ * @param prototype Output array of filter_length coefficients
+ * @param transposed_taps Output array of 2 * filter_length floats, laid out
+ *                        as pfb_t.transposed_taps
+ * @return true on success, false on error
+ */
+bool pfb_load_filter(const pfb_config_t *config, float *prototype, float *transposed_taps);
+
+/**
+ * @brief Path of the cache file for a filter configuration
+ *
+ * @param config Filter configuration with cache_dir set
+ * @param path Output buffer
+ * @param size Size of path in bytes
+ * @return true on success, false without cache_dir or when path is too small
+ */
+bool pfb_filter_cache_path(const pfb_config_t *config, char *path, size_t size);
+
+/**
+ * @brief Sum the columns of an elementwise product, SIMD dispatched
+ *
+ * out[j] = sum over r of taps[r * width + j] * window[r * width + j] for
+ * j < width, rows accumulated in order; bit-identical on every path.
+ *
+ * @param taps Row-major coefficients, rows * width floats
+ * @param window Row-major data, rows * width floats
+ * @param rows Number of rows
+ * @param width Floats per row
+ * @param out Output array of width floats
+ */
+void pfb_sweep_columns(const float *taps, const float *window, uint32_t rows, uint32_t width,
+                       float *out);
+
+/**
+ * @brief Force the scalar tap loop instead of the detected SIMD path
+ *
+ * Both give bit-identical outputs; intended for tests and benchmarks.
+ *
+ * @param scalar true for scalar, false to return to auto-detection
+ */
+void pfb_force_scalar(bool scalar);
+
+/**
+ * @brief Get the unread outputs of a channel as one span, without copying
+ *
+ * Consumer side of the channel ring: may run on another thread than
+ * pfb_process_block. The span stays valid and unchanged until it is
+ * committed; outputs written meanwhile are picked up by the next read.
+ * Once the writer reaches the end of the ring it waits for the span to be
+ * committed in full before starting over at the front.
+ *
+ * @param pfb Pointer to PFB instance
+ * @param channel_index Channel index (0 to num_channels-1)
+ * @param samples Pointer to receive number of readable samples
+ * @return Pointer to the oldest unread output, NULL on error
+ */
+const float complex *pfb_channel_read(const pfb_t *pfb, uint32_t channel_index,
+                                      uint32_t *samples);
+
+/**
+ * @brief Release the oldest outputs of a channel back to the PFB
+ *
+ * @param pfb Pointer to PFB instance
+ * @param channel_index Channel index (0 to num_channels-1)
+ * @param samples Number of outputs consumed, at most what the last read returned
+ * @return true on success, false on error or when samples exceeds the unread count
+ */
+bool pfb_channel_commit(pfb_t *pfb, uint32_t channel_index, uint32_t samples);
+
 /**
  * @brief Get channel output buffer
  *
+ * Same as pfb_channel_read().
+ *
  * @param pfb Pointer to PFB instance
  * @param channel_index Channel index (0 to num_channels-1)
  * @param samples Pointer to receive number of available samples
@@ -152,6 +318,10 @@ const float complex *pfb_get_channel_output(const pfb_t *pfb, uint32_t channel_i
 /**
  * @brief Reset channel output buffer (mark as consumed)
  *
+ * Commits every unread output. Only for a consumer on the producer's
+ * thread: from another thread it would also discard outputs written after
+ * the last read, so use pfb_channel_commit() there.
+ *
  * @param pfb Pointer to PFB instance
  * @param channel_index Channel index (0 to num_channels-1)
  * @return true on success, false on error
@@ -163,7 +333,7 @@ bool pfb_reset_channel_output(pfb_t *pfb, uint32_t channel_index);
  *
  * @param pfb Pointer to PFB instance
  * @param total_samples Pointer to receive total samples processed
- * @param channel_samples Array to receive samples per channel
+ * @param channel_samples Array to receive unread samples per channel
  * @param channel_samples_size Size of channel_samples array
  * @return true on success, false on error
  */
@@ -178,6 +348,25 @@ bool pfb_get_statistics(const pfb_t *pfb, uint64_t *total_samples,
  */
 double pfb_calculate_isolation(const pfb_config_t *config);
 
+/**
+ * @brief Estimate the processing cost of a configuration
+ *
+ * Counts the tap sweep, commutator FFT and channel rotations; the DDC bank
+ * (ddc.h) uses the same units to pick the cheaper of the two.
+ *
+ * @param config Pointer to configuration
+ * @return Real multiply-adds per input sample, negative on error
+ */
+double pfb_estimate_cost(const pfb_config_t *config);
+
+/**
+ * @brief Get the channel output sample rate
+ *
+ * @param pfb Pointer to PFB instance
+ * @return sample_rate * oversampling / num_channels in Hz, negative on error
+ */
+double pfb_get_output_rate(const pfb_t *pfb);
+
 /**
  * @brief Get channel center frequency
  *
@@ -214,4 +403,27 @@ bool pfb_get_config_string(const pfb_t *pfb, char *buffer, uint32_t buffer_size)
  */
 bool pfb_reset(pfb_t *pfb);
 
+/**
+ * @brief Save the filter state to a checkpoint
+ *
+ * Every channel ring must have been read out: outputs still buffered are
+ * not saved.
+ *
+ * @param pfb Pointer to PFB instance
+ * @param writer Open checkpoint
+ * @return true on success, false on error
+ */
+bool pfb_save_state(const pfb_t *pfb, checkpoint_writer_t *writer);
+
+/**
+ * @brief Restore the filter state of pfb_save_state, with empty rings
+ *
+ * The bank must have the configuration of the saved one.
+ *
+ * @param pfb Pointer to PFB instance
+ * @param checkpoint Loaded checkpoint
+ * @return true on success, false if missing or of another configuration
+ */
+bool pfb_load_state(pfb_t *pfb, const checkpoint_t *checkpoint);
+
 #endif /* PFB_H */
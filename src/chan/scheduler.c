@@ -2,13 +2,33 @@
  * IQ Lab - scheduler.c: Channel Processing Scheduler Implementation
  *
  * Purpose: Manages scheduling and coordination of channel processing tasks
- * with overlap handling, priority management, and resource optimization.
+ * with overlap handling, priority management, and resource optimization,
+ * and executes runnable tasks on a work-stealing thread pool.
+ *
+ * Task slots never move: a task ID is its slot index until the task is
+ * removed (booked tasks) or has run (runnable tasks), and free slots are
+ * kept on a stack. Both heaps store task IDs and every slot remembers its
+ * heap position, so completing or removing a booked task is O(log n).
+ *
+ * The scheduler lock guards the slots, the heaps and the counters. The
+ * deques are lock-free (Chase-Lev, fixed capacity): only their owner
+ * pushes and takes, any worker may steal. A worker looks for work in its
+ * own deque, then the ready heap, then the other deques, and sleeps on
+ * work_cond while the queued count is zero; that count only grows under
+ * the lock, so no wake-up is lost.
+ *
+ * Pooled buffers carry a one-line header naming their size class. A free
+ * pushes the block onto the freeing worker's cache for that class, or the
+ * shared list under pool_lock, and an allocation pops it again: both are
+ * O(1) and a worker that keeps reusing the same sizes never takes a lock.
  *
  *
  * Date: 2025
  */
 
 #include "scheduler.h"
+#include "../iq_core/stft.h"
+#include "../iq_core/affinity.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -18,6 +38,347 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// Slot states
+enum {
+    SLOT_FREE = 0,               // Unused, on the free stack
+    SLOT_PENDING,                // Booked task waiting in the pending heap
+    SLOT_DONE,                   // Booked task marked completed
+    SLOT_QUEUED                  // Runnable task queued or running
+};
+
+// Marks an empty deque; task IDs are below max_tasks
+#define SCHEDULER_NO_TASK UINT32_MAX
+
+// The worker running on this thread, NULL outside any pool
+static _Thread_local scheduler_worker_t *current_worker = NULL;
+
+// Monotonic enough for task timings: seconds since the epoch
+static double clock_seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+// The lock of a scheduler passed as const
+static pthread_mutex_t *scheduler_lock(const scheduler_t *scheduler) {
+    return (pthread_mutex_t *)&scheduler->lock;
+}
+
+/*
+ * Priority heaps
+ */
+
+// True when task a runs before task b
+static bool task_before(const scheduler_t *scheduler, uint32_t a, uint32_t b) {
+    if (scheduler->config.enable_priority) {
+        const channel_task_t *ta = &scheduler->tasks[a];
+        const channel_task_t *tb = &scheduler->tasks[b];
+        if (ta->priority != tb->priority) return ta->priority < tb->priority;
+        if (ta->start_time != tb->start_time) return ta->start_time < tb->start_time;
+    }
+    return scheduler->slots[a].sequence < scheduler->slots[b].sequence;
+}
+
+static void heap_place(scheduler_t *scheduler, scheduler_heap_t *heap, uint32_t position,
+                       uint32_t id) {
+    heap->items[position] = id;
+    scheduler->slots[id].heap_position = position;
+}
+
+static void heap_sift_up(scheduler_t *scheduler, scheduler_heap_t *heap, uint32_t position) {
+    uint32_t id = heap->items[position];
+    while (position > 0) {
+        uint32_t parent = (position - 1) / 2;
+        if (!task_before(scheduler, id, heap->items[parent])) break;
+        heap_place(scheduler, heap, position, heap->items[parent]);
+        position = parent;
+    }
+    heap_place(scheduler, heap, position, id);
+}
+
+static void heap_sift_down(scheduler_t *scheduler, scheduler_heap_t *heap, uint32_t position) {
+    uint32_t id = heap->items[position];
+    for (;;) {
+        uint32_t child = 2 * position + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && task_before(scheduler, heap->items[child + 1], heap->items[child])) {
+            child++;
+        }
+        if (!task_before(scheduler, heap->items[child], id)) break;
+        heap_place(scheduler, heap, position, heap->items[child]);
+        position = child;
+    }
+    heap_place(scheduler, heap, position, id);
+}
+
+static void heap_push(scheduler_t *scheduler, scheduler_heap_t *heap, uint32_t id) {
+    heap_place(scheduler, heap, heap->count++, id);
+    heap_sift_up(scheduler, heap, heap->count - 1);
+}
+
+// Take the entry at position out of the heap
+static void heap_remove(scheduler_t *scheduler, scheduler_heap_t *heap, uint32_t position) {
+    uint32_t last = heap->items[--heap->count];
+    if (position == heap->count) return;
+
+    heap_place(scheduler, heap, position, last);
+    heap_sift_up(scheduler, heap, position);
+    heap_sift_down(scheduler, heap, scheduler->slots[last].heap_position);
+}
+
+static uint32_t heap_pop(scheduler_t *scheduler, scheduler_heap_t *heap) {
+    if (heap->count == 0) return SCHEDULER_NO_TASK;
+    uint32_t id = heap->items[0];
+    heap_remove(scheduler, heap, 0);
+    return id;
+}
+
+static void heap_rebuild(scheduler_t *scheduler, scheduler_heap_t *heap) {
+    for (uint32_t i = heap->count / 2; i-- > 0; ) {
+        heap_sift_down(scheduler, heap, i);
+    }
+}
+
+/*
+ * Work-stealing deques (Chase and Lev). The bottom store and top load of
+ * take and the two loads of steal are sequentially consistent, which
+ * orders a take against a concurrent steal of the last task.
+ */
+
+static bool deque_init(scheduler_deque_t *deque, uint32_t capacity) {
+    deque->items = (atomic_uint *)calloc(capacity, sizeof(atomic_uint));
+    if (!deque->items) return false;
+    deque->capacity = capacity;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    return true;
+}
+
+// Owner only
+static void deque_push(scheduler_deque_t *deque, uint32_t id) {
+    int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    atomic_store_explicit(&deque->items[bottom % deque->capacity], id, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+}
+
+// Owner only: the newest task, SCHEDULER_NO_TASK when empty
+static uint32_t deque_take(scheduler_deque_t *deque) {
+    int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_seq_cst);
+    int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return SCHEDULER_NO_TASK;
+    }
+
+    uint32_t id = atomic_load_explicit(&deque->items[bottom % deque->capacity], memory_order_relaxed);
+    if (top == bottom) {
+        // Last task: race the thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            id = SCHEDULER_NO_TASK;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return id;
+}
+
+// Any thread: the oldest task, SCHEDULER_NO_TASK when empty or lost to another thief
+static uint32_t deque_steal(scheduler_deque_t *deque) {
+    int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+    int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_seq_cst);
+    if (top >= bottom) return SCHEDULER_NO_TASK;
+
+    uint32_t id = atomic_load_explicit(&deque->items[top % deque->capacity], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return SCHEDULER_NO_TASK;
+    }
+    return id;
+}
+
+/*
+ * Buffer pool
+ */
+
+// Header magic values
+#define BLOCK_IN_USE 0x5C4EB10Cu
+#define BLOCK_FREE   0x5C4EF4EEu
+
+_Static_assert(sizeof(scheduler_block_t) <= SCHEDULER_BUFFER_ALIGNMENT,
+               "block header must fit in one alignment unit");
+
+static size_t class_bytes(uint32_t size_class) {
+    return (size_t)SCHEDULER_BUFFER_ALIGNMENT << size_class;
+}
+
+// Smallest class holding size bytes, SCHEDULER_SIZE_CLASSES when none does
+static uint32_t class_for_size(uint32_t size) {
+    uint32_t units = (uint32_t)(((uint64_t)size + SCHEDULER_BUFFER_ALIGNMENT - 1) /
+                                SCHEDULER_BUFFER_ALIGNMENT);
+    uint32_t size_class = 0;
+    while (size_class < SCHEDULER_SIZE_CLASSES && (1u << size_class) < units) {
+        size_class++;
+    }
+    return size_class;
+}
+
+static void *block_buffer(scheduler_block_t *block) {
+    return (unsigned char *)block + SCHEDULER_BUFFER_ALIGNMENT;
+}
+
+static scheduler_block_t *buffer_block(void *buffer) {
+    return (scheduler_block_t *)((unsigned char *)buffer - SCHEDULER_BUFFER_ALIGNMENT);
+}
+
+// A new block from the system: header and buffer on their own cache lines
+static scheduler_block_t *block_create(scheduler_t *scheduler, uint32_t size_class, uint32_t size) {
+    size_t bytes = size_class < SCHEDULER_SIZE_CLASSES ? class_bytes(size_class) : size;
+    void *raw = malloc(bytes + 2 * SCHEDULER_BUFFER_ALIGNMENT - 1);
+    if (!raw) return NULL;
+
+    uintptr_t base = ((uintptr_t)raw + SCHEDULER_BUFFER_ALIGNMENT - 1) &
+                     ~(uintptr_t)(SCHEDULER_BUFFER_ALIGNMENT - 1);
+    scheduler_block_t *block = (scheduler_block_t *)base;
+    block->raw = raw;
+    block->owner = scheduler;
+    block->size_class = size_class;
+    return block;
+}
+
+static void release_blocks(scheduler_block_t *list) {
+    while (list) {
+        scheduler_block_t *next = list->next;
+        free(list->raw);
+        list = next;
+    }
+}
+
+// Return a worker's cached blocks to the system; the worker must be idle
+static void drain_worker_cache(scheduler_worker_t *worker) {
+    for (uint32_t c = 0; c < SCHEDULER_SIZE_CLASSES; c++) {
+        release_blocks(worker->cache[c]);
+        worker->cache[c] = NULL;
+        worker->cache_count[c] = 0;
+    }
+}
+
+// Return the shared free blocks to the system
+static void drain_free_lists(scheduler_t *scheduler) {
+    pthread_mutex_lock(&scheduler->pool_lock);
+    for (uint32_t c = 0; c < SCHEDULER_SIZE_CLASSES; c++) {
+        release_blocks(scheduler->free_lists[c]);
+        scheduler->free_lists[c] = NULL;
+    }
+    scheduler->pool_cached_bytes = 0;
+    pthread_mutex_unlock(&scheduler->pool_lock);
+}
+
+// This thread's worker if it belongs to scheduler, else NULL
+static scheduler_worker_t *local_worker(const scheduler_t *scheduler) {
+    scheduler_worker_t *worker = current_worker;
+    return worker && worker->scheduler == scheduler ? worker : NULL;
+}
+
+/*
+ * Worker pool
+ */
+
+// Return a slot to the free stack (lock held)
+static void release_slot(scheduler_t *scheduler, uint32_t id) {
+    if (scheduler->tasks[id].duration > 0.0) scheduler->timed_tasks--;
+    scheduler->slots[id].state = SLOT_FREE;
+    scheduler->free_slots[scheduler->num_free++] = id;
+    scheduler->num_tasks--;
+}
+
+// Next task for a worker: its own deque, the ready heap, then the others' deques
+static uint32_t find_task(scheduler_t *scheduler, scheduler_worker_t *worker) {
+    uint32_t id = deque_take(&worker->deque);
+
+    if (id == SCHEDULER_NO_TASK) {
+        pthread_mutex_lock(&scheduler->lock);
+        id = heap_pop(scheduler, &scheduler->ready);
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+    for (uint32_t i = 1; id == SCHEDULER_NO_TASK && i < scheduler->num_workers; i++) {
+        uint32_t victim = (worker->index + i) % scheduler->num_workers;
+        id = deque_steal(&scheduler->workers[victim].deque);
+    }
+
+    if (id != SCHEDULER_NO_TASK) atomic_fetch_sub(&scheduler->queued, 1);
+    return id;
+}
+
+static void run_task(scheduler_t *scheduler, uint32_t id) {
+    channel_task_t *task = &scheduler->tasks[id];
+
+    double begin = clock_seconds();
+    bool ok = task->run(task, task->user_data);
+    double end = clock_seconds();
+
+    pthread_mutex_lock(&scheduler->lock);
+    task->completed = true;
+    task->completion_time = end - scheduler->creation_time;
+    scheduler->total_tasks_processed++;
+    scheduler->total_processing_time += end - begin;
+    scheduler->average_task_time = scheduler->total_processing_time / scheduler->total_tasks_processed;
+    if (!ok) scheduler->failed_tasks++;
+
+    release_slot(scheduler, id);
+    scheduler->active_tasks--;
+    if (--scheduler->outstanding == 0) {
+        pthread_cond_broadcast(&scheduler->idle_cond);
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+}
+
+static void *worker_thread(void *arg) {
+    scheduler_worker_t *worker = arg;
+    scheduler_t *scheduler = worker->scheduler;
+    current_worker = worker;
+
+    // Pinned before any task, so its deque and buffer cache fill node-local
+    iq_affinity_pin_next();
+
+    for (;;) {
+        uint32_t id = find_task(scheduler, worker);
+        if (id != SCHEDULER_NO_TASK) {
+            run_task(scheduler, id);
+            continue;
+        }
+
+        // A non-zero count with nothing found means a task is in transit: retry
+        pthread_mutex_lock(&scheduler->lock);
+        while (atomic_load(&scheduler->queued) == 0 && !scheduler->stopping) {
+            pthread_cond_wait(&scheduler->work_cond, &scheduler->lock);
+        }
+        bool stop = scheduler->stopping && atomic_load(&scheduler->queued) == 0;
+        pthread_mutex_unlock(&scheduler->lock);
+        if (stop) break;
+    }
+
+    current_worker = NULL;
+    return NULL;
+}
+
+// Stop and join the workers, then free their deques and caches
+static void stop_workers(scheduler_t *scheduler) {
+    pthread_mutex_lock(&scheduler->lock);
+    scheduler->stopping = true;
+    pthread_cond_broadcast(&scheduler->work_cond);
+    pthread_mutex_unlock(&scheduler->lock);
+
+    for (uint32_t w = 0; w < scheduler->num_workers; w++) {
+        if (scheduler->workers[w].started) pthread_join(scheduler->workers[w].thread, NULL);
+        free(scheduler->workers[w].deque.items);
+        drain_worker_cache(&scheduler->workers[w]);
+    }
+    free(scheduler->workers);
+    scheduler->workers = NULL;
+}
+
 /**
  * @brief Initialize scheduler configuration with defaults
  */
@@ -31,6 +392,7 @@ bool scheduler_config_init(scheduler_config_t *config, uint32_t max_channels) {
     config->processing_timeout = 30.0;       // 30 second timeout
     config->enable_priority = true;
     config->buffer_pool_size = 1024 * 1024;  // 1MB buffer pool
+    config->num_workers = 0;                 // One worker per core
 
     return true;
 }
@@ -45,6 +407,7 @@ bool scheduler_config_validate(const scheduler_config_t *config) {
     if (config->max_overlap > config->max_channels) return false;
     if (config->processing_timeout <= 0.0) return false;
     if (config->buffer_pool_size == 0) return false;
+    if (config->num_workers > SCHEDULER_MAX_WORKERS) return false;
 
     return true;
 }
@@ -57,7 +420,7 @@ scheduler_t *scheduler_create(const scheduler_config_t *config) {
         return NULL;
     }
 
-    scheduler_t *scheduler = (scheduler_t *)malloc(sizeof(scheduler_t));
+    scheduler_t *scheduler = (scheduler_t *)calloc(1, sizeof(scheduler_t));
     if (!scheduler) return NULL;
 
     // Copy configuration
@@ -65,32 +428,58 @@ scheduler_t *scheduler_create(const scheduler_config_t *config) {
 
     // Initialize task management
     scheduler->max_tasks = config->max_channels * 2;  // Allow 2 tasks per channel
-    scheduler->tasks = (channel_task_t *)malloc(scheduler->max_tasks * sizeof(channel_task_t));
-    if (!scheduler->tasks) {
-        free(scheduler);
-        return NULL;
-    }
-
-    scheduler->num_tasks = 0;
-
-    // Initialize buffer pool
-    scheduler->buffer_pool = (void **)malloc(config->buffer_pool_size * sizeof(void *));
-    if (!scheduler->buffer_pool) {
+    uint32_t num_workers = config->num_workers == 0 ? stft_default_threads() : config->num_workers;
+    if (num_workers > SCHEDULER_MAX_WORKERS) num_workers = SCHEDULER_MAX_WORKERS;
+
+    scheduler->tasks = (channel_task_t *)calloc(scheduler->max_tasks, sizeof(channel_task_t));
+    scheduler->slots = (scheduler_slot_t *)calloc(scheduler->max_tasks, sizeof(scheduler_slot_t));
+    scheduler->free_slots = (uint32_t *)malloc(scheduler->max_tasks * sizeof(uint32_t));
+    scheduler->pending.items = (uint32_t *)malloc(scheduler->max_tasks * sizeof(uint32_t));
+    scheduler->ready.items = (uint32_t *)malloc(scheduler->max_tasks * sizeof(uint32_t));
+    scheduler->workers = (scheduler_worker_t *)calloc(num_workers, sizeof(scheduler_worker_t));
+    if (!scheduler->tasks || !scheduler->slots || !scheduler->free_slots ||
+        !scheduler->pending.items || !scheduler->ready.items || !scheduler->workers) {
+        free(scheduler->workers);
+        free(scheduler->ready.items);
+        free(scheduler->pending.items);
+        free(scheduler->free_slots);
+        free(scheduler->slots);
         free(scheduler->tasks);
         free(scheduler);
         return NULL;
     }
 
-    scheduler->buffer_pool_used = 0;
-
-    // Initialize performance tracking
-    scheduler->total_tasks_processed = 0;
-    scheduler->total_processing_time = 0.0;
-    scheduler->average_task_time = 0.0;
+    // Lowest IDs are handed out first
+    for (uint32_t i = 0; i < scheduler->max_tasks; i++) {
+        scheduler->free_slots[i] = scheduler->max_tasks - 1 - i;
+    }
+    scheduler->num_free = scheduler->max_tasks;
 
     // Initialize state
-    scheduler->initialized = true;
+    pthread_mutex_init(&scheduler->lock, NULL);
+    pthread_cond_init(&scheduler->work_cond, NULL);
+    pthread_cond_init(&scheduler->idle_cond, NULL);
+    pthread_mutex_init(&scheduler->pool_lock, NULL);
+    atomic_init(&scheduler->queued, 0);
+    atomic_init(&scheduler->buffer_pool_used, 0);
+    scheduler->creation_time = clock_seconds();
     scheduler->last_update_time = 0.0;  // Will be set on first use
+    scheduler->initialized = true;
+
+    // Start the pool
+    scheduler->num_workers = num_workers;
+    for (uint32_t w = 0; w < num_workers; w++) {
+        scheduler_worker_t *worker = &scheduler->workers[w];
+        worker->scheduler = scheduler;
+        worker->index = w;
+        if (!deque_init(&worker->deque, scheduler->max_tasks) ||
+            pthread_create(&worker->thread, NULL, worker_thread, worker) != 0) {
+            fprintf(stderr, "Scheduler: failed to start %u worker threads\n", num_workers);
+            scheduler_destroy(scheduler);
+            return NULL;
+        }
+        worker->started = true;
+    }
 
     return scheduler;
 }
@@ -101,18 +490,55 @@ scheduler_t *scheduler_create(const scheduler_config_t *config) {
 void scheduler_destroy(scheduler_t *scheduler) {
     if (!scheduler) return;
 
-    // Free buffer pool
-    if (scheduler->buffer_pool) {
-        // Note: In a real implementation, you'd track and free individual buffers
-        free(scheduler->buffer_pool);
+    if (scheduler->workers) {
+        stop_workers(scheduler);
     }
 
-    // Free task array
+    // Free buffer pool
+    drain_free_lists(scheduler);
+    pthread_mutex_destroy(&scheduler->pool_lock);
+
+    pthread_cond_destroy(&scheduler->idle_cond);
+    pthread_cond_destroy(&scheduler->work_cond);
+    pthread_mutex_destroy(&scheduler->lock);
+
+    // Free task storage
+    free(scheduler->ready.items);
+    free(scheduler->pending.items);
+    free(scheduler->free_slots);
+    free(scheduler->slots);
     free(scheduler->tasks);
 
     free(scheduler);
 }
 
+// Overlap test against every live task of the channel (lock held)
+static bool check_overlap_locked(const scheduler_t *scheduler, uint32_t channel_id,
+                                 double start_time, double duration) {
+    // Zero-length intervals can only overlap a task with a positive duration
+    if (duration <= 0.0 && scheduler->timed_tasks == 0) {
+        return true;
+    }
+
+    double end_time = start_time + duration;
+
+    for (uint32_t i = 0; i < scheduler->max_tasks; i++) {
+        const channel_task_t *task = &scheduler->tasks[i];
+        uint8_t state = scheduler->slots[i].state;
+        if (state == SLOT_FREE || state == SLOT_DONE || task->channel_id != channel_id) {
+            continue;
+        }
+
+        // Check for time overlap
+        double task_end = task->start_time + task->duration;
+        if (!(end_time <= task->start_time || start_time >= task_end)) {
+            return false;  // Overlap detected
+        }
+    }
+
+    return true;  // No overlap
+}
+
 /**
  * @brief Add a processing task to the scheduler
  */
@@ -121,96 +547,150 @@ int32_t scheduler_add_task(scheduler_t *scheduler, const channel_task_t *task) {
         return -1;
     }
 
-    if (scheduler->num_tasks >= scheduler->max_tasks) {
+    pthread_mutex_lock(&scheduler->lock);
+
+    if (scheduler->num_free == 0) {
+        pthread_mutex_unlock(&scheduler->lock);
         return -2;  // No space for new tasks
     }
 
     // Check for overlap conflicts
-    if (!scheduler_check_overlap(scheduler, task->channel_id,
-                                task->start_time, task->duration)) {
+    if (!check_overlap_locked(scheduler, task->channel_id, task->start_time, task->duration)) {
+        pthread_mutex_unlock(&scheduler->lock);
         return -3;  // Overlap conflict
     }
 
-    // Find available slot
-    uint32_t task_id = scheduler->num_tasks;
-    memcpy(&scheduler->tasks[task_id], task, sizeof(channel_task_t));
-    scheduler->tasks[task_id].completed = false;
-    scheduler->tasks[task_id].completion_time = 0.0;
-
+    uint32_t task_id = scheduler->free_slots[--scheduler->num_free];
+    channel_task_t *slot = &scheduler->tasks[task_id];
+    memcpy(slot, task, sizeof(channel_task_t));
+    slot->completed = false;
+    slot->completion_time = 0.0;
+    slot->task_id = task_id;
+    scheduler->slots[task_id].sequence = scheduler->next_sequence++;
     scheduler->num_tasks++;
+    scheduler->active_tasks++;
+    if (task->duration > 0.0) scheduler->timed_tasks++;
+
+    if (!task->run) {
+        scheduler->slots[task_id].state = SLOT_PENDING;
+        heap_push(scheduler, &scheduler->pending, task_id);
+        pthread_mutex_unlock(&scheduler->lock);
+        return (int32_t)task_id;
+    }
 
-    return task_id;
+    scheduler->slots[task_id].state = SLOT_QUEUED;
+    scheduler->outstanding++;
+
+    // Spawned by one of our tasks: keep it on that worker, where it is likely
+    // hot. Counted first, so a worker that finds it also finds the count
+    scheduler_worker_t *worker = current_worker;
+    bool spawned = worker && worker->scheduler == scheduler;
+    if (!spawned) {
+        heap_push(scheduler, &scheduler->ready, task_id);
+    }
+    atomic_fetch_add(&scheduler->queued, 1);
+    pthread_cond_signal(&scheduler->work_cond);
+    pthread_mutex_unlock(&scheduler->lock);
+
+    if (spawned) {
+        deque_push(&worker->deque, task_id);
+    }
+
+    return (int32_t)task_id;
 }
 
 /**
  * @brief Remove a task from the scheduler
  */
 bool scheduler_remove_task(scheduler_t *scheduler, uint32_t task_id) {
-    if (!scheduler || !scheduler->initialized || task_id >= scheduler->num_tasks) {
+    if (!scheduler || !scheduler->initialized || task_id >= scheduler->max_tasks) {
         return false;
     }
 
-    // Remove task by shifting remaining tasks
-    for (uint32_t i = task_id; i < scheduler->num_tasks - 1; i++) {
-        memcpy(&scheduler->tasks[i], &scheduler->tasks[i + 1], sizeof(channel_task_t));
+    pthread_mutex_lock(&scheduler->lock);
+    uint8_t state = scheduler->slots[task_id].state;
+    bool removable = state == SLOT_PENDING || state == SLOT_DONE;
+    if (removable) {
+        if (state == SLOT_PENDING) {
+            heap_remove(scheduler, &scheduler->pending, scheduler->slots[task_id].heap_position);
+            scheduler->active_tasks--;
+        }
+        release_slot(scheduler, task_id);
     }
+    pthread_mutex_unlock(&scheduler->lock);
 
-    scheduler->num_tasks--;
-    return true;
+    return removable;
 }
 
 /**
  * @brief Get next task to process (priority-based)
  */
 bool scheduler_get_next_task(scheduler_t *scheduler, channel_task_t *task) {
-    if (!scheduler || !scheduler->initialized || !task || scheduler->num_tasks == 0) {
+    if (!scheduler || !scheduler->initialized || !task) {
         return false;
     }
 
-    // Find highest priority incomplete task
-    uint32_t best_task = (uint32_t)-1;
-    uint32_t best_priority = (uint32_t)-1;
-
-    for (uint32_t i = 0; i < scheduler->num_tasks; i++) {
-        if (!scheduler->tasks[i].completed &&
-            scheduler->tasks[i].priority < best_priority) {
-            best_task = i;
-            best_priority = scheduler->tasks[i].priority;
-        }
-    }
-
-    if (best_task == (uint32_t)-1) {
-        return false;  // No incomplete tasks
+    pthread_mutex_lock(&scheduler->lock);
+    bool available = scheduler->pending.count > 0;
+    if (available) {
+        memcpy(task, &scheduler->tasks[scheduler->pending.items[0]], sizeof(channel_task_t));
     }
+    pthread_mutex_unlock(&scheduler->lock);
 
-    memcpy(task, &scheduler->tasks[best_task], sizeof(channel_task_t));
-    return true;
+    return available;
 }
 
 /**
  * @brief Mark a task as completed
  */
 bool scheduler_complete_task(scheduler_t *scheduler, uint32_t task_id, double completion_time) {
-    if (!scheduler || !scheduler->initialized || task_id >= scheduler->num_tasks) {
+    if (!scheduler || !scheduler->initialized || task_id >= scheduler->max_tasks) {
         return false;
     }
 
-    if (scheduler->tasks[task_id].completed) {
-        return false;  // Already completed
+    pthread_mutex_lock(&scheduler->lock);
+    if (scheduler->slots[task_id].state != SLOT_PENDING) {
+        pthread_mutex_unlock(&scheduler->lock);
+        return false;  // Unknown, already completed or run by the pool
     }
 
-    scheduler->tasks[task_id].completed = true;
-    scheduler->tasks[task_id].completion_time = completion_time;
+    channel_task_t *task = &scheduler->tasks[task_id];
+    heap_remove(scheduler, &scheduler->pending, scheduler->slots[task_id].heap_position);
+    scheduler->slots[task_id].state = SLOT_DONE;
+    scheduler->active_tasks--;
+    if (task->duration > 0.0) scheduler->timed_tasks--;
+    task->completed = true;
+    task->completion_time = completion_time;
 
     // Update performance statistics
-    double task_time = completion_time - scheduler->tasks[task_id].start_time;
+    double task_time = completion_time - task->start_time;
     scheduler->total_tasks_processed++;
     scheduler->total_processing_time += task_time;
     scheduler->average_task_time = scheduler->total_processing_time / scheduler->total_tasks_processed;
+    pthread_mutex_unlock(&scheduler->lock);
 
     return true;
 }
 
+/**
+ * @brief Wait until every runnable task has finished
+ */
+bool scheduler_wait(scheduler_t *scheduler) {
+    if (!scheduler || !scheduler->initialized) {
+        return false;
+    }
+
+    pthread_mutex_lock(&scheduler->lock);
+    while (scheduler->outstanding > 0) {
+        pthread_cond_wait(&scheduler->idle_cond, &scheduler->lock);
+    }
+    bool ok = scheduler->failed_tasks == 0;
+    scheduler->failed_tasks = 0;
+    pthread_mutex_unlock(&scheduler->lock);
+
+    return ok;
+}
+
 /**
  * @brief Allocate a temporary buffer from the pool
  */
@@ -219,19 +699,33 @@ void *scheduler_allocate_buffer(scheduler_t *scheduler, uint32_t size) {
         return NULL;
     }
 
-    if (scheduler->buffer_pool_used >= scheduler->config.buffer_pool_size) {
-        return NULL;  // No buffers available
+    uint32_t size_class = class_for_size(size);
+    scheduler_block_t *block = NULL;
+    if (size_class < SCHEDULER_SIZE_CLASSES) {
+        scheduler_worker_t *worker = local_worker(scheduler);
+        if (worker && worker->cache[size_class]) {
+            block = worker->cache[size_class];
+            worker->cache[size_class] = block->next;
+            worker->cache_count[size_class]--;
+        } else {
+            pthread_mutex_lock(&scheduler->pool_lock);
+            block = scheduler->free_lists[size_class];
+            if (block) {
+                scheduler->free_lists[size_class] = block->next;
+                scheduler->pool_cached_bytes -= class_bytes(size_class);
+            }
+            pthread_mutex_unlock(&scheduler->pool_lock);
+        }
     }
 
-    // Simplified allocation - in practice you'd manage a proper pool
-    void *buffer = malloc(size);
-    if (!buffer) return NULL;
-
-    // Track buffer (simplified)
-    scheduler->buffer_pool[scheduler->buffer_pool_used] = buffer;
-    scheduler->buffer_pool_used++;
+    // Nothing to reuse: a fresh block
+    if (!block) block = block_create(scheduler, size_class, size);
+    if (!block) return NULL;
 
-    return buffer;
+    block->next = NULL;
+    block->magic = BLOCK_IN_USE;
+    atomic_fetch_add(&scheduler->buffer_pool_used, 1);
+    return block_buffer(block);
 }
 
 /**
@@ -242,20 +736,38 @@ bool scheduler_free_buffer(scheduler_t *scheduler, void *buffer) {
         return false;
     }
 
-    // Find buffer in pool and free it
-    for (uint32_t i = 0; i < scheduler->buffer_pool_used; i++) {
-        if (scheduler->buffer_pool[i] == buffer) {
-            free(buffer);
-            // Remove from pool by shifting
-            for (uint32_t j = i; j < scheduler->buffer_pool_used - 1; j++) {
-                scheduler->buffer_pool[j] = scheduler->buffer_pool[j + 1];
-            }
-            scheduler->buffer_pool_used--;
+    scheduler_block_t *block = buffer_block(buffer);
+    if (block->owner != scheduler || block->magic != BLOCK_IN_USE) {
+        return false;  // Not from this pool, or freed already
+    }
+    block->magic = BLOCK_FREE;
+    atomic_fetch_sub(&scheduler->buffer_pool_used, 1);
+
+    uint32_t size_class = block->size_class;
+    if (size_class < SCHEDULER_SIZE_CLASSES) {
+        scheduler_worker_t *worker = local_worker(scheduler);
+        if (worker && worker->cache_count[size_class] < SCHEDULER_CACHE_DEPTH) {
+            block->next = worker->cache[size_class];
+            worker->cache[size_class] = block;
+            worker->cache_count[size_class]++;
             return true;
         }
+
+        pthread_mutex_lock(&scheduler->pool_lock);
+        bool keep = scheduler->pool_cached_bytes + class_bytes(size_class) <=
+                    scheduler->config.buffer_pool_size;
+        if (keep) {
+            block->next = scheduler->free_lists[size_class];
+            scheduler->free_lists[size_class] = block;
+            scheduler->pool_cached_bytes += class_bytes(size_class);
+        }
+        pthread_mutex_unlock(&scheduler->pool_lock);
+        if (keep) return true;
     }
 
-    return false;  // Buffer not found in pool
+    // Large, or the pool holds enough idle memory
+    free(block->raw);
+    return true;
 }
 
 /**
@@ -267,15 +779,11 @@ bool scheduler_get_statistics(const scheduler_t *scheduler,
         return false;
     }
 
+    pthread_mutex_lock(scheduler_lock(scheduler));
     if (total_tasks) *total_tasks = scheduler->total_tasks_processed;
     if (avg_time) *avg_time = scheduler->average_task_time;
-    if (active_tasks) {
-        uint32_t active = 0;
-        for (uint32_t i = 0; i < scheduler->num_tasks; i++) {
-            if (!scheduler->tasks[i].completed) active++;
-        }
-        *active_tasks = active;
-    }
+    if (active_tasks) *active_tasks = scheduler->active_tasks;
+    pthread_mutex_unlock(scheduler_lock(scheduler));
 
     return true;
 }
@@ -289,21 +797,11 @@ bool scheduler_check_overlap(const scheduler_t *scheduler, uint32_t channel_id,
         return false;
     }
 
-    double end_time = start_time + duration;
-
-    // Check all active tasks for this channel
-    for (uint32_t i = 0; i < scheduler->num_tasks; i++) {
-        if (scheduler->tasks[i].channel_id == channel_id && !scheduler->tasks[i].completed) {
-            double task_end = scheduler->tasks[i].start_time + scheduler->tasks[i].duration;
-
-            // Check for time overlap
-            if (!(end_time <= scheduler->tasks[i].start_time || start_time >= task_end)) {
-                return false;  // Overlap detected
-            }
-        }
-    }
+    pthread_mutex_lock(scheduler_lock(scheduler));
+    bool clear = check_overlap_locked(scheduler, channel_id, start_time, duration);
+    pthread_mutex_unlock(scheduler_lock(scheduler));
 
-    return true;  // No overlap
+    return clear;
 }
 
 /**
@@ -314,29 +812,10 @@ bool scheduler_optimize_schedule(scheduler_t *scheduler) {
         return false;
     }
 
-    // Simple bubble sort by priority and start time
-    for (uint32_t i = 0; i < scheduler->num_tasks - 1; i++) {
-        for (uint32_t j = 0; j < scheduler->num_tasks - i - 1; j++) {
-            bool should_swap = false;
-
-            // Sort by priority first (lower number = higher priority)
-            if (scheduler->tasks[j].priority > scheduler->tasks[j + 1].priority) {
-                should_swap = true;
-            }
-            // Then by start time for same priority
-            else if (scheduler->tasks[j].priority == scheduler->tasks[j + 1].priority &&
-                     scheduler->tasks[j].start_time > scheduler->tasks[j + 1].start_time) {
-                should_swap = true;
-            }
-
-            if (should_swap) {
-                channel_task_t temp;
-                memcpy(&temp, &scheduler->tasks[j], sizeof(channel_task_t));
-                memcpy(&scheduler->tasks[j], &scheduler->tasks[j + 1], sizeof(channel_task_t));
-                memcpy(&scheduler->tasks[j + 1], &temp, sizeof(channel_task_t));
-            }
-        }
-    }
+    pthread_mutex_lock(&scheduler->lock);
+    heap_rebuild(scheduler, &scheduler->pending);
+    heap_rebuild(scheduler, &scheduler->ready);
+    pthread_mutex_unlock(&scheduler->lock);
 
     return true;
 }
@@ -350,17 +829,14 @@ bool scheduler_get_status_string(const scheduler_t *scheduler,
         return false;
     }
 
-    uint32_t active_tasks = 0;
-    for (uint32_t i = 0; i < scheduler->num_tasks; i++) {
-        if (!scheduler->tasks[i].completed) active_tasks++;
-    }
-
+    pthread_mutex_lock(scheduler_lock(scheduler));
     int written = snprintf(buffer, buffer_size,
                           "Scheduler: %u/%u active tasks, %llu total processed, "
-                          "%.3f avg time",
-                          active_tasks, scheduler->num_tasks,
-                          scheduler->total_tasks_processed,
-                          scheduler->average_task_time);
+                          "%.3f avg time, %u workers",
+                          scheduler->active_tasks, scheduler->num_tasks,
+                          (unsigned long long)scheduler->total_tasks_processed,
+                          scheduler->average_task_time, scheduler->num_workers);
+    pthread_mutex_unlock(scheduler_lock(scheduler));
 
     return written > 0 && (uint32_t)written < buffer_size;
 }
@@ -373,20 +849,38 @@ bool scheduler_reset(scheduler_t *scheduler) {
         return false;
     }
 
+    pthread_mutex_lock(&scheduler->lock);
+    if (scheduler->outstanding > 0) {
+        pthread_mutex_unlock(&scheduler->lock);
+        return false;
+    }
+
     // Clear all tasks
+    memset(scheduler->slots, 0, scheduler->max_tasks * sizeof(scheduler_slot_t));
+    for (uint32_t i = 0; i < scheduler->max_tasks; i++) {
+        scheduler->free_slots[i] = scheduler->max_tasks - 1 - i;
+    }
+    scheduler->num_free = scheduler->max_tasks;
     scheduler->num_tasks = 0;
-
-    // Free all buffers in pool
-    for (uint32_t i = 0; i < scheduler->buffer_pool_used; i++) {
-        free(scheduler->buffer_pool[i]);
+    scheduler->active_tasks = 0;
+    scheduler->timed_tasks = 0;
+    scheduler->next_sequence = 0;
+    scheduler->pending.count = 0;
+    scheduler->ready.count = 0;
+    scheduler->failed_tasks = 0;
+
+    // Return idle buffers to the system; the workers are idle too
+    for (uint32_t w = 0; w < scheduler->num_workers; w++) {
+        drain_worker_cache(&scheduler->workers[w]);
     }
-    scheduler->buffer_pool_used = 0;
+    drain_free_lists(scheduler);
 
     // Reset statistics
     scheduler->total_tasks_processed = 0;
     scheduler->total_processing_time = 0.0;
     scheduler->average_task_time = 0.0;
     scheduler->last_update_time = 0.0;
+    pthread_mutex_unlock(&scheduler->lock);
 
     return true;
 }
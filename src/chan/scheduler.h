@@ -2,16 +2,27 @@
  * IQ Lab - scheduler.h: Channel Processing Scheduler
  *
  * Purpose: Manages the scheduling and coordination of channel processing
- * operations, including overlap handling and resource allocation.
+ * operations, including overlap handling and resource allocation, and runs
+ * per-channel tasks concurrently on a fixed pool of worker threads.
  *
   *
  * Date: 2025
  *
  * Key Features:
  * - Channel overlap management
- * - Processing priority handling
- * - Resource allocation optimization
+ * - Processing priority handling: binary heaps keyed on (priority,
+ *   start_time, submission order), O(log n) per add, pop and removal
+ * - Fixed worker pool with work-stealing deques (Chase-Lev): tasks added
+ *   from a running task go onto that worker's deque and idle workers steal
+ *   the oldest ones, tasks added from other threads go through the heap
+ * - Buffer pool: power-of-two size classes of cache-line aligned blocks,
+ *   O(1) allocate and free, each worker keeping a small cache per class
  * - Progress tracking and reporting
+ *
+ * A task with a run function is executed by the pool and its slot is freed
+ * once it returns; scheduler_wait() blocks until every such task is done.
+ * A task without one is only booked: scheduler_get_next_task() hands it out
+ * in priority order and scheduler_complete_task() retires it, as before.
  */
 
 #ifndef SCHEDULER_H
@@ -19,11 +30,32 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Upper bound on worker threads
+#define SCHEDULER_MAX_WORKERS 64
+
+// Buffer pool: blocks of 64 << c bytes for size class c
+#define SCHEDULER_BUFFER_ALIGNMENT 64    // Alignment of every pooled buffer
+#define SCHEDULER_SIZE_CLASSES 15        // 64 bytes to 1 MiB; larger requests bypass the pool
+#define SCHEDULER_CACHE_DEPTH 16         // Blocks per class a worker keeps to itself
 
 // Forward declarations
 typedef struct scheduler_t scheduler_t;
 typedef struct channel_task_t channel_task_t;
 typedef struct scheduler_config_t scheduler_config_t;
+typedef struct scheduler_worker_t scheduler_worker_t;
+typedef struct scheduler_block_t scheduler_block_t;
+
+/**
+ * @brief Task body, run on a worker thread
+ *
+ * @param task The task's slot (task_id and user_data are set)
+ * @param user_data The task's user_data
+ * @return true on success; a false return makes scheduler_wait() fail
+ */
+typedef bool (*scheduler_task_fn)(channel_task_t *task, void *user_data);
 
 /**
  * @brief Scheduler Configuration Structure
@@ -32,8 +64,9 @@ struct scheduler_config_t {
     uint32_t max_channels;       // Maximum number of channels to manage
     uint32_t max_overlap;        // Maximum allowed channel overlap
     double processing_timeout;   // Timeout for processing operations (seconds)
-    bool enable_priority;        // Enable priority-based scheduling
-    uint32_t buffer_pool_size;   // Size of buffer pool for temporary storage
+    bool enable_priority;        // Enable priority-based scheduling (else FIFO)
+    uint32_t buffer_pool_size;   // Bytes of freed buffers kept for reuse
+    uint32_t num_workers;        // Worker threads (0: one per core)
 };
 
 /**
@@ -48,7 +81,67 @@ struct channel_task_t {
     uint32_t output_samples;     // Expected output samples
     bool completed;              // Completion status
     double completion_time;      // Actual completion time
+    scheduler_task_fn run;       // Body run by the pool (NULL: bookkeeping only)
     void *user_data;             // User-defined data pointer
+    uint32_t task_id;            // Slot index, set by the scheduler
+};
+
+/**
+ * @brief Per-slot scheduling state
+ */
+typedef struct {
+    uint8_t state;               // Free, pending, queued or done
+    uint32_t heap_position;      // Index in the heap holding the slot
+    uint64_t sequence;           // Submission order, breaks priority ties
+} scheduler_slot_t;
+
+/**
+ * @brief Binary min-heap of task IDs
+ */
+typedef struct {
+    uint32_t *items;             // Task IDs, heap ordered
+    uint32_t count;              // Tasks in the heap
+} scheduler_heap_t;
+
+/**
+ * @brief Work-stealing deque of task IDs
+ *
+ * The owning worker pushes and takes at the bottom; other workers steal
+ * from the top. The capacity covers every task slot, so it never fills.
+ */
+typedef struct {
+    atomic_uint *items;          // capacity slots
+    int64_t capacity;            // Number of slots
+    atomic_int_fast64_t top;     // Next task to steal
+    atomic_int_fast64_t bottom;  // Next free slot (owner only)
+} scheduler_deque_t;
+
+/**
+ * @brief Header in front of every pooled buffer
+ *
+ * Occupies one alignment unit, so the buffer after it stays aligned.
+ */
+struct scheduler_block_t {
+    scheduler_block_t *next;     // Free list link
+    scheduler_t *owner;          // Scheduler the block belongs to
+    void *raw;                   // Start of the underlying allocation
+    uint32_t size_class;         // Class index, SCHEDULER_SIZE_CLASSES for large blocks
+    uint32_t magic;              // Marks a block in use
+};
+
+/**
+ * @brief One worker thread
+ */
+struct scheduler_worker_t {
+    scheduler_t *scheduler;      // Owning scheduler
+    uint32_t index;              // Position in the pool
+    pthread_t thread;            // Thread handle
+    bool started;                // Thread was created
+    scheduler_deque_t deque;     // Tasks spawned by this worker
+
+    // Buffers freed on this thread, reused without taking the pool lock
+    scheduler_block_t *cache[SCHEDULER_SIZE_CLASSES];
+    uint32_t cache_count[SCHEDULER_SIZE_CLASSES];
 };
 
 /**
@@ -58,13 +151,34 @@ struct scheduler_t {
     scheduler_config_t config;   // Configuration parameters
 
     // Task management
-    channel_task_t *tasks;       // Array of active tasks
-    uint32_t num_tasks;          // Number of active tasks
+    channel_task_t *tasks;       // Task slots, indexed by task ID
+    scheduler_slot_t *slots;     // Scheduling state of every slot
+    uint32_t *free_slots;        // Stack of unused task IDs
+    uint32_t num_free;           // Entries on the free stack
+    uint32_t num_tasks;          // Number of occupied slots
     uint32_t max_tasks;          // Maximum number of tasks
+    uint32_t active_tasks;       // Tasks not yet completed
+    uint32_t timed_tasks;        // Live tasks with a positive duration
+    uint64_t next_sequence;      // Sequence of the next added task
+    scheduler_heap_t pending;    // Booked tasks, for scheduler_get_next_task
+    scheduler_heap_t ready;      // Runnable tasks added from outside the pool
+
+    // Worker pool
+    scheduler_worker_t *workers; // num_workers workers
+    uint32_t num_workers;        // Number of worker threads
+    pthread_mutex_t lock;        // Guards everything but the deques
+    pthread_cond_t work_cond;    // Signalled when tasks are queued or on shutdown
+    pthread_cond_t idle_cond;    // Signalled when the last runnable task finishes
+    atomic_uint queued;          // Runnable tasks in the heap or a deque
+    uint32_t outstanding;        // Runnable tasks added but not finished
+    uint32_t failed_tasks;       // Runnable tasks that failed since the last wait
+    bool stopping;               // Workers exit once the queues are empty
 
     // Resource management
-    void **buffer_pool;          // Pool of temporary buffers
-    uint32_t buffer_pool_used;   // Number of buffers in use
+    pthread_mutex_t pool_lock;   // Guards the shared free lists
+    scheduler_block_t *free_lists[SCHEDULER_SIZE_CLASSES]; // Shared free blocks per class
+    uint64_t pool_cached_bytes;  // Bytes on the shared free lists
+    atomic_uint buffer_pool_used; // Number of buffers in use
 
     // Performance tracking
     uint64_t total_tasks_processed;  // Total tasks completed
@@ -73,6 +187,7 @@ struct scheduler_t {
 
     // State management
     bool initialized;            // Initialization flag
+    double creation_time;        // Clock reading at creation (seconds)
     double last_update_time;     // Last status update time
 };
 
@@ -94,7 +209,7 @@ bool scheduler_config_init(scheduler_config_t *config, uint32_t max_channels);
 bool scheduler_config_validate(const scheduler_config_t *config);
 
 /**
- * @brief Create scheduler instance
+ * @brief Create scheduler instance and start its workers
  *
  * @param config Pointer to validated configuration
  * @return Pointer to initialized scheduler, NULL on error
@@ -104,6 +219,8 @@ scheduler_t *scheduler_create(const scheduler_config_t *config);
 /**
  * @brief Destroy scheduler instance
  *
+ * Runs every queued task to completion, then joins the workers.
+ *
  * @param scheduler Pointer to scheduler instance
  */
 void scheduler_destroy(scheduler_t *scheduler);
@@ -111,15 +228,23 @@ void scheduler_destroy(scheduler_t *scheduler);
 /**
  * @brief Add a processing task to the scheduler
  *
+ * With task->run set the task is queued for the pool right away; added
+ * from inside a running task it goes onto that worker's own deque. May be
+ * called from any thread.
+ *
  * @param scheduler Pointer to scheduler instance
  * @param task Pointer to task description
- * @return Task ID on success, negative on error
+ * @return Task ID on success, negative on error (-2: no free slot,
+ *         -3: overlaps a task of the same channel)
  */
 int32_t scheduler_add_task(scheduler_t *scheduler, const channel_task_t *task);
 
 /**
  * @brief Remove a task from the scheduler
  *
+ * Only booked tasks (no run function) can be removed; task IDs of the
+ * other tasks do not change.
+ *
  * @param scheduler Pointer to scheduler instance
  * @param task_id Task identifier
  * @return true on success, false on error
@@ -127,7 +252,7 @@ int32_t scheduler_add_task(scheduler_t *scheduler, const channel_task_t *task);
 bool scheduler_remove_task(scheduler_t *scheduler, uint32_t task_id);
 
 /**
- * @brief Get next task to process (priority-based)
+ * @brief Get next booked task to process (priority-based)
  *
  * @param scheduler Pointer to scheduler instance
  * @param task Pointer to receive task description
@@ -136,7 +261,7 @@ bool scheduler_remove_task(scheduler_t *scheduler, uint32_t task_id);
 bool scheduler_get_next_task(scheduler_t *scheduler, channel_task_t *task);
 
 /**
- * @brief Mark a task as completed
+ * @brief Mark a booked task as completed
  *
  * @param scheduler Pointer to scheduler instance
  * @param task_id Task identifier
@@ -145,9 +270,24 @@ bool scheduler_get_next_task(scheduler_t *scheduler, channel_task_t *task);
  */
 bool scheduler_complete_task(scheduler_t *scheduler, uint32_t task_id, double completion_time);
 
+/**
+ * @brief Wait until every runnable task has finished
+ *
+ * Must not be called from a task.
+ *
+ * @param scheduler Pointer to scheduler instance
+ * @return true if no task failed since the previous wait, false otherwise
+ */
+bool scheduler_wait(scheduler_t *scheduler);
+
 /**
  * @brief Allocate a temporary buffer from the pool
  *
+ * The size is rounded up to its class; blocks freed earlier are reused,
+ * first from the calling worker's cache, then from the shared lists.
+ * Buffers are SCHEDULER_BUFFER_ALIGNMENT aligned and not zeroed. May be
+ * called from any thread.
+ *
  * @param scheduler Pointer to scheduler instance
  * @param size Buffer size in bytes
  * @return Pointer to allocated buffer, NULL on error
@@ -157,6 +297,11 @@ void *scheduler_allocate_buffer(scheduler_t *scheduler, uint32_t size);
 /**
  * @brief Free a buffer back to the pool
  *
+ * The block goes to the calling worker's cache while it has room, else to
+ * the shared lists while they hold less than config.buffer_pool_size
+ * bytes, else back to the system. Every buffer must be freed before the
+ * scheduler is destroyed.
+ *
  * @param scheduler Pointer to scheduler instance
  * @param buffer Pointer to buffer to free
  * @return true on success, false on error
@@ -188,7 +333,10 @@ bool scheduler_check_overlap(const scheduler_t *scheduler, uint32_t channel_id,
                            double start_time, double duration);
 
 /**
- * @brief Optimize task scheduling for minimal conflicts
+ * @brief Restore priority order after tasks were edited in place
+ *
+ * The heaps keep tasks ordered as they are added; this rebuilds them in
+ * O(n) when priorities or start times in scheduler->tasks were changed.
  *
  * @param scheduler Pointer to scheduler instance
  * @return true on success, false on error
@@ -209,8 +357,11 @@ bool scheduler_get_status_string(const scheduler_t *scheduler,
 /**
  * @brief Reset scheduler state
  *
+ * Also returns the pooled free blocks to the system; buffers in use stay
+ * valid.
+ *
  * @param scheduler Pointer to scheduler instance
- * @return true on success, false on error
+ * @return true on success, false on error (runnable tasks still queued)
  */
 bool scheduler_reset(scheduler_t *scheduler);
 
@@ -1,6 +1,8 @@
 #include "converter.h"
 #include "formats/wav_converter.h"
 #include "formats/iq_converter.h"
+#include "formats/iqz_converter.h"
+#include "../iq_core/io_iqz.h"
 #include "utils/file_utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,10 +36,16 @@ static file_format_t detect_iq_format_from_content(const char *filename);
 static file_format_t detect_format_from_content(const char *filename);
 bool is_wav_iq_format(const char *filename);
 
+static double converter_wall_seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
 // Public function implementations
 converter_result_t convert_file(const conversion_request_t *request) {
     converter_result_t result = {0};
-    clock_t start_time = clock();
+    double start_time = converter_wall_seconds();
 
     // Validate conversion request
     if (!validate_conversion_request(request, result.error_message, sizeof(result.error_message))) {
@@ -88,7 +96,10 @@ converter_result_t convert_file(const conversion_request_t *request) {
     }
 
     // Execute conversion
-    if (request->output_format == FORMAT_IQ_S16 || request->output_format == FORMAT_IQ_S8) {
+    if (request->output_format == FORMAT_IQZ) {
+        // Every readable input encodes through the streaming reader
+        result = iq_to_iqz(&actual_request);
+    } else if (iq_is_native_format(request->output_format)) {
         // Convert to native IQ format
         if (actual_input_format == FORMAT_WAV) {
             // Check if WAV file contains IQ data or regular audio
@@ -104,7 +115,7 @@ converter_result_t convert_file(const conversion_request_t *request) {
         } else {
         result = handler->convert_to_iq(&actual_request);
         }
-    } else if (actual_input_format == FORMAT_IQ_S16 || actual_input_format == FORMAT_IQ_S8) {
+    } else if (iq_is_native_format(actual_input_format)) {
         // Convert from native IQ format
         result = handler->convert_from_iq(&actual_request);
     } else {
@@ -117,8 +128,8 @@ converter_result_t convert_file(const conversion_request_t *request) {
     }
 
     // Calculate conversion time
-    clock_t end_time = clock();
-    result.conversion_time_seconds = (double)(end_time - start_time) / CLOCKS_PER_SEC;
+    // Wall time: clock() would add up the CPU time of every conversion thread
+    result.conversion_time_seconds = converter_wall_seconds() - start_time;
 
     // Extract metadata if available
     if (handler->extract_metadata) {
@@ -150,6 +161,13 @@ file_format_t detect_file_format(const char *filename) {
         if (strcmp(ext, ".iq") == 0 || strcmp(ext, ".IQ") == 0) {
             // For .iq files, examine content to determine s8 or s16
             return detect_iq_format_from_content(filename);
+        } else if (strcmp(ext, ".s12") == 0) {
+            // Packed widths cannot be told apart by content, only by name
+            return FORMAT_IQ_S12;
+        } else if (strcmp(ext, ".s4") == 0) {
+            return FORMAT_IQ_S4;
+        } else if (strcmp(ext, ".iqz") == 0 || strcmp(ext, ".IQZ") == 0) {
+            return FORMAT_IQZ;
         } else if (strcmp(ext, ".sigmf") == 0 || strcmp(ext, ".SIGMF") == 0) {
             return FORMAT_SIGMF;
         } else if (strcmp(ext, ".wav") == 0 || strcmp(ext, ".WAV") == 0) {
@@ -350,6 +368,10 @@ file_format_t detect_format_from_content(const char *filename) {
         }
     }
 
+    if (bytes_read >= 8 && memcmp(header, IQZ_MAGIC, 8) == 0) {
+        return FORMAT_IQZ;
+    }
+
     // Could add more format detection here (e.g., HDF5, etc.)
 
     return FORMAT_AUTO;
@@ -461,12 +483,20 @@ bool extract_file_metadata(const char *filename, file_metadata_t *metadata) {
 
 bool is_conversion_supported(file_format_t from_format, file_format_t to_format) {
     // For now, we only support conversions to/from native IQ formats
-    bool from_supported = (from_format == FORMAT_WAV || from_format == FORMAT_IQ_S8 || from_format == FORMAT_IQ_S16);
-    bool to_supported = (to_format == FORMAT_IQ_S8 || to_format == FORMAT_IQ_S16);
+    bool from_supported = (from_format == FORMAT_WAV || iq_is_native_format(from_format));
+    bool to_supported = iq_is_native_format(to_format);
+
+    // IQZ encodes s8/s16 values from anything the reader streams and decodes to native IQ
+    if (to_format == FORMAT_IQZ) {
+        bool packed = from_format == FORMAT_IQ_S12 || from_format == FORMAT_IQ_S4;
+        return (from_supported && !packed) || from_format == FORMAT_IQZ;
+    }
+    if (from_format == FORMAT_IQZ) {
+        return to_supported;
+    }
 
     // Special case: conversion between IQ formats
-    if ((from_format == FORMAT_IQ_S8 || from_format == FORMAT_IQ_S16) &&
-        (to_format == FORMAT_IQ_S8 || to_format == FORMAT_IQ_S16)) {
+    if (iq_is_native_format(from_format) && iq_is_native_format(to_format)) {
         return true;
     }
 
@@ -481,6 +511,9 @@ const char *get_format_description(file_format_t format) {
         case FORMAT_WAV: return "WAV IQ";
         case FORMAT_SIGMF: return "SigMF";
         case FORMAT_HDF5: return "HDF5";
+        case FORMAT_IQZ: return "IQZ compressé";
+        case FORMAT_IQ_S12: return "IQ natif 12-bit packé";
+        case FORMAT_IQ_S4: return "IQ natif 4-bit packé";
         default: return "Format inconnu";
     }
 }
@@ -492,6 +525,9 @@ const char *get_format_extension(file_format_t format) {
         case FORMAT_WAV: return ".wav";
         case FORMAT_SIGMF: return ".sigmf";
         case FORMAT_HDF5: return ".h5";
+        case FORMAT_IQZ: return ".iqz";
+        case FORMAT_IQ_S12: return ".s12";
+        case FORMAT_IQ_S4: return ".s4";
         default: return "";
     }
 }
@@ -503,6 +539,8 @@ void init_converter_options(converter_options_t *options) {
     options->verbose = false;
     options->sample_rate = 0;  // Auto-detection
     options->max_memory_mb = 0;  // Unlimited
+    options->num_threads = 0;  // One per CPU
+    options->lossy_bits = 0;  // Lossless IQZ
     options->preserve_metadata = true;
 }
 
@@ -577,6 +615,42 @@ static format_handler_t *get_format_handlers(void) {
             .convert_from_iq = iq_to_iq,
             .extract_metadata = iq_extract_metadata
         },
+        {
+            .format = FORMAT_IQ_S8,
+            .name = "IQ_S8",
+            .extension = ".iq",
+            .can_handle = iq_can_handle,
+            .convert_to_iq = iq_to_iq,
+            .convert_from_iq = iq_to_iq,
+            .extract_metadata = iq_extract_metadata
+        },
+        {
+            .format = FORMAT_IQ_S12,
+            .name = "IQ_S12",
+            .extension = ".s12",
+            .can_handle = iq_can_handle,
+            .convert_to_iq = iq_to_iq,
+            .convert_from_iq = iq_to_iq,
+            .extract_metadata = iq_extract_metadata
+        },
+        {
+            .format = FORMAT_IQ_S4,
+            .name = "IQ_S4",
+            .extension = ".s4",
+            .can_handle = iq_can_handle,
+            .convert_to_iq = iq_to_iq,
+            .convert_from_iq = iq_to_iq,
+            .extract_metadata = iq_extract_metadata
+        },
+        {
+            .format = FORMAT_IQZ,
+            .name = "IQZ",
+            .extension = ".iqz",
+            .can_handle = iqz_can_handle,
+            .convert_to_iq = iqz_to_iq,
+            .convert_from_iq = iq_to_iqz,
+            .extract_metadata = iqz_extract_metadata
+        },
         // Add other formats here in the future
         {0} // Termination
     };
@@ -12,7 +12,10 @@ typedef enum {
     FORMAT_IQ_S16,    // Native IQ 16-bit
     FORMAT_WAV,       // WAV IQ
     FORMAT_SIGMF,     // SigMF (future)
-    FORMAT_HDF5       // HDF5 (future)
+    FORMAT_HDF5,      // HDF5 (future)
+    FORMAT_IQZ,       // Chunked compressed IQ (src/iq_core/io_iqz.h)
+    FORMAT_IQ_S12,    // Native IQ packed 12-bit (3 bytes per sample)
+    FORMAT_IQ_S4      // Native IQ packed 4-bit (1 byte per sample)
 } file_format_t;
 
 // Conversion options
@@ -20,7 +23,9 @@ typedef struct {
     bool force_overwrite;      // Overwrite destination file
     bool verbose;             // Verbose mode
     uint32_t sample_rate;     // Sample rate (0 = auto-detection)
-    size_t max_memory_mb;     // Memory limit in MB (0 = unlimited)
+    size_t max_memory_mb;     // Memory limit in MB for conversion buffers (0 = unlimited)
+    uint32_t num_threads;     // Conversion worker threads (0 = one per CPU)
+    uint32_t lossy_bits;      // IQZ output: BFP mantissa bits (0 = lossless)
     bool preserve_metadata;   // Preserve metadata if possible
 } converter_options_t;
 
@@ -1,6 +1,7 @@
 #include "iq_converter.h"
 #include "../../iq_core/io_iq.h"
 #include "../utils/file_utils.h"
+#include "../utils/parallel_convert.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,7 +13,8 @@ bool iq_can_handle(const char *filename) {
 
     // Check by file extension
     const char *ext = strrchr(filename, '.');
-    if (ext && (strcmp(ext, ".iq") == 0 || strcmp(ext, ".IQ") == 0)) {
+    if (ext && (strcmp(ext, ".iq") == 0 || strcmp(ext, ".IQ") == 0 ||
+                strcmp(ext, ".s12") == 0 || strcmp(ext, ".s4") == 0)) {
         return true;
     }
 
@@ -23,6 +25,29 @@ bool iq_can_handle(const char *filename) {
     return false;
 }
 
+bool iq_is_native_format(file_format_t format) {
+    return format == FORMAT_IQ_S8 || format == FORMAT_IQ_S16 ||
+           format == FORMAT_IQ_S12 || format == FORMAT_IQ_S4;
+}
+
+iq_format_t iq_file_format_to_core(file_format_t format) {
+    switch (format) {
+        case FORMAT_IQ_S8:  return IQ_FORMAT_S8;
+        case FORMAT_IQ_S12: return IQ_FORMAT_S12;
+        case FORMAT_IQ_S4:  return IQ_FORMAT_S4;
+        default:            return IQ_FORMAT_S16;
+    }
+}
+
+file_format_t iq_core_format_to_file(iq_format_t format) {
+    switch (format) {
+        case IQ_FORMAT_S8:  return FORMAT_IQ_S8;
+        case IQ_FORMAT_S12: return FORMAT_IQ_S12;
+        case IQ_FORMAT_S4:  return FORMAT_IQ_S4;
+        default:            return FORMAT_IQ_S16;
+    }
+}
+
 converter_result_t iq_to_iq(const conversion_request_t *request) {
     converter_result_t result = {0};
     clock_t start_time = clock();
@@ -34,49 +59,46 @@ converter_result_t iq_to_iq(const conversion_request_t *request) {
         printf("Files: %s → %s\n", request->input_file, request->output_file);
     }
 
-    // For now, we only handle simple copy (same format)
-    // Resolution conversions (s8 ↔ s16) would need to be implemented later
-
-    if (request->input_format == request->output_format) {
-        // Simple file copy
-        if (!file_copy(request->input_file, request->output_file)) {
-            snprintf(result.error_message, sizeof(result.error_message),
-                    "Error during file copy");
-            result.success = false;
-            return result;
-        }
-
-        // Get copied file size
-        size_t file_size = get_file_size(request->output_file);
-        if (file_size == 0) {
-            snprintf(result.error_message, sizeof(result.error_message),
-                    "Error: copied file is empty");
-            result.success = false;
-            return result;
-        }
-
-        // Estimate number of samples
-        size_t bytes_per_sample = (request->input_format == FORMAT_IQ_S8) ? 2 : 4;
-        size_t num_samples = file_size / bytes_per_sample;
-
-        result.success = true;
-        result.samples_converted = num_samples;
-        result.bytes_processed = file_size;
-
-        if (request->options.verbose) {
-            printf("✅ Copy successful!\n");
-            printf("Size: %zu bytes\n", file_size);
-            printf("Samples: %zu\n", num_samples);
-        }
-
-    } else {
-        // Format conversion (s8 ↔ s16) - not implemented yet
+    size_t file_size = get_file_size(request->input_file);
+    if (file_size == 0) {
         snprintf(result.error_message, sizeof(result.error_message),
-                "Conversion between different IQ formats not implemented");
+                "Error: source file is empty");
         result.success = false;
         return result;
     }
 
+    // Same format is a straight byte copy; other widths go through float
+    // exactly like loading and saving the file would (x/128 then *32767, x/32768 then *127)
+    iq_format_t input_format = iq_file_format_to_core(request->input_format);
+    iq_format_t output_format = iq_file_format_to_core(request->output_format);
+    parallel_convert_job_t job = {
+        .input_file = request->input_file,
+        .input_format = input_format,
+        .output_file = request->output_file,
+        .output_format = output_format,
+        .num_samples = file_size / iq_native_sample_bytes(input_format),
+        .rescale = input_format != output_format,
+        .max_memory_mb = request->options.max_memory_mb,
+        .num_threads = request->options.num_threads
+    };
+
+    parallel_convert_stats_t stats;
+    if (!parallel_convert(&job, &stats, result.error_message, sizeof(result.error_message))) {
+        result.success = false;
+        return result;
+    }
+
+    result.success = true;
+    result.samples_converted = (size_t)job.num_samples;
+    result.bytes_processed = (size_t)stats.bytes_written;
+
+    if (request->options.verbose) {
+        printf("✅ %s successful!\n", job.rescale ? "Conversion" : "Copy");
+        printf("Threads: %u, %zu samples per chunk\n", stats.threads, stats.chunk_samples);
+        printf("Size: %llu bytes\n", (unsigned long long)stats.bytes_written);
+        printf("Samples: %llu\n", (unsigned long long)job.num_samples);
+    }
+
     // Calculate time
     clock_t end_time = clock();
     result.conversion_time_seconds = (double)(end_time - start_time) / CLOCKS_PER_SEC;
@@ -89,7 +111,7 @@ bool iq_extract_metadata(const char *filename, file_metadata_t *metadata) {
 
     // Detect IQ file format using the core function
     iq_format_t core_format = iq_detect_format(filename);
-    file_format_t detected_format = (core_format == IQ_FORMAT_S8) ? FORMAT_IQ_S8 : FORMAT_IQ_S16;
+    file_format_t detected_format = iq_core_format_to_file(core_format);
 
     // Get file size
     size_t file_size = get_file_size(filename);
@@ -98,7 +120,7 @@ bool iq_extract_metadata(const char *filename, file_metadata_t *metadata) {
     }
 
     // Calculate number of samples
-    size_t bytes_per_sample = (detected_format == FORMAT_IQ_S8) ? 2 : 4;
+    size_t bytes_per_sample = iq_native_sample_bytes(core_format);
     size_t num_samples = file_size / bytes_per_sample;
 
     // Fill metadata
@@ -108,10 +130,9 @@ bool iq_extract_metadata(const char *filename, file_metadata_t *metadata) {
     metadata->data_size_bytes = file_size;
 
     // Description
-    const char *format_name = (detected_format == FORMAT_IQ_S8) ? "8-bit" : "16-bit";
     snprintf(metadata->description, sizeof(metadata->description),
-            "Native IQ file %s - %zu complex samples",
-            format_name, num_samples);
+            "Native IQ file %u-bit%s - %zu complex samples",
+            iq_format_bits(core_format), bytes_per_sample % 2 ? " packed" : "", num_samples);
 
     return true;
 }
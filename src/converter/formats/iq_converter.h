@@ -2,6 +2,7 @@
 #define IQ_IQ_CONVERTER_H
 
 #include "../converter.h"
+#include "../../iq_core/io_iq.h"
 
 /*
  * Functions for conversion between native IQ formats
@@ -11,12 +12,21 @@
 // Check if file can be handled by this converter
 bool iq_can_handle(const char *filename);
 
-// Convert between IQ formats (s8 ↔ s16)
+// Convert between IQ formats (s8 ↔ s16) or copy when they match
 converter_result_t iq_to_iq(const conversion_request_t *request);
 
 // Extract metadata from native IQ file
 bool iq_extract_metadata(const char *filename, file_metadata_t *metadata);
 
+// True for the raw IQ formats (s8, s16, packed s12/s4)
+bool iq_is_native_format(file_format_t format);
+
+// Core sample format of a raw IQ format (s16 for anything else)
+iq_format_t iq_file_format_to_core(file_format_t format);
+
+// Raw IQ format holding core samples of the given width
+file_format_t iq_core_format_to_file(iq_format_t format);
+
 // Internal utility functions (defined in iq_converter.c)
 
 #endif // IQ_IQ_CONVERTER_H
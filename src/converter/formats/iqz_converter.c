@@ -0,0 +1,211 @@
+#include "iqz_converter.h"
+#include "iq_converter.h"
+#include "../../iq_core/io_iq.h"
+#include "../../iq_core/io_iqz.h"
+#include "../utils/file_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+bool iqz_can_handle(const char *filename) {
+    if (!filename) return false;
+
+    const char *ext = strrchr(filename, '.');
+    if (ext && (strcmp(ext, ".iqz") == 0 || strcmp(ext, ".IQZ") == 0)) {
+        return true;
+    }
+
+    return iqz_probe(filename);
+}
+
+// Open the source of an encode: raw IQ in the requested width, anything else detected
+static bool iqz_open_source(const conversion_request_t *request, iq_reader_t *reader) {
+    if (iq_is_native_format(request->input_format)) {
+        return iq_reader_init(reader, request->input_file, iq_file_format_to_core(request->input_format));
+    }
+
+    return iq_reader_open(reader, request->input_file);
+}
+
+converter_result_t iq_to_iqz(const conversion_request_t *request) {
+    converter_result_t result = {0};
+
+    iq_reader_t reader;
+    if (!iqz_open_source(request, &reader)) {
+        snprintf(result.error_message, sizeof(result.error_message),
+                "Cannot open source file: %s", request->input_file);
+        result.success = false;
+        return result;
+    }
+
+    // Values are stored in the width they already have: WAV stays 16-bit and lossless is exact
+    uint32_t sample_rate = request->options.sample_rate ? request->options.sample_rate : reader.sample_rate;
+    iqz_writer_t *writer = iqz_writer_create(request->output_file, reader.format, sample_rate,
+                                             IQZ_DEFAULT_CHUNK, request->options.lossy_bits);
+    if (!writer) {
+        snprintf(result.error_message, sizeof(result.error_message),
+                "Cannot create IQZ file %s (lossy bits %u)", request->output_file, request->options.lossy_bits);
+        iq_reader_close(&reader);
+        result.success = false;
+        return result;
+    }
+
+    if (request->options.verbose) {
+        printf("IQ to IQZ encoding: %s → %s\n", request->input_file, request->output_file);
+        if (request->options.lossy_bits) {
+            printf("Codec: block floating point, %u-bit mantissas\n", request->options.lossy_bits);
+        } else {
+            printf("Codec: lossless (prediction + Rice)\n");
+        }
+    }
+
+    size_t sample_bytes = iq_native_sample_bytes(reader.format);
+    void *block = malloc((size_t)IQZ_DEFAULT_CHUNK * sample_bytes);
+    bool ok = block != NULL;
+    size_t total_samples = 0;
+
+    while (ok) {
+        size_t n = iq_read_native(&reader, block, IQZ_DEFAULT_CHUNK);
+        if (n == 0) break;
+        ok = iqz_writer_write(writer, block, n);
+        total_samples += n;
+    }
+
+    free(block);
+    iq_reader_close(&reader);
+    ok = iqz_writer_close(writer) && ok;
+
+    if (!ok) {
+        snprintf(result.error_message, sizeof(result.error_message),
+                "Error encoding IQZ file %s", request->output_file);
+        result.success = false;
+        return result;
+    }
+
+    size_t output_bytes = get_file_size(request->output_file);
+    result.success = true;
+    result.samples_converted = total_samples;
+    result.bytes_processed = output_bytes;
+    result.output_metadata.format = FORMAT_IQZ;
+    result.output_metadata.sample_rate = sample_rate;
+    result.output_metadata.num_samples = total_samples;
+    result.output_metadata.data_size_bytes = output_bytes;
+
+    if (request->options.verbose && total_samples > 0) {
+        double ratio = (double)(total_samples * sample_bytes) / (double)output_bytes;
+        printf("✅ Encoded %zu samples into %zu bytes (%.2fx)\n", total_samples, output_bytes, ratio);
+    }
+
+    return result;
+}
+
+converter_result_t iqz_to_iq(const conversion_request_t *request) {
+    converter_result_t result = {0};
+
+    iq_reader_t reader;
+    if (!iqz_probe(request->input_file) || !iq_reader_open(&reader, request->input_file)) {
+        snprintf(result.error_message, sizeof(result.error_message),
+                "Cannot open IQZ file: %s", request->input_file);
+        result.success = false;
+        return result;
+    }
+
+    FILE *output = fopen(request->output_file, "wb");
+    if (!output) {
+        snprintf(result.error_message, sizeof(result.error_message),
+                "Cannot create output file: %s", strerror(errno));
+        iq_reader_close(&reader);
+        result.success = false;
+        return result;
+    }
+
+    // Same width copies the values; other widths go through float like iq_to_iq
+    iq_format_t output_format = iq_file_format_to_core(request->output_format);
+    bool rescale = output_format != reader.format;
+    size_t in_bytes = iq_native_sample_bytes(reader.format);
+    size_t out_bytes = iq_native_sample_bytes(output_format);
+
+    if (request->options.verbose) {
+        printf("IQZ to IQ decoding: %s → %s\n", request->input_file, request->output_file);
+    }
+
+    uint8_t *block = (uint8_t *)malloc((size_t)IQZ_DEFAULT_CHUNK * in_bytes);
+    float *values = rescale ? (float *)malloc((size_t)IQZ_DEFAULT_CHUNK * 2 * sizeof(float)) : NULL;
+    uint8_t *converted = rescale ? (uint8_t *)malloc((size_t)IQZ_DEFAULT_CHUNK * out_bytes) : NULL;
+    bool ok = block && (!rescale || (values && converted));
+    size_t total_samples = 0;
+
+    while (ok) {
+        size_t n = iq_read_native(&reader, block, IQZ_DEFAULT_CHUNK);
+        if (n == 0) break;
+
+        const uint8_t *data = block;
+        if (rescale) {
+            ok = iq_convert_to_float(block, n * in_bytes, reader.format, values, n);
+            iq_convert_from_float(values, n * 2, output_format, converted);
+            data = converted;
+        }
+        ok = ok && fwrite(data, out_bytes, n, output) == n;
+        total_samples += n;
+    }
+
+    // A decode that stopped early means a damaged chunk
+    ok = ok && total_samples == reader.total_samples;
+
+    free(block);
+    free(values);
+    free(converted);
+    iq_reader_close(&reader);
+    if (fclose(output) != 0) {
+        ok = false;
+    }
+
+    if (!ok) {
+        snprintf(result.error_message, sizeof(result.error_message),
+                "Error decoding IQZ file %s after %zu samples", request->input_file, total_samples);
+        result.success = false;
+        return result;
+    }
+
+    result.success = true;
+    result.samples_converted = total_samples;
+    result.bytes_processed = total_samples * out_bytes;
+    result.output_metadata.format = request->output_format;
+    result.output_metadata.num_samples = total_samples;
+    result.output_metadata.data_size_bytes = total_samples * out_bytes;
+
+    return result;
+}
+
+bool iqz_extract_metadata(const char *filename, file_metadata_t *metadata) {
+    if (!filename || !metadata) return false;
+
+    iqz_file_t *file = iqz_open(filename);
+    if (!file) {
+        return false;
+    }
+
+    const iqz_info_t *info = iqz_info(file);
+    metadata->format = FORMAT_IQZ;
+    metadata->sample_rate = info->sample_rate;
+    metadata->num_samples = (size_t)info->num_samples;
+    metadata->data_size_bytes = (size_t)info->file_bytes;
+
+    double raw_bytes = (double)info->num_samples * (double)iq_native_sample_bytes(info->format);
+    double ratio = info->file_bytes ? raw_bytes / (double)info->file_bytes : 0.0;
+    if (info->codec == IQZ_CODEC_BFP) {
+        snprintf(metadata->description, sizeof(metadata->description),
+                "IQZ %s-bit, BFP %u-bit mantissas - %llu complex samples, %.2fx",
+                info->format == IQ_FORMAT_S8 ? "8" : "16", info->mantissa_bits,
+                (unsigned long long)info->num_samples, ratio);
+    } else {
+        snprintf(metadata->description, sizeof(metadata->description),
+                "IQZ %s-bit, lossless - %llu complex samples, %.2fx",
+                info->format == IQ_FORMAT_S8 ? "8" : "16",
+                (unsigned long long)info->num_samples, ratio);
+    }
+
+    iqz_close(file);
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef IQ_IQZ_CONVERTER_H
+#define IQ_IQZ_CONVERTER_H
+
+#include "../converter.h"
+
+/*
+ * Functions for the IQZ compressed container (src/iq_core/io_iqz.h)
+ * Native IQ, WAV IQ and IQZ files encode to IQZ; IQZ decodes to native IQ.
+ */
+
+// Check if file can be handled by this converter
+bool iqz_can_handle(const char *filename);
+
+// Encode an IQ, WAV or IQZ file into an IQZ container (options.lossy_bits picks the codec)
+converter_result_t iq_to_iqz(const conversion_request_t *request);
+
+// Decode an IQZ container to native s8/s16 IQ
+converter_result_t iqz_to_iq(const conversion_request_t *request);
+
+// Extract metadata from an IQZ container
+bool iqz_extract_metadata(const char *filename, file_metadata_t *metadata);
+
+#endif // IQ_IQZ_CONVERTER_H
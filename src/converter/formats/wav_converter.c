@@ -1,5 +1,7 @@
 #include "wav_converter.h"
+#include "iq_converter.h"
 #include "../utils/file_utils.h"
+#include "../utils/parallel_convert.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -143,13 +145,17 @@ bool wav_reader_open(wav_reader_t *reader, const char *filename) {
         } else if (memcmp(chunk_id, "data", 4) == 0) {
             // Data chunk found (standard format)
             memcpy(reader->header.data_id, chunk_id, 4);
-            reader->header.data_size = chunk_size;
+            // RF64 writes 0xFFFFFFFF here and keeps the real size in ds64
+            if (!reader->is_rf64 || chunk_size != 0xFFFFFFFF) {
+                reader->header.data_size = chunk_size;
+            }
             reader->data_offset = offset + 8;
             break;
         } else if (memcmp(chunk_id, "ds64", 4) == 0 && reader->is_rf64) {
             // ds64 chunk for RF64 (64-bit size)
             if (chunk_size >= 24) {
-                reader->header.data_size = read_u64_le(header_data + offset + 8);
+                // ds64 body: RIFF size, then data size
+                reader->header.data_size = read_u64_le(header_data + offset + RF64_DATA_SIZE_OFFSET);
                 memcpy(reader->header.data_id, "ds64", 4);
             }
             offset += 8 + chunk_size;
@@ -167,7 +173,10 @@ bool wav_reader_open(wav_reader_t *reader, const char *filename) {
             uint32_t chunk_size = read_u32_le(header_data + offset + 4);
 
             if (memcmp(chunk_id, "data", 4) == 0) {
-                reader->header.data_size = chunk_size; // May be 0xFFFFFFFF
+                // 0xFFFFFFFF defers to the 64-bit size from ds64
+                if (chunk_size != 0xFFFFFFFF) {
+                    reader->header.data_size = chunk_size;
+                }
                 reader->data_offset = offset + 8;
                 break;
             }
@@ -457,97 +466,44 @@ converter_result_t wav_to_iq(const conversion_request_t *request) {
         printf("Sample rate: %u Hz\n", reader.header.sample_rate);
         printf("Resolution: %d bits\n", reader.header.bits_per_sample);
         printf("Channels: %d\n", reader.header.channels);
-        printf("Data size: %llu bytes\n", reader.header.data_size);
-    }
-
-    // Create output IQ file
-    FILE *iq_file = fopen(request->output_file, "wb");
-    if (!iq_file) {
-        snprintf(result.error_message, sizeof(result.error_message),
-                "Cannot create IQ file: %s (%s)",
-                request->output_file, strerror(errno));
-        wav_reader_close(&reader);
-        result.success = false;
-        return result;
-    }
-
-    // Configure conversion
-    const size_t BUFFER_SIZE = 65536;  // 64 KB of WAV data at a time
-    float *float_buffer = (float *)malloc(BUFFER_SIZE * 2 * sizeof(float));
-    int16_t *int16_buffer = (int16_t *)malloc(BUFFER_SIZE * 2 * sizeof(int16_t));
-
-    if (!float_buffer || !int16_buffer) {
-        snprintf(result.error_message, sizeof(result.error_message),
-                "Memory allocation failed");
-        free(float_buffer);
-        free(int16_buffer);
-        fclose(iq_file);
-        wav_reader_close(&reader);
-        result.success = false;
-        return result;
+        printf("Data size: %llu bytes\n", (unsigned long long)reader.header.data_size);
     }
 
-    // Block conversion
-    size_t total_samples = 0;
-    size_t total_bytes = 0;
-    bool conversion_error = false;
-
-    if (request->options.verbose) {
-        printf("\nStarting conversion...\n");
-        printf("Progress: 0%%");
-        fflush(stdout);
+    // Samples come from the data chunk only, never from trailing chunks
+    uint64_t file_bytes = get_file_size(request->input_file);
+    uint64_t data_bytes = file_bytes > reader.data_offset ? file_bytes - reader.data_offset : 0;
+    if (reader.header.data_size > 0 && reader.header.data_size < data_bytes) {
+        data_bytes = reader.header.data_size;
     }
+    size_t data_offset = reader.data_offset;
+    wav_header_t header = reader.header;  // Closing clears the reader
+    wav_reader_close(&reader);
 
-    while (!conversion_error) {
-        // Read a block of WAV data
-        size_t samples_read = wav_read_samples(&reader, float_buffer, BUFFER_SIZE);
-
-        if (samples_read == 0) {
-            // End of file
-            break;
-        }
-
-        // Convert float to int16 for IQ format
-        for (size_t i = 0; i < samples_read * 2; i++) {
-            // Clip to avoid overflow
-            float sample = float_buffer[i];
-            if (sample > 1.0f) sample = 1.0f;
-            if (sample < -1.0f) sample = -1.0f;
-
-            int16_buffer[i] = (int16_t)(sample * 32767.0f);
-        }
-
-        // Write to IQ file
-        size_t bytes_to_write = samples_read * 4;  // 4 bytes per complex sample (I+Q)
-        size_t bytes_written = fwrite(int16_buffer, 1, bytes_to_write, iq_file);
-
-        if (bytes_written != bytes_to_write) {
-            snprintf(result.error_message, sizeof(result.error_message),
-                    "Error writing to IQ file");
-            conversion_error = true;
-            break;
-        }
-
-        total_samples += samples_read;
-        total_bytes += bytes_written;
-
-        // Display progress
-        if (request->options.verbose && total_samples % 10000 == 0) {
-            double progress = (double)reader.bytes_read / (double)reader.header.data_size * 100.0;
-            printf("\rProgress: %.1f%%", progress);
-            fflush(stdout);
-        }
-    }
+    // Mono and stereo 16-bit PCM both hold interleaved I/Q values on disk;
+    // each value goes through float (x/32768, then *32767 or *127)
+    parallel_convert_job_t job = {
+        .input_file = request->input_file,
+        .input_offset = data_offset,
+        .input_format = IQ_FORMAT_S16,
+        .output_file = request->output_file,
+        .output_format = iq_file_format_to_core(request->output_format),
+        .num_samples = data_bytes / iq_native_sample_bytes(IQ_FORMAT_S16),
+        .rescale = true,
+        .max_memory_mb = request->options.max_memory_mb,
+        .num_threads = request->options.num_threads
+    };
 
     if (request->options.verbose) {
-        printf("\rProgress: 100.0%% - Complete!\n");
+        parallel_convert_stats_t plan;
+        parallel_convert_plan(&job, &plan);
+        printf("\nStarting conversion: %u thread(s), %zu samples per chunk, %.1f MB of buffers\n",
+               plan.threads, plan.chunk_samples, (double)plan.buffer_bytes / (1024.0 * 1024.0));
     }
 
-    // Cleanup
-    free(float_buffer);
-    free(int16_buffer);
-    fclose(iq_file);
-    wav_reader_close(&reader);
+    parallel_convert_stats_t stats;
+    bool conversion_error = !parallel_convert(&job, &stats, result.error_message, sizeof(result.error_message));
+    size_t total_samples = (size_t)job.num_samples;
+    size_t total_bytes = conversion_error ? 0 : (size_t)stats.bytes_written;
 
     // Final result
     if (!conversion_error) {
@@ -557,13 +513,13 @@ converter_result_t wav_to_iq(const conversion_request_t *request) {
 
         // Input metadata
         result.input_metadata.format = FORMAT_WAV;
-        result.input_metadata.sample_rate = reader.header.sample_rate;
+        result.input_metadata.sample_rate = header.sample_rate;
         result.input_metadata.num_samples = total_samples;
-        result.input_metadata.data_size_bytes = reader.header.data_size;
+        result.input_metadata.data_size_bytes = header.data_size;
 
         // Output metadata
-        result.output_metadata.format = (request->output_format == FORMAT_IQ_S8) ? FORMAT_IQ_S8 : FORMAT_IQ_S16;
-        result.output_metadata.sample_rate = reader.header.sample_rate;
+        result.output_metadata.format = iq_core_format_to_file(iq_file_format_to_core(request->output_format));
+        result.output_metadata.sample_rate = header.sample_rate;
         result.output_metadata.num_samples = total_samples;
         result.output_metadata.data_size_bytes = total_bytes;
 
@@ -1,3 +1,7 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // strdup under -std=c11
+#endif
+
 #include "file_utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -0,0 +1,370 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // pread, pwrite, ftruncate under -std=c11
+#endif
+
+#include "parallel_convert.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Threads are dropped before chunks get smaller than this (complex samples)
+#define PARALLEL_CONVERT_MIN_CHUNK (64 * 1024)
+
+// Values converted per pass through the float stage (stack buffer)
+#define PARALLEL_CONVERT_FLOAT_BLOCK 4096
+
+typedef struct {
+    const parallel_convert_job_t *job;
+    int input_fd;
+    int output_fd;
+    size_t chunk_samples;
+    uint64_t num_chunks;
+    atomic_uint_fast64_t next_chunk;  // Next chunk index to claim
+    atomic_bool failed;
+    pthread_mutex_t error_lock;
+    char error[256];                  // First failure reported by a worker
+#ifdef _WIN32
+    pthread_mutex_t io_lock;          // No positioned I/O: seek + read/write under a lock
+#endif
+} pc_shared_t;
+
+typedef struct {
+    pc_shared_t *shared;
+    uint8_t *input;                   // One chunk of raw input
+    uint8_t *output;                  // One chunk of converted output (rescaling jobs only)
+    pthread_t thread;
+    bool started;
+} pc_worker_t;
+
+uint32_t parallel_convert_default_threads(void) {
+    long count;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = (long)info.dwNumberOfProcessors;
+#else
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (count < 1) count = 1;
+    if (count > PARALLEL_CONVERT_MAX_THREADS) count = PARALLEL_CONVERT_MAX_THREADS;
+    return (uint32_t)count;
+}
+
+// Bytes of buffer one worker needs per complex sample of chunk
+static size_t pc_buffer_bytes_per_sample(const parallel_convert_job_t *job) {
+    size_t bytes = iq_native_sample_bytes(job->input_format);
+    if (job->rescale) {
+        bytes += iq_native_sample_bytes(job->output_format);
+    }
+    return bytes;
+}
+
+static size_t pc_align_up(uint64_t samples) {
+    return (size_t)((samples + PARALLEL_CONVERT_ALIGN - 1) / PARALLEL_CONVERT_ALIGN * PARALLEL_CONVERT_ALIGN);
+}
+
+void parallel_convert_plan(const parallel_convert_job_t *job, parallel_convert_stats_t *plan) {
+    memset(plan, 0, sizeof(*plan));
+
+    size_t per_sample = pc_buffer_bytes_per_sample(job);
+    uint32_t threads = job->num_threads ? job->num_threads : parallel_convert_default_threads();
+    if (threads > PARALLEL_CONVERT_MAX_THREADS) threads = PARALLEL_CONVERT_MAX_THREADS;
+
+    // No more workers than aligned chunks to give them
+    uint64_t max_chunks = (job->num_samples + PARALLEL_CONVERT_ALIGN - 1) / PARALLEL_CONVERT_ALIGN;
+    if (max_chunks < 1) max_chunks = 1;
+    if (threads > max_chunks) threads = (uint32_t)max_chunks;
+
+    size_t chunk = PARALLEL_CONVERT_CHUNK;
+    if (job->max_memory_mb > 0) {
+        size_t budget = job->max_memory_mb * 1024 * 1024;
+        while (threads > 1 && budget / threads / per_sample < PARALLEL_CONVERT_MIN_CHUNK) {
+            threads--;
+        }
+        size_t limit = budget / threads / per_sample;
+        if (chunk > limit) chunk = limit;
+    }
+
+    // Small inputs: spread the samples over every worker
+    size_t share = pc_align_up((job->num_samples + threads - 1) / threads);
+    if (chunk > share) chunk = share;
+
+    chunk = chunk / PARALLEL_CONVERT_ALIGN * PARALLEL_CONVERT_ALIGN;
+    if (chunk < PARALLEL_CONVERT_ALIGN) chunk = PARALLEL_CONVERT_ALIGN;
+
+    plan->threads = threads;
+    plan->chunk_samples = chunk;
+    plan->buffer_bytes = (size_t)threads * chunk * per_sample;
+}
+
+static void pc_fail(pc_shared_t *shared, const char *message) {
+    pthread_mutex_lock(&shared->error_lock);
+    if (!atomic_load(&shared->failed)) {
+        snprintf(shared->error, sizeof(shared->error), "%s", message);
+        atomic_store(&shared->failed, true);
+    }
+    pthread_mutex_unlock(&shared->error_lock);
+}
+
+// Read exactly 'size' bytes at 'offset'; a short file is an error
+static bool pc_read_at(pc_shared_t *shared, uint8_t *buffer, size_t size, uint64_t offset) {
+#ifdef _WIN32
+    pthread_mutex_lock(&shared->io_lock);
+    bool ok = _lseeki64(shared->input_fd, (__int64)offset, SEEK_SET) >= 0;
+    while (ok && size > 0) {
+        int got = _read(shared->input_fd, buffer, size > (1u << 30) ? (1u << 30) : (unsigned)size);
+        if (got <= 0) {
+            ok = false;
+            break;
+        }
+        buffer += got;
+        size -= (size_t)got;
+    }
+    pthread_mutex_unlock(&shared->io_lock);
+    return ok;
+#else
+    while (size > 0) {
+        ssize_t got = pread(shared->input_fd, buffer, size, (off_t)offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            if (got == 0) errno = EIO;
+            return false;
+        }
+        buffer += got;
+        size -= (size_t)got;
+        offset += (uint64_t)got;
+    }
+    return true;
+#endif
+}
+
+static bool pc_write_at(pc_shared_t *shared, const uint8_t *buffer, size_t size, uint64_t offset) {
+#ifdef _WIN32
+    pthread_mutex_lock(&shared->io_lock);
+    bool ok = _lseeki64(shared->output_fd, (__int64)offset, SEEK_SET) >= 0;
+    while (ok && size > 0) {
+        int put = _write(shared->output_fd, buffer, size > (1u << 30) ? (1u << 30) : (unsigned)size);
+        if (put <= 0) {
+            ok = false;
+            break;
+        }
+        buffer += put;
+        size -= (size_t)put;
+    }
+    pthread_mutex_unlock(&shared->io_lock);
+    return ok;
+#else
+    while (size > 0) {
+        ssize_t put = pwrite(shared->output_fd, buffer, size, (off_t)offset);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) {
+            if (put == 0) errno = EIO;
+            return false;
+        }
+        buffer += put;
+        size -= (size_t)put;
+        offset += (uint64_t)put;
+    }
+    return true;
+#endif
+}
+
+// Raw values -> float -> raw values, one stack block at a time
+// Offsets step in whole I/Q pairs so packed s12/s4 stay byte-aligned
+static void pc_rescale(const parallel_convert_job_t *job, const uint8_t *input, uint8_t *output, size_t values) {
+    float block[PARALLEL_CONVERT_FLOAT_BLOCK];
+    size_t in_pair = iq_native_sample_bytes(job->input_format);
+    size_t out_pair = iq_native_sample_bytes(job->output_format);
+
+    for (size_t done = 0; done < values; done += PARALLEL_CONVERT_FLOAT_BLOCK) {
+        size_t count = values - done < PARALLEL_CONVERT_FLOAT_BLOCK ? values - done : PARALLEL_CONVERT_FLOAT_BLOCK;
+        iq_convert_to_float(input + done / 2 * in_pair, count / 2 * in_pair, job->input_format,
+                            block, PARALLEL_CONVERT_FLOAT_BLOCK / 2);
+        iq_convert_from_float(block, count, job->output_format, output + done / 2 * out_pair);
+    }
+}
+
+static void *pc_worker_run(void *arg) {
+    pc_worker_t *worker = (pc_worker_t *)arg;
+    pc_shared_t *shared = worker->shared;
+    const parallel_convert_job_t *job = shared->job;
+    size_t in_sample = iq_native_sample_bytes(job->input_format);
+    size_t out_sample = job->rescale ? iq_native_sample_bytes(job->output_format) : in_sample;
+    char message[256];
+
+    while (!atomic_load(&shared->failed)) {
+        uint64_t chunk = atomic_fetch_add(&shared->next_chunk, 1);
+        if (chunk >= shared->num_chunks) {
+            break;
+        }
+
+        uint64_t first = chunk * shared->chunk_samples;
+        size_t count = shared->chunk_samples;
+        if (count > job->num_samples - first) {
+            count = (size_t)(job->num_samples - first);
+        }
+
+        if (!pc_read_at(shared, worker->input, count * in_sample, job->input_offset + first * in_sample)) {
+            snprintf(message, sizeof(message), "Read failed at sample %llu: %s",
+                     (unsigned long long)first, strerror(errno));
+            pc_fail(shared, message);
+            break;
+        }
+
+        const uint8_t *result = worker->input;
+        if (job->rescale) {
+            pc_rescale(job, worker->input, worker->output, count * 2);
+            result = worker->output;
+        }
+
+        if (!pc_write_at(shared, result, count * out_sample, first * out_sample)) {
+            snprintf(message, sizeof(message), "Write failed at sample %llu: %s",
+                     (unsigned long long)first, strerror(errno));
+            pc_fail(shared, message);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static int pc_open(const char *path, bool output) {
+#ifdef _WIN32
+    return output ? _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE)
+                  : _open(path, _O_RDONLY | _O_BINARY);
+#else
+    return output ? open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : open(path, O_RDONLY);
+#endif
+}
+
+static int pc_close(int fd) {
+#ifdef _WIN32
+    return _close(fd);
+#else
+    return close(fd);
+#endif
+}
+
+// Size the output up front so chunks can land in any order
+static bool pc_set_size(int fd, uint64_t bytes) {
+#ifdef _WIN32
+    return _chsize_s(fd, (__int64)bytes) == 0;
+#else
+    return ftruncate(fd, (off_t)bytes) == 0;
+#endif
+}
+
+bool parallel_convert(const parallel_convert_job_t *job, parallel_convert_stats_t *stats,
+                      char *error_message, size_t max_length) {
+    if (!job || !job->input_file || !job->output_file) {
+        snprintf(error_message, max_length, "Invalid conversion job");
+        return false;
+    }
+    if (!job->rescale && job->input_format != job->output_format) {
+        snprintf(error_message, max_length, "Byte copy needs identical input and output formats");
+        return false;
+    }
+
+    parallel_convert_stats_t plan;
+    parallel_convert_plan(job, &plan);
+    size_t in_sample = iq_native_sample_bytes(job->input_format);
+    size_t out_sample = job->rescale ? iq_native_sample_bytes(job->output_format) : in_sample;
+    plan.bytes_written = job->num_samples * out_sample;
+
+    pc_shared_t shared;
+    memset(&shared, 0, sizeof(shared));
+    shared.job = job;
+    shared.chunk_samples = plan.chunk_samples;
+    shared.num_chunks = (job->num_samples + plan.chunk_samples - 1) / plan.chunk_samples;
+    atomic_init(&shared.next_chunk, 0);
+    atomic_init(&shared.failed, false);
+
+    shared.input_fd = pc_open(job->input_file, false);
+    if (shared.input_fd < 0) {
+        snprintf(error_message, max_length, "Cannot open %s: %s", job->input_file, strerror(errno));
+        return false;
+    }
+    shared.output_fd = pc_open(job->output_file, true);
+    if (shared.output_fd < 0) {
+        snprintf(error_message, max_length, "Cannot create %s: %s", job->output_file, strerror(errno));
+        pc_close(shared.input_fd);
+        return false;
+    }
+    if (!pc_set_size(shared.output_fd, plan.bytes_written)) {
+        snprintf(error_message, max_length, "Cannot size %s: %s", job->output_file, strerror(errno));
+        pc_close(shared.output_fd);
+        pc_close(shared.input_fd);
+        return false;
+    }
+
+    pc_worker_t *workers = (pc_worker_t *)calloc(plan.threads, sizeof(pc_worker_t));
+    bool ok = workers != NULL;
+    for (uint32_t i = 0; ok && i < plan.threads; i++) {
+        workers[i].shared = &shared;
+        workers[i].input = (uint8_t *)malloc(plan.chunk_samples * in_sample);
+        if (job->rescale) {
+            workers[i].output = (uint8_t *)malloc(plan.chunk_samples * out_sample);
+        }
+        ok = workers[i].input && (!job->rescale || workers[i].output);
+    }
+    if (!ok) {
+        snprintf(error_message, max_length, "Memory allocation failed for %u conversion buffers", plan.threads);
+    }
+
+    if (ok) {
+        pthread_mutex_init(&shared.error_lock, NULL);
+#ifdef _WIN32
+        pthread_mutex_init(&shared.io_lock, NULL);
+#endif
+        // The calling thread is worker 0; a worker that fails to start just leaves its chunks to the others
+        for (uint32_t i = 1; i < plan.threads; i++) {
+            workers[i].started = pthread_create(&workers[i].thread, NULL, pc_worker_run, &workers[i]) == 0;
+        }
+        pc_worker_run(&workers[0]);
+        for (uint32_t i = 1; i < plan.threads; i++) {
+            if (workers[i].started) {
+                pthread_join(workers[i].thread, NULL);
+            }
+        }
+
+        if (atomic_load(&shared.failed)) {
+            snprintf(error_message, max_length, "%s", shared.error);
+            ok = false;
+        }
+        pthread_mutex_destroy(&shared.error_lock);
+#ifdef _WIN32
+        pthread_mutex_destroy(&shared.io_lock);
+#endif
+    }
+
+    for (uint32_t i = 0; workers && i < plan.threads; i++) {
+        free(workers[i].input);
+        free(workers[i].output);
+    }
+    free(workers);
+
+    if (pc_close(shared.output_fd) != 0 && ok) {
+        snprintf(error_message, max_length, "Error closing %s: %s", job->output_file, strerror(errno));
+        ok = false;
+    }
+    pc_close(shared.input_fd);
+
+    if (ok && stats) {
+        *stats = plan;
+    }
+    return ok;
+}
@@ -0,0 +1,62 @@
+#ifndef IQ_PARALLEL_CONVERT_H
+#define IQ_PARALLEL_CONVERT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../../iq_core/io_iq.h"
+
+/*
+ * Chunked parallel conversion of raw interleaved IQ values
+ * The input range is split into chunks aligned to PARALLEL_CONVERT_ALIGN
+ * samples; a pool of workers claims chunks in order, reads each with a
+ * positioned read, converts it and writes it at its own output offset, so
+ * the output is the same whatever the thread count or chunk size.
+ */
+
+// Chunk boundaries fall on multiples of this many complex samples
+#define PARALLEL_CONVERT_ALIGN 4096
+
+// Default chunk when memory is not limited (complex samples)
+#define PARALLEL_CONVERT_CHUNK (1024 * 1024)
+
+// Upper bound on worker threads
+#define PARALLEL_CONVERT_MAX_THREADS 64
+
+typedef struct {
+    const char *input_file;
+    uint64_t input_offset;      // Byte offset of the first input value (e.g. past a WAV header)
+    iq_format_t input_format;   // Raw value type of the input
+    const char *output_file;    // Created or truncated; holds only the converted values
+    iq_format_t output_format;  // Raw value type of the output
+    uint64_t num_samples;       // Complex samples to convert
+    bool rescale;               // Go through float (x/32768 or x/128, then *32767 or *127); false copies bytes
+    size_t max_memory_mb;       // Bound on all chunk buffers together (0 = unlimited)
+    uint32_t num_threads;       // Worker threads (0 = one per CPU)
+} parallel_convert_job_t;
+
+typedef struct {
+    uint32_t threads;           // Workers actually started
+    size_t chunk_samples;       // Complex samples per chunk
+    size_t buffer_bytes;        // Chunk buffers held across all workers
+    uint64_t bytes_written;     // Output bytes
+} parallel_convert_stats_t;
+
+// Hardware threads available (at least 1, at most PARALLEL_CONVERT_MAX_THREADS)
+uint32_t parallel_convert_default_threads(void);
+
+/*
+ * Pick the thread count and chunk size for a job without running it
+ * Threads are dropped before chunks shrink below 64K samples, and the
+ * chunk buffers of all threads fit in max_memory_mb when it is set.
+ */
+void parallel_convert_plan(const parallel_convert_job_t *job, parallel_convert_stats_t *plan);
+
+/*
+ * Run a conversion job
+ * Returns false and fills error_message on failure; 'stats' may be NULL.
+ */
+bool parallel_convert(const parallel_convert_job_t *job, parallel_convert_stats_t *stats,
+                      char *error_message, size_t max_length);
+
+#endif // IQ_PARALLEL_CONVERT_H
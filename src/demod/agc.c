@@ -39,6 +39,15 @@
  * - Peak Smoothing: Exponential moving average
  * - Gain Smoothing: Linear interpolation for artifact reduction
  *
+ * Block Mode (agc_set_block_size / agc_process_block):
+ * - Peak envelope of each sub-block in one vectorised pass
+ * - Detector, hang counter and gain updated once per sub-block with the
+ *   per-sample coefficients compounded over its length
+ * - Gain ramped linearly from the previous to the new value across the
+ *   sub-block (vectorised), so the gain never steps between samples
+ * - SSE2/AVX on x86, NEON on AArch64, dispatched once at run time; the
+ *   peak and ramp kernels give the same outputs as the scalar ones
+ *
  * Performance:
  * - O(1) complexity per sample
  * - Memory efficient (fixed state size)
@@ -59,6 +68,30 @@
 #include "agc.h"
 #include <math.h>
 #include <string.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AGC_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define AGC_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Per-sample gain smoothing factor
+#define AGC_GAIN_SMOOTHING 0.2f
+
+// Block kernels, chosen on first use
+enum {
+    AGC_SIMD_SCALAR,
+    AGC_SIMD_SSE2,
+    AGC_SIMD_AVX,
+    AGC_SIMD_NEON
+};
+
+static atomic_int agc_simd_active = -1;
 
 // Initialize AGC with default parameters suitable for audio demodulation
 bool agc_init(agc_t *agc, uint32_t sample_rate) {
@@ -98,6 +131,10 @@ bool agc_init_custom(agc_t *agc, uint32_t sample_rate,
     // release_coeff = 1 - exp(-1/(release_time * sample_rate))
     agc->release_coeff = 1.0f - expf(-1.0f / (release_time * (float)sample_rate));
 
+    // Per-sample processing until block mode is enabled
+    agc->block_size = 0;
+    agc->block_attack_coeff = agc->block_release_coeff = agc->block_smooth_coeff = 0.0f;
+
     return true;
 }
 
@@ -138,7 +175,7 @@ float agc_process_sample(agc_t *agc, float input_sample) {
     // Smooth gain changes to avoid artifacts
     // Faster smoothing for better response
     float gain_change = target_gain - agc->current_gain;
-    agc->current_gain += 0.2f * gain_change; // Increased from 0.1 to 0.2
+    agc->current_gain += AGC_GAIN_SMOOTHING * gain_change; // Increased from 0.1 to 0.2
 
     // Ensure gain doesn't go below 1.0 (no attenuation)
     if (agc->current_gain < 1.0f) {
@@ -155,6 +192,10 @@ bool agc_process_buffer(agc_t *agc, float *buffer, uint32_t num_samples) {
         return false;
     }
 
+    if (agc->block_size > 0) {
+        return agc_process_block(agc, buffer, num_samples);
+    }
+
     for (uint32_t i = 0; i < num_samples; i++) {
         buffer[i] = agc_process_sample(agc, buffer[i]);
     }
@@ -162,6 +203,234 @@ bool agc_process_buffer(agc_t *agc, float *buffer, uint32_t num_samples) {
     return true;
 }
 
+// Per-sample coefficients compounded over n samples: n steps of
+// d += c * (x - d) with a constant x move d by 1 - (1 - c)^n of the way
+static void agc_block_coeffs(const agc_t *agc, uint32_t n,
+                             float *attack, float *release, float *smooth) {
+    *attack = 1.0f - powf(1.0f - agc->attack_coeff, (float)n);
+    *release = 1.0f - powf(1.0f - agc->release_coeff, (float)n);
+    *smooth = 1.0f - powf(1.0f - AGC_GAIN_SMOOTHING, (float)n);
+}
+
+// Enable block mode
+bool agc_set_block_size(agc_t *agc, uint32_t block_size) {
+    if (!agc) return false;
+
+    agc->block_size = block_size;
+    if (block_size > 0) {
+        agc_block_coeffs(agc, block_size, &agc->block_attack_coeff,
+                         &agc->block_release_coeff, &agc->block_smooth_coeff);
+    }
+    return true;
+}
+
+static int agc_simd_detect(void) {
+#if defined(AGC_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx")) return AGC_SIMD_AVX;
+    if (__builtin_cpu_supports("sse2")) return AGC_SIMD_SSE2;
+    return AGC_SIMD_SCALAR;
+#elif defined(AGC_HAVE_NEON)
+    return AGC_SIMD_NEON;
+#else
+    return AGC_SIMD_SCALAR;
+#endif
+}
+
+void agc_force_scalar(bool scalar) {
+    atomic_store(&agc_simd_active, scalar ? AGC_SIMD_SCALAR : agc_simd_detect());
+}
+
+// Largest |x[k]| (the maximum does not depend on the order, so every
+// kernel returns the same value)
+static float agc_peak_scalar(const float *x, uint32_t n) {
+    float peak = 0.0f;
+    for (uint32_t k = 0; k < n; k++) {
+        float a = fabsf(x[k]);
+        peak = a > peak ? a : peak;
+    }
+    return peak;
+}
+
+// x[k] *= gain + step * (k + 1), from sample begin
+static void agc_ramp_scalar(float *x, uint32_t begin, uint32_t n, float gain, float step) {
+    for (uint32_t k = begin; k < n; k++) {
+        x[k] *= gain + step * (float)(k + 1);
+    }
+}
+
+#if defined(AGC_HAVE_X86_SIMD)
+
+__attribute__((target("sse2")))
+static float agc_peak_sse2(const float *x, uint32_t n) {
+    const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 m = _mm_setzero_ps();
+    uint32_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        m = _mm_max_ps(m, _mm_and_ps(_mm_loadu_ps(x + k), mask));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, m);
+    float peak = agc_peak_scalar(x + k, n - k);
+    for (int l = 0; l < 4; l++) peak = lanes[l] > peak ? lanes[l] : peak;
+    return peak;
+}
+
+__attribute__((target("sse2")))
+static void agc_ramp_sse2(float *x, uint32_t n, float gain, float step) {
+    const __m128 g = _mm_set1_ps(gain), s = _mm_set1_ps(step);
+    __m128 index = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    uint32_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m128 ramp = _mm_add_ps(g, _mm_mul_ps(s, index));
+        _mm_storeu_ps(x + k, _mm_mul_ps(_mm_loadu_ps(x + k), ramp));
+        index = _mm_add_ps(index, four);
+    }
+    agc_ramp_scalar(x, k, n, gain, step);
+}
+
+__attribute__((target("avx")))
+static float agc_peak_avx(const float *x, uint32_t n) {
+    const __m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 m = _mm256_setzero_ps();
+    uint32_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        m = _mm256_max_ps(m, _mm256_and_ps(_mm256_loadu_ps(x + k), mask));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, m);
+    float peak = agc_peak_scalar(x + k, n - k);
+    for (int l = 0; l < 8; l++) peak = lanes[l] > peak ? lanes[l] : peak;
+    return peak;
+}
+
+__attribute__((target("avx")))
+static void agc_ramp_avx(float *x, uint32_t n, float gain, float step) {
+    const __m256 g = _mm256_set1_ps(gain), s = _mm256_set1_ps(step);
+    __m256 index = _mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+    const __m256 eight = _mm256_set1_ps(8.0f);
+    uint32_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256 ramp = _mm256_add_ps(g, _mm256_mul_ps(s, index));
+        _mm256_storeu_ps(x + k, _mm256_mul_ps(_mm256_loadu_ps(x + k), ramp));
+        index = _mm256_add_ps(index, eight);
+    }
+    agc_ramp_scalar(x, k, n, gain, step);
+}
+
+#endif /* AGC_HAVE_X86_SIMD */
+
+#if defined(AGC_HAVE_NEON)
+
+static float agc_peak_neon(const float *x, uint32_t n) {
+    float32x4_t m = vdupq_n_f32(0.0f);
+    uint32_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        m = vmaxq_f32(m, vabsq_f32(vld1q_f32(x + k)));
+    }
+    float peak = agc_peak_scalar(x + k, n - k);
+    float lanes = vmaxvq_f32(m);
+    return lanes > peak ? lanes : peak;
+}
+
+static void agc_ramp_neon(float *x, uint32_t n, float gain, float step) {
+    const float32x4_t g = vdupq_n_f32(gain), s = vdupq_n_f32(step);
+    const float init[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float32x4_t index = vld1q_f32(init);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    uint32_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        float32x4_t ramp = vaddq_f32(g, vmulq_f32(s, index));
+        vst1q_f32(x + k, vmulq_f32(vld1q_f32(x + k), ramp));
+        index = vaddq_f32(index, four);
+    }
+    agc_ramp_scalar(x, k, n, gain, step);
+}
+
+#endif /* AGC_HAVE_NEON */
+
+// Process a buffer in sub-blocks
+bool agc_process_block(agc_t *agc, float *buffer, uint32_t num_samples) {
+    if (!agc || !buffer || num_samples == 0) {
+        return false;
+    }
+
+    int simd = atomic_load(&agc_simd_active);
+    if (simd < 0) {
+        simd = agc_simd_detect();
+        atomic_store(&agc_simd_active, simd);
+    }
+
+    const uint32_t block = agc->block_size > 0 ? agc->block_size : AGC_DEFAULT_BLOCK_SIZE;
+    const float hang_samples = agc->hang_time * (float)agc->sample_rate;
+
+    for (uint32_t done = 0; done < num_samples; done += block) {
+        uint32_t n = num_samples - done < block ? num_samples - done : block;
+        float *x = buffer + done;
+
+        float attack, release, smooth;
+        if (n == agc->block_size) {
+            attack = agc->block_attack_coeff;
+            release = agc->block_release_coeff;
+            smooth = agc->block_smooth_coeff;
+        } else {
+            agc_block_coeffs(agc, n, &attack, &release, &smooth);
+        }
+
+        // Envelope of the sub-block
+        float peak;
+        switch (simd) {
+#if defined(AGC_HAVE_X86_SIMD)
+            case AGC_SIMD_AVX:  peak = agc_peak_avx(x, n); break;
+            case AGC_SIMD_SSE2: peak = agc_peak_sse2(x, n); break;
+#endif
+#if defined(AGC_HAVE_NEON)
+            case AGC_SIMD_NEON: peak = agc_peak_neon(x, n); break;
+#endif
+            default:            peak = agc_peak_scalar(x, n); break;
+        }
+
+        // Detector and hang counter, as n samples of agc_process_sample
+        if (peak > agc->peak_detector) {
+            agc->peak_detector = attack * (peak - agc->peak_detector) + agc->peak_detector;
+            agc->hang_counter = hang_samples;
+        } else if (agc->hang_counter <= 0.0f) {
+            agc->peak_detector = release * (peak - agc->peak_detector) + agc->peak_detector;
+        } else {
+            agc->hang_counter -= (float)n;
+        }
+
+        float target_gain = 1.0f;
+        if (agc->peak_detector > 0.0f) {
+            target_gain = agc->reference_level / agc->peak_detector;
+        }
+        if (target_gain > agc->max_gain) {
+            target_gain = agc->max_gain;
+        }
+
+        float gain = agc->current_gain + smooth * (target_gain - agc->current_gain);
+        if (gain < 1.0f) {
+            gain = 1.0f;
+        }
+
+        // Ramp from the previous gain, reaching the new one on the last sample
+        float step = (gain - agc->current_gain) / (float)n;
+        switch (simd) {
+#if defined(AGC_HAVE_X86_SIMD)
+            case AGC_SIMD_AVX:  agc_ramp_avx(x, n, agc->current_gain, step); break;
+            case AGC_SIMD_SSE2: agc_ramp_sse2(x, n, agc->current_gain, step); break;
+#endif
+#if defined(AGC_HAVE_NEON)
+            case AGC_SIMD_NEON: agc_ramp_neon(x, n, agc->current_gain, step); break;
+#endif
+            default:            agc_ramp_scalar(x, 0, n, agc->current_gain, step); break;
+        }
+        agc->current_gain = gain;
+    }
+
+    return true;
+}
+
 // Reset AGC state
 void agc_reset(agc_t *agc) {
     if (!agc) return;
@@ -4,6 +4,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Block mode sub-block used by the demodulator tools (1.3 ms at 48 kHz)
+#define AGC_DEFAULT_BLOCK_SIZE 64
+
 // AGC (Automatic Gain Control) context
 typedef struct {
     // Configuration parameters
@@ -22,6 +25,13 @@ typedef struct {
     // Pre-computed coefficients
     float attack_coeff;     // Attack coefficient (1 - exp(-1/(attack_time * sample_rate)))
     float release_coeff;    // Release coefficient (1 - exp(-1/(release_time * sample_rate)))
+
+    // Block mode: one detector and gain update per sub-block of block_size
+    // samples, gain ramped linearly across it (0: per-sample processing)
+    uint32_t block_size;
+    float block_attack_coeff;   // attack_coeff compounded over block_size samples
+    float block_release_coeff;  // release_coeff compounded over block_size samples
+    float block_smooth_coeff;   // Gain smoothing compounded over block_size samples
 } agc_t;
 
 // Initialize AGC with default parameters
@@ -35,9 +45,19 @@ bool agc_init_custom(agc_t *agc, uint32_t sample_rate,
 // Process a single audio sample through AGC
 float agc_process_sample(agc_t *agc, float input_sample);
 
-// Process a buffer of audio samples through AGC
+// Process a buffer of audio samples through AGC (block mode when enabled)
 bool agc_process_buffer(agc_t *agc, float *buffer, uint32_t num_samples);
 
+// Enable block mode with sub-blocks of block_size samples (0: per sample)
+bool agc_set_block_size(agc_t *agc, uint32_t block_size);
+
+// Process a buffer in sub-blocks, whatever the configured mode: peak
+// envelope per sub-block, then a linear gain ramp to the updated gain
+bool agc_process_block(agc_t *agc, float *buffer, uint32_t num_samples);
+
+// Use the portable envelope/ramp kernels only (benchmarks and tests)
+void agc_force_scalar(bool scalar);
+
 // Reset AGC state
 void agc_reset(agc_t *agc);
 
@@ -18,7 +18,8 @@
  * - O(1) complexity per sample
  * - Minimal memory usage (fixed state)
  * - Suitable for real-time processing
- * - No dynamic memory allocation during processing
+ * - No dynamic memory allocation during processing (the optional channel
+ *   filter allocates once, when it is set)
  *
  * Applications:
  * - AM broadcast radio (MW, SW)
@@ -29,6 +30,7 @@
 
 #include "am.h"
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
@@ -36,6 +38,9 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// IQ samples channel-filtered per pass by the buffer calls
+#define AM_BLOCK_SAMPLES 256
+
 // Initialize AM demodulator with default parameters
 bool am_demod_init(am_demod_t *am, float sample_rate) {
     // Default DC blocking cutoff at 100 Hz
@@ -54,6 +59,7 @@ bool am_demod_init_custom(am_demod_t *am, float sample_rate, float dc_block_cuto
     // Initialize DC blocking filter
     am->dc_block_alpha = am_compute_dc_block_coeff(dc_block_cutoff, sample_rate);
     am->dc_block_prev = 0.0f;
+    am->use_fir = false;
 
     // Initialize statistics
     am->samples_processed = 0;
@@ -63,12 +69,8 @@ bool am_demod_init_custom(am_demod_t *am, float sample_rate, float dc_block_cuto
     return true;
 }
 
-// Process a single IQ sample and return demodulated audio
-float am_demod_process_sample(am_demod_t *am, float i_sample, float q_sample) {
-    if (!am) {
-        return 0.0f;
-    }
-
+// Envelope, statistics and DC blocking of one (filtered) sample
+static float am_demod_envelope(am_demod_t *am, float i_sample, float q_sample) {
     // Compute envelope (magnitude)
     float envelope = am_compute_envelope(i_sample, q_sample);
 
@@ -88,6 +90,20 @@ float am_demod_process_sample(am_demod_t *am, float i_sample, float q_sample) {
     return dc_blocked;
 }
 
+// Process a single IQ sample and return demodulated audio
+float am_demod_process_sample(am_demod_t *am, float i_sample, float q_sample) {
+    if (!am) {
+        return 0.0f;
+    }
+
+    if (am->use_fir) {
+        float iq[2] = {i_sample, q_sample};
+        fir_process(&am->fir, iq, iq, 1);
+        return am_demod_envelope(am, iq[0], iq[1]);
+    }
+    return am_demod_envelope(am, i_sample, q_sample);
+}
+
 // Process a buffer of IQ samples
 bool am_demod_process_buffer(am_demod_t *am,
                            const float *i_buffer, const float *q_buffer,
@@ -103,6 +119,39 @@ bool am_demod_process_buffer(am_demod_t *am,
     return true;
 }
 
+// Process a buffer of interleaved IQ samples
+bool am_demod_process_buffer_iq(am_demod_t *am, const float *iq,
+                                uint32_t num_samples, float *output_buffer) {
+    if (!am || !iq || !output_buffer || num_samples == 0) {
+        return false;
+    }
+
+    if (!am->use_fir) {
+        for (uint32_t i = 0; i < num_samples; i++) {
+            output_buffer[i] = am_demod_envelope(am, iq[2 * i], iq[2 * i + 1]);
+        }
+        return true;
+    }
+
+    float filtered[2 * AM_BLOCK_SAMPLES];
+    for (uint32_t done = 0; done < num_samples; done += AM_BLOCK_SAMPLES) {
+        uint32_t n = num_samples - done < AM_BLOCK_SAMPLES ? num_samples - done : AM_BLOCK_SAMPLES;
+        fir_process(&am->fir, iq + 2 * (size_t)done, filtered, n);
+        for (uint32_t i = 0; i < n; i++) {
+            output_buffer[done + i] = am_demod_envelope(am, filtered[2 * i], filtered[2 * i + 1]);
+        }
+    }
+
+    return true;
+}
+
+// Process a buffer of complex samples: float complex is laid out as
+// float[2] (real, imaginary), so this is the interleaved buffer
+bool am_demod_process_buffer_complex(am_demod_t *am, const float complex *samples,
+                                     uint32_t num_samples, float *output_buffer) {
+    return am_demod_process_buffer_iq(am, (const float *)samples, num_samples, output_buffer);
+}
+
 // Reset AM demodulator state
 void am_demod_reset(am_demod_t *am) {
     if (!am) return;
@@ -111,6 +160,37 @@ void am_demod_reset(am_demod_t *am) {
     am->samples_processed = 0;
     am->envelope_max = 0.0f;
     am->envelope_min = 1.0f;
+    if (am->use_fir) fir_reset(&am->fir);
+}
+
+// Set the channel filter
+bool am_demod_set_channel_filter(am_demod_t *am, float cutoff_hz, float transition_hz) {
+    if (!am) return false;
+
+    am_demod_free(am);
+    if (transition_hz <= 0.0f) return true;
+    if (cutoff_hz <= 0.0f) return false;
+
+    // -6 dB at the middle of the transition band
+    double transition = transition_hz / am->sample_rate;
+    double cutoff = (cutoff_hz + 0.5 * transition_hz) / am->sample_rate;
+    uint32_t num_taps = fir_kaiser_length(transition, FIR_DEFAULT_STOPBAND_DB);
+    if (cutoff >= 0.5 || num_taps == 0) return false;
+
+    float *taps = (float *)malloc(num_taps * sizeof(float));
+    bool ok = taps && fir_design_lowpass(taps, num_taps, cutoff, FIR_DEFAULT_STOPBAND_DB) &&
+              fir_init(&am->fir, taps, num_taps, 2, FIR_METHOD_AUTO);
+    free(taps);
+    am->use_fir = ok;
+    return ok;
+}
+
+// Free the channel filter
+void am_demod_free(am_demod_t *am) {
+    if (!am || !am->use_fir) return;
+
+    fir_free(&am->fir);
+    am->use_fir = false;
 }
 
 // Get statistics
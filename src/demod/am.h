@@ -12,14 +12,18 @@
  * - Support for broadcast AM, amateur radio, and utility signals
  *
  * The implementation uses efficient envelope detection suitable for
- * real-time processing of AM signals with proper DC removal.
+ * real-time processing of AM signals with proper DC removal. An optional
+ * Kaiser FIR channel filter (am_demod_set_channel_filter, fir_t) can reject
+ * neighbouring signals before the envelope; am_demod_free releases it.
  *
  * Usage:
  *   am_demod_t am;
  *   am_demod_init_custom(&am, sample_rate, dc_cutoff);
  *   float audio = am_demod_process_sample(&am, i_sample, q_sample);
+ *   am_demod_process_buffer_iq(&am, iq, num_samples, audio_buffer);
  *
  * Algorithm:
+ *   0. Optional IQ low-pass channel filter
  *   1. Compute magnitude: envelope = sqrt(I² + Q²)
  *   2. Apply DC blocking: high-pass filter removes carrier DC
  *   3. Track statistics: envelope min/max for signal analysis
@@ -34,6 +38,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <complex.h>
+
+#include "../iq_core/fir.h"
 
 // AM demodulator context
 typedef struct {
@@ -44,6 +51,10 @@ typedef struct {
     float dc_block_alpha;       // DC blocking filter coefficient
     float dc_block_prev;        // DC blocking filter previous output
 
+    // Channel filter before the envelope (am_demod_set_channel_filter)
+    bool use_fir;
+    fir_t fir;                  // IQ low-pass
+
     // Statistics
     uint32_t samples_processed; // Total samples processed
     float envelope_max;         // Maximum envelope value seen
@@ -64,9 +75,25 @@ bool am_demod_process_buffer(am_demod_t *am,
                            const float *i_buffer, const float *q_buffer,
                            uint32_t num_samples, float *output_buffer);
 
+// Process a buffer of interleaved IQ samples [I, Q, I, Q, ...]
+bool am_demod_process_buffer_iq(am_demod_t *am, const float *iq,
+                                uint32_t num_samples, float *output_buffer);
+
+// Process a buffer of complex samples (same layout as interleaved IQ)
+bool am_demod_process_buffer_complex(am_demod_t *am, const float complex *samples,
+                                     uint32_t num_samples, float *output_buffer);
+
 // Reset AM demodulator state
 void am_demod_reset(am_demod_t *am);
 
+// Filter the IQ input to the carrier +- cutoff_hz with a Kaiser FIR, 60 dB
+// down transition_hz further out (transition_hz <= 0 removes the filter).
+// The audio is delayed by the filter's group delay plus fir_t.latency
+bool am_demod_set_channel_filter(am_demod_t *am, float cutoff_hz, float transition_hz);
+
+// Free the channel filter, if any (the demodulator may be re-initialised)
+void am_demod_free(am_demod_t *am);
+
 // Get statistics
 float am_demod_get_envelope_max(const am_demod_t *am);
 float am_demod_get_envelope_min(const am_demod_t *am);
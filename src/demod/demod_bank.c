@@ -0,0 +1,414 @@
+/*
+ * IQ Lab - demod_bank.c: Multi-Channel Demodulator Bank Implementation
+ *
+ * The channelizer is the only producer of the channel buffers and runs on
+ * the caller's thread. When it pauses on a full buffer (or at the end of
+ * the stream) every channel gets one drain task on the scheduler; a task
+ * reads its channel's buffer in place, runs the chain chunk by chunk and
+ * commits what it consumed, and the caller waits for all of them before
+ * feeding the channelizer again. Channels the PFB produces but nobody
+ * demodulates are dropped by the caller once the tasks are done.
+ *
+ * Each chain stage is timed for --profile on the thread that runs it.
+ *
+ * Date: 2025
+ */
+
+#include "demod_bank.h"
+#include "../iq_core/stft.h"
+#include "../iq_core/profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Outputs a resampler may produce beyond input * ratio
+#define DEMOD_BANK_OUTPUT_MARGIN 64
+
+static const char *const MODE_NAMES[] = {"fm", "am", "usb", "lsb"};
+
+/**
+ * @brief Defaults for a bank
+ */
+bool demod_bank_config_init(demod_bank_config_t *config, uint32_t num_channels,
+                            double sample_rate, double channel_bandwidth) {
+    if (!config) return false;
+
+    memset(config, 0, sizeof(*config));
+    if (!pfb_config_init(&config->pfb, num_channels, sample_rate, channel_bandwidth)) {
+        return false;
+    }
+    config->audio_rate = 48000;
+    config->num_workers = 0;
+    config->fm_deviation = 5000.0f;
+    config->fm_deemphasis = 75e-6f;
+    config->ssb_bfo = 1500.0f;
+    config->ssb_lpf_cutoff = 3000.0f;
+    config->enable_agc = false;
+    config->agc_reference = 0.25f;
+    config->agc_max_gain = 1000.0f;
+    wave_writer_options_init(&config->wav);
+    return true;
+}
+
+bool demod_bank_parse_mode(const char *name, demod_bank_mode_t *mode) {
+    if (!name || !mode) return false;
+
+    for (uint32_t m = 0; m < sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]); m++) {
+        if (strcmp(name, MODE_NAMES[m]) == 0) {
+            *mode = (demod_bank_mode_t)m;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *demod_bank_mode_name(demod_bank_mode_t mode) {
+    return (uint32_t)mode < sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]) ? MODE_NAMES[mode] : "?";
+}
+
+/**
+ * @brief Demodulator, resampling stages, AGC, buffers and file of one channel
+ */
+static bool channel_init(demod_bank_t *bank, demod_bank_channel_t *ch, const char *wav_path) {
+    const demod_bank_config_t *config = &bank->config;
+    const float rate = (float)bank->channel_rate;
+
+    bool ok;
+    switch (ch->mode) {
+        case DEMOD_BANK_FM:
+            ok = fm_demod_init_custom(&ch->fm, rate, config->fm_deviation,
+                                      config->fm_deemphasis, false);
+            break;
+        case DEMOD_BANK_AM:
+            ok = am_demod_init(&ch->am, rate);
+            break;
+        default:
+            ok = ssb_demod_init_custom(&ch->ssb, rate,
+                                       ch->mode == DEMOD_BANK_LSB ? SSB_MODE_LSB : SSB_MODE_USB,
+                                       config->ssb_bfo, config->ssb_lpf_cutoff);
+            break;
+    }
+    if (!ok) {
+        fprintf(stderr, "DEMOD_BANK: cannot run %s on channel %u at %.1f Hz\n",
+                demod_bank_mode_name(ch->mode), ch->channel_index, bank->channel_rate);
+        return false;
+    }
+
+    // Non-integer rate: Farrow to the nearest integer one first
+    double rounded = floor(bank->channel_rate + 0.5);
+    ch->integer_rate = (uint32_t)rounded;
+    ch->use_farrow = fabs(bank->channel_rate - rounded) > 1e-6;
+    ch->use_resampler = ch->integer_rate != config->audio_rate;
+    if (ch->use_farrow &&
+        !resample_farrow_init(&ch->farrow, bank->channel_rate, rounded, 1)) {
+        return false;
+    }
+    if (ch->use_resampler && !resample_init(&ch->resampler, ch->integer_rate, config->audio_rate)) {
+        fprintf(stderr, "DEMOD_BANK: cannot resample %u Hz to %u Hz\n", ch->integer_rate,
+                config->audio_rate);
+        return false;
+    }
+
+    if (config->enable_agc) {
+        if (!agc_init_custom(&ch->agc, config->audio_rate, 0.01f, 0.1f, config->agc_reference,
+                             config->agc_max_gain, 0.5f)) {
+            return false;
+        }
+        agc_set_block_size(&ch->agc, AGC_DEFAULT_BLOCK_SIZE);
+    }
+
+    ch->stage_capacity = (uint32_t)ceil(DEMOD_BANK_CHUNK * rounded / bank->channel_rate) +
+                         DEMOD_BANK_OUTPUT_MARGIN;
+    ch->resampled_capacity = (uint32_t)ceil((double)ch->stage_capacity * config->audio_rate /
+                                            ch->integer_rate) + DEMOD_BANK_OUTPUT_MARGIN;
+    ch->audio = (float *)malloc(DEMOD_BANK_CHUNK * sizeof(float));
+    ch->stage = ch->use_farrow ? (float *)malloc(ch->stage_capacity * sizeof(float)) : NULL;
+    ch->resampled = ch->use_resampler ? (float *)malloc(ch->resampled_capacity * sizeof(float))
+                                      : NULL;
+    if (!ch->audio || (ch->use_farrow && !ch->stage) || (ch->use_resampler && !ch->resampled)) {
+        return false;
+    }
+
+    if (!wave_writer_init_custom(&ch->wav, wav_path, config->audio_rate, 1, &config->wav)) {
+        fprintf(stderr, "DEMOD_BANK: cannot create %s\n", wav_path);
+        return false;
+    }
+    ch->wav_open = true;
+    return true;
+}
+
+/**
+ * @brief Run count channel samples through a channel's chain
+ */
+static bool channel_run(demod_bank_t *bank, demod_bank_channel_t *ch,
+                        const float complex *data, uint32_t count) {
+    for (uint32_t done = 0; done < count; done += DEMOD_BANK_CHUNK) {
+        uint32_t n = count - done < DEMOD_BANK_CHUNK ? count - done : DEMOD_BANK_CHUNK;
+
+        uint64_t start = iq_profile_begin();
+        switch (ch->mode) {
+            case DEMOD_BANK_FM:
+                fm_demod_process_buffer_complex(&ch->fm, data + done, n, ch->audio);
+                break;
+            case DEMOD_BANK_AM:
+                am_demod_process_buffer_complex(&ch->am, data + done, n, ch->audio);
+                break;
+            default:
+                ssb_demod_process_buffer_complex(&ch->ssb, data + done, n, ch->audio);
+                break;
+        }
+        ch->input_samples += n;
+        iq_profile_end(IQ_PROFILE_DEMOD, start, n, (uint64_t)n * sizeof(float complex));
+
+        float *audio = ch->audio;
+        uint32_t length = n;
+        start = iq_profile_begin();
+        if (ch->use_farrow) {
+            resample_farrow_process(&ch->farrow, audio, length, ch->stage, ch->stage_capacity,
+                                    &length);
+            audio = ch->stage;
+        }
+        if (ch->use_resampler && length > 0) {
+            if (!resample_process_buffer(&ch->resampler, audio, length, ch->resampled,
+                                         ch->resampled_capacity, &length)) {
+                return false;
+            }
+            audio = ch->resampled;
+        }
+        iq_profile_end(IQ_PROFILE_RESAMPLE, start, n, (uint64_t)n * sizeof(float));
+        if (length == 0) continue;
+
+        if (bank->config.enable_agc) {
+            start = iq_profile_begin();
+            agc_process_buffer(&ch->agc, audio, length);
+            iq_profile_end(IQ_PROFILE_DEMOD, start, 0, 0);
+        }
+
+        start = iq_profile_begin();
+        bool written = wave_writer_write_float(&ch->wav, audio, length);
+        iq_profile_end(IQ_PROFILE_ENCODE, start, length, (uint64_t)length * sizeof(int16_t));
+        if (!written) {
+            fprintf(stderr, "DEMOD_BANK: write failed on channel %u\n", ch->channel_index);
+            return false;
+        }
+        ch->audio_samples += length;
+    }
+    return true;
+}
+
+/**
+ * @brief Demodulate everything buffered for one channel and release it
+ *
+ * A failed channel keeps releasing its outputs so the others go on.
+ */
+static bool channel_drain(demod_bank_t *bank, uint32_t slot) {
+    demod_bank_channel_t *ch = &bank->channels[slot];
+    uint32_t count;
+
+    if (bank->ddc) {
+        const float complex *data = ddc_bank_get_channel_output(bank->ddc, slot, &count);
+        if (data && count > 0 && !ch->failed) {
+            ch->failed = !channel_run(bank, ch, data, count);
+        }
+        ddc_bank_reset_channel_output(bank->ddc, slot);
+        return !ch->failed;
+    }
+
+    const float complex *data;
+    while ((data = pfb_channel_read(bank->pfb, ch->channel_index, &count)) != NULL && count > 0) {
+        if (!ch->failed) {
+            ch->failed = !channel_run(bank, ch, data, count);
+        }
+        pfb_channel_commit(bank->pfb, ch->channel_index, count);
+    }
+    return !ch->failed;
+}
+
+// Scheduler task: drain the channel of slot task->channel_id
+static bool drain_task(channel_task_t *task, void *user_data) {
+    demod_bank_t *bank = user_data;
+    bool ok = channel_drain(bank, task->channel_id);
+    if (!ok) atomic_store(&bank->failed, true);
+    return ok;
+}
+
+/**
+ * @brief Drain every channel, on the pool when there is one
+ */
+static bool drain_all(demod_bank_t *bank) {
+    if (!bank->scheduler) {
+        for (uint32_t slot = 0; slot < bank->num_channels; slot++) {
+            if (!channel_drain(bank, slot)) atomic_store(&bank->failed, true);
+        }
+    } else {
+        for (uint32_t slot = 0; slot < bank->num_channels; slot++) {
+            channel_task_t task = {0};
+            task.channel_id = slot;
+            task.run = drain_task;
+            task.user_data = bank;
+            while (scheduler_add_task(bank->scheduler, &task) == -2) {
+                scheduler_wait(bank->scheduler);
+            }
+        }
+        scheduler_wait(bank->scheduler);
+    }
+
+    // The full bank fills every channel; drop the ones nobody demodulates
+    if (bank->pfb) {
+        for (uint32_t chan = 0; chan < bank->pfb->num_channels; chan++) {
+            if (!bank->selected[chan]) pfb_reset_channel_output(bank->pfb, chan);
+        }
+    }
+    return !atomic_load(&bank->failed);
+}
+
+/**
+ * @brief Create the channelizer, the channel chains and the worker pool
+ */
+demod_bank_t *demod_bank_create(const demod_bank_config_t *config,
+                                const uint32_t *channel_indices,
+                                const demod_bank_mode_t *modes,
+                                const char *const *wav_paths, uint32_t count) {
+    if (!config || !channel_indices || !modes || !wav_paths || count == 0 ||
+        config->audio_rate == 0 || !pfb_config_validate(&config->pfb) ||
+        count > config->pfb.num_channels) {
+        return NULL;
+    }
+
+    demod_bank_t *bank = (demod_bank_t *)calloc(1, sizeof(demod_bank_t));
+    if (!bank) return NULL;
+    bank->config = *config;
+    atomic_init(&bank->failed, false);
+
+    bank->channels = (demod_bank_channel_t *)calloc(count, sizeof(demod_bank_channel_t));
+    if (!bank->channels) {
+        demod_bank_destroy(bank);
+        return NULL;
+    }
+    bank->num_channels = count;
+
+    if (config->use_ddc) {
+        bank->ddc = ddc_bank_create(&config->pfb, channel_indices, count);
+        if (!bank->ddc) {
+            demod_bank_destroy(bank);
+            return NULL;
+        }
+        bank->channel_rate = ddc_bank_get_output_rate(bank->ddc);
+    } else {
+        bank->selected = (bool *)calloc(config->pfb.num_channels, sizeof(bool));
+        bank->pfb = bank->selected ? pfb_create(&config->pfb) : NULL;
+        if (!bank->pfb) {
+            demod_bank_destroy(bank);
+            return NULL;
+        }
+        for (uint32_t slot = 0; slot < count; slot++) {
+            if (channel_indices[slot] >= config->pfb.num_channels ||
+                bank->selected[channel_indices[slot]]) {
+                fprintf(stderr, "DEMOD_BANK: channel %u out of range or selected twice\n",
+                        channel_indices[slot]);
+                demod_bank_destroy(bank);
+                return NULL;
+            }
+            bank->selected[channel_indices[slot]] = true;
+        }
+        bank->channel_rate = pfb_get_output_rate(bank->pfb);
+    }
+
+    for (uint32_t slot = 0; slot < count; slot++) {
+        demod_bank_channel_t *ch = &bank->channels[slot];
+        ch->channel_index = channel_indices[slot];
+        ch->mode = modes[slot];
+        ch->center_frequency = bank->ddc ? bank->ddc->channels[slot].center_frequency
+                                         : pfb_get_channel_frequency(bank->pfb, ch->channel_index);
+        if (!channel_init(bank, ch, wav_paths[slot])) {
+            demod_bank_destroy(bank);
+            return NULL;
+        }
+    }
+
+    // Workers, at most one per channel; a single one runs inline
+    uint32_t workers = config->num_workers == 0 ? stft_default_threads() : config->num_workers;
+    if (workers > count) workers = count;
+    if (workers > SCHEDULER_MAX_WORKERS) workers = SCHEDULER_MAX_WORKERS;
+    bank->num_workers = workers > 1 ? workers : 1;
+    if (workers > 1) {
+        scheduler_config_t sched_config;
+        scheduler_config_init(&sched_config, count);
+        sched_config.num_workers = workers;
+        bank->scheduler = scheduler_create(&sched_config);
+        if (!bank->scheduler) {
+            demod_bank_destroy(bank);
+            return NULL;
+        }
+    }
+
+    return bank;
+}
+
+/**
+ * @brief Feed a block through the channelizer, draining whenever it pauses
+ */
+bool demod_bank_process_block(demod_bank_t *bank, const float complex *input,
+                              uint32_t input_length) {
+    if (!bank || (!input && input_length > 0)) return false;
+
+    while (input_length > 0) {
+        uint64_t start = iq_profile_begin();
+        int32_t processed = bank->ddc ? ddc_bank_process_block(bank->ddc, input, input_length)
+                                      : pfb_process_block(bank->pfb, input, input_length);
+        iq_profile_end(IQ_PROFILE_CHANNELIZE, start, processed > 0 ? (uint64_t)processed : 0,
+                       processed > 0 ? (uint64_t)processed * sizeof(float complex) : 0);
+        if (processed < 0) {
+            fprintf(stderr, "DEMOD_BANK: channelizer failed\n");
+            return false;
+        }
+        input += processed;
+        input_length -= (uint32_t)processed;
+        bank->samples_consumed += (uint32_t)processed;
+
+        if (input_length > 0 && !drain_all(bank)) {
+            return false;
+        }
+    }
+    return !atomic_load(&bank->failed);
+}
+
+/**
+ * @brief Drain the last outputs and close every file
+ */
+bool demod_bank_finish(demod_bank_t *bank) {
+    if (!bank) return false;
+
+    bool ok = drain_all(bank);
+    for (uint32_t slot = 0; slot < bank->num_channels; slot++) {
+        demod_bank_channel_t *ch = &bank->channels[slot];
+        if (ch->wav_open) {
+            ok = wave_writer_close(&ch->wav) && ok;
+            ch->wav_open = false;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Free everything the bank holds
+ */
+void demod_bank_destroy(demod_bank_t *bank) {
+    if (!bank) return;
+
+    scheduler_destroy(bank->scheduler);
+    for (uint32_t slot = 0; bank->channels && slot < bank->num_channels; slot++) {
+        demod_bank_channel_t *ch = &bank->channels[slot];
+        if (ch->wav_open) wave_writer_close(&ch->wav);
+        if (ch->use_resampler) resample_free(&ch->resampler);
+        free(ch->audio);
+        free(ch->stage);
+        free(ch->resampled);
+    }
+    free(bank->channels);
+    pfb_destroy(bank->pfb);
+    ddc_bank_destroy(bank->ddc);
+    free(bank->selected);
+    free(bank);
+}
@@ -0,0 +1,210 @@
+/*
+ * IQ Lab - demod_bank.h: Multi-Channel Demodulator Bank
+ *
+ * Purpose: Demodulates many narrow channels of one wideband stream in a
+ * single pass: the channels come out of a PFB (or sparse DDCs, ddc.h) and
+ * every one of them feeds its own FM, AM or SSB demodulator, optional AGC,
+ * audio resampler and WAV file.
+ *
+ * Date: 2025
+ *
+ * Data flow:
+ *
+ *   input --> PFB / DDC (caller's thread) --> channel buffers
+ *         --> per-channel tasks on the scheduler pool:
+ *             demod -> [Farrow to an integer rate] -> resample -> [AGC]
+ *             -> buffered WAV (int16 conversion in the writer)
+ *
+ * The channelizer runs until a channel buffer fills (or the caller ends
+ * the stream), then one task per channel drains its buffer, so every
+ * channel's DSP runs on a worker while the channels themselves are
+ * independent: no locks are taken in the per-channel chain, and each file
+ * is written in stream order. With one worker the same chain runs inline.
+ *
+ * Channel rates that are not integers (fs / M rarely is) first go through
+ * a cubic Farrow stage to the nearest integer rate, the ratio close to 1
+ * it is accurate at, then through the planned polyphase resampler.
+ */
+
+#ifndef DEMOD_BANK_H
+#define DEMOD_BANK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <complex.h>
+
+#include "fm.h"
+#include "am.h"
+#include "ssb.h"
+#include "agc.h"
+#include "wave.h"
+#include "../iq_core/resample.h"
+#include "../chan/pfb.h"
+#include "../chan/ddc.h"
+#include "../chan/scheduler.h"
+
+// Channel samples demodulated per pass of a channel's chain
+#define DEMOD_BANK_CHUNK 4096
+
+// Forward declarations
+typedef struct demod_bank_t demod_bank_t;
+typedef struct demod_bank_channel_t demod_bank_channel_t;
+
+/**
+ * @brief Demodulator attached to one channel
+ */
+typedef enum {
+    DEMOD_BANK_FM,
+    DEMOD_BANK_AM,
+    DEMOD_BANK_USB,
+    DEMOD_BANK_LSB
+} demod_bank_mode_t;
+
+/**
+ * @brief Bank configuration
+ */
+typedef struct {
+    pfb_config_t pfb;            // Channel layout (validated PFB configuration)
+    bool use_ddc;                // Sparse DDCs for the selected channels instead of the full PFB
+    uint32_t audio_rate;         // WAV sample rate (Hz)
+    uint32_t num_workers;        // Scheduler workers (0: one per core, 1: inline)
+
+    float fm_deviation;          // FM peak deviation (Hz)
+    float fm_deemphasis;         // FM deemphasis time constant (seconds)
+    float ssb_bfo;               // SSB BFO offset (Hz)
+    float ssb_lpf_cutoff;        // SSB sideband filter cutoff (Hz)
+
+    bool enable_agc;             // Block AGC on the audio
+    float agc_reference;         // AGC target level (linear, 0 to 1)
+    float agc_max_gain;          // AGC maximum gain (linear)
+
+    wave_writer_options_t wav;   // Output buffering, O_DIRECT and RF64
+} demod_bank_config_t;
+
+/**
+ * @brief One demodulated channel
+ */
+struct demod_bank_channel_t {
+    uint32_t channel_index;      // PFB channel index
+    demod_bank_mode_t mode;      // Demodulator
+    double center_frequency;     // Channel center, relative to the input (Hz)
+
+    fm_demod_t fm;               // The mode's demodulator (others unused)
+    am_demod_t am;
+    ssb_demod_t ssb;
+    agc_t agc;
+
+    bool use_farrow;             // Non-integer channel rate: Farrow stage first
+    resample_farrow_t farrow;    // Channel rate to integer_rate
+    bool use_resampler;          // integer_rate differs from the audio rate
+    resample_t resampler;        // integer_rate to audio_rate
+    uint32_t integer_rate;       // Rate entering the polyphase resampler (Hz)
+
+    float *audio;                // Demodulated chunk
+    float *stage;                // Farrow output
+    float *resampled;            // Audio-rate output
+    uint32_t stage_capacity;     // Samples the stage buffer holds
+    uint32_t resampled_capacity; // Samples the resampled buffer holds
+
+    wave_writer_t wav;           // Output file
+    bool wav_open;               // wav is open
+    uint64_t input_samples;      // Channel samples demodulated
+    uint64_t audio_samples;      // Audio samples written
+    bool failed;                 // A write failed; the channel stops
+};
+
+/**
+ * @brief Demodulator bank context
+ */
+struct demod_bank_t {
+    demod_bank_config_t config;  // Configuration
+
+    pfb_t *pfb;                  // Full filter bank (NULL with DDCs)
+    ddc_bank_t *ddc;             // One DDC per channel (NULL with the PFB)
+    bool *selected;              // Per PFB channel: demodulated (PFB only)
+    double channel_rate;         // Channel sample rate (Hz)
+
+    demod_bank_channel_t *channels; // In request order
+    uint32_t num_channels;
+
+    scheduler_t *scheduler;      // Worker pool (NULL: inline)
+    uint32_t num_workers;        // Workers in use
+    atomic_bool failed;          // A channel task failed
+    uint64_t samples_consumed;   // Input samples taken by the channelizer
+};
+
+/**
+ * @brief Initialize a bank configuration with defaults
+ *
+ * 48 kHz audio, one worker per core, NBFM (5 kHz deviation, 75 us
+ * deemphasis), SSB with a 1.5 kHz BFO and 3 kHz filter, AGC off, and the
+ * default WAV writer options (1 MiB buffer per file, RF64 reserved).
+ *
+ * @param config Configuration to fill
+ * @param num_channels PFB channels (power of 2)
+ * @param sample_rate Input sample rate (Hz)
+ * @param channel_bandwidth Channel bandwidth (Hz)
+ * @return true on success, false on error
+ */
+bool demod_bank_config_init(demod_bank_config_t *config, uint32_t num_channels,
+                            double sample_rate, double channel_bandwidth);
+
+/**
+ * @brief Create a bank demodulating the given channels into WAV files
+ *
+ * @param config Bank configuration
+ * @param channel_indices PFB channel of every demodulator (distinct)
+ * @param modes Demodulator of every channel
+ * @param wav_paths Output file of every channel
+ * @param count Number of channels
+ * @return Pointer to initialized bank, NULL on error
+ */
+demod_bank_t *demod_bank_create(const demod_bank_config_t *config,
+                                const uint32_t *channel_indices,
+                                const demod_bank_mode_t *modes,
+                                const char *const *wav_paths, uint32_t count);
+
+/**
+ * @brief Channelize and demodulate a block of input samples
+ *
+ * Consumes the whole block: whenever the channelizer pauses on a full
+ * channel buffer, every channel is drained through its chain first.
+ *
+ * @param bank Pointer to bank
+ * @param input Complex input samples (I + j*Q)
+ * @param input_length Number of input samples
+ * @return true on success, false if channelizing or a channel failed
+ */
+bool demod_bank_process_block(demod_bank_t *bank, const float complex *input,
+                              uint32_t input_length);
+
+/**
+ * @brief Demodulate what the channel buffers still hold and close the files
+ *
+ * @param bank Pointer to bank
+ * @return true if every channel was written completely
+ */
+bool demod_bank_finish(demod_bank_t *bank);
+
+/**
+ * @brief Destroy a bank (closes files still open)
+ *
+ * @param bank Pointer to bank
+ */
+void demod_bank_destroy(demod_bank_t *bank);
+
+/**
+ * @brief Parse a mode name: fm, am, usb or lsb
+ *
+ * @param name Mode name
+ * @param mode Receives the mode
+ * @return true if the name is known
+ */
+bool demod_bank_parse_mode(const char *name, demod_bank_mode_t *mode);
+
+/**
+ * @brief Name of a mode
+ */
+const char *demod_bank_mode_name(demod_bank_mode_t mode);
+
+#endif /* DEMOD_BANK_H */
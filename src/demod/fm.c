@@ -9,11 +9,28 @@
  * 2. Phase differentiation: dφ/dt gives frequency deviation
  * 3. Scaling: Convert deviation to normalized audio (-1 to +1)
  *
+ * Block Demodulation (fm_demod_process_block):
+ * 1. Discriminator: arg(x[n] * conj(x[n-1])) is the phase step directly,
+ *    already wrapped to (-pi, pi]; an odd polynomial atan on [0, 1] with
+ *    octant folding replaces atan2f, branch free, so the SSE2/AVX/NEON
+ *    kernels run it lane-wise with the same operations as the scalar one
+ * 2. DC blocking and de-emphasis run as one recursive pass over the block
+ * 3. The pilot correlator runs on a linear copy of its history
+ *
  * Stereo Processing:
  * 1. Pilot detection: Correlate with 19kHz reference
  * 2. Subcarrier demodulation: Mix with 38kHz oscillator
  * 3. Matrix decoding: L = (L+R) + (L-R), R = (L+R) - (L-R)
  *
+ * Filtered Stereo (fm_demod_set_stereo_filters):
+ * 1. DC-blocked MPX through a quadrature pair of 19 kHz band-passes
+ *    (Kaiser low-pass prototype shifted by cos / sin): the analytic pilot
+ *    A e^{j(theta - pi/2)} for a pilot A sin(theta)
+ * 2. Carrier sin(2 theta) = -2 I Q / (I^2 + Q^2), free of the pilot level
+ * 3. MPX delayed to the band-pass outputs; (MPX, 2 MPX carrier) through
+ *    one 2-channel 15 kHz low-pass gives (L+R, L-R)
+ * 4. Matrix, then de-emphasis per channel
+ *
  * Performance Notes:
  * - O(1) complexity per sample
  * - Suitable for real-time processing up to 8Msps
@@ -27,13 +44,62 @@
 
 #include "fm.h"
 #include <math.h>
+#include <float.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FM_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define FM_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// atan(a) on [0, 1]: a * P(a^2), odd minimax, |error| < 1e-5 rad
+#define FM_ATAN_C1 0.99997726f
+#define FM_ATAN_C3 -0.33262347f
+#define FM_ATAN_C5 0.19354346f
+#define FM_ATAN_C7 -0.11643287f
+#define FM_ATAN_C9 0.05265332f
+#define FM_ATAN_C11 -0.01172120f
+
+#define FM_PI_F 3.14159265f
+#define FM_PI_2_F 1.57079633f
+
+// Pilot correlator taps
+#define FM_PILOT_TAPS 16
+
+// Samples per pilot pass
+#define FM_BLOCK_SAMPLES 256
+
+// Filtered stereo decoder: pilot band-pass passes 19 kHz +- 1 kHz, audio
+// low-pass 15 kHz; both 60 dB down FM_STEREO_TRANSITION_HZ further out
+#define FM_PILOT_HZ 19000.0
+#define FM_PILOT_PASS_HZ 1000.0
+#define FM_AUDIO_PASS_HZ 15000.0
+#define FM_STEREO_TRANSITION_HZ 3000.0
+#define FM_PILOT_TIME_CONSTANT 0.01    // Pilot level smoothing (s)
+#define FM_STEREO_PILOT_THRESHOLD 0.01f
+
+enum {
+    FM_SIMD_SCALAR,
+    FM_SIMD_SSE2,
+    FM_SIMD_AVX,
+    FM_SIMD_NEON
+};
+
+// -1 until the first block detects the CPU
+static atomic_int fm_simd_active = -1;
+
 // Initialize FM demodulator with default parameters for broadcast FM
 bool fm_demod_init(fm_demod_t *fm, float sample_rate) {
     // Standard broadcast FM parameters with stereo
@@ -64,15 +130,18 @@ bool fm_demod_init_stereo(fm_demod_t *fm, float sample_rate, float max_deviation
 
     // Initialize state
     fm->prev_phase = 0.0f;
+    fm->prev_i = fm->prev_q = 0.0f;
     fm->phase_initialized = false;
     fm->samples_processed = 0;
     fm->stereo_mode = false;
+    fm->stereo_filters = false;
 
     // Initialize DC blocking filter (high-pass)
     // Cutoff frequency ~10 Hz to remove DC component
     float dc_cutoff = 10.0f;
     fm->dc_block_alpha = dc_cutoff / (dc_cutoff + sample_rate / (2.0f * M_PI));
     fm->dc_block_prev = 0.0f;
+    fm->mpx_prev = fm->mpx_dc_prev = 0.0f;
 
     // Initialize deemphasis filter
     fm->deemph_alpha = fm_compute_deemphasis_coeff(deemphasis_time, sample_rate);
@@ -92,8 +161,7 @@ bool fm_demod_init_stereo(fm_demod_t *fm, float sample_rate, float max_deviation
         }
 
         // Stereo subcarrier (38kHz)
-        fm->subcarrier_phase = 0.0f;
-        fm->subcarrier_phase_inc = 2.0f * M_PI * 38000.0f / sample_rate;  // 38kHz
+        nco_init(&fm->subcarrier, 38000.0, sample_rate);
         fm->subcarrier_prev_i = 0.0f;
         fm->subcarrier_prev_q = 0.0f;
         fm->subcarrier_lpf_prev = 0.0f;
@@ -137,6 +205,8 @@ float fm_demod_process_sample(fm_demod_t *fm, float i_sample, float q_sample) {
 
     // Update previous phase
     fm->prev_phase = current_phase;
+    fm->prev_i = i_sample;
+    fm->prev_q = q_sample;
     fm->phase_initialized = true;
 
     // Apply DC blocking filter
@@ -183,21 +253,494 @@ bool fm_demod_process_buffer(fm_demod_t *fm,
     return true;
 }
 
+static int fm_simd_detect(void) {
+#if defined(FM_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx")) return FM_SIMD_AVX;
+    if (__builtin_cpu_supports("sse2")) return FM_SIMD_SSE2;
+    return FM_SIMD_SCALAR;
+#elif defined(FM_HAVE_NEON)
+    return FM_SIMD_NEON;
+#else
+    return FM_SIMD_SCALAR;
+#endif
+}
+
+void fm_demod_force_scalar(bool scalar) {
+    atomic_store(&fm_simd_active, scalar ? FM_SIMD_SCALAR : fm_simd_detect());
+}
+
+// atan2(y, x) by octant folding of the [0, 1] polynomial; every step has
+// a lane-wise SIMD equivalent (max, min, divide, compare-select, sign copy)
+static inline float fast_atan2(float y, float x) {
+    float ax = fabsf(x), ay = fabsf(y);
+    float mx = ax > ay ? ax : ay;
+    float mn = ax < ay ? ax : ay;
+    float a = mn / (mx > FLT_MIN ? mx : FLT_MIN);
+    float s = a * a;
+    float r = (((((FM_ATAN_C11 * s + FM_ATAN_C9) * s + FM_ATAN_C7) * s + FM_ATAN_C5) * s +
+                FM_ATAN_C3) * s + FM_ATAN_C1) * a;
+    r = ay > ax ? FM_PI_2_F - r : r;
+    r = x < 0.0f ? FM_PI_F - r : r;
+    return copysignf(r, y);
+}
+
+// Scaled, clamped phase step between consecutive samples of iq[-2..];
+// samples [begin, count)
+static void fm_discriminate_scalar(const float *iq, uint32_t begin, uint32_t count, float scale,
+                                   float *out) {
+    for (uint32_t n = begin; n < count; n++) {
+        const float *x = iq + 2 * (size_t)n;
+        float i = x[0], q = x[1];
+        float pi = x[-2], pq = x[-1];
+        float re = i * pi + q * pq;
+        float im = q * pi - i * pq;
+        float v = fast_atan2(im, re) * scale;
+        v = v < 1.0f ? v : 1.0f;
+        out[n] = v > -1.0f ? v : -1.0f;
+    }
+}
+
+#if defined(FM_HAVE_X86_SIMD)
+
+// SSE2: four samples per register
+__attribute__((target("sse2")))
+static void fm_discriminate_sse2(const float *iq, uint32_t count, float scale, float *out) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 tiny = _mm_set1_ps(FLT_MIN);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f), minus_one = _mm_set1_ps(-1.0f);
+    const __m128 half_pi = _mm_set1_ps(FM_PI_2_F), pi = _mm_set1_ps(FM_PI_F);
+    const __m128 gain = _mm_set1_ps(scale);
+    uint32_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        const float *x = iq + 2 * (size_t)n;
+        __m128 a = _mm_loadu_ps(x), b = _mm_loadu_ps(x + 4);
+        __m128 pa = _mm_loadu_ps(x - 2), pb = _mm_loadu_ps(x + 2);
+        __m128 i = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 q = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 pi_ = _mm_shuffle_ps(pa, pb, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 pq = _mm_shuffle_ps(pa, pb, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 re = _mm_add_ps(_mm_mul_ps(i, pi_), _mm_mul_ps(q, pq));
+        __m128 im = _mm_sub_ps(_mm_mul_ps(q, pi_), _mm_mul_ps(i, pq));
+
+        __m128 ax = _mm_andnot_ps(sign, re), ay = _mm_andnot_ps(sign, im);
+        __m128 r = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), tiny));
+        __m128 s = _mm_mul_ps(r, r);
+        __m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(FM_ATAN_C11), s), _mm_set1_ps(FM_ATAN_C9));
+        p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(FM_ATAN_C7));
+        p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(FM_ATAN_C5));
+        p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(FM_ATAN_C3));
+        p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(FM_ATAN_C1));
+        r = _mm_mul_ps(p, r);
+        __m128 steep = _mm_cmpgt_ps(ay, ax);
+        r = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(half_pi, r)), _mm_andnot_ps(steep, r));
+        __m128 back = _mm_cmplt_ps(re, zero);
+        r = _mm_or_ps(_mm_and_ps(back, _mm_sub_ps(pi, r)), _mm_andnot_ps(back, r));
+        r = _mm_or_ps(r, _mm_and_ps(sign, im));
+
+        __m128 v = _mm_min_ps(_mm_mul_ps(r, gain), one);
+        _mm_storeu_ps(out + n, _mm_max_ps(v, minus_one));
+    }
+    if (n < count) fm_discriminate_scalar(iq, n, count, scale, out);
+}
+
+// AVX: eight samples per register; the 128-bit halves are loaded so that
+// the in-lane shuffle leaves the samples in order
+__attribute__((target("avx")))
+static void fm_discriminate_avx(const float *iq, uint32_t count, float scale, float *out) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 tiny = _mm256_set1_ps(FLT_MIN);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f), minus_one = _mm256_set1_ps(-1.0f);
+    const __m256 half_pi = _mm256_set1_ps(FM_PI_2_F), pi = _mm256_set1_ps(FM_PI_F);
+    const __m256 gain = _mm256_set1_ps(scale);
+    uint32_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        const float *x = iq + 2 * (size_t)n;
+        __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(x)),
+                                        _mm_loadu_ps(x + 8), 1);
+        __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(x + 4)),
+                                        _mm_loadu_ps(x + 12), 1);
+        __m256 pa = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(x - 2)),
+                                         _mm_loadu_ps(x + 6), 1);
+        __m256 pb = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(x + 2)),
+                                         _mm_loadu_ps(x + 10), 1);
+        __m256 i = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 q = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 pi_ = _mm256_shuffle_ps(pa, pb, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 pq = _mm256_shuffle_ps(pa, pb, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 re = _mm256_add_ps(_mm256_mul_ps(i, pi_), _mm256_mul_ps(q, pq));
+        __m256 im = _mm256_sub_ps(_mm256_mul_ps(q, pi_), _mm256_mul_ps(i, pq));
+
+        __m256 ax = _mm256_andnot_ps(sign, re), ay = _mm256_andnot_ps(sign, im);
+        __m256 r = _mm256_div_ps(_mm256_min_ps(ax, ay),
+                                 _mm256_max_ps(_mm256_max_ps(ax, ay), tiny));
+        __m256 s = _mm256_mul_ps(r, r);
+        __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(FM_ATAN_C11), s),
+                                 _mm256_set1_ps(FM_ATAN_C9));
+        p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(FM_ATAN_C7));
+        p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(FM_ATAN_C5));
+        p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(FM_ATAN_C3));
+        p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(FM_ATAN_C1));
+        r = _mm256_mul_ps(p, r);
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(half_pi, r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(pi, r), _mm256_cmp_ps(re, zero, _CMP_LT_OQ));
+        r = _mm256_or_ps(r, _mm256_and_ps(sign, im));
+
+        __m256 v = _mm256_min_ps(_mm256_mul_ps(r, gain), one);
+        _mm256_storeu_ps(out + n, _mm256_max_ps(v, minus_one));
+    }
+    if (n < count) fm_discriminate_scalar(iq, n, count, scale, out);
+}
+
+#endif /* FM_HAVE_X86_SIMD */
+
+#if defined(FM_HAVE_NEON)
+
+// NEON: four samples per register, deinterleaved by vld2q. Separate
+// multiply and add (not vmla/vfma) keep the rounding of the scalar path
+static void fm_discriminate_neon(const float *iq, uint32_t count, float scale, float *out) {
+    const float32x4_t tiny = vdupq_n_f32(FLT_MIN);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f), minus_one = vdupq_n_f32(-1.0f);
+    const float32x4_t half_pi = vdupq_n_f32(FM_PI_2_F), pi = vdupq_n_f32(FM_PI_F);
+    const float32x4_t gain = vdupq_n_f32(scale);
+    const uint32x4_t sign = vdupq_n_u32(0x80000000u);
+    uint32_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        float32x4x2_t x = vld2q_f32(iq + 2 * (size_t)n);
+        float32x4x2_t px = vld2q_f32(iq + 2 * (size_t)n - 2);
+        float32x4_t re = vaddq_f32(vmulq_f32(x.val[0], px.val[0]), vmulq_f32(x.val[1], px.val[1]));
+        float32x4_t im = vsubq_f32(vmulq_f32(x.val[1], px.val[0]), vmulq_f32(x.val[0], px.val[1]));
+
+        float32x4_t ax = vabsq_f32(re), ay = vabsq_f32(im);
+        float32x4_t r = vdivq_f32(vminq_f32(ax, ay), vmaxq_f32(vmaxq_f32(ax, ay), tiny));
+        float32x4_t s = vmulq_f32(r, r);
+        float32x4_t p = vaddq_f32(vmulq_f32(vdupq_n_f32(FM_ATAN_C11), s), vdupq_n_f32(FM_ATAN_C9));
+        p = vaddq_f32(vmulq_f32(p, s), vdupq_n_f32(FM_ATAN_C7));
+        p = vaddq_f32(vmulq_f32(p, s), vdupq_n_f32(FM_ATAN_C5));
+        p = vaddq_f32(vmulq_f32(p, s), vdupq_n_f32(FM_ATAN_C3));
+        p = vaddq_f32(vmulq_f32(p, s), vdupq_n_f32(FM_ATAN_C1));
+        r = vmulq_f32(p, r);
+        r = vbslq_f32(vcgtq_f32(ay, ax), vsubq_f32(half_pi, r), r);
+        r = vbslq_f32(vcltq_f32(re, zero), vsubq_f32(pi, r), r);
+        r = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(r),
+                                            vandq_u32(vreinterpretq_u32_f32(im), sign)));
+
+        float32x4_t v = vminq_f32(vmulq_f32(r, gain), one);
+        vst1q_f32(out + n, vmaxq_f32(v, minus_one));
+    }
+    if (n < count) fm_discriminate_scalar(iq, n, count, scale, out);
+}
+
+#endif /* FM_HAVE_NEON */
+
+// Discriminate samples [0, count) of iq given iq[-2], iq[-1]
+static void fm_discriminate(const float *iq, uint32_t count, float scale, float *out) {
+    int simd = atomic_load(&fm_simd_active);
+    if (simd < 0) {
+        simd = fm_simd_detect();
+        atomic_store(&fm_simd_active, simd);
+    }
+
+    switch (simd) {
+#if defined(FM_HAVE_X86_SIMD)
+        case FM_SIMD_AVX:  fm_discriminate_avx(iq, count, scale, out); break;
+        case FM_SIMD_SSE2: fm_discriminate_sse2(iq, count, scale, out); break;
+#endif
+#if defined(FM_HAVE_NEON)
+        case FM_SIMD_NEON: fm_discriminate_neon(iq, count, scale, out); break;
+#endif
+        default:           fm_discriminate_scalar(iq, 0, count, scale, out); break;
+    }
+}
+
+// Pilot correlation over a block, the per-sample correlator's taps and
+// smoothing on a linear history: line[0..15] are the 16 samples before the
+// block. As in fm_demod_process_sample, tap 0 meets the oldest of the last
+// 16 samples and tap i >= 1 the sample i - 1 before the newest
+static void fm_pilot_block(fm_demod_t *fm, const float *audio, uint32_t count) {
+    float line[FM_PILOT_TAPS + FM_BLOCK_SAMPLES];
+    for (uint32_t k = 0; k < FM_PILOT_TAPS; k++) {
+        line[k] = fm->pilot_history[(fm->pilot_index + k) % FM_PILOT_TAPS];
+    }
+
+    float level = fm->pilot_level;
+    for (uint32_t done = 0; done < count; done += FM_BLOCK_SAMPLES) {
+        uint32_t n = count - done < FM_BLOCK_SAMPLES ? count - done : FM_BLOCK_SAMPLES;
+        memcpy(line + FM_PILOT_TAPS, audio + done, n * sizeof(float));
+        for (uint32_t j = 0; j < n; j++) {
+            const float *newest = line + FM_PILOT_TAPS + j;
+            float corr = newest[1 - FM_PILOT_TAPS] * fm->pilot_filter[0];
+            for (int i = 1; i < FM_PILOT_TAPS; i++) {
+                corr += newest[1 - i] * fm->pilot_filter[i];
+            }
+            level = 0.9f * level + 0.1f * fabsf(corr);
+        }
+        memmove(line, line + n, FM_PILOT_TAPS * sizeof(float));
+    }
+    fm->pilot_level = level;
+
+    // Ring with slot 0 the oldest of the last 16 samples
+    memcpy(fm->pilot_history, line, sizeof(fm->pilot_history));
+    fm->pilot_index = 0;
+}
+
+// Discriminator over a block; the first sample pairs with the stored one
+static void fm_discriminate_block(fm_demod_t *fm, const float *iq, uint32_t num_samples,
+                                  float *output) {
+    const float scale = (float)(fm->sample_rate / (2.0 * M_PI * fm->max_deviation));
+    if (fm->phase_initialized) {
+        const float first[4] = {fm->prev_i, fm->prev_q, iq[0], iq[1]};
+        fm_discriminate_scalar(first + 2, 0, 1, scale, output);
+    } else {
+        output[0] = 0.0f;
+    }
+    if (num_samples > 1) fm_discriminate(iq + 2, num_samples - 1, scale, output + 1);
+
+    fm->prev_i = iq[2 * (size_t)num_samples - 2];
+    fm->prev_q = iq[2 * (size_t)num_samples - 1];
+    fm->prev_phase = atan2f(fm->prev_q, fm->prev_i);
+    fm->phase_initialized = true;
+}
+
+// Process a block of interleaved IQ samples
+bool fm_demod_process_block(fm_demod_t *fm, const float *iq, uint32_t num_samples,
+                            float *output) {
+    if (!fm || !iq || !output || num_samples == 0) {
+        return false;
+    }
+
+    // Pass 1: discriminator
+    fm_discriminate_block(fm, iq, num_samples, output);
+
+    // Pass 2: DC blocking and de-emphasis
+    float dc_prev = fm->dc_block_prev, deemph_prev = fm->deemph_prev;
+    const float dc_alpha = fm->dc_block_alpha, deemph_alpha = fm->deemph_alpha;
+    for (uint32_t n = 0; n < num_samples; n++) {
+        float dc_blocked = output[n] - dc_prev + dc_alpha * dc_prev;
+        dc_prev = dc_blocked;
+        deemph_prev = deemph_alpha * (dc_blocked - deemph_prev) + deemph_prev;
+        output[n] = deemph_prev;
+    }
+    fm->dc_block_prev = dc_prev;
+    fm->deemph_prev = deemph_prev;
+
+    // Pass 3: pilot detection
+    if (fm->stereo_detection) fm_pilot_block(fm, output, num_samples);
+
+    fm->samples_processed += num_samples;
+    return true;
+}
+
+// DC blocker y = x - x[-1] + (1 - alpha) y[-1] over the MPX, in place:
+// flat across the pilot and subcarrier bands
+static void fm_mpx_dc_block(fm_demod_t *fm, float *mpx, uint32_t count) {
+    const float pole = 1.0f - fm->dc_block_alpha;
+    float x_prev = fm->mpx_prev, y_prev = fm->mpx_dc_prev;
+    for (uint32_t j = 0; j < count; j++) {
+        float x = mpx[j];
+        y_prev = x - x_prev + pole * y_prev;
+        x_prev = x;
+        mpx[j] = y_prev;
+    }
+    fm->mpx_prev = x_prev;
+    fm->mpx_dc_prev = y_prev;
+}
+
+// Discriminator and DC blocker only: the MPX for fm_stereo_process
+bool fm_demod_process_mpx(fm_demod_t *fm, const float *iq, uint32_t num_samples,
+                          float *mpx) {
+    if (!fm || !iq || !mpx || num_samples == 0) {
+        return false;
+    }
+
+    fm_discriminate_block(fm, iq, num_samples, mpx);
+    fm_mpx_dc_block(fm, mpx, num_samples);
+    fm->samples_processed += num_samples;
+    return true;
+}
+
 // Reset FM demodulator state
 void fm_demod_reset(fm_demod_t *fm) {
     if (!fm) return;
 
     fm->prev_phase = 0.0f;
+    fm->prev_i = fm->prev_q = 0.0f;
     fm->phase_initialized = false;
     fm->samples_processed = 0;
     fm->dc_block_prev = 0.0f;
     fm->deemph_prev = 0.0f;
+    fm->mpx_prev = fm->mpx_dc_prev = 0.0f;
 
     if (fm->stereo_detection) {
         memset(fm->pilot_history, 0, sizeof(fm->pilot_history));
         fm->pilot_index = 0;
         fm->pilot_level = 0.0f;
     }
+
+    if (fm->stereo_filters) {
+        fir_reset(&fm->pilot_fir_i);
+        fir_reset(&fm->pilot_fir_q);
+        fir_reset(&fm->audio_fir);
+        memset(fm->mpx_delay, 0, fm->mpx_delay_length * sizeof(float));
+        fm->mpx_delay_index = 0;
+        fm->deemph_prev_right = 0.0f;
+    }
+}
+
+// Kaiser low-pass passing up to pass_hz, 60 dB down FM_STEREO_TRANSITION_HZ
+// further out; returns the tap count (0 on failure), taps from malloc
+static uint32_t fm_design_lowpass(float sample_rate, double pass_hz, float **taps) {
+    double transition = FM_STEREO_TRANSITION_HZ / sample_rate;
+    double cutoff = (pass_hz + 0.5 * FM_STEREO_TRANSITION_HZ) / sample_rate;
+    uint32_t num_taps = fir_kaiser_length(transition, FIR_DEFAULT_STOPBAND_DB);
+    *taps = (float *)malloc(num_taps * sizeof(float));
+    if (!*taps || !fir_design_lowpass(*taps, num_taps, cutoff, FIR_DEFAULT_STOPBAND_DB)) {
+        free(*taps);
+        *taps = NULL;
+        return 0;
+    }
+    return num_taps;
+}
+
+// Create the filtered stereo decoder's filters
+static bool fm_stereo_filters_init(fm_demod_t *fm) {
+    float *prototype, *audio;
+    uint32_t pilot_taps = fm_design_lowpass(fm->sample_rate, FM_PILOT_PASS_HZ, &prototype);
+    uint32_t audio_taps = fm_design_lowpass(fm->sample_rate, FM_AUDIO_PASS_HZ, &audio);
+    float *shifted = (float *)malloc(2 * (size_t)pilot_taps * sizeof(float));
+    bool ok = pilot_taps > 0 && audio_taps > 0 && shifted;
+
+    if (ok) {
+        // Quadrature pair about the centre tap: together the positive-
+        // frequency half of the band, unit gain at 19 kHz
+        double center = (pilot_taps - 1) / 2.0;
+        double w = 2.0 * M_PI * FM_PILOT_HZ / fm->sample_rate;
+        for (uint32_t i = 0; i < pilot_taps; i++) {
+            shifted[i] = (float)(2.0 * prototype[i] * cos(w * (i - center)));
+            shifted[pilot_taps + i] = (float)(2.0 * prototype[i] * sin(w * (i - center)));
+        }
+        ok = fir_init(&fm->pilot_fir_i, shifted, pilot_taps, 1, FIR_METHOD_AUTO);
+        if (ok && !fir_init(&fm->pilot_fir_q, shifted + pilot_taps, pilot_taps, 1,
+                            FIR_METHOD_AUTO)) {
+            fir_free(&fm->pilot_fir_i);
+            ok = false;
+        }
+    }
+    if (ok && !fir_init(&fm->audio_fir, audio, audio_taps, 2, FIR_METHOD_AUTO)) {
+        fir_free(&fm->pilot_fir_i);
+        fir_free(&fm->pilot_fir_q);
+        ok = false;
+    }
+    free(prototype);
+    free(audio);
+    free(shifted);
+    if (!ok) return false;
+
+    // Same length and method, so the two band-passes lag alike
+    fm->mpx_delay_length = (pilot_taps - 1) / 2 + fm->pilot_fir_i.latency;
+    fm->mpx_delay = (float *)calloc(fm->mpx_delay_length + 1, sizeof(float));
+    if (!fm->mpx_delay) {
+        fir_free(&fm->pilot_fir_i);
+        fir_free(&fm->pilot_fir_q);
+        fir_free(&fm->audio_fir);
+        return false;
+    }
+    fm->mpx_delay_index = 0;
+    fm->mpx_prev = fm->mpx_dc_prev = 0.0f;
+    fm->pilot_alpha = (float)(1.0 - exp(-1.0 / (FM_PILOT_TIME_CONSTANT * fm->sample_rate)));
+    fm->deemph_prev_right = 0.0f;
+    return true;
+}
+
+// Switch the stereo calls to the filtered decoder
+bool fm_demod_set_stereo_filters(fm_demod_t *fm, bool enable) {
+    if (!fm) return false;
+
+    fm_demod_free(fm);
+    if (!enable) return true;
+    if (fm->sample_rate < FM_STEREO_FILTER_MIN_RATE) return false;
+
+    fm->stereo_filters = fm_stereo_filters_init(fm);
+    if (fm->stereo_filters) fm->pilot_level = 0.0f;
+    return fm->stereo_filters;
+}
+
+// Input samples by which the filtered decoder's audio lags
+uint32_t fm_demod_stereo_delay(const fm_demod_t *fm) {
+    if (!fm || !fm->stereo_filters) return 0;
+    return fm->mpx_delay_length + (fm->audio_fir.num_taps - 1) / 2 + fm->audio_fir.latency;
+}
+
+// Free the stereo filters
+void fm_demod_free(fm_demod_t *fm) {
+    if (!fm || !fm->stereo_filters) return;
+
+    fir_free(&fm->pilot_fir_i);
+    fir_free(&fm->pilot_fir_q);
+    fir_free(&fm->audio_fir);
+    free(fm->mpx_delay);
+    fm->mpx_delay = NULL;
+    fm->stereo_filters = false;
+}
+
+// Filtered stereo decoding of a block of interleaved IQ samples
+static void fm_stereo_filtered(fm_demod_t *fm, const float *iq, uint32_t num_samples,
+                               float *left_buffer, float *right_buffer) {
+    float mpx[FM_BLOCK_SAMPLES], pilot_i[FM_BLOCK_SAMPLES], pilot_q[FM_BLOCK_SAMPLES];
+    float audio[2 * FM_BLOCK_SAMPLES];
+
+    for (uint32_t done = 0; done < num_samples; done += FM_BLOCK_SAMPLES) {
+        uint32_t n = num_samples - done < FM_BLOCK_SAMPLES ? num_samples - done : FM_BLOCK_SAMPLES;
+        fm_discriminate_block(fm, iq + 2 * (size_t)done, n, mpx);
+
+        fm_mpx_dc_block(fm, mpx, n);
+
+        fir_process(&fm->pilot_fir_i, mpx, pilot_i, n);
+        fir_process(&fm->pilot_fir_q, mpx, pilot_q, n);
+
+        // Delay line of mpx_delay_length + 1 slots: each sample comes back
+        // mpx_delay_length samples later
+        const uint32_t slots = fm->mpx_delay_length + 1;
+        float level = fm->pilot_level;
+        for (uint32_t j = 0; j < n; j++) {
+            fm->mpx_delay[fm->mpx_delay_index] = mpx[j];
+            fm->mpx_delay_index = fm->mpx_delay_index + 1 == slots ? 0 : fm->mpx_delay_index + 1;
+            float delayed = fm->mpx_delay[fm->mpx_delay_index];
+
+            float power = pilot_i[j] * pilot_i[j] + pilot_q[j] * pilot_q[j];
+            level += fm->pilot_alpha * (sqrtf(power) - level);
+            float carrier = power > FLT_MIN ? -2.0f * pilot_i[j] * pilot_q[j] / power : 0.0f;
+            audio[2 * j] = delayed;
+            audio[2 * j + 1] = 2.0f * delayed * carrier;
+        }
+        fm->pilot_level = level;
+
+        fir_process(&fm->audio_fir, audio, audio, n);
+
+        const float blend = fm->pilot_level >= FM_STEREO_PILOT_THRESHOLD ? fm->stereo_blend : 0.0f;
+        const float alpha = fm->deemph_alpha;
+        float prev_left = fm->deemph_prev, prev_right = fm->deemph_prev_right;
+        for (uint32_t j = 0; j < n; j++) {
+            float sum = audio[2 * j], diff = blend * audio[2 * j + 1];
+            prev_left = alpha * (sum + diff - prev_left) + prev_left;
+            prev_right = alpha * (sum - diff - prev_right) + prev_right;
+
+            // Normalize to prevent clipping
+            float left = prev_left, right = prev_right;
+            float max_val = fmaxf(fabsf(left), fabsf(right));
+            if (max_val > 1.0f) {
+                left /= max_val;
+                right /= max_val;
+            }
+            left_buffer[done + j] = left;
+            right_buffer[done + j] = right;
+        }
+        fm->deemph_prev = prev_left;
+        fm->deemph_prev_right = prev_right;
+    }
+    fm->samples_processed += num_samples;
 }
 
 // Get current pilot level
@@ -225,6 +768,12 @@ bool fm_demod_process_stereo(fm_demod_t *fm, float i_sample, float q_sample,
         return false;
     }
 
+    if (fm->stereo_filters) {
+        const float iq[2] = {i_sample, q_sample};
+        fm_stereo_filtered(fm, iq, 1, left_output, right_output);
+        return true;
+    }
+
     // First get the mono (L+R) signal
     float mono_signal = fm_demod_process_sample(fm, i_sample, q_sample);
 
@@ -236,8 +785,8 @@ bool fm_demod_process_stereo(fm_demod_t *fm, float i_sample, float q_sample,
 
     // Demodulate stereo subcarrier (38kHz)
     // Generate 38kHz reference signal
-    float subcarrier_i = cosf(fm->subcarrier_phase);
-    float subcarrier_q = sinf(fm->subcarrier_phase);
+    float subcarrier_i, subcarrier_q;
+    nco_step(&fm->subcarrier, &subcarrier_i, &subcarrier_q);
 
     // Mix with the mono signal to extract L-R information
     // The 38kHz subcarrier is amplitude modulated with (L-R)
@@ -258,12 +807,6 @@ bool fm_demod_process_stereo(fm_demod_t *fm, float i_sample, float q_sample,
                      0.1f * (lr_envelope - fm->subcarrier_lpf_prev);
     fm->subcarrier_lpf_prev = lr_signal;
 
-    // Update subcarrier phase
-    fm->subcarrier_phase += fm->subcarrier_phase_inc;
-    if (fm->subcarrier_phase > 2.0f * M_PI) {
-        fm->subcarrier_phase -= 2.0f * M_PI;
-    }
-
     // Matrix decoding
     // L = (L+R) + (L-R)
     // R = (L+R) - (L-R)
@@ -307,6 +850,50 @@ bool fm_demod_process_stereo_buffer(fm_demod_t *fm,
     return true;
 }
 
+// Process a buffer of interleaved IQ samples (mono output)
+bool fm_demod_process_buffer_iq(fm_demod_t *fm, const float *iq,
+                                uint32_t num_samples, float *output_buffer) {
+    return fm_demod_process_block(fm, iq, num_samples, output_buffer);
+}
+
+// Process a buffer of complex samples: float complex is laid out as
+// float[2] (real, imaginary), so this is the interleaved buffer
+bool fm_demod_process_buffer_complex(fm_demod_t *fm, const float complex *samples,
+                                     uint32_t num_samples, float *output_buffer) {
+    return fm_demod_process_block(fm, (const float *)samples, num_samples, output_buffer);
+}
+
+// Process a buffer of interleaved IQ samples (stereo output)
+bool fm_demod_process_stereo_buffer_iq(fm_demod_t *fm, const float *iq,
+                                       uint32_t num_samples,
+                                       float *left_buffer, float *right_buffer) {
+    if (!fm || !iq || !left_buffer || !right_buffer || num_samples == 0) {
+        return false;
+    }
+
+    if (fm->stereo_filters) {
+        fm_stereo_filtered(fm, iq, num_samples, left_buffer, right_buffer);
+        return true;
+    }
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        if (!fm_demod_process_stereo(fm, iq[2 * i], iq[2 * i + 1],
+                                    &left_buffer[i], &right_buffer[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Process a buffer of complex samples (stereo output)
+bool fm_demod_process_stereo_buffer_complex(fm_demod_t *fm, const float complex *samples,
+                                            uint32_t num_samples,
+                                            float *left_buffer, float *right_buffer) {
+    return fm_demod_process_stereo_buffer_iq(fm, (const float *)samples, num_samples,
+                                             left_buffer, right_buffer);
+}
+
 // Utility: Compute phase difference between two complex samples
 float fm_phase_difference(float i1, float q1, float i2, float q2) {
     float phase1 = atan2f(q1, i1);
@@ -320,6 +907,11 @@ float fm_phase_difference(float i1, float q1, float i2, float q2) {
     return diff;
 }
 
+// Utility: atan2 of the block discriminator
+float fm_fast_atan2(float y, float x) {
+    return fast_atan2(y, x);
+}
+
 // Utility: Compute deemphasis filter coefficient
 float fm_compute_deemphasis_coeff(float time_constant, float sample_rate) {
     // For first-order IIR deemphasis: y[n] = alpha * (x[n] - y[n-1]) + y[n-1]
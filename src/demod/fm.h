@@ -6,6 +6,9 @@
  *
  * This module provides professional FM demodulation capabilities including:
  * - FM discriminator using phase differentiation
+ * - Block discriminator for interleaved IQ: conjugate product
+ *   arg(x[n] * conj(x[n-1])) with a polynomial atan, SIMD where the CPU has
+ *   it, and the IIR stages in a separate pass over the block
  * - Stereo pilot tone detection (19kHz)
  * - Stereo subcarrier demodulation (38kHz)
  * - Matrix decoding for L/R channel separation
@@ -15,11 +18,22 @@
  * The implementation supports both mono and stereo FM broadcast standards
  * with configurable parameters for different regional requirements.
  *
+ * Filtered stereo decoder (fm_demod_set_stereo_filters, fs >= 120 kHz):
+ * the stereo calls then run the discriminator output (MPX) through Kaiser
+ * FIRs (fir_t): a quadrature 19 kHz band-pass pair gives the pilot phase
+ * and level, the 38 kHz carrier is its doubled phase, and a 15 kHz
+ * low-pass over L+R and the demodulated L-R leaves the two audio bands;
+ * L and R are de-emphasised separately. fm_demod_free releases the
+ * filters. Outputs lag by the filter delays (fm_demod_stereo_delay).
+ *
  * Usage:
  *   fm_demod_t fm;
  *   fm_demod_init_stereo(&fm, sample_rate, deviation, deemphasis, blend);
  *   fm_demod_process_stereo(&fm, i, q, &left, &right);
  *
+ * Many channels (e.g. iqchan outputs):
+ *   fm_demod_process_block(&fm, iq, num_samples, audio);
+ *
  * Dependencies: math.h, stdbool.h, stdint.h
  * Thread Safety: Not thread-safe (single demodulator instance per thread)
  */
@@ -31,6 +45,15 @@
 #include <stdbool.h>
 #include <complex.h>
 
+#include "../iq_core/nco.h"
+#include "../iq_core/fir.h"
+
+// Largest error of the block discriminator's atan (radians)
+#define FM_FAST_ATAN_MAX_ERROR 1e-5f
+
+// Lowest sample rate for the filtered stereo decoder (L-R reaches 53 kHz)
+#define FM_STEREO_FILTER_MIN_RATE 120000.0f
+
 // FM demodulator context
 typedef struct {
     // Configuration
@@ -43,6 +66,7 @@ typedef struct {
     // Internal state
     float prev_phase;           // Previous phase for differentiation
     bool phase_initialized;     // Whether prev_phase has been set
+    float prev_i, prev_q;       // Previous sample, for the block discriminator
 
     // Filters
     float dc_block_alpha;       // DC blocking filter coefficient
@@ -59,8 +83,7 @@ typedef struct {
     float pilot_level;          // Detected pilot level
 
     // Stereo subcarrier demodulation (38kHz)
-    float subcarrier_phase;     // 38kHz subcarrier phase
-    float subcarrier_phase_inc; // 38kHz phase increment per sample
+    nco_t subcarrier;           // 38kHz subcarrier oscillator
     float subcarrier_prev_i;    // Previous I for differentiation
     float subcarrier_prev_q;    // Previous Q for differentiation
     float subcarrier_lpf_prev;  // Low-pass filter for subcarrier envelope
@@ -70,6 +93,20 @@ typedef struct {
     uint32_t stereo_index;      // Current position in stereo buffer
     float stereo_sum;           // Running sum for L-R correlation
 
+    // Filtered stereo decoder (fm_demod_set_stereo_filters)
+    bool stereo_filters;
+    fir_t pilot_fir_i;          // 19 kHz band-pass, in phase
+    fir_t pilot_fir_q;          // 19 kHz band-pass, quadrature
+    fir_t audio_fir;            // 15 kHz low-pass over (L+R, L-R) pairs
+    float *mpx_delay;           // MPX delay line matching the pilot filters
+    uint32_t mpx_delay_length;
+    uint32_t mpx_delay_index;
+    float mpx_prev;             // Previous MPX sample (DC blocker input, also
+                                // for fm_demod_process_mpx)
+    float mpx_dc_prev;          // DC blocker previous output
+    float pilot_alpha;          // Pilot level smoothing coefficient
+    float deemph_prev_right;    // Right channel deemphasis state
+
     // Output channels
     bool stereo_mode;           // Whether stereo signal is detected
 
@@ -91,6 +128,21 @@ bool fm_demod_init_stereo(fm_demod_t *fm, float sample_rate, float max_deviation
 // Process a single IQ sample and return demodulated mono audio
 float fm_demod_process_sample(fm_demod_t *fm, float i_sample, float q_sample);
 
+// Process a block of interleaved IQ samples (mono output); the same as
+// fm_demod_process_sample per sample to within FM_FAST_ATAN_MAX_ERROR of
+// discriminator phase, and both may be mixed on one demodulator
+bool fm_demod_process_block(fm_demod_t *fm, const float *iq, uint32_t num_samples,
+                            float *output);
+
+// Discriminator and DC blocker only, no de-emphasis: the stereo multiplex
+// (MPX) for fm_stereo_process (fm_stereo.h)
+bool fm_demod_process_mpx(fm_demod_t *fm, const float *iq, uint32_t num_samples,
+                          float *mpx);
+
+// Force the scalar block discriminator instead of the detected SIMD path
+// (bit-identical outputs; for tests and benchmarks)
+void fm_demod_force_scalar(bool scalar);
+
 // Process IQ samples and return stereo audio (L+R in output[0], L-R in output[1])
 bool fm_demod_process_stereo(fm_demod_t *fm, float i_sample, float q_sample,
                             float *left_output, float *right_output);
@@ -106,9 +158,36 @@ bool fm_demod_process_stereo_buffer(fm_demod_t *fm,
                                   uint32_t num_samples,
                                   float *left_buffer, float *right_buffer);
 
+// Process a buffer of interleaved IQ samples [I, Q, I, Q, ...] (mono
+// output, through fm_demod_process_block)
+bool fm_demod_process_buffer_iq(fm_demod_t *fm, const float *iq,
+                                uint32_t num_samples, float *output_buffer);
+
+// Process a buffer of complex samples (same layout as interleaved IQ)
+bool fm_demod_process_buffer_complex(fm_demod_t *fm, const float complex *samples,
+                                     uint32_t num_samples, float *output_buffer);
+
+// Stereo output from interleaved IQ or complex samples
+bool fm_demod_process_stereo_buffer_iq(fm_demod_t *fm, const float *iq,
+                                       uint32_t num_samples,
+                                       float *left_buffer, float *right_buffer);
+bool fm_demod_process_stereo_buffer_complex(fm_demod_t *fm, const float complex *samples,
+                                            uint32_t num_samples,
+                                            float *left_buffer, float *right_buffer);
+
 // Reset FM demodulator state
 void fm_demod_reset(fm_demod_t *fm);
 
+// Switch the stereo calls to the filtered decoder (false: back to the
+// built-in one); fails below FM_STEREO_FILTER_MIN_RATE
+bool fm_demod_set_stereo_filters(fm_demod_t *fm, bool enable);
+
+// Input samples by which the filtered decoder's audio lags (0 without it)
+uint32_t fm_demod_stereo_delay(const fm_demod_t *fm);
+
+// Free the stereo filters, if any (the demodulator may be re-initialised)
+void fm_demod_free(fm_demod_t *fm);
+
 // Get current pilot level (if stereo detection enabled)
 float fm_demod_get_pilot_level(const fm_demod_t *fm);
 
@@ -120,6 +199,7 @@ void fm_demod_set_stereo_blend(fm_demod_t *fm, float blend);
 
 // Utility functions
 float fm_phase_difference(float i1, float q1, float i2, float q2);
+float fm_fast_atan2(float y, float x);  // Within FM_FAST_ATAN_MAX_ERROR of atan2f
 float fm_compute_deemphasis_coeff(float time_constant, float sample_rate);
 
 #endif // IQ_LAB_FM_H
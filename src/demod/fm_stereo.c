@@ -0,0 +1,223 @@
+/*
+ * IQ Lab - FM Stereo Decoder Implementation
+ *
+ * Per MPX sample (one pass, no trig):
+ * 1. Pilot amplitudes: one-pole averages of 2 x sin(phi) and 2 x cos(phi)
+ * 2. Phase error x cos(phi) / |pilot|, smoothed, into a PI loop filter:
+ *    the integrator is the frequency correction, the proportional term
+ *    the phase nudge
+ * 3. Pilot cancelled (y = x - A sin(phi)), pair (y, 4 y sin(phi) cos(phi))
+ * 4. Phasor times e^{j w0} (1 + j dphi); renormalised by (3 - |p|^2) / 2
+ *    once per block
+ *
+ * Per block: the pairs are decimated in place by the two-channel decim_t,
+ * then matrixed and de-emphasised at the output rate.
+ *
+ * Loop design: natural frequency FM_STEREO_LOOP_HZ, damping 0.707, phase
+ * detector gain 1/2 after the amplitude normalisation. The phase error
+ * carries the audio, mixed to 4..34 kHz by the 19 kHz phasor; its 500 Hz
+ * smoothing and the narrow loop average that out. The amplitude used for
+ * the normalisation, and the lock deciding the blend, are taken once per
+ * block, on a grid fixed to the stream.
+ */
+
+#include "fm_stereo.h"
+#include "fm.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FM_STEREO_PILOT_HZ 19000.0
+#define FM_STEREO_AUDIO_HZ 15000.0
+#define FM_STEREO_LOOP_HZ 10.0          // PLL natural frequency
+#define FM_STEREO_LOOP_DAMPING 0.707
+#define FM_STEREO_ERROR_HZ 500.0        // Phase error smoothing
+#define FM_STEREO_PULL_IN_HZ 50.0       // Largest pilot offset tracked
+#define FM_STEREO_LEVEL_TIME 0.01       // Pilot amplitude smoothing (s)
+
+bool fm_stereo_init(fm_stereo_t *stereo, double sample_rate, float deemphasis_time,
+                    float stereo_blend) {
+    if (!stereo || sample_rate < FM_STEREO_MIN_RATE || deemphasis_time <= 0.0f ||
+        stereo_blend < 0.0f || stereo_blend > 1.0f) {
+        return false;
+    }
+    memset(stereo, 0, sizeof(*stereo));
+
+    // Largest factor keeping FM_STEREO_MIN_OUTPUT_RATE, dividing an integer rate
+    uint32_t decimation = (uint32_t)floor(sample_rate / FM_STEREO_MIN_OUTPUT_RATE);
+    if (sample_rate == floor(sample_rate)) {
+        while (decimation > 1 && fmod(sample_rate, decimation) != 0.0) decimation--;
+    }
+    if (decimation < 1) decimation = 1;
+    stereo->sample_rate = sample_rate;
+    stereo->decimation = decimation;
+    stereo->output_rate = sample_rate / decimation;
+    stereo->stereo_blend = stereo_blend;
+
+    double w0 = 2.0 * M_PI * FM_STEREO_PILOT_HZ / sample_rate;
+    stereo->step_c = (float)cos(w0);
+    stereo->step_s = (float)sin(w0);
+
+    double wn = 2.0 * M_PI * FM_STEREO_LOOP_HZ / sample_rate;
+    const double detector_gain = 0.5;
+    stereo->loop_kp = (float)(2.0 * FM_STEREO_LOOP_DAMPING * wn / detector_gain);
+    stereo->loop_ki = (float)(wn * wn / detector_gain);
+    stereo->error_alpha = (float)(1.0 - exp(-2.0 * M_PI * FM_STEREO_ERROR_HZ / sample_rate));
+    stereo->max_correction = (float)(2.0 * M_PI * FM_STEREO_PULL_IN_HZ / sample_rate);
+    stereo->level_alpha = (float)(1.0 - exp(-1.0 / (FM_STEREO_LEVEL_TIME * sample_rate)));
+
+    stereo->pairs = (float *)malloc(2 * FM_STEREO_BLOCK_SAMPLES * sizeof(float));
+    decim_plan_t plan;
+    decim_plan_factor(&plan, decimation);
+    if (!stereo->pairs || !decim_init(&stereo->chain, &plan, FM_STEREO_AUDIO_HZ / sample_rate, 2)) {
+        fm_stereo_free(stereo);
+        return false;
+    }
+    stereo->deemph_alpha = fm_compute_deemphasis_coeff(deemphasis_time, (float)stereo->output_rate);
+    fm_stereo_reset(stereo);
+    return true;
+}
+
+// Per-block phasor renormalisation, loop normalisation and stereo blend
+static void fm_stereo_block_update(fm_stereo_t *stereo) {
+    // |phasor| drifts by float rounding only
+    float g = 1.5f - 0.5f * (stereo->phasor_c * stereo->phasor_c + stereo->phasor_s * stereo->phasor_s);
+    stereo->phasor_c *= g;
+    stereo->phasor_s *= g;
+
+    float amplitude = sqrtf(stereo->pilot_level * stereo->pilot_level +
+                            stereo->pilot_quadrature * stereo->pilot_quadrature);
+    stereo->inv_amplitude = 1.0f / fmaxf(amplitude, FM_STEREO_PILOT_THRESHOLD);
+    stereo->block_blend = fm_stereo_locked(stereo) ? stereo->stereo_blend : 0.0f;
+}
+
+// PLL and pair forming over at most FM_STEREO_BLOCK_SAMPLES
+static void fm_stereo_pll(fm_stereo_t *stereo, const float *mpx, uint32_t count, float *pairs) {
+    float c = stereo->phasor_c, s = stereo->phasor_s;
+    float level = stereo->pilot_level, quadrature = stereo->pilot_quadrature;
+    float error = stereo->loop_error, freq = stereo->loop_freq;
+    const float step_c = stereo->step_c, step_s = stereo->step_s;
+    const float level_alpha = stereo->level_alpha, error_alpha = stereo->error_alpha;
+    const float kp = stereo->loop_kp, ki = stereo->loop_ki, limit = stereo->max_correction;
+
+    const float inv_amplitude = stereo->inv_amplitude;
+
+    // The loop correction takes effect one sample late, which a 10 Hz loop
+    // does not notice: the phasor and the loop are then two short dependency
+    // chains instead of one long one
+    float dphi = freq + kp * error;
+    for (uint32_t j = 0; j < count; j++) {
+        float x = mpx[j];
+        level += level_alpha * (2.0f * x * s - level);
+        quadrature += level_alpha * (2.0f * x * c - quadrature);
+
+        // Pilot out, then (L+R, L-R) with sin(2 phi) = 2 sin(phi) cos(phi)
+        float y = x - level * s;
+        pairs[2 * j] = y;
+        pairs[2 * j + 1] = 4.0f * y * s * c;
+
+        float rc = step_c - step_s * dphi, rs = step_s + step_c * dphi;
+        float nc = c * rc - s * rs, ns = c * rs + s * rc;
+
+        error += error_alpha * (x * c * inv_amplitude - error);
+        freq += ki * error;
+        freq = freq > limit ? limit : freq < -limit ? -limit : freq;
+        dphi = freq + kp * error;
+        c = nc;
+        s = ns;
+    }
+
+    stereo->phasor_c = c;
+    stereo->phasor_s = s;
+    stereo->pilot_level = level;
+    stereo->pilot_quadrature = quadrature;
+    stereo->loop_error = error;
+    stereo->loop_freq = freq;
+}
+
+uint32_t fm_stereo_process(fm_stereo_t *stereo, const float *mpx, uint32_t count,
+                           float *left, float *right) {
+    if (!stereo || !stereo->pairs || !mpx || !left || !right) return 0;
+
+    uint32_t written = 0;
+    for (uint32_t done = 0; done < count;) {
+        // Blocks on a fixed grid of the stream, so any split of the input
+        // gives the same outputs; the phasor, amplitude and lock update per block
+        uint32_t offset = (uint32_t)(stereo->samples_processed % FM_STEREO_BLOCK_SAMPLES);
+        if (offset == 0 && stereo->samples_processed > 0) fm_stereo_block_update(stereo);
+        uint32_t n = FM_STEREO_BLOCK_SAMPLES - offset;
+        if (n > count - done) n = count - done;
+
+        fm_stereo_pll(stereo, mpx + done, n, stereo->pairs);
+        uint32_t m = (uint32_t)decim_process(&stereo->chain, stereo->pairs, n);
+        done += n;
+        stereo->samples_processed += n;
+
+        // Matrix: a straight pass the compiler vectorises
+        const float blend = stereo->block_blend;
+        float *l = left + written, *r = right + written;
+        const float *pairs = stereo->pairs;
+        for (uint32_t k = 0; k < m; k++) {
+            float sum = pairs[2 * k], diff = blend * pairs[2 * k + 1];
+            l[k] = sum + diff;
+            r[k] = sum - diff;
+        }
+
+        // De-emphasis: both channels in one two-lane recursion
+        const float alpha = stereo->deemph_alpha;
+        float prev[2] = { stereo->deemph_left, stereo->deemph_right };
+        for (uint32_t k = 0; k < m; k++) {
+            float in[2] = { l[k], r[k] };
+            for (int lane = 0; lane < 2; lane++) prev[lane] += alpha * (in[lane] - prev[lane]);
+
+            // Normalize to prevent clipping
+            float peak = fmaxf(fmaxf(fabsf(prev[0]), fabsf(prev[1])), 1.0f);
+            l[k] = prev[0] / peak;
+            r[k] = prev[1] / peak;
+        }
+        stereo->deemph_left = prev[0];
+        stereo->deemph_right = prev[1];
+        written += m;
+    }
+    return written;
+}
+
+bool fm_stereo_locked(const fm_stereo_t *stereo) {
+    return stereo && stereo->pilot_level >= FM_STEREO_PILOT_THRESHOLD &&
+           fabsf(stereo->pilot_quadrature) < 0.5f * stereo->pilot_level;
+}
+
+double fm_stereo_pilot_frequency(const fm_stereo_t *stereo) {
+    if (!stereo || stereo->sample_rate <= 0.0) return 0.0;
+    double w = atan2(stereo->step_s, stereo->step_c) + stereo->loop_freq;
+    return w * stereo->sample_rate / (2.0 * M_PI);
+}
+
+double fm_stereo_delay(const fm_stereo_t *stereo) {
+    return stereo ? stereo->chain.delay : 0.0;
+}
+
+void fm_stereo_reset(fm_stereo_t *stereo) {
+    if (!stereo) return;
+
+    stereo->phasor_c = 1.0f;
+    stereo->phasor_s = 0.0f;
+    stereo->loop_freq = stereo->loop_error = 0.0f;
+    stereo->pilot_level = stereo->pilot_quadrature = 0.0f;
+    stereo->deemph_left = stereo->deemph_right = 0.0f;
+    stereo->samples_processed = 0;
+    fm_stereo_block_update(stereo);
+    decim_reset(&stereo->chain);
+}
+
+void fm_stereo_free(fm_stereo_t *stereo) {
+    if (!stereo) return;
+
+    decim_free(&stereo->chain);
+    free(stereo->pairs);
+    stereo->pairs = NULL;
+}
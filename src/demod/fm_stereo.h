@@ -0,0 +1,121 @@
+/*
+ * IQ Lab - FM Stereo Decoder Header
+ *
+ * Purpose: Broadcast FM stereo from the multiplex (MPX) signal, with the
+ * audio filtering done at a decimated rate
+ *
+ *
+ * The MPX is the discriminator output before de-emphasis
+ * (fm_demod_process_mpx):
+ *
+ *   mpx = (L+R) + (L-R) sin(2 theta) + A sin(theta),   theta = 2 pi 19 kHz t
+ *
+ * Decoder stages:
+ * - Pilot PLL: a second-order loop locks a unit phasor e^{j phi} to the
+ *   19 kHz pilot. The phasor advances by one complex multiply per sample
+ *   (the 19 kHz step times 1 + j dphi for the loop's correction), with a
+ *   first-order renormalisation per block: no sin/cos per sample. The
+ *   phase error is mpx cos(phi), normalised by the pilot amplitude so the
+ *   loop bandwidth does not depend on the injection level.
+ * - Pilot amplitude and lock: one-pole averages of 2 mpx sin(phi) (the
+ *   in-phase amplitude, A when locked) and 2 mpx cos(phi).
+ * - 38 kHz reference by phasor squaring: sin(2 phi) = 2 sin(phi) cos(phi).
+ *   The pilot is cancelled from the MPX (A sin(phi)), then the decoder forms
+ *   the pair (L+R, L-R) = (mpx, 2 mpx sin(2 phi)).
+ * - The pairs run through one two-channel decim_t (halfbands and a final
+ *   FIR that only compute the outputs they keep). This is the 15 kHz
+ *   audio low-pass and the rate reduction in one stage, down to the
+ *   output rate of FM_STEREO_MIN_OUTPUT_RATE or more.
+ * - Matrix and de-emphasis on the decimated block. The matrix is a
+ *   straight-line pass over the block. The two de-emphasis filters run
+ *   side by side, as one two-lane recursion.
+ *
+ * Below FM_STEREO_PILOT_THRESHOLD of pilot, or out of lock, the decoder
+ * outputs L+R in both channels.
+ *
+ * Usage:
+ *   fm_stereo_t stereo;
+ *   fm_stereo_init(&stereo, mpx_rate, 50e-6f, 1.0f);
+ *   fm_demod_process_mpx(&fm, iq, count, mpx);
+ *   outputs = fm_stereo_process(&stereo, mpx, count, left, right);
+ *   // left/right at stereo.output_rate
+ *
+ * Dependencies: decim.h, fm.h
+ * Thread Safety: Not thread-safe (single decoder instance per thread)
+ */
+
+#ifndef IQ_LAB_FM_STEREO_H
+#define IQ_LAB_FM_STEREO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../iq_core/decim.h"
+
+// Lowest MPX rate the decoder accepts (L-R reaches 53 kHz)
+#define FM_STEREO_MIN_RATE 120000.0
+
+// Outputs are decimated to at least this rate: the 15 kHz audio, with a
+// transition band wide enough to keep the decimating filters short
+#define FM_STEREO_MIN_OUTPUT_RATE 44000.0
+
+// Pilot amplitude (MPX units) from which stereo is decoded
+#define FM_STEREO_PILOT_THRESHOLD 0.01f
+
+// MPX samples per decimation pass
+#define FM_STEREO_BLOCK_SAMPLES 1024
+
+typedef struct {
+    double sample_rate;      // MPX rate (Hz)
+    double output_rate;      // Audio rate, sample_rate / decimation
+    uint32_t decimation;
+    float stereo_blend;      // 0: mono, 1: full separation
+
+    // Pilot PLL
+    float phasor_c, phasor_s;   // cos and sin of the local pilot phase phi
+    float step_c, step_s;       // e^{j w0}, w0 = 19 kHz in rad/sample
+    float loop_freq;            // Loop integrator: frequency correction (rad/sample)
+    float loop_error;           // Smoothed phase error
+    float error_alpha;          // Phase error smoothing coefficient
+    float loop_kp, loop_ki;     // Proportional and integral gains
+    float max_correction;       // Pull-in limit (rad/sample)
+    float pilot_level;          // In-phase pilot amplitude
+    float pilot_quadrature;     // Quadrature pilot amplitude (~0 in lock)
+    float level_alpha;          // Pilot amplitude smoothing coefficient
+    float inv_amplitude;        // 1 / pilot amplitude, per block
+    float block_blend;          // Blend for the current block (0 out of lock)
+
+    // Audio
+    decim_t chain;              // (L+R, L-R) pairs to the output rate
+    float *pairs;               // One block of interleaved pairs
+    float deemph_alpha;         // De-emphasis at the output rate
+    float deemph_left, deemph_right;
+
+    uint64_t samples_processed;
+} fm_stereo_t;
+
+// Initialize for an MPX rate of at least FM_STEREO_MIN_RATE. With an
+// integer rate, the decimation divides it, so output_rate is an integer too.
+bool fm_stereo_init(fm_stereo_t *stereo, double sample_rate, float deemphasis_time,
+                    float stereo_blend);
+
+// Decode count MPX samples. Writes at most count / decimation + 1 samples
+// to left and right, and returns how many.
+uint32_t fm_stereo_process(fm_stereo_t *stereo, const float *mpx, uint32_t count,
+                           float *left, float *right);
+
+// Whether the PLL holds a pilot strong enough to decode stereo
+bool fm_stereo_locked(const fm_stereo_t *stereo);
+
+// Pilot frequency the PLL tracks (Hz)
+double fm_stereo_pilot_frequency(const fm_stereo_t *stereo);
+
+// MPX samples by which the outputs lag
+double fm_stereo_delay(const fm_stereo_t *stereo);
+
+// Clear the loop, filters and de-emphasis
+void fm_stereo_reset(fm_stereo_t *stereo);
+
+void fm_stereo_free(fm_stereo_t *stereo);
+
+#endif // IQ_LAB_FM_STEREO_H
@@ -23,7 +23,7 @@
  * Performance Notes:
  * - O(1) complexity per sample
  * - Real-time capable up to high sample rates
- * - Fixed memory usage, no dynamic allocation
+ * - Fixed memory usage; only the optional FIR sideband filter allocates
  * - Phase-continuous BFO prevents clicks/pops
  *
  * Applications:
@@ -35,6 +35,7 @@
 
 #include "ssb.h"
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
@@ -42,6 +43,25 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// IQ samples mixed per pass by the buffer calls
+#define SSB_BLOCK_SAMPLES 256
+
+// BFO offset: LSB mixes with -f_bfo
+static double ssb_bfo_offset(const ssb_demod_t *ssb) {
+    return ssb->mode == SSB_MODE_LSB ? -(double)ssb->bfo_frequency : (double)ssb->bfo_frequency;
+}
+
+// Low-pass filter one mixed sample to remove the unwanted sideband; the
+// real part is the audio (the imaginary part contains the other sideband)
+static inline float ssb_lowpass(ssb_demod_t *ssb, float mixed_i, float mixed_q) {
+    float filtered_i = ssb->lpf_alpha * (mixed_i - ssb->lpf_prev_i) + ssb->lpf_prev_i;
+    float filtered_q = ssb->lpf_alpha * (mixed_q - ssb->lpf_prev_q) + ssb->lpf_prev_q;
+
+    ssb->lpf_prev_i = filtered_i;
+    ssb->lpf_prev_q = filtered_q;
+    return filtered_i;
+}
+
 // Initialize SSB demodulator with default parameters
 bool ssb_demod_init(ssb_demod_t *ssb, float sample_rate) {
     // Default to USB mode with 1.5 kHz BFO and 3 kHz LPF cutoff
@@ -60,16 +80,12 @@ bool ssb_demod_init_custom(ssb_demod_t *ssb, float sample_rate, ssb_mode_t mode,
     ssb->mode = mode;
     ssb->bfo_frequency = bfo_frequency;
 
-    // Initialize BFO
-    ssb->bfo_phase = 0.0f;
-    ssb->bfo_phase_inc = ssb_compute_bfo_phase_inc(bfo_frequency, sample_rate);
-
-    // For LSB mode, we need to negate the BFO frequency (mix with -f_bfo)
-    if (mode == SSB_MODE_LSB) {
-        ssb->bfo_phase_inc = -ssb->bfo_phase_inc;
-    }
+    // Initialize BFO (for LSB mode it runs at -f_bfo)
+    nco_init(&ssb->bfo, ssb_bfo_offset(ssb), sample_rate);
 
     // Initialize low-pass filter
+    ssb->lpf_cutoff = lpf_cutoff;
+    ssb->use_fir = false;
     ssb->lpf_alpha = ssb_compute_lpf_coeff(lpf_cutoff, sample_rate);
     ssb->lpf_prev_i = 0.0f;
     ssb->lpf_prev_q = 0.0f;
@@ -87,34 +103,22 @@ float ssb_demod_process_sample(ssb_demod_t *ssb, float i_sample, float q_sample)
     }
 
     // Generate BFO signal
-    float bfo_cos = cosf(ssb->bfo_phase);
-    float bfo_sin = sinf(ssb->bfo_phase);
+    float bfo_cos, bfo_sin;
+    nco_step(&ssb->bfo, &bfo_cos, &bfo_sin);
 
     // Mix input with BFO (complex multiplication)
     // (I + jQ) * (cos(θ) + j*sin(θ)) = (I*cos - Q*sin) + j(I*sin + Q*cos)
     float mixed_i = i_sample * bfo_cos - q_sample * bfo_sin;
     float mixed_q = i_sample * bfo_sin + q_sample * bfo_cos;
 
-    // Apply low-pass filter to remove unwanted sideband
-    float filtered_i = ssb->lpf_alpha * (mixed_i - ssb->lpf_prev_i) + ssb->lpf_prev_i;
-    float filtered_q = ssb->lpf_alpha * (mixed_q - ssb->lpf_prev_q) + ssb->lpf_prev_q;
-
-    // Update filter state
-    ssb->lpf_prev_i = filtered_i;
-    ssb->lpf_prev_q = filtered_q;
-
-    // Update BFO phase
-    ssb->bfo_phase += ssb->bfo_phase_inc;
-    if (ssb->bfo_phase > 2.0f * M_PI) {
-        ssb->bfo_phase -= 2.0f * M_PI;
-    } else if (ssb->bfo_phase < -2.0f * M_PI) {
-        ssb->bfo_phase += 2.0f * M_PI;
-    }
-
+    // Apply low-pass filter and return the real part as audio
     ssb->samples_processed++;
-
-    // Return the real part as audio (imaginary part contains the other sideband)
-    return filtered_i;
+    if (ssb->use_fir) {
+        float audio;
+        fir_process(&ssb->fir, &mixed_i, &audio, 1);
+        return audio;
+    }
+    return ssb_lowpass(ssb, mixed_i, mixed_q);
 }
 
 // Process a buffer of IQ samples
@@ -132,28 +136,90 @@ bool ssb_demod_process_buffer(ssb_demod_t *ssb,
     return true;
 }
 
+// Process a buffer of interleaved IQ samples: the BFO mix runs as one
+// vectorised nco_mix per block, then the filter; same outputs as
+// ssb_demod_process_sample
+bool ssb_demod_process_buffer_iq(ssb_demod_t *ssb, const float *iq,
+                                 uint32_t num_samples, float *output_buffer) {
+    if (!ssb || !iq || !output_buffer || num_samples == 0) {
+        return false;
+    }
+
+    float mixed[2 * SSB_BLOCK_SAMPLES];
+    for (uint32_t done = 0; done < num_samples; done += SSB_BLOCK_SAMPLES) {
+        uint32_t n = num_samples - done < SSB_BLOCK_SAMPLES ? num_samples - done : SSB_BLOCK_SAMPLES;
+        nco_mix(&ssb->bfo, iq + 2 * (size_t)done, mixed, n);
+        if (ssb->use_fir) {
+            // Real taps: filtering I alone gives the real part of the
+            // filtered complex signal
+            for (uint32_t i = 0; i < n; i++) mixed[i] = mixed[2 * i];
+            fir_process(&ssb->fir, mixed, output_buffer + done, n);
+            continue;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            output_buffer[done + i] = ssb_lowpass(ssb, mixed[2 * i], mixed[2 * i + 1]);
+        }
+    }
+    ssb->samples_processed += num_samples;
+
+    return true;
+}
+
+// Process a buffer of complex samples: float complex is laid out as
+// float[2] (real, imaginary), so this is the interleaved buffer
+bool ssb_demod_process_buffer_complex(ssb_demod_t *ssb, const float complex *samples,
+                                      uint32_t num_samples, float *output_buffer) {
+    return ssb_demod_process_buffer_iq(ssb, (const float *)samples, num_samples, output_buffer);
+}
+
 // Reset SSB demodulator state
 void ssb_demod_reset(ssb_demod_t *ssb) {
     if (!ssb) return;
 
-    ssb->bfo_phase = 0.0f;
+    nco_reset(&ssb->bfo);
     ssb->lpf_prev_i = 0.0f;
     ssb->lpf_prev_q = 0.0f;
+    if (ssb->use_fir) fir_reset(&ssb->fir);
     ssb->samples_processed = 0;
 }
 
+// Replace the IIR sideband filter with an FIR
+bool ssb_demod_set_sideband_filter(ssb_demod_t *ssb, float transition_hz) {
+    if (!ssb) return false;
+
+    ssb_demod_free(ssb);
+    if (transition_hz <= 0.0f) return true;
+
+    // -6 dB at the middle of the transition band
+    double transition = transition_hz / ssb->sample_rate;
+    double cutoff = (ssb->lpf_cutoff + 0.5 * transition_hz) / ssb->sample_rate;
+    uint32_t num_taps = fir_kaiser_length(transition, FIR_DEFAULT_STOPBAND_DB);
+    if (cutoff >= 0.5 || num_taps == 0) return false;
+
+    float *taps = (float *)malloc(num_taps * sizeof(float));
+    bool ok = taps && fir_design_lowpass(taps, num_taps, cutoff, FIR_DEFAULT_STOPBAND_DB) &&
+              fir_init(&ssb->fir, taps, num_taps, 1, FIR_METHOD_AUTO);
+    free(taps);
+    ssb->use_fir = ok;
+    return ok;
+}
+
+// Free the FIR sideband filter
+void ssb_demod_free(ssb_demod_t *ssb) {
+    if (!ssb || !ssb->use_fir) return;
+
+    fir_free(&ssb->fir);
+    ssb->use_fir = false;
+}
+
 // Set SSB mode (USB/LSB)
 bool ssb_demod_set_mode(ssb_demod_t *ssb, ssb_mode_t mode) {
     if (!ssb) return false;
 
     ssb->mode = mode;
 
-    // Recalculate BFO phase increment based on new mode
-    ssb->bfo_phase_inc = ssb_compute_bfo_phase_inc(ssb->bfo_frequency, ssb->sample_rate);
-
-    if (mode == SSB_MODE_LSB) {
-        ssb->bfo_phase_inc = -ssb->bfo_phase_inc;
-    }
+    // Retune the BFO for the new mode, keeping its phase
+    nco_set_frequency(&ssb->bfo, ssb_bfo_offset(ssb));
 
     return true;
 }
@@ -164,12 +230,8 @@ bool ssb_demod_set_bfo_frequency(ssb_demod_t *ssb, float bfo_frequency) {
 
     ssb->bfo_frequency = bfo_frequency;
 
-    // Recalculate BFO phase increment
-    ssb->bfo_phase_inc = ssb_compute_bfo_phase_inc(bfo_frequency, ssb->sample_rate);
-
-    if (ssb->mode == SSB_MODE_LSB) {
-        ssb->bfo_phase_inc = -ssb->bfo_phase_inc;
-    }
+    // Retune the BFO, keeping its phase
+    nco_set_frequency(&ssb->bfo, ssb_bfo_offset(ssb));
 
     return true;
 }
@@ -12,16 +12,20 @@
  * - Support for amateur radio and professional SSB communications
  *
  * The implementation uses efficient complex mixing and filtering
- * suitable for real-time SSB signal processing.
+ * suitable for real-time SSB signal processing. The default sideband
+ * filter is a single-pole IIR; ssb_demod_set_sideband_filter swaps in a
+ * sharp Kaiser FIR (fir_t, direct or overlap-save by length), after which
+ * ssb_demod_free releases it.
  *
  * Usage:
  *   ssb_demod_t ssb;
  *   ssb_demod_init_custom(&ssb, sample_rate, SSB_MODE_USB, bfo_freq, lpf_cutoff);
  *   float audio = ssb_demod_process_sample(&ssb, i_sample, q_sample);
+ *   ssb_demod_process_buffer_iq(&ssb, iq, num_samples, audio_buffer);
  *
  * Algorithm:
- *   1. Generate quadrature BFO signals: cos(θ), sin(θ)
- *   2. Complex mixing: (I+jQ) * (cos(θ)+j*sin(θ))
+ *   1. Generate quadrature BFO signals: cos(θ), sin(θ) (recursive nco_t)
+ *   2. Complex mixing: (I+jQ) * (cos(θ)+j*sin(θ)), block-wise in the buffer calls
  *   3. Low-pass filtering to select desired sideband
  *   4. Extract real part as audio output
  *
@@ -38,6 +42,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <complex.h>
+
+#include "../iq_core/nco.h"
+#include "../iq_core/fir.h"
 
 // SSB demodulator modes
 typedef enum {
@@ -52,15 +60,19 @@ typedef struct {
     ssb_mode_t mode;           // USB or LSB mode
     float bfo_frequency;       // Beat Frequency Oscillator frequency (Hz)
 
-    // BFO state (for frequency shifting)
-    float bfo_phase;           // Current BFO phase
-    float bfo_phase_inc;       // BFO phase increment per sample
+    // BFO state (for frequency shifting): +bfo_frequency for USB, - for LSB
+    nco_t bfo;
 
     // Low-pass filter for sideband rejection (simple IIR)
+    float lpf_cutoff;          // Low-pass cutoff (Hz)
     float lpf_alpha;           // Low-pass filter coefficient
     float lpf_prev_i;          // Previous I filter output
     float lpf_prev_q;          // Previous Q filter output
 
+    // FIR sideband filter in place of the IIR (ssb_demod_set_sideband_filter)
+    bool use_fir;
+    fir_t fir;                 // Low-pass at lpf_cutoff on the mixed I
+
     // Statistics
     uint32_t samples_processed; // Total samples processed
 } ssb_demod_t;
@@ -80,9 +92,25 @@ bool ssb_demod_process_buffer(ssb_demod_t *ssb,
                             const float *i_buffer, const float *q_buffer,
                             uint32_t num_samples, float *output_buffer);
 
+// Process a buffer of interleaved IQ samples [I, Q, I, Q, ...]
+bool ssb_demod_process_buffer_iq(ssb_demod_t *ssb, const float *iq,
+                                 uint32_t num_samples, float *output_buffer);
+
+// Process a buffer of complex samples (same layout as interleaved IQ)
+bool ssb_demod_process_buffer_complex(ssb_demod_t *ssb, const float complex *samples,
+                                      uint32_t num_samples, float *output_buffer);
+
 // Reset SSB demodulator state
 void ssb_demod_reset(ssb_demod_t *ssb);
 
+// Replace the IIR with a Kaiser FIR low-pass passing up to the cutoff and
+// 60 dB down transition_hz above it (<= 0 returns to the IIR). The audio is delayed by
+// the filter's group delay plus fir_t.latency
+bool ssb_demod_set_sideband_filter(ssb_demod_t *ssb, float transition_hz);
+
+// Free the FIR sideband filter, if any (the demodulator may be re-initialised)
+void ssb_demod_free(ssb_demod_t *ssb);
+
 // Set SSB mode (USB/LSB)
 bool ssb_demod_set_mode(ssb_demod_t *ssb, ssb_mode_t mode);
 
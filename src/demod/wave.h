@@ -3,8 +3,19 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 
+// Default write buffer size (bytes)
+#define WAVE_DEFAULT_BUFFER_SIZE (1024 * 1024)
+
+// Write buffer alignment, a multiple of the block size O_DIRECT requires
+#define WAVE_BUFFER_ALIGN 4096
+
+// Header sizes: plain RIFF, and RIFF with a JUNK chunk reserving room for ds64
+#define WAVE_HEADER_SIZE 44
+#define WAVE_RF64_HEADER_SIZE 80
+
 // WAV file format structures (RIFF)
 typedef struct {
     char riff_id[4];       // "RIFF"
@@ -29,26 +40,60 @@ typedef struct {
     // Audio data follows...
 } wave_data_chunk_t;
 
+// WAV writer options
+typedef struct {
+    size_t buffer_size;    // Write buffer in bytes (rounded up to WAVE_BUFFER_ALIGN)
+    bool direct_io;        // Bypass the page cache (O_DIRECT) where the file system allows
+    bool rf64;             // Reserve a ds64 chunk: outputs past 4 GB become RF64
+} wave_writer_options_t;
+
 // WAV writer context
 typedef struct {
-    FILE *file;
+    int fd;                // Output file (-1 when closed)
+    uint8_t *buffer;       // Aligned write buffer; the first one starts with the header slot
+    size_t buffer_size;    // Buffer capacity (bytes)
+    size_t buffer_fill;    // Bytes pending in the buffer
+    uint64_t file_offset;  // Bytes already written to the file
+    uint32_t header_size;  // WAVE_HEADER_SIZE or WAVE_RF64_HEADER_SIZE
+    bool direct_io;        // fd is in O_DIRECT mode
+    bool rf64;             // ds64 space reserved
+    bool failed;           // A write failed; the file is incomplete
     uint32_t sample_rate;
     uint16_t channels;     // 1 = mono, 2 = stereo
-    uint32_t total_samples; // Total samples written
-    uint32_t data_size;    // Size of data chunk in bytes
+    uint64_t total_samples; // Total samples written (per channel)
+    uint64_t data_size;    // Size of data chunk in bytes
 } wave_writer_t;
 
-// Initialize WAV writer
+// Default options: 1 MiB buffer, page cache, RF64 reserved
+void wave_writer_options_init(wave_writer_options_t *options);
+
+// Initialize WAV writer (default buffer, plain 44-byte header, 4 GB limit)
 bool wave_writer_init(wave_writer_t *writer, const char *filename,
                      uint32_t sample_rate, uint16_t channels);
 
+// Initialize WAV writer with explicit options (NULL: defaults)
+bool wave_writer_init_custom(wave_writer_t *writer, const char *filename,
+                             uint32_t sample_rate, uint16_t channels,
+                             const wave_writer_options_t *options);
+
 // Write audio samples (16-bit PCM, interleaved if stereo)
 bool wave_writer_write_samples(wave_writer_t *writer,
                               const int16_t *samples, uint32_t num_samples);
 
-// Close WAV writer and finalize headers
+// Write float samples in [-1, 1] (interleaved if stereo), clamped and
+// converted to 16-bit PCM straight into the write buffer
+bool wave_writer_write_float(wave_writer_t *writer,
+                             const float *samples, uint32_t num_samples);
+
+// Close WAV writer: flush the buffer and write the final header once
 bool wave_writer_close(wave_writer_t *writer);
 
+// Float to 16-bit PCM: clamp to [-1, 1], scale by 32767, truncate
+void wave_convert_float(const float *input, int16_t *output, size_t count);
+
+// Use the portable conversion kernel only (benchmarks and tests)
+void wave_force_scalar(bool scalar);
+
 // Utility functions
 uint32_t wave_calculate_data_size(uint32_t num_samples, uint16_t channels);
 uint32_t wave_calculate_file_size(uint32_t data_size);
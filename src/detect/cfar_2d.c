@@ -0,0 +1,282 @@
+/*
+ * IQ Lab - Two-Dimensional (Time x Frequency) CFAR Detector Implementation
+ *
+ * Row ages count back from the newest row (age 0). With T ring rows the
+ * CUT row has age delay_rows and the guard band covers ages
+ * ref_rows .. ref_rows + 2*guard_rows. Pushing a row therefore:
+ * - adds the entering row to col_all and subtracts the row of age T,
+ * - adds the row reaching age ref_rows to col_guard and subtracts the row
+ *   passing age ref_rows + 2*guard_rows,
+ * all before the new row overwrites the oldest slot.
+ *
+ * A training rectangle is the full-height block over the clipped training
+ * bins minus the guard block over the clipped guard bins, each read from the
+ * frequency prefix sums of its column sums.
+ */
+
+#include "cfar_2d.h"
+#include "cfar_ca.h"
+#include "cfar_mask.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Frequency extent of the training and guard blocks around one bin
+typedef struct {
+    uint32_t outer_lo, outer_hi; // Inclusive, clipped to the spectrum
+    uint32_t inner_lo, inner_hi;
+} cfar_2d_span_t;
+
+static cfar_2d_span_t cfar_2d_span(const cfar_2d_t *cfar, uint32_t cut_index) {
+    uint32_t last = cfar->fft_size - 1;
+    uint32_t outer = cfar->guard_cells + cfar->ref_cells;
+    uint32_t inner = cfar->guard_cells;
+    cfar_2d_span_t s;
+
+    s.outer_lo = cut_index > outer ? cut_index - outer : 0;
+    s.outer_hi = last - cut_index > outer ? cut_index + outer : last;
+    s.inner_lo = cut_index > inner ? cut_index - inner : 0;
+    s.inner_hi = last - cut_index > inner ? cut_index + inner : last;
+    return s;
+}
+
+// Row of the given age; age 0 is 'incoming' when not yet in the ring
+static const double *cfar_2d_row(const cfar_2d_t *cfar, const double *incoming, uint32_t age) {
+    if (incoming) {
+        if (age == 0) return incoming;
+        return cfar->ring + (size_t)((cfar->head + cfar->ring_rows - age) % cfar->ring_rows) * cfar->fft_size;
+    }
+    return cfar->ring + (size_t)((cfar->head + cfar->ring_rows - 1 - age) % cfar->ring_rows) * cfar->fft_size;
+}
+
+static void cfar_2d_accumulate(double *col, const double *row, uint32_t n, double sign) {
+    for (uint32_t i = 0; i < n; i++) col[i] += sign * row[i];
+}
+
+// Rebuild both column sums from a full ring
+static void cfar_2d_resum(cfar_2d_t *cfar) {
+    uint32_t n = cfar->fft_size;
+    memset(cfar->col_all, 0, n * sizeof(double));
+    memset(cfar->col_guard, 0, n * sizeof(double));
+    for (uint32_t age = 0; age < cfar->ring_rows; age++) {
+        const double *row = cfar_2d_row(cfar, NULL, age);
+        cfar_2d_accumulate(cfar->col_all, row, n, 1.0);
+        if (age >= cfar->ref_rows && age <= cfar->ref_rows + 2 * cfar->guard_rows) {
+            cfar_2d_accumulate(cfar->col_guard, row, n, 1.0);
+        }
+    }
+    cfar->rows_since_resum = 0;
+}
+
+bool cfar_2d_init(cfar_2d_t *cfar, uint32_t fft_size, double pfa,
+                  uint32_t ref_cells, uint32_t guard_cells,
+                  uint32_t ref_rows, uint32_t guard_rows) {
+    if (!cfar) return false;
+    memset(cfar, 0, sizeof(*cfar));
+
+    if (!cfar_2d_validate_params(fft_size, pfa, ref_cells, guard_cells, ref_rows, guard_rows)) {
+        return false;
+    }
+
+    cfar->fft_size = fft_size;
+    cfar->pfa = pfa;
+    cfar->ref_cells = ref_cells;
+    cfar->guard_cells = guard_cells;
+    cfar->ref_rows = ref_rows;
+    cfar->guard_rows = guard_rows;
+    cfar->ring_rows = 2 * (ref_rows + guard_rows) + 1;
+    cfar->delay_rows = ref_rows + guard_rows;
+    cfar->max_cells = (2 * (ref_cells + guard_cells) + 1) * cfar->ring_rows -
+                      (2 * guard_cells + 1) * (2 * guard_rows + 1);
+
+    cfar->alpha = malloc(((size_t)cfar->max_cells + 1) * sizeof(double));
+    cfar->ring = malloc((size_t)cfar->ring_rows * fft_size * sizeof(double));
+    cfar->col_all = malloc((size_t)fft_size * sizeof(double));
+    cfar->col_guard = malloc((size_t)fft_size * sizeof(double));
+    cfar->prefix_all = malloc(((size_t)fft_size + 1) * sizeof(double));
+    cfar->prefix_guard = malloc(((size_t)fft_size + 1) * sizeof(double));
+    cfar->thresholds = malloc((size_t)fft_size * sizeof(double));
+    cfar->exceed_mask = malloc(CFAR_MASK_WORDS(fft_size) * sizeof(uint64_t));
+    if (!cfar->alpha || !cfar->ring || !cfar->col_all || !cfar->col_guard ||
+        !cfar->prefix_all || !cfar->prefix_guard || !cfar->thresholds || !cfar->exceed_mask) {
+        cfar_2d_free(cfar);
+        return false;
+    }
+
+    // alpha(n) = n * (pfa^(-1/n) - 1) for the mean of n exponential cells
+    cfar->alpha[0] = 0.0;
+    for (uint32_t n = 1; n <= cfar->max_cells; n++) {
+        cfar->alpha[n] = (double)n * (pow(pfa, -1.0 / (double)n) - 1.0);
+    }
+
+    cfar->initialized = true;
+    cfar_2d_reset(cfar);
+    return true;
+}
+
+uint32_t cfar_2d_push_row(cfar_2d_t *cfar, const double *power_row,
+                          cfar_detection_t *detections, uint32_t max_detections) {
+    if (!cfar || !cfar->initialized || !power_row || !detections || max_detections == 0) {
+        return 0;
+    }
+
+    const uint32_t n = cfar->fft_size;
+    const uint64_t seen = cfar->rows_pushed;
+    const uint32_t guard_enter = cfar->ref_rows;
+    const uint32_t guard_leave = cfar->ref_rows + 2 * cfar->guard_rows + 1;
+
+    // Running column sums, updated before the oldest slot is overwritten
+    if (seen >= guard_enter) {
+        cfar_2d_accumulate(cfar->col_guard, cfar_2d_row(cfar, power_row, guard_enter), n, 1.0);
+    }
+    if (seen >= guard_leave) {
+        cfar_2d_accumulate(cfar->col_guard, cfar_2d_row(cfar, power_row, guard_leave), n, -1.0);
+    }
+    cfar_2d_accumulate(cfar->col_all, power_row, n, 1.0);
+    if (seen >= cfar->ring_rows) {
+        cfar_2d_accumulate(cfar->col_all, cfar_2d_row(cfar, power_row, cfar->ring_rows), n, -1.0);
+    }
+
+    memcpy(cfar->ring + (size_t)cfar->head * n, power_row, n * sizeof(double));
+    cfar->head = (cfar->head + 1) % cfar->ring_rows;
+    cfar->rows_pushed++;
+
+    if (cfar->rows_pushed < cfar->ring_rows) {
+        return 0; // Ring still filling
+    }
+    if (++cfar->rows_since_resum >= CFAR_2D_RESUM_ROWS) {
+        cfar_2d_resum(cfar);
+    }
+
+    // Frequency prefix sums of both column sums
+    double *prefix_all = cfar->prefix_all;
+    double *prefix_guard = cfar->prefix_guard;
+    prefix_all[0] = 0.0;
+    prefix_guard[0] = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        prefix_all[i + 1] = prefix_all[i] + cfar->col_all[i];
+        prefix_guard[i + 1] = prefix_guard[i] + cfar->col_guard[i];
+    }
+
+    const uint32_t guard_height = 2 * cfar->guard_rows + 1;
+    for (uint32_t cut_index = 0; cut_index < n; cut_index++) {
+        cfar_2d_span_t s = cfar_2d_span(cfar, cut_index);
+        uint32_t cells = (s.outer_hi - s.outer_lo + 1) * cfar->ring_rows -
+                         (s.inner_hi - s.inner_lo + 1) * guard_height;
+        double sum = (prefix_all[s.outer_hi + 1] - prefix_all[s.outer_lo]) -
+                     (prefix_guard[s.inner_hi + 1] - prefix_guard[s.inner_lo]);
+
+        cfar->thresholds[cut_index] = cfar->alpha[cells] * sum / (double)cells;
+    }
+
+    const double *cut_row = cfar_2d_row(cfar, NULL, cfar->delay_rows);
+    cfar_exceed_mask(cut_row, cfar->thresholds, n, cfar->exceed_mask);
+    return cfar_compact_detections(cut_row, cfar->thresholds, cfar->exceed_mask, n,
+                                   detections, max_detections);
+}
+
+double cfar_2d_get_threshold(const cfar_2d_t *cfar, uint32_t cut_index) {
+    if (!cfar || !cfar->initialized || cut_index >= cfar->fft_size ||
+        cfar->rows_pushed < cfar->ring_rows) {
+        return 0.0;
+    }
+
+    cfar_2d_span_t s = cfar_2d_span(cfar, cut_index);
+    double sum = 0.0;
+    uint32_t cells = 0;
+    for (uint32_t age = 0; age < cfar->ring_rows; age++) {
+        const double *row = cfar_2d_row(cfar, NULL, age);
+        bool guard_row = age >= cfar->ref_rows && age <= cfar->ref_rows + 2 * cfar->guard_rows;
+        for (uint32_t i = s.outer_lo; i <= s.outer_hi; i++) {
+            if (guard_row && i >= s.inner_lo && i <= s.inner_hi) continue;
+            sum += row[i];
+            cells++;
+        }
+    }
+
+    return cfar->alpha[cells] * sum / (double)cells;
+}
+
+void cfar_2d_reset(cfar_2d_t *cfar) {
+    if (!cfar || !cfar->initialized) return;
+
+    memset(cfar->col_all, 0, cfar->fft_size * sizeof(double));
+    memset(cfar->col_guard, 0, cfar->fft_size * sizeof(double));
+    cfar->head = 0;
+    cfar->rows_pushed = 0;
+    cfar->rows_since_resum = 0;
+}
+
+// Ring position of a checkpointed detector, with its geometry
+typedef struct {
+    uint32_t fft_size;
+    uint32_t ring_rows;
+    uint32_t head;
+    uint32_t rows_since_resum;
+    uint64_t rows_pushed;
+} cfar_2d_state_t;
+
+bool cfar_2d_save_state(const cfar_2d_t *cfar, checkpoint_writer_t *writer) {
+    if (!cfar || !cfar->initialized || !writer) return false;
+
+    cfar_2d_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.fft_size = cfar->fft_size;
+    state.ring_rows = cfar->ring_rows;
+    state.head = cfar->head;
+    state.rows_since_resum = cfar->rows_since_resum;
+    state.rows_pushed = cfar->rows_pushed;
+
+    // The column sums are running sums: saved as they are, not rebuilt
+    size_t row_bytes = (size_t)cfar->fft_size * sizeof(double);
+    return checkpoint_put(writer, "cfar_2d.state", &state, sizeof(state)) &&
+           checkpoint_put(writer, "cfar_2d.ring", cfar->ring, cfar->ring_rows * row_bytes) &&
+           checkpoint_put(writer, "cfar_2d.col_all", cfar->col_all, row_bytes) &&
+           checkpoint_put(writer, "cfar_2d.col_guard", cfar->col_guard, row_bytes);
+}
+
+bool cfar_2d_load_state(cfar_2d_t *cfar, const checkpoint_t *checkpoint) {
+    if (!cfar || !cfar->initialized) return false;
+
+    cfar_2d_state_t state;
+    size_t row_bytes = (size_t)cfar->fft_size * sizeof(double);
+    bool ok = checkpoint_get(checkpoint, "cfar_2d.state", &state, sizeof(state)) &&
+              state.fft_size == cfar->fft_size && state.ring_rows == cfar->ring_rows &&
+              state.head < cfar->ring_rows &&
+              checkpoint_get(checkpoint, "cfar_2d.ring", cfar->ring, cfar->ring_rows * row_bytes) &&
+              checkpoint_get(checkpoint, "cfar_2d.col_all", cfar->col_all, row_bytes) &&
+              checkpoint_get(checkpoint, "cfar_2d.col_guard", cfar->col_guard, row_bytes);
+    if (!ok) {
+        cfar_2d_reset(cfar);
+        return false;
+    }
+
+    cfar->head = state.head;
+    cfar->rows_since_resum = state.rows_since_resum;
+    cfar->rows_pushed = state.rows_pushed;
+    return true;
+}
+
+void cfar_2d_free(cfar_2d_t *cfar) {
+    if (!cfar) return;
+
+    free(cfar->alpha);
+    free(cfar->ring);
+    free(cfar->col_all);
+    free(cfar->col_guard);
+    free(cfar->prefix_all);
+    free(cfar->prefix_guard);
+    free(cfar->thresholds);
+    free(cfar->exceed_mask);
+    memset(cfar, 0, sizeof(*cfar));
+}
+
+bool cfar_2d_validate_params(uint32_t fft_size, double pfa, uint32_t ref_cells,
+                             uint32_t guard_cells, uint32_t ref_rows, uint32_t guard_rows) {
+    if (!cfar_ca_validate_params(fft_size, pfa, ref_cells, guard_cells)) {
+        return false;
+    }
+
+    return ref_rows <= CFAR_2D_MAX_REF_ROWS && guard_rows <= CFAR_2D_MAX_GUARD_ROWS;
+}
@@ -0,0 +1,148 @@
+/*
+ * IQ Lab - Two-Dimensional (Time x Frequency) CFAR Detector Header
+ *
+ * Purpose: Cell-averaging CFAR over a rolling waterfall of power rows
+ *
+ *
+ * Per-frame CFAR only sees one row, so a weak carrier that persists for many
+ * frames is judged against just 2*ref_cells neighbours. The 2-D detector keeps
+ * the last T power rows in a ring and trains on a rectangle around the Cell
+ * Under Test that spans frequency AND time. The much larger training region
+ * lowers the CA multiplier towards -ln(pfa) and steadies the noise estimate,
+ * which is where the extra sensitivity comes from.
+ *
+ *          <-- ref_cells --><-guard-> CUT <-guard-><-- ref_cells -->
+ *     ^    +-------------------------------------------------------+
+ *  ref_rows|                   training cells                      |
+ *     v    |                +-------------------+                  |
+ *  guard   |                |  guard (+ CUT)    |                  |
+ *  rows    |                +-------------------+                  |
+ *     ^    |                   training cells                      |
+ *  ref_rows+-------------------------------------------------------+
+ *
+ * Choosing the geometry:
+ * - ref_rows = 0 makes the guard band span the whole ring, so only the
+ *   neighbouring bins train, over all T rows. Suits carriers that last longer
+ *   than the ring, which would otherwise raise their own threshold.
+ * - ref_rows > 0 also trains on the CUT's own bin in earlier and later rows.
+ *   Suits bursts shorter than the guard band.
+ *
+ * The CUT is the centre row of the ring, so detections trail the newest row
+ * by delay_rows = guard_rows + ref_rows frames; the last delay_rows rows of a
+ * stream are never tested.
+ *
+ * Usage:
+ *   cfar_2d_t cfar;
+ *   cfar_2d_init(&cfar, fft_size, pfa, ref_cells, guard_cells, ref_rows, guard_rows);
+ *   for each power row:
+ *       n = cfar_2d_push_row(&cfar, row, detections, max_detections);
+ *       // detections belong to the row pushed cfar.delay_rows rows earlier
+ *
+ * Technical Details:
+ * - Separable running sums: per-bin column sums over the whole ring and over
+ *   the guard rows are updated by adding the entering row and subtracting the
+ *   leaving one; a prefix sum across frequency then gives any rectangle in
+ *   two subtractions, so each cell costs O(1) regardless of the region size
+ * - Column sums are rebuilt from the ring every CFAR_2D_RESUM_ROWS rows so
+ *   add/subtract rounding cannot accumulate over long streams
+ * - Threshold multiplier alpha(n) = n * (pfa^(-1/n) - 1) for the mean of n
+ *   training cells, tabulated for every reachable n (fewer near band edges)
+ * - Exceedances go through the shared CFAR mask and compaction (cfar_mask.h)
+ *
+ * Memory: T * fft_size doubles for the ring, T = 2*(ref_rows + guard_rows) + 1
+ * Thread Safety: Not thread-safe (single detector instance per thread)
+ */
+
+#ifndef IQ_LAB_CFAR_2D_H
+#define IQ_LAB_CFAR_2D_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cfar_os.h"
+
+#define CFAR_2D_MAX_REF_ROWS 32
+#define CFAR_2D_MAX_GUARD_ROWS 8
+#define CFAR_2D_RESUM_ROWS 1024
+
+// 2-D CA-CFAR detector configuration and state
+typedef struct {
+    // Configuration parameters
+    uint32_t fft_size;           // Bins per row
+    double pfa;                  // Probability of False Alarm
+    uint32_t ref_cells;          // Training bins per side
+    uint32_t guard_cells;        // Guard bins per side of the CUT
+    uint32_t ref_rows;           // Training rows per side (time)
+    uint32_t guard_rows;         // Guard rows per side of the CUT (time)
+
+    // Derived parameters
+    uint32_t ring_rows;          // T = 2*(ref_rows + guard_rows) + 1
+    uint32_t delay_rows;         // Rows between the newest row and the CUT row
+    uint32_t max_cells;          // Largest training region (no edge clipping)
+    double *alpha;               // alpha[n] for n = 0 .. max_cells
+
+    // Ring of the last ring_rows power rows
+    double *ring;                // ring_rows * fft_size
+    uint32_t head;               // Slot the next row is written to
+    uint64_t rows_pushed;        // Rows seen since init/reset
+    uint32_t rows_since_resum;   // Rows since the column sums were rebuilt
+
+    // Working buffers
+    double *col_all;             // Per-bin sum over all ring rows
+    double *col_guard;           // Per-bin sum over the 2*guard_rows+1 centre rows
+    double *prefix_all;          // fft_size + 1 running sums of col_all
+    double *prefix_guard;        // fft_size + 1 running sums of col_guard
+    double *thresholds;          // Per-bin linear threshold of the CUT row
+    uint64_t *exceed_mask;       // Exceedance bits of the CUT row
+
+    // State
+    bool initialized;
+} cfar_2d_t;
+
+/*
+ * Initialize a 2-D CFAR detector
+ * Frequency parameters follow cfar_ca_validate_params; ref_rows up to
+ * CFAR_2D_MAX_REF_ROWS, guard_rows up to CFAR_2D_MAX_GUARD_ROWS.
+ * Returns true on success, false on parameter error or allocation failure
+ */
+bool cfar_2d_init(cfar_2d_t *cfar, uint32_t fft_size, double pfa,
+                  uint32_t ref_cells, uint32_t guard_cells,
+                  uint32_t ref_rows, uint32_t guard_rows);
+
+/*
+ * Append one power row (linear, fft_size bins) and test the centre row
+ * Returns the number of detections written (0 while the ring fills up).
+ * bin_index refers to the row pushed delay_rows calls earlier.
+ */
+uint32_t cfar_2d_push_row(cfar_2d_t *cfar, const double *power_row,
+                          cfar_detection_t *detections, uint32_t max_detections);
+
+/*
+ * Linear threshold of one bin of the current CUT row, computed directly
+ * from the ring; returns 0.0 on error or while the ring fills up
+ */
+double cfar_2d_get_threshold(const cfar_2d_t *cfar, uint32_t cut_index);
+
+/*
+ * Drop all buffered rows (start of a new stream); configuration is kept
+ */
+void cfar_2d_reset(cfar_2d_t *cfar);
+
+/*
+ * Save / restore the row ring and its column sums; on load the detector
+ * must be configured like the saved one
+ */
+bool cfar_2d_save_state(const cfar_2d_t *cfar, checkpoint_writer_t *writer);
+bool cfar_2d_load_state(cfar_2d_t *cfar, const checkpoint_t *checkpoint);
+
+/*
+ * Free detector resources and reset to uninitialized state
+ */
+void cfar_2d_free(cfar_2d_t *cfar);
+
+/*
+ * Validate detector parameters without creating detector
+ */
+bool cfar_2d_validate_params(uint32_t fft_size, double pfa, uint32_t ref_cells,
+                             uint32_t guard_cells, uint32_t ref_rows, uint32_t guard_rows);
+
+#endif /* IQ_LAB_CFAR_2D_H */
@@ -0,0 +1,177 @@
+/*
+ * IQ Lab - Cell-Averaging CFAR Detector Implementation
+ *
+ * Each frame is scanned in three passes: prefix[i] = sum of bins [0, i),
+ * then the threshold of every CUT, then the shared exceedance mask and
+ * compaction (cfar_mask.h). A training block [a, b] then sums to
+ * prefix[b + 1] - prefix[a], so the threshold costs the same for any
+ * ref_cells.
+ *
+ * Block means are scaled by alpha(n) for their own cell count n; CA uses
+ * both blocks as one, GO/SO keep the larger/smaller scaled block. Near the
+ * band edges a missing block is simply left out.
+ */
+
+#include "cfar_ca.h"
+#include "cfar_mask.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Training block bounds for one CUT, clipped to the spectrum
+typedef struct {
+    int64_t left_lo, left_hi;    // Inclusive; empty when hi < lo
+    int64_t right_lo, right_hi;
+} cfar_ca_blocks_t;
+
+static cfar_ca_blocks_t cfar_ca_blocks(const cfar_ca_t *cfar, uint32_t cut_index) {
+    int64_t cut = cut_index;
+    int64_t guard = cfar->guard_cells;
+    int64_t ref = cfar->ref_cells;
+    int64_t last = (int64_t)cfar->fft_size - 1;
+    cfar_ca_blocks_t b;
+
+    b.left_lo = cut - guard - ref < 0 ? 0 : cut - guard - ref;
+    b.left_hi = cut - guard - 1;
+    b.right_lo = cut + guard + 1;
+    b.right_hi = cut + guard + ref > last ? last : cut + guard + ref;
+    return b;
+}
+
+// Combine the two block sums into a threshold
+static double cfar_ca_combine(const cfar_ca_t *cfar, double left_sum, uint32_t left_n,
+                              double right_sum, uint32_t right_n) {
+    if (cfar->mode == CFAR_MODE_CA || left_n == 0 || right_n == 0) {
+        uint32_t n = left_n + right_n;
+        if (n == 0) return 0.0;
+        return cfar->alpha[n] * (left_sum + right_sum) / (double)n;
+    }
+
+    double left = cfar->alpha[left_n] * left_sum / (double)left_n;
+    double right = cfar->alpha[right_n] * right_sum / (double)right_n;
+    if (cfar->mode == CFAR_MODE_GO) return left > right ? left : right;
+    return left < right ? left : right;
+}
+
+bool cfar_ca_init(cfar_ca_t *cfar, uint32_t fft_size, double pfa,
+                  uint32_t ref_cells, uint32_t guard_cells, cfar_mode_t mode) {
+    if (!cfar) return false;
+    memset(cfar, 0, sizeof(*cfar));
+
+    if (!cfar_ca_validate_params(fft_size, pfa, ref_cells, guard_cells) ||
+        (mode != CFAR_MODE_CA && mode != CFAR_MODE_GO && mode != CFAR_MODE_SO)) {
+        return false;
+    }
+
+    cfar->fft_size = fft_size;
+    cfar->pfa = pfa;
+    cfar->ref_cells = ref_cells;
+    cfar->guard_cells = guard_cells;
+    cfar->mode = mode;
+
+    cfar->alpha = malloc((2 * (size_t)ref_cells + 1) * sizeof(double));
+    cfar->prefix = malloc(((size_t)fft_size + 1) * sizeof(double));
+    cfar->thresholds = malloc((size_t)fft_size * sizeof(double));
+    cfar->exceed_mask = malloc(CFAR_MASK_WORDS(fft_size) * sizeof(uint64_t));
+    if (!cfar->alpha || !cfar->prefix || !cfar->thresholds || !cfar->exceed_mask) {
+        cfar_ca_free(cfar);
+        return false;
+    }
+
+    // alpha(n) = n * (pfa^(-1/n) - 1) for the mean of n exponential cells
+    cfar->alpha[0] = 0.0;
+    for (uint32_t n = 1; n <= 2 * ref_cells; n++) {
+        cfar->alpha[n] = (double)n * (pow(pfa, -1.0 / (double)n) - 1.0);
+    }
+
+    cfar->initialized = true;
+    return true;
+}
+
+uint32_t cfar_ca_process_frame(cfar_ca_t *cfar, const double *power_spectrum,
+                               cfar_detection_t *detections, uint32_t max_detections) {
+    if (!cfar || !cfar->initialized || !power_spectrum || !detections || max_detections == 0) {
+        return 0;
+    }
+
+    double *prefix = cfar->prefix;
+    prefix[0] = 0.0;
+    for (uint32_t i = 0; i < cfar->fft_size; i++) {
+        prefix[i + 1] = prefix[i] + power_spectrum[i];
+    }
+
+    for (uint32_t cut_index = 0; cut_index < cfar->fft_size; cut_index++) {
+        cfar_ca_blocks_t b = cfar_ca_blocks(cfar, cut_index);
+        uint32_t left_n = b.left_hi >= b.left_lo ? (uint32_t)(b.left_hi - b.left_lo + 1) : 0;
+        uint32_t right_n = b.right_hi >= b.right_lo ? (uint32_t)(b.right_hi - b.right_lo + 1) : 0;
+        double left_sum = left_n ? prefix[b.left_hi + 1] - prefix[b.left_lo] : 0.0;
+        double right_sum = right_n ? prefix[b.right_hi + 1] - prefix[b.right_lo] : 0.0;
+
+        cfar->thresholds[cut_index] = cfar_ca_combine(cfar, left_sum, left_n, right_sum, right_n);
+    }
+
+    cfar_exceed_mask(power_spectrum, cfar->thresholds, cfar->fft_size, cfar->exceed_mask);
+    return cfar_compact_detections(power_spectrum, cfar->thresholds, cfar->exceed_mask, cfar->fft_size,
+                                   detections, max_detections);
+}
+
+uint32_t cfar_ca_detect_thresholds(cfar_ca_t *cfar, const double *power_spectrum, const double *thresholds,
+                                   cfar_detection_t *detections, uint32_t max_detections) {
+    if (!cfar || !cfar->initialized || !power_spectrum || !thresholds || !detections || max_detections == 0) {
+        return 0;
+    }
+
+    cfar_exceed_mask(power_spectrum, thresholds, cfar->fft_size, cfar->exceed_mask);
+    return cfar_compact_detections(power_spectrum, thresholds, cfar->exceed_mask, cfar->fft_size,
+                                   detections, max_detections);
+}
+
+double cfar_ca_get_threshold(const cfar_ca_t *cfar, const double *power_spectrum, uint32_t cut_index) {
+    if (!cfar || !cfar->initialized || !power_spectrum || cut_index >= cfar->fft_size) {
+        return 0.0;
+    }
+
+    cfar_ca_blocks_t b = cfar_ca_blocks(cfar, cut_index);
+    double left_sum = 0.0, right_sum = 0.0;
+    uint32_t left_n = 0, right_n = 0;
+    for (int64_t i = b.left_lo; i <= b.left_hi; i++, left_n++) left_sum += power_spectrum[i];
+    for (int64_t i = b.right_lo; i <= b.right_hi; i++, right_n++) right_sum += power_spectrum[i];
+
+    return cfar_ca_combine(cfar, left_sum, left_n, right_sum, right_n);
+}
+
+void cfar_ca_free(cfar_ca_t *cfar) {
+    if (!cfar) return;
+
+    free(cfar->alpha);
+    free(cfar->prefix);
+    free(cfar->thresholds);
+    free(cfar->exceed_mask);
+    memset(cfar, 0, sizeof(*cfar));
+}
+
+bool cfar_ca_validate_params(uint32_t fft_size, double pfa, uint32_t ref_cells,
+                             uint32_t guard_cells) {
+    // Same ranges as OS-CFAR; any rank in range makes the rank check pass
+    return cfar_os_validate_params(fft_size, pfa, ref_cells, guard_cells, 1);
+}
+
+bool cfar_mode_from_name(const char *name, cfar_mode_t *mode) {
+    if (!name || !mode) return false;
+
+    if (strcmp(name, "ca") == 0) *mode = CFAR_MODE_CA;
+    else if (strcmp(name, "go") == 0) *mode = CFAR_MODE_GO;
+    else if (strcmp(name, "so") == 0) *mode = CFAR_MODE_SO;
+    else return false;
+    return true;
+}
+
+const char *cfar_mode_name(cfar_mode_t mode) {
+    switch (mode) {
+        case CFAR_MODE_CA: return "ca";
+        case CFAR_MODE_GO: return "go";
+        case CFAR_MODE_SO: return "so";
+    }
+    return "unknown";
+}
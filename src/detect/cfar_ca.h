@@ -0,0 +1,118 @@
+/*
+ * IQ Lab - Cell-Averaging CFAR Detector Header
+ *
+ * Purpose: Mean-level CFAR detection (CA, GO and SO variants)
+ *
+ *
+ * Mean-level CFAR estimates the noise floor around each Cell Under Test from
+ * the average of its training cells instead of an ordered statistic. It is
+ * less robust than OS-CFAR next to strong interferers but much cheaper:
+ * a prefix sum over the frame makes every window average two subtractions.
+ *
+ * Modes:
+ * - CA (cell averaging): mean of both training blocks; best in homogeneous noise
+ * - GO (greatest of): larger of the two block means; fewer false alarms at
+ *   clutter edges
+ * - SO (smallest of): smaller of the two block means; resolves closely
+ *   spaced targets
+ *
+ * Usage:
+ *   cfar_ca_t cfar;
+ *   cfar_ca_init(&cfar, fft_size, pfa, ref_cells, guard_cells, CFAR_MODE_CA);
+ *   cfar_ca_process_frame(&cfar, power_spectrum, detections, max_detections);
+ *
+ * Technical Details:
+ * - Training window: ref_cells per side, guard_cells excluded around the CUT
+ * - Near band edges only the cells inside the spectrum are used
+ * - Threshold multiplier for the mean of n exponential cells:
+ *   alpha(n) = n * (pfa^(-1/n) - 1), tabulated for every n up to 2*ref_cells;
+ *   CA scales the mean of all cells, GO/SO scale each block by its own n
+ * - Output uses cfar_detection_t, so clustering works unchanged
+ *
+ * Performance: O(N) per frame (one prefix sum, O(1) per threshold, one
+ * vectorized compare; see cfar_mask.h)
+ * Thread Safety: Not thread-safe (single detector instance per thread)
+ */
+
+#ifndef IQ_LAB_CFAR_CA_H
+#define IQ_LAB_CFAR_CA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cfar_os.h"
+
+// Mean-level CFAR variant
+typedef enum {
+    CFAR_MODE_CA = 0,            // Cell averaging
+    CFAR_MODE_GO,                // Greatest-of block means
+    CFAR_MODE_SO                 // Smallest-of block means
+} cfar_mode_t;
+
+// Mean-level CFAR detector configuration and state
+typedef struct {
+    // Configuration parameters
+    uint32_t fft_size;           // Size of FFT frame
+    double pfa;                  // Probability of False Alarm
+    uint32_t ref_cells;          // Training cells per side
+    uint32_t guard_cells;        // Guard cells around CUT
+    cfar_mode_t mode;            // CA, GO or SO
+
+    // Derived parameters
+    double *alpha;               // alpha[n] for n = 0 .. 2*ref_cells averaged cells
+
+    // Working buffers
+    double *prefix;              // fft_size + 1 running sums of the current frame
+    double *thresholds;          // Per-bin linear threshold of the current frame
+    uint64_t *exceed_mask;       // Exceedance bits of the current frame
+
+    // State
+    bool initialized;
+} cfar_ca_t;
+
+/*
+ * Initialize a mean-level CFAR detector
+ * Parameter ranges follow cfar_os_validate_params (without the rank).
+ * Returns true on success, false on parameter error or allocation failure
+ */
+bool cfar_ca_init(cfar_ca_t *cfar, uint32_t fft_size, double pfa,
+                  uint32_t ref_cells, uint32_t guard_cells, cfar_mode_t mode);
+
+/*
+ * Process a single FFT frame (linear power, fft_size bins)
+ * Returns the number of detections written (0 to max_detections)
+ */
+uint32_t cfar_ca_process_frame(cfar_ca_t *cfar, const double *power_spectrum,
+                               cfar_detection_t *detections, uint32_t max_detections);
+
+/*
+ * Detections of one frame against thresholds computed elsewhere, e.g. the
+ * device CFAR stage of gpu.h; same mask and compaction as process_frame
+ */
+uint32_t cfar_ca_detect_thresholds(cfar_ca_t *cfar, const double *power_spectrum, const double *thresholds,
+                                   cfar_detection_t *detections, uint32_t max_detections);
+
+/*
+ * Adaptive threshold (linear) for one CUT, computed directly from the
+ * spectrum; returns 0.0 on error
+ */
+double cfar_ca_get_threshold(const cfar_ca_t *cfar, const double *power_spectrum, uint32_t cut_index);
+
+/*
+ * Free detector resources and reset to uninitialized state
+ */
+void cfar_ca_free(cfar_ca_t *cfar);
+
+/*
+ * Validate detector parameters without creating detector
+ */
+bool cfar_ca_validate_params(uint32_t fft_size, double pfa, uint32_t ref_cells,
+                             uint32_t guard_cells);
+
+/*
+ * Mode names ("ca", "go", "so")
+ * cfar_mode_from_name returns false for unknown names.
+ */
+bool cfar_mode_from_name(const char *name, cfar_mode_t *mode);
+const char *cfar_mode_name(cfar_mode_t mode);
+
+#endif /* IQ_LAB_CFAR_CA_H */
@@ -0,0 +1,269 @@
+/*
+ * IQ Lab - CFAR Exceedance Mask and Detection Compaction
+ *
+ * The compare packs each vector's lanes with movemask (x86) or lane
+ * extraction (NEON) into the running 64-bit word; the scalar path ORs
+ * comparison results the same way, so every path yields identical masks.
+ * The block L1 sums accumulate per lane and add the lanes at the end.
+ */
+
+#include "cfar_mask.h"
+#include <stdatomic.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CFAR_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define CFAR_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+enum {
+    CFAR_SIMD_SCALAR,
+    CFAR_SIMD_SSE2,
+    CFAR_SIMD_AVX,
+    CFAR_SIMD_NEON
+};
+
+// -1 until the first frame detects the CPU
+static atomic_int cfar_simd_active = -1;
+
+static int cfar_simd_detect(void) {
+#if defined(CFAR_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx")) return CFAR_SIMD_AVX;
+    if (__builtin_cpu_supports("sse2")) return CFAR_SIMD_SSE2;
+    return CFAR_SIMD_SCALAR;
+#elif defined(CFAR_HAVE_NEON)
+    return CFAR_SIMD_NEON;
+#else
+    return CFAR_SIMD_SCALAR;
+#endif
+}
+
+void cfar_mask_force_scalar(bool scalar) {
+    atomic_store(&cfar_simd_active, scalar ? CFAR_SIMD_SCALAR : cfar_simd_detect());
+}
+
+// Bits for bins [begin, end) of one word, scalar
+static uint64_t cfar_mask_bits_scalar(const double *power, const double *threshold,
+                                      uint32_t begin, uint32_t end) {
+    uint64_t bits = 0;
+    for (uint32_t i = begin; i < end; i++) {
+        bool hit = (threshold[i] > 0.0) & (power[i] > threshold[i]);
+        bits |= (uint64_t)hit << (i - begin);
+    }
+    return bits;
+}
+
+#if defined(CFAR_HAVE_X86_SIMD)
+
+// SSE2: two bins per compare
+__attribute__((target("sse2")))
+static uint64_t cfar_mask_word_sse2(const double *power, const double *threshold) {
+    const __m128d zero = _mm_setzero_pd();
+    uint64_t bits = 0;
+    for (uint32_t j = 0; j < 64; j += 2) {
+        __m128d t = _mm_loadu_pd(threshold + j);
+        __m128d p = _mm_loadu_pd(power + j);
+        __m128d hit = _mm_and_pd(_mm_cmpgt_pd(t, zero), _mm_cmpgt_pd(p, t));
+        bits |= (uint64_t)_mm_movemask_pd(hit) << j;
+    }
+    return bits;
+}
+
+// AVX: four bins per compare (ordered, non-signalling: NaN is never a hit)
+__attribute__((target("avx")))
+static uint64_t cfar_mask_word_avx(const double *power, const double *threshold) {
+    const __m256d zero = _mm256_setzero_pd();
+    uint64_t bits = 0;
+    for (uint32_t j = 0; j < 64; j += 4) {
+        __m256d t = _mm256_loadu_pd(threshold + j);
+        __m256d p = _mm256_loadu_pd(power + j);
+        __m256d hit = _mm256_and_pd(_mm256_cmp_pd(t, zero, _CMP_GT_OQ), _mm256_cmp_pd(p, t, _CMP_GT_OQ));
+        bits |= (uint64_t)_mm256_movemask_pd(hit) << j;
+    }
+    return bits;
+}
+
+#endif /* CFAR_HAVE_X86_SIMD */
+
+#if defined(CFAR_HAVE_NEON)
+
+// NEON: two bins per compare
+static uint64_t cfar_mask_word_neon(const double *power, const double *threshold) {
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    uint64_t bits = 0;
+    for (uint32_t j = 0; j < 64; j += 2) {
+        float64x2_t t = vld1q_f64(threshold + j);
+        float64x2_t p = vld1q_f64(power + j);
+        uint64x2_t hit = vandq_u64(vcgtq_f64(t, zero), vcgtq_f64(p, t));
+        bits |= (vgetq_lane_u64(hit, 0) & 1) << j;
+        bits |= (vgetq_lane_u64(hit, 1) & 1) << (j + 1);
+    }
+    return bits;
+}
+
+#endif /* CFAR_HAVE_NEON */
+
+void cfar_exceed_mask(const double *power, const double *threshold, uint32_t n, uint64_t *mask) {
+    int simd = atomic_load(&cfar_simd_active);
+    if (simd < 0) {
+        simd = cfar_simd_detect();
+        atomic_store(&cfar_simd_active, simd);
+    }
+
+    uint32_t full_words = n / 64;
+    for (uint32_t w = 0; w < full_words; w++) {
+        const double *p = power + (size_t)w * 64;
+        const double *t = threshold + (size_t)w * 64;
+        switch (simd) {
+#if defined(CFAR_HAVE_X86_SIMD)
+            case CFAR_SIMD_AVX:  mask[w] = cfar_mask_word_avx(p, t); break;
+            case CFAR_SIMD_SSE2: mask[w] = cfar_mask_word_sse2(p, t); break;
+#endif
+#if defined(CFAR_HAVE_NEON)
+            case CFAR_SIMD_NEON: mask[w] = cfar_mask_word_neon(p, t); break;
+#endif
+            default:             mask[w] = cfar_mask_bits_scalar(power, threshold, w * 64, w * 64 + 64); break;
+        }
+    }
+
+    // Partial last word
+    if (n % 64) {
+        mask[full_words] = cfar_mask_bits_scalar(power, threshold, full_words * 64, n);
+    }
+}
+
+#if defined(CFAR_HAVE_X86_SIMD)
+
+// SSE2: two bins per step; |x| by clearing the sign bit
+__attribute__((target("sse2")))
+static uint32_t cfar_l1_sse2(const double *a, const double *b, uint32_t n, double *distance, double *norm) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d dist = _mm_setzero_pd(), sum = _mm_setzero_pd();
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(a + i);
+        __m128d y = _mm_loadu_pd(b + i);
+        dist = _mm_add_pd(dist, _mm_andnot_pd(sign, _mm_sub_pd(x, y)));
+        sum = _mm_add_pd(sum, _mm_andnot_pd(sign, y));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, dist);
+    *distance += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sum);
+    *norm += lanes[0] + lanes[1];
+    return i;
+}
+
+// AVX: four bins per step
+__attribute__((target("avx")))
+static uint32_t cfar_l1_avx(const double *a, const double *b, uint32_t n, double *distance, double *norm) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d dist = _mm256_setzero_pd(), sum = _mm256_setzero_pd();
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(a + i);
+        __m256d y = _mm256_loadu_pd(b + i);
+        dist = _mm256_add_pd(dist, _mm256_andnot_pd(sign, _mm256_sub_pd(x, y)));
+        sum = _mm256_add_pd(sum, _mm256_andnot_pd(sign, y));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, dist);
+    *distance += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm256_storeu_pd(lanes, sum);
+    *norm += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    return i;
+}
+
+#endif /* CFAR_HAVE_X86_SIMD */
+
+#if defined(CFAR_HAVE_NEON)
+
+// NEON: two bins per step
+static uint32_t cfar_l1_neon(const double *a, const double *b, uint32_t n, double *distance, double *norm) {
+    float64x2_t dist = vdupq_n_f64(0.0), sum = vdupq_n_f64(0.0);
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t x = vld1q_f64(a + i);
+        float64x2_t y = vld1q_f64(b + i);
+        dist = vaddq_f64(dist, vabdq_f64(x, y));
+        sum = vaddq_f64(sum, vabsq_f64(y));
+    }
+    *distance += vgetq_lane_f64(dist, 0) + vgetq_lane_f64(dist, 1);
+    *norm += vgetq_lane_f64(sum, 0) + vgetq_lane_f64(sum, 1);
+    return i;
+}
+
+#endif /* CFAR_HAVE_NEON */
+
+void cfar_block_l1(const double *a, const double *b, uint32_t n, double *distance, double *norm) {
+    int simd = atomic_load(&cfar_simd_active);
+    if (simd < 0) {
+        simd = cfar_simd_detect();
+        atomic_store(&cfar_simd_active, simd);
+    }
+
+    *distance = 0.0;
+    *norm = 0.0;
+    uint32_t i = 0;
+    switch (simd) {
+#if defined(CFAR_HAVE_X86_SIMD)
+        case CFAR_SIMD_AVX:  i = cfar_l1_avx(a, b, n, distance, norm); break;
+        case CFAR_SIMD_SSE2: i = cfar_l1_sse2(a, b, n, distance, norm); break;
+#endif
+#if defined(CFAR_HAVE_NEON)
+        case CFAR_SIMD_NEON: i = cfar_l1_neon(a, b, n, distance, norm); break;
+#endif
+        default: break;
+    }
+    for (; i < n; i++) {
+        *distance += fabs(a[i] - b[i]);
+        *norm += fabs(b[i]);
+    }
+}
+
+// Index of the lowest set bit (bits != 0)
+static uint32_t cfar_lowest_bit(uint64_t bits) {
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctzll(bits);
+#else
+    uint32_t i = 0;
+    while (!(bits & 1)) { bits >>= 1; i++; }
+    return i;
+#endif
+}
+
+uint32_t cfar_compact_detections(const double *power, const double *threshold,
+                                 const uint64_t *mask, uint32_t n,
+                                 cfar_detection_t *detections, uint32_t max_detections) {
+    uint32_t num_detections = 0;
+
+    for (size_t w = 0; w < CFAR_MASK_WORDS(n) && num_detections < max_detections; w++) {
+        uint64_t bits = mask[w];
+        while (bits && num_detections < max_detections) {
+            uint32_t bin = (uint32_t)(w * 64) + cfar_lowest_bit(bits);
+            bits &= bits - 1;
+
+            double threshold_linear = threshold[bin];
+            double signal_power_linear = power[bin];
+            double threshold_db = 10.0 * log10(threshold_linear);
+            double signal_power_db = 10.0 * log10(signal_power_linear);
+            cfar_detection_t *detection = &detections[num_detections++];
+
+            detection->bin_index = bin;
+            detection->threshold = threshold_db;
+            detection->signal_power = signal_power_db;
+            detection->snr_estimate = signal_power_db - threshold_db;
+
+            // Confidence based on SNR, capped at 10x
+            double snr_ratio = signal_power_linear / threshold_linear;
+            detection->confidence = fmin(1.0, snr_ratio / 10.0);
+        }
+    }
+
+    return num_detections;
+}
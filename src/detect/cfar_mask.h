@@ -0,0 +1,58 @@
+/*
+ * IQ Lab - CFAR Exceedance Mask and Detection Compaction
+ *
+ * Purpose: Shared back end of the CFAR detectors
+ *
+ * Detectors first fill a per-bin threshold row, then hand it here. The
+ * compare runs branch-free over the whole frame (AVX or SSE2 on x86, NEON on
+ * AArch64, scalar elsewhere) and packs exceedances into 64-bit words; the
+ * compaction step walks only the set bits, so the dB conversions, SNR and
+ * confidence are computed for detections alone. Noise bins cost one compare.
+ *
+ * A bin is detected when threshold > 0 and power > threshold, exactly the
+ * test the scalar detector loops applied (NaN never detects).
+ *
+ * The block L1 distance behind the incremental OS-CFAR mode lives here too,
+ * on the same dispatch.
+ *
+ * Dependencies: cfar_os.h (cfar_detection_t)
+ * Thread Safety: Stateless apart from the one-time CPU feature probe
+ */
+
+#ifndef IQ_LAB_CFAR_MASK_H
+#define IQ_LAB_CFAR_MASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cfar_os.h"
+
+// 64-bit mask words needed for n bins
+#define CFAR_MASK_WORDS(n) (((size_t)(n) + 63) / 64)
+
+/*
+ * Set bit i of mask (word i / 64, bit i % 64) for every exceeding bin
+ * 'mask' holds CFAR_MASK_WORDS(n) words; bits past n are cleared.
+ */
+void cfar_exceed_mask(const double *power, const double *threshold, uint32_t n, uint64_t *mask);
+
+/*
+ * Fill detections for the set bits in ascending bin order, up to
+ * max_detections; returns the number written
+ */
+uint32_t cfar_compact_detections(const double *power, const double *threshold,
+                                 const uint64_t *mask, uint32_t n,
+                                 cfar_detection_t *detections, uint32_t max_detections);
+
+/*
+ * Change measure of the incremental OS-CFAR: *distance = sum |a[i] - b[i]|
+ * and *norm = sum |b[i]| over n bins. The SIMD paths sum in lanes, so they
+ * may differ from the scalar sums by rounding.
+ */
+void cfar_block_l1(const double *a, const double *b, uint32_t n, double *distance, double *norm);
+
+/*
+ * Use the scalar compare even where SIMD is available (tests, benchmarks)
+ */
+void cfar_mask_force_scalar(bool scalar);
+
+#endif /* IQ_LAB_CFAR_MASK_H */
@@ -21,9 +21,19 @@
  * distribution and the desired PFA target.
  *
  * Performance Considerations:
- * - Sorting dominates complexity: O(N log N) per frame
- * - Memory usage is O(FFT_SIZE) for training buffer
- * - Suitable for real-time processing up to ~8192 FFT size
+ * - Frame processing keeps the training cells in a sorted window that is
+ *   updated incrementally as the CUT advances (O(log R) search per update)
+ * - Thresholds are identical to selecting from the copied training cells
+ * - The threshold row is compared to the spectrum as a bitmask, then only the
+ *   set bits are turned into detections
+ * - Incremental frames slide the window over the dirty runs only, each
+ *   started from scratch at its first bin; the window holds the same cells
+ *   as in a full pass, so recomputed thresholds are bit-identical
+ * - Approximate frames quantize each power once (one log10 per cell the
+ *   windows touch) and slide a histogram instead; the k-th highest cell
+ *   is found by walking the per-64-bin group counts down from the top,
+ *   then the bins of one group
+ * - Memory usage is O(ref_cells) for the training buffers
  *
  * Edge Cases Handled:
  * - Boundary conditions at spectrum edges
@@ -33,6 +43,7 @@
  */
 
 #include "cfar_os.h"
+#include "cfar_mask.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -107,6 +118,111 @@ static double quickselect(double *arr, int n, int k) {
     return arr[k];
 }
 
+/*
+ * Sorted sliding window of training cells
+ * Only positive powers take part, matching the single-CUT path. Equal
+ * values are interchangeable, so removal may take any matching entry.
+ */
+static uint32_t sorted_lower_bound(const double *sorted, uint32_t count, double value) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (sorted[mid] < value) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void sorted_window_insert(cfar_os_t *cfar, double value) {
+    if (!(value > 0.0) || cfar->sorted_count >= cfar->buffer_size) return;
+
+    uint32_t pos = sorted_lower_bound(cfar->sorted_window, cfar->sorted_count, value);
+    memmove(&cfar->sorted_window[pos + 1], &cfar->sorted_window[pos],
+            (cfar->sorted_count - pos) * sizeof(double));
+    cfar->sorted_window[pos] = value;
+    cfar->sorted_count++;
+}
+
+static void sorted_window_remove(cfar_os_t *cfar, double value) {
+    if (!(value > 0.0)) return;
+
+    uint32_t pos = sorted_lower_bound(cfar->sorted_window, cfar->sorted_count, value);
+    if (pos >= cfar->sorted_count || cfar->sorted_window[pos] != value) return;
+    memmove(&cfar->sorted_window[pos], &cfar->sorted_window[pos + 1],
+            (cfar->sorted_count - pos - 1) * sizeof(double));
+    cfar->sorted_count--;
+}
+
+/*
+ * Histogram window of the approximate mode: the same cells as the sorted
+ * window, counted per power bin
+ */
+#define HIST_GROUP 64
+#define HIST_NONE UINT16_MAX
+
+static uint16_t hist_quantize(const cfar_os_t *cfar, double value) {
+    if (!(value > 0.0)) return HIST_NONE;
+
+    double bin = floor((10.0 * log10(value) - CFAR_OS_HIST_MIN_DB) / cfar->hist_bin_db);
+    if (bin < 0.0) return 0;
+    if (bin >= cfar->hist_bins) return (uint16_t)(cfar->hist_bins - 1);
+    return (uint16_t)bin;
+}
+
+static void hist_insert(cfar_os_t *cfar, uint16_t bin) {
+    if (bin == HIST_NONE) return;
+    cfar->hist_counts[bin]++;
+    cfar->hist_groups[bin / HIST_GROUP]++;
+    cfar->hist_total++;
+}
+
+static void hist_remove(cfar_os_t *cfar, uint16_t bin) {
+    if (bin == HIST_NONE) return;
+    cfar->hist_counts[bin]--;
+    cfar->hist_groups[bin / HIST_GROUP]--;
+    cfar->hist_total--;
+}
+
+// Power bin of the k-th highest cell (hist_total >= k)
+static uint32_t hist_select(const cfar_os_t *cfar, uint32_t k) {
+    uint32_t group = (cfar->hist_bins - 1) / HIST_GROUP;
+    while (cfar->hist_groups[group] < k) {
+        k -= cfar->hist_groups[group];
+        group--;
+    }
+    uint32_t bin = group * HIST_GROUP + HIST_GROUP - 1;
+    if (bin >= cfar->hist_bins) bin = cfar->hist_bins - 1;
+    while (cfar->hist_counts[bin] < k) {
+        k -= cfar->hist_counts[bin];
+        bin--;
+    }
+    return bin;
+}
+
+static void hist_release(cfar_os_t *cfar) {
+    free(cfar->hist_counts);
+    free(cfar->hist_groups);
+    free(cfar->hist_levels);
+    free(cfar->quantized);
+    cfar->hist_counts = NULL;
+    cfar->hist_groups = NULL;
+    cfar->hist_levels = NULL;
+    cfar->quantized = NULL;
+    cfar->hist_bin_db = 0.0;
+    cfar->hist_bins = 0;
+    cfar->hist_total = 0;
+}
+
+// Either window: the histogram in approximate mode, else the sorted cells
+static inline void window_insert(cfar_os_t *cfar, const double *power_spectrum, int64_t i) {
+    if (cfar->hist_bins) hist_insert(cfar, cfar->quantized[i]);
+    else sorted_window_insert(cfar, power_spectrum[i]);
+}
+
+static inline void window_remove(cfar_os_t *cfar, const double *power_spectrum, int64_t i) {
+    if (cfar->hist_bins) hist_remove(cfar, cfar->quantized[i]);
+    else sorted_window_remove(cfar, power_spectrum[i]);
+}
 
 // Public API implementation
 
@@ -129,11 +245,36 @@ bool cfar_os_init(cfar_os_t *cfar, uint32_t fft_size, double pfa,
     cfar->guard_cells = guard_cells;
     cfar->os_rank = os_rank;
     cfar->total_training_cells = 2 * ref_cells;
+    cfar->block_bins = 0;
+    cfar->change_tolerance = 0.0;
+    cfar->reference = NULL;
+    cfar->reference_valid = false;
+    cfar->blocks_checked = 0;
+    cfar->blocks_kept = 0;
+    cfar->hist_bin_db = 0.0;
+    cfar->hist_bins = 0;
+    cfar->hist_total = 0;
+    cfar->hist_counts = NULL;
+    cfar->hist_groups = NULL;
+    cfar->hist_levels = NULL;
+    cfar->quantized = NULL;
 
     // Allocate training buffer
     cfar->buffer_size = cfar->total_training_cells;
     cfar->training_buffer = malloc(cfar->buffer_size * sizeof(double));
-    if (!cfar->training_buffer) {
+    cfar->sorted_window = malloc(cfar->buffer_size * sizeof(double));
+    cfar->sorted_count = 0;
+    cfar->thresholds = malloc((size_t)fft_size * sizeof(double));
+    cfar->exceed_mask = malloc(CFAR_MASK_WORDS(fft_size) * sizeof(uint64_t));
+    if (!cfar->training_buffer || !cfar->sorted_window || !cfar->thresholds || !cfar->exceed_mask) {
+        free(cfar->training_buffer);
+        free(cfar->sorted_window);
+        free(cfar->thresholds);
+        free(cfar->exceed_mask);
+        cfar->training_buffer = NULL;
+        cfar->sorted_window = NULL;
+        cfar->thresholds = NULL;
+        cfar->exceed_mask = NULL;
         return false;
     }
 
@@ -144,53 +285,112 @@ bool cfar_os_init(cfar_os_t *cfar, uint32_t fft_size, double pfa,
     return true;
 }
 
-uint32_t cfar_os_process_frame(cfar_os_t *cfar, const double *power_spectrum,
-                               cfar_detection_t *detections, uint32_t max_detections) {
-
-    if (!cfar || !cfar->initialized || !power_spectrum || !detections || max_detections == 0) {
-        return 0;
+// Thresholds of the CUTs [begin, end): the window is filled for 'begin', then slides
+static void compute_thresholds(cfar_os_t *cfar, const double *power_spectrum, int64_t begin, int64_t end) {
+    const int64_t n = cfar->fft_size;
+    const int64_t guard = cfar->guard_cells;
+    const int64_t ref = cfar->ref_cells;
+    double *thresholds = cfar->thresholds;
+
+    // Approximate mode: the power bin of every cell these windows touch
+    if (cfar->hist_bins) {
+        int64_t first = begin - guard - ref < 0 ? 0 : begin - guard - ref;
+        int64_t last = end + guard + ref > n ? n : end + guard + ref;
+        for (int64_t i = first; i < last; i++) cfar->quantized[i] = hist_quantize(cfar, power_spectrum[i]);
+        memset(cfar->hist_counts, 0, cfar->hist_bins * sizeof(uint32_t));
+        memset(cfar->hist_groups, 0, (cfar->hist_bins + HIST_GROUP - 1) / HIST_GROUP * sizeof(uint32_t));
+        cfar->hist_total = 0;
     }
 
-    uint32_t num_detections = 0;
-
-    // Process each bin as a potential Cell Under Test (CUT)
-    for (uint32_t cut_index = 0; cut_index < cfar->fft_size && num_detections < max_detections; cut_index++) {
+    // Training window of the first CUT: both blocks, clipped to the frame
+    cfar->sorted_count = 0;
+    for (int64_t i = begin - guard - ref; i < begin - guard; i++) {
+        if (i >= 0) window_insert(cfar, power_spectrum, i);
+    }
+    for (int64_t i = begin + guard + 1; i <= begin + guard + ref && i < n; i++) {
+        window_insert(cfar, power_spectrum, i);
+    }
 
-        // Calculate adaptive threshold for this CUT
-        double threshold_linear = cfar_os_get_threshold(cfar, power_spectrum, cut_index);
-        if (threshold_linear <= 0.0) {
-            continue; // Skip if threshold calculation failed
+    // Threshold of every bin as a Cell Under Test (CUT); 0 means no decision
+    for (int64_t cut = begin; cut < end; cut++) {
+        // Slide by one bin: each block gains one cell and loses one
+        if (cut > begin) {
+            if (cut - guard - ref - 1 >= 0) window_remove(cfar, power_spectrum, cut - guard - ref - 1);
+            if (cut - guard - 1 >= 0) window_insert(cfar, power_spectrum, cut - guard - 1);
+            if (cut + guard < n) window_remove(cfar, power_spectrum, cut + guard);
+            if (cut + guard + ref < n) window_insert(cfar, power_spectrum, cut + guard + ref);
         }
 
-        // Get signal power at CUT
-        double signal_power_linear = power_spectrum[cut_index];
-        if (signal_power_linear <= 0.0) {
-            continue; // Skip invalid power values
+        // K-th highest training cell, scaled by the CFAR constant
+        if (cfar->hist_bins) {
+            thresholds[cut] = cfar->hist_total < cfar->os_rank
+                ? 0.0
+                : cfar->hist_levels[hist_select(cfar, cfar->os_rank)] * cfar->cfar_constant;
+        } else {
+            thresholds[cut] = cfar->sorted_count < cfar->os_rank
+                ? 0.0 // Insufficient training cells
+                : cfar->sorted_window[cfar->sorted_count - cfar->os_rank] * cfar->cfar_constant;
         }
+    }
+}
 
-        // Convert to dB for easier interpretation
-        double threshold_db = 10.0 * log10(threshold_linear);
-        double signal_power_db = 10.0 * log10(signal_power_linear);
+/*
+ * Incremental frame: recompute the thresholds within a window's reach of
+ * the blocks that moved away from their reference, as merged runs
+ */
+static void update_thresholds(cfar_os_t *cfar, const double *power_spectrum) {
+    const int64_t n = cfar->fft_size;
+    const int64_t reach = (int64_t)cfar->guard_cells + cfar->ref_cells;
+    const uint32_t block = cfar->block_bins;
+    int64_t run_begin = -1, run_end = -1;
+
+    for (uint32_t start = 0; start < cfar->fft_size; start += block) {
+        uint32_t length = cfar->fft_size - start < block ? cfar->fft_size - start : block;
+        double distance, norm;
+        cfar_block_l1(power_spectrum + start, cfar->reference + start, length, &distance, &norm);
+        cfar->blocks_checked++;
+
+        // NaN compares false, so it counts as a change
+        if (distance <= cfar->change_tolerance * norm) {
+            cfar->blocks_kept++;
+            continue;
+        }
+        memcpy(cfar->reference + start, power_spectrum + start, length * sizeof(double));
 
-        // Check if signal exceeds threshold
-        if (signal_power_linear > threshold_linear) {
-            // Detection found!
-            cfar_detection_t *detection = &detections[num_detections];
+        int64_t begin = (int64_t)start - reach < 0 ? 0 : (int64_t)start - reach;
+        int64_t end = (int64_t)(start + length) + reach > n ? n : (int64_t)(start + length) + reach;
+        if (run_end >= begin) {
+            run_end = end;
+            continue;
+        }
+        if (run_begin >= 0) compute_thresholds(cfar, power_spectrum, run_begin, run_end);
+        run_begin = begin;
+        run_end = end;
+    }
+    if (run_begin >= 0) compute_thresholds(cfar, power_spectrum, run_begin, run_end);
+}
 
-            detection->bin_index = cut_index;
-            detection->threshold = threshold_db;
-            detection->signal_power = signal_power_db;
-            detection->snr_estimate = signal_power_db - threshold_db;
+uint32_t cfar_os_process_frame(cfar_os_t *cfar, const double *power_spectrum,
+                               cfar_detection_t *detections, uint32_t max_detections) {
 
-            // Calculate confidence based on SNR
-            double snr_ratio = signal_power_linear / threshold_linear;
-            detection->confidence = fmin(1.0, snr_ratio / 10.0); // Cap at 10dB SNR
+    if (!cfar || !cfar->initialized || !power_spectrum || !detections || max_detections == 0) {
+        return 0;
+    }
 
-            num_detections++;
+    if (cfar->block_bins && cfar->reference_valid) {
+        update_thresholds(cfar, power_spectrum);
+    } else {
+        compute_thresholds(cfar, power_spectrum, 0, cfar->fft_size);
+        if (cfar->block_bins) {
+            memcpy(cfar->reference, power_spectrum, (size_t)cfar->fft_size * sizeof(double));
+            cfar->reference_valid = true;
         }
     }
 
-    return num_detections;
+    // Compare the whole row at once, then build detections for set bits only
+    cfar_exceed_mask(power_spectrum, cfar->thresholds, cfar->fft_size, cfar->exceed_mask);
+    return cfar_compact_detections(power_spectrum, cfar->thresholds, cfar->exceed_mask, cfar->fft_size,
+                                   detections, max_detections);
 }
 
 double cfar_os_get_threshold(cfar_os_t *cfar, const double *power_spectrum, uint32_t cut_index) {
@@ -240,6 +440,56 @@ double cfar_os_get_threshold(cfar_os_t *cfar, const double *power_spectrum, uint
     return threshold;
 }
 
+bool cfar_os_set_incremental(cfar_os_t *cfar, uint32_t block_bins, double tolerance) {
+    if (!cfar || !cfar->initialized) return false;
+    if (!(tolerance >= 0.0) || !isfinite(tolerance)) {
+        fprintf(stderr, "Error: Invalid incremental CFAR tolerance %g\n", tolerance);
+        return false;
+    }
+
+    free(cfar->reference);
+    cfar->reference = NULL;
+    cfar->block_bins = 0;
+    if (block_bins > 0) {
+        cfar->reference = malloc((size_t)cfar->fft_size * sizeof(double));
+        if (!cfar->reference) return false;
+        cfar->block_bins = block_bins;
+    }
+    cfar->change_tolerance = tolerance;
+    cfar->reference_valid = false;
+    cfar->blocks_checked = 0;
+    cfar->blocks_kept = 0;
+    return true;
+}
+
+bool cfar_os_set_approximate(cfar_os_t *cfar, double bin_db) {
+    if (!cfar || !cfar->initialized) return false;
+    if (bin_db != 0.0 && !(bin_db >= CFAR_OS_HIST_MIN_WIDTH_DB && bin_db <= CFAR_OS_HIST_MAX_WIDTH_DB)) {
+        fprintf(stderr, "Error: Invalid approximate CFAR bin width %g dB\n", bin_db);
+        return false;
+    }
+
+    hist_release(cfar);
+    cfar->reference_valid = false;  // Kept thresholds came from the other window
+    if (bin_db == 0.0) return true;
+
+    uint32_t bins = (uint32_t)ceil((CFAR_OS_HIST_MAX_DB - CFAR_OS_HIST_MIN_DB) / bin_db);
+    cfar->hist_counts = calloc(bins, sizeof(uint32_t));
+    cfar->hist_groups = calloc((bins + HIST_GROUP - 1) / HIST_GROUP, sizeof(uint32_t));
+    cfar->hist_levels = malloc(bins * sizeof(double));
+    cfar->quantized = malloc((size_t)cfar->fft_size * sizeof(uint16_t));
+    if (!cfar->hist_counts || !cfar->hist_groups || !cfar->hist_levels || !cfar->quantized) {
+        hist_release(cfar);
+        return false;
+    }
+    for (uint32_t bin = 0; bin < bins; bin++) {
+        cfar->hist_levels[bin] = pow(10.0, (CFAR_OS_HIST_MIN_DB + (bin + 1) * bin_db) / 10.0);
+    }
+    cfar->hist_bin_db = bin_db;
+    cfar->hist_bins = bins;
+    return true;
+}
+
 void cfar_os_reset(cfar_os_t *cfar) {
     if (!cfar) return;
 
@@ -247,6 +497,10 @@ void cfar_os_reset(cfar_os_t *cfar) {
     if (cfar->training_buffer) {
         memset(cfar->training_buffer, 0, cfar->buffer_size * sizeof(double));
     }
+    cfar->sorted_count = 0;
+    cfar->reference_valid = false;
+    cfar->blocks_checked = 0;
+    cfar->blocks_kept = 0;
 
     // Reset derived parameters (keep configuration)
     cfar->total_training_cells = 2 * cfar->ref_cells;
@@ -254,6 +508,62 @@ void cfar_os_reset(cfar_os_t *cfar) {
                                                  cfar->os_rank, cfar->pfa);
 }
 
+// Frame-to-frame state of a checkpointed detector, with its geometry
+typedef struct {
+    uint32_t fft_size;
+    uint32_t block_bins;
+    uint32_t reference_valid;
+    uint32_t hist_bins;
+    uint64_t blocks_checked;
+    uint64_t blocks_kept;
+} cfar_os_state_t;
+
+bool cfar_os_save_state(const cfar_os_t *cfar, checkpoint_writer_t *writer) {
+    if (!cfar || !cfar->initialized || !writer) return false;
+
+    cfar_os_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.fft_size = cfar->fft_size;
+    state.block_bins = cfar->block_bins;
+    state.reference_valid = cfar->reference_valid;
+    state.hist_bins = cfar->hist_bins;
+    state.blocks_checked = cfar->blocks_checked;
+    state.blocks_kept = cfar->blocks_kept;
+    bool ok = checkpoint_put(writer, "cfar_os.state", &state, sizeof(state));
+
+    // Kept blocks reuse the thresholds of earlier frames
+    size_t row_bytes = (size_t)cfar->fft_size * sizeof(double);
+    if (ok && cfar->block_bins && cfar->reference_valid) {
+        ok = checkpoint_put(writer, "cfar_os.reference", cfar->reference, row_bytes) &&
+             checkpoint_put(writer, "cfar_os.thresholds", cfar->thresholds, row_bytes);
+    }
+    return ok;
+}
+
+bool cfar_os_load_state(cfar_os_t *cfar, const checkpoint_t *checkpoint) {
+    if (!cfar || !cfar->initialized) return false;
+    cfar_os_reset(cfar);
+
+    cfar_os_state_t state;
+    size_t row_bytes = (size_t)cfar->fft_size * sizeof(double);
+    bool ok = checkpoint_get(checkpoint, "cfar_os.state", &state, sizeof(state)) &&
+              state.fft_size == cfar->fft_size && state.block_bins == cfar->block_bins &&
+              state.hist_bins == cfar->hist_bins;
+    if (ok && state.block_bins && state.reference_valid) {
+        ok = checkpoint_get(checkpoint, "cfar_os.reference", cfar->reference, row_bytes) &&
+             checkpoint_get(checkpoint, "cfar_os.thresholds", cfar->thresholds, row_bytes);
+    }
+    if (!ok) {
+        cfar_os_reset(cfar);
+        return false;
+    }
+
+    cfar->reference_valid = state.block_bins && state.reference_valid;
+    cfar->blocks_checked = state.blocks_checked;
+    cfar->blocks_kept = state.blocks_kept;
+    return true;
+}
+
 void cfar_os_free(cfar_os_t *cfar) {
     if (!cfar) return;
 
@@ -262,6 +572,12 @@ void cfar_os_free(cfar_os_t *cfar) {
         free(cfar->training_buffer);
         cfar->training_buffer = NULL;
     }
+    free(cfar->sorted_window);
+    cfar->sorted_window = NULL;
+    free(cfar->thresholds);
+    free(cfar->exceed_mask);
+    free(cfar->reference);
+    hist_release(cfar);
 
     // Reset all fields
     memset(cfar, 0, sizeof(cfar_os_t));
@@ -274,9 +590,9 @@ bool cfar_os_get_config_string(const cfar_os_t *cfar, char *buffer, uint32_t buf
     }
 
     int written = snprintf(buffer, buffer_size,
-                          "OS-CFAR: FFT=%u, PFA=%.2e, RefCells=%u, GuardCells=%u, OS-Rank=%u",
+                          "OS-CFAR: FFT=%u, PFA=%.2e, RefCells=%u, GuardCells=%u, OS-Rank=%u%s",
                           cfar->fft_size, cfar->pfa, cfar->ref_cells,
-                          cfar->guard_cells, cfar->os_rank);
+                          cfar->guard_cells, cfar->os_rank, cfar->hist_bins ? ", Approximate" : "");
 
     return (written > 0 && (uint32_t)written < buffer_size);
 }
@@ -36,7 +36,28 @@
  * - OS Rank: k parameter selects robustness vs sensitivity tradeoff
  *
  * Performance:
- * - O(N log N) complexity per frame (dominated by sorting)
+ * - Frames slide one sorted training window across the spectrum: two cells
+ *   enter and two leave per bin (binary search plus a move of at most
+ *   2*ref_cells doubles), and the k-th value is read by index; no per-bin
+ *   copy or selection
+ * - Thresholds land in a per-bin row that is compared in one vectorized pass
+ *   (cfar_mask.h); only exceeding bins pay for the dB/SNR conversions
+ * - cfar_os_get_threshold() still evaluates a single CUT from scratch
+ * - Incremental mode (cfar_os_set_incremental) for static spectra: each
+ *   block of bins is compared (SIMD L1 distance) with the spectrum its
+ *   thresholds were last computed from, and only the thresholds whose
+ *   training window touches a changed block are recomputed; the compare
+ *   and the detections still use the new frame
+ * - Approximate mode (cfar_os_set_approximate) for very wide training
+ *   regions: the window is a histogram of quantized powers (bins of
+ *   bin_db dB) with a count per 64 bins, so a slide is four counter
+ *   updates and the rank is found from the cumulative counts in
+ *   O(bins / 64 + 64), whatever ref_cells is. The threshold is the upper
+ *   edge of the k-th value's bin: never below the exact threshold and less
+ *   than bin_db dB above it (0.1 dB: under 2.4% in power), so the false
+ *   alarm rate never exceeds the exact detector's. The bound holds while
+ *   the k-th value lies in [CFAR_OS_HIST_MIN_DB, CFAR_OS_HIST_MAX_DB);
+ *   outside that range powers are clamped into the end bins
  * - Memory efficient with fixed-size state
  * - Suitable for real-time processing up to high FFT sizes
  *
@@ -48,7 +69,7 @@
  *
  * Dependencies: stdlib.h, stdbool.h, stdint.h, math.h
  * Thread Safety: Not thread-safe (single detector instance per thread)
- * Performance: O(N log N) per FFT frame, suitable for real-time SDR
+ * Performance: O(N log R) comparisons per FFT frame, suitable for real-time SDR
  */
 
 #ifndef IQ_LAB_CFAR_OS_H
@@ -56,11 +77,19 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "../iq_core/checkpoint.h"
+
+#define CFAR_OS_DEFAULT_BLOCK_BINS 64  // Incremental mode: bins per change block
+#define CFAR_OS_HIST_DEFAULT_DB 0.1    // Approximate mode: power bin width (dB)
+#define CFAR_OS_HIST_MIN_WIDTH_DB 0.01 // Narrowest power bin
+#define CFAR_OS_HIST_MAX_WIDTH_DB 3.0  // Widest power bin
+#define CFAR_OS_HIST_MIN_DB -200.0     // Lowest power with its own bins (dB)
+#define CFAR_OS_HIST_MAX_DB 200.0      // Highest power with its own bins (dB)
 
 // OS-CFAR detector configuration and state
 typedef struct {
     // Configuration parameters
-    uint32_t fft_size;           // Size of FFT frame (must be power of 2)
+    uint32_t fft_size;           // Size of FFT frame (any length)
     double pfa;                  // Probability of False Alarm (1e-6 to 1e-2)
     uint32_t ref_cells;          // Training cells per side (8-32 typical)
     uint32_t guard_cells;        // Guard cells around CUT (1-4 typical)
@@ -73,6 +102,27 @@ typedef struct {
     // Working buffers
     double *training_buffer;     // Buffer for training cell values
     uint32_t buffer_size;        // Size of training buffer
+    double *sorted_window;       // Training cells of the sliding window, ascending
+    uint32_t sorted_count;       // Valid entries in sorted_window
+    double *thresholds;          // Per-bin linear threshold of the current frame
+    uint64_t *exceed_mask;       // Exceedance bits of the current frame
+
+    // Incremental mode (block_bins 0: every frame from scratch)
+    uint32_t block_bins;         // Bins per change block
+    double change_tolerance;     // Block kept while its L1 change <= tolerance * its L1 norm
+    double *reference;           // Per block, the spectrum its thresholds came from
+    bool reference_valid;        // False until the first frame (and after a reset)
+    uint64_t blocks_checked;     // Blocks compared
+    uint64_t blocks_kept;        // ... whose thresholds were kept
+
+    // Approximate mode (hist_bins 0: exact sorted window)
+    double hist_bin_db;          // Width of a power bin (dB)
+    uint32_t hist_bins;          // Power bins from CFAR_OS_HIST_MIN_DB to CFAR_OS_HIST_MAX_DB
+    uint32_t hist_total;         // Training cells in the histogram
+    uint32_t *hist_counts;       // Training cells per power bin
+    uint32_t *hist_groups;       // Training cells per 64 power bins
+    double *hist_levels;         // Per power bin, its upper edge (linear)
+    uint16_t *quantized;         // Per spectrum bin, its power bin (UINT16_MAX: not positive)
 
     // State
     bool initialized;            // Whether detector is properly initialized
@@ -94,7 +144,7 @@ typedef struct {
  *
  * Parameters:
  *   cfar        - Pointer to detector structure to initialize
- *   fft_size    - Size of FFT frame (must be power of 2)
+ *   fft_size    - Size of FFT frame (any length)
  *   pfa         - Desired Probability of False Alarm (e.g., 1e-3)
  *   ref_cells   - Number of training cells per side of CUT (8-32)
  *   guard_cells - Number of guard cells around CUT (1-4)
@@ -121,6 +171,38 @@ bool cfar_os_init(cfar_os_t *cfar, uint32_t fft_size, double pfa,
 uint32_t cfar_os_process_frame(cfar_os_t *cfar, const double *power_spectrum,
                                cfar_detection_t *detections, uint32_t max_detections);
 
+/*
+ * Switch the incremental mode on (block_bins > 0) or off (0)
+ *
+ * A block of block_bins bins counts as changed when the L1 distance of the
+ * new frame to the block's reference exceeds tolerance * the reference's L1
+ * norm; a changed block becomes the new reference. Thresholds are
+ * recomputed for every bin whose training window overlaps a changed block
+ * and kept elsewhere, so every threshold comes from values whose blocks lie
+ * within the tolerance of their references, as the current frame's do.
+ * Tolerance 0 recomputes on any change and gives the from-scratch
+ * detections exactly. The first frame after this call or a reset is
+ * computed in full.
+ *
+ * Returns:
+ *   false on an invalid tolerance (negative or not finite) or no memory
+ */
+bool cfar_os_set_incremental(cfar_os_t *cfar, uint32_t block_bins, double tolerance);
+
+/*
+ * Switch the approximate mode on (bin_db > 0) or off (0)
+ *
+ * Frames then take the k-th value from a sliding histogram of powers
+ * quantized to bin_db dB (CFAR_OS_HIST_DEFAULT_DB typical); each threshold
+ * is at least the exact one and less than bin_db dB above it. Combines
+ * with the incremental mode; cfar_os_get_threshold() stays exact.
+ *
+ * Returns:
+ *   false on a width outside [CFAR_OS_HIST_MIN_WIDTH_DB,
+ *   CFAR_OS_HIST_MAX_WIDTH_DB] (other than 0) or no memory
+ */
+bool cfar_os_set_approximate(cfar_os_t *cfar, double bin_db);
+
 /*
  * Calculate the adaptive threshold for a specific CUT
  *
@@ -142,6 +224,19 @@ double cfar_os_get_threshold(cfar_os_t *cfar, const double *power_spectrum, uint
  */
 void cfar_os_reset(cfar_os_t *cfar);
 
+/*
+ * Save / restore the state carried from frame to frame (the incremental
+ * mode's references and kept thresholds, and its counters)
+ *
+ * Parameters:
+ *   cfar - Detector; on load, configured like the saved one
+ *
+ * Returns:
+ *   true on success, false on error or a checkpoint of another detector
+ */
+bool cfar_os_save_state(const cfar_os_t *cfar, checkpoint_writer_t *writer);
+bool cfar_os_load_state(cfar_os_t *cfar, const checkpoint_t *checkpoint);
+
 /*
  * Free detector resources and reset to uninitialized state
  *
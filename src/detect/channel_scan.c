@@ -0,0 +1,309 @@
+/*
+ * IQ Lab - Channelized Coarse-to-Fine Detection
+ *
+ * Channel outputs are drained from the bank's rings into one staging row
+ * per channel as soon as they are written, so frames can overlap by more
+ * than a ring holds; each frame is then read in place from the staging.
+ */
+
+#include "channel_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CHANNEL_SCAN_CUTOFF 1.5         // Prototype bandwidth in channel spacings
+#define CHANNEL_SCAN_ZERO_SAMPLES 4096  // Flush input per pfb_process_block call
+
+// k-th smallest of values[0 .. n) (reorders them)
+static double select_kth(double *values, uint32_t n, uint32_t k) {
+    uint32_t lo = 0, hi = n - 1;
+    while (lo < hi) {
+        double pivot = values[lo + (hi - lo) / 2];
+        uint32_t i = lo, j = hi;
+        while (i <= j) {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j) {
+                double t = values[i];
+                values[i] = values[j];
+                values[j] = t;
+                i++;
+                if (j == 0) break;
+                j--;
+            }
+        }
+        if (k <= j) hi = j;
+        else if (k >= i) lo = i;
+        else break;
+    }
+    return values[k];
+}
+
+bool channel_scan_validate(const channel_scan_config_t *config) {
+    if (!config) return false;
+    const uint32_t m = config->num_channels;
+    if (m < PFB_MIN_CHANNELS || m > PFB_MAX_CHANNELS || (m & (m - 1)) != 0) {
+        fprintf(stderr, "Channel count must be a power of two from %d to %d, got %u\n",
+                PFB_MIN_CHANNELS, PFB_MAX_CHANNELS, m);
+        return false;
+    }
+    const uint32_t d = m / 2;
+    if (config->fft_size < 2 * m || config->fft_size % d != 0 || config->hop_size == 0 ||
+        config->hop_size % d != 0 || config->hop_size > config->fft_size) {
+        fprintf(stderr, "FFT size and hop must be multiples of %u (half the %u channels), "
+                "FFT >= %u and hop <= FFT\n", d, m, 2 * m);
+        return false;
+    }
+    if (!(config->margin_db > 0.0) || config->sample_rate <= 0.0 || config->max_detections == 0) {
+        fprintf(stderr, "Invalid channel scan parameters\n");
+        return false;
+    }
+    uint32_t fine = config->fft_size / d;
+    bool cfar_ok = config->use_os ?
+        cfar_os_validate_params(fine, config->pfa, config->ref_cells, config->guard_cells, config->os_rank) :
+        cfar_ca_validate_params(fine, config->pfa, config->ref_cells, config->guard_cells);
+    if (!cfar_ok) {
+        fprintf(stderr, "CFAR parameters do not fit the %u-bin channel rows (fewer channels or a longer FFT)\n",
+                fine);
+        return false;
+    }
+    return true;
+}
+
+channel_scan_t *channel_scan_create(const channel_scan_config_t *config) {
+    if (!channel_scan_validate(config)) return NULL;
+
+    channel_scan_t *scan = calloc(1, sizeof(*scan));
+    if (!scan) return NULL;
+    scan->config = *config;
+    const uint32_t m = config->num_channels;
+    scan->decimation = m / 2;
+    scan->fine_size = config->fft_size / scan->decimation;
+    scan->fine_hop = config->hop_size / scan->decimation;
+    scan->margin = pow(10.0, config->margin_db / 10.0);
+    scan->power_scale = (double)scan->decimation * (double)scan->decimation;
+
+    // 2x oversampled bank with a short prototype: coarse power only needs
+    // the channels kept apart, not the isolation of a channelizer
+    pfb_config_t bank;
+    bool ok = pfb_config_init(&bank, m, config->sample_rate, CHANNEL_SCAN_CUTOFF * config->sample_rate / m);
+    if (ok) {
+        bank.filter_length = 1;
+        while (bank.filter_length < m * PFB_MIN_BRANCH_TAPS) bank.filter_length *= 2;
+        bank.oversampling = 2;
+        scan->pfb = pfb_config_validate(&bank) ? pfb_create(&bank) : NULL;
+    }
+    if (!scan->pfb) {
+        fprintf(stderr, "Failed to create the %u-channel filter bank\n", m);
+        channel_scan_destroy(scan);
+        return NULL;
+    }
+
+    // Channel output j then sits at input sample j * D
+    double delay = ((double)bank.filter_length - 1.0) / 2.0 - (double)(scan->decimation - 1);
+    scan->drop_left = delay > 0.0 ? (uint32_t)llround(delay / scan->decimation) : 0;
+    scan->flush_samples = (size_t)bank.filter_length + scan->decimation;
+
+    scan->capacity = scan->fine_size + bank.block_size;
+    scan->staging = malloc((size_t)m * scan->capacity * sizeof(float complex));
+    scan->channel_power = malloc(m * sizeof(double));
+    scan->sort_scratch = malloc(m * sizeof(double));
+    scan->hold_left = calloc(m, sizeof(uint32_t));
+    scan->row = malloc(scan->fine_size * sizeof(double));
+    scan->scratch = malloc(config->max_detections * sizeof(cfar_detection_t));
+    scan->zeros = calloc(CHANNEL_SCAN_ZERO_SAMPLES, sizeof(float complex));
+    scan->plan = fft_plan_f32_acquire(scan->fine_size, FFT_FORWARD);
+    if (config->window != WINDOW_RECTANGULAR) {
+        double param = config->window == WINDOW_KAISER ? WINDOW_KAISER_DEFAULT_BETA : 0.0;
+        scan->fine_window = window_acquire(config->window, scan->fine_size, param);
+    }
+    if (!scan->staging || !scan->channel_power || !scan->sort_scratch || !scan->hold_left ||
+        !scan->row || !scan->scratch || !scan->zeros || !scan->plan ||
+        (config->window != WINDOW_RECTANGULAR && !scan->fine_window)) {
+        fprintf(stderr, "Failed to allocate the channel scan\n");
+        channel_scan_destroy(scan);
+        return NULL;
+    }
+
+    ok = config->use_os ?
+        cfar_os_init(&scan->cfar_os, scan->fine_size, config->pfa, config->ref_cells,
+                     config->guard_cells, config->os_rank) :
+        cfar_ca_init(&scan->cfar_ca, scan->fine_size, config->pfa, config->ref_cells,
+                     config->guard_cells, config->ca_mode);
+    if (!ok) {
+        fprintf(stderr, "Failed to initialize the channel CFAR\n");
+        channel_scan_destroy(scan);
+        return NULL;
+    }
+    return scan;
+}
+
+void channel_scan_destroy(channel_scan_t *scan) {
+    if (!scan) return;
+    pfb_destroy(scan->pfb);
+    if (scan->plan) fft_plan_f32_release(scan->plan);
+    window_release(scan->fine_window);
+    cfar_os_free(&scan->cfar_os);
+    cfar_ca_free(&scan->cfar_ca);
+    free(scan->staging);
+    free(scan->channel_power);
+    free(scan->sort_scratch);
+    free(scan->hold_left);
+    free(scan->row);
+    free(scan->scratch);
+    free(scan->zeros);
+    free(scan);
+}
+
+void channel_scan_reset(channel_scan_t *scan) {
+    if (!scan) return;
+    pfb_reset(scan->pfb);
+    double delay = ((double)scan->pfb->filter_length - 1.0) / 2.0 - (double)(scan->decimation - 1);
+    scan->drop_left = delay > 0.0 ? (uint32_t)llround(delay / scan->decimation) : 0;
+    scan->staged = 0;
+    scan->staged_base = 0;
+    memset(scan->hold_left, 0, scan->config.num_channels * sizeof(uint32_t));
+    scan->samples_in = 0;
+    scan->next_frame = 0;
+    scan->frames = 0;
+    scan->fine_frames = 0;
+}
+
+// Free the staged outputs before the next frame's first one
+static void compact_staging(channel_scan_t *scan) {
+    uint64_t first = scan->next_frame * scan->fine_hop;
+    if (first <= scan->staged_base) return;
+    uint64_t shift = first - scan->staged_base;
+    if (shift > scan->staged) shift = scan->staged;
+    uint32_t keep = scan->staged - (uint32_t)shift;
+    if (keep > 0) {
+        for (uint32_t c = 0; c < scan->config.num_channels; c++) {
+            float complex *row = scan->staging + (size_t)c * scan->capacity;
+            memmove(row, row + shift, keep * sizeof(float complex));
+        }
+    }
+    scan->staged = keep;
+    scan->staged_base += shift;
+}
+
+// Move every written output from the bank's rings to the staging rows
+static void drain_bank(channel_scan_t *scan) {
+    uint32_t available = 0;
+    pfb_channel_read(scan->pfb, 0, &available);
+    uint32_t drop = available < scan->drop_left ? available : scan->drop_left;
+    uint32_t take = available - drop;
+    for (uint32_t c = 0; c < scan->config.num_channels; c++) {
+        uint32_t count = 0;
+        const float complex *out = pfb_channel_read(scan->pfb, c, &count);
+        if (out && take > 0) {
+            memcpy(scan->staging + (size_t)c * scan->capacity + scan->staged, out + drop,
+                   take * sizeof(float complex));
+        }
+        pfb_channel_commit(scan->pfb, c, count);
+    }
+    scan->drop_left -= drop;
+    scan->staged += take;
+}
+
+size_t channel_scan_push(channel_scan_t *scan, const float complex *input, size_t count) {
+    if (!scan || count == 0) return 0;
+    compact_staging(scan);
+
+    const uint32_t d = scan->decimation;
+    size_t consumed = 0;
+    while (consumed < count) {
+        // Outputs this chunk may write: into the staging, or discarded as delay
+        uint64_t room = (uint64_t)(scan->capacity - scan->staged) + scan->drop_left;
+        uint64_t ring = scan->pfb->config.block_size;
+        if (room > ring) room = ring;
+        uint64_t limit = room * d - scan->pfb->pending;
+        if (room == 0 || limit == 0) break;
+
+        size_t chunk = count - consumed;
+        if (chunk > limit) chunk = (size_t)limit;
+        const float complex *samples = input ? input + consumed : scan->zeros;
+        if (!input && chunk > CHANNEL_SCAN_ZERO_SAMPLES) chunk = CHANNEL_SCAN_ZERO_SAMPLES;
+
+        int32_t n = pfb_process_block(scan->pfb, samples, (uint32_t)chunk);
+        if (n <= 0) break;
+        consumed += (size_t)n;
+        drain_bank(scan);
+    }
+    if (input) scan->samples_in += consumed;
+    return consumed;
+}
+
+bool channel_scan_frame(channel_scan_t *scan, cfar_detection_t *detections,
+                        uint32_t *num_detections, uint64_t *offset) {
+    if (!scan) return false;
+    const channel_scan_config_t *config = &scan->config;
+    const uint64_t frame = scan->next_frame;
+    const uint64_t first = frame * scan->fine_hop;
+    if (frame * config->hop_size + config->fft_size > scan->samples_in ||
+        first < scan->staged_base || first + scan->fine_size > scan->staged_base + scan->staged) {
+        return false;
+    }
+
+    const uint32_t m = config->num_channels;
+    const uint32_t f = scan->fine_size;
+    const size_t column = (size_t)(first - scan->staged_base);
+
+    // Coarse: mean power per channel against the median channel
+    for (uint32_t c = 0; c < m; c++) {
+        const float *x = (const float *)(scan->staging + (size_t)c * scan->capacity + column);
+        double sum = 0.0;
+        for (uint32_t k = 0; k < 2 * f; k++) sum += (double)x[k] * x[k];
+        scan->channel_power[c] = sum / f;
+        scan->sort_scratch[c] = scan->channel_power[c];
+    }
+    double threshold = select_kth(scan->sort_scratch, m, m / 2) * scan->margin;
+
+    // Fine: FFT and CFAR of the active channels, kept bins only
+    uint32_t found = 0;
+    const uint32_t quarter = f / 4;
+    const uint32_t spacing = config->fft_size / m;
+    const float *window = scan->fine_window ? scan->fine_window->coefficients_f32 : NULL;
+    for (uint32_t c = 0; c < m; c++) {
+        bool active = scan->channel_power[c] > threshold;
+        if (active) {
+            scan->hold_left[c] = config->hold_frames;
+        } else if (scan->hold_left[c] > 0) {
+            scan->hold_left[c]--;
+            active = true;
+        }
+        if (!active) continue;
+        scan->fine_frames++;
+
+        const float *x = (const float *)(scan->staging + (size_t)c * scan->capacity + column);
+        if (!fft_spectral_frame_f64(scan->plan, x, window, scan->row, false)) continue;
+
+        for (uint32_t k = 0; k < f; k++) scan->row[k] *= scan->power_scale;
+        uint32_t n = config->use_os ?
+            cfar_os_process_frame(&scan->cfar_os, scan->row, scan->scratch, config->max_detections) :
+            cfar_ca_process_frame(&scan->cfar_ca, scan->row, scan->scratch, config->max_detections);
+        for (uint32_t i = 0; i < n && found < config->max_detections; i++) {
+            uint32_t bin = scan->scratch[i].bin_index;
+            if (bin < quarter || bin >= f - quarter) continue;
+            int64_t global = (int64_t)c * spacing + (int64_t)bin - (int64_t)(f / 2);
+            if (global < 0) global += config->fft_size;
+            detections[found] = scan->scratch[i];
+            detections[found].bin_index = (uint32_t)global;
+            found++;
+        }
+    }
+
+    // Ascending bins, as a full-band row reports them (channel 0 wraps)
+    for (uint32_t i = 1; i < found; i++) {
+        cfar_detection_t d = detections[i];
+        uint32_t j = i;
+        for (; j > 0 && detections[j - 1].bin_index > d.bin_index; j--) detections[j] = detections[j - 1];
+        detections[j] = d;
+    }
+
+    *num_detections = found;
+    *offset = frame * config->hop_size;
+    scan->next_frame++;
+    scan->frames++;
+    return true;
+}
@@ -0,0 +1,160 @@
+/*
+ * IQ Lab - Channelized Coarse-to-Fine Detection Header
+ *
+ * Purpose: Run CFAR only where a sparse wideband spectrum has energy
+ *
+ *
+ * A full-band detector transforms and thresholds all N bins of every frame,
+ * even when a handful of narrow signals occupy a fraction of the band. The
+ * scan splits the band with a polyphase filter bank (pfb.h) into M
+ * channels first and works in two levels:
+ *
+ * 1. Coarse: the mean power of each channel's outputs over the frame,
+ *    against the median over all channels (the noise of a sparse band)
+ *    plus a margin. Channels above it, and the next hold_frames frames of
+ *    each, are active.
+ * 2. Fine: each active channel gets its own FFT of F = 2N/M points and a
+ *    per-frame CFAR (OS or CA/GO/SO). The bank is 2x oversampled, so F
+ *    points at 2 fs/M give the bin width fs/N of the full-band FFT; the
+ *    central half of the row is the channel's own N/M bins, the outer
+ *    halves belong to its neighbours and only train the CFAR.
+ *
+ * Detections come back in full-band bins (0 .. N-1, DC at N/2) and in
+ * ascending bin order, with powers scaled to the full-band FFT, so
+ * clustering and features see the same values as the full-band path.
+ *
+ * Usage:
+ *   channel_scan_config_t cfg = { .fft_size = 4096, .hop_size = 1024,
+ *                                 .num_channels = 32, ... };
+ *   channel_scan_t *scan = channel_scan_create(&cfg);
+ *   while (samples) {
+ *       for (done = 0; done < n; done += channel_scan_push(scan, x + done, n - done))
+ *           while (channel_scan_frame(scan, dets, &count, &offset)) ...;
+ *   }
+ *   then channel_scan_push(scan, NULL, scan->flush_samples) the same way
+ *
+ * Technical Details:
+ * - Channel c is centred at (c - M/2) fs / M, i.e. full-band bin c N / M;
+ *   channel 0 straddles +-fs/2 and wraps around the row
+ * - The bank's prototype has PFB_MIN_BRANCH_TAPS taps per branch and a
+ *   cutoff of 0.75 fs/M, flat over the kept half and with its transition
+ *   clear of the aliases of the 2 fs/M output rate
+ * - The filter delay is dropped from the channel outputs, so frame k covers
+ *   input samples [k hop, k hop + N) like the full-band frame k
+ * - Frames only exist where the full-band path has them: k hop + N no more
+ *   than the samples pushed (flush padding excluded)
+ *
+ * Memory: the bank (M rings), M staged frames plus one ring, and one fine plan
+ * Thread Safety: Not thread-safe (single scan instance per thread)
+ */
+
+#ifndef IQ_LAB_CHANNEL_SCAN_H
+#define IQ_LAB_CHANNEL_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <complex.h>
+#include "cfar_os.h"
+#include "cfar_ca.h"
+#include "../chan/pfb.h"
+#include "../iq_core/fft.h"
+#include "../iq_core/window.h"
+
+#define CHANNEL_SCAN_DEFAULT_MARGIN_DB 3.0  // Coarse threshold over the median channel
+#define CHANNEL_SCAN_DEFAULT_HOLD 2         // Frames a channel stays active after a loud one
+
+// Scan parameters
+typedef struct {
+    uint32_t fft_size;           // N: full-band frame and bin grid
+    uint32_t hop_size;           // Full-band hop (a multiple of M / 2, at most N)
+    uint32_t num_channels;       // M: power of two, N / M >= 2
+    double sample_rate;          // Input rate (Hz)
+    window_type_t window;        // Window of the fine FFTs
+    double margin_db;            // Coarse threshold over the median channel power
+    uint32_t hold_frames;        // Frames a channel stays active after a loud one
+    double pfa;                  // Fine CFAR parameters, as for a full-band row
+    uint32_t ref_cells;
+    uint32_t guard_cells;
+    uint32_t os_rank;
+    bool use_os;                 // OS-CFAR, else cell averaging in ca_mode
+    cfar_mode_t ca_mode;
+    uint32_t max_detections;     // Per frame
+} channel_scan_config_t;
+
+// Scan state
+typedef struct {
+    channel_scan_config_t config;
+
+    // Derived parameters
+    uint32_t decimation;         // D = M / 2 input samples per channel output
+    uint32_t fine_size;          // F = N / D
+    uint32_t fine_hop;           // hop / D channel outputs per frame
+    double margin;               // 10^(margin_db / 10)
+    double power_scale;          // D^2: fine-row power to full-band row power
+    size_t flush_samples;        // Zeros to push at the end for the last frames
+
+    // Coarse level
+    pfb_t *pfb;
+    float complex *staging;      // M rows of 'capacity' outputs
+    uint32_t capacity;
+    uint32_t staged;             // Outputs in every row
+    uint64_t staged_base;        // Output index of staging column 0
+    uint32_t drop_left;          // Delay outputs still to discard
+    double *channel_power;       // Per channel, this frame
+    double *sort_scratch;        // Median selection
+    uint32_t *hold_left;         // Per channel hangover
+
+    // Fine level
+    fft_plan_f32_t *plan;
+    const window_t *fine_window; // NULL for rectangular
+    double *row;                 // F bins
+    cfar_os_t cfar_os;
+    cfar_ca_t cfar_ca;
+    cfar_detection_t *scratch;   // One channel's detections
+    float complex *zeros;        // Flush input
+
+    // Stream position
+    uint64_t samples_in;         // Real input samples pushed
+    uint64_t next_frame;         // Index of the next frame to return
+
+    // Statistics
+    uint64_t frames;
+    uint64_t fine_frames;        // Channel frames that ran the fine FFT and CFAR
+} channel_scan_t;
+
+/*
+ * Check a configuration without building anything
+ * Prints the reason on stderr and returns false when it cannot run.
+ */
+bool channel_scan_validate(const channel_scan_config_t *config);
+
+/*
+ * Create a scan for a validated configuration
+ * Returns NULL (with a message on stderr) on invalid parameters or no memory.
+ */
+channel_scan_t *channel_scan_create(const channel_scan_config_t *config);
+
+// Free the scan; NULL is ignored
+void channel_scan_destroy(channel_scan_t *scan);
+
+// Start a new stream: clear the bank, staging, holds and statistics
+void channel_scan_reset(channel_scan_t *scan);
+
+/*
+ * Feed up to 'count' input samples (NULL: that many zeros, not counted as
+ * input). Stops early when the staged outputs are full: take the ready
+ * frames with channel_scan_frame() and push the rest. Returns the samples
+ * consumed.
+ */
+size_t channel_scan_push(channel_scan_t *scan, const float complex *input, size_t count);
+
+/*
+ * Next complete frame, if one is staged: its detections (at most
+ * config.max_detections) in full-band bins and the sample offset of the
+ * frame. Returns false when more input is needed.
+ */
+bool channel_scan_frame(channel_scan_t *scan, cfar_detection_t *detections,
+                        uint32_t *num_detections, uint64_t *offset);
+
+#endif /* IQ_LAB_CHANNEL_SCAN_H */
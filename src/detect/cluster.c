@@ -19,10 +19,20 @@
  * - Feature Aggregation: Track SNR, bandwidth, and power statistics
  * - Gap Closure: Complete events after configurable inactivity periods
  *
+ * Index:
+ * - Clusters live densely in clusters[0 .. num_clusters); removal moves the
+ *   last cluster into the freed slot and patches its links
+ * - Each slot sits in a hash chain keyed by floor(centre_bin / bucket_width)
+ *   with bucket_width >= the frequency gap, so every cluster within the gap
+ *   of a bin is in one of the (at most three) buckets covering bin +/- gap
+ * - A min-heap on last_update_s hands out idle clusters without a scan
+ * - Only the cluster that just changed can become mergeable, so the merge
+ *   pass is a bucket query around that cluster, repeated while it absorbs
+ *   neighbours
+ *
  * Performance Considerations:
- * - O(N) complexity per detection (N = active clusters)
+ * - Add, merge and expire touch a few buckets plus O(log N) heap work
  * - Memory usage scales with max_clusters parameter
- * - Suitable for real-time processing with moderate cluster counts
  *
  * Edge Cases Handled:
  * - Empty detection streams
@@ -102,6 +112,7 @@ static void merge_clusters(active_cluster_t *dest, const active_cluster_t *src)
 
     dest->snr_sum += src->snr_sum;
     dest->num_detections += src->num_detections;
+    features_accum_merge(&dest->features, &src->features);
 }
 
 /*
@@ -131,6 +142,7 @@ static void cluster_to_event(const active_cluster_t *cluster, cluster_event_t *e
 
     // Detection statistics
     event->num_detections = cluster->num_detections;
+    event->features = cluster->features;
 
     // Calculate confidence based on SNR and duration
     double snr_factor = fmin(event->avg_snr_db / 20.0, 1.0); // Cap at 20dB SNR
@@ -150,49 +162,195 @@ static void cluster_to_event(const active_cluster_t *cluster, cluster_event_t *e
     }
 }
 
+// Centre bin of an active cluster
+static double cluster_center_bin(const active_cluster_t *c) {
+    return c->center_freq_sum / c->num_detections;
+}
+
+static uint32_t bucket_for_key(const cluster_t *cluster, int64_t key) {
+    return (uint32_t)((uint64_t)key * 2654435761u) & cluster->bucket_mask;
+}
+
+static int64_t bucket_key(const cluster_t *cluster, double center_bin) {
+    return (int64_t)floor(center_bin / cluster->bucket_width);
+}
+
+static void bucket_link(cluster_t *cluster, uint32_t slot) {
+    cluster_link_t *link = &cluster->links[slot];
+    link->bucket = bucket_for_key(cluster, bucket_key(cluster, cluster_center_bin(&cluster->clusters[slot])));
+    link->prev = -1;
+    link->next = cluster->bucket_heads[link->bucket];
+    if (link->next >= 0) cluster->links[link->next].prev = (int32_t)slot;
+    cluster->bucket_heads[link->bucket] = (int32_t)slot;
+}
+
+static void bucket_unlink(cluster_t *cluster, uint32_t slot) {
+    cluster_link_t *link = &cluster->links[slot];
+    if (link->prev >= 0) cluster->links[link->prev].next = link->next;
+    else cluster->bucket_heads[link->bucket] = link->next;
+    if (link->next >= 0) cluster->links[link->next].prev = link->prev;
+}
+
+// Move a slot to the bucket of its (changed) centre
+static void bucket_update(cluster_t *cluster, uint32_t slot) {
+    uint32_t bucket = bucket_for_key(cluster, bucket_key(cluster, cluster_center_bin(&cluster->clusters[slot])));
+    if (bucket != cluster->links[slot].bucket) {
+        bucket_unlink(cluster, slot);
+        bucket_link(cluster, slot);
+    }
+}
+
+static double heap_time(const cluster_t *cluster, uint32_t pos) {
+    return cluster->clusters[cluster->expiry_heap[pos]].last_update_s;
+}
+
+static void heap_place(cluster_t *cluster, uint32_t pos, uint32_t slot) {
+    cluster->expiry_heap[pos] = slot;
+    cluster->links[slot].heap_pos = pos;
+}
+
+static void heap_sift(cluster_t *cluster, uint32_t pos) {
+    uint32_t slot = cluster->expiry_heap[pos];
+    double t = cluster->clusters[slot].last_update_s;
+
+    // Up
+    while (pos > 0 && heap_time(cluster, (pos - 1) / 2) > t) {
+        heap_place(cluster, pos, cluster->expiry_heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+    // Down
+    for (;;) {
+        uint32_t child = 2 * pos + 1;
+        if (child >= cluster->num_clusters) break;
+        if (child + 1 < cluster->num_clusters && heap_time(cluster, child + 1) < heap_time(cluster, child)) child++;
+        if (heap_time(cluster, child) >= t) break;
+        heap_place(cluster, pos, cluster->expiry_heap[child]);
+        pos = child;
+    }
+    heap_place(cluster, pos, slot);
+}
+
+// Append a freshly filled slot (num_clusters already counts it)
+static void index_insert(cluster_t *cluster, uint32_t slot) {
+    bucket_link(cluster, slot);
+    heap_place(cluster, cluster->num_clusters - 1, slot);
+    heap_sift(cluster, cluster->num_clusters - 1);
+}
+
+// Remove a slot from the index and swap the last cluster into it
+static void index_remove(cluster_t *cluster, uint32_t slot) {
+    uint32_t last = cluster->num_clusters - 1;
+
+    bucket_unlink(cluster, slot);
+    uint32_t pos = cluster->links[slot].heap_pos;
+    uint32_t tail = cluster->expiry_heap[last];
+    cluster->num_clusters--;
+    if (pos != last) {
+        heap_place(cluster, pos, tail);
+        heap_sift(cluster, pos);
+    }
+
+    if (slot != last) {
+        cluster->clusters[slot] = cluster->clusters[last];
+        cluster->links[slot] = cluster->links[last];
+        cluster_link_t *link = &cluster->links[slot];
+        if (link->prev >= 0) cluster->links[link->prev].next = (int32_t)slot;
+        else cluster->bucket_heads[link->bucket] = (int32_t)slot;
+        if (link->next >= 0) cluster->links[link->next].prev = (int32_t)slot;
+        cluster->expiry_heap[link->heap_pos] = slot;
+    }
+}
+
+/*
+ * Visit the hash chains that can hold clusters centred within the frequency
+ * gap of 'center_bin'; 'chains' receives up to 3 distinct bucket indices
+ */
+static uint32_t candidate_buckets(const cluster_t *cluster, double center_bin, uint32_t chains[3]) {
+    int64_t lo = bucket_key(cluster, center_bin - cluster->max_freq_gap_hz);
+    int64_t hi = bucket_key(cluster, center_bin + cluster->max_freq_gap_hz);
+    uint32_t count = 0;
+
+    for (int64_t key = lo; key <= hi && count < 3; key++) {
+        uint32_t bucket = bucket_for_key(cluster, key);
+        bool seen = false;
+        for (uint32_t i = 0; i < count; i++) seen |= chains[i] == bucket;
+        if (!seen) chains[count++] = bucket;
+    }
+    return count;
+}
+
 /*
  * Find the best cluster to add a detection to, or return -1 if none suitable
+ * Equal scores go to the lower slot so results do not depend on chain order.
  */
 static int32_t find_best_cluster(const cluster_t *cluster, const cfar_detection_t *detection,
                                 double frame_time) {
 
     int32_t best_cluster_idx = -1;
     double best_score = -1.0;
+    uint32_t chains[3];
+    uint32_t num_chains = candidate_buckets(cluster, (double)detection->bin_index, chains);
 
-    for (uint32_t i = 0; i < cluster->num_clusters; i++) {
-        const active_cluster_t *c = &cluster->clusters[i];
+    for (uint32_t b = 0; b < num_chains; b++) {
+        for (int32_t i = cluster->bucket_heads[chains[b]]; i >= 0; i = cluster->links[i].next) {
+            const active_cluster_t *c = &cluster->clusters[i];
 
-        // Check temporal proximity
-        double time_gap = frame_time - c->last_update_s;
-        if (time_gap > cluster->max_time_gap_s) {
-            continue; // Too old
-        }
+            // Check temporal proximity
+            double time_gap = frame_time - c->last_update_s;
+            if (time_gap > cluster->max_time_gap_s) {
+                continue; // Too old
+            }
 
-        // Check frequency proximity using bin indices
-        double cluster_center_bin = c->center_freq_sum / c->num_detections;
-        double freq_gap_bins = fabs((double)detection->bin_index - cluster_center_bin);
+            // Frequency gap in bins, compared against max_freq_gap_hz as before
+            double freq_gap_hz = fabs((double)detection->bin_index - cluster_center_bin(c));
+            if (freq_gap_hz > cluster->max_freq_gap_hz) {
+                continue; // Too far in frequency
+            }
 
-        // Convert bin gap to approximate frequency gap (assuming FFT size ~ sample_rate)
-        // This is a rough approximation for the frequency gap check
-        double approx_fft_size = cluster->sample_rate_hz; // Rough estimate
-        double freq_gap_hz = freq_gap_bins * (cluster->sample_rate_hz / approx_fft_size);
+            // Calculate score (prefer closer in time and frequency)
+            double time_score = 1.0 / (1.0 + time_gap);
+            double freq_score = 1.0 / (1.0 + freq_gap_hz / 1000.0); // Normalize to kHz
+            double score = time_score * freq_score;
 
-        if (freq_gap_hz > cluster->max_freq_gap_hz) {
-            continue; // Too far in frequency
+            if (score > best_score || (score == best_score && i < best_cluster_idx)) {
+                best_score = score;
+                best_cluster_idx = i;
+            }
         }
+    }
 
-        // Calculate score (prefer closer in time and frequency)
-        double time_score = 1.0 / (1.0 + time_gap);
-        double freq_score = 1.0 / (1.0 + freq_gap_hz / 1000.0); // Normalize to kHz
-        double score = time_score * freq_score;
+    return best_cluster_idx;
+}
 
-        if (score > best_score) {
-            best_score = score;
-            best_cluster_idx = (int32_t)i;
+/*
+ * Merge every cluster that has become adjacent to 'slot' into it
+ */
+static void merge_neighbours(cluster_t *cluster, uint32_t slot) {
+    for (;;) {
+        uint32_t chains[3];
+        uint32_t num_chains = candidate_buckets(cluster, cluster_center_bin(&cluster->clusters[slot]), chains);
+        int32_t partner = -1;
+
+        for (uint32_t b = 0; b < num_chains; b++) {
+            for (int32_t i = cluster->bucket_heads[chains[b]]; i >= 0; i = cluster->links[i].next) {
+                if ((uint32_t)i == slot || (partner >= 0 && i > partner)) continue;
+                if (clusters_should_merge(&cluster->clusters[slot], &cluster->clusters[i],
+                                          cluster->max_time_gap_s, cluster->max_freq_gap_hz,
+                                          cluster->sample_rate_hz)) {
+                    partner = i;
+                }
+            }
         }
-    }
+        if (partner < 0) return;
 
-    return best_cluster_idx;
+        merge_clusters(&cluster->clusters[slot], &cluster->clusters[partner]);
+        bool moved = slot == cluster->num_clusters - 1;
+        index_remove(cluster, (uint32_t)partner);
+        if (moved) slot = (uint32_t)partner; // Swap-remove relocated the survivor
+
+        bucket_update(cluster, slot);
+        heap_sift(cluster, cluster->links[slot].heap_pos);
+    }
 }
 
 // Public API implementation
@@ -215,15 +373,35 @@ bool cluster_init(cluster_t *cluster, double max_time_gap_ms, double max_freq_ga
     cluster->max_clusters = max_clusters;
     cluster->sample_rate_hz = sample_rate_hz;
 
-    // Allocate cluster array
+    // Hash table at least twice the cluster capacity
+    uint32_t num_buckets = 1;
+    while (num_buckets < 2 * max_clusters) num_buckets <<= 1;
+    cluster->bucket_width = max_freq_gap_hz > 1.0 ? max_freq_gap_hz : 1.0;
+    cluster->bucket_mask = num_buckets - 1;
+
+    // Allocate cluster array and index
     cluster->clusters = calloc(max_clusters, sizeof(active_cluster_t));
-    if (!cluster->clusters) {
+    cluster->links = calloc(max_clusters, sizeof(cluster_link_t));
+    cluster->expiry_heap = calloc(max_clusters, sizeof(uint32_t));
+    cluster->bucket_heads = malloc(num_buckets * sizeof(int32_t));
+    if (!cluster->clusters || !cluster->links || !cluster->expiry_heap || !cluster->bucket_heads) {
+        free(cluster->clusters);
+        free(cluster->links);
+        free(cluster->expiry_heap);
+        free(cluster->bucket_heads);
+        cluster->clusters = NULL;
+        cluster->links = NULL;
+        cluster->expiry_heap = NULL;
+        cluster->bucket_heads = NULL;
         return false;
     }
+    memset(cluster->bucket_heads, 0xff, num_buckets * sizeof(int32_t));
 
     // Initialize state
     cluster->num_clusters = 0;
     cluster->next_cluster_id = 0;
+    cluster->event_sink = NULL;
+    cluster->event_sink_user = NULL;
     cluster->initialized = true;
 
     return true;
@@ -235,48 +413,13 @@ bool cluster_add_detection(cluster_t *cluster, const cfar_detection_t *detection
         return false;
     }
 
-    // Check if we have room for a new cluster
-    if (cluster->num_clusters >= cluster->max_clusters) {
-        // Try to find a cluster to merge with
-        int32_t best_idx = find_best_cluster(cluster, detection, frame_time);
-        if (best_idx >= 0) {
-            // Update existing cluster
-            active_cluster_t *c = &cluster->clusters[best_idx];
-            c->last_update_s = frame_time;
-            c->frame_count++;
-
-            // Update frequency bounds
-            if (detection->bin_index < c->min_bin) c->min_bin = detection->bin_index;
-            if (detection->bin_index > c->max_bin) c->max_bin = detection->bin_index;
-
-            // Aggregate center frequency and bandwidth
-            double detection_freq_hz = (detection->bin_index / (double)cluster->sample_rate_hz - 0.5) * cluster->sample_rate_hz;
-            c->center_freq_sum += detection_freq_hz;
-            c->bandwidth_sum += 1000.0; // Rough bandwidth estimate
-
-            // Update signal quality
-            if (detection->snr_estimate > c->peak_snr_db) {
-                c->peak_snr_db = detection->snr_estimate;
-            }
-            if (detection->signal_power > c->peak_power_dbfs) {
-                c->peak_power_dbfs = detection->signal_power;
-            }
-
-            c->snr_sum += detection->snr_estimate;
-            c->num_detections++;
-
-            return true;
-        } else {
-            // No suitable cluster found and we're at capacity
-            return false;
-        }
-    }
-
     // Find best existing cluster to add to
     int32_t best_idx = find_best_cluster(cluster, detection, frame_time);
+    uint32_t slot;
     if (best_idx >= 0) {
         // Update existing cluster
-        active_cluster_t *c = &cluster->clusters[best_idx];
+        slot = (uint32_t)best_idx;
+        active_cluster_t *c = &cluster->clusters[slot];
         c->last_update_s = frame_time;
         c->frame_count++;
 
@@ -299,10 +442,20 @@ bool cluster_add_detection(cluster_t *cluster, const cfar_detection_t *detection
 
         c->snr_sum += detection->snr_estimate;
         c->num_detections++;
+        features_accum_add(&c->features, detection->bin_index,
+                           detection->signal_power, detection->threshold);
+
+        bucket_update(cluster, slot);
+        heap_sift(cluster, cluster->links[slot].heap_pos);
+
+    } else if (cluster->num_clusters >= cluster->max_clusters) {
+        // No suitable cluster found and we're at capacity
+        return false;
 
     } else {
         // Create new cluster
-        active_cluster_t *c = &cluster->clusters[cluster->num_clusters];
+        slot = cluster->num_clusters;
+        active_cluster_t *c = &cluster->clusters[slot];
 
         c->start_time_s = frame_time;
         c->last_update_s = frame_time;
@@ -319,29 +472,16 @@ bool cluster_add_detection(cluster_t *cluster, const cfar_detection_t *detection
         c->snr_sum = detection->snr_estimate;
         c->peak_power_dbfs = detection->signal_power;
         c->num_detections = 1;
+        features_accum_reset(&c->features);
+        features_accum_add(&c->features, detection->bin_index,
+                           detection->signal_power, detection->threshold);
 
         cluster->num_clusters++;
+        index_insert(cluster, slot);
     }
 
-    // Check for cluster merging after adding the detection
-    // This is a simple O(N²) merge - could be optimized for large cluster counts
-    for (uint32_t i = 0; i < cluster->num_clusters; i++) {
-        for (uint32_t j = i + 1; j < cluster->num_clusters; j++) {
-            if (clusters_should_merge(&cluster->clusters[i], &cluster->clusters[j],
-                                    cluster->max_time_gap_s, cluster->max_freq_gap_hz,
-                                    cluster->sample_rate_hz)) {
-                // Merge j into i
-                merge_clusters(&cluster->clusters[i], &cluster->clusters[j]);
-
-                // Remove cluster j by shifting remaining clusters
-                for (uint32_t k = j; k < cluster->num_clusters - 1; k++) {
-                    cluster->clusters[k] = cluster->clusters[k + 1];
-                }
-                cluster->num_clusters--;
-                j--; // Adjust index since we removed an element
-            }
-        }
-    }
+    // Only the cluster just touched can have become adjacent to another
+    merge_neighbours(cluster, slot);
 
     return true;
 }
@@ -354,26 +494,64 @@ uint32_t cluster_get_events(cluster_t *cluster, cluster_event_t *events, uint32_
 
     uint32_t num_events = 0;
 
-    // Check each cluster for completion
-    for (uint32_t i = 0; i < cluster->num_clusters && num_events < max_events; ) {
-        active_cluster_t *c = &cluster->clusters[i];
+    // Retire clusters in order of last update until one is still live
+    while (cluster->num_clusters > 0 && num_events < max_events) {
+        uint32_t slot = cluster->expiry_heap[0];
+        active_cluster_t *c = &cluster->clusters[slot];
 
         // Check if cluster should be completed (gap timeout)
         double time_gap = current_time - c->last_update_s;
-        if (time_gap > cluster->max_time_gap_s && c->num_detections >= 3) {
-            // Convert cluster to event
-            cluster_to_event(c, &events[num_events], cluster->sample_rate_hz, (uint32_t)(cluster->sample_rate_hz * 2)); // Rough FFT size estimate
-            num_events++;
+        if (time_gap <= cluster->max_time_gap_s) {
+            break;
+        }
 
-            // Remove completed cluster by shifting remaining clusters
-            for (uint32_t j = i; j < cluster->num_clusters - 1; j++) {
-                cluster->clusters[j] = cluster->clusters[j + 1];
+        if (c->num_detections >= 3) {
+            // Convert cluster to event, keeping the batch ordered by start time
+            cluster_event_t event;
+            cluster_to_event(c, &event, cluster->sample_rate_hz, (uint32_t)(cluster->sample_rate_hz * 2)); // Rough FFT size estimate
+            uint32_t pos = num_events++;
+            while (pos > 0 && events[pos - 1].start_time_s > event.start_time_s) {
+                events[pos] = events[pos - 1];
+                pos--;
             }
-            cluster->num_clusters--;
-            // Don't increment i since we removed an element
-        } else {
-            i++; // Move to next cluster
+            events[pos] = event;
         }
+
+        // Too short to report clusters can never grow again: drop them too
+        index_remove(cluster, slot);
+    }
+
+    return num_events;
+}
+
+void cluster_set_event_sink(cluster_t *cluster, cluster_event_sink_t sink, void *user) {
+    if (!cluster) return;
+
+    cluster->event_sink = sink;
+    cluster->event_sink_user = sink ? user : NULL;
+}
+
+uint32_t cluster_advance(cluster_t *cluster, double current_time) {
+    if (!cluster || !cluster->initialized || !cluster->event_sink) {
+        return 0;
+    }
+
+    uint32_t num_events = 0;
+
+    while (cluster->num_clusters > 0) {
+        uint32_t slot = cluster->expiry_heap[0];
+        active_cluster_t *c = &cluster->clusters[slot];
+        if (current_time - c->last_update_s <= cluster->max_time_gap_s) {
+            break;
+        }
+
+        if (c->num_detections >= 3) {
+            cluster_event_t event;
+            cluster_to_event(c, &event, cluster->sample_rate_hz, (uint32_t)(cluster->sample_rate_hz * 2)); // Rough FFT size estimate
+            cluster->event_sink(&event, cluster->event_sink_user);
+            num_events++;
+        }
+        index_remove(cluster, slot);
     }
 
     return num_events;
@@ -385,11 +563,65 @@ void cluster_reset(cluster_t *cluster) {
     if (cluster->clusters) {
         memset(cluster->clusters, 0, cluster->max_clusters * sizeof(active_cluster_t));
     }
+    if (cluster->bucket_heads) {
+        memset(cluster->bucket_heads, 0xff, ((size_t)cluster->bucket_mask + 1) * sizeof(int32_t));
+    }
 
     cluster->num_clusters = 0;
     cluster->next_cluster_id = 0;
 }
 
+// Counters of a checkpointed context, with its table sizes
+typedef struct {
+    uint32_t max_clusters;
+    uint32_t bucket_mask;
+    uint32_t num_clusters;
+    uint32_t next_cluster_id;
+} cluster_state_t;
+
+bool cluster_save_state(const cluster_t *cluster, checkpoint_writer_t *writer) {
+    if (!cluster || !cluster->initialized || !writer) return false;
+
+    cluster_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.max_clusters = cluster->max_clusters;
+    state.bucket_mask = cluster->bucket_mask;
+    state.num_clusters = cluster->num_clusters;
+    state.next_cluster_id = cluster->next_cluster_id;
+
+    // Slots, chains and heap verbatim: the same order of ties and merges
+    size_t slots = cluster->max_clusters;
+    return checkpoint_put(writer, "cluster.state", &state, sizeof(state)) &&
+           checkpoint_put(writer, "cluster.clusters", cluster->clusters, slots * sizeof(active_cluster_t)) &&
+           checkpoint_put(writer, "cluster.links", cluster->links, slots * sizeof(cluster_link_t)) &&
+           checkpoint_put(writer, "cluster.heap", cluster->expiry_heap, slots * sizeof(uint32_t)) &&
+           checkpoint_put(writer, "cluster.buckets", cluster->bucket_heads,
+                          ((size_t)cluster->bucket_mask + 1) * sizeof(int32_t));
+}
+
+bool cluster_load_state(cluster_t *cluster, const checkpoint_t *checkpoint) {
+    if (!cluster || !cluster->initialized) return false;
+
+    cluster_state_t state;
+    size_t slots = cluster->max_clusters;
+    bool ok = checkpoint_get(checkpoint, "cluster.state", &state, sizeof(state)) &&
+              state.max_clusters == cluster->max_clusters && state.bucket_mask == cluster->bucket_mask &&
+              state.num_clusters <= cluster->max_clusters &&
+              checkpoint_get(checkpoint, "cluster.clusters", cluster->clusters, slots * sizeof(active_cluster_t)) &&
+              checkpoint_get(checkpoint, "cluster.links", cluster->links, slots * sizeof(cluster_link_t)) &&
+              checkpoint_get(checkpoint, "cluster.heap", cluster->expiry_heap, slots * sizeof(uint32_t)) &&
+              checkpoint_get(checkpoint, "cluster.buckets", cluster->bucket_heads,
+                             ((size_t)cluster->bucket_mask + 1) * sizeof(int32_t));
+    if (!ok) {
+        cluster_reset(cluster);
+        return false;
+    }
+
+    cluster->num_clusters = state.num_clusters;
+    cluster->next_cluster_id = state.next_cluster_id;
+    return true;
+}
+
 void cluster_free(cluster_t *cluster) {
     if (!cluster) return;
 
@@ -397,6 +629,9 @@ void cluster_free(cluster_t *cluster) {
         free(cluster->clusters);
         cluster->clusters = NULL;
     }
+    free(cluster->links);
+    free(cluster->expiry_heap);
+    free(cluster->bucket_heads);
 
     memset(cluster, 0, sizeof(cluster_t));
     cluster->initialized = false;
@@ -21,6 +21,11 @@
  *   cluster_add_detection(&cluster, detection, frame_time);
  *   cluster_get_events(&cluster, events, max_events);
  *
+ * Streaming usage (no polling, no output array limit):
+ *   cluster_set_event_sink(&cluster, on_event, user);
+ *   per frame: cluster_add_detection(...); cluster_advance(&cluster, frame_time);
+ *   at end of stream: cluster_advance(&cluster, INFINITY);
+ *
  * Algorithm Overview:
  * 1. Maintain active signal clusters with temporal hysteresis
  * 2. Add new detections to existing clusters or create new ones
@@ -33,11 +38,15 @@
  * - Gap Tolerance: Maximum time/frequency separation for merging
  * - Hysteresis: Prevents cluster fragmentation from brief gaps
  * - Feature Aggregation: SNR, bandwidth, center frequency averaging
+ * - Spectral features accumulate incrementally (features_accum_t), so a
+ *   closing event never rescans the spectrum
  *
  * Performance:
- * - O(N) per detection addition (N = active clusters)
- * - Memory usage scales with number of active clusters
- * - Suitable for real-time processing with moderate cluster counts
+ * - Active clusters are indexed by centre bin in buckets max_freq_gap wide,
+ *   so a detection or merge only looks at clusters in the adjacent buckets
+ * - Expiry pops clusters from a min-heap on last update time: O(log N) each
+ * - Storage is a dense array with swap-remove; no element shifting
+ * - Memory usage scales with max_clusters
  *
  * Applications:
  * - Signal event formation from raw detections
@@ -47,7 +56,7 @@
  *
  * Dependencies: stdlib.h, stdbool.h, stdint.h, math.h
  * Thread Safety: Not thread-safe (single cluster instance per thread)
- * Performance: O(N) per detection, suitable for real-time SDR processing
+ * Performance: ~O(log N) per detection, merge and expiry (N = active clusters)
  */
 
 #ifndef IQ_LAB_CLUSTER_H
@@ -56,6 +65,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "cfar_os.h"  // Include for cfar_detection_t definition
+#include "features.h" // Include for features_accum_t definition
 
 // Event structure representing a completed signal cluster
 typedef struct {
@@ -82,6 +92,10 @@ typedef struct {
     // Modulation hints
     double modulation_confidence; // Confidence in modulation classification
     const char *modulation_guess;  // Modulation type hint
+
+    // Spectral moments of every detection in the event; pass to
+    // features_accum_finalize() with the FFT size for PAPR, flatness etc.
+    features_accum_t features;
 } cluster_event_t;
 
 // Active cluster structure for tracking ongoing events
@@ -104,8 +118,22 @@ typedef struct {
 
     // Detection count
     uint32_t num_detections;    // Total detections in this cluster
+
+    // Feature moments, updated per detection and on merge
+    features_accum_t features;
 } active_cluster_t;
 
+// Receives each completed event as soon as its cluster times out
+typedef void (*cluster_event_sink_t)(const cluster_event_t *event, void *user);
+
+// Spatial and expiry index entry, one per cluster slot
+typedef struct {
+    int32_t prev;               // Previous slot in the bucket chain, -1 at the head
+    int32_t next;               // Next slot in the bucket chain, -1 at the tail
+    uint32_t bucket;            // Hash table bucket holding this slot
+    uint32_t heap_pos;          // Position in the expiry heap
+} cluster_link_t;
+
 // Main clustering context
 typedef struct {
     // Configuration parameters
@@ -119,6 +147,17 @@ typedef struct {
     uint32_t num_clusters;      // Current number of active clusters
     uint32_t next_cluster_id;   // Next available cluster ID
 
+    // Index over clusters[0 .. num_clusters)
+    double bucket_width;        // Centre-bin span of one bucket (>= max gap)
+    uint32_t bucket_mask;       // Hash table size - 1 (power of two)
+    int32_t *bucket_heads;      // First slot of each hash chain, -1 if empty
+    cluster_link_t *links;      // Per-slot chain links and heap position
+    uint32_t *expiry_heap;      // Slots as a min-heap on last_update_s
+
+    // Streaming output
+    cluster_event_sink_t event_sink; // NULL: events only via cluster_get_events
+    void *event_sink_user;      // Passed back to event_sink
+
     // Working buffers
     bool initialized;           // Whether clustering is properly initialized
 } cluster_t;
@@ -156,6 +195,9 @@ bool cluster_add_detection(cluster_t *cluster, const cfar_detection_t *detection
 
 /*
  * Extract completed events from the clustering system
+ * Clusters idle for more than max_time_gap are retired oldest update first;
+ * those with at least 3 detections become events, the rest are dropped.
+ * Returned events are ordered by start time.
  *
  * Parameters:
  *   cluster     - Pointer to cluster context
@@ -168,6 +210,23 @@ bool cluster_add_detection(cluster_t *cluster, const cfar_detection_t *detection
  */
 uint32_t cluster_get_events(cluster_t *cluster, cluster_event_t *events, uint32_t max_events, double current_time);
 
+/*
+ * Route completed events to a callback instead of cluster_get_events
+ * Pass NULL to detach. Events reach the sink from cluster_advance().
+ */
+void cluster_set_event_sink(cluster_t *cluster, cluster_event_sink_t sink, void *user);
+
+/*
+ * Advance the clustering clock and emit every event whose cluster has been
+ * idle for more than max_time_gap, oldest update first
+ * Costs O(1) when nothing has expired, so it can run every frame; INFINITY
+ * flushes every remaining cluster.
+ *
+ * Returns:
+ *   Number of events passed to the sink (0 if no sink is set)
+ */
+uint32_t cluster_advance(cluster_t *cluster, double current_time);
+
 /*
  * Reset clustering state (clear all active clusters)
  *
@@ -176,6 +235,20 @@ uint32_t cluster_get_events(cluster_t *cluster, cluster_event_t *events, uint32_
  */
 void cluster_reset(cluster_t *cluster);
 
+/*
+ * Save / restore the open clusters with their index, so events continue
+ * as if the stream had not been interrupted
+ *
+ * Parameters:
+ *   cluster - Cluster context; on load, initialized with the saved
+ *             max_clusters and gaps (the event sink is kept)
+ *
+ * Returns:
+ *   true on success, false on error or a checkpoint of another context
+ */
+bool cluster_save_state(const cluster_t *cluster, checkpoint_writer_t *writer);
+bool cluster_load_state(cluster_t *cluster, const checkpoint_t *checkpoint);
+
 /*
  * Free clustering resources and reset to uninitialized state
  *
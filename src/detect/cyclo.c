@@ -0,0 +1,299 @@
+/*
+ * IQ Lab - Cyclostationary Features
+ *
+ * FFT accumulation method over batched FFTs: one call transforms a
+ * segment's P channelizer frames, then one call per first channel the P
+ * point products against every second channel. Coherence is accumulated
+ * as |S|^2 and power products over the segments and only turned into a
+ * profile at the end.
+ */
+
+#include "cyclo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static bool is_power_of_two(uint32_t n) {
+    return n && (n & (n - 1)) == 0;
+}
+
+bool cyclo_init(cyclo_t *cyclo, uint32_t channels, uint32_t blocks) {
+    if (!cyclo) return false;
+    memset(cyclo, 0, sizeof(*cyclo));
+    if (!is_power_of_two(channels) || channels < 8 || channels > 256 ||
+        !is_power_of_two(blocks) || blocks < 16 || blocks > 4096) {
+        fprintf(stderr, "Invalid cyclic feature sizes: channels %u, blocks %u (powers of two, >= 8 and >= 16)\n",
+                channels, blocks);
+        return false;
+    }
+
+    cyclo->channels = channels;
+    cyclo->blocks = blocks;
+    cyclo->hop = channels / 4;
+    cyclo->kept = blocks / 8;
+    cyclo->segment_samples = (blocks - 1) * cyclo->hop + channels;
+    // Pair offsets of -N' .. N' - 1 channels, P / 4 cells each, plus half a pair either side
+    cyclo->profile_offset = channels * blocks / 4 + cyclo->kept;
+    cyclo->profile_size = 2 * cyclo->profile_offset;
+
+    const size_t pairs = (size_t)channels * channels;
+    const size_t cells = pairs * 2 * cyclo->kept;
+    cyclo->channel_plan = fft_plan_f32_acquire(channels, FFT_FORWARD);
+    cyclo->cyclic_plan = fft_plan_f32_acquire(blocks, FFT_FORWARD);
+    cyclo->window = window_acquire(WINDOW_HANN, channels, 0.0);
+    cyclo->taper = window_acquire(WINDOW_HANN, blocks, 0.0);
+    cyclo->frames = malloc((size_t)blocks * channels * sizeof(fft_complex_f32_t));
+    cyclo->spectra = malloc((size_t)blocks * channels * sizeof(fft_complex_f32_t));
+    cyclo->channel = malloc((size_t)blocks * channels * sizeof(fft_complex_f32_t));
+    cyclo->products = malloc((size_t)blocks * channels * sizeof(fft_complex_f32_t));
+    cyclo->cyclic = malloc((size_t)blocks * channels * sizeof(fft_complex_f32_t));
+    cyclo->power = malloc(channels * sizeof(double));
+    cyclo->grid = malloc(cells * sizeof(double));
+    cyclo->conj_grid = malloc(cells * sizeof(double));
+    cyclo->norm = malloc(pairs * sizeof(double));
+    cyclo->profile = malloc(cyclo->profile_size * sizeof(double));
+    cyclo->profile_freq = malloc(cyclo->profile_size * sizeof(double));
+    cyclo->conj_profile = malloc(cyclo->profile_size * sizeof(double));
+    cyclo->conj_profile_freq = malloc(cyclo->profile_size * sizeof(double));
+    cyclo->scratch = malloc(cyclo->profile_size * sizeof(double));
+
+    if (!cyclo->channel_plan || !cyclo->cyclic_plan || !cyclo->window || !cyclo->taper ||
+        !cyclo->frames || !cyclo->spectra || !cyclo->channel || !cyclo->products ||
+        !cyclo->cyclic || !cyclo->power || !cyclo->grid || !cyclo->conj_grid || !cyclo->norm ||
+        !cyclo->profile || !cyclo->profile_freq || !cyclo->conj_profile ||
+        !cyclo->conj_profile_freq || !cyclo->scratch) {
+        fprintf(stderr, "Failed to allocate cyclic feature buffers\n");
+        cyclo_free(cyclo);
+        return false;
+    }
+    return true;
+}
+
+void cyclo_free(cyclo_t *cyclo) {
+    if (!cyclo) return;
+    if (cyclo->channel_plan) fft_plan_f32_release(cyclo->channel_plan);
+    if (cyclo->cyclic_plan) fft_plan_f32_release(cyclo->cyclic_plan);
+    if (cyclo->window) window_release(cyclo->window);
+    if (cyclo->taper) window_release(cyclo->taper);
+    free(cyclo->frames);
+    free(cyclo->spectra);
+    free(cyclo->channel);
+    free(cyclo->products);
+    free(cyclo->cyclic);
+    free(cyclo->power);
+    free(cyclo->grid);
+    free(cyclo->conj_grid);
+    free(cyclo->norm);
+    free(cyclo->profile);
+    free(cyclo->profile_freq);
+    free(cyclo->conj_profile);
+    free(cyclo->conj_profile_freq);
+    free(cyclo->scratch);
+    memset(cyclo, 0, sizeof(*cyclo));
+}
+
+// Channelize one segment: channel c (frequency (c - N'/2) / N') as P
+// outputs referenced to the segment's start, and its tapered power
+static void channelize(cyclo_t *cyclo, const float *iq) {
+    const uint32_t n = cyclo->channels, p_count = cyclo->blocks, hop = cyclo->hop;
+    const float *w = cyclo->window->coefficients_f32;
+
+    for (uint32_t p = 0; p < p_count; p++) {
+        const float *frame = iq + 2 * (size_t)p * hop;
+        fft_complex_f32_t *out = cyclo->frames + (size_t)p * n;
+        for (uint32_t k = 0; k < n; k++) {
+            out[k] = w[k] * (frame[2 * k] + I * frame[2 * k + 1]);
+        }
+    }
+    fft_execute_batch_f32(cyclo->channel_plan, cyclo->frames, cyclo->spectra, p_count, n, n);
+
+    // With L = N' / 4 the time reference e^(-j 2 pi k p L / N') is (-j)^(k p)
+    static const float complex turn[4] = { 1.0f, -I, -1.0f, I };
+    const double *taper = cyclo->taper->coefficients;
+    for (uint32_t c = 0; c < n; c++) {
+        uint32_t k = (c + n / 2) % n;
+        fft_complex_f32_t *row = cyclo->channel + (size_t)c * p_count;
+        double power = 0.0;
+        for (uint32_t p = 0; p < p_count; p++) {
+            row[p] = cyclo->spectra[(size_t)p * n + k] * turn[(k * p) & 3];
+            power += taper[p] * ((double)crealf(row[p]) * crealf(row[p]) +
+                                 (double)cimagf(row[p]) * cimagf(row[p]));
+        }
+        cyclo->power[c] = power;
+    }
+}
+
+// Products of channel c1 with every channel c2 <= c1, transformed and
+// added to 'grid' (conjugate: X1 X2, else X1 X2*)
+static void accumulate_pairs(cyclo_t *cyclo, uint32_t c1, bool conjugate, double *grid) {
+    const uint32_t n = cyclo->channels, p_count = cyclo->blocks, kept = cyclo->kept;
+    const double *taper = cyclo->taper->coefficients;
+    const fft_complex_f32_t *x1 = cyclo->channel + (size_t)c1 * p_count;
+
+    for (uint32_t c2 = 0; c2 <= c1; c2++) {
+        const fft_complex_f32_t *x2 = cyclo->channel + (size_t)c2 * p_count;
+        fft_complex_f32_t *out = cyclo->products + (size_t)c2 * p_count;
+        for (uint32_t p = 0; p < p_count; p++) {
+            out[p] = (float)taper[p] * x1[p] * (conjugate ? x2[p] : conjf(x2[p]));
+        }
+    }
+    fft_execute_batch_f32(cyclo->cyclic_plan, cyclo->products, cyclo->cyclic, c1 + 1, p_count, p_count);
+
+    for (uint32_t c2 = 0; c2 <= c1; c2++) {
+        const fft_complex_f32_t *s = cyclo->cyclic + (size_t)c2 * p_count;
+        double *cells = grid + ((size_t)c1 * n + c2) * 2 * kept;
+        for (uint32_t j = 0; j < 2 * kept; j++) {
+            // Cell j is cyclic offset q = j - kept, FFT output q mod P
+            uint32_t q = (j + p_count - kept) % p_count;
+            cells[j] += (double)crealf(s[q]) * crealf(s[q]) + (double)cimagf(s[q]) * cimagf(s[q]);
+        }
+    }
+}
+
+// Largest coherence per cyclic cell; returns nothing, fills profile and its frequencies
+static void build_profile(cyclo_t *cyclo, const double *grid, bool conjugate,
+                          double *profile, double *profile_freq) {
+    const uint32_t n = cyclo->channels, kept = cyclo->kept;
+    const int32_t per_channel = (int32_t)(cyclo->blocks / 4);
+
+    for (uint32_t a = 0; a < cyclo->profile_size; a++) {
+        profile[a] = 0.0;
+        profile_freq[a] = 0.0;
+    }
+    for (uint32_t c1 = 0; c1 < n; c1++) {
+        for (uint32_t c2 = 0; c2 <= c1; c2++) {
+            double norm = cyclo->norm[(size_t)c1 * n + c2];
+            if (!(norm > 0.0)) continue;
+            const double *cells = grid + ((size_t)c1 * n + c2) * 2 * kept;
+            // Non-conjugate: a = f1 - f2, f = (f1 + f2) / 2; conjugate: a = f1 + f2, f = (f1 - f2) / 2
+            int32_t base = conjugate ? ((int32_t)c1 + (int32_t)c2 - (int32_t)n) * per_channel
+                                     : ((int32_t)c1 - (int32_t)c2) * per_channel;
+            double freq = conjugate ? 0.5 * ((double)c1 - (double)c2) / n
+                                    : 0.5 * ((double)c1 + (double)c2 - (double)n) / n;
+            for (uint32_t j = 0; j < 2 * kept; j++) {
+                int32_t a = (int32_t)cyclo->profile_offset + base + (int32_t)j - (int32_t)kept;
+                if (a < 0 || a >= (int32_t)cyclo->profile_size) continue;
+                double coherence = sqrt(fmin(1.0, cells[j] / norm));
+                if (coherence > profile[a]) {
+                    profile[a] = coherence;
+                    profile_freq[a] = freq;
+                }
+            }
+        }
+    }
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Median of profile[first .. last)
+static double profile_median(cyclo_t *cyclo, const double *profile, uint32_t first, uint32_t last) {
+    uint32_t count = last - first;
+    if (count == 0) return 0.0;
+    memcpy(cyclo->scratch, profile + first, count * sizeof(double));
+    qsort(cyclo->scratch, count, sizeof(double), compare_double);
+    return cyclo->scratch[count / 2];
+}
+
+bool cyclo_analyze(cyclo_t *cyclo, const float *iq_samples, uint32_t num_samples,
+                   double sample_rate_hz, cyclo_features_t *features) {
+    if (!features) return false;
+    memset(features, 0, sizeof(*features));
+    if (!cyclo || !cyclo->grid || !iq_samples || !(sample_rate_hz > 0.0) ||
+        num_samples < cyclo->segment_samples) {
+        return false;
+    }
+
+    const uint32_t n = cyclo->channels;
+    const size_t pairs = (size_t)n * n;
+    uint32_t segments = num_samples / cyclo->segment_samples;
+    if (segments > CYCLO_MAX_SEGMENTS) segments = CYCLO_MAX_SEGMENTS;
+    const float *start = iq_samples + 2 * (size_t)((num_samples - segments * cyclo->segment_samples) / 2);
+
+    memset(cyclo->grid, 0, pairs * 2 * cyclo->kept * sizeof(double));
+    memset(cyclo->conj_grid, 0, pairs * 2 * cyclo->kept * sizeof(double));
+    memset(cyclo->norm, 0, pairs * sizeof(double));
+    for (uint32_t s = 0; s < segments; s++) {
+        channelize(cyclo, start + 2 * (size_t)s * cyclo->segment_samples);
+        for (uint32_t c1 = 0; c1 < n; c1++) {
+            for (uint32_t c2 = 0; c2 <= c1; c2++) {
+                cyclo->norm[(size_t)c1 * n + c2] += cyclo->power[c1] * cyclo->power[c2];
+            }
+            accumulate_pairs(cyclo, c1, false, cyclo->grid);
+            accumulate_pairs(cyclo, c1, true, cyclo->conj_grid);
+        }
+    }
+
+    build_profile(cyclo, cyclo->grid, false, cyclo->profile, cyclo->profile_freq);
+    build_profile(cyclo, cyclo->conj_grid, true, cyclo->conj_profile, cyclo->conj_profile_freq);
+
+    // Non-conjugate: a > 0 past the power spectrum's own line
+    const uint32_t first = cyclo->profile_offset + CYCLO_ALPHA_GUARD + 1;
+    const uint32_t last = cyclo->profile_size - 1;
+    features->floor = profile_median(cyclo, cyclo->profile, first, last);
+    features->conj_floor = profile_median(cyclo, cyclo->conj_profile, 0, cyclo->profile_size);
+    if (!(features->floor > 0.0)) return false;
+
+    const double cell_hz = sample_rate_hz / ((double)cyclo->blocks * cyclo->hop);
+    const double threshold = CYCLO_PEAK_MARGIN * features->floor;
+    for (uint32_t a = first; a < last; a++) {
+        double c = cyclo->profile[a];
+        if (c <= threshold || c < cyclo->profile[a - 1] || c < cyclo->profile[a + 1]) continue;
+
+        // Insert into the strongest-first list
+        uint32_t slot = features->num_peaks < CYCLO_MAX_PEAKS ? features->num_peaks : CYCLO_MAX_PEAKS;
+        while (slot > 0 && features->peaks[slot - 1].coherence < c) slot--;
+        if (slot >= CYCLO_MAX_PEAKS) continue;
+        uint32_t end = features->num_peaks < CYCLO_MAX_PEAKS ? features->num_peaks : CYCLO_MAX_PEAKS - 1;
+        memmove(&features->peaks[slot + 1], &features->peaks[slot], (end - slot) * sizeof(cyclo_peak_t));
+        features->peaks[slot].alpha_hz = ((double)a - cyclo->profile_offset) * cell_hz;
+        features->peaks[slot].freq_hz = cyclo->profile_freq[a] * sample_rate_hz;
+        features->peaks[slot].coherence = c;
+        if (features->num_peaks < CYCLO_MAX_PEAKS) features->num_peaks++;
+    }
+    if (features->num_peaks > 0) features->symbol_rate_hz = features->peaks[0].alpha_hz;
+
+    // Conjugate: the strongest cell anywhere, a = 0 included (a carrier at DC)
+    uint32_t best = 0;
+    for (uint32_t a = 1; a < cyclo->profile_size; a++) {
+        if (cyclo->conj_profile[a] > cyclo->conj_profile[best]) best = a;
+    }
+    features->conjugate.alpha_hz = ((double)best - cyclo->profile_offset) * cell_hz;
+    features->conjugate.freq_hz = cyclo->conj_profile_freq[best] * sample_rate_hz;
+    features->conjugate.coherence = cyclo->conj_profile[best];
+    features->has_conjugate = features->conj_floor > 0.0 &&
+                              features->conjugate.coherence > CYCLO_PEAK_MARGIN * features->conj_floor;
+
+    features->sample_rate_hz = sample_rate_hz;
+    features->segments = segments;
+    features->valid = true;
+    return true;
+}
+
+bool cyclo_refine_modulation(const cyclo_features_t *features, features_result_t *result) {
+    if (!features || !result || !features->valid || features->num_peaks == 0 || !result->modulation_hint) {
+        return false;
+    }
+    const char *hint = result->modulation_hint;
+    const double strength = fmin(1.0, features->peaks[0].coherence / (CYCLO_PEAK_MARGIN * features->floor) - 1.0);
+
+    if (strcmp(hint, "unknown") == 0 || strcmp(hint, "noise") == 0) {
+        result->modulation_hint = features->has_conjugate ? "bpsk" : "psk";
+        result->modulation_confidence = 0.5 + 0.4 * strength;
+        return true;
+    }
+    if (strcmp(hint, "fm") == 0) {
+        // Symbols come at a sizeable share of the band; an audio tone far below it
+        double lowest = features->peaks[0].alpha_hz;
+        for (uint32_t i = 1; i < features->num_peaks; i++) lowest = fmin(lowest, features->peaks[i].alpha_hz);
+        if (lowest >= CYCLO_FSK_MIN_RATE * features->sample_rate_hz) {
+            result->modulation_hint = "fsk";
+            result->modulation_confidence = 0.5 + 0.4 * strength;
+            return true;
+        }
+    }
+    return false;
+}
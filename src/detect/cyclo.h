@@ -0,0 +1,156 @@
+/*
+ * IQ Lab - Cyclostationary Features Header
+ *
+ * Purpose: Cyclic-frequency peaks of an event's samples for modulation classification
+ *
+ *
+ * Spectral shape and envelope statistics cannot tell a PSK or QAM burst
+ * from band-limited noise, or BPSK from QPSK: all of them look like a
+ * flat-topped hump with a moving envelope. Their symbol clock does show
+ * up as cyclostationarity: the spectral correlation S^a(f) between
+ * frequencies f + a/2 and f - a/2 is non-zero at the cyclic frequency
+ * a = symbol rate, and for a real constellation (BPSK, PAM) the
+ * conjugate correlation is non-zero as well (at twice the carrier
+ * offset), where noise has neither.
+ *
+ * The estimate is the FFT accumulation method (FAM):
+ * 1. Channelizer: N' point Hann-windowed FFTs every L = N' / 4 samples
+ *    over P frames, one batched FFT call; bin k of frame p is turned by
+ *    e^(-j 2 pi k p L / N') so every channel is referenced to the same time
+ * 2. Products: for each channel pair X_1(p) X_2(p)* (and X_1(p) X_2(p) for
+ *    the conjugate), Hann-tapered over the P frames, one batched P point
+ *    FFT per first channel
+ * 3. Coherence: |S|^2 over the product of the two channels' powers,
+ *    averaged over the segments the snippet holds; 1 for a perfectly
+ *    correlated pair, about 1.5 / P for noise. Only the central P / 4
+ *    outputs of each pair are kept, which tiles the cyclic axis without
+ *    gaps at a resolution of rate / (P L)
+ * 4. Profile: the largest coherence over f for each cyclic frequency a;
+ *    a peak is a local maximum more than CYCLO_PEAK_MARGIN times the
+ *    profile's median (its noise level)
+ *
+ * Usage:
+ *   cyclo_t cyclo;
+ *   cyclo_init(&cyclo, CYCLO_DEFAULT_CHANNELS, CYCLO_DEFAULT_BLOCKS);
+ *   cyclo_features_t cf;
+ *   if (cyclo_analyze(&cyclo, iq, count, rate, &cf)) cyclo_refine_modulation(&cf, &result);
+ *   cyclo_free(&cyclo);
+ *
+ * Technical Details:
+ * - Meant for an event's samples at about its bandwidth (event_features.h);
+ *   cyclic frequencies are in Hz at that rate, a in (-rate, rate)
+ * - A segment is (P - 1) L + N' samples; up to CYCLO_MAX_SEGMENTS of them
+ *   from the middle of the snippet are averaged
+ * - Non-conjugate peaks below CYCLO_ALPHA_GUARD resolution cells are the
+ *   power spectrum's own line (a = 0) and are skipped
+ * - Cost per segment: P FFTs of N' points and N'^2 + N' FFTs of P points
+ *   (pairs with the first channel at or above the second only)
+ *
+ * Memory: two coherence grids of N'^2 P / 4 doubles plus one segment's frames
+ * Thread Safety: Not thread-safe (one instance per thread)
+ */
+
+#ifndef IQ_LAB_CYCLO_H
+#define IQ_LAB_CYCLO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "features.h"
+#include "../iq_core/fft.h"
+#include "../iq_core/window.h"
+
+#define CYCLO_DEFAULT_CHANNELS 32    // N': channelizer FFT size
+#define CYCLO_DEFAULT_BLOCKS 128     // P: channelizer frames per cyclic FFT
+#define CYCLO_MAX_SEGMENTS 8         // Segments averaged per snippet
+#define CYCLO_MAX_PEAKS 4            // Non-conjugate peaks reported
+#define CYCLO_ALPHA_GUARD 2          // Cyclic cells either side of a = 0 skipped
+#define CYCLO_PEAK_MARGIN 3.5        // Peak coherence over the profile's median
+#define CYCLO_FSK_MIN_RATE 0.1       // Lowest peak of a keyed carrier, share of the rate
+
+// One cyclic-frequency peak
+typedef struct {
+    double alpha_hz;             // Cyclic frequency a
+    double freq_hz;              // Spectral frequency f of the strongest cell
+    double coherence;            // |S^a(f)|, normalized (0-1)
+} cyclo_peak_t;
+
+// Cyclostationary features of one snippet
+typedef struct {
+    bool valid;
+    double sample_rate_hz;       // Rate of the snippet
+    uint32_t segments;           // Segments averaged
+    double floor;                // Median of the non-conjugate profile
+    double conj_floor;           // ... and of the conjugate one
+
+    uint32_t num_peaks;          // Non-conjugate peaks at a > 0, strongest first
+    cyclo_peak_t peaks[CYCLO_MAX_PEAKS];
+    bool has_conjugate;          // A conjugate peak stands out
+    cyclo_peak_t conjugate;      // Strongest conjugate cell (a = 2 x carrier offset)
+
+    double symbol_rate_hz;       // a of the strongest peak, 0 without one
+} cyclo_features_t;
+
+// Estimator state
+typedef struct {
+    uint32_t channels;           // N'
+    uint32_t blocks;             // P
+    uint32_t hop;                // L = N' / 4
+    uint32_t kept;               // P / 8: cyclic outputs kept either side per pair
+    uint32_t segment_samples;    // (P - 1) L + N'
+    uint32_t profile_size;       // Cyclic cells from -rate to +rate
+    uint32_t profile_offset;     // Cell of a = 0
+
+    fft_plan_f32_t *channel_plan;    // N' points
+    fft_plan_f32_t *cyclic_plan;     // P points
+    const window_t *window;          // Channelizer taper, N'
+    const window_t *taper;           // Product taper, P
+
+    fft_complex_f32_t *frames;       // P windowed frames of N'
+    fft_complex_f32_t *spectra;      // Their FFTs
+    fft_complex_f32_t *channel;      // N' channels of P outputs, lowest frequency first
+    fft_complex_f32_t *products;     // N' products against one channel
+    fft_complex_f32_t *cyclic;       // Their FFTs
+    double *power;                   // Tapered power per channel, this segment
+
+    double *grid;                    // Accumulated |S|^2, N'^2 pairs x 2 kept
+    double *conj_grid;               // ... conjugate
+    double *norm;                    // Accumulated power products per pair
+    double *profile;                 // Largest coherence per cyclic cell
+    double *profile_freq;            // ... at this f (Hz / rate)
+    double *conj_profile;
+    double *conj_profile_freq;
+    double *scratch;                 // Median selection
+} cyclo_t;
+
+/*
+ * Initialize for channels N' (a power of two, at least 8) and blocks P
+ * (a power of two, at least 16)
+ * Returns false (with a message on stderr) on invalid sizes or no memory.
+ */
+bool cyclo_init(cyclo_t *cyclo, uint32_t channels, uint32_t blocks);
+
+// Free the estimator's buffers and plans
+void cyclo_free(cyclo_t *cyclo);
+
+/*
+ * Estimate the cyclic features of num_samples interleaved I/Q samples at
+ * sample_rate_hz
+ * Returns false (features->valid false) when the snippet is shorter than
+ * one segment or has no power.
+ */
+bool cyclo_analyze(cyclo_t *cyclo, const float *iq_samples, uint32_t num_samples,
+                   double sample_rate_hz, cyclo_features_t *features);
+
+/*
+ * Refine a time-domain classification (features_extract_from_iq) with the
+ * cyclic features:
+ * - "unknown" or "noise" with a symbol-rate peak: "bpsk" with a conjugate
+ *   peak (a real constellation), else "psk" (QPSK, 8PSK, QAM)
+ * - "fm" whose lowest cyclic peak is at least CYCLO_FSK_MIN_RATE of the
+ *   rate: "fsk" (a tone-modulated FM carrier repeats at its audio rate,
+ *   far below that)
+ * Other hints are left alone. Returns true when the hint changed.
+ */
+bool cyclo_refine_modulation(const cyclo_features_t *features, features_result_t *result);
+
+#endif /* IQ_LAB_CYCLO_H */
@@ -0,0 +1,333 @@
+/*
+ * IQ Lab - Time-Domain Energy Gate
+ *
+ * The block power kernels square and pair-add I and Q with one multiply-add
+ * (pmaddwd on x86, widening multiplies on NEON) and accumulate in 64-bit
+ * lanes, so every path returns the same exact integer sum.
+ */
+
+#include "energy_gate.h"
+#include <stdio.h>
+#include <stdatomic.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ENERGY_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define ENERGY_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+enum {
+    ENERGY_SIMD_SCALAR,
+    ENERGY_SIMD_SSE2,
+    ENERGY_SIMD_AVX2,
+    ENERGY_SIMD_NEON
+};
+
+// -1 until the first block detects the CPU
+static atomic_int energy_simd_active = -1;
+
+static int energy_simd_detect(void) {
+#if defined(ENERGY_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx2")) return ENERGY_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return ENERGY_SIMD_SSE2;
+    return ENERGY_SIMD_SCALAR;
+#elif defined(ENERGY_HAVE_NEON)
+    return ENERGY_SIMD_NEON;
+#else
+    return ENERGY_SIMD_SCALAR;
+#endif
+}
+
+void energy_gate_force_scalar(bool scalar) {
+    atomic_store(&energy_simd_active, scalar ? ENERGY_SIMD_SCALAR : energy_simd_detect());
+}
+
+#if defined(ENERGY_HAVE_X86_SIMD)
+
+// pmaddwd of a vector with itself gives I^2 + Q^2 per sample: up to 2^31,
+// so the lanes are widened as unsigned
+
+__attribute__((target("sse2")))
+static inline __m128i energy_widen_add_sse2(__m128i acc, __m128i sums) {
+    const __m128i zero = _mm_setzero_si128();
+    acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sums, zero));
+    return _mm_add_epi64(acc, _mm_unpackhi_epi32(sums, zero));
+}
+
+__attribute__((target("sse2")))
+static uint64_t energy_reduce_sse2(__m128i acc) {
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1];
+}
+
+// SSE2: four s16 samples per step; returns the samples consumed
+__attribute__((target("sse2")))
+static size_t energy_s16_sse2(const int16_t *iq, size_t count, uint64_t *sum) {
+    __m128i acc = _mm_setzero_si128();
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(iq + 2 * n));
+        acc = energy_widen_add_sse2(acc, _mm_madd_epi16(x, x));
+    }
+    *sum += energy_reduce_sse2(acc);
+    return n;
+}
+
+// SSE2: eight s8 samples per step, sign-extended to 16 bits
+__attribute__((target("sse2")))
+static size_t energy_s8_sse2(const int8_t *iq, size_t count, uint64_t *sum) {
+    __m128i acc = _mm_setzero_si128();
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(iq + 2 * n));
+        __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+        __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+        acc = energy_widen_add_sse2(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+    }
+    *sum += energy_reduce_sse2(acc);
+    return n;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i energy_widen_add_avx2(__m256i acc, __m256i sums) {
+    const __m256i zero = _mm256_setzero_si256();
+    acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(sums, zero));
+    return _mm256_add_epi64(acc, _mm256_unpackhi_epi32(sums, zero));
+}
+
+__attribute__((target("avx2")))
+static uint64_t energy_reduce_avx2(__m256i acc) {
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// AVX2: eight s16 samples per step
+__attribute__((target("avx2")))
+static size_t energy_s16_avx2(const int16_t *iq, size_t count, uint64_t *sum) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(iq + 2 * n));
+        acc = energy_widen_add_avx2(acc, _mm256_madd_epi16(x, x));
+    }
+    *sum += energy_reduce_avx2(acc);
+    return n;
+}
+
+// AVX2: eight s8 samples per step
+__attribute__((target("avx2")))
+static size_t energy_s8_avx2(const int8_t *iq, size_t count, uint64_t *sum) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m256i x = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(iq + 2 * n)));
+        acc = energy_widen_add_avx2(acc, _mm256_madd_epi16(x, x));
+    }
+    *sum += energy_reduce_avx2(acc);
+    return n;
+}
+
+#endif /* ENERGY_HAVE_X86_SIMD */
+
+#if defined(ENERGY_HAVE_NEON)
+
+// NEON: squares widen to 32 bits (at most 2^30) and pair-add into 64-bit lanes
+static inline uint64x2_t energy_square_add_neon(uint64x2_t acc, int16x8_t x) {
+    int32x4_t lo = vmull_s16(vget_low_s16(x), vget_low_s16(x));
+    int32x4_t hi = vmull_s16(vget_high_s16(x), vget_high_s16(x));
+    acc = vpadalq_u32(acc, vreinterpretq_u32_s32(lo));
+    return vpadalq_u32(acc, vreinterpretq_u32_s32(hi));
+}
+
+// NEON: four s16 samples per step
+static size_t energy_s16_neon(const int16_t *iq, size_t count, uint64_t *sum) {
+    uint64x2_t acc = vdupq_n_u64(0);
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        acc = energy_square_add_neon(acc, vld1q_s16(iq + 2 * n));
+    }
+    *sum += vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+    return n;
+}
+
+// NEON: eight s8 samples per step
+static size_t energy_s8_neon(const int8_t *iq, size_t count, uint64_t *sum) {
+    uint64x2_t acc = vdupq_n_u64(0);
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        int8x16_t x = vld1q_s8(iq + 2 * n);
+        acc = energy_square_add_neon(acc, vmovl_s8(vget_low_s8(x)));
+        acc = energy_square_add_neon(acc, vmovl_s8(vget_high_s8(x)));
+    }
+    *sum += vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+    return n;
+}
+
+#endif /* ENERGY_HAVE_NEON */
+
+uint64_t energy_gate_block_power(const void *samples, uint32_t bits, size_t count) {
+    if (!samples || (bits != 8 && bits != 16)) return 0;
+
+    int simd = atomic_load(&energy_simd_active);
+    if (simd < 0) {
+        simd = energy_simd_detect();
+        atomic_store(&energy_simd_active, simd);
+    }
+
+    uint64_t sum = 0;
+    size_t n = 0;
+    if (bits == 16) {
+        const int16_t *iq = samples;
+        switch (simd) {
+#if defined(ENERGY_HAVE_X86_SIMD)
+            case ENERGY_SIMD_AVX2: n = energy_s16_avx2(iq, count, &sum); break;
+            case ENERGY_SIMD_SSE2: n = energy_s16_sse2(iq, count, &sum); break;
+#endif
+#if defined(ENERGY_HAVE_NEON)
+            case ENERGY_SIMD_NEON: n = energy_s16_neon(iq, count, &sum); break;
+#endif
+            default: break;
+        }
+        for (; n < count; n++) {
+            int32_t i = iq[2 * n], q = iq[2 * n + 1];
+            sum += (uint64_t)(i * i) + (uint64_t)(q * q);
+        }
+    } else {
+        const int8_t *iq = samples;
+        switch (simd) {
+#if defined(ENERGY_HAVE_X86_SIMD)
+            case ENERGY_SIMD_AVX2: n = energy_s8_avx2(iq, count, &sum); break;
+            case ENERGY_SIMD_SSE2: n = energy_s8_sse2(iq, count, &sum); break;
+#endif
+#if defined(ENERGY_HAVE_NEON)
+            case ENERGY_SIMD_NEON: n = energy_s8_neon(iq, count, &sum); break;
+#endif
+            default: break;
+        }
+        for (; n < count; n++) {
+            int32_t i = iq[2 * n], q = iq[2 * n + 1];
+            sum += (uint64_t)(i * i + q * q);
+        }
+    }
+    return sum;
+}
+
+bool energy_gate_init(energy_gate_t *gate, double margin_db, uint32_t time_constant,
+                      uint32_t hold_frames) {
+    if (!gate) return false;
+    if (!(margin_db > 0.0) || time_constant < 1) {
+        fprintf(stderr, "Error: Invalid energy gate (margin %g dB, %u frames)\n",
+                margin_db, time_constant);
+        return false;
+    }
+
+    gate->margin_db = margin_db;
+    gate->time_constant = time_constant;
+    gate->hold_frames = hold_frames;
+    gate->margin = pow(10.0, margin_db / 10.0);
+    gate->weight = 1.0 / (double)time_constant;
+    energy_gate_reset(gate);
+    return true;
+}
+
+void energy_gate_reset(energy_gate_t *gate) {
+    if (!gate) return;
+    gate->floor = 0.0;
+    gate->seeded = false;
+    gate->hold_left = 0;
+    gate->frames = 0;
+    gate->active_frames = 0;
+}
+
+// Running state of a checkpointed gate
+typedef struct {
+    double floor;
+    uint32_t seeded;
+    uint32_t hold_left;
+    uint64_t frames;
+    uint64_t active_frames;
+} energy_gate_state_t;
+
+bool energy_gate_save_state(const energy_gate_t *gate, checkpoint_writer_t *writer) {
+    if (!gate || !writer) return false;
+
+    energy_gate_state_t state = {0};
+    state.floor = gate->floor;
+    state.seeded = gate->seeded;
+    state.hold_left = gate->hold_left;
+    state.frames = gate->frames;
+    state.active_frames = gate->active_frames;
+    return checkpoint_put(writer, "energy_gate.state", &state, sizeof(state));
+}
+
+bool energy_gate_load_state(energy_gate_t *gate, const checkpoint_t *checkpoint) {
+    energy_gate_state_t state;
+    if (!gate || !checkpoint_get(checkpoint, "energy_gate.state", &state, sizeof(state))) {
+        return false;
+    }
+
+    gate->floor = state.floor;
+    gate->seeded = state.seeded != 0;
+    gate->hold_left = state.hold_left;
+    gate->frames = state.frames;
+    gate->active_frames = state.active_frames;
+    return true;
+}
+
+bool energy_gate_update(energy_gate_t *gate, double loudest, double quietest) {
+    gate->frames++;
+    if (!gate->seeded) {
+        gate->floor = quietest;
+        gate->seeded = true;
+    }
+
+    // Judged against the floor of the frames before this one
+    bool loud = loudest > gate->floor * gate->margin;
+    if (quietest < gate->floor) {
+        gate->floor = quietest;
+    } else {
+        double weight = loud ? gate->weight / ENERGY_GATE_ACTIVE_SLOWDOWN : gate->weight;
+        gate->floor += weight * (quietest - gate->floor);
+    }
+
+    bool active = loud;
+    if (loud) {
+        gate->hold_left = gate->hold_frames;
+    } else if (gate->hold_left > 0) {
+        gate->hold_left--;
+        active = true;
+    }
+    if (active) gate->active_frames++;
+    return active;
+}
+
+bool energy_gate_frame(energy_gate_t *gate, const void *samples, uint32_t bits,
+                       size_t count, size_t block) {
+    if (bits != 8 && bits != 16) {
+        gate->frames++;
+        gate->active_frames++;
+        return true;
+    }
+    if (block == 0 || block > count) block = count;
+
+    const uint8_t *bytes = samples;
+    const size_t sample_bytes = 2 * (bits / 8);
+    double loudest = 0.0, quietest = INFINITY;
+    for (size_t start = 0, length; start < count; start += length) {
+        // A short remainder joins the last block
+        length = count - start < 2 * block ? count - start : block;
+        double power = (double)energy_gate_block_power(bytes + start * sample_bytes, bits, length) /
+                       (double)length;
+        if (power > loudest) loudest = power;
+        if (power < quietest) quietest = power;
+    }
+    if (count == 0) quietest = 0.0;
+    return energy_gate_update(gate, loudest, quietest);
+}
@@ -0,0 +1,116 @@
+/*
+ * IQ Lab - Time-Domain Energy Gate Header
+ *
+ * Purpose: Skip the FFT, CFAR and clustering of frames that hold only noise
+ *
+ *
+ * In a sparse capture (bursts separated by long quiet stretches) almost
+ * every frame goes through an FFT and a CFAR pass that finds nothing. The
+ * gate looks at the raw samples first: the mean power of each sub-block of
+ * a frame, from the native s8/s16 samples with integer SIMD (SSE2/AVX2 or
+ * NEON, a scalar tail), against a running estimate of the quiet level. A
+ * frame is active when any of its sub-blocks rises margin dB above that
+ * floor; only active frames, and the next hold_frames after them, need the
+ * spectral path.
+ *
+ * Floor tracking:
+ * - Fed with the quietest sub-block of each frame, so a burst that covers
+ *   part of a frame does not raise it
+ * - Falls at once to a quieter block (a minimum tracker)
+ * - Rises with weight 1/time_constant over inactive frames, and
+ *   ENERGY_GATE_ACTIVE_SLOWDOWN times slower over active ones, so a level
+ *   step is still learnt but a burst a few hundred frames long is not
+ *
+ * Usage:
+ *   energy_gate_t gate;
+ *   energy_gate_init(&gate, 3.0, 64, 2);
+ *   for each frame:
+ *       if (!energy_gate_frame(&gate, samples, 16, fft_size, hop_size)) continue;
+ *       ... FFT, CFAR, clustering ...
+ *   skipped = gate.frames - gate.active_frames;
+ *
+ * Technical Details:
+ * - The gate sees total band power: a narrowband signal far below the
+ *   noise of the whole band does not open it, so the margin should be small
+ *   (a few dB) and the gate suits captures whose signals are strong bursts
+ * - Powers are in native units (|I|^2 + |Q|^2 per sample, integer scale),
+ *   since only ratios to the floor matter
+ * - The first frame seeds the floor and is judged against it
+ *
+ * Memory: fixed-size state, no allocation
+ * Thread Safety: energy_gate_block_power() is reentrant; a gate instance is
+ *                updated by one thread at a time, frames in stream order
+ */
+
+#ifndef IQ_LAB_ENERGY_GATE_H
+#define IQ_LAB_ENERGY_GATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../iq_core/checkpoint.h"
+
+#define ENERGY_GATE_ACTIVE_SLOWDOWN 64  // Floor rise over active frames vs quiet ones
+#define ENERGY_GATE_DEFAULT_HOLD 2      // Frames kept active after the last loud one
+
+// Energy gate configuration and state
+typedef struct {
+    // Configuration parameters
+    double margin_db;            // Activity threshold above the floor
+    uint32_t time_constant;      // Frames of floor memory
+    uint32_t hold_frames;        // Frames kept active after the last loud one
+
+    // Derived parameters
+    double margin;               // Linear power ratio 10^(margin_db / 10)
+    double weight;               // Floor rise weight 1/time_constant
+
+    // State
+    double floor;                // Quiet-level mean power per sample (native units)
+    bool seeded;                 // Floor set from the first frame
+    uint32_t hold_left;          // Hangover frames still to pass
+    uint64_t frames;             // Frames judged
+    uint64_t active_frames;      // ... and passed to the spectral path
+} energy_gate_t;
+
+/*
+ * Initialize a gate
+ * margin_db > 0; time_constant >= 1 frames. Returns false (with a message
+ * on stderr) on invalid parameters.
+ */
+bool energy_gate_init(energy_gate_t *gate, double margin_db, uint32_t time_constant,
+                      uint32_t hold_frames);
+
+// Forget the floor and the counters (next stream)
+void energy_gate_reset(energy_gate_t *gate);
+
+// Save / restore the floor, hangover and counters
+bool energy_gate_save_state(const energy_gate_t *gate, checkpoint_writer_t *writer);
+bool energy_gate_load_state(energy_gate_t *gate, const checkpoint_t *checkpoint);
+
+/*
+ * Sum of I^2 + Q^2 over 'count' interleaved complex samples of 8 or 16 bits
+ * Exact (integer) on every path; 0 for other widths.
+ */
+uint64_t energy_gate_block_power(const void *samples, uint32_t bits, size_t count);
+
+/*
+ * Judge one frame of 'count' samples, as sub-blocks of 'block' samples
+ * (block 0 or >= count: the frame is one block; a remainder shorter than
+ * a block joins the last one). Updates the floor and the counters;
+ * returns true when the frame needs the spectral path. Widths other than
+ * 8 and 16 bits are always active.
+ */
+bool energy_gate_frame(energy_gate_t *gate, const void *samples, uint32_t bits,
+                       size_t count, size_t block);
+
+/*
+ * Judge a frame from its sub-block mean powers (per sample): the loudest
+ * decides, the quietest feeds the floor. energy_gate_frame() in terms of
+ * powers, for callers that measure elsewhere.
+ */
+bool energy_gate_update(energy_gate_t *gate, double loudest, double quietest);
+
+// Force the SIMD kernels off (tests compare the paths)
+void energy_gate_force_scalar(bool scalar);
+
+#endif /* IQ_LAB_ENERGY_GATE_H */
@@ -0,0 +1,536 @@
+/*
+ * IQ Lab - Event Catalog
+ *
+ * Partitions are plain arrays of records, so appending is a write at the
+ * end and a record is found by its position. The index of a partition is
+ * (lower edge, position) pairs in lower-edge order: an event overlaps
+ * [f_min, f_max] only if its lower edge lies in [f_min - widest, f_max],
+ * one contiguous run of the index found by two binary searches. Indexes
+ * are written to a temporary file and renamed over the old one, so a
+ * query never sees a half-written index.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "event_catalog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define catalog_mkdir(path) _mkdir(path)
+#else
+#define catalog_mkdir(path) mkdir((path), 0755)
+#endif
+
+#define CATALOG_MANIFEST "catalog.txt"
+#define CATALOG_MANIFEST_HEADER "# IQ Lab event catalog v1"
+#define CATALOG_INDEX_MAGIC "IQCATIX1"
+#define CATALOG_RECORD_BYTES 64
+#define CATALOG_MAX_SOURCES (1u << 20)
+
+_Static_assert(sizeof(event_catalog_record_t) == CATALOG_RECORD_BYTES, "record layout");
+
+typedef struct {
+    char magic[8];
+    uint64_t records;           // Records covered, in partition order
+    double max_width;           // Widest band among them
+    double t_min;               // Earliest start
+    double t_max;               // Latest end
+} catalog_index_header_t;
+
+typedef struct {
+    double f_low;
+    uint64_t record;
+} catalog_index_entry_t;
+
+struct event_catalog {
+    char dir[EVENT_CATALOG_MAX_PATH];
+    FILE *manifest;                   // Opened for appending
+    event_catalog_source_t **sources; // By id
+    uint32_t num_sources;
+    uint32_t sources_capacity;
+    int64_t *partitions;              // Days, ascending
+    uint32_t num_partitions;
+    uint32_t partitions_capacity;
+    double max_duration_s;            // Longest event of any source
+    int64_t *touched;                 // Days appended to since the last commit
+    uint32_t num_touched;
+    uint32_t touched_capacity;
+    FILE *append_file;                // Partition open for appending
+    int64_t append_day;
+    bool failed;                      // A write since the last commit failed
+};
+
+static void catalog_path(const event_catalog_t *catalog, char *path, size_t size,
+                         int64_t day, const char *ext) {
+    snprintf(path, size, "%s/%lld.%s", catalog->dir, (long long)day, ext);
+}
+
+// Grow an array of 'elem' bytes to hold one more entry
+static bool catalog_reserve(void **array, uint32_t *capacity, uint32_t count, size_t elem) {
+    if (count < *capacity) return true;
+    uint32_t grown = *capacity ? *capacity * 2 : 16;
+    void *bigger = realloc(*array, grown * elem);
+    if (!bigger) return false;
+    *array = bigger;
+    *capacity = grown;
+    return true;
+}
+
+static bool catalog_has_partition(const event_catalog_t *catalog, int64_t day) {
+    uint32_t lo = 0, hi = catalog->num_partitions;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (catalog->partitions[mid] < day) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < catalog->num_partitions && catalog->partitions[lo] == day;
+}
+
+static bool catalog_add_partition(event_catalog_t *catalog, int64_t day) {
+    if (catalog_has_partition(catalog, day)) return true;
+    if (!catalog_reserve((void **)&catalog->partitions, &catalog->partitions_capacity,
+                         catalog->num_partitions, sizeof(int64_t))) {
+        return false;
+    }
+    uint32_t at = catalog->num_partitions;
+    while (at > 0 && catalog->partitions[at - 1] > day) {
+        catalog->partitions[at] = catalog->partitions[at - 1];
+        at--;
+    }
+    catalog->partitions[at] = day;
+    catalog->num_partitions++;
+    return true;
+}
+
+// Add or update a source from a manifest line or a new log
+static event_catalog_source_t *catalog_put_source(event_catalog_t *catalog, const event_catalog_source_t *entry) {
+    if (entry->id < catalog->num_sources) {
+        *catalog->sources[entry->id] = *entry;
+    } else if (entry->id == catalog->num_sources && entry->id < CATALOG_MAX_SOURCES) {
+        event_catalog_source_t *source = malloc(sizeof(*source));
+        if (!source || !catalog_reserve((void **)&catalog->sources, &catalog->sources_capacity,
+                                        catalog->num_sources, sizeof(*catalog->sources))) {
+            free(source);
+            return NULL;
+        }
+        *source = *entry;
+        catalog->sources[catalog->num_sources++] = source;
+    } else {
+        return NULL;  // Ids are dense and in order
+    }
+    if (entry->max_duration_s > catalog->max_duration_s) {
+        catalog->max_duration_s = entry->max_duration_s;
+    }
+    return catalog->sources[entry->id];
+}
+
+static bool catalog_read_manifest(event_catalog_t *catalog, FILE *file) {
+    char line[EVENT_CATALOG_MAX_PATH + 128];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        long long day;
+        event_catalog_source_t entry;
+        unsigned long long offset, size;
+        long long mtime;
+        int consumed = 0;
+        if (line[0] == '#' || line[0] == '\0') {
+            continue;
+        } else if (sscanf(line, "partition %lld", &day) == 1) {
+            if (!catalog_add_partition(catalog, day)) return false;
+        } else if (sscanf(line, "source %u %llu %llu %lld %lf %n", &entry.id, &offset, &size, &mtime,
+                          &entry.max_duration_s, &consumed) == 5 && consumed > 0) {
+            entry.offset = offset;
+            entry.size = size;
+            entry.mtime = mtime;
+            snprintf(entry.path, sizeof(entry.path), "%s", line + consumed);
+            if (!catalog_put_source(catalog, &entry)) return false;
+        } else {
+            return false;
+        }
+    }
+    return !ferror(file);
+}
+
+event_catalog_t *event_catalog_open(const char *dir, bool create) {
+    if (!dir || strlen(dir) + 32 > EVENT_CATALOG_MAX_PATH) return NULL;
+
+    event_catalog_t *catalog = calloc(1, sizeof(*catalog));
+    if (!catalog) return NULL;
+    snprintf(catalog->dir, sizeof(catalog->dir), "%s", dir);
+    size_t length = strlen(catalog->dir);
+    while (length > 1 && (catalog->dir[length - 1] == '/' || catalog->dir[length - 1] == '\\')) {
+        catalog->dir[--length] = '\0';
+    }
+    if (create && catalog_mkdir(catalog->dir) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create catalog directory: %s\n", dir);
+        free(catalog);
+        return NULL;
+    }
+
+    char path[EVENT_CATALOG_MAX_PATH + 32];
+    snprintf(path, sizeof(path), "%s/%s", catalog->dir, CATALOG_MANIFEST);
+    FILE *existing = fopen(path, "r");
+    bool ok = true;
+    if (existing) {
+        ok = catalog_read_manifest(catalog, existing);
+        fclose(existing);
+    } else if (!create) {
+        fprintf(stderr, "Not an event catalog: %s\n", dir);
+        event_catalog_close(catalog);
+        return NULL;
+    }
+    catalog->manifest = ok ? fopen(path, "a") : NULL;
+    if (!catalog->manifest) {
+        fprintf(stderr, ok ? "Failed to open catalog manifest: %s\n" : "Damaged catalog manifest: %s\n", path);
+        event_catalog_close(catalog);
+        return NULL;
+    }
+    if (!existing) {
+        fprintf(catalog->manifest, "%s\n", CATALOG_MANIFEST_HEADER);
+        fflush(catalog->manifest);
+    }
+    return catalog;
+}
+
+void event_catalog_close(event_catalog_t *catalog) {
+    if (!catalog) return;
+    if (catalog->append_file) fclose(catalog->append_file);
+    if (catalog->manifest) fclose(catalog->manifest);
+    for (uint32_t i = 0; i < catalog->num_sources; i++) free(catalog->sources[i]);
+    free(catalog->sources);
+    free(catalog->partitions);
+    free(catalog->touched);
+    free(catalog);
+}
+
+event_catalog_source_t *event_catalog_source(event_catalog_t *catalog, const char *path,
+                                             uint64_t size, int64_t mtime) {
+    if (!catalog || !path || strlen(path) >= EVENT_CATALOG_MAX_PATH) return NULL;
+
+    for (uint32_t i = 0; i < catalog->num_sources; i++) {
+        event_catalog_source_t *source = catalog->sources[i];
+        if (strcmp(source->path, path) != 0) continue;
+        if (size < source->size || mtime < source->mtime) {
+            source->offset = 0;
+        }
+        source->size = size;
+        source->mtime = mtime;
+        return source;
+    }
+
+    event_catalog_source_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.id = catalog->num_sources;
+    entry.size = size;
+    entry.mtime = mtime;
+    snprintf(entry.path, sizeof(entry.path), "%s", path);
+    return catalog_put_source(catalog, &entry);
+}
+
+const event_catalog_source_t *event_catalog_source_by_id(const event_catalog_t *catalog, uint32_t id) {
+    return catalog && id < catalog->num_sources ? catalog->sources[id] : NULL;
+}
+
+bool event_catalog_append(event_catalog_t *catalog, event_catalog_source_t *source,
+                          const event_catalog_record_t *record) {
+    if (!catalog || !source || !record || !isfinite(record->t_start) || !isfinite(record->t_end) ||
+        !isfinite(record->f_low) || !isfinite(record->f_high)) {
+        return false;
+    }
+    double day_f = floor(record->t_start / EVENT_CATALOG_PARTITION_S);
+    if (fabs(day_f) > 1e12) return false;
+    int64_t day = (int64_t)day_f;
+
+    if (!catalog->append_file || catalog->append_day != day) {
+        if (catalog->append_file && fclose(catalog->append_file) != 0) catalog->failed = true;
+        catalog->append_file = NULL;
+
+        char path[EVENT_CATALOG_MAX_PATH + 32];
+        catalog_path(catalog, path, sizeof(path), day, "events");
+        catalog->append_file = fopen(path, "ab");
+        if (!catalog->append_file) {
+            catalog->failed = true;
+            return false;
+        }
+        catalog->append_day = day;
+
+        bool touched = false;
+        for (uint32_t i = 0; i < catalog->num_touched && !touched; i++) touched = catalog->touched[i] == day;
+        if (!touched) {
+            if (!catalog_reserve((void **)&catalog->touched, &catalog->touched_capacity,
+                                 catalog->num_touched, sizeof(int64_t))) {
+                catalog->failed = true;
+                return false;
+            }
+            catalog->touched[catalog->num_touched++] = day;
+        }
+        if (!catalog_has_partition(catalog, day)) {
+            if (!catalog_add_partition(catalog, day)) {
+                catalog->failed = true;
+                return false;
+            }
+            fprintf(catalog->manifest, "partition %lld\n", (long long)day);
+        }
+    }
+
+    event_catalog_record_t stored = *record;
+    stored.source = source->id;
+    stored.modulation[EVENT_CATALOG_MODULATION - 1] = '\0';
+    if (fwrite(&stored, sizeof(stored), 1, catalog->append_file) != 1) {
+        catalog->failed = true;
+        return false;
+    }
+    double duration = record->t_end - record->t_start;
+    if (duration > source->max_duration_s) source->max_duration_s = duration;
+    if (duration > catalog->max_duration_s) catalog->max_duration_s = duration;
+    return true;
+}
+
+static int catalog_entry_compare(const void *a, const void *b) {
+    const catalog_index_entry_t *x = a, *y = b;
+    if (x->f_low != y->f_low) return x->f_low < y->f_low ? -1 : 1;
+    return x->record < y->record ? -1 : x->record > y->record;
+}
+
+// Rebuild one partition's index from its records
+static bool catalog_reindex(event_catalog_t *catalog, int64_t day) {
+    char path[EVENT_CATALOG_MAX_PATH + 32], index_path[EVENT_CATALOG_MAX_PATH + 32];
+    char temp_path[EVENT_CATALOG_MAX_PATH + 40];
+    catalog_path(catalog, path, sizeof(path), day, "events");
+    catalog_path(catalog, index_path, sizeof(index_path), day, "index");
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", index_path);
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+    size_t capacity = 4096, count = 0;
+    catalog_index_entry_t *entries = malloc(capacity * sizeof(*entries));
+    catalog_index_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CATALOG_INDEX_MAGIC, sizeof(header.magic));
+    header.t_min = INFINITY;
+    header.t_max = -INFINITY;
+
+    event_catalog_record_t batch[1024];
+    size_t got;
+    bool ok = entries != NULL;
+    while (ok && (got = fread(batch, sizeof(batch[0]), 1024, file)) > 0) {
+        if (count + got > capacity) {
+            while (count + got > capacity) capacity *= 2;
+            catalog_index_entry_t *grown = realloc(entries, capacity * sizeof(*entries));
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            entries = grown;
+        }
+        for (size_t i = 0; i < got; i++) {
+            entries[count].f_low = batch[i].f_low;
+            entries[count].record = count;
+            count++;
+            header.max_width = fmax(header.max_width, batch[i].f_high - batch[i].f_low);
+            header.t_min = fmin(header.t_min, batch[i].t_start);
+            header.t_max = fmax(header.t_max, batch[i].t_end);
+        }
+    }
+    ok = ok && !ferror(file);
+    fclose(file);
+
+    if (ok) {
+        qsort(entries, count, sizeof(*entries), catalog_entry_compare);
+        header.records = count;
+        FILE *out = fopen(temp_path, "wb");
+        ok = out && fwrite(&header, sizeof(header), 1, out) == 1 &&
+             fwrite(entries, sizeof(*entries), count, out) == count;
+        if (out && fclose(out) != 0) ok = false;
+#ifdef _WIN32
+        if (ok) remove(index_path);  // rename() does not replace on Windows
+#endif
+        ok = ok && rename(temp_path, index_path) == 0;
+        if (!ok) remove(temp_path);
+    }
+    free(entries);
+    return ok;
+}
+
+bool event_catalog_commit(event_catalog_t *catalog, event_catalog_source_t *source, uint64_t offset) {
+    if (!catalog || !source) return false;
+
+    bool ok = !catalog->failed;
+    bool changed = catalog->num_touched > 0 || offset != source->offset;
+    if (catalog->append_file && fclose(catalog->append_file) != 0) ok = false;
+    catalog->append_file = NULL;
+    for (uint32_t i = 0; i < catalog->num_touched; i++) {
+        if (!catalog_reindex(catalog, catalog->touched[i])) ok = false;
+    }
+    catalog->num_touched = 0;
+
+    // Only a fully written ingest moves the source on
+    if (ok && changed) {
+        source->offset = offset;
+        fprintf(catalog->manifest, "source %u %llu %llu %lld %.6f %s\n", source->id,
+                (unsigned long long)source->offset, (unsigned long long)source->size,
+                (long long)source->mtime, source->max_duration_s, source->path);
+    }
+    if (fflush(catalog->manifest) != 0) ok = false;
+    catalog->failed = false;
+    return ok;
+}
+
+event_catalog_query_t event_catalog_query_all(void) {
+    event_catalog_query_t query = {-INFINITY, INFINITY, -INFINITY, INFINITY, -INFINITY};
+    return query;
+}
+
+bool event_catalog_match(const event_catalog_query_t *query, const event_catalog_record_t *record) {
+    return record->t_end >= query->t_min && record->t_start <= query->t_max &&
+           record->f_high >= query->f_min && record->f_low <= query->f_max &&
+           record->snr_db >= query->min_snr_db;
+}
+
+// First index entry at or after 'position' whose lower edge is >= 'f' (or > 'f' if 'after')
+static bool catalog_index_search(FILE *index, uint64_t count, double f, bool after, uint64_t *position) {
+    uint64_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        catalog_index_entry_t entry;
+        if (fseek(index, (long)(sizeof(catalog_index_header_t) + mid * sizeof(entry)), SEEK_SET) != 0 ||
+            fread(&entry, sizeof(entry), 1, index) != 1) {
+            return false;
+        }
+        if (after ? entry.f_low <= f : entry.f_low < f) lo = mid + 1;
+        else hi = mid;
+    }
+    *position = lo;
+    return true;
+}
+
+static int catalog_u64_compare(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Visit records [first, last) of a partition in order; false on a read error
+// or when the visitor stops ('*stopped' tells which)
+static bool catalog_scan(FILE *file, uint64_t first, uint64_t last, const event_catalog_query_t *query,
+                         event_catalog_visit_t visit, void *user, event_catalog_stats_t *stats, bool *stopped) {
+    if (first >= last) return true;
+    if (fseek(file, (long)(first * CATALOG_RECORD_BYTES), SEEK_SET) != 0) return false;
+    event_catalog_record_t batch[1024];
+    for (uint64_t at = first; at < last;) {
+        size_t want = last - at < 1024 ? (size_t)(last - at) : 1024;
+        if (fread(batch, sizeof(batch[0]), want, file) != want) return false;
+        for (size_t i = 0; i < want; i++) {
+            stats->records_read++;
+            if (!event_catalog_match(query, &batch[i])) continue;
+            stats->matches++;
+            if (!visit(&batch[i], user)) {
+                *stopped = true;
+                return false;
+            }
+        }
+        at += want;
+    }
+    return true;
+}
+
+// Query one partition through its index
+static bool catalog_query_partition(event_catalog_t *catalog, int64_t day, const event_catalog_query_t *query,
+                                    event_catalog_visit_t visit, void *user, event_catalog_stats_t *stats,
+                                    bool *stopped) {
+    char path[EVENT_CATALOG_MAX_PATH + 32], index_path[EVENT_CATALOG_MAX_PATH + 32];
+    catalog_path(catalog, path, sizeof(path), day, "events");
+    catalog_path(catalog, index_path, sizeof(index_path), day, "index");
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return true;  // Declared in the manifest, nothing written yet
+    fseek(file, 0, SEEK_END);
+    long bytes = ftell(file);
+    uint64_t total = bytes > 0 ? (uint64_t)bytes / CATALOG_RECORD_BYTES : 0;
+
+    FILE *index = fopen(index_path, "rb");
+    catalog_index_header_t header;
+    bool indexed = index && fread(&header, sizeof(header), 1, index) == 1 &&
+                   memcmp(header.magic, CATALOG_INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+                   header.records <= total;
+    uint64_t covered = indexed ? header.records : 0;
+
+    bool ok = true;
+    bool time_miss = indexed && (header.t_max < query->t_min || header.t_min > query->t_max);
+    bool bounded = isfinite(query->f_min) || isfinite(query->f_max);
+    if (!indexed || time_miss) {
+        // Nothing indexed to search, or the indexed records all miss in time
+    } else if (!bounded) {
+        ok = catalog_scan(file, 0, covered, query, visit, user, stats, stopped);
+    } else {
+        uint64_t first = 0, last = covered;
+        double lowest = query->f_min - header.max_width;
+        ok = (!isfinite(lowest) || catalog_index_search(index, covered, lowest, false, &first)) &&
+             (!isfinite(query->f_max) || catalog_index_search(index, covered, query->f_max, true, &last));
+
+        // The candidates' positions, read in file order
+        uint64_t candidates = last > first ? last - first : 0;
+        uint64_t *positions = candidates ? malloc(candidates * sizeof(uint64_t)) : NULL;
+        if (candidates && !positions) ok = false;
+        if (ok && candidates) {
+            ok = fseek(index, (long)(sizeof(header) + first * sizeof(catalog_index_entry_t)), SEEK_SET) == 0;
+            for (uint64_t k = 0; ok && k < candidates; k++) {
+                catalog_index_entry_t entry;
+                ok = fread(&entry, sizeof(entry), 1, index) == 1 && entry.record < covered;
+                if (ok) positions[k] = entry.record;
+            }
+            if (ok) qsort(positions, candidates, sizeof(uint64_t), catalog_u64_compare);
+        }
+        for (uint64_t k = 0; ok && k < candidates; k++) {
+            event_catalog_record_t record;
+            ok = fseek(file, (long)(positions[k] * CATALOG_RECORD_BYTES), SEEK_SET) == 0 &&
+                 fread(&record, sizeof(record), 1, file) == 1;
+            if (!ok) break;
+            stats->records_read++;
+            if (!event_catalog_match(query, &record)) continue;
+            stats->matches++;
+            if (!visit(&record, user)) {
+                *stopped = true;
+                ok = false;
+            }
+        }
+        free(positions);
+    }
+
+    // Records appended after the index was built
+    if (ok) ok = catalog_scan(file, covered, total, query, visit, user, stats, stopped);
+
+    if (index) fclose(index);
+    fclose(file);
+    return ok;
+}
+
+bool event_catalog_query(event_catalog_t *catalog, const event_catalog_query_t *query,
+                         event_catalog_visit_t visit, void *user, event_catalog_stats_t *stats) {
+    event_catalog_stats_t local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!catalog || !query || !visit) return false;
+    stats->partitions = catalog->num_partitions;
+
+    // An event overlapping the query started at most max_duration before t_min
+    double first_day = floor((query->t_min - catalog->max_duration_s) / EVENT_CATALOG_PARTITION_S);
+    double last_day = floor(query->t_max / EVENT_CATALOG_PARTITION_S);
+    for (uint32_t p = 0; p < catalog->num_partitions; p++) {
+        double day = (double)catalog->partitions[p];
+        if (day < first_day || day > last_day) continue;
+        stats->partitions_read++;
+        bool stopped = false;
+        if (!catalog_query_partition(catalog, catalog->partitions[p], query, visit, user, stats, &stopped)) {
+            return stopped;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,141 @@
+/*
+ * IQ Lab - Event Catalog Header
+ *
+ * Purpose: Answer time and frequency range queries over events of many runs
+ *
+ *
+ * A catalog is a directory of detection events from any number of
+ * iqdetect logs, in absolute time (UTC seconds) and absolute frequency
+ * (Hz). It only grows: ingesting appends records and never rewrites them.
+ *
+ * Layout:
+ *   catalog.txt       manifest, appended to: one "partition <day>" line per
+ *                     partition, one "source ..." line per ingest of a log
+ *                     (the last line of a source wins)
+ *   <day>.events      partition: fixed 64-byte records of the events that
+ *                     start on that UTC day, in ingest order
+ *   <day>.index       the partition's frequency interval index: its records
+ *                     sorted by lower band edge with the widest band and
+ *                     the time range, rebuilt after each ingest touching it
+ *
+ * A query visits only the partitions whose days can hold an overlapping
+ * event (a day earlier per day of the longest event), skips any whose
+ * index time range misses, and within a partition binary-searches the
+ * sorted lower edges for [f_min - widest band, f_max], so it reads the
+ * candidates rather than the partition. Records appended after the index
+ * was built (an ingest cut short) are scanned, never lost.
+ *
+ * Incremental ingest: each source log is remembered with its size, mtime
+ * and how far it was read (bytes of a text log, events of a binary or
+ * SigMF log), so ingesting a job's output directory again only adds the
+ * logs, or the part of a growing log, not yet in the catalog.
+ *
+ * Usage:
+ *   event_catalog_t *catalog = event_catalog_open("catalog/", true);
+ *   event_catalog_source_t *source = event_catalog_source(catalog, path, size, mtime);
+ *   for each event past source->offset: event_catalog_append(catalog, source, &record);
+ *   event_catalog_commit(catalog, source, new_offset);
+ *   event_catalog_query(catalog, &query, visit, user, &stats);
+ *   event_catalog_close(catalog);
+ *
+ * Thread Safety: one process ingesting into a catalog at a time; queries
+ *                may run alongside an ingest and see whole records
+ */
+
+#ifndef IQ_LAB_EVENT_CATALOG_H
+#define IQ_LAB_EVENT_CATALOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EVENT_CATALOG_PARTITION_S 86400.0   // One partition per UTC day
+#define EVENT_CATALOG_MAX_PATH 512
+#define EVENT_CATALOG_MODULATION 16         // Bytes kept of a modulation name
+
+// One stored event (64 bytes on disk)
+typedef struct {
+    double t_start;             // UTC seconds since the epoch
+    double t_end;
+    double f_low;               // Absolute band edges (Hz)
+    double f_high;
+    float snr_db;               // Peak SNR
+    float peak_dbfs;
+    float confidence;
+    uint32_t source;            // Source log id
+    char modulation[EVENT_CATALOG_MODULATION];  // NUL-padded, "" if unknown
+} event_catalog_record_t;
+
+// One ingested log
+typedef struct {
+    uint32_t id;
+    uint64_t offset;            // Bytes (CSV, JSONL) or events (iqev, SigMF) ingested
+    uint64_t size;              // File size and mtime when last ingested
+    int64_t mtime;
+    double max_duration_s;      // Longest event taken from it
+    char path[EVENT_CATALOG_MAX_PATH];
+} event_catalog_source_t;
+
+// Events overlapping [t_min, t_max] x [f_min, f_max] with snr_db >= min_snr_db
+typedef struct {
+    double t_min, t_max;
+    double f_min, f_max;
+    double min_snr_db;
+} event_catalog_query_t;
+
+typedef struct {
+    uint32_t partitions;        // Partitions in the catalog
+    uint32_t partitions_read;   // ... opened by the query
+    uint64_t records_read;      // Records examined
+    uint64_t matches;           // Records passed to the visitor
+} event_catalog_stats_t;
+
+// Return false to stop the query
+typedef bool (*event_catalog_visit_t)(const event_catalog_record_t *record, void *user);
+
+typedef struct event_catalog event_catalog_t;
+
+/*
+ * Open a catalog directory, creating it (and its manifest) if 'create'.
+ * NULL with a message on stderr on failure.
+ */
+event_catalog_t *event_catalog_open(const char *dir, bool create);
+
+// Flush pending appends (without committing their source) and free
+void event_catalog_close(event_catalog_t *catalog);
+
+/*
+ * The catalog's entry for a log, added (offset 0) if new. A log whose size
+ * shrank or whose mtime went back was replaced: its offset restarts at 0
+ * (the records of its earlier contents stay). The pointer stays valid
+ * until event_catalog_close().
+ */
+event_catalog_source_t *event_catalog_source(event_catalog_t *catalog, const char *path,
+                                             uint64_t size, int64_t mtime);
+
+// Source by id (NULL if unknown)
+const event_catalog_source_t *event_catalog_source_by_id(const event_catalog_t *catalog, uint32_t id);
+
+// Append one event of 'source'; false on a write error or non-finite times
+bool event_catalog_append(event_catalog_t *catalog, event_catalog_source_t *source,
+                          const event_catalog_record_t *record);
+
+/*
+ * Rebuild the index of every partition appended to and record 'source' as
+ * read up to 'offset'. Returns false if a write failed.
+ */
+bool event_catalog_commit(event_catalog_t *catalog, event_catalog_source_t *source, uint64_t offset);
+
+// Query that matches everything
+event_catalog_query_t event_catalog_query_all(void);
+
+/*
+ * Pass every matching record to 'visit', partition by partition in day
+ * order. Returns false on a read error; 'stats' may be NULL.
+ */
+bool event_catalog_query(event_catalog_t *catalog, const event_catalog_query_t *query,
+                         event_catalog_visit_t visit, void *user, event_catalog_stats_t *stats);
+
+// Whether a record matches a query
+bool event_catalog_match(const event_catalog_query_t *query, const event_catalog_record_t *record);
+
+#endif /* IQ_LAB_EVENT_CATALOG_H */
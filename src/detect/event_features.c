@@ -0,0 +1,258 @@
+/*
+ * IQ Lab - Asynchronous Event Feature Extraction
+ *
+ * Event k goes to worker k mod W and comes back on that worker's done
+ * queue, so taking the results round-robin from the oldest restores the
+ * submit order without any locking.
+ */
+
+#include "event_features.h"
+#include "../iq_core/xlate.h"
+#include "../iq_core/profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Read, translate and decimate one event's span into the worker's snippet;
+// returns the samples after the filters' warm-up, 0 if there are none
+static size_t load_snippet(event_features_worker_t *worker, const cluster_event_t *event,
+                           double *output_rate, size_t *first) {
+    const event_features_t *pool = worker->pool;
+    const double rate = pool->sample_rate;
+    const uint32_t n = pool->fft_size;
+
+    // Span: from the start to the end of the last frame, from the beginning of the file
+    uint64_t start = event->start_time_s > 0.0 ? (uint64_t)(event->start_time_s * rate) : 0;
+    uint64_t end = (event->end_time_s > 0.0 ? (uint64_t)(event->end_time_s * rate) : 0) + n;
+    uint64_t total = worker->reader.total_samples;
+    if (total && end > total) end = total;
+    if (end <= start) return 0;
+    uint64_t count = end - start;
+    if (count > EVENT_FEATURES_MAX_SAMPLES) count = EVENT_FEATURES_MAX_SAMPLES;
+    if (count < FEATURES_IQ_MIN_SAMPLES) return 0;
+
+    // Band: the event's bins around DC, the rate a little above their width
+    double span_hz = (double)(event->max_bin - event->min_bin + 1) * rate / n;
+    double offset_hz = (0.5 * (event->min_bin + event->max_bin) / n - 0.5) * rate;
+    double factor = floor(rate / (EVENT_FEATURES_OVERSAMPLE * span_hz));
+    uint32_t decimation = factor >= 1.0 ? (uint32_t)fmin(factor, 1u << 20) : 1;
+    if (decimation > count / (2 * FEATURES_IQ_MIN_SAMPLES)) {
+        decimation = (uint32_t)(count / (2 * FEATURES_IQ_MIN_SAMPLES));
+    }
+    if (decimation == 0) decimation = 1;
+
+    xlate_t xlate;
+    if (!xlate_init(&xlate, rate, offset_hz, decimation, span_hz)) return 0;
+    *output_rate = xlate_output_rate(&xlate);
+
+    // Read the filters' delay ahead of the start; its outputs are dropped
+    uint64_t lead = (uint64_t)ceil(xlate.delay);
+    if (lead > start) lead = start;
+    *first = (size_t)(lead / decimation);
+
+    size_t written = 0;
+    uint64_t remaining = count + lead;
+    bool ok = iq_reader_seek_sample(&worker->reader, start - lead);
+    while (ok && remaining > 0) {
+        size_t want = remaining < EVENT_FEATURES_READ_SAMPLES ? (size_t)remaining : EVENT_FEATURES_READ_SAMPLES;
+        if (written + want / decimation + 1 > worker->output_capacity) break;
+        size_t got = iq_read_samples(&worker->reader, worker->input, want);
+        if (got == 0) break;
+        written += xlate_process(&xlate, worker->input, got, worker->output + 2 * written);
+        remaining -= got;
+    }
+    xlate_free(&xlate);
+
+    return ok && written > *first ? written - *first : 0;
+}
+
+// Drop the quiet ends of a snippet: the event's first and last frames reach
+// past the burst, and the on/off edges would read as amplitude modulation
+static size_t trim_to_burst(const float *iq, size_t count, size_t *first) {
+    const size_t w = EVENT_FEATURES_TRIM_WINDOW;
+    if (count < FEATURES_IQ_MIN_SAMPLES + 2 * w) return count;
+
+    double total = 0.0;
+    for (size_t n = 0; n < count; n++) total += iq[2 * n] * iq[2 * n] + iq[2 * n + 1] * iq[2 * n + 1];
+    const double threshold = EVENT_FEATURES_TRIM_FRACTION * total / count * w;
+
+    // Slide a window of w samples in from each end until it reaches the threshold
+    size_t begin = 0, end = count;
+    double sum = 0.0;
+    for (size_t n = 0; n < w; n++) sum += iq[2 * n] * iq[2 * n] + iq[2 * n + 1] * iq[2 * n + 1];
+    while (begin + w < end && sum < threshold) {
+        sum -= iq[2 * begin] * iq[2 * begin] + iq[2 * begin + 1] * iq[2 * begin + 1];
+        sum += iq[2 * (begin + w)] * iq[2 * (begin + w)] + iq[2 * (begin + w) + 1] * iq[2 * (begin + w) + 1];
+        begin++;
+    }
+    sum = 0.0;
+    for (size_t n = end - w; n < end; n++) sum += iq[2 * n] * iq[2 * n] + iq[2 * n + 1] * iq[2 * n + 1];
+    while (end > begin + w && sum < threshold) {
+        end--;
+        sum -= iq[2 * end] * iq[2 * end] + iq[2 * end + 1] * iq[2 * end + 1];
+        sum += iq[2 * (end - w)] * iq[2 * (end - w)] + iq[2 * (end - w) + 1] * iq[2 * (end - w) + 1];
+    }
+
+    if (end - begin < FEATURES_IQ_MIN_SAMPLES) return count;
+    *first += begin;
+    return end - begin;
+}
+
+static void *event_features_worker(void *arg) {
+    event_features_worker_t *worker = arg;
+    char name[32];
+    snprintf(name, sizeof(name), "features %u", worker->index);
+    iq_trace_thread_name(name);
+
+    for (;;) {
+        event_features_job_t *job = iq_spsc_pop(&worker->jobs);
+        if (!job) break;
+
+        double output_rate = 0.0;
+        size_t first = 0;
+        size_t count = load_snippet(worker, &job->event, &output_rate, &first);
+        count = trim_to_burst(worker->output + 2 * first, count, &first);
+        job->valid = count >= FEATURES_IQ_MIN_SAMPLES &&
+                     features_extract_from_iq(&worker->features, worker->output + 2 * first,
+                                              (uint32_t)count, output_rate, &job->result);
+        cyclo_features_t cyclic;
+        job->refined = job->valid &&
+                       cyclo_analyze(&worker->cyclo, worker->output + 2 * first, (uint32_t)count,
+                                     output_rate, &cyclic) &&
+                       cyclo_refine_modulation(&cyclic, &job->result);
+        iq_spsc_push(&worker->done, job);
+    }
+    return NULL;
+}
+
+// Pass the oldest event on once its worker is done (waiting for it if asked)
+static bool emit_next(event_features_t *pool, bool wait) {
+    if (pool->emitted == pool->submitted) return false;
+    event_features_worker_t *worker = &pool->workers[pool->emitted % pool->num_workers];
+
+    void *item;
+    if (wait) {
+        item = iq_spsc_pop(&worker->done);
+    } else if (!iq_spsc_try_pop(&worker->done, &item)) {
+        return false;
+    }
+
+    event_features_job_t *job = item;
+    if (job->valid) {
+        job->event.modulation_guess = job->result.modulation_hint;
+        job->event.modulation_confidence = job->result.modulation_confidence;
+        pool->classified++;
+        if (job->refined) pool->refined++;
+    }
+    pool->emitted++;
+    pool->sink(&job->event, pool->user);
+    return true;
+}
+
+event_features_t *event_features_create(const char *input_file, double sample_rate,
+                                        uint32_t fft_size, uint32_t num_workers,
+                                        cluster_event_sink_t sink, void *user) {
+    if (!input_file || !(sample_rate > 0.0) || fft_size == 0 || !sink ||
+        num_workers == 0 || num_workers > EVENT_FEATURES_MAX_WORKERS) {
+        fprintf(stderr, "Invalid event feature parameters (1 to %d workers)\n", EVENT_FEATURES_MAX_WORKERS);
+        return NULL;
+    }
+
+    event_features_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) return NULL;
+    pool->sample_rate = sample_rate;
+    pool->fft_size = fft_size;
+    pool->num_workers = num_workers;
+    pool->sink = sink;
+    pool->user = user;
+    pool->num_jobs = num_workers * EVENT_FEATURES_QUEUE_DEPTH;
+    pool->jobs = calloc(pool->num_jobs, sizeof(*pool->jobs));
+    pool->workers = calloc(num_workers, sizeof(*pool->workers));
+    bool ok = pool->jobs && pool->workers;
+
+    // The snippet holds every output of a full span read at decimation 1
+    const size_t capacity = EVENT_FEATURES_MAX_SAMPLES + EVENT_FEATURES_READ_SAMPLES + 1;
+    for (uint32_t w = 0; ok && w < num_workers; w++) {
+        event_features_worker_t *worker = &pool->workers[w];
+        worker->pool = pool;
+        worker->index = w;
+        worker->output_capacity = capacity;
+        worker->input = malloc(2 * EVENT_FEATURES_READ_SAMPLES * sizeof(float));
+        worker->output = malloc(2 * capacity * sizeof(float));
+        ok = worker->input && worker->output &&
+             iq_spsc_init(&worker->jobs, EVENT_FEATURES_QUEUE_DEPTH + 1) &&
+             iq_spsc_init(&worker->done, EVENT_FEATURES_QUEUE_DEPTH + 1) &&
+             features_init(&worker->features, fft_size, sample_rate, 0) &&
+             cyclo_init(&worker->cyclo, CYCLO_DEFAULT_CHANNELS, CYCLO_DEFAULT_BLOCKS);
+        if (ok) {
+            worker->reader_open = iq_reader_open(&worker->reader, input_file);
+            if (!worker->reader_open) {
+                fprintf(stderr, "Event features: cannot open %s\n", input_file);
+                ok = false;
+            } else if (worker->reader.stream) {
+                fprintf(stderr, "Event features need a seekable input, not a live stream\n");
+                ok = false;
+            }
+        }
+    }
+    for (uint32_t w = 0; ok && w < num_workers; w++) {
+        event_features_worker_t *worker = &pool->workers[w];
+        worker->started = pthread_create(&worker->thread, NULL, event_features_worker, worker) == 0;
+        ok = worker->started;
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Failed to start event feature extraction\n");
+        event_features_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void event_features_submit(event_features_t *pool, const cluster_event_t *event) {
+    if (pool->submitted - pool->emitted == pool->num_jobs) {
+        emit_next(pool, true);
+    }
+
+    event_features_job_t *job = &pool->jobs[pool->submitted % pool->num_jobs];
+    job->event = *event;
+    job->valid = false;
+    job->refined = false;
+    iq_spsc_push(&pool->workers[pool->submitted % pool->num_workers].jobs, job);
+    pool->submitted++;
+
+    while (emit_next(pool, false)) {
+    }
+}
+
+void event_features_flush(event_features_t *pool) {
+    if (!pool) return;
+    while (emit_next(pool, true)) {
+    }
+}
+
+void event_features_destroy(event_features_t *pool) {
+    if (!pool) return;
+
+    for (uint32_t w = 0; pool->workers && w < pool->num_workers; w++) {
+        event_features_worker_t *worker = &pool->workers[w];
+        if (!worker->started) continue;
+        // The done queue holds every job in flight, so the worker never waits on it
+        iq_spsc_push(&worker->jobs, NULL);
+        pthread_join(worker->thread, NULL);
+    }
+    for (uint32_t w = 0; pool->workers && w < pool->num_workers; w++) {
+        event_features_worker_t *worker = &pool->workers[w];
+        if (worker->reader_open) iq_reader_close(&worker->reader);
+        features_free(&worker->features);
+        cyclo_free(&worker->cyclo);
+        iq_spsc_free(&worker->jobs);
+        iq_spsc_free(&worker->done);
+        free(worker->input);
+        free(worker->output);
+    }
+    free(pool->workers);
+    free(pool->jobs);
+    free(pool);
+}
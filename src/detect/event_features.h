@@ -0,0 +1,140 @@
+/*
+ * IQ Lab - Asynchronous Event Feature Extraction Header
+ *
+ * Purpose: Classify closed events from their samples without stalling detection
+ *
+ *
+ * The spectral path only knows an event by its detections; a modulation
+ * guess from the samples (features_extract_from_iq) needs the event's span
+ * read back from the file, mixed to DC and decimated to its band, which is
+ * too slow for the detection loop. The pool takes closed events from the
+ * cluster sink, hands them round-robin to worker threads over SPSC queues
+ * and passes them on to the real sink in the order they closed, with the
+ * modulation guess and confidence from the samples when the extraction
+ * succeeds (the spectral guess is kept otherwise).
+ *
+ * Each worker has its own reader on the input, translating decimator
+ * (xlate.h) and feature extractor:
+ * - Samples: from the event's start to the end of its last frame, at most
+ *   EVENT_FEATURES_MAX_SAMPLES of them
+ * - Band: the event's bins [min_bin, max_bin] moved to DC, decimated to
+ *   about EVENT_FEATURES_OVERSAMPLE times their width (at least
+ *   2 * FEATURES_IQ_MIN_SAMPLES outputs), with the filters' warm-up read
+ *   ahead of the start and dropped
+ * - Ends: the first and last frames reach past the burst; leading and
+ *   trailing stretches whose power stays under EVENT_FEATURES_TRIM_FRACTION
+ *   of the snippet's mean are cut, so on/off edges do not read as AM
+ * - Cyclic features: snippets of at least one segment also go through the
+ *   FFT accumulation method (cyclo.h), whose symbol-rate and conjugate
+ *   peaks turn "unknown" or "noise" into "bpsk" / "psk" and a keyed FM
+ *   carrier into "fsk"
+ *
+ * Usage:
+ *   event_features_t *pool = event_features_create(path, rate, fft_size, 4, sink, user);
+ *   cluster_set_event_sink(&cluster, submit_to_pool, pool);
+ *   ... detection; submit calls event_features_submit(pool, event) ...
+ *   event_features_flush(pool);          // every event has reached 'sink'
+ *   event_features_destroy(pool);
+ *
+ * Technical Details:
+ * - The input must be seekable (a file or a published source, not a live
+ *   stream); every worker opens it again
+ * - Event times are taken from the start of the file
+ * - At most EVENT_FEATURES_QUEUE_DEPTH events per worker are in flight;
+ *   a submit beyond that waits for the oldest one and passes it on
+ * - Results depend only on the event, not on the worker count or timing
+ *
+ * Memory: per worker a reader, one read block, one decimated snippet and
+ *         the cyclic estimator's grids (about 0.5 MB)
+ * Thread Safety: submit, flush and destroy from one thread; the sink runs
+ *                on that thread
+ */
+
+#ifndef IQ_LAB_EVENT_FEATURES_H
+#define IQ_LAB_EVENT_FEATURES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "cluster.h"
+#include "features.h"
+#include "cyclo.h"
+#include "../iq_core/io_iq.h"
+#include "../iq_core/spsc_queue.h"
+
+#define EVENT_FEATURES_MAX_SAMPLES (1u << 19)  // Input samples read per event
+#define EVENT_FEATURES_READ_SAMPLES 16384      // Input samples per read
+#define EVENT_FEATURES_QUEUE_DEPTH 16          // Events in flight per worker
+#define EVENT_FEATURES_OVERSAMPLE 1.25         // Decimated rate over the event's bin span
+#define EVENT_FEATURES_TRIM_WINDOW 16          // Decimated samples per edge power measurement
+#define EVENT_FEATURES_TRIM_FRACTION 0.1       // Edges quieter than this share of the mean power are dropped
+#define EVENT_FEATURES_MAX_WORKERS 64
+
+// One event on its way through the pool
+typedef struct {
+    cluster_event_t event;       // As closed by the cluster engine
+    bool valid;                  // Extraction succeeded; 'result' holds it
+    features_result_t result;    // Features of the decimated snippet
+    bool refined;                // The cyclic features changed result's hint
+} event_features_job_t;
+
+typedef struct event_features_t event_features_t;
+
+// Worker thread state
+typedef struct {
+    event_features_t *pool;
+    uint32_t index;
+    pthread_t thread;
+    bool started;
+    iq_spsc_t jobs;              // Main thread -> worker (NULL stops it)
+    iq_spsc_t done;              // Worker -> main thread, in submit order
+    iq_reader_t reader;          // Own reader on the input
+    bool reader_open;
+    features_t features;
+    cyclo_t cyclo;               // Cyclic features of the same snippet
+    float *input;                // EVENT_FEATURES_READ_SAMPLES interleaved samples
+    float *output;               // Decimated snippet
+    size_t output_capacity;      // Samples 'output' holds
+} event_features_worker_t;
+
+// Worker pool
+struct event_features_t {
+    double sample_rate;          // Input rate (Hz)
+    uint32_t fft_size;           // Bin grid of the events
+    uint32_t num_workers;
+    cluster_event_sink_t sink;   // Receives the events, in order
+    void *user;
+
+    event_features_job_t *jobs;  // Ring of num_workers * EVENT_FEATURES_QUEUE_DEPTH
+    uint32_t num_jobs;
+    event_features_worker_t *workers;
+
+    uint64_t submitted;          // Events taken
+    uint64_t emitted;            // ... passed to the sink
+    uint64_t classified;         // ... with features from the samples
+    uint64_t refined;            // ... whose hint the cyclic features changed
+};
+
+/*
+ * Start num_workers threads (1 .. EVENT_FEATURES_MAX_WORKERS) on an input
+ * of the given rate, for events on an fft_size bin grid
+ * Returns NULL (with a message on stderr) if the input cannot be opened,
+ * on invalid parameters or on no memory.
+ */
+event_features_t *event_features_create(const char *input_file, double sample_rate,
+                                        uint32_t fft_size, uint32_t num_workers,
+                                        cluster_event_sink_t sink, void *user);
+
+/*
+ * Queue a closed event (copied); passes every event that is complete by
+ * now to the sink, and waits for the oldest one first if the pool is full
+ */
+void event_features_submit(event_features_t *pool, const cluster_event_t *event);
+
+// Wait for every queued event and pass it to the sink; NULL is ignored
+void event_features_flush(event_features_t *pool);
+
+// Stop the workers and free the pool (events not flushed are dropped); NULL is ignored
+void event_features_destroy(event_features_t *pool);
+
+#endif /* IQ_LAB_EVENT_FEATURES_H */
@@ -0,0 +1,413 @@
+/*
+ * IQ Lab - Binary Columnar Event Log
+ *
+ * The writer fills one array per column and writes a block as its header,
+ * the names it introduced, then each column in turn. The reader fetches a
+ * block's columns with a single read into one buffer and points the
+ * column arrays into it; a block its filter rules out costs one header
+ * read, the (usually empty) name list and a seek.
+ */
+
+#include "event_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define EVENT_LOG_MAGIC "IQEVLOG1"
+#define EVENT_LOG_BLOCK_MAGIC "EVBK"
+#define EVENT_LOG_BYTE_ORDER 0x01020304u
+#define EVENT_LOG_VERSION 1u
+#define EVENT_LOG_MAX_BLOCK (1u << 24)  // Larger counts mean a damaged header
+
+// Columns in file order
+enum {
+    COL_START, COL_END, COL_DURATION, COL_CENTER, COL_BANDWIDTH,
+    COL_PEAK_SNR, COL_AVG_SNR, COL_PEAK_POWER, COL_CONFIDENCE, COL_MOD_CONFIDENCE,
+    F64_COLUMNS
+};
+enum { COL_MIN_BIN, COL_MAX_BIN, COL_DETECTIONS, U32_COLUMNS };
+
+#define EVENT_BYTES (F64_COLUMNS * sizeof(double) + U32_COLUMNS * sizeof(uint32_t) + sizeof(uint16_t))
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+} event_log_file_header_t;
+
+typedef struct {
+    char magic[4];
+    uint32_t count;
+    uint32_t names;             // Dictionary entries introduced here
+    uint32_t name_bytes;        // Bytes of those entries
+    uint64_t column_bytes;
+    double t_min, t_max, f_min, f_max, snr_max;
+} event_log_block_header_t;
+
+_Static_assert(sizeof(event_log_file_header_t) == 16, "file header layout");
+_Static_assert(sizeof(event_log_block_header_t) == 64, "block header layout");
+
+struct event_log_writer {
+    FILE *file;
+    uint32_t capacity;          // Events per block
+    uint32_t count;             // Events buffered
+    double *f64;                // F64_COLUMNS columns of 'capacity'
+    uint32_t *u32;              // U32_COLUMNS columns of 'capacity'
+    uint16_t *modulation;
+    char *names[EVENT_LOG_MAX_MODULATIONS];  // Code k is names[k - 1]
+    uint32_t num_names;
+    uint32_t names_written;     // Names already in an earlier block
+    const char *last_name;      // Last string seen, usually a literal
+    uint16_t last_code;
+    bool failed;
+};
+
+struct event_log_reader {
+    FILE *file;
+    char *names[EVENT_LOG_MAX_MODULATIONS];
+    uint32_t num_names;
+    unsigned char *columns;     // One block of columns
+    size_t columns_capacity;
+    uint64_t blocks_read;
+    uint64_t blocks_skipped;
+    bool failed;
+};
+
+// =============================================================================
+// Writing
+// =============================================================================
+
+event_log_writer_t *event_log_create(const char *path, uint32_t block_events) {
+    if (!path) return NULL;
+    if (block_events == 0) block_events = EVENT_LOG_BLOCK_EVENTS;
+    if (block_events > EVENT_LOG_MAX_BLOCK) block_events = EVENT_LOG_MAX_BLOCK;
+
+    event_log_writer_t *log = calloc(1, sizeof(*log));
+    if (!log) return NULL;
+    log->capacity = block_events;
+    log->f64 = malloc((size_t)F64_COLUMNS * block_events * sizeof(double));
+    log->u32 = malloc((size_t)U32_COLUMNS * block_events * sizeof(uint32_t));
+    log->modulation = malloc(block_events * sizeof(uint16_t));
+    log->file = fopen(path, "wb");
+    if (!log->f64 || !log->u32 || !log->modulation || !log->file) {
+        fprintf(stderr, "Failed to create event log: %s\n", path);
+        if (log->file) fclose(log->file);
+        free(log->f64);
+        free(log->u32);
+        free(log->modulation);
+        free(log);
+        return NULL;
+    }
+
+    event_log_file_header_t header;
+    memcpy(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic));
+    header.byte_order = EVENT_LOG_BYTE_ORDER;
+    header.version = EVENT_LOG_VERSION;
+    log->failed = fwrite(&header, sizeof(header), 1, log->file) != 1;
+    return log;
+}
+
+// Dictionary code of a name, adding it if new (0 for none or a full dictionary)
+static uint16_t event_log_code(event_log_writer_t *log, const char *name) {
+    if (!name) return 0;
+    if (name == log->last_name) return log->last_code;
+
+    uint32_t code = 0;
+    for (uint32_t k = 0; k < log->num_names; k++) {
+        if (strncmp(log->names[k], name, EVENT_LOG_MAX_NAME) == 0) {
+            code = k + 1;
+            break;
+        }
+    }
+    if (code == 0 && log->num_names < EVENT_LOG_MAX_MODULATIONS) {
+        size_t length = strlen(name);
+        if (length > EVENT_LOG_MAX_NAME) length = EVENT_LOG_MAX_NAME;
+        char *copy = malloc(length + 1);
+        if (!copy) return 0;
+        memcpy(copy, name, length);
+        copy[length] = '\0';
+        log->names[log->num_names++] = copy;
+        code = log->num_names;
+    }
+
+    log->last_name = name;
+    log->last_code = (uint16_t)code;
+    return (uint16_t)code;
+}
+
+bool event_log_append(event_log_writer_t *log, const cluster_event_t *event) {
+    if (!log || !event) return false;
+
+    uint32_t i = log->count;
+    size_t n = log->capacity;
+    log->f64[COL_START * n + i] = event->start_time_s;
+    log->f64[COL_END * n + i] = event->end_time_s;
+    log->f64[COL_DURATION * n + i] = event->duration_s;
+    log->f64[COL_CENTER * n + i] = event->center_freq_hz;
+    log->f64[COL_BANDWIDTH * n + i] = event->bandwidth_hz;
+    log->f64[COL_PEAK_SNR * n + i] = event->peak_snr_db;
+    log->f64[COL_AVG_SNR * n + i] = event->avg_snr_db;
+    log->f64[COL_PEAK_POWER * n + i] = event->peak_power_dbfs;
+    log->f64[COL_CONFIDENCE * n + i] = event->confidence;
+    log->f64[COL_MOD_CONFIDENCE * n + i] = event->modulation_confidence;
+    log->u32[COL_MIN_BIN * n + i] = event->min_bin;
+    log->u32[COL_MAX_BIN * n + i] = event->max_bin;
+    log->u32[COL_DETECTIONS * n + i] = event->num_detections;
+    log->modulation[i] = event_log_code(log, event->modulation_guess);
+    log->count++;
+
+    if (log->count == log->capacity) {
+        return event_log_flush(log);
+    }
+    return !log->failed;
+}
+
+bool event_log_flush(event_log_writer_t *log) {
+    if (!log) return false;
+    if (log->count == 0) return !log->failed;
+
+    uint32_t count = log->count;
+    size_t n = log->capacity;
+    event_log_block_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EVENT_LOG_BLOCK_MAGIC, sizeof(header.magic));
+    header.count = count;
+    header.names = log->num_names - log->names_written;
+    header.column_bytes = (uint64_t)count * EVENT_BYTES;
+    header.t_min = header.f_min = INFINITY;
+    header.t_max = header.f_max = header.snr_max = -INFINITY;
+    for (uint32_t i = 0; i < count; i++) {
+        double half = log->f64[COL_BANDWIDTH * n + i] / 2.0;
+        double center = log->f64[COL_CENTER * n + i];
+        header.t_min = fmin(header.t_min, log->f64[COL_START * n + i]);
+        header.t_max = fmax(header.t_max, log->f64[COL_END * n + i]);
+        header.f_min = fmin(header.f_min, center - half);
+        header.f_max = fmax(header.f_max, center + half);
+        header.snr_max = fmax(header.snr_max, log->f64[COL_PEAK_SNR * n + i]);
+    }
+    for (uint32_t k = log->names_written; k < log->num_names; k++) {
+        header.name_bytes += 1 + (uint32_t)strlen(log->names[k]);
+    }
+
+    FILE *file = log->file;
+    bool ok = !log->failed && fwrite(&header, sizeof(header), 1, file) == 1;
+    for (uint32_t k = log->names_written; ok && k < log->num_names; k++) {
+        uint8_t length = (uint8_t)strlen(log->names[k]);
+        ok = fwrite(&length, 1, 1, file) == 1 && fwrite(log->names[k], 1, length, file) == length;
+    }
+    for (int c = 0; ok && c < F64_COLUMNS; c++) {
+        ok = fwrite(log->f64 + c * n, sizeof(double), count, file) == count;
+    }
+    for (int c = 0; ok && c < U32_COLUMNS; c++) {
+        ok = fwrite(log->u32 + c * n, sizeof(uint32_t), count, file) == count;
+    }
+    ok = ok && fwrite(log->modulation, sizeof(uint16_t), count, file) == count;
+
+    log->names_written = log->num_names;
+    log->count = 0;
+    log->failed = !ok;
+    return ok;
+}
+
+bool event_log_close(event_log_writer_t *log) {
+    if (!log) return false;
+    bool ok = event_log_flush(log);
+    if (fclose(log->file) != 0) ok = false;
+    for (uint32_t k = 0; k < log->num_names; k++) free(log->names[k]);
+    free(log->f64);
+    free(log->u32);
+    free(log->modulation);
+    free(log);
+    return ok;
+}
+
+// =============================================================================
+// Reading
+// =============================================================================
+
+event_log_reader_t *event_log_open(const char *path) {
+    if (!path) return NULL;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open event log: %s\n", path);
+        return NULL;
+    }
+    event_log_file_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != EVENT_LOG_VERSION) {
+        fprintf(stderr, "Not an event log: %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+    if (header.byte_order != EVENT_LOG_BYTE_ORDER) {
+        fprintf(stderr, "Event log written with the other byte order: %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    event_log_reader_t *log = calloc(1, sizeof(*log));
+    if (!log) {
+        fclose(file);
+        return NULL;
+    }
+    log->file = file;
+    return log;
+}
+
+// Read the names a block introduces into the dictionary
+static bool event_log_read_names(event_log_reader_t *log, const event_log_block_header_t *header) {
+    if (header->names > EVENT_LOG_MAX_MODULATIONS - log->num_names) return false;
+
+    uint32_t bytes = 0;
+    for (uint32_t k = 0; k < header->names; k++) {
+        uint8_t length;
+        if (fread(&length, 1, 1, log->file) != 1) return false;
+        char *name = malloc((size_t)length + 1);
+        if (!name) return false;
+        if (fread(name, 1, length, log->file) != length) {
+            free(name);
+            return false;
+        }
+        name[length] = '\0';
+        log->names[log->num_names++] = name;
+        bytes += 1u + length;
+    }
+    return bytes == header->name_bytes;
+}
+
+static bool event_log_overlaps(const event_log_filter_t *filter, const event_log_block_header_t *header) {
+    return header->t_max >= filter->t_min && header->t_min <= filter->t_max &&
+           header->f_max >= filter->f_min && header->f_min <= filter->f_max &&
+           header->snr_max >= filter->min_snr_db;
+}
+
+bool event_log_next(event_log_reader_t *log, const event_log_filter_t *filter,
+                    event_log_block_t *block) {
+    if (!log || !block || log->failed) return false;
+
+    for (;;) {
+        event_log_block_header_t header;
+        size_t got = fread(&header, 1, sizeof(header), log->file);
+        if (got == 0 && feof(log->file)) {
+            return false;
+        }
+        if (got != sizeof(header) || memcmp(header.magic, EVENT_LOG_BLOCK_MAGIC, 4) != 0 ||
+            header.count == 0 || header.count > EVENT_LOG_MAX_BLOCK ||
+            header.column_bytes != (uint64_t)header.count * EVENT_BYTES ||
+            !event_log_read_names(log, &header)) {
+            log->failed = true;
+            return false;
+        }
+
+        if (filter && !event_log_overlaps(filter, &header)) {
+            if (fseek(log->file, (long)header.column_bytes, SEEK_CUR) != 0) {
+                log->failed = true;
+                return false;
+            }
+            log->blocks_skipped++;
+            continue;
+        }
+
+        size_t bytes = (size_t)header.column_bytes;
+        if (bytes > log->columns_capacity) {
+            unsigned char *grown = realloc(log->columns, bytes);
+            if (!grown) {
+                log->failed = true;
+                return false;
+            }
+            log->columns = grown;
+            log->columns_capacity = bytes;
+        }
+        if (fread(log->columns, 1, bytes, log->file) != bytes) {
+            log->failed = true;
+            return false;
+        }
+        log->blocks_read++;
+
+        uint32_t n = header.count;
+        const double *f64 = (const double *)log->columns;
+        const uint32_t *u32 = (const uint32_t *)(log->columns + (size_t)F64_COLUMNS * n * sizeof(double));
+        block->count = n;
+        block->t_min = header.t_min;
+        block->t_max = header.t_max;
+        block->f_min = header.f_min;
+        block->f_max = header.f_max;
+        block->snr_max = header.snr_max;
+        block->start_time_s = f64 + (size_t)COL_START * n;
+        block->end_time_s = f64 + (size_t)COL_END * n;
+        block->duration_s = f64 + (size_t)COL_DURATION * n;
+        block->center_freq_hz = f64 + (size_t)COL_CENTER * n;
+        block->bandwidth_hz = f64 + (size_t)COL_BANDWIDTH * n;
+        block->peak_snr_db = f64 + (size_t)COL_PEAK_SNR * n;
+        block->avg_snr_db = f64 + (size_t)COL_AVG_SNR * n;
+        block->peak_power_dbfs = f64 + (size_t)COL_PEAK_POWER * n;
+        block->confidence = f64 + (size_t)COL_CONFIDENCE * n;
+        block->modulation_confidence = f64 + (size_t)COL_MOD_CONFIDENCE * n;
+        block->min_bin = u32 + (size_t)COL_MIN_BIN * n;
+        block->max_bin = u32 + (size_t)COL_MAX_BIN * n;
+        block->num_detections = u32 + (size_t)COL_DETECTIONS * n;
+        block->modulation = (const uint16_t *)(u32 + (size_t)U32_COLUMNS * n);
+        return true;
+    }
+}
+
+bool event_log_failed(const event_log_reader_t *log) {
+    return !log || log->failed;
+}
+
+void event_log_stats(const event_log_reader_t *log, uint64_t *blocks_read, uint64_t *blocks_skipped) {
+    if (blocks_read) *blocks_read = log ? log->blocks_read : 0;
+    if (blocks_skipped) *blocks_skipped = log ? log->blocks_skipped : 0;
+}
+
+const char *event_log_modulation(const event_log_reader_t *log, uint16_t code) {
+    if (!log || code == 0 || code > log->num_names) return NULL;
+    return log->names[code - 1];
+}
+
+bool event_log_event(const event_log_reader_t *log, const event_log_block_t *block,
+                     uint32_t index, cluster_event_t *event) {
+    if (!block || !event || index >= block->count) return false;
+
+    memset(event, 0, sizeof(*event));
+    event->start_time_s = block->start_time_s[index];
+    event->end_time_s = block->end_time_s[index];
+    event->duration_s = block->duration_s[index];
+    event->min_bin = block->min_bin[index];
+    event->max_bin = block->max_bin[index];
+    event->center_freq_hz = block->center_freq_hz[index];
+    event->bandwidth_hz = block->bandwidth_hz[index];
+    event->peak_snr_db = block->peak_snr_db[index];
+    event->avg_snr_db = block->avg_snr_db[index];
+    event->peak_power_dbfs = block->peak_power_dbfs[index];
+    event->num_detections = block->num_detections[index];
+    event->confidence = block->confidence[index];
+    event->modulation_confidence = block->modulation_confidence[index];
+    event->modulation_guess = event_log_modulation(log, block->modulation[index]);
+    return true;
+}
+
+void event_log_close_reader(event_log_reader_t *log) {
+    if (!log) return;
+    fclose(log->file);
+    for (uint32_t k = 0; k < log->num_names; k++) free(log->names[k]);
+    free(log->columns);
+    free(log);
+}
+
+event_log_filter_t event_log_filter_all(void) {
+    event_log_filter_t filter = {-INFINITY, INFINITY, -INFINITY, INFINITY, -INFINITY};
+    return filter;
+}
+
+bool event_log_match(const event_log_filter_t *filter, const event_log_block_t *block, uint32_t index) {
+    if (!filter) return true;
+    double half = block->bandwidth_hz[index] / 2.0;
+    double center = block->center_freq_hz[index];
+    return block->end_time_s[index] >= filter->t_min && block->start_time_s[index] <= filter->t_max &&
+           center + half >= filter->f_min && center - half <= filter->f_max &&
+           block->peak_snr_db[index] >= filter->min_snr_db;
+}
@@ -0,0 +1,154 @@
+/*
+ * IQ Lab - Binary Columnar Event Log Header
+ *
+ * Purpose: Store detection events compactly and scan them at memory speed
+ *
+ *
+ * CSV and JSONL event logs are read back one text field at a time, which
+ * dominates any report over months of runs. This format keeps the events
+ * of a log in blocks of up to EVENT_LOG_BLOCK_EVENTS, each field of
+ * cluster_event_t as one fixed-width column per block, so a reader loads a
+ * block with one read and works on plain arrays. Each block header carries
+ * the block's time, frequency and SNR range: a reader with a filter skips
+ * blocks outside it without reading their columns.
+ *
+ * File layout (host byte order, checked against a marker in the header):
+ *   file header   "IQEVLOG1", byte-order marker, version
+ *   per block     header (count, dictionary and column bytes, ranges)
+ *                 new modulation names (u8 length + bytes each)
+ *                 columns: 10 x f64, 3 x u32, 1 x u16 modulation code
+ *
+ * modulation_guess is dictionary-encoded: each distinct name is written
+ * once, in the block where it first appears, and events carry a 16-bit
+ * code (0 for none). The feature moments (features_accum_t) are not
+ * stored; the finalized fields of the event are.
+ *
+ * Usage:
+ *   event_log_writer_t *log = event_log_create("events.iqev", 0);
+ *   for each event: event_log_append(log, &event);
+ *   event_log_close(log);
+ *
+ *   event_log_reader_t *in = event_log_open("events.iqev");
+ *   event_log_filter_t filter = event_log_filter_all();
+ *   filter.f_min = 100e3; filter.f_max = 200e3;
+ *   event_log_block_t block;
+ *   while (event_log_next(in, &filter, &block))
+ *       for (i = 0; i < block.count; i++)
+ *           if (event_log_match(&filter, &block, i)) ... block.peak_snr_db[i] ...
+ *   event_log_close_reader(in);
+ *
+ * Memory: the writer holds one block of columns; the reader one block of
+ *         columns and the dictionary
+ * Thread Safety: one thread per writer or reader
+ */
+
+#ifndef IQ_LAB_EVENT_LOG_H
+#define IQ_LAB_EVENT_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cluster.h"
+
+#define EVENT_LOG_BLOCK_EVENTS 4096     // Default events per block
+#define EVENT_LOG_MAX_MODULATIONS 1024  // Distinct modulation names per log
+#define EVENT_LOG_MAX_NAME 255          // Longest stored name (longer ones are cut)
+
+typedef struct event_log_writer event_log_writer_t;
+typedef struct event_log_reader event_log_reader_t;
+
+/*
+ * One block of events as columns
+ * The column pointers stay valid until the next event_log_next() call.
+ */
+typedef struct {
+    uint32_t count;                     // Events in the block
+
+    // Ranges over the block's events
+    double t_min;                       // Earliest start_time_s
+    double t_max;                       // Latest end_time_s
+    double f_min;                       // Lowest lower band edge (centre - bw / 2)
+    double f_max;                       // Highest upper band edge
+    double snr_max;                     // Highest peak_snr_db
+
+    // Columns, one entry per event
+    const double *start_time_s;
+    const double *end_time_s;
+    const double *duration_s;
+    const double *center_freq_hz;
+    const double *bandwidth_hz;
+    const double *peak_snr_db;
+    const double *avg_snr_db;
+    const double *peak_power_dbfs;
+    const double *confidence;
+    const double *modulation_confidence;
+    const uint32_t *min_bin;
+    const uint32_t *max_bin;
+    const uint32_t *num_detections;
+    const uint16_t *modulation;         // Dictionary code, 0 for none
+} event_log_block_t;
+
+/*
+ * Events of interest: those overlapping [t_min, t_max] in time and
+ * [f_min, f_max] in frequency with peak SNR of at least min_snr_db
+ */
+typedef struct {
+    double t_min, t_max;
+    double f_min, f_max;
+    double min_snr_db;
+} event_log_filter_t;
+
+/*
+ * Create a log (replacing any file at 'path') with blocks of
+ * 'block_events' events (0 for EVENT_LOG_BLOCK_EVENTS). NULL on failure,
+ * with a message on stderr.
+ */
+event_log_writer_t *event_log_create(const char *path, uint32_t block_events);
+
+// Add one event; a full block is written out. False on a write error.
+bool event_log_append(event_log_writer_t *log, const cluster_event_t *event);
+
+// Write the events buffered so far as a (short) block
+bool event_log_flush(event_log_writer_t *log);
+
+// Flush, close and free; false if any write failed
+bool event_log_close(event_log_writer_t *log);
+
+/*
+ * Open a log for reading. NULL (with a message on stderr) if the file is
+ * missing, not an event log, or from a host of the other byte order.
+ */
+event_log_reader_t *event_log_open(const char *path);
+
+/*
+ * Load the next block that may hold events of 'filter' (NULL: every
+ * block). Returns false at the end of the log or on a damaged block; see
+ * event_log_failed().
+ */
+bool event_log_next(event_log_reader_t *log, const event_log_filter_t *filter,
+                    event_log_block_t *block);
+
+// Whether reading stopped at a damaged or truncated block
+bool event_log_failed(const event_log_reader_t *log);
+
+// Blocks loaded and blocks skipped by their ranges so far
+void event_log_stats(const event_log_reader_t *log, uint64_t *blocks_read, uint64_t *blocks_skipped);
+
+// Name of a modulation code (NULL for 0 or an unknown code)
+const char *event_log_modulation(const event_log_reader_t *log, uint16_t code);
+
+/*
+ * Rebuild event 'index' of a block; modulation_guess points into the
+ * reader's dictionary and the feature moments are zero
+ */
+bool event_log_event(const event_log_reader_t *log, const event_log_block_t *block,
+                     uint32_t index, cluster_event_t *event);
+
+void event_log_close_reader(event_log_reader_t *log);
+
+// Filter that passes every event
+event_log_filter_t event_log_filter_all(void);
+
+// Whether event 'index' of a block passes the filter
+bool event_log_match(const event_log_filter_t *filter, const event_log_block_t *block, uint32_t index);
+
+#endif /* IQ_LAB_EVENT_LOG_H */
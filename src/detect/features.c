@@ -41,6 +41,10 @@
 #include <math.h>
 #include <assert.h>
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 // Internal helper functions
 
 /*
@@ -204,6 +208,18 @@ static uint32_t detect_occupied_bandwidth(const double *power_spectrum, uint32_t
     return min_bandwidth;
 }
 
+/*
+ * Mean of the tracked per-bin floor over the signal bins
+ */
+static double tracked_noise_floor(const double *tracked_floor, uint32_t start_bin, uint32_t end_bin) {
+    double sum = 0.0;
+    for (uint32_t bin = start_bin; bin <= end_bin; bin++) {
+        sum += tracked_floor[bin];
+    }
+    double mean = sum / (end_bin - start_bin + 1);
+    return mean > 0.0 ? mean : 1e-12;
+}
+
 // Public API implementation
 
 bool features_init(features_t *features, uint32_t fft_size, double sample_rate_hz,
@@ -230,6 +246,7 @@ bool features_init(features_t *features, uint32_t fft_size, double sample_rate_h
     features->bandwidth_3db_threshold = 0.5;      // -3dB
     features->bandwidth_occupied_threshold = 0.99; // 99% occupied
 
+    features->tracked_floor = NULL;
     features->initialized = true;
     return true;
 }
@@ -269,10 +286,12 @@ bool features_extract_from_spectrum(features_t *features, const double *power_sp
         return false;
     }
 
-    // Estimate noise floor
-    double noise_floor = estimate_noise_floor_spectrum(power_spectrum, features->fft_size,
-                                                     signal_start, signal_end,
-                                                     features->noise_bins_margin);
+    // Noise floor: tracked across frames if available, else from the neighbours
+    double noise_floor = features->tracked_floor ?
+        tracked_noise_floor(features->tracked_floor, signal_start, signal_end) :
+        estimate_noise_floor_spectrum(power_spectrum, features->fft_size,
+                                      signal_start, signal_end,
+                                      features->noise_bins_margin);
 
     // Calculate SNR
     result->snr_db = features_calculate_snr(peak_power, noise_floor);
@@ -345,17 +364,115 @@ bool features_extract_from_spectrum(features_t *features, const double *power_sp
     return true;
 }
 
+void features_set_noise_floor(features_t *features, const double *tracked_floor) {
+    if (!features) return;
+    features->tracked_floor = tracked_floor;
+}
+
+// Time-domain classification thresholds (features_extract_from_iq)
+#define IQ_CONSTANT_ENVELOPE_RATIO 1.1   // M4 / M2^2 below this: constant envelope
+#define IQ_CW_SPREAD 0.05                // RMS frequency spread / rate below this: a carrier
+#define IQ_AM_CARRIER_FRACTION 0.3       // Power share of the carrier above this: AM
+#define IQ_NOISE_RATIO_MARGIN 0.15       // M4 / M2^2 within this of 2: Gaussian noise
+
 bool features_extract_from_iq(features_t *features, const float *iq_samples,
                               uint32_t num_samples, double sample_rate_hz,
                               features_result_t *result) {
-    // TODO: Implement time-domain feature extraction
-    // For now, return false to indicate not implemented
-    (void)features;
-    (void)iq_samples;
-    (void)num_samples;
-    (void)sample_rate_hz;
-    (void)result;
-    return false;
+    if (!features || !features->initialized || !iq_samples || !result ||
+        num_samples < FEATURES_IQ_MIN_SAMPLES || !(sample_rate_hz > 0.0)) {
+        if (result) result->valid = false;
+        return false;
+    }
+    memset(result, 0, sizeof(*result));
+
+    // Envelope moments and the lag-1 correlation, whose phase is the mean
+    // frequency and whose magnitude against M2 the spread around it
+    double m2 = 0.0, m4 = 0.0, peak = 0.0;
+    double r_re = 0.0, r_im = 0.0;
+    for (uint32_t n = 0; n < num_samples; n++) {
+        double i = iq_samples[2 * n], q = iq_samples[2 * n + 1];
+        double p = i * i + q * q;
+        m2 += p;
+        m4 += p * p;
+        if (p > peak) peak = p;
+        if (n > 0) {
+            double pi = iq_samples[2 * n - 2], pq = iq_samples[2 * n - 1];
+            r_re += i * pi + q * pq;
+            r_im += q * pi - i * pq;
+        }
+    }
+    if (!(m2 > 0.0) || !isfinite(m4)) {
+        result->valid = false;
+        return false;
+    }
+    double lag_power = m2 - 0.5 * (iq_samples[0] * iq_samples[0] + iq_samples[1] * iq_samples[1] +
+                                   iq_samples[2 * num_samples - 2] * iq_samples[2 * num_samples - 2] +
+                                   iq_samples[2 * num_samples - 1] * iq_samples[2 * num_samples - 1]);
+    double omega = atan2(r_im, r_re);
+    double rho = lag_power > 0.0 ? fmin(1.0, hypot(r_re, r_im) / lag_power) : 0.0;
+    double spread = sqrt(2.0 * (1.0 - rho)) / (2.0 * M_PI);  // Cycles per sample
+    m2 /= num_samples;
+    m4 /= num_samples;
+    double ratio = m4 / (m2 * m2);
+
+    // Carrier: the mean of the signal turned back by the mean frequency; the
+    // phasor is renormalized now and then so it stays on the unit circle
+    double c_re = 0.0, c_im = 0.0, w_re = 1.0, w_im = 0.0;
+    const double step_re = cos(omega), step_im = -sin(omega);
+    for (uint32_t n = 0; n < num_samples; n++) {
+        double i = iq_samples[2 * n], q = iq_samples[2 * n + 1];
+        c_re += i * w_re - q * w_im;
+        c_im += i * w_im + q * w_re;
+        double t = w_re * step_re - w_im * step_im;
+        w_im = w_re * step_im + w_im * step_re;
+        w_re = t;
+        if ((n & 1023) == 1023) {
+            double norm = hypot(w_re, w_im);
+            w_re /= norm;
+            w_im /= norm;
+        }
+    }
+    double carrier = (c_re * c_re + c_im * c_im) / ((double)num_samples * num_samples * m2);
+
+    // M2M4 estimate: exact for a constant envelope in Gaussian noise
+    double signal = 2.0 * m2 * m2 - m4;
+    signal = signal > 0.0 ? sqrt(signal) : 0.0;
+    double noise = m2 - signal;
+
+    result->avg_power_dbfs = 10.0 * log10(m2);
+    result->peak_power_dbfs = 10.0 * log10(peak);
+    result->peak_to_avg_ratio = 10.0 * log10(peak / m2);
+    result->snr_db = features_calculate_snr(signal, noise);
+    result->noise_floor_dbfs = noise > 0.0 ? 10.0 * log10(noise) : -INFINITY;
+    result->spectral_centroid = omega / (2.0 * M_PI);
+    result->spectral_spread = spread;
+    result->center_frequency_hz = result->spectral_centroid * sample_rate_hz;
+    result->bandwidth_hz = 2.0 * spread * sample_rate_hz;
+    result->total_bins = num_samples;
+
+    // Constant envelope: a carrier or FM; else a carrier with a moving
+    // envelope (AM), Gaussian noise, or nothing this can tell apart
+    double confidence;
+    if (ratio < IQ_CONSTANT_ENVELOPE_RATIO) {
+        result->modulation_hint = spread < IQ_CW_SPREAD ? "cw" : "fm";
+        confidence = 1.0 - 0.5 * (ratio - 1.0) / (IQ_CONSTANT_ENVELOPE_RATIO - 1.0);
+        if (spread >= IQ_CW_SPREAD) {
+            result->fm_deviation_hz = spread * sample_rate_hz * sqrt(2.0);  // Peak, sinusoidal tone
+        }
+    } else if (carrier > IQ_AM_CARRIER_FRACTION) {
+        result->modulation_hint = "am";
+        confidence = 0.5 + 0.5 * fmin(1.0, (carrier - IQ_AM_CARRIER_FRACTION) / (1.0 - IQ_AM_CARRIER_FRACTION));
+    } else if (fabs(ratio - 2.0) < IQ_NOISE_RATIO_MARGIN) {
+        result->modulation_hint = "noise";
+        confidence = 1.0 - 0.5 * fabs(ratio - 2.0) / IQ_NOISE_RATIO_MARGIN;
+    } else {
+        result->modulation_hint = "unknown";
+        confidence = 0.3;
+    }
+    result->modulation_confidence = fmax(0.0, fmin(1.0, confidence));
+
+    result->valid = true;
+    return true;
 }
 
 double features_calculate_snr(double signal_power, double noise_power) {
@@ -370,6 +487,10 @@ double features_estimate_noise_floor(const features_t *features, const double *p
     uint32_t signal_start = center_bin - bandwidth_bins / 2;
     uint32_t signal_end = center_bin + bandwidth_bins / 2;
 
+    if (features->tracked_floor && signal_start <= signal_end && signal_end < features->fft_size) {
+        return tracked_noise_floor(features->tracked_floor, signal_start, signal_end);
+    }
+
     return estimate_noise_floor_spectrum(power_spectrum, features->fft_size,
                                        signal_start, signal_end, features->noise_bins_margin);
 }
@@ -468,6 +589,94 @@ double features_calculate_spectral_flatness(const double *power_spectrum,
     return geometric_mean / arithmetic_mean;
 }
 
+void features_accum_reset(features_accum_t *acc) {
+    if (!acc) return;
+    memset(acc, 0, sizeof(*acc));
+}
+
+void features_accum_add(features_accum_t *acc, uint32_t bin, double power_db, double noise_db) {
+    if (!acc) return;
+
+    double power = pow(10.0, power_db / 10.0);
+    double bin_d = (double)bin;
+
+    if (acc->count == 0 || bin < acc->min_bin) acc->min_bin = bin;
+    if (acc->count == 0 || bin > acc->max_bin) acc->max_bin = bin;
+    if (power > acc->peak_power) acc->peak_power = power;
+
+    acc->power_sum += power;
+    acc->log_power_sum += power_db;
+    acc->noise_sum += pow(10.0, noise_db / 10.0);
+    acc->bin_power_sum += bin_d * power;
+    acc->bin_sq_power_sum += bin_d * bin_d * power;
+    acc->count++;
+}
+
+void features_accum_merge(features_accum_t *dest, const features_accum_t *src) {
+    if (!dest || !src || src->count == 0) return;
+
+    if (dest->count == 0 || src->min_bin < dest->min_bin) dest->min_bin = src->min_bin;
+    if (dest->count == 0 || src->max_bin > dest->max_bin) dest->max_bin = src->max_bin;
+    if (src->peak_power > dest->peak_power) dest->peak_power = src->peak_power;
+
+    dest->power_sum += src->power_sum;
+    dest->log_power_sum += src->log_power_sum;
+    dest->noise_sum += src->noise_sum;
+    dest->bin_power_sum += src->bin_power_sum;
+    dest->bin_sq_power_sum += src->bin_sq_power_sum;
+    dest->count += src->count;
+}
+
+bool features_accum_finalize(const features_accum_t *acc, uint32_t fft_size,
+                             double sample_rate_hz, features_result_t *result) {
+    if (!acc || !result || acc->count == 0 || fft_size == 0 || sample_rate_hz <= 0.0) {
+        return false;
+    }
+
+    memset(result, 0, sizeof(features_result_t));
+
+    double n = (double)acc->count;
+    double avg_power = acc->power_sum / n;
+    double noise_floor = acc->noise_sum / n;
+    double bin_hz = sample_rate_hz / fft_size;
+
+    // Signal quality
+    result->snr_db = features_calculate_snr(acc->peak_power, noise_floor);
+    result->peak_power_dbfs = 10.0 * log10(acc->peak_power);
+    result->avg_power_dbfs = 10.0 * log10(avg_power);
+    result->noise_floor_dbfs = 10.0 * log10(noise_floor);
+
+    // Bandwidth from the detected bin span
+    result->total_bins = acc->max_bin - acc->min_bin + 1;
+    result->bandwidth_occupied_hz = (double)result->total_bins * bin_hz;
+    result->bandwidth_hz = result->bandwidth_occupied_hz;
+
+    // Spectral characteristics; the geometric mean comes from the dB sum,
+    // which cannot underflow the way a running product would
+    result->peak_to_avg_ratio = 10.0 * log10(acc->peak_power / avg_power);
+    double geometric_mean = pow(10.0, acc->log_power_sum / n / 10.0);
+    result->spectral_flatness = fmin(geometric_mean / avg_power, 1.0);
+
+    if (acc->power_sum > 0.0) {
+        double centroid_bin = acc->bin_power_sum / acc->power_sum;
+        double variance = acc->bin_sq_power_sum / acc->power_sum - centroid_bin * centroid_bin;
+        result->spectral_centroid = centroid_bin / fft_size;
+        result->spectral_spread = sqrt(fmax(variance, 0.0)) / fft_size;
+        result->center_frequency_hz = centroid_bin * bin_hz;
+    }
+
+    result->signal_bins = acc->count;  // Detected cells, across all frames
+    result->valid = true;
+
+    // The moments only support a hint: modulation_confidence stays 0 (unrated)
+    result->modulation_hint = features_classify_modulation(result);
+    if (strcmp(result->modulation_hint, "fm") == 0) {
+        result->fm_deviation_hz = result->bandwidth_hz / 4.0;
+    }
+
+    return true;
+}
+
 void features_reset(features_t *features) {
     if (!features) return;
     // No dynamic state to reset currently
@@ -23,6 +23,12 @@
  *   features_extract_from_spectrum(&features, power_spectrum, center_bin, bandwidth_bins);
  *   double snr = features_get_snr(&features);
  *
+ * Incremental usage (features of a detection cluster, no spectrum rescans):
+ *   features_accum_t acc;
+ *   features_accum_reset(&acc);
+ *   per detection: features_accum_add(&acc, bin, power_db, noise_db);
+ *   features_accum_finalize(&acc, fft_size, sample_rate, &result);
+ *
  * Technical Details:
  * - SNR Calculation: Signal power vs local noise floor estimation
  * - Bandwidth Methods: -3dB points, 99% power containment, spectral edges
@@ -51,6 +57,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define FEATURES_IQ_MIN_SAMPLES 64   // Shortest segment features_extract_from_iq() classifies
+
 // Feature extraction result structure
 typedef struct {
     // Signal quality metrics
@@ -100,10 +108,27 @@ typedef struct {
     double bandwidth_3db_threshold;  // -3dB threshold relative to peak (0.5)
     double bandwidth_occupied_threshold; // Occupied bandwidth threshold (0.99)
 
+    // Shared noise floor
+    const double *tracked_floor;     // Per-bin floor (noise_floor_get), NULL to estimate
+
     // Internal state
     bool initialized;                // Whether extractor is properly initialized
 } features_t;
 
+// Running moments of a set of detected cells, updated one cell at a time
+// and mergeable, so a cluster's features are ready as soon as it closes
+typedef struct {
+    uint32_t count;                  // Cells accumulated
+    uint32_t min_bin;                // Lowest bin seen
+    uint32_t max_bin;                // Highest bin seen
+    double power_sum;                // Sum of linear power
+    double log_power_sum;            // Sum of power in dB (geometric mean)
+    double peak_power;               // Largest linear power
+    double noise_sum;                // Sum of linear noise reference levels
+    double bin_power_sum;            // Sum of bin * power (centroid)
+    double bin_sq_power_sum;         // Sum of bin^2 * power (spread)
+} features_accum_t;
+
 // Public API functions
 
 /*
@@ -138,18 +163,34 @@ bool features_extract_from_spectrum(features_t *features, const double *power_sp
                                    uint32_t center_bin, uint32_t bandwidth_bins,
                                    features_result_t *result);
 
+/*
+ * Read the noise floor from a per-bin tracker instead of the spectrum
+ * The array (fft_size linear powers, e.g. noise_floor_get()) must stay valid
+ * while it is set; NULL returns to estimating from neighbouring bins.
+ */
+void features_set_noise_floor(features_t *features, const double *tracked_floor);
+
 /*
  * Extract features from a signal segment in time domain
  *
+ * Meant for an event's samples mixed to DC and decimated to about its
+ * bandwidth (iqdetect --iq-features). Classifies from the envelope's
+ * M4 / M2^2 (1 for a constant envelope, 2 for Gaussian noise), the RMS
+ * frequency spread from the lag-1 correlation and the power share of a
+ * carrier at the mean frequency: "cw", "fm", "am", "noise" or "unknown".
+ * Fills the power, PAPR, centroid / spread (cycles per sample), bandwidth
+ * (twice the spread) and an M2M4 SNR, exact for a constant envelope.
+ * A constant envelope needs about 13 dB of SNR to be recognised.
+ *
  * Parameters:
  *   features       - Pointer to initialized feature extractor
  *   iq_samples     - Complex IQ samples (interleaved I/Q)
- *   num_samples    - Number of IQ sample pairs
+ *   num_samples    - Number of IQ sample pairs (at least FEATURES_IQ_MIN_SAMPLES)
  *   sample_rate_hz - Sample rate of the IQ data
  *   result         - Pointer to store extraction results
  *
  * Returns:
- *   true on success, false on error
+ *   true on success, false on error (too few samples, no power)
  */
 bool features_extract_from_iq(features_t *features, const float *iq_samples,
                               uint32_t num_samples, double sample_rate_hz,
@@ -169,6 +210,7 @@ double features_calculate_snr(double signal_power, double noise_power);
 
 /*
  * Estimate local noise floor around a signal
+ * Uses the tracked floor over the signal bins when one is set.
  *
  * Parameters:
  *   features       - Pointer to feature extractor
@@ -236,6 +278,47 @@ double features_calculate_papr(const double *power_spectrum, uint32_t start_bin,
 double features_calculate_spectral_flatness(const double *power_spectrum,
                                            uint32_t start_bin, uint32_t end_bin);
 
+/*
+ * Clear an incremental feature accumulator
+ */
+void features_accum_reset(features_accum_t *acc);
+
+/*
+ * Add one detected cell to an accumulator
+ *
+ * Parameters:
+ *   acc      - Accumulator to update
+ *   bin      - FFT bin of the cell
+ *   power_db - Cell power in dB
+ *   noise_db - Noise reference the cell was detected against, in dB
+ */
+void features_accum_add(features_accum_t *acc, uint32_t bin, double power_db, double noise_db);
+
+/*
+ * Fold the cells of src into dest (cluster merges)
+ */
+void features_accum_merge(features_accum_t *dest, const features_accum_t *src);
+
+/*
+ * Turn accumulated moments into features without revisiting the spectrum
+ * Bandwidth is the span of detected bins; the -3dB bandwidth needs the
+ * spectral shape and is left at 0. Spectral flatness is the geometric over
+ * the arithmetic mean of the accumulated cell powers. The modulation hint
+ * is unrated: modulation_confidence is 0 (features_extract_from_iq rates
+ * its classification from the samples).
+ *
+ * Parameters:
+ *   acc            - Accumulator holding at least one cell
+ *   fft_size       - FFT size the bins refer to
+ *   sample_rate_hz - Sample rate in Hz
+ *   result         - Pointer to store the features
+ *
+ * Returns:
+ *   true on success, false if the accumulator is empty or parameters invalid
+ */
+bool features_accum_finalize(const features_accum_t *acc, uint32_t fft_size,
+                             double sample_rate_hz, features_result_t *result);
+
 /*
  * Reset feature extractor state
  *
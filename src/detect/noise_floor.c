@@ -0,0 +1,313 @@
+/*
+ * IQ Lab - Per-Bin Noise Floor Tracker Implementation
+ *
+ * All three modes seed every bin with the first row and then update each
+ * bin independently, so a row costs O(fft_size) (times the sub-window count
+ * for minimum statistics).
+ *
+ * The minimum-statistics bias depends on the smoothing weight, the window
+ * length and how far the open sub-window has filled. Rather than a closed
+ * form, init runs the same tracker over deterministic unit-mean exponential
+ * noise and takes the reciprocal of the mean floor it settles on, which is
+ * exact for this implementation and costs well under a millisecond.
+ */
+
+#include "noise_floor.h"
+#include "cfar_mask.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_LN2
+#define M_LN2 0.69314718055994530942
+#endif
+
+#define NOISE_FLOOR_MEDIAN_STEP 2.0      // Log-domain median step times time_constant
+#define NOISE_FLOOR_CALIBRATION_BINS 64  // Bins of synthetic noise for the bias
+#define NOISE_FLOOR_CALIBRATION_ROWS 16  // Measured rows per time constant
+
+static bool noise_floor_alloc(noise_floor_t *nf, uint32_t fft_size, noise_floor_mode_t mode,
+                              uint32_t time_constant) {
+    memset(nf, 0, sizeof(*nf));
+
+    if (fft_size == 0 || time_constant < 2 ||
+        (mode == NOISE_FLOOR_MINIMUM && time_constant < NOISE_FLOOR_SUBWINDOWS) ||
+        (mode != NOISE_FLOOR_EWMA && mode != NOISE_FLOOR_MEDIAN && mode != NOISE_FLOOR_MINIMUM)) {
+        return false;
+    }
+
+    nf->fft_size = fft_size;
+    nf->mode = mode;
+    nf->time_constant = time_constant;
+    nf->weight = 1.0 / (double)time_constant;
+    nf->step_up = exp(NOISE_FLOOR_MEDIAN_STEP / (double)time_constant);
+    nf->step_down = 1.0 / nf->step_up;
+    nf->min_bias = 1.0;
+    nf->subwindow_rows = time_constant / NOISE_FLOOR_SUBWINDOWS;
+
+    size_t n = fft_size;
+    nf->floor = malloc(n * sizeof(double));
+    nf->smoothed = malloc(n * sizeof(double));
+    nf->current_min = malloc(n * sizeof(double));
+    nf->subwindow_min = malloc(n * NOISE_FLOOR_SUBWINDOWS * sizeof(double));
+    nf->thresholds = malloc(n * sizeof(double));
+    nf->exceed_mask = malloc(CFAR_MASK_WORDS(fft_size) * sizeof(uint64_t));
+    if (!nf->floor || !nf->smoothed || !nf->current_min || !nf->subwindow_min ||
+        !nf->thresholds || !nf->exceed_mask) {
+        noise_floor_free(nf);
+        return false;
+    }
+
+    nf->initialized = true;
+    return true;
+}
+
+// Reciprocal of the mean minimum-statistics floor on unit-mean exponential noise
+static double noise_floor_calibrate_min(uint32_t time_constant) {
+    noise_floor_t sim;
+    if (!noise_floor_alloc(&sim, NOISE_FLOOR_CALIBRATION_BINS, NOISE_FLOOR_MINIMUM, time_constant)) {
+        return 1.0;
+    }
+
+    double row[NOISE_FLOOR_CALIBRATION_BINS];
+    uint32_t rng = 12345u;
+    uint32_t warmup = 2 * time_constant;
+    uint32_t measured = NOISE_FLOOR_CALIBRATION_ROWS * time_constant;
+    double sum = 0.0;
+
+    for (uint32_t r = 0; r < warmup + measured; r++) {
+        for (uint32_t i = 0; i < NOISE_FLOOR_CALIBRATION_BINS; i++) {
+            rng = rng * 1664525u + 1013904223u;
+            row[i] = -log(((rng >> 8) + 1) / 16777217.0);
+        }
+        noise_floor_update(&sim, row);
+        if (r < warmup) continue;
+        for (uint32_t i = 0; i < NOISE_FLOOR_CALIBRATION_BINS; i++) sum += sim.floor[i];
+    }
+    noise_floor_free(&sim);
+
+    double mean = sum / ((double)measured * NOISE_FLOOR_CALIBRATION_BINS);
+    return mean > 0.0 ? 1.0 / mean : 1.0;
+}
+
+bool noise_floor_init(noise_floor_t *nf, uint32_t fft_size, noise_floor_mode_t mode,
+                      uint32_t time_constant) {
+    if (!nf || !noise_floor_alloc(nf, fft_size, mode, time_constant)) {
+        return false;
+    }
+
+    if (mode == NOISE_FLOOR_MINIMUM) {
+        nf->min_bias = noise_floor_calibrate_min(time_constant);
+    }
+    return true;
+}
+
+static void noise_floor_seed(noise_floor_t *nf, const double *row) {
+    uint32_t n = nf->fft_size;
+    for (uint32_t b = 0; b < n; b++) {
+        double x = row[b];
+        nf->smoothed[b] = nf->mode == NOISE_FLOOR_MEDIAN ? x * M_LN2 : x;
+        nf->current_min[b] = x;
+        for (uint32_t s = 0; s < NOISE_FLOOR_SUBWINDOWS; s++) {
+            nf->subwindow_min[(size_t)s * n + b] = x;
+        }
+        nf->floor[b] = nf->mode == NOISE_FLOOR_MINIMUM ? x * nf->min_bias : x;
+    }
+    nf->subwindow_rows_seen = 0;
+    nf->subwindow_next = 0;
+}
+
+void noise_floor_update(noise_floor_t *nf, const double *power_row) {
+    if (!nf || !nf->initialized || !power_row) return;
+
+    const uint32_t n = nf->fft_size;
+    if (nf->rows_seen++ == 0) {
+        noise_floor_seed(nf, power_row);
+        return;
+    }
+
+    switch (nf->mode) {
+    case NOISE_FLOOR_EWMA: {
+        const double w = nf->weight;
+        for (uint32_t b = 0; b < n; b++) {
+            nf->floor[b] += w * (power_row[b] - nf->floor[b]);
+        }
+        break;
+    }
+
+    case NOISE_FLOOR_MEDIAN:
+        // smoothed holds the running median; the mean of exponential noise
+        // is median / ln 2
+        for (uint32_t b = 0; b < n; b++) {
+            double m = nf->smoothed[b];
+            m *= power_row[b] > m ? nf->step_up : nf->step_down;
+            nf->smoothed[b] = m;
+            nf->floor[b] = m * (1.0 / M_LN2);
+        }
+        break;
+
+    case NOISE_FLOOR_MINIMUM: {
+        const double a = NOISE_FLOOR_MIN_SMOOTHING;
+        for (uint32_t b = 0; b < n; b++) {
+            double p = nf->smoothed[b] + a * (power_row[b] - nf->smoothed[b]);
+            nf->smoothed[b] = p;
+            double m = p < nf->current_min[b] ? p : nf->current_min[b];
+            nf->current_min[b] = m;
+            for (uint32_t s = 0; s < NOISE_FLOOR_SUBWINDOWS; s++) {
+                double sub = nf->subwindow_min[(size_t)s * n + b];
+                if (sub < m) m = sub;
+            }
+            nf->floor[b] = m * nf->min_bias;
+        }
+
+        // Close the sub-window: its minimum replaces the oldest one
+        if (++nf->subwindow_rows_seen >= nf->subwindow_rows) {
+            memcpy(nf->subwindow_min + (size_t)nf->subwindow_next * n, nf->current_min,
+                   n * sizeof(double));
+            memcpy(nf->current_min, nf->smoothed, n * sizeof(double));
+            nf->subwindow_next = (nf->subwindow_next + 1) % NOISE_FLOOR_SUBWINDOWS;
+            nf->subwindow_rows_seen = 0;
+        }
+        break;
+    }
+    }
+}
+
+bool noise_floor_ready(const noise_floor_t *nf) {
+    return nf && nf->initialized && nf->rows_seen > 0;
+}
+
+const double *noise_floor_get(const noise_floor_t *nf) {
+    return noise_floor_ready(nf) ? nf->floor : NULL;
+}
+
+double noise_floor_band(const noise_floor_t *nf, uint32_t start_bin, uint32_t end_bin) {
+    if (!noise_floor_ready(nf) || start_bin > end_bin || start_bin >= nf->fft_size) {
+        return 0.0;
+    }
+    if (end_bin >= nf->fft_size) end_bin = nf->fft_size - 1;
+
+    double sum = 0.0;
+    for (uint32_t b = start_bin; b <= end_bin; b++) sum += nf->floor[b];
+    return sum / (double)(end_bin - start_bin + 1);
+}
+
+uint32_t noise_floor_detect(noise_floor_t *nf, const double *power_row, double pfa,
+                            cfar_detection_t *detections, uint32_t max_detections) {
+    if (!noise_floor_ready(nf) || !power_row || !detections || max_detections == 0 ||
+        pfa <= 0.0 || pfa >= 1.0) {
+        return 0;
+    }
+
+    // Known-mean exponential noise: P(x > t) = exp(-t / floor)
+    const double scale = -log(pfa);
+    const uint32_t n = nf->fft_size;
+    for (uint32_t b = 0; b < n; b++) {
+        nf->thresholds[b] = scale * nf->floor[b];
+    }
+
+    cfar_exceed_mask(power_row, nf->thresholds, n, nf->exceed_mask);
+    return cfar_compact_detections(power_row, nf->thresholds, nf->exceed_mask, n,
+                                   detections, max_detections);
+}
+
+void noise_floor_reset(noise_floor_t *nf) {
+    if (!nf || !nf->initialized) return;
+    nf->rows_seen = 0;
+    nf->subwindow_rows_seen = 0;
+    nf->subwindow_next = 0;
+}
+
+// Row counters of a checkpointed tracker, with its configuration
+typedef struct {
+    uint32_t fft_size;
+    uint32_t mode;
+    uint32_t time_constant;
+    uint32_t subwindow_rows_seen;
+    uint32_t subwindow_next;
+    uint32_t reserved;
+    uint64_t rows_seen;
+} noise_floor_state_t;
+
+bool noise_floor_save_state(const noise_floor_t *nf, checkpoint_writer_t *writer) {
+    if (!nf || !nf->initialized || !writer) return false;
+
+    noise_floor_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.fft_size = nf->fft_size;
+    state.mode = (uint32_t)nf->mode;
+    state.time_constant = nf->time_constant;
+    state.subwindow_rows_seen = nf->subwindow_rows_seen;
+    state.subwindow_next = nf->subwindow_next;
+    state.rows_seen = nf->rows_seen;
+
+    size_t row_bytes = (size_t)nf->fft_size * sizeof(double);
+    return checkpoint_put(writer, "noise_floor.state", &state, sizeof(state)) &&
+           checkpoint_put(writer, "noise_floor.floor", nf->floor, row_bytes) &&
+           checkpoint_put(writer, "noise_floor.smoothed", nf->smoothed, row_bytes) &&
+           checkpoint_put(writer, "noise_floor.cur_min", nf->current_min, row_bytes) &&
+           checkpoint_put(writer, "noise_floor.sub_min", nf->subwindow_min,
+                          NOISE_FLOOR_SUBWINDOWS * row_bytes);
+}
+
+bool noise_floor_load_state(noise_floor_t *nf, const checkpoint_t *checkpoint) {
+    if (!nf || !nf->initialized) return false;
+
+    noise_floor_state_t state;
+    size_t row_bytes = (size_t)nf->fft_size * sizeof(double);
+    bool ok = checkpoint_get(checkpoint, "noise_floor.state", &state, sizeof(state)) &&
+              state.fft_size == nf->fft_size && state.mode == (uint32_t)nf->mode &&
+              state.time_constant == nf->time_constant &&
+              state.subwindow_next < NOISE_FLOOR_SUBWINDOWS &&
+              checkpoint_get(checkpoint, "noise_floor.floor", nf->floor, row_bytes) &&
+              checkpoint_get(checkpoint, "noise_floor.smoothed", nf->smoothed, row_bytes) &&
+              checkpoint_get(checkpoint, "noise_floor.cur_min", nf->current_min, row_bytes) &&
+              checkpoint_get(checkpoint, "noise_floor.sub_min", nf->subwindow_min,
+                             NOISE_FLOOR_SUBWINDOWS * row_bytes);
+    if (!ok) {
+        noise_floor_reset(nf);
+        return false;
+    }
+
+    nf->subwindow_rows_seen = state.subwindow_rows_seen;
+    nf->subwindow_next = state.subwindow_next;
+    nf->rows_seen = state.rows_seen;
+    return true;
+}
+
+void noise_floor_free(noise_floor_t *nf) {
+    if (!nf) return;
+
+    free(nf->floor);
+    free(nf->smoothed);
+    free(nf->current_min);
+    free(nf->subwindow_min);
+    free(nf->thresholds);
+    free(nf->exceed_mask);
+    memset(nf, 0, sizeof(*nf));
+}
+
+bool noise_floor_mode_from_name(const char *name, noise_floor_mode_t *mode) {
+    if (!name || !mode) return false;
+
+    if (strcmp(name, "ewma") == 0) {
+        *mode = NOISE_FLOOR_EWMA;
+    } else if (strcmp(name, "median") == 0) {
+        *mode = NOISE_FLOOR_MEDIAN;
+    } else if (strcmp(name, "min") == 0 || strcmp(name, "minimum") == 0) {
+        *mode = NOISE_FLOOR_MINIMUM;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *noise_floor_mode_name(noise_floor_mode_t mode) {
+    switch (mode) {
+    case NOISE_FLOOR_EWMA:    return "ewma";
+    case NOISE_FLOOR_MEDIAN:  return "median";
+    case NOISE_FLOOR_MINIMUM: return "minimum";
+    }
+    return "unknown";
+}
@@ -0,0 +1,137 @@
+/*
+ * IQ Lab - Per-Bin Noise Floor Tracker Header
+ *
+ * Purpose: Carry a per-bin noise level across frames instead of re-deriving it
+ *
+ *
+ * Per-frame CFAR and features_estimate_noise_floor() rebuild the noise level
+ * from the current spectrum every time: a sort or mean over neighbouring
+ * bins, repeated row after row even when the band is stationary. The tracker
+ * keeps one running estimate per bin, updated in O(1) per bin per row, that
+ * the detectors, the feature extractor and the SNR estimate can all read.
+ *
+ * Tracking modes:
+ * - ewma:    exponentially weighted mean, weight 1/time_constant. Cheapest,
+ *            but a carrier that sits in a bin gradually becomes its floor.
+ * - median:  multiplicative sign tracker that settles on the running median
+ *            of each bin, scaled by 1/ln 2 to the mean of exponential noise.
+ *            Ignores bursts that occupy a bin less than half the time.
+ * - minimum: minimum statistics (Martin): the minimum of a short-term
+ *            smoothed periodogram over a window of time_constant rows, kept
+ *            as 4 sub-window minima, times a bias correction. Follows the
+ *            floor under signals that are present most of the time.
+ *
+ * Usage:
+ *   noise_floor_t nf;
+ *   noise_floor_init(&nf, fft_size, NOISE_FLOOR_MEDIAN, 64);
+ *   for each power row:
+ *       n = noise_floor_detect(&nf, row, pfa, detections, max);  // optional
+ *       noise_floor_update(&nf, row);
+ *       snr_db = 10 * log10(row[bin] / noise_floor_get(&nf)[bin]);
+ *
+ * Technical Details:
+ * - Estimates are linear power, the mean of the noise in each bin
+ * - The first row seeds every mode; noise_floor_ready() is false before it
+ * - noise_floor_detect() thresholds each bin at -ln(pfa) times its floor,
+ *   the known-noise CFAR threshold for exponential power, through the shared
+ *   CFAR mask and compaction (cfar_mask.h); no order statistics per row
+ *
+ * Memory: 3 + NOISE_FLOOR_SUBWINDOWS rows of fft_size doubles
+ * Thread Safety: Not thread-safe (single tracker instance per thread)
+ */
+
+#ifndef IQ_LAB_NOISE_FLOOR_H
+#define IQ_LAB_NOISE_FLOOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cfar_os.h"  // Include for cfar_detection_t definition
+
+#define NOISE_FLOOR_SUBWINDOWS 4        // Minimum-statistics sub-windows
+#define NOISE_FLOOR_MIN_SMOOTHING 0.2   // Periodogram smoothing weight (minimum mode)
+
+// Tracking algorithm
+typedef enum {
+    NOISE_FLOOR_EWMA,
+    NOISE_FLOOR_MEDIAN,
+    NOISE_FLOOR_MINIMUM
+} noise_floor_mode_t;
+
+// Noise floor tracker configuration and state
+typedef struct {
+    // Configuration parameters
+    uint32_t fft_size;           // Bins per row
+    noise_floor_mode_t mode;     // Tracking algorithm
+    uint32_t time_constant;      // Rows of memory (EWMA weight, median step, window)
+
+    // Derived parameters
+    double weight;               // EWMA weight 1/time_constant
+    double step_up;              // Median tracker factor when the bin is above
+    double step_down;            // ... and when it is below
+    double min_bias;             // Minimum statistics bias correction
+    uint32_t subwindow_rows;     // Rows per minimum-statistics sub-window
+
+    // Per-bin state
+    double *floor;               // Current noise floor estimate (linear)
+    double *smoothed;            // Smoothed periodogram (minimum mode)
+    double *current_min;         // Minimum of the open sub-window (minimum mode)
+    double *subwindow_min;       // NOISE_FLOOR_SUBWINDOWS closed sub-window minima
+    uint32_t subwindow_rows_seen; // Rows in the open sub-window
+    uint32_t subwindow_next;     // Closed sub-window slot to overwrite next
+
+    // Detection buffers
+    double *thresholds;          // Per-bin linear detection threshold
+    uint64_t *exceed_mask;       // Exceedance bits
+
+    // State
+    uint64_t rows_seen;          // Rows since init/reset
+    bool initialized;
+} noise_floor_t;
+
+/*
+ * Initialize a tracker for rows of fft_size bins
+ * time_constant must be at least 2 rows (and at least NOISE_FLOOR_SUBWINDOWS
+ * for the minimum mode). Returns false on parameter error or allocation failure.
+ */
+bool noise_floor_init(noise_floor_t *nf, uint32_t fft_size, noise_floor_mode_t mode,
+                      uint32_t time_constant);
+
+// Fold one power row (linear, fft_size bins) into the estimate
+void noise_floor_update(noise_floor_t *nf, const double *power_row);
+
+// Whether at least one row has been seen
+bool noise_floor_ready(const noise_floor_t *nf);
+
+// Per-bin floor (linear), NULL before the first row
+const double *noise_floor_get(const noise_floor_t *nf);
+
+// Mean floor over bins [start_bin, end_bin], 0.0 before the first row
+double noise_floor_band(const noise_floor_t *nf, uint32_t start_bin, uint32_t end_bin);
+
+/*
+ * Known-noise CFAR against the tracked floor: bins above -ln(pfa) * floor
+ * Returns the number of detections written (0 before the first row);
+ * snr_estimate is relative to the detection threshold, as for the other
+ * CFAR detectors.
+ */
+uint32_t noise_floor_detect(noise_floor_t *nf, const double *power_row, double pfa,
+                            cfar_detection_t *detections, uint32_t max_detections);
+
+// Forget all rows; configuration is kept
+void noise_floor_reset(noise_floor_t *nf);
+
+// Save / restore the per-bin state; on load the tracker must be configured
+// like the saved one
+bool noise_floor_save_state(const noise_floor_t *nf, checkpoint_writer_t *writer);
+bool noise_floor_load_state(noise_floor_t *nf, const checkpoint_t *checkpoint);
+
+// Free tracker resources and reset to uninitialized state
+void noise_floor_free(noise_floor_t *nf);
+
+// Parse "ewma", "median" or "min"/"minimum"; false if unknown
+bool noise_floor_mode_from_name(const char *name, noise_floor_mode_t *mode);
+
+// Short name of a mode
+const char *noise_floor_mode_name(noise_floor_mode_t mode);
+
+#endif /* IQ_LAB_NOISE_FLOOR_H */
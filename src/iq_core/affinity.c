@@ -0,0 +1,267 @@
+/*
+ * IQ Lab - Worker placement on multi-socket machines
+ *
+ * The policy turns into one CPU order when it is set: node by node for
+ * compact, one CPU of each node in turn for scatter, or the list as given.
+ * Threads take positions in that order with an atomic counter, so pinning
+ * costs one fetch-add and one affinity call per thread start. Per-node
+ * counters serve iq_affinity_pin_node() from the same order.
+ */
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // pthread_setaffinity_np, cpu_set_t
+#endif
+
+#include "affinity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+static iq_pin_policy_t policy = IQ_PIN_NONE;
+static int16_t cpu_node[IQ_AFFINITY_MAX_CPUS];   // -1: not online
+static uint32_t cpu_count;                       // Online CPUs
+static uint32_t node_count;
+static int order[IQ_AFFINITY_MAX_CPUS];          // CPUs in the policy's order
+static uint32_t order_count;
+static atomic_uint next_slot;
+static atomic_uint next_on_node[IQ_AFFINITY_MAX_NODES];
+static _Thread_local int thread_node = -1;
+
+// Mark the CPUs of a list such as "0-7,16-23" in 'marks'; false if malformed
+static bool parse_cpu_list(const char *text, bool *marks) {
+    const char *c = text;
+    while (*c && *c != '\n') {
+        char *end = NULL;
+        long first = strtol(c, &end, 10);
+        if (end == c || first < 0) return false;
+        long last = first;
+        c = end;
+        if (*c == '-') {
+            const char *from = c + 1;
+            last = strtol(from, &end, 10);
+            if (end == from || last < first) return false;
+            c = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < IQ_AFFINITY_MAX_CPUS; cpu++) marks[cpu] = true;
+        if (*c == ',') c++;
+        else if (*c && *c != '\n') return false;
+    }
+    return true;
+}
+
+static bool read_cpu_list(const char *path, bool *marks) {
+    FILE *file = fopen(path, "r");
+    if (!file) return false;
+    char line[4096];
+    bool ok = fgets(line, sizeof(line), file) && parse_cpu_list(line, marks);
+    fclose(file);
+    return ok;
+}
+
+// Online CPUs and the node of each
+static void load_topology(void) {
+    if (cpu_count > 0) return;
+
+    static bool online[IQ_AFFINITY_MAX_CPUS];
+    memset(online, 0, sizeof(online));
+    if (!read_cpu_list("/sys/devices/system/cpu/online", online)) {
+        long count;
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        count = (long)info.dwNumberOfProcessors;
+#else
+        count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        for (long cpu = 0; cpu < count && cpu < IQ_AFFINITY_MAX_CPUS; cpu++) online[cpu] = true;
+    }
+
+    for (int cpu = 0; cpu < IQ_AFFINITY_MAX_CPUS; cpu++) {
+        cpu_node[cpu] = online[cpu] ? 0 : -1;
+        if (online[cpu]) cpu_count++;
+    }
+    if (cpu_count == 0) {
+        cpu_node[0] = 0;
+        cpu_count = 1;
+    }
+
+    // Node directories may skip numbers (offline or memory-only nodes)
+    node_count = 1;
+    for (int node = 0; node < IQ_AFFINITY_MAX_NODES; node++) {
+        static bool marks[IQ_AFFINITY_MAX_CPUS];
+        char path[64];
+        memset(marks, 0, sizeof(marks));
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        if (!read_cpu_list(path, marks)) continue;
+        for (int cpu = 0; cpu < IQ_AFFINITY_MAX_CPUS; cpu++) {
+            if (marks[cpu] && cpu_node[cpu] >= 0) cpu_node[cpu] = (int16_t)node;
+        }
+        if ((uint32_t)node + 1 > node_count) node_count = (uint32_t)node + 1;
+    }
+}
+
+// The policy's CPU order
+static void build_order(iq_pin_policy_t mode, const bool *listed) {
+    order_count = 0;
+    if (mode == IQ_PIN_LIST) {
+        for (int cpu = 0; cpu < IQ_AFFINITY_MAX_CPUS; cpu++) {
+            if (listed[cpu] && cpu_node[cpu] >= 0) order[order_count++] = cpu;
+        }
+    } else if (mode == IQ_PIN_COMPACT) {
+        for (uint32_t node = 0; node < node_count; node++) {
+            for (int cpu = 0; cpu < IQ_AFFINITY_MAX_CPUS; cpu++) {
+                if (cpu_node[cpu] == (int)node) order[order_count++] = cpu;
+            }
+        }
+    } else if (mode == IQ_PIN_SCATTER) {
+        // The k-th CPU of every node, for k = 0, 1, ...
+        int taken[IQ_AFFINITY_MAX_NODES] = {0};
+        while (order_count < cpu_count) {
+            uint32_t before = order_count;
+            for (uint32_t node = 0; node < node_count; node++) {
+                int seen = 0;
+                for (int cpu = 0; cpu < IQ_AFFINITY_MAX_CPUS; cpu++) {
+                    if (cpu_node[cpu] != (int)node) continue;
+                    if (seen++ == taken[node]) {
+                        order[order_count++] = cpu;
+                        taken[node]++;
+                        break;
+                    }
+                }
+            }
+            if (order_count == before) break;
+        }
+    }
+}
+
+bool iq_affinity_set(const char *spec) {
+    load_topology();
+
+    iq_pin_policy_t mode;
+    static bool listed[IQ_AFFINITY_MAX_CPUS];
+    memset(listed, 0, sizeof(listed));
+    if (!spec || !spec[0] || strcmp(spec, "compact") == 0) {
+        mode = IQ_PIN_COMPACT;
+    } else if (strcmp(spec, "scatter") == 0) {
+        mode = IQ_PIN_SCATTER;
+    } else if (strcmp(spec, "none") == 0) {
+        mode = IQ_PIN_NONE;
+    } else if (parse_cpu_list(spec, listed)) {
+        mode = IQ_PIN_LIST;
+    } else {
+        return false;
+    }
+
+    build_order(mode, listed);
+    if (mode != IQ_PIN_NONE && order_count == 0) return false;
+    policy = mode;
+    atomic_store(&next_slot, 0);
+    for (int node = 0; node < IQ_AFFINITY_MAX_NODES; node++) atomic_store(&next_on_node[node], 0);
+    return true;
+}
+
+bool iq_affinity_start(const char *spec) {
+    if (!iq_affinity_set(spec)) {
+        fprintf(stderr, "Invalid --pin value '%s' (compact, scatter or a CPU list such as 0-7,16-23)\n",
+                spec);
+        policy = IQ_PIN_NONE;
+        return false;
+    }
+    // The tool's main thread takes the first CPU
+    iq_affinity_pin_next();
+    return true;
+}
+
+bool iq_affinity_parse_arg(const char *arg) {
+    if (!arg || strncmp(arg, "--pin", 5) != 0) return false;
+    if (arg[5] != '\0' && arg[5] != '=') return false;
+    return iq_affinity_start(arg[5] == '=' ? arg + 6 : NULL);
+}
+
+iq_pin_policy_t iq_affinity_policy(void) {
+    return policy;
+}
+
+uint32_t iq_affinity_nodes(void) {
+    load_topology();
+    return node_count;
+}
+
+uint32_t iq_affinity_cpus(void) {
+    load_topology();
+    return cpu_count;
+}
+
+int iq_affinity_node_of_cpu(int cpu) {
+    load_topology();
+    if (cpu < 0 || cpu >= IQ_AFFINITY_MAX_CPUS || cpu_node[cpu] < 0) return 0;
+    return cpu_node[cpu];
+}
+
+// Bind the calling thread to one CPU
+static int pin_to(int cpu) {
+#if defined(_WIN32)
+    if (cpu >= 64 || SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) == 0) return -1;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) return -1;
+#else
+    return -1;
+#endif
+    thread_node = cpu_node[cpu];
+    return cpu;
+}
+
+int iq_affinity_pin_next(void) {
+    if (policy == IQ_PIN_NONE) return -1;
+    uint32_t slot = atomic_fetch_add(&next_slot, 1);
+    return pin_to(order[slot % order_count]);
+}
+
+int iq_affinity_pin_node(int node) {
+    if (policy == IQ_PIN_NONE) return -1;
+    if (node < 0 || node >= IQ_AFFINITY_MAX_NODES) return iq_affinity_pin_next();
+
+    uint32_t on_node = 0;
+    for (uint32_t i = 0; i < order_count; i++) {
+        if (cpu_node[order[i]] == node) on_node++;
+    }
+    if (on_node == 0) return iq_affinity_pin_next();
+
+    uint32_t k = atomic_fetch_add(&next_on_node[node], 1) % on_node;
+    for (uint32_t i = 0; i < order_count; i++) {
+        if (cpu_node[order[i]] == node && k-- == 0) return pin_to(order[i]);
+    }
+    return -1;
+}
+
+int iq_affinity_current_node(void) {
+    return thread_node;
+}
+
+void iq_affinity_first_touch(void *buffer, size_t bytes) {
+    if (policy == IQ_PIN_NONE || !buffer) return;
+#ifdef _WIN32
+    const size_t page = 4096;
+#else
+    long size = sysconf(_SC_PAGESIZE);
+    const size_t page = size > 0 ? (size_t)size : 4096;
+#endif
+    // Rewrite each page's first byte: the contents stay, the page is placed
+    volatile unsigned char *bytes_at = (volatile unsigned char *)buffer;
+    for (size_t offset = 0; offset < bytes; offset += page) {
+        bytes_at[offset] = bytes_at[offset];
+    }
+    if (bytes > 0) bytes_at[bytes - 1] = bytes_at[bytes - 1];
+}
@@ -0,0 +1,89 @@
+#ifndef IQ_AFFINITY_H
+#define IQ_AFFINITY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Worker placement on multi-socket machines
+ * A tool started with --pin[=<policy>] pins each pool thread to one CPU as
+ * the thread starts, so its FFT scratch and the blocks it fills first are
+ * placed on its own NUMA node by the kernel's first-touch rule:
+ *
+ *   compact (default)  threads fill the CPUs of one node before the next,
+ *                      keeping a pipeline's stages on one socket
+ *   scatter            threads go round-robin over the nodes
+ *   <cpu list>         threads take these CPUs in order, e.g. 0-7,16-23
+ *
+ * CPUs are handed out in thread start order from one process-wide list,
+ * wrapping once every CPU is taken. A stage that must sit beside its input
+ * ring pins with iq_affinity_pin_node() to the ring's node instead.
+ *
+ * The topology comes from /sys/devices/system/node (one node holding every
+ * online CPU elsewhere). Without --pin every call here is a no-op and
+ * threads float as before.
+ */
+
+#define IQ_AFFINITY_MAX_CPUS 1024
+#define IQ_AFFINITY_MAX_NODES 64
+
+typedef enum {
+    IQ_PIN_NONE = 0,          // Threads float (default)
+    IQ_PIN_COMPACT,           // Fill one node's CPUs before the next
+    IQ_PIN_SCATTER,           // Alternate nodes
+    IQ_PIN_LIST               // Explicit CPU list
+} iq_pin_policy_t;
+
+/*
+ * Turn pinning on with a policy or CPU list (NULL for compact) and pin the
+ * calling (main) thread to the first CPU of the order. An invalid value is
+ * reported on stderr, leaves pinning off and returns false.
+ */
+bool iq_affinity_start(const char *spec);
+
+/*
+ * Parse "--pin" or "--pin=<policy|cpu list>" with iq_affinity_start()
+ * True only if 'arg' was the option with a valid value.
+ */
+bool iq_affinity_parse_arg(const char *arg);
+
+/*
+ * Set the policy from its name or a CPU list (NULL or "" for compact)
+ * Returns false on an unknown policy or a list naming no online CPU.
+ */
+bool iq_affinity_set(const char *spec);
+
+// Current policy
+iq_pin_policy_t iq_affinity_policy(void);
+
+// NUMA nodes and online CPUs found
+uint32_t iq_affinity_nodes(void);
+uint32_t iq_affinity_cpus(void);
+
+// Node of a CPU (0 if unknown)
+int iq_affinity_node_of_cpu(int cpu);
+
+/*
+ * Pin the calling thread to the next CPU of the policy's order
+ * Returns the CPU, or -1 when pinning is off or the system refused.
+ */
+int iq_affinity_pin_next(void);
+
+/*
+ * Pin the calling thread to the next CPU of 'node' (the next CPU of the
+ * policy's order if the node has none in it). Returns the CPU or -1.
+ */
+int iq_affinity_pin_node(int node);
+
+// Node the calling thread is pinned to, -1 if it is not pinned
+int iq_affinity_current_node(void);
+
+/*
+ * Write one byte per page of 'buffer' from the calling thread, placing
+ * pages nothing has written yet on that thread's node. Only worth calling
+ * on fresh malloc() memory from a pinned thread; a no-op without --pin.
+ */
+void iq_affinity_first_touch(void *buffer, size_t bytes);
+
+#endif // IQ_AFFINITY_H
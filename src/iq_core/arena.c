@@ -0,0 +1,145 @@
+/*
+ * IQ Lab - Scratch arenas and the heap allocation guard
+ *
+ * Generations come from one process-wide counter, so an arena created at
+ * the address of a freed one (a stack arena in a loop) never looks like
+ * the one a thread's scratch was carved from.
+ */
+
+#include "arena.h"
+#include "hugepage.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static atomic_uint_fast64_t iq_arena_generations = 0;
+
+static _Thread_local iq_arena_t *iq_arena_bound = NULL;
+static _Thread_local bool iq_alloc_guard_on = false;
+static _Thread_local uint64_t iq_alloc_made = 0;
+
+static uint64_t iq_arena_next_generation(void) {
+    return atomic_fetch_add_explicit(&iq_arena_generations, 1, memory_order_relaxed) + 1;
+}
+
+bool iq_arena_init(iq_arena_t *arena, size_t capacity) {
+    arena->base = NULL;
+    arena->storage = NULL;
+    arena->capacity = 0;
+    atomic_init(&arena->used, 0);
+    atomic_init(&arena->overflows, 0);
+    arena->generation = iq_arena_next_generation();
+    if (capacity == 0) return true;
+
+    // Large FFT scratch is touched all over on every frame: back it with huge pages
+    arena->storage = iq_huge_alloc(capacity);
+    if (!arena->storage) {
+        fprintf(stderr, "Error: Failed to reserve a %zu-byte scratch arena\n", capacity);
+        return false;
+    }
+    arena->base = arena->storage;  // IQ_HUGE_ALIGN-aligned
+    arena->capacity = capacity;
+    return true;
+}
+
+void iq_arena_free(iq_arena_t *arena) {
+    if (!arena) return;
+    if (iq_arena_bound == arena) iq_arena_bound = NULL;
+    iq_huge_free(arena->storage);
+    arena->storage = NULL;
+    arena->base = NULL;
+    arena->capacity = 0;
+    atomic_store_explicit(&arena->used, 0, memory_order_relaxed);
+    arena->generation = iq_arena_next_generation();
+}
+
+void *iq_arena_alloc(iq_arena_t *arena, size_t bytes) {
+    if (!arena || bytes == 0) return NULL;
+
+    // Round up so the next block stays aligned
+    size_t rounded = (bytes + IQ_ARENA_ALIGN - 1) & ~(size_t)(IQ_ARENA_ALIGN - 1);
+    if (rounded < bytes || rounded > arena->capacity) {
+        atomic_fetch_add_explicit(&arena->overflows, 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    size_t offset = atomic_load_explicit(&arena->used, memory_order_relaxed);
+    do {
+        if (arena->capacity - offset < rounded) {
+            atomic_fetch_add_explicit(&arena->overflows, 1, memory_order_relaxed);
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&arena->used, &offset, offset + rounded,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    return arena->base + offset;
+}
+
+void iq_arena_reset(iq_arena_t *arena) {
+    if (!arena) return;
+    atomic_store_explicit(&arena->used, 0, memory_order_relaxed);
+    arena->generation = iq_arena_next_generation();
+}
+
+size_t iq_arena_used(const iq_arena_t *arena) {
+    return arena ? atomic_load_explicit(&arena->used, memory_order_relaxed) : 0;
+}
+
+iq_arena_t *iq_arena_bind(iq_arena_t *arena) {
+    iq_arena_t *previous = iq_arena_bound;
+    iq_arena_bound = arena;
+    return previous;
+}
+
+iq_arena_t *iq_arena_current(void) {
+    return iq_arena_bound;
+}
+
+bool iq_alloc_guard(bool on) {
+    bool previous = iq_alloc_guard_on;
+    iq_alloc_guard_on = on;
+    return previous;
+}
+
+bool iq_alloc_guarded(void) {
+    return iq_alloc_guard_on;
+}
+
+uint64_t iq_alloc_count(void) {
+    return iq_alloc_made;
+}
+
+#if defined(IQ_ALLOC_DEBUG) && defined(__GLIBC__)
+/*
+ * Counting allocator: replaces the C library's entry points for the whole
+ * process and forwards to glibc's own implementation, so free() and every
+ * allocation made inside the library still pair up.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+static void iq_alloc_note(const char *call, size_t bytes) {
+    iq_alloc_made++;
+    if (!iq_alloc_guard_on) return;
+
+    // The report may allocate itself
+    iq_alloc_guard_on = false;
+    fprintf(stderr, "Error: %s(%zu) in a steady-state thread (allocation %llu of this thread)\n",
+            call, bytes, (unsigned long long)iq_alloc_made);
+    abort();
+}
+
+void *malloc(size_t size) {
+    iq_alloc_note("malloc", size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    iq_alloc_note("calloc", count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+    if (size > 0) iq_alloc_note("realloc", size);
+    return __libc_realloc(pointer, size);
+}
+#endif
@@ -0,0 +1,84 @@
+#ifndef IQ_ARENA_H
+#define IQ_ARENA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+ * Preallocated scratch arenas for streaming pipelines
+ * A pipeline reserves one block up front, sized for the scratch its modules
+ * ask for on every call, and binds it to each thread that runs a stage:
+ *
+ *   iq_arena_t arena;
+ *   iq_arena_init(&arena, threads * fft_scratch_bytes(fft_size));
+ *   iq_arena_t *previous = iq_arena_bind(&arena);
+ *   ... steady-state loop ...
+ *   iq_arena_bind(previous);
+ *   iq_arena_free(&arena);
+ *
+ * Modules with per-thread scratch (the FFT work, chirp and frame buffers)
+ * carve it from the bound arena the first time a size is needed and keep
+ * it until the thread is bound to another arena, so after the first frame
+ * a pipeline runs on memory it already owns. Allocation is a bump of one
+ * atomic offset: threads of a pool may share an arena, and nothing is
+ * handed back until the arena is reset or freed. A request that does not
+ * fit is counted as an overflow and the module falls back to the heap.
+ *
+ * Heap allocation guard: a thread that has finished warming up calls
+ * iq_alloc_guard(true). In builds with IQ_ALLOC_DEBUG (make ALLOC_DEBUG=1)
+ * malloc, calloc and realloc are counted per thread, and one made by a
+ * guarded thread prints the thread's count and aborts, so a steady state
+ * that is not allocation-free fails loudly instead of showing up as tail
+ * latency. Work that may allocate (opening an event log, say) drops the
+ * guard around itself. Without IQ_ALLOC_DEBUG the guard is a thread-local
+ * flag and nothing is counted. Counting needs glibc (allocations are
+ * forwarded to __libc_malloc); elsewhere debug builds count nothing.
+ */
+
+#define IQ_ARENA_ALIGN 64       // Every block starts on a cache line
+
+typedef struct {
+    uint8_t *base;              // IQ_ARENA_ALIGN-aligned start of the block
+    void *storage;              // What iq_huge_alloc returned
+    size_t capacity;
+    atomic_size_t used;         // Bump offset
+    atomic_uint_fast64_t overflows; // Requests that did not fit
+    uint64_t generation;        // Changes on init and reset: held scratch is stale
+} iq_arena_t;
+
+/*
+ * Reserve 'capacity' bytes
+ * Returns false (with a message on stderr) if the block cannot be allocated.
+ */
+bool iq_arena_init(iq_arena_t *arena, size_t capacity);
+
+// Free the block; no thread may still be using memory from it
+void iq_arena_free(iq_arena_t *arena);
+
+// IQ_ARENA_ALIGN-aligned 'bytes' bytes, or NULL (an overflow) when full
+void *iq_arena_alloc(iq_arena_t *arena, size_t bytes);
+
+// Hand everything back; every thread holding scratch from it drops it on next use
+void iq_arena_reset(iq_arena_t *arena);
+
+// Bytes handed out so far
+size_t iq_arena_used(const iq_arena_t *arena);
+
+// Bind 'arena' (NULL: the heap) as the calling thread's scratch; returns the previous one
+iq_arena_t *iq_arena_bind(iq_arena_t *arena);
+
+// The calling thread's scratch arena, or NULL
+iq_arena_t *iq_arena_current(void);
+
+// Guard the calling thread against heap allocations; returns the previous state
+bool iq_alloc_guard(bool on);
+
+// Whether the calling thread is guarded
+bool iq_alloc_guarded(void);
+
+// Heap allocations made by the calling thread (0 without IQ_ALLOC_DEBUG)
+uint64_t iq_alloc_count(void);
+
+#endif // IQ_ARENA_H
@@ -0,0 +1,263 @@
+/*
+ * IQ Lab - Pipeline checkpoints
+ *
+ * File layout: a header (magic, version, tool, section count, payload size,
+ * checksum), then the payload: per section a 32-byte tag and size record
+ * and the data, padded to 8 bytes. The header is written last, over a
+ * placeholder, once the payload checksum is known; the file is synced
+ * before the rename so the rename never exposes unwritten data.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // fileno, fsync, fseeko, ftruncate under -std=c11
+#endif
+
+#include "checkpoint.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#define CHECKPOINT_MAGIC "IQLABCKP"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_FNV_OFFSET 0xcbf29ce484222325ull
+#define CHECKPOINT_FNV_PRIME 0x100000001b3ull
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    char tool[16];
+    uint64_t payload_bytes;
+    uint64_t checksum;
+} checkpoint_header_t;
+
+typedef struct {
+    char tag[CHECKPOINT_TAG_LEN + 1];
+    uint64_t size;               // Data bytes, before padding
+} checkpoint_section_t;
+
+static uint64_t checkpoint_hash(uint64_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * CHECKPOINT_FNV_PRIME;
+    }
+    return hash;
+}
+
+// 64-bit file positioning (plain fseek/ftell are 32-bit on Windows)
+static bool checkpoint_seek(FILE *file, uint64_t offset, int whence) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, whence) == 0;
+#else
+    return fseeko(file, (off_t)offset, whence) == 0;
+#endif
+}
+
+static bool checkpoint_tell(FILE *file, uint64_t *offset) {
+#ifdef _WIN32
+    __int64 pos = _ftelli64(file);
+#else
+    off_t pos = ftello(file);
+#endif
+    if (pos < 0) return false;
+    *offset = (uint64_t)pos;
+    return true;
+}
+
+// Flush stdio and the OS cache to the device
+static bool checkpoint_sync(FILE *file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Write and hash payload bytes
+static bool checkpoint_write(checkpoint_writer_t *writer, const void *data, size_t size) {
+    if (size > 0 && fwrite(data, 1, size, writer->file) != size) {
+        writer->failed = true;
+        return false;
+    }
+    writer->checksum = checkpoint_hash(writer->checksum, data, size);
+    writer->payload_bytes += size;
+    return true;
+}
+
+bool checkpoint_begin(checkpoint_writer_t *writer, const char *path, const char *tool) {
+    if (!writer || !path || !tool) return false;
+    memset(writer, 0, sizeof(*writer));
+    if (strlen(path) >= sizeof(writer->path) || strlen(tool) >= sizeof(writer->tool)) {
+        return false;
+    }
+    snprintf(writer->path, sizeof(writer->path), "%s", path);
+    snprintf(writer->temp_path, sizeof(writer->temp_path), "%s.tmp", path);
+    snprintf(writer->tool, sizeof(writer->tool), "%s", tool);
+    writer->checksum = CHECKPOINT_FNV_OFFSET;
+
+    // Placeholder header, rewritten by the commit
+    checkpoint_header_t header = {0};
+    writer->file = fopen(writer->temp_path, "wb");
+    if (!writer->file || fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+        checkpoint_abort(writer);
+        return false;
+    }
+    return true;
+}
+
+bool checkpoint_put(checkpoint_writer_t *writer, const char *tag, const void *data, size_t size) {
+    if (!writer || !writer->file || writer->failed) return false;
+    if (!tag || strlen(tag) > CHECKPOINT_TAG_LEN || (size > 0 && !data)) {
+        writer->failed = true;
+        return false;
+    }
+
+    checkpoint_section_t section;
+    memset(&section, 0, sizeof(section));
+    memcpy(section.tag, tag, strlen(tag));
+    section.size = size;
+    static const uint8_t padding[8] = {0};
+    if (!checkpoint_write(writer, &section, sizeof(section)) ||
+        !checkpoint_write(writer, data, size) ||
+        !checkpoint_write(writer, padding, (8 - size % 8) % 8)) {
+        return false;
+    }
+    writer->num_sections++;
+    return true;
+}
+
+bool checkpoint_commit(checkpoint_writer_t *writer) {
+    if (!writer || !writer->file) return false;
+
+    checkpoint_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.num_sections = writer->num_sections;
+    memcpy(header.tool, writer->tool, sizeof(header.tool));
+    header.payload_bytes = writer->payload_bytes;
+    header.checksum = writer->checksum;
+
+    bool ok = !writer->failed && checkpoint_seek(writer->file, 0, SEEK_SET) &&
+              fwrite(&header, sizeof(header), 1, writer->file) == 1 &&
+              checkpoint_sync(writer->file);
+    if (fclose(writer->file) != 0) ok = false;
+    writer->file = NULL;
+#ifdef _WIN32
+    if (ok) remove(writer->path);  // rename() does not replace on Windows
+#endif
+    ok = ok && rename(writer->temp_path, writer->path) == 0;
+    if (!ok) remove(writer->temp_path);
+    return ok;
+}
+
+void checkpoint_abort(checkpoint_writer_t *writer) {
+    if (!writer || !writer->file) return;
+    fclose(writer->file);
+    writer->file = NULL;
+    remove(writer->temp_path);
+}
+
+bool checkpoint_load(checkpoint_t *checkpoint, const char *path, const char *tool) {
+    if (!checkpoint || !path || !tool) return false;
+    memset(checkpoint, 0, sizeof(*checkpoint));
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open checkpoint: %s\n", path);
+        return false;
+    }
+
+    checkpoint_header_t header;
+    uint64_t file_bytes = 0;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == CHECKPOINT_VERSION &&
+              checkpoint_seek(file, 0, SEEK_END) && checkpoint_tell(file, &file_bytes) &&
+              header.payload_bytes == file_bytes - sizeof(header) &&
+              checkpoint_seek(file, sizeof(header), SEEK_SET);
+    if (ok && strncmp(header.tool, tool, sizeof(header.tool)) != 0) {
+        fprintf(stderr, "Checkpoint %s was written by %.16s, not %s\n", path, header.tool, tool);
+        fclose(file);
+        return false;
+    }
+
+    uint8_t *payload = ok ? malloc(header.payload_bytes ? (size_t)header.payload_bytes : 1) : NULL;
+    ok = payload && fread(payload, 1, (size_t)header.payload_bytes, file) == header.payload_bytes &&
+         checkpoint_hash(CHECKPOINT_FNV_OFFSET, payload, (size_t)header.payload_bytes) == header.checksum;
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Damaged checkpoint: %s\n", path);
+        free(payload);
+        return false;
+    }
+
+    checkpoint->payload = payload;
+    checkpoint->payload_bytes = header.payload_bytes;
+    checkpoint->num_sections = header.num_sections;
+    return true;
+}
+
+const void *checkpoint_find(const checkpoint_t *checkpoint, const char *tag, size_t *size) {
+    if (!checkpoint || !checkpoint->payload || !tag) return NULL;
+
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < checkpoint->num_sections; i++) {
+        if (checkpoint->payload_bytes - offset < sizeof(checkpoint_section_t)) return NULL;
+        checkpoint_section_t section;
+        memcpy(&section, checkpoint->payload + offset, sizeof(section));
+        offset += sizeof(section);
+        if (section.size > checkpoint->payload_bytes - offset) return NULL;
+
+        if (strncmp(section.tag, tag, sizeof(section.tag)) == 0) {
+            if (size) *size = (size_t)section.size;
+            return checkpoint->payload + offset;
+        }
+        offset += (section.size + 7) / 8 * 8;
+    }
+    return NULL;
+}
+
+bool checkpoint_get(const checkpoint_t *checkpoint, const char *tag, void *data, size_t size) {
+    size_t found = 0;
+    const void *section = checkpoint_find(checkpoint, tag, &found);
+    if (!section || found != size) return false;
+    if (size > 0) memcpy(data, section, size);
+    return true;
+}
+
+void checkpoint_free(checkpoint_t *checkpoint) {
+    if (!checkpoint) return;
+    free(checkpoint->payload);
+    memset(checkpoint, 0, sizeof(*checkpoint));
+}
+
+bool checkpoint_sync_output(FILE *file, uint64_t *bytes) {
+    return file && bytes && checkpoint_sync(file) && checkpoint_tell(file, bytes);
+}
+
+FILE *checkpoint_reopen_output(const char *path, uint64_t bytes) {
+    FILE *file = fopen(path, "r+b");
+    uint64_t size = 0;
+    bool ok = file && checkpoint_seek(file, 0, SEEK_END) && checkpoint_tell(file, &size) &&
+              size >= bytes && fflush(file) == 0;
+#ifdef _WIN32
+    ok = ok && _chsize_s(_fileno(file), (__int64)bytes) == 0;
+#else
+    ok = ok && ftruncate(fileno(file), (off_t)bytes) == 0;
+#endif
+    ok = ok && checkpoint_seek(file, bytes, SEEK_SET);
+    if (!ok) {
+        fprintf(stderr, "Cannot resume output %s at byte %llu\n", path, (unsigned long long)bytes);
+        if (file) fclose(file);
+        return NULL;
+    }
+    return file;
+}
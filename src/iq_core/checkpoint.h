@@ -0,0 +1,96 @@
+#ifndef IQ_CHECKPOINT_H
+#define IQ_CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Pipeline checkpoints
+ *
+ * A checkpoint is a set of tagged binary sections in one file: the stream
+ * position, the filter and detector state of each stage and the sizes of
+ * the outputs written so far. Each module saves and restores its own
+ * sections (pfb_save_state, cluster_save_state, ...); the tool adds its
+ * counters and output positions.
+ *
+ * Writes go to <path>.tmp and are renamed over <path> once complete, so a
+ * run killed while checkpointing leaves the previous checkpoint intact.
+ * The header carries the tool name and a checksum of the sections; a file
+ * that fails either is rejected on load.
+ *
+ * Sections hold the in-memory layout of their state, so a checkpoint is
+ * only read back by the same build on the same machine.
+ *
+ * Usage:
+ *   checkpoint_writer_t w;
+ *   checkpoint_begin(&w, path, "iqchan");
+ *   checkpoint_put(&w, "stream", &position, sizeof(position));
+ *   pfb_save_state(pfb, &w);
+ *   checkpoint_commit(&w);
+ *
+ *   checkpoint_t cp;
+ *   checkpoint_load(&cp, path, "iqchan");
+ *   checkpoint_get(&cp, "stream", &position, sizeof(position));
+ *   pfb_load_state(pfb, &cp);
+ *   checkpoint_free(&cp);
+ *
+ * Thread Safety: one thread per writer or checkpoint
+ */
+
+// Longest section tag, without the terminator
+#define CHECKPOINT_TAG_LEN 23
+
+// Longest checkpoint path
+#define CHECKPOINT_MAX_PATH 1024
+
+typedef struct {
+    FILE *file;                  // The temporary file, NULL once committed
+    char path[CHECKPOINT_MAX_PATH];
+    char temp_path[CHECKPOINT_MAX_PATH + 8];
+    char tool[16];
+    uint32_t num_sections;
+    uint64_t payload_bytes;      // Section headers and data after the file header
+    uint64_t checksum;           // FNV-1a over the payload
+    bool failed;                 // A put failed; commit discards the file
+} checkpoint_writer_t;
+
+typedef struct {
+    uint8_t *payload;            // Every section, as written
+    uint64_t payload_bytes;
+    uint32_t num_sections;
+} checkpoint_t;
+
+// Start a checkpoint of 'tool' to be committed to 'path'
+bool checkpoint_begin(checkpoint_writer_t *writer, const char *path, const char *tool);
+
+// Append one section; tags are unique within a checkpoint
+bool checkpoint_put(checkpoint_writer_t *writer, const char *tag, const void *data, size_t size);
+
+// Flush the sections to disk and replace 'path' with them; false (and the
+// previous checkpoint kept) if any put or write failed
+bool checkpoint_commit(checkpoint_writer_t *writer);
+
+// Drop an uncommitted checkpoint
+void checkpoint_abort(checkpoint_writer_t *writer);
+
+// Read a checkpoint written by 'tool'; false if missing, damaged or another tool's
+bool checkpoint_load(checkpoint_t *checkpoint, const char *path, const char *tool);
+
+// A section's data and size, or NULL if the checkpoint has no such tag
+const void *checkpoint_find(const checkpoint_t *checkpoint, const char *tag, size_t *size);
+
+// Copy a section of exactly 'size' bytes; false if missing or of another size
+bool checkpoint_get(const checkpoint_t *checkpoint, const char *tag, void *data, size_t size);
+
+void checkpoint_free(checkpoint_t *checkpoint);
+
+// Flush an output file to disk and report its size, for the checkpoint
+bool checkpoint_sync_output(FILE *file, uint64_t *bytes);
+
+// Cut an output file back to 'bytes' (what a checkpoint recorded) and open
+// it for appending from there; NULL if it is shorter or cannot be opened
+FILE *checkpoint_reopen_output(const char *path, uint64_t bytes);
+
+#endif // IQ_CHECKPOINT_H
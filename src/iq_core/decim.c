@@ -0,0 +1,338 @@
+#include "decim.h"
+#include "window.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// CIC input quantisation: 24 bits below full scale
+#define DECIM_CIC_INPUT_SCALE 8388608.0
+
+// Kaiser taps for DECIM_STOPBAND_DB with a transition of delta (cycles/sample)
+static uint32_t kaiser_length(double delta) {
+    double taps = ceil((DECIM_STOPBAND_DB - 8.0) / (2.285 * 2.0 * M_PI * delta)) + 1.0;
+    return taps < 3.0 ? 3 : (uint32_t)taps;
+}
+
+// Halfband from rate to rate / 2 keeping fp (cycles/sample) alias free:
+// 4k + 3 taps; 0 if fp does not fit
+static uint32_t halfband_length(double fp) {
+    if (fp <= 0.0 || fp >= 0.25) return 0;
+    uint32_t length = kaiser_length(0.5 - 2.0 * fp);
+    length = length < 7 ? 7 : length;
+    return length + (3 - length % 4 + 4) % 4;
+}
+
+// Final FIR by factor with output rate 1 / factor (cycles/sample); odd
+// length for a whole-sample group delay; 0 if fp does not fit
+static uint32_t final_fir_length(uint32_t factor, double fp) {
+    double output = 1.0 / factor;
+    if (fp <= 0.0 || 2.0 * fp >= output) return 0;
+    return kaiser_length(output - 2.0 * fp) | 1;
+}
+
+static bool cic_fits(uint32_t factor, double passband) {
+    return factor <= DECIM_CIC_MAX_FACTOR &&
+           passband * factor <= DECIM_CIC_MAX_PASSBAND * (1.0 + 1e-9);
+}
+
+/**
+ * @brief Design a Kaiser-windowed sinc low-pass with unit DC gain
+ *
+ * cutoff is in cycles per sample; a halfband keeps only the centre tap and
+ * the taps an odd distance from it.
+ */
+static float *design_lowpass(uint32_t length, double cutoff, bool halfband) {
+    double beta = 0.1102 * (DECIM_STOPBAND_DB - 8.7);
+    const window_t *window = window_acquire(WINDOW_KAISER, length, beta);
+    float *taps = (float *)malloc(length * sizeof(float));
+    if (!window || !taps) {
+        if (window) window_release(window);
+        free(taps);
+        return NULL;
+    }
+
+    double center = (length - 1) / 2.0;
+    double sum = 0.0;
+    const double *design = window->coefficients;
+    for (uint32_t i = 0; i < length; i++) {
+        double x = i - center;
+        double tap = fabs(x) < 1e-10 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        if (halfband && x != 0.0 && ((uint32_t)fabs(x) % 2) == 0) tap = 0.0;
+        tap *= design[i];
+        taps[i] = (float)tap;
+        sum += tap;
+    }
+    window_release(window);
+
+    for (uint32_t i = 0; i < length; i++) {
+        taps[i] = (float)(taps[i] / sum);
+    }
+    return taps;
+}
+
+/**
+ * @brief Add one FIR stage to the chain
+ */
+static bool add_fir_stage(decim_t *decim, uint32_t length, uint32_t decimation, bool halfband) {
+    float *taps = design_lowpass(length, halfband ? 0.25 : 0.5 / decimation, halfband);
+    if (!taps) return false;
+
+    decim_fir_t *stage = &decim->stages[decim->num_stages++];
+    stage->decimation = decimation;
+    stage->length = length;
+    stage->stride = halfband ? 2 : 1;
+    stage->num_taps = (length + stage->stride - 1) / stage->stride;
+    stage->history = (float *)calloc(2 * (size_t)length * decim->channels, sizeof(float));
+    if (!stage->history) {
+        free(taps);
+        return false;
+    }
+
+    // Symmetric taps: the newest-first order is the design order.
+    // A halfband of 4k+3 taps keeps the even ones and the centre
+    if (halfband) {
+        stage->center_offset = (length - 1) / 2;
+        stage->center_tap = taps[stage->center_offset];
+        for (uint32_t t = 0; t < stage->num_taps; t++) taps[t] = taps[2 * t];
+    }
+    stage->taps = taps;
+    return true;
+}
+
+/**
+ * @brief Split a decimation factor into CIC, halfband and FIR stages
+ */
+void decim_plan_factor(decim_plan_t *plan, uint32_t decimation) {
+    if (!plan) return;
+
+    plan->cic_factor = 1;
+    plan->num_halfbands = 0;
+    plan->fir_factor = decimation;
+    if (decimation <= 1) {
+        plan->fir_factor = 1;
+        return;
+    }
+
+    // Largest CIC factor leaving DECIM_CIC_MIN_REMAINDER or more
+    uint32_t remaining = decimation;
+    if (decimation >= DECIM_CIC_MIN_DECIMATION) {
+        for (uint32_t r = DECIM_CIC_MAX_FACTOR; r >= 2; r--) {
+            if (decimation % r == 0 && decimation / r >= DECIM_CIC_MIN_REMAINDER) {
+                plan->cic_factor = r;
+                remaining /= r;
+                break;
+            }
+        }
+    }
+    while (remaining % 2 == 0 && remaining >= 4 && plan->num_halfbands + 1 < DECIM_MAX_STAGES) {
+        plan->num_halfbands++;
+        remaining /= 2;
+    }
+    plan->fir_factor = remaining;
+}
+
+/**
+ * @brief Total decimation factor of a plan
+ */
+uint32_t decim_plan_decimation(const decim_plan_t *plan) {
+    if (!plan) return 0;
+    uint64_t factor = (uint64_t)plan->cic_factor * plan->fir_factor;
+    for (uint32_t h = 0; h < plan->num_halfbands && factor <= UINT32_MAX; h++) factor *= 2;
+    return factor > UINT32_MAX ? 0 : (uint32_t)factor;
+}
+
+/**
+ * @brief Multiply-adds per input sample and channel of a plan
+ */
+double decim_plan_macs(const decim_plan_t *plan, double passband) {
+    if (!plan || plan->cic_factor == 0 || plan->fir_factor == 0 || passband <= 0.0 ||
+        plan->num_halfbands + (plan->fir_factor > 1) > DECIM_MAX_STAGES ||
+        decim_plan_decimation(plan) == 0) {
+        return -1.0;
+    }
+
+    // Each stage's cost per its own input, scaled by the factor before it
+    double macs = 0.0;
+    double before = 1.0;
+    if (plan->cic_factor > 1) {
+        if (!cic_fits(plan->cic_factor, passband)) return -1.0;
+        macs += DECIM_CIC_ORDER + (DECIM_CIC_ORDER + 1.0) / plan->cic_factor;
+        before = plan->cic_factor;
+    }
+    for (uint32_t h = 0; h < plan->num_halfbands; h++) {
+        uint32_t length = halfband_length(passband * before);
+        if (length == 0) return -1.0;
+        macs += ((length + 1) / 2 + 1) / 2.0 / before;
+        before *= 2.0;
+    }
+    if (plan->fir_factor > 1) {
+        uint32_t length = final_fir_length(plan->fir_factor, passband * before);
+        if (length == 0) return -1.0;
+        macs += (double)length / plan->fir_factor / before;
+    }
+    return macs;
+}
+
+/**
+ * @brief Design the decimation chain of a plan
+ */
+bool decim_init(decim_t *decim, const decim_plan_t *plan, double passband, uint32_t channels) {
+    if (!decim || channels == 0 || channels > DECIM_MAX_CHANNELS) return false;
+    double macs = decim_plan_macs(plan, passband);
+    if (macs < 0.0) return false;
+
+    memset(decim, 0, sizeof(*decim));
+    decim->channels = channels;
+    decim->decimation = decim_plan_decimation(plan);
+    decim->macs_per_input = macs;
+
+    double before = 1.0;
+    if (plan->cic_factor > 1) {
+        uint32_t r = plan->cic_factor;
+        decim->have_cic = true;
+        decim->cic.decimation = r;
+        decim->cic.scale = 1.0 / (DECIM_CIC_INPUT_SCALE * pow((double)r, DECIM_CIC_ORDER));
+        decim->delay += DECIM_CIC_ORDER * (r - 1) / 2.0;
+        before = r;
+    }
+    for (uint32_t h = 0; h < plan->num_halfbands; h++) {
+        if (!add_fir_stage(decim, halfband_length(passband * before), 2, true)) {
+            decim_free(decim);
+            return false;
+        }
+        decim->delay += (decim->stages[decim->num_stages - 1].length - 1) / 2.0 * before;
+        before *= 2.0;
+    }
+    if (plan->fir_factor > 1) {
+        uint32_t length = final_fir_length(plan->fir_factor, passband * before);
+        if (!add_fir_stage(decim, length, plan->fir_factor, false)) {
+            decim_free(decim);
+            return false;
+        }
+        decim->delay += (length - 1) / 2.0 * before;
+    }
+    return true;
+}
+
+// Two's complement view of a wrapped integrator value
+static int64_t cic_signed(uint64_t value) {
+    return value > (uint64_t)INT64_MAX ? -(int64_t)(~value) - 1 : (int64_t)value;
+}
+
+// CIC decimation in place; returns the outputs written
+static size_t cic_block(decim_cic_t *cic, uint32_t channels, float *samples, size_t count) {
+    size_t outputs = 0;
+    for (size_t n = 0; n < count; n++) {
+        uint64_t value[DECIM_MAX_CHANNELS];
+        for (uint32_t rail = 0; rail < channels; rail++) {
+            // Integrators wrap modulo 2^64; the combs undo it exactly
+            uint64_t v = (uint64_t)(int64_t)lrint(samples[channels * n + rail] *
+                                                  DECIM_CIC_INPUT_SCALE);
+            for (int s = 0; s < DECIM_CIC_ORDER; s++) {
+                cic->integrators[rail][s] += v;
+                v = cic->integrators[rail][s];
+            }
+            value[rail] = v;
+        }
+        if (++cic->pending < cic->decimation) continue;
+        cic->pending = 0;
+
+        for (uint32_t rail = 0; rail < channels; rail++) {
+            uint64_t v = value[rail];
+            for (int s = 0; s < DECIM_CIC_ORDER; s++) {
+                uint64_t previous = cic->combs[rail][s];
+                cic->combs[rail][s] = v;
+                v -= previous;
+            }
+            samples[channels * outputs + rail] = (float)(cic_signed(v) * cic->scale);
+        }
+        outputs++;
+    }
+    return outputs;
+}
+
+// FIR decimation in place for a constant channel count, so each caller
+// gets its own unrolled copy; returns the outputs written
+static inline size_t fir_block(decim_fir_t *stage, float *samples, size_t count,
+                               const uint32_t channels) {
+    const uint32_t length = stage->length;
+    const size_t step = (size_t)channels * stage->stride;
+    const size_t center = (size_t)channels * stage->center_offset;
+    size_t outputs = 0;
+
+    for (size_t n = 0; n < count; n++) {
+        uint32_t w = stage->history_index;
+        float *first = stage->history + (size_t)channels * w;
+        float *second = stage->history + (size_t)channels * (w + length);
+        for (uint32_t c = 0; c < channels; c++) first[c] = second[c] = samples[channels * n + c];
+        stage->history_index = w + 1 == length ? 0 : w + 1;
+        if (++stage->pending < stage->decimation) continue;
+        stage->pending = 0;
+
+        // Newest sample at slot w + length, older ones below it
+        const float *newest = second;
+        const float *middle = newest - center;
+        float acc[DECIM_MAX_CHANNELS];
+        for (uint32_t c = 0; c < channels; c++) acc[c] = stage->center_tap * middle[c];
+        for (uint32_t t = 0; t < stage->num_taps; t++) {
+            const float *x = newest - t * step;
+            for (uint32_t c = 0; c < channels; c++) acc[c] += stage->taps[t] * x[c];
+        }
+        for (uint32_t c = 0; c < channels; c++) samples[channels * outputs + c] = acc[c];
+        outputs++;
+    }
+    return outputs;
+}
+
+/**
+ * @brief Run a block through every stage in place
+ */
+size_t decim_process(decim_t *decim, float *samples, size_t count) {
+    if (!decim || !samples || decim->channels == 0) return 0;
+
+    if (decim->have_cic) count = cic_block(&decim->cic, decim->channels, samples, count);
+    for (uint32_t s = 0; s < decim->num_stages && count > 0; s++) {
+        if (decim->channels == 1) {
+            count = fir_block(&decim->stages[s], samples, count, 1);
+        } else {
+            count = fir_block(&decim->stages[s], samples, count, 2);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Clear the CIC and FIR states
+ */
+void decim_reset(decim_t *decim) {
+    if (!decim) return;
+
+    memset(decim->cic.integrators, 0, sizeof(decim->cic.integrators));
+    memset(decim->cic.combs, 0, sizeof(decim->cic.combs));
+    decim->cic.pending = 0;
+    for (uint32_t s = 0; s < decim->num_stages; s++) {
+        decim_fir_t *stage = &decim->stages[s];
+        if (stage->history) {
+            memset(stage->history, 0, 2 * (size_t)stage->length * decim->channels * sizeof(float));
+        }
+        stage->history_index = 0;
+        stage->pending = 0;
+    }
+}
+
+/**
+ * @brief Free the stage filters
+ */
+void decim_free(decim_t *decim) {
+    if (!decim) return;
+
+    for (uint32_t s = 0; s < decim->num_stages; s++) {
+        free(decim->stages[s].taps);
+        free(decim->stages[s].history);
+    }
+    memset(decim, 0, sizeof(*decim));
+}
@@ -0,0 +1,108 @@
+#ifndef IQ_LAB_DECIM_H
+#define IQ_LAB_DECIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Multi-stage integer decimator
+ *
+ * Reduces the rate of real (1 channel) or interleaved IQ (2 channels)
+ * float blocks, in place, through
+ *
+ *   [CIC R] -> [halfband /2]... -> [FIR /F]
+ *
+ * as laid out by a decim_plan_t. Every filter stage keeps a mirrored delay
+ * line and only evaluates the outputs it keeps: a stage decimating by F
+ * costs one dot product per F inputs, and halfbands skip their zero taps.
+ * The CIC (order DECIM_CIC_ORDER) runs in integer arithmetic, so it is
+ * exact across blocks like the FIR stages and any block split gives the
+ * same outputs.
+ *
+ * Stages are designed for DECIM_STOPBAND_DB of attenuation and keep
+ * 0..passband alias free. The CIC is only planned where its passband droop
+ * stays below 0.3 dB: passband at most DECIM_CIC_MAX_PASSBAND of its
+ * output rate. Outputs follow the input by decim_t.delay input samples.
+ */
+
+#define DECIM_MAX_STAGES 24               // Halfbands plus the final FIR
+#define DECIM_MAX_CHANNELS 2
+#define DECIM_CIC_ORDER 4
+#define DECIM_CIC_MAX_FACTOR 512          // Keeps the integer CIC within 64 bits
+#define DECIM_CIC_MIN_DECIMATION 64       // decim_plan_factor: smallest D given a CIC
+#define DECIM_CIC_MIN_REMAINDER 8         // ... and the factor it leaves to the FIRs
+#define DECIM_CIC_MAX_PASSBAND 0.05       // Passband edge / CIC output rate
+#define DECIM_STOPBAND_DB 80.0
+
+// Stage layout: D = cic_factor * 2^num_halfbands * fir_factor
+typedef struct {
+    uint32_t cic_factor;     // R (1: no CIC)
+    uint32_t num_halfbands;
+    uint32_t fir_factor;     // Final FIR factor F (1: none)
+} decim_plan_t;
+
+// One FIR decimating stage: taps[t] multiplies the sample stride * t
+// before the newest, plus the centre tap of a halfband
+typedef struct {
+    uint32_t decimation;     // Inputs per output
+    uint32_t length;         // Filter span (samples)
+    uint32_t num_taps;       // Strided taps
+    uint32_t stride;         // 1, or 2 for a halfband
+    float *taps;             // Strided taps, newest sample first
+    float center_tap;        // Halfband centre tap (0 otherwise)
+    uint32_t center_offset;  // Its delay from the newest sample
+    float *history;          // Interleaved channels, each sample twice, length apart
+    uint32_t history_index;  // Oldest slot, the next one written
+    uint32_t pending;        // Inputs since the last output
+} decim_fir_t;
+
+// Cascaded integrator-comb decimator, one rail per channel
+typedef struct {
+    uint32_t decimation;                                   // R
+    uint64_t integrators[DECIM_MAX_CHANNELS][DECIM_CIC_ORDER];
+    uint64_t combs[DECIM_MAX_CHANNELS][DECIM_CIC_ORDER];   // Previous comb inputs
+    uint32_t pending;                                      // Inputs since the last output
+    double scale;                                          // 1 / (input scale * R^order)
+} decim_cic_t;
+
+// Decimation chain state
+typedef struct {
+    uint32_t channels;       // 1: real samples, 2: interleaved IQ
+    uint32_t decimation;     // Total factor D
+    double delay;            // Group delay (input samples)
+    double macs_per_input;   // Multiply-adds per input sample and channel
+
+    bool have_cic;
+    decim_cic_t cic;
+    uint32_t num_stages;
+    decim_fir_t stages[DECIM_MAX_STAGES];
+} decim_t;
+
+// Split a factor D: a CIC when D >= DECIM_CIC_MIN_DECIMATION (leaving
+// DECIM_CIC_MIN_REMAINDER or more), then halfbands while the final FIR
+// keeps a factor of 2 or more
+void decim_plan_factor(decim_plan_t *plan, uint32_t decimation);
+
+// Total factor of a plan
+uint32_t decim_plan_decimation(const decim_plan_t *plan);
+
+// Cost of a plan keeping passband (cycles per input sample) alias free, in
+// multiply-adds per input sample and channel (CIC additions count as one);
+// negative if the passband does not fit the plan
+double decim_plan_macs(const decim_plan_t *plan, double passband);
+
+// Design the stages of a plan for 1 or 2 channels
+bool decim_init(decim_t *decim, const decim_plan_t *plan, double passband, uint32_t channels);
+
+// Decimate count samples (channels floats each) in place; returns the
+// outputs left at the start of samples
+size_t decim_process(decim_t *decim, float *samples, size_t count);
+
+// Clear the stage states
+void decim_reset(decim_t *decim);
+
+// Free the stage filters
+void decim_free(decim_t *decim);
+
+#endif // IQ_LAB_DECIM_H
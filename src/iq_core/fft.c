@@ -5,34 +5,43 @@
  *
  * PURPOSE:
  *   Provides high-performance FFT processing for RF signal analysis. Implements
- *   radix-2 Cooley-Tukey algorithm with optimized memory usage and real-time
- *   processing capabilities. Essential for spectrum analysis, filtering, and
- *   demodulation operations.
+ *   a radix-4 Stockham autosort algorithm with optimized memory usage and
+ *   real-time processing capabilities. Essential for spectrum analysis,
+ *   filtering, and demodulation operations.
  *
  * ALGORITHMS:
- *   - Radix-2 FFT: Decimation-in-time Cooley-Tukey algorithm
- *   - Bit-reversal permutation for optimal memory access
- *   - Pre-computed twiddle factors for efficiency
- *   - In-place processing to minimize memory usage
+ *   - Radix-4 FFT: Stockham autosort decimation-in-frequency passes
+ *   - Radix-2 cleanup pass when log2(N) is odd
+ *   - Natural-order output, no bit-reversal permutation
+ *   - Pre-computed, per-stage packed twiddle factors
+ *   - Real-input FFT: N/2-point complex FFT plus Hermitian post-twiddle
+ *   - Mixed radix 4/2/3/5/7 Stockham passes for 2^a * 3^b * 5^c * 7^d sizes
+ *   - Bluestein chirp-z fallback for any other length
+ *   - Sizes 2..256: generated straight-line codelets (tools/fft_codegen.c)
+ *     with constant twiddles, no pass loop and no work buffer
  *
  * FEATURES:
  *   - Forward and inverse FFT support
- *   - Automatic size validation (power-of-2 requirement)
+ *   - Any size 1..FFT_MAX_SIZE, with fft_query_cost() to compare candidates
  *   - FFT shift for proper frequency domain representation
- *   - Windowing support (Hann, Hamming, Blackman)
+ *   - Fused window + FFT + shift + power frames for STFT tools
  *   - Memory-efficient plans with reusable twiddle factors
  *   - Comprehensive error handling and validation
  *
  * PERFORMANCE:
  *   - O(N log N) complexity for N-point FFT
+ *   - Radix-4 needs ~25% fewer multiplies and half the passes of radix-2
  *   - Pre-computed twiddle factors reduce per-transform overhead
- *   - In-place operation minimizes memory allocation
+ *   - Per-thread work buffer: no allocation per transform, carved from the
+ *     thread's bound arena (arena.h) when a pipeline has reserved one
+ *   - SSE2 / AVX2+FMA / NEON butterflies and |X|^2 loops, picked at plan
+ *     creation by CPU feature detection, scalar C kept as the fallback
  *   - Optimized for real-time SDR applications
  *
  * USAGE:
  *   1. Create FFT plan: fft_plan_create(size, direction)
  *   2. Execute transform: fft_execute(plan, input, output)
- *   3. Apply window: fft_apply_window(data, window, size)
+ *   3. STFT frames: fft_spectral_frame(plan_f32, iq, window, row, db)
  *   4. Clean up: fft_plan_destroy(plan)
  *
  * DEPENDENCIES:
@@ -40,79 +49,276 @@
  *   - Custom complex type definitions from fft.h
  *
  * LIMITATIONS:
- *   - FFT size must be power of 2 (2^1 to 2^24)
- *   - Maximum size: 16M points (FFT_MAX_SIZE)
+ *   - Powers of two are fastest; Bluestein sizes cost ~3 FFTs of 2N-1 rounded up
+ *   - Maximum size: 1M points (FFT_MAX_SIZE)
  *   - Input/output arrays must be properly allocated
  *
  * =============================================================================
  */
 
 #include "fft.h"
+#include "arena.h"
+#include "hugepage.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FFT_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define FFT_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+#define FFT_MAX_RADIX 7  // Largest native Stockham radix; other primes go to Bluestein
+
 /*
- * Radix-2 FFT implementation using Cooley-Tukey algorithm
- * Optimized for real-time signal processing applications
+ * Stockham autosort FFT: radix-4 passes with a final radix-2 pass when
+ * log2(N) is odd. Each pass reads one buffer and writes the other in natural
+ * order, so no bit-reversal permutation is needed.
  */
 
 // Internal helper functions
 static uint32_t log2_uint32(uint32_t n);
-static void fft_radix2(fft_complex_t *data, uint32_t size, fft_direction_t direction);
-static bool create_bit_reversal_table(uint32_t *table, uint32_t size);
 static bool create_twiddle_factors(fft_complex_t *twiddles, uint32_t size, fft_direction_t direction);
+static void create_stage_twiddles(fft_complex_t *stage_twiddles, const fft_complex_t *twiddles,
+                                  uint32_t size, uint32_t num_radix4_stages);
+static fft_complex_t *fft_get_work_buffer(uint32_t size);
+static inline fft_complex_t fft_cmul(fft_complex_t a, fft_complex_t b);
+static void fft_stockham_radix4(const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                                uint32_t stride, const fft_complex_t *tw, bool inverse);
+static void fft_stockham_radix2(const fft_complex_t *x, fft_complex_t *y, uint32_t stride);
+static fft_complex_f32_t *fft_get_work_buffer_f32(uint32_t size);
+static void fft_stockham_radix4_f32(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t n,
+                                    uint32_t stride, const fft_complex_f32_t *tw, bool inverse);
+static void fft_stockham_radix2_f32(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t stride);
+static void fft_radix4_pass(fft_simd_t simd, const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                            uint32_t stride, const fft_complex_t *tw, bool inverse);
+static void fft_radix4_pass_f32(fft_simd_t simd, const fft_complex_f32_t *x, fft_complex_f32_t *y,
+                                uint32_t n, uint32_t stride, const fft_complex_f32_t *tw, bool inverse);
+static uint32_t fft_power_spectrum_simd(fft_simd_t simd, const fft_complex_t *x, double *out,
+                                        uint32_t size, double norm);
+static uint32_t fft_power_spectrum_f32_simd(fft_simd_t simd, const fft_complex_f32_t *x, float *out,
+                                            uint32_t size, float norm);
+static bool fft_factorize(uint32_t size, uint8_t *factors, uint32_t *num_factors);
+static uint32_t fft_stage_twiddle_count(const fft_plan_t *plan);
+static fft_plan_t *fft_plan_create_default(uint32_t size, fft_direction_t direction);
+static fft_plan_t *fft_plan_create_radix4(uint32_t size, fft_direction_t direction, bool codelet);
+static fft_plan_t *fft_plan_create_mixed(uint32_t size, fft_direction_t direction,
+                                         const uint8_t *factors, uint32_t num_factors);
+static fft_plan_t *fft_plan_create_bluestein(uint32_t size, fft_direction_t direction);
+static fft_plan_f32_t *fft_plan_f32_from(fft_plan_t *ref);
+static bool fft_execute_mixed(const fft_plan_t *plan, const fft_complex_t *input,
+                              fft_complex_t *output);
+static bool fft_execute_bluestein(const fft_plan_t *plan, const fft_complex_t *input,
+                                  fft_complex_t *output);
+static bool fft_execute_mixed_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *input,
+                                  fft_complex_f32_t *output);
+static bool fft_execute_bluestein_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *input,
+                                      fft_complex_f32_t *output);
+static fft_complex_t *fft_get_chirp_buffer(uint32_t size);
+static const fft_complex_f32_t *fft_spectral_transform(const fft_plan_f32_t *plan, const float *iq,
+                                                      const float *window);
+static void fft_mixed_pass(fft_simd_t simd, const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                           uint32_t stride, uint32_t radix, const fft_complex_t *tw, bool inverse);
+static void fft_mixed_pass_f32(fft_simd_t simd, const fft_complex_f32_t *x, fft_complex_f32_t *y,
+                               uint32_t n, uint32_t stride, uint32_t radix,
+                               const fft_complex_f32_t *tw, bool inverse);
+static void fft_codelet_run(fft_simd_t simd, uint32_t log2_size, const fft_complex_t *x,
+                            fft_complex_t *y, bool inverse);
+static void fft_codelet_run_f32(fft_simd_t simd, uint32_t log2_size, const fft_complex_f32_t *xa,
+                                const fft_complex_f32_t *xb, fft_complex_f32_t *ya,
+                                fft_complex_f32_t *yb, bool inverse);
+
+// One per-thread scratch buffer, from the bound arena or the heap
+typedef struct {
+    void *data;
+    uint32_t capacity;          // Elements
+    bool heap;                  // Owned here (freed on release), else arena memory
+} fft_scratch_t;
+
+// Per-thread ping-pong buffers for the Stockham passes, the Bluestein
+// convolution and spectral frames
+static _Thread_local fft_scratch_t fft_work_buffer;
+static _Thread_local fft_scratch_t fft_work_buffer_f32;
+static _Thread_local fft_scratch_t fft_chirp_buffer;
+static _Thread_local fft_scratch_t fft_frame_buffer;
+
+// Arena (and its generation) the arena-backed buffers above came from
+static _Thread_local iq_arena_t *fft_scratch_arena = NULL;
+static _Thread_local uint64_t fft_scratch_generation = 0;
+
+// Heap-backed buffers are freed by this key's destructor when their thread
+// exits, so worker threads need no cleanup call of their own
+static pthread_key_t fft_scratch_key;
+static pthread_once_t fft_scratch_key_once = PTHREAD_ONCE_INIT;
+static bool fft_scratch_key_ok = false;
+static _Thread_local bool fft_scratch_registered = false;
+
+static void *fft_scratch_get(fft_scratch_t *scratch, uint32_t count, size_t elem_bytes);
 
-// Create FFT plan
+/*
+ * Plan cache: one slot per (kind, direction, log2 size). Power-of-two sizes up
+ * to FFT_MAX_SIZE give a small fixed table, so lookup is a direct index. Other
+ * sizes share a short list per (kind, direction) searched linearly; when it is
+ * full, plans are handed out uncached and destroyed on release. The lock only
+ * guards slot bookkeeping; plans are built outside it and are immutable once
+ * published.
+ */
+#define FFT_CACHE_LEVELS 21     // log2 sizes 0..20 (FFT_MAX_SIZE == 2^20)
+#define FFT_CACHE_EXTRA_SLOTS 32 // non-power-of-two sizes per (kind, direction)
+#define FFT_CACHE_KIND_F64  0
+#define FFT_CACHE_KIND_F32  1
+#define FFT_CACHE_KIND_REAL 2   // direction slot 0 only
+
+typedef struct {
+    void *plan;
+    uint32_t size;
+    uint32_t refcount;
+} fft_cache_entry_t;
+
+static fft_cache_entry_t fft_plan_cache[3][2][FFT_CACHE_LEVELS];
+static fft_cache_entry_t fft_plan_cache_extra[3][2][FFT_CACHE_EXTRA_SLOTS];
+static atomic_flag fft_plan_cache_lock = ATOMIC_FLAG_INIT;
+
+// Create FFT plan (measured wisdom first, then the fixed rules)
 fft_plan_t *fft_plan_create(uint32_t size, fft_direction_t direction) {
-    if (!fft_is_power_of_two(size) || size == 0 || size > FFT_MAX_SIZE) {
+    if (size == 0 || size > FFT_MAX_SIZE) {
+        return NULL;
+    }
+
+    fft_wisdom_t wisdom;
+    if (fft_wisdom_lookup(size, FFT_PRECISION_F64, &wisdom)) {
+        fft_plan_t *plan = fft_plan_create_as(size, direction, wisdom.algorithm, wisdom.simd);
+        if (plan) {
+            return plan;
+        }
+    }
+    return fft_plan_create_default(size, direction);
+}
+
+// Internal: Plan by the fixed rules: codelet or radix-4 for powers of two,
+// mixed radix for 2/3/5/7-smooth sizes, Bluestein otherwise
+static fft_plan_t *fft_plan_create_default(uint32_t size, fft_direction_t direction) {
+    if (fft_is_power_of_two(size)) {
+        return fft_plan_create_radix4(size, direction, true);
+    }
+
+    uint8_t factors[FFT_MAX_FACTORS];
+    uint32_t num_factors = 0;
+    if (fft_factorize(size, factors, &num_factors)) {
+        return fft_plan_create_mixed(size, direction, factors, num_factors);
+    }
+
+    return fft_plan_create_bluestein(size, direction);
+}
+
+// Create a plan with a given schedule and kernel family
+fft_plan_t *fft_plan_create_as(uint32_t size, fft_direction_t direction,
+                               fft_algorithm_t algorithm, fft_simd_t simd) {
+    if (size == 0 || size > FFT_MAX_SIZE || !fft_simd_supported(simd)) {
         return NULL;
     }
 
-    fft_plan_t *plan = (fft_plan_t *)malloc(sizeof(fft_plan_t));
+    uint8_t factors[FFT_MAX_FACTORS];
+    uint32_t num_factors = 0;
+    fft_plan_t *plan = NULL;
+    switch (algorithm) {
+        case FFT_ALGO_CODELET:
+            if (!fft_is_power_of_two(size) || size < 2 || size > FFT_CODELET_MAX_SIZE) return NULL;
+            plan = fft_plan_create_radix4(size, direction, true);
+            break;
+        case FFT_ALGO_RADIX4:
+            if (!fft_is_power_of_two(size)) return NULL;
+            plan = fft_plan_create_radix4(size, direction, false);
+            break;
+        case FFT_ALGO_MIXED_RADIX:
+            if (!fft_factorize(size, factors, &num_factors)) return NULL;
+            plan = fft_plan_create_mixed(size, direction, factors, num_factors);
+            break;
+        case FFT_ALGO_BLUESTEIN:
+            plan = fft_plan_create_bluestein(size, direction);
+            break;
+        default:
+            return NULL;
+    }
+
+    if (plan) {
+        plan->simd = simd;
+        if (plan->chirp_plan) {
+            plan->chirp_plan->simd = simd;
+        }
+    }
+    return plan;
+}
+
+// Internal: Power-of-two plan (radix-4 passes plus optional radix-2 pass, or
+// a generated codelet for small sizes when 'codelet' allows). No FFT_MAX_SIZE
+// check so Bluestein can build its 2N-1 convolution plan.
+static fft_plan_t *fft_plan_create_radix4(uint32_t size, fft_direction_t direction, bool codelet) {
+    fft_plan_t *plan = (fft_plan_t *)calloc(1, sizeof(fft_plan_t));
     if (!plan) {
         return NULL;
     }
 
     plan->size = size;
     plan->direction = direction;
+    plan->algorithm = FFT_ALGO_RADIX4;
     plan->is_inverse_normalized = (direction == FFT_INVERSE);
+    plan->log2_size = log2_uint32(size);
+    plan->num_radix4_stages = plan->log2_size / 2;
+    plan->has_radix2_stage = (plan->log2_size % 2) != 0;
+    plan->stage_twiddles = NULL;
+    plan->simd = fft_simd_detect();
+
+    // Codelets carry their twiddles as constants: no tables to build
+    if (codelet && size >= 2 && size <= FFT_CODELET_MAX_SIZE) {
+        plan->algorithm = FFT_ALGO_CODELET;
+        return plan;
+    }
 
-    // Allocate twiddle factors
-    uint32_t num_twiddles = size / 2;
-    plan->twiddle_factors = (fft_complex_t *)malloc(num_twiddles * sizeof(fft_complex_t));
+    // Allocate twiddle factors (at least one entry so size 1 plans are valid)
+    uint32_t num_twiddles = size > 1 ? size / 2 : 1;
+    plan->twiddle_factors = (fft_complex_t *)iq_huge_alloc(num_twiddles * sizeof(fft_complex_t));
     if (!plan->twiddle_factors) {
         free(plan);
         return NULL;
     }
 
-    // Allocate bit reversal table
-    plan->bit_reversal_table = (uint32_t *)malloc(size * sizeof(uint32_t));
-    if (!plan->bit_reversal_table) {
-        free(plan->twiddle_factors);
+    // Create twiddle factors
+    if (!create_twiddle_factors(plan->twiddle_factors, size, direction)) {
+        iq_huge_free(plan->twiddle_factors);
         free(plan);
         return NULL;
     }
 
-    // Create bit reversal table
-    if (!create_bit_reversal_table(plan->bit_reversal_table, size)) {
-        free(plan->bit_reversal_table);
-        free(plan->twiddle_factors);
-        free(plan);
-        return NULL;
-    }
+    // Radix-4 passes need W^p, W^2p, W^3p; packing them per stage keeps each
+    // pass reading one contiguous stream. Total size is below N entries.
+    if (plan->num_radix4_stages > 0) {
+        uint32_t num_stage_twiddles = 0;
+        for (uint32_t n = size; n >= 4; n /= 4) {
+            num_stage_twiddles += 3 * (n / 4);
+        }
 
-    // Create twiddle factors
-    if (!create_twiddle_factors(plan->twiddle_factors, size, direction)) {
-        free(plan->bit_reversal_table);
-        free(plan->twiddle_factors);
-        free(plan);
-        return NULL;
+        plan->stage_twiddles = (fft_complex_t *)iq_huge_alloc(num_stage_twiddles * sizeof(fft_complex_t));
+        if (!plan->stage_twiddles) {
+            iq_huge_free(plan->twiddle_factors);
+            free(plan);
+            return NULL;
+        }
+
+        create_stage_twiddles(plan->stage_twiddles, plan->twiddle_factors,
+                              size, plan->num_radix4_stages);
     }
 
     return plan;
@@ -123,268 +329,1940 @@ void fft_plan_destroy(fft_plan_t *plan) {
     if (!plan) return;
 
     if (plan->twiddle_factors) {
-        free(plan->twiddle_factors);
+        iq_huge_free(plan->twiddle_factors);
         plan->twiddle_factors = NULL;
     }
 
-    if (plan->bit_reversal_table) {
-        free(plan->bit_reversal_table);
-        plan->bit_reversal_table = NULL;
+    if (plan->stage_twiddles) {
+        iq_huge_free(plan->stage_twiddles);
+        plan->stage_twiddles = NULL;
     }
 
+    fft_plan_destroy(plan->chirp_plan);
+    iq_huge_free(plan->chirp);
+    iq_huge_free(plan->chirp_kernel);
     free(plan);
 }
 
-// Execute FFT using pre-computed plan
-bool fft_execute(const fft_plan_t *plan, const fft_complex_t *input, fft_complex_t *output) {
-    if (!plan || !input || !output) {
-        return false;
+// Internal: Mixed-radix plan for sizes made of 2, 3, 4, 5 and 7
+static fft_plan_t *fft_plan_create_mixed(uint32_t size, fft_direction_t direction,
+                                         const uint8_t *factors, uint32_t num_factors) {
+    fft_plan_t *plan = (fft_plan_t *)calloc(1, sizeof(fft_plan_t));
+    if (!plan) {
+        return NULL;
     }
 
-    // Validate plan integrity
-    if (!plan->twiddle_factors || !plan->bit_reversal_table) {
-        return false;
-    }
+    plan->size = size;
+    plan->direction = direction;
+    plan->algorithm = FFT_ALGO_MIXED_RADIX;
+    plan->is_inverse_normalized = (direction == FFT_INVERSE);
+    plan->simd = fft_simd_detect();
+    plan->num_factors = num_factors;
+    memcpy(plan->factors, factors, num_factors);
 
-    // Copy input to output (we'll transform in-place)
-    memcpy(output, input, plan->size * sizeof(fft_complex_t));
+    plan->stage_twiddles = (fft_complex_t *)iq_huge_alloc(fft_stage_twiddle_count(plan) * sizeof(fft_complex_t));
+    if (!plan->stage_twiddles) {
+        free(plan);
+        return NULL;
+    }
 
-    // Apply bit reversal
-    for (uint32_t i = 0; i < plan->size; i++) {
-        uint32_t j = plan->bit_reversal_table[i];
-        if (i < j) {
-            // Swap elements
-            fft_complex_t temp = output[i];
-            output[i] = output[j];
-            output[j] = temp;
+    // Pass with radix r over sub-length n needs W_n^(j*p) for j = 1..r-1,
+    // p < n/r, i.e. W_N^(j*p*N/n); computed directly so no error accumulates
+    double angle_scale = (direction == FFT_FORWARD) ? -2.0 * M_PI : 2.0 * M_PI;
+    fft_complex_t *tw = plan->stage_twiddles;
+    uint32_t n = size;
+    for (uint32_t f = 0; f < num_factors; f++) {
+        uint32_t radix = factors[f];
+        uint32_t step = size / n;
+        for (uint32_t p = 0; p < n / radix; p++) {
+            for (uint32_t j = 1; j < radix; j++) {
+                double angle = angle_scale * (double)(j * p * step) / (double)size;
+                *tw++ = cos(angle) + sin(angle) * I;
+            }
         }
+        n /= radix;
     }
 
-    // Execute radix-2 FFT
-    fft_radix2(output, plan->size, plan->direction);
+    return plan;
+}
 
-    // Normalize inverse FFT
-    if (plan->is_inverse_normalized) {
-        double scale = 1.0 / (double)plan->size;
-        for (uint32_t i = 0; i < plan->size; i++) {
-            output[i] *= scale;
-        }
+// Internal: Bluestein plan. X[k] = c[k] * sum_n (x[n] c[n]) conj(c[k-n]) with
+// c[n] = exp(-/+i*pi*n^2/N); the convolution runs as a power-of-two FFT of
+// length M >= 2N - 1 against the pre-transformed conjugate chirp.
+static fft_plan_t *fft_plan_create_bluestein(uint32_t size, fft_direction_t direction) {
+    fft_plan_t *plan = (fft_plan_t *)calloc(1, sizeof(fft_plan_t));
+    if (!plan) {
+        return NULL;
     }
 
-    return true;
-}
+    uint32_t m = fft_next_power_of_two(2 * size - 1);
+    plan->size = size;
+    plan->direction = direction;
+    plan->algorithm = FFT_ALGO_BLUESTEIN;
+    plan->is_inverse_normalized = (direction == FFT_INVERSE);
+    plan->simd = fft_simd_detect();
+    plan->chirp_plan = fft_plan_create_radix4(m, FFT_FORWARD, true);
+    plan->chirp = (fft_complex_t *)iq_huge_alloc(size * sizeof(fft_complex_t));
+    plan->chirp_kernel = (fft_complex_t *)iq_huge_alloc(m * sizeof(fft_complex_t));
 
-// Convenience function for forward FFT
-bool fft_forward(const fft_complex_t *input, fft_complex_t *output, uint32_t size) {
-    fft_plan_t *plan = fft_plan_create(size, FFT_FORWARD);
-    if (!plan) return false;
+    if (!plan->chirp_plan || !plan->chirp || !plan->chirp_kernel) {
+        fft_plan_destroy(plan);
+        return NULL;
+    }
 
-    bool success = fft_execute(plan, input, output);
-    fft_plan_destroy(plan);
+    // n^2 is reduced mod 2N before scaling so the phase stays exact for large n
+    double sign = (direction == FFT_FORWARD) ? -1.0 : 1.0;
+    for (uint32_t n = 0; n < size; n++) {
+        uint64_t n2 = ((uint64_t)n * n) % (2 * (uint64_t)size);
+        double angle = sign * M_PI * (double)n2 / (double)size;
+        plan->chirp[n] = cos(angle) + sin(angle) * I;
+    }
 
-    return success;
-}
+    plan->chirp_kernel[0] = conj(plan->chirp[0]);
+    for (uint32_t n = 1; n < size; n++) {
+        plan->chirp_kernel[n] = conj(plan->chirp[n]);
+        plan->chirp_kernel[m - n] = conj(plan->chirp[n]);
+    }
 
-// Convenience function for inverse FFT
-bool fft_inverse(const fft_complex_t *input, fft_complex_t *output, uint32_t size) {
-    fft_plan_t *plan = fft_plan_create(size, FFT_INVERSE);
-    if (!plan) return false;
+    if (!fft_execute(plan->chirp_plan, plan->chirp_kernel, plan->chirp_kernel)) {
+        fft_plan_destroy(plan);
+        return NULL;
+    }
 
-    bool success = fft_execute(plan, input, output);
-    fft_plan_destroy(plan);
+    // Fold the 1/M of the inverse convolution FFT into the kernel
+    double scale = 1.0 / (double)m;
+    for (uint32_t k = 0; k < m; k++) {
+        plan->chirp_kernel[k] *= scale;
+    }
 
-    return success;
+    return plan;
 }
 
-// Real-to-complex FFT (for real-valued signals)
-bool fft_real_forward(const double *input, fft_complex_t *output, uint32_t size) {
-    if (!input || !output || size == 0) return false;
+// Execute FFT using pre-computed plan
+bool fft_execute(const fft_plan_t *plan, const fft_complex_t *input, fft_complex_t *output) {
+    if (!plan || !input || !output) {
+        return false;
+    }
 
-    // For now, just copy real input to complex output with zero imaginary parts
-    // A more optimized version would use real FFT algorithms
-    for (uint32_t i = 0; i < size; i++) {
-        output[i] = input[i] + 0.0 * I;
+    if (plan->algorithm == FFT_ALGO_CODELET) {
+        fft_codelet_run(plan->simd, plan->log2_size, input, output, plan->direction == FFT_INVERSE);
+        if (plan->is_inverse_normalized) {
+            double scale = 1.0 / (double)plan->size;
+            for (uint32_t i = 0; i < plan->size; i++) {
+                output[i] *= scale;
+            }
+        }
+        return true;
+    }
+    if (plan->algorithm == FFT_ALGO_MIXED_RADIX) {
+        return fft_execute_mixed(plan, input, output);
+    }
+    if (plan->algorithm == FFT_ALGO_BLUESTEIN) {
+        return fft_execute_bluestein(plan, input, output);
     }
 
-    return fft_forward(output, output, size);
-}
+    // Validate plan integrity
+    if (!plan->twiddle_factors || (plan->num_radix4_stages > 0 && !plan->stage_twiddles)) {
+        return false;
+    }
 
-// Complex-to-real inverse FFT
-bool fft_real_inverse(const fft_complex_t *input, double *output, uint32_t size) {
-    if (!input || !output || size == 0) return false;
+    uint32_t size = plan->size;
+    uint32_t total_stages = plan->num_radix4_stages + (plan->has_radix2_stage ? 1 : 0);
 
-    fft_complex_t *temp = (fft_complex_t *)malloc(size * sizeof(fft_complex_t));
-    if (!temp) return false;
+    if (total_stages == 0) {
+        output[0] = input[0];
+        return true;
+    }
 
-    bool success = fft_inverse(input, temp, size);
-    if (success) {
-        // Extract real parts
-        for (uint32_t i = 0; i < size; i++) {
-            output[i] = creal(temp[i]);
-        }
+    fft_complex_t *work = fft_get_work_buffer(size);
+    if (!work) {
+        return false;
     }
 
-    free(temp);
-    return success;
-}
+    // Ping-pong between output and the work buffer so the last pass lands in
+    // output. An in-place call with an odd pass count would make the first
+    // pass overwrite its own input, so stage the data in the work buffer.
+    const fft_complex_t *src = input;
+    fft_complex_t *dst = (total_stages % 2 != 0) ? output : work;
+    if (input == output && dst == output) {
+        memcpy(work, input, size * sizeof(fft_complex_t));
+        src = work;
+    }
 
-// Check if number is power of two
-bool fft_is_power_of_two(uint32_t n) {
-    return (n != 0) && ((n & (n - 1)) == 0);
-}
+    bool inverse = (plan->direction == FFT_INVERSE);
+    const fft_complex_t *tw = plan->stage_twiddles;
+    uint32_t stride = 1;
 
-// Get next power of two >= n
-uint32_t fft_next_power_of_two(uint32_t n) {
-    if (n == 0) return 1;
+    for (uint32_t n = size; n >= 4; n /= 4) {
+        fft_radix4_pass(plan->simd, src, dst, n, stride, tw, inverse);
+        tw += 3 * (n / 4);
+        stride *= 4;
 
-    n--;
-    n |= n >> 1;
-    n |= n >> 2;
-    n |= n >> 4;
-    n |= n >> 8;
-    n |= n >> 16;
-    n++;
+        src = dst;
+        dst = (dst == output) ? work : output;
+    }
 
-    return n;
-}
+    if (plan->has_radix2_stage) {
+        fft_stockham_radix2(src, dst, stride);
+    }
 
-// Bit reversal function
-uint32_t fft_bit_reverse(uint32_t n, uint32_t bits) {
-    uint32_t result = 0;
-    for (uint32_t i = 0; i < bits; i++) {
-        result = (result << 1) | (n & 1);
-        n >>= 1;
+    // Normalize inverse FFT
+    if (plan->is_inverse_normalized) {
+        double scale = 1.0 / (double)size;
+        for (uint32_t i = 0; i < size; i++) {
+            output[i] *= scale;
+        }
     }
-    return result;
-}
 
-// Magnitude calculation
-double fft_magnitude(fft_complex_t c) {
-    return cabs(c);
+    return true;
 }
 
-// Magnitude squared (more efficient than magnitude for comparisons)
-double fft_magnitude_squared(fft_complex_t c) {
-    return creal(c) * creal(c) + cimag(c) * cimag(c);
-}
+// Internal: Run the mixed-radix pass schedule (same ping-pong as fft_execute)
+static bool fft_execute_mixed(const fft_plan_t *plan, const fft_complex_t *input,
+                              fft_complex_t *output) {
+    if (!plan->stage_twiddles || plan->num_factors == 0) {
+        return false;
+    }
 
-// Phase calculation
-double fft_phase(fft_complex_t c) {
-    return carg(c);
-}
+    uint32_t size = plan->size;
+    fft_complex_t *work = fft_get_work_buffer(size);
+    if (!work) {
+        return false;
+    }
 
-// Magnitude in dB
-double fft_magnitude_db(fft_complex_t c, double reference) {
-    double mag = fft_magnitude(c);
-    if (mag <= 0.0) return -INFINITY;
-    return 20.0 * log10(mag / reference);
-}
+    const fft_complex_t *src = input;
+    fft_complex_t *dst = (plan->num_factors % 2 != 0) ? output : work;
+    if (input == output && dst == output) {
+        memcpy(work, input, size * sizeof(fft_complex_t));
+        src = work;
+    }
 
-// Power spectrum calculation
-bool fft_power_spectrum(const fft_complex_t *fft_output, double *power_spectrum,
-                       uint32_t size, bool normalize) {
-    if (!fft_output || !power_spectrum || size == 0) return false;
+    bool inverse = (plan->direction == FFT_INVERSE);
+    const fft_complex_t *tw = plan->stage_twiddles;
+    uint32_t n = size;
+    uint32_t stride = 1;
 
-    double norm_factor = normalize ? (1.0 / (double)size) : 1.0;
+    for (uint32_t f = 0; f < plan->num_factors; f++) {
+        uint32_t radix = plan->factors[f];
+        fft_mixed_pass(plan->simd, src, dst, n, stride, radix, tw, inverse);
+        tw += (radix - 1) * (n / radix);
+        n /= radix;
+        stride *= radix;
 
-    for (uint32_t i = 0; i < size; i++) {
-        power_spectrum[i] = fft_magnitude_squared(fft_output[i]) * norm_factor;
+        src = dst;
+        dst = (dst == output) ? work : output;
+    }
+
+    if (plan->is_inverse_normalized) {
+        double scale = 1.0 / (double)size;
+        for (uint32_t i = 0; i < size; i++) {
+            output[i] *= scale;
+        }
     }
 
     return true;
 }
 
-// FFT shift: move DC component to center of spectrum
-// This makes negative frequencies appear on the left, DC in middle, positive on right
-bool fft_shift(const fft_complex_t *input, fft_complex_t *output, uint32_t size) {
-    if (!input || !output || size == 0 || size % 2 != 0) return false;
+// Internal: Circular convolution of buf (chirped input, zero padded to M)
+// with the conjugate chirp, in place
+static bool fft_bluestein_convolve(const fft_plan_t *plan, fft_complex_t *buf) {
+    uint32_t m = plan->chirp_plan->size;
 
-    uint32_t half_size = size / 2;
+    if (!fft_execute(plan->chirp_plan, buf, buf)) {
+        return false;
+    }
 
-    // Copy second half to beginning of output (negative frequencies)
-    for (uint32_t i = 0; i < half_size; i++) {
-        output[i] = input[i + half_size];
+    // Inverse FFT as conj(FFT(conj(.))); the 1/M is already in the kernel
+    for (uint32_t k = 0; k < m; k++) {
+        buf[k] = conj(fft_cmul(buf[k], plan->chirp_kernel[k]));
     }
 
-    // Copy first half to end of output (positive frequencies + DC)
-    for (uint32_t i = 0; i < half_size; i++) {
-        output[i + half_size] = input[i];
+    if (!fft_execute(plan->chirp_plan, buf, buf)) {
+        return false;
     }
 
     return true;
 }
 
-// FFT shift for real arrays (power spectrum)
-bool fft_shift_real(const double *input, double *output, uint32_t size) {
-    if (!input || !output || size == 0 || size % 2 != 0) return false;
+// Internal: Bluestein transform for sizes with prime factors above 7
+static bool fft_execute_bluestein(const fft_plan_t *plan, const fft_complex_t *input,
+                                  fft_complex_t *output) {
+    if (!plan->chirp_plan || !plan->chirp || !plan->chirp_kernel) {
+        return false;
+    }
 
-    uint32_t half_size = size / 2;
+    uint32_t size = plan->size;
+    uint32_t m = plan->chirp_plan->size;
+    fft_complex_t *buf = fft_get_chirp_buffer(m);
+    if (!buf) {
+        return false;
+    }
 
-    // Copy second half to beginning of output (negative frequencies)
-    for (uint32_t i = 0; i < half_size; i++) {
-        output[i] = input[i + half_size];
+    for (uint32_t n = 0; n < size; n++) {
+        buf[n] = fft_cmul(input[n], plan->chirp[n]);
     }
+    memset(buf + size, 0, (m - size) * sizeof(fft_complex_t));
 
-    // Copy first half to end of output (positive frequencies + DC)
-    for (uint32_t i = 0; i < half_size; i++) {
-        output[i + half_size] = input[i];
+    if (!fft_bluestein_convolve(plan, buf)) {
+        return false;
+    }
+
+    double scale = plan->is_inverse_normalized ? 1.0 / (double)size : 1.0;
+    for (uint32_t k = 0; k < size; k++) {
+        output[k] = fft_cmul(plan->chirp[k], conj(buf[k])) * scale;
     }
 
     return true;
 }
 
-// Convert IQ samples to complex format
-void fft_iq_to_complex(const float *iq_data, fft_complex_t *complex_data,
-                      uint32_t num_samples, bool scale_to_unit) {
-    if (!iq_data || !complex_data || num_samples == 0) return;
-
-    double scale = scale_to_unit ? (1.0 / 32768.0) : 1.0;  // Assume s16 range
+// Create single-precision FFT plan (its own wisdom, else the fixed rules)
+fft_plan_f32_t *fft_plan_f32_create(uint32_t size, fft_direction_t direction) {
+    if (size == 0 || size > FFT_MAX_SIZE) {
+        return NULL;
+    }
 
-    for (uint32_t i = 0; i < num_samples; i++) {
-        double i_val = (double)iq_data[i * 2] * scale;
-        double q_val = (double)iq_data[i * 2 + 1] * scale;
-        complex_data[i] = i_val + q_val * I;
+    fft_wisdom_t wisdom;
+    if (fft_wisdom_lookup(size, FFT_PRECISION_F32, &wisdom)) {
+        fft_plan_f32_t *plan = fft_plan_f32_create_as(size, direction, wisdom.algorithm, wisdom.simd);
+        if (plan) {
+            return plan;
+        }
     }
+    return fft_plan_f32_from(fft_plan_create_default(size, direction));
 }
 
-// Convert complex format back to IQ samples
-void fft_complex_to_iq(const fft_complex_t *complex_data, float *iq_data,
-                      uint32_t num_samples, bool scale_from_unit) {
-    if (!complex_data || !iq_data || num_samples == 0) return;
+// Create a single-precision plan with a given schedule and kernel family
+fft_plan_f32_t *fft_plan_f32_create_as(uint32_t size, fft_direction_t direction,
+                                       fft_algorithm_t algorithm, fft_simd_t simd) {
+    return fft_plan_f32_from(fft_plan_create_as(size, direction, algorithm, simd));
+}
 
-    double scale = scale_from_unit ? 32767.0 : 1.0;  // Assume s16 range
+// Internal: Single-precision plan from a double-precision one (consumed):
+// the tables are built in double precision and rounded once
+static fft_plan_f32_t *fft_plan_f32_from(fft_plan_t *ref) {
+    if (!ref) {
+        return NULL;
+    }
 
-    for (uint32_t i = 0; i < num_samples; i++) {
-        iq_data[i * 2] = (float)(creal(complex_data[i]) * scale);
-        iq_data[i * 2 + 1] = (float)(cimag(complex_data[i]) * scale);
+    uint32_t size = ref->size;
+    fft_plan_f32_t *plan = (fft_plan_f32_t *)calloc(1, sizeof(fft_plan_f32_t));
+    if (!plan) {
+        fft_plan_destroy(ref);
+        return NULL;
     }
-}
 
-// Internal: Calculate log2 of uint32
-static uint32_t log2_uint32(uint32_t n) {
-    uint32_t log = 0;
-    while (n >>= 1) log++;
-    return log;
-}
+    plan->size = ref->size;
+    plan->direction = ref->direction;
+    plan->algorithm = ref->algorithm;
+    plan->log2_size = ref->log2_size;
+    plan->num_radix4_stages = ref->num_radix4_stages;
+    plan->has_radix2_stage = ref->has_radix2_stage;
+    plan->num_factors = ref->num_factors;
+    memcpy(plan->factors, ref->factors, sizeof(plan->factors));
+    plan->is_inverse_normalized = ref->is_inverse_normalized;
+    plan->stage_twiddles = NULL;
+    plan->simd = ref->simd;
+
+    // Bluestein keeps its chirp and convolution in double precision
+    if (ref->algorithm == FFT_ALGO_BLUESTEIN) {
+        plan->bluestein_plan = ref;
+        return plan;
+    }
 
-// Internal: Create bit reversal table
-static bool create_bit_reversal_table(uint32_t *table, uint32_t size) {
-    if (!table || size == 0) return false;
+    if (ref->twiddle_factors) {
+        uint32_t num_twiddles = size > 1 ? size / 2 : 1;
+        plan->twiddle_factors = (fft_complex_f32_t *)iq_huge_alloc(num_twiddles * sizeof(fft_complex_f32_t));
+        if (!plan->twiddle_factors) {
+            free(plan);
+            fft_plan_destroy(ref);
+            return NULL;
+        }
+        for (uint32_t i = 0; i < num_twiddles; i++) {
+            plan->twiddle_factors[i] = (fft_complex_f32_t)ref->twiddle_factors[i];
+        }
+    }
 
-    uint32_t bits = log2_uint32(size);
+    if (ref->stage_twiddles) {
+        uint32_t num_stage_twiddles = fft_stage_twiddle_count(ref);
 
-    for (uint32_t i = 0; i < size; i++) {
-        table[i] = fft_bit_reverse(i, bits);
+        plan->stage_twiddles = (fft_complex_f32_t *)iq_huge_alloc(num_stage_twiddles * sizeof(fft_complex_f32_t));
+        if (!plan->stage_twiddles) {
+            iq_huge_free(plan->twiddle_factors);
+            free(plan);
+            fft_plan_destroy(ref);
+            return NULL;
+        }
+        for (uint32_t i = 0; i < num_stage_twiddles; i++) {
+            plan->stage_twiddles[i] = (fft_complex_f32_t)ref->stage_twiddles[i];
+        }
     }
 
-    return true;
+    fft_plan_destroy(ref);
+    return plan;
 }
 
-// Internal: Create twiddle factors
-static bool create_twiddle_factors(fft_complex_t *twiddles, uint32_t size, fft_direction_t direction) {
-    if (!twiddles || size == 0) return false;
+// Destroy single-precision FFT plan
+void fft_plan_f32_destroy(fft_plan_f32_t *plan) {
+    if (!plan) return;
+
+    iq_huge_free(plan->twiddle_factors);
+    iq_huge_free(plan->stage_twiddles);
+    fft_plan_destroy(plan->bluestein_plan);
+    free(plan);
+}
+
+// Internal: Single-precision codelet on up to two frames at once (xb == xa
+// and yb == ya for one frame); vector codelets take one frame per lane pair
+static bool fft_execute_codelet_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *xa,
+                                    const fft_complex_f32_t *xb, fft_complex_f32_t *ya,
+                                    fft_complex_f32_t *yb) {
+    fft_codelet_run_f32(plan->simd, plan->log2_size, xa, xb, ya, yb, plan->direction == FFT_INVERSE);
+
+    if (plan->is_inverse_normalized) {
+        float scale = 1.0f / (float)plan->size;
+        for (uint32_t i = 0; i < plan->size; i++) {
+            ya[i] *= scale;
+        }
+        for (uint32_t i = 0; yb != ya && i < plan->size; i++) {
+            yb[i] *= scale;
+        }
+    }
+    return true;
+}
+
+// Execute single-precision FFT (same pass schedule as fft_execute)
+bool fft_execute_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *input,
+                     fft_complex_f32_t *output) {
+    if (!plan || !input || !output) {
+        return false;
+    }
+
+    if (plan->algorithm == FFT_ALGO_CODELET) {
+        return fft_execute_codelet_f32(plan, input, input, output, output);
+    }
+    if (plan->algorithm == FFT_ALGO_MIXED_RADIX) {
+        return fft_execute_mixed_f32(plan, input, output);
+    }
+    if (plan->algorithm == FFT_ALGO_BLUESTEIN) {
+        return fft_execute_bluestein_f32(plan, input, output);
+    }
+
+    if (!plan->twiddle_factors || (plan->num_radix4_stages > 0 && !plan->stage_twiddles)) {
+        return false;
+    }
+
+    uint32_t size = plan->size;
+    uint32_t total_stages = plan->num_radix4_stages + (plan->has_radix2_stage ? 1 : 0);
+
+    if (total_stages == 0) {
+        output[0] = input[0];
+        return true;
+    }
+
+    fft_complex_f32_t *work = fft_get_work_buffer_f32(size);
+    if (!work) {
+        return false;
+    }
+
+    const fft_complex_f32_t *src = input;
+    fft_complex_f32_t *dst = (total_stages % 2 != 0) ? output : work;
+    if (input == output && dst == output) {
+        memcpy(work, input, size * sizeof(fft_complex_f32_t));
+        src = work;
+    }
+
+    bool inverse = (plan->direction == FFT_INVERSE);
+    const fft_complex_f32_t *tw = plan->stage_twiddles;
+    uint32_t stride = 1;
+
+    for (uint32_t n = size; n >= 4; n /= 4) {
+        fft_radix4_pass_f32(plan->simd, src, dst, n, stride, tw, inverse);
+        tw += 3 * (n / 4);
+        stride *= 4;
+
+        src = dst;
+        dst = (dst == output) ? work : output;
+    }
+
+    if (plan->has_radix2_stage) {
+        fft_stockham_radix2_f32(src, dst, stride);
+    }
+
+    if (plan->is_inverse_normalized) {
+        float scale = 1.0f / (float)size;
+        for (uint32_t i = 0; i < size; i++) {
+            output[i] *= scale;
+        }
+    }
+
+    return true;
+}
+
+// Internal: Single-precision mixed-radix pass schedule
+static bool fft_execute_mixed_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *input,
+                                  fft_complex_f32_t *output) {
+    if (!plan->stage_twiddles || plan->num_factors == 0) {
+        return false;
+    }
+
+    uint32_t size = plan->size;
+    fft_complex_f32_t *work = fft_get_work_buffer_f32(size);
+    if (!work) {
+        return false;
+    }
+
+    const fft_complex_f32_t *src = input;
+    fft_complex_f32_t *dst = (plan->num_factors % 2 != 0) ? output : work;
+    if (input == output && dst == output) {
+        memcpy(work, input, size * sizeof(fft_complex_f32_t));
+        src = work;
+    }
+
+    bool inverse = (plan->direction == FFT_INVERSE);
+    const fft_complex_f32_t *tw = plan->stage_twiddles;
+    uint32_t n = size;
+    uint32_t stride = 1;
+
+    for (uint32_t f = 0; f < plan->num_factors; f++) {
+        uint32_t radix = plan->factors[f];
+        fft_mixed_pass_f32(plan->simd, src, dst, n, stride, radix, tw, inverse);
+        tw += (radix - 1) * (n / radix);
+        n /= radix;
+        stride *= radix;
+
+        src = dst;
+        dst = (dst == output) ? work : output;
+    }
+
+    if (plan->is_inverse_normalized) {
+        float scale = 1.0f / (float)size;
+        for (uint32_t i = 0; i < size; i++) {
+            output[i] *= scale;
+        }
+    }
+
+    return true;
+}
+
+// Internal: Single-precision Bluestein, widened to double around the convolution
+static bool fft_execute_bluestein_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *input,
+                                      fft_complex_f32_t *output) {
+    const fft_plan_t *ref = plan->bluestein_plan;
+    if (!ref || !ref->chirp_plan || !ref->chirp || !ref->chirp_kernel) {
+        return false;
+    }
+
+    uint32_t size = ref->size;
+    uint32_t m = ref->chirp_plan->size;
+    fft_complex_t *buf = fft_get_chirp_buffer(m);
+    if (!buf) {
+        return false;
+    }
+
+    for (uint32_t n = 0; n < size; n++) {
+        buf[n] = fft_cmul((fft_complex_t)input[n], ref->chirp[n]);
+    }
+    memset(buf + size, 0, (m - size) * sizeof(fft_complex_t));
+
+    if (!fft_bluestein_convolve(ref, buf)) {
+        return false;
+    }
+
+    double scale = ref->is_inverse_normalized ? 1.0 / (double)size : 1.0;
+    for (uint32_t k = 0; k < size; k++) {
+        output[k] = (fft_complex_f32_t)(fft_cmul(ref->chirp[k], conj(buf[k])) * scale);
+    }
+
+    return true;
+}
+
+/*
+ * Batched execution runs frames in groups that advance through the radix-4
+ * passes together: each pass's twiddle block is pulled into cache once and
+ * reused by every frame of the group before moving to the next pass. Groups
+ * shrink so a group's ping-pong buffers stay within FFT_BATCH_CACHE_BYTES;
+ * large frames already saturate the cache on their own and run one at a time.
+ */
+#define FFT_BATCH_GROUP 4
+#define FFT_BATCH_CACHE_BYTES (256u * 1024u)
+
+// Internal: Frames per group for a given frame footprint
+static uint32_t fft_batch_group_size(uint32_t size, size_t elem_bytes) {
+    size_t frame_bytes = 2 * (size_t)size * elem_bytes;   // source + destination
+    size_t group = FFT_BATCH_CACHE_BYTES / frame_bytes;
+    if (group < 1) group = 1;
+    if (group > FFT_BATCH_GROUP) group = FFT_BATCH_GROUP;
+    return (uint32_t)group;
+}
+
+// Execute a batch of double-precision FFTs
+bool fft_execute_batch(const fft_plan_t *plan, const fft_complex_t *input, fft_complex_t *output,
+                       uint32_t count, size_t in_stride, size_t out_stride) {
+    if (!plan || !input || !output || out_stride < plan->size) {
+        return false;
+    }
+
+    uint32_t size = plan->size;
+    uint32_t total_stages = plan->num_radix4_stages + (plan->has_radix2_stage ? 1 : 0);
+
+    // In-place batches, trivial sizes, codelets and non-power-of-two schedules
+    // take the per-frame path
+    if (input == output || total_stages < 2 || plan->algorithm != FFT_ALGO_RADIX4) {
+        for (uint32_t f = 0; f < count; f++) {
+            if (!fft_execute(plan, input + f * in_stride, output + f * out_stride)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (!plan->twiddle_factors || (plan->num_radix4_stages > 0 && !plan->stage_twiddles)) {
+        return false;
+    }
+
+    uint32_t max_group = fft_batch_group_size(size, sizeof(fft_complex_t));
+    fft_complex_t *work = fft_get_work_buffer(max_group * size);
+    if (!work) {
+        return false;
+    }
+
+    bool inverse = (plan->direction == FFT_INVERSE);
+    double scale = 1.0 / (double)size;
+
+    for (uint32_t first = 0; first < count; first += max_group) {
+        uint32_t group = count - first < max_group ? count - first : max_group;
+        const fft_complex_t *src[FFT_BATCH_GROUP];
+        fft_complex_t *dst[FFT_BATCH_GROUP];
+        fft_complex_t *out[FFT_BATCH_GROUP];
+
+        for (uint32_t f = 0; f < group; f++) {
+            out[f] = output + (size_t)(first + f) * out_stride;
+            src[f] = input + (size_t)(first + f) * in_stride;
+            dst[f] = (total_stages % 2 != 0) ? out[f] : work + (size_t)f * size;
+        }
+
+        const fft_complex_t *tw = plan->stage_twiddles;
+        uint32_t stride = 1;
+        for (uint32_t n = size; n >= 4; n /= 4) {
+            for (uint32_t f = 0; f < group; f++) {
+                fft_radix4_pass(plan->simd, src[f], dst[f], n, stride, tw, inverse);
+                src[f] = dst[f];
+                dst[f] = (dst[f] == out[f]) ? work + (size_t)f * size : out[f];
+            }
+            tw += 3 * (n / 4);
+            stride *= 4;
+        }
+
+        for (uint32_t f = 0; f < group; f++) {
+            if (plan->has_radix2_stage) {
+                fft_stockham_radix2(src[f], dst[f], stride);
+            }
+            if (plan->is_inverse_normalized) {
+                for (uint32_t i = 0; i < size; i++) {
+                    out[f][i] *= scale;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Execute a batch of single-precision FFTs
+bool fft_execute_batch_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *input,
+                           fft_complex_f32_t *output, uint32_t count,
+                           size_t in_stride, size_t out_stride) {
+    if (!plan || !input || !output || out_stride < plan->size) {
+        return false;
+    }
+
+    uint32_t size = plan->size;
+    uint32_t total_stages = plan->num_radix4_stages + (plan->has_radix2_stage ? 1 : 0);
+
+    // Codelets take frames two at a time (one per vector lane pair); in place
+    // they go frame by frame in case strided frames overlap
+    if (plan->algorithm == FFT_ALGO_CODELET && input != output) {
+        for (uint32_t f = 0; f < count; f += 2) {
+            uint32_t g = f + 1 < count ? f + 1 : f;
+            fft_execute_codelet_f32(plan, input + f * in_stride, input + g * in_stride,
+                                    output + f * out_stride, output + g * out_stride);
+        }
+        return true;
+    }
+
+    if (input == output || total_stages < 2 || plan->algorithm != FFT_ALGO_RADIX4) {
+        for (uint32_t f = 0; f < count; f++) {
+            if (!fft_execute_f32(plan, input + f * in_stride, output + f * out_stride)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (!plan->twiddle_factors || (plan->num_radix4_stages > 0 && !plan->stage_twiddles)) {
+        return false;
+    }
+
+    uint32_t max_group = fft_batch_group_size(size, sizeof(fft_complex_f32_t));
+    fft_complex_f32_t *work = fft_get_work_buffer_f32(max_group * size);
+    if (!work) {
+        return false;
+    }
+
+    bool inverse = (plan->direction == FFT_INVERSE);
+    float scale = 1.0f / (float)size;
+
+    for (uint32_t first = 0; first < count; first += max_group) {
+        uint32_t group = count - first < max_group ? count - first : max_group;
+        const fft_complex_f32_t *src[FFT_BATCH_GROUP];
+        fft_complex_f32_t *dst[FFT_BATCH_GROUP];
+        fft_complex_f32_t *out[FFT_BATCH_GROUP];
+
+        for (uint32_t f = 0; f < group; f++) {
+            out[f] = output + (size_t)(first + f) * out_stride;
+            src[f] = input + (size_t)(first + f) * in_stride;
+            dst[f] = (total_stages % 2 != 0) ? out[f] : work + (size_t)f * size;
+        }
+
+        const fft_complex_f32_t *tw = plan->stage_twiddles;
+        uint32_t stride = 1;
+        for (uint32_t n = size; n >= 4; n /= 4) {
+            for (uint32_t f = 0; f < group; f++) {
+                fft_radix4_pass_f32(plan->simd, src[f], dst[f], n, stride, tw, inverse);
+                src[f] = dst[f];
+                dst[f] = (dst[f] == out[f]) ? work + (size_t)f * size : out[f];
+            }
+            tw += 3 * (n / 4);
+            stride *= 4;
+        }
+
+        for (uint32_t f = 0; f < group; f++) {
+            if (plan->has_radix2_stage) {
+                fft_stockham_radix2_f32(src[f], dst[f], stride);
+            }
+            if (plan->is_inverse_normalized) {
+                for (uint32_t i = 0; i < size; i++) {
+                    out[f][i] *= scale;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Convenience function for forward FFT
+bool fft_forward(const fft_complex_t *input, fft_complex_t *output, uint32_t size) {
+    fft_plan_t *plan = fft_plan_acquire(size, FFT_FORWARD);
+    if (!plan) return false;
+
+    bool success = fft_execute(plan, input, output);
+    fft_plan_release(plan);
+
+    return success;
+}
+
+// Convenience function for inverse FFT
+bool fft_inverse(const fft_complex_t *input, fft_complex_t *output, uint32_t size) {
+    fft_plan_t *plan = fft_plan_acquire(size, FFT_INVERSE);
+    if (!plan) return false;
+
+    bool success = fft_execute(plan, input, output);
+    fft_plan_release(plan);
+
+    return success;
+}
+
+// Create real-input FFT plan
+fft_real_plan_t *fft_real_plan_create(uint32_t size) {
+    if (size < 2 || size % 2 != 0 || size > FFT_MAX_SIZE) {
+        return NULL;
+    }
+
+    fft_real_plan_t *plan = (fft_real_plan_t *)malloc(sizeof(fft_real_plan_t));
+    if (!plan) {
+        return NULL;
+    }
+
+    uint32_t half = size / 2;
+    plan->size = size;
+    plan->half_forward = fft_plan_create(half, FFT_FORWARD);
+    plan->half_inverse = fft_plan_create(half, FFT_INVERSE);
+    plan->post_twiddles = (fft_complex_t *)iq_huge_alloc(half * sizeof(fft_complex_t));
+
+    if (!plan->half_forward || !plan->half_inverse || !plan->post_twiddles) {
+        fft_real_plan_destroy(plan);
+        return NULL;
+    }
+
+    for (uint32_t k = 0; k < half; k++) {
+        double angle = -2.0 * M_PI * (double)k / (double)size;
+        plan->post_twiddles[k] = cos(angle) + sin(angle) * I;
+    }
+
+    return plan;
+}
+
+// Destroy real-input FFT plan
+void fft_real_plan_destroy(fft_real_plan_t *plan) {
+    if (!plan) return;
+
+    fft_plan_destroy(plan->half_forward);
+    fft_plan_destroy(plan->half_inverse);
+    iq_huge_free(plan->post_twiddles);
+    free(plan);
+}
+
+// Execute real-to-complex FFT
+bool fft_real_execute_forward(const fft_real_plan_t *plan, const double *input, fft_complex_t *output) {
+    if (!plan || !input || !output) {
+        return false;
+    }
+
+    uint32_t half = plan->size / 2;
+
+    // Interleaved real samples already read as z[n] = x[2n] + i*x[2n+1]
+    if (!fft_execute(plan->half_forward, (const fft_complex_t *)input, output)) {
+        return false;
+    }
+
+    // Split Z into even/odd spectra and recombine, pairing k with N/2 - k so
+    // the pass can run in place
+    for (uint32_t k = 1; k <= half / 2; k++) {
+        uint32_t m = half - k;
+        fft_complex_t zk = output[k];
+        fft_complex_t zm = conj(output[m]);
+
+        fft_complex_t even_k = 0.5 * (zk + zm);
+        fft_complex_t diff = zk - zm;
+        fft_complex_t odd_k = 0.5 * (cimag(diff) - creal(diff) * I);   // diff / 2i
+        fft_complex_t even_m = conj(even_k);
+        fft_complex_t odd_m = conj(odd_k);
+
+        output[k] = even_k + fft_cmul(plan->post_twiddles[k], odd_k);
+        output[m] = even_m + fft_cmul(plan->post_twiddles[m], odd_m);
+    }
+
+    double z0_re = creal(output[0]);
+    double z0_im = cimag(output[0]);
+    output[0] = z0_re + z0_im;
+    output[half] = z0_re - z0_im;
+
+    return true;
+}
+
+// Execute complex-to-real inverse FFT
+bool fft_real_execute_inverse(const fft_real_plan_t *plan, const fft_complex_t *input, double *output) {
+    if (!plan || !input || !output) {
+        return false;
+    }
+
+    uint32_t half = plan->size / 2;
+
+    // Rebuild Z[k] = E[k] + i*O[k] directly in the output buffer; the N real
+    // outputs share storage with the N/2 complex values
+    fft_complex_t *z = (fft_complex_t *)output;
+    for (uint32_t k = 0; k < half; k++) {
+        fft_complex_t xk = input[k];
+        fft_complex_t xm = conj(input[half - k]);
+
+        fft_complex_t even = 0.5 * (xk + xm);
+        fft_complex_t odd = fft_cmul(0.5 * (xk - xm), conj(plan->post_twiddles[k]));
+        z[k] = even + (-cimag(odd) + creal(odd) * I);                 // even + i*odd
+    }
+
+    // z[n] = x[2n] + i*x[2n+1], which is exactly the interleaved real output
+    return fft_execute(plan->half_inverse, z, z);
+}
+
+// Real-to-complex FFT (for real-valued signals)
+bool fft_real_forward(const double *input, fft_complex_t *output, uint32_t size) {
+    if (!input || !output || size == 0) return false;
+
+    if (size == 1) {
+        output[0] = input[0];
+        return true;
+    }
+
+    fft_real_plan_t *plan = fft_real_plan_acquire(size);
+    if (!plan) return false;
+
+    bool success = fft_real_execute_forward(plan, input, output);
+    fft_real_plan_release(plan);
+
+    // Fill the redundant upper half from Hermitian symmetry
+    if (success) {
+        for (uint32_t k = size / 2 + 1; k < size; k++) {
+            output[k] = conj(output[size - k]);
+        }
+    }
+
+    return success;
+}
+
+// Complex-to-real inverse FFT
+bool fft_real_inverse(const fft_complex_t *input, double *output, uint32_t size) {
+    if (!input || !output || size == 0) return false;
+
+    if (size == 1) {
+        output[0] = creal(input[0]);
+        return true;
+    }
+
+    fft_real_plan_t *plan = fft_real_plan_acquire(size);
+    if (!plan) return false;
+
+    bool success = fft_real_execute_inverse(plan, input, output);
+    fft_real_plan_release(plan);
+
+    return success;
+}
+
+// Internal: Spin on the cache lock (held only for a few loads/stores)
+static void fft_cache_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&fft_plan_cache_lock, memory_order_acquire)) {
+        // Busy-wait; critical sections never allocate or build plans
+    }
+}
+
+static void fft_cache_unlock(void) {
+    atomic_flag_clear_explicit(&fft_plan_cache_lock, memory_order_release);
+}
+
+// Internal: Build a plan of the given cache kind
+static void *fft_cache_build(int kind, uint32_t size, fft_direction_t direction) {
+    switch (kind) {
+        case FFT_CACHE_KIND_F64:  return fft_plan_create(size, direction);
+        case FFT_CACHE_KIND_F32:  return fft_plan_f32_create(size, direction);
+        case FFT_CACHE_KIND_REAL: return fft_real_plan_create(size);
+        default:                  return NULL;
+    }
+}
+
+// Internal: Destroy a plan of the given cache kind
+static void fft_cache_destroy(int kind, void *plan) {
+    switch (kind) {
+        case FFT_CACHE_KIND_F64:  fft_plan_destroy((fft_plan_t *)plan); break;
+        case FFT_CACHE_KIND_F32:  fft_plan_f32_destroy((fft_plan_f32_t *)plan); break;
+        case FFT_CACHE_KIND_REAL: fft_real_plan_destroy((fft_real_plan_t *)plan); break;
+        default: break;
+    }
+}
+
+// Internal: Slot holding (or free to hold) a size; caller holds the lock.
+// Returns NULL when every non-power-of-two slot holds another size.
+static fft_cache_entry_t *fft_cache_slot(int kind, int dir, uint32_t size) {
+    if (fft_is_power_of_two(size)) {
+        return &fft_plan_cache[kind][dir][log2_uint32(size)];
+    }
+
+    fft_cache_entry_t *free_slot = NULL;
+    for (uint32_t i = 0; i < FFT_CACHE_EXTRA_SLOTS; i++) {
+        fft_cache_entry_t *entry = &fft_plan_cache_extra[kind][dir][i];
+        if (entry->plan && entry->size == size) {
+            return entry;
+        }
+        if (!entry->plan && !free_slot) {
+            free_slot = entry;
+        }
+    }
+    return free_slot;
+}
+
+// Internal: Look up (building on miss) a cached plan and take a reference
+static void *fft_cache_acquire(int kind, uint32_t size, fft_direction_t direction) {
+    if (size == 0 || size > FFT_MAX_SIZE) {
+        return NULL;
+    }
+
+    int dir = (kind == FFT_CACHE_KIND_REAL || direction == FFT_FORWARD) ? 0 : 1;
+
+    fft_cache_lock();
+    fft_cache_entry_t *entry = fft_cache_slot(kind, dir, size);
+    if (entry && entry->plan) {
+        entry->refcount++;
+        void *plan = entry->plan;
+        fft_cache_unlock();
+        return plan;
+    }
+    fft_cache_unlock();
+
+    // Miss: build without holding the lock
+    void *built = fft_cache_build(kind, size, direction);
+    if (!built) {
+        return NULL;
+    }
+
+    // Re-resolve the slot: another thread may have published this size or
+    // taken the free slot in the meantime
+    fft_cache_lock();
+    entry = fft_cache_slot(kind, dir, size);
+    void *plan = built;
+    if (entry && entry->plan) {
+        plan = entry->plan;
+        entry->refcount++;
+    } else if (entry) {
+        entry->plan = built;
+        entry->size = size;
+        entry->refcount = 1;
+        built = NULL;
+    } else {
+        built = NULL;   // No slot left: hand the plan out uncached
+    }
+    fft_cache_unlock();
+
+    // Another thread published the same plan first
+    if (built) {
+        fft_cache_destroy(kind, built);
+    }
+
+    return plan;
+}
+
+// Internal: Drop a reference to a cached plan (destroying uncached ones)
+static void fft_cache_release(int kind, const void *plan, uint32_t size, fft_direction_t direction) {
+    if (!plan || size == 0 || size > FFT_MAX_SIZE) {
+        return;
+    }
+
+    int dir = (kind == FFT_CACHE_KIND_REAL || direction == FFT_FORWARD) ? 0 : 1;
+
+    fft_cache_lock();
+    fft_cache_entry_t *entry = fft_cache_slot(kind, dir, size);
+    bool cached = entry && entry->plan == plan;
+    if (cached && entry->refcount > 0) {
+        entry->refcount--;
+    }
+    fft_cache_unlock();
+
+    if (!cached) {
+        fft_cache_destroy(kind, (void *)plan);
+    }
+}
+
+// Acquire a shared double-precision plan from the cache
+fft_plan_t *fft_plan_acquire(uint32_t size, fft_direction_t direction) {
+    return (fft_plan_t *)fft_cache_acquire(FFT_CACHE_KIND_F64, size, direction);
+}
+
+// Release a plan obtained from fft_plan_acquire
+void fft_plan_release(const fft_plan_t *plan) {
+    if (!plan) return;
+    fft_cache_release(FFT_CACHE_KIND_F64, plan, plan->size, plan->direction);
+}
+
+// Acquire a shared single-precision plan from the cache
+fft_plan_f32_t *fft_plan_f32_acquire(uint32_t size, fft_direction_t direction) {
+    return (fft_plan_f32_t *)fft_cache_acquire(FFT_CACHE_KIND_F32, size, direction);
+}
+
+// Release a plan obtained from fft_plan_f32_acquire
+void fft_plan_f32_release(const fft_plan_f32_t *plan) {
+    if (!plan) return;
+    fft_cache_release(FFT_CACHE_KIND_F32, plan, plan->size, plan->direction);
+}
+
+// Acquire a shared real-input plan from the cache
+fft_real_plan_t *fft_real_plan_acquire(uint32_t size) {
+    if (size < 2) return NULL;
+    return (fft_real_plan_t *)fft_cache_acquire(FFT_CACHE_KIND_REAL, size, FFT_FORWARD);
+}
+
+// Release a plan obtained from fft_real_plan_acquire
+void fft_real_plan_release(const fft_real_plan_t *plan) {
+    if (!plan) return;
+    fft_cache_release(FFT_CACHE_KIND_REAL, plan, plan->size, FFT_FORWARD);
+}
+
+// Build forward and inverse plans for the given sizes ahead of time
+bool fft_plan_cache_prewarm(const uint32_t *sizes, uint32_t num_sizes, fft_precision_t precision) {
+    if (!sizes && num_sizes > 0) return false;
+
+    int kind = (precision == FFT_PRECISION_F32) ? FFT_CACHE_KIND_F32 : FFT_CACHE_KIND_F64;
+    bool success = true;
+
+    for (uint32_t i = 0; i < num_sizes; i++) {
+        for (int dir = 0; dir < 2; dir++) {
+            fft_direction_t direction = dir ? FFT_INVERSE : FFT_FORWARD;
+            void *plan = fft_cache_acquire(kind, sizes[i], direction);
+            if (!plan) {
+                success = false;
+                continue;
+            }
+            fft_cache_release(kind, plan, sizes[i], direction);
+        }
+    }
+
+    return success;
+}
+
+// Internal: Cache entry by flat index (power-of-two levels, then extra slots)
+static fft_cache_entry_t *fft_cache_entry_at(int kind, int dir, int index) {
+    if (index < FFT_CACHE_LEVELS) {
+        return &fft_plan_cache[kind][dir][index];
+    }
+    return &fft_plan_cache_extra[kind][dir][index - FFT_CACHE_LEVELS];
+}
+
+// Free every cached plan that has no outstanding references
+uint32_t fft_plan_cache_clear(void) {
+    enum { SLOTS = FFT_CACHE_LEVELS + FFT_CACHE_EXTRA_SLOTS };
+    void *to_free[3][2][SLOTS] = {{{0}}};
+    uint32_t freed = 0;
+
+    fft_cache_lock();
+    for (int kind = 0; kind < 3; kind++) {
+        for (int dir = 0; dir < 2; dir++) {
+            for (int index = 0; index < SLOTS; index++) {
+                fft_cache_entry_t *entry = fft_cache_entry_at(kind, dir, index);
+                if (entry->plan && entry->refcount == 0) {
+                    to_free[kind][dir][index] = entry->plan;
+                    entry->plan = NULL;
+                }
+            }
+        }
+    }
+    fft_cache_unlock();
+
+    for (int kind = 0; kind < 3; kind++) {
+        for (int dir = 0; dir < 2; dir++) {
+            for (int index = 0; index < SLOTS; index++) {
+                if (to_free[kind][dir][index]) {
+                    fft_cache_destroy(kind, to_free[kind][dir][index]);
+                    freed++;
+                }
+            }
+        }
+    }
+
+    return freed;
+}
+
+/*
+ * Wisdom: measured (algorithm, kernel family) per (size, precision), a short
+ * unsorted table searched linearly at plan creation. The spin lock guards the
+ * table only; files are read and written outside it. The IQLAB_FFT_WISDOM
+ * file is read once, by whichever call touches the table first, while any
+ * concurrent callers wait for it.
+ */
+static fft_wisdom_t fft_wisdom_table[FFT_WISDOM_MAX];
+static uint32_t fft_wisdom_count = 0;
+static atomic_flag fft_wisdom_lock = ATOMIC_FLAG_INIT;
+static atomic_int fft_wisdom_autoload_state = 0;   // 0: not read, 1: reading, 2: done
+
+static void fft_wisdom_table_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&fft_wisdom_lock, memory_order_acquire)) {
+        // Busy-wait; critical sections only copy entries
+    }
+}
+
+static void fft_wisdom_table_unlock(void) {
+    atomic_flag_clear_explicit(&fft_wisdom_lock, memory_order_release);
+}
+
+static bool fft_wisdom_valid(const fft_wisdom_t *entry) {
+    return entry && entry->size >= 1 && entry->size <= FFT_MAX_SIZE &&
+           (entry->precision == FFT_PRECISION_F64 || entry->precision == FFT_PRECISION_F32) &&
+           (int)entry->algorithm >= FFT_ALGO_RADIX4 && (int)entry->algorithm <= FFT_ALGO_CODELET &&
+           (int)entry->simd >= FFT_SIMD_NONE && (int)entry->simd <= FFT_SIMD_NEON;
+}
+
+// Internal: Insert or replace under the lock
+static bool fft_wisdom_put(const fft_wisdom_t *entry) {
+    bool stored = false;
+    fft_wisdom_table_lock();
+    for (uint32_t i = 0; i < fft_wisdom_count; i++) {
+        if (fft_wisdom_table[i].size == entry->size && fft_wisdom_table[i].precision == entry->precision) {
+            fft_wisdom_table[i] = *entry;
+            stored = true;
+            break;
+        }
+    }
+    if (!stored && fft_wisdom_count < FFT_WISDOM_MAX) {
+        fft_wisdom_table[fft_wisdom_count++] = *entry;
+        stored = true;
+    }
+    fft_wisdom_table_unlock();
+    return stored;
+}
+
+// Internal: Merge a wisdom file; lines that do not parse are skipped so files
+// from newer builds (other algorithm or kernel names) still load
+static bool fft_wisdom_read(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        char precision[8], algorithm[32], simd[32];
+        fft_wisdom_t entry;
+        if (line[0] == '#' ||
+            sscanf(line, "%u %7s %31s %31s %lf", &entry.size, precision, algorithm, simd, &entry.ns) != 5) {
+            continue;
+        }
+        if (strcmp(precision, "f64") == 0) {
+            entry.precision = FFT_PRECISION_F64;
+        } else if (strcmp(precision, "f32") == 0) {
+            entry.precision = FFT_PRECISION_F32;
+        } else {
+            continue;
+        }
+        if (fft_algorithm_from_name(algorithm, &entry.algorithm) && fft_simd_from_name(simd, &entry.simd) &&
+            fft_wisdom_valid(&entry)) {
+            fft_wisdom_put(&entry);
+        }
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+// Internal: Read the IQLAB_FFT_WISDOM file on first use
+static void fft_wisdom_autoload(void) {
+    int expected = 0;
+    if (atomic_compare_exchange_strong(&fft_wisdom_autoload_state, &expected, 1)) {
+        const char *path = getenv(FFT_WISDOM_ENV);
+        if (path && path[0]) {
+            fft_wisdom_read(path);
+        }
+        atomic_store(&fft_wisdom_autoload_state, 2);
+        return;
+    }
+    while (atomic_load(&fft_wisdom_autoload_state) != 2) {
+        // Another thread is reading the file
+    }
+}
+
+bool fft_wisdom_record(const fft_wisdom_t *entry) {
+    if (!fft_wisdom_valid(entry)) {
+        return false;
+    }
+    fft_wisdom_autoload();
+    return fft_wisdom_put(entry);
+}
+
+bool fft_wisdom_lookup(uint32_t size, fft_precision_t precision, fft_wisdom_t *entry) {
+    fft_wisdom_autoload();
+
+    fft_wisdom_t found;
+    bool hit = false;
+    fft_wisdom_table_lock();
+    for (uint32_t i = 0; i < fft_wisdom_count; i++) {
+        if (fft_wisdom_table[i].size == size && fft_wisdom_table[i].precision == precision) {
+            found = fft_wisdom_table[i];
+            hit = true;
+            break;
+        }
+    }
+    fft_wisdom_table_unlock();
+
+    // Files may be shared between machines: skip kernels this CPU lacks
+    if (!hit || !fft_simd_supported(found.simd)) {
+        return false;
+    }
+    if (entry) {
+        *entry = found;
+    }
+    return true;
+}
+
+bool fft_wisdom_load(const char *path) {
+    if (!path) {
+        return false;
+    }
+    fft_wisdom_autoload();
+    return fft_wisdom_read(path);
+}
+
+bool fft_wisdom_save(const char *path) {
+    if (!path) {
+        return false;
+    }
+    fft_wisdom_autoload();
+
+    static fft_wisdom_t snapshot[FFT_WISDOM_MAX];
+    fft_wisdom_table_lock();
+    uint32_t count = fft_wisdom_count;
+    memcpy(snapshot, fft_wisdom_table, count * sizeof(fft_wisdom_t));
+    fft_wisdom_table_unlock();
+
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "# IQ Lab FFT wisdom v1\n");
+    fprintf(file, "# size precision algorithm simd ns\n");
+    // Precision, then size, so files diff cleanly between tuning runs
+    for (int precision = FFT_PRECISION_F64; precision <= FFT_PRECISION_F32; precision++) {
+        uint32_t last = 0;
+        for (;;) {
+            const fft_wisdom_t *next = NULL;
+            for (uint32_t i = 0; i < count; i++) {
+                if ((int)snapshot[i].precision == precision && snapshot[i].size > last &&
+                    (!next || snapshot[i].size < next->size)) {
+                    next = &snapshot[i];
+                }
+            }
+            if (!next) break;
+            fprintf(file, "%u %s %s %s %.1f\n", next->size,
+                    precision == FFT_PRECISION_F32 ? "f32" : "f64",
+                    fft_algorithm_name(next->algorithm), fft_simd_name(next->simd), next->ns);
+            last = next->size;
+        }
+    }
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+uint32_t fft_wisdom_forget(void) {
+    fft_wisdom_autoload();
+    fft_wisdom_table_lock();
+    uint32_t dropped = fft_wisdom_count;
+    fft_wisdom_count = 0;
+    fft_wisdom_table_unlock();
+    return dropped;
+}
+
+// Internal: Real flops of one radix-r butterfly, excluding output twiddles
+static double fft_butterfly_flops(uint32_t radix) {
+    switch (radix) {
+        case 2:  return 4.0;
+        case 3:  return 16.0;
+        case 4:  return 16.0;
+        case 5:  return 40.0;
+        default: return (double)(radix * radix) * 6.0 + (double)(radix * (radix - 1)) * 2.0;
+    }
+}
+
+// Internal: Flops of a Stockham pass schedule over size points
+static double fft_schedule_flops(uint32_t size, const uint8_t *factors, uint32_t num_factors) {
+    double flops = 0.0;
+    for (uint32_t f = 0; f < num_factors; f++) {
+        uint32_t radix = factors[f];
+        flops += (double)(size / radix) * (fft_butterfly_flops(radix) + 6.0 * (double)(radix - 1));
+    }
+    return flops;
+}
+
+// Report the algorithm and estimated cost fft_plan_create would give a size
+bool fft_query_cost(uint32_t size, fft_cost_t *cost) {
+    if (!cost || size == 0 || size > FFT_MAX_SIZE) {
+        return false;
+    }
+
+    uint8_t factors[FFT_MAX_FACTORS];
+    uint32_t num_factors = 0;
+
+    memset(cost, 0, sizeof(*cost));
+    cost->transform_size = size;
+
+    if (fft_factorize(size, factors, &num_factors)) {
+        // Power-of-two sizes factor as 4, 4, ..., 2: the radix-4 schedule, or
+        // the same butterflies unrolled into one codelet pass
+        cost->algorithm = fft_is_power_of_two(size) ? FFT_ALGO_RADIX4 : FFT_ALGO_MIXED_RADIX;
+        cost->num_passes = num_factors;
+        cost->flops = fft_schedule_flops(size, factors, num_factors);
+        if (cost->algorithm == FFT_ALGO_RADIX4 && size >= 2 && size <= FFT_CODELET_MAX_SIZE) {
+            cost->algorithm = FFT_ALGO_CODELET;
+            cost->num_passes = 1;
+            return true;
+        }
+
+        size_t table = 0;
+        uint32_t n = size;
+        for (uint32_t f = 0; f < num_factors; f++) {
+            table += (size_t)(factors[f] - 1) * (n / factors[f]);
+            n /= factors[f];
+        }
+        if (cost->algorithm == FFT_ALGO_RADIX4) {
+            table += size > 1 ? size / 2 : 1;
+        }
+        cost->plan_bytes = table * sizeof(fft_complex_t);
+        return true;
+    }
+
+    // Bluestein: two M-point FFTs, the kernel product and two chirp products
+    uint32_t m = fft_next_power_of_two(2 * size - 1);
+    fft_factorize(m, factors, &num_factors);
+    double inner_flops = fft_schedule_flops(m, factors, num_factors);
+
+    cost->algorithm = FFT_ALGO_BLUESTEIN;
+    cost->num_passes = num_factors;
+    cost->transform_size = m;
+    cost->flops = 2.0 * inner_flops + 6.0 * (double)m + 12.0 * (double)size;
+    cost->plan_bytes = ((size_t)size + 2 * (size_t)m) * sizeof(fft_complex_t);
+    return true;
+}
+
+// Human-readable algorithm name
+const char *fft_algorithm_name(fft_algorithm_t algorithm) {
+    switch (algorithm) {
+        case FFT_ALGO_RADIX4:      return "radix-4";
+        case FFT_ALGO_MIXED_RADIX: return "mixed-radix";
+        case FFT_ALGO_BLUESTEIN:   return "bluestein";
+        case FFT_ALGO_CODELET:     return "codelet";
+        default:                   return "unknown";
+    }
+}
+
+// Algorithm from its fft_algorithm_name() name
+bool fft_algorithm_from_name(const char *name, fft_algorithm_t *algorithm) {
+    for (int a = FFT_ALGO_RADIX4; name && a <= FFT_ALGO_CODELET; a++) {
+        if (strcmp(name, fft_algorithm_name((fft_algorithm_t)a)) == 0) {
+            if (algorithm) *algorithm = (fft_algorithm_t)a;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Detect the best butterfly kernel family for the running CPU
+fft_simd_t fft_simd_detect(void) {
+#if defined(FFT_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return FFT_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return FFT_SIMD_SSE2;
+    }
+    return FFT_SIMD_NONE;
+#elif defined(FFT_HAVE_NEON)
+    return FFT_SIMD_NEON;   // AdvSIMD is mandatory on AArch64
+#else
+    return FFT_SIMD_NONE;
+#endif
+}
+
+// Human-readable SIMD kernel family name
+const char *fft_simd_name(fft_simd_t simd) {
+    switch (simd) {
+        case FFT_SIMD_SSE2: return "sse2";
+        case FFT_SIMD_AVX2: return "avx2";
+        case FFT_SIMD_NEON: return "neon";
+        default:            return "scalar";
+    }
+}
+
+// Kernel family from its fft_simd_name() name
+bool fft_simd_from_name(const char *name, fft_simd_t *simd) {
+    for (int k = FFT_SIMD_NONE; name && k <= FFT_SIMD_NEON; k++) {
+        if (strcmp(name, fft_simd_name((fft_simd_t)k)) == 0) {
+            if (simd) *simd = (fft_simd_t)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether kernels of a family can run here (every family up to the detected one)
+bool fft_simd_supported(fft_simd_t simd) {
+    switch (simd) {
+        case FFT_SIMD_NONE:
+            return true;
+#if defined(FFT_HAVE_X86_SIMD)
+        case FFT_SIMD_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case FFT_SIMD_AVX2:
+            return fft_simd_detect() == FFT_SIMD_AVX2;
+#elif defined(FFT_HAVE_NEON)
+        case FFT_SIMD_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+// Check if number is power of two
+bool fft_is_power_of_two(uint32_t n) {
+    return (n != 0) && ((n & (n - 1)) == 0);
+}
+
+// Get next power of two >= n
+uint32_t fft_next_power_of_two(uint32_t n) {
+    if (n == 0) return 1;
+
+    n--;
+    n |= n >> 1;
+    n |= n >> 2;
+    n |= n >> 4;
+    n |= n >> 8;
+    n |= n >> 16;
+    n++;
+
+    return n;
+}
+
+// Bit reversal function
+uint32_t fft_bit_reverse(uint32_t n, uint32_t bits) {
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < bits; i++) {
+        result = (result << 1) | (n & 1);
+        n >>= 1;
+    }
+    return result;
+}
+
+// Magnitude calculation
+double fft_magnitude(fft_complex_t c) {
+    return cabs(c);
+}
+
+// Magnitude squared (more efficient than magnitude for comparisons)
+double fft_magnitude_squared(fft_complex_t c) {
+    return creal(c) * creal(c) + cimag(c) * cimag(c);
+}
+
+// Phase calculation
+double fft_phase(fft_complex_t c) {
+    return carg(c);
+}
+
+// Magnitude in dB
+double fft_magnitude_db(fft_complex_t c, double reference) {
+    double mag = fft_magnitude(c);
+    if (mag <= 0.0) return -INFINITY;
+    return 20.0 * log10(mag / reference);
+}
+
+// Power spectrum calculation
+bool fft_power_spectrum(const fft_complex_t *fft_output, double *power_spectrum,
+                       uint32_t size, bool normalize) {
+    if (!fft_output || !power_spectrum || size == 0) return false;
+
+    double norm_factor = normalize ? (1.0 / (double)size) : 1.0;
+
+    // Vector kernel handles the bulk, scalar loop finishes the tail
+    uint32_t i = fft_power_spectrum_simd(fft_simd_detect(), fft_output, power_spectrum,
+                                         size, norm_factor);
+    for (; i < size; i++) {
+        power_spectrum[i] = fft_magnitude_squared(fft_output[i]) * norm_factor;
+    }
+
+    return true;
+}
+
+// Single-precision power spectrum calculation
+bool fft_power_spectrum_f32(const fft_complex_f32_t *fft_output, float *power_spectrum,
+                            uint32_t size, bool normalize) {
+    if (!fft_output || !power_spectrum || size == 0) return false;
+
+    float norm_factor = normalize ? (1.0f / (float)size) : 1.0f;
+
+    uint32_t i = fft_power_spectrum_f32_simd(fft_simd_detect(), fft_output, power_spectrum,
+                                             size, norm_factor);
+    for (; i < size; i++) {
+        float re = crealf(fft_output[i]);
+        float im = cimagf(fft_output[i]);
+        power_spectrum[i] = (re * re + im * im) * norm_factor;
+    }
+
+    return true;
+}
+
+// FFT shift: move DC component to center of spectrum
+// This makes negative frequencies appear on the left, DC in middle, positive on right.
+// Odd sizes put DC at index N/2 (rounded down), matching numpy.fft.fftshift.
+bool fft_shift(const fft_complex_t *input, fft_complex_t *output, uint32_t size) {
+    if (!input || !output || size == 0) return false;
+
+    uint32_t half_size = size / 2;
+    uint32_t upper = size - half_size;   // Bins 0..upper-1: DC and positive frequencies
+
+    // Copy second half to beginning of output (negative frequencies)
+    for (uint32_t i = 0; i < half_size; i++) {
+        output[i] = input[i + upper];
+    }
+
+    // Copy first half to end of output (positive frequencies + DC)
+    for (uint32_t i = 0; i < upper; i++) {
+        output[i + half_size] = input[i];
+    }
+
+    return true;
+}
+
+// FFT shift for real arrays (power spectrum)
+bool fft_shift_real(const double *input, double *output, uint32_t size) {
+    if (!input || !output || size == 0) return false;
+
+    uint32_t half_size = size / 2;
+    uint32_t upper = size - half_size;
+
+    // Copy second half to beginning of output (negative frequencies)
+    for (uint32_t i = 0; i < half_size; i++) {
+        output[i] = input[i + upper];
+    }
+
+    // Copy first half to end of output (positive frequencies + DC)
+    for (uint32_t i = 0; i < upper; i++) {
+        output[i + half_size] = input[i];
+    }
+
+    return true;
+}
+
+// Internal: Reverse a run of single-precision bins in place
+static void fft_reverse_f32(fft_complex_f32_t *data, uint32_t count) {
+    for (uint32_t i = 0, j = count - 1; i < j; i++, j--) {
+        fft_complex_f32_t temp = data[i];
+        data[i] = data[j];
+        data[j] = temp;
+    }
+}
+
+// FFT shift for single-precision complex arrays
+bool fft_shift_f32(const fft_complex_f32_t *input, fft_complex_f32_t *output, uint32_t size) {
+    if (!input || !output || size == 0) return false;
+
+    uint32_t half_size = size / 2;
+    uint32_t upper = size - half_size;
+
+    if (input == output) {
+        if (upper == half_size) {
+            // In-place: swap halves
+            for (uint32_t i = 0; i < half_size; i++) {
+                fft_complex_f32_t temp = output[i];
+                output[i] = output[i + half_size];
+                output[i + half_size] = temp;
+            }
+        } else {
+            // Odd size: rotate left by `upper` with three reversals
+            fft_reverse_f32(output, upper);
+            fft_reverse_f32(output + upper, half_size);
+            fft_reverse_f32(output, size);
+        }
+        return true;
+    }
+
+    memcpy(output, input + upper, half_size * sizeof(fft_complex_f32_t));
+    memcpy(output + half_size, input, upper * sizeof(fft_complex_f32_t));
+
+    return true;
+}
+
+// Internal: Get (growing if needed) the calling thread's spectral frame buffer
+static fft_complex_f32_t *fft_get_frame_buffer(uint32_t size) {
+    return (fft_complex_f32_t *)fft_scratch_get(&fft_frame_buffer, size, sizeof(fft_complex_f32_t));
+}
+
+// Internal: Per-thread staging and spectrum buffers for spectral frames
+static bool fft_spectral_buffers(uint32_t size, fft_complex_f32_t **staged,
+                                 fft_complex_f32_t **spectrum) {
+    fft_complex_f32_t *buffer = fft_get_frame_buffer(2 * size);
+    if (!buffer) {
+        return false;
+    }
+
+    *staged = buffer;
+    *spectrum = buffer + size;
+    return true;
+}
+
+// Internal: Stage (windowing if requested) and transform one frame; returns
+// the unshifted spectrum in the calling thread's frame buffer
+static const fft_complex_f32_t *fft_spectral_transform(const fft_plan_f32_t *plan, const float *iq,
+                                                      const float *window) {
+    uint32_t size = plan->size;
+    fft_complex_f32_t *staged, *spectrum;
+    if (!fft_spectral_buffers(size, &staged, &spectrum)) {
+        return NULL;
+    }
+
+    // Interleaved float I/Q already has the float complex layout, so a
+    // rectangular frame feeds the FFT directly
+    const fft_complex_f32_t *src = (const fft_complex_f32_t *)iq;
+    if (window) {
+        for (uint32_t i = 0; i < size; i++) {
+            staged[i] = (iq[2 * i] * window[i]) + (iq[2 * i + 1] * window[i]) * I;
+        }
+        src = staged;
+    }
+
+    if (!fft_execute_f32(plan, src, spectrum)) {
+        return NULL;
+    }
+
+    return spectrum;
+}
+
+// Internal: Integer counterpart of fft_spectral_transform. The 2^-7 / 2^-15
+// normalization is folded into the window tap, which is exact, so the staged
+// frame equals the one built from iq_convert_to_float output.
+static const fft_complex_f32_t *fft_spectral_transform_int(const fft_plan_f32_t *plan, const void *iq,
+                                                          uint32_t bits, const float *window) {
+    if (bits != 8 && bits != 16) {
+        fprintf(stderr, "Unsupported sample width: %u bits (8 or 16)\n", bits);
+        return NULL;
+    }
+
+    uint32_t size = plan->size;
+    fft_complex_f32_t *staged, *spectrum;
+    if (!fft_spectral_buffers(size, &staged, &spectrum)) {
+        return NULL;
+    }
+
+    float *out = (float *)staged;
+    const float scale = (bits == 8) ? 1.0f / 128.0f : 1.0f / 32768.0f;
+    if (bits == 8) {
+        const int8_t *in = (const int8_t *)iq;
+        for (uint32_t i = 0; i < size; i++) {
+            float tap = window ? window[i] * scale : scale;
+            out[2 * i] = (float)in[2 * i] * tap;
+            out[2 * i + 1] = (float)in[2 * i + 1] * tap;
+        }
+    } else {
+        const int16_t *in = (const int16_t *)iq;
+        for (uint32_t i = 0; i < size; i++) {
+            float tap = window ? window[i] * scale : scale;
+            out[2 * i] = (float)in[2 * i] * tap;
+            out[2 * i + 1] = (float)in[2 * i + 1] * tap;
+        }
+    }
+
+    if (!fft_execute_f32(plan, staged, spectrum)) {
+        return NULL;
+    }
+
+    return spectrum;
+}
+
+// Internal: fftshifted |X|^2 row (float), linear or dB
+static void fft_spectral_row(const fft_complex_f32_t *spectrum, uint32_t size, float *row, bool db) {
+    // The shift is folded into the read index: row[0..half) comes from the
+    // negative-frequency bins spectrum[upper..N), the rest from spectrum[0..upper)
+    uint32_t half_size = size / 2;
+    uint32_t upper = size - half_size;
+
+    if (!db) {
+        fft_simd_t simd = fft_simd_detect();
+        uint32_t i = fft_power_spectrum_f32_simd(simd, spectrum + upper, row, half_size, 1.0f);
+        for (; i < half_size; i++) {
+            float re = crealf(spectrum[upper + i]), im = cimagf(spectrum[upper + i]);
+            row[i] = re * re + im * im;
+        }
+        i = fft_power_spectrum_f32_simd(simd, spectrum, row + half_size, upper, 1.0f);
+        for (; i < upper; i++) {
+            float re = crealf(spectrum[i]), im = cimagf(spectrum[i]);
+            row[half_size + i] = re * re + im * im;
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        fft_complex_f32_t x = spectrum[i < half_size ? i + upper : i - half_size];
+        float p = crealf(x) * crealf(x) + cimagf(x) * cimagf(x);
+        row[i] = 10.0f * log10f(p + 1e-12f);
+    }
+}
+
+// Internal: fftshifted |X|^2 row (double), linear or dB
+static void fft_spectral_row_f64(const fft_complex_f32_t *spectrum, uint32_t size, double *row, bool db) {
+    uint32_t half_size = size / 2;
+    uint32_t upper = size - half_size;
+
+    for (uint32_t i = 0; i < size; i++) {
+        fft_complex_f32_t x = spectrum[i < half_size ? i + upper : i - half_size];
+        double re = crealf(x), im = cimagf(x);
+        double p = re * re + im * im;
+        row[i] = db ? 10.0 * log10(p + 1e-12) : p;
+    }
+}
+
+// Fused window + FFT + fftshift + power row (float)
+bool fft_spectral_frame(const fft_plan_f32_t *plan, const float *iq, const float *window,
+                        float *row, bool db) {
+    if (!plan || !iq || !row) return false;
+
+    const fft_complex_f32_t *spectrum = fft_spectral_transform(plan, iq, window);
+    if (!spectrum) return false;
+
+    fft_spectral_row(spectrum, plan->size, row, db);
+    return true;
+}
+
+// Spectral rows for 'count' frames at a hop of 'hop' complex samples
+bool fft_spectral_batch(const fft_plan_f32_t *plan, const float *iq, uint32_t count, size_t hop,
+                        const float *window, float *rows, bool db) {
+    if (!plan || !iq || !rows) return false;
+
+    uint32_t size = plan->size;
+    if (window) {
+        for (uint32_t f = 0; f < count; f++) {
+            if (!fft_spectral_frame(plan, iq + (size_t)f * hop * 2, window,
+                                    rows + (size_t)f * size, db)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Rectangular frames are read in place, so they can go through the
+    // batched transform a cache-sized group at a time
+    uint32_t max_group = fft_batch_group_size(size, sizeof(fft_complex_f32_t));
+    fft_complex_f32_t *spectra = fft_get_frame_buffer(max_group * size);
+    if (!spectra) return false;
+
+    const fft_complex_f32_t *frames = (const fft_complex_f32_t *)iq;
+    for (uint32_t first = 0; first < count; first += max_group) {
+        uint32_t group = count - first < max_group ? count - first : max_group;
+        if (!fft_execute_batch_f32(plan, frames + (size_t)first * hop, spectra, group, hop, size)) {
+            return false;
+        }
+        for (uint32_t f = 0; f < group; f++) {
+            fft_spectral_row(spectra + (size_t)f * size, size, rows + (size_t)(first + f) * size, db);
+        }
+    }
+    return true;
+}
+
+// Fused window + FFT + fftshift + power row (double)
+bool fft_spectral_frame_f64(const fft_plan_f32_t *plan, const float *iq, const float *window,
+                            double *row, bool db) {
+    if (!plan || !iq || !row) return false;
+
+    const fft_complex_f32_t *spectrum = fft_spectral_transform(plan, iq, window);
+    if (!spectrum) return false;
+
+    fft_spectral_row_f64(spectrum, plan->size, row, db);
+    return true;
+}
+
+// Fused window + FFT + fftshift + power rows in both precisions
+bool fft_spectral_frame_dual(const fft_plan_f32_t *plan, const float *iq, const float *window,
+                             float *row, double *row_f64, bool db) {
+    if (!plan || !iq || (!row && !row_f64)) return false;
+
+    const fft_complex_f32_t *spectrum = fft_spectral_transform(plan, iq, window);
+    if (!spectrum) return false;
+
+    if (row) fft_spectral_row(spectrum, plan->size, row, db);
+    if (row_f64) fft_spectral_row_f64(spectrum, plan->size, row_f64, db);
+    return true;
+}
+
+// Fused integer-input spectral frame (float row)
+bool fft_spectral_frame_int(const fft_plan_f32_t *plan, const void *iq, uint32_t bits,
+                            const float *window, float *row, bool db) {
+    if (!plan || !iq || !row) return false;
+
+    const fft_complex_f32_t *spectrum = fft_spectral_transform_int(plan, iq, bits, window);
+    if (!spectrum) return false;
+
+    fft_spectral_row(spectrum, plan->size, row, db);
+    return true;
+}
+
+// Fused integer-input spectral frame (double row)
+bool fft_spectral_frame_int_f64(const fft_plan_f32_t *plan, const void *iq, uint32_t bits,
+                                const float *window, double *row, bool db) {
+    if (!plan || !iq || !row) return false;
+
+    const fft_complex_f32_t *spectrum = fft_spectral_transform_int(plan, iq, bits, window);
+    if (!spectrum) return false;
+
+    fft_spectral_row_f64(spectrum, plan->size, row, db);
+    return true;
+}
+
+// Convert IQ samples to complex format
+void fft_iq_to_complex(const float *iq_data, fft_complex_t *complex_data,
+                      uint32_t num_samples, bool scale_to_unit) {
+    if (!iq_data || !complex_data || num_samples == 0) return;
+
+    double scale = scale_to_unit ? (1.0 / 32768.0) : 1.0;  // Assume s16 range
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        double i_val = (double)iq_data[i * 2] * scale;
+        double q_val = (double)iq_data[i * 2 + 1] * scale;
+        complex_data[i] = i_val + q_val * I;
+    }
+}
+
+// Convert complex format back to IQ samples
+void fft_complex_to_iq(const fft_complex_t *complex_data, float *iq_data,
+                      uint32_t num_samples, bool scale_from_unit) {
+    if (!complex_data || !iq_data || num_samples == 0) return;
+
+    double scale = scale_from_unit ? 32767.0 : 1.0;  // Assume s16 range
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        iq_data[i * 2] = (float)(creal(complex_data[i]) * scale);
+        iq_data[i * 2 + 1] = (float)(cimag(complex_data[i]) * scale);
+    }
+}
+
+// Internal: Split size into Stockham radices: 4s first (so radix-4 passes see
+// the SIMD-friendly strides), then 3, 5, 7, and a single 2 last where its pass
+// needs no twiddles. Fails if any other prime factor remains.
+static bool fft_factorize(uint32_t size, uint8_t *factors, uint32_t *num_factors) {
+    static const uint8_t odd_radices[] = {3, 5, 7};
+    uint32_t count = 0;
+    uint32_t n = size;
+
+    while (n % 4 == 0) {
+        factors[count++] = 4;
+        n /= 4;
+    }
+    for (uint32_t i = 0; i < sizeof(odd_radices); i++) {
+        while (n % odd_radices[i] == 0) {
+            factors[count++] = odd_radices[i];
+            n /= odd_radices[i];
+        }
+    }
+    bool has_radix2 = (n % 2 == 0);
+    if (has_radix2) {
+        n /= 2;
+    }
+    if (n != 1) {
+        return false;
+    }
+    if (has_radix2) {
+        factors[count++] = 2;
+    }
+
+    *num_factors = count;
+    return true;
+}
+
+// Internal: Number of packed per-pass twiddles a plan carries
+static uint32_t fft_stage_twiddle_count(const fft_plan_t *plan) {
+    uint32_t count = 0;
+
+    if (plan->algorithm == FFT_ALGO_MIXED_RADIX) {
+        uint32_t n = plan->size;
+        for (uint32_t f = 0; f < plan->num_factors; f++) {
+            count += (plan->factors[f] - 1) * (n / plan->factors[f]);
+            n /= plan->factors[f];
+        }
+    } else if (plan->algorithm == FFT_ALGO_RADIX4) {
+        for (uint32_t n = plan->size; n >= 4 && plan->num_radix4_stages > 0; n /= 4) {
+            count += 3 * (n / 4);
+        }
+    }
+
+    return count;
+}
+
+// Internal: Calculate log2 of uint32
+static uint32_t log2_uint32(uint32_t n) {
+    uint32_t log = 0;
+    while (n >>= 1) log++;
+    return log;
+}
+
+// Internal: Create twiddle factors
+static bool create_twiddle_factors(fft_complex_t *twiddles, uint32_t size, fft_direction_t direction) {
+    if (!twiddles || size == 0) return false;
 
-    uint32_t num_twiddles = size / 2;
+    uint32_t num_twiddles = size > 1 ? size / 2 : 1;
     double angle_scale = (direction == FFT_FORWARD) ? -2.0 * M_PI : 2.0 * M_PI;
 
     for (uint32_t i = 0; i < num_twiddles; i++) {
@@ -395,34 +2273,1138 @@ static bool create_twiddle_factors(fft_complex_t *twiddles, uint32_t size, fft_d
     return true;
 }
 
-// Internal: Radix-2 FFT implementation
-static void fft_radix2(fft_complex_t *data, uint32_t size, fft_direction_t direction) {
-    uint32_t stages = log2_uint32(size);
+// Internal: Pack W_n^p, W_n^2p, W_n^3p for every radix-4 pass
+static void create_stage_twiddles(fft_complex_t *stage_twiddles, const fft_complex_t *twiddles,
+                                  uint32_t size, uint32_t num_radix4_stages) {
+    uint32_t half = size / 2;
+    uint32_t n = size;
+
+    for (uint32_t stage = 0; stage < num_radix4_stages; stage++, n /= 4) {
+        uint32_t step = size / n;   // W_n^p == W_N^(p * N/n)
+
+        for (uint32_t p = 0; p < n / 4; p++) {
+            for (uint32_t m = 1; m <= 3; m++) {
+                // W_N^(k + N/2) == -W_N^k extends the half-circle table
+                uint32_t k = m * p * step;
+                *stage_twiddles++ = (k < half) ? twiddles[k] : -twiddles[k - half];
+            }
+        }
+    }
+}
+
+// Internal: Get (growing if needed) the calling thread's Stockham work buffer
+static fft_complex_t *fft_get_work_buffer(uint32_t size) {
+    return (fft_complex_t *)fft_scratch_get(&fft_work_buffer, size, sizeof(fft_complex_t));
+}
+
+// Internal: Complex multiply written out so it never reaches the libgcc
+// NaN-recovery helper (__muldc3)
+static inline fft_complex_t fft_cmul(fft_complex_t a, fft_complex_t b) {
+    double ar = creal(a), ai = cimag(a);
+    double br = creal(b), bi = cimag(b);
+    return (ar * br - ai * bi) + (ar * bi + ai * br) * I;
+}
+
+// Internal: One radix-4 Stockham pass over sub-transforms of length n
+static void fft_stockham_radix4(const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                                uint32_t stride, const fft_complex_t *tw, bool inverse) {
+    uint32_t n1 = n / 4;
+
+    for (uint32_t p = 0; p < n1; p++) {
+        fft_complex_t w1 = tw[3 * p];
+        fft_complex_t w2 = tw[3 * p + 1];
+        fft_complex_t w3 = tw[3 * p + 2];
+
+        const fft_complex_t *xa = x + stride * p;
+        const fft_complex_t *xb = x + stride * (p + n1);
+        const fft_complex_t *xc = x + stride * (p + 2 * n1);
+        const fft_complex_t *xd = x + stride * (p + 3 * n1);
+        fft_complex_t *y0 = y + stride * (4 * p);
+        fft_complex_t *y1 = y0 + stride;
+        fft_complex_t *y2 = y1 + stride;
+        fft_complex_t *y3 = y2 + stride;
+
+        for (uint32_t q = 0; q < stride; q++) {
+            fft_complex_t a = xa[q], b = xb[q], c = xc[q], d = xd[q];
+
+            fft_complex_t apc = a + c;
+            fft_complex_t amc = a - c;
+            fft_complex_t bpd = b + d;
+            fft_complex_t bmd = b - d;
+
+            // Forward uses -j for the W4 rotation, inverse uses +j
+            fft_complex_t jbmd = inverse ? (-cimag(bmd) + creal(bmd) * I)
+                                         : (cimag(bmd) - creal(bmd) * I);
+
+            y0[q] = apc + bpd;
+            y1[q] = fft_cmul(w1, amc + jbmd);
+            y2[q] = fft_cmul(w2, apc - bpd);
+            y3[q] = fft_cmul(w3, amc - jbmd);
+        }
+    }
+}
+
+// Internal: Final radix-2 Stockham pass (n == 2, all twiddles are 1)
+static void fft_stockham_radix2(const fft_complex_t *x, fft_complex_t *y, uint32_t stride) {
+    for (uint32_t q = 0; q < stride; q++) {
+        fft_complex_t a = x[q];
+        fft_complex_t b = x[q + stride];
+        y[q] = a + b;
+        y[q + stride] = a - b;
+    }
+}
+
+// Internal: Get (growing if needed) the calling thread's Bluestein buffer; kept
+// apart from the work buffer because its inner FFTs use that one
+static fft_complex_t *fft_get_chirp_buffer(uint32_t size) {
+    return (fft_complex_t *)fft_scratch_get(&fft_chirp_buffer, size, sizeof(fft_complex_t));
+}
+
+// Internal: Get (growing if needed) the calling thread's float32 work buffer
+static fft_complex_f32_t *fft_get_work_buffer_f32(uint32_t size) {
+    return (fft_complex_f32_t *)fft_scratch_get(&fft_work_buffer_f32, size, sizeof(fft_complex_f32_t));
+}
+
+// Internal: Drop one scratch buffer, freeing it if it came from the heap
+static void fft_scratch_drop(fft_scratch_t *scratch) {
+    if (scratch->heap) free(scratch->data);
+    scratch->data = NULL;
+    scratch->capacity = 0;
+    scratch->heap = false;
+}
+
+static void fft_scratch_thread_exit(void *value) {
+    (void)value;
+    fft_scratch_registered = false;
+    fft_release_thread_buffers();
+}
+
+static void fft_scratch_key_create(void) {
+    fft_scratch_key_ok = pthread_key_create(&fft_scratch_key, fft_scratch_thread_exit) == 0;
+}
+
+// Internal: Have the calling thread's heap buffers freed when it exits
+static void fft_scratch_register(void) {
+    if (fft_scratch_registered) return;
+    pthread_once(&fft_scratch_key_once, fft_scratch_key_create);
+    fft_scratch_registered = fft_scratch_key_ok &&
+                             pthread_setspecific(fft_scratch_key, &fft_scratch_registered) == 0;
+}
+
+// Free the calling thread's scratch buffers now rather than at thread exit
+void fft_release_thread_buffers(void) {
+    fft_scratch_drop(&fft_work_buffer);
+    fft_scratch_drop(&fft_work_buffer_f32);
+    fft_scratch_drop(&fft_chirp_buffer);
+    fft_scratch_drop(&fft_frame_buffer);
+    fft_scratch_arena = NULL;
+    fft_scratch_generation = 0;
+}
+
+// Internal: Get (growing if needed) one scratch buffer of 'count' elements.
+// Once the thread is bound to another arena (or its arena was reset) the
+// buffers held so far are dropped, so none outlives the memory it points at.
+static void *fft_scratch_get(fft_scratch_t *scratch, uint32_t count, size_t elem_bytes) {
+    iq_arena_t *arena = iq_arena_current();
+    uint64_t generation = arena ? arena->generation : 0;
+    if (arena != fft_scratch_arena || generation != fft_scratch_generation) {
+        fft_release_thread_buffers();
+        fft_scratch_arena = arena;
+        fft_scratch_generation = generation;
+    }
+    if (scratch->capacity >= count) {
+        return scratch->data;
+    }
+
+    // Growing in an arena abandons the smaller block; fft_scratch_bytes()
+    // sizes the arena for each buffer at its largest
+    size_t bytes = (size_t)count * elem_bytes;
+    void *data = arena ? iq_arena_alloc(arena, bytes) : NULL;
+    if (data) {
+        if (scratch->heap) free(scratch->data);
+        scratch->heap = false;
+    } else {
+        // No arena, or it is full
+        data = scratch->heap ? realloc(scratch->data, bytes) : malloc(bytes);
+        if (!data) {
+            return NULL;
+        }
+        scratch->heap = true;
+        fft_scratch_register();
+    }
+    scratch->data = data;
+    scratch->capacity = count;
+    return data;
+}
+
+// Per-thread scratch bytes for plans of 'size': each buffer at its largest
+size_t fft_scratch_bytes(uint32_t size) {
+    if (size == 0 || size > FFT_MAX_SIZE) {
+        return 0;
+    }
+
+    size_t work = (size_t)fft_batch_group_size(size, sizeof(fft_complex_t)) * size;
+    size_t work_f32 = (size_t)fft_batch_group_size(size, sizeof(fft_complex_f32_t)) * size;
+    size_t frame = work_f32 > 2 * (size_t)size ? work_f32 : 2 * (size_t)size;
+    size_t chirp = 0;
+
+    uint8_t factors[FFT_MAX_FACTORS];
+    uint32_t num_factors = 0;
+    if (!fft_is_power_of_two(size) && !fft_factorize(size, factors, &num_factors)) {
+        // Bluestein: the convolution buffer and the work buffer of its inner plan
+        chirp = fft_next_power_of_two(2 * size - 1);
+        if (chirp > work) work = chirp;
+    }
+
+    size_t bytes = 0;
+    size_t parts[4] = { work * sizeof(fft_complex_t), chirp * sizeof(fft_complex_t),
+                        work_f32 * sizeof(fft_complex_f32_t), frame * sizeof(fft_complex_f32_t) };
+    for (int i = 0; i < 4; i++) {
+        bytes += (parts[i] + IQ_ARENA_ALIGN - 1) & ~(size_t)(IQ_ARENA_ALIGN - 1);
+    }
+    return bytes;
+}
+
+// Internal: Single-precision complex multiply
+static inline fft_complex_f32_t fft_cmul_f32(fft_complex_f32_t a, fft_complex_f32_t b) {
+    float ar = crealf(a), ai = cimagf(a);
+    float br = crealf(b), bi = cimagf(b);
+    return (ar * br - ai * bi) + (ar * bi + ai * br) * I;
+}
+
+// Internal: Single-precision radix-4 Stockham pass
+static void fft_stockham_radix4_f32(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t n,
+                                    uint32_t stride, const fft_complex_f32_t *tw, bool inverse) {
+    uint32_t n1 = n / 4;
+
+    for (uint32_t p = 0; p < n1; p++) {
+        fft_complex_f32_t w1 = tw[3 * p];
+        fft_complex_f32_t w2 = tw[3 * p + 1];
+        fft_complex_f32_t w3 = tw[3 * p + 2];
+
+        const fft_complex_f32_t *xa = x + stride * p;
+        const fft_complex_f32_t *xb = x + stride * (p + n1);
+        const fft_complex_f32_t *xc = x + stride * (p + 2 * n1);
+        const fft_complex_f32_t *xd = x + stride * (p + 3 * n1);
+        fft_complex_f32_t *y0 = y + stride * (4 * p);
+        fft_complex_f32_t *y1 = y0 + stride;
+        fft_complex_f32_t *y2 = y1 + stride;
+        fft_complex_f32_t *y3 = y2 + stride;
+
+        for (uint32_t q = 0; q < stride; q++) {
+            fft_complex_f32_t a = xa[q], b = xb[q], c = xc[q], d = xd[q];
+
+            fft_complex_f32_t apc = a + c;
+            fft_complex_f32_t amc = a - c;
+            fft_complex_f32_t bpd = b + d;
+            fft_complex_f32_t bmd = b - d;
+
+            fft_complex_f32_t jbmd = inverse ? (-cimagf(bmd) + crealf(bmd) * I)
+                                             : (cimagf(bmd) - crealf(bmd) * I);
+
+            y0[q] = apc + bpd;
+            y1[q] = fft_cmul_f32(w1, amc + jbmd);
+            y2[q] = fft_cmul_f32(w2, apc - bpd);
+            y3[q] = fft_cmul_f32(w3, amc - jbmd);
+        }
+    }
+}
+
+// Internal: Single-precision final radix-2 Stockham pass
+static void fft_stockham_radix2_f32(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t stride) {
+    for (uint32_t q = 0; q < stride; q++) {
+        fft_complex_f32_t a = x[q];
+        fft_complex_f32_t b = x[q + stride];
+        y[q] = a + b;
+        y[q + stride] = a - b;
+    }
+}
+
+// Internal: Radix-3 Stockham pass
+static void fft_stockham_radix3(const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                                uint32_t stride, const fft_complex_t *tw, bool inverse) {
+    uint32_t n1 = n / 3;
+    const double s3 = (inverse ? 1.0 : -1.0) * 0.86602540378443864676;   // +/- sin(2*pi/3)
+
+    for (uint32_t p = 0; p < n1; p++) {
+        fft_complex_t w1 = tw[2 * p];
+        fft_complex_t w2 = tw[2 * p + 1];
+
+        const fft_complex_t *xa = x + stride * p;
+        const fft_complex_t *xb = x + stride * (p + n1);
+        const fft_complex_t *xc = x + stride * (p + 2 * n1);
+        fft_complex_t *y0 = y + stride * (3 * p);
+        fft_complex_t *y1 = y0 + stride;
+        fft_complex_t *y2 = y1 + stride;
+
+        for (uint32_t q = 0; q < stride; q++) {
+            fft_complex_t a = xa[q], b = xb[q], c = xc[q];
+
+            fft_complex_t bpc = b + c;
+            fft_complex_t bmc = b - c;
+            fft_complex_t mid = a - 0.5 * bpc;
+            fft_complex_t rot = s3 * (-cimag(bmc) + creal(bmc) * I);   // s3 * i * (b - c)
+
+            y0[q] = a + bpc;
+            y1[q] = fft_cmul(w1, mid + rot);
+            y2[q] = fft_cmul(w2, mid - rot);
+        }
+    }
+}
+
+// Internal: Radix-5 Stockham pass
+static void fft_stockham_radix5(const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                                uint32_t stride, const fft_complex_t *tw, bool inverse) {
+    uint32_t n1 = n / 5;
+    const double c1 = 0.30901699437494742410;    // cos(2*pi/5)
+    const double c2 = -0.80901699437494742410;   // cos(4*pi/5)
+    const double sign = inverse ? 1.0 : -1.0;
+    const double s1 = sign * 0.95105651629515357212;   // +/- sin(2*pi/5)
+    const double s2 = sign * 0.58778525229247312917;   // +/- sin(4*pi/5)
+
+    for (uint32_t p = 0; p < n1; p++) {
+        const fft_complex_t *w = tw + 4 * p;
+
+        const fft_complex_t *xa = x + stride * p;
+        const fft_complex_t *xb = x + stride * (p + n1);
+        const fft_complex_t *xc = x + stride * (p + 2 * n1);
+        const fft_complex_t *xd = x + stride * (p + 3 * n1);
+        const fft_complex_t *xe = x + stride * (p + 4 * n1);
+        fft_complex_t *y0 = y + stride * (5 * p);
+        fft_complex_t *y1 = y0 + stride;
+        fft_complex_t *y2 = y1 + stride;
+        fft_complex_t *y3 = y2 + stride;
+        fft_complex_t *y4 = y3 + stride;
+
+        for (uint32_t q = 0; q < stride; q++) {
+            fft_complex_t a = xa[q], b = xb[q], c = xc[q], d = xd[q], e = xe[q];
+
+            fft_complex_t bpe = b + e, bme = b - e;
+            fft_complex_t cpd = c + d, cmd = c - d;
+
+            fft_complex_t m1 = a + c1 * bpe + c2 * cpd;
+            fft_complex_t m2 = a + c2 * bpe + c1 * cpd;
+            fft_complex_t t1 = s1 * bme + s2 * cmd;
+            fft_complex_t t2 = s2 * bme - s1 * cmd;
+            fft_complex_t r1 = -cimag(t1) + creal(t1) * I;   // i * t1
+            fft_complex_t r2 = -cimag(t2) + creal(t2) * I;   // i * t2
+
+            y0[q] = a + bpe + cpd;
+            y1[q] = fft_cmul(w[0], m1 + r1);
+            y2[q] = fft_cmul(w[1], m2 + r2);
+            y3[q] = fft_cmul(w[2], m2 - r2);
+            y4[q] = fft_cmul(w[3], m1 - r1);
+        }
+    }
+}
+
+// Internal: Generic odd-radix Stockham pass (radix 7), direct r-point DFT
+static void fft_stockham_generic(const fft_complex_t *x, fft_complex_t *y, uint32_t n, uint32_t stride,
+                                 uint32_t radix, const fft_complex_t *tw, bool inverse) {
+    uint32_t n1 = n / radix;
+    fft_complex_t roots[FFT_MAX_RADIX];
+    fft_complex_t in[FFT_MAX_RADIX];
+
+    double angle_scale = (inverse ? 2.0 : -2.0) * M_PI / (double)radix;
+    for (uint32_t k = 0; k < radix; k++) {
+        roots[k] = (fft_complex_t)(cos(angle_scale * (double)k) + sin(angle_scale * (double)k) * I);
+    }
+
+    for (uint32_t p = 0; p < n1; p++) {
+        const fft_complex_t *w = tw + (radix - 1) * p;
+        fft_complex_t *yp = y + stride * (radix * p);
+
+        for (uint32_t q = 0; q < stride; q++) {
+            for (uint32_t l = 0; l < radix; l++) {
+                in[l] = x[stride * (p + l * n1) + q];
+            }
+
+            for (uint32_t j = 0; j < radix; j++) {
+                fft_complex_t acc = in[0];
+                uint32_t k = 0;
+                for (uint32_t l = 1; l < radix; l++) {
+                    k += j;
+                    if (k >= radix) k -= radix;
+                    acc += fft_cmul(in[l], roots[k]);
+                }
+                yp[stride * j + q] = (j == 0) ? acc : fft_cmul(w[j - 1], acc);
+            }
+        }
+    }
+}
+
+// Internal: Single-precision radix-3 Stockham pass
+static void fft_stockham_radix3_f32(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t n,
+                                    uint32_t stride, const fft_complex_f32_t *tw, bool inverse) {
+    uint32_t n1 = n / 3;
+    const float s3 = (inverse ? 1.0f : -1.0f) * 0.86602540378443864676f;   // +/- sin(2*pi/3)
+
+    for (uint32_t p = 0; p < n1; p++) {
+        fft_complex_f32_t w1 = tw[2 * p];
+        fft_complex_f32_t w2 = tw[2 * p + 1];
+
+        const fft_complex_f32_t *xa = x + stride * p;
+        const fft_complex_f32_t *xb = x + stride * (p + n1);
+        const fft_complex_f32_t *xc = x + stride * (p + 2 * n1);
+        fft_complex_f32_t *y0 = y + stride * (3 * p);
+        fft_complex_f32_t *y1 = y0 + stride;
+        fft_complex_f32_t *y2 = y1 + stride;
+
+        for (uint32_t q = 0; q < stride; q++) {
+            fft_complex_f32_t a = xa[q], b = xb[q], c = xc[q];
+
+            fft_complex_f32_t bpc = b + c;
+            fft_complex_f32_t bmc = b - c;
+            fft_complex_f32_t mid = a - 0.5f * bpc;
+            fft_complex_f32_t rot = s3 * (-cimagf(bmc) + crealf(bmc) * I);   // s3 * i * (b - c)
+
+            y0[q] = a + bpc;
+            y1[q] = fft_cmul_f32(w1, mid + rot);
+            y2[q] = fft_cmul_f32(w2, mid - rot);
+        }
+    }
+}
+
+// Internal: Single-precision radix-5 Stockham pass
+static void fft_stockham_radix5_f32(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t n,
+                                    uint32_t stride, const fft_complex_f32_t *tw, bool inverse) {
+    uint32_t n1 = n / 5;
+    const float c1 = 0.30901699437494742410f;    // cos(2*pi/5)
+    const float c2 = -0.80901699437494742410f;   // cos(4*pi/5)
+    const float sign = inverse ? 1.0f : -1.0f;
+    const float s1 = sign * 0.95105651629515357212f;   // +/- sin(2*pi/5)
+    const float s2 = sign * 0.58778525229247312917f;   // +/- sin(4*pi/5)
+
+    for (uint32_t p = 0; p < n1; p++) {
+        const fft_complex_f32_t *w = tw + 4 * p;
+
+        const fft_complex_f32_t *xa = x + stride * p;
+        const fft_complex_f32_t *xb = x + stride * (p + n1);
+        const fft_complex_f32_t *xc = x + stride * (p + 2 * n1);
+        const fft_complex_f32_t *xd = x + stride * (p + 3 * n1);
+        const fft_complex_f32_t *xe = x + stride * (p + 4 * n1);
+        fft_complex_f32_t *y0 = y + stride * (5 * p);
+        fft_complex_f32_t *y1 = y0 + stride;
+        fft_complex_f32_t *y2 = y1 + stride;
+        fft_complex_f32_t *y3 = y2 + stride;
+        fft_complex_f32_t *y4 = y3 + stride;
+
+        for (uint32_t q = 0; q < stride; q++) {
+            fft_complex_f32_t a = xa[q], b = xb[q], c = xc[q], d = xd[q], e = xe[q];
+
+            fft_complex_f32_t bpe = b + e, bme = b - e;
+            fft_complex_f32_t cpd = c + d, cmd = c - d;
+
+            fft_complex_f32_t m1 = a + c1 * bpe + c2 * cpd;
+            fft_complex_f32_t m2 = a + c2 * bpe + c1 * cpd;
+            fft_complex_f32_t t1 = s1 * bme + s2 * cmd;
+            fft_complex_f32_t t2 = s2 * bme - s1 * cmd;
+            fft_complex_f32_t r1 = -cimagf(t1) + crealf(t1) * I;   // i * t1
+            fft_complex_f32_t r2 = -cimagf(t2) + crealf(t2) * I;   // i * t2
+
+            y0[q] = a + bpe + cpd;
+            y1[q] = fft_cmul_f32(w[0], m1 + r1);
+            y2[q] = fft_cmul_f32(w[1], m2 + r2);
+            y3[q] = fft_cmul_f32(w[2], m2 - r2);
+            y4[q] = fft_cmul_f32(w[3], m1 - r1);
+        }
+    }
+}
 
-    // For each stage
-    for (uint32_t stage = 1; stage <= stages; stage++) {
-        uint32_t half_size = 1 << (stage - 1);  // 2^(stage-1)
-        uint32_t full_size = 1 << stage;        // 2^stage
+// Internal: Single-precision generic odd-radix Stockham pass (radix 7), direct r-point DFT
+static void fft_stockham_generic_f32(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t n, uint32_t stride,
+                                     uint32_t radix, const fft_complex_f32_t *tw, bool inverse) {
+    uint32_t n1 = n / radix;
+    fft_complex_f32_t roots[FFT_MAX_RADIX];
+    fft_complex_f32_t in[FFT_MAX_RADIX];
 
-        // For each sub-FFT
-        for (uint32_t group = 0; group < size; group += full_size) {
-            // For each butterfly in the sub-FFT
-            for (uint32_t k = 0; k < half_size; k++) {
-                uint32_t index1 = group + k;
-                uint32_t index2 = group + k + half_size;
+    double angle_scale = (inverse ? 2.0 : -2.0) * M_PI / (double)radix;
+    for (uint32_t k = 0; k < radix; k++) {
+        roots[k] = (fft_complex_f32_t)(cos(angle_scale * (double)k) + sin(angle_scale * (double)k) * I);
+    }
 
-                // Twiddle factor
-                double angle = (direction == FFT_FORWARD) ?
-                    -2.0 * M_PI * (double)k / (double)full_size :
-                     2.0 * M_PI * (double)k / (double)full_size;
+    for (uint32_t p = 0; p < n1; p++) {
+        const fft_complex_f32_t *w = tw + (radix - 1) * p;
+        fft_complex_f32_t *yp = y + stride * (radix * p);
 
-                fft_complex_t twiddle = cos(angle) + sin(angle) * I;
+        for (uint32_t q = 0; q < stride; q++) {
+            for (uint32_t l = 0; l < radix; l++) {
+                in[l] = x[stride * (p + l * n1) + q];
+            }
 
-                // Butterfly operation
-                fft_complex_t temp = data[index2] * twiddle;
-                data[index2] = data[index1] - temp;
-                data[index1] = data[index1] + temp;
+            for (uint32_t j = 0; j < radix; j++) {
+                fft_complex_f32_t acc = in[0];
+                uint32_t k = 0;
+                for (uint32_t l = 1; l < radix; l++) {
+                    k += j;
+                    if (k >= radix) k -= radix;
+                    acc += fft_cmul_f32(in[l], roots[k]);
+                }
+                yp[stride * j + q] = (j == 0) ? acc : fft_cmul_f32(w[j - 1], acc);
             }
         }
     }
 }
+
+/*
+ * =============================================================================
+ * SIMD kernels
+ * =============================================================================
+ *
+ * Complex values stay interleaved (re, im). A radix-4 pass broadcasts the
+ * three twiddles of sub-transform p and vectorizes the contiguous q loop, so
+ * every kernel needs stride to be a multiple of its vector width; the first
+ * pass (stride 1) always runs scalar. Twiddle multiply uses
+ *   a * w = a * wr + swap(a) * (-wi, +wi)
+ * with the signed wi vector built once per p.
+ */
+
+#if defined(FFT_HAVE_X86_SIMD)
+
+// SSE2: two float complex per register
+__attribute__((target("sse2")))
+static void fft_radix4_f32_sse2(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t n,
+                                uint32_t stride, const fft_complex_f32_t *tw, bool inverse) {
+    uint32_t n1 = n / 4;
+    // Multiplying swap(v) by rot gives -j*v (forward) or +j*v (inverse)
+    const __m128 rot = inverse ? _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f)
+                               : _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+
+    for (uint32_t p = 0; p < n1; p++) {
+        __m128 w1r = _mm_set1_ps(crealf(tw[3 * p]));
+        __m128 w1i = _mm_setr_ps(-cimagf(tw[3 * p]), cimagf(tw[3 * p]), -cimagf(tw[3 * p]), cimagf(tw[3 * p]));
+        __m128 w2r = _mm_set1_ps(crealf(tw[3 * p + 1]));
+        __m128 w2i = _mm_setr_ps(-cimagf(tw[3 * p + 1]), cimagf(tw[3 * p + 1]), -cimagf(tw[3 * p + 1]), cimagf(tw[3 * p + 1]));
+        __m128 w3r = _mm_set1_ps(crealf(tw[3 * p + 2]));
+        __m128 w3i = _mm_setr_ps(-cimagf(tw[3 * p + 2]), cimagf(tw[3 * p + 2]), -cimagf(tw[3 * p + 2]), cimagf(tw[3 * p + 2]));
+
+        const float *xa = (const float *)(x + stride * p);
+        const float *xb = (const float *)(x + stride * (p + n1));
+        const float *xc = (const float *)(x + stride * (p + 2 * n1));
+        const float *xd = (const float *)(x + stride * (p + 3 * n1));
+        float *y0 = (float *)(y + stride * (4 * p));
+        float *y1 = y0 + 2 * stride;
+        float *y2 = y1 + 2 * stride;
+        float *y3 = y2 + 2 * stride;
+
+        for (uint32_t q = 0; q < 2 * stride; q += 4) {
+            __m128 a = _mm_loadu_ps(xa + q);
+            __m128 b = _mm_loadu_ps(xb + q);
+            __m128 c = _mm_loadu_ps(xc + q);
+            __m128 d = _mm_loadu_ps(xd + q);
+
+            __m128 apc = _mm_add_ps(a, c);
+            __m128 amc = _mm_sub_ps(a, c);
+            __m128 bpd = _mm_add_ps(b, d);
+            __m128 bmd = _mm_sub_ps(b, d);
+            __m128 jbmd = _mm_mul_ps(_mm_shuffle_ps(bmd, bmd, _MM_SHUFFLE(2, 3, 0, 1)), rot);
+
+            __m128 t1 = _mm_add_ps(amc, jbmd);
+            __m128 t2 = _mm_sub_ps(apc, bpd);
+            __m128 t3 = _mm_sub_ps(amc, jbmd);
+
+            _mm_storeu_ps(y0 + q, _mm_add_ps(apc, bpd));
+            _mm_storeu_ps(y1 + q, _mm_add_ps(_mm_mul_ps(t1, w1r),
+                          _mm_mul_ps(_mm_shuffle_ps(t1, t1, _MM_SHUFFLE(2, 3, 0, 1)), w1i)));
+            _mm_storeu_ps(y2 + q, _mm_add_ps(_mm_mul_ps(t2, w2r),
+                          _mm_mul_ps(_mm_shuffle_ps(t2, t2, _MM_SHUFFLE(2, 3, 0, 1)), w2i)));
+            _mm_storeu_ps(y3 + q, _mm_add_ps(_mm_mul_ps(t3, w3r),
+                          _mm_mul_ps(_mm_shuffle_ps(t3, t3, _MM_SHUFFLE(2, 3, 0, 1)), w3i)));
+        }
+    }
+}
+
+// AVX2 + FMA: four float complex per register
+__attribute__((target("avx2,fma")))
+static void fft_radix4_f32_avx2(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t n,
+                                uint32_t stride, const fft_complex_f32_t *tw, bool inverse) {
+    uint32_t n1 = n / 4;
+    const __m256 rot = inverse ? _mm256_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f)
+                               : _mm256_setr_ps(1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f);
+    const __m256 sign = _mm256_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+
+    for (uint32_t p = 0; p < n1; p++) {
+        __m256 w1r = _mm256_set1_ps(crealf(tw[3 * p]));
+        __m256 w1i = _mm256_mul_ps(_mm256_set1_ps(cimagf(tw[3 * p])), sign);
+        __m256 w2r = _mm256_set1_ps(crealf(tw[3 * p + 1]));
+        __m256 w2i = _mm256_mul_ps(_mm256_set1_ps(cimagf(tw[3 * p + 1])), sign);
+        __m256 w3r = _mm256_set1_ps(crealf(tw[3 * p + 2]));
+        __m256 w3i = _mm256_mul_ps(_mm256_set1_ps(cimagf(tw[3 * p + 2])), sign);
+
+        const float *xa = (const float *)(x + stride * p);
+        const float *xb = (const float *)(x + stride * (p + n1));
+        const float *xc = (const float *)(x + stride * (p + 2 * n1));
+        const float *xd = (const float *)(x + stride * (p + 3 * n1));
+        float *y0 = (float *)(y + stride * (4 * p));
+        float *y1 = y0 + 2 * stride;
+        float *y2 = y1 + 2 * stride;
+        float *y3 = y2 + 2 * stride;
+
+        for (uint32_t q = 0; q < 2 * stride; q += 8) {
+            __m256 a = _mm256_loadu_ps(xa + q);
+            __m256 b = _mm256_loadu_ps(xb + q);
+            __m256 c = _mm256_loadu_ps(xc + q);
+            __m256 d = _mm256_loadu_ps(xd + q);
+
+            __m256 apc = _mm256_add_ps(a, c);
+            __m256 amc = _mm256_sub_ps(a, c);
+            __m256 bpd = _mm256_add_ps(b, d);
+            __m256 bmd = _mm256_sub_ps(b, d);
+            __m256 jbmd = _mm256_mul_ps(_mm256_permute_ps(bmd, _MM_SHUFFLE(2, 3, 0, 1)), rot);
+
+            __m256 t1 = _mm256_add_ps(amc, jbmd);
+            __m256 t2 = _mm256_sub_ps(apc, bpd);
+            __m256 t3 = _mm256_sub_ps(amc, jbmd);
+
+            _mm256_storeu_ps(y0 + q, _mm256_add_ps(apc, bpd));
+            _mm256_storeu_ps(y1 + q, _mm256_fmadd_ps(_mm256_permute_ps(t1, _MM_SHUFFLE(2, 3, 0, 1)), w1i,
+                                                     _mm256_mul_ps(t1, w1r)));
+            _mm256_storeu_ps(y2 + q, _mm256_fmadd_ps(_mm256_permute_ps(t2, _MM_SHUFFLE(2, 3, 0, 1)), w2i,
+                                                     _mm256_mul_ps(t2, w2r)));
+            _mm256_storeu_ps(y3 + q, _mm256_fmadd_ps(_mm256_permute_ps(t3, _MM_SHUFFLE(2, 3, 0, 1)), w3i,
+                                                     _mm256_mul_ps(t3, w3r)));
+        }
+    }
+}
+
+// AVX2 + FMA: two double complex per register
+__attribute__((target("avx2,fma")))
+static void fft_radix4_f64_avx2(const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                                uint32_t stride, const fft_complex_t *tw, bool inverse) {
+    uint32_t n1 = n / 4;
+    const __m256d rot = inverse ? _mm256_setr_pd(-1.0, 1.0, -1.0, 1.0)
+                                : _mm256_setr_pd(1.0, -1.0, 1.0, -1.0);
+    const __m256d sign = _mm256_setr_pd(-1.0, 1.0, -1.0, 1.0);
+
+    for (uint32_t p = 0; p < n1; p++) {
+        __m256d w1r = _mm256_set1_pd(creal(tw[3 * p]));
+        __m256d w1i = _mm256_mul_pd(_mm256_set1_pd(cimag(tw[3 * p])), sign);
+        __m256d w2r = _mm256_set1_pd(creal(tw[3 * p + 1]));
+        __m256d w2i = _mm256_mul_pd(_mm256_set1_pd(cimag(tw[3 * p + 1])), sign);
+        __m256d w3r = _mm256_set1_pd(creal(tw[3 * p + 2]));
+        __m256d w3i = _mm256_mul_pd(_mm256_set1_pd(cimag(tw[3 * p + 2])), sign);
+
+        const double *xa = (const double *)(x + stride * p);
+        const double *xb = (const double *)(x + stride * (p + n1));
+        const double *xc = (const double *)(x + stride * (p + 2 * n1));
+        const double *xd = (const double *)(x + stride * (p + 3 * n1));
+        double *y0 = (double *)(y + stride * (4 * p));
+        double *y1 = y0 + 2 * stride;
+        double *y2 = y1 + 2 * stride;
+        double *y3 = y2 + 2 * stride;
+
+        for (uint32_t q = 0; q < 2 * stride; q += 4) {
+            __m256d a = _mm256_loadu_pd(xa + q);
+            __m256d b = _mm256_loadu_pd(xb + q);
+            __m256d c = _mm256_loadu_pd(xc + q);
+            __m256d d = _mm256_loadu_pd(xd + q);
+
+            __m256d apc = _mm256_add_pd(a, c);
+            __m256d amc = _mm256_sub_pd(a, c);
+            __m256d bpd = _mm256_add_pd(b, d);
+            __m256d bmd = _mm256_sub_pd(b, d);
+            __m256d jbmd = _mm256_mul_pd(_mm256_permute_pd(bmd, 0x5), rot);
+
+            __m256d t1 = _mm256_add_pd(amc, jbmd);
+            __m256d t2 = _mm256_sub_pd(apc, bpd);
+            __m256d t3 = _mm256_sub_pd(amc, jbmd);
+
+            _mm256_storeu_pd(y0 + q, _mm256_add_pd(apc, bpd));
+            _mm256_storeu_pd(y1 + q, _mm256_fmadd_pd(_mm256_permute_pd(t1, 0x5), w1i, _mm256_mul_pd(t1, w1r)));
+            _mm256_storeu_pd(y2 + q, _mm256_fmadd_pd(_mm256_permute_pd(t2, 0x5), w2i, _mm256_mul_pd(t2, w2r)));
+            _mm256_storeu_pd(y3 + q, _mm256_fmadd_pd(_mm256_permute_pd(t3, 0x5), w3i, _mm256_mul_pd(t3, w3r)));
+        }
+    }
+}
+
+// |X|^2, SSE2, four float complex per iteration
+__attribute__((target("sse2")))
+static uint32_t fft_power_f32_sse2(const fft_complex_f32_t *x, float *out, uint32_t size, float norm) {
+    const float *in = (const float *)x;
+    const __m128 scale = _mm_set1_ps(norm);
+    uint32_t i = 0;
+
+    for (; i + 4 <= size; i += 4) {
+        __m128 a = _mm_loadu_ps(in + 2 * i);
+        __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        a = _mm_mul_ps(a, a);
+        b = _mm_mul_ps(b, b);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(re, im), scale));
+    }
+    return i;
+}
+
+// |X|^2, AVX2, eight float complex per iteration
+__attribute__((target("avx2,fma")))
+static uint32_t fft_power_f32_avx2(const fft_complex_f32_t *x, float *out, uint32_t size, float norm) {
+    const float *in = (const float *)x;
+    const __m256 scale = _mm256_set1_ps(norm);
+    uint32_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        __m256 a = _mm256_loadu_ps(in + 2 * i);
+        __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+        // hadd interleaves 128-bit lanes: [a01 a23 b01 b23 | a45 a67 b45 b67]
+        __m256 sum = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+        sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(sum, scale));
+    }
+    return i;
+}
+
+// |X|^2, SSE2, two double complex per iteration
+__attribute__((target("sse2")))
+static uint32_t fft_power_f64_sse2(const fft_complex_t *x, double *out, uint32_t size, double norm) {
+    const double *in = (const double *)x;
+    const __m128d scale = _mm_set1_pd(norm);
+    uint32_t i = 0;
+
+    for (; i + 2 <= size; i += 2) {
+        __m128d a = _mm_loadu_pd(in + 2 * i);
+        __m128d b = _mm_loadu_pd(in + 2 * i + 2);
+        a = _mm_mul_pd(a, a);
+        b = _mm_mul_pd(b, b);
+        __m128d sum = _mm_add_pd(_mm_unpacklo_pd(a, b), _mm_unpackhi_pd(a, b));
+        _mm_storeu_pd(out + i, _mm_mul_pd(sum, scale));
+    }
+    return i;
+}
+
+// |X|^2, AVX2, four double complex per iteration
+__attribute__((target("avx2,fma")))
+static uint32_t fft_power_f64_avx2(const fft_complex_t *x, double *out, uint32_t size, double norm) {
+    const double *in = (const double *)x;
+    const __m256d scale = _mm256_set1_pd(norm);
+    uint32_t i = 0;
+
+    for (; i + 4 <= size; i += 4) {
+        __m256d a = _mm256_loadu_pd(in + 2 * i);
+        __m256d b = _mm256_loadu_pd(in + 2 * i + 4);
+        // hadd gives [|x0|^2 |x2|^2 |x1|^2 |x3|^2]
+        __m256d sum = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+        sum = _mm256_permute4x64_pd(sum, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(sum, scale));
+    }
+    return i;
+}
+
+#endif /* FFT_HAVE_X86_SIMD */
+
+#if defined(FFT_HAVE_NEON)
+
+// Multiply interleaved complex t by broadcast twiddle (wr, signed wi)
+static inline float32x4_t fft_cmul_neon(float32x4_t t, float32x4_t wr, float32x4_t wi) {
+    return vfmaq_f32(vmulq_f32(t, wr), vrev64q_f32(t), wi);
+}
+
+// NEON: two float complex per register
+static void fft_radix4_f32_neon(const fft_complex_f32_t *x, fft_complex_f32_t *y, uint32_t n,
+                                uint32_t stride, const fft_complex_f32_t *tw, bool inverse) {
+    uint32_t n1 = n / 4;
+    static const float rot_fwd[4] = {1.0f, -1.0f, 1.0f, -1.0f};
+    static const float rot_inv[4] = {-1.0f, 1.0f, -1.0f, 1.0f};
+    const float32x4_t rot = vld1q_f32(inverse ? rot_inv : rot_fwd);
+    const float32x4_t sign = vld1q_f32(rot_inv);
+
+    for (uint32_t p = 0; p < n1; p++) {
+        float32x4_t w1r = vdupq_n_f32(crealf(tw[3 * p]));
+        float32x4_t w1i = vmulq_f32(vdupq_n_f32(cimagf(tw[3 * p])), sign);
+        float32x4_t w2r = vdupq_n_f32(crealf(tw[3 * p + 1]));
+        float32x4_t w2i = vmulq_f32(vdupq_n_f32(cimagf(tw[3 * p + 1])), sign);
+        float32x4_t w3r = vdupq_n_f32(crealf(tw[3 * p + 2]));
+        float32x4_t w3i = vmulq_f32(vdupq_n_f32(cimagf(tw[3 * p + 2])), sign);
+
+        const float *xa = (const float *)(x + stride * p);
+        const float *xb = (const float *)(x + stride * (p + n1));
+        const float *xc = (const float *)(x + stride * (p + 2 * n1));
+        const float *xd = (const float *)(x + stride * (p + 3 * n1));
+        float *y0 = (float *)(y + stride * (4 * p));
+        float *y1 = y0 + 2 * stride;
+        float *y2 = y1 + 2 * stride;
+        float *y3 = y2 + 2 * stride;
+
+        for (uint32_t q = 0; q < 2 * stride; q += 4) {
+            float32x4_t a = vld1q_f32(xa + q);
+            float32x4_t b = vld1q_f32(xb + q);
+            float32x4_t c = vld1q_f32(xc + q);
+            float32x4_t d = vld1q_f32(xd + q);
+
+            float32x4_t apc = vaddq_f32(a, c);
+            float32x4_t amc = vsubq_f32(a, c);
+            float32x4_t bpd = vaddq_f32(b, d);
+            float32x4_t jbmd = vmulq_f32(vrev64q_f32(vsubq_f32(b, d)), rot);
+
+            vst1q_f32(y0 + q, vaddq_f32(apc, bpd));
+            vst1q_f32(y1 + q, fft_cmul_neon(vaddq_f32(amc, jbmd), w1r, w1i));
+            vst1q_f32(y2 + q, fft_cmul_neon(vsubq_f32(apc, bpd), w2r, w2i));
+            vst1q_f32(y3 + q, fft_cmul_neon(vsubq_f32(amc, jbmd), w3r, w3i));
+        }
+    }
+}
+
+// |X|^2, NEON, four float complex per iteration (vld2 de-interleaves re/im)
+static uint32_t fft_power_f32_neon(const fft_complex_f32_t *x, float *out, uint32_t size, float norm) {
+    const float *in = (const float *)x;
+    uint32_t i = 0;
+
+    for (; i + 4 <= size; i += 4) {
+        float32x4x2_t v = vld2q_f32(in + 2 * i);
+        float32x4_t p = vfmaq_f32(vmulq_f32(v.val[0], v.val[0]), v.val[1], v.val[1]);
+        vst1q_f32(out + i, vmulq_n_f32(p, norm));
+    }
+    return i;
+}
+
+#endif /* FFT_HAVE_NEON */
+
+// Internal: Run one double-precision radix-4 pass with the best available kernel
+static void fft_radix4_pass(fft_simd_t simd, const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                            uint32_t stride, const fft_complex_t *tw, bool inverse) {
+#if defined(FFT_HAVE_X86_SIMD)
+    if (simd == FFT_SIMD_AVX2 && stride % 2 == 0) {
+        fft_radix4_f64_avx2(x, y, n, stride, tw, inverse);
+        return;
+    }
+#endif
+    (void)simd;
+    fft_stockham_radix4(x, y, n, stride, tw, inverse);
+}
+
+// Internal: Run one single-precision radix-4 pass with the best available kernel
+static void fft_radix4_pass_f32(fft_simd_t simd, const fft_complex_f32_t *x, fft_complex_f32_t *y,
+                                uint32_t n, uint32_t stride, const fft_complex_f32_t *tw, bool inverse) {
+#if defined(FFT_HAVE_X86_SIMD)
+    if (simd == FFT_SIMD_AVX2 && stride % 4 == 0) {
+        fft_radix4_f32_avx2(x, y, n, stride, tw, inverse);
+        return;
+    }
+    if ((simd == FFT_SIMD_AVX2 || simd == FFT_SIMD_SSE2) && stride % 2 == 0) {
+        fft_radix4_f32_sse2(x, y, n, stride, tw, inverse);
+        return;
+    }
+#elif defined(FFT_HAVE_NEON)
+    if (simd == FFT_SIMD_NEON && stride % 2 == 0) {
+        fft_radix4_f32_neon(x, y, n, stride, tw, inverse);
+        return;
+    }
+#endif
+    (void)simd;
+    fft_stockham_radix4_f32(x, y, n, stride, tw, inverse);
+}
+
+// Internal: Run one mixed-radix pass; radix 4 reuses the SIMD radix-4 kernels
+static void fft_mixed_pass(fft_simd_t simd, const fft_complex_t *x, fft_complex_t *y, uint32_t n,
+                           uint32_t stride, uint32_t radix, const fft_complex_t *tw, bool inverse) {
+    switch (radix) {
+        case 2: fft_stockham_radix2(x, y, stride); break;   // Only ever the last pass
+        case 3: fft_stockham_radix3(x, y, n, stride, tw, inverse); break;
+        case 4: fft_radix4_pass(simd, x, y, n, stride, tw, inverse); break;
+        case 5: fft_stockham_radix5(x, y, n, stride, tw, inverse); break;
+        default: fft_stockham_generic(x, y, n, stride, radix, tw, inverse); break;
+    }
+}
+
+// Internal: Single-precision mixed-radix pass
+static void fft_mixed_pass_f32(fft_simd_t simd, const fft_complex_f32_t *x, fft_complex_f32_t *y,
+                               uint32_t n, uint32_t stride, uint32_t radix,
+                               const fft_complex_f32_t *tw, bool inverse) {
+    switch (radix) {
+        case 2: fft_stockham_radix2_f32(x, y, stride); break;
+        case 3: fft_stockham_radix3_f32(x, y, n, stride, tw, inverse); break;
+        case 4: fft_radix4_pass_f32(simd, x, y, n, stride, tw, inverse); break;
+        case 5: fft_stockham_radix5_f32(x, y, n, stride, tw, inverse); break;
+        default: fft_stockham_generic_f32(x, y, n, stride, radix, tw, inverse); break;
+    }
+}
+
+// Internal: Vectorized |X|^2 (double), returns number of bins written
+static uint32_t fft_power_spectrum_simd(fft_simd_t simd, const fft_complex_t *x, double *out,
+                                        uint32_t size, double norm) {
+#if defined(FFT_HAVE_X86_SIMD)
+    if (simd == FFT_SIMD_AVX2) return fft_power_f64_avx2(x, out, size, norm);
+    if (simd == FFT_SIMD_SSE2) return fft_power_f64_sse2(x, out, size, norm);
+#endif
+    (void)simd; (void)x; (void)out; (void)size; (void)norm;
+    return 0;
+}
+
+// Internal: Vectorized |X|^2 (float), returns number of bins written
+static uint32_t fft_power_spectrum_f32_simd(fft_simd_t simd, const fft_complex_f32_t *x, float *out,
+                                            uint32_t size, float norm) {
+#if defined(FFT_HAVE_X86_SIMD)
+    if (simd == FFT_SIMD_AVX2) return fft_power_f32_avx2(x, out, size, norm);
+    if (simd == FFT_SIMD_SSE2) return fft_power_f32_sse2(x, out, size, norm);
+#elif defined(FFT_HAVE_NEON)
+    if (simd == FFT_SIMD_NEON) return fft_power_f32_neon(x, out, size, norm);
+#endif
+    (void)simd; (void)x; (void)out; (void)size; (void)norm;
+    return 0;
+}
+
+/*
+ * Generated codelets
+ * fft_codelets.inc (from tools/fft_codegen.c) holds one forward transform
+ * per size 2..FFT_CODELET_MAX_SIZE as straight-line code over FFT_CL_V
+ * values. It is included once per kernel family below with the FFT_CL_*
+ * macros bound to that family's arithmetic. Inverse transforms run the
+ * forward codelet on conjugated data: scalar codelets swap the real and
+ * imaginary streams (swap(DFT(swap(x))) is the unnormalized inverse DFT),
+ * vector codelets flip the imaginary sign on load and store.
+ */
+
+typedef struct { double re, im; } fft_cl_f64_t;
+typedef struct { float re, im; } fft_cl_f32_t;
+
+// Scalar arithmetic shared by both precisions
+#define FFT_CL_ATTR
+#define FFT_CL_LOAD(i) ((FFT_CL_V){ xr[2 * (i)], xi[2 * (i)] })
+#define FFT_CL_STORE(i, v) (yr[2 * (i)] = (v).re, yi[2 * (i)] = (v).im)
+#define FFT_CL_ADD(a, b) ((FFT_CL_V){ (a).re + (b).re, (a).im + (b).im })
+#define FFT_CL_SUB(a, b) ((FFT_CL_V){ (a).re - (b).re, (a).im - (b).im })
+#define FFT_CL_NEG(a) ((FFT_CL_V){ -(a).re, -(a).im })
+#define FFT_CL_MUL_NJ(a) ((FFT_CL_V){ (a).im, -(a).re })
+#define FFT_CL_MUL(a, c, s) ((FFT_CL_V){ (a).re * (FFT_CL_R)(c) - (a).im * (FFT_CL_R)(s), \
+                                         (a).re * (FFT_CL_R)(s) + (a).im * (FFT_CL_R)(c) })
+
+// Scalar double precision
+#define FFT_CL_R double
+#define FFT_CL_V fft_cl_f64_t
+#define FFT_CL_NAME(n) fft_codelet_f64_##n
+#define FFT_CL_TABLE fft_codelets_f64
+#define FFT_CL_PARAMS const fft_complex_t *x, fft_complex_t *y, bool inverse
+#define FFT_CL_PROLOGUE \
+    const double *xr = (const double *)x + inverse, *xi = (const double *)x + !inverse; \
+    double *yr = (double *)y + inverse, *yi = (double *)y + !inverse;
+#include "fft_codelets.inc"
+#undef FFT_CL_R
+#undef FFT_CL_V
+#undef FFT_CL_NAME
+#undef FFT_CL_TABLE
+#undef FFT_CL_PARAMS
+#undef FFT_CL_PROLOGUE
+
+// Scalar single precision
+#define FFT_CL_R float
+#define FFT_CL_V fft_cl_f32_t
+#define FFT_CL_NAME(n) fft_codelet_f32_##n
+#define FFT_CL_TABLE fft_codelets_f32
+#define FFT_CL_PARAMS const fft_complex_f32_t *x, fft_complex_f32_t *y, bool inverse
+#define FFT_CL_PROLOGUE \
+    const float *xr = (const float *)x + inverse, *xi = (const float *)x + !inverse; \
+    float *yr = (float *)y + inverse, *yi = (float *)y + !inverse;
+#include "fft_codelets.inc"
+#undef FFT_CL_R
+#undef FFT_CL_V
+#undef FFT_CL_NAME
+#undef FFT_CL_TABLE
+#undef FFT_CL_PARAMS
+#undef FFT_CL_PROLOGUE
+
+#undef FFT_CL_ATTR
+#undef FFT_CL_LOAD
+#undef FFT_CL_STORE
+#undef FFT_CL_ADD
+#undef FFT_CL_SUB
+#undef FFT_CL_NEG
+#undef FFT_CL_MUL_NJ
+#undef FFT_CL_MUL
+
+_Static_assert(1u << (sizeof(fft_codelets_f64) / sizeof(fft_codelets_f64[0]) - 1) == FFT_CODELET_MAX_SIZE,
+               "fft_codelets.inc does not match FFT_CODELET_MAX_SIZE; run make codelets");
+
+#if defined(FFT_HAVE_X86_SIMD)
+
+// SSE2 double: one complex per register
+#define FFT_CL_ATTR __attribute__((target("sse2")))
+#define FFT_CL_V __m128d
+#define FFT_CL_NAME(n) fft_codelet_f64_sse2_##n
+#define FFT_CL_TABLE fft_codelets_f64_sse2
+#define FFT_CL_PARAMS const fft_complex_t *x, fft_complex_t *y, bool inverse
+#define FFT_CL_PROLOGUE const __m128d flip = inverse ? _mm_set_pd(-0.0, 0.0) : _mm_setzero_pd();
+#define FFT_CL_LOAD(i) _mm_xor_pd(_mm_loadu_pd((const double *)(x + (i))), flip)
+#define FFT_CL_STORE(i, v) _mm_storeu_pd((double *)(y + (i)), _mm_xor_pd(v, flip))
+#define FFT_CL_ADD(a, b) _mm_add_pd(a, b)
+#define FFT_CL_SUB(a, b) _mm_sub_pd(a, b)
+#define FFT_CL_NEG(a) _mm_xor_pd(a, _mm_set1_pd(-0.0))
+#define FFT_CL_MUL_NJ(a) _mm_xor_pd(_mm_shuffle_pd(a, a, 1), _mm_set_pd(-0.0, 0.0))
+#define FFT_CL_MUL(a, c, s) _mm_add_pd(_mm_mul_pd(a, _mm_set1_pd(c)), \
+                                       _mm_mul_pd(_mm_shuffle_pd(a, a, 1), _mm_set_pd(s, -(s))))
+#include "fft_codelets.inc"
+#undef FFT_CL_ATTR
+#undef FFT_CL_V
+#undef FFT_CL_NAME
+#undef FFT_CL_TABLE
+#undef FFT_CL_PARAMS
+#undef FFT_CL_PROLOGUE
+#undef FFT_CL_LOAD
+#undef FFT_CL_STORE
+#undef FFT_CL_ADD
+#undef FFT_CL_SUB
+#undef FFT_CL_NEG
+#undef FFT_CL_MUL_NJ
+#undef FFT_CL_MUL
+
+// SSE2 float: lanes 0-1 carry frame a, lanes 2-3 frame b
+#define FFT_CL_ATTR __attribute__((target("sse2")))
+#define FFT_CL_V __m128
+#define FFT_CL_NAME(n) fft_codelet_f32_sse2_##n
+#define FFT_CL_TABLE fft_codelets_f32_sse2
+#define FFT_CL_PARAMS const fft_complex_f32_t *xa, const fft_complex_f32_t *xb, \
+                      fft_complex_f32_t *ya, fft_complex_f32_t *yb, bool inverse
+#define FFT_CL_PROLOGUE \
+    const __m128 flip = inverse ? _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f) : _mm_setzero_ps();
+#define FFT_CL_LOAD(i) _mm_xor_ps(_mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(xa + (i))), \
+                                               (const __m64 *)(xb + (i))), flip)
+#define FFT_CL_STORE(i, v) do { \
+        __m128 out_ = _mm_xor_ps(v, flip); \
+        _mm_storel_pi((__m64 *)(ya + (i)), out_); \
+        _mm_storeh_pi((__m64 *)(yb + (i)), out_); \
+    } while (0)
+#define FFT_CL_ADD(a, b) _mm_add_ps(a, b)
+#define FFT_CL_SUB(a, b) _mm_sub_ps(a, b)
+#define FFT_CL_NEG(a) _mm_xor_ps(a, _mm_set1_ps(-0.0f))
+#define FFT_CL_MUL_NJ(a) _mm_xor_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), \
+                                    _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f))
+#define FFT_CL_MUL(a, c, s) _mm_add_ps(_mm_mul_ps(a, _mm_set1_ps((float)(c))), \
+    _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), \
+               _mm_setr_ps(-(float)(s), (float)(s), -(float)(s), (float)(s))))
+#include "fft_codelets.inc"
+#undef FFT_CL_ATTR
+#undef FFT_CL_V
+#undef FFT_CL_NAME
+#undef FFT_CL_TABLE
+#undef FFT_CL_PARAMS
+#undef FFT_CL_PROLOGUE
+#undef FFT_CL_LOAD
+#undef FFT_CL_STORE
+#undef FFT_CL_ADD
+#undef FFT_CL_SUB
+#undef FFT_CL_NEG
+#undef FFT_CL_MUL_NJ
+#undef FFT_CL_MUL
+
+#endif /* FFT_HAVE_X86_SIMD */
+
+#if defined(FFT_HAVE_NEON)
+
+// Lane multipliers: identity, conjugate, and the (-s, +s) twiddle sign
+static const double fft_cl_neon_f64[3][2] = { {1.0, 1.0}, {1.0, -1.0}, {-1.0, 1.0} };
+static const float fft_cl_neon_f32[3][4] = { {1.0f, 1.0f, 1.0f, 1.0f},
+                                             {1.0f, -1.0f, 1.0f, -1.0f},
+                                             {-1.0f, 1.0f, -1.0f, 1.0f} };
+
+// NEON double: one complex per register
+#define FFT_CL_ATTR
+#define FFT_CL_V float64x2_t
+#define FFT_CL_NAME(n) fft_codelet_f64_neon_##n
+#define FFT_CL_TABLE fft_codelets_f64_neon
+#define FFT_CL_PARAMS const fft_complex_t *x, fft_complex_t *y, bool inverse
+#define FFT_CL_PROLOGUE \
+    const float64x2_t flip = vld1q_f64(fft_cl_neon_f64[inverse ? 1 : 0]); \
+    const float64x2_t conj = vld1q_f64(fft_cl_neon_f64[1]); \
+    const float64x2_t sign = vld1q_f64(fft_cl_neon_f64[2]); \
+    (void)conj; (void)sign;
+#define FFT_CL_LOAD(i) vmulq_f64(vld1q_f64((const double *)(x + (i))), flip)
+#define FFT_CL_STORE(i, v) vst1q_f64((double *)(y + (i)), vmulq_f64(v, flip))
+#define FFT_CL_ADD(a, b) vaddq_f64(a, b)
+#define FFT_CL_SUB(a, b) vsubq_f64(a, b)
+#define FFT_CL_NEG(a) vnegq_f64(a)
+#define FFT_CL_MUL_NJ(a) vmulq_f64(vextq_f64(a, a, 1), conj)
+#define FFT_CL_MUL(a, c, s) vfmaq_f64(vmulq_n_f64(a, c), vextq_f64(a, a, 1), vmulq_n_f64(sign, s))
+#include "fft_codelets.inc"
+#undef FFT_CL_V
+#undef FFT_CL_NAME
+#undef FFT_CL_TABLE
+#undef FFT_CL_PARAMS
+#undef FFT_CL_PROLOGUE
+#undef FFT_CL_LOAD
+#undef FFT_CL_STORE
+#undef FFT_CL_ADD
+#undef FFT_CL_SUB
+#undef FFT_CL_NEG
+#undef FFT_CL_MUL_NJ
+#undef FFT_CL_MUL
+
+// NEON float: lanes 0-1 carry frame a, lanes 2-3 frame b
+#define FFT_CL_V float32x4_t
+#define FFT_CL_NAME(n) fft_codelet_f32_neon_##n
+#define FFT_CL_TABLE fft_codelets_f32_neon
+#define FFT_CL_PARAMS const fft_complex_f32_t *xa, const fft_complex_f32_t *xb, \
+                      fft_complex_f32_t *ya, fft_complex_f32_t *yb, bool inverse
+#define FFT_CL_PROLOGUE \
+    const float32x4_t flip = vld1q_f32(fft_cl_neon_f32[inverse ? 1 : 0]); \
+    const float32x4_t conj = vld1q_f32(fft_cl_neon_f32[1]); \
+    const float32x4_t sign = vld1q_f32(fft_cl_neon_f32[2]); \
+    (void)conj; (void)sign;
+#define FFT_CL_LOAD(i) vmulq_f32(vcombine_f32(vld1_f32((const float *)(xa + (i))), \
+                                              vld1_f32((const float *)(xb + (i)))), flip)
+#define FFT_CL_STORE(i, v) do { \
+        float32x4_t out_ = vmulq_f32(v, flip); \
+        vst1_f32((float *)(ya + (i)), vget_low_f32(out_)); \
+        vst1_f32((float *)(yb + (i)), vget_high_f32(out_)); \
+    } while (0)
+#define FFT_CL_ADD(a, b) vaddq_f32(a, b)
+#define FFT_CL_SUB(a, b) vsubq_f32(a, b)
+#define FFT_CL_NEG(a) vnegq_f32(a)
+#define FFT_CL_MUL_NJ(a) vmulq_f32(vrev64q_f32(a), conj)
+#define FFT_CL_MUL(a, c, s) vfmaq_f32(vmulq_n_f32(a, (float)(c)), vrev64q_f32(a), \
+                                      vmulq_n_f32(sign, (float)(s)))
+#include "fft_codelets.inc"
+#undef FFT_CL_ATTR
+#undef FFT_CL_V
+#undef FFT_CL_NAME
+#undef FFT_CL_TABLE
+#undef FFT_CL_PARAMS
+#undef FFT_CL_PROLOGUE
+#undef FFT_CL_LOAD
+#undef FFT_CL_STORE
+#undef FFT_CL_ADD
+#undef FFT_CL_SUB
+#undef FFT_CL_NEG
+#undef FFT_CL_MUL_NJ
+#undef FFT_CL_MUL
+
+#endif /* FFT_HAVE_NEON */
+
+// Internal: Run the double-precision codelet for 2^log2_size points
+static void fft_codelet_run(fft_simd_t simd, uint32_t log2_size, const fft_complex_t *x,
+                            fft_complex_t *y, bool inverse) {
+#if defined(FFT_HAVE_X86_SIMD)
+    if (simd == FFT_SIMD_SSE2 || simd == FFT_SIMD_AVX2) {
+        fft_codelets_f64_sse2[log2_size](x, y, inverse);
+        return;
+    }
+#elif defined(FFT_HAVE_NEON)
+    if (simd == FFT_SIMD_NEON) {
+        fft_codelets_f64_neon[log2_size](x, y, inverse);
+        return;
+    }
+#endif
+    (void)simd;
+    fft_codelets_f64[log2_size](x, y, inverse);
+}
+
+// Internal: Run the single-precision codelet on frames a and b (the same
+// pointers for one frame)
+static void fft_codelet_run_f32(fft_simd_t simd, uint32_t log2_size, const fft_complex_f32_t *xa,
+                                const fft_complex_f32_t *xb, fft_complex_f32_t *ya,
+                                fft_complex_f32_t *yb, bool inverse) {
+#if defined(FFT_HAVE_X86_SIMD)
+    if (simd == FFT_SIMD_SSE2 || simd == FFT_SIMD_AVX2) {
+        fft_codelets_f32_sse2[log2_size](xa, xb, ya, yb, inverse);
+        return;
+    }
+#elif defined(FFT_HAVE_NEON)
+    if (simd == FFT_SIMD_NEON) {
+        fft_codelets_f32_neon[log2_size](xa, xb, ya, yb, inverse);
+        return;
+    }
+#endif
+    (void)simd;
+    fft_codelets_f32[log2_size](xa, ya, inverse);
+    if (yb != ya) {
+        fft_codelets_f32[log2_size](xb, yb, inverse);
+    }
+}
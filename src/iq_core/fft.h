@@ -2,11 +2,14 @@
 #define IQ_FFT_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <complex.h>
 
 // FFT configuration
 #define FFT_MAX_SIZE 1048576  // 2^20, should be enough for most applications
+#define FFT_MAX_FACTORS 32    // Mixed-radix passes per plan (2^20 needs at most 20)
+#define FFT_CODELET_MAX_SIZE 64  // Largest size with a generated straight-line codelet
 
 /*
  * Complex number type for FFT operations
@@ -14,6 +17,12 @@
  */
 typedef double complex fft_complex_t;
 
+/*
+ * Single-precision complex type for float32 FFT plans
+ * Matches the float IQ buffers used throughout the pipeline
+ */
+typedef float complex fft_complex_f32_t;
+
 /*
  * FFT direction
  */
@@ -22,18 +31,88 @@ typedef enum {
     FFT_INVERSE = 1    // Inverse FFT (frequency -> time)
 } fft_direction_t;
 
+/*
+ * SIMD kernel families for butterflies and |X|^2 loops
+ * Chosen at plan creation from what the running CPU supports
+ */
+typedef enum {
+    FFT_SIMD_NONE = 0,  // Portable scalar C
+    FFT_SIMD_SSE2,      // x86 SSE2
+    FFT_SIMD_AVX2,      // x86 AVX2 + FMA
+    FFT_SIMD_NEON       // ARM AdvSIMD (AArch64)
+} fft_simd_t;
+
+/*
+ * Transform algorithm chosen for a plan size
+ */
+typedef enum {
+    FFT_ALGO_RADIX4 = 0,    // Power of two: radix-4 Stockham (+ radix-2 pass)
+    FFT_ALGO_MIXED_RADIX,   // 2^a * 3^b * 5^c * 7^d: radix-4/2/3/5/7 Stockham passes
+    FFT_ALGO_BLUESTEIN,     // Any other size: chirp-z convolution on a power-of-two FFT
+    FFT_ALGO_CODELET        // Power of two 2..FFT_CODELET_MAX_SIZE: generated straight-line code
+} fft_algorithm_t;
+
 /*
  * FFT plan structure
- * Contains pre-computed twiddle factors and bit reversal table
+ * Contains pre-computed twiddle factors and the pass schedule for the chosen
+ * algorithm. Plans are immutable once created, so one plan may be executed
+ * concurrently from several threads (the Stockham work buffer is per-thread).
  */
-typedef struct {
-    uint32_t size;                    // FFT size (must be power of 2)
+typedef struct fft_plan_t {
+    uint32_t size;                    // FFT size (any length 1..FFT_MAX_SIZE)
     fft_direction_t direction;        // Forward or inverse
-    fft_complex_t *twiddle_factors;   // Pre-computed twiddle factors
-    uint32_t *bit_reversal_table;     // Bit reversal lookup table
+    fft_algorithm_t algorithm;        // Pass schedule used by fft_execute
+    uint32_t log2_size;               // log2(size) (radix-4 and codelet plans)
+    fft_complex_t *twiddle_factors;   // exp(-/+2*pi*i*k/N) for k < N/2 (radix-4 plans only)
+    fft_complex_t *stage_twiddles;    // Per-pass twiddles: radix-4 (w1, w2, w3) triples,
+                                      // or (r - 1) entries per butterfly for mixed radix
+    uint32_t num_radix4_stages;       // Number of radix-4 Stockham passes
+    bool has_radix2_stage;            // Trailing radix-2 pass when log2(size) is odd
+    uint8_t factors[FFT_MAX_FACTORS]; // Mixed-radix pass radices, first pass first
+    uint32_t num_factors;             // Number of mixed-radix passes
+    struct fft_plan_t *chirp_plan;    // Bluestein: forward power-of-two plan of length M
+    fft_complex_t *chirp;             // Bluestein: exp(-/+i*pi*n^2/N) for n < N
+    fft_complex_t *chirp_kernel;      // Bluestein: FFT_M of the conjugate chirp, scaled by 1/M
     bool is_inverse_normalized;       // Whether to normalize inverse FFT
+    fft_simd_t simd;                  // Butterfly kernel family (FFT_SIMD_NONE forces scalar)
 } fft_plan_t;
 
+/*
+ * Single-precision FFT plan structure
+ * Same stage schedule as fft_plan_t with float32 twiddles and buffers, so each
+ * bin costs 8 bytes instead of 16. Twiddles are computed in double precision
+ * and rounded once. Bluestein sizes run through a double-precision plan: the
+ * n^2 chirp phase is too coarse in float for large N.
+ */
+typedef struct {
+    uint32_t size;                        // FFT size (any length 1..FFT_MAX_SIZE)
+    fft_direction_t direction;            // Forward or inverse
+    fft_algorithm_t algorithm;            // Pass schedule used by fft_execute_f32
+    uint32_t log2_size;                   // log2(size) (radix-4 and codelet plans)
+    fft_complex_f32_t *twiddle_factors;   // exp(-/+2*pi*i*k/N) for k < N/2 (radix-4 plans only)
+    fft_complex_f32_t *stage_twiddles;    // Per-pass twiddles, same layout as fft_plan_t
+    uint32_t num_radix4_stages;           // Number of radix-4 Stockham passes
+    bool has_radix2_stage;                // Trailing radix-2 pass when log2(size) is odd
+    uint8_t factors[FFT_MAX_FACTORS];     // Mixed-radix pass radices, first pass first
+    uint32_t num_factors;                 // Number of mixed-radix passes
+    fft_plan_t *bluestein_plan;           // Bluestein sizes: double-precision plan to run
+    bool is_inverse_normalized;           // Whether to normalize inverse FFT
+    fft_simd_t simd;                      // Butterfly kernel family (FFT_SIMD_NONE forces scalar)
+} fft_plan_f32_t;
+
+/*
+ * Real-input FFT plan
+ * An N-point real transform runs as one N/2-point complex FFT over the
+ * even/odd sample pairs plus a Hermitian post-twiddle pass. Only the
+ * non-redundant N/2 + 1 bins (DC..Nyquist) are produced or consumed.
+ */
+typedef struct {
+    uint32_t size;                    // Real transform length N (even, >= 2)
+    fft_plan_t *half_forward;         // N/2-point forward complex plan
+    fft_plan_t *half_inverse;         // N/2-point inverse complex plan
+    fft_complex_t *post_twiddles;     // exp(-2*pi*i*k/N) for k < N/2
+} fft_real_plan_t;
+
 /*
  * Function declarations
  */
@@ -47,16 +126,153 @@ void fft_plan_destroy(fft_plan_t *plan);
 // Execute FFT using the plan
 bool fft_execute(const fft_plan_t *plan, const fft_complex_t *input, fft_complex_t *output);
 
-// Convenience functions for one-off FFTs (creates/destroys plan internally)
+// Single-precision plan creation, destruction and execution
+fft_plan_f32_t *fft_plan_f32_create(uint32_t size, fft_direction_t direction);
+void fft_plan_f32_destroy(fft_plan_f32_t *plan);
+bool fft_execute_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *input,
+                     fft_complex_f32_t *output);
+
+/*
+ * Cost query: which algorithm a size would get and roughly what it costs,
+ * without building the plan. Lets callers pick between e.g. an exact 3000-bin
+ * transform and rounding up to 4096. Reports the fixed rules; a size with
+ * wisdom (below) may be built with another algorithm.
+ */
+typedef struct {
+    fft_algorithm_t algorithm;    // Algorithm fft_plan_create would choose
+    uint32_t num_passes;          // Stockham passes per transform (Bluestein: per inner FFT)
+    uint32_t transform_size;      // Length actually transformed (Bluestein: M >= 2N - 1)
+    double flops;                 // Estimated real floating-point operations per transform
+    size_t plan_bytes;            // Approximate double-precision plan table footprint
+} fft_cost_t;
+
+bool fft_query_cost(uint32_t size, fft_cost_t *cost);
+const char *fft_algorithm_name(fft_algorithm_t algorithm);
+
+/*
+ * Process-wide plan cache
+ * Plans are keyed by (size, direction, precision), built once and shared.
+ * Lookups are thread-safe and cached plans are immutable, so several threads
+ * may execute the same plan. Every acquire must be paired with a release;
+ * never pass a cached plan to fft_plan_destroy. Released plans stay cached
+ * until fft_plan_cache_clear() so later lookups skip the twiddle build.
+ */
+typedef enum {
+    FFT_PRECISION_F64 = 0,  // fft_plan_t
+    FFT_PRECISION_F32 = 1   // fft_plan_f32_t
+} fft_precision_t;
+
+fft_plan_t *fft_plan_acquire(uint32_t size, fft_direction_t direction);
+void fft_plan_release(const fft_plan_t *plan);
+fft_plan_f32_t *fft_plan_f32_acquire(uint32_t size, fft_direction_t direction);
+void fft_plan_f32_release(const fft_plan_f32_t *plan);
+fft_real_plan_t *fft_real_plan_acquire(uint32_t size);
+void fft_real_plan_release(const fft_real_plan_t *plan);
+
+// Build forward and inverse plans for the given sizes ahead of the first frame
+bool fft_plan_cache_prewarm(const uint32_t *sizes, uint32_t num_sizes, fft_precision_t precision);
+
+// Free cached plans that are not currently acquired; returns number freed
+uint32_t fft_plan_cache_clear(void);
+
+/*
+ * Measured plan choices ("wisdom")
+ * Without wisdom a size gets its algorithm from fixed rules and the widest
+ * SIMD family the CPU has. fft_tune() (fft_tune.h, or the iqtune tool)
+ * times every candidate for one size and precision and records the fastest
+ * here; plans created afterwards are built that way. Wisdom is saved as a
+ * small text file, and the file named by the IQLAB_FFT_WISDOM environment
+ * variable is loaded on the first plan creation, so tuned runs pay no
+ * measuring delay. Entries naming kernels the running CPU lacks are ignored.
+ */
+#define FFT_WISDOM_ENV "IQLAB_FFT_WISDOM"
+#define FFT_WISDOM_MAX 512          // Entries held (size x precision)
+
+typedef struct {
+    uint32_t size;                  // Transform length
+    fft_precision_t precision;      // Plan type the entry applies to
+    fft_algorithm_t algorithm;      // Pass schedule to build
+    fft_simd_t simd;                // Kernel family to run
+    double ns;                      // Measured time per forward transform
+} fft_wisdom_t;
+
+// Add or replace the entry for (size, precision); false if invalid or full
+bool fft_wisdom_record(const fft_wisdom_t *entry);
+
+// Entry for (size, precision) usable on this CPU; false if none
+bool fft_wisdom_lookup(uint32_t size, fft_precision_t precision, fft_wisdom_t *entry);
+
+// Merge a wisdom file into the table, or write the table out
+bool fft_wisdom_load(const char *path);
+bool fft_wisdom_save(const char *path);
+
+// Drop every entry (later plans use the fixed rules); returns number dropped
+uint32_t fft_wisdom_forget(void);
+
+/*
+ * Plans with an explicit schedule and kernel family, bypassing wisdom
+ * NULL if the algorithm cannot transform this size or the CPU lacks 'simd'.
+ */
+fft_plan_t *fft_plan_create_as(uint32_t size, fft_direction_t direction,
+                               fft_algorithm_t algorithm, fft_simd_t simd);
+fft_plan_f32_t *fft_plan_f32_create_as(uint32_t size, fft_direction_t direction,
+                                       fft_algorithm_t algorithm, fft_simd_t simd);
+
+// Algorithm or kernel family from its name (fft_algorithm_name / fft_simd_name)
+bool fft_algorithm_from_name(const char *name, fft_algorithm_t *algorithm);
+bool fft_simd_from_name(const char *name, fft_simd_t *simd);
+
+// Whether the running CPU can execute kernels of 'simd'
+bool fft_simd_supported(fft_simd_t simd);
+
+/*
+ * Batched execution: transform `count` frames in one call. Frame f is read from
+ * input + f * in_stride and written to output + f * out_stride (strides in
+ * complex elements). in_stride may be smaller than the plan size, so
+ * overlapping STFT hops can be read straight from one sample buffer;
+ * out_stride must be at least the plan size.
+ */
+bool fft_execute_batch(const fft_plan_t *plan, const fft_complex_t *input, fft_complex_t *output,
+                       uint32_t count, size_t in_stride, size_t out_stride);
+bool fft_execute_batch_f32(const fft_plan_f32_t *plan, const fft_complex_f32_t *input,
+                           fft_complex_f32_t *output, uint32_t count,
+                           size_t in_stride, size_t out_stride);
+
+// Convenience functions for one-off FFTs (uses the plan cache)
 bool fft_forward(const fft_complex_t *input, fft_complex_t *output, uint32_t size);
 bool fft_inverse(const fft_complex_t *input, fft_complex_t *output, uint32_t size);
 
-// Real-to-complex FFT (for real-valued input signals)
+// Real-input plan creation and destruction
+fft_real_plan_t *fft_real_plan_create(uint32_t size);
+void fft_real_plan_destroy(fft_real_plan_t *plan);
+
+// Real-to-complex FFT: N real samples -> N/2 + 1 bins (DC..Nyquist)
+bool fft_real_execute_forward(const fft_real_plan_t *plan, const double *input, fft_complex_t *output);
+
+// Complex-to-real inverse FFT: N/2 + 1 bins -> N real samples (normalized by 1/N)
+bool fft_real_execute_inverse(const fft_real_plan_t *plan, const fft_complex_t *input, double *output);
+
+// Real-to-complex FFT, full N-bin Hermitian spectrum (uses the plan cache)
 bool fft_real_forward(const double *input, fft_complex_t *output, uint32_t size);
 
-// Complex-to-real inverse FFT (for complex spectrum to real signal)
+// Complex-to-real inverse FFT from a full N-bin spectrum (uses bins 0..N/2 only)
 bool fft_real_inverse(const fft_complex_t *input, double *output, uint32_t size);
 
+// Free the calling thread's FFT scratch buffers now (a thread's buffers are
+// freed automatically when it exits)
+void fft_release_thread_buffers(void);
+
+/*
+ * Scratch one thread needs to run plans of 'size' without allocating
+ * Per-thread buffers are carved from the thread's bound arena (arena.h)
+ * when there is one; reserve this much per thread that runs such plans.
+ */
+size_t fft_scratch_bytes(uint32_t size);
+
+// Best SIMD kernel family supported by the running CPU, and its name
+fft_simd_t fft_simd_detect(void);
+const char *fft_simd_name(fft_simd_t simd);
+
 // Utility functions
 bool fft_is_power_of_two(uint32_t n);
 uint32_t fft_next_power_of_two(uint32_t n);
@@ -72,12 +288,57 @@ double fft_magnitude_db(fft_complex_t c, double reference);
 bool fft_power_spectrum(const fft_complex_t *fft_output, double *power_spectrum,
                        uint32_t size, bool normalize);
 
-// FFT shift: move DC component to center of spectrum
+// FFT shift: move DC component to center of spectrum (index N/2, rounded down, for odd N)
 bool fft_shift(const fft_complex_t *input, fft_complex_t *output, uint32_t size);
 
 // FFT shift for real arrays (power spectrum)
 bool fft_shift_real(const double *input, double *output, uint32_t size);
 
+// Single-precision power spectrum and FFT shift
+bool fft_power_spectrum_f32(const fft_complex_f32_t *fft_output, float *power_spectrum,
+                            uint32_t size, bool normalize);
+bool fft_shift_f32(const fft_complex_f32_t *input, fft_complex_f32_t *output, uint32_t size);
+
+/*
+ * Fused spectral frame for STFT tools: interleaved float IQ (I0, Q0, I1, ...)
+ * is windowed while it is staged, transformed, and written as an fftshifted
+ * |X|^2 row (DC at bin N/2) in linear power or 10*log10(|X|^2 + 1e-12) dB.
+ * Replaces the copy / FFT / shift / power sequence with the FFT passes plus
+ * one staging sweep and one output sweep. window holds N real taps or NULL
+ * for a rectangular frame; the power is not normalized.
+ */
+bool fft_spectral_frame(const fft_plan_f32_t *plan, const float *iq, const float *window,
+                        float *row, bool db);
+
+// Same as fft_spectral_frame, writing a double-precision row (e.g. for CFAR)
+bool fft_spectral_frame_f64(const fft_plan_f32_t *plan, const float *iq, const float *window,
+                            double *row, bool db);
+
+// One transform, both row formats: row equals fft_spectral_frame and row_f64
+// fft_spectral_frame_f64 bit for bit; either may be NULL (spectral_bus.h)
+bool fft_spectral_frame_dual(const fft_plan_f32_t *plan, const float *iq, const float *window,
+                             float *row, double *row_f64, bool db);
+
+/*
+ * Spectral rows for 'count' frames spaced 'hop' complex samples apart in one
+ * interleaved buffer, written back to back in 'rows' (count * N floats).
+ * Rows equal fft_spectral_frame on each frame bit for bit; rectangular
+ * frames go through fft_execute_batch_f32 in cache-sized groups.
+ */
+bool fft_spectral_batch(const fft_plan_f32_t *plan, const float *iq, uint32_t count, size_t hop,
+                        const float *window, float *rows, bool db);
+
+/*
+ * Integer-input spectral frames: interleaved signed 8- or 16-bit IQ ('bits')
+ * is normalized to [-1, 1) inside the window multiply while it is staged, so
+ * detection front ends never hold a float copy of the samples. Rows match
+ * fft_spectral_frame* on the iq_convert_to_float output bit for bit.
+ */
+bool fft_spectral_frame_int(const fft_plan_f32_t *plan, const void *iq, uint32_t bits,
+                            const float *window, float *row, bool db);
+bool fft_spectral_frame_int_f64(const fft_plan_f32_t *plan, const void *iq, uint32_t bits,
+                                const float *window, double *row, bool db);
+
 // Convert real IQ samples to complex format
 void fft_iq_to_complex(const float *iq_data, fft_complex_t *complex_data,
                       uint32_t num_samples, bool scale_to_unit);
@@ -0,0 +1,135 @@
+/*
+ * IQ Lab - FFT autotuning
+ *
+ * Every candidate transforms the same deterministic frame out of place, so
+ * the comparison sees identical data and cache state; only the best round
+ * counts, which drops rounds disturbed by other work on the machine.
+ */
+
+#include "fft_tune.h"
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Schedules that can transform 'size', in order of preference on ties
+static uint32_t tune_algorithms(uint32_t size, fft_algorithm_t *algorithms) {
+    uint32_t count = 0;
+    if (fft_is_power_of_two(size)) {
+        if (size <= FFT_CODELET_MAX_SIZE) algorithms[count++] = FFT_ALGO_CODELET;
+        algorithms[count++] = FFT_ALGO_RADIX4;
+        algorithms[count++] = FFT_ALGO_MIXED_RADIX;
+        return count;
+    }
+
+    fft_cost_t cost;
+    if (fft_query_cost(size, &cost) && cost.algorithm == FFT_ALGO_MIXED_RADIX) {
+        algorithms[count++] = FFT_ALGO_MIXED_RADIX;
+    }
+    algorithms[count++] = FFT_ALGO_BLUESTEIN;
+    return count;
+}
+
+// Best round of one plan, in nanoseconds per transform; negative on failure
+static double tune_time(uint32_t size, fft_precision_t precision, fft_algorithm_t algorithm,
+                        fft_simd_t simd, const void *input, void *output) {
+    fft_plan_t *plan = NULL;
+    fft_plan_f32_t *plan_f32 = NULL;
+    if (precision == FFT_PRECISION_F32) {
+        plan_f32 = fft_plan_f32_create_as(size, FFT_FORWARD, algorithm, simd);
+        if (!plan_f32) return -1.0;
+    } else {
+        plan = fft_plan_create_as(size, FFT_FORWARD, algorithm, simd);
+        if (!plan) return -1.0;
+    }
+
+    uint32_t reps = FFT_TUNE_POINTS / size;
+    if (reps == 0) reps = 1;
+
+    double best = -1.0;
+    for (int round = 0; round <= FFT_TUNE_TRIALS; round++) {
+        uint64_t start = iq_profile_now();
+        for (uint32_t r = 0; r < reps; r++) {
+            if (plan_f32) {
+                fft_execute_f32(plan_f32, input, output);
+            } else {
+                fft_execute(plan, input, output);
+            }
+        }
+        double ns = (double)(iq_profile_now() - start) / (double)reps;
+        // Round 0 warms caches, scratch buffers and branch predictors
+        if (round > 0 && (best < 0.0 || ns < best)) best = ns;
+    }
+
+    fft_plan_f32_destroy(plan_f32);
+    fft_plan_destroy(plan);
+    return best;
+}
+
+bool fft_tune(uint32_t size, fft_precision_t precision, fft_tune_result_t *result) {
+    if (size < 2 || size > FFT_MAX_SIZE) {
+        return false;
+    }
+
+    size_t elem = precision == FFT_PRECISION_F32 ? sizeof(fft_complex_f32_t) : sizeof(fft_complex_t);
+    void *input = malloc(size * elem);
+    void *output = malloc(size * elem);
+    if (!input || !output) {
+        free(input);
+        free(output);
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        double re = sin(0.37 * (double)i) + 0.25 * cos(1.9 * (double)i);
+        double im = cos(0.11 * (double)i) - 0.5 * sin(2.3 * (double)i);
+        if (precision == FFT_PRECISION_F32) {
+            ((fft_complex_f32_t *)input)[i] = (float)re + (float)im * I;
+        } else {
+            ((fft_complex_t *)input)[i] = re + im * I;
+        }
+    }
+
+    fft_algorithm_t algorithms[4];
+    uint32_t num_algorithms = tune_algorithms(size, algorithms);
+    static const fft_simd_t families[] = {FFT_SIMD_NONE, FFT_SIMD_SSE2, FFT_SIMD_AVX2, FFT_SIMD_NEON};
+
+    fft_cost_t cost;
+    fft_query_cost(size, &cost);
+    fft_simd_t detected = fft_simd_detect();
+
+    fft_tune_result_t tuned;
+    memset(&tuned, 0, sizeof(tuned));
+    tuned.best.ns = -1.0;
+    tuned.default_ns = -1.0;
+
+    for (uint32_t a = 0; a < num_algorithms; a++) {
+        for (size_t f = 0; f < sizeof(families) / sizeof(families[0]); f++) {
+            if (!fft_simd_supported(families[f])) continue;
+            double ns = tune_time(size, precision, algorithms[a], families[f], input, output);
+            if (ns < 0.0) continue;
+
+            tuned.candidates++;
+            if (algorithms[a] == cost.algorithm && families[f] == detected) {
+                tuned.default_ns = ns;
+            }
+            if (tuned.best.ns < 0.0 || ns < tuned.best.ns) {
+                tuned.best.size = size;
+                tuned.best.precision = precision;
+                tuned.best.algorithm = algorithms[a];
+                tuned.best.simd = families[f];
+                tuned.best.ns = ns;
+            }
+        }
+    }
+
+    free(input);
+    free(output);
+
+    if (tuned.candidates == 0 || !fft_wisdom_record(&tuned.best)) {
+        return false;
+    }
+    if (result) {
+        *result = tuned;
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef IQ_FFT_TUNE_H
+#define IQ_FFT_TUNE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fft.h"
+
+/*
+ * FFT autotuning
+ * fft_tune() builds one forward plan for every schedule that can transform
+ * a size (codelet, radix-4 and mixed radix for powers of two; mixed radix
+ * and Bluestein for other smooth sizes; Bluestein otherwise) with every
+ * kernel family the CPU runs, times each on the same frame, and records the
+ * fastest as wisdom (fft.h). Plans created afterwards use it; plans already
+ * held in the plan cache keep their build until fft_plan_cache_clear().
+ *
+ * Each candidate gets one warm-up round, then the best of
+ * FFT_TUNE_TRIALS rounds of enough transforms to cover about
+ * FFT_TUNE_POINTS points, which keeps small sizes above timer resolution.
+ * Tuning a size costs a few milliseconds up to about a second at 2^20.
+ */
+#define FFT_TUNE_TRIALS 5
+#define FFT_TUNE_POINTS (1u << 18)
+
+typedef struct {
+    fft_wisdom_t best;          // Fastest candidate (recorded as wisdom)
+    double default_ns;          // Time of the fixed-rules choice (same measurement)
+    uint32_t candidates;        // Plans timed
+} fft_tune_result_t;
+
+// Time the candidates for one size and precision and record the winner
+bool fft_tune(uint32_t size, fft_precision_t precision, fft_tune_result_t *result);
+
+#endif // IQ_FFT_TUNE_H
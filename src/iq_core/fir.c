@@ -0,0 +1,427 @@
+#include "fir.h"
+#include "window.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FIR_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define FIR_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Overlap-save sizes tried: next power of two >= 2M, then up to this many doublings
+#define FIR_FFT_SIZE_STEPS 4
+
+// Direct-form kernels, chosen on first use
+enum {
+    FIR_SIMD_SCALAR,
+    FIR_SIMD_SSE2,
+    FIR_SIMD_AVX,
+    FIR_SIMD_NEON
+};
+
+static atomic_int fir_simd_active = -1;
+
+static int fir_simd_detect(void) {
+#if defined(FIR_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx")) return FIR_SIMD_AVX;
+    if (__builtin_cpu_supports("sse2")) return FIR_SIMD_SSE2;
+    return FIR_SIMD_SCALAR;
+#elif defined(FIR_HAVE_NEON)
+    return FIR_SIMD_NEON;
+#else
+    return FIR_SIMD_SCALAR;
+#endif
+}
+
+void fir_force_scalar(bool scalar) {
+    atomic_store(&fir_simd_active, scalar ? FIR_SIMD_SCALAR : fir_simd_detect());
+}
+
+uint32_t fir_kaiser_length(double transition, double stopband_db) {
+    if (transition <= 0.0) return 0;
+    double taps = ceil((stopband_db - 8.0) / (2.285 * 2.0 * M_PI * transition)) + 1.0;
+    return (taps < 3.0 ? 3 : (uint32_t)taps) | 1;
+}
+
+static double kaiser_beta(double stopband_db) {
+    if (stopband_db > 50.0) return 0.1102 * (stopband_db - 8.7);
+    if (stopband_db > 21.0) {
+        return 0.5842 * pow(stopband_db - 21.0, 0.4) + 0.07886 * (stopband_db - 21.0);
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Windowed sinc low-pass in double precision (no normalisation)
+ */
+static bool design_sinc(double *taps, uint32_t num_taps, double cutoff, double stopband_db) {
+    const window_t *window = window_acquire(WINDOW_KAISER, num_taps, kaiser_beta(stopband_db));
+    if (!window) return false;
+
+    double center = (num_taps - 1) / 2.0;
+    for (uint32_t i = 0; i < num_taps; i++) {
+        double x = i - center;
+        double tap = fabs(x) < 1e-10 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        taps[i] = tap * window->coefficients[i];
+    }
+    window_release(window);
+    return true;
+}
+
+bool fir_design_lowpass(float *taps, uint32_t num_taps, double cutoff, double stopband_db) {
+    if (!taps || num_taps == 0 || cutoff <= 0.0 || cutoff >= 0.5) return false;
+
+    double *design = (double *)malloc(num_taps * sizeof(double));
+    if (!design || !design_sinc(design, num_taps, cutoff, stopband_db)) {
+        free(design);
+        return false;
+    }
+    double sum = 0.0;
+    for (uint32_t i = 0; i < num_taps; i++) sum += design[i];
+    for (uint32_t i = 0; i < num_taps; i++) taps[i] = (float)(design[i] / sum);
+    free(design);
+    return true;
+}
+
+bool fir_design_bandpass(float *taps, uint32_t num_taps, double low, double high,
+                         double stopband_db) {
+    if (!taps || num_taps == 0 || low <= 0.0 || high <= low || high >= 0.5) return false;
+
+    double *upper = (double *)malloc(2 * (size_t)num_taps * sizeof(double));
+    if (!upper) return false;
+    double *lower = upper + num_taps;
+    if (!design_sinc(upper, num_taps, high, stopband_db) ||
+        !design_sinc(lower, num_taps, low, stopband_db)) {
+        free(upper);
+        return false;
+    }
+
+    // Difference of two low-passes, scaled to unit gain at the centre
+    double center = 0.5 * (low + high);
+    double complex gain = 0.0;
+    for (uint32_t i = 0; i < num_taps; i++) {
+        upper[i] -= lower[i];
+        gain += upper[i] * cexp(-I * 2.0 * M_PI * center * (double)i);
+    }
+    double scale = 1.0 / cabs(gain);
+    for (uint32_t i = 0; i < num_taps; i++) taps[i] = (float)(upper[i] * scale);
+    free(upper);
+    return true;
+}
+
+/**
+ * @brief Overlap-save size with the fewest flops per output frame
+ */
+static uint32_t best_fft_size(uint32_t num_taps, uint32_t channels, double *flops) {
+    uint32_t best = 0;
+    double best_flops = 0.0;
+    uint32_t size = fft_next_power_of_two(2 * num_taps);
+    for (int step = 0; step <= FIR_FFT_SIZE_STEPS && size <= FFT_MAX_SIZE; step++, size *= 2) {
+        fft_cost_t cost;
+        if (!fft_query_cost(size, &cost)) break;
+        // Forward and inverse transforms plus the spectrum product
+        double frames = (double)(size - num_taps + 1) * (channels == 1 ? 2.0 : 1.0);
+        double per_frame = (2.0 * cost.flops + 6.0 * size) / frames;
+        if (best == 0 || per_frame < best_flops) {
+            best = size;
+            best_flops = per_frame;
+        }
+    }
+    if (flops) *flops = best_flops;
+    return best;
+}
+
+double fir_estimate_flops(uint32_t num_taps, uint32_t channels, fir_method_t method) {
+    if (num_taps == 0 || channels == 0 || channels > FIR_MAX_CHANNELS) return 0.0;
+
+    double direct = 2.0 * num_taps * channels;
+    double fft = 0.0;
+    if (best_fft_size(num_taps, channels, &fft) == 0) fft = INFINITY;
+    switch (method) {
+        case FIR_METHOD_DIRECT: return direct;
+        case FIR_METHOD_FFT: return fft;
+        default: return direct < FIR_FFT_OVERHEAD * fft ? direct : FIR_FFT_OVERHEAD * fft;
+    }
+}
+
+static bool init_direct(fir_t *fir, const float *taps) {
+    const uint32_t channels = fir->channels;
+    const uint32_t group = FIR_LANES / channels;
+    fir->padded_taps = (fir->num_taps + group - 1) / group * group;
+
+    size_t window = (size_t)fir->padded_taps * channels;
+    fir->taps = (float *)calloc(window, sizeof(float));
+    fir->history = (float *)calloc(window - channels + (size_t)FIR_DIRECT_BLOCK * channels,
+                                   sizeof(float));
+    if (!fir->taps || !fir->history) return false;
+
+    // Window slot j holds x[n - (P - 1 - j)]: weight taps[P - 1 - j], zero
+    // past the real taps
+    const uint32_t pad = fir->padded_taps - fir->num_taps;
+    for (uint32_t j = pad; j < fir->padded_taps; j++) {
+        float tap = taps[fir->padded_taps - 1 - j];
+        for (uint32_t c = 0; c < channels; c++) fir->taps[(size_t)j * channels + c] = tap;
+    }
+    fir->latency = 0;
+    return true;
+}
+
+static bool init_fft(fir_t *fir, const float *taps) {
+    const uint32_t n = best_fft_size(fir->num_taps, fir->channels, NULL);
+    if (n == 0) return false;
+
+    const uint32_t block = n - fir->num_taps + 1;
+    fir->fft_size = n;
+    fir->block_frames = fir->channels == 1 ? 2 * block : block;
+    fir->latency = fir->block_frames;
+
+    fir->kernel = (fft_complex_f32_t *)calloc(n, sizeof(fft_complex_f32_t));
+    fir->frame = (fft_complex_f32_t *)calloc(n, sizeof(fft_complex_f32_t));
+    fir->spectrum = (fft_complex_f32_t *)calloc(n, sizeof(fft_complex_f32_t));
+    fir->pending = (float *)calloc((size_t)(fir->num_taps - 1 + fir->block_frames) * fir->channels,
+                                   sizeof(float));
+    fir->block_output = (float *)calloc((size_t)fir->block_frames * fir->channels, sizeof(float));
+    fir->forward = fft_plan_f32_acquire(n, FFT_FORWARD);
+    fir->inverse = fft_plan_f32_acquire(n, FFT_INVERSE);
+    if (!fir->kernel || !fir->frame || !fir->spectrum || !fir->pending || !fir->block_output ||
+        !fir->forward || !fir->inverse) {
+        return false;
+    }
+
+    // The inverse plan scales by 1 / N, so the plain kernel spectrum gives
+    // the circular convolution
+    for (uint32_t i = 0; i < fir->num_taps; i++) fir->frame[i] = taps[i];
+    return fft_execute_f32(fir->forward, fir->frame, fir->kernel);
+}
+
+bool fir_init(fir_t *fir, const float *taps, uint32_t num_taps, uint32_t channels,
+              fir_method_t method) {
+    if (!fir || !taps || num_taps == 0 || channels == 0 || channels > FIR_MAX_CHANNELS) {
+        return false;
+    }
+
+    memset(fir, 0, sizeof(*fir));
+    fir->channels = channels;
+    fir->num_taps = num_taps;
+
+    if (method == FIR_METHOD_AUTO) {
+        double direct = fir_estimate_flops(num_taps, channels, FIR_METHOD_DIRECT);
+        method = direct <= fir_estimate_flops(num_taps, channels, FIR_METHOD_AUTO)
+                     ? FIR_METHOD_DIRECT : FIR_METHOD_FFT;
+    }
+    fir->method = method;
+
+    bool ok = method == FIR_METHOD_FFT ? init_fft(fir, taps) : init_direct(fir, taps);
+    if (!ok) fir_free(fir);
+    return ok;
+}
+
+// FIR_LANES partial sums of taps[k] * x[k] over n floats (a multiple of
+// FIR_LANES); every kernel adds in the same lanes and order
+static void fir_dot_scalar(const float *taps, const float *x, size_t n, float *acc) {
+    for (int l = 0; l < FIR_LANES; l++) acc[l] = 0.0f;
+    for (size_t k = 0; k < n; k += FIR_LANES) {
+        for (int l = 0; l < FIR_LANES; l++) acc[l] += taps[k + l] * x[k + l];
+    }
+}
+
+#if defined(FIR_HAVE_X86_SIMD)
+__attribute__((target("sse2")))
+static void fir_dot_sse2(const float *taps, const float *x, size_t n, float *acc) {
+    __m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+    for (size_t k = 0; k < n; k += FIR_LANES) {
+        lo = _mm_add_ps(lo, _mm_mul_ps(_mm_loadu_ps(taps + k), _mm_loadu_ps(x + k)));
+        hi = _mm_add_ps(hi, _mm_mul_ps(_mm_loadu_ps(taps + k + 4), _mm_loadu_ps(x + k + 4)));
+    }
+    _mm_storeu_ps(acc, lo);
+    _mm_storeu_ps(acc + 4, hi);
+}
+
+__attribute__((target("avx")))
+static void fir_dot_avx(const float *taps, const float *x, size_t n, float *acc) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t k = 0; k < n; k += FIR_LANES) {
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(taps + k), _mm256_loadu_ps(x + k)));
+    }
+    _mm256_storeu_ps(acc, sum);
+}
+#endif /* FIR_HAVE_X86_SIMD */
+
+#if defined(FIR_HAVE_NEON)
+static void fir_dot_neon(const float *taps, const float *x, size_t n, float *acc) {
+    float32x4_t lo = vdupq_n_f32(0.0f), hi = vdupq_n_f32(0.0f);
+    for (size_t k = 0; k < n; k += FIR_LANES) {
+        lo = vaddq_f32(lo, vmulq_f32(vld1q_f32(taps + k), vld1q_f32(x + k)));
+        hi = vaddq_f32(hi, vmulq_f32(vld1q_f32(taps + k + 4), vld1q_f32(x + k + 4)));
+    }
+    vst1q_f32(acc, lo);
+    vst1q_f32(acc + 4, hi);
+}
+#endif /* FIR_HAVE_NEON */
+
+typedef void (*fir_dot_fn)(const float *, const float *, size_t, float *);
+
+static fir_dot_fn fir_select_dot(void) {
+    int simd = atomic_load(&fir_simd_active);
+    if (simd < 0) {
+        simd = fir_simd_detect();
+        atomic_store(&fir_simd_active, simd);
+    }
+    switch (simd) {
+#if defined(FIR_HAVE_X86_SIMD)
+        case FIR_SIMD_AVX:  return fir_dot_avx;
+        case FIR_SIMD_SSE2: return fir_dot_sse2;
+#endif
+#if defined(FIR_HAVE_NEON)
+        case FIR_SIMD_NEON: return fir_dot_neon;
+#endif
+        default: return fir_dot_scalar;
+    }
+}
+
+// Inputs are copied behind the delay line a run at a time rather than one
+// frame before each dot product, which would read back a store still in
+// flight on every output
+static void process_direct(fir_t *fir, const float *input, float *output, size_t count) {
+    const uint32_t channels = fir->channels;
+    const size_t window = (size_t)fir->padded_taps * channels;
+    const size_t history = window - channels;
+    const fir_dot_fn dot = fir_select_dot();
+    float acc[FIR_LANES];
+
+    while (count > 0) {
+        size_t run = count < FIR_DIRECT_BLOCK ? count : FIR_DIRECT_BLOCK;
+        memcpy(fir->history + history, input, run * channels * sizeof(float));
+
+        // Output n: the window of padded_taps frames ending at its input
+        for (size_t n = 0; n < run; n++) {
+            dot(fir->taps, fir->history + n * channels, window, acc);
+            if (channels == 1) {
+                output[n] = ((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+                            ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+            } else {
+                output[2 * n] = (acc[0] + acc[2]) + (acc[4] + acc[6]);
+                output[2 * n + 1] = (acc[1] + acc[3]) + (acc[5] + acc[7]);
+            }
+        }
+
+        memmove(fir->history, fir->history + run * channels, history * sizeof(float));
+        input += run * channels;
+        output += run * channels;
+        count -= run;
+    }
+}
+
+/**
+ * @brief Filter the complete block in pending
+ *
+ * IQ: pending is the transform input as is. Real: frame k carries
+ * pending[k] + j pending[L + k], so the two halves of the block come out
+ * of the real and imaginary parts (the taps are real).
+ */
+static void run_fft_block(fir_t *fir) {
+    const uint32_t n = fir->fft_size;
+    const uint32_t history = fir->num_taps - 1;
+    const uint32_t block = n - history;
+
+    if (fir->channels == 2) {
+        memcpy(fir->frame, fir->pending, n * sizeof(fft_complex_f32_t));
+    } else {
+        for (uint32_t k = 0; k < n; k++) {
+            fir->frame[k] = fir->pending[k] + I * fir->pending[block + k];
+        }
+    }
+
+    fft_execute_f32(fir->forward, fir->frame, fir->spectrum);
+    for (uint32_t k = 0; k < n; k++) fir->spectrum[k] *= fir->kernel[k];
+    fft_execute_f32(fir->inverse, fir->spectrum, fir->frame);
+
+    if (fir->channels == 2) {
+        memcpy(fir->block_output, fir->frame + history, block * sizeof(fft_complex_f32_t));
+    } else {
+        for (uint32_t k = 0; k < block; k++) {
+            fir->block_output[k] = crealf(fir->frame[history + k]);
+            fir->block_output[block + k] = cimagf(fir->frame[history + k]);
+        }
+    }
+
+    // The last M - 1 frames lead the next block
+    memmove(fir->pending, fir->pending + (size_t)fir->block_frames * fir->channels,
+            (size_t)history * fir->channels * sizeof(float));
+}
+
+static void process_fft(fir_t *fir, const float *input, float *output, size_t count) {
+    const uint32_t channels = fir->channels;
+    const size_t history = (size_t)(fir->num_taps - 1) * channels;
+
+    while (count > 0) {
+        size_t n = fir->block_frames - fir->fill;
+        if (n > count) n = count;
+        size_t floats = n * channels;
+        size_t offset = (size_t)fir->fill * channels;
+
+        // Take the inputs before handing out outputs: output may be input
+        memcpy(fir->pending + history + offset, input, floats * sizeof(float));
+        memcpy(output, fir->block_output + offset, floats * sizeof(float));
+        fir->fill += (uint32_t)n;
+        input += floats;
+        output += floats;
+        count -= n;
+
+        if (fir->fill == fir->block_frames) {
+            run_fft_block(fir);
+            fir->fill = 0;
+        }
+    }
+}
+
+void fir_process(fir_t *fir, const float *input, float *output, size_t count) {
+    if (!fir || !input || !output || count == 0) return;
+
+    if (fir->method == FIR_METHOD_FFT) {
+        process_fft(fir, input, output, count);
+    } else {
+        process_direct(fir, input, output, count);
+    }
+}
+
+void fir_reset(fir_t *fir) {
+    if (!fir) return;
+
+    if (fir->history) {
+        memset(fir->history, 0, (size_t)(fir->padded_taps - 1) * fir->channels * sizeof(float));
+    }
+    if (fir->pending) {
+        memset(fir->pending, 0, (size_t)(fir->num_taps - 1 + fir->block_frames) * fir->channels *
+                                    sizeof(float));
+        memset(fir->block_output, 0, (size_t)fir->block_frames * fir->channels * sizeof(float));
+    }
+    fir->fill = 0;
+}
+
+void fir_free(fir_t *fir) {
+    if (!fir) return;
+
+    free(fir->taps);
+    free(fir->history);
+    free(fir->kernel);
+    free(fir->frame);
+    free(fir->spectrum);
+    free(fir->pending);
+    free(fir->block_output);
+    if (fir->forward) fft_plan_f32_release(fir->forward);
+    if (fir->inverse) fft_plan_f32_release(fir->inverse);
+    memset(fir, 0, sizeof(*fir));
+}
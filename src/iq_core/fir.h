@@ -0,0 +1,103 @@
+#ifndef IQ_LAB_FIR_H
+#define IQ_LAB_FIR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "fft.h"
+
+/*
+ * FIR filter engine
+ *
+ * Filters real (1 channel) or interleaved IQ (2 channels) float streams
+ * with real taps, one output per input. Two methods share the interface:
+ *
+ *   direct form   inputs staged in runs of FIR_DIRECT_BLOCK behind the
+ *                 delay line, one dot product per output, for short
+ *                 filters; SSE2 / AVX / NEON kernels with the same
+ *                 FIR_LANES partial sums as the scalar one (bit-identical)
+ *   overlap-save  blocks of L = N - M + 1 frames through an N-point float
+ *                 FFT against the precomputed kernel spectrum, for long
+ *                 ones; a real stream packs two consecutive blocks into the
+ *                 real and imaginary parts of one transform
+ *
+ * FIR_METHOD_AUTO picks the one with the smaller operation count per
+ * output (fir_estimate_flops). Overlap-save emits a block once it is
+ * complete, so its outputs lag by fir_t.latency frames (one block; 0 in
+ * direct form): output n is y[n - latency]. Any block split of the input
+ * gives the same outputs.
+ */
+
+#define FIR_MAX_CHANNELS 2
+#define FIR_LANES 8                  // Direct-form partial sums, every kernel
+#define FIR_DIRECT_BLOCK 512         // Direct-form frames staged per pass
+#define FIR_DEFAULT_STOPBAND_DB 60.0
+#define FIR_FFT_OVERHEAD 2.0         // Direct-form flops per FFT flop at equal time (measured)
+
+// Filtering method
+typedef enum {
+    FIR_METHOD_AUTO,                 // Cheaper of the two for the tap count
+    FIR_METHOD_DIRECT,
+    FIR_METHOD_FFT
+} fir_method_t;
+
+// Filter state
+typedef struct {
+    uint32_t channels;               // 1: real samples, 2: interleaved IQ
+    uint32_t num_taps;               // M
+    fir_method_t method;             // FIR_METHOD_DIRECT or FIR_METHOD_FFT
+    uint32_t latency;                // Output lag on top of the filter's own delay (frames)
+
+    // Direct form
+    uint32_t padded_taps;            // M rounded up so a window is whole FIR_LANES groups
+    float *taps;                     // Oldest-first, zero-padded, repeated per channel
+    float *history;                  // padded_taps - 1 frames, then the staged run
+
+    // Overlap-save
+    uint32_t fft_size;               // N (power of two)
+    uint32_t block_frames;           // Frames per transform: L, or 2L for a real stream
+    const fft_plan_f32_t *forward;   // Shared plans (fft_plan_f32_acquire)
+    const fft_plan_f32_t *inverse;
+    fft_complex_f32_t *kernel;       // FFT of the zero-padded taps
+    fft_complex_f32_t *frame;        // Transform input, then inverse output
+    fft_complex_f32_t *spectrum;
+    float *pending;                  // M - 1 frames of history, then the current block
+    float *block_output;             // Outputs of the last complete block
+    uint32_t fill;                   // Frames of the current block received
+} fir_t;
+
+// Kaiser low-pass length for stopband_db over a transition width
+// (cycles/sample); always odd, so the group delay is a whole sample
+uint32_t fir_kaiser_length(double transition, double stopband_db);
+
+// Kaiser-windowed sinc low-pass with unit DC gain; cutoff (cycles/sample)
+// is the -6 dB point, the middle of the transition band
+bool fir_design_lowpass(float *taps, uint32_t num_taps, double cutoff, double stopband_db);
+
+// Kaiser-windowed band-pass from low to high (cycles/sample, -6 dB edges)
+// with unit gain at the band centre
+bool fir_design_bandpass(float *taps, uint32_t num_taps, double low, double high,
+                         double stopband_db);
+
+// Estimated floating-point operations per output frame; FIR_METHOD_AUTO
+// gives the smaller of the two (the FFT count weighted by FIR_FFT_OVERHEAD)
+double fir_estimate_flops(uint32_t num_taps, uint32_t channels, fir_method_t method);
+
+// Create a filter for 1 or 2 channels (taps are copied)
+bool fir_init(fir_t *fir, const float *taps, uint32_t num_taps, uint32_t channels,
+              fir_method_t method);
+
+// Filter count frames (channels floats each); output may be input
+void fir_process(fir_t *fir, const float *input, float *output, size_t count);
+
+// Clear the delay line (and any partial block)
+void fir_reset(fir_t *fir);
+
+// Free the filter
+void fir_free(fir_t *fir);
+
+// Use the portable direct-form kernel only (benchmarks and tests)
+void fir_force_scalar(bool scalar);
+
+#endif // IQ_LAB_FIR_H
@@ -0,0 +1,708 @@
+/*
+ * IQ Lab - OpenCL Compute Backend
+ *
+ * The OpenCL 1.2 entry points used here are declared locally and resolved
+ * from the ICD loader (libOpenCL / OpenCL.dll) at gpu_open(), so the build
+ * needs no vendor SDK. One program holds every kernel:
+ *
+ *   iq_stage_*     window and scale frames out of the uploaded sample span
+ *   iq_fft_pass    one radix-2 Stockham pass over every frame of a chunk
+ *   iq_power_rows  fftshift and |X|^2 (or dB) into rows
+ *   iq_cfar_mean   CA/GO/SO threshold of every cell, summed over its
+ *                  training cells directly (no float prefix sums)
+ *
+ * Three in-order queues split each chunk into upload, compute and
+ * download; events chain chunk i's stages and keep a buffer set from being
+ * refilled before chunk i - 2 has finished with it.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "gpu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#ifdef IQ_WITH_OPENCL
+
+#ifdef _WIN32
+#include <windows.h>
+#define IQ_CL_CALL __stdcall
+#else
+#include <dlfcn.h>
+#define IQ_CL_CALL
+#endif
+
+// OpenCL 1.2 types and constants (cl.h)
+typedef int32_t cl_int;
+typedef uint32_t cl_uint;
+typedef uint64_t cl_ulong;
+typedef cl_uint cl_bool;
+typedef cl_ulong cl_bitfield;
+typedef cl_bitfield cl_device_type;
+typedef cl_bitfield cl_mem_flags;
+typedef cl_bitfield cl_command_queue_properties;
+typedef cl_uint cl_device_info;
+typedef cl_uint cl_program_build_info;
+typedef intptr_t cl_context_properties;
+typedef struct _cl_platform_id *cl_platform_id;
+typedef struct _cl_device_id *cl_device_id;
+typedef struct _cl_context *cl_context;
+typedef struct _cl_command_queue *cl_command_queue;
+typedef struct _cl_mem *cl_mem;
+typedef struct _cl_program *cl_program;
+typedef struct _cl_kernel *cl_kernel;
+typedef struct _cl_event *cl_event;
+
+#define CL_SUCCESS 0
+#define CL_FALSE 0
+#define CL_DEVICE_TYPE_GPU (1u << 2)
+#define CL_DEVICE_TYPE_ACCELERATOR (1u << 3)
+#define CL_DEVICE_NAME 0x102B
+#define CL_CONTEXT_PLATFORM 0x1084
+#define CL_MEM_READ_WRITE (1u << 0)
+#define CL_MEM_WRITE_ONLY (1u << 1)
+#define CL_MEM_READ_ONLY (1u << 2)
+#define CL_PROGRAM_BUILD_LOG 0x1183
+
+#define GPU_MAX_PLATFORMS 16
+#define GPU_MAX_DEVICES 16
+
+typedef struct {
+    void *library;
+    cl_int (IQ_CL_CALL *GetPlatformIDs)(cl_uint, cl_platform_id *, cl_uint *);
+    cl_int (IQ_CL_CALL *GetDeviceIDs)(cl_platform_id, cl_device_type, cl_uint, cl_device_id *, cl_uint *);
+    cl_int (IQ_CL_CALL *GetDeviceInfo)(cl_device_id, cl_device_info, size_t, void *, size_t *);
+    cl_context (IQ_CL_CALL *CreateContext)(const cl_context_properties *, cl_uint, const cl_device_id *,
+                                           void (IQ_CL_CALL *)(const char *, const void *, size_t, void *),
+                                           void *, cl_int *);
+    cl_command_queue (IQ_CL_CALL *CreateCommandQueue)(cl_context, cl_device_id, cl_command_queue_properties, cl_int *);
+    cl_program (IQ_CL_CALL *CreateProgramWithSource)(cl_context, cl_uint, const char **, const size_t *, cl_int *);
+    cl_int (IQ_CL_CALL *BuildProgram)(cl_program, cl_uint, const cl_device_id *, const char *,
+                                      void (IQ_CL_CALL *)(cl_program, void *), void *);
+    cl_int (IQ_CL_CALL *GetProgramBuildInfo)(cl_program, cl_device_id, cl_program_build_info, size_t, void *, size_t *);
+    cl_kernel (IQ_CL_CALL *CreateKernel)(cl_program, const char *, cl_int *);
+    cl_int (IQ_CL_CALL *SetKernelArg)(cl_kernel, cl_uint, size_t, const void *);
+    cl_mem (IQ_CL_CALL *CreateBuffer)(cl_context, cl_mem_flags, size_t, void *, cl_int *);
+    cl_int (IQ_CL_CALL *EnqueueWriteBuffer)(cl_command_queue, cl_mem, cl_bool, size_t, size_t, const void *,
+                                            cl_uint, const cl_event *, cl_event *);
+    cl_int (IQ_CL_CALL *EnqueueReadBuffer)(cl_command_queue, cl_mem, cl_bool, size_t, size_t, void *,
+                                           cl_uint, const cl_event *, cl_event *);
+    cl_int (IQ_CL_CALL *EnqueueNDRangeKernel)(cl_command_queue, cl_kernel, cl_uint, const size_t *, const size_t *,
+                                              const size_t *, cl_uint, const cl_event *, cl_event *);
+    cl_int (IQ_CL_CALL *Flush)(cl_command_queue);
+    cl_int (IQ_CL_CALL *Finish)(cl_command_queue);
+    cl_int (IQ_CL_CALL *ReleaseEvent)(cl_event);
+    cl_int (IQ_CL_CALL *ReleaseMemObject)(cl_mem);
+    cl_int (IQ_CL_CALL *ReleaseKernel)(cl_kernel);
+    cl_int (IQ_CL_CALL *ReleaseProgram)(cl_program);
+    cl_int (IQ_CL_CALL *ReleaseCommandQueue)(cl_command_queue);
+    cl_int (IQ_CL_CALL *ReleaseContext)(cl_context);
+} gpu_cl_api_t;
+
+struct gpu_context {
+    gpu_cl_api_t cl;
+    cl_device_id device;
+    cl_context context;
+    cl_command_queue upload;     // Host -> device sample spans
+    cl_command_queue compute;    // Kernels
+    cl_command_queue download;   // Device -> host rows and thresholds
+    cl_program program;
+    char name[256];
+};
+
+// One chunk's device buffers; two sets alternate
+typedef struct {
+    cl_mem samples;              // Sample span of the chunk
+    cl_mem rows;                 // chunk_frames * N floats
+    cl_mem thresholds;           // Same, CFAR only
+    cl_event consumed;           // Staging done reading 'samples'
+    cl_event drained;            // Download of rows/thresholds done
+} gpu_stft_set_t;
+
+struct gpu_stft {
+    gpu_context_t *gpu;
+    uint32_t fft_size;
+    uint32_t log2_size;
+    gpu_samples_t samples;
+    size_t sample_bytes;         // Per complex sample
+    uint32_t chunk_frames;
+    size_t span_capacity;        // Bytes each 'samples' buffer holds
+    cl_mem window;               // N taps (ones when rectangular)
+    cl_mem twiddle;              // exp(-2 pi i m / N), m < N/2
+    cl_mem alpha;                // CFAR multipliers
+    cl_mem work[2];              // Ping-pong spectra, chunk_frames * N complex;
+                                 // shared, since only the in-order compute queue uses them
+    cl_kernel stage, pass, power, cfar;
+    bool cfar_enabled;
+    uint32_t ref_cells, guard_cells, cfar_mode;
+    gpu_stft_set_t sets[2];
+};
+
+static const char *const gpu_kernel_source =
+    "__kernel void iq_stage_f32(__global const float2 *in, __global const float *window,\n"
+    "                           uint n, uint hop, __global float2 *out) {\n"
+    "    size_t gid = get_global_id(0);\n"
+    "    size_t frame = gid / n;\n"
+    "    uint i = (uint)(gid - frame * n);\n"
+    "    out[gid] = in[frame * hop + i] * window[i];\n"
+    "}\n"
+    "__kernel void iq_stage_s16(__global const short2 *in, __global const float *window,\n"
+    "                           uint n, uint hop, __global float2 *out) {\n"
+    "    size_t gid = get_global_id(0);\n"
+    "    size_t frame = gid / n;\n"
+    "    uint i = (uint)(gid - frame * n);\n"
+    "    out[gid] = convert_float2(in[frame * hop + i]) * (window[i] * (1.0f / 32768.0f));\n"
+    "}\n"
+    "__kernel void iq_stage_s8(__global const char2 *in, __global const float *window,\n"
+    "                          uint n, uint hop, __global float2 *out) {\n"
+    "    size_t gid = get_global_id(0);\n"
+    "    size_t frame = gid / n;\n"
+    "    uint i = (uint)(gid - frame * n);\n"
+    "    out[gid] = convert_float2(in[frame * hop + i]) * (window[i] * (1.0f / 128.0f));\n"
+    "}\n"
+    "__kernel void iq_fft_pass(__global const float2 *in, __global float2 *out,\n"
+    "                          __global const float2 *twiddle, uint n, uint ns) {\n"
+    "    size_t gid = get_global_id(0);\n"
+    "    uint mid = n >> 1;\n"
+    "    size_t frame = gid / mid;\n"
+    "    uint j = (uint)(gid - frame * mid);\n"
+    "    __global const float2 *x = in + frame * n;\n"
+    "    __global float2 *y = out + frame * n;\n"
+    "    uint k = j & (ns - 1);\n"
+    "    float2 a = x[j];\n"
+    "    float2 b = x[j + mid];\n"
+    "    float2 w = twiddle[k * (mid / ns)];\n"
+    "    float2 t = (float2)(b.x * w.x - b.y * w.y, b.x * w.y + b.y * w.x);\n"
+    "    uint d = ((j - k) << 1) + k;\n"
+    "    y[d] = a + t;\n"
+    "    y[d + ns] = a - t;\n"
+    "}\n"
+    "__kernel void iq_power_rows(__global const float2 *spectra, uint n, uint db,\n"
+    "                            __global float *rows) {\n"
+    "    size_t gid = get_global_id(0);\n"
+    "    size_t frame = gid / n;\n"
+    "    uint i = (uint)(gid - frame * n);\n"
+    "    uint mid = n >> 1;\n"
+    "    float2 x = spectra[frame * n + (i < mid ? i + mid : i - mid)];\n"
+    "    float p = x.x * x.x + x.y * x.y;\n"
+    "    rows[gid] = db ? 10.0f * log10(p + 1e-12f) : p;\n"
+    "}\n"
+    "__kernel void iq_cfar_mean(__global const float *rows, __global const float *alpha,\n"
+    "                           uint n, uint ref, uint guard, uint mode,\n"
+    "                           __global float *thresholds) {\n"
+    "    size_t gid = get_global_id(0);\n"
+    "    size_t frame = gid / n;\n"
+    "    int cut = (int)(gid - frame * n);\n"
+    "    __global const float *row = rows + frame * n;\n"
+    "    int left_lo = max(cut - (int)guard - (int)ref, 0);\n"
+    "    int left_hi = cut - (int)guard - 1;\n"
+    "    int right_lo = cut + (int)guard + 1;\n"
+    "    int right_hi = min(cut + (int)guard + (int)ref, (int)n - 1);\n"
+    "    float left_sum = 0.0f, right_sum = 0.0f;\n"
+    "    uint left_n = 0, right_n = 0;\n"
+    "    for (int b = left_lo; b <= left_hi; b++, left_n++) left_sum += row[b];\n"
+    "    for (int b = right_lo; b <= right_hi; b++, right_n++) right_sum += row[b];\n"
+    "    float t;\n"
+    "    if (mode == 0 || left_n == 0 || right_n == 0) {\n"
+    "        uint count = left_n + right_n;\n"
+    "        t = count ? alpha[count] * (left_sum + right_sum) / (float)count : 0.0f;\n"
+    "    } else {\n"
+    "        float l = alpha[left_n] * left_sum / (float)left_n;\n"
+    "        float r = alpha[right_n] * right_sum / (float)right_n;\n"
+    "        t = mode == 1 ? fmax(l, r) : fmin(l, r);\n"
+    "    }\n"
+    "    thresholds[gid] = t;\n"
+    "}\n";
+
+static void *gpu_symbol(void *library, const char *name) {
+#ifdef _WIN32
+    FARPROC proc = GetProcAddress((HMODULE)library, name);
+    void *sym;
+    memcpy(&sym, &proc, sizeof(sym));
+    return sym;
+#else
+    return dlsym(library, name);
+#endif
+}
+
+static void gpu_unload_api(gpu_cl_api_t *cl) {
+    if (!cl->library) return;
+#ifdef _WIN32
+    FreeLibrary((HMODULE)cl->library);
+#else
+    dlclose(cl->library);
+#endif
+    cl->library = NULL;
+}
+
+// Function pointers are filled through memcpy: ISO C has no void * to
+// function pointer conversion
+#define GPU_CL_LOAD(member) do { \
+        void *sym = gpu_symbol(cl->library, "cl" #member); \
+        if (!sym) return false; \
+        memcpy(&cl->member, &sym, sizeof(sym)); \
+    } while (0)
+
+static bool gpu_load_api(gpu_cl_api_t *cl) {
+#ifdef _WIN32
+    cl->library = (void *)LoadLibraryA("OpenCL.dll");
+#elif defined(__APPLE__)
+    cl->library = dlopen("/System/Library/Frameworks/OpenCL.framework/OpenCL", RTLD_NOW | RTLD_LOCAL);
+#else
+    cl->library = dlopen("libOpenCL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!cl->library) cl->library = dlopen("libOpenCL.so", RTLD_NOW | RTLD_LOCAL);
+#endif
+    if (!cl->library) return false;
+
+    GPU_CL_LOAD(GetPlatformIDs);
+    GPU_CL_LOAD(GetDeviceIDs);
+    GPU_CL_LOAD(GetDeviceInfo);
+    GPU_CL_LOAD(CreateContext);
+    GPU_CL_LOAD(CreateCommandQueue);
+    GPU_CL_LOAD(CreateProgramWithSource);
+    GPU_CL_LOAD(BuildProgram);
+    GPU_CL_LOAD(GetProgramBuildInfo);
+    GPU_CL_LOAD(CreateKernel);
+    GPU_CL_LOAD(SetKernelArg);
+    GPU_CL_LOAD(CreateBuffer);
+    GPU_CL_LOAD(EnqueueWriteBuffer);
+    GPU_CL_LOAD(EnqueueReadBuffer);
+    GPU_CL_LOAD(EnqueueNDRangeKernel);
+    GPU_CL_LOAD(Flush);
+    GPU_CL_LOAD(Finish);
+    GPU_CL_LOAD(ReleaseEvent);
+    GPU_CL_LOAD(ReleaseMemObject);
+    GPU_CL_LOAD(ReleaseKernel);
+    GPU_CL_LOAD(ReleaseProgram);
+    GPU_CL_LOAD(ReleaseCommandQueue);
+    GPU_CL_LOAD(ReleaseContext);
+    return true;
+}
+
+bool gpu_compiled(void) {
+    return true;
+}
+
+// First GPU/accelerator device of any platform whose name contains 'match'
+static bool gpu_pick_device(gpu_context_t *gpu, const char *match, cl_platform_id *platform) {
+    gpu_cl_api_t *cl = &gpu->cl;
+    cl_platform_id platforms[GPU_MAX_PLATFORMS];
+    cl_uint num_platforms = 0;
+    if (cl->GetPlatformIDs(GPU_MAX_PLATFORMS, platforms, &num_platforms) != CL_SUCCESS || num_platforms == 0) {
+        fprintf(stderr, "GPU: no OpenCL platform installed\n");
+        return false;
+    }
+    if (num_platforms > GPU_MAX_PLATFORMS) num_platforms = GPU_MAX_PLATFORMS;
+
+    for (cl_uint p = 0; p < num_platforms; p++) {
+        cl_device_id devices[GPU_MAX_DEVICES];
+        cl_uint num_devices = 0;
+        if (cl->GetDeviceIDs(platforms[p], CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_ACCELERATOR,
+                             GPU_MAX_DEVICES, devices, &num_devices) != CL_SUCCESS) {
+            continue;
+        }
+        if (num_devices > GPU_MAX_DEVICES) num_devices = GPU_MAX_DEVICES;
+        for (cl_uint d = 0; d < num_devices; d++) {
+            char name[sizeof(gpu->name)] = {0};
+            if (cl->GetDeviceInfo(devices[d], CL_DEVICE_NAME, sizeof(name) - 1, name, NULL) != CL_SUCCESS) {
+                continue;
+            }
+            if (match && match[0] && !strstr(name, match)) continue;
+            gpu->device = devices[d];
+            memcpy(gpu->name, name, sizeof(name));
+            *platform = platforms[p];
+            return true;
+        }
+    }
+    fprintf(stderr, "GPU: no OpenCL GPU device%s%s found\n",
+            match && match[0] ? " matching " : "", match && match[0] ? match : "");
+    return false;
+}
+
+gpu_context_t *gpu_open(const char *match) {
+    gpu_context_t *gpu = calloc(1, sizeof(gpu_context_t));
+    if (!gpu) return NULL;
+    gpu_cl_api_t *cl = &gpu->cl;
+
+    if (!gpu_load_api(cl)) {
+        fprintf(stderr, "GPU: no OpenCL runtime found\n");
+        gpu_close(gpu);
+        return NULL;
+    }
+
+    cl_platform_id platform;
+    if (!gpu_pick_device(gpu, match, &platform)) {
+        gpu_close(gpu);
+        return NULL;
+    }
+
+    cl_int err = CL_SUCCESS;
+    const cl_context_properties properties[3] = { CL_CONTEXT_PLATFORM, (cl_context_properties)platform, 0 };
+    gpu->context = cl->CreateContext(properties, 1, &gpu->device, NULL, NULL, &err);
+    if (err == CL_SUCCESS) gpu->upload = cl->CreateCommandQueue(gpu->context, gpu->device, 0, &err);
+    if (err == CL_SUCCESS) gpu->compute = cl->CreateCommandQueue(gpu->context, gpu->device, 0, &err);
+    if (err == CL_SUCCESS) gpu->download = cl->CreateCommandQueue(gpu->context, gpu->device, 0, &err);
+    if (err != CL_SUCCESS) {
+        fprintf(stderr, "GPU: failed to set up %s (OpenCL error %d)\n", gpu->name, (int)err);
+        gpu_close(gpu);
+        return NULL;
+    }
+
+    const char *source = gpu_kernel_source;
+    gpu->program = cl->CreateProgramWithSource(gpu->context, 1, &source, NULL, &err);
+    if (err == CL_SUCCESS) err = cl->BuildProgram(gpu->program, 1, &gpu->device, "", NULL, NULL);
+    if (err != CL_SUCCESS) {
+        char log[2048] = {0};
+        if (gpu->program) {
+            cl->GetProgramBuildInfo(gpu->program, gpu->device, CL_PROGRAM_BUILD_LOG, sizeof(log) - 1, log, NULL);
+        }
+        fprintf(stderr, "GPU: kernel build failed on %s (OpenCL error %d)\n%s\n", gpu->name, (int)err, log);
+        gpu_close(gpu);
+        return NULL;
+    }
+    return gpu;
+}
+
+void gpu_close(gpu_context_t *gpu) {
+    if (!gpu) return;
+    gpu_cl_api_t *cl = &gpu->cl;
+    if (gpu->program) cl->ReleaseProgram(gpu->program);
+    if (gpu->download) cl->ReleaseCommandQueue(gpu->download);
+    if (gpu->compute) cl->ReleaseCommandQueue(gpu->compute);
+    if (gpu->upload) cl->ReleaseCommandQueue(gpu->upload);
+    if (gpu->context) cl->ReleaseContext(gpu->context);
+    gpu_unload_api(cl);
+    free(gpu);
+}
+
+const char *gpu_device_name(const gpu_context_t *gpu) {
+    return gpu ? gpu->name : "none";
+}
+
+static cl_mem gpu_buffer(gpu_context_t *gpu, cl_mem_flags flags, size_t bytes) {
+    cl_int err = CL_SUCCESS;
+    cl_mem mem = gpu->cl.CreateBuffer(gpu->context, flags, bytes, NULL, &err);
+    return err == CL_SUCCESS ? mem : NULL;
+}
+
+static void gpu_release_mem(gpu_context_t *gpu, cl_mem *mem) {
+    if (*mem) gpu->cl.ReleaseMemObject(*mem);
+    *mem = NULL;
+}
+
+static void gpu_release_event(gpu_context_t *gpu, cl_event *event) {
+    if (*event) gpu->cl.ReleaseEvent(*event);
+    *event = NULL;
+}
+
+// Blocking upload of a constant table
+static bool gpu_upload_table(gpu_context_t *gpu, cl_mem mem, const void *data, size_t bytes) {
+    return gpu->cl.EnqueueWriteBuffer(gpu->upload, mem, 1, 0, bytes, data, 0, NULL, NULL) == CL_SUCCESS;
+}
+
+gpu_stft_t *gpu_stft_create(gpu_context_t *gpu, uint32_t fft_size, const float *window,
+                            gpu_samples_t samples) {
+    if (!gpu) return NULL;
+    if (fft_size < 2 || fft_size > GPU_STFT_MAX_SIZE || (fft_size & (fft_size - 1)) != 0) {
+        fprintf(stderr, "GPU: FFT size %u is not a power of two up to %u\n", fft_size, GPU_STFT_MAX_SIZE);
+        return NULL;
+    }
+    if (samples != GPU_SAMPLES_F32 && samples != GPU_SAMPLES_S16 && samples != GPU_SAMPLES_S8) {
+        return NULL;
+    }
+
+    gpu_stft_t *stft = calloc(1, sizeof(gpu_stft_t));
+    float *taps = malloc((size_t)fft_size * sizeof(float));
+    float *twiddle = malloc((size_t)fft_size * sizeof(float));
+    if (!stft || !taps || !twiddle) {
+        free(stft);
+        free(taps);
+        free(twiddle);
+        return NULL;
+    }
+    stft->gpu = gpu;
+    stft->fft_size = fft_size;
+    while ((1u << stft->log2_size) < fft_size) stft->log2_size++;
+    stft->samples = samples;
+    stft->sample_bytes = samples == GPU_SAMPLES_F32 ? 8 : samples == GPU_SAMPLES_S16 ? 4 : 2;
+    stft->chunk_frames = fft_size >= GPU_STFT_CHUNK_BINS ? 1 : GPU_STFT_CHUNK_BINS / fft_size;
+
+    for (uint32_t i = 0; i < fft_size; i++) taps[i] = window ? window[i] : 1.0f;
+    for (uint32_t m = 0; m < fft_size / 2; m++) {
+        double angle = -2.0 * M_PI * (double)m / (double)fft_size;
+        twiddle[2 * m] = (float)cos(angle);
+        twiddle[2 * m + 1] = (float)sin(angle);
+    }
+
+    const char *stage_name = samples == GPU_SAMPLES_F32 ? "iq_stage_f32" :
+                             samples == GPU_SAMPLES_S16 ? "iq_stage_s16" : "iq_stage_s8";
+    cl_int e1 = CL_SUCCESS, e2 = CL_SUCCESS, e3 = CL_SUCCESS, e4 = CL_SUCCESS;
+    stft->stage = gpu->cl.CreateKernel(gpu->program, stage_name, &e1);
+    stft->pass = gpu->cl.CreateKernel(gpu->program, "iq_fft_pass", &e2);
+    stft->power = gpu->cl.CreateKernel(gpu->program, "iq_power_rows", &e3);
+    stft->cfar = gpu->cl.CreateKernel(gpu->program, "iq_cfar_mean", &e4);
+
+    size_t frame_bins = (size_t)stft->chunk_frames * fft_size;
+    stft->window = gpu_buffer(gpu, CL_MEM_READ_ONLY, (size_t)fft_size * sizeof(float));
+    stft->twiddle = gpu_buffer(gpu, CL_MEM_READ_ONLY, (size_t)fft_size * sizeof(float));
+    bool ok = e1 == CL_SUCCESS && e2 == CL_SUCCESS && e3 == CL_SUCCESS && e4 == CL_SUCCESS &&
+              stft->window && stft->twiddle;
+    stft->work[0] = gpu_buffer(gpu, CL_MEM_READ_WRITE, frame_bins * 8);
+    stft->work[1] = gpu_buffer(gpu, CL_MEM_READ_WRITE, frame_bins * 8);
+    ok = ok && stft->work[0] && stft->work[1];
+    for (int s = 0; ok && s < 2; s++) {
+        stft->sets[s].rows = gpu_buffer(gpu, CL_MEM_READ_WRITE, frame_bins * sizeof(float));
+        ok = stft->sets[s].rows != NULL;
+    }
+    ok = ok && gpu_upload_table(gpu, stft->window, taps, (size_t)fft_size * sizeof(float)) &&
+         gpu_upload_table(gpu, stft->twiddle, twiddle, (size_t)fft_size * sizeof(float));
+    free(taps);
+    free(twiddle);
+    if (!ok) {
+        fprintf(stderr, "GPU: not enough device memory for %u-point STFT chunks\n", fft_size);
+        gpu_stft_destroy(stft);
+        return NULL;
+    }
+    return stft;
+}
+
+bool gpu_stft_set_cfar(gpu_stft_t *stft, uint32_t ref_cells, uint32_t guard_cells,
+                       uint32_t mode, const double *alpha) {
+    if (!stft || !alpha || mode > 2 || ref_cells == 0) return false;
+    gpu_context_t *gpu = stft->gpu;
+
+    size_t count = 2 * (size_t)ref_cells + 1;
+    float *table = malloc(count * sizeof(float));
+    if (!table) return false;
+    for (size_t n = 0; n < count; n++) table[n] = (float)alpha[n];
+
+    gpu_release_mem(gpu, &stft->alpha);
+    stft->alpha = gpu_buffer(gpu, CL_MEM_READ_ONLY, count * sizeof(float));
+    bool ok = stft->alpha && gpu_upload_table(gpu, stft->alpha, table, count * sizeof(float));
+    free(table);
+
+    size_t frame_bins = (size_t)stft->chunk_frames * stft->fft_size;
+    for (int s = 0; ok && s < 2; s++) {
+        if (!stft->sets[s].thresholds) {
+            stft->sets[s].thresholds = gpu_buffer(gpu, CL_MEM_WRITE_ONLY, frame_bins * sizeof(float));
+        }
+        ok = stft->sets[s].thresholds != NULL;
+    }
+    stft->cfar_enabled = ok;
+    stft->ref_cells = ref_cells;
+    stft->guard_cells = guard_cells;
+    stft->cfar_mode = mode;
+    return ok;
+}
+
+// Wait for everything queued and drop the chunk events
+static void gpu_stft_drain(gpu_stft_t *stft) {
+    gpu_context_t *gpu = stft->gpu;
+    gpu->cl.Finish(gpu->upload);
+    gpu->cl.Finish(gpu->compute);
+    gpu->cl.Finish(gpu->download);
+    for (int s = 0; s < 2; s++) {
+        gpu_release_event(gpu, &stft->sets[s].consumed);
+        gpu_release_event(gpu, &stft->sets[s].drained);
+    }
+}
+
+// Kernel over 'items' work items; 'waits' may be empty
+static bool gpu_run(gpu_stft_t *stft, cl_kernel kernel, size_t items,
+                    cl_uint num_waits, const cl_event *waits, cl_event *done) {
+    return stft->gpu->cl.EnqueueNDRangeKernel(stft->gpu->compute, kernel, 1, NULL, &items, NULL,
+                                              num_waits, num_waits ? waits : NULL, done) == CL_SUCCESS;
+}
+
+#define GPU_ARG(kernel, index, value) \
+    (stft->gpu->cl.SetKernelArg((kernel), (index), sizeof(value), &(value)) == CL_SUCCESS)
+
+// Queue one chunk on buffer set 's': upload, stage, passes, rows, thresholds, download
+static bool gpu_stft_chunk(gpu_stft_t *stft, gpu_stft_set_t *set, const uint8_t *span, size_t span_bytes,
+                           uint32_t frames, cl_uint hop, bool db, float *rows, float *thresholds) {
+    gpu_context_t *gpu = stft->gpu;
+    gpu_cl_api_t *cl = &gpu->cl;
+    const cl_uint n = stft->fft_size;
+    const size_t bins = (size_t)frames * n;
+
+    // Upload once the chunk two back has been staged out of this buffer
+    cl_event uploaded = NULL;
+    cl_event prior = set->consumed;
+    bool ok = cl->EnqueueWriteBuffer(gpu->upload, set->samples, CL_FALSE, 0, span_bytes, span,
+                                     prior ? 1 : 0, prior ? &prior : NULL, &uploaded) == CL_SUCCESS;
+    gpu_release_event(gpu, &set->consumed);
+    if (!ok) return false;
+    cl->Flush(gpu->upload);
+
+    // Staging waits for the upload and for the download of the chunk two back
+    cl_event waits[2] = { uploaded, set->drained };
+    ok = GPU_ARG(stft->stage, 0, set->samples) && GPU_ARG(stft->stage, 1, stft->window) &&
+         GPU_ARG(stft->stage, 2, n) && GPU_ARG(stft->stage, 3, hop) &&
+         GPU_ARG(stft->stage, 4, stft->work[0]) &&
+         gpu_run(stft, stft->stage, bins, set->drained ? 2 : 1, waits, &set->consumed);
+    gpu_release_event(gpu, &uploaded);
+    gpu_release_event(gpu, &set->drained);
+
+    for (uint32_t p = 0; ok && p < stft->log2_size; p++) {
+        cl_uint ns = 1u << p;
+        ok = GPU_ARG(stft->pass, 0, stft->work[p & 1]) && GPU_ARG(stft->pass, 1, stft->work[(p + 1) & 1]) &&
+             GPU_ARG(stft->pass, 2, stft->twiddle) && GPU_ARG(stft->pass, 3, n) && GPU_ARG(stft->pass, 4, ns) &&
+             gpu_run(stft, stft->pass, bins / 2, 0, NULL, NULL);
+    }
+
+    cl_event computed = NULL;
+    cl_uint db_flag = db ? 1 : 0;
+    bool with_cfar = thresholds != NULL;
+    ok = ok && GPU_ARG(stft->power, 0, stft->work[stft->log2_size & 1]) && GPU_ARG(stft->power, 1, n) &&
+         GPU_ARG(stft->power, 2, db_flag) && GPU_ARG(stft->power, 3, set->rows) &&
+         gpu_run(stft, stft->power, bins, 0, NULL, with_cfar ? NULL : &computed);
+    if (ok && with_cfar) {
+        ok = GPU_ARG(stft->cfar, 0, set->rows) && GPU_ARG(stft->cfar, 1, stft->alpha) &&
+             GPU_ARG(stft->cfar, 2, n) && GPU_ARG(stft->cfar, 3, stft->ref_cells) &&
+             GPU_ARG(stft->cfar, 4, stft->guard_cells) && GPU_ARG(stft->cfar, 5, stft->cfar_mode) &&
+             GPU_ARG(stft->cfar, 6, set->thresholds) &&
+             gpu_run(stft, stft->cfar, bins, 0, NULL, &computed);
+    }
+    if (!ok) {
+        gpu_release_event(gpu, &computed);
+        return false;
+    }
+    cl->Flush(gpu->compute);
+
+    // Download; the last read marks the set free again
+    ok = cl->EnqueueReadBuffer(gpu->download, set->rows, CL_FALSE, 0, bins * sizeof(float), rows,
+                               1, &computed, with_cfar ? NULL : &set->drained) == CL_SUCCESS;
+    if (ok && with_cfar) {
+        ok = cl->EnqueueReadBuffer(gpu->download, set->thresholds, CL_FALSE, 0, bins * sizeof(float),
+                                   thresholds, 0, NULL, &set->drained) == CL_SUCCESS;
+    }
+    gpu_release_event(gpu, &computed);
+    cl->Flush(gpu->download);
+    return ok;
+}
+
+bool gpu_stft_rows(gpu_stft_t *stft, const void *iq, uint32_t num_frames, size_t hop,
+                   float *rows, bool db, float *thresholds) {
+    if (!stft || !iq || !rows || hop == 0 || hop > UINT32_MAX) return false;
+    if (thresholds && (!stft->cfar_enabled || db)) return false;
+    if (num_frames == 0) return true;
+    gpu_context_t *gpu = stft->gpu;
+    const uint32_t n = stft->fft_size;
+
+    // Grow the span buffers for this hop (nothing is in flight between calls)
+    size_t span_bytes = ((size_t)(stft->chunk_frames - 1) * hop + n) * stft->sample_bytes;
+    if (span_bytes > stft->span_capacity) {
+        for (int s = 0; s < 2; s++) {
+            gpu_release_mem(gpu, &stft->sets[s].samples);
+            stft->sets[s].samples = gpu_buffer(gpu, CL_MEM_READ_ONLY, span_bytes);
+            if (!stft->sets[s].samples) {
+                fprintf(stderr, "GPU: not enough device memory for a %zu-byte sample span\n", span_bytes);
+                stft->span_capacity = 0;
+                return false;
+            }
+        }
+        stft->span_capacity = span_bytes;
+    }
+
+    const uint8_t *samples = (const uint8_t *)iq;
+    bool ok = true;
+    for (uint32_t first = 0, chunk = 0; ok && first < num_frames; chunk++) {
+        uint32_t frames = num_frames - first < stft->chunk_frames ? num_frames - first : stft->chunk_frames;
+        size_t offset = (size_t)first * hop * stft->sample_bytes;
+        size_t bytes = ((size_t)(frames - 1) * hop + n) * stft->sample_bytes;
+        ok = gpu_stft_chunk(stft, &stft->sets[chunk & 1], samples + offset, bytes, frames, (cl_uint)hop, db,
+                            rows + (size_t)first * n, thresholds ? thresholds + (size_t)first * n : NULL);
+        first += frames;
+    }
+    gpu_stft_drain(stft);
+    if (!ok) fprintf(stderr, "GPU: STFT dispatch failed on %s\n", gpu->name);
+    return ok;
+}
+
+bool gpu_stft_backend_rows(void *stft, const float *iq, uint32_t num_frames, size_t hop,
+                           float *rows, bool db) {
+    gpu_stft_t *engine = (gpu_stft_t *)stft;
+    if (!engine || engine->samples != GPU_SAMPLES_F32) return false;
+    return gpu_stft_rows(engine, iq, num_frames, hop, rows, db, NULL);
+}
+
+void gpu_stft_destroy(gpu_stft_t *stft) {
+    if (!stft) return;
+    gpu_context_t *gpu = stft->gpu;
+    gpu_stft_drain(stft);
+    for (int s = 0; s < 2; s++) {
+        gpu_stft_set_t *set = &stft->sets[s];
+        gpu_release_mem(gpu, &set->samples);
+        gpu_release_mem(gpu, &set->rows);
+        gpu_release_mem(gpu, &set->thresholds);
+    }
+    gpu_release_mem(gpu, &stft->window);
+    gpu_release_mem(gpu, &stft->twiddle);
+    gpu_release_mem(gpu, &stft->alpha);
+    gpu_release_mem(gpu, &stft->work[0]);
+    gpu_release_mem(gpu, &stft->work[1]);
+    if (stft->stage) gpu->cl.ReleaseKernel(stft->stage);
+    if (stft->pass) gpu->cl.ReleaseKernel(stft->pass);
+    if (stft->power) gpu->cl.ReleaseKernel(stft->power);
+    if (stft->cfar) gpu->cl.ReleaseKernel(stft->cfar);
+    free(stft);
+}
+
+#else // !IQ_WITH_OPENCL
+
+bool gpu_compiled(void) {
+    return false;
+}
+
+gpu_context_t *gpu_open(const char *match) {
+    (void)match;
+    fprintf(stderr, "GPU: built without the OpenCL backend (make GPU=1)\n");
+    return NULL;
+}
+
+void gpu_close(gpu_context_t *gpu) {
+    (void)gpu;
+}
+
+const char *gpu_device_name(const gpu_context_t *gpu) {
+    (void)gpu;
+    return "none";
+}
+
+gpu_stft_t *gpu_stft_create(gpu_context_t *gpu, uint32_t fft_size, const float *window,
+                            gpu_samples_t samples) {
+    (void)gpu; (void)fft_size; (void)window; (void)samples;
+    return NULL;
+}
+
+bool gpu_stft_set_cfar(gpu_stft_t *stft, uint32_t ref_cells, uint32_t guard_cells,
+                       uint32_t mode, const double *alpha) {
+    (void)stft; (void)ref_cells; (void)guard_cells; (void)mode; (void)alpha;
+    return false;
+}
+
+bool gpu_stft_rows(gpu_stft_t *stft, const void *iq, uint32_t num_frames, size_t hop,
+                   float *rows, bool db, float *thresholds) {
+    (void)stft; (void)iq; (void)num_frames; (void)hop; (void)rows; (void)db; (void)thresholds;
+    return false;
+}
+
+bool gpu_stft_backend_rows(void *stft, const float *iq, uint32_t num_frames, size_t hop,
+                           float *rows, bool db) {
+    (void)stft; (void)iq; (void)num_frames; (void)hop; (void)rows; (void)db;
+    return false;
+}
+
+void gpu_stft_destroy(gpu_stft_t *stft) {
+    (void)stft;
+}
+
+#endif // IQ_WITH_OPENCL
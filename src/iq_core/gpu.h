@@ -0,0 +1,81 @@
+#ifndef GPU_H
+#define GPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Optional OpenCL compute backend for STFT rows and mean-level CFAR
+ * Built when the tree is compiled with IQ_WITH_OPENCL (make GPU=1). The
+ * OpenCL runtime is loaded when a tool asks for a device, so building
+ * needs no SDK and the binaries still run on machines without one:
+ * gpu_open() then returns NULL and callers stay on the CPU path.
+ *
+ * A gpu_stft_t turns thousands of frames per call into fftshifted |X|^2
+ * rows (linear or dB, unnormalized, like fft_spectral_batch). Frames are
+ * split into chunks of about GPU_STFT_CHUNK_BINS bins that alternate
+ * between two device buffer sets: the upload of chunk i + 1 and the
+ * download of chunk i - 1 run on their own queues while chunk i computes.
+ * Power-of-two FFT sizes only (radix-2 Stockham passes).
+ *
+ * Device arithmetic is single precision with its own operation order, so
+ * rows match the CPU path to float rounding, not bit for bit.
+ */
+
+#define GPU_STFT_CHUNK_BINS (1u << 21)  // Bins per device chunk
+#define GPU_STFT_MAX_SIZE (1u << 20)    // Largest FFT size on the device
+
+typedef struct gpu_context gpu_context_t;
+typedef struct gpu_stft gpu_stft_t;
+
+// Input sample layout of a gpu_stft_t: interleaved I/Q
+typedef enum {
+    GPU_SAMPLES_F32 = 0,    // float
+    GPU_SAMPLES_S16,        // int16_t, scaled by 1/32768 like fft_spectral_frame_int
+    GPU_SAMPLES_S8          // int8_t, scaled by 1/128
+} gpu_samples_t;
+
+// True when the tree was built with the OpenCL backend
+bool gpu_compiled(void);
+
+/*
+ * Open the first GPU or accelerator whose name contains 'match' (NULL or
+ * "" for the first one). Returns NULL, with the reason on stderr, when the
+ * backend is not compiled in, no OpenCL runtime is installed or no device
+ * is present.
+ */
+gpu_context_t *gpu_open(const char *match);
+void gpu_close(gpu_context_t *gpu);
+const char *gpu_device_name(const gpu_context_t *gpu);
+
+/*
+ * STFT engine for one FFT size and window (N taps or NULL for rectangular)
+ * Returns NULL for unsupported sizes or when the device runs out of memory.
+ */
+gpu_stft_t *gpu_stft_create(gpu_context_t *gpu, uint32_t fft_size, const float *window,
+                            gpu_samples_t samples);
+
+/*
+ * Also compute mean-level CFAR thresholds of every linear row on the device:
+ * 'mode' 0/1/2 for CA/GO/SO (cfar_mode_t), alpha[0 .. 2 * ref_cells] the
+ * multiplier table of cfar_ca_t. Thresholds follow cfar_ca_get_threshold.
+ */
+bool gpu_stft_set_cfar(gpu_stft_t *stft, uint32_t ref_cells, uint32_t guard_cells,
+                       uint32_t mode, const double *alpha);
+
+/*
+ * Rows of 'num_frames' frames spaced 'hop' samples apart (num_frames * N
+ * floats), linear or dB. 'thresholds' (num_frames * N floats, linear rows
+ * only) receives the CFAR thresholds when gpu_stft_set_cfar was called.
+ */
+bool gpu_stft_rows(gpu_stft_t *stft, const void *iq, uint32_t num_frames, size_t hop,
+                   float *rows, bool db, float *thresholds);
+
+// gpu_stft_rows without thresholds, shaped for stft_set_backend (float input)
+bool gpu_stft_backend_rows(void *stft, const float *iq, uint32_t num_frames, size_t hop,
+                           float *rows, bool db);
+
+void gpu_stft_destroy(gpu_stft_t *stft);
+
+#endif // GPU_H
@@ -0,0 +1,246 @@
+/*
+ * IQ Lab - Huge-page backed buffers
+ *
+ * Every block is preceded by one IQ_HUGE_ALIGN-sized header recording what
+ * was allocated (the heap storage or the whole mapping) and how, so
+ * iq_huge_free() needs nothing but the pointer. Transparent huge pages
+ * need the mapping itself aligned to the huge page size: the allocator
+ * over-maps by one huge page and trims both ends.
+ */
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // MAP_ANONYMOUS, MAP_HUGETLB, madvise under -std=c11
+#endif
+
+#include "hugepage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#define IQ_HUGE_MAGIC 0x4951485547455047ull    // "IQHUGEPG"
+#define IQ_HUGE_DEFAULT_PAGE (2u << 20)
+
+typedef struct {
+    uint64_t magic;
+    void *storage;               // What malloc or the mapping returned
+    size_t length;               // Mapping length (0 for the heap)
+    uint32_t kind;               // iq_page_kind_t
+} iq_huge_header_t;
+
+_Static_assert(sizeof(iq_huge_header_t) <= IQ_HUGE_ALIGN, "header must fit its slot");
+
+static atomic_int huge_mode = -1;        // -1: not read from the environment yet
+static pthread_once_t huge_page_once = PTHREAD_ONCE_INIT;
+static size_t huge_page_bytes = IQ_HUGE_DEFAULT_PAGE;
+#ifdef _WIN32
+static size_t large_page_bytes;          // 0: large pages unavailable
+#endif
+
+bool iq_huge_mode_from_name(const char *name, iq_huge_mode_t *mode) {
+    if (!name || !mode) return false;
+    if (strcmp(name, "off") == 0) {
+        *mode = IQ_HUGE_OFF;
+    } else if (strcmp(name, "thp") == 0) {
+        *mode = IQ_HUGE_THP;
+    } else if (strcmp(name, "explicit") == 0) {
+        *mode = IQ_HUGE_EXPLICIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *iq_huge_mode_name(iq_huge_mode_t mode) {
+    switch (mode) {
+        case IQ_HUGE_OFF: return "off";
+        case IQ_HUGE_THP: return "thp";
+        case IQ_HUGE_EXPLICIT: return "explicit";
+    }
+    return "unknown";
+}
+
+const char *iq_page_kind_name(iq_page_kind_t kind) {
+    switch (kind) {
+        case IQ_PAGES_HEAP: return "heap";
+        case IQ_PAGES_SMALL: return "small pages";
+        case IQ_PAGES_TRANSPARENT: return "transparent huge pages";
+        case IQ_PAGES_EXPLICIT: return "explicit huge pages";
+    }
+    return "unknown";
+}
+
+void iq_huge_set_mode(iq_huge_mode_t mode) {
+    atomic_store(&huge_mode, (int)mode);
+}
+
+iq_huge_mode_t iq_huge_mode(void) {
+    int mode = atomic_load(&huge_mode);
+    if (mode >= 0) return (iq_huge_mode_t)mode;
+
+    iq_huge_mode_t parsed = IQ_HUGE_THP;
+    const char *name = getenv(IQ_HUGE_ENV);
+    if (name && name[0] && !iq_huge_mode_from_name(name, &parsed)) {
+        fprintf(stderr, "Warning: %s=%s is not off, thp or explicit; using thp\n", IQ_HUGE_ENV, name);
+    }
+
+    // A concurrent iq_huge_set_mode() wins over the environment
+    int expected = -1;
+    atomic_compare_exchange_strong(&huge_mode, &expected, (int)parsed);
+    return (iq_huge_mode_t)atomic_load(&huge_mode);
+}
+
+#ifdef _WIN32
+// Large pages need SeLockMemoryPrivilege enabled in the process token
+static void iq_huge_enable_large_pages(void) {
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return;
+
+    TOKEN_PRIVILEGES privileges;
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    if (LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+        AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL) &&
+        GetLastError() == ERROR_SUCCESS) {
+        large_page_bytes = GetLargePageMinimum();
+    }
+    CloseHandle(token);
+}
+#endif
+
+static void iq_huge_detect_page_size(void) {
+#ifdef _WIN32
+    iq_huge_enable_large_pages();
+    if (large_page_bytes > 0) huge_page_bytes = large_page_bytes;
+#elif defined(__linux__)
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+    unsigned long long bytes = 0;
+    if (f) {
+        if (fscanf(f, "%llu", &bytes) != 1) bytes = 0;
+        fclose(f);
+    }
+    if (bytes == 0 && (f = fopen("/proc/meminfo", "r"))) {
+        char line[128];
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "Hugepagesize: %llu kB", &bytes) == 1) {
+                bytes *= 1024;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    // A power of two of at least a base page, or the default
+    if (bytes >= 4096 && (bytes & (bytes - 1)) == 0) huge_page_bytes = (size_t)bytes;
+#endif
+}
+
+size_t iq_huge_page_size(void) {
+    pthread_once(&huge_page_once, iq_huge_detect_page_size);
+    return huge_page_bytes;
+}
+
+static void *iq_huge_finish(void *storage, uintptr_t header_at, size_t length, iq_page_kind_t kind) {
+    iq_huge_header_t *header = (iq_huge_header_t *)header_at;
+    header->magic = IQ_HUGE_MAGIC;
+    header->storage = storage;
+    header->length = length;
+    header->kind = (uint32_t)kind;
+    return (void *)(header_at + IQ_HUGE_ALIGN);
+}
+
+static void *iq_huge_heap_alloc(size_t bytes) {
+    if (bytes > SIZE_MAX - 2 * IQ_HUGE_ALIGN) return NULL;
+    void *storage = calloc(1, bytes + 2 * IQ_HUGE_ALIGN);
+    if (!storage) return NULL;
+    uintptr_t start = ((uintptr_t)storage + IQ_HUGE_ALIGN - 1) & ~(uintptr_t)(IQ_HUGE_ALIGN - 1);
+    return iq_huge_finish(storage, start, 0, IQ_PAGES_HEAP);
+}
+
+#ifdef __linux__
+// An anonymous mapping aligned to 'page' and advised for transparent huge pages
+static void *iq_huge_map_transparent(size_t length, size_t page) {
+    size_t span = length + page;
+    uint8_t *raw = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+
+    uintptr_t start = ((uintptr_t)raw + page - 1) & ~(uintptr_t)(page - 1);
+    size_t head = start - (uintptr_t)raw;
+    if (head > 0) munmap(raw, head);
+    if (span - head > length) munmap((uint8_t *)start + length, span - head - length);
+
+    iq_page_kind_t kind = IQ_PAGES_TRANSPARENT;
+#ifdef MADV_HUGEPAGE
+    if (madvise((void *)start, length, MADV_HUGEPAGE) != 0) kind = IQ_PAGES_SMALL;  // No THP in this kernel
+#else
+    kind = IQ_PAGES_SMALL;
+#endif
+    return iq_huge_finish((void *)start, start, length, kind);
+}
+#endif
+
+void *iq_huge_alloc(size_t bytes) {
+    if (bytes == 0) bytes = 1;
+    iq_huge_mode_t mode = iq_huge_mode();
+    if (mode == IQ_HUGE_OFF || bytes < IQ_HUGE_MIN_BYTES) return iq_huge_heap_alloc(bytes);
+
+    size_t page = iq_huge_page_size();
+    if (bytes > SIZE_MAX - IQ_HUGE_ALIGN - 2 * page) return NULL;
+    size_t length = (bytes + IQ_HUGE_ALIGN + page - 1) & ~(page - 1);
+
+#ifdef _WIN32
+    if (mode == IQ_HUGE_EXPLICIT && large_page_bytes > 0) {
+        void *storage = VirtualAlloc(NULL, length, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (storage) return iq_huge_finish(storage, (uintptr_t)storage, length, IQ_PAGES_EXPLICIT);
+    }
+#elif defined(__linux__)
+#ifdef MAP_HUGETLB
+    if (mode == IQ_HUGE_EXPLICIT) {
+        // Only the default huge page size: no MAP_HUGE_* size bits
+        void *storage = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (storage != MAP_FAILED) {
+            return iq_huge_finish(storage, (uintptr_t)storage, length, IQ_PAGES_EXPLICIT);
+        }
+    }
+#endif
+    void *block = iq_huge_map_transparent(length, page);
+    if (block) return block;
+#endif
+    return iq_huge_heap_alloc(bytes);
+}
+
+static iq_huge_header_t *iq_huge_header(const void *block) {
+    iq_huge_header_t *header = (iq_huge_header_t *)((uintptr_t)block - IQ_HUGE_ALIGN);
+    if (header->magic != IQ_HUGE_MAGIC) {
+        fprintf(stderr, "Error: %p was not allocated by iq_huge_alloc\n", block);
+        abort();
+    }
+    return header;
+}
+
+void iq_huge_free(void *block) {
+    if (!block) return;
+    iq_huge_header_t *header = iq_huge_header(block);
+    header->magic = 0;
+
+    if (header->kind == IQ_PAGES_HEAP) {
+        free(header->storage);
+        return;
+    }
+#ifdef _WIN32
+    VirtualFree(header->storage, 0, MEM_RELEASE);
+#elif defined(__linux__)
+    munmap(header->storage, header->length);
+#endif
+}
+
+iq_page_kind_t iq_huge_kind(const void *block) {
+    return block ? (iq_page_kind_t)iq_huge_header(block)->kind : IQ_PAGES_HEAP;
+}
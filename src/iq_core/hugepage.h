@@ -0,0 +1,78 @@
+#ifndef IQ_HUGEPAGE_H
+#define IQ_HUGEPAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Huge-page backed buffers
+ * Large FFT tables, sample rings and filter histories span thousands of
+ * 4 KB pages; random and strided access over them misses the TLB on
+ * nearly every touch. iq_huge_alloc() backs blocks of at least
+ * IQ_HUGE_MIN_BYTES with 2 MB (or the system's) pages where it can:
+ *
+ *   thp       transparent huge pages: an aligned anonymous mapping with
+ *             madvise(MADV_HUGEPAGE) on Linux (the default)
+ *   explicit  reserved huge pages (MAP_HUGETLB on Linux, large pages on
+ *             Windows, which need the "Lock pages in memory" privilege),
+ *             falling back to thp when none are free
+ *   off       the C heap
+ *
+ * The mode is read from IQLAB_HUGEPAGES on the first allocation, or set
+ * with iq_huge_set_mode(). Smaller blocks, and every block where the
+ * platform has no huge pages, come from the heap, so callers need no
+ * special cases. Memory is zeroed and IQ_HUGE_ALIGN-aligned, and must be
+ * released with iq_huge_free().
+ *
+ * Huge pages are taken once, when a pipeline builds its plans and
+ * buffers; allocating or freeing them in a steady-state loop costs a
+ * system call and a page clear each time.
+ *
+ * Thread Safety: all functions may be called from any thread
+ */
+
+#define IQ_HUGE_ENV "IQLAB_HUGEPAGES"
+#define IQ_HUGE_ALIGN 64                 // Every block starts on a cache line
+#define IQ_HUGE_MIN_BYTES (1u << 20)     // Smaller blocks stay on the heap
+
+typedef enum {
+    IQ_HUGE_OFF = 0,
+    IQ_HUGE_THP,
+    IQ_HUGE_EXPLICIT
+} iq_huge_mode_t;
+
+// What backs a block
+typedef enum {
+    IQ_PAGES_HEAP = 0,           // malloc
+    IQ_PAGES_SMALL,              // A mapping of base pages (huge pages unavailable)
+    IQ_PAGES_TRANSPARENT,        // A mapping advised for transparent huge pages
+    IQ_PAGES_EXPLICIT            // Reserved huge or large pages
+} iq_page_kind_t;
+
+// Parse "off", "thp" or "explicit"
+bool iq_huge_mode_from_name(const char *name, iq_huge_mode_t *mode);
+
+const char *iq_huge_mode_name(iq_huge_mode_t mode);
+
+const char *iq_page_kind_name(iq_page_kind_t kind);
+
+// Set the mode for later allocations (blocks already handed out keep theirs)
+void iq_huge_set_mode(iq_huge_mode_t mode);
+
+// The mode in force, reading IQLAB_HUGEPAGES first if nothing set it
+iq_huge_mode_t iq_huge_mode(void);
+
+// The huge page size the allocator rounds mappings to (2 MB where unknown)
+size_t iq_huge_page_size(void);
+
+// Zeroed, IQ_HUGE_ALIGN-aligned 'bytes' bytes, or NULL
+void *iq_huge_alloc(size_t bytes);
+
+// Release a block from iq_huge_alloc (NULL is ignored)
+void iq_huge_free(void *block);
+
+// What backs a block from iq_huge_alloc
+iq_page_kind_t iq_huge_kind(const void *block);
+
+#endif // IQ_HUGEPAGE_H
@@ -0,0 +1,262 @@
+/*
+ * IQ Lab - Asynchronous read-ahead
+ *
+ * Single producer / single consumer ring: the I/O thread fills slots at
+ * 'head', the consumer takes them in order from 'tail'. A slot is never
+ * written while it counts as filled, so the sample buffers themselves need
+ * no locking; only the counters are guarded by the mutex.
+ *
+ * Time either side spends blocked on the other is the profiler's "wait"
+ * stage: on the reader a consumer behind, on the consumer a slow disk.
+ *
+ * When paced, the reader reads a block ahead of its due time (into the
+ * spare 'discard' buffer if no slot is free yet), sleeps until it is due
+ * and only then decides: a free slot takes it, a full ring drops it. Only
+ * the reader fills slots, so a slot free at read time is still free then.
+ * The monitor is called with the ring lock held, so its fill level tracks
+ * the ring exactly.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // nanosleep under -std=c11
+#endif
+
+#include "io_async.h"
+#include "profile.h"
+#include "hugepage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define IQ_ASYNC_PACE_SLICE_NS 5000000u   // Longest sleep between stop checks when paced
+
+static void iq_async_sleep_ns(uint64_t ns) {
+#ifdef _WIN32
+    Sleep((DWORD)(ns / 1000000u) + 1);
+#else
+    struct timespec ts = {(time_t)(ns / 1000000000u), (long)(ns % 1000000000u)};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// Paced reader: sleep until 'due', returning with the lock held (false on stop)
+static bool iq_async_wait_until(iq_async_t *async, uint64_t due) {
+    pthread_mutex_lock(&async->lock);
+    while (!async->stop) {
+        uint64_t now = iq_profile_now();
+        if (now >= due) return true;
+        pthread_mutex_unlock(&async->lock);
+        uint64_t remaining = due - now;
+        iq_async_sleep_ns(remaining < IQ_ASYNC_PACE_SLICE_NS ? remaining : IQ_ASYNC_PACE_SLICE_NS);
+        pthread_mutex_lock(&async->lock);
+    }
+    return false;
+}
+
+// Background reader: keep every free slot filled until EOF or stop
+static void *iq_async_thread(void *arg) {
+    iq_async_t *async = (iq_async_t *)arg;
+    const bool paced = async->realtime_rate > 0.0;
+    const uint64_t epoch_ns = iq_profile_now();
+    uint64_t next_start = async->reader->position;
+    uint64_t paced_samples = 0;
+    iq_trace_thread_name("reader");
+
+    pthread_mutex_lock(&async->lock);
+    while (!async->stop) {
+        // A live source does not wait for the consumer; a full ring overruns
+        uint64_t wait_start = iq_profile_begin();
+        bool waited = false;
+        while (!paced && async->filled == async->num_blocks && !async->stop) {
+            pthread_cond_wait(&async->free_cond, &async->lock);
+            waited = true;
+        }
+        if (waited) iq_profile_end(IQ_PROFILE_WAIT, wait_start, 0, 0);
+        if (async->stop) break;
+
+        uint32_t slot = async->head;
+        bool full = async->filled == async->num_blocks;
+        pthread_mutex_unlock(&async->lock);
+
+        // Read and convert without the lock; the consumer cannot see this slot
+        float *slot_buffer = async->storage + (size_t)slot * async->block_samples * 2;
+        float *buffer = full ? async->discard : slot_buffer;
+        size_t count = iq_read_samples(async->reader, buffer, async->block_samples);
+
+        if (paced && count > 0) {
+            // Due when its last sample would have arrived
+            paced_samples += count;
+            uint64_t due = epoch_ns + (uint64_t)((double)paced_samples / async->realtime_rate * 1e9);
+            if (!iq_async_wait_until(async, due)) break;
+        } else {
+            pthread_mutex_lock(&async->lock);
+        }
+
+        if (count == 0) {
+            async->eof = true;
+            pthread_cond_broadcast(&async->filled_cond);
+            break;
+        }
+
+        if (async->filled == async->num_blocks) {
+            rt_monitor_overrun(async->monitor, count);
+            next_start += count;
+            continue;
+        }
+        // The consumer freed a slot while this block was on its way
+        if (buffer != slot_buffer) memcpy(slot_buffer, buffer, count * 2 * sizeof(float));
+
+        async->blocks[slot].samples = slot_buffer;
+        async->blocks[slot].num_samples = count;
+        async->blocks[slot].start = next_start;
+        async->blocks[slot].arrival_ns = iq_profile_now();
+        next_start += count;
+
+        async->head = (slot + 1) % async->num_blocks;
+        async->filled++;
+        rt_monitor_arrived(async->monitor, count, async->filled, async->num_blocks);
+        pthread_cond_broadcast(&async->filled_cond);
+    }
+    pthread_mutex_unlock(&async->lock);
+
+    return NULL;
+}
+
+iq_async_t *iq_async_create(iq_reader_t *reader, size_t block_samples, uint32_t num_blocks) {
+    return iq_async_create_realtime(reader, block_samples, num_blocks, 0.0, NULL);
+}
+
+iq_async_t *iq_async_create_realtime(iq_reader_t *reader, size_t block_samples, uint32_t num_blocks,
+                                     double sample_rate, rt_monitor_t *monitor) {
+    if (!reader || (!reader->file && !reader->source && !reader->compressed && !reader->stream)) {
+        fprintf(stderr, "Error: Async read-ahead needs an open reader\n");
+        return NULL;
+    }
+
+    if (block_samples == 0) block_samples = IQ_ASYNC_BLOCK_SAMPLES;
+    if (num_blocks == 0) num_blocks = IQ_ASYNC_NUM_BLOCKS;
+    if (num_blocks < 2) num_blocks = 2;
+
+    iq_async_t *async = (iq_async_t *)calloc(1, sizeof(iq_async_t));
+    if (!async) {
+        fprintf(stderr, "Error: Failed to allocate async reader\n");
+        return NULL;
+    }
+
+    async->reader = reader;
+    async->block_samples = block_samples;
+    async->num_blocks = num_blocks;
+    async->storage = (float *)iq_huge_alloc((size_t)num_blocks * block_samples * 2 * sizeof(float));
+    async->blocks = (iq_async_block_t *)calloc(num_blocks, sizeof(iq_async_block_t));
+    async->realtime_rate = sample_rate > 0.0 ? sample_rate : 0.0;
+    async->monitor = monitor;
+    if (async->realtime_rate > 0.0) async->discard = (float *)malloc(block_samples * 2 * sizeof(float));
+
+    if (!async->storage || !async->blocks || (async->realtime_rate > 0.0 && !async->discard)) {
+        fprintf(stderr, "Error: Failed to allocate %u read-ahead blocks of %zu samples\n",
+                num_blocks, block_samples);
+        iq_huge_free(async->storage);
+        free(async->blocks);
+        free(async->discard);
+        free(async);
+        return NULL;
+    }
+
+    pthread_mutex_init(&async->lock, NULL);
+    pthread_cond_init(&async->filled_cond, NULL);
+    pthread_cond_init(&async->free_cond, NULL);
+
+    if (pthread_create(&async->thread, NULL, iq_async_thread, async) != 0) {
+        fprintf(stderr, "Error: Failed to start read-ahead thread\n");
+        pthread_cond_destroy(&async->free_cond);
+        pthread_cond_destroy(&async->filled_cond);
+        pthread_mutex_destroy(&async->lock);
+        iq_huge_free(async->storage);
+        free(async->blocks);
+        free(async->discard);
+        free(async);
+        return NULL;
+    }
+
+    return async;
+}
+
+const iq_async_block_t *iq_async_acquire(iq_async_t *async) {
+    if (!async) return NULL;
+
+    pthread_mutex_lock(&async->lock);
+
+    // Every slot held: the I/O thread cannot make progress until a release
+    if (async->acquired == async->num_blocks) {
+        pthread_mutex_unlock(&async->lock);
+        fprintf(stderr, "Error: All %u read-ahead blocks are held\n", async->num_blocks);
+        return NULL;
+    }
+
+    uint64_t wait_start = async->monitor ? iq_profile_now() : iq_profile_begin();
+    bool waited = false;
+    while (async->acquired == async->filled && !async->eof && !async->stop) {
+        pthread_cond_wait(&async->filled_cond, &async->lock);
+        waited = true;
+    }
+    if (waited) {
+        iq_profile_end(IQ_PROFILE_WAIT, wait_start, 0, 0);
+        if (async->monitor) rt_monitor_idle(async->monitor, iq_profile_now() - wait_start);
+    }
+
+    const iq_async_block_t *block = NULL;
+    if (async->acquired < async->filled) {
+        uint32_t slot = (async->tail + async->acquired) % async->num_blocks;
+        block = &async->blocks[slot];
+        async->acquired++;
+    }
+
+    pthread_mutex_unlock(&async->lock);
+    return block;
+}
+
+void iq_async_release(iq_async_t *async, const iq_async_block_t *block) {
+    if (!async || !block) return;
+
+    pthread_mutex_lock(&async->lock);
+
+    if (async->acquired == 0 || block != &async->blocks[async->tail]) {
+        pthread_mutex_unlock(&async->lock);
+        fprintf(stderr, "Error: Read-ahead blocks must be released oldest first\n");
+        return;
+    }
+
+    if (async->monitor) {
+        rt_monitor_consumed(async->monitor, block->num_samples, iq_profile_now() - block->arrival_ns);
+    }
+    async->tail = (async->tail + 1) % async->num_blocks;
+    async->filled--;
+    async->acquired--;
+    pthread_cond_signal(&async->free_cond);
+
+    pthread_mutex_unlock(&async->lock);
+}
+
+void iq_async_destroy(iq_async_t *async) {
+    if (!async) return;
+
+    pthread_mutex_lock(&async->lock);
+    async->stop = true;
+    pthread_cond_broadcast(&async->free_cond);
+    pthread_cond_broadcast(&async->filled_cond);
+    pthread_mutex_unlock(&async->lock);
+
+    pthread_join(async->thread, NULL);
+
+    pthread_cond_destroy(&async->free_cond);
+    pthread_cond_destroy(&async->filled_cond);
+    pthread_mutex_destroy(&async->lock);
+    iq_huge_free(async->storage);
+    free(async->blocks);
+    free(async->discard);
+    free(async);
+}
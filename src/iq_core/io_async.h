@@ -0,0 +1,92 @@
+#ifndef IO_ASYNC_H
+#define IO_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "io_iq.h"
+#include "rt_monitor.h"
+
+/*
+ * Asynchronous read-ahead over an iq_reader_t
+ * A background thread reads and converts the file into a ring of
+ * 'num_blocks' float blocks while the caller processes earlier ones, so
+ * disk latency overlaps the DSP instead of stalling it. Blocks are handed
+ * out in file order by pointer; nothing is copied on the consumer side.
+ *
+ * The reader is owned by the I/O thread between create and destroy; the
+ * caller may still read the fields fixed at open (format, sample_rate,
+ * total_samples) but must not read from or seek it.
+ *
+ * Created with a real-time rate, the reader emulates a live source: each
+ * block becomes available only when its last sample would have arrived at
+ * that rate, and a block that comes due while every slot is filled is read
+ * and thrown away (an overrun) instead of waiting for the consumer.
+ */
+
+// Default ring geometry used by the CLI tools
+#define IQ_ASYNC_BLOCK_SAMPLES 65536
+#define IQ_ASYNC_NUM_BLOCKS    4
+
+// One filled ring slot
+typedef struct {
+    const float *samples;   // Interleaved I/Q floats, valid until released
+    size_t num_samples;     // Complex samples in this block
+    uint64_t start;         // File index of the first sample
+    uint64_t arrival_ns;    // iq_profile_now() when the block became available
+} iq_async_block_t;
+
+typedef struct {
+    iq_reader_t *reader;        // Source (used only by the I/O thread)
+    size_t block_samples;       // Capacity of each slot in complex samples
+    uint32_t num_blocks;        // Ring size
+    float *storage;             // num_blocks * block_samples * 2 floats
+    iq_async_block_t *blocks;   // Slot descriptors
+
+    pthread_t thread;           // Background reader
+    pthread_mutex_t lock;
+    pthread_cond_t filled_cond; // Signalled when a slot is filled or EOF
+    pthread_cond_t free_cond;   // Signalled when the consumer releases a slot
+
+    uint32_t head;              // Next slot the I/O thread fills
+    uint32_t tail;              // Oldest slot held or ready for the consumer
+    uint32_t filled;            // Slots filled and not yet released
+    uint32_t acquired;          // Of those, slots handed to the consumer
+    bool eof;                   // I/O thread reached end of file
+    bool stop;                  // Destroy requested
+
+    double realtime_rate;       // Samples/s to pace the reader at, 0 = as fast as possible
+    rt_monitor_t *monitor;      // Optional, told about arrivals, overruns and releases
+    float *discard;             // One block read into when a paced block overruns
+} iq_async_t;
+
+/*
+ * Start read-ahead on an open reader
+ * block_samples / num_blocks of 0 select the defaults above; at least two
+ * blocks are used so one can be processed while the next is read.
+ */
+iq_async_t *iq_async_create(iq_reader_t *reader, size_t block_samples, uint32_t num_blocks);
+
+/*
+ * Start read-ahead paced at 'sample_rate' samples/s (0 = unpaced), reporting
+ * to 'monitor' if it is not NULL. Overruns only happen when paced.
+ */
+iq_async_t *iq_async_create_realtime(iq_reader_t *reader, size_t block_samples, uint32_t num_blocks,
+                                     double sample_rate, rt_monitor_t *monitor);
+
+/*
+ * Wait for the next block in file order
+ * Several blocks may be held at once (e.g. an FFT frame that straddles a
+ * boundary), up to num_blocks. Returns NULL at end of file, or if every
+ * slot is already held.
+ */
+const iq_async_block_t *iq_async_acquire(iq_async_t *async);
+
+// Return the oldest held block to the ring (blocks are released in order)
+void iq_async_release(iq_async_t *async, const iq_async_block_t *block);
+
+// Stop the I/O thread and free the ring (the reader stays open)
+void iq_async_destroy(iq_async_t *async);
+
+#endif // IO_ASYNC_H
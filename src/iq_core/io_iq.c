@@ -11,11 +11,13 @@
  * SUPPORTED FORMATS:
  *   - Raw IQ (s8/s16): Interleaved I,Q samples as signed integers
  *   - WAV IQ: RIFF/WAV container with IQ data as audio channels
+ *   - IQZ: chunked compressed container (io_iqz.c), streamed and seekable
  *   - Complex float: Normalized [-1,1] for internal processing
  *
  * FEATURES:
  *   - Automatic format detection from file extensions
  *   - Memory-efficient block-based processing for large files
+ *   - Zero-copy memory-mapped access with on-demand block conversion
  *   - Format conversion between s8/s16 and float complex
  *   - WAV header parsing and validation
  *   - Error handling with detailed error messages
@@ -25,9 +27,13 @@
  *   Load IQ data: iq_data_load_file() or iq_data_load_wav()
  *   Save IQ data: iq_data_save_file()
  *   Format conversion: iq_convert_format()
+ *   Large captures: iq_mmap_open() + iq_mmap_block() per processing block
+ *   Shared decode: iq_source_load() + iq_source_publish(), then every
+ *   iq_reader_open() of that path streams the decoded samples
  *
  * DEPENDENCIES:
  *   - Standard C libraries (stdio, stdlib, string, errno, math)
+ *   - POSIX mmap / Win32 file mapping for iq_mmap_*
  *   - Custom types from io_iq.h
  *
  * THREAD SAFETY:
@@ -37,13 +43,41 @@
  * =============================================================================
  */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // mmap, posix_madvise under -std=c11
+#endif
+
 #include "io_iq.h"
+#include "io_iqz.h"
+#include "io_stream.h"
+#include "profile.h"
+#include "hugepage.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IQ_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define IQ_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 // WAV file header structure
 typedef struct {
@@ -69,6 +103,8 @@ typedef struct {
  * Raw formats:
  * - s8: 8-bit signed integers (-128 to +127)
  * - s16: 16-bit signed integers (-32768 to +32767)
+ * - s12: packed 12-bit (-2048 to +2047), 3 bytes per I/Q pair
+ * - s4: packed 4-bit (-8 to +7), 1 byte per I/Q pair
  *
  * We convert to float [-1,1] for DSP operations
  */
@@ -78,12 +114,527 @@ typedef struct {
 
 // Forward declarations
 bool iq_load_wav_file(const char *filename, iq_data_t *iq_data);
+static bool iq_mmap_map_file(iq_mmap_t *map, const char *filename);
+static void iq_mmap_unmap_file(iq_mmap_t *map);
+static bool iq_mmap_parse_wav(iq_mmap_t *map, const char *filename);
+static bool iq_wav_layout(const wav_header_t *header, uint64_t file_bytes, const char *filename,
+                          uint16_t *channels, uint64_t *num_samples);
+static bool iq_file_seek(FILE *file, uint64_t offset, int whence);
+static uint64_t iq_file_tell(FILE *file);
+static size_t iq_frame_bytes(iq_format_t format, uint16_t channels);
+static void iq_s8_to_f32(const int8_t *in, float *out, size_t count);
+static void iq_s16_to_f32(const int16_t *in, float *out, size_t count);
+static void iq_s12_to_f32(const uint8_t *in, float *out, size_t count);
+static void iq_s4_to_f32(const uint8_t *in, float *out, size_t count);
+static void iq_pack_s12(const int16_t *values, size_t count, uint8_t *out);
+static void iq_pack_s4(const int8_t *values, size_t count, uint8_t *out);
+static void iq_s8_to_f64(const int8_t *in, double *out, size_t count);
+static void iq_s16_to_f64(const int16_t *in, double *out, size_t count);
+
+/*
+ * Memory-mapped access
+ * The file is mapped read-only and samples are converted a block at a time,
+ * so resident memory is the page cache plus one block of floats instead of a
+ * raw copy and a full float copy of the capture.
+ */
+
+bool iq_mmap_open(iq_mmap_t *map, const char *filename) {
+    if (!map || !filename) {
+        return false;
+    }
+
+    memset(map, 0, sizeof(*map));
+    map->os_file = -1;
+
+    // Compressed chunks have no fixed byte offset per sample
+    if (iqz_probe(filename)) {
+        fprintf(stderr, "'%s' is an IQZ container and cannot be mapped; stream it with iq_reader_open\n", filename);
+        return false;
+    }
+
+    if (!iq_mmap_map_file(map, filename)) {
+        return false;
+    }
+
+    if (strstr(filename, ".wav") || strstr(filename, ".WAV")) {
+        if (!iq_mmap_parse_wav(map, filename)) {
+            iq_mmap_close(map);
+            return false;
+        }
+    } else {
+        map->format = iq_detect_format(filename);
+        map->channels = 2;
+        map->raw = map->map_base;
+        map->num_samples = map->map_bytes / iq_native_sample_bytes(map->format);
+    }
+
+    if (map->num_samples == 0) {
+        fprintf(stderr, "File too small to contain IQ data\n");
+        iq_mmap_close(map);
+        return false;
+    }
+
+    // Tools walk captures front to back
+    iq_mmap_advise(map, 0, 0, true);
+    return true;
+}
+
+size_t iq_mmap_read(const iq_mmap_t *map, size_t start, size_t count, float *output) {
+    if (!map || !map->raw || !output || start >= map->num_samples) {
+        return 0;
+    }
+
+    if (count > map->num_samples - start) {
+        count = map->num_samples - start;
+    }
+
+    const uint8_t *src = map->raw + start * iq_frame_bytes(map->format, map->channels);
+
+    // Page faults on the mapping land here too: mapped reads have no separate I/O step
+    uint64_t t = iq_profile_begin();
+    if (map->channels == 2) {
+        if (!iq_convert_to_float(src, count * iq_native_sample_bytes(map->format), map->format, output, count)) {
+            return 0;
+        }
+    } else {
+        // Mono WAV: I = audio sample, Q = 0
+        iq_convert_mono_to_float((const int16_t *)src, count, output);
+    }
+    iq_profile_end(IQ_PROFILE_CONVERT, t, count, count * iq_frame_bytes(map->format, map->channels));
+
+    return count;
+}
+
+const float *iq_mmap_block(iq_mmap_t *map, size_t start, size_t count, size_t *converted) {
+    if (converted) *converted = 0;
+    if (!map || count == 0) {
+        return NULL;
+    }
+
+    if (count > map->block_capacity) {
+        float *block = (float *)realloc(map->block, count * 2 * sizeof(float));
+        if (!block) {
+            fprintf(stderr, "Memory allocation failed for IQ block buffer\n");
+            return NULL;
+        }
+        map->block = block;
+        map->block_capacity = count;
+    }
+
+    size_t n = iq_mmap_read(map, start, count, map->block);
+    if (converted) *converted = n;
+    return n ? map->block : NULL;
+}
+
+const void *iq_mmap_raw(const iq_mmap_t *map, size_t start) {
+    if (!map || !map->raw || start >= map->num_samples) {
+        return NULL;
+    }
+    return map->raw + start * iq_frame_bytes(map->format, map->channels);
+}
+
+void iq_mmap_advise(const iq_mmap_t *map, size_t start, size_t count, bool will_need) {
+    if (!map || !map->map_base) {
+        return;
+    }
+
+#ifndef _WIN32
+    size_t frame_bytes = iq_frame_bytes(map->format, map->channels);
+    size_t offset = (size_t)(map->raw - map->map_base) + start * frame_bytes;
+    size_t length = count ? count * frame_bytes : map->map_bytes - offset;
+    if (offset >= map->map_bytes) return;
+    if (length > map->map_bytes - offset) length = map->map_bytes - offset;
+
+    // posix_madvise wants a page-aligned start
+    long page = sysconf(_SC_PAGESIZE);
+    size_t align = (page > 0) ? (size_t)page : 4096;
+    size_t head = offset % align;
+    void *addr = (void *)(map->map_base + offset - head);
+
+    if (count == 0 && will_need) {
+        posix_madvise(addr, length + head, POSIX_MADV_SEQUENTIAL);
+    } else {
+        posix_madvise(addr, length + head, will_need ? POSIX_MADV_WILLNEED : POSIX_MADV_DONTNEED);
+    }
+#else
+    // The Windows cache manager already reads ahead on sequential access
+    (void)start;
+    (void)count;
+    (void)will_need;
+#endif
+}
+
+void iq_mmap_close(iq_mmap_t *map) {
+    if (!map) {
+        return;
+    }
+
+    iq_mmap_unmap_file(map);
+    free(map->block);
+    map->block = NULL;
+    map->block_capacity = 0;
+    map->raw = NULL;
+    map->num_samples = 0;
+}
+
+// Internal: Map the whole file read-only
+static bool iq_mmap_map_file(iq_mmap_t *map, const char *filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "Error opening IQ file '%s' (error %lu)\n", filename, GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        fprintf(stderr, "Cannot map empty or unreadable file '%s'\n", filename);
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        fprintf(stderr, "Error mapping IQ file '%s' (error %lu)\n", filename, GetLastError());
+        CloseHandle(file);
+        return false;
+    }
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        fprintf(stderr, "Error mapping IQ file '%s' (error %lu)\n", filename, GetLastError());
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    map->map_base = (const uint8_t *)view;
+    map->map_bytes = (size_t)size.QuadPart;
+    map->os_file = (intptr_t)file;
+    map->os_mapping = (intptr_t)mapping;
+    return true;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening IQ file '%s': %s\n", filename, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        fprintf(stderr, "Cannot map empty or unreadable file '%s'\n", filename);
+        close(fd);
+        return false;
+    }
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        fprintf(stderr, "Error mapping IQ file '%s': %s\n", filename, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    map->map_base = (const uint8_t *)view;
+    map->map_bytes = (size_t)st.st_size;
+    map->os_file = fd;
+    return true;
+#endif
+}
+
+// Internal: Release the mapping and its handles
+static void iq_mmap_unmap_file(iq_mmap_t *map) {
+    if (!map->map_base) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(map->map_base);
+    CloseHandle((HANDLE)map->os_mapping);
+    CloseHandle((HANDLE)map->os_file);
+#else
+    munmap((void *)map->map_base, map->map_bytes);
+    close((int)map->os_file);
+#endif
+
+    map->map_base = NULL;
+    map->map_bytes = 0;
+    map->os_file = -1;
+    map->os_mapping = 0;
+}
+
+// Internal: Locate the PCM data inside a mapped WAV file
+static bool iq_mmap_parse_wav(iq_mmap_t *map, const char *filename) {
+    wav_header_t header;
+    if (map->map_bytes < sizeof(header)) {
+        fprintf(stderr, "Error reading WAV header from '%s'\n", filename);
+        return false;
+    }
+    memcpy(&header, map->map_base, sizeof(header));
+
+    uint64_t num_samples = 0;
+    if (!iq_wav_layout(&header, map->map_bytes, filename, &map->channels, &num_samples)) {
+        return false;
+    }
+
+    map->format = IQ_FORMAT_S16;
+    map->sample_rate = header.sample_rate;
+    map->raw = map->map_base + sizeof(header);
+    map->num_samples = (size_t)num_samples;
+    return true;
+}
+
+// Internal: 64-bit file positioning (plain fseek/ftell are 32-bit on Windows)
+static bool iq_file_seek(FILE *file, uint64_t offset, int whence) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, whence) == 0;
+#else
+    return fseeko(file, (off_t)offset, whence) == 0;
+#endif
+}
+
+static uint64_t iq_file_tell(FILE *file) {
+#ifdef _WIN32
+    __int64 pos = _ftelli64(file);
+#else
+    off_t pos = ftello(file);
+#endif
+    return (pos < 0) ? 0 : (uint64_t)pos;
+}
+
+// Internal: Validate a canonical 44-byte WAV header and size its PCM data
+static bool iq_wav_layout(const wav_header_t *header, uint64_t file_bytes, const char *filename,
+                          uint16_t *channels, uint64_t *num_samples) {
+    if (memcmp(header->riff, "RIFF", 4) != 0 ||
+        memcmp(header->wave, "WAVE", 4) != 0 ||
+        memcmp(header->fmt, "fmt ", 4) != 0 ||
+        memcmp(header->data, "data", 4) != 0) {
+        fprintf(stderr, "Invalid WAV header in '%s'\n", filename);
+        return false;
+    }
+
+    if (header->format != 1 || header->bits_per_sample != 16 ||
+        header->channels == 0 || header->channels > 2) {
+        fprintf(stderr, "Unsupported WAV layout in '%s' (16-bit PCM mono/stereo only)\n", filename);
+        return false;
+    }
+
+    // Trust the file length over a truncated or streaming-written data_size
+    uint64_t data_bytes = file_bytes > sizeof(*header) ? file_bytes - sizeof(*header) : 0;
+    if (header->data_size < data_bytes) {
+        data_bytes = header->data_size;
+    }
+
+    *channels = header->channels;
+    *num_samples = data_bytes / (header->channels * sizeof(int16_t));
+    return true;
+}
+
+// Published shared sources (see iq_source_publish for the threading rule)
+static const iq_source_t *iq_sources[IQ_MAX_SOURCES];
+
+// Internal: Anonymous read/write mapping of 'bytes' (NULL on failure)
+static void *iq_map_anonymous(size_t bytes) {
+#ifdef _WIN32
+    return VirtualAlloc(NULL, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#ifdef MAP_ANONYMOUS
+    void *view = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#else
+    // Strict POSIX has no MAP_ANONYMOUS; a private /dev/zero mapping is the same
+    int fd = open("/dev/zero", O_RDWR);
+    if (fd < 0) {
+        return NULL;
+    }
+    void *view = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+#endif
+    return view == MAP_FAILED ? NULL : view;
+#endif
+}
+
+static void iq_unmap_anonymous(void *view, size_t bytes) {
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(view, 0, MEM_RELEASE);
+#else
+    munmap(view, bytes);
+#endif
+}
+
+bool iq_source_load(iq_source_t *source, const char *filename) {
+    if (!source || !filename) {
+        return false;
+    }
+
+    memset(source, 0, sizeof(*source));
+    if (strlen(filename) >= sizeof(source->path)) {
+        fprintf(stderr, "IQ file path too long: %s\n", filename);
+        return false;
+    }
+
+    // Decode from the file itself even if another copy is published
+    iq_reader_t reader;
+    const iq_source_t *published = iq_source_find(filename);
+    if (published) {
+        iq_source_withdraw(published);
+    }
+    bool opened = iq_reader_open(&reader, filename);
+    if (published) {
+        iq_source_publish(published);
+    }
+    if (!opened) {
+        return false;
+    }
+
+    size_t num_samples = (size_t)reader.total_samples;
+    size_t bytes = num_samples * 2 * sizeof(float);
+    float *samples = (float *)iq_map_anonymous(bytes);
+    if (!samples) {
+        fprintf(stderr, "Cannot map %zu bytes for decoded IQ samples\n", bytes);
+        iq_reader_close(&reader);
+        return false;
+    }
+
+    size_t decoded = 0;
+    while (decoded < num_samples) {
+        size_t count = num_samples - decoded < IQ_BUFFER_SIZE ? num_samples - decoded : IQ_BUFFER_SIZE;
+        size_t n = iq_read_samples(&reader, samples + decoded * 2, count);
+        if (n == 0) break;
+        decoded += n;
+    }
+    iq_reader_close(&reader);
+
+    if (decoded != num_samples) {
+        fprintf(stderr, "Short read decoding '%s' (%zu of %zu samples)\n",
+                filename, decoded, num_samples);
+        iq_unmap_anonymous(samples, bytes);
+        return false;
+    }
+
+    strcpy(source->path, filename);
+    source->samples = samples;
+    source->num_samples = num_samples;
+    source->map_bytes = bytes;
+    source->format = reader.format;
+    source->sample_rate = reader.sample_rate;
+    return true;
+}
+
+bool iq_source_publish(const iq_source_t *source) {
+    if (!source || !source->samples || iq_source_find(source->path)) {
+        return false;
+    }
+
+    for (int i = 0; i < IQ_MAX_SOURCES; i++) {
+        if (!iq_sources[i]) {
+            iq_sources[i] = source;
+            return true;
+        }
+    }
+    return false;
+}
+
+void iq_source_withdraw(const iq_source_t *source) {
+    for (int i = 0; i < IQ_MAX_SOURCES; i++) {
+        if (iq_sources[i] == source) {
+            iq_sources[i] = NULL;
+        }
+    }
+}
+
+const iq_source_t *iq_source_find(const char *filename) {
+    if (!filename) {
+        return NULL;
+    }
+
+    for (int i = 0; i < IQ_MAX_SOURCES; i++) {
+        if (iq_sources[i] && strcmp(iq_sources[i]->path, filename) == 0) {
+            return iq_sources[i];
+        }
+    }
+    return NULL;
+}
+
+void iq_source_free(iq_source_t *source) {
+    if (!source) {
+        return;
+    }
+
+    iq_source_withdraw(source);
+    if (source->samples) {
+        iq_unmap_anonymous(source->samples, source->map_bytes);
+    }
+    source->samples = NULL;
+    source->num_samples = 0;
+    source->map_bytes = 0;
+}
+
+// Internal: Stream an IQZ container; its header gives the format and rate
+static bool iq_reader_open_compressed(iq_reader_t *reader, const char *filename) {
+    memset(reader, 0, sizeof(*reader));
+    reader->compressed = iqz_open(filename);
+    if (!reader->compressed) {
+        return false;
+    }
+
+    const iqz_info_t *info = iqz_info(reader->compressed);
+    reader->format = info->format;
+    reader->buffer_size = IQ_BUFFER_SIZE;
+    reader->channels = 2;
+    reader->sample_rate = info->sample_rate;
+    reader->total_samples = info->num_samples;
+    return true;
+}
+
+// Internal: Open a live source; 'format' is the default when the name sets none
+static bool iq_reader_open_stream(iq_reader_t *reader, const char *filename, iq_format_t format) {
+    memset(reader, 0, sizeof(*reader));
+    reader->stream = iq_stream_open(filename, &format, &reader->sample_rate);
+    if (!reader->stream) {
+        return false;
+    }
+
+    reader->format = format;
+    reader->buffer_size = IQ_BUFFER_SIZE;
+    reader->channels = 2;
+    reader->total_samples = 0;  // Unknown until the source ends
+    return true;
+}
+
+// Internal: Format named by a file extension; false if the name gives none
+static bool iq_format_from_name(const char *filename, iq_format_t *format) {
+    if (strstr(filename, ".wav") || strstr(filename, ".WAV") ||
+        strstr(filename, ".s16") || strstr(filename, ".iq16")) {
+        *format = IQ_FORMAT_S16; // WAV files are typically 16-bit
+    } else if (strstr(filename, ".s8") || strstr(filename, ".iq8")) {
+        *format = IQ_FORMAT_S8;
+    } else if (strstr(filename, ".s12") || strstr(filename, ".iq12") || strstr(filename, ".cs12")) {
+        *format = IQ_FORMAT_S12;
+    } else if (strstr(filename, ".s4") || strstr(filename, ".iq4") || strstr(filename, ".cs4")) {
+        *format = IQ_FORMAT_S4;
+    } else {
+        return false;
+    }
+    return true;
+}
 
 bool iq_reader_init(iq_reader_t *reader, const char *filename, iq_format_t format) {
     if (!reader || !filename) {
         return false;
     }
 
+    // Before any probe: bytes read from a pipe or socket cannot be put back
+    if (iq_stream_is_spec(filename) || iq_stream_is_pipe(filename)) {
+        return iq_reader_open_stream(reader, filename, format);
+    }
+
+    if (iqz_probe(filename)) {
+        return iq_reader_open_compressed(reader, filename);
+    }
+
+    memset(reader, 0, sizeof(*reader));
+
     // Open file in binary mode for raw IQ data
     reader->file = fopen(filename, "rb");
     if (!reader->file) {
@@ -95,60 +646,601 @@ bool iq_reader_init(iq_reader_t *reader, const char *filename, iq_format_t forma
     reader->buffer_size = IQ_BUFFER_SIZE;
     reader->bytes_read = 0;
     reader->eof = false;
+    reader->channels = 2;
+
+    uint64_t file_bytes = 0;
+    if (iq_file_seek(reader->file, 0, SEEK_END)) {
+        file_bytes = iq_file_tell(reader->file);
+    }
+    iq_file_seek(reader->file, 0, SEEK_SET);
+    reader->total_samples = file_bytes / iq_native_sample_bytes(format);
+
+    return true;
+}
+
+bool iq_reader_open(iq_reader_t *reader, const char *filename) {
+    if (!reader || !filename) {
+        return false;
+    }
+
+    // Stream a published decoded copy without touching the file
+    const iq_source_t *source = iq_source_find(filename);
+    if (source) {
+        memset(reader, 0, sizeof(*reader));
+        reader->source = source;
+        reader->format = source->format;
+        reader->buffer_size = IQ_BUFFER_SIZE;
+        reader->channels = 2;  // Mono WAV was expanded to Q = 0 when decoded
+        reader->sample_rate = source->sample_rate;
+        reader->total_samples = source->num_samples;
+        return true;
+    }
+
+    // Live sources take their format from their options, a pipe from its name
+    if (iq_stream_is_spec(filename) || iq_stream_is_pipe(filename)) {
+        iq_format_t format = IQ_FORMAT_S16;
+        iq_format_from_name(filename, &format);
+        return iq_reader_open_stream(reader, filename, format);
+    }
+
+    if (iqz_probe(filename)) {
+        if (!iq_reader_open_compressed(reader, filename)) {
+            return false;
+        }
+        if (reader->total_samples == 0) {
+            fprintf(stderr, "File too small to contain IQ data\n");
+            iq_reader_close(reader);
+            return false;
+        }
+        return true;
+    }
+
+    bool is_wav = strstr(filename, ".wav") || strstr(filename, ".WAV");
+    iq_format_t format = is_wav ? IQ_FORMAT_S16 : iq_detect_format(filename);
+    if (!iq_reader_init(reader, filename, format)) {
+        return false;
+    }
+
+    if (is_wav) {
+        uint64_t file_bytes = 0;
+        if (iq_file_seek(reader->file, 0, SEEK_END)) {
+            file_bytes = iq_file_tell(reader->file);
+        }
+        iq_file_seek(reader->file, 0, SEEK_SET);
+
+        wav_header_t header;
+        if (fread(&header, sizeof(header), 1, reader->file) != 1 ||
+            !iq_wav_layout(&header, file_bytes, filename, &reader->channels,
+                           &reader->total_samples)) {
+            iq_reader_close(reader);
+            return false;
+        }
+        reader->sample_rate = header.sample_rate;
+        reader->data_offset = sizeof(header);
+    }
+
+    if (reader->total_samples == 0) {
+        fprintf(stderr, "File too small to contain IQ data\n");
+        iq_reader_close(reader);
+        return false;
+    }
 
     return true;
 }
 
+// Internal: Next samples of a reader over a shared source (NULL at end)
+static const float *iq_source_next(iq_reader_t *reader, size_t max_samples, size_t *count) {
+    uint64_t left = reader->total_samples - reader->position;
+    *count = max_samples < left ? max_samples : (size_t)left;
+    if (*count < max_samples) {
+        reader->eof = true;
+    }
+    if (*count == 0) {
+        return NULL;
+    }
+
+    const float *samples = reader->source->samples + reader->position * 2;
+    reader->bytes_read += *count * iq_native_sample_bytes(reader->format);
+    reader->position += *count;
+    return samples;
+}
+
+// Internal: Raw bytes from the file or the live source
+static size_t iq_reader_read_raw(iq_reader_t *reader, void *buffer, size_t bytes) {
+    if (reader->stream) {
+        return iq_stream_read(reader->stream, buffer, bytes);
+    }
+    return fread(buffer, 1, bytes, reader->file);
+}
+
+// Internal: Decode native samples of an IQZ reader (0 at end or on a corrupt chunk)
+static size_t iq_compressed_next(iq_reader_t *reader, void *buffer, size_t max_samples) {
+    size_t count = iqz_read(reader->compressed, reader->position, buffer, max_samples);
+    if (count < max_samples) {
+        reader->eof = true;
+    }
+
+    reader->bytes_read += count * iq_native_sample_bytes(reader->format);
+    reader->position += count;
+    return count;
+}
+
 size_t iq_read_samples(iq_reader_t *reader, float *buffer, size_t max_samples) {
-    if (!reader || !reader->file || !buffer || reader->eof) {
+    if (!reader || (!reader->file && !reader->source && !reader->compressed && !reader->stream) || !buffer || reader->eof ||
+        max_samples == 0) {
         return 0;
     }
 
-    // Calculate bytes per complex sample (2 values: I and Q)
-    size_t bytes_per_sample = (reader->format == IQ_FORMAT_S8) ? 2 : 4;
+    if (reader->source) {
+        size_t count;
+        const float *samples = iq_source_next(reader, max_samples, &count);
+        if (samples) {
+            memcpy(buffer, samples, count * 2 * sizeof(float));
+        }
+        return count;
+    }
+
+    if (reader->compressed) {
+        size_t max_bytes = max_samples * iq_native_sample_bytes(reader->format);
+        if (max_bytes > reader->raw_capacity) {
+            uint8_t *raw = (uint8_t *)realloc(reader->raw_buffer, max_bytes);
+            if (!raw) {
+                fprintf(stderr, "Memory allocation failed for raw IQ buffer\n");
+                return 0;
+            }
+            reader->raw_buffer = raw;
+            reader->raw_capacity = max_bytes;
+        }
+
+        uint64_t t = iq_profile_begin();
+        size_t count = iq_compressed_next(reader, reader->raw_buffer, max_samples);
+        const size_t raw_bytes = count * iq_native_sample_bytes(reader->format);
+        iq_profile_end(IQ_PROFILE_READ, t, count, raw_bytes);
+        t = iq_profile_begin();
+        if (count > 0 &&
+            !iq_convert_to_float(reader->raw_buffer, raw_bytes, reader->format, buffer, count)) {
+            fprintf(stderr, "IQ conversion failed\n");
+            return 0;
+        }
+        iq_profile_end(IQ_PROFILE_CONVERT, t, count, raw_bytes);
+        return count;
+    }
+
+    // Calculate bytes per complex sample (2 values: I and Q; WAV mono has 1)
+    size_t bytes_per_sample = iq_frame_bytes(reader->format, reader->channels);
     size_t max_bytes = max_samples * bytes_per_sample;
 
-    // Allocate temporary buffer for raw bytes
-    uint8_t *raw_buffer = (uint8_t *)malloc(max_bytes);
-    if (!raw_buffer) {
-        fprintf(stderr, "Memory allocation failed for raw IQ buffer\n");
-        return 0;
+    // Reuse the raw buffer across reads
+    if (max_bytes > reader->raw_capacity) {
+        uint8_t *raw = (uint8_t *)realloc(reader->raw_buffer, max_bytes);
+        if (!raw) {
+            fprintf(stderr, "Memory allocation failed for raw IQ buffer\n");
+            return 0;
+        }
+        reader->raw_buffer = raw;
+        reader->raw_capacity = max_bytes;
     }
 
     // Read raw bytes from file
-    size_t bytes_to_read = max_bytes;
-    size_t bytes_read = fread(raw_buffer, 1, bytes_to_read, reader->file);
+    uint64_t t = iq_profile_begin();
+    size_t bytes_read = iq_reader_read_raw(reader, reader->raw_buffer, max_bytes);
+    if (bytes_read < max_bytes) {
+        reader->eof = true;
+    }
 
-    if (bytes_read == 0) {
-        if (feof(reader->file)) {
-            reader->eof = true;
-        }
-        free(raw_buffer);
+    size_t samples_read = bytes_read / bytes_per_sample;
+    iq_profile_end(IQ_PROFILE_READ, t, samples_read, bytes_read);
+    if (samples_read == 0) {
         return 0;
     }
 
     // Convert bytes to float samples
+    t = iq_profile_begin();
+    if (reader->channels == 2) {
+        if (!iq_convert_to_float(reader->raw_buffer, samples_read * bytes_per_sample,
+                                 reader->format, buffer, samples_read)) {
+            fprintf(stderr, "IQ conversion failed\n");
+            return 0;
+        }
+    } else {
+        // Mono WAV: I = audio sample, Q = 0
+        iq_convert_mono_to_float((const int16_t *)reader->raw_buffer, samples_read, buffer);
+    }
+    iq_profile_end(IQ_PROFILE_CONVERT, t, samples_read, bytes_read);
+
+    reader->bytes_read += bytes_read;
+    reader->position += samples_read;
+    return samples_read;
+}
+
+size_t iq_native_sample_bytes(iq_format_t format) {
+    switch (format) {
+        case IQ_FORMAT_S8:  return 2;
+        case IQ_FORMAT_S12: return 3;
+        case IQ_FORMAT_S4:  return 1;
+        default:            return 4;
+    }
+}
+
+unsigned iq_format_bits(iq_format_t format) {
+    switch (format) {
+        case IQ_FORMAT_S8:  return 8;
+        case IQ_FORMAT_S12: return 12;
+        case IQ_FORMAT_S4:  return 4;
+        default:            return 16;
+    }
+}
+
+bool iq_parse_format(const char *name, iq_format_t *format) {
+    static const iq_format_t formats[] = { IQ_FORMAT_S8, IQ_FORMAT_S16, IQ_FORMAT_S12, IQ_FORMAT_S4 };
+    if (!name || !format) {
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcmp(name, iq_format_name(formats[i])) == 0) {
+            *format = formats[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *iq_format_name(iq_format_t format) {
+    switch (format) {
+        case IQ_FORMAT_S8:  return "s8";
+        case IQ_FORMAT_S12: return "s12";
+        case IQ_FORMAT_S4:  return "s4";
+        default:            return "s16";
+    }
+}
+
+// Internal: Bytes per frame on disk (mono WAV frames hold a single s16 value)
+static size_t iq_frame_bytes(iq_format_t format, uint16_t channels) {
+    return (channels == 2) ? iq_native_sample_bytes(format) : 2;
+}
+
+size_t iq_read_native(iq_reader_t *reader, void *buffer, size_t max_samples) {
+    if (!reader || (!reader->file && !reader->source && !reader->compressed && !reader->stream) || !buffer || reader->eof ||
+        max_samples == 0) {
+        return 0;
+    }
+
+    if (reader->source) {
+        // Decoded values are k/128, k/32768, k/2048 or k/8 exactly: scaling back is lossless
+        size_t count;
+        const float *samples = iq_source_next(reader, max_samples, &count);
+        if (reader->format == IQ_FORMAT_S8) {
+            int8_t *out = (int8_t *)buffer;
+            for (size_t i = 0; i < count * 2; i++) out[i] = (int8_t)lrintf(samples[i] * 128.0f);
+        } else if (reader->format == IQ_FORMAT_S16) {
+            int16_t *out = (int16_t *)buffer;
+            for (size_t i = 0; i < count * 2; i++) out[i] = (int16_t)lrintf(samples[i] * 32768.0f);
+        } else {
+            // Pack a block at a time through the stack
+            enum { PACK_BLOCK = 512 };
+            int16_t values[PACK_BLOCK * 2];
+            int8_t nibbles[PACK_BLOCK * 2];
+            uint8_t *out = (uint8_t *)buffer;
+            size_t sample_bytes = iq_native_sample_bytes(reader->format);
+            for (size_t start = 0; start < count; start += PACK_BLOCK) {
+                size_t n = count - start < PACK_BLOCK ? count - start : PACK_BLOCK;
+                const float *in = samples + start * 2;
+                if (reader->format == IQ_FORMAT_S12) {
+                    for (size_t i = 0; i < n * 2; i++) values[i] = (int16_t)lrintf(in[i] * 2048.0f);
+                    iq_pack_s12(values, n * 2, out + start * sample_bytes);
+                } else {
+                    for (size_t i = 0; i < n * 2; i++) nibbles[i] = (int8_t)lrintf(in[i] * 8.0f);
+                    iq_pack_s4(nibbles, n * 2, out + start * sample_bytes);
+                }
+            }
+        }
+        return count;
+    }
+
+    if (reader->compressed) {
+        uint64_t t = iq_profile_begin();
+        size_t count = iq_compressed_next(reader, buffer, max_samples);
+        iq_profile_end(IQ_PROFILE_READ, t, count, count * iq_native_sample_bytes(reader->format));
+        return count;
+    }
+
+    size_t bytes_per_sample = iq_frame_bytes(reader->format, reader->channels);
+    size_t max_bytes = max_samples * bytes_per_sample;
+
+    // Interleaved files are already in native layout: read straight into the caller's buffer
+    uint8_t *dest = (uint8_t *)buffer;
+    if (reader->channels != 2) {
+        if (max_bytes > reader->raw_capacity) {
+            uint8_t *raw = (uint8_t *)realloc(reader->raw_buffer, max_bytes);
+            if (!raw) {
+                fprintf(stderr, "Memory allocation failed for raw IQ buffer\n");
+                return 0;
+            }
+            reader->raw_buffer = raw;
+            reader->raw_capacity = max_bytes;
+        }
+        dest = reader->raw_buffer;
+    }
+
+    uint64_t t = iq_profile_begin();
+    size_t bytes_read = iq_reader_read_raw(reader, dest, max_bytes);
+    if (bytes_read < max_bytes) {
+        reader->eof = true;
+    }
+
     size_t samples_read = bytes_read / bytes_per_sample;
-    bool conversion_ok = iq_convert_to_float(raw_buffer, bytes_read,
-                                           reader->format, buffer, samples_read);
+    iq_profile_end(IQ_PROFILE_READ, t, samples_read, bytes_read);
+    if (samples_read == 0) {
+        return 0;
+    }
 
-    free(raw_buffer);
+    if (reader->channels != 2) {
+        // Mono WAV: I = audio sample, Q = 0
+        const int16_t *mono = (const int16_t *)reader->raw_buffer;
+        int16_t *out = (int16_t *)buffer;
+        for (size_t i = 0; i < samples_read; i++) {
+            out[i * 2] = mono[i];
+            out[i * 2 + 1] = 0;
+        }
+    }
 
-    if (!conversion_ok) {
-        fprintf(stderr, "IQ conversion failed\n");
+    reader->bytes_read += bytes_read;
+    reader->position += samples_read;
+    return samples_read;
+}
+
+bool iq_reader_seek_sample(iq_reader_t *reader, uint64_t sample) {
+    if (!reader || (!reader->file && !reader->source && !reader->compressed && !reader->stream)) {
+        return false;
+    }
+
+    if (reader->total_samples && sample > reader->total_samples) {
+        reader->position = reader->total_samples;
+        reader->eof = true;
+        return false;
+    }
+
+    // Chunks are found from the sample index when the next read decodes
+    if (reader->source || reader->compressed) {
+        reader->position = sample;
+        reader->eof = false;
+        return true;
+    }
+
+    // A live source only moves forward, by reading what lies in between
+    if (reader->stream) {
+        if (sample < reader->position) {
+            fprintf(stderr, "Error: Cannot seek back in a live stream\n");
+            return false;
+        }
+        uint8_t discard[16384];
+        uint64_t left = (sample - reader->position) * iq_native_sample_bytes(reader->format);
+        while (left > 0) {
+            size_t want = left < sizeof(discard) ? (size_t)left : sizeof(discard);
+            size_t got = iq_stream_read(reader->stream, discard, want);
+            reader->bytes_read += got;
+            left -= got;
+            if (got < want) {
+                reader->position = sample - left / iq_native_sample_bytes(reader->format);
+                reader->eof = true;
+                return false;
+            }
+        }
+        reader->position = sample;
+        return true;
+    }
+
+    // Fixed-width frames: the byte offset follows directly from the index
+    uint64_t offset = reader->data_offset + sample * iq_frame_bytes(reader->format, reader->channels);
+    if (!iq_file_seek(reader->file, offset, SEEK_SET)) {
+        return false;
+    }
+
+    reader->position = sample;
+    reader->eof = false;
+    return true;
+}
+
+bool iq_reader_skip(iq_reader_t *reader, uint64_t num_samples) {
+    if (!reader) {
+        return false;
+    }
+
+    return iq_reader_seek_sample(reader, reader->position + num_samples);
+}
+
+size_t iq_reader_refill(iq_reader_t *reader, float *buffer, size_t valid,
+                        size_t consumed, size_t capacity) {
+    if (!reader || !buffer) {
         return 0;
     }
 
-    reader->bytes_read += bytes_read;
-    return samples_read;
+    // Keep the overlap, or skip the part of the hop that was never buffered
+    size_t keep = 0;
+    if (consumed < valid) {
+        keep = valid - consumed;
+        memmove(buffer, buffer + consumed * 2, keep * 2 * sizeof(float));
+    } else if (consumed > valid) {
+        if (!iq_reader_skip(reader, consumed - valid)) {
+            return 0;
+        }
+    }
+
+    // Top up behind the overlap; short reads mean end of file
+    while (keep < capacity) {
+        size_t n = iq_read_samples(reader, buffer + keep * 2, capacity - keep);
+        if (n == 0) break;
+        keep += n;
+    }
+
+    return keep;
+}
+
+bool iq_block_init(iq_block_t *block, iq_reader_t *reader, size_t capacity) {
+    if (!block || !reader || capacity == 0) {
+        return false;
+    }
+
+    memset(block, 0, sizeof(*block));
+    block->data = (float *)iq_huge_alloc(capacity * 2 * sizeof(float));
+    if (!block->data) {
+        fprintf(stderr, "Memory allocation failed for IQ block\n");
+        return false;
+    }
+
+    block->reader = reader;
+    block->capacity = capacity;
+    block->start = reader->position;
+    return true;
+}
+
+const float *iq_block_span(iq_block_t *block, uint64_t offset, size_t length) {
+    if (!block || !block->data || offset < block->start || length > block->capacity) {
+        return NULL;
+    }
+
+    if (offset + length > block->start + block->valid) {
+        size_t consumed = (size_t)(offset - block->start);
+        block->valid = iq_reader_refill(block->reader, block->data, block->valid,
+                                        consumed, block->capacity);
+        block->start = offset;
+        if (block->valid < length) {
+            return NULL;
+        }
+    }
+
+    return block->data + (size_t)(offset - block->start) * 2;
+}
+
+bool iq_block_init_native(iq_block_t *block, iq_reader_t *reader, size_t capacity) {
+    if (!block || !reader || capacity == 0) {
+        return false;
+    }
+
+    memset(block, 0, sizeof(*block));
+    block->native = iq_huge_alloc(capacity * iq_native_sample_bytes(reader->format));
+    if (!block->native) {
+        fprintf(stderr, "Memory allocation failed for IQ block\n");
+        return false;
+    }
+
+    block->reader = reader;
+    block->format = reader->format;
+    block->capacity = capacity;
+    block->start = reader->position;
+    return true;
+}
+
+const void *iq_block_span_native(iq_block_t *block, uint64_t offset, size_t length) {
+    if (!block || !block->native || offset < block->start || length > block->capacity) {
+        return NULL;
+    }
+
+    size_t sample_bytes = iq_native_sample_bytes(block->reader->format);
+    uint8_t *data = (uint8_t *)block->native;
+
+    if (offset + length > block->start + block->valid) {
+        // Same carry-over as iq_reader_refill, in native bytes
+        size_t consumed = (size_t)(offset - block->start);
+        size_t keep = 0;
+        if (consumed < block->valid) {
+            keep = block->valid - consumed;
+            memmove(data, data + consumed * sample_bytes, keep * sample_bytes);
+        } else if (consumed > block->valid &&
+                   !iq_reader_skip(block->reader, consumed - block->valid)) {
+            block->valid = 0;
+            block->start = offset;
+            return NULL;
+        }
+
+        while (keep < block->capacity) {
+            size_t n = iq_read_native(block->reader, data + keep * sample_bytes, block->capacity - keep);
+            if (n == 0) break;
+            keep += n;
+        }
+
+        block->valid = keep;
+        block->start = offset;
+        if (block->valid < length) {
+            return NULL;
+        }
+    }
+
+    return data + (size_t)(offset - block->start) * sample_bytes;
+}
+
+bool iq_block_rebind(iq_block_t *block, iq_reader_t *reader) {
+    if (!block || !reader || (!block->data && !block->native)) {
+        return false;
+    }
+
+    if (block->native) {
+        // The buffer is kept when the width is unchanged
+        if (iq_native_sample_bytes(reader->format) != iq_native_sample_bytes(block->format)) {
+            void *native = iq_huge_alloc(block->capacity * iq_native_sample_bytes(reader->format));
+            if (!native) {
+                fprintf(stderr, "Memory allocation failed for IQ block\n");
+                return false;
+            }
+            iq_huge_free(block->native);
+            block->native = native;
+        }
+        block->format = reader->format;
+    }
+
+    block->reader = reader;
+    block->start = reader->position;
+    block->valid = 0;
+    return true;
+}
+
+bool iq_block_continue(iq_block_t *block, iq_reader_t *reader) {
+    if (!block || !reader || (!block->data && !block->native)) {
+        return false;
+    }
+    if (block->native && reader->format != block->format) {
+        fprintf(stderr, "Segment format %s does not match the stream (%s)\n",
+                iq_format_name(reader->format), iq_format_name(block->format));
+        return false;
+    }
+
+    // Offsets are the block's own; only the source of the next refill changes
+    block->reader = reader;
+    return true;
+}
+
+void iq_block_free(iq_block_t *block) {
+    if (!block) {
+        return;
+    }
+
+    iq_huge_free(block->data);
+    iq_huge_free(block->native);
+    block->data = NULL;
+    block->native = NULL;
+    block->capacity = 0;
+    block->valid = 0;
 }
 
 void iq_reader_close(iq_reader_t *reader) {
-    if (reader && reader->file) {
+    if (!reader) {
+        return;
+    }
+
+    if (reader->file) {
         fclose(reader->file);
         reader->file = NULL;
-        reader->eof = true;
     }
+    free(reader->raw_buffer);
+    reader->raw_buffer = NULL;
+    reader->raw_capacity = 0;
+    reader->source = NULL;
+    iqz_close(reader->compressed);
+    reader->compressed = NULL;
+    iq_stream_close(reader->stream);
+    reader->stream = NULL;
+    reader->eof = true;
 }
 
 bool iq_load_file(const char *filename, iq_data_t *iq_data) {
@@ -156,73 +1248,91 @@ bool iq_load_file(const char *filename, iq_data_t *iq_data) {
         return false;
     }
 
+    // A published decoded copy only needs copying
+    const iq_source_t *source = iq_source_find(filename);
+    if (source) {
+        iq_data->data = (float *)iq_huge_alloc(source->num_samples * 2 * sizeof(float));
+        if (!iq_data->data) {
+            fprintf(stderr, "Memory allocation failed for IQ data\n");
+            return false;
+        }
+        memcpy(iq_data->data, source->samples, source->num_samples * 2 * sizeof(float));
+        iq_data->num_samples = source->num_samples;
+        iq_data->format = source->format;
+        iq_data->sample_rate = source->sample_rate;
+        return true;
+    }
+
     // Check if it's a WAV file first
     if (strstr(filename, ".wav") || strstr(filename, ".WAV")) {
         return iq_load_wav_file(filename, iq_data);
     }
 
-    // Get file size
-    size_t file_size = iq_get_file_size(filename);
-    if (file_size == 0) {
-        return false;
-    }
+    // Compressed containers decode chunk by chunk through a reader
+    if (iqz_probe(filename)) {
+        iq_reader_t reader;
+        if (!iq_reader_open(&reader, filename)) {
+            return false;
+        }
 
-    // Auto-detect format
-    iq_format_t format = iq_detect_format(filename);
-    size_t bytes_per_sample = (format == IQ_FORMAT_S8) ? 2 : 4;
-    size_t num_samples = file_size / bytes_per_sample;
+        size_t num_samples = (size_t)reader.total_samples;
+        iq_data->data = (float *)iq_huge_alloc(num_samples * 2 * sizeof(float));
+        if (!iq_data->data) {
+            fprintf(stderr, "Memory allocation failed for IQ data\n");
+            iq_reader_close(&reader);
+            return false;
+        }
 
-    if (num_samples == 0) {
-        fprintf(stderr, "File too small to contain IQ data\n");
-        return false;
-    }
+        size_t done = 0;
+        while (done < num_samples) {
+            size_t want = num_samples - done < IQ_BUFFER_SIZE ? num_samples - done : IQ_BUFFER_SIZE;
+            size_t n = iq_read_samples(&reader, iq_data->data + done * 2, want);
+            if (n == 0) break;
+            done += n;
+        }
 
-    // Allocate memory for float data (2 floats per complex sample)
-    iq_data->data = (float *)malloc(num_samples * 2 * sizeof(float));
-    if (!iq_data->data) {
-        fprintf(stderr, "Memory allocation failed for IQ data\n");
-        return false;
-    }
+        iq_data->num_samples = num_samples;
+        iq_data->format = reader.format;
+        iq_data->sample_rate = reader.sample_rate;
+        iq_reader_close(&reader);
 
-    // Read entire file into memory
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        fprintf(stderr, "Error opening file '%s': %s\n", filename, strerror(errno));
-        free(iq_data->data);
-        iq_data->data = NULL;
-        return false;
+        if (done < num_samples) {
+            fprintf(stderr, "IQZ file '%s' ended after %zu of %zu samples\n", filename, done, num_samples);
+            iq_free(iq_data);
+            return false;
+        }
+        return true;
     }
 
-    // Allocate temporary buffer for raw data
-    uint8_t *raw_data = (uint8_t *)malloc(file_size);
-    if (!raw_data) {
-        fprintf(stderr, "Memory allocation failed for raw data buffer\n");
-        fclose(file);
-        free(iq_data->data);
-        iq_data->data = NULL;
+    // Map the file so the only raw copy is the page cache
+    iq_mmap_t map;
+    if (!iq_mmap_open(&map, filename)) {
         return false;
     }
 
-    size_t bytes_read = fread(raw_data, 1, file_size, file);
-    fclose(file);
+    iq_format_t format = map.format;
+    size_t num_samples = map.num_samples;
 
-    if (bytes_read != file_size) {
-        fprintf(stderr, "Incomplete file read: expected %zu bytes, got %zu\n",
-                file_size, bytes_read);
-        free(raw_data);
-        free(iq_data->data);
-        iq_data->data = NULL;
+    // Allocate memory for float data (2 floats per complex sample)
+    iq_data->data = (float *)iq_huge_alloc(num_samples * 2 * sizeof(float));
+    if (!iq_data->data) {
+        fprintf(stderr, "Memory allocation failed for IQ data\n");
+        iq_mmap_close(&map);
         return false;
     }
 
-    // Convert to float
-    bool conversion_ok = iq_convert_to_float(raw_data, file_size, format,
-                                           iq_data->data, num_samples);
+    // Convert block by block, dropping pages behind the cursor
+    bool conversion_ok = true;
+    for (size_t start = 0; start < num_samples && conversion_ok; start += IQ_BUFFER_SIZE) {
+        size_t count = num_samples - start < IQ_BUFFER_SIZE ? num_samples - start : IQ_BUFFER_SIZE;
+        conversion_ok = iq_mmap_read(&map, start, count, iq_data->data + start * 2) == count;
+        iq_mmap_advise(&map, start, count, false);
+    }
 
-    free(raw_data);
+    iq_mmap_close(&map);
 
     if (!conversion_ok) {
-        free(iq_data->data);
+        iq_huge_free(iq_data->data);
         iq_data->data = NULL;
         return false;
     }
@@ -237,7 +1347,7 @@ bool iq_load_file(const char *filename, iq_data_t *iq_data) {
 
 void iq_free(iq_data_t *iq_data) {
     if (iq_data && iq_data->data) {
-        free(iq_data->data);
+        iq_huge_free(iq_data->data);
         iq_data->data = NULL;
         iq_data->num_samples = 0;
     }
@@ -250,7 +1360,7 @@ bool iq_convert_to_float(const uint8_t *raw_data, size_t num_bytes,
         return false;
     }
 
-    size_t bytes_per_sample = (format == IQ_FORMAT_S8) ? 2 : 4;
+    size_t bytes_per_sample = iq_native_sample_bytes(format);
     size_t expected_samples = num_bytes / bytes_per_sample;
 
     if (expected_samples > max_samples) {
@@ -259,25 +1369,55 @@ bool iq_convert_to_float(const uint8_t *raw_data, size_t num_bytes,
         return false;
     }
 
+    // Each complex sample is two values, converted as one flat stream
     if (format == IQ_FORMAT_S8) {
-        // Convert s8 to float [-1,1]
-        const int8_t *s8_data = (const int8_t *)raw_data;
-
-        for (size_t i = 0; i < expected_samples; i++) {
-            // I component
-            output[i * 2] = (float)s8_data[i * 2] / 128.0f;
-            // Q component
-            output[i * 2 + 1] = (float)s8_data[i * 2 + 1] / 128.0f;
-        }
+        iq_s8_to_f32((const int8_t *)raw_data, output, expected_samples * 2);
     } else if (format == IQ_FORMAT_S16) {
-        // Convert s16 to float [-1,1]
-        const int16_t *s16_data = (const int16_t *)raw_data;
+        iq_s16_to_f32((const int16_t *)raw_data, output, expected_samples * 2);
+    } else if (format == IQ_FORMAT_S12) {
+        iq_s12_to_f32(raw_data, output, expected_samples * 2);
+    } else if (format == IQ_FORMAT_S4) {
+        iq_s4_to_f32(raw_data, output, expected_samples * 2);
+    } else {
+        fprintf(stderr, "Unsupported IQ format\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool iq_convert_to_complex(const uint8_t *raw_data, size_t num_bytes,
+                           iq_format_t format, double complex *output, size_t max_samples) {
 
-        for (size_t i = 0; i < expected_samples; i++) {
-            // I component
-            output[i * 2] = (float)s16_data[i * 2] / 32768.0f;
-            // Q component
-            output[i * 2 + 1] = (float)s16_data[i * 2 + 1] / 32768.0f;
+    if (!raw_data || !output) {
+        return false;
+    }
+
+    size_t bytes_per_sample = iq_native_sample_bytes(format);
+    size_t expected_samples = num_bytes / bytes_per_sample;
+
+    if (expected_samples > max_samples) {
+        fprintf(stderr, "Buffer too small: need %zu samples, have %zu\n",
+                expected_samples, max_samples);
+        return false;
+    }
+
+    // double complex is laid out as { re, im }, i.e. interleaved I/Q doubles
+    double *out = (double *)output;
+    if (format == IQ_FORMAT_S8) {
+        iq_s8_to_f64((const int8_t *)raw_data, out, expected_samples * 2);
+    } else if (format == IQ_FORMAT_S16) {
+        iq_s16_to_f64((const int16_t *)raw_data, out, expected_samples * 2);
+    } else if (format == IQ_FORMAT_S12 || format == IQ_FORMAT_S4) {
+        // Packed values are exact in float, so widening the float result is exact too
+        enum { WIDEN_BLOCK = 1024 };
+        float block[WIDEN_BLOCK * 2];
+        for (size_t start = 0; start < expected_samples; start += WIDEN_BLOCK) {
+            size_t n = expected_samples - start < WIDEN_BLOCK ? expected_samples - start : WIDEN_BLOCK;
+            iq_convert_to_float(raw_data + start * bytes_per_sample, n * bytes_per_sample, format, block, n);
+            for (size_t i = 0; i < n * 2; i++) {
+                out[start * 2 + i] = (double)block[i];
+            }
         }
     } else {
         fprintf(stderr, "Unsupported IQ format\n");
@@ -350,7 +1490,7 @@ bool iq_load_wav_file(const char *filename, iq_data_t *iq_data) {
     }
 
     // Allocate memory for IQ data (always 2 floats per complex sample)
-    iq_data->data = (float *)malloc(num_samples * 2 * sizeof(float));
+    iq_data->data = (float *)iq_huge_alloc(num_samples * 2 * sizeof(float));
     if (!iq_data->data) {
         fprintf(stderr, "Memory allocation failed for WAV IQ data\n");
         fclose(file);
@@ -362,7 +1502,7 @@ bool iq_load_wav_file(const char *filename, iq_data_t *iq_data) {
     int16_t *wav_buffer = (int16_t *)malloc(buffer_size * sizeof(int16_t));
     if (!wav_buffer) {
         fprintf(stderr, "Memory allocation failed for WAV buffer\n");
-        free(iq_data->data);
+        iq_huge_free(iq_data->data);
         iq_data->data = NULL;
         fclose(file);
         return false;
@@ -376,22 +1516,18 @@ bool iq_load_wav_file(const char *filename, iq_data_t *iq_data) {
         fprintf(stderr, "Incomplete WAV data read: expected %zu samples, got %zu\n",
                 buffer_size, samples_read);
         free(wav_buffer);
-        free(iq_data->data);
+        iq_huge_free(iq_data->data);
         iq_data->data = NULL;
         return false;
     }
 
     // Convert WAV to IQ format
-    for (size_t i = 0; i < num_samples; i++) {
-        if (header.channels == 1) {
-            // Mono: I = audio sample, Q = 0
-            iq_data->data[i * 2] = (float)wav_buffer[i] / 32768.0f;     // I component
-            iq_data->data[i * 2 + 1] = 0.0f;                           // Q component
-        } else {
-            // Stereo: left = I, right = Q
-            iq_data->data[i * 2] = (float)wav_buffer[i * 2] / 32768.0f;       // I component
-            iq_data->data[i * 2 + 1] = (float)wav_buffer[i * 2 + 1] / 32768.0f; // Q component
-        }
+    if (header.channels == 1) {
+        // Mono: I = audio sample, Q = 0
+        iq_convert_mono_to_float(wav_buffer, num_samples, iq_data->data);
+    } else {
+        // Stereo: left = I, right = Q
+        iq_s16_to_f32(wav_buffer, iq_data->data, num_samples * 2);
     }
 
     free(wav_buffer);
@@ -419,62 +1555,40 @@ bool iq_data_save_file(const char *filename, const iq_data_t *iq_data) {
         return false;
     }
 
-    bool success = false;
-    uint8_t *buffer = NULL;
+    bool success = iq_write_samples(file, iq_data->data, iq_data->num_samples, iq_data->format);
 
-    // Allocate buffer for raw data
-    size_t raw_bytes_per_sample = (iq_data->format == IQ_FORMAT_S8) ? 1 : 2;
-    size_t total_raw_bytes = iq_data->num_samples * 2 * raw_bytes_per_sample; // *2 for I+Q
+    if (fclose(file) != 0) {
+        success = false;
+    }
+    return success;
+}
 
-    buffer = malloc(total_raw_bytes);
-    if (!buffer) {
-        fclose(file);
+/*
+ * Append float IQ samples to an open file in raw s8/s16/s12/s4 format
+ * Converts through a fixed stack block so memory use does not grow with
+ * the number of samples written.
+ */
+bool iq_write_samples(FILE *file, const float *samples, size_t num_samples, iq_format_t format) {
+    if (!file || (!samples && num_samples > 0)) {
         return false;
     }
 
-    // Convert normalized float [-1,1] to raw format
-    if (iq_data->format == IQ_FORMAT_S8) {
-        // Convert to 8-bit signed
-        for (size_t i = 0; i < iq_data->num_samples; i++) {
-            float i_val = iq_data->data[i * 2] * 127.0f;     // I component
-            float q_val = iq_data->data[i * 2 + 1] * 127.0f; // Q component
+    enum { WRITE_BLOCK = 4096 };   // Complex samples per fwrite
+    int16_t buffer_16[WRITE_BLOCK * 2];
 
-            // Clamp to valid range
-            if (i_val > 127.0f) i_val = 127.0f;
-            if (i_val < -128.0f) i_val = -128.0f;
-            if (q_val > 127.0f) q_val = 127.0f;
-            if (q_val < -128.0f) q_val = -128.0f;
-
-            buffer[i * 2] = (int8_t)i_val;         // I as 8-bit signed
-            buffer[i * 2 + 1] = (int8_t)q_val;     // Q as 8-bit signed
-        }
-    } else {
-        // Convert to 16-bit signed
-        for (size_t i = 0; i < iq_data->num_samples; i++) {
-            float i_val = iq_data->data[i * 2] * 32767.0f;     // I component
-            float q_val = iq_data->data[i * 2 + 1] * 32767.0f; // Q component
+    for (size_t start = 0; start < num_samples; start += WRITE_BLOCK) {
+        size_t count = num_samples - start < WRITE_BLOCK ? num_samples - start : WRITE_BLOCK;
+        size_t bytes = count * iq_native_sample_bytes(format);
 
-            // Clamp to valid range
-            if (i_val > 32767.0f) i_val = 32767.0f;
-            if (i_val < -32768.0f) i_val = -32768.0f;
-            if (q_val > 32767.0f) q_val = 32767.0f;
-            if (q_val < -32768.0f) q_val = -32768.0f;
+        // Convert normalized float [-1,1] to raw format
+        iq_convert_from_float(samples + start * 2, count * 2, format, buffer_16);
 
-            int16_t *buffer_16 = (int16_t *)buffer;
-            buffer_16[i * 2] = (int16_t)i_val;         // I as 16-bit signed
-            buffer_16[i * 2 + 1] = (int16_t)q_val;     // Q as 16-bit signed
+        if (fwrite(buffer_16, 1, bytes, file) != bytes) {
+            return false;
         }
     }
 
-    // Write the raw data to file
-    size_t bytes_written = fwrite(buffer, 1, total_raw_bytes, file);
-    if (bytes_written == total_raw_bytes) {
-        success = true;
-    }
-
-    free(buffer);
-    fclose(file);
-    return success;
+    return true;
 }
 
 size_t iq_get_file_size(const char *filename) {
@@ -505,16 +1619,9 @@ iq_format_t iq_detect_format(const char *filename) {
     }
 
     // First check file extension hints
-    if (strstr(filename, ".wav") || strstr(filename, ".WAV")) {
-        return IQ_FORMAT_S16; // WAV files are typically 16-bit
-    }
-
-    if (strstr(filename, ".s16") || strstr(filename, ".iq16")) {
-        return IQ_FORMAT_S16;
-    }
-
-    if (strstr(filename, ".s8") || strstr(filename, ".iq8")) {
-        return IQ_FORMAT_S8;
+    iq_format_t named;
+    if (iq_format_from_name(filename, &named)) {
+        return named;
     }
 
     // For files without explicit format hints, analyze content
@@ -647,3 +1754,782 @@ iq_format_t iq_detect_format(const char *filename) {
     // Final fallback
     return IQ_FORMAT_S16;
 }
+
+/*
+ * =============================================================================
+ * Sample conversion kernels
+ * =============================================================================
+ *
+ * Raw IQ is a flat stream of signed values; s8 scales by 1/128 and s16 by
+ * 1/32768. Both are powers of two, so multiplying instead of dividing and
+ * widening through int32 in SIMD lanes is exact: every kernel family gives
+ * bit-identical output to the scalar loop. The way back (scale by 127 or
+ * 32767, clamp, truncate) uses the same IEEE multiply, min/max and truncating
+ * conversion in every family, so it matches the scalar loop for all finite
+ * input. Each SIMD kernel returns how many values it handled and the scalar
+ * loop finishes the tail.
+ *
+ * Packed s12 and s4 unpack in the register: s12 gathers each 3-byte pair
+ * into an int32 lane and extracts I and Q with shift pairs, s4 sign-shifts
+ * the two nibbles out of each byte. Their scales (1/2048, 1/8) are powers
+ * of two as well, so the same bit-identical guarantee holds. Packing back is
+ * scalar; the write path is not where packed formats pay off.
+ */
+
+static const float IQ_S8_SCALE = 1.0f / 128.0f;
+static const float IQ_S16_SCALE = 1.0f / 32768.0f;
+static const float IQ_S12_SCALE = 1.0f / 2048.0f;
+static const float IQ_S4_SCALE = 1.0f / 8.0f;
+
+// -1 until the first conversion detects the CPU
+static atomic_int iq_simd_active = -1;
+
+static iq_simd_t iq_simd_detect(void) {
+#if defined(IQ_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx2")) {
+        return IQ_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return IQ_SIMD_SSE2;
+    }
+    return IQ_SIMD_NONE;
+#elif defined(IQ_HAVE_NEON)
+    return IQ_SIMD_NEON;   // AdvSIMD is mandatory on AArch64
+#else
+    return IQ_SIMD_NONE;
+#endif
+}
+
+iq_simd_t iq_convert_simd(void) {
+    int simd = atomic_load(&iq_simd_active);
+    if (simd < 0) {
+        simd = (int)iq_simd_detect();
+        atomic_store(&iq_simd_active, simd);
+    }
+    return (iq_simd_t)simd;
+}
+
+void iq_convert_set_simd(iq_simd_t simd) {
+    iq_simd_t detected = iq_simd_detect();
+    bool supported = simd == IQ_SIMD_NONE || simd == detected ||
+                     (simd == IQ_SIMD_SSE2 && detected == IQ_SIMD_AVX2);
+    atomic_store(&iq_simd_active, (int)(supported ? simd : detected));
+}
+
+const char *iq_simd_name(iq_simd_t simd) {
+    switch (simd) {
+        case IQ_SIMD_SSE2: return "sse2";
+        case IQ_SIMD_AVX2: return "avx2";
+        case IQ_SIMD_NEON: return "neon";
+        default:           return "scalar";
+    }
+}
+
+#if defined(IQ_HAVE_X86_SIMD)
+
+// s16 -> float, SSE2, eight values per iteration
+__attribute__((target("sse2")))
+static size_t iq_s16_f32_sse2(const int16_t *in, float *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(IQ_S16_SCALE);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        // Duplicate each value into both halves of an int32, then sign-shift down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    return i;
+}
+
+// s16 -> float, AVX2, sixteen values per iteration
+__attribute__((target("avx2")))
+static size_t iq_s16_f32_avx2(const int16_t *in, float *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(IQ_S16_SCALE);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in + i)));
+        __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in + i + 8)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+    }
+    return i;
+}
+
+// s8 -> float, SSE2, sixteen values per iteration
+__attribute__((target("sse2")))
+static size_t iq_s8_f32_sse2(const int8_t *in, float *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(IQ_S8_SCALE);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i w0 = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+        __m128i w1 = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+        __m128i d0 = _mm_srai_epi32(_mm_unpacklo_epi16(w0, w0), 16);
+        __m128i d1 = _mm_srai_epi32(_mm_unpackhi_epi16(w0, w0), 16);
+        __m128i d2 = _mm_srai_epi32(_mm_unpacklo_epi16(w1, w1), 16);
+        __m128i d3 = _mm_srai_epi32(_mm_unpackhi_epi16(w1, w1), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(d0), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(d1), scale));
+        _mm_storeu_ps(out + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(d2), scale));
+        _mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(d3), scale));
+    }
+    return i;
+}
+
+// s8 -> float, AVX2, sixteen values per iteration
+__attribute__((target("avx2")))
+static size_t iq_s8_f32_avx2(const int8_t *in, float *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(IQ_S8_SCALE);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(in + i)));
+        __m256i b = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(in + i + 8)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+    }
+    return i;
+}
+
+// Mono s16 -> (I, 0) pairs, SSE2, eight samples per iteration
+__attribute__((target("sse2")))
+static size_t iq_mono_f32_sse2(const int16_t *in, float *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(IQ_S16_SCALE);
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale);
+        __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale);
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(lo, zero));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(lo, zero));
+        _mm_storeu_ps(out + 2 * i + 8, _mm_unpacklo_ps(hi, zero));
+        _mm_storeu_ps(out + 2 * i + 12, _mm_unpackhi_ps(hi, zero));
+    }
+    return i;
+}
+
+// Mono s16 -> (I, 0) pairs, AVX2, eight samples per iteration
+__attribute__((target("avx2")))
+static size_t iq_mono_f32_avx2(const int16_t *in, float *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(IQ_S16_SCALE);
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in + i)));
+        __m256 f = _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale);
+        // unpack works per 128-bit lane: lo = [f0 0 f1 0 | f4 0 f5 0], hi = [f2 0 f3 0 | f6 0 f7 0]
+        __m256 lo = _mm256_unpacklo_ps(f, zero);
+        __m256 hi = _mm256_unpackhi_ps(f, zero);
+        _mm256_storeu_ps(out + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    return i;
+}
+
+// s16 -> double, SSE2, four values per iteration
+__attribute__((target("sse2")))
+static size_t iq_s16_f64_sse2(const int16_t *in, double *out, size_t count) {
+    const __m128d scale = _mm_set1_pd((double)IQ_S16_SCALE);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadl_epi64((const __m128i *)(in + i));
+        __m128i d = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(d), scale));
+        _mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(d, d)), scale));
+    }
+    return i;
+}
+
+// s16 -> double, AVX2, eight values per iteration
+__attribute__((target("avx2")))
+static size_t iq_s16_f64_avx2(const int16_t *in, double *out, size_t count) {
+    const __m256d scale = _mm256_set1_pd((double)IQ_S16_SCALE);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i d = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in + i)));
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(d)), scale));
+        _mm256_storeu_pd(out + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1)), scale));
+    }
+    return i;
+}
+
+// s8 -> double, SSE2, eight values per iteration
+__attribute__((target("sse2")))
+static size_t iq_s8_f64_sse2(const int8_t *in, double *out, size_t count) {
+    const __m128d scale = _mm_set1_pd((double)IQ_S8_SCALE);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadl_epi64((const __m128i *)(in + i));
+        __m128i w = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 16);
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(lo), scale));
+        _mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(lo, lo)), scale));
+        _mm_storeu_pd(out + i + 4, _mm_mul_pd(_mm_cvtepi32_pd(hi), scale));
+        _mm_storeu_pd(out + i + 6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(hi, hi)), scale));
+    }
+    return i;
+}
+
+// s8 -> double, AVX2, eight values per iteration
+__attribute__((target("avx2")))
+static size_t iq_s8_f64_avx2(const int8_t *in, double *out, size_t count) {
+    const __m256d scale = _mm256_set1_pd((double)IQ_S8_SCALE);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i d = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(in + i)));
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(d)), scale));
+        _mm256_storeu_pd(out + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1)), scale));
+    }
+    return i;
+}
+
+// float -> s16, SSE2, eight values per iteration (clamp, then truncate like the C cast)
+__attribute__((target("sse2")))
+static size_t iq_f32_s16_sse2(const float *in, int16_t *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), hi), lo);
+        __m128 b = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), hi), lo);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+    }
+    return i;
+}
+
+// float -> s16, AVX2, sixteen values per iteration
+__attribute__((target("avx2")))
+static size_t iq_f32_s16_avx2(const float *in, int16_t *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(32767.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256 a = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), hi), lo);
+        __m256 b = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale), hi), lo);
+        // Packing works per 128-bit lane: [a0-3 b0-3 | a4-7 b4-7], so swap the middle quarters
+        __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b));
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return i;
+}
+
+// float -> s8, SSE2, sixteen values per iteration
+__attribute__((target("sse2")))
+static size_t iq_f32_s8_sse2(const float *in, int8_t *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(127.0f);
+    const __m128 hi = _mm_set1_ps(127.0f);
+    const __m128 lo = _mm_set1_ps(-128.0f);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i d[4];
+        for (int k = 0; k < 4; k++) {
+            __m128 v = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4 * k), scale), hi), lo);
+            d[k] = _mm_cvttps_epi32(v);
+        }
+        __m128i w0 = _mm_packs_epi32(d[0], d[1]);
+        __m128i w1 = _mm_packs_epi32(d[2], d[3]);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi16(w0, w1));
+    }
+    return i;
+}
+
+// float -> s8, AVX2, thirty-two values per iteration
+__attribute__((target("avx2")))
+static size_t iq_f32_s8_avx2(const float *in, int8_t *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(127.0f);
+    const __m256 hi = _mm256_set1_ps(127.0f);
+    const __m256 lo = _mm256_set1_ps(-128.0f);
+    // After two per-lane packs the dwords read [a0 b0 c0 d0 | a1 b1 c1 d1]
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m256i d[4];
+        for (int k = 0; k < 4; k++) {
+            __m256 v = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8 * k), scale), hi), lo);
+            d[k] = _mm256_cvttps_epi32(v);
+        }
+        __m256i w0 = _mm256_packs_epi32(d[0], d[1]);
+        __m256i w1 = _mm256_packs_epi32(d[2], d[3]);
+        __m256i packed = _mm256_packs_epi16(w0, w1);
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    return i;
+}
+
+// Packed s12 -> float, SSE2, eight values (twelve bytes) per iteration
+__attribute__((target("sse2")))
+static size_t iq_s12_f32_sse2(const uint8_t *in, float *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(IQ_S12_SCALE);
+    const __m128i m0 = _mm_set_epi32(0, 0, 0, 0x00FFFFFF);
+    const __m128i m1 = _mm_set_epi32(0, 0, 0x00FFFFFF, 0);
+    const __m128i m2 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0);
+    const __m128i m3 = _mm_set_epi32(0x00FFFFFF, 0, 0, 0);
+    size_t bytes = count / 2 * 3;
+    size_t i = 0;
+
+    // The load reads four bytes past the twelve it uses
+    for (; i / 2 * 3 + 16 <= bytes; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i / 2 * 3));
+        // Shift byte 3k up to lane k, so lane k holds b0 | b1 << 8 | b2 << 16 of pair k
+        __m128i r = _mm_or_si128(_mm_or_si128(_mm_and_si128(x, m0),
+                                              _mm_and_si128(_mm_slli_si128(x, 1), m1)),
+                                 _mm_or_si128(_mm_and_si128(_mm_slli_si128(x, 2), m2),
+                                              _mm_and_si128(_mm_slli_si128(x, 3), m3)));
+        __m128i iv = _mm_srai_epi32(_mm_slli_epi32(r, 20), 20);
+        __m128i qv = _mm_srai_epi32(_mm_slli_epi32(r, 8), 20);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi32(iv, qv)), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi32(iv, qv)), scale));
+    }
+    return i;
+}
+
+// Packed s12 -> float, AVX2, sixteen values (24 bytes) per iteration
+__attribute__((target("avx2")))
+static size_t iq_s12_f32_avx2(const uint8_t *in, float *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(IQ_S12_SCALE);
+    const __m256i gather = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    size_t bytes = count / 2 * 3;
+    size_t i = 0;
+
+    // The second load reads four bytes past the 24 it uses
+    for (; i / 2 * 3 + 28 <= bytes; i += 16) {
+        const uint8_t *p = in + i / 2 * 3;
+        __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+                                            _mm_loadu_si128((const __m128i *)(p + 12)), 1);
+        __m256i r = _mm256_shuffle_epi8(x, gather);
+        __m256i iv = _mm256_srai_epi32(_mm256_slli_epi32(r, 20), 20);
+        __m256i qv = _mm256_srai_epi32(_mm256_slli_epi32(r, 8), 20);
+        // Per-lane unpacks leave pairs 0,1,4,5 and 2,3,6,7; the lane permute restores order
+        __m256i lo = _mm256_unpacklo_epi32(iv, qv);
+        __m256i hi = _mm256_unpackhi_epi32(iv, qv);
+        __m256i a = _mm256_permute2x128_si256(lo, hi, 0x20);
+        __m256i b = _mm256_permute2x128_si256(lo, hi, 0x31);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+    }
+    return i;
+}
+
+// Packed s4 -> float, SSE2, 32 values (sixteen bytes) per iteration
+__attribute__((target("sse2")))
+static size_t iq_s4_f32_sse2(const uint8_t *in, float *out, size_t count) {
+    const __m128 scale = _mm_set1_ps(IQ_S4_SCALE);
+    size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i / 2));
+        __m128i w[2] = { _mm_unpacklo_epi8(x, x), _mm_unpackhi_epi8(x, x) };
+        for (int h = 0; h < 2; h++) {
+            // Each byte fills an int32; Q is its top nibble, I the one below
+            __m128i t[2] = { _mm_unpacklo_epi16(w[h], w[h]), _mm_unpackhi_epi16(w[h], w[h]) };
+            for (int k = 0; k < 2; k++) {
+                __m128i qv = _mm_srai_epi32(t[k], 28);
+                __m128i iv = _mm_srai_epi32(_mm_slli_epi32(t[k], 4), 28);
+                float *o = out + i + h * 16 + k * 8;
+                _mm_storeu_ps(o, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi32(iv, qv)), scale));
+                _mm_storeu_ps(o + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi32(iv, qv)), scale));
+            }
+        }
+    }
+    return i;
+}
+
+// Packed s4 -> float, AVX2, sixteen values (eight bytes) per iteration
+__attribute__((target("avx2")))
+static size_t iq_s4_f32_avx2(const uint8_t *in, float *out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(IQ_S4_SCALE);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i x = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(in + i / 2)));
+        __m256i qv = _mm256_srai_epi32(x, 4);
+        __m256i iv = _mm256_srai_epi32(_mm256_slli_epi32(x, 28), 28);
+        __m256i lo = _mm256_unpacklo_epi32(iv, qv);
+        __m256i hi = _mm256_unpackhi_epi32(iv, qv);
+        __m256i a = _mm256_permute2x128_si256(lo, hi, 0x20);
+        __m256i b = _mm256_permute2x128_si256(lo, hi, 0x31);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+    }
+    return i;
+}
+
+#endif /* IQ_HAVE_X86_SIMD */
+
+#if defined(IQ_HAVE_NEON)
+
+// s16 -> float, NEON, eight values per iteration
+static size_t iq_s16_f32_neon(const int16_t *in, float *out, size_t count) {
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t x = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), IQ_S16_SCALE));
+        vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), IQ_S16_SCALE));
+    }
+    return i;
+}
+
+// s8 -> float, NEON, sixteen values per iteration
+static size_t iq_s8_f32_neon(const int8_t *in, float *out, size_t count) {
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        int8x16_t x = vld1q_s8(in + i);
+        int16x8_t w0 = vmovl_s8(vget_low_s8(x));
+        int16x8_t w1 = vmovl_s8(vget_high_s8(x));
+        vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(w0))), IQ_S8_SCALE));
+        vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(w0))), IQ_S8_SCALE));
+        vst1q_f32(out + i + 8, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(w1))), IQ_S8_SCALE));
+        vst1q_f32(out + i + 12, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(w1))), IQ_S8_SCALE));
+    }
+    return i;
+}
+
+// Mono s16 -> (I, 0) pairs, NEON, four samples per iteration
+static size_t iq_mono_f32_neon(const int16_t *in, float *out, size_t count) {
+    size_t i = 0;
+    float32x4x2_t pair;
+    pair.val[1] = vdupq_n_f32(0.0f);
+
+    for (; i + 4 <= count; i += 4) {
+        pair.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(in + i))), IQ_S16_SCALE);
+        vst2q_f32(out + 2 * i, pair);   // Interleaving store: I0 Q0 I1 Q1 ...
+    }
+    return i;
+}
+
+// s16 -> double, NEON, four values per iteration (float -> double is exact)
+static size_t iq_s16_f64_neon(const int16_t *in, double *out, size_t count) {
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t f = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(in + i))), IQ_S16_SCALE);
+        vst1q_f64(out + i, vcvt_f64_f32(vget_low_f32(f)));
+        vst1q_f64(out + i + 2, vcvt_high_f64_f32(f));
+    }
+    return i;
+}
+
+// float -> s16, NEON, eight values per iteration (vcvtq truncates toward zero)
+static size_t iq_f32_s16_neon(const float *in, int16_t *out, size_t count) {
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+    const float32x4_t lo = vdupq_n_f32(-32768.0f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vmaxq_f32(vminq_f32(vmulq_n_f32(vld1q_f32(in + i), 32767.0f), hi), lo);
+        float32x4_t b = vmaxq_f32(vminq_f32(vmulq_n_f32(vld1q_f32(in + i + 4), 32767.0f), hi), lo);
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a)), vqmovn_s32(vcvtq_s32_f32(b))));
+    }
+    return i;
+}
+
+// float -> s8, NEON, eight values per iteration
+static size_t iq_f32_s8_neon(const float *in, int8_t *out, size_t count) {
+    const float32x4_t hi = vdupq_n_f32(127.0f);
+    const float32x4_t lo = vdupq_n_f32(-128.0f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vmaxq_f32(vminq_f32(vmulq_n_f32(vld1q_f32(in + i), 127.0f), hi), lo);
+        float32x4_t b = vmaxq_f32(vminq_f32(vmulq_n_f32(vld1q_f32(in + i + 4), 127.0f), hi), lo);
+        int16x8_t w = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a)), vqmovn_s32(vcvtq_s32_f32(b)));
+        vst1_s8(out + i, vqmovn_s16(w));
+    }
+    return i;
+}
+
+// Packed s12 -> float, NEON, sixteen values (24 bytes) per iteration
+static size_t iq_s12_f32_neon(const uint8_t *in, float *out, size_t count) {
+    const uint8x8_t low_nibble = vdup_n_u8(0x0F);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        uint8x8x3_t b = vld3_u8(in + i / 2 * 3);   // De-interleaves bytes 0, 1, 2 of each pair
+        uint16x8_t a = vorrq_u16(vmovl_u8(b.val[0]), vshlq_n_u16(vmovl_u8(vand_u8(b.val[1], low_nibble)), 8));
+        uint16x8_t c = vorrq_u16(vmovl_u8(vshr_n_u8(b.val[1], 4)), vshlq_n_u16(vmovl_u8(b.val[2]), 4));
+        int16x8_t iv = vshrq_n_s16(vshlq_n_s16(vreinterpretq_s16_u16(a), 4), 4);
+        int16x8_t qv = vshrq_n_s16(vshlq_n_s16(vreinterpretq_s16_u16(c), 4), 4);
+        float32x4x2_t pair;
+        pair.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(iv))), IQ_S12_SCALE);
+        pair.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(qv))), IQ_S12_SCALE);
+        vst2q_f32(out + i, pair);
+        pair.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(iv))), IQ_S12_SCALE);
+        pair.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(qv))), IQ_S12_SCALE);
+        vst2q_f32(out + i + 8, pair);
+    }
+    return i;
+}
+
+// Packed s4 -> float, NEON, sixteen values (eight bytes) per iteration
+static size_t iq_s4_f32_neon(const uint8_t *in, float *out, size_t count) {
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        int8x8_t x = vreinterpret_s8_u8(vld1_u8(in + i / 2));
+        int16x8_t qv = vmovl_s8(vshr_n_s8(x, 4));
+        int16x8_t iv = vmovl_s8(vshr_n_s8(vshl_n_s8(x, 4), 4));
+        float32x4x2_t pair;
+        pair.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(iv))), IQ_S4_SCALE);
+        pair.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(qv))), IQ_S4_SCALE);
+        vst2q_f32(out + i, pair);
+        pair.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(iv))), IQ_S4_SCALE);
+        pair.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(qv))), IQ_S4_SCALE);
+        vst2q_f32(out + i + 8, pair);
+    }
+    return i;
+}
+
+#endif /* IQ_HAVE_NEON */
+
+// Dispatchers: SIMD body, scalar tail
+
+static void iq_s8_to_f32(const int8_t *in, float *out, size_t count) {
+    size_t i = 0;
+    switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+        case IQ_SIMD_AVX2: i = iq_s8_f32_avx2(in, out, count); break;
+        case IQ_SIMD_SSE2: i = iq_s8_f32_sse2(in, out, count); break;
+#endif
+#if defined(IQ_HAVE_NEON)
+        case IQ_SIMD_NEON: i = iq_s8_f32_neon(in, out, count); break;
+#endif
+        default: break;
+    }
+    for (; i < count; i++) {
+        out[i] = (float)in[i] / 128.0f;
+    }
+}
+
+static void iq_s16_to_f32(const int16_t *in, float *out, size_t count) {
+    size_t i = 0;
+    switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+        case IQ_SIMD_AVX2: i = iq_s16_f32_avx2(in, out, count); break;
+        case IQ_SIMD_SSE2: i = iq_s16_f32_sse2(in, out, count); break;
+#endif
+#if defined(IQ_HAVE_NEON)
+        case IQ_SIMD_NEON: i = iq_s16_f32_neon(in, out, count); break;
+#endif
+        default: break;
+    }
+    for (; i < count; i++) {
+        out[i] = (float)in[i] / 32768.0f;
+    }
+}
+
+// Packed values come in I/Q pairs, so every kernel stops on an even index
+static void iq_s12_to_f32(const uint8_t *in, float *out, size_t count) {
+    size_t i = 0;
+    switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+        case IQ_SIMD_AVX2: i = iq_s12_f32_avx2(in, out, count); break;
+        case IQ_SIMD_SSE2: i = iq_s12_f32_sse2(in, out, count); break;
+#endif
+#if defined(IQ_HAVE_NEON)
+        case IQ_SIMD_NEON: i = iq_s12_f32_neon(in, out, count); break;
+#endif
+        default: break;
+    }
+    for (; i + 2 <= count; i += 2) {
+        const uint8_t *p = in + i / 2 * 3;
+        int a = p[0] | (p[1] & 0x0F) << 8;
+        int b = p[1] >> 4 | p[2] << 4;
+        out[i] = (float)((a ^ 0x800) - 0x800) / 2048.0f;
+        out[i + 1] = (float)((b ^ 0x800) - 0x800) / 2048.0f;
+    }
+}
+
+static void iq_s4_to_f32(const uint8_t *in, float *out, size_t count) {
+    size_t i = 0;
+    switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+        case IQ_SIMD_AVX2: i = iq_s4_f32_avx2(in, out, count); break;
+        case IQ_SIMD_SSE2: i = iq_s4_f32_sse2(in, out, count); break;
+#endif
+#if defined(IQ_HAVE_NEON)
+        case IQ_SIMD_NEON: i = iq_s4_f32_neon(in, out, count); break;
+#endif
+        default: break;
+    }
+    for (; i + 2 <= count; i += 2) {
+        int b = in[i / 2];
+        out[i] = (float)(((b & 0x0F) ^ 0x8) - 0x8) / 8.0f;
+        out[i + 1] = (float)((b >> 4 ^ 0x8) - 0x8) / 8.0f;
+    }
+}
+
+// An odd trailing value is packed with a zero partner
+static void iq_pack_s12(const int16_t *values, size_t count, uint8_t *out) {
+    for (size_t i = 0; i < count; i += 2) {
+        unsigned a = (unsigned)values[i] & 0xFFF;
+        unsigned b = (i + 1 < count) ? (unsigned)values[i + 1] & 0xFFF : 0;
+        uint8_t *p = out + i / 2 * 3;
+        p[0] = (uint8_t)(a & 0xFF);
+        p[1] = (uint8_t)(a >> 8 | (b & 0x0F) << 4);
+        p[2] = (uint8_t)(b >> 4);
+    }
+}
+
+static void iq_pack_s4(const int8_t *values, size_t count, uint8_t *out) {
+    for (size_t i = 0; i < count; i += 2) {
+        unsigned a = (unsigned)values[i] & 0x0F;
+        unsigned b = (i + 1 < count) ? (unsigned)values[i + 1] & 0x0F : 0;
+        out[i / 2] = (uint8_t)(a | b << 4);
+    }
+}
+
+static void iq_s8_to_f64(const int8_t *in, double *out, size_t count) {
+    size_t i = 0;
+    switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+        case IQ_SIMD_AVX2: i = iq_s8_f64_avx2(in, out, count); break;
+        case IQ_SIMD_SSE2: i = iq_s8_f64_sse2(in, out, count); break;
+#endif
+        default: break;
+    }
+    for (; i < count; i++) {
+        out[i] = (double)in[i] / 128.0;
+    }
+}
+
+static void iq_s16_to_f64(const int16_t *in, double *out, size_t count) {
+    size_t i = 0;
+    switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+        case IQ_SIMD_AVX2: i = iq_s16_f64_avx2(in, out, count); break;
+        case IQ_SIMD_SSE2: i = iq_s16_f64_sse2(in, out, count); break;
+#endif
+#if defined(IQ_HAVE_NEON)
+        case IQ_SIMD_NEON: i = iq_s16_f64_neon(in, out, count); break;
+#endif
+        default: break;
+    }
+    for (; i < count; i++) {
+        out[i] = (double)in[i] / 32768.0;
+    }
+}
+
+void iq_convert_mono_to_float(const int16_t *pcm, size_t num_samples, float *output) {
+    if (!pcm || !output) {
+        return;
+    }
+
+    size_t i = 0;
+    switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+        case IQ_SIMD_AVX2: i = iq_mono_f32_avx2(pcm, output, num_samples); break;
+        case IQ_SIMD_SSE2: i = iq_mono_f32_sse2(pcm, output, num_samples); break;
+#endif
+#if defined(IQ_HAVE_NEON)
+        case IQ_SIMD_NEON: i = iq_mono_f32_neon(pcm, output, num_samples); break;
+#endif
+        default: break;
+    }
+    for (; i < num_samples; i++) {
+        output[i * 2] = (float)pcm[i] / 32768.0f;
+        output[i * 2 + 1] = 0.0f;
+    }
+}
+
+void iq_convert_from_float(const float *input, size_t count, iq_format_t format, void *output) {
+    if (!input || !output) {
+        return;
+    }
+
+    size_t i = 0;
+    if (format == IQ_FORMAT_S8) {
+        int8_t *out = (int8_t *)output;
+        switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+            case IQ_SIMD_AVX2: i = iq_f32_s8_avx2(input, out, count); break;
+            case IQ_SIMD_SSE2: i = iq_f32_s8_sse2(input, out, count); break;
+#endif
+#if defined(IQ_HAVE_NEON)
+            case IQ_SIMD_NEON: i = iq_f32_s8_neon(input, out, count); break;
+#endif
+            default: break;
+        }
+        for (; i < count; i++) {
+            float v = input[i] * 127.0f;
+
+            // Clamp to valid range
+            if (v > 127.0f) v = 127.0f;
+            if (v < -128.0f) v = -128.0f;
+
+            out[i] = (int8_t)v;
+        }
+    } else if (format == IQ_FORMAT_S12 || format == IQ_FORMAT_S4) {
+        // Quantise a block at a time, then pack it into place
+        enum { PACK_BLOCK = 1024 };
+        int16_t values[PACK_BLOCK];
+        int8_t nibbles[PACK_BLOCK];
+        float full = (format == IQ_FORMAT_S12) ? 2047.0f : 7.0f;
+        size_t pair_bytes = iq_native_sample_bytes(format);
+        uint8_t *out = (uint8_t *)output;
+
+        for (size_t start = 0; start < count; start += PACK_BLOCK) {
+            size_t n = count - start < PACK_BLOCK ? count - start : PACK_BLOCK;
+            for (size_t k = 0; k < n; k++) {
+                float v = input[start + k] * full;
+
+                // Clamp to valid range
+                if (v > full) v = full;
+                if (v < -full - 1.0f) v = -full - 1.0f;
+
+                if (format == IQ_FORMAT_S12) {
+                    values[k] = (int16_t)v;
+                } else {
+                    nibbles[k] = (int8_t)v;
+                }
+            }
+            if (format == IQ_FORMAT_S12) {
+                iq_pack_s12(values, n, out + start / 2 * pair_bytes);
+            } else {
+                iq_pack_s4(nibbles, n, out + start / 2 * pair_bytes);
+            }
+        }
+    } else {
+        int16_t *out = (int16_t *)output;
+        switch (iq_convert_simd()) {
+#if defined(IQ_HAVE_X86_SIMD)
+            case IQ_SIMD_AVX2: i = iq_f32_s16_avx2(input, out, count); break;
+            case IQ_SIMD_SSE2: i = iq_f32_s16_sse2(input, out, count); break;
+#endif
+#if defined(IQ_HAVE_NEON)
+            case IQ_SIMD_NEON: i = iq_f32_s16_neon(input, out, count); break;
+#endif
+            default: break;
+        }
+        for (; i < count; i++) {
+            float v = input[i] * 32767.0f;
+
+            // Clamp to valid range
+            if (v > 32767.0f) v = 32767.0f;
+            if (v < -32768.0f) v = -32768.0f;
+
+            out[i] = (int16_t)v;
+        }
+    }
+}
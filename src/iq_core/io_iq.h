@@ -5,13 +5,36 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <complex.h>
 
-// IQ data format enumeration
+/*
+ * IQ data format enumeration
+ * The packed formats keep every complex sample on whole bytes, so sample
+ * offsets stay a multiplication and files can be cut anywhere:
+ *   s12: 3 bytes per I/Q pair, I = b0 | (b1 & 0x0F) << 8, Q = b1 >> 4 | b2 << 4
+ *        (the SoapySDR CS12 layout), each a two's complement 12-bit value
+ *   s4:  1 byte per I/Q pair, I in the low nibble, Q in the high nibble
+ */
 typedef enum {
     IQ_FORMAT_S8,   // 8-bit signed integers
-    IQ_FORMAT_S16   // 16-bit signed integers
+    IQ_FORMAT_S16,  // 16-bit signed integers
+    IQ_FORMAT_S12,  // Packed 12-bit signed integers
+    IQ_FORMAT_S4    // Packed 4-bit signed integers
 } iq_format_t;
 
+/*
+ * Conversion kernel families for s8/s16/s12/s4 <-> float
+ * Detected once from the running CPU; every family gives bit-identical
+ * results (the scales 1/128, 1/32768, 1/2048 and 1/8 are exact in float,
+ * and the way back clamps and truncates exactly like the scalar cast)
+ */
+typedef enum {
+    IQ_SIMD_NONE = 0,  // Portable scalar C
+    IQ_SIMD_SSE2,      // x86 SSE2
+    IQ_SIMD_AVX2,      // x86 AVX2
+    IQ_SIMD_NEON       // ARM AdvSIMD (AArch64)
+} iq_simd_t;
+
 // IQ data structure
 typedef struct {
     float *data;        // Interleaved I/Q samples as float [-1,1]
@@ -20,6 +43,26 @@ typedef struct {
     iq_format_t format; // Original data format
 } iq_data_t;
 
+/*
+ * Decoded IQ file shared by every reader in the process (iq_source_publish)
+ * The samples are converted once, into an anonymous mapping; readers
+ * opened on the same path stream from it, each with its own position.
+ */
+typedef struct {
+    char path[1024];        // File the samples were decoded from
+    float *samples;         // Interleaved I/Q floats, 2 * num_samples
+    size_t num_samples;     // Complex samples
+    size_t map_bytes;       // Length of the mapping behind 'samples'
+    iq_format_t format;     // Format of the file (native reads re-quantise to it)
+    uint32_t sample_rate;   // From the WAV header, 0 for raw files
+} iq_source_t;
+
+// Published sources at once
+#define IQ_MAX_SOURCES 16
+
+struct iqz_file;  // io_iqz.h
+struct iq_stream; // io_stream.h
+
 // File reading context for streaming large files
 typedef struct {
     FILE *file;         // File handle
@@ -27,14 +70,119 @@ typedef struct {
     size_t buffer_size; // Size of internal buffer in samples
     size_t bytes_read;  // Total bytes read so far
     bool eof;          // End of file reached
+    uint16_t channels;      // Values per frame: 2 for I/Q, 1 for mono WAV (Q = 0)
+    uint32_t sample_rate;   // From the WAV header, 0 for raw files
+    uint64_t data_offset;   // Byte offset of the first sample
+    uint64_t total_samples; // Complex samples in the file
+    uint64_t position;      // Index of the next sample to be read
+    uint8_t *raw_buffer;    // Raw bytes of the last block (reused between reads)
+    size_t raw_capacity;    // Capacity of raw_buffer in bytes
+    const iq_source_t *source; // Shared decoded samples read instead of 'file' (or NULL)
+    struct iqz_file *compressed; // IQZ container read instead of 'file' (or NULL)
+    struct iq_stream *stream;    // Live source (pipe or socket) read instead of 'file' (or NULL)
 } iq_reader_t;
 
+// Sliding block over an iq_reader_t for frame/hop access with overlap carry-over
+typedef struct {
+    iq_reader_t *reader;  // Source (not owned)
+    float *data;          // Interleaved I/Q, 2 * capacity floats (NULL for native blocks)
+    void *native;         // Interleaved s8/s16 I/Q in the reader's format (native blocks only)
+    iq_format_t format;   // Format of the native samples held
+    size_t capacity;      // Capacity in complex samples
+    uint64_t start;       // Absolute sample index of data[0]
+    size_t valid;         // Complex samples currently held
+} iq_block_t;
+
+// Memory-mapped IQ file: the page cache holds the only copy of the samples
+typedef struct {
+    const uint8_t *map_base;  // Start of the read-only mapping
+    size_t map_bytes;         // Length of the mapping
+    const uint8_t *raw;       // First raw sample (past any WAV header)
+    size_t num_samples;       // Complex samples available
+    iq_format_t format;       // Raw sample format
+    uint16_t channels;        // Values per frame: 2 for I/Q, 1 for mono WAV (Q = 0)
+    uint32_t sample_rate;     // From the WAV header, 0 for raw files
+    float *block;             // Conversion buffer behind iq_mmap_block()
+    size_t block_capacity;    // Capacity of 'block' in complex samples
+    intptr_t os_file;         // Platform file descriptor / HANDLE
+    intptr_t os_mapping;      // Windows mapping HANDLE (unused on POSIX)
+} iq_mmap_t;
+
+/*
+ * Map an IQ file read-only (mmap on POSIX, MapViewOfFile on Windows)
+ * Raw s8/s16 files use the same format detection as iq_load_file; 16-bit PCM
+ * WAV files are mapped past their header. Nothing is read or converted here.
+ */
+bool iq_mmap_open(iq_mmap_t *map, const char *filename);
+
+/*
+ * Convert 'count' complex samples starting at 'start' into 'output'
+ * (2 * count floats). Returns the number converted, clipped at end of file.
+ * Does not touch the map's own buffer, so threads may convert disjoint ranges.
+ */
+size_t iq_mmap_read(const iq_mmap_t *map, size_t start, size_t count, float *output);
+
+/*
+ * Convert a range into the map's internal block buffer and return it
+ * The pointer stays valid until the next iq_mmap_block() or iq_mmap_close().
+ * Returns NULL if the range is empty or starts past the end of the file.
+ */
+const float *iq_mmap_block(iq_mmap_t *map, size_t start, size_t count, size_t *converted);
+
+/*
+ * Pointer to the raw interleaved sample at 'start' (NULL if out of range)
+ * For consumers that work on native s8/s16 values without conversion.
+ */
+const void *iq_mmap_raw(const iq_mmap_t *map, size_t start);
+
+/*
+ * Page-cache hint for a sample range: prefetch it (will_need) or let the
+ * kernel drop it once a streaming consumer has moved past (!will_need)
+ */
+void iq_mmap_advise(const iq_mmap_t *map, size_t start, size_t count, bool will_need);
+
+/*
+ * Unmap the file and free the block buffer
+ */
+void iq_mmap_close(iq_mmap_t *map);
+
+/*
+ * Decode a whole IQ file once (same detection as iq_reader_open) into an
+ * anonymous mapping, for a job whose steps all read the same capture
+ */
+bool iq_source_load(iq_source_t *source, const char *filename);
+
+/*
+ * Make iq_reader_open and iq_load_file on source->path read the decoded
+ * samples instead of the file, until withdrawn. Publish and withdraw from
+ * one thread, while no reader is being opened.
+ */
+bool iq_source_publish(const iq_source_t *source);
+void iq_source_withdraw(const iq_source_t *source);
+
+// Published source for a path (NULL if none)
+const iq_source_t *iq_source_find(const char *filename);
+
+// Unmap the samples (withdraws the source if still published)
+void iq_source_free(iq_source_t *source);
+
 /*
  * Initialize IQ reader for streaming file reading
  * This prevents loading entire large IQ files into memory at once
  */
 bool iq_reader_init(iq_reader_t *reader, const char *filename, iq_format_t format);
 
+/*
+ * Open an IQ file for streaming with the same detection as iq_load_file
+ * Raw s8/s16 formats are detected from the name/content; 16-bit PCM WAV
+ * files are read past their header and report their sample rate. IQZ
+ * containers (io_iqz.h) are decoded chunk by chunk, seeks included. A path
+ * with a published iq_source_t streams from its decoded samples instead.
+ * Stdin, named pipes and tcp:// / rtltcp:// / udp:// names open live
+ * sources (io_stream.h): total_samples is 0 and seeks only go forward.
+ */
+bool iq_reader_open(iq_reader_t *reader, const char *filename);
+
 /*
  * Read next block of IQ samples into provided buffer
  * Returns number of complex samples read (not bytes)
@@ -42,6 +190,89 @@ bool iq_reader_init(iq_reader_t *reader, const char *filename, iq_format_t forma
  */
 size_t iq_read_samples(iq_reader_t *reader, float *buffer, size_t max_samples);
 
+/*
+ * Read the next block without converting: interleaved int8_t or int16_t I/Q,
+ * or packed s12/s4 bytes, in reader->format (mono WAV is expanded to Q = 0).
+ * 'buffer' holds max_samples * iq_native_sample_bytes() bytes. Returns the
+ * number of complex samples read.
+ */
+size_t iq_read_native(iq_reader_t *reader, void *buffer, size_t max_samples);
+
+// Bytes per complex sample in native form (2 for s8, 4 for s16, 3 for s12, 1 for s4)
+size_t iq_native_sample_bytes(iq_format_t format);
+
+// Bits per I or Q value (8, 16, 12 or 4)
+unsigned iq_format_bits(iq_format_t format);
+
+// Parse a format name ("s8", "s16", "s12" or "s4"); false for anything else
+bool iq_parse_format(const char *name, iq_format_t *format);
+
+// Short name of a format, as accepted by iq_parse_format()
+const char *iq_format_name(iq_format_t format);
+
+/*
+ * Skip forward 'num_samples' complex samples without converting them
+ * Returns false if that moves past the end of the file.
+ */
+bool iq_reader_skip(iq_reader_t *reader, uint64_t num_samples);
+
+/*
+ * Position the reader at absolute complex sample 'sample' (forward or back)
+ * Only the seek is done; no data before the target is read. Returns false
+ * if the index is past the end of the file.
+ */
+bool iq_reader_seek_sample(iq_reader_t *reader, uint64_t sample);
+
+/*
+ * Slide a block buffer forward for overlapped processing
+ * Drops the first 'consumed' of 'valid' samples in 'buffer', moves the rest
+ * (FFT overlap, filter history) to the front and reads new samples behind
+ * them up to 'capacity'. 'consumed' may exceed 'valid' (hop > frame size);
+ * the gap is skipped in the file. Returns the new number of valid samples.
+ */
+size_t iq_reader_refill(iq_reader_t *reader, float *buffer, size_t valid,
+                        size_t consumed, size_t capacity);
+
+/*
+ * Sliding block: allocate 'capacity' samples of buffer over 'reader'
+ * Capacity bounds the longest span (e.g. frame plus batch of hops) ever asked for.
+ */
+bool iq_block_init(iq_block_t *block, iq_reader_t *reader, size_t capacity);
+
+/*
+ * Make samples [offset, offset + length) resident and return a pointer to
+ * 'offset'. Offsets must not move backwards; samples before 'offset' are
+ * dropped on refill. Returns NULL once the span runs past end of file.
+ */
+const float *iq_block_span(iq_block_t *block, uint64_t offset, size_t length);
+
+/*
+ * Native sliding block: same frame/hop semantics as iq_block_span, but the
+ * samples stay in the file's s8/s16 form (2-4x less memory and bandwidth
+ * than floats; pair with fft_spectral_frame_int). Returns NULL at end of file.
+ */
+bool iq_block_init_native(iq_block_t *block, iq_reader_t *reader, size_t capacity);
+const void *iq_block_span_native(iq_block_t *block, uint64_t offset, size_t length);
+
+/*
+ * Point an existing block at another (or reopened) reader, keeping its
+ * buffer: the block restarts empty at the reader's position. A native
+ * buffer is resized to the new reader's sample width. For batch runs that
+ * stream many files through one block.
+ */
+bool iq_block_rebind(iq_block_t *block, iq_reader_t *reader);
+
+/*
+ * Point a block at the next segment of the same stream (a file that
+ * carries on where the last one ended): the samples still held stay in
+ * place and offsets run on across the boundary, so the frame that straddles
+ * it is whole. The reader must have the block's sample format.
+ */
+bool iq_block_continue(iq_block_t *block, iq_reader_t *reader);
+
+// Free the block buffer (the reader stays open)
+void iq_block_free(iq_block_t *block);
+
 /*
  * Close reader and free resources
  */
@@ -55,6 +286,8 @@ bool iq_load_file(const char *filename, iq_data_t *iq_data);
 
 /*
  * Free IQ data structure and its internal buffer
+ * The buffer iq_load_file allocates comes from iq_huge_alloc (hugepage.h),
+ * so it is released here and never with free().
  */
 void iq_free(iq_data_t *iq_data);
 
@@ -64,13 +297,49 @@ void iq_free(iq_data_t *iq_data);
  */
 bool iq_data_save_file(const char *filename, const iq_data_t *iq_data);
 
+/*
+ * Append normalized float IQ samples to an open file as raw s8/s16/s12/s4
+ * Streaming counterpart of iq_data_save_file.
+ */
+bool iq_write_samples(FILE *file, const float *samples, size_t num_samples, iq_format_t format);
+
 /*
  * Convert raw IQ bytes to normalized float array [-1,1]
- * Handles both s8 and s16 formats with proper scaling
+ * Handles s8, s16 and the packed s12/s4 formats with proper scaling
  */
 bool iq_convert_to_float(const uint8_t *raw_data, size_t num_bytes,
                         iq_format_t format, float *output, size_t max_samples);
 
+/*
+ * Convert 'count' normalized floats to raw values in 'output'
+ * Scales by 127 / 32767 / 2047 / 7, clamps and truncates, as
+ * iq_write_samples does. Packed formats take whole I/Q pairs (even 'count').
+ */
+void iq_convert_from_float(const float *input, size_t count, iq_format_t format, void *output);
+
+/*
+ * Convert raw IQ bytes straight into a double complex FFT input buffer
+ * Same scaling as iq_convert_to_float. Interleaved float output already has
+ * the float complex layout, so single-precision plans need no fused variant.
+ */
+bool iq_convert_to_complex(const uint8_t *raw_data, size_t num_bytes,
+                           iq_format_t format, double complex *output, size_t max_samples);
+
+/*
+ * Convert mono 16-bit PCM (WAV) to interleaved IQ with I = sample, Q = 0
+ * 'output' holds 2 * num_samples floats.
+ */
+void iq_convert_mono_to_float(const int16_t *pcm, size_t num_samples, float *output);
+
+// Kernel family used by the conversions (detected on first use)
+iq_simd_t iq_convert_simd(void);
+
+// Force a kernel family (tests, benchmarks); unsupported families fall back to detection
+void iq_convert_set_simd(iq_simd_t simd);
+
+// Human-readable kernel family name
+const char *iq_simd_name(iq_simd_t simd);
+
 /*
  * Get file size in bytes
  */
@@ -78,7 +347,8 @@ size_t iq_get_file_size(const char *filename);
 
 /*
  * Auto-detect IQ format from file content
- * Examines first few bytes to determine s8 vs s16
+ * Examines first few bytes to determine s8 vs s16; packed formats are only
+ * chosen from the name (.s12/.iq12/.cs12, .s4/.iq4/.cs4)
  */
 iq_format_t iq_detect_format(const char *filename);
 
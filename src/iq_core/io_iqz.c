@@ -0,0 +1,792 @@
+/*
+ * =============================================================================
+ * IQ Lab - IQZ Compressed Container
+ * =============================================================================
+ *
+ * Chunked storage for s8/s16 IQ with a chunk index at the end of the file.
+ * Chunks are coded independently (prediction history starts at zero), so
+ * random access decodes one chunk. See io_iqz.h for the layout.
+ *
+ * Bit streams are written least significant bit first. A Rice code for a
+ * zigzagged residual u with parameter k is q = u >> k zero bits, a one bit,
+ * then the low k bits; q reaching IQZ_RICE_ESCAPE is followed by u in full.
+ * =============================================================================
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // fseeko, ftello under -std=c11
+#endif
+
+#include "io_iqz.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+// Chunk modes (first byte of every chunk)
+enum {
+    IQZ_CHUNK_RAW = 0,
+    IQZ_CHUNK_RICE = 1,
+    IQZ_CHUNK_BFP = 2
+};
+
+// Values sharing one Rice parameter
+#define IQZ_RICE_BLOCK 64
+
+// Unary length that marks an escaped residual
+#define IQZ_RICE_ESCAPE 24
+
+// Values sharing one BFP exponent
+#define IQZ_BFP_BLOCK 16
+
+struct iqz_writer {
+    FILE *file;
+    iq_format_t format;
+    iqz_codec_t codec;
+    uint32_t mantissa_bits;
+    uint32_t chunk_samples;
+    uint32_t sample_rate;
+    uint8_t *pending;           // Native samples of the chunk being filled
+    size_t pending_samples;
+    int32_t *values;            // The chunk widened to int32
+    uint8_t *encoded;           // Encoded chunk
+    size_t encoded_capacity;
+    uint64_t num_samples;
+    uint64_t position;          // Bytes written so far
+    uint64_t *offsets;          // Start of every chunk
+    size_t num_chunks;
+    size_t offsets_capacity;
+    bool failed;
+};
+
+struct iqz_file {
+    FILE *file;
+    iqz_info_t info;
+    uint64_t *offsets;          // num_chunks + 1 entries
+    uint8_t *compressed;        // Bytes of the chunk being decoded
+    size_t compressed_capacity;
+    uint8_t *chunk;             // Decoded native samples of 'cached'
+    uint64_t cached;            // Chunk held in 'chunk' (UINT64_MAX: none)
+    uint64_t bytes_read;
+};
+
+typedef struct {
+    uint8_t *data;
+    size_t capacity;
+    size_t length;
+    uint64_t acc;
+    unsigned bits;
+    bool overflow;
+} iqz_bit_writer_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+    size_t pos;                 // Next byte to load (may pass 'length': zeros)
+    uint64_t acc;
+    unsigned bits;
+} iqz_bit_reader_t;
+
+// Little-endian field access
+
+static void iqz_put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void iqz_put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t iqz_get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t iqz_get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static bool iqz_seek(FILE *file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// Bit streams
+
+static void iqz_bits_put(iqz_bit_writer_t *w, uint32_t value, unsigned count) {
+    w->acc |= (uint64_t)value << w->bits;
+    w->bits += count;
+    while (w->bits >= 8) {
+        if (w->length < w->capacity) {
+            w->data[w->length++] = (uint8_t)w->acc;
+        } else {
+            w->overflow = true;
+        }
+        w->acc >>= 8;
+        w->bits -= 8;
+    }
+}
+
+static void iqz_bits_flush(iqz_bit_writer_t *w) {
+    if (w->bits > 0) {
+        iqz_bits_put(w, 0, 8 - w->bits);
+    }
+}
+
+static void iqz_bits_refill(iqz_bit_reader_t *r) {
+    while (r->bits <= 56) {
+        uint64_t byte = r->pos < r->length ? r->data[r->pos] : 0;
+        r->acc |= byte << r->bits;
+        r->pos++;
+        r->bits += 8;
+    }
+}
+
+static uint32_t iqz_bits_get(iqz_bit_reader_t *r, unsigned count) {
+    if (count == 0) return 0;
+    iqz_bits_refill(r);
+    uint32_t value = (uint32_t)(r->acc & ((UINT64_C(1) << count) - 1));
+    r->acc >>= count;
+    r->bits -= count;
+    return value;
+}
+
+static unsigned iqz_trailing_zeros(uint64_t x) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(x);
+#else
+    unsigned n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// Zero run up to the next one bit; IQZ_RICE_ESCAPE + 1 on a corrupt stream
+static unsigned iqz_bits_unary(iqz_bit_reader_t *r) {
+    iqz_bits_refill(r);
+    if (r->acc == 0) {
+        return IQZ_RICE_ESCAPE + 1;
+    }
+    unsigned q = iqz_trailing_zeros(r->acc);
+    if (q > IQZ_RICE_ESCAPE) {
+        return q;
+    }
+    r->acc >>= q + 1;
+    r->bits -= q + 1;
+    return q;
+}
+
+// True if decoding stayed inside the chunk
+static bool iqz_bits_within(const iqz_bit_reader_t *r) {
+    return (uint64_t)r->pos * 8 - r->bits <= (uint64_t)r->length * 8;
+}
+
+// Bits of a zigzagged residual: order-2 prediction of s8 stays within 10, s16 within 18
+static unsigned iqz_escape_bits(iq_format_t format) {
+    return (format == IQ_FORMAT_S8) ? 10 : 18;
+}
+
+static uint32_t iqz_zigzag(int32_t r) {
+    return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+}
+
+static int32_t iqz_unzigzag(uint32_t u) {
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+static int32_t iqz_predict(unsigned order, int32_t a, int32_t b) {
+    switch (order) {
+        case 1: return a;
+        case 2: return 2 * a - b;
+        default: return 0;
+    }
+}
+
+static void iqz_widen(const void *samples, size_t values, iq_format_t format, int32_t *out) {
+    if (format == IQ_FORMAT_S8) {
+        const int8_t *in = (const int8_t *)samples;
+        for (size_t i = 0; i < values; i++) out[i] = in[i];
+    } else {
+        const int16_t *in = (const int16_t *)samples;
+        for (size_t i = 0; i < values; i++) out[i] = in[i];
+    }
+}
+
+static void iqz_store(void *samples, size_t index, int32_t value, iq_format_t format) {
+    if (format == IQ_FORMAT_S8) {
+        if (value > 127) value = 127;
+        if (value < -128) value = -128;
+        ((int8_t *)samples)[index] = (int8_t)value;
+    } else {
+        if (value > 32767) value = 32767;
+        if (value < -32768) value = -32768;
+        ((int16_t *)samples)[index] = (int16_t)value;
+    }
+}
+
+/*
+ * Lossless chunk: mode, per-channel orders, then Rice blocks
+ * Returns the encoded size, or 0 if it would not beat 'capacity' bytes.
+ */
+static size_t iqz_encode_rice(const int32_t *values, size_t count, iq_format_t format,
+                              uint8_t *out, size_t capacity) {
+    // Pick each channel's order by the sum of its absolute residuals
+    uint64_t cost[2][3] = {{0}};
+    int32_t a[2] = {0}, b[2] = {0};
+    for (size_t i = 0; i < count; i++) {
+        unsigned ch = (unsigned)(i & 1);
+        int32_t x = values[i];
+        for (unsigned order = 0; order < 3; order++) {
+            int32_t r = x - iqz_predict(order, a[ch], b[ch]);
+            cost[ch][order] += (uint64_t)(r < 0 ? -(int64_t)r : r);
+        }
+        b[ch] = a[ch];
+        a[ch] = x;
+    }
+    unsigned orders[2];
+    for (unsigned ch = 0; ch < 2; ch++) {
+        orders[ch] = 0;
+        for (unsigned order = 1; order < 3; order++) {
+            if (cost[ch][order] < cost[ch][orders[ch]]) orders[ch] = order;
+        }
+    }
+
+    if (capacity < 2) return 0;
+    out[0] = IQZ_CHUNK_RICE;
+    out[1] = (uint8_t)(orders[0] | (orders[1] << 2));
+    iqz_bit_writer_t w = { out + 2, capacity - 2, 0, 0, 0, false };
+
+    unsigned escape_bits = iqz_escape_bits(format);
+    uint32_t residuals[IQZ_RICE_BLOCK];
+    a[0] = a[1] = b[0] = b[1] = 0;
+    for (size_t start = 0; start < count && !w.overflow; start += IQZ_RICE_BLOCK) {
+        size_t n = count - start < IQZ_RICE_BLOCK ? count - start : IQZ_RICE_BLOCK;
+        uint64_t sum = 0;
+        for (size_t j = 0; j < n; j++) {
+            size_t i = start + j;
+            unsigned ch = (unsigned)(i & 1);
+            residuals[j] = iqz_zigzag(values[i] - iqz_predict(orders[ch], a[ch], b[ch]));
+            sum += residuals[j];
+            b[ch] = a[ch];
+            a[ch] = values[i];
+        }
+
+        // k near log2 of the mean residual
+        unsigned k = 0;
+        while (k + 1 < escape_bits && ((uint64_t)n << (k + 1)) <= sum) k++;
+        iqz_bits_put(&w, k, 5);
+
+        for (size_t j = 0; j < n; j++) {
+            uint32_t q = residuals[j] >> k;
+            if (q < IQZ_RICE_ESCAPE) {
+                iqz_bits_put(&w, 1u << q, q + 1);
+                iqz_bits_put(&w, residuals[j] & ((1u << k) - 1), k);
+            } else {
+                iqz_bits_put(&w, 1u << IQZ_RICE_ESCAPE, IQZ_RICE_ESCAPE + 1);
+                iqz_bits_put(&w, residuals[j], escape_bits);
+            }
+        }
+    }
+    iqz_bits_flush(&w);
+
+    return w.overflow ? 0 : 2 + w.length;
+}
+
+static bool iqz_decode_rice(const uint8_t *in, size_t length, size_t count, iq_format_t format, void *samples) {
+    if (length < 2) return false;
+    unsigned orders[2] = { in[1] & 3u, (in[1] >> 2) & 3u };
+    if (orders[0] > 2 || orders[1] > 2) return false;
+
+    iqz_bit_reader_t r = { in + 2, length - 2, 0, 0, 0 };
+    unsigned escape_bits = iqz_escape_bits(format);
+    int32_t a[2] = {0}, b[2] = {0};
+
+    for (size_t start = 0; start < count; start += IQZ_RICE_BLOCK) {
+        size_t n = count - start < IQZ_RICE_BLOCK ? count - start : IQZ_RICE_BLOCK;
+        unsigned k = iqz_bits_get(&r, 5);
+        if (k >= escape_bits) return false;
+
+        for (size_t j = 0; j < n; j++) {
+            unsigned q = iqz_bits_unary(&r);
+            uint32_t u;
+            if (q < IQZ_RICE_ESCAPE) {
+                u = ((uint32_t)q << k) | iqz_bits_get(&r, k);
+            } else if (q == IQZ_RICE_ESCAPE) {
+                u = iqz_bits_get(&r, escape_bits);
+            } else {
+                return false;
+            }
+
+            size_t i = start + j;
+            unsigned ch = (unsigned)(i & 1);
+            int32_t x = iqz_unzigzag(u) + iqz_predict(orders[ch], a[ch], b[ch]);
+            iqz_store(samples, i, x, format);
+            b[ch] = a[ch];
+            a[ch] = x;
+        }
+        if (!iqz_bits_within(&r)) return false;
+    }
+
+    return true;
+}
+
+// Lossy chunk: mode, then per block a 4-bit exponent and mantissas
+static size_t iqz_encode_bfp(const int32_t *values, size_t count, unsigned mantissa_bits,
+                             uint8_t *out, size_t capacity) {
+    const int32_t limit = 1 << (mantissa_bits - 1);
+    const int32_t bias = 1 << 20;  // Keeps the shifted operand positive for every exponent
+    uint32_t mask = (1u << mantissa_bits) - 1;
+
+    out[0] = IQZ_CHUNK_BFP;
+    iqz_bit_writer_t w = { out + 1, capacity - 1, 0, 0, 0, false };
+
+    for (size_t start = 0; start < count; start += IQZ_BFP_BLOCK) {
+        size_t n = count - start < IQZ_BFP_BLOCK ? count - start : IQZ_BFP_BLOCK;
+        int32_t peak = 0;
+        for (size_t j = 0; j < n; j++) {
+            int32_t v = values[start + j] < 0 ? -values[start + j] : values[start + j];
+            if (v > peak) peak = v;
+        }
+
+        unsigned e = 0;
+        while (e < 15 && (peak >> e) >= limit) e++;
+        iqz_bits_put(&w, e, 4);
+
+        int32_t half = e ? 1 << (e - 1) : 0;
+        for (size_t j = 0; j < IQZ_BFP_BLOCK; j++) {
+            int32_t m = 0;
+            if (j < n) {
+                // Round to nearest: floor((x + half) / 2^e) through a positive operand
+                m = ((values[start + j] + half + bias) >> e) - (bias >> e);
+                if (m > limit - 1) m = limit - 1;
+                if (m < -limit) m = -limit;
+            }
+            iqz_bits_put(&w, (uint32_t)m & mask, mantissa_bits);
+        }
+    }
+    iqz_bits_flush(&w);
+
+    return w.overflow ? 0 : 1 + w.length;
+}
+
+static bool iqz_decode_bfp(const uint8_t *in, size_t length, size_t count, iq_format_t format,
+                           unsigned mantissa_bits, void *samples) {
+    const int32_t limit = 1 << (mantissa_bits - 1);
+    iqz_bit_reader_t r = { in + 1, length - 1, 0, 0, 0 };
+
+    for (size_t start = 0; start < count; start += IQZ_BFP_BLOCK) {
+        size_t n = count - start < IQZ_BFP_BLOCK ? count - start : IQZ_BFP_BLOCK;
+        unsigned e = iqz_bits_get(&r, 4);
+        for (size_t j = 0; j < IQZ_BFP_BLOCK; j++) {
+            int32_t m = (int32_t)iqz_bits_get(&r, mantissa_bits);
+            if (m & limit) m -= 2 * limit;
+            if (j < n) {
+                iqz_store(samples, start + j, m * (1 << e), format);
+            }
+        }
+    }
+
+    return iqz_bits_within(&r);
+}
+
+// Writer
+
+static size_t iqz_bfp_chunk_bytes(size_t values, unsigned mantissa_bits) {
+    size_t blocks = (values + IQZ_BFP_BLOCK - 1) / IQZ_BFP_BLOCK;
+    return 1 + (blocks * (4 + IQZ_BFP_BLOCK * (size_t)mantissa_bits) + 7) / 8;
+}
+
+static void iqz_write_header(uint8_t *header, const iqz_writer_t *writer, uint64_t index_offset) {
+    memset(header, 0, IQZ_HEADER_SIZE);
+    memcpy(header, IQZ_MAGIC, 8);
+    iqz_put_u32(header + 8, IQZ_VERSION);
+    header[12] = (writer->format == IQ_FORMAT_S8) ? 0 : 1;
+    header[13] = (uint8_t)writer->codec;
+    header[14] = (uint8_t)writer->mantissa_bits;
+    iqz_put_u32(header + 16, writer->chunk_samples);
+    iqz_put_u32(header + 20, writer->sample_rate);
+    iqz_put_u64(header + 24, writer->num_samples);
+    iqz_put_u64(header + 32, index_offset);
+    iqz_put_u64(header + 40, writer->num_chunks);
+}
+
+iqz_writer_t *iqz_writer_create(const char *filename, iq_format_t format, uint32_t sample_rate,
+                                uint32_t chunk_samples, uint32_t mantissa_bits) {
+    if (!filename) {
+        return NULL;
+    }
+
+    if (format != IQ_FORMAT_S8 && format != IQ_FORMAT_S16) {
+        fprintf(stderr, "IQZ: only s8 and s16 samples can be compressed\n");
+        return NULL;
+    }
+
+    unsigned value_bits = (format == IQ_FORMAT_S8) ? 8 : 16;
+    if (mantissa_bits != 0 && (mantissa_bits < 2 || mantissa_bits >= value_bits)) {
+        fprintf(stderr, "IQZ: mantissa bits must be 2..%u for %u-bit samples\n", value_bits - 1, value_bits);
+        return NULL;
+    }
+
+    iqz_writer_t *writer = (iqz_writer_t *)calloc(1, sizeof(*writer));
+    if (!writer) {
+        return NULL;
+    }
+
+    writer->format = format;
+    writer->codec = mantissa_bits ? IQZ_CODEC_BFP : IQZ_CODEC_LOSSLESS;
+    writer->mantissa_bits = mantissa_bits;
+    writer->chunk_samples = chunk_samples ? chunk_samples : IQZ_DEFAULT_CHUNK;
+    writer->sample_rate = sample_rate;
+
+    size_t raw_bytes = (size_t)writer->chunk_samples * iq_native_sample_bytes(format);
+    size_t values = (size_t)writer->chunk_samples * 2;
+    writer->encoded_capacity = 1 + raw_bytes;
+    if (mantissa_bits && iqz_bfp_chunk_bytes(values, mantissa_bits) > writer->encoded_capacity) {
+        writer->encoded_capacity = iqz_bfp_chunk_bytes(values, mantissa_bits);
+    }
+    writer->pending = (uint8_t *)malloc(raw_bytes);
+    writer->values = (int32_t *)malloc(values * sizeof(int32_t));
+    writer->encoded = (uint8_t *)malloc(writer->encoded_capacity);
+    writer->file = fopen(filename, "wb");
+
+    if (!writer->pending || !writer->values || !writer->encoded || !writer->file) {
+        if (!writer->file) {
+            fprintf(stderr, "Error creating IQZ file '%s': %s\n", filename, strerror(errno));
+        } else {
+            fprintf(stderr, "Memory allocation failed for IQZ writer\n");
+            fclose(writer->file);
+        }
+        free(writer->pending);
+        free(writer->values);
+        free(writer->encoded);
+        free(writer);
+        return NULL;
+    }
+
+    // Placeholder until close: an index offset of 0 marks an unfinished file
+    uint8_t header[IQZ_HEADER_SIZE];
+    iqz_write_header(header, writer, 0);
+    writer->failed = fwrite(header, 1, sizeof(header), writer->file) != sizeof(header);
+    writer->position = IQZ_HEADER_SIZE;
+    return writer;
+}
+
+static bool iqz_writer_flush(iqz_writer_t *writer) {
+    if (writer->pending_samples == 0) {
+        return true;
+    }
+
+    if (writer->num_chunks == writer->offsets_capacity) {
+        size_t capacity = writer->offsets_capacity ? writer->offsets_capacity * 2 : 256;
+        uint64_t *offsets = (uint64_t *)realloc(writer->offsets, capacity * sizeof(uint64_t));
+        if (!offsets) {
+            fprintf(stderr, "Memory allocation failed for IQZ index\n");
+            return false;
+        }
+        writer->offsets = offsets;
+        writer->offsets_capacity = capacity;
+    }
+
+    size_t values = writer->pending_samples * 2;
+    size_t raw_bytes = writer->pending_samples * iq_native_sample_bytes(writer->format);
+    iqz_widen(writer->pending, values, writer->format, writer->values);
+
+    size_t bytes;
+    if (writer->codec == IQZ_CODEC_BFP) {
+        bytes = iqz_encode_bfp(writer->values, values, writer->mantissa_bits,
+                               writer->encoded, writer->encoded_capacity);
+    } else {
+        // Only keep the Rice stream if it beats storing the chunk raw
+        bytes = iqz_encode_rice(writer->values, values, writer->format, writer->encoded, raw_bytes);
+        if (bytes == 0) {
+            writer->encoded[0] = IQZ_CHUNK_RAW;
+            memcpy(writer->encoded + 1, writer->pending, raw_bytes);
+            bytes = 1 + raw_bytes;
+        }
+    }
+    if (bytes == 0 || fwrite(writer->encoded, 1, bytes, writer->file) != bytes) {
+        return false;
+    }
+
+    writer->offsets[writer->num_chunks++] = writer->position;
+    writer->position += bytes;
+    writer->pending_samples = 0;
+    return true;
+}
+
+bool iqz_writer_write(iqz_writer_t *writer, const void *samples, size_t num_samples) {
+    if (!writer || (!samples && num_samples > 0) || writer->failed) {
+        return false;
+    }
+
+    size_t sample_bytes = iq_native_sample_bytes(writer->format);
+    const uint8_t *src = (const uint8_t *)samples;
+    while (num_samples > 0) {
+        size_t room = writer->chunk_samples - writer->pending_samples;
+        size_t n = num_samples < room ? num_samples : room;
+        memcpy(writer->pending + writer->pending_samples * sample_bytes, src, n * sample_bytes);
+        writer->pending_samples += n;
+        writer->num_samples += n;
+        src += n * sample_bytes;
+        num_samples -= n;
+
+        if (writer->pending_samples == writer->chunk_samples && !iqz_writer_flush(writer)) {
+            writer->failed = true;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool iqz_writer_close(iqz_writer_t *writer) {
+    if (!writer) {
+        return false;
+    }
+
+    bool ok = !writer->failed && iqz_writer_flush(writer);
+
+    // Index: every chunk start, then the end of the last chunk
+    uint64_t index_offset = writer->position;
+    uint8_t entry[8];
+    for (size_t i = 0; ok && i <= writer->num_chunks; i++) {
+        iqz_put_u64(entry, i < writer->num_chunks ? writer->offsets[i] : index_offset);
+        ok = fwrite(entry, 1, sizeof(entry), writer->file) == sizeof(entry);
+    }
+
+    uint8_t header[IQZ_HEADER_SIZE];
+    iqz_write_header(header, writer, index_offset);
+    ok = ok && iqz_seek(writer->file, 0) && fwrite(header, 1, sizeof(header), writer->file) == sizeof(header);
+
+    if (fclose(writer->file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error writing IQZ file\n");
+    }
+
+    free(writer->pending);
+    free(writer->values);
+    free(writer->encoded);
+    free(writer->offsets);
+    free(writer);
+    return ok;
+}
+
+// Reader
+
+bool iqz_probe(const char *filename) {
+    if (!filename) {
+        return false;
+    }
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        return false;
+    }
+    char magic[8];
+    bool match = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, IQZ_MAGIC, 8) == 0;
+    fclose(file);
+    return match;
+}
+
+iqz_file_t *iqz_open(const char *filename) {
+    if (!filename) {
+        return NULL;
+    }
+
+    iqz_file_t *iqz = (iqz_file_t *)calloc(1, sizeof(*iqz));
+    if (!iqz) {
+        return NULL;
+    }
+    iqz->cached = UINT64_MAX;
+
+    iqz->file = fopen(filename, "rb");
+    if (!iqz->file) {
+        fprintf(stderr, "Error opening IQZ file '%s': %s\n", filename, strerror(errno));
+        free(iqz);
+        return NULL;
+    }
+
+    uint8_t header[IQZ_HEADER_SIZE];
+    const char *problem = NULL;
+    iqz_info_t *info = &iqz->info;
+    if (fread(header, 1, sizeof(header), iqz->file) != sizeof(header) || memcmp(header, IQZ_MAGIC, 8) != 0) {
+        problem = "not an IQZ container";
+    } else if (iqz_get_u32(header + 8) != IQZ_VERSION) {
+        problem = "unsupported version";
+    } else {
+        info->format = header[12] == 0 ? IQ_FORMAT_S8 : IQ_FORMAT_S16;
+        info->codec = (iqz_codec_t)header[13];
+        info->mantissa_bits = header[14];
+        info->chunk_samples = iqz_get_u32(header + 16);
+        info->sample_rate = iqz_get_u32(header + 20);
+        info->num_samples = iqz_get_u64(header + 24);
+        info->num_chunks = iqz_get_u64(header + 40);
+        unsigned value_bits = (info->format == IQ_FORMAT_S8) ? 8 : 16;
+        uint64_t index_offset = iqz_get_u64(header + 32);
+
+        if (header[12] > 1 || header[13] > IQZ_CODEC_BFP ||
+            (info->codec == IQZ_CODEC_BFP && (info->mantissa_bits < 2 || info->mantissa_bits >= value_bits))) {
+            problem = "unknown sample format or codec";
+        } else if (index_offset == 0) {
+            problem = "file was not finished (no chunk index)";
+        } else if (info->chunk_samples == 0 ||
+                   info->num_chunks != (info->num_samples + info->chunk_samples - 1) / info->chunk_samples ||
+                   info->num_chunks > SIZE_MAX / sizeof(uint64_t) - 1) {
+            problem = "inconsistent chunk count";
+        } else {
+            size_t entries = (size_t)info->num_chunks + 1;
+            uint8_t entry[8];
+            iqz->offsets = (uint64_t *)malloc(entries * sizeof(uint64_t));
+            bool ok = iqz->offsets && iqz_seek(iqz->file, index_offset);
+            for (size_t i = 0; ok && i < entries; i++) {
+                ok = fread(entry, 1, sizeof(entry), iqz->file) == sizeof(entry);
+                iqz->offsets[i] = ok ? iqz_get_u64(entry) : 0;
+                ok = ok && (i == 0 ? iqz->offsets[i] >= IQZ_HEADER_SIZE : iqz->offsets[i] > iqz->offsets[i - 1]);
+            }
+            if (!ok || iqz->offsets[entries - 1] != index_offset) {
+                problem = "damaged chunk index";
+            }
+            info->file_bytes = index_offset + entries * sizeof(entry);
+        }
+    }
+
+    if (!problem) {
+        size_t chunk_bytes = (size_t)info->chunk_samples * iq_native_sample_bytes(info->format);
+        iqz->chunk = (uint8_t *)malloc(chunk_bytes);
+        if (!iqz->chunk) {
+            problem = "out of memory";
+        }
+    }
+
+    if (problem) {
+        fprintf(stderr, "Error reading IQZ file '%s': %s\n", filename, problem);
+        iqz_close(iqz);
+        return NULL;
+    }
+    return iqz;
+}
+
+const iqz_info_t *iqz_info(const iqz_file_t *file) {
+    return file ? &file->info : NULL;
+}
+
+uint64_t iqz_bytes_read(const iqz_file_t *file) {
+    return file ? file->bytes_read : 0;
+}
+
+static bool iqz_load_chunk(iqz_file_t *iqz, uint64_t chunk) {
+    if (iqz->cached == chunk) {
+        return true;
+    }
+    iqz->cached = UINT64_MAX;
+
+    const iqz_info_t *info = &iqz->info;
+    uint64_t first = chunk * info->chunk_samples;
+    size_t samples = (size_t)(info->num_samples - first < info->chunk_samples ? info->num_samples - first
+                                                                                : info->chunk_samples);
+    size_t raw_bytes = samples * iq_native_sample_bytes(info->format);
+    uint64_t length = iqz->offsets[chunk + 1] - iqz->offsets[chunk];
+
+    if (length > iqz->compressed_capacity) {
+        if (length > raw_bytes + 16 && length > iqz_bfp_chunk_bytes(samples * 2, 15)) {
+            fprintf(stderr, "IQZ chunk %llu is larger than any encoding\n", (unsigned long long)chunk);
+            return false;
+        }
+        uint8_t *buffer = (uint8_t *)realloc(iqz->compressed, (size_t)length);
+        if (!buffer) {
+            fprintf(stderr, "Memory allocation failed for IQZ chunk\n");
+            return false;
+        }
+        iqz->compressed = buffer;
+        iqz->compressed_capacity = (size_t)length;
+    }
+
+    if (!iqz_seek(iqz->file, iqz->offsets[chunk]) ||
+        fread(iqz->compressed, 1, (size_t)length, iqz->file) != length) {
+        fprintf(stderr, "Short read on IQZ chunk %llu\n", (unsigned long long)chunk);
+        return false;
+    }
+    iqz->bytes_read += length;
+
+    bool ok;
+    switch (iqz->compressed[0]) {
+        case IQZ_CHUNK_RAW:
+            ok = length == 1 + raw_bytes;
+            if (ok) memcpy(iqz->chunk, iqz->compressed + 1, raw_bytes);
+            break;
+        case IQZ_CHUNK_RICE:
+            ok = info->codec == IQZ_CODEC_LOSSLESS &&
+                 iqz_decode_rice(iqz->compressed, (size_t)length, samples * 2, info->format, iqz->chunk);
+            break;
+        case IQZ_CHUNK_BFP:
+            ok = info->codec == IQZ_CODEC_BFP &&
+                 iqz_decode_bfp(iqz->compressed, (size_t)length, samples * 2, info->format,
+                                info->mantissa_bits, iqz->chunk);
+            break;
+        default:
+            ok = false;
+            break;
+    }
+    if (!ok) {
+        fprintf(stderr, "Corrupt IQZ chunk %llu\n", (unsigned long long)chunk);
+        return false;
+    }
+
+    iqz->cached = chunk;
+    return true;
+}
+
+size_t iqz_read(iqz_file_t *file, uint64_t start, void *samples, size_t max_samples) {
+    if (!file || !samples) {
+        return 0;
+    }
+
+    const iqz_info_t *info = &file->info;
+    size_t sample_bytes = iq_native_sample_bytes(info->format);
+    uint8_t *out = (uint8_t *)samples;
+    size_t done = 0;
+
+    while (done < max_samples && start < info->num_samples) {
+        uint64_t chunk = start / info->chunk_samples;
+        if (!iqz_load_chunk(file, chunk)) {
+            break;
+        }
+
+        size_t offset = (size_t)(start - chunk * info->chunk_samples);
+        uint64_t chunk_end = (chunk + 1) * info->chunk_samples;
+        if (chunk_end > info->num_samples) chunk_end = info->num_samples;
+        size_t n = (size_t)(chunk_end - start);
+        if (n > max_samples - done) n = max_samples - done;
+
+        memcpy(out + done * sample_bytes, file->chunk + offset * sample_bytes, n * sample_bytes);
+        done += n;
+        start += n;
+    }
+
+    return done;
+}
+
+void iqz_close(iqz_file_t *file) {
+    if (!file) {
+        return;
+    }
+
+    if (file->file) {
+        fclose(file->file);
+    }
+    free(file->offsets);
+    free(file->compressed);
+    free(file->chunk);
+    free(file);
+}
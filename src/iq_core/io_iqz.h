@@ -0,0 +1,93 @@
+#ifndef IQ_IO_IQZ_H
+#define IQ_IO_IQZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "io_iq.h"
+
+/*
+ * IQZ: chunked, compressed container for s8/s16 IQ captures
+ *
+ * Layout (little-endian):
+ *   64-byte header   magic "IQLABIQZ", version, sample format, codec,
+ *                    chunk size, sample rate, sample count, index offset
+ *   chunks           each starts with its mode byte and decodes on its own
+ *   index            num_chunks + 1 offsets; chunk k is [off[k], off[k+1])
+ *
+ * Codecs, chosen per file:
+ *   IQZ_CODEC_LOSSLESS  per chunk and channel, the best of order 0/1/2
+ *                       fixed prediction, residuals Rice-coded in blocks of
+ *                       64 values with their own parameter; a chunk that
+ *                       does not shrink is stored raw
+ *   IQZ_CODEC_BFP       fixed-rate block floating point: every 16 values
+ *                       share a 4-bit exponent and keep 'mantissa_bits'
+ *                       signed bits each (lossy)
+ *
+ * Every chunk holds chunk_samples samples (the last may be shorter), so
+ * the chunk of any sample is a division and a seek costs at most one
+ * chunk decode. iq_reader_open() reads IQZ files transparently.
+ */
+
+#define IQZ_MAGIC "IQLABIQZ"
+#define IQZ_VERSION 1
+#define IQZ_HEADER_SIZE 64
+
+// Default samples per chunk (256 KiB of raw s16)
+#define IQZ_DEFAULT_CHUNK 65536
+
+typedef enum {
+    IQZ_CODEC_LOSSLESS = 0,   // Prediction + Rice coding
+    IQZ_CODEC_BFP = 1         // Fixed-rate block floating point
+} iqz_codec_t;
+
+// Container description, valid while the file is open
+typedef struct {
+    iq_format_t format;       // Sample format the values decode to
+    iqz_codec_t codec;
+    uint32_t mantissa_bits;   // BFP only
+    uint32_t chunk_samples;   // Complex samples per chunk
+    uint32_t sample_rate;     // 0 when unknown
+    uint64_t num_samples;     // Complex samples in the file
+    uint64_t num_chunks;
+    uint64_t file_bytes;      // Size of the container on disk
+} iqz_info_t;
+
+typedef struct iqz_writer iqz_writer_t;
+typedef struct iqz_file iqz_file_t;
+
+/*
+ * Create a container; 'mantissa_bits' 0 selects the lossless codec,
+ * otherwise BFP with that many bits (2..7 for s8, 2..15 for s16).
+ * 'chunk_samples' 0 uses IQZ_DEFAULT_CHUNK.
+ */
+iqz_writer_t *iqz_writer_create(const char *filename, iq_format_t format, uint32_t sample_rate,
+                                uint32_t chunk_samples, uint32_t mantissa_bits);
+
+// Append interleaved native s8/s16 samples
+bool iqz_writer_write(iqz_writer_t *writer, const void *samples, size_t num_samples);
+
+// Flush the last chunk, write the index and header; false if any write failed
+bool iqz_writer_close(iqz_writer_t *writer);
+
+// True if the file starts with the IQZ magic
+bool iqz_probe(const char *filename);
+
+// Open a finished container for reading (NULL on error)
+iqz_file_t *iqz_open(const char *filename);
+
+const iqz_info_t *iqz_info(const iqz_file_t *file);
+
+/*
+ * Decode up to 'max_samples' samples starting at 'start' into 'samples'
+ * (interleaved native values). Returns the number decoded; 0 at the end
+ * of the file or on a corrupt chunk.
+ */
+size_t iqz_read(iqz_file_t *file, uint64_t start, void *samples, size_t max_samples);
+
+// Compressed bytes read from disk so far
+uint64_t iqz_bytes_read(const iqz_file_t *file);
+
+void iqz_close(iqz_file_t *file);
+
+#endif // IQ_IO_IQZ_H
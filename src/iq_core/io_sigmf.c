@@ -11,13 +11,15 @@
  * SIGMF STANDARD:
  *   - Version 1.2.0 compliance
  *   - JSON-based metadata format
- *   - Supports complex data types (ci8, ci16, cf32)
+ *   - Supports complex data types (ci8, ci16, cf32, packed ci12/ci4)
  *   - Frequency, sample rate, and timing information
  *   - Extensible annotations and captures metadata
  *
  * FEATURES:
  *   - Complete SigMF v1.2.0 reader/writer implementation
- *   - Lightweight JSON parser (no external dependencies)
+ *   - Single-pass JSON tokenizer (no external dependencies)
+ *   - Streaming annotation reader and writer for large detection outputs
+ *   - Sidecar interval-tree index for time/frequency annotation queries
  *   - Automatic format detection and validation
  *   - Metadata validation and error reporting
  *   - Support for multiple captures and annotations
@@ -26,7 +28,7 @@
  * METADATA SUPPORTED:
  *   - Global: version, datatype, sample_rate, center_frequency, description, author, datetime
  *   - Captures: sample_start, frequency, datetime, sample_count
- *   - Annotations: sample_start, sample_count, frequency, description, comment
+ *   - Annotations: sample_start, sample_count, freq_lower/upper_edge, label, comment
  *
  * USAGE:
  *   1. Initialize metadata: sigmf_init_metadata(&meta)
@@ -40,8 +42,8 @@
  *   - Automatic pairing by filename convention
  *
  * PERFORMANCE:
- *   - Minimal memory footprint
- *   - Fast JSON parsing without external libraries
+ *   - Minimal memory footprint (fixed read buffer, no whole-file copy)
+ *   - O(n) JSON parsing: each byte is tokenized once, no key rescans
  *   - Efficient string handling and validation
  *
  * DEPENDENCIES:
@@ -64,15 +66,24 @@
 #include <ctype.h>
 #include <time.h>
 #include <errno.h>
+#include <sys/stat.h>
 
 /*
  * Minimal SigMF v1.2.0 implementation
- * Simple JSON parser/writer without external dependencies
+ * Single-pass JSON tokenizer/writer without external dependencies
  */
 
-// Internal buffer sizes
-#define SIGMF_JSON_BUFFER_SIZE 8192
-#define SIGMF_MAX_LINE_LENGTH 1024
+// Bytes pulled from the file per refill
+#define SIGMF_JSON_CHUNK_SIZE 65536
+
+// Longest decoded string kept from one token (the rest is consumed and dropped)
+#define SIGMF_JSON_TEXT_SIZE 1024
+
+// Longest member key kept for matching (every core: key is shorter)
+#define SIGMF_JSON_KEY_SIZE 64
+
+// Nesting limit when skipping unknown values
+#define SIGMF_JSON_MAX_DEPTH 256
 
 // Initialize SigMF metadata structure
 void sigmf_init_metadata(sigmf_metadata_t *metadata) {
@@ -102,103 +113,459 @@ void sigmf_free_metadata(sigmf_metadata_t *metadata) {
     }
     metadata->num_captures = 0;
     metadata->num_annotations = 0;
+    metadata->annotation_capacity = 0;
 }
 
-// Simple JSON string escaping
-static void json_escape_string(const char *input, char *output, size_t max_len) {
-    size_t i = 0, j = 0;
+/*
+ * JSON tokenizer
+ * Pulls the file through a fixed chunk, one token at a time. Strings are
+ * unescaped (\uXXXX to UTF-8) into the token text, numbers and literals
+ * keep their source text; structural characters are tokens of their own
+ * so the parser checks separators itself.
+ */
+
+typedef enum {
+    JSON_END,
+    JSON_OBJECT_START,
+    JSON_OBJECT_END,
+    JSON_ARRAY_START,
+    JSON_ARRAY_END,
+    JSON_COLON,
+    JSON_COMMA,
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_LITERAL,       // true, false, null
+    JSON_ERROR
+} json_token_type_t;
+
+typedef struct {
+    FILE *file;
+    const char *filename;
+    char chunk[SIGMF_JSON_CHUNK_SIZE];
+    size_t chunk_limit;             // Bytes requested per refill (<= chunk size)
+    size_t chunk_length;
+    size_t chunk_position;
+    uint64_t chunk_offset;          // File offset of chunk[0]
+    size_t line;
+
+    json_token_type_t type;
+    uint64_t token_offset;          // File offset of the current token
+    char text[SIGMF_JSON_TEXT_SIZE];
+    size_t text_length;
+    char key[SIGMF_JSON_KEY_SIZE];  // Key of the member being read
+    bool failed;
+} json_reader_t;
+
+static void json_reader_init(json_reader_t *reader, FILE *file, const char *filename) {
+    reader->file = file;
+    reader->filename = filename;
+    reader->chunk_limit = sizeof(reader->chunk);
+    reader->chunk_length = 0;
+    reader->chunk_position = 0;
+    reader->chunk_offset = 0;
+    reader->line = 1;
+    reader->type = JSON_END;
+    reader->token_offset = 0;
+    reader->text[0] = '\0';
+    reader->text_length = 0;
+    reader->key[0] = '\0';
+    reader->failed = false;
+}
 
-    if (!input || !output || max_len < 3) return;
+static bool json_fail(json_reader_t *reader, const char *message) {
+    if (!reader->failed) {
+        fprintf(stderr, "Error: %s:%zu: %s\n", reader->filename, reader->line, message);
+    }
+    reader->failed = true;
+    reader->type = JSON_ERROR;
+    return false;
+}
 
-    output[j++] = '"';
+static int json_peek(json_reader_t *reader) {
+    if (reader->chunk_position == reader->chunk_length) {
+        reader->chunk_offset += reader->chunk_length;
+        reader->chunk_length = fread(reader->chunk, 1, reader->chunk_limit, reader->file);
+        reader->chunk_position = 0;
+        if (reader->chunk_length == 0) return EOF;
+    }
+    return (unsigned char)reader->chunk[reader->chunk_position];
+}
 
-    for (i = 0; input[i] && j < max_len - 2; i++) {
-        char c = input[i];
-        if (c == '"' || c == '\\') {
-            if (j < max_len - 3) {
-                output[j++] = '\\';
-                output[j++] = c;
-            }
-        } else if (c == '\n') {
-            if (j < max_len - 3) {
-                output[j++] = '\\';
-                output[j++] = 'n';
-            }
-        } else if (c == '\r') {
-            if (j < max_len - 3) {
-                output[j++] = '\\';
-                output[j++] = 'r';
-            }
-        } else if (c == '\t') {
-            if (j < max_len - 3) {
-                output[j++] = '\\';
-                output[j++] = 't';
+static int json_get(json_reader_t *reader) {
+    int c = json_peek(reader);
+    if (c != EOF) {
+        reader->chunk_position++;
+        if (c == '\n') reader->line++;
+    }
+    return c;
+}
+
+static void json_append(json_reader_t *reader, int c) {
+    if (reader->text_length + 1 < sizeof(reader->text)) {
+        reader->text[reader->text_length++] = (char)c;
+    }
+}
+
+static void json_append_utf8(json_reader_t *reader, uint32_t code) {
+    if (code < 0x80) {
+        json_append(reader, (int)code);
+    } else if (code < 0x800) {
+        json_append(reader, 0xC0 | (int)(code >> 6));
+        json_append(reader, 0x80 | (int)(code & 0x3F));
+    } else if (code < 0x10000) {
+        json_append(reader, 0xE0 | (int)(code >> 12));
+        json_append(reader, 0x80 | (int)((code >> 6) & 0x3F));
+        json_append(reader, 0x80 | (int)(code & 0x3F));
+    } else {
+        json_append(reader, 0xF0 | (int)(code >> 18));
+        json_append(reader, 0x80 | (int)((code >> 12) & 0x3F));
+        json_append(reader, 0x80 | (int)((code >> 6) & 0x3F));
+        json_append(reader, 0x80 | (int)(code & 0x3F));
+    }
+}
+
+static bool json_read_hex4(json_reader_t *reader, uint32_t *code) {
+    *code = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = json_get(reader);
+        if (!isxdigit(c)) return json_fail(reader, "Invalid \\u escape");
+        *code = (*code << 4) | (uint32_t)(isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+    }
+    return true;
+}
+
+static bool json_read_string(json_reader_t *reader) {
+    for (;;) {
+        int c = json_get(reader);
+        if (c == EOF || c == '\n') return json_fail(reader, "Unterminated string");
+        if (c == '"') break;
+        if (c != '\\') {
+            json_append(reader, c);
+            continue;
+        }
+
+        c = json_get(reader);
+        switch (c) {
+            case '"': case '\\': case '/': json_append(reader, c); break;
+            case 'b': json_append(reader, '\b'); break;
+            case 'f': json_append(reader, '\f'); break;
+            case 'n': json_append(reader, '\n'); break;
+            case 'r': json_append(reader, '\r'); break;
+            case 't': json_append(reader, '\t'); break;
+            case 'u': {
+                uint32_t code;
+                if (!json_read_hex4(reader, &code)) return false;
+                // A high surrogate pairs with the \uDC00-\uDFFF that follows it
+                if (code >= 0xD800 && code < 0xDC00 && json_peek(reader) == '\\') {
+                    json_get(reader);
+                    uint32_t low;
+                    if (json_get(reader) != 'u' || !json_read_hex4(reader, &low)) {
+                        return json_fail(reader, "Invalid surrogate pair");
+                    }
+                    code = (low >= 0xDC00 && low < 0xE000)
+                         ? 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00) : '?';
+                } else if (code >= 0xD800 && code < 0xE000) {
+                    code = '?';
+                }
+                json_append_utf8(reader, code);
+                break;
             }
-        } else if (isprint(c)) {
-            output[j++] = c;
+            default:
+                return json_fail(reader, "Invalid escape in string");
         }
     }
+    reader->type = JSON_STRING;
+    return true;
+}
 
-    output[j++] = '"';
-    output[j] = '\0';
+// Advance to the next token; false on end of input or error
+static bool json_next(json_reader_t *reader) {
+    if (reader->failed) return false;
+
+    int c = json_get(reader);
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r') c = json_get(reader);
+
+    reader->text_length = 0;
+    reader->text[0] = '\0';
+    reader->token_offset = reader->chunk_offset + reader->chunk_position - 1;
+
+    bool ok = true;
+    switch (c) {
+        case EOF: reader->type = JSON_END; return false;
+        case '{': reader->type = JSON_OBJECT_START; break;
+        case '}': reader->type = JSON_OBJECT_END; break;
+        case '[': reader->type = JSON_ARRAY_START; break;
+        case ']': reader->type = JSON_ARRAY_END; break;
+        case ':': reader->type = JSON_COLON; break;
+        case ',': reader->type = JSON_COMMA; break;
+        case '"': ok = json_read_string(reader); break;
+        default:
+            if (c == '-' || isdigit(c)) {
+                json_append(reader, c);
+                while ((c = json_peek(reader)) != EOF &&
+                       (isdigit(c) || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')) {
+                    json_append(reader, json_get(reader));
+                }
+                reader->type = JSON_NUMBER;
+            } else if (isalpha(c)) {
+                json_append(reader, c);
+                while ((c = json_peek(reader)) != EOF && isalpha(c)) {
+                    json_append(reader, json_get(reader));
+                }
+                reader->text[reader->text_length] = '\0';
+                if (strcmp(reader->text, "true") != 0 && strcmp(reader->text, "false") != 0 &&
+                    strcmp(reader->text, "null") != 0) {
+                    return json_fail(reader, "Unexpected word");
+                }
+                reader->type = JSON_LITERAL;
+            } else {
+                return json_fail(reader, "Unexpected character");
+            }
+            break;
+    }
+    reader->text[reader->text_length] = '\0';
+    return ok;
+}
+
+/*
+ * Parser primitives
+ * Containers are walked with json_next_member / json_next_element once
+ * their opening token is current; each leaves the first token of the
+ * member value or element current, as every value reader expects.
+ */
+
+// Copy a token's text into a field, cutting at a UTF-8 character boundary
+static void json_copy_text(char *dest, size_t size, const char *text, size_t length) {
+    if (length >= size) {
+        length = size - 1;
+        while (length > 0 && ((unsigned char)text[length] & 0xC0) == 0x80) length--;
+    }
+    memcpy(dest, text, length);
+    dest[length] = '\0';
 }
 
-// Simple JSON parsing helpers
-static char *json_skip_whitespace(char *json) {
-    while (*json && isspace(*json)) json++;
-    return json;
+static bool json_is_value_start(json_token_type_t type) {
+    return type == JSON_OBJECT_START || type == JSON_ARRAY_START || type == JSON_STRING ||
+           type == JSON_NUMBER || type == JSON_LITERAL;
 }
 
-static char *json_find_string_value(char *json, const char *key) {
-    char search_key[256];
-    snprintf(search_key, sizeof(search_key), "\"%s\"", key);
+// Next member of an object: true with reader->key set, false at '}' or on error
+static bool json_next_member(json_reader_t *reader, bool *first) {
+    if (!json_next(reader)) return json_fail(reader, "Unterminated object");
+    if (reader->type == JSON_OBJECT_END) return false;
+    if (!*first) {
+        if (reader->type != JSON_COMMA) return json_fail(reader, "Expected ',' or '}' in object");
+        if (!json_next(reader)) return json_fail(reader, "Unterminated object");
+    }
+    *first = false;
 
-    char *pos = strstr(json, search_key);
-    if (!pos) return NULL;
+    if (reader->type != JSON_STRING) return json_fail(reader, "Expected a member name");
+    json_copy_text(reader->key, sizeof(reader->key), reader->text, reader->text_length);
 
-    pos += strlen(search_key);
-    pos = json_skip_whitespace(pos);
+    if (!json_next(reader) || reader->type != JSON_COLON) {
+        return json_fail(reader, "Expected ':' after member name");
+    }
+    if (!json_next(reader) || !json_is_value_start(reader->type)) {
+        return json_fail(reader, "Missing member value");
+    }
+    return true;
+}
 
-    if (*pos != ':') return NULL;
-    pos = json_skip_whitespace(pos + 1);
+// Next element of an array: true on its first token, false at ']' or on error
+static bool json_next_element(json_reader_t *reader, bool *first) {
+    if (!json_next(reader)) return json_fail(reader, "Unterminated array");
+    if (reader->type == JSON_ARRAY_END) return false;
+    if (!*first) {
+        if (reader->type != JSON_COMMA) return json_fail(reader, "Expected ',' or ']' in array");
+        if (!json_next(reader)) return json_fail(reader, "Unterminated array");
+    }
+    *first = false;
 
-    if (*pos != '"') return NULL;
-    return pos + 1; // Return start of string value
+    if (!json_is_value_start(reader->type)) return json_fail(reader, "Missing array element");
+    return true;
 }
 
-static char *json_extract_string(char *json, char *dest, size_t max_len) {
-    char *start = json;
-    char *end = start;
+// Consume the value whose first token is current
+static bool json_skip_value(json_reader_t *reader, int depth) {
+    if (depth > SIGMF_JSON_MAX_DEPTH) return json_fail(reader, "Nesting too deep");
 
-    while (*end && *end != '"' && (size_t)(end - start) < max_len - 1) {
-        if (*end == '\\' && *(end + 1)) {
-            end++; // Skip escaped character
-        }
-        end++;
+    bool first = true;
+    switch (reader->type) {
+        case JSON_OBJECT_START:
+            while (json_next_member(reader, &first)) {
+                if (!json_skip_value(reader, depth + 1)) return false;
+            }
+            return !reader->failed;
+        case JSON_ARRAY_START:
+            while (json_next_element(reader, &first)) {
+                if (!json_skip_value(reader, depth + 1)) return false;
+            }
+            return !reader->failed;
+        case JSON_STRING:
+        case JSON_NUMBER:
+        case JSON_LITERAL:
+            return true;
+        default:
+            return json_fail(reader, "Unexpected token");
     }
+}
 
-    if (*end != '"') return NULL;
+// Unsigned integer value; fractional or exponent forms are rounded, values of
+// another type are skipped and leave 'value' unchanged
+static bool json_read_uint64(json_reader_t *reader, uint64_t *value) {
+    if (reader->type != JSON_NUMBER) return json_skip_value(reader, 0);
+
+    char *end = NULL;
+    if (strpbrk(reader->text, ".eE")) {
+        double number = strtod(reader->text, &end);
+        if (*end) return json_fail(reader, "Invalid number");
+        *value = number > 0.0 ? (uint64_t)(number + 0.5) : 0;
+    } else if (reader->text[0] == '-') {
+        strtoll(reader->text, &end, 10);
+        if (*end) return json_fail(reader, "Invalid number");
+        *value = 0;
+    } else {
+        errno = 0;
+        unsigned long long number = strtoull(reader->text, &end, 10);
+        if (*end || errno == ERANGE) return json_fail(reader, "Invalid number");
+        *value = (uint64_t)number;
+    }
+    return true;
+}
 
-    size_t len = (size_t)(end - start);
-    if (len >= max_len) len = max_len - 1;
+// String value truncated to 'size'; values of another type are skipped
+static bool json_read_text(json_reader_t *reader, char *dest, size_t size) {
+    if (reader->type != JSON_STRING) return json_skip_value(reader, 0);
+    json_copy_text(dest, size, reader->text, reader->text_length);
+    return true;
+}
+
+static bool json_read_global(json_reader_t *reader, sigmf_global_t *global) {
+    if (reader->type != JSON_OBJECT_START) return json_fail(reader, "\"global\" is not an object");
+
+    bool first = true;
+    while (json_next_member(reader, &first)) {
+        const char *key = reader->key;
+        bool ok;
+        if (strcmp(key, "core:datatype") == 0) {
+            ok = json_read_text(reader, global->datatype, sizeof(global->datatype));
+        } else if (strcmp(key, "core:sample_rate") == 0) {
+            ok = json_read_uint64(reader, &global->sample_rate);
+        } else if (strcmp(key, "core:version") == 0) {
+            ok = json_read_text(reader, global->version, sizeof(global->version));
+        } else if (strcmp(key, "core:description") == 0) {
+            ok = json_read_text(reader, global->description, sizeof(global->description));
+        } else if (strcmp(key, "core:author") == 0) {
+            ok = json_read_text(reader, global->author, sizeof(global->author));
+        } else if (strcmp(key, "core:datetime") == 0) {
+            ok = json_read_text(reader, global->datetime, sizeof(global->datetime));
+        } else if (strcmp(key, "core:license") == 0) {
+            ok = json_read_text(reader, global->license, sizeof(global->license));
+        } else if (strcmp(key, "core:hw") == 0) {
+            ok = json_read_text(reader, global->hw_info, sizeof(global->hw_info));
+        } else if (strcmp(key, "core:sha512") == 0) {
+            // Hex digest of the dataset
+            ok = json_read_text(reader, global->sha512, sizeof(global->sha512));
+        } else {
+            ok = json_skip_value(reader, 1);
+        }
+        if (!ok) return false;
+    }
+    return !reader->failed;
+}
+
+static bool json_read_captures(json_reader_t *reader, sigmf_metadata_t *metadata) {
+    if (reader->type != JSON_ARRAY_START) return json_fail(reader, "\"captures\" is not an array");
+
+    bool element = true;
+    while (json_next_element(reader, &element)) {
+        if (reader->type != JSON_OBJECT_START) return json_fail(reader, "Capture is not an object");
+
+        uint64_t sample_start = 0;
+        uint64_t frequency = metadata->global.frequency;
+        char datetime[32] = "";
+
+        bool first = true;
+        while (json_next_member(reader, &first)) {
+            const char *key = reader->key;
+            bool ok;
+            if (strcmp(key, "core:sample_start") == 0) {
+                ok = json_read_uint64(reader, &sample_start);
+            } else if (strcmp(key, "core:frequency") == 0) {
+                ok = json_read_uint64(reader, &frequency);
+            } else if (strcmp(key, "core:datetime") == 0) {
+                ok = json_read_text(reader, datetime, sizeof(datetime));
+            } else {
+                ok = json_skip_value(reader, 1);
+            }
+            if (!ok) return false;
+        }
+        if (reader->failed) return false;
 
-    memcpy(dest, start, len);
-    dest[len] = '\0';
+        if (!sigmf_add_capture(metadata, sample_start, frequency, datetime)) {
+            return json_fail(reader, "Out of memory for captures");
+        }
+    }
+    return !reader->failed;
+}
 
-    return end + 1;
+// One annotation object (current token); core:comment and the older
+// core:description both land in 'description'
+static bool json_read_annotation(json_reader_t *reader, sigmf_annotation_t *annotation) {
+    memset(annotation, 0, sizeof(*annotation));
+    if (reader->type != JSON_OBJECT_START) return json_fail(reader, "Annotation is not an object");
+
+    bool first = true;
+    while (json_next_member(reader, &first)) {
+        const char *key = reader->key;
+        bool ok;
+        if (strcmp(key, "core:sample_start") == 0) {
+            ok = json_read_uint64(reader, &annotation->sample_start);
+        } else if (strcmp(key, "core:sample_count") == 0) {
+            ok = json_read_uint64(reader, &annotation->sample_count);
+        } else if (strcmp(key, "core:freq_lower_edge") == 0) {
+            ok = json_read_uint64(reader, &annotation->freq_lower_edge);
+        } else if (strcmp(key, "core:freq_upper_edge") == 0) {
+            ok = json_read_uint64(reader, &annotation->freq_upper_edge);
+        } else if (strcmp(key, "core:label") == 0) {
+            ok = json_read_text(reader, annotation->label, sizeof(annotation->label));
+        } else if (strcmp(key, "core:comment") == 0 || strcmp(key, "core:description") == 0) {
+            ok = json_read_text(reader, annotation->description, sizeof(annotation->description));
+        } else {
+            ok = json_skip_value(reader, 1);
+        }
+        if (!ok) return false;
+    }
+    return !reader->failed;
 }
 
-static uint64_t json_extract_uint64(char *json) {
-    char *end;
-    return strtoull(json, &end, 10);
+// Room for one more annotation, growing the array geometrically
+static sigmf_annotation_t *sigmf_append_annotation(sigmf_metadata_t *metadata) {
+    if (metadata->num_annotations >= metadata->annotation_capacity) {
+        size_t capacity = metadata->num_annotations ? metadata->num_annotations * 2 : 16;
+        sigmf_annotation_t *annotations = realloc(metadata->annotations,
+                                                  capacity * sizeof(sigmf_annotation_t));
+        if (!annotations) return NULL;
+        metadata->annotations = annotations;
+        metadata->annotation_capacity = capacity;
+    }
+    return &metadata->annotations[metadata->num_annotations++];
 }
 
-/*
-static double json_extract_double(char *json) {
-    char *end;
-    return strtod(json, &end);
+static bool json_read_annotations(json_reader_t *reader, sigmf_metadata_t *metadata) {
+    if (reader->type != JSON_ARRAY_START) return json_fail(reader, "\"annotations\" is not an array");
+
+    bool first = true;
+    while (json_next_element(reader, &first)) {
+        sigmf_annotation_t *annotation = sigmf_append_annotation(metadata);
+        if (!annotation) return json_fail(reader, "Out of memory for annotations");
+        if (!json_read_annotation(reader, annotation)) {
+            metadata->num_annotations--;
+            return false;
+        }
+    }
+    return !reader->failed;
 }
-*/
 
 // Read SigMF metadata from .sigmf-meta file
 bool sigmf_read_metadata(const char *filename, sigmf_metadata_t *metadata) {
@@ -207,113 +574,219 @@ bool sigmf_read_metadata(const char *filename, sigmf_metadata_t *metadata) {
     FILE *file = fopen(filename, "r");
     if (!file) return false;
 
-    char buffer[SIGMF_JSON_BUFFER_SIZE];
-    size_t bytes_read = fread(buffer, 1, sizeof(buffer) - 1, file);
-    fclose(file);
-
-    if (bytes_read == 0) return false;
-    buffer[bytes_read] = '\0';
+    json_reader_t *reader = malloc(sizeof(json_reader_t));
+    if (!reader) {
+        fclose(file);
+        return false;
+    }
+    json_reader_init(reader, file, filename);
 
     // Initialize metadata
     sigmf_init_metadata(metadata);
 
-    char *json = buffer;
-
-    // Parse global section
-    char *global_pos = strstr(json, "\"global\"");
-    if (global_pos) {
-        // Parse core:datatype
-        char *datatype_pos = json_find_string_value(global_pos, "core:datatype");
-        if (datatype_pos) {
-            char datatype_str[16];
-            json_extract_string(datatype_pos, datatype_str, sizeof(datatype_str));
-            strcpy(metadata->global.datatype, datatype_str);
-        }
+    bool ok = json_next(reader) && reader->type == JSON_OBJECT_START;
+    if (!ok) {
+        json_fail(reader, "Expected a JSON object");
+    }
 
-        // Parse core:sample_rate
-        char *rate_pos = json_find_string_value(global_pos, "core:sample_rate");
-        if (rate_pos) {
-            metadata->global.sample_rate = json_extract_uint64(rate_pos);
+    bool first = true;
+    while (ok && json_next_member(reader, &first)) {
+        if (strcmp(reader->key, "global") == 0) {
+            ok = json_read_global(reader, &metadata->global);
+        } else if (strcmp(reader->key, "captures") == 0) {
+            ok = json_read_captures(reader, metadata);
+        } else if (strcmp(reader->key, "annotations") == 0) {
+            ok = json_read_annotations(reader, metadata);
+        } else {
+            ok = json_skip_value(reader, 1);
         }
+    }
+    ok = ok && !reader->failed;
 
-        // Parse core:version
-        char *version_pos = json_find_string_value(global_pos, "core:version");
-        if (version_pos) {
-            char version_str[16];
-            json_extract_string(version_pos, version_str, sizeof(version_str));
-            strcpy(metadata->global.version, version_str);
-        }
+    // Nothing but whitespace may follow the document
+    if (ok && json_next(reader)) {
+        ok = json_fail(reader, "Trailing data after the document");
+    }
+    ok = ok && !reader->failed;
 
-        // Parse core:description
-        char *desc_pos = json_find_string_value(global_pos, "core:description");
-        if (desc_pos) {
-            json_extract_string(desc_pos, metadata->global.description, sizeof(metadata->global.description));
-        }
+    fclose(file);
+    free(reader);
+    return ok;
+}
 
-        // Parse core:author
-        char *author_pos = json_find_string_value(global_pos, "core:author");
-        if (author_pos) {
-            json_extract_string(author_pos, metadata->global.author, sizeof(metadata->global.author));
-        }
-    }
+/*
+ * Streaming annotation reader
+ */
 
-    // Parse captures section
-    char *captures_pos = strstr(json, "\"captures\"");
-    if (captures_pos) {
-        // Simple implementation - parse first capture only for now
-        char *sample_start_pos = json_find_string_value(captures_pos, "core:sample_start");
-        if (sample_start_pos) {
-            sigmf_add_capture(metadata, json_extract_uint64(sample_start_pos),
-                            metadata->global.frequency, metadata->global.datetime);
-        }
+struct sigmf_annotation_reader {
+    json_reader_t json;
+    char path[1024];
+    bool first;             // No element of the array read yet
+    bool done;              // Array ended (or the document has none)
+};
 
-        char *freq_pos = json_find_string_value(captures_pos, "core:frequency");
-        if (freq_pos) {
-            metadata->captures[0].frequency = json_extract_uint64(freq_pos);
-        }
+sigmf_annotation_reader_t *sigmf_annotation_reader_open(const char *filename) {
+    if (!filename) return NULL;
 
-        char *datetime_pos = json_find_string_value(captures_pos, "core:datetime");
-        if (datetime_pos) {
-            json_extract_string(datetime_pos, metadata->captures[0].datetime, sizeof(metadata->captures[0].datetime));
+    sigmf_annotation_reader_t *reader = malloc(sizeof(sigmf_annotation_reader_t));
+    if (!reader) return NULL;
+
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        free(reader);
+        return NULL;
+    }
+    snprintf(reader->path, sizeof(reader->path), "%s", filename);
+    json_reader_init(&reader->json, file, reader->path);
+    reader->first = true;
+    reader->done = true;
+
+    json_reader_t *json = &reader->json;
+    if (!json_next(json) || json->type != JSON_OBJECT_START) {
+        json_fail(json, "Expected a JSON object");
+    }
+
+    // Skip members up to the annotations array
+    bool first = true;
+    while (!json->failed && json_next_member(json, &first)) {
+        if (strcmp(json->key, "annotations") != 0) {
+            json_skip_value(json, 1);
+        } else if (json->type != JSON_ARRAY_START) {
+            json_fail(json, "\"annotations\" is not an array");
+        } else {
+            reader->done = false;
+            break;
         }
     }
 
+    if (json->failed) {
+        fclose(file);
+        free(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+// Next annotation and the file offset of its object
+static bool sigmf_annotation_reader_next_at(sigmf_annotation_reader_t *reader,
+                                            sigmf_annotation_t *annotation, uint64_t *offset) {
+    if (!reader || !annotation || reader->done) return false;
+
+    if (!json_next_element(&reader->json, &reader->first)) {
+        reader->done = true;
+        return false;
+    }
+    *offset = reader->json.token_offset;
+    if (!json_read_annotation(&reader->json, annotation)) {
+        reader->done = true;
+        return false;
+    }
     return true;
 }
 
-// Write SigMF metadata to .sigmf-meta file
-bool sigmf_write_metadata(const char *filename, const sigmf_metadata_t *metadata) {
-    if (!filename || !metadata) return false;
+bool sigmf_annotation_reader_next(sigmf_annotation_reader_t *reader, sigmf_annotation_t *annotation) {
+    uint64_t offset;
+    return sigmf_annotation_reader_next_at(reader, annotation, &offset);
+}
+
+bool sigmf_annotation_reader_close(sigmf_annotation_reader_t *reader) {
+    if (!reader) return false;
+
+    bool ok = !reader->json.failed;
+    fclose(reader->json.file);
+    free(reader);
+    return ok;
+}
+
+/*
+ * Writer
+ */
+
+struct sigmf_writer {
+    FILE *file;
+    size_t num_annotations;     // Annotations written so far
+};
+
+// Write 's' as a quoted JSON string (UTF-8 passes through unchanged)
+static void json_write_string(FILE *file, const char *s) {
+    fputc('"', file);
+    for (const unsigned char *p = (const unsigned char *)(s ? s : ""); *p; p++) {
+        switch (*p) {
+            case '"': fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            case '\n': fputs("\\n", file); break;
+            case '\r': fputs("\\r", file); break;
+            case '\t': fputs("\\t", file); break;
+            default:
+                if (*p < 0x20) {
+                    fprintf(file, "\\u%04x", *p);
+                } else {
+                    fputc(*p, file);
+                }
+                break;
+        }
+    }
+    fputc('"', file);
+}
+
+sigmf_writer_t *sigmf_writer_open(const char *filename, const sigmf_metadata_t *metadata) {
+    if (!filename || !metadata) return NULL;
+
+    sigmf_writer_t *writer = malloc(sizeof(sigmf_writer_t));
+    if (!writer) return NULL;
 
     FILE *file = fopen(filename, "w");
-    if (!file) return false;
+    if (!file) {
+        free(writer);
+        return NULL;
+    }
+    writer->file = file;
+    writer->num_annotations = 0;
 
+    const sigmf_global_t *global = &metadata->global;
     fprintf(file, "{\n");
     fprintf(file, "  \"global\": {\n");
-    fprintf(file, "    \"core:datatype\": \"%s\",\n", metadata->global.datatype);
-    fprintf(file, "    \"core:sample_rate\": %llu,\n", metadata->global.sample_rate);
-    fprintf(file, "    \"core:version\": \"%s\",\n", metadata->global.version);
-
-    char escaped_desc[512];
-    json_escape_string(metadata->global.description, escaped_desc, sizeof(escaped_desc));
-    fprintf(file, "    \"core:description\": %s,\n", escaped_desc);
-
-    char escaped_author[256];
-    json_escape_string(metadata->global.author, escaped_author, sizeof(escaped_author));
-    fprintf(file, "    \"core:author\": %s,\n", escaped_author);
+    fprintf(file, "    \"core:datatype\": ");
+    json_write_string(file, global->datatype);
+    fprintf(file, ",\n    \"core:sample_rate\": %llu,\n", (unsigned long long)global->sample_rate);
+    fprintf(file, "    \"core:version\": ");
+    json_write_string(file, global->version);
+    fprintf(file, ",\n    \"core:description\": ");
+    json_write_string(file, global->description);
+    fprintf(file, ",\n    \"core:author\": ");
+    json_write_string(file, global->author);
+    fprintf(file, ",\n");
+
+    if (global->license[0]) {
+        fprintf(file, "    \"core:license\": ");
+        json_write_string(file, global->license);
+        fprintf(file, ",\n");
+    }
+    if (global->hw_info[0]) {
+        fprintf(file, "    \"core:hw\": ");
+        json_write_string(file, global->hw_info);
+        fprintf(file, ",\n");
+    }
+    if (global->sha512[0]) {
+        fprintf(file, "    \"core:sha512\": ");
+        json_write_string(file, global->sha512);
+        fprintf(file, ",\n");
+    }
 
-    fprintf(file, "    \"core:datetime\": \"%s\"\n", metadata->global.datetime);
-    fprintf(file, "  },\n");
+    fprintf(file, "    \"core:datetime\": ");
+    json_write_string(file, global->datetime);
+    fprintf(file, "\n  },\n");
 
     fprintf(file, "  \"captures\": [\n");
 
     for (size_t i = 0; i < metadata->num_captures; i++) {
         const sigmf_capture_t *capture = &metadata->captures[i];
         fprintf(file, "    {\n");
-        fprintf(file, "      \"core:sample_start\": %llu,\n", capture->sample_start);
-        fprintf(file, "      \"core:frequency\": %llu,\n", capture->frequency);
-        fprintf(file, "      \"core:datetime\": \"%s\"\n", capture->datetime);
-        fprintf(file, "    }");
+        fprintf(file, "      \"core:sample_start\": %llu,\n", (unsigned long long)capture->sample_start);
+        fprintf(file, "      \"core:frequency\": %llu,\n", (unsigned long long)capture->frequency);
+        fprintf(file, "      \"core:datetime\": ");
+        json_write_string(file, capture->datetime);
+        fprintf(file, "\n    }");
 
         if (i < metadata->num_captures - 1) {
             fprintf(file, ",");
@@ -322,13 +795,414 @@ bool sigmf_write_metadata(const char *filename, const sigmf_metadata_t *metadata
     }
 
     fprintf(file, "  ],\n");
-    fprintf(file, "  \"annotations\": []\n");
-    fprintf(file, "}\n");
+    fprintf(file, "  \"annotations\": [");
 
+    for (size_t i = 0; i < metadata->num_annotations; i++) {
+        sigmf_writer_write_annotation(writer, &metadata->annotations[i]);
+    }
+    return writer;
+}
+
+// One annotation per line keeps large detection files diffable
+bool sigmf_writer_write_annotation(sigmf_writer_t *writer, const sigmf_annotation_t *annotation) {
+    if (!writer || !annotation) return false;
+
+    FILE *file = writer->file;
+    fprintf(file, "%s\n    {\"core:sample_start\": %llu, \"core:sample_count\": %llu",
+            writer->num_annotations ? "," : "",
+            (unsigned long long)annotation->sample_start,
+            (unsigned long long)annotation->sample_count);
+    if (annotation->freq_lower_edge || annotation->freq_upper_edge) {
+        fprintf(file, ", \"core:freq_lower_edge\": %llu, \"core:freq_upper_edge\": %llu",
+                (unsigned long long)annotation->freq_lower_edge,
+                (unsigned long long)annotation->freq_upper_edge);
+    }
+    if (annotation->label[0]) {
+        fprintf(file, ", \"core:label\": ");
+        json_write_string(file, annotation->label);
+    }
+    if (annotation->description[0]) {
+        fprintf(file, ", \"core:comment\": ");
+        json_write_string(file, annotation->description);
+    }
+    fputc('}', file);
+
+    writer->num_annotations++;
+    return !ferror(file);
+}
+
+bool sigmf_writer_add_annotation(sigmf_writer_t *writer,
+                                 uint64_t sample_start,
+                                 uint64_t sample_count,
+                                 uint64_t freq_lower,
+                                 uint64_t freq_upper,
+                                 const char *label) {
+    sigmf_annotation_t annotation = {0};
+    annotation.sample_start = sample_start;
+    annotation.sample_count = sample_count;
+    annotation.freq_lower_edge = freq_lower;
+    annotation.freq_upper_edge = freq_upper;
+    if (label) {
+        snprintf(annotation.label, sizeof(annotation.label), "%s", label);
+    }
+    return sigmf_writer_write_annotation(writer, &annotation);
+}
+
+bool sigmf_writer_close(sigmf_writer_t *writer) {
+    if (!writer) return false;
+
+    FILE *file = writer->file;
+    fprintf(file, "%s]\n}\n", writer->num_annotations ? "\n  " : "");
+
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    free(writer);
+    return ok;
+}
+
+// Write SigMF metadata to .sigmf-meta file
+bool sigmf_write_metadata(const char *filename, const sigmf_metadata_t *metadata) {
+    if (!filename || !metadata) return false;
+
+    sigmf_writer_t *writer = sigmf_writer_open(filename, metadata);
+    if (!writer) return false;
+    return sigmf_writer_close(writer);
+}
+
+/*
+ * Annotation index
+ * Annotations sorted by sample_start with an implicit augmented interval
+ * tree laid over the array (cgranges layout): node i at level k is the
+ * array element i, its children sit at i -/+ 2^(k-1), and max_end holds
+ * the largest end in its subtree. Leaves are the even indices; a query
+ * descends only into subtrees whose max_end reaches the window, so it
+ * costs O(log n + matches) and visits matches in sample_start order.
+ */
+
+#define SIGMF_INDEX_MAGIC "IQSIGIDX"
+#define SIGMF_INDEX_VERSION 1u
+#define SIGMF_INDEX_BYTE_ORDER 0x01020304u
+
+// Subtrees at or below this level are scanned linearly
+#define SIGMF_INDEX_SCAN_LEVEL 3
+
+typedef struct {
+    sigmf_index_entry_t entry;
+    uint64_t sample_end;        // Exclusive; zero-length annotations cover one sample
+    uint64_t max_end;           // Largest sample_end in this node's subtree
+} sigmf_index_node_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;        // Catches a sidecar written on another endianness
+    uint32_t node_size;         // Catches a layout change
+    int32_t root_level;
+    uint64_t meta_size;         // Size and mtime of the .sigmf-meta it indexes
+    int64_t meta_mtime;
+    uint64_t count;
+} sigmf_index_header_t;
+
+struct sigmf_annotation_index {
+    sigmf_index_node_t *nodes;
+    size_t count;
+    int root_level;             // -1 when empty
+    char meta_path[1024];
+    FILE *meta;                 // Opened on the first sigmf_index_read_annotation
+};
+
+static int sigmf_index_compare(const void *a, const void *b) {
+    const sigmf_index_entry_t *x = &((const sigmf_index_node_t *)a)->entry;
+    const sigmf_index_entry_t *y = &((const sigmf_index_node_t *)b)->entry;
+    if (x->sample_start != y->sample_start) return x->sample_start < y->sample_start ? -1 : 1;
+    if (x->ordinal != y->ordinal) return x->ordinal < y->ordinal ? -1 : 1;
+    return 0;
+}
+
+// Fill max_end bottom up; returns the root level (-1 when empty)
+static int sigmf_index_build_tree(sigmf_index_node_t *nodes, int64_t n) {
+    if (n <= 0) return -1;
+
+    int64_t last_i = 0;
+    uint64_t last = 0;      // max_end of the rightmost node at the previous level
+    for (int64_t i = 0; i < n; i += 2) {
+        last_i = i;
+        last = nodes[i].max_end = nodes[i].sample_end;
+    }
+
+    int k;
+    for (k = 1; (int64_t)1 << k <= n; k++) {
+        int64_t x = (int64_t)1 << (k - 1);
+        int64_t step = x << 2;
+        for (int64_t i = (x << 1) - 1; i < n; i += step) {
+            uint64_t left = nodes[i - x].max_end;
+            uint64_t right = i + x < n ? nodes[i + x].max_end : last;
+            uint64_t e = nodes[i].sample_end;
+            if (left > e) e = left;
+            if (right > e) e = right;
+            nodes[i].max_end = e;
+        }
+        last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+        if (last_i < n && nodes[last_i].max_end > last) last = nodes[last_i].max_end;
+    }
+    return k - 1;
+}
+
+static bool sigmf_index_meta_stat(const char *meta_filename, uint64_t *size, int64_t *mtime) {
+    struct stat st;
+    if (stat(meta_filename, &st) != 0) return false;
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+// Load the sidecar if it matches the meta file's size and mtime
+static bool sigmf_index_load(sigmf_annotation_index_t *index, const char *index_filename,
+                             uint64_t meta_size, int64_t meta_mtime) {
+    FILE *file = fopen(index_filename, "rb");
+    if (!file) return false;
+
+    sigmf_index_header_t header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, SIGMF_INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == SIGMF_INDEX_VERSION &&
+              header.byte_order == SIGMF_INDEX_BYTE_ORDER &&
+              header.node_size == sizeof(sigmf_index_node_t) &&
+              header.meta_size == meta_size && header.meta_mtime == meta_mtime &&
+              header.count <= SIZE_MAX / sizeof(sigmf_index_node_t);
+
+    sigmf_index_node_t *nodes = NULL;
+    if (ok && header.count > 0) {
+        nodes = malloc((size_t)header.count * sizeof(sigmf_index_node_t));
+        ok = nodes && fread(nodes, sizeof(sigmf_index_node_t), (size_t)header.count, file) == header.count;
+    }
     fclose(file);
+
+    if (!ok) {
+        free(nodes);
+        return false;
+    }
+    index->nodes = nodes;
+    index->count = (size_t)header.count;
+    index->root_level = header.root_level;
     return true;
 }
 
+// Stream the meta file's annotations into sorted nodes
+static bool sigmf_index_scan(sigmf_annotation_index_t *index, const char *meta_filename) {
+    sigmf_annotation_reader_t *reader = sigmf_annotation_reader_open(meta_filename);
+    if (!reader) return false;
+
+    size_t capacity = 0;
+    sigmf_annotation_t annotation;
+    uint64_t offset;
+    while (sigmf_annotation_reader_next_at(reader, &annotation, &offset)) {
+        if (index->count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            sigmf_index_node_t *nodes = realloc(index->nodes, capacity * sizeof(sigmf_index_node_t));
+            if (!nodes) {
+                fprintf(stderr, "Error: Out of memory indexing %s\n", meta_filename);
+                sigmf_annotation_reader_close(reader);
+                return false;
+            }
+            index->nodes = nodes;
+        }
+
+        sigmf_index_node_t *node = &index->nodes[index->count];
+        node->entry.sample_start = annotation.sample_start;
+        node->entry.sample_count = annotation.sample_count;
+        node->entry.freq_lower_edge = annotation.freq_lower_edge;
+        node->entry.freq_upper_edge = annotation.freq_upper_edge;
+        node->entry.meta_offset = offset;
+        node->entry.ordinal = index->count;
+        uint64_t length = annotation.sample_count ? annotation.sample_count : 1;
+        node->sample_end = annotation.sample_start > UINT64_MAX - length
+                         ? UINT64_MAX : annotation.sample_start + length;
+        node->max_end = node->sample_end;
+        index->count++;
+    }
+    if (!sigmf_annotation_reader_close(reader)) return false;
+
+    if (index->count > 1) {
+        qsort(index->nodes, index->count, sizeof(sigmf_index_node_t), sigmf_index_compare);
+    }
+    index->root_level = sigmf_index_build_tree(index->nodes, (int64_t)index->count);
+    return true;
+}
+
+static bool sigmf_index_save(const sigmf_annotation_index_t *index, const char *index_filename,
+                             uint64_t meta_size, int64_t meta_mtime) {
+    sigmf_index_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SIGMF_INDEX_MAGIC, sizeof(header.magic));
+    header.version = SIGMF_INDEX_VERSION;
+    header.byte_order = SIGMF_INDEX_BYTE_ORDER;
+    header.node_size = sizeof(sigmf_index_node_t);
+    header.root_level = index->root_level;
+    header.meta_size = meta_size;
+    header.meta_mtime = meta_mtime;
+    header.count = index->count;
+
+    FILE *file = fopen(index_filename, "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (index->count == 0 ||
+               fwrite(index->nodes, sizeof(sigmf_index_node_t), index->count, file) == index->count);
+    ok = fclose(file) == 0 && ok;
+    if (!ok) remove(index_filename);
+    return ok;
+}
+
+void sigmf_get_index_filename(const char *meta_filename, char *index_filename, size_t max_len) {
+    if (!meta_filename || !index_filename || max_len == 0) return;
+
+    const char *suffix = ".sigmf-meta";
+    size_t len = strlen(meta_filename);
+    size_t suffix_len = strlen(suffix);
+    if (len >= suffix_len && strcmp(meta_filename + len - suffix_len, suffix) == 0) {
+        len -= suffix_len;
+    }
+    snprintf(index_filename, max_len, "%.*s.sigmf-idx", (int)len, meta_filename);
+}
+
+sigmf_annotation_index_t *sigmf_index_open(const char *meta_filename) {
+    if (!meta_filename) return NULL;
+
+    uint64_t meta_size;
+    int64_t meta_mtime;
+    if (!sigmf_index_meta_stat(meta_filename, &meta_size, &meta_mtime)) {
+        fprintf(stderr, "Error: Cannot open SigMF metadata %s\n", meta_filename);
+        return NULL;
+    }
+
+    sigmf_annotation_index_t *index = calloc(1, sizeof(sigmf_annotation_index_t));
+    if (!index) return NULL;
+    snprintf(index->meta_path, sizeof(index->meta_path), "%s", meta_filename);
+    index->root_level = -1;
+
+    char index_filename[1024];
+    sigmf_get_index_filename(meta_filename, index_filename, sizeof(index_filename));
+
+    if (!sigmf_index_load(index, index_filename, meta_size, meta_mtime)) {
+        if (!sigmf_index_scan(index, meta_filename)) {
+            sigmf_index_close(index);
+            return NULL;
+        }
+        // A read-only directory only costs the next open another scan
+        sigmf_index_save(index, index_filename, meta_size, meta_mtime);
+    }
+    return index;
+}
+
+void sigmf_index_close(sigmf_annotation_index_t *index) {
+    if (!index) return;
+
+    if (index->meta) fclose(index->meta);
+    free(index->nodes);
+    free(index);
+}
+
+size_t sigmf_index_count(const sigmf_annotation_index_t *index) {
+    return index ? index->count : 0;
+}
+
+const sigmf_index_entry_t *sigmf_index_entry(const sigmf_annotation_index_t *index, size_t i) {
+    if (!index || i >= index->count) return NULL;
+    return &index->nodes[i].entry;
+}
+
+// Annotations without a band match every frequency window
+static bool sigmf_index_band_matches(const sigmf_index_entry_t *entry,
+                                     uint64_t freq_lower, uint64_t freq_upper) {
+    if (entry->freq_lower_edge == 0 && entry->freq_upper_edge == 0) return true;
+    return entry->freq_lower_edge <= freq_upper && freq_lower <= entry->freq_upper_edge;
+}
+
+size_t sigmf_index_query(const sigmf_annotation_index_t *index,
+                         uint64_t sample_start, uint64_t sample_end,
+                         uint64_t freq_lower, uint64_t freq_upper,
+                         const sigmf_index_entry_t **results, size_t max_results) {
+    if (!index || index->root_level < 0 || sample_start >= sample_end || freq_lower > freq_upper) {
+        return 0;
+    }
+
+    const sigmf_index_node_t *nodes = index->nodes;
+    const int64_t n = (int64_t)index->count;
+    size_t matches = 0;
+
+    // Node, level and whether its left subtree is done; depth <= 2 per level
+    struct { int64_t x; int k; bool left_done; } stack[128];
+    int top = 0;
+    stack[top].x = ((int64_t)1 << index->root_level) - 1;
+    stack[top].k = index->root_level;
+    stack[top++].left_done = false;
+
+#define SIGMF_INDEX_VISIT(i) do { \
+        const sigmf_index_node_t *node_ = &nodes[(i)]; \
+        if (sample_start < node_->sample_end && \
+            sigmf_index_band_matches(&node_->entry, freq_lower, freq_upper)) { \
+            if (matches < max_results && results) results[matches] = &node_->entry; \
+            matches++; \
+        } \
+    } while (0)
+
+    while (top > 0) {
+        int64_t x = stack[--top].x;
+        int k = stack[top].k;
+        bool left_done = stack[top].left_done;
+
+        if (k <= SIGMF_INDEX_SCAN_LEVEL) {
+            int64_t i0 = x >> k << k;
+            int64_t i1 = i0 + ((int64_t)1 << (k + 1)) - 1;
+            if (i1 > n) i1 = n;
+            for (int64_t i = i0; i < i1 && nodes[i].entry.sample_start < sample_end; i++) {
+                SIGMF_INDEX_VISIT(i);
+            }
+        } else if (!left_done) {
+            // Revisit this node after its left subtree, which may lie past the end
+            int64_t y = x - ((int64_t)1 << (k - 1));
+            stack[top].x = x;
+            stack[top].k = k;
+            stack[top++].left_done = true;
+            if (y >= n || nodes[y].max_end > sample_start) {
+                stack[top].x = y;
+                stack[top].k = k - 1;
+                stack[top++].left_done = false;
+            }
+        } else if (x < n && nodes[x].entry.sample_start < sample_end) {
+            SIGMF_INDEX_VISIT(x);
+            stack[top].x = x + ((int64_t)1 << (k - 1));
+            stack[top].k = k - 1;
+            stack[top++].left_done = false;
+        }
+    }
+
+#undef SIGMF_INDEX_VISIT
+
+    return matches;
+}
+
+bool sigmf_index_read_annotation(sigmf_annotation_index_t *index, const sigmf_index_entry_t *entry,
+                                 sigmf_annotation_t *annotation) {
+    if (!index || !entry || !annotation) return false;
+
+    if (!index->meta) {
+        index->meta = fopen(index->meta_path, "r");
+        if (!index->meta) return false;
+    }
+    if (fseek(index->meta, (long)entry->meta_offset, SEEK_SET) != 0) return false;
+
+    json_reader_t *reader = malloc(sizeof(json_reader_t));
+    if (!reader) return false;
+    json_reader_init(reader, index->meta, index->meta_path);
+    reader->chunk_offset = entry->meta_offset;
+    reader->chunk_limit = 4096;     // One object, not a whole chunk
+
+    bool ok = json_next(reader) && json_read_annotation(reader, annotation);
+    free(reader);
+    return ok;
+}
+
 // Create SigMF metadata from basic parameters
 bool sigmf_create_basic_metadata(sigmf_metadata_t *metadata,
                                 const char *datatype,
@@ -365,8 +1239,9 @@ bool sigmf_add_capture(sigmf_metadata_t *metadata,
     sigmf_capture_t *capture = &metadata->captures[metadata->num_captures];
     capture->sample_start = sample_start;
     capture->frequency = frequency;
+    capture->datetime[0] = '\0';
     if (datetime) {
-        strcpy(capture->datetime, datetime);
+        snprintf(capture->datetime, sizeof(capture->datetime), "%s", datetime);
     }
     capture->duration_s = 0.0; // Not calculated here
 
@@ -383,22 +1258,17 @@ bool sigmf_add_annotation(sigmf_metadata_t *metadata,
                          const char *label) {
     if (!metadata) return false;
 
-    size_t new_size = (metadata->num_annotations + 1) * sizeof(sigmf_annotation_t);
-    sigmf_annotation_t *new_annotations = realloc(metadata->annotations, new_size);
+    sigmf_annotation_t *annotation = sigmf_append_annotation(metadata);
+    if (!annotation) return false;
 
-    if (!new_annotations) return false;
-    metadata->annotations = new_annotations;
-
-    sigmf_annotation_t *annotation = &metadata->annotations[metadata->num_annotations];
+    memset(annotation, 0, sizeof(*annotation));
     annotation->sample_start = sample_start;
     annotation->sample_count = sample_count;
     annotation->freq_lower_edge = freq_lower;
     annotation->freq_upper_edge = freq_upper;
     if (label) {
-        strcpy(annotation->label, label);
+        snprintf(annotation->label, sizeof(annotation->label), "%s", label);
     }
-
-    metadata->num_annotations++;
     return true;
 }
 
@@ -443,11 +1313,16 @@ bool sigmf_meta_file_exists(const char *iq_filename) {
 sigmf_datatype_t sigmf_parse_datatype(const char *datatype_str) {
     if (!datatype_str) return SIGMF_DATATYPE_CI16;
 
-    if (strcmp(datatype_str, "ci8") == 0) return SIGMF_DATATYPE_CI8;
-    if (strcmp(datatype_str, "ci16") == 0) return SIGMF_DATATYPE_CI16;
-    if (strcmp(datatype_str, "ci32") == 0) return SIGMF_DATATYPE_CI32;
-    if (strcmp(datatype_str, "cf32") == 0) return SIGMF_DATATYPE_CF32;
-    if (strcmp(datatype_str, "cf64") == 0) return SIGMF_DATATYPE_CF64;
+    // Ignore the "_le"/"_be" endianness suffix
+    size_t len = strcspn(datatype_str, "_");
+
+    if (len == 3 && strncmp(datatype_str, "ci8", len) == 0) return SIGMF_DATATYPE_CI8;
+    if (len == 4 && strncmp(datatype_str, "ci16", len) == 0) return SIGMF_DATATYPE_CI16;
+    if (len == 4 && strncmp(datatype_str, "ci32", len) == 0) return SIGMF_DATATYPE_CI32;
+    if (len == 4 && strncmp(datatype_str, "cf32", len) == 0) return SIGMF_DATATYPE_CF32;
+    if (len == 4 && strncmp(datatype_str, "cf64", len) == 0) return SIGMF_DATATYPE_CF64;
+    if (len == 4 && strncmp(datatype_str, "ci12", len) == 0) return SIGMF_DATATYPE_CI12;
+    if (len == 3 && strncmp(datatype_str, "ci4", len) == 0) return SIGMF_DATATYPE_CI4;
 
     return SIGMF_DATATYPE_CI16; // Default
 }
@@ -460,6 +1335,8 @@ const char *sigmf_datatype_to_string(sigmf_datatype_t datatype) {
         case SIGMF_DATATYPE_CI32: return "ci32";
         case SIGMF_DATATYPE_CF32: return "cf32";
         case SIGMF_DATATYPE_CF64: return "cf64";
+        case SIGMF_DATATYPE_CI12: return "ci12";
+        case SIGMF_DATATYPE_CI4: return "ci4";
         default: return "ci16";
     }
 }
@@ -473,3 +1350,90 @@ void sigmf_get_current_datetime(char *datetime_str, size_t max_len) {
 
     strftime(datetime_str, max_len, "%Y-%m-%dT%H:%M:%SZ", tm_info);
 }
+
+// Parse "YYYY-MM-DDTHH:MM:SS[.fff]Z" into seconds since the epoch (UTC)
+bool sigmf_parse_datetime(const char *datetime, double *seconds) {
+    int year, month, day, hour, minute;
+    double second;
+    if (!datetime || sscanf(datetime, "%d-%d-%dT%d:%d:%lf",
+                            &year, &month, &day, &hour, &minute, &second) != 6) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+
+    // Days from civil date (proleptic Gregorian); timegm() is not portable
+    int y = year - (month <= 2);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long long days = (long long)era * 146097 + doe - 719468;
+
+    *seconds = (double)days * 86400.0 + hour * 3600.0 + minute * 60.0 + second;
+    return true;
+}
+
+// Epoch seconds of the recording's first sample
+bool sigmf_start_time(const sigmf_metadata_t *metadata, double *seconds) {
+    if (!metadata || !seconds) return false;
+    for (size_t i = 0; i < metadata->num_captures; i++) {
+        const sigmf_capture_t *capture = &metadata->captures[i];
+        double t;
+        if (!sigmf_parse_datetime(capture->datetime, &t)) continue;
+        if (capture->sample_start > 0) {
+            if (metadata->global.sample_rate == 0) return false;
+            t -= (double)capture->sample_start / (double)metadata->global.sample_rate;
+        }
+        *seconds = t;
+        return true;
+    }
+    return false;
+}
+
+// Map a time offset into the recording to a sample index
+bool sigmf_time_to_sample(const sigmf_metadata_t *metadata, double seconds, uint64_t *sample) {
+    if (!metadata || !sample || metadata->global.sample_rate == 0 || seconds < 0.0) return false;
+
+    double rate = (double)metadata->global.sample_rate;
+    if (metadata->num_captures == 0) {
+        *sample = (uint64_t)(seconds * rate);
+        return true;
+    }
+
+    // Timed segments need a datetime on every capture
+    const sigmf_capture_t *captures = metadata->captures;
+    double origin = 0.0;
+    bool timed = sigmf_parse_datetime(captures[0].datetime, &origin);
+    for (size_t i = 1; timed && i < metadata->num_captures; i++) {
+        double t;
+        timed = sigmf_parse_datetime(captures[i].datetime, &t);
+    }
+    if (!timed) {
+        *sample = captures[0].sample_start + (uint64_t)(seconds * rate);
+        return true;
+    }
+
+    // Last segment starting at or before 'seconds' holds the sample
+    size_t segment = 0;
+    double segment_offset = 0.0;
+    for (size_t i = 1; i < metadata->num_captures; i++) {
+        double t;
+        sigmf_parse_datetime(captures[i].datetime, &t);
+        if (t - origin > seconds) break;
+        segment = i;
+        segment_offset = t - origin;
+    }
+
+    // Epoch seconds carry ~1e-7 s of rounding; keep it from dropping a sample
+    uint64_t index = captures[segment].sample_start +
+                     (uint64_t)((seconds - segment_offset) * rate + 1e-3);
+
+    // Times in a recording gap snap forward to the next segment
+    if (segment + 1 < metadata->num_captures &&
+        index > captures[segment + 1].sample_start) {
+        index = captures[segment + 1].sample_start;
+    }
+
+    *sample = index;
+    return true;
+}
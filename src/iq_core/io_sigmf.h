@@ -2,12 +2,21 @@
 #define IQ_IO_SIGMF_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <time.h>
 
 /*
  * Minimal SigMF v1.2.0 implementation for IQ Lab
  * Focus on core fields needed for basic RF analysis
+ *
+ * .sigmf-meta files are read by a single-pass JSON tokenizer working
+ * through a fixed read buffer: no key lookup rescans the document and no
+ * string field overflows (longer values are truncated to the field).
+ * Detection output can carry tens of thousands of annotations, so besides
+ * loading them all (sigmf_read_metadata) they can be streamed one at a
+ * time in constant memory (sigmf_annotation_reader_*), and written the
+ * same way (sigmf_writer_*).
  */
 
 // SigMF data types
@@ -16,7 +25,9 @@ typedef enum {
     SIGMF_DATATYPE_CI16,   // Complex int16 (s16 I/Q)
     SIGMF_DATATYPE_CI32,   // Complex int32
     SIGMF_DATATYPE_CF32,   // Complex float32
-    SIGMF_DATATYPE_CF64    // Complex float64
+    SIGMF_DATATYPE_CF64,   // Complex float64
+    SIGMF_DATATYPE_CI12,   // Packed 12-bit I/Q, 3 bytes per sample (not in the SigMF core spec)
+    SIGMF_DATATYPE_CI4     // Packed 4-bit I/Q, 1 byte per sample (not in the SigMF core spec)
 } sigmf_datatype_t;
 
 // SigMF global metadata
@@ -30,6 +41,7 @@ typedef struct {
     char datetime[32];          // ISO 8601 datetime
     char license[128];          // License info
     char hw_info[256];          // Hardware information
+    char sha512[129];           // core:sha512 of the dataset file, "" if absent
 } sigmf_global_t;
 
 // SigMF capture metadata (per capture segment)
@@ -57,8 +69,25 @@ typedef struct {
     size_t num_captures;
     sigmf_annotation_t *annotations; // Array of annotations
     size_t num_annotations;
+    size_t annotation_capacity;    // Allocated entries of 'annotations'
 } sigmf_metadata_t;
 
+// Streaming annotation reader and metadata writer (opaque)
+typedef struct sigmf_annotation_reader sigmf_annotation_reader_t;
+typedef struct sigmf_writer sigmf_writer_t;
+
+// Annotation index (opaque) and the per-annotation record a query returns
+typedef struct sigmf_annotation_index sigmf_annotation_index_t;
+
+typedef struct {
+    uint64_t sample_start;      // Start sample
+    uint64_t sample_count;      // Number of samples
+    uint64_t freq_lower_edge;   // Band, 0/0 when the annotation has none
+    uint64_t freq_upper_edge;
+    uint64_t meta_offset;       // Byte offset of the object in the .sigmf-meta
+    uint64_t ordinal;           // Position in the file's annotations array
+} sigmf_index_entry_t;
+
 /*
  * Function declarations
  */
@@ -69,10 +98,11 @@ void sigmf_init_metadata(sigmf_metadata_t *metadata);
 // Free SigMF metadata structure
 void sigmf_free_metadata(sigmf_metadata_t *metadata);
 
-// Read SigMF metadata from .sigmf-meta file
+// Read SigMF metadata from .sigmf-meta file (global, captures and every annotation)
+// Returns false, with a message on stderr, when the file is not valid JSON
 bool sigmf_read_metadata(const char *filename, sigmf_metadata_t *metadata);
 
-// Write SigMF metadata to .sigmf-meta file
+// Write SigMF metadata to .sigmf-meta file, annotations included
 bool sigmf_write_metadata(const char *filename, const sigmf_metadata_t *metadata);
 
 // Create SigMF metadata from basic parameters
@@ -97,6 +127,69 @@ bool sigmf_add_annotation(sigmf_metadata_t *metadata,
                          uint64_t freq_upper,
                          const char *label);
 
+/*
+ * Streaming annotations
+ * The reader skips to the top-level "annotations" array (wherever it sits
+ * in the document) and decodes one object per call, so a scan costs one
+ * pass over the file and a fixed amount of memory. sigmf_annotation_reader_next
+ * returns false at the end of the array or on a syntax error; close tells
+ * the two apart (true when the stream was well formed).
+ */
+sigmf_annotation_reader_t *sigmf_annotation_reader_open(const char *filename);
+bool sigmf_annotation_reader_next(sigmf_annotation_reader_t *reader, sigmf_annotation_t *annotation);
+bool sigmf_annotation_reader_close(sigmf_annotation_reader_t *reader);
+
+/*
+ * Streaming writer
+ * Open writes global, captures and any annotations already in 'metadata',
+ * then leaves the annotations array open; each add appends one (arguments
+ * as sigmf_add_annotation) without keeping it in memory. Close ends the
+ * document and returns false if any write failed.
+ */
+sigmf_writer_t *sigmf_writer_open(const char *filename, const sigmf_metadata_t *metadata);
+bool sigmf_writer_add_annotation(sigmf_writer_t *writer,
+                                 uint64_t sample_start,
+                                 uint64_t sample_count,
+                                 uint64_t freq_lower,
+                                 uint64_t freq_upper,
+                                 const char *label);
+bool sigmf_writer_write_annotation(sigmf_writer_t *writer, const sigmf_annotation_t *annotation);
+bool sigmf_writer_close(sigmf_writer_t *writer);
+
+/*
+ * Annotation index
+ * sigmf_index_open loads "<name>.sigmf-idx" next to "<name>.sigmf-meta",
+ * or streams the meta file once to build it (and writes the sidecar when
+ * the directory allows). The sidecar records the meta file's size and
+ * mtime; a mismatch rebuilds it. Entries are sorted by sample_start under
+ * an implicit interval tree.
+ *
+ * sigmf_index_query returns the annotations overlapping samples
+ * [sample_start, sample_end) x Hz [freq_lower, freq_upper] in sample_start
+ * order. A zero-length annotation covers its start sample, and one without
+ * a band matches every frequency window (pass 0, UINT64_MAX for all bands).
+ * At most max_results entry pointers are stored (they stay valid until
+ * close); the return value is the total match count, so a caller can size
+ * its array from a first call with max_results 0.
+ * sigmf_index_read_annotation decodes an entry's full annotation (label,
+ * comment) straight from its offset in the meta file.
+ */
+sigmf_annotation_index_t *sigmf_index_open(const char *meta_filename);
+void sigmf_index_close(sigmf_annotation_index_t *index);
+size_t sigmf_index_count(const sigmf_annotation_index_t *index);
+// i-th entry in sample_start order
+const sigmf_index_entry_t *sigmf_index_entry(const sigmf_annotation_index_t *index, size_t i);
+size_t sigmf_index_query(const sigmf_annotation_index_t *index,
+                         uint64_t sample_start, uint64_t sample_end,
+                         uint64_t freq_lower, uint64_t freq_upper,
+                         const sigmf_index_entry_t **results, size_t max_results);
+bool sigmf_index_read_annotation(sigmf_annotation_index_t *index, const sigmf_index_entry_t *entry,
+                                 sigmf_annotation_t *annotation);
+
+// Sidecar index filename for a metadata file
+// e.g., "capture.sigmf-meta" -> "capture.sigmf-idx"
+void sigmf_get_index_filename(const char *meta_filename, char *index_filename, size_t max_len);
+
 // Get SigMF metadata filename from IQ filename
 // e.g., "capture.iq" -> "capture.sigmf-meta"
 void sigmf_get_meta_filename(const char *iq_filename, char *meta_filename, size_t max_len);
@@ -113,4 +206,24 @@ const char *sigmf_datatype_to_string(sigmf_datatype_t datatype);
 // Get current datetime in ISO 8601 format
 void sigmf_get_current_datetime(char *datetime_str, size_t max_len);
 
+// Parse an ISO 8601 UTC datetime ("YYYY-MM-DDTHH:MM:SS[.fff]Z") into epoch seconds
+bool sigmf_parse_datetime(const char *datetime, double *seconds);
+
+/*
+ * Map 'seconds' from the start of the recording to a sample index
+ * When every capture carries a core:datetime the captures are placed on
+ * that timeline, so recordings with gaps seek to the right segment (times
+ * inside a gap land on the first sample after it). Otherwise the samples
+ * are taken as contiguous from the first capture's core:sample_start.
+ */
+bool sigmf_time_to_sample(const sigmf_metadata_t *metadata, double seconds, uint64_t *sample);
+
+/*
+ * UTC time of sample 0 in seconds since the epoch: the first capture with a
+ * core:datetime, moved back by its core:sample_start at the global rate.
+ * Returns false when no capture is timed; used to align recordings of
+ * several receivers (iqtdoa).
+ */
+bool sigmf_start_time(const sigmf_metadata_t *metadata, double *seconds);
+
 #endif // IQ_IO_SIGMF_H
@@ -0,0 +1,403 @@
+/*
+ * IQ Lab - Live sample sources
+ *
+ * Pipes are read with stdio; sockets with recv() straight into the
+ * caller's buffer, looping until the request is whole, so the reader above
+ * sees the same blocking fread() semantics it has on files. UDP datagrams
+ * are received whole into a staging buffer and handed out from there.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // getaddrinfo, fileno under -std=c11
+#endif
+
+#include "io_stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <io.h>
+#include <fcntl.h>
+typedef SOCKET iq_socket_t;
+#define IQ_SOCKET_INVALID INVALID_SOCKET
+#define iq_socket_close closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netdb.h>
+#include <unistd.h>
+typedef int iq_socket_t;
+#define IQ_SOCKET_INVALID (-1)
+#define iq_socket_close close
+#endif
+
+#define IQ_RTLTCP_HEADER 12          // "RTL0", tuner type, gain count
+#define IQ_RTLTCP_SET_FREQUENCY 0x01
+#define IQ_RTLTCP_SET_SAMPLE_RATE 0x02
+
+// Parsed stream name
+typedef struct {
+    iq_stream_kind_t kind;
+    char host[256];
+    char port[16];
+    iq_format_t format;
+    bool format_set;
+    uint32_t sample_rate;
+    uint32_t frequency;
+} iq_stream_spec_t;
+
+static const char *iq_stream_scheme(const char *name, iq_stream_kind_t *kind) {
+    static const struct { const char *prefix; iq_stream_kind_t kind; } schemes[] = {
+        {"tcp://", IQ_STREAM_TCP}, {"rtltcp://", IQ_STREAM_RTLTCP}, {"udp://", IQ_STREAM_UDP},
+    };
+    for (size_t i = 0; i < sizeof(schemes) / sizeof(schemes[0]); i++) {
+        size_t length = strlen(schemes[i].prefix);
+        if (strncmp(name, schemes[i].prefix, length) == 0) {
+            *kind = schemes[i].kind;
+            return name + length;
+        }
+    }
+    return NULL;
+}
+
+// "-" and "stdin", bare or followed by options
+static const char *iq_stream_stdin_options(const char *name) {
+    if (name[0] == '-' && (name[1] == '\0' || name[1] == '?')) return name + 1;
+    if (strncmp(name, "stdin", 5) == 0 && (name[5] == '\0' || name[5] == '?')) return name + 5;
+    return NULL;
+}
+
+bool iq_stream_is_spec(const char *name) {
+    iq_stream_kind_t kind;
+    return name && (iq_stream_stdin_options(name) || iq_stream_scheme(name, &kind));
+}
+
+bool iq_stream_is_pipe(const char *path) {
+    if (!path) return false;
+#ifdef _WIN32
+    return strncmp(path, "\\\\.\\pipe\\", 9) == 0;
+#else
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISFIFO(st.st_mode);
+#endif
+}
+
+// Options after '?': format=, rate=, freq=
+static bool iq_stream_parse_options(const char *options, iq_stream_spec_t *spec) {
+    while (options && *options) {
+        const char *end = strchr(options, '&');
+        size_t length = end ? (size_t)(end - options) : strlen(options);
+        char option[64];
+        if (length >= sizeof(option)) {
+            fprintf(stderr, "Error: Stream option too long: %.*s\n", (int)length, options);
+            return false;
+        }
+        memcpy(option, options, length);
+        option[length] = '\0';
+
+        char *value = strchr(option, '=');
+        if (!value) {
+            fprintf(stderr, "Error: Stream option '%s' needs a value\n", option);
+            return false;
+        }
+        *value++ = '\0';
+        char *rest = NULL;
+        if (strcmp(option, "format") == 0) {
+            if (!iq_parse_format(value, &spec->format)) {
+                fprintf(stderr, "Error: Invalid stream format '%s'. Use 's8', 's16', 's12' or 's4'\n", value);
+                return false;
+            }
+            spec->format_set = true;
+        } else if (strcmp(option, "rate") == 0 || strcmp(option, "freq") == 0) {
+            double hz = strtod(value, &rest);
+            if (rest == value || *rest != '\0' || hz <= 0.0 || hz > 4294967295.0) {
+                fprintf(stderr, "Error: Invalid stream %s '%s'\n", option, value);
+                return false;
+            }
+            if (option[0] == 'r') spec->sample_rate = (uint32_t)(hz + 0.5);
+            else spec->frequency = (uint32_t)(hz + 0.5);
+        } else {
+            fprintf(stderr, "Error: Unknown stream option '%s' (format, rate or freq)\n", option);
+            return false;
+        }
+        options = end ? end + 1 : NULL;
+    }
+    return true;
+}
+
+// "host:port" or "[v6 address]:port"; the host may be empty for UDP
+static bool iq_stream_parse_address(const char *address, size_t length, iq_stream_spec_t *spec) {
+    const char *colon = NULL;
+    const char *host = address;
+    size_t host_length;
+    if (length > 0 && address[0] == '[') {
+        const char *close = memchr(address, ']', length);
+        if (!close || close + 1 >= address + length || close[1] != ':') return false;
+        host = address + 1;
+        host_length = (size_t)(close - host);
+        colon = close + 1;
+    } else {
+        for (const char *c = address + length; c > address; c--) {
+            if (c[-1] == ':') {
+                colon = c - 1;
+                break;
+            }
+        }
+        if (!colon) return false;
+        host_length = (size_t)(colon - address);
+    }
+    size_t port_length = (size_t)(address + length - colon - 1);
+    if (host_length >= sizeof(spec->host) || port_length == 0 || port_length >= sizeof(spec->port)) {
+        return false;
+    }
+    memcpy(spec->host, host, host_length);
+    spec->host[host_length] = '\0';
+    memcpy(spec->port, colon + 1, port_length);
+    spec->port[port_length] = '\0';
+    return true;
+}
+
+static bool iq_stream_parse(const char *name, iq_stream_spec_t *spec) {
+    const char *options = iq_stream_stdin_options(name);
+    if (options) {
+        spec->kind = IQ_STREAM_PIPE;
+        return iq_stream_parse_options(*options == '?' ? options + 1 : NULL, spec);
+    }
+
+    const char *address = iq_stream_scheme(name, &spec->kind);
+    if (!address) return false;
+    const char *query = strchr(address, '?');
+    size_t length = query ? (size_t)(query - address) : strlen(address);
+    if (!iq_stream_parse_address(address, length, spec) ||
+        (spec->kind != IQ_STREAM_UDP && spec->host[0] == '\0')) {
+        fprintf(stderr, "Error: Stream '%s' needs host:port\n", name);
+        return false;
+    }
+    return iq_stream_parse_options(query ? query + 1 : NULL, spec);
+}
+
+// Half a second of samples at the stream's rate, within the limits
+static size_t iq_stream_buffer_size(const iq_stream_spec_t *spec) {
+    if (spec->sample_rate == 0) return IQ_STREAM_BUFFER_DEFAULT;
+    double bytes = (double)spec->sample_rate * (double)iq_native_sample_bytes(spec->format) * 0.5;
+    if (bytes < IQ_STREAM_BUFFER_MIN) return IQ_STREAM_BUFFER_MIN;
+    if (bytes > IQ_STREAM_BUFFER_MAX) return IQ_STREAM_BUFFER_MAX;
+    return (size_t)bytes;
+}
+
+static bool iq_stream_sockets_ready(void) {
+#ifdef _WIN32
+    static bool started = false;
+    if (!started) {
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            fprintf(stderr, "Error: Cannot start Winsock\n");
+            return false;
+        }
+        started = true;
+    }
+#endif
+    return true;
+}
+
+// Connect (TCP) or bind (UDP) the first address that works
+static iq_socket_t iq_stream_socket(const iq_stream_spec_t *spec, size_t buffer_bytes) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = spec->kind == IQ_STREAM_UDP ? SOCK_DGRAM : SOCK_STREAM;
+    if (spec->kind == IQ_STREAM_UDP) hints.ai_flags = AI_PASSIVE;
+
+    struct addrinfo *addresses = NULL;
+    int error = getaddrinfo(spec->host[0] ? spec->host : NULL, spec->port, &hints, &addresses);
+    if (error != 0) {
+        fprintf(stderr, "Error: Cannot resolve %s:%s: %s\n", spec->host, spec->port, gai_strerror(error));
+        return IQ_SOCKET_INVALID;
+    }
+
+    iq_socket_t fd = IQ_SOCKET_INVALID;
+    for (struct addrinfo *a = addresses; a; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd == IQ_SOCKET_INVALID) continue;
+
+        // Before connect, so TCP can offer a window scaled to it
+        int size = (int)buffer_bytes;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (const char *)&size, sizeof(size));
+
+        int result = spec->kind == IQ_STREAM_UDP ? bind(fd, a->ai_addr, (int)a->ai_addrlen)
+                                                 : connect(fd, a->ai_addr, (int)a->ai_addrlen);
+        if (result == 0) break;
+        iq_socket_close(fd);
+        fd = IQ_SOCKET_INVALID;
+    }
+    freeaddrinfo(addresses);
+
+    if (fd == IQ_SOCKET_INVALID) {
+        fprintf(stderr, "Error: Cannot %s %s:%s: %s\n", spec->kind == IQ_STREAM_UDP ? "bind" : "connect to",
+                spec->host[0] ? spec->host : "*", spec->port, strerror(errno));
+    }
+    return fd;
+}
+
+// rtl_tcp command: one byte of command, four of big-endian parameter
+static bool iq_rtltcp_command(iq_socket_t fd, uint8_t command, uint32_t value) {
+    uint8_t message[5] = {command, (uint8_t)(value >> 24), (uint8_t)(value >> 16),
+                          (uint8_t)(value >> 8), (uint8_t)value};
+    return send(fd, (const char *)message, sizeof(message), 0) == (int)sizeof(message);
+}
+
+static bool iq_rtltcp_start(iq_stream_t *stream, const iq_stream_spec_t *spec) {
+    uint8_t header[IQ_RTLTCP_HEADER];
+    stream->offset_binary = false;   // The header is not sample data
+    if (iq_stream_read(stream, header, sizeof(header)) != sizeof(header) ||
+        memcmp(header, "RTL0", 4) != 0) {
+        fprintf(stderr, "Error: %s:%s is not an rtl_tcp server\n", spec->host, spec->port);
+        return false;
+    }
+    stream->bytes = 0;
+    stream->offset_binary = true;
+
+    iq_socket_t fd = (iq_socket_t)stream->socket;
+    if ((spec->sample_rate && !iq_rtltcp_command(fd, IQ_RTLTCP_SET_SAMPLE_RATE, spec->sample_rate)) ||
+        (spec->frequency && !iq_rtltcp_command(fd, IQ_RTLTCP_SET_FREQUENCY, spec->frequency))) {
+        fprintf(stderr, "Error: Cannot tune the rtl_tcp server\n");
+        return false;
+    }
+    return true;
+}
+
+static iq_stream_t *iq_stream_open_pipe(iq_stream_t *stream, const char *name, size_t buffer_bytes) {
+    if (iq_stream_stdin_options(name)) {
+        stream->pipe = stdin;
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    } else {
+        stream->pipe = fopen(name, "rb");
+        stream->owns_pipe = true;
+        if (!stream->pipe) {
+            fprintf(stderr, "Error opening pipe '%s': %s\n", name, strerror(errno));
+            free(stream);
+            return NULL;
+        }
+    }
+    // Nothing has been read yet, so the buffer can still be replaced
+    setvbuf(stream->pipe, NULL, _IOFBF, buffer_bytes);
+    return stream;
+}
+
+iq_stream_t *iq_stream_open(const char *name, iq_format_t *format, uint32_t *sample_rate) {
+    if (!name || !format || !sample_rate) return NULL;
+
+    iq_stream_spec_t spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.format = *format;
+    if (iq_stream_is_spec(name)) {
+        if (!iq_stream_parse(name, &spec)) return NULL;
+    } else {
+        spec.kind = IQ_STREAM_PIPE;
+    }
+    if (spec.kind == IQ_STREAM_RTLTCP) {
+        if (spec.format_set && spec.format != IQ_FORMAT_S8) {
+            fprintf(stderr, "Error: rtl_tcp streams are 8-bit (format=s8)\n");
+            return NULL;
+        }
+        spec.format = IQ_FORMAT_S8;
+    }
+
+    iq_stream_t *stream = (iq_stream_t *)calloc(1, sizeof(iq_stream_t));
+    if (!stream) {
+        fprintf(stderr, "Error: Failed to allocate stream\n");
+        return NULL;
+    }
+    stream->kind = spec.kind;
+    stream->socket = (intptr_t)IQ_SOCKET_INVALID;
+    stream->buffer_bytes = iq_stream_buffer_size(&spec);
+    *format = spec.format;
+    *sample_rate = spec.sample_rate;
+
+    if (spec.kind == IQ_STREAM_PIPE) {
+        return iq_stream_open_pipe(stream, name, stream->buffer_bytes);
+    }
+
+    if (spec.kind == IQ_STREAM_UDP) {
+        stream->datagram = (uint8_t *)malloc(IQ_STREAM_DATAGRAM);
+        if (!stream->datagram) {
+            fprintf(stderr, "Error: Failed to allocate stream\n");
+            free(stream);
+            return NULL;
+        }
+    }
+
+    iq_socket_t fd = iq_stream_sockets_ready() ? iq_stream_socket(&spec, stream->buffer_bytes)
+                                               : IQ_SOCKET_INVALID;
+    stream->socket = (intptr_t)fd;
+    if (fd == IQ_SOCKET_INVALID || (spec.kind == IQ_STREAM_RTLTCP && !iq_rtltcp_start(stream, &spec))) {
+        iq_stream_close(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+// One recv() into 'buffer'; 0 once the stream has ended
+static size_t iq_stream_receive(iq_stream_t *stream, void *buffer, size_t bytes) {
+    iq_socket_t fd = (iq_socket_t)stream->socket;
+    int want = bytes > (1u << 30) ? (1 << 30) : (int)bytes;
+    for (;;) {
+        int got = (int)recv(fd, (char *)buffer, want, 0);
+        if (got > 0) return (size_t)got;
+#ifndef _WIN32
+        if (got < 0 && errno == EINTR) continue;
+#endif
+        // UDP allows empty datagrams; only TCP ends on 0
+        if (got == 0 && stream->kind == IQ_STREAM_UDP) continue;
+        stream->closed = true;
+        return 0;
+    }
+}
+
+size_t iq_stream_read(iq_stream_t *stream, void *buffer, size_t bytes) {
+    if (!stream || !buffer) return 0;
+
+    uint8_t *out = (uint8_t *)buffer;
+    size_t done = 0;
+    while (done < bytes && !stream->closed) {
+        size_t n;
+        if (stream->kind == IQ_STREAM_PIPE) {
+            n = fread(out + done, 1, bytes - done, stream->pipe);
+            if (n < bytes - done) stream->closed = true;
+        } else if (stream->kind == IQ_STREAM_UDP) {
+            if (stream->datagram_offset == stream->datagram_length) {
+                stream->datagram_length = iq_stream_receive(stream, stream->datagram, IQ_STREAM_DATAGRAM);
+                stream->datagram_offset = 0;
+                if (stream->datagram_length == 0) break;
+            }
+            n = stream->datagram_length - stream->datagram_offset;
+            if (n > bytes - done) n = bytes - done;
+            memcpy(out + done, stream->datagram + stream->datagram_offset, n);
+            stream->datagram_offset += n;
+        } else {
+            n = iq_stream_receive(stream, out + done, bytes - done);
+        }
+        done += n;
+    }
+
+    // rtl_tcp sends offset binary: 0x80 is zero
+    if (stream->offset_binary) {
+        for (size_t i = 0; i < done; i++) out[i] ^= 0x80;
+    }
+    stream->bytes += done;
+    return done;
+}
+
+void iq_stream_close(iq_stream_t *stream) {
+    if (!stream) return;
+    if (stream->pipe && stream->owns_pipe) fclose(stream->pipe);
+    if ((iq_socket_t)stream->socket != IQ_SOCKET_INVALID) iq_socket_close((iq_socket_t)stream->socket);
+    free(stream->datagram);
+    free(stream);
+}
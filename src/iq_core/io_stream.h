@@ -0,0 +1,86 @@
+#ifndef IQ_IO_STREAM_H
+#define IQ_IO_STREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "io_iq.h"
+
+/*
+ * Live sample sources behind iq_reader_t
+ * iq_reader_open() reads these names as streams instead of files:
+ *
+ *   -  or  stdin            samples piped in on standard input
+ *   <named pipe>            a FIFO (or \\.\pipe\name on Windows), read as written
+ *   tcp://host:port         raw interleaved I/Q from a TCP server
+ *   rtltcp://host:port      an rtl_tcp server: its 12-byte dongle header is
+ *                           checked and skipped, and its unsigned 8-bit
+ *                           samples are read as s8
+ *   udp://[host]:port       datagrams received on a local port (host is the
+ *                           address to bind, any if empty)
+ *
+ * Every name but a named pipe takes options after '?', joined with '&':
+ *   format=s8|s16|s12|s4    sample format (default s16; rtl_tcp is always s8)
+ *   rate=<Hz>               sample rate reported by the reader; rtl_tcp
+ *                           servers are also tuned to it
+ *   freq=<Hz>               rtl_tcp only: centre frequency to tune
+ * A named pipe takes its format from its name, like a file.
+ *
+ * A stream has no length (total_samples 0) and only moves forward: a
+ * forward seek reads and discards, a backward one fails. Reads block until
+ * a whole request has arrived or the peer closes (UDP never does). Socket
+ * receive buffers are sized for half a second of samples at the given
+ * rate, so a short stall in the consumer does not cost data.
+ */
+
+#define IQ_STREAM_BUFFER_DEFAULT (8u << 20)   // Socket / pipe buffer without a rate
+#define IQ_STREAM_BUFFER_MIN     (1u << 20)
+#define IQ_STREAM_BUFFER_MAX     (64u << 20)
+#define IQ_STREAM_DATAGRAM       65536        // Largest UDP payload
+
+typedef enum {
+    IQ_STREAM_PIPE,     // stdin or a named pipe
+    IQ_STREAM_TCP,
+    IQ_STREAM_RTLTCP,
+    IQ_STREAM_UDP
+} iq_stream_kind_t;
+
+typedef struct iq_stream {
+    iq_stream_kind_t kind;
+    FILE *pipe;                 // IQ_STREAM_PIPE
+    bool owns_pipe;             // False for stdin
+    intptr_t socket;            // Platform socket (TCP, rtl_tcp, UDP)
+    bool offset_binary;         // rtl_tcp: unsigned bytes, flipped to two's complement
+    uint8_t *datagram;          // UDP: the datagram being handed out
+    size_t datagram_length;
+    size_t datagram_offset;
+    size_t buffer_bytes;        // Receive buffer asked for
+    bool closed;                // The peer closed or a read failed
+    uint64_t bytes;             // Bytes delivered so far
+} iq_stream_t;
+
+// True for "-", "stdin" and tcp:// / rtltcp:// / udp:// names (options included)
+bool iq_stream_is_spec(const char *name);
+
+// True for a named pipe on disk
+bool iq_stream_is_pipe(const char *path);
+
+/*
+ * Open a stream name (a spec or a named pipe)
+ * 'format' holds the default on entry (a pipe's format from its name) and
+ * the stream's format on return; 'sample_rate' is the rate= option or 0.
+ * Returns NULL with a message on stderr if the source cannot be opened.
+ */
+iq_stream_t *iq_stream_open(const char *name, iq_format_t *format, uint32_t *sample_rate);
+
+/*
+ * Read 'bytes' bytes, blocking until they have all arrived
+ * Returns fewer only once the stream has ended.
+ */
+size_t iq_stream_read(iq_stream_t *stream, void *buffer, size_t bytes);
+
+// Close the source (stdin stays open) and free the stream
+void iq_stream_close(iq_stream_t *stream);
+
+#endif // IQ_IO_STREAM_H
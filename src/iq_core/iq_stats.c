@@ -0,0 +1,260 @@
+/*
+ * IQ Lab - Whole-file IQ statistics
+ *
+ * Every path reduces blocks of float samples into the same partial sums
+ * (sum of squares, sums of I and Q, peak); the sampled estimate reads a
+ * few spaced blocks, the full pass gives each thread one contiguous range.
+ * Sums are taken per fixed chunk of REDUCE_CHUNK_SAMPLES and added into
+ * exact accumulators (reduce.h), and the full pass cuts its ranges on
+ * chunk boundaries, so every thread count gives the same bits.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // sysconf under -std=c11
+#endif
+
+#include "iq_stats.h"
+#include "io_iq.h"
+#include "reduce.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Samples per read in the full pass (a multiple of REDUCE_CHUNK_SAMPLES)
+#define IQ_STATS_READ_BLOCK 65536
+
+typedef struct {
+    reduce_sum_t sum_sq;
+    reduce_sum_t sum_i;
+    reduce_sum_t sum_q;
+    double peak;
+    uint64_t count;
+} iq_stats_acc_t;
+
+static void iq_stats_init(iq_stats_acc_t *acc) {
+    reduce_sum_init(&acc->sum_sq);
+    reduce_sum_init(&acc->sum_i);
+    reduce_sum_init(&acc->sum_q);
+    acc->peak = 0.0;
+    acc->count = 0;
+}
+
+// 'samples' starts on a chunk boundary; each chunk's sums go in exactly
+static void iq_stats_add(iq_stats_acc_t *acc, const float *samples, size_t count) {
+    for (size_t start = 0; start < count; start += REDUCE_CHUNK_SAMPLES) {
+        size_t end = count - start < REDUCE_CHUNK_SAMPLES ? count : start + REDUCE_CHUNK_SAMPLES;
+        double sum_sq = 0.0, sum_i = 0.0, sum_q = 0.0;
+        float peak = 0.0f;
+        for (size_t k = start; k < end; k++) {
+            float i = samples[k * 2];
+            float q = samples[k * 2 + 1];
+            sum_sq += (double)i * i + (double)q * q;
+            sum_i += i;
+            sum_q += q;
+            if (fabsf(i) > peak) peak = fabsf(i);
+            if (fabsf(q) > peak) peak = fabsf(q);
+        }
+        reduce_sum_add(&acc->sum_sq, sum_sq);
+        reduce_sum_add(&acc->sum_i, sum_i);
+        reduce_sum_add(&acc->sum_q, sum_q);
+        if (peak > acc->peak) acc->peak = peak;
+    }
+    acc->count += count;
+}
+
+static void iq_stats_merge(iq_stats_acc_t *into, const iq_stats_acc_t *from) {
+    reduce_sum_merge(&into->sum_sq, &from->sum_sq);
+    reduce_sum_merge(&into->sum_i, &from->sum_i);
+    reduce_sum_merge(&into->sum_q, &from->sum_q);
+    if (from->peak > into->peak) into->peak = from->peak;
+    into->count += from->count;
+}
+
+static void iq_stats_finish(const iq_stats_acc_t *acc, uint64_t total_samples, iq_stats_t *stats) {
+    stats->total_samples = total_samples;
+    stats->samples_used = acc->count;
+    stats->rms = acc->count ? sqrt(reduce_sum_value(&acc->sum_sq) / (double)(acc->count * 2)) : 0.0;
+    stats->dc_i = acc->count ? reduce_sum_value(&acc->sum_i) / (double)acc->count : 0.0;
+    stats->dc_q = acc->count ? reduce_sum_value(&acc->sum_q) / (double)acc->count : 0.0;
+    stats->peak = acc->peak;
+}
+
+// Read [begin, end) from an open reader into 'acc'
+static bool iq_stats_read_range(iq_reader_t *reader, uint64_t begin, uint64_t end,
+                                float *buffer, size_t buffer_samples, iq_stats_acc_t *acc) {
+    if (begin >= end) {
+        return true;
+    }
+    if (!iq_reader_seek_sample(reader, begin)) {
+        return false;
+    }
+
+    // Whole buffers only, so chunks stay where the range put them
+    uint64_t position = begin;
+    while (position < end) {
+        size_t want = end - position < buffer_samples ? (size_t)(end - position) : buffer_samples;
+        size_t have = 0;
+        while (have < want) {
+            size_t got = iq_read_samples(reader, buffer + have * 2, want - have);
+            if (got == 0) {
+                return false;
+            }
+            have += got;
+        }
+        iq_stats_add(acc, buffer, want);
+        position += want;
+    }
+    return true;
+}
+
+uint32_t iq_stats_default_threads(void) {
+    long count;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = (long)info.dwNumberOfProcessors;
+#else
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (count < 1) count = 1;
+    if (count > IQ_STATS_MAX_THREADS) count = IQ_STATS_MAX_THREADS;
+    return (uint32_t)count;
+}
+
+bool iq_stats_sampled(const char *filename, uint32_t num_blocks, uint32_t block_samples,
+                      iq_stats_t *stats) {
+    if (!filename || !stats || num_blocks == 0 || block_samples == 0) {
+        return false;
+    }
+
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, filename)) {
+        return false;
+    }
+
+    uint64_t total = reader.total_samples;
+    float *buffer = (float *)malloc((size_t)block_samples * 2 * sizeof(float));
+    if (!buffer) {
+        iq_reader_close(&reader);
+        return false;
+    }
+
+    iq_stats_acc_t acc;
+    iq_stats_init(&acc);
+    bool ok = true;
+    if (total <= (uint64_t)num_blocks * block_samples) {
+        ok = iq_stats_read_range(&reader, 0, total, buffer, block_samples, &acc);
+    } else {
+        // Block k starts k/(n-1) of the way through, so the first and last blocks are included
+        uint64_t span = total - block_samples;
+        for (uint32_t k = 0; ok && k < num_blocks; k++) {
+            uint64_t start = num_blocks > 1 ? span * k / (num_blocks - 1) : span / 2;
+            ok = iq_stats_read_range(&reader, start, start + block_samples, buffer, block_samples, &acc);
+        }
+    }
+
+    free(buffer);
+    iq_reader_close(&reader);
+    if (!ok) {
+        fprintf(stderr, "Error sampling IQ file '%s'\n", filename);
+        return false;
+    }
+
+    iq_stats_finish(&acc, total, stats);
+    return true;
+}
+
+typedef struct {
+    const char *filename;
+    uint64_t begin;
+    uint64_t end;
+    iq_stats_acc_t acc;
+    bool ok;
+    bool started;
+    pthread_t thread;
+} iq_stats_worker_t;
+
+static void *iq_stats_worker_run(void *arg) {
+    iq_stats_worker_t *worker = (iq_stats_worker_t *)arg;
+    worker->ok = false;
+
+    // Each range has its own reader: no shared file position
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, worker->filename)) {
+        return NULL;
+    }
+    float *buffer = (float *)malloc((size_t)IQ_STATS_READ_BLOCK * 2 * sizeof(float));
+    if (buffer) {
+        worker->ok = iq_stats_read_range(&reader, worker->begin, worker->end,
+                                         buffer, IQ_STATS_READ_BLOCK, &worker->acc);
+    }
+    free(buffer);
+    iq_reader_close(&reader);
+    return NULL;
+}
+
+bool iq_stats_full(const char *filename, uint32_t num_threads, iq_stats_t *stats) {
+    if (!filename || !stats) {
+        return false;
+    }
+
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, filename)) {
+        return false;
+    }
+    uint64_t total = reader.total_samples;
+    iq_reader_close(&reader);
+
+    if (num_threads == 0) num_threads = iq_stats_default_threads();
+    if (num_threads > IQ_STATS_MAX_THREADS) num_threads = IQ_STATS_MAX_THREADS;
+    // Small files are not worth a thread per read block
+    uint64_t max_useful = (total + IQ_STATS_READ_BLOCK - 1) / IQ_STATS_READ_BLOCK;
+    if (max_useful < 1) max_useful = 1;
+    if (num_threads > max_useful) num_threads = (uint32_t)max_useful;
+
+    iq_stats_worker_t *workers = (iq_stats_worker_t *)calloc(num_threads, sizeof(*workers));
+    if (!workers) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < num_threads; i++) {
+        workers[i].filename = filename;
+        workers[i].begin = reduce_split(total, num_threads, i);
+        workers[i].end = reduce_split(total, num_threads, i + 1);
+        iq_stats_init(&workers[i].acc);
+    }
+
+    // Worker 0 runs on the calling thread
+    for (uint32_t i = 1; i < num_threads; i++) {
+        workers[i].started = pthread_create(&workers[i].thread, NULL, iq_stats_worker_run, &workers[i]) == 0;
+    }
+    iq_stats_worker_run(&workers[0]);
+
+    bool ok = workers[0].ok;
+    iq_stats_acc_t acc = workers[0].acc;
+    for (uint32_t i = 1; i < num_threads; i++) {
+        if (workers[i].started) {
+            pthread_join(workers[i].thread, NULL);
+        } else {
+            iq_stats_worker_run(&workers[i]);   // Could not spawn: do the range here
+        }
+        ok = ok && workers[i].ok;
+        iq_stats_merge(&acc, &workers[i].acc);
+    }
+    free(workers);
+
+    if (!ok) {
+        fprintf(stderr, "Error reading IQ file '%s' for statistics\n", filename);
+        return false;
+    }
+
+    iq_stats_finish(&acc, total, stats);
+    return true;
+}
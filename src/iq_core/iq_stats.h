@@ -0,0 +1,47 @@
+#ifndef IQ_STATS_H
+#define IQ_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Whole-file IQ statistics (RMS, DC offset, peak) without loading samples
+ *
+ * Two ways to get them, both through iq_reader_t so raw, WAV and IQZ
+ * files work alike:
+ *   iq_stats_sampled()  reads a fixed number of evenly spaced blocks; the
+ *                       cost does not grow with the file, so listings stay
+ *                       fast on any capture
+ *   iq_stats_full()     streams every sample, split into contiguous ranges
+ *                       read by one thread each
+ * Ranges are cut on fixed chunk boundaries and the partial sums are exact
+ * (reduce.h), so every thread count gives the same bits.
+ */
+
+// Defaults for the sampled estimate: 64 blocks of 4096 samples
+#define IQ_STATS_SAMPLED_BLOCKS 64
+#define IQ_STATS_SAMPLED_BLOCK_SAMPLES 4096
+
+// Upper bound on iq_stats_full() threads
+#define IQ_STATS_MAX_THREADS 64
+
+typedef struct {
+    uint64_t total_samples;   // Complex samples in the file
+    uint64_t samples_used;    // Samples the figures below come from
+    double rms;               // Over all I and Q values, full scale 1.0
+    double dc_i;              // Mean of I
+    double dc_q;              // Mean of Q
+    double peak;              // Largest |I| or |Q|
+} iq_stats_t;
+
+// Estimate from 'num_blocks' evenly spaced blocks (the whole file when it is smaller)
+bool iq_stats_sampled(const char *filename, uint32_t num_blocks, uint32_t block_samples,
+                      iq_stats_t *stats);
+
+// Exact statistics over every sample (0 threads = one per CPU)
+bool iq_stats_full(const char *filename, uint32_t num_threads, iq_stats_t *stats);
+
+// One per online CPU, capped at IQ_STATS_MAX_THREADS
+uint32_t iq_stats_default_threads(void);
+
+#endif // IQ_STATS_H
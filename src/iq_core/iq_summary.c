@@ -0,0 +1,486 @@
+/*
+ * IQ Lab - Per-file summary sidecar
+ *
+ * Workers take contiguous runs of spectra, so every block and spectrum has
+ * exactly one writer and no partial results need merging; the whole-file
+ * totals are summed from the block records afterwards, in file order.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // struct stat under -std=c11
+#endif
+
+#include "iq_summary.h"
+#include "fft.h"
+#include "stft.h"
+#include "window.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define IQ_SUMMARY_MAGIC "IQSUMRY1"
+#define IQ_SUMMARY_VERSION 1u
+#define IQ_SUMMARY_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;        // Catches a sidecar written on another endianness
+    uint32_t block_size;        // sizeof(iq_summary_block_t), catches a layout change
+    uint32_t format;            // iq_format_t of the source
+    uint64_t source_size;       // Size and mtime of the file summarised
+    int64_t source_mtime;
+    uint64_t total_samples;
+    uint32_t sample_rate;
+    uint32_t block_samples;
+    uint64_t num_blocks;
+    uint32_t fft_size;
+    uint32_t blocks_per_spectrum;
+    uint64_t num_spectra;
+    double sum_sq;              // Whole-file totals
+    double sum_i;
+    double sum_q;
+    double peak;
+    uint64_t clipped;
+} iq_summary_header_t;
+
+typedef struct {
+    const char *filename;
+    const iq_summary_t *summary;  // Geometry; blocks and spectra are written through it
+    const fft_plan_f32_t *plan;
+    const float *window;
+    float clip_level;
+    uint64_t first_spectrum;
+    uint64_t end_spectrum;
+    bool ok;
+    bool started;
+    pthread_t thread;
+} iq_summary_worker_t;
+
+static bool iq_summary_source_stat(const char *filename, uint64_t *size, int64_t *mtime) {
+    struct stat st;
+    if (stat(filename, &st) != 0) return false;
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+void iq_summary_default_params(iq_summary_params_t *params) {
+    if (!params) return;
+    memset(params, 0, sizeof(*params));
+    params->block_samples = IQ_SUMMARY_DEFAULT_BLOCK_SAMPLES;
+    params->fft_size = IQ_SUMMARY_DEFAULT_FFT_SIZE;
+    params->spectrum_seconds = IQ_SUMMARY_DEFAULT_SPECTRUM_SECONDS;
+}
+
+void iq_summary_path(const char *iq_file, char *path, size_t max_len) {
+    if (!iq_file || !path || max_len == 0) return;
+    snprintf(path, max_len, "%s%s", iq_file, IQ_SUMMARY_EXTENSION);
+}
+
+uint64_t iq_summary_block_length(const iq_summary_t *summary, uint64_t index) {
+    if (!summary || index >= summary->num_blocks) return 0;
+    uint64_t start = index * summary->block_samples;
+    uint64_t left = summary->total_samples - start;
+    return left < summary->block_samples ? left : summary->block_samples;
+}
+
+static void iq_summary_add_block(const float *samples, size_t count, float clip_level,
+                                 iq_summary_block_t *block) {
+    double sum_sq = 0.0, sum_i = 0.0, sum_q = 0.0;
+    float peak = 0.0f;
+    uint32_t clipped = 0;
+    for (size_t k = 0; k < count; k++) {
+        float i = samples[k * 2];
+        float q = samples[k * 2 + 1];
+        sum_sq += (double)i * i + (double)q * q;
+        sum_i += i;
+        sum_q += q;
+        float ai = fabsf(i), aq = fabsf(q);
+        if (ai > peak) peak = ai;
+        if (aq > peak) peak = aq;
+        clipped += (ai >= clip_level) + (aq >= clip_level);
+    }
+    block->sum_sq = sum_sq;
+    block->sum_i = sum_i;
+    block->sum_q = sum_q;
+    block->peak = peak;
+    block->clipped = clipped;
+}
+
+static void *iq_summary_worker_run(void *arg) {
+    iq_summary_worker_t *worker = (iq_summary_worker_t *)arg;
+    const iq_summary_t *summary = worker->summary;
+    const uint32_t fft_size = summary->fft_size;
+    worker->ok = false;
+
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, worker->filename)) {
+        return NULL;
+    }
+    float *buffer = (float *)malloc((size_t)summary->block_samples * 2 * sizeof(float));
+    float *rows = (float *)malloc((size_t)summary->block_samples * sizeof(float));
+    double *accum = (double *)malloc(fft_size * sizeof(double));
+    stft_t *stft = stft_create(worker->plan, worker->window, 1);
+
+    uint64_t first_block = worker->first_spectrum * summary->blocks_per_spectrum;
+    bool ok = buffer && rows && accum && stft && iq_reader_seek_sample(&reader, first_block * summary->block_samples);
+    for (uint64_t s = worker->first_spectrum; ok && s < worker->end_spectrum; s++) {
+        uint64_t b0 = s * summary->blocks_per_spectrum;
+        uint64_t b1 = b0 + summary->blocks_per_spectrum;
+        if (b1 > summary->num_blocks) b1 = summary->num_blocks;
+
+        memset(accum, 0, fft_size * sizeof(double));
+        uint64_t frames = 0;
+        for (uint64_t b = b0; ok && b < b1; b++) {
+            size_t want = (size_t)iq_summary_block_length(summary, b);
+            size_t have = 0;
+            while (have < want) {
+                size_t got = iq_read_samples(&reader, buffer + have * 2, want - have);
+                if (got == 0) break;
+                have += got;
+            }
+            if (have < want) {
+                ok = false;
+                break;
+            }
+            iq_summary_add_block(buffer, want, worker->clip_level, &summary->blocks[b]);
+
+            // Whole frames only: a short last block leaves its tail out of the spectrum
+            uint32_t count = (uint32_t)(want / fft_size);
+            if (count > 0 && !stft_accumulate(stft, buffer, count, fft_size, rows, accum)) ok = false;
+            frames += count;
+        }
+
+        float *spectrum = summary->spectra + s * fft_size;
+        for (uint32_t k = 0; k < fft_size; k++) {
+            spectrum[k] = frames ? (float)(accum[k] / (double)frames) : 0.0f;
+        }
+    }
+    worker->ok = ok;
+
+    stft_destroy(stft);
+    free(accum);
+    free(rows);
+    free(buffer);
+    iq_reader_close(&reader);
+    return NULL;
+}
+
+typedef struct {
+    double sum_sq;
+    double sum_i;
+    double sum_q;
+    double peak;
+    uint64_t clipped;
+    uint64_t samples;
+} iq_summary_sums_t;
+
+// Sums over blocks [first, first + count), always in file order
+static void iq_summary_sum_blocks(const iq_summary_t *summary, uint64_t first, uint64_t count,
+                                  iq_summary_sums_t *sums) {
+    memset(sums, 0, sizeof(*sums));
+    for (uint64_t b = first; b < first + count; b++) {
+        const iq_summary_block_t *block = &summary->blocks[b];
+        sums->sum_sq += block->sum_sq;
+        sums->sum_i += block->sum_i;
+        sums->sum_q += block->sum_q;
+        if (block->peak > sums->peak) sums->peak = block->peak;
+        sums->clipped += block->clipped;
+        sums->samples += iq_summary_block_length(summary, b);
+    }
+}
+
+static void iq_summary_finish(const iq_summary_sums_t *sums, uint64_t total_samples, iq_stats_t *stats) {
+    uint64_t n = sums->samples;
+    stats->total_samples = total_samples;
+    stats->samples_used = n;
+    stats->rms = n ? sqrt(sums->sum_sq / (double)(n * 2)) : 0.0;
+    stats->dc_i = n ? sums->sum_i / (double)n : 0.0;
+    stats->dc_q = n ? sums->sum_q / (double)n : 0.0;
+    stats->peak = sums->peak;
+}
+
+bool iq_summary_build(const char *iq_file, const iq_summary_params_t *params,
+                      iq_summary_t *summary) {
+    if (!iq_file || !summary) {
+        return false;
+    }
+    memset(summary, 0, sizeof(*summary));
+
+    iq_summary_params_t defaults;
+    iq_summary_default_params(&defaults);
+    if (!params) params = &defaults;
+    if (params->fft_size < 2 || params->fft_size > FFT_MAX_SIZE ||
+        params->block_samples < params->fft_size || params->block_samples % params->fft_size != 0 ||
+        !(params->spectrum_seconds > 0.0)) {
+        fprintf(stderr, "Error: Summary needs 2 <= fft_size <= block_samples, block_samples a multiple of fft_size and a positive spectrum interval\n");
+        return false;
+    }
+
+    if (!iq_summary_source_stat(iq_file, &summary->source_size, &summary->source_mtime)) {
+        fprintf(stderr, "Error: Cannot stat IQ file '%s'\n", iq_file);
+        return false;
+    }
+
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, iq_file)) {
+        return false;
+    }
+    summary->format = reader.format;
+    summary->total_samples = reader.total_samples;
+    summary->sample_rate = params->sample_rate ? params->sample_rate :
+                           reader.sample_rate ? reader.sample_rate : IQ_SUMMARY_FALLBACK_RATE;
+    iq_reader_close(&reader);
+
+    summary->block_samples = params->block_samples;
+    summary->fft_size = params->fft_size;
+    summary->num_blocks = (summary->total_samples + summary->block_samples - 1) / summary->block_samples;
+    double per_spectrum = floor(params->spectrum_seconds * summary->sample_rate / summary->block_samples + 0.5);
+    if (per_spectrum < 1.0) per_spectrum = 1.0;
+    if (per_spectrum > (double)UINT32_MAX) per_spectrum = (double)UINT32_MAX;
+    summary->blocks_per_spectrum = (uint32_t)per_spectrum;
+    summary->num_spectra = (summary->num_blocks + summary->blocks_per_spectrum - 1) / summary->blocks_per_spectrum;
+
+    if (summary->num_blocks == 0) {
+        return true;
+    }
+
+    summary->blocks = (iq_summary_block_t *)calloc((size_t)summary->num_blocks, sizeof(iq_summary_block_t));
+    summary->spectra = (float *)calloc((size_t)summary->num_spectra * summary->fft_size, sizeof(float));
+    fft_plan_f32_t *plan = fft_plan_f32_create(summary->fft_size, FFT_FORWARD);
+    const window_t *window = window_acquire(WINDOW_HANN, summary->fft_size, 0.0);
+    if (!summary->blocks || !summary->spectra || !plan || !window) {
+        fprintf(stderr, "Error: Failed to allocate summary of '%s'\n", iq_file);
+        window_release(window);
+        fft_plan_f32_destroy(plan);
+        iq_summary_free(summary);
+        return false;
+    }
+
+    uint32_t num_threads = params->num_threads ? params->num_threads : iq_stats_default_threads();
+    if (num_threads > IQ_STATS_MAX_THREADS) num_threads = IQ_STATS_MAX_THREADS;
+    if (num_threads > summary->num_spectra) num_threads = (uint32_t)summary->num_spectra;
+
+    iq_summary_worker_t *workers = (iq_summary_worker_t *)calloc(num_threads, sizeof(*workers));
+    if (!workers) {
+        window_release(window);
+        fft_plan_f32_destroy(plan);
+        iq_summary_free(summary);
+        return false;
+    }
+
+    // Full scale: the largest positive code, e.g. 32767/32768 for s16
+    uint32_t full_scale = 1u << (iq_format_bits(summary->format) - 1);
+    float clip_level = (float)(full_scale - 1) / (float)full_scale;
+    for (uint32_t i = 0; i < num_threads; i++) {
+        workers[i].filename = iq_file;
+        workers[i].summary = summary;
+        workers[i].plan = plan;
+        workers[i].window = window->coefficients_f32;
+        workers[i].clip_level = clip_level;
+        workers[i].first_spectrum = summary->num_spectra * i / num_threads;
+        workers[i].end_spectrum = summary->num_spectra * (i + 1) / num_threads;
+    }
+
+    // Worker 0 runs on the calling thread
+    for (uint32_t i = 1; i < num_threads; i++) {
+        workers[i].started = pthread_create(&workers[i].thread, NULL, iq_summary_worker_run, &workers[i]) == 0;
+    }
+    iq_summary_worker_run(&workers[0]);
+
+    bool ok = workers[0].ok;
+    for (uint32_t i = 1; i < num_threads; i++) {
+        if (workers[i].started) {
+            pthread_join(workers[i].thread, NULL);
+        } else {
+            iq_summary_worker_run(&workers[i]);   // Could not spawn: do the range here
+        }
+        ok = ok && workers[i].ok;
+    }
+    free(workers);
+    window_release(window);
+    fft_plan_f32_destroy(plan);
+
+    if (!ok) {
+        fprintf(stderr, "Error reading IQ file '%s' for its summary\n", iq_file);
+        iq_summary_free(summary);
+        return false;
+    }
+
+    iq_summary_sums_t sums;
+    iq_summary_sum_blocks(summary, 0, summary->num_blocks, &sums);
+    iq_summary_finish(&sums, summary->total_samples, &summary->stats);
+    summary->clipped = sums.clipped;
+    return true;
+}
+
+bool iq_summary_save(const iq_summary_t *summary, const char *path) {
+    if (!summary || !path || (summary->num_blocks && (!summary->blocks || !summary->spectra))) {
+        return false;
+    }
+
+    iq_summary_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IQ_SUMMARY_MAGIC, sizeof(header.magic));
+    header.version = IQ_SUMMARY_VERSION;
+    header.byte_order = IQ_SUMMARY_BYTE_ORDER;
+    header.block_size = sizeof(iq_summary_block_t);
+    header.format = (uint32_t)summary->format;
+    header.source_size = summary->source_size;
+    header.source_mtime = summary->source_mtime;
+    header.total_samples = summary->total_samples;
+    header.sample_rate = summary->sample_rate;
+    header.block_samples = summary->block_samples;
+    header.num_blocks = summary->num_blocks;
+    header.fft_size = summary->fft_size;
+    header.blocks_per_spectrum = summary->blocks_per_spectrum;
+    header.num_spectra = summary->num_spectra;
+    iq_summary_sums_t sums;
+    iq_summary_sum_blocks(summary, 0, summary->num_blocks, &sums);
+    header.sum_sq = sums.sum_sq;
+    header.sum_i = sums.sum_i;
+    header.sum_q = sums.sum_q;
+    header.peak = sums.peak;
+    header.clipped = sums.clipped;
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot create summary file '%s'\n", path);
+        return false;
+    }
+    size_t spectrum_values = (size_t)summary->num_spectra * summary->fft_size;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (summary->num_blocks == 0 ||
+               (fwrite(summary->blocks, sizeof(iq_summary_block_t), (size_t)summary->num_blocks, file) == summary->num_blocks &&
+                fwrite(summary->spectra, sizeof(float), spectrum_values, file) == spectrum_values));
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to write summary file '%s'\n", path);
+        remove(path);
+    }
+    return ok;
+}
+
+bool iq_summary_load(const char *path, bool header_only, iq_summary_t *summary) {
+    if (!path || !summary) {
+        return false;
+    }
+    memset(summary, 0, sizeof(*summary));
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    iq_summary_header_t header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, IQ_SUMMARY_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == IQ_SUMMARY_VERSION &&
+              header.byte_order == IQ_SUMMARY_BYTE_ORDER &&
+              header.block_size == sizeof(iq_summary_block_t) &&
+              header.format <= IQ_FORMAT_S4 &&
+              header.fft_size >= 2 && header.block_samples >= header.fft_size &&
+              header.blocks_per_spectrum > 0 &&
+              header.num_blocks == (header.total_samples + header.block_samples - 1) / header.block_samples &&
+              header.num_spectra == (header.num_blocks + header.blocks_per_spectrum - 1) / header.blocks_per_spectrum &&
+              header.num_blocks <= SIZE_MAX / sizeof(iq_summary_block_t) &&
+              header.num_spectra <= SIZE_MAX / sizeof(float) / header.fft_size;
+    if (!ok) {
+        fclose(file);
+        return false;
+    }
+
+    summary->source_size = header.source_size;
+    summary->source_mtime = header.source_mtime;
+    summary->format = (iq_format_t)header.format;
+    summary->sample_rate = header.sample_rate;
+    summary->total_samples = header.total_samples;
+    summary->block_samples = header.block_samples;
+    summary->num_blocks = header.num_blocks;
+    summary->fft_size = header.fft_size;
+    summary->blocks_per_spectrum = header.blocks_per_spectrum;
+    summary->num_spectra = header.num_spectra;
+    iq_summary_sums_t sums = {
+        header.sum_sq, header.sum_i, header.sum_q, header.peak, header.clipped, header.total_samples
+    };
+    iq_summary_finish(&sums, header.total_samples, &summary->stats);
+    summary->clipped = header.clipped;
+
+    if (!header_only && summary->num_blocks > 0) {
+        size_t spectrum_values = (size_t)summary->num_spectra * summary->fft_size;
+        summary->blocks = (iq_summary_block_t *)malloc((size_t)summary->num_blocks * sizeof(iq_summary_block_t));
+        summary->spectra = (float *)malloc(spectrum_values * sizeof(float));
+        ok = summary->blocks && summary->spectra &&
+             fread(summary->blocks, sizeof(iq_summary_block_t), (size_t)summary->num_blocks, file) == summary->num_blocks &&
+             fread(summary->spectra, sizeof(float), spectrum_values, file) == spectrum_values;
+    }
+    fclose(file);
+
+    if (!ok) {
+        fprintf(stderr, "Error: Truncated summary file '%s'\n", path);
+        iq_summary_free(summary);
+        return false;
+    }
+    return true;
+}
+
+bool iq_summary_is_fresh(const iq_summary_t *summary, const char *iq_file) {
+    uint64_t size;
+    int64_t mtime;
+    if (!summary || !iq_file || !iq_summary_source_stat(iq_file, &size, &mtime)) {
+        return false;
+    }
+    return size == summary->source_size && mtime == summary->source_mtime;
+}
+
+bool iq_summary_open(const char *iq_file, bool header_only, bool build,
+                     const iq_summary_params_t *params, iq_summary_t *summary) {
+    if (!iq_file || !summary) {
+        return false;
+    }
+
+    char path[1024];
+    iq_summary_path(iq_file, path, sizeof(path));
+    if (iq_summary_load(path, header_only, summary)) {
+        if (iq_summary_is_fresh(summary, iq_file)) {
+            return true;
+        }
+        iq_summary_free(summary);
+    }
+    if (!build || !iq_summary_build(iq_file, params, summary)) {
+        return false;
+    }
+
+    // The summary is still good in memory if the sidecar cannot be written
+    iq_summary_save(summary, path);
+    if (header_only) {
+        free(summary->blocks);
+        free(summary->spectra);
+        summary->blocks = NULL;
+        summary->spectra = NULL;
+    }
+    return true;
+}
+
+bool iq_summary_range_stats(const iq_summary_t *summary, uint64_t first, uint64_t count,
+                            iq_stats_t *stats) {
+    if (!summary || !stats || !summary->blocks ||
+        first > summary->num_blocks || count > summary->num_blocks - first) {
+        return false;
+    }
+
+    iq_summary_sums_t sums;
+    iq_summary_sum_blocks(summary, first, count, &sums);
+    iq_summary_finish(&sums, summary->total_samples, stats);
+    return true;
+}
+
+void iq_summary_free(iq_summary_t *summary) {
+    if (!summary) return;
+    free(summary->blocks);
+    free(summary->spectra);
+    summary->blocks = NULL;
+    summary->spectra = NULL;
+}
@@ -0,0 +1,115 @@
+#ifndef IQ_SUMMARY_H
+#define IQ_SUMMARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "io_iq.h"
+#include "iq_stats.h"
+
+/*
+ * Per-file summary sidecar ("<file>.iqsum")
+ * One streaming pass over a capture records what overviews need, so they
+ * never touch the raw IQ again:
+ *   - per block of block_samples: sum of squares, sums of I and Q, peak
+ *     and the number of clipped values (|I| or |Q| at the format's
+ *     largest code), enough to rebuild RMS, DC and peak over any block range
+ *   - one averaged Hann power spectrum (fft_size bins, DC centred, the same
+ *     linear power as stft_rows) per blocks_per_spectrum blocks, i.e. per
+ *     spectrum_seconds of capture
+ *   - whole-file totals, exact: iq_stats_full() figures and a clip count
+ *
+ * The sidecar records the size and mtime of the file it summarises and is
+ * ignored once either changes. The header alone answers iqinfo; blocks and
+ * spectra are a few MB even for a 100 GB capture (32 bytes per 64K-sample
+ * block, 4 KB per spectrum), so a full overview loads in milliseconds.
+ *
+ * The pass is split into contiguous runs of whole spectra, one per thread,
+ * each writing its own blocks and spectra; totals are then summed block by
+ * block in file order, so the sidecar is the same for any thread count.
+ */
+
+#define IQ_SUMMARY_EXTENSION ".iqsum"
+
+// Defaults: 64K-sample blocks, 1024-bin spectra, one spectrum per second
+#define IQ_SUMMARY_DEFAULT_BLOCK_SAMPLES 65536
+#define IQ_SUMMARY_DEFAULT_FFT_SIZE 1024
+#define IQ_SUMMARY_DEFAULT_SPECTRUM_SECONDS 1.0
+
+// Rate assumed for spectrum_seconds when neither the caller nor the file gives one
+#define IQ_SUMMARY_FALLBACK_RATE 1000000
+
+typedef struct {
+    uint32_t block_samples;   // Samples per power block, a multiple of fft_size
+    uint32_t fft_size;        // Bins per spectrum; frames do not overlap
+    double spectrum_seconds;  // Capture time averaged into each spectrum
+    uint32_t sample_rate;     // 0 = from the file header
+    uint32_t num_threads;     // 0 = one per CPU
+} iq_summary_params_t;
+
+// One block as stored on disk
+typedef struct {
+    double sum_sq;            // Sum of I^2 + Q^2
+    double sum_i;
+    double sum_q;
+    float peak;               // Largest |I| or |Q|
+    uint32_t clipped;         // I and Q values at full scale
+} iq_summary_block_t;
+
+typedef struct {
+    uint64_t source_size;     // Size and mtime of the summarised file
+    int64_t source_mtime;
+    iq_format_t format;
+    uint32_t sample_rate;     // Rate spectrum_seconds was converted with
+    uint64_t total_samples;
+    uint32_t block_samples;
+    uint64_t num_blocks;      // Last block may be short
+    uint32_t fft_size;
+    uint32_t blocks_per_spectrum;
+    uint64_t num_spectra;     // Last spectrum may cover fewer blocks
+    iq_stats_t stats;         // Whole file, every sample
+    uint64_t clipped;         // Whole file
+    iq_summary_block_t *blocks;  // num_blocks records (NULL when loaded header only)
+    float *spectra;           // num_spectra * fft_size linear power (NULL when header only)
+} iq_summary_t;
+
+// Default block, FFT and spectrum interval; rate from the file, all CPUs
+void iq_summary_default_params(iq_summary_params_t *params);
+
+// "<iq_file>.iqsum"
+void iq_summary_path(const char *iq_file, char *path, size_t max_len);
+
+/*
+ * Summarise a whole file in one pass (raw, WAV or IQZ via iq_reader_t)
+ * NULL params selects iq_summary_default_params().
+ */
+bool iq_summary_build(const char *iq_file, const iq_summary_params_t *params,
+                      iq_summary_t *summary);
+
+// Write a built summary; a failed write leaves no file behind
+bool iq_summary_save(const iq_summary_t *summary, const char *path);
+
+// Read a sidecar; header_only skips the blocks and spectra
+bool iq_summary_load(const char *path, bool header_only, iq_summary_t *summary);
+
+// True when 'iq_file' still has the size and mtime the summary was built from
+bool iq_summary_is_fresh(const iq_summary_t *summary, const char *iq_file);
+
+/*
+ * The fresh sidecar next to 'iq_file', or with 'build' a new one computed
+ * and saved in its place (params as for iq_summary_build). Returns false
+ * when there is no fresh sidecar and 'build' is off, or building fails.
+ */
+bool iq_summary_open(const char *iq_file, bool header_only, bool build,
+                     const iq_summary_params_t *params, iq_summary_t *summary);
+
+// RMS, DC and peak over blocks [first, first + count) of a loaded summary
+bool iq_summary_range_stats(const iq_summary_t *summary, uint64_t first, uint64_t count,
+                            iq_stats_t *stats);
+
+// Samples held by block 'index' (block_samples except for the last block)
+uint64_t iq_summary_block_length(const iq_summary_t *summary, uint64_t index);
+
+void iq_summary_free(iq_summary_t *summary);
+
+#endif // IQ_SUMMARY_H
@@ -0,0 +1,315 @@
+#include "nco.h"
+#include <math.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NCO_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define NCO_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Mixing kernel, chosen on first use
+enum {
+    NCO_SIMD_SCALAR,
+    NCO_SIMD_SSE2,
+    NCO_SIMD_AVX,
+    NCO_SIMD_NEON
+};
+
+static atomic_int nco_simd_active = -1;
+
+// Lanes for samples n .. n + NCO_LANES - 1 from the phasor of sample n,
+// with lane (count % NCO_LANES) holding sample n
+static void nco_seed(nco_t *nco, double base_re, double base_im) {
+    double angle = 2.0 * M_PI * nco->frequency / nco->sample_rate;
+    uint32_t first = nco->count % NCO_LANES;
+
+    for (uint32_t k = 0; k < NCO_LANES; k++) {
+        double c = cos(angle * k), s = sin(angle * k);
+        uint32_t l = (first + k) % NCO_LANES;
+        nco->lane_re[l] = base_re * c - base_im * s;
+        nco->lane_im[l] = base_re * s + base_im * c;
+    }
+    nco->step_re = cos(angle * NCO_LANES);
+    nco->step_im = sin(angle * NCO_LANES);
+}
+
+/**
+ * @brief Initialize the oscillator at phase 0
+ */
+bool nco_init(nco_t *nco, double frequency, double sample_rate) {
+    if (!nco || !(sample_rate > 0.0)) return false;
+
+    memset(nco, 0, sizeof(*nco));
+    nco->frequency = frequency;
+    nco->sample_rate = sample_rate;
+    nco_seed(nco, 1.0, 0.0);
+    return true;
+}
+
+/**
+ * @brief Retune, keeping the phase of the next sample
+ */
+bool nco_set_frequency(nco_t *nco, double frequency) {
+    if (!nco || !(nco->sample_rate > 0.0)) return false;
+
+    uint32_t l = nco->count % NCO_LANES;
+    double re = nco->lane_re[l], im = nco->lane_im[l];
+    double magnitude = sqrt(re * re + im * im);
+
+    nco->frequency = frequency;
+    nco_seed(nco, re / magnitude, im / magnitude);
+    return true;
+}
+
+/**
+ * @brief Restart at phase 0
+ */
+void nco_reset(nco_t *nco) {
+    if (!nco || !(nco->sample_rate > 0.0)) return;
+
+    nco->count = 0;
+    nco_seed(nco, 1.0, 0.0);
+}
+
+// Rotate the lane that just produced a sample; the last NCO_LANES samples
+// of every NCO_RENORM renormalise their lane, so all lanes are pulled back
+// to unit magnitude at the same points of the stream
+static inline void nco_advance(nco_t *nco, uint32_t l) {
+    double re = nco->lane_re[l], im = nco->lane_im[l];
+    double next_re = re * nco->step_re - im * nco->step_im;
+    double next_im = re * nco->step_im + im * nco->step_re;
+
+    if (nco->count >= NCO_RENORM - NCO_LANES) {
+        double magnitude = sqrt(next_re * next_re + next_im * next_im);
+        next_re /= magnitude;
+        next_im /= magnitude;
+    }
+    nco->lane_re[l] = next_re;
+    nco->lane_im[l] = next_im;
+    if (++nco->count == NCO_RENORM) nco->count = 0;
+}
+
+/**
+ * @brief Current phasor, then one sample on
+ */
+void nco_step(nco_t *nco, float *re, float *im) {
+    uint32_t l = nco->count % NCO_LANES;
+
+    *re = (float)nco->lane_re[l];
+    *im = (float)nco->lane_im[l];
+    nco_advance(nco, l);
+}
+
+static int nco_simd_detect(void) {
+#if defined(NCO_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx")) return NCO_SIMD_AVX;
+    if (__builtin_cpu_supports("sse2")) return NCO_SIMD_SSE2;
+    return NCO_SIMD_SCALAR;
+#elif defined(NCO_HAVE_NEON)
+    return NCO_SIMD_NEON;
+#else
+    return NCO_SIMD_SCALAR;
+#endif
+}
+
+void nco_force_scalar(bool scalar) {
+    atomic_store(&nco_simd_active, scalar ? NCO_SIMD_SCALAR : nco_simd_detect());
+}
+
+// One sample at a time; loads each input before its output is stored, so
+// in and out may be the same buffer
+static void nco_mix_scalar(nco_t *nco, const float *in, float *out, size_t count) {
+    for (size_t n = 0; n < count; n++) {
+        float pr, pi;
+        nco_step(nco, &pr, &pi);
+        float i_val = in[2 * n], q_val = in[2 * n + 1];
+        out[2 * n] = i_val * pr - q_val * pi;
+        out[2 * n + 1] = i_val * pi + q_val * pr;
+    }
+}
+
+/*
+ * Vector kernels: groups of NCO_LANES samples starting at lane 0. The lanes
+ * stay in registers, are narrowed to float for the mix and rotated (and
+ * renormalised in the last group of each period) in double exactly as
+ * nco_advance does.
+ */
+
+#if defined(NCO_HAVE_X86_SIMD)
+
+__attribute__((target("sse2")))
+static void nco_mix_sse2(nco_t *nco, const float *in, float *out, size_t groups) {
+    __m128d re01 = _mm_loadu_pd(nco->lane_re), re23 = _mm_loadu_pd(nco->lane_re + 2);
+    __m128d im01 = _mm_loadu_pd(nco->lane_im), im23 = _mm_loadu_pd(nco->lane_im + 2);
+    const __m128d step_re = _mm_set1_pd(nco->step_re), step_im = _mm_set1_pd(nco->step_im);
+    uint32_t count = nco->count;
+
+    for (size_t g = 0; g < groups; g++, in += 2 * NCO_LANES, out += 2 * NCO_LANES) {
+        __m128 pr = _mm_movelh_ps(_mm_cvtpd_ps(re01), _mm_cvtpd_ps(re23));
+        __m128 pi = _mm_movelh_ps(_mm_cvtpd_ps(im01), _mm_cvtpd_ps(im23));
+        __m128 v0 = _mm_loadu_ps(in), v1 = _mm_loadu_ps(in + 4);
+        __m128 x_i = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 x_q = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 y_re = _mm_sub_ps(_mm_mul_ps(x_i, pr), _mm_mul_ps(x_q, pi));
+        __m128 y_im = _mm_add_ps(_mm_mul_ps(x_i, pi), _mm_mul_ps(x_q, pr));
+        _mm_storeu_ps(out, _mm_unpacklo_ps(y_re, y_im));
+        _mm_storeu_ps(out + 4, _mm_unpackhi_ps(y_re, y_im));
+
+        __m128d n_re01 = _mm_sub_pd(_mm_mul_pd(re01, step_re), _mm_mul_pd(im01, step_im));
+        __m128d n_im01 = _mm_add_pd(_mm_mul_pd(re01, step_im), _mm_mul_pd(im01, step_re));
+        __m128d n_re23 = _mm_sub_pd(_mm_mul_pd(re23, step_re), _mm_mul_pd(im23, step_im));
+        __m128d n_im23 = _mm_add_pd(_mm_mul_pd(re23, step_im), _mm_mul_pd(im23, step_re));
+        if (count == NCO_RENORM - NCO_LANES) {
+            __m128d m01 = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(n_re01, n_re01), _mm_mul_pd(n_im01, n_im01)));
+            __m128d m23 = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(n_re23, n_re23), _mm_mul_pd(n_im23, n_im23)));
+            n_re01 = _mm_div_pd(n_re01, m01);
+            n_im01 = _mm_div_pd(n_im01, m01);
+            n_re23 = _mm_div_pd(n_re23, m23);
+            n_im23 = _mm_div_pd(n_im23, m23);
+        }
+        re01 = n_re01;
+        im01 = n_im01;
+        re23 = n_re23;
+        im23 = n_im23;
+        count += NCO_LANES;
+        if (count == NCO_RENORM) count = 0;
+    }
+
+    _mm_storeu_pd(nco->lane_re, re01);
+    _mm_storeu_pd(nco->lane_re + 2, re23);
+    _mm_storeu_pd(nco->lane_im, im01);
+    _mm_storeu_pd(nco->lane_im + 2, im23);
+    nco->count = count;
+}
+
+__attribute__((target("avx")))
+static void nco_mix_avx(nco_t *nco, const float *in, float *out, size_t groups) {
+    __m256d re = _mm256_loadu_pd(nco->lane_re), im = _mm256_loadu_pd(nco->lane_im);
+    const __m256d step_re = _mm256_set1_pd(nco->step_re), step_im = _mm256_set1_pd(nco->step_im);
+    uint32_t count = nco->count;
+
+    for (size_t g = 0; g < groups; g++, in += 2 * NCO_LANES, out += 2 * NCO_LANES) {
+        __m128 pr = _mm256_cvtpd_ps(re), pi = _mm256_cvtpd_ps(im);
+        __m128 v0 = _mm_loadu_ps(in), v1 = _mm_loadu_ps(in + 4);
+        __m128 x_i = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 x_q = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 y_re = _mm_sub_ps(_mm_mul_ps(x_i, pr), _mm_mul_ps(x_q, pi));
+        __m128 y_im = _mm_add_ps(_mm_mul_ps(x_i, pi), _mm_mul_ps(x_q, pr));
+        _mm_storeu_ps(out, _mm_unpacklo_ps(y_re, y_im));
+        _mm_storeu_ps(out + 4, _mm_unpackhi_ps(y_re, y_im));
+
+        __m256d n_re = _mm256_sub_pd(_mm256_mul_pd(re, step_re), _mm256_mul_pd(im, step_im));
+        __m256d n_im = _mm256_add_pd(_mm256_mul_pd(re, step_im), _mm256_mul_pd(im, step_re));
+        if (count == NCO_RENORM - NCO_LANES) {
+            __m256d m = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(n_re, n_re), _mm256_mul_pd(n_im, n_im)));
+            n_re = _mm256_div_pd(n_re, m);
+            n_im = _mm256_div_pd(n_im, m);
+        }
+        re = n_re;
+        im = n_im;
+        count += NCO_LANES;
+        if (count == NCO_RENORM) count = 0;
+    }
+
+    _mm256_storeu_pd(nco->lane_re, re);
+    _mm256_storeu_pd(nco->lane_im, im);
+    nco->count = count;
+}
+
+#endif /* NCO_HAVE_X86_SIMD */
+
+#if defined(NCO_HAVE_NEON)
+
+static void nco_mix_neon(nco_t *nco, const float *in, float *out, size_t groups) {
+    float64x2_t re01 = vld1q_f64(nco->lane_re), re23 = vld1q_f64(nco->lane_re + 2);
+    float64x2_t im01 = vld1q_f64(nco->lane_im), im23 = vld1q_f64(nco->lane_im + 2);
+    const float64x2_t step_re = vdupq_n_f64(nco->step_re), step_im = vdupq_n_f64(nco->step_im);
+    uint32_t count = nco->count;
+
+    for (size_t g = 0; g < groups; g++, in += 2 * NCO_LANES, out += 2 * NCO_LANES) {
+        float32x4_t pr = vcombine_f32(vcvt_f32_f64(re01), vcvt_f32_f64(re23));
+        float32x4_t pi = vcombine_f32(vcvt_f32_f64(im01), vcvt_f32_f64(im23));
+        float32x4x2_t x = vld2q_f32(in);
+        float32x4x2_t y;
+        y.val[0] = vsubq_f32(vmulq_f32(x.val[0], pr), vmulq_f32(x.val[1], pi));
+        y.val[1] = vaddq_f32(vmulq_f32(x.val[0], pi), vmulq_f32(x.val[1], pr));
+        vst2q_f32(out, y);
+
+        float64x2_t n_re01 = vsubq_f64(vmulq_f64(re01, step_re), vmulq_f64(im01, step_im));
+        float64x2_t n_im01 = vaddq_f64(vmulq_f64(re01, step_im), vmulq_f64(im01, step_re));
+        float64x2_t n_re23 = vsubq_f64(vmulq_f64(re23, step_re), vmulq_f64(im23, step_im));
+        float64x2_t n_im23 = vaddq_f64(vmulq_f64(re23, step_im), vmulq_f64(im23, step_re));
+        if (count == NCO_RENORM - NCO_LANES) {
+            float64x2_t m01 = vsqrtq_f64(vaddq_f64(vmulq_f64(n_re01, n_re01), vmulq_f64(n_im01, n_im01)));
+            float64x2_t m23 = vsqrtq_f64(vaddq_f64(vmulq_f64(n_re23, n_re23), vmulq_f64(n_im23, n_im23)));
+            n_re01 = vdivq_f64(n_re01, m01);
+            n_im01 = vdivq_f64(n_im01, m01);
+            n_re23 = vdivq_f64(n_re23, m23);
+            n_im23 = vdivq_f64(n_im23, m23);
+        }
+        re01 = n_re01;
+        im01 = n_im01;
+        re23 = n_re23;
+        im23 = n_im23;
+        count += NCO_LANES;
+        if (count == NCO_RENORM) count = 0;
+    }
+
+    vst1q_f64(nco->lane_re, re01);
+    vst1q_f64(nco->lane_re + 2, re23);
+    vst1q_f64(nco->lane_im, im01);
+    vst1q_f64(nco->lane_im + 2, im23);
+    nco->count = count;
+}
+
+#endif /* NCO_HAVE_NEON */
+
+/**
+ * @brief Mix interleaved IQ by the oscillator
+ */
+void nco_mix(nco_t *nco, const float *iq_in, float *iq_out, size_t count) {
+    if (!nco || !iq_in || !iq_out) return;
+
+    int simd = atomic_load(&nco_simd_active);
+    if (simd < 0) {
+        simd = nco_simd_detect();
+        atomic_store(&nco_simd_active, simd);
+    }
+    if (simd == NCO_SIMD_SCALAR) {
+        nco_mix_scalar(nco, iq_in, iq_out, count);
+        return;
+    }
+
+    // Step to lane 0, run whole groups, finish the tail one by one
+    size_t head = (NCO_LANES - nco->count % NCO_LANES) % NCO_LANES;
+    if (head > count) head = count;
+    nco_mix_scalar(nco, iq_in, iq_out, head);
+    iq_in += 2 * head;
+    iq_out += 2 * head;
+    count -= head;
+
+    size_t groups = count / NCO_LANES;
+    switch (simd) {
+#if defined(NCO_HAVE_X86_SIMD)
+        case NCO_SIMD_AVX:  nco_mix_avx(nco, iq_in, iq_out, groups); break;
+        case NCO_SIMD_SSE2: nco_mix_sse2(nco, iq_in, iq_out, groups); break;
+#endif
+#if defined(NCO_HAVE_NEON)
+        case NCO_SIMD_NEON: nco_mix_neon(nco, iq_in, iq_out, groups); break;
+#endif
+        default:            nco_mix_scalar(nco, iq_in, iq_out, groups * NCO_LANES); break;
+    }
+
+    size_t done = groups * NCO_LANES;
+    nco_mix_scalar(nco, iq_in + 2 * done, iq_out + 2 * done, count - done);
+}
@@ -0,0 +1,62 @@
+#ifndef IQ_LAB_NCO_H
+#define IQ_LAB_NCO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Numerically controlled oscillator
+ *
+ * Produces the unit phasor exp(j 2 pi f n / fs) without any sin/cos in the
+ * loop: NCO_LANES double precision phasors hold consecutive samples and
+ * each one is rotated by exp(j 2 pi f NCO_LANES / fs) after it is used, so
+ * a block kernel can advance all lanes with one vector complex multiply.
+ * The lanes are renormalised to unit magnitude every NCO_RENORM samples of
+ * the stream, which keeps the amplitude drift of the recurrence below
+ * 1e-12 however long it runs.
+ *
+ * nco_mix multiplies interleaved IQ by the phasor (SSE2/AVX on x86, NEON
+ * on AArch64, dispatched once at run time). Every path rotates, converts
+ * and mixes with the same separate multiplies and adds as the scalar code,
+ * so they are bit-identical to each other and to nco_step, and any split
+ * of the stream into blocks or single steps gives the same outputs.
+ *
+ * Usage:
+ *   nco_t nco;
+ *   nco_init(&nco, -offset_hz, sample_rate);
+ *   nco_mix(&nco, iq_in, iq_out, count);
+ */
+
+#define NCO_LANES 4
+#define NCO_RENORM 1024          // Samples between renormalisations (multiple of NCO_LANES)
+
+// Oscillator state; lane (count % NCO_LANES) holds the next sample
+typedef struct {
+    double frequency;            // Hz (negative: clockwise)
+    double sample_rate;          // Hz
+    double lane_re[NCO_LANES];
+    double lane_im[NCO_LANES];
+    double step_re, step_im;     // exp(j 2 pi f NCO_LANES / fs)
+    uint32_t count;              // Samples since the last renormalisation
+} nco_t;
+
+// Start at phase 0 for frequency at sample_rate
+bool nco_init(nco_t *nco, double frequency, double sample_rate);
+
+// Change the frequency, continuing from the current phase
+bool nco_set_frequency(nco_t *nco, double frequency);
+
+// Restart at phase 0
+void nco_reset(nco_t *nco);
+
+// Phasor for the next sample, then advance by one sample
+void nco_step(nco_t *nco, float *re, float *im);
+
+// iq_out = iq_in * phasor for count interleaved IQ samples (may be in place)
+void nco_mix(nco_t *nco, const float *iq_in, float *iq_out, size_t count);
+
+// Use the portable mixing kernel only (benchmarks and tests)
+void nco_force_scalar(bool scalar);
+
+#endif // IQ_LAB_NCO_H
@@ -0,0 +1,522 @@
+/*
+ * IQ Lab - Hot-path profiling counters
+ *
+ * Every thread owns one block of counters, linked into a global list under
+ * a mutex the first time the thread records anything. Only the owner
+ * writes a block, with relaxed load/store pairs (no read-modify-write), so
+ * recording costs two clock reads and four plain adds; readers merging at
+ * exit need no lock beyond the list walk. Blocks stay on the list for the
+ * life of the process, as a thread's counters must outlive the thread.
+ *
+ * While tracing, a block also owns a ring of events. The owner writes the
+ * slot at 'ring_head' and then publishes the new head with a release
+ * store, so the dump at exit reads whole events from threads still
+ * running; once the ring is full the oldest events are overwritten.
+ *
+ * Latency histograms follow the same rule: the owner bumps a bucket with a
+ * relaxed load/store pair and readers sum the buckets of every block.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // clock_gettime under -std=c11
+#endif
+
+#include "profile.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define IQ_TRACE_NAME_SIZE 32
+#define IQ_TRACE_TRACK_TID 1000000   // Tids of the named span tracks start here
+
+typedef struct {
+    uint64_t start;
+    uint64_t ns;
+    uint32_t stage;
+} iq_trace_event_t;
+
+typedef struct iq_profile_block {
+    atomic_uint_fast64_t calls[IQ_PROFILE_STAGE_COUNT];
+    atomic_uint_fast64_t ns[IQ_PROFILE_STAGE_COUNT];
+    atomic_uint_fast64_t items[IQ_PROFILE_STAGE_COUNT];
+    atomic_uint_fast64_t bytes[IQ_PROFILE_STAGE_COUNT];
+    iq_latency_hist_t latency[IQ_PROFILE_STAGE_COUNT];
+    iq_trace_event_t *ring;             // IQ_TRACE_RING_EVENTS, allocated on the first event
+    atomic_uint_fast64_t ring_head;     // Events ever written
+    uint32_t id;                        // Trace tid, in registration order
+    char name[IQ_TRACE_NAME_SIZE];      // profile_lock
+    struct iq_profile_block *next;
+} iq_profile_block_t;
+
+typedef struct {
+    char name[64];
+    char track[64];                     // "" : on thread 'tid'
+    uint32_t tid;
+    uint64_t start;
+    uint64_t ns;
+} iq_trace_span_t;
+
+atomic_bool iq_profile_on = false;
+
+static _Thread_local iq_profile_block_t *profile_block = NULL;
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+static iq_profile_block_t *profile_blocks = NULL;   // profile_lock
+static uint32_t profile_threads = 0;                // profile_lock
+static char profile_tool[64];                       // Set once, by the first start
+static bool profile_exit_registered = false;        // profile_lock
+static bool profile_counters = false;               // profile_lock: report counters at exit
+static char *profile_json = NULL;
+static uint64_t profile_start_ns = 0;
+static uint64_t profile_epoch_ns = 0;               // Trace time zero
+
+static atomic_bool trace_on = false;
+static char *trace_json = NULL;
+static iq_trace_span_t *trace_spans = NULL;         // profile_lock
+static size_t trace_span_count = 0;
+static size_t trace_span_capacity = 0;
+static uint64_t trace_spans_dropped = 0;
+
+static const char *const stage_names[IQ_PROFILE_STAGE_COUNT] = {
+    "read", "convert", "fft", "cfar", "cluster", "channelize",
+    "filter", "demod", "resample", "encode", "write", "wait",
+};
+
+uint64_t iq_profile_now(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+const char *iq_profile_stage_name(iq_profile_stage_t stage) {
+    return (unsigned)stage < IQ_PROFILE_STAGE_COUNT ? stage_names[stage] : "unknown";
+}
+
+static iq_profile_block_t *iq_profile_thread_block(void) {
+    if (profile_block) return profile_block;
+    iq_profile_block_t *block = calloc(1, sizeof(*block));
+    if (!block) return NULL;
+    pthread_mutex_lock(&profile_lock);
+    block->next = profile_blocks;
+    profile_blocks = block;
+    block->id = ++profile_threads;
+    pthread_mutex_unlock(&profile_lock);
+    profile_block = block;
+    return block;
+}
+
+static inline void iq_profile_add(atomic_uint_fast64_t *counter, uint64_t value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
+
+// Below 4 ns one bucket per nanosecond, then floor(log2) * 4 plus the two
+// bits after the leading one
+static uint32_t iq_latency_bucket(uint64_t ns) {
+    if (ns < 4) return (uint32_t)ns;
+    uint32_t log2 = 63;
+    while (!(ns >> log2)) log2--;
+    uint32_t bucket = log2 * 4 + (uint32_t)((ns >> (log2 - 2)) & 3);
+    return bucket < IQ_LATENCY_BUCKETS ? bucket : IQ_LATENCY_BUCKETS - 1;
+}
+
+// Middle of a bucket's range
+static uint64_t iq_latency_bucket_ns(uint32_t bucket) {
+    if (bucket < 4) return bucket;
+    uint32_t log2 = bucket / 4;
+    uint64_t width = (uint64_t)1 << (log2 - 2);
+    return (4 + (bucket & 3)) * width + width / 2;
+}
+
+void iq_latency_add(iq_latency_hist_t *hist, uint64_t ns) {
+    iq_profile_add(&hist->counts[iq_latency_bucket(ns)], 1);
+    if (ns > atomic_load_explicit(&hist->max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&hist->max_ns, ns, memory_order_relaxed);
+    }
+}
+
+// Percentiles of merged bucket counts
+static void iq_latency_summarize(const uint64_t *counts, uint64_t max_ns, iq_latency_t *latency) {
+    memset(latency, 0, sizeof(*latency));
+    for (uint32_t b = 0; b < IQ_LATENCY_BUCKETS; b++) latency->count += counts[b];
+    if (latency->count == 0) return;
+
+    const uint64_t p50_rank = (latency->count + 1) / 2;
+    const uint64_t p99_rank = latency->count - latency->count / 100;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < IQ_LATENCY_BUCKETS; b++) {
+        if (counts[b] == 0) continue;
+        seen += counts[b];
+        uint64_t ns = iq_latency_bucket_ns(b);
+        if (ns > max_ns) ns = max_ns;
+        if (latency->p50_ns == 0 && seen >= p50_rank) latency->p50_ns = ns;
+        if (seen >= p99_rank) {
+            latency->p99_ns = ns;
+            break;
+        }
+    }
+    latency->max_ns = max_ns;
+}
+
+void iq_latency_get(const iq_latency_hist_t *hist, iq_latency_t *latency) {
+    uint64_t counts[IQ_LATENCY_BUCKETS];
+    for (uint32_t b = 0; b < IQ_LATENCY_BUCKETS; b++) {
+        counts[b] = atomic_load_explicit(&hist->counts[b], memory_order_relaxed);
+    }
+    iq_latency_summarize(counts, atomic_load_explicit(&hist->max_ns, memory_order_relaxed), latency);
+}
+
+static void iq_trace_push(iq_profile_block_t *block, iq_profile_stage_t stage,
+                          uint64_t start, uint64_t ns) {
+    if (!block->ring) {
+        block->ring = calloc(IQ_TRACE_RING_EVENTS, sizeof(iq_trace_event_t));
+        if (!block->ring) return;
+    }
+    uint64_t head = atomic_load_explicit(&block->ring_head, memory_order_relaxed);
+    iq_trace_event_t *event = &block->ring[head % IQ_TRACE_RING_EVENTS];
+    event->start = start;
+    event->ns = ns;
+    event->stage = (uint32_t)stage;
+    atomic_store_explicit(&block->ring_head, head + 1, memory_order_release);
+}
+
+void iq_profile_record(iq_profile_stage_t stage, uint64_t start, uint64_t end,
+                       uint64_t items, uint64_t bytes) {
+    if ((unsigned)stage >= IQ_PROFILE_STAGE_COUNT) return;
+    iq_profile_block_t *block = iq_profile_thread_block();
+    if (!block) return;
+    const uint64_t ns = end > start ? end - start : 0;
+    iq_profile_add(&block->calls[stage], 1);
+    iq_profile_add(&block->ns[stage], ns);
+    iq_profile_add(&block->items[stage], items);
+    iq_profile_add(&block->bytes[stage], bytes);
+    iq_latency_add(&block->latency[stage], ns);
+    if (atomic_load_explicit(&trace_on, memory_order_relaxed)) {
+        iq_trace_push(block, stage, start, ns);
+    }
+}
+
+void iq_profile_get(iq_profile_stage_t stage, iq_profile_totals_t *totals) {
+    memset(totals, 0, sizeof(*totals));
+    if ((unsigned)stage >= IQ_PROFILE_STAGE_COUNT) return;
+    pthread_mutex_lock(&profile_lock);
+    for (iq_profile_block_t *b = profile_blocks; b; b = b->next) {
+        uint64_t calls = atomic_load_explicit(&b->calls[stage], memory_order_relaxed);
+        if (calls == 0) continue;
+        totals->calls += calls;
+        totals->ns += atomic_load_explicit(&b->ns[stage], memory_order_relaxed);
+        totals->items += atomic_load_explicit(&b->items[stage], memory_order_relaxed);
+        totals->bytes += atomic_load_explicit(&b->bytes[stage], memory_order_relaxed);
+        totals->threads++;
+    }
+    pthread_mutex_unlock(&profile_lock);
+}
+
+void iq_profile_latency(iq_profile_stage_t stage, iq_latency_t *latency) {
+    memset(latency, 0, sizeof(*latency));
+    if ((unsigned)stage >= IQ_PROFILE_STAGE_COUNT) return;
+    uint64_t counts[IQ_LATENCY_BUCKETS] = {0};
+    uint64_t max_ns = 0;
+    pthread_mutex_lock(&profile_lock);
+    for (iq_profile_block_t *b = profile_blocks; b; b = b->next) {
+        const iq_latency_hist_t *hist = &b->latency[stage];
+        for (uint32_t k = 0; k < IQ_LATENCY_BUCKETS; k++) {
+            counts[k] += atomic_load_explicit(&hist->counts[k], memory_order_relaxed);
+        }
+        uint64_t block_max = atomic_load_explicit(&hist->max_ns, memory_order_relaxed);
+        if (block_max > max_ns) max_ns = block_max;
+    }
+    pthread_mutex_unlock(&profile_lock);
+    iq_latency_summarize(counts, max_ns, latency);
+}
+
+static double iq_profile_wall_seconds(void) {
+    return profile_start_ns ? (double)(iq_profile_now() - profile_start_ns) * 1e-9 : 0.0;
+}
+
+void iq_profile_print(FILE *out) {
+    const double wall = iq_profile_wall_seconds();
+    pthread_mutex_lock(&profile_lock);
+    const uint32_t threads = profile_threads;
+    pthread_mutex_unlock(&profile_lock);
+
+    fprintf(out, "\nProfile: %s, %.3f s wall, %u thread%s recording\n",
+            profile_tool[0] ? profile_tool : "iq_lab", wall, threads, threads == 1 ? "" : "s");
+    fprintf(out, "%-11s %10s %11s %7s %4s %14s %10s %9s %10s %10s\n",
+            "stage", "calls", "ms", "% wall", "thr", "items", "Mitems/s", "MB/s", "p99 us", "max us");
+    for (int s = 0; s < IQ_PROFILE_STAGE_COUNT; s++) {
+        iq_profile_totals_t t;
+        iq_profile_get((iq_profile_stage_t)s, &t);
+        if (t.calls == 0) continue;
+        iq_latency_t latency;
+        iq_profile_latency((iq_profile_stage_t)s, &latency);
+        const double seconds = (double)t.ns * 1e-9;
+        fprintf(out, "%-11s %10llu %11.2f %7.1f %4u %14llu", stage_names[s],
+                (unsigned long long)t.calls, seconds * 1e3, wall > 0.0 ? 100.0 * seconds / wall : 0.0,
+                t.threads, (unsigned long long)t.items);
+        if (seconds > 0.0 && t.items > 0) fprintf(out, " %10.2f", (double)t.items / seconds * 1e-6);
+        else fprintf(out, " %10s", "-");
+        if (seconds > 0.0 && t.bytes > 0) fprintf(out, " %9.1f", (double)t.bytes / seconds / 1048576.0);
+        else fprintf(out, " %9s", "-");
+        fprintf(out, " %10.1f %10.1f\n", (double)latency.p99_ns * 1e-3, (double)latency.max_ns * 1e-3);
+    }
+}
+
+bool iq_profile_write_json(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot write profile %s\n", path);
+        return false;
+    }
+    pthread_mutex_lock(&profile_lock);
+    const uint32_t threads = profile_threads;
+    pthread_mutex_unlock(&profile_lock);
+
+    fprintf(f, "{\n  \"tool\": \"%s\",\n  \"wall_seconds\": %.6f,\n  \"threads\": %u,\n  \"stages\": [",
+            profile_tool[0] ? profile_tool : "iq_lab", iq_profile_wall_seconds(), threads);
+    bool first = true;
+    for (int s = 0; s < IQ_PROFILE_STAGE_COUNT; s++) {
+        iq_profile_totals_t t;
+        iq_profile_get((iq_profile_stage_t)s, &t);
+        if (t.calls == 0) continue;
+        iq_latency_t latency;
+        iq_profile_latency((iq_profile_stage_t)s, &latency);
+        fprintf(f, "%s\n    {\"stage\": \"%s\", \"calls\": %llu, \"seconds\": %.6f, \"threads\": %u, "
+                   "\"items\": %llu, \"bytes\": %llu, \"p50_seconds\": %.9f, \"p99_seconds\": %.9f, "
+                   "\"max_seconds\": %.9f}",
+                first ? "" : ",", stage_names[s], (unsigned long long)t.calls, (double)t.ns * 1e-9,
+                t.threads, (unsigned long long)t.items, (unsigned long long)t.bytes,
+                (double)latency.p50_ns * 1e-9, (double)latency.p99_ns * 1e-9, (double)latency.max_ns * 1e-9);
+        first = false;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+void iq_trace_thread_name(const char *name) {
+    if (!iq_profile_enabled()) return;    // No block for threads of unprofiled runs
+    iq_profile_block_t *block = iq_profile_thread_block();
+    if (!block || !name) return;
+    pthread_mutex_lock(&profile_lock);
+    snprintf(block->name, sizeof(block->name), "%s", name);
+    pthread_mutex_unlock(&profile_lock);
+}
+
+void iq_trace_span(const char *name, const char *track, uint64_t start, uint64_t end) {
+    if (!atomic_load_explicit(&trace_on, memory_order_relaxed) || !name) return;
+    iq_profile_block_t *block = iq_profile_thread_block();
+    if (!block) return;
+
+    pthread_mutex_lock(&profile_lock);
+    if (trace_span_count == trace_span_capacity && trace_span_capacity < IQ_TRACE_MAX_SPANS) {
+        size_t capacity = trace_span_capacity ? trace_span_capacity * 2 : 64;
+        iq_trace_span_t *spans = realloc(trace_spans, capacity * sizeof(*spans));
+        if (spans) {
+            trace_spans = spans;
+            trace_span_capacity = capacity;
+        }
+    }
+    if (trace_span_count < trace_span_capacity) {
+        iq_trace_span_t *span = &trace_spans[trace_span_count++];
+        snprintf(span->name, sizeof(span->name), "%s", name);
+        snprintf(span->track, sizeof(span->track), "%s", track ? track : "");
+        span->tid = block->id;
+        span->start = start;
+        span->ns = end > start ? end - start : 0;
+    } else {
+        trace_spans_dropped++;
+    }
+    pthread_mutex_unlock(&profile_lock);
+}
+
+// JSON string contents; names come from tool arguments and YAML steps
+static void iq_trace_write_string(FILE *f, const char *text) {
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++) {
+        if (*c == '"' || *c == '\\') fprintf(f, "\\%c", *c);
+        else if (*c < 0x20) fprintf(f, "\\u%04x", *c);
+        else fputc(*c, f);
+    }
+}
+
+static double iq_trace_us(uint64_t t) {
+    return t > profile_epoch_ns ? (double)(t - profile_epoch_ns) * 1e-3 : 0.0;
+}
+
+static void iq_trace_write_thread_name(FILE *f, uint32_t tid, const char *name) {
+    fprintf(f, ",\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"", tid);
+    iq_trace_write_string(f, name);
+    fprintf(f, "\"}}");
+}
+
+// Track index of a named span track, adding it to 'tracks' if new
+static uint32_t iq_trace_track_index(const char **tracks, uint32_t *count, const char *track) {
+    for (uint32_t t = 0; t < *count; t++) {
+        if (strcmp(tracks[t], track) == 0) return t;
+    }
+    tracks[*count] = track;
+    return (*count)++;
+}
+
+bool iq_trace_write_json(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot write trace %s\n", path);
+        return false;
+    }
+
+    pthread_mutex_lock(&profile_lock);
+    uint64_t dropped = trace_spans_dropped;
+    for (iq_profile_block_t *b = profile_blocks; b; b = b->next) {
+        uint64_t head = atomic_load_explicit(&b->ring_head, memory_order_acquire);
+        if (head > IQ_TRACE_RING_EVENTS) dropped += head - IQ_TRACE_RING_EVENTS;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\": \"ms\",\n\"otherData\": {\"tool\": \"");
+    iq_trace_write_string(f, profile_tool[0] ? profile_tool : "iq_lab");
+    fprintf(f, "\", \"dropped_events\": %llu},\n\"traceEvents\": [\n", (unsigned long long)dropped);
+    fprintf(f, "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"");
+    iq_trace_write_string(f, profile_tool[0] ? profile_tool : "iq_lab");
+    fprintf(f, "\"}}");
+
+    for (iq_profile_block_t *b = profile_blocks; b; b = b->next) {
+        char name[IQ_TRACE_NAME_SIZE];
+        if (b->name[0]) snprintf(name, sizeof(name), "%s", b->name);
+        else snprintf(name, sizeof(name), "thread %u", b->id);
+        iq_trace_write_thread_name(f, b->id, name);
+
+        uint64_t head = atomic_load_explicit(&b->ring_head, memory_order_acquire);
+        if (!b->ring) continue;
+        uint64_t first = head > IQ_TRACE_RING_EVENTS ? head - IQ_TRACE_RING_EVENTS : 0;
+        for (uint64_t e = first; e < head; e++) {
+            const iq_trace_event_t *event = &b->ring[e % IQ_TRACE_RING_EVENTS];
+            fprintf(f, ",\n{\"ph\": \"X\", \"cat\": \"stage\", \"name\": \"%s\", \"pid\": 1, \"tid\": %u, "
+                       "\"ts\": %.3f, \"dur\": %.3f}",
+                    iq_profile_stage_name((iq_profile_stage_t)event->stage), b->id,
+                    iq_trace_us(event->start), (double)event->ns * 1e-3);
+        }
+    }
+
+    // Spans on a track of their own get one tid per track name
+    const char **tracks = trace_span_count ? malloc(trace_span_count * sizeof(*tracks)) : NULL;
+    uint32_t track_count = 0;
+    for (size_t s = 0; s < trace_span_count; s++) {
+        const iq_trace_span_t *span = &trace_spans[s];
+        uint32_t tid = span->tid;
+        if (span->track[0] && tracks) {
+            uint32_t before = track_count;
+            tid = IQ_TRACE_TRACK_TID + iq_trace_track_index(tracks, &track_count, span->track);
+            if (track_count > before) iq_trace_write_thread_name(f, tid, span->track);
+        }
+        fprintf(f, ",\n{\"ph\": \"X\", \"cat\": \"span\", \"name\": \"");
+        iq_trace_write_string(f, span->name);
+        fprintf(f, "\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                tid, iq_trace_us(span->start), (double)span->ns * 1e-3);
+    }
+    free(tracks);
+    pthread_mutex_unlock(&profile_lock);
+
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+static void iq_profile_report(void) {
+    if (trace_json) iq_trace_write_json(trace_json);
+    if (!profile_counters) return;
+    if (profile_json) {
+        iq_profile_write_json(profile_json);
+    } else {
+        iq_profile_print(stderr);
+    }
+}
+
+static char *iq_profile_strdup(const char *text) {
+    size_t length = strlen(text) + 1;
+    char *copy = malloc(length);
+    if (copy) memcpy(copy, text, length);
+    return copy;
+}
+
+// First start of either kind: name the tool, the epoch and the exit report
+// (profile_lock held)
+static bool iq_profile_enable(const char *tool) {
+    if (!profile_exit_registered) {
+        snprintf(profile_tool, sizeof(profile_tool), "%s", tool ? tool : "iq_lab");
+        profile_epoch_ns = iq_profile_now();
+        if (atexit(iq_profile_report) != 0) {
+            fprintf(stderr, "Error: Cannot register the profile report\n");
+            return false;
+        }
+        profile_exit_registered = true;
+    }
+    atomic_store_explicit(&iq_profile_on, true, memory_order_relaxed);
+    return true;
+}
+
+bool iq_profile_start(const char *tool, const char *json_path) {
+    pthread_mutex_lock(&profile_lock);
+    bool ok = true;
+    if (!profile_counters) {
+        ok = iq_profile_enable(tool);
+        if (ok) {
+            if (json_path && json_path[0]) profile_json = iq_profile_strdup(json_path);
+            profile_start_ns = iq_profile_now();
+            profile_counters = true;
+        }
+    }
+    pthread_mutex_unlock(&profile_lock);
+    return ok;
+}
+
+bool iq_profile_collect(const char *tool) {
+    pthread_mutex_lock(&profile_lock);
+    bool ok = iq_profile_enable(tool);
+    pthread_mutex_unlock(&profile_lock);
+    return ok;
+}
+
+bool iq_trace_start(const char *tool, const char *json_path) {
+    if (!json_path || !json_path[0]) {
+        fprintf(stderr, "Error: --trace needs an output file (--trace=<file.json>)\n");
+        return false;
+    }
+    pthread_mutex_lock(&profile_lock);
+    bool ok = true;
+    if (!atomic_load_explicit(&trace_on, memory_order_relaxed)) {
+        trace_json = iq_profile_strdup(json_path);
+        ok = trace_json && iq_profile_enable(tool);
+        if (ok) atomic_store_explicit(&trace_on, true, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&profile_lock);
+
+    // The thread that starts the trace is "main" unless it has a name
+    iq_profile_block_t *block = ok ? iq_profile_thread_block() : NULL;
+    if (block) {
+        pthread_mutex_lock(&profile_lock);
+        if (!block->name[0]) snprintf(block->name, sizeof(block->name), "main");
+        pthread_mutex_unlock(&profile_lock);
+    }
+    return ok;
+}
+
+bool iq_profile_parse_arg(const char *tool, const char *arg) {
+    if (!arg) return false;
+    if (strncmp(arg, "--trace=", 8) == 0) {
+        iq_trace_start(tool, arg + 8);
+        return true;
+    }
+    if (strncmp(arg, "--profile", 9) != 0) return false;
+    if (arg[9] != '\0' && arg[9] != '=') return false;
+    iq_profile_start(tool, arg[9] == '=' ? arg + 10 : NULL);
+    return true;
+}
@@ -0,0 +1,169 @@
+#ifndef IQ_PROFILE_H
+#define IQ_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+/*
+ * Hot-path profiling counters
+ * A tool started with --profile times its stages with begin/end pairs:
+ *
+ *   uint64_t t = iq_profile_begin();
+ *   ... run the stage on 'count' samples ...
+ *   iq_profile_end(IQ_PROFILE_FFT, t, count, bytes);
+ *
+ * Each thread adds calls, nanoseconds, items and bytes to counters of its
+ * own (registered on first use, so no thread ever waits on another), and
+ * the totals are merged when the report is printed at exit. Stages may
+ * nest: a stage's time includes whatever it calls, and threads running in
+ * parallel can add up to more than the wall time.
+ *
+ * While profiling is off both calls are a relaxed load and a branch, and
+ * iq_profile_begin() does not read the clock.
+ *
+ * With --trace=<file.json> every timed call is also kept as an event in a
+ * ring of its thread (the latest IQ_TRACE_RING_EVENTS per thread) and the
+ * rings are written as Chrome trace-event JSON at exit, one track per
+ * thread, for chrome://tracing or ui.perfetto.dev. Time a thread spends
+ * blocked on a queue is the "wait" stage, so stalls between stages show
+ * as gaps filled with waits.
+ *
+ * Each stage also keeps a log-scale histogram of its call times, for the
+ * p50 / p99 / max latencies in the report and in the real-time monitor.
+ */
+
+#define IQ_TRACE_RING_EVENTS 65536   // Events kept per thread, oldest dropped first
+#define IQ_TRACE_MAX_SPANS 65536     // Named spans kept per process
+
+// Latency histogram: four buckets per power of two (about 19% apart) up to
+// 2^48 ns, so a percentile is within half a bucket of the true value
+#define IQ_LATENCY_BUCKETS 192
+
+typedef enum {
+    IQ_PROFILE_READ,          // File and decompression I/O
+    IQ_PROFILE_CONVERT,       // Raw to float conversion
+    IQ_PROFILE_FFT,           // STFT / FFT frames
+    IQ_PROFILE_CFAR,          // CFAR thresholds and detections
+    IQ_PROFILE_CLUSTER,       // Detection clustering and event output
+    IQ_PROFILE_CHANNELIZE,    // Polyphase filter bank / DDC
+    IQ_PROFILE_FILTER,        // Frequency translation and decimation
+    IQ_PROFILE_DEMOD,         // Demodulators (with AGC)
+    IQ_PROFILE_RESAMPLE,      // Rate conversion
+    IQ_PROFILE_ENCODE,        // PNG / WAV / CSV / NPY encoding
+    IQ_PROFILE_WRITE,         // Output file I/O
+    IQ_PROFILE_WAIT,          // Blocked on a queue, the reader or the writers
+    IQ_PROFILE_STAGE_COUNT
+} iq_profile_stage_t;
+
+// Merged totals of one stage
+typedef struct {
+    uint64_t calls;
+    uint64_t ns;
+    uint64_t items;
+    uint64_t bytes;
+    uint32_t threads;         // Threads that recorded this stage
+} iq_profile_totals_t;
+
+// Latency percentiles of a histogram
+typedef struct {
+    uint64_t count;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+} iq_latency_t;
+
+// Written by one thread at a time; read by any (relaxed atomics)
+typedef struct {
+    atomic_uint_fast64_t counts[IQ_LATENCY_BUCKETS];
+    atomic_uint_fast64_t max_ns;
+} iq_latency_hist_t;
+
+extern atomic_bool iq_profile_on;
+
+// Monotonic clock in nanoseconds
+uint64_t iq_profile_now(void);
+
+// Add one call timed from 'start' to 'end' to the calling thread's counters
+// (and its trace ring while tracing)
+void iq_profile_record(iq_profile_stage_t stage, uint64_t start, uint64_t end,
+                       uint64_t items, uint64_t bytes);
+
+static inline bool iq_profile_enabled(void) {
+    return atomic_load_explicit(&iq_profile_on, memory_order_relaxed);
+}
+
+static inline uint64_t iq_profile_begin(void) {
+    return iq_profile_enabled() ? iq_profile_now() : 0;
+}
+
+// A begin taken before profiling started (start 0) is not recorded
+static inline void iq_profile_end(iq_profile_stage_t stage, uint64_t start, uint64_t items, uint64_t bytes) {
+    if (iq_profile_enabled() && start != 0) iq_profile_record(stage, start, iq_profile_now(), items, bytes);
+}
+
+/*
+ * Start profiling for 'tool' and report at exit: a table on stderr, or
+ * JSON to 'json_path' when it is not NULL. Later calls (tools run by
+ * iqjob in its own process) keep the first tool name and output.
+ * Returns false if the exit handler cannot be registered.
+ */
+bool iq_profile_start(const char *tool, const char *json_path);
+
+/*
+ * Record a trace of 'tool' and write it to 'json_path' at exit (Chrome
+ * trace-event format). Later calls keep the first trace. Returns false
+ * without a path or if the exit handler cannot be registered.
+ */
+bool iq_trace_start(const char *tool, const char *json_path);
+
+// Name the calling thread's track in the trace ("reader", "fft 2", ...);
+// a no-op unless profiling or tracing has started
+void iq_trace_thread_name(const char *name);
+
+/*
+ * Add a named span from 'start' to 'end' (iq_profile_now() times) to the
+ * trace: on the calling thread's track, or on its own track 'track' (e.g.
+ * one per iqjob step, for work done by child processes). Ignored unless
+ * tracing.
+ */
+void iq_trace_span(const char *name, const char *track, uint64_t start, uint64_t end);
+
+/*
+ * Record stage counters without an exit report, for callers that read them
+ * while running (the real-time monitor). Returns false if the exit handler
+ * for a later trace cannot be registered.
+ */
+bool iq_profile_collect(const char *tool);
+
+/*
+ * Handle a "--profile", "--profile=<file.json>" or "--trace=<file.json>"
+ * argument for tools that parse their own argv; returns false for any
+ * other argument.
+ */
+bool iq_profile_parse_arg(const char *tool, const char *arg);
+
+// Stage name as printed in reports ("read", "fft", ...)
+const char *iq_profile_stage_name(iq_profile_stage_t stage);
+
+// Sum every thread's counters for 'stage'
+void iq_profile_get(iq_profile_stage_t stage, iq_profile_totals_t *totals);
+
+// Merge every thread's latency histogram of 'stage'
+void iq_profile_latency(iq_profile_stage_t stage, iq_latency_t *latency);
+
+// Add one measurement (only one thread may add to a histogram at a time)
+void iq_latency_add(iq_latency_hist_t *hist, uint64_t ns);
+
+// Percentiles of one histogram
+void iq_latency_get(const iq_latency_hist_t *hist, iq_latency_t *latency);
+
+// Print the per-stage breakdown, or write it as JSON
+void iq_profile_print(FILE *out);
+bool iq_profile_write_json(const char *path);
+
+// Write the trace recorded so far
+bool iq_trace_write_json(const char *path);
+
+#endif // IQ_PROFILE_H
@@ -0,0 +1,184 @@
+/*
+ * IQ Lab - Streaming PSD accumulator
+ *
+ * Each bin is updated frame by frame in file order, and a mean's sum keeps
+ * a Kahan carry next to it, so folding the same rows in any split of bin
+ * ranges gives the same bits.
+ */
+
+#include "psd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define PSD_DB_FLOOR 1e-12      // Added before log10, as fft_spectral_frame does
+
+static const char *const psd_average_names[] = { "linear", "log", "ema", "max" };
+
+// Kahan step: add x to *sum, carrying the rounding error in *carry
+static inline void psd_kahan_add(double *sum, double *carry, double x) {
+    double y = x - *carry;
+    double t = *sum + y;
+    *carry = (t - *sum) - y;
+    *sum = t;
+}
+
+bool psd_init(psd_t *psd, uint32_t bins, psd_average_t average, double alpha) {
+    memset(psd, 0, sizeof(*psd));
+    if (bins == 0 || average > PSD_AVG_MAX) {
+        fprintf(stderr, "Error: Invalid PSD accumulator (%u bins)\n", bins);
+        return false;
+    }
+    if (average == PSD_AVG_EMA && !(alpha > 0.0 && alpha <= 1.0)) {
+        fprintf(stderr, "Error: EMA weight must be in (0, 1], got %g\n", alpha);
+        return false;
+    }
+
+    psd->value = calloc(bins, sizeof(double));
+    psd->carry = calloc(bins, sizeof(double));
+    if (!psd->value || !psd->carry) {
+        fprintf(stderr, "Error: Failed to allocate a %u-bin PSD\n", bins);
+        psd_free(psd);
+        return false;
+    }
+    psd->bins = bins;
+    psd->average = average;
+    psd->alpha = alpha;
+    psd->decay = 1.0;
+    return true;
+}
+
+void psd_reset(psd_t *psd) {
+    if (!psd || !psd->value) return;
+    memset(psd->value, 0, (size_t)psd->bins * sizeof(double));
+    memset(psd->carry, 0, (size_t)psd->bins * sizeof(double));
+    psd->decay = 1.0;
+    psd->frames = 0;
+}
+
+void psd_free(psd_t *psd) {
+    if (!psd) return;
+    free(psd->value);
+    free(psd->carry);
+    psd->value = NULL;
+    psd->carry = NULL;
+    psd->bins = 0;
+    psd->frames = 0;
+}
+
+void psd_add_range(psd_t *psd, const float *rows, uint32_t num_frames, uint32_t begin, uint32_t end) {
+    if (!psd || !psd->value || !rows) return;
+    if (end > psd->bins) end = psd->bins;
+
+    double *value = psd->value;
+    double *carry = psd->carry;
+    const size_t stride = psd->bins;
+    for (uint32_t f = 0; f < num_frames; f++) {
+        const float *row = rows + (size_t)f * stride;
+        switch (psd->average) {
+        case PSD_AVG_LINEAR:
+            for (uint32_t k = begin; k < end; k++) psd_kahan_add(&value[k], &carry[k], row[k]);
+            break;
+        case PSD_AVG_LOG:
+            for (uint32_t k = begin; k < end; k++) {
+                psd_kahan_add(&value[k], &carry[k], 10.0 * log10((double)row[k] + PSD_DB_FLOOR));
+            }
+            break;
+        case PSD_AVG_EMA:
+            for (uint32_t k = begin; k < end; k++) value[k] += psd->alpha * ((double)row[k] - value[k]);
+            break;
+        case PSD_AVG_MAX:
+            for (uint32_t k = begin; k < end; k++) {
+                if (row[k] > value[k]) value[k] = row[k];
+            }
+            break;
+        }
+    }
+}
+
+void psd_advance(psd_t *psd, uint32_t num_frames) {
+    if (!psd) return;
+    if (psd->average == PSD_AVG_EMA) {
+        for (uint32_t f = 0; f < num_frames; f++) psd->decay *= 1.0 - psd->alpha;
+    }
+    psd->frames += num_frames;
+}
+
+void psd_add_rows(psd_t *psd, const float *rows, uint32_t num_frames) {
+    if (!psd) return;
+    psd_add_range(psd, rows, num_frames, 0, psd->bins);
+    psd_advance(psd, num_frames);
+}
+
+bool psd_merge(psd_t *dst, const psd_t *later) {
+    if (!dst || !later || !dst->value || !later->value || dst->bins != later->bins ||
+        dst->average != later->average || dst->alpha != later->alpha) {
+        fprintf(stderr, "Error: PSD accumulators do not match\n");
+        return false;
+    }
+
+    for (uint32_t k = 0; k < dst->bins; k++) {
+        switch (dst->average) {
+        case PSD_AVG_LINEAR:
+        case PSD_AVG_LOG:
+            // later's sum is value - carry; keep both parts
+            psd_kahan_add(&dst->value[k], &dst->carry[k], later->value[k]);
+            psd_kahan_add(&dst->value[k], &dst->carry[k], -later->carry[k]);
+            break;
+        case PSD_AVG_EMA:
+            // later started from zero: dst's state has decayed through its frames
+            dst->value[k] = dst->value[k] * later->decay + later->value[k];
+            break;
+        case PSD_AVG_MAX:
+            if (later->value[k] > dst->value[k]) dst->value[k] = later->value[k];
+            break;
+        }
+    }
+    dst->decay *= later->decay;
+    dst->frames += later->frames;
+    return true;
+}
+
+bool psd_result(const psd_t *psd, double *out, bool db) {
+    if (!psd || !psd->value || !out || psd->frames == 0) return false;
+
+    const double frames = (double)psd->frames;
+    const double weight = 1.0 - psd->decay;
+    for (uint32_t k = 0; k < psd->bins; k++) {
+        double v;
+        switch (psd->average) {
+        case PSD_AVG_LOG:
+            v = (psd->value[k] - psd->carry[k]) / frames;
+            out[k] = db ? v : pow(10.0, v / 10.0);
+            continue;
+        case PSD_AVG_EMA:
+            v = weight > 0.0 ? psd->value[k] / weight : psd->value[k];
+            break;
+        case PSD_AVG_MAX:
+            v = psd->value[k];
+            break;
+        case PSD_AVG_LINEAR:
+        default:
+            v = (psd->value[k] - psd->carry[k]) / frames;
+            break;
+        }
+        out[k] = db ? 10.0 * log10(v + PSD_DB_FLOOR) : v;
+    }
+    return true;
+}
+
+const char *psd_average_name(psd_average_t average) {
+    return average <= PSD_AVG_MAX ? psd_average_names[average] : "unknown";
+}
+
+bool psd_average_from_name(const char *name, psd_average_t *average) {
+    if (!name) return false;
+    for (size_t i = 0; i < sizeof(psd_average_names) / sizeof(psd_average_names[0]); i++) {
+        if (strcmp(name, psd_average_names[i]) == 0) {
+            *average = (psd_average_t)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,89 @@
+#ifndef IQ_PSD_H
+#define IQ_PSD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Streaming power spectral density accumulator
+ * Folds spectral rows (linear power per bin, as fft_spectral_frame and
+ * stft_rows produce them) into one spectrum. With rows from windowed,
+ * overlapping frames (stft_rows with a window and hop < N) the linear mean
+ * is Welch's estimate; the other modes trade it for tracking or peaks:
+ *
+ *   PSD_AVG_LINEAR  mean of linear power (Welch)
+ *   PSD_AVG_LOG     mean of dB values: less pulled up by bursts
+ *   PSD_AVG_EMA     exponential moving average, weight alpha per new frame
+ *   PSD_AVG_MAX     max-hold
+ *
+ * Means are sums with Kahan compensation per bin, so a long capture loses
+ * nothing to rounding. EMA starts from zero and divides the start's weight
+ * back out on readout, so early frames are not biased toward zero.
+ *
+ * Parallel use: rows may be folded one bin range at a time
+ * (psd_add_range, then psd_advance once per batch), which is how the STFT
+ * pool splits stft_accumulate_psd; every bin still sees its frames in
+ * order, so the result does not depend on the thread count. Partial PSDs
+ * over consecutive stretches of a capture combine with psd_merge, the later
+ * stretch merged into the earlier one.
+ */
+
+typedef enum {
+    PSD_AVG_LINEAR = 0,
+    PSD_AVG_LOG,
+    PSD_AVG_EMA,
+    PSD_AVG_MAX
+} psd_average_t;
+
+typedef struct {
+    uint32_t bins;
+    psd_average_t average;
+    double alpha;           // EMA weight of a new frame
+    double *value;          // Per bin: sum of power or dB, EMA state or peak
+    double *carry;          // Kahan compensation of the sums (means only)
+    double decay;           // EMA: weight still on the zero start, (1 - alpha)^frames
+    uint64_t frames;
+} psd_t;
+
+/*
+ * Accumulator for 'bins' bins; 'alpha' in (0, 1] is used by PSD_AVG_EMA only
+ * Returns false (with a message on stderr) on bad arguments or no memory.
+ */
+bool psd_init(psd_t *psd, uint32_t bins, psd_average_t average, double alpha);
+
+// Forget every frame
+void psd_reset(psd_t *psd);
+
+// Free the per-bin state
+void psd_free(psd_t *psd);
+
+// Fold 'num_frames' rows of psd->bins values, oldest first
+void psd_add_rows(psd_t *psd, const float *rows, uint32_t num_frames);
+
+/*
+ * Fold bins [begin, end) of 'num_frames' rows; once every range of a batch
+ * is in, psd_advance(num_frames) counts the frames
+ */
+void psd_add_range(psd_t *psd, const float *rows, uint32_t num_frames, uint32_t begin, uint32_t end);
+void psd_advance(psd_t *psd, uint32_t num_frames);
+
+/*
+ * Combine 'later' (frames that follow dst's) into 'dst'
+ * Both need the same bins, mode and alpha; returns false otherwise.
+ */
+bool psd_merge(psd_t *dst, const psd_t *later);
+
+/*
+ * The estimate per bin, in linear power or dB (10 log10(p + 1e-12), as in
+ * the rest of iq_lab). Returns false before the first frame.
+ */
+bool psd_result(const psd_t *psd, double *out, bool db);
+
+// "linear", "log", "ema", "max"
+const char *psd_average_name(psd_average_t average);
+
+// Parse one of the names above
+bool psd_average_from_name(const char *name, psd_average_t *average);
+
+#endif // IQ_PSD_H
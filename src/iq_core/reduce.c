@@ -0,0 +1,112 @@
+/*
+ * IQ Lab - Deterministic parallel reductions
+ *
+ * A double is m * 2^e with a 53-bit integer m and e >= -1126 after
+ * frexp's normalisation, so adding it to the accumulator is adding m,
+ * shifted, into at most three 32-bit digits. Digits are signed 64-bit, so
+ * each can absorb 2^31 such adds before the carries must be pushed up;
+ * normalisation does that every REDUCE_NORMALIZE_EVERY adds and before a
+ * read. A normalised accumulator is unique for its value, which is what
+ * makes the rounded result independent of the order of the adds.
+ */
+
+#include "reduce.h"
+#include <string.h>
+#include <math.h>
+
+#define REDUCE_BIAS 1126                  // Exponent of digit 0
+#define REDUCE_NORMALIZE_EVERY (1u << 30)
+#define REDUCE_POS_INF 1u
+#define REDUCE_NEG_INF 2u
+#define REDUCE_NAN 4u
+
+uint64_t reduce_split(uint64_t total, uint32_t parts, uint32_t index) {
+    if (parts == 0 || index >= parts) return total;
+    uint64_t chunks = (total + REDUCE_CHUNK_SAMPLES - 1) / REDUCE_CHUNK_SAMPLES;
+    uint64_t start = chunks * index / parts * REDUCE_CHUNK_SAMPLES;
+    return start < total ? start : total;
+}
+
+void reduce_sum_init(reduce_sum_t *sum) {
+    memset(sum, 0, sizeof(*sum));
+}
+
+// Carry every digit into the next: all but the top end up in [0, 2^32)
+static void reduce_normalize(reduce_sum_t *sum) {
+    for (int k = 0; k + 1 < REDUCE_DIGITS; k++) {
+        int64_t low = (int64_t)((uint64_t)sum->digit[k] & 0xFFFFFFFFu);
+        int64_t carry = (sum->digit[k] - low) / 4294967296LL;
+        sum->digit[k] = low;
+        sum->digit[k + 1] += carry;
+    }
+    sum->pending = 0;
+}
+
+void reduce_sum_add(reduce_sum_t *sum, double value) {
+    if (value == 0.0) return;
+    if (!isfinite(value)) {
+        sum->special |= isnan(value) ? REDUCE_NAN : value > 0.0 ? REDUCE_POS_INF : REDUCE_NEG_INF;
+        return;
+    }
+    if (sum->pending >= REDUCE_NORMALIZE_EVERY) reduce_normalize(sum);
+
+    int exponent;
+    double fraction = frexp(value, &exponent);      // value = fraction * 2^exponent, |fraction| in [0.5, 1)
+    int64_t mantissa = (int64_t)ldexp(fraction, 53); // Exact: 53 significant bits
+    uint64_t magnitude = (uint64_t)(mantissa < 0 ? -mantissa : mantissa);
+    int position = exponent - 53 + REDUCE_BIAS;
+    int k = position / 32, shift = position % 32;
+
+    int64_t parts[3];
+    parts[0] = (int64_t)((magnitude << shift) & 0xFFFFFFFFu);
+    uint64_t rest = shift ? magnitude >> (32 - shift) : magnitude >> 32;
+    parts[1] = (int64_t)(rest & 0xFFFFFFFFu);
+    parts[2] = (int64_t)(rest >> 32);
+    for (int j = 0; j < 3; j++) {
+        sum->digit[k + j] += mantissa < 0 ? -parts[j] : parts[j];
+    }
+    sum->pending++;
+}
+
+void reduce_sum_merge(reduce_sum_t *into, const reduce_sum_t *from) {
+    reduce_sum_t other = *from;
+    if (into->pending >= REDUCE_NORMALIZE_EVERY / 2) reduce_normalize(into);
+    if (other.pending >= REDUCE_NORMALIZE_EVERY / 2) reduce_normalize(&other);
+    for (int k = 0; k < REDUCE_DIGITS; k++) into->digit[k] += other.digit[k];
+    into->pending += other.pending;
+    into->special |= other.special;
+}
+
+double reduce_sum_value(const reduce_sum_t *sum) {
+    if (sum->special & REDUCE_NAN || (sum->special & REDUCE_POS_INF && sum->special & REDUCE_NEG_INF)) {
+        return NAN;
+    }
+    if (sum->special) return sum->special & REDUCE_POS_INF ? INFINITY : -INFINITY;
+
+    reduce_sum_t exact = *sum;
+    reduce_normalize(&exact);
+
+    // Work on the magnitude so every digit is in [0, 2^32)
+    bool negative = exact.digit[REDUCE_DIGITS - 1] < 0;
+    if (negative) {
+        for (int k = 0; k < REDUCE_DIGITS; k++) exact.digit[k] = -exact.digit[k];
+        reduce_normalize(&exact);
+    }
+    int top = REDUCE_DIGITS - 1;
+    while (top > 0 && exact.digit[top] == 0) top--;
+    if (exact.digit[top] == 0) return 0.0;
+
+    // The 64 bits from the leading one, with a sticky bit for any below
+    // them, convert to double with a single correct rounding
+    uint64_t digits[3] = {0, 0, 0};
+    for (int j = 0; j < 3 && top - j >= 0; j++) digits[j] = (uint64_t)exact.digit[top - j];
+    int lead = 0;
+    while (lead < 32 && (digits[0] >> lead) != 0) lead++;
+    uint64_t window = digits[0] << (64 - lead) | digits[1] << (32 - lead) | digits[2] >> lead;
+    bool sticky = (digits[2] & ((1ull << lead) - 1)) != 0;
+    for (int k = top - 3; k >= 0 && !sticky; k--) sticky = exact.digit[k] != 0;
+    if (sticky) window |= 1;
+
+    double value = ldexp((double)window, 32 * top - REDUCE_BIAS + lead - 64);
+    return negative ? -value : value;
+}
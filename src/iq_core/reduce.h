@@ -0,0 +1,61 @@
+#ifndef IQ_REDUCE_H
+#define IQ_REDUCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Deterministic parallel reductions
+ *
+ * Floating-point addition is not associative, so a sum split over threads
+ * and merged comes out with different last bits for each thread count.
+ * Two rules make a parallel reduction give the same bits for -j1 and -j64:
+ *
+ *   1. Fixed chunks: work is cut at multiples of REDUCE_CHUNK_SAMPLES of
+ *      the whole input (reduce_split), never at thread boundaries, and each
+ *      chunk is summed the same way on whichever thread gets it.
+ *   2. Exact accumulation: chunk results are added into a reduce_sum_t, a
+ *      fixed-point accumulator wide enough to hold any sum of doubles
+ *      without rounding. Adding and merging are exact, hence associative
+ *      and commutative: any split, any merge order, same value.
+ *
+ * The value is rounded to double only once, from the exact sum, so it is
+ * also more accurate than a running double sum. Adding costs a few integer
+ * operations, so callers add per chunk, not per sample.
+ *
+ * Usage:
+ *   worker i: for chunks c in [reduce_split(n, k, i), reduce_split(n, k, i+1)):
+ *                 reduce_sum_add(&part[i], sum of chunk c);
+ *   then:     for each i: reduce_sum_merge(&total, &part[i]);
+ *             reduce_sum_value(&total);
+ *
+ * Thread Safety: one thread per accumulator; merge after joining
+ */
+
+// Samples per fixed chunk of a parallel reduction
+#define REDUCE_CHUNK_SAMPLES 4096
+
+// 32-bit digits covering every finite double, with room for carries
+#define REDUCE_DIGITS 70
+
+typedef struct {
+    int64_t digit[REDUCE_DIGITS];   // Value = sum of digit[k] * 2^(32k - 1126)
+    uint32_t pending;               // Adds since digits were last normalized
+    uint32_t special;               // Infinities and NaNs seen
+} reduce_sum_t;
+
+// Start of part 'index' of 'parts' over [0, total), on a chunk boundary
+uint64_t reduce_split(uint64_t total, uint32_t parts, uint32_t index);
+
+void reduce_sum_init(reduce_sum_t *sum);
+
+// Add one value exactly (infinities and NaN propagate as in IEEE addition)
+void reduce_sum_add(reduce_sum_t *sum, double value);
+
+// Add another accumulator into 'into'
+void reduce_sum_merge(reduce_sum_t *into, const reduce_sum_t *from);
+
+// The exact sum rounded to double
+double reduce_sum_value(const reduce_sum_t *sum);
+
+#endif // IQ_REDUCE_H
@@ -1,4 +1,5 @@
 #include "resample.h"
+#include "window.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -7,127 +8,362 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// Independent accumulators in the polyphase dot product (one AVX register)
+#define RESAMPLE_LANES 8
+
+// Inputs pre-decimated per pass
+#define RESAMPLE_BLOCK_SAMPLES 4096
+
+// Default filter: 32 periods of the lower rate, cutoff at 0.4 of it
+#define RESAMPLE_DEFAULT_LENGTH 32
+#define RESAMPLE_DEFAULT_CUTOFF 0.4f
+
+static bool init_planned(resample_t *resampler, uint32_t input_rate, uint32_t output_rate,
+                         uint32_t channels);
+
 // Initialize resampler with default parameters
 bool resample_init(resample_t *resampler, uint32_t input_rate, uint32_t output_rate) {
-    // Use reasonable defaults for audio resampling
-    return resample_init_custom(resampler, input_rate, output_rate, 32, 0.4f);
+    return init_planned(resampler, input_rate, output_rate, 1);
 }
 
-// Initialize resampler with custom parameters
-bool resample_init_custom(resample_t *resampler, uint32_t input_rate, uint32_t output_rate,
-                         uint32_t filter_length, float cutoff_freq) {
+static uint32_t gcd_u32(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// L / M for output_rate / input_rate: lowest terms, or the last continued
+// fraction convergent with L <= RESAMPLE_MAX_PHASES
+static void rational_ratio(uint32_t input_rate, uint32_t output_rate, uint32_t *L, uint32_t *M) {
+    uint32_t g = gcd_u32(input_rate, output_rate);
+    *L = output_rate / g;
+    *M = input_rate / g;
+    if (*L <= RESAMPLE_MAX_PHASES) return;
+
+    uint64_t num = output_rate, den = input_rate;
+    uint64_t p0 = 0, q0 = 1, p1 = 1, q1 = 0;            // Convergents h(-2), h(-1)
+    while (den != 0) {
+        uint64_t a = num / den;
+        uint64_t p2 = a * p1 + p0, q2 = a * q1 + q0;
+        if (p2 > RESAMPLE_MAX_PHASES) break;
+        p0 = p1; q0 = q1; p1 = p2; q1 = q2;
+        uint64_t r = num % den;
+        num = den;
+        den = r;
+    }
+    if (p1 == 0) {                                      // Ratio below 1 / RESAMPLE_MAX_PHASES
+        p1 = 1;
+        q1 = (uint64_t)llround((double)input_rate / output_rate);
+    }
+    *L = (uint32_t)p1;
+    *M = (uint32_t)q1;
+}
+
+// Taps per phase covering filter_length periods of the lower rate, rounded
+// up to whole lanes of the dot product
+static uint32_t phase_taps(uint32_t L, uint32_t M, uint32_t filter_length) {
+    const uint32_t period = L > M ? L : M;
+    uint32_t taps = (uint32_t)(((uint64_t)filter_length * period + L - 1) / L);
+    return (taps + RESAMPLE_LANES - 1) / RESAMPLE_LANES * RESAMPLE_LANES;
+}
+
+// Tap n of the windowed-sinc prototype with cutoff fc (cycles per sample)
+static double prototype_tap(const window_t *window, double fc, uint32_t n) {
+    double x = n - (window->size - 1) / 2.0;
+    double h = fabs(x) < 1e-10 ? 2.0 * fc : sin(2.0 * M_PI * fc * x) / (M_PI * x);
+    return h * window->coefficients[n];
+}
+
+/**
+ * @brief Design the sub-filters and delay line for 1 (real) or 2 (IQ) channels
+ */
+static bool init_polyphase(resample_t *resampler, uint32_t input_rate, uint32_t output_rate,
+                           uint32_t filter_length, float cutoff_freq, uint32_t channels) {
     if (!resampler || input_rate == 0 || output_rate == 0 ||
         filter_length == 0 || cutoff_freq <= 0.0f || cutoff_freq >= 0.5f) {
         return false;
     }
 
     // Set basic parameters
+    memset(resampler, 0, sizeof(*resampler));
     resampler->input_rate = input_rate;
     resampler->output_rate = output_rate;
     resampler->ratio = (double)output_rate / (double)input_rate;
     resampler->filter_length = filter_length;
     resampler->cutoff_freq = cutoff_freq;
+    resampler->channels = channels;
+    rational_ratio(input_rate, output_rate, &resampler->interpolation, &resampler->decimation);
+
+    // The prototype runs at L * input_rate, where one period of the lower
+    // rate is max(L, M) samples; each phase gets the taps that cover the span
+    const uint32_t L = resampler->interpolation;
+    const uint32_t M = resampler->decimation;
+    const uint32_t period = L > M ? L : M;
+    const uint32_t taps = phase_taps(L, M, filter_length);
+    const uint32_t length = taps * L;
+    resampler->taps_per_phase = taps;
+    resampler->stage_rate = input_rate;
+    resampler->macs_per_input = (double)taps * L / M;
+
+    // Delay line holds every input twice
+    resampler->history_length = taps;
+    resampler->history_buffer = (float *)calloc(2 * (size_t)taps * channels, sizeof(float));
+    resampler->filter_coeffs = (float *)malloc((size_t)length * channels * sizeof(float));
+    // Designed once, so the (possibly large) window stays out of the shared cache
+    window_t *window = window_create_param(WINDOW_KAISER, length, WINDOW_KAISER_DEFAULT_BETA);
+    if (!resampler->history_buffer || !resampler->filter_coeffs || !window) {
+        window_destroy(window);
+        resample_free(resampler);
+        return false;
+    }
 
-    // Initialize state
-    resampler->phase = 0.0;
-    resampler->input_count = 0;
-    resampler->output_count = 0;
+    // Kaiser-windowed sinc at cutoff_freq of the lower rate, gain L so every
+    // phase passes DC at unity
+    const double fc = (double)cutoff_freq / period;
+    double sum = 0.0;
+    for (uint32_t n = 0; n < length; n++) {
+        sum += prototype_tap(window, fc, n);
+    }
 
-    // Allocate history buffer (for filter state)
-    resampler->history_length = filter_length;
-    resampler->history_buffer = (float *)calloc(resampler->history_length, sizeof(float));
-    if (!resampler->history_buffer) {
-        return false;
+    // Phase p, slot i (oldest first) multiplies input newest - (taps-1-i): h[p + (taps-1-i) L],
+    // repeated for each channel of the interleaved delay line
+    for (uint32_t p = 0; p < L; p++) {
+        float *sub = resampler->filter_coeffs + (size_t)p * taps * channels;
+        for (uint32_t i = 0; i < taps; i++) {
+            float h = (float)(prototype_tap(window, fc, p + (taps - 1 - i) * L) * L / sum);
+            for (uint32_t c = 0; c < channels; c++) sub[i * channels + c] = h;
+        }
     }
+    window_destroy(window);
 
-    // Allocate and generate filter coefficients (simple windowed sinc)
-    resampler->filter_coeffs = (float *)malloc(filter_length * sizeof(float));
-    if (!resampler->filter_coeffs) {
-        free(resampler->history_buffer);
-        resampler->history_buffer = NULL;
+    return true;
+}
+
+// Initialize resampler with custom parameters
+bool resample_init_custom(resample_t *resampler, uint32_t input_rate, uint32_t output_rate,
+                         uint32_t filter_length, float cutoff_freq) {
+    return init_polyphase(resampler, input_rate, output_rate, filter_length, cutoff_freq, 1);
+}
+
+/**
+ * @brief Plan the cheapest pre-decimation and polyphase chain
+ *
+ * Tries every CIC factor (1 for none) and halfband count whose stages
+ * divide input_rate and leave the polyphase stage RESAMPLE_PLAN_MIN_OVERSAMPLE
+ * output rates or more, and keeps the one with the fewest multiply-adds per
+ * input sample; the single polyphase stage is the first candidate.
+ */
+bool resample_plan(resample_plan_t *plan, uint32_t input_rate, uint32_t output_rate,
+                   uint32_t filter_length, float cutoff_freq) {
+    if (!plan || input_rate == 0 || output_rate == 0 ||
+        filter_length == 0 || cutoff_freq <= 0.0f || cutoff_freq >= 0.5f) {
         return false;
     }
 
-    // Generate windowed sinc filter coefficients
-    // This is a simplified filter - in production you'd use a proper window function
-    float sum = 0.0f;
-    for (uint32_t i = 0; i < filter_length; i++) {
-        float x = 2.0f * M_PI * cutoff_freq * (i - filter_length/2.0f);
-        if (fabsf(x) < 1e-6f) {
-            resampler->filter_coeffs[i] = 1.0f; // Handle sinc(0) = 1
-        } else {
-            resampler->filter_coeffs[i] = sinf(x) / x;
+    memset(plan, 0, sizeof(*plan));
+    plan->predecimation.cic_factor = 1;
+    plan->predecimation.fir_factor = 1;
+    plan->stage_rate = input_rate;
+    rational_ratio(input_rate, output_rate, &plan->interpolation, &plan->decimation);
+    plan->taps_per_phase = phase_taps(plan->interpolation, plan->decimation, filter_length);
+    plan->macs_per_input = (double)plan->taps_per_phase * plan->interpolation / plan->decimation;
+
+    const uint64_t min_rate = (uint64_t)RESAMPLE_PLAN_MIN_OVERSAMPLE * output_rate;
+    const double passband = 0.5 * output_rate / input_rate;
+    for (uint32_t r = 1; r <= DECIM_CIC_MAX_FACTOR; r++) {
+        if (input_rate % r != 0 || input_rate / r < min_rate) continue;
+        decim_plan_t stages = {r, 0, 1};
+        for (uint32_t rate = input_rate / r; ; rate /= 2, stages.num_halfbands++) {
+            if (stages.num_halfbands > 0 || r > 1) {
+                double macs = decim_plan_macs(&stages, passband);
+                if (macs < 0.0) break;
+
+                uint32_t L, M;
+                rational_ratio(rate, output_rate, &L, &M);
+                uint32_t taps = phase_taps(L, M, filter_length);
+                macs += (double)taps * L / M * rate / input_rate;
+                if (macs < plan->macs_per_input) {
+                    plan->predecimation = stages;
+                    plan->stage_rate = rate;
+                    plan->interpolation = L;
+                    plan->decimation = M;
+                    plan->taps_per_phase = taps;
+                    plan->macs_per_input = macs;
+                }
+            }
+            if (rate % 2 != 0 || rate / 2 < min_rate ||
+                stages.num_halfbands + 1 >= DECIM_MAX_STAGES) {
+                break;
+            }
         }
-        // Simple Hamming window
-        float window = 0.54f - 0.46f * cosf(2.0f * M_PI * i / (filter_length - 1));
-        resampler->filter_coeffs[i] *= window;
-        sum += fabsf(resampler->filter_coeffs[i]);
     }
+    return true;
+}
 
-    // Normalize filter coefficients
-    if (sum > 0.0f) {
-        for (uint32_t i = 0; i < filter_length; i++) {
-            resampler->filter_coeffs[i] /= sum;
-        }
+/**
+ * @brief Initialize the planned chain for 1 (real) or 2 (IQ) channels
+ */
+static bool init_planned(resample_t *resampler, uint32_t input_rate, uint32_t output_rate,
+                         uint32_t channels) {
+    resample_plan_t plan;
+    if (!resampler ||
+        !resample_plan(&plan, input_rate, output_rate, RESAMPLE_DEFAULT_LENGTH,
+                       RESAMPLE_DEFAULT_CUTOFF) ||
+        !init_polyphase(resampler, plan.stage_rate, output_rate, RESAMPLE_DEFAULT_LENGTH,
+                        RESAMPLE_DEFAULT_CUTOFF, channels)) {
+        return false;
     }
+    if (plan.stage_rate == input_rate) return true;
 
+    // The polyphase stage runs at stage_rate; the chain converts from input_rate
+    resampler->input_rate = input_rate;
+    resampler->ratio = (double)output_rate / (double)input_rate;
+    resampler->macs_per_input = plan.macs_per_input;
+    resampler->predecimator = (decim_t *)malloc(sizeof(decim_t));
+    resampler->stage_buffer = (float *)malloc((size_t)RESAMPLE_BLOCK_SAMPLES * channels *
+                                              sizeof(float));
+    if (!resampler->predecimator || !resampler->stage_buffer ||
+        !decim_init(resampler->predecimator, &plan.predecimation,
+                    0.5 * output_rate / input_rate, channels)) {
+        free(resampler->predecimator);
+        resampler->predecimator = NULL;
+        resample_free(resampler);
+        return false;
+    }
     return true;
 }
 
-// Process a single input sample and generate output samples
-uint32_t resample_process_sample(resample_t *resampler, float input_sample,
-                                float *output_buffer, uint32_t max_output_samples) {
-    if (!resampler || !output_buffer || max_output_samples == 0) {
-        return 0;
-    }
+// Initialize an IQ resampler with default parameters
+bool resample_iq_init(resample_t *resampler, uint32_t input_rate, uint32_t output_rate) {
+    return init_planned(resampler, input_rate, output_rate, 2);
+}
 
-    uint32_t samples_generated = 0;
+// Initialize an IQ resampler with custom parameters
+bool resample_iq_init_custom(resample_t *resampler, uint32_t input_rate, uint32_t output_rate,
+                             uint32_t filter_length, float cutoff_freq) {
+    return init_polyphase(resampler, input_rate, output_rate, filter_length, cutoff_freq, 2);
+}
 
-    // Update history buffer
-    if (resampler->history_buffer) {
-        // Shift history
-        for (uint32_t i = resampler->history_length - 1; i > 0; i--) {
-            resampler->history_buffer[i] = resampler->history_buffer[i - 1];
-        }
-        resampler->history_buffer[0] = input_sample;
+// Store one input (channels floats) in both halves of the delay line
+static inline void push_input(resample_t *resampler, const float *input) {
+    const uint32_t channels = resampler->channels;
+    uint32_t w = resampler->history_index;
+    float *first = resampler->history_buffer + (size_t)w * channels;
+    float *second = first + (size_t)resampler->history_length * channels;
+    for (uint32_t c = 0; c < channels; c++) {
+        first[c] = input[c];
+        second[c] = input[c];
     }
+    resampler->history_index = w + 1 == resampler->history_length ? 0 : w + 1;
+}
 
-    // Generate output samples based on conversion ratio
-    // Use inverse ratio for phase increment
-    double phase_increment = 1.0 / resampler->ratio;
-
-    while (resampler->phase < 1.0 && samples_generated < max_output_samples) {
-        // Linear interpolation between current and previous sample
-        float current_sample = input_sample;
-        float prev_sample = (resampler->history_length > 1) ?
-                           resampler->history_buffer[1] : current_sample;
+// Lane-wise products of n floats (a multiple of RESAMPLE_LANES): independent
+// accumulators the compiler keeps in one vector register, summed in a fixed
+// order by the caller so every build gives the same outputs
+static inline void dot_lanes(const float *restrict coeffs, const float *restrict window,
+                             uint32_t n, float lanes[RESAMPLE_LANES]) {
+    float acc[RESAMPLE_LANES] = {0.0f};
+    for (uint32_t i = 0; i < n; i += RESAMPLE_LANES) {
+        for (uint32_t j = 0; j < RESAMPLE_LANES; j++) {
+            acc[j] += coeffs[i + j] * window[i + j];
+        }
+    }
+    memcpy(lanes, acc, sizeof(acc));
+}
 
-        // Interpolate based on phase
-        float interpolated_sample = prev_sample +
-                                  (current_sample - prev_sample) * (float)resampler->phase;
+// Output of the phase-p sub-filter over the last taps_per_phase inputs;
+// lanes alternate I and Q for an IQ resampler
+static inline void phase_output(const resample_t *resampler, uint32_t p, float *output) {
+    const uint32_t n = resampler->taps_per_phase * resampler->channels;
+    const float *coeffs = resampler->filter_coeffs + (size_t)p * n;
+    const float *window = resampler->history_buffer +
+                          (size_t)resampler->history_index * resampler->channels;
+    float a[RESAMPLE_LANES];
+    dot_lanes(coeffs, window, n, a);
+    if (resampler->channels == 1) {
+        output[0] = ((a[0] + a[1]) + (a[2] + a[3])) + ((a[4] + a[5]) + (a[6] + a[7]));
+    } else {
+        output[0] = (a[0] + a[2]) + (a[4] + a[6]);
+        output[1] = (a[1] + a[3]) + (a[5] + a[7]);
+    }
+}
 
-        // Apply simple low-pass filtering (if history available)
-        if (resampler->filter_coeffs && resampler->history_buffer) {
-            float filtered_sample = 0.0f;
-            for (uint32_t i = 0; i < resampler->history_length; i++) {
-                filtered_sample += resampler->history_buffer[i] * resampler->filter_coeffs[i];
-            }
-            interpolated_sample = filtered_sample;
+// Emit the outputs that fall on the newest input, up to max_output_samples
+static inline uint32_t emit_outputs(resample_t *resampler, float *output_buffer,
+                                    uint32_t max_output_samples) {
+    const uint32_t L = resampler->interpolation;
+    uint32_t generated = 0;
+    while (resampler->phase_index < L) {
+        if (generated < max_output_samples) {
+            phase_output(resampler, resampler->phase_index,
+                         output_buffer + (size_t)generated * resampler->channels);
+            generated++;
         }
+        resampler->phase_index += resampler->decimation;
+    }
+    resampler->phase_index -= L;
+    return generated;
+}
 
-        output_buffer[samples_generated] = interpolated_sample;
-        samples_generated++;
+// Run a block of channels-float inputs through the delay line; returns the
+// outputs and sets the inputs consumed
+static uint32_t polyphase_block(resample_t *resampler, const float *input, uint32_t input_samples,
+                                float *output, uint32_t max_output_samples, uint32_t *consumed) {
+    const uint32_t channels = resampler->channels;
+    uint32_t total_output = 0;
+    uint32_t n = 0;
+    for (; n < input_samples && total_output < max_output_samples; n++) {
+        push_input(resampler, input + (size_t)n * channels);
+        total_output += emit_outputs(resampler, output + (size_t)total_output * channels,
+                                     max_output_samples - total_output);
+    }
+    *consumed = n;
+    return total_output;
+}
 
-        // Advance phase by inverse ratio
-        resampler->phase += phase_increment;
+// Run a block through the pre-decimation, if any, and the polyphase stage
+static uint32_t process_block(resample_t *resampler, const float *input, uint32_t input_samples,
+                              float *output, uint32_t max_output_samples) {
+    const uint32_t channels = resampler->channels;
+    uint32_t total_output = 0;
+    uint32_t consumed = 0;
+    if (!resampler->predecimator) {
+        total_output = polyphase_block(resampler, input, input_samples, output,
+                                       max_output_samples, &consumed);
+    }
+    while (resampler->predecimator && consumed < input_samples &&
+           total_output < max_output_samples) {
+        uint32_t n = input_samples - consumed;
+        if (n > RESAMPLE_BLOCK_SAMPLES) n = RESAMPLE_BLOCK_SAMPLES;
+        memcpy(resampler->stage_buffer, input + (size_t)consumed * channels,
+               (size_t)n * channels * sizeof(float));
+        uint32_t decimated = (uint32_t)decim_process(resampler->predecimator,
+                                                     resampler->stage_buffer, n);
+        uint32_t used;
+        total_output += polyphase_block(resampler, resampler->stage_buffer, decimated,
+                                        output + (size_t)total_output * channels,
+                                        max_output_samples - total_output, &used);
+        consumed += n;
     }
 
-    // Reset phase for next input sample (keep fractional part)
-    resampler->phase = fmod(resampler->phase, 1.0);
-    resampler->input_count++;
-    resampler->output_count += samples_generated;
+    resampler->phase = (double)resampler->phase_index / resampler->interpolation;
+    resampler->input_count += consumed;
+    resampler->output_count += total_output;
+    return total_output;
+}
 
-    return samples_generated;
+// Process a single input sample and generate output samples
+uint32_t resample_process_sample(resample_t *resampler, float input_sample,
+                                float *output_buffer, uint32_t max_output_samples) {
+    if (!resampler || !resampler->history_buffer || resampler->channels != 1 ||
+        !output_buffer || max_output_samples == 0) {
+        return 0;
+    }
+
+    return process_block(resampler, &input_sample, 1, output_buffer, max_output_samples);
 }
 
 // Process a buffer of input samples
@@ -135,22 +371,30 @@ bool resample_process_buffer(resample_t *resampler,
                            const float *input_buffer, uint32_t input_samples,
                            float *output_buffer, uint32_t max_output_samples,
                            uint32_t *output_samples_generated) {
-    if (!resampler || !input_buffer || !output_buffer || !output_samples_generated ||
-        input_samples == 0 || max_output_samples == 0) {
+    if (!resampler || !resampler->history_buffer || resampler->channels != 1 ||
+        !input_buffer || !output_buffer ||
+        !output_samples_generated || input_samples == 0 || max_output_samples == 0) {
         return false;
     }
 
-    uint32_t total_output = 0;
-    uint32_t output_remaining = max_output_samples;
+    *output_samples_generated = process_block(resampler, input_buffer, input_samples,
+                                              output_buffer, max_output_samples);
+    return true;
+}
 
-    for (uint32_t i = 0; i < input_samples && output_remaining > 0; i++) {
-        uint32_t generated = resample_process_sample(resampler, input_buffer[i],
-                                                   output_buffer + total_output, output_remaining);
-        total_output += generated;
-        output_remaining -= generated;
+// Process a buffer of interleaved IQ samples
+bool resample_iq_process_buffer(resample_t *resampler,
+                                const float *iq_input, uint32_t input_samples,
+                                float *iq_output, uint32_t max_output_samples,
+                                uint32_t *output_samples_generated) {
+    if (!resampler || !resampler->history_buffer || resampler->channels != 2 ||
+        !iq_input || !iq_output ||
+        !output_samples_generated || input_samples == 0 || max_output_samples == 0) {
+        return false;
     }
 
-    *output_samples_generated = total_output;
+    *output_samples_generated = process_block(resampler, iq_input, input_samples,
+                                              iq_output, max_output_samples);
     return true;
 }
 
@@ -159,12 +403,16 @@ void resample_reset(resample_t *resampler) {
     if (!resampler) return;
 
     resampler->phase = 0.0;
+    resampler->phase_index = 0;
+    resampler->history_index = 0;
     resampler->input_count = 0;
     resampler->output_count = 0;
+    if (resampler->predecimator) decim_reset(resampler->predecimator);
 
     // Clear history buffer
     if (resampler->history_buffer) {
-        memset(resampler->history_buffer, 0, resampler->history_length * sizeof(float));
+        memset(resampler->history_buffer, 0,
+               2 * (size_t)resampler->history_length * resampler->channels * sizeof(float));
     }
 }
 
@@ -181,6 +429,95 @@ void resample_free(resample_t *resampler) {
         free(resampler->history_buffer);
         resampler->history_buffer = NULL;
     }
+
+    if (resampler->predecimator) {
+        decim_free(resampler->predecimator);
+        free(resampler->predecimator);
+        resampler->predecimator = NULL;
+    }
+    free(resampler->stage_buffer);
+    resampler->stage_buffer = NULL;
+}
+
+// Initialize a Farrow resampler
+bool resample_farrow_init(resample_farrow_t *farrow, double input_rate, double output_rate,
+                          uint32_t channels) {
+    if (!farrow || !(input_rate > 0.0) || !(output_rate > 0.0) ||
+        (channels != 1 && channels != 2)) {
+        return false;
+    }
+
+    memset(farrow, 0, sizeof(*farrow));
+    farrow->input_rate = input_rate;
+    farrow->output_rate = output_rate;
+    farrow->step = input_rate / output_rate;
+    farrow->channels = channels;
+    resample_farrow_reset(farrow);
+    return true;
+}
+
+// Cubic Lagrange through x[-1..2] at mu in [0, 1), in Farrow (Horner) form
+static inline float farrow_cubic(float xm1, float x0, float x1, float x2, float mu) {
+    float c1 = x1 - (1.0f / 3.0f) * xm1 - 0.5f * x0 - (1.0f / 6.0f) * x2;
+    float c2 = 0.5f * (xm1 + x1) - x0;
+    float c3 = (1.0f / 6.0f) * (x2 - xm1) + 0.5f * (x0 - x1);
+    return ((c3 * mu + c2) * mu + c1) * mu + x0;
+}
+
+// Process a buffer through the Farrow interpolator
+bool resample_farrow_process(resample_farrow_t *farrow, const float *input,
+                             uint32_t input_samples, float *output,
+                             uint32_t max_output_samples, uint32_t *output_samples_generated) {
+    if (!farrow || !input || !output || !output_samples_generated ||
+        input_samples == 0 || max_output_samples == 0) {
+        return false;
+    }
+
+    const uint32_t channels = farrow->channels;
+    const double step = farrow->step;
+    double position = farrow->position;
+    float (*h)[2] = farrow->history;
+    uint32_t generated = 0;
+    uint32_t consumed = 0;
+
+    for (; consumed < input_samples && generated < max_output_samples; consumed++) {
+        // Shift the four-sample window; slot 3 is the newest input
+        for (uint32_t c = 0; c < channels; c++) {
+            h[0][c] = h[1][c];
+            h[1][c] = h[2][c];
+            h[2][c] = h[3][c];
+            h[3][c] = input[(size_t)consumed * channels + c];
+        }
+
+        // Outputs between slots 1 and 2
+        while (position < 1.0 && generated < max_output_samples) {
+            float mu = (float)position;
+            for (uint32_t c = 0; c < channels; c++) {
+                output[(size_t)generated * channels + c] =
+                    farrow_cubic(h[0][c], h[1][c], h[2][c], h[3][c], mu);
+            }
+            generated++;
+            position += step;
+        }
+        position -= 1.0;
+    }
+
+    farrow->position = position;
+    farrow->input_count += consumed;
+    farrow->output_count += generated;
+    *output_samples_generated = generated;
+    return true;
+}
+
+// Reset Farrow state
+void resample_farrow_reset(resample_farrow_t *farrow) {
+    if (!farrow) return;
+
+    // The first input lands in slot 3; output 0 falls on it two inputs later
+    farrow->position = 2.0;
+    memset(farrow->history, 0, sizeof(farrow->history));
+    farrow->input_count = 0;
+    farrow->output_count = 0;
 }
 
 // Utility functions
@@ -3,46 +3,123 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "decim.h"
 
-// Resampling context for rational rate conversion
+// Most polyphase branches; rate pairs needing more use the last
+// continued-fraction convergent of the ratio with at most this many
+#define RESAMPLE_MAX_PHASES 65536
+
+// Lowest polyphase stage input rate a plan may decimate to, in output rates
+#define RESAMPLE_PLAN_MIN_OVERSAMPLE 2
+
+/*
+ * Polyphase rational resampler
+ *
+ * Converts by L / M = output_rate / input_rate in lowest terms. The
+ * prototype low-pass runs at L * input_rate and is stored as L sub-filters
+ * of taps_per_phase taps, one per output phase, each reversed to line up
+ * with the delay line oldest sample first. The delay line keeps every
+ * input twice, taps_per_phase apart, so the last taps_per_phase inputs are
+ * always contiguous: an output is one dot product with the sub-filter of
+ * its phase and nothing is shifted per sample. Output k uses phase
+ * k * M mod L and the inputs up to floor(k * M / L).
+ *
+ * The same state resamples interleaved IQ (resample_iq_*): the delay line
+ * and the sub-filters are interleaved, each tap stored once per rail, so
+ * I and Q come out of one pass over the same contiguous floats.
+ *
+ * Every polyphase output costs taps_per_phase multiply-adds, which grows
+ * with input_rate / output_rate, so for large reductions resample_init
+ * plans a chain (resample_plan): an integer pre-decimation by CIC and
+ * halfband stages (decim_t), each running at its own rate, down to
+ * stage_rate, then the polyphase stage from stage_rate to output_rate.
+ * The plan is the cheapest in multiply-adds per input sample among the
+ * CIC factors and halfband counts whose stages divide input_rate exactly.
+ * The pre-decimation keeps 0..output_rate / 2 alias free, leaving the
+ * polyphase stage the band edge. interpolation and decimation are the
+ * polyphase stage's L / M (relative to stage_rate).
+ */
 typedef struct {
     // Conversion parameters
     uint32_t input_rate;     // Input sample rate (Hz)
     uint32_t output_rate;    // Output sample rate (Hz)
     double ratio;           // Conversion ratio (output_rate / input_rate)
+    uint32_t interpolation;  // L
+    uint32_t decimation;     // M
+    uint32_t channels;       // 1: real samples, 2: interleaved IQ
 
     // Filter parameters
-    uint32_t filter_length;  // Length of anti-aliasing filter
-    float cutoff_freq;      // Cutoff frequency (0.0 to 0.5, normalized to output rate)
-    float *filter_coeffs;   // FIR filter coefficients
+    uint32_t filter_length;  // Filter span in periods of the lower rate
+    float cutoff_freq;      // Cutoff frequency (0.0 to 0.5, normalized to the lower rate)
+    uint32_t taps_per_phase; // Inputs each output is computed from
+    float *filter_coeffs;   // L sub-filters: [(p * taps_per_phase + i) * channels + c] pairs with the i-th oldest input
 
     // Internal state
-    double phase;           // Current phase accumulator (0.0 to 1.0)
+    double phase;           // Position of the next output past the newest input (0.0 to 1.0)
+    uint32_t phase_index;   // The same in 1/L steps: next output is at newest + phase_index / L
     uint32_t input_count;   // Number of input samples processed
     uint32_t output_count;  // Number of output samples generated
 
-    // History buffer for FIR filtering
+    // Delay line for FIR filtering: each input at slots w and w + history_length
     uint32_t history_length;
+    uint32_t history_index;  // w: oldest slot, the next one written
     float *history_buffer;
+
+    // Pre-decimation ahead of the polyphase stage
+    decim_t *predecimator;   // NULL: polyphase stage only
+    float *stage_buffer;     // Input block decimated in place
+    uint32_t stage_rate;     // Polyphase stage input rate (Hz)
+    double macs_per_input;   // Multiply-adds per input sample and channel, whole chain
 } resample_t;
 
-// Initialize resampler with given rates
+// Stage chain for a conversion
+typedef struct {
+    decim_plan_t predecimation;  // Integer stages (factor 1: none)
+    uint32_t stage_rate;         // Polyphase stage input rate (Hz)
+    uint32_t interpolation;      // Polyphase L
+    uint32_t decimation;         // Polyphase M
+    uint32_t taps_per_phase;     // Polyphase taps per output
+    double macs_per_input;       // Multiply-adds per input sample and channel
+} resample_plan_t;
+
+// Plan the cheapest chain for a conversion with the given polyphase filter
+// (reductions by less than 2 * RESAMPLE_PLAN_MIN_OVERSAMPLE stay one stage)
+bool resample_plan(resample_plan_t *plan, uint32_t input_rate, uint32_t output_rate,
+                   uint32_t filter_length, float cutoff_freq);
+
+// Initialize resampler with given rates, planning a stage chain
 bool resample_init(resample_t *resampler, uint32_t input_rate, uint32_t output_rate);
 
-// Initialize resampler with custom filter parameters
+// Initialize a single-stage resampler with custom filter parameters (span
+// in periods of the lower rate, cutoff as a fraction of the lower rate)
 bool resample_init_custom(resample_t *resampler, uint32_t input_rate, uint32_t output_rate,
                          uint32_t filter_length, float cutoff_freq);
 
-// Process a single input sample and generate output samples
+// Process a single input sample and generate output samples; outputs
+// beyond max_output_samples are dropped
 uint32_t resample_process_sample(resample_t *resampler, float input_sample,
                                 float *output_buffer, uint32_t max_output_samples);
 
-// Process a buffer of input samples
+// Process a buffer of input samples; stops once the output is full (with
+// a pre-decimation, outputs past the end of the block that filled it are
+// dropped)
 bool resample_process_buffer(resample_t *resampler,
                            const float *input_buffer, uint32_t input_samples,
                            float *output_buffer, uint32_t max_output_samples,
                            uint32_t *output_samples_generated);
 
+// Initialize a resampler for interleaved IQ samples (reset/free as above;
+// the default one is planned like resample_init)
+bool resample_iq_init(resample_t *resampler, uint32_t input_rate, uint32_t output_rate);
+bool resample_iq_init_custom(resample_t *resampler, uint32_t input_rate, uint32_t output_rate,
+                             uint32_t filter_length, float cutoff_freq);
+
+// Process a buffer of interleaved IQ samples (counts in complex samples)
+bool resample_iq_process_buffer(resample_t *resampler,
+                                const float *iq_input, uint32_t input_samples,
+                                float *iq_output, uint32_t max_output_samples,
+                                uint32_t *output_samples_generated);
+
 // Reset resampler state
 void resample_reset(resample_t *resampler);
 
@@ -53,7 +130,44 @@ void resample_free(resample_t *resampler);
 uint32_t resample_estimate_output_size(uint32_t input_samples, double ratio);
 double resample_get_ratio(uint32_t input_rate, uint32_t output_rate);
 
-// Predefined configurations for common conversions
+/*
+ * Cubic Farrow fractional resampler
+ *
+ * For any ratio, including rates that are not integers (SigMF allows
+ * them). Each output is the cubic Lagrange interpolant through the four
+ * inputs around its position, evaluated in Farrow form: four polynomial
+ * coefficients from the inputs, then Horner in the fractional position mu.
+ * Output k sits at input position k * input_rate / output_rate, so the
+ * outputs are time aligned with the inputs; they wait for two inputs past
+ * their position. There is no anti-alias filter: for large rate reductions
+ * run the polyphase resampler (or a decimator) first and leave the Farrow
+ * stage the residual ratio close to 1.
+ */
+typedef struct {
+    double input_rate;       // Input sample rate (Hz, any positive value)
+    double output_rate;      // Output sample rate (Hz)
+    double step;             // Input samples per output
+    uint32_t channels;       // 1: real samples, 2: interleaved IQ
+    double position;         // Next output, in inputs past history slot 1
+    float history[4][2];     // Last four inputs, oldest first
+    uint64_t input_count;    // Number of input samples processed
+    uint64_t output_count;   // Number of output samples generated
+} resample_farrow_t;
+
+// Initialize for channels 1 (real) or 2 (interleaved IQ)
+bool resample_farrow_init(resample_farrow_t *farrow, double input_rate, double output_rate,
+                          uint32_t channels);
+
+// Process a buffer of inputs (counts in samples of channels floats); stops
+// once the output is full
+bool resample_farrow_process(resample_farrow_t *farrow, const float *input,
+                             uint32_t input_samples, float *output,
+                             uint32_t max_output_samples, uint32_t *output_samples_generated);
+
+// Reset Farrow state
+void resample_farrow_reset(resample_farrow_t *farrow);
+
+// Predefined configurations for common conversions (planned chains)
 bool resample_init_audio_48k(resample_t *resampler, uint32_t input_rate);  // To 48kHz audio
 bool resample_init_audio_44k(resample_t *resampler, uint32_t input_rate);  // To 44.1kHz audio
 
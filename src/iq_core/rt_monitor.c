@@ -0,0 +1,246 @@
+/*
+ * IQ Lab - Real-time deadline monitor
+ *
+ * Counters are plain fields under one mutex: the reader touches them once
+ * per block and the consumer a few times per block, far below the rate at
+ * which a lock would show up next to the DSP. Stage latencies are merged
+ * from the profiler's per-thread histograms when a report is made.
+ */
+
+#include "rt_monitor.h"
+#include <stdlib.h>
+#include <string.h>
+
+rt_monitor_t *rt_monitor_create(const char *tool, double sample_rate, double interval_s,
+                                const char *stats_path) {
+    if (sample_rate <= 0.0) {
+        fprintf(stderr, "Error: Real-time monitoring needs the sample rate\n");
+        return NULL;
+    }
+    if (interval_s <= 0.0) interval_s = RT_MONITOR_INTERVAL;
+
+    rt_monitor_t *monitor = (rt_monitor_t *)calloc(1, sizeof(rt_monitor_t));
+    if (!monitor) {
+        fprintf(stderr, "Error: Failed to allocate the real-time monitor\n");
+        return NULL;
+    }
+    snprintf(monitor->tool, sizeof(monitor->tool), "%s", tool ? tool : "iq_lab");
+    monitor->sample_rate = sample_rate;
+    monitor->interval_ns = (uint64_t)(interval_s * 1e9);
+    if (stats_path && stats_path[0]) {
+        size_t length = strlen(stats_path) + 1;
+        monitor->stats_path = malloc(length);
+        if (!monitor->stats_path) {
+            fprintf(stderr, "Error: Failed to allocate the real-time monitor\n");
+            free(monitor);
+            return NULL;
+        }
+        memcpy(monitor->stats_path, stats_path, length);
+    }
+
+    iq_profile_collect(monitor->tool);
+    pthread_mutex_init(&monitor->lock, NULL);
+    monitor->start_ns = iq_profile_now();
+    monitor->next_report_ns = monitor->start_ns + monitor->interval_ns;
+    return monitor;
+}
+
+void rt_monitor_arrived(rt_monitor_t *monitor, uint64_t samples, uint32_t fill, uint32_t capacity) {
+    if (!monitor) return;
+    pthread_mutex_lock(&monitor->lock);
+    monitor->samples_arrived += samples;
+    monitor->ring_fill = fill;
+    monitor->ring_capacity = capacity;
+    if (fill > monitor->ring_peak) monitor->ring_peak = fill;
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+void rt_monitor_overrun(rt_monitor_t *monitor, uint64_t samples) {
+    if (!monitor) return;
+    pthread_mutex_lock(&monitor->lock);
+    monitor->overruns++;
+    monitor->dropped_samples += samples;
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+void rt_monitor_idle(rt_monitor_t *monitor, uint64_t ns) {
+    if (!monitor) return;
+    pthread_mutex_lock(&monitor->lock);
+    monitor->idle_ns += ns;
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+void rt_monitor_consumed(rt_monitor_t *monitor, uint64_t samples, uint64_t latency_ns) {
+    if (!monitor) return;
+    pthread_mutex_lock(&monitor->lock);
+    monitor->samples_consumed += samples;
+    monitor->blocks++;
+    if (monitor->ring_fill > 0) monitor->ring_fill--;
+    iq_latency_add(&monitor->block_latency, latency_ns);
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+void rt_monitor_stall(rt_monitor_t *monitor) {
+    if (!monitor) return;
+    pthread_mutex_lock(&monitor->lock);
+    monitor->stalls++;
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+void rt_monitor_degraded(rt_monitor_t *monitor) {
+    if (!monitor) return;
+    pthread_mutex_lock(&monitor->lock);
+    monitor->degraded++;
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+bool rt_monitor_behind(rt_monitor_t *monitor) {
+    if (!monitor) return false;
+    pthread_mutex_lock(&monitor->lock);
+    bool behind = monitor->ring_capacity > 0 && monitor->ring_fill * 4 >= monitor->ring_capacity * 3;
+    pthread_mutex_unlock(&monitor->lock);
+    return behind;
+}
+
+void rt_monitor_get(rt_monitor_t *monitor, rt_monitor_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!monitor) return;
+    const uint64_t now = iq_profile_now();
+    pthread_mutex_lock(&monitor->lock);
+    stats->elapsed_s = (double)(now - monitor->start_ns) * 1e-9;
+    stats->stream_s = (double)monitor->samples_consumed / monitor->sample_rate;
+    stats->speed = stats->elapsed_s > 0.0 ? stats->stream_s / stats->elapsed_s : 0.0;
+    stats->lag_s = stats->elapsed_s - stats->stream_s;
+    stats->load = stats->elapsed_s > 0.0 ? 1.0 - (double)monitor->idle_ns * 1e-9 / stats->elapsed_s : 0.0;
+    if (stats->load < 0.0) stats->load = 0.0;
+    stats->ring_fill = monitor->ring_fill;
+    stats->ring_capacity = monitor->ring_capacity;
+    stats->ring_peak = monitor->ring_peak;
+    stats->blocks = monitor->blocks;
+    stats->overruns = monitor->overruns;
+    stats->dropped_samples = monitor->dropped_samples;
+    stats->stalls = monitor->stalls;
+    stats->degraded = monitor->degraded;
+    iq_latency_get(&monitor->block_latency, &stats->block_latency);
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+// 'label' follows the tool name ("done" on the final line)
+static void rt_monitor_print_line(rt_monitor_t *monitor, FILE *out, const char *label) {
+    rt_monitor_stats_t s;
+    rt_monitor_get(monitor, &s);
+    fprintf(out, "[%s%s] %.1f s  speed %.2fx  lag %.3f s  load %.0f%%  ring %u/%u (peak %u)  "
+                 "overruns %llu (%llu samples)  stalls %llu  degraded %llu  "
+                 "block p50 %.2f p99 %.2f max %.2f ms",
+            monitor->tool, label, s.elapsed_s, s.speed, s.lag_s, 100.0 * s.load,
+            s.ring_fill, s.ring_capacity, s.ring_peak,
+            (unsigned long long)s.overruns, (unsigned long long)s.dropped_samples,
+            (unsigned long long)s.stalls, (unsigned long long)s.degraded,
+            (double)s.block_latency.p50_ns * 1e-6, (double)s.block_latency.p99_ns * 1e-6,
+            (double)s.block_latency.max_ns * 1e-6);
+
+    // Waits are idle time, not work
+    for (int stage = 0; stage < IQ_PROFILE_WAIT; stage++) {
+        iq_latency_t latency;
+        iq_profile_latency((iq_profile_stage_t)stage, &latency);
+        if (latency.count == 0) continue;
+        fprintf(out, "  %s p99 %.2f ms", iq_profile_stage_name((iq_profile_stage_t)stage),
+                (double)latency.p99_ns * 1e-6);
+    }
+    fprintf(out, "\n");
+}
+
+void rt_monitor_print(rt_monitor_t *monitor, FILE *out) {
+    if (monitor) rt_monitor_print_line(monitor, out, "");
+}
+
+static void rt_monitor_write_latency(FILE *f, const iq_latency_t *latency) {
+    fprintf(f, "{\"count\": %llu, \"p50\": %.9f, \"p99\": %.9f, \"max\": %.9f}",
+            (unsigned long long)latency->count, (double)latency->p50_ns * 1e-9,
+            (double)latency->p99_ns * 1e-9, (double)latency->max_ns * 1e-9);
+}
+
+bool rt_monitor_write_json(rt_monitor_t *monitor, const char *path) {
+    if (!monitor || !path) return false;
+
+    // Written beside the file and renamed over it, so a reader never sees half
+    char temp[4096];
+    int written = snprintf(temp, sizeof(temp), "%s.tmp", path);
+    if (written <= 0 || (size_t)written >= sizeof(temp)) return false;
+    FILE *f = fopen(temp, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot write real-time stats %s\n", path);
+        return false;
+    }
+
+    rt_monitor_stats_t s;
+    rt_monitor_get(monitor, &s);
+    fprintf(f, "{\n  \"tool\": \"%s\",\n  \"sample_rate\": %.1f,\n  \"elapsed_seconds\": %.6f,\n"
+               "  \"stream_seconds\": %.6f,\n  \"speed\": %.4f,\n  \"lag_seconds\": %.6f,\n  \"load\": %.4f,\n"
+               "  \"ring_fill\": %u,\n  \"ring_capacity\": %u,\n  \"ring_peak\": %u,\n  \"blocks\": %llu,\n"
+               "  \"overruns\": %llu,\n  \"dropped_samples\": %llu,\n  \"stalls\": %llu,\n"
+               "  \"degraded_blocks\": %llu,\n  \"block_latency\": ",
+            monitor->tool, monitor->sample_rate, s.elapsed_s, s.stream_s, s.speed, s.lag_s, s.load,
+            s.ring_fill, s.ring_capacity, s.ring_peak, (unsigned long long)s.blocks,
+            (unsigned long long)s.overruns, (unsigned long long)s.dropped_samples,
+            (unsigned long long)s.stalls, (unsigned long long)s.degraded);
+    rt_monitor_write_latency(f, &s.block_latency);
+    fprintf(f, ",\n  \"stages\": [");
+    bool first = true;
+    for (int stage = 0; stage < IQ_PROFILE_STAGE_COUNT; stage++) {
+        iq_latency_t latency;
+        iq_profile_latency((iq_profile_stage_t)stage, &latency);
+        if (latency.count == 0) continue;
+        fprintf(f, "%s\n    {\"stage\": \"%s\", \"latency\": ", first ? "" : ",",
+                iq_profile_stage_name((iq_profile_stage_t)stage));
+        rt_monitor_write_latency(f, &latency);
+        fprintf(f, "}");
+        first = false;
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    bool ok = fclose(f) == 0;
+    if (!ok || rename(temp, path) != 0) {
+        // Some platforms refuse to rename over an existing file
+        remove(path);
+        if (!ok || rename(temp, path) != 0) {
+            remove(temp);
+            fprintf(stderr, "Error: Cannot write real-time stats %s\n", path);
+            return false;
+        }
+    }
+    return true;
+}
+
+void rt_monitor_poll(rt_monitor_t *monitor) {
+    if (!monitor) return;
+    const uint64_t now = iq_profile_now();
+    pthread_mutex_lock(&monitor->lock);
+    bool due = now >= monitor->next_report_ns;
+    if (due) {
+        while (monitor->next_report_ns <= now) monitor->next_report_ns += monitor->interval_ns;
+    }
+    pthread_mutex_unlock(&monitor->lock);
+    if (!due) return;
+
+    if (monitor->stats_path) {
+        rt_monitor_write_json(monitor, monitor->stats_path);
+    } else {
+        rt_monitor_print(monitor, stderr);
+    }
+}
+
+void rt_monitor_destroy(rt_monitor_t *monitor) {
+    if (!monitor) return;
+    // Nothing to report from a run that never started (a setup error)
+    if (monitor->blocks > 0 || monitor->overruns > 0) {
+        if (monitor->stats_path) {
+            rt_monitor_write_json(monitor, monitor->stats_path);
+        } else {
+            rt_monitor_print_line(monitor, stderr, " done");
+        }
+    }
+    pthread_mutex_destroy(&monitor->lock);
+    free(monitor->stats_path);
+    free(monitor);
+}
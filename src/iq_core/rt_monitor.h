@@ -0,0 +1,116 @@
+#ifndef RT_MONITOR_H
+#define RT_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "profile.h"
+
+/*
+ * Real-time deadline monitor for streaming runs
+ * The tools' --realtime mode replays a capture at its sample rate through
+ * the async reader, the way an SDR delivers samples: a block that arrives
+ * while the read-ahead ring is full is lost (an overrun), as it would be
+ * on live hardware. The monitor follows such a run:
+ *
+ *   - consumed sample time against wall-clock time (speed, lag, load)
+ *   - ring fill and its peak, overruns and the samples they dropped
+ *   - stalls on downstream rings (a filter bank waiting for its outputs)
+ *   - p50 / p99 / max latency of a block, from its arrival to its release,
+ *     and of every profiled stage
+ *
+ * and reports every 'interval' seconds: one line on stderr, or the stats
+ * as JSON rewritten in place. rt_monitor_behind() tells a tool to shed
+ * optional work while the ring is filling, before samples are dropped.
+ *
+ * The reader thread reports arrivals and overruns, the consumer the rest;
+ * every call takes the monitor's lock once.
+ */
+
+#define RT_MONITOR_INTERVAL 1.0     // Default report interval in seconds
+
+typedef struct {
+    double elapsed_s;           // Wall time since the monitor started
+    double stream_s;            // Sample time consumed
+    double speed;               // stream_s / elapsed_s (1.0 keeps up with a live source)
+    double lag_s;               // How far the output trails the wall clock
+    double load;                // Fraction of the wall time the consumer was busy
+    uint32_t ring_fill;         // Filled slots at the last arrival
+    uint32_t ring_capacity;
+    uint32_t ring_peak;
+    uint64_t blocks;            // Blocks consumed
+    uint64_t overruns;          // Blocks lost to a full ring
+    uint64_t dropped_samples;
+    uint64_t stalls;            // Downstream ring-full pauses
+    uint64_t degraded;          // Blocks processed with optional work skipped
+    iq_latency_t block_latency;
+} rt_monitor_stats_t;
+
+typedef struct {
+    char tool[64];
+    double sample_rate;
+    uint64_t interval_ns;
+    char *stats_path;           // NULL: report lines on stderr
+
+    pthread_mutex_t lock;
+    uint64_t start_ns;
+    uint64_t next_report_ns;
+    uint64_t samples_arrived;
+    uint64_t samples_consumed;
+    uint64_t idle_ns;
+    uint32_t ring_fill;
+    uint32_t ring_capacity;
+    uint32_t ring_peak;
+    uint64_t blocks;
+    uint64_t overruns;
+    uint64_t dropped_samples;
+    uint64_t stalls;
+    uint64_t degraded;
+    iq_latency_hist_t block_latency;
+} rt_monitor_t;
+
+/*
+ * Monitor a stream of 'sample_rate' samples/s for 'tool'
+ * interval_s of 0 selects RT_MONITOR_INTERVAL; stats_path NULL reports on
+ * stderr. Stage latencies are collected from the profiler, which is
+ * switched on for the run.
+ */
+rt_monitor_t *rt_monitor_create(const char *tool, double sample_rate, double interval_s,
+                                const char *stats_path);
+
+// Print (or write) the final report, if any block was seen, and free the monitor
+void rt_monitor_destroy(rt_monitor_t *monitor);
+
+// Reader: a block of 'samples' arrived, leaving 'fill' of 'capacity' slots filled
+void rt_monitor_arrived(rt_monitor_t *monitor, uint64_t samples, uint32_t fill, uint32_t capacity);
+
+// Reader: a block of 'samples' arrived to a full ring and was dropped
+void rt_monitor_overrun(rt_monitor_t *monitor, uint64_t samples);
+
+// Consumer: waited 'ns' for a block
+void rt_monitor_idle(rt_monitor_t *monitor, uint64_t ns);
+
+// Consumer: released a block of 'samples' 'latency_ns' after it arrived
+void rt_monitor_consumed(rt_monitor_t *monitor, uint64_t samples, uint64_t latency_ns);
+
+// Consumer: a downstream ring was full and processing paused
+void rt_monitor_stall(rt_monitor_t *monitor);
+
+// Consumer: a block was processed with optional work skipped
+void rt_monitor_degraded(rt_monitor_t *monitor);
+
+// True while the ring is three quarters full or more: shed optional work
+bool rt_monitor_behind(rt_monitor_t *monitor);
+
+// Report if the interval has passed (consumer, between blocks)
+void rt_monitor_poll(rt_monitor_t *monitor);
+
+// Snapshot of the counters
+void rt_monitor_get(rt_monitor_t *monitor, rt_monitor_stats_t *stats);
+
+// One report line, or the stats as JSON
+void rt_monitor_print(rt_monitor_t *monitor, FILE *out);
+bool rt_monitor_write_json(rt_monitor_t *monitor, const char *path);
+
+#endif // RT_MONITOR_H
@@ -0,0 +1,267 @@
+/*
+ * IQ Lab - Spectral frame bus
+ *
+ * Single producer, fixed subscriber set: the producer fills ring slots in
+ * frame order and publishes them by bumping 'produced'; each subscriber
+ * copies rows out of the slots behind its own cursor and advances it. Slot
+ * i % ring_frames is rewritten only after every attached cursor passed
+ * frame i, so rows are copied outside the lock.
+ */
+
+#include "spectral_bus.h"
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Look-ahead the producer's block reads past each frame (complex samples)
+#define SPECTRAL_BUS_BLOCK_SAMPLES 65536
+
+// Subscriber the calling thread stands for (spectral_bus_bind)
+static _Thread_local spectral_bus_t *bound_bus;
+static _Thread_local uint32_t bound_subscriber;
+
+// Oldest row an attached subscriber still needs; 'produced' when none is attached
+static uint64_t spectral_bus_oldest(const spectral_bus_t *bus, bool *any) {
+    uint64_t oldest = bus->produced;
+    *any = false;
+    for (uint32_t s = 0; s < bus->subscriber_count; s++) {
+        if (!bus->attached[s]) continue;
+        *any = true;
+        if (bus->next[s] < oldest) oldest = bus->next[s];
+    }
+    return oldest;
+}
+
+static void *spectral_bus_produce(void *arg) {
+    spectral_bus_t *bus = (spectral_bus_t *)arg;
+    const uint32_t n = bus->fft_size;
+    const float *taps = bus->window ? bus->window->coefficients_f32 : NULL;
+    bool failed = false;
+    iq_trace_thread_name("spectral bus");
+
+    for (uint64_t offset = 0; ; offset += bus->hop) {
+        // Wait for a free slot; stop early once nobody reads any more
+        pthread_mutex_lock(&bus->lock);
+        bool any;
+        uint64_t wait_start = iq_profile_begin();
+        bool waited = false;
+        for (;;) {
+            uint64_t oldest = spectral_bus_oldest(bus, &any);
+            if (bus->stop || !any || bus->produced - oldest < bus->ring_frames) break;
+            pthread_cond_wait(&bus->consumed_cond, &bus->lock);
+            waited = true;
+        }
+        if (waited) iq_profile_end(IQ_PROFILE_WAIT, wait_start, 0, 0);
+        bool quit = bus->stop || !any;
+        uint64_t frame = bus->produced;
+        pthread_mutex_unlock(&bus->lock);
+        if (quit) break;
+
+        const float *samples = iq_block_span(&bus->block, offset, n);
+        if (!samples) break;  // End of stream
+
+        size_t slot = (size_t)(frame % bus->ring_frames) * n;
+        uint64_t fft_start = iq_profile_begin();
+        bool fft_ok = fft_spectral_frame_dual(bus->plan, samples, taps,
+                                              bus->rows_f32 ? bus->rows_f32 + slot : NULL,
+                                              bus->rows_f64 ? bus->rows_f64 + slot : NULL, false);
+        iq_profile_end(IQ_PROFILE_FFT, fft_start, n, 0);
+        if (!fft_ok) {
+            fprintf(stderr, "Spectral bus: FFT failed at frame %llu\n", (unsigned long long)frame);
+            failed = true;
+            break;
+        }
+
+        pthread_mutex_lock(&bus->lock);
+        bus->produced++;
+        pthread_cond_broadcast(&bus->produced_cond);
+        pthread_mutex_unlock(&bus->lock);
+    }
+
+    pthread_mutex_lock(&bus->lock);
+    bus->done = true;
+    bus->failed = failed;
+    pthread_cond_broadcast(&bus->produced_cond);
+    pthread_mutex_unlock(&bus->lock);
+    return NULL;
+}
+
+spectral_bus_t *spectral_bus_create(const char *path, uint32_t fft_size, uint32_t hop,
+                                    window_type_t window_type, uint32_t subscribers,
+                                    uint32_t formats) {
+    if (!path || fft_size == 0 || hop == 0 || subscribers == 0 ||
+        subscribers > SPECTRAL_BUS_MAX_SUBSCRIBERS ||
+        (formats & (SPECTRAL_BUS_F32 | SPECTRAL_BUS_F64)) == 0 ||
+        strlen(path) >= sizeof(((spectral_bus_t *)0)->path)) {
+        fprintf(stderr, "Spectral bus: invalid parameters\n");
+        return NULL;
+    }
+
+    spectral_bus_t *bus = calloc(1, sizeof(*bus));
+    if (!bus) return NULL;
+    strcpy(bus->path, path);
+    bus->fft_size = fft_size;
+    bus->hop = hop;
+    bus->window_type = window_type;
+    bus->formats = formats;
+    bus->subscriber_count = subscribers;
+    for (uint32_t s = 0; s < subscribers; s++) bus->attached[s] = true;
+
+    bus->ring_frames = SPECTRAL_BUS_RING_BINS / fft_size;
+    if (bus->ring_frames < 4) bus->ring_frames = 4;
+    size_t bins = (size_t)bus->ring_frames * fft_size;
+    if (formats & SPECTRAL_BUS_F32) bus->rows_f32 = malloc(bins * sizeof(float));
+    if (formats & SPECTRAL_BUS_F64) bus->rows_f64 = malloc(bins * sizeof(double));
+    if (((formats & SPECTRAL_BUS_F32) && !bus->rows_f32) ||
+        ((formats & SPECTRAL_BUS_F64) && !bus->rows_f64)) {
+        fprintf(stderr, "Spectral bus: allocation failed\n");
+        free(bus->rows_f32);
+        free(bus->rows_f64);
+        free(bus);
+        return NULL;
+    }
+
+    if (!iq_reader_open(&bus->reader, path)) {
+        fprintf(stderr, "Spectral bus: failed to open %s\n", path);
+        free(bus->rows_f32);
+        free(bus->rows_f64);
+        free(bus);
+        return NULL;
+    }
+    size_t span = fft_size > hop ? fft_size : hop;
+    bool block_ok = iq_block_init(&bus->block, &bus->reader, span + SPECTRAL_BUS_BLOCK_SAMPLES);
+
+    bus->plan = fft_plan_f32_acquire(fft_size, FFT_FORWARD);
+    if (window_type != WINDOW_RECTANGULAR) {
+        double param = (window_type == WINDOW_KAISER) ? WINDOW_KAISER_DEFAULT_BETA : 0.0;
+        bus->window = window_acquire(window_type, fft_size, param);
+    }
+    if (!block_ok || !bus->plan || (window_type != WINDOW_RECTANGULAR && !bus->window)) {
+        fprintf(stderr, "Spectral bus: failed to set up the %u-point transform\n", fft_size);
+        if (block_ok) iq_block_free(&bus->block);
+        if (bus->plan) fft_plan_f32_release(bus->plan);
+        window_release(bus->window);
+        iq_reader_close(&bus->reader);
+        free(bus->rows_f32);
+        free(bus->rows_f64);
+        free(bus);
+        return NULL;
+    }
+
+    pthread_mutex_init(&bus->lock, NULL);
+    pthread_cond_init(&bus->produced_cond, NULL);
+    pthread_cond_init(&bus->consumed_cond, NULL);
+    return bus;
+}
+
+bool spectral_bus_start(spectral_bus_t *bus) {
+    if (!bus || bus->started) return false;
+    if (pthread_create(&bus->thread, NULL, spectral_bus_produce, bus) != 0) {
+        fprintf(stderr, "Spectral bus: failed to start the producer\n");
+        return false;
+    }
+    bus->started = true;
+    return true;
+}
+
+void spectral_bus_destroy(spectral_bus_t *bus) {
+    if (!bus) return;
+
+    if (bus->started) {
+        pthread_mutex_lock(&bus->lock);
+        bus->stop = true;
+        pthread_cond_broadcast(&bus->consumed_cond);
+        pthread_mutex_unlock(&bus->lock);
+        pthread_join(bus->thread, NULL);
+    }
+
+    pthread_mutex_destroy(&bus->lock);
+    pthread_cond_destroy(&bus->produced_cond);
+    pthread_cond_destroy(&bus->consumed_cond);
+    iq_block_free(&bus->block);
+    iq_reader_close(&bus->reader);
+    fft_plan_f32_release(bus->plan);
+    window_release(bus->window);
+    free(bus->rows_f32);
+    free(bus->rows_f64);
+    free(bus);
+}
+
+// Copy rows of one format out of the ring; see spectral_bus_read_f32
+static uint32_t spectral_bus_read(spectral_bus_t *bus, uint32_t subscriber, void *rows,
+                                  const void *ring, size_t elem_size, uint32_t count) {
+    if (!bus || !rows || !ring || subscriber >= bus->subscriber_count) return 0;
+
+    const size_t row_bytes = (size_t)bus->fft_size * elem_size;
+    uint32_t copied = 0;
+    while (copied < count) {
+        pthread_mutex_lock(&bus->lock);
+        while (bus->attached[subscriber] && bus->next[subscriber] >= bus->produced && !bus->done) {
+            pthread_cond_wait(&bus->produced_cond, &bus->lock);
+        }
+        uint64_t first = bus->next[subscriber];
+        uint64_t available = bus->attached[subscriber] ? bus->produced - first : 0;
+        pthread_mutex_unlock(&bus->lock);
+        if (available == 0) break;
+
+        // Published slots behind the cursor stay put until it moves on
+        uint32_t take = count - copied < available ? count - copied : (uint32_t)available;
+        for (uint32_t f = 0; f < take; f++) {
+            size_t slot = (size_t)((first + f) % bus->ring_frames);
+            memcpy((char *)rows + (size_t)(copied + f) * row_bytes,
+                   (const char *)ring + slot * row_bytes, row_bytes);
+        }
+        copied += take;
+
+        pthread_mutex_lock(&bus->lock);
+        bus->next[subscriber] = first + take;
+        pthread_cond_signal(&bus->consumed_cond);
+        pthread_mutex_unlock(&bus->lock);
+    }
+    return copied;
+}
+
+uint32_t spectral_bus_read_f32(spectral_bus_t *bus, uint32_t subscriber, float *rows, uint32_t count) {
+    return bus ? spectral_bus_read(bus, subscriber, rows, bus->rows_f32, sizeof(float), count) : 0;
+}
+
+uint32_t spectral_bus_read_f64(spectral_bus_t *bus, uint32_t subscriber, double *rows, uint32_t count) {
+    return bus ? spectral_bus_read(bus, subscriber, rows, bus->rows_f64, sizeof(double), count) : 0;
+}
+
+void spectral_bus_detach(spectral_bus_t *bus, uint32_t subscriber) {
+    if (!bus || subscriber >= bus->subscriber_count) return;
+
+    pthread_mutex_lock(&bus->lock);
+    bus->attached[subscriber] = false;
+    pthread_cond_signal(&bus->consumed_cond);
+    pthread_mutex_unlock(&bus->lock);
+}
+
+bool spectral_bus_failed(spectral_bus_t *bus) {
+    if (!bus) return false;
+
+    pthread_mutex_lock(&bus->lock);
+    bool failed = bus->failed;
+    pthread_mutex_unlock(&bus->lock);
+    return failed;
+}
+
+void spectral_bus_bind(spectral_bus_t *bus, uint32_t subscriber) {
+    bound_bus = bus;
+    bound_subscriber = subscriber;
+}
+
+spectral_bus_t *spectral_bus_bound(const char *path, uint32_t fft_size, uint32_t hop,
+                                   window_type_t window_type, uint32_t format,
+                                   uint32_t *subscriber) {
+    spectral_bus_t *bus = bound_bus;
+    if (!bus || !path || strcmp(bus->path, path) != 0 || bus->fft_size != fft_size ||
+        bus->hop != hop || bus->window_type != window_type || (bus->formats & format) != format ||
+        format == 0) {
+        return NULL;
+    }
+    if (subscriber) *subscriber = bound_subscriber;
+    return bus;
+}
@@ -0,0 +1,122 @@
+#ifndef SPECTRAL_BUS_H
+#define SPECTRAL_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "io_iq.h"
+#include "window.h"
+
+/*
+ * Spectral frame bus
+ * One producer thread streams a capture through a single STFT (frames of
+ * fft_size samples every hop, window taps as the tools acquire them) and
+ * publishes each fftshifted linear |X|^2 row to a fixed set of subscribers,
+ * so several consumers (spectrum accumulator, waterfall and tile writers,
+ * CFAR detector, features) share one pass over the file and one FFT per
+ * frame. Rows are computed once per frame in each precision a subscriber
+ * asked for (fft_spectral_frame_dual): float rows equal fft_spectral_frame
+ * / stft_rows and double rows fft_spectral_frame_f64 bit for bit, so a
+ * subscriber's output matches the one it computes for itself.
+ *
+ * Rows sit in a ring of frames; the producer reuses a slot only once every
+ * attached subscriber has read past it, so the slowest consumer sets the
+ * pace and memory stays bounded. Subscribers are counted at creation and
+ * all start attached (none can miss the first rows); one that stops early
+ * or never reads must detach, or the producer stalls once the ring is full.
+ *
+ * Binding: a thread bound to a bus subscriber (spectral_bus_bind) lets tool
+ * code running on it find the bus by its own geometry (spectral_bus_bound)
+ * without any change to the tool's arguments. The pipeline executor binds
+ * the threads of fused steps (pipeline_execute_in_process).
+ */
+
+// Upper bound on subscribers of one bus
+#define SPECTRAL_BUS_MAX_SUBSCRIBERS 16
+
+// Ring size target in bins (frames = bins / fft_size, at least 4)
+#define SPECTRAL_BUS_RING_BINS (1u << 20)
+
+// Row formats a subscriber reads (bit mask)
+#define SPECTRAL_BUS_F32 1u
+#define SPECTRAL_BUS_F64 2u
+
+typedef struct spectral_bus spectral_bus_t;
+
+struct spectral_bus {
+    // Geometry (the key subscribers match)
+    char path[1024];
+    uint32_t fft_size;
+    uint32_t hop;
+    window_type_t window_type;
+    uint32_t formats;               // SPECTRAL_BUS_F32 | SPECTRAL_BUS_F64
+
+    // Ring of published rows, frame i in slot i % ring_frames
+    uint32_t ring_frames;
+    float *rows_f32;                // ring_frames * fft_size, or NULL
+    double *rows_f64;               // ring_frames * fft_size, or NULL
+
+    // Producer
+    pthread_t thread;
+    bool started;
+    iq_reader_t reader;
+    iq_block_t block;
+    const fft_plan_f32_t *plan;
+    const window_t *window;
+
+    // Shared state under lock
+    pthread_mutex_t lock;
+    pthread_cond_t produced_cond;   // Signalled when a row is published
+    pthread_cond_t consumed_cond;   // Signalled when a subscriber advances
+    uint64_t produced;              // Rows published so far
+    bool done;                      // No more rows (end of file or error)
+    bool failed;                    // The producer stopped on an error
+    bool stop;                      // Destroy requested
+    uint32_t subscriber_count;
+    uint64_t next[SPECTRAL_BUS_MAX_SUBSCRIBERS];    // Next row each one reads
+    bool attached[SPECTRAL_BUS_MAX_SUBSCRIBERS];
+};
+
+/*
+ * Create a bus over 'path' for 'subscribers' consumers and open the input
+ * (iq_reader_open, so a published iq_source_t is shared). Kaiser windows use
+ * WINDOW_KAISER_DEFAULT_BETA, as in iqls and iqdetect. Returns NULL on error.
+ */
+spectral_bus_t *spectral_bus_create(const char *path, uint32_t fft_size, uint32_t hop,
+                                    window_type_t window_type, uint32_t subscribers,
+                                    uint32_t formats);
+
+// Start the producer thread
+bool spectral_bus_start(spectral_bus_t *bus);
+
+// Stop the producer (if still running), join it and free the bus
+void spectral_bus_destroy(spectral_bus_t *bus);
+
+/*
+ * Copy the subscriber's next 'count' rows into 'rows' (count * fft_size
+ * values), blocking until they are published. Returns the number of rows
+ * copied: fewer than 'count' only at end of stream (or on a producer
+ * error, see spectral_bus_failed). The format must be one the bus computes.
+ */
+uint32_t spectral_bus_read_f32(spectral_bus_t *bus, uint32_t subscriber, float *rows, uint32_t count);
+uint32_t spectral_bus_read_f64(spectral_bus_t *bus, uint32_t subscriber, double *rows, uint32_t count);
+
+// Stop reading: the producer no longer waits for this subscriber (idempotent)
+void spectral_bus_detach(spectral_bus_t *bus, uint32_t subscriber);
+
+// True once the producer stopped on a read or transform error
+bool spectral_bus_failed(spectral_bus_t *bus);
+
+// Bind the calling thread to a subscriber of 'bus' (NULL clears the binding)
+void spectral_bus_bind(spectral_bus_t *bus, uint32_t subscriber);
+
+/*
+ * The bus bound to the calling thread if its geometry is path / fft_size /
+ * hop / window_type and it computes 'format', else NULL. Fills 'subscriber'.
+ */
+spectral_bus_t *spectral_bus_bound(const char *path, uint32_t fft_size, uint32_t hop,
+                                   window_type_t window_type, uint32_t format,
+                                   uint32_t *subscriber);
+
+#endif // SPECTRAL_BUS_H
@@ -0,0 +1,111 @@
+/*
+ * IQ Lab - Lock-free SPSC queue
+ *
+ * head and tail count pushes and pops since init and are never wrapped;
+ * the slot is the count masked by capacity - 1 and the fill level is
+ * head - tail. Each side reads its own index relaxed and publishes it with
+ * release; the other side's index is read with acquire.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // sched_yield under -std=c11
+#endif
+
+#include "spsc_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+// Failed attempts before a waiting side starts yielding its time slice
+#define IQ_SPSC_SPIN_LIMIT 256
+
+static void iq_spsc_backoff(uint32_t *spins) {
+    if (*spins < IQ_SPSC_SPIN_LIMIT) {
+        (*spins)++;
+        return;
+    }
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+bool iq_spsc_init(iq_spsc_t *queue, uint32_t capacity) {
+    if (!queue || capacity == 0 || capacity > (1u << 31)) {
+        return false;
+    }
+
+    uint32_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    queue->items = calloc(size, sizeof(void *));
+    if (!queue->items) {
+        fprintf(stderr, "Error: Failed to allocate SPSC queue of %u items\n", size);
+        return false;
+    }
+    queue->capacity = size;
+    queue->mask = size - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return true;
+}
+
+void iq_spsc_free(iq_spsc_t *queue) {
+    if (!queue) return;
+    free(queue->items);
+    queue->items = NULL;
+    queue->capacity = 0;
+    queue->mask = 0;
+}
+
+bool iq_spsc_try_push(iq_spsc_t *queue, void *item) {
+    uint_fast64_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint_fast64_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail >= queue->capacity) {
+        return false;
+    }
+
+    queue->items[head & queue->mask] = item;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool iq_spsc_try_pop(iq_spsc_t *queue, void **item) {
+    uint_fast64_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint_fast64_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+
+    *item = queue->items[tail & queue->mask];
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+void iq_spsc_push(iq_spsc_t *queue, void *item) {
+    uint32_t spins = 0;
+    while (!iq_spsc_try_push(queue, item)) {
+        iq_spsc_backoff(&spins);
+    }
+}
+
+void *iq_spsc_pop(iq_spsc_t *queue) {
+    void *item;
+    uint32_t spins = 0;
+    while (!iq_spsc_try_pop(queue, &item)) {
+        iq_spsc_backoff(&spins);
+    }
+    return item;
+}
+
+uint32_t iq_spsc_size(iq_spsc_t *queue) {
+    uint_fast64_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    uint_fast64_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    return (uint32_t)(head - tail);
+}
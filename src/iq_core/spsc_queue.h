@@ -0,0 +1,58 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+ * Lock-free single-producer / single-consumer pointer queue
+ * A power-of-two ring with one atomic index per side: the producer only
+ * writes 'head', the consumer only writes 'tail', and each reads the other's
+ * index with acquire ordering, so an item's contents are visible to the
+ * consumer once the pointer is. Exactly one thread may push and one thread
+ * may pop; stages that fan out or in use one queue per pair of threads.
+ *
+ * The blocking calls spin briefly and then yield, so a stalled side costs
+ * no lock and no system call beyond sched_yield. NULL is a valid item and
+ * is used by the tools as an end-of-stream marker.
+ */
+
+// Cache line size used to keep the two indices apart
+#define IQ_SPSC_CACHE_LINE 64
+
+typedef struct {
+    void **items;               // capacity slots
+    uint32_t capacity;          // Power of two
+    uint32_t mask;              // capacity - 1
+
+    _Alignas(IQ_SPSC_CACHE_LINE) atomic_uint_fast64_t head; // Next slot to push (producer)
+    _Alignas(IQ_SPSC_CACHE_LINE) atomic_uint_fast64_t tail; // Next slot to pop (consumer)
+} iq_spsc_t;
+
+/*
+ * Initialize a queue holding at least 'capacity' items (rounded up to a
+ * power of two). Returns false on a zero capacity or allocation failure.
+ */
+bool iq_spsc_init(iq_spsc_t *queue, uint32_t capacity);
+
+// Free the ring; no thread may be using the queue
+void iq_spsc_free(iq_spsc_t *queue);
+
+// Push without waiting; false if the queue is full (producer only)
+bool iq_spsc_try_push(iq_spsc_t *queue, void *item);
+
+// Pop without waiting; false if the queue is empty (consumer only)
+bool iq_spsc_try_pop(iq_spsc_t *queue, void **item);
+
+// Push, waiting while the queue is full (producer only)
+void iq_spsc_push(iq_spsc_t *queue, void *item);
+
+// Pop, waiting while the queue is empty (consumer only)
+void *iq_spsc_pop(iq_spsc_t *queue);
+
+// Items currently queued; exact only when called from one of the two sides
+uint32_t iq_spsc_size(iq_spsc_t *queue);
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,282 @@
+/*
+ * IQ Lab - Parallel STFT engine
+ *
+ * Fork/join over a persistent pool: stft_dispatch() publishes a phase by
+ * bumping 'generation', runs worker 0's share on the calling thread and
+ * waits for the pool. Slices are fixed by worker index, so the output does
+ * not depend on scheduling.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // sysconf under -std=c11
+#endif
+
+#include "stft.h"
+#include "affinity.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+enum {
+    STFT_PHASE_TRANSFORM,
+    STFT_PHASE_ACCUMULATE,
+    STFT_PHASE_PSD
+};
+
+uint32_t stft_default_threads(void) {
+    long count;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = (long)info.dwNumberOfProcessors;
+#else
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (count < 1) count = 1;
+    if (count > STFT_MAX_THREADS) count = STFT_MAX_THREADS;
+    return (uint32_t)count;
+}
+
+// Worker 'index' share of [0, total): contiguous and fixed by index
+static void stft_slice(uint64_t total, uint32_t index, uint32_t parts,
+                       uint64_t *begin, uint64_t *end) {
+    *begin = total * index / parts;
+    *end = total * (index + 1) / parts;
+}
+
+// One worker's part of the current phase
+static bool stft_run_share(stft_t *stft, uint32_t index) {
+    uint64_t begin, end;
+
+    if (stft->phase == STFT_PHASE_TRANSFORM) {
+        stft_slice(stft->num_frames, index, stft->num_threads, &begin, &end);
+        if (begin == end) return true;
+        return fft_spectral_batch(stft->plan, stft->iq + begin * stft->hop * 2,
+                                  (uint32_t)(end - begin), stft->hop, stft->window,
+                                  stft->rows + begin * stft->fft_size, stft->db);
+    }
+
+    // Sum this worker's bins over every frame, oldest frame first
+    stft_slice(stft->fft_size, index, stft->num_threads, &begin, &end);
+    if (stft->phase == STFT_PHASE_PSD) {
+        psd_add_range(stft->psd, stft->sum_rows, stft->num_frames, (uint32_t)begin, (uint32_t)end);
+        return true;
+    }
+    for (uint32_t f = 0; f < stft->num_frames; f++) {
+        const float *row = stft->sum_rows + (size_t)f * stft->fft_size;
+        for (uint64_t k = begin; k < end; k++) {
+            stft->accum[k] += row[k];
+        }
+    }
+    return true;
+}
+
+static void *stft_thread(void *arg) {
+    stft_worker_t *worker = (stft_worker_t *)arg;
+    stft_t *stft = worker->stft;
+    uint64_t seen = 0;
+
+    // Pinned before the first FFT, so the thread's scratch is node-local
+    iq_affinity_pin_next();
+
+    pthread_mutex_lock(&stft->lock);
+    for (;;) {
+        while (stft->generation == seen && !stft->stop) {
+            pthread_cond_wait(&stft->work_cond, &stft->lock);
+        }
+        if (stft->stop) break;
+        seen = stft->generation;
+        pthread_mutex_unlock(&stft->lock);
+
+        iq_arena_bind(stft->arena);
+        iq_alloc_guard(stft->guarded);
+        bool ok = stft_run_share(stft, worker->index);
+
+        pthread_mutex_lock(&stft->lock);
+        if (!ok) stft->failed = true;
+        if (--stft->busy == 0) pthread_cond_signal(&stft->done_cond);
+    }
+    pthread_mutex_unlock(&stft->lock);
+
+    iq_alloc_guard(false);
+    iq_arena_bind(NULL);
+    return NULL;
+}
+
+// Run one phase on every worker and wait for all of them
+static bool stft_dispatch(stft_t *stft, int phase) {
+    stft->phase = phase;
+    stft->failed = false;
+    stft->arena = iq_arena_current();
+    stft->guarded = iq_alloc_guarded();
+
+    if (stft->num_threads > 1) {
+        pthread_mutex_lock(&stft->lock);
+        stft->busy = stft->num_threads - 1;
+        stft->generation++;
+        pthread_cond_broadcast(&stft->work_cond);
+        pthread_mutex_unlock(&stft->lock);
+    }
+
+    bool ok = stft_run_share(stft, 0);
+
+    if (stft->num_threads > 1) {
+        pthread_mutex_lock(&stft->lock);
+        while (stft->busy > 0) {
+            pthread_cond_wait(&stft->done_cond, &stft->lock);
+        }
+        if (stft->failed) ok = false;
+        pthread_mutex_unlock(&stft->lock);
+    }
+
+    return ok;
+}
+
+stft_t *stft_create(const fft_plan_f32_t *plan, const float *window, uint32_t num_threads) {
+    if (!plan) {
+        fprintf(stderr, "Error: STFT engine needs an FFT plan\n");
+        return NULL;
+    }
+
+    if (num_threads == 0) num_threads = stft_default_threads();
+    if (num_threads > STFT_MAX_THREADS) num_threads = STFT_MAX_THREADS;
+
+    stft_t *stft = (stft_t *)calloc(1, sizeof(stft_t));
+    if (!stft) {
+        fprintf(stderr, "Error: Failed to allocate STFT engine\n");
+        return NULL;
+    }
+
+    stft->plan = plan;
+    stft->window = window;
+    stft->fft_size = plan->size;
+    stft->num_threads = 1;
+    if (num_threads == 1) {
+        return stft;
+    }
+
+    stft->threads = (pthread_t *)calloc(num_threads - 1, sizeof(pthread_t));
+    stft->workers = (stft_worker_t *)calloc(num_threads - 1, sizeof(stft_worker_t));
+    if (!stft->threads || !stft->workers) {
+        fprintf(stderr, "Error: Failed to allocate %u STFT workers\n", num_threads);
+        free(stft->threads);
+        free(stft->workers);
+        free(stft);
+        return NULL;
+    }
+
+    pthread_mutex_init(&stft->lock, NULL);
+    pthread_cond_init(&stft->work_cond, NULL);
+    pthread_cond_init(&stft->done_cond, NULL);
+
+    // Slices are sized by the final count, so fix it before any thread runs
+    uint32_t started = 0;
+    for (uint32_t t = 1; t < num_threads; t++) {
+        stft->workers[t - 1].stft = stft;
+        stft->workers[t - 1].index = t;
+    }
+    stft->num_threads = num_threads;
+    for (; started < num_threads - 1; started++) {
+        if (pthread_create(&stft->threads[started], NULL, stft_thread, &stft->workers[started]) != 0) {
+            break;
+        }
+    }
+
+    // Fewer threads than asked for: run with the pool that did start
+    if (started < num_threads - 1) {
+        fprintf(stderr, "Warning: Started %u of %u STFT threads\n", started + 1, num_threads);
+        pthread_mutex_lock(&stft->lock);
+        stft->num_threads = started + 1;
+        pthread_mutex_unlock(&stft->lock);
+    }
+
+    return stft;
+}
+
+bool stft_rows(stft_t *stft, const float *iq, uint32_t num_frames, size_t hop,
+               float *rows, bool db) {
+    if (!stft || !iq || !rows) return false;
+    if (num_frames == 0) return true;
+
+    if (stft->backend_rows) {
+        if (stft->backend_rows(stft->backend, iq, num_frames, hop, rows, db)) return true;
+        fprintf(stderr, "Warning: STFT backend failed; continuing on %u CPU threads\n", stft->num_threads);
+        stft->backend_rows = NULL;
+        stft->backend = NULL;
+    }
+
+    stft->iq = iq;
+    stft->num_frames = num_frames;
+    stft->hop = hop;
+    stft->rows = rows;
+    stft->db = db;
+    stft->accum = NULL;
+
+    return stft_dispatch(stft, STFT_PHASE_TRANSFORM);
+}
+
+bool stft_accumulate_rows(stft_t *stft, const float *rows, uint32_t num_frames, double *accum) {
+    if (!stft || !rows || !accum) return false;
+    if (num_frames == 0) return true;
+
+    stft->sum_rows = rows;
+    stft->num_frames = num_frames;
+    stft->accum = accum;
+
+    return stft_dispatch(stft, STFT_PHASE_ACCUMULATE);
+}
+
+bool stft_accumulate_psd(stft_t *stft, const float *rows, uint32_t num_frames, psd_t *psd) {
+    if (!stft || !rows || !psd || psd->bins != stft->fft_size) return false;
+    if (num_frames == 0) return true;
+
+    stft->sum_rows = rows;
+    stft->num_frames = num_frames;
+    stft->psd = psd;
+
+    if (!stft_dispatch(stft, STFT_PHASE_PSD)) return false;
+    psd_advance(psd, num_frames);
+    return true;
+}
+
+bool stft_accumulate(stft_t *stft, const float *iq, uint32_t num_frames, size_t hop,
+                     float *rows, double *accum) {
+    if (!stft || !accum) return false;
+
+    if (!stft_rows(stft, iq, num_frames, hop, rows, false)) return false;
+    return stft_accumulate_rows(stft, rows, num_frames, accum);
+}
+
+void stft_set_backend(stft_t *stft, stft_backend_rows_fn rows, void *backend) {
+    if (!stft) return;
+    stft->backend_rows = rows;
+    stft->backend = rows ? backend : NULL;
+}
+
+void stft_destroy(stft_t *stft) {
+    if (!stft) return;
+
+    if (stft->threads) {
+        pthread_mutex_lock(&stft->lock);
+        stft->stop = true;
+        pthread_cond_broadcast(&stft->work_cond);
+        pthread_mutex_unlock(&stft->lock);
+
+        for (uint32_t t = 0; t + 1 < stft->num_threads; t++) {
+            pthread_join(stft->threads[t], NULL);
+        }
+
+        pthread_cond_destroy(&stft->done_cond);
+        pthread_cond_destroy(&stft->work_cond);
+        pthread_mutex_destroy(&stft->lock);
+    }
+
+    free(stft->threads);
+    free(stft->workers);
+    free(stft);
+}
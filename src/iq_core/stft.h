@@ -0,0 +1,128 @@
+#ifndef STFT_H
+#define STFT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "fft.h"
+#include "arena.h"
+#include "psd.h"
+
+/*
+ * Parallel STFT engine
+ * A fixed pool of worker threads turns batches of overlapping frames into
+ * fftshifted spectral rows (fft_spectral_batch). The calling thread takes
+ * part as worker 0, so a one-thread engine runs inline with no pool at all.
+ *
+ * Work is split by index, never by completion order: each worker transforms
+ * a contiguous slice of the batch's frames, then owns a contiguous range of
+ * bins when rows are summed. Every bin is therefore accumulated frame by
+ * frame in file order, and results are bit-identical to the serial loop for
+ * any thread count.
+ *
+ * The plan and window are shared read-only; FFT scratch is per thread.
+ * Each phase runs under the dispatching thread's scratch arena and heap
+ * allocation guard (arena.h), so a pipeline that reserved an arena and
+ * finished warming up covers its pool threads as well.
+ */
+
+// Upper bound on worker threads
+#define STFT_MAX_THREADS 64
+
+typedef struct stft stft_t;
+
+/*
+ * Optional row backend (e.g. an OpenCL device, gpu.h): same contract as
+ * stft_rows for one whole batch. Its rows need not be bit-identical to the
+ * pool's.
+ */
+typedef bool (*stft_backend_rows_fn)(void *backend, const float *iq, uint32_t num_frames,
+                                     size_t hop, float *rows, bool db);
+
+// Per-worker context handed to each pool thread
+typedef struct {
+    stft_t *stft;
+    uint32_t index;
+} stft_worker_t;
+
+struct stft {
+    const fft_plan_f32_t *plan;  // Shared plan (not owned)
+    const float *window;         // N taps or NULL for rectangular (not owned)
+    uint32_t fft_size;
+    uint32_t num_threads;        // Workers including the calling thread
+
+    pthread_t *threads;          // num_threads - 1 pool threads
+    stft_worker_t *workers;      // Their contexts
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;    // Signalled when a phase is dispatched
+    pthread_cond_t done_cond;    // Signalled when the last pool thread finishes
+    uint64_t generation;         // Incremented per dispatched phase
+    uint32_t busy;               // Pool threads still in the current phase
+    bool stop;                   // Destroy requested
+    bool failed;                 // A worker failed in the current phase
+
+    // Current job
+    int phase;                   // Transform or accumulate
+    const float *iq;             // First frame, interleaved I/Q
+    uint32_t num_frames;
+    size_t hop;                  // Frame spacing in complex samples
+    bool db;                     // Rows in dB instead of linear power
+    float *rows;                 // num_frames * fft_size output rows
+    const float *sum_rows;       // Rows summed by the accumulate phase
+    double *accum;               // fft_size running sums (accumulate only)
+    psd_t *psd;                  // Estimator folded by the PSD phase
+    iq_arena_t *arena;           // Dispatcher's scratch arena
+    bool guarded;                // Dispatcher's allocation guard
+
+    stft_backend_rows_fn backend_rows; // Replaces the transform phase when set
+    void *backend;               // Its state (not owned)
+};
+
+// Online CPU count, clamped to [1, STFT_MAX_THREADS]
+uint32_t stft_default_threads(void);
+
+/*
+ * Create an engine for one plan and window
+ * num_threads of 0 selects stft_default_threads().
+ */
+stft_t *stft_create(const fft_plan_f32_t *plan, const float *window, uint32_t num_threads);
+
+/*
+ * Spectral rows for 'num_frames' frames spaced 'hop' complex samples apart,
+ * written back to back in 'rows' (num_frames * N floats), linear or dB
+ */
+bool stft_rows(stft_t *stft, const float *iq, uint32_t num_frames, size_t hop,
+               float *rows, bool db);
+
+/*
+ * Add the linear power rows of 'num_frames' frames into accum[0..N), frame
+ * by frame in order; 'rows' is caller-provided scratch of num_frames * N
+ */
+bool stft_accumulate(stft_t *stft, const float *iq, uint32_t num_frames, size_t hop,
+                     float *rows, double *accum);
+
+/*
+ * Add 'num_frames' rows already produced by stft_rows (linear power) into
+ * accum[0..N) in frame order, e.g. when the same rows also feed a waterfall
+ */
+bool stft_accumulate_rows(stft_t *stft, const float *rows, uint32_t num_frames, double *accum);
+
+/*
+ * Fold 'num_frames' linear power rows into a PSD accumulator of N bins,
+ * each worker taking a contiguous bin range (psd_add_range), so the
+ * estimate is bit-identical for any thread count
+ */
+bool stft_accumulate_psd(stft_t *stft, const float *rows, uint32_t num_frames, psd_t *psd);
+
+/*
+ * Send stft_rows batches to 'rows' instead of the pool (NULL restores the
+ * pool). If the backend fails, that batch is redone on the pool and the
+ * backend is dropped for the rest of the run.
+ */
+void stft_set_backend(stft_t *stft, stft_backend_rows_fn rows, void *backend);
+
+// Stop the pool and free the engine (the plan and window stay valid)
+void stft_destroy(stft_t *stft);
+
+#endif // STFT_H
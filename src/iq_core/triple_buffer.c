@@ -0,0 +1,69 @@
+/*
+ * IQ Lab - Lock-free triple buffer
+ *
+ * 'middle' packs the middle slot index (bits 0-1) with a fresh flag set by
+ * publish and cleared by acquire. The exchange is acq_rel on both sides:
+ * release makes the producer's writes to the slot it gives away visible,
+ * acquire makes the slot it gets back safe to overwrite.
+ */
+
+#include "triple_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define IQ_TRIPLE_INDEX 3u
+#define IQ_TRIPLE_FRESH 4u
+
+bool iq_triple_init(iq_triple_t *triple, size_t slot_bytes) {
+    if (!triple || slot_bytes == 0) {
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        triple->slots[i] = calloc(1, slot_bytes);
+        if (!triple->slots[i]) {
+            fprintf(stderr, "Error: Failed to allocate triple buffer of %zu bytes\n", slot_bytes);
+            while (--i >= 0) free(triple->slots[i]);
+            return false;
+        }
+    }
+    triple->slot_bytes = slot_bytes;
+    triple->front = 0;
+    triple->back = 2;
+    atomic_init(&triple->middle, 1u);
+    return true;
+}
+
+void iq_triple_free(iq_triple_t *triple) {
+    if (!triple) return;
+    for (int i = 0; i < 3; i++) {
+        free(triple->slots[i]);
+        triple->slots[i] = NULL;
+    }
+    triple->slot_bytes = 0;
+}
+
+void *iq_triple_back(iq_triple_t *triple) {
+    return triple->slots[triple->back];
+}
+
+void iq_triple_publish(iq_triple_t *triple) {
+    unsigned previous = atomic_exchange_explicit(&triple->middle, triple->back | IQ_TRIPLE_FRESH,
+                                                 memory_order_acq_rel);
+    triple->back = previous & IQ_TRIPLE_INDEX;
+}
+
+bool iq_triple_acquire(iq_triple_t *triple) {
+    if (!(atomic_load_explicit(&triple->middle, memory_order_relaxed) & IQ_TRIPLE_FRESH)) {
+        return false;
+    }
+    // Only the producer can set the flag again, so the slot taken is fresh
+    unsigned previous = atomic_exchange_explicit(&triple->middle, triple->front,
+                                                 memory_order_acq_rel);
+    triple->front = previous & IQ_TRIPLE_INDEX;
+    return true;
+}
+
+const void *iq_triple_front(const iq_triple_t *triple) {
+    return triple->slots[triple->front];
+}
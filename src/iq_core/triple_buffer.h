@@ -0,0 +1,58 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+ * Lock-free single-producer / single-consumer triple buffer
+ * Three equal slots: the producer fills its back slot, the consumer reads
+ * its front slot, and the third ("middle") holds the latest finished frame.
+ * Publishing swaps back and middle, acquiring swaps middle and front, each
+ * with one atomic exchange, so neither side ever waits for the other and a
+ * slow consumer simply skips frames: it always gets the newest one.
+ *
+ * For a producer that outpaces its display (a DSP worker feeding a render
+ * loop); use iq_spsc_t when every item must be delivered.
+ */
+
+// Cache line size used to keep the two sides apart
+#define IQ_TRIPLE_CACHE_LINE 64
+
+typedef struct {
+    uint8_t *slots[3];          // slot_bytes each, zeroed at init
+    size_t slot_bytes;
+
+    _Alignas(IQ_TRIPLE_CACHE_LINE) atomic_uint middle; // Middle slot index | IQ_TRIPLE_FRESH
+    _Alignas(IQ_TRIPLE_CACHE_LINE) uint32_t back;      // Producer's slot
+    _Alignas(IQ_TRIPLE_CACHE_LINE) uint32_t front;     // Consumer's slot
+} iq_triple_t;
+
+/*
+ * Allocate three zeroed slots of 'slot_bytes' bytes
+ * Returns false on a zero size or allocation failure.
+ */
+bool iq_triple_init(iq_triple_t *triple, size_t slot_bytes);
+
+// Free the slots; no thread may be using the buffer
+void iq_triple_free(iq_triple_t *triple);
+
+// Slot to fill with the next frame (producer only)
+void *iq_triple_back(iq_triple_t *triple);
+
+// Hand the back slot to the consumer; an unread frame it replaces is dropped
+void iq_triple_publish(iq_triple_t *triple);
+
+/*
+ * Take the newest published frame as the front slot (consumer only)
+ * Returns false, leaving the front slot as it was, when nothing was
+ * published since the last call.
+ */
+bool iq_triple_acquire(iq_triple_t *triple);
+
+// Frame last taken by iq_triple_acquire, all zeros before (consumer only)
+const void *iq_triple_front(const iq_triple_t *triple);
+
+#endif // TRIPLE_BUFFER_H
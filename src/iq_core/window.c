@@ -0,0 +1,559 @@
+/*
+ * =============================================================================
+ * IQ Lab - Window Function Module
+ * =============================================================================
+ *
+ * PURPOSE:
+ *   Provides the tapering windows used ahead of FFTs and in FIR design, with
+ *   the spectral figures of merit (coherent gain, ENBW, scalloping loss)
+ *   needed to correct power and SNR measurements for the window.
+ *
+ * WINDOWS:
+ *   - Rectangular, Hann, Hamming, Blackman
+ *   - 4-term Blackman-Harris and 5-term flat-top
+ *   - Kaiser-Bessel with caller-chosen beta
+ *   - DPSS (first Slepian sequence) with caller-chosen NW
+ *
+ * PERFORMANCE:
+ *   - Taps are generated once per (type, size, param) in double and float
+ *   - window_acquire() shares tables process-wide, so per-frame code only
+ *     multiplies; CFAR/SNR corrections read the cached figures instead of
+ *     re-summing the taps every frame
+ *   - DPSS uses Sturm-sequence bisection plus inverse iteration on the
+ *     tridiagonal Slepian matrix: O(N) per step, no dense eigensolver
+ *
+ * USAGE:
+ *   1. const window_t *w = window_acquire(WINDOW_HANN, N, 0.0)
+ *   2. fft_spectral_frame(plan, iq, w->coefficients_f32, row, true)
+ *   3. snr_db -= 10 * log10(w->enbw_bins)
+ *   4. window_release(w)
+ *
+ * =============================================================================
+ */
+
+#include "window.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <stdatomic.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Internal helper functions
+static bool window_generate(window_type_t type, uint32_t size, double param, double *w);
+static void window_cosine_sum(double *w, uint32_t size, const double *a, uint32_t terms);
+static void window_normalize_peak(double *w, uint32_t size);
+static double window_bessel_i0(double x);
+static bool window_dpss(double *w, uint32_t size, double nw);
+static void window_compute_metrics(window_t *window);
+
+/*
+ * Window cache: a short list searched linearly under a spinlock, the same
+ * scheme as the FFT plan cache. There are only ever a handful of distinct
+ * (type, size, param) keys in one process.
+ */
+#define WINDOW_CACHE_SLOTS 32
+
+typedef struct {
+    window_t *window;
+    uint32_t refcount;
+} window_cache_entry_t;
+
+static window_cache_entry_t window_cache[WINDOW_CACHE_SLOTS];
+static atomic_flag window_cache_lock = ATOMIC_FLAG_INIT;
+
+// Window names, indexed by window_type_t
+static const char *const window_names[WINDOW_TYPE_COUNT] = {
+    "rectangular", "hann", "hamming", "blackman",
+    "blackman-harris", "flat-top", "kaiser", "dpss"
+};
+
+// Create window with default parameters
+window_t *window_create(window_type_t type, uint32_t size) {
+    double param = 0.0;
+    if (type == WINDOW_KAISER) param = WINDOW_KAISER_DEFAULT_BETA;
+    if (type == WINDOW_DPSS) param = WINDOW_DPSS_DEFAULT_NW;
+    return window_create_param(type, size, param);
+}
+
+// Create window with explicit parameter
+window_t *window_create_param(window_type_t type, uint32_t size, double param) {
+    if (size == 0 || (int)type < 0 || (int)type >= WINDOW_TYPE_COUNT) {
+        return NULL;
+    }
+    if (type != WINDOW_KAISER && type != WINDOW_DPSS) {
+        param = 0.0;
+    }
+    if ((type == WINDOW_KAISER && param < 0.0) ||
+        (type == WINDOW_DPSS && (param <= 0.0 || param >= size / 2.0 + 0.5))) {
+        if (size > 1) return NULL;
+    }
+
+    window_t *window = (window_t *)calloc(1, sizeof(window_t));
+    if (!window) {
+        return NULL;
+    }
+
+    window->type = type;
+    window->size = size;
+    window->param = param;
+    window->coefficients = (double *)malloc(size * sizeof(double));
+    window->coefficients_f32 = (float *)malloc(size * sizeof(float));
+
+    if (!window->coefficients || !window->coefficients_f32 ||
+        !window_generate(type, size, param, window->coefficients)) {
+        window_destroy(window);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        window->coefficients_f32[i] = (float)window->coefficients[i];
+    }
+
+    window_compute_metrics(window);
+    return window;
+}
+
+// Create window from name (unknown names fall back to Hann)
+window_t *window_create_from_name(const char *name, uint32_t size) {
+    window_type_t type;
+    if (!window_type_from_name(name, &type)) {
+        type = WINDOW_HANN;
+    }
+    return window_create(type, size);
+}
+
+// Destroy window
+void window_destroy(window_t *window) {
+    if (!window) return;
+
+    free(window->coefficients);
+    free(window->coefficients_f32);
+    free(window);
+}
+
+// Internal: Spin on the cache lock (held only for slot bookkeeping)
+static void window_cache_lock_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&window_cache_lock, memory_order_acquire)) {
+        // Busy-wait; windows are generated outside the lock
+    }
+}
+
+static void window_cache_lock_release(void) {
+    atomic_flag_clear_explicit(&window_cache_lock, memory_order_release);
+}
+
+// Internal: Cached entry for a key, caller holds the lock
+static window_cache_entry_t *window_cache_find(window_type_t type, uint32_t size, double param) {
+    for (uint32_t i = 0; i < WINDOW_CACHE_SLOTS; i++) {
+        window_t *w = window_cache[i].window;
+        if (w && w->type == type && w->size == size && w->param == param) {
+            return &window_cache[i];
+        }
+    }
+    return NULL;
+}
+
+// Acquire a shared window table
+const window_t *window_acquire(window_type_t type, uint32_t size, double param) {
+    if (type == WINDOW_DPSS && param == 0.0) param = WINDOW_DPSS_DEFAULT_NW;
+    if (type != WINDOW_KAISER && type != WINDOW_DPSS) param = 0.0;
+
+    window_cache_lock_acquire();
+    window_cache_entry_t *entry = window_cache_find(type, size, param);
+    if (entry) {
+        entry->refcount++;
+        const window_t *window = entry->window;
+        window_cache_lock_release();
+        return window;
+    }
+    window_cache_lock_release();
+
+    // Miss: generate without holding the lock
+    window_t *built = window_create_param(type, size, param);
+    if (!built) {
+        return NULL;
+    }
+
+    window_cache_lock_acquire();
+    const window_t *window = built;
+    entry = window_cache_find(type, size, param);
+    if (entry) {
+        entry->refcount++;
+        window = entry->window;
+    } else {
+        for (uint32_t i = 0; i < WINDOW_CACHE_SLOTS; i++) {
+            if (!window_cache[i].window) {
+                entry = &window_cache[i];
+                break;
+            }
+        }
+        if (entry) {
+            entry->window = built;
+            entry->refcount = 1;
+        }
+        built = NULL;   // Published, or handed out uncached when the list is full
+    }
+    window_cache_lock_release();
+
+    // Another thread published the same table first
+    window_destroy(built);
+    return window;
+}
+
+// Release a window obtained from window_acquire
+void window_release(const window_t *window) {
+    if (!window) return;
+
+    bool cached = false;
+    window_cache_lock_acquire();
+    for (uint32_t i = 0; i < WINDOW_CACHE_SLOTS; i++) {
+        if (window_cache[i].window == window) {
+            if (window_cache[i].refcount > 0) window_cache[i].refcount--;
+            cached = true;
+            break;
+        }
+    }
+    window_cache_lock_release();
+
+    if (!cached) {
+        window_destroy((window_t *)window);
+    }
+}
+
+// Free every cached window with no outstanding references
+uint32_t window_cache_clear(void) {
+    window_t *to_free[WINDOW_CACHE_SLOTS] = {0};
+    uint32_t freed = 0;
+
+    window_cache_lock_acquire();
+    for (uint32_t i = 0; i < WINDOW_CACHE_SLOTS; i++) {
+        if (window_cache[i].window && window_cache[i].refcount == 0) {
+            to_free[i] = window_cache[i].window;
+            window_cache[i].window = NULL;
+        }
+    }
+    window_cache_lock_release();
+
+    for (uint32_t i = 0; i < WINDOW_CACHE_SLOTS; i++) {
+        if (to_free[i]) {
+            window_destroy(to_free[i]);
+            freed++;
+        }
+    }
+
+    return freed;
+}
+
+// Parse window name
+bool window_type_from_name(const char *name, window_type_t *type) {
+    if (!name || !type) return false;
+
+    char lower[32];
+    size_t len = strlen(name);
+    if (len >= sizeof(lower)) return false;
+    for (size_t i = 0; i <= len; i++) {
+        lower[i] = (char)tolower((unsigned char)name[i]);
+    }
+
+    for (int t = 0; t < WINDOW_TYPE_COUNT; t++) {
+        if (strcmp(lower, window_names[t]) == 0) {
+            *type = (window_type_t)t;
+            return true;
+        }
+    }
+
+    // Common short forms
+    if (strcmp(lower, "rect") == 0 || strcmp(lower, "none") == 0) {
+        *type = WINDOW_RECTANGULAR;
+    } else if (strcmp(lower, "hanning") == 0) {
+        *type = WINDOW_HANN;
+    } else if (strcmp(lower, "bh") == 0 || strcmp(lower, "blackmanharris") == 0) {
+        *type = WINDOW_BLACKMAN_HARRIS;
+    } else if (strcmp(lower, "flattop") == 0) {
+        *type = WINDOW_FLAT_TOP;
+    } else if (strcmp(lower, "slepian") == 0) {
+        *type = WINDOW_DPSS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Canonical window name
+const char *window_type_name(window_type_t type) {
+    if ((int)type < 0 || (int)type >= WINDOW_TYPE_COUNT) return "unknown";
+    return window_names[type];
+}
+
+// Get window coefficient
+double window_coefficient(const window_t *window, int index) {
+    if (!window || index < 0 || (uint32_t)index >= window->size) {
+        return 0.0;
+    }
+    return window->coefficients[index];
+}
+
+// Coherent gain: sum(w) / N
+double window_coherent_gain(const window_t *window) {
+    return window ? window->coherent_gain : 0.0;
+}
+
+// Equivalent noise bandwidth in bins
+double window_enbw_bins(const window_t *window) {
+    return window ? window->enbw_bins : 0.0;
+}
+
+// Scalloping loss in dB
+double window_scalloping_loss_db(const window_t *window) {
+    return window ? window->scalloping_loss_db : 0.0;
+}
+
+// Apply window to real samples
+bool window_apply_real(const window_t *window, const double *input, double *output) {
+    if (!window || !input || !output) return false;
+
+    for (uint32_t i = 0; i < window->size; i++) {
+        output[i] = input[i] * window->coefficients[i];
+    }
+    return true;
+}
+
+// Apply window to complex samples
+bool window_apply_complex(const window_t *window, const fft_complex_t *input, fft_complex_t *output) {
+    if (!window || !input || !output) return false;
+
+    for (uint32_t i = 0; i < window->size; i++) {
+        output[i] = input[i] * window->coefficients[i];
+    }
+    return true;
+}
+
+// Apply window to interleaved float IQ
+bool window_apply_iq(const window_t *window, const float *iq_in, float *iq_out) {
+    if (!window || !iq_in || !iq_out) return false;
+
+    const float *w = window->coefficients_f32;
+    for (uint32_t i = 0; i < window->size; i++) {
+        iq_out[2 * i] = iq_in[2 * i] * w[i];
+        iq_out[2 * i + 1] = iq_in[2 * i + 1] * w[i];
+    }
+    return true;
+}
+
+// Internal: Fill w with the requested window
+static bool window_generate(window_type_t type, uint32_t size, double param, double *w) {
+    static const double hann[] = {0.5, 0.5};
+    static const double hamming[] = {0.54, 0.46};
+    static const double blackman[] = {0.42, 0.5, 0.08};
+    static const double blackman_harris[] = {0.35875, 0.48829, 0.14128, 0.01168};
+    static const double flat_top[] = {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368};
+
+    if (size == 1) {
+        w[0] = 1.0;
+        return true;
+    }
+
+    switch (type) {
+        case WINDOW_RECTANGULAR:
+            for (uint32_t i = 0; i < size; i++) w[i] = 1.0;
+            return true;
+        case WINDOW_HANN:
+            window_cosine_sum(w, size, hann, 2);
+            break;
+        case WINDOW_HAMMING:
+            window_cosine_sum(w, size, hamming, 2);
+            break;
+        case WINDOW_BLACKMAN:
+            window_cosine_sum(w, size, blackman, 3);
+            break;
+        case WINDOW_BLACKMAN_HARRIS:
+            window_cosine_sum(w, size, blackman_harris, 4);
+            break;
+        case WINDOW_FLAT_TOP:
+            window_cosine_sum(w, size, flat_top, 5);
+            break;
+        case WINDOW_KAISER: {
+            double norm = window_bessel_i0(param);
+            for (uint32_t i = 0; i < size; i++) {
+                double x = 2.0 * i / (size - 1.0) - 1.0;   // Map to [-1, 1]
+                double t = 1.0 - x * x;
+                w[i] = window_bessel_i0(param * sqrt(t > 0.0 ? t : 0.0)) / norm;
+            }
+            break;
+        }
+        case WINDOW_DPSS:
+            return window_dpss(w, size, param);
+        default:
+            return false;
+    }
+
+    // Even sizes have no centre tap, so the sampled peak falls just short of 1
+    window_normalize_peak(w, size);
+    return true;
+}
+
+// Internal: Symmetric generalized cosine window sum_k (-1)^k a_k cos(2*pi*k*n/(N-1))
+static void window_cosine_sum(double *w, uint32_t size, const double *a, uint32_t terms) {
+    double denom = (double)(size - 1);
+
+    for (uint32_t i = 0; i < size; i++) {
+        double phase = 2.0 * M_PI * (double)i / denom;
+        double value = a[0];
+        double sign = -1.0;
+        for (uint32_t k = 1; k < terms; k++, sign = -sign) {
+            value += sign * a[k] * cos(phase * (double)k);
+        }
+        w[i] = value;
+    }
+
+    // Pin the exact symmetry that rounding in cos() blurs
+    for (uint32_t i = 0; i < size / 2; i++) {
+        w[size - 1 - i] = w[i];
+    }
+
+}
+
+// Internal: Scale so the largest tap is exactly 1.0
+static void window_normalize_peak(double *w, uint32_t size) {
+    double peak = 0.0;
+    for (uint32_t i = 0; i < size; i++) {
+        if (w[i] > peak) peak = w[i];
+    }
+    if (peak > 0.0) {
+        for (uint32_t i = 0; i < size; i++) w[i] /= peak;
+    }
+}
+
+// Internal: Modified Bessel function of the first kind, order 0 (power series)
+static double window_bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    double half_sq = 0.25 * x * x;
+
+    for (int k = 1; k < 500; k++) {
+        term *= half_sq / ((double)k * (double)k);
+        sum += term;
+        if (term < 1e-17 * sum) break;
+    }
+    return sum;
+}
+
+/*
+ * Internal: First discrete prolate spheroidal sequence. It is the eigenvector
+ * of the largest eigenvalue of the symmetric tridiagonal matrix
+ *   diag[i]  = ((N - 1 - 2i) / 2)^2 * cos(2*pi*W)
+ *   off[i]   = i * (N - i) / 2            (between rows i - 1 and i)
+ * with W = NW / N. The eigenvalue comes from Sturm-count bisection, the
+ * vector from a few steps of inverse iteration (Thomas algorithm).
+ */
+static bool window_dpss(double *w, uint32_t size, double nw) {
+    double *diag = (double *)malloc(size * sizeof(double));
+    double *off = (double *)malloc(size * sizeof(double));
+    double *c = (double *)malloc(size * sizeof(double));
+    double *x = (double *)malloc(size * sizeof(double));
+    if (!diag || !off || !c || !x) {
+        free(diag); free(off); free(c); free(x);
+        return false;
+    }
+
+    double cos_w = cos(2.0 * M_PI * nw / (double)size);
+    double lo = 0.0, hi = 0.0;
+    for (uint32_t i = 0; i < size; i++) {
+        double h = ((double)size - 1.0 - 2.0 * i) / 2.0;
+        diag[i] = h * h * cos_w;
+        off[i] = (i == 0) ? 0.0 : (double)i * (double)(size - i) / 2.0;
+    }
+
+    // Gershgorin bounds bracket every eigenvalue
+    for (uint32_t i = 0; i < size; i++) {
+        double radius = fabs(off[i]) + (i + 1 < size ? fabs(off[i + 1]) : 0.0);
+        if (i == 0 || diag[i] - radius < lo) lo = diag[i] - radius;
+        if (i == 0 || diag[i] + radius > hi) hi = diag[i] + radius;
+    }
+
+    // Bisect for the largest eigenvalue: count(x) == N means all are below x
+    double scale = fmax(fabs(lo), fabs(hi));
+    for (int iter = 0; iter < 200 && hi - lo > 1e-15 * scale; iter++) {
+        double mid = 0.5 * (lo + hi);
+        uint32_t below = 0;
+        double q = 1.0;
+        for (uint32_t i = 0; i < size; i++) {
+            q = diag[i] - mid - (i > 0 ? off[i] * off[i] / q : 0.0);
+            if (q == 0.0) q = -1e-300;
+            if (q < 0.0) below++;
+        }
+        if (below == size) hi = mid;
+        else lo = mid;
+    }
+
+    // Shift just past the eigenvalue so (T - shift) stays non-singular
+    double shift = hi + 1e-10 * scale;
+    for (uint32_t i = 0; i < size; i++) w[i] = 1.0;
+
+    for (int iter = 0; iter < 3; iter++) {
+        // Forward sweep of the Thomas algorithm on (T - shift) x = w
+        double denom = diag[0] - shift;
+        c[0] = (size > 1) ? off[1] / denom : 0.0;
+        x[0] = w[0] / denom;
+        for (uint32_t i = 1; i < size; i++) {
+            denom = diag[i] - shift - off[i] * c[i - 1];
+            c[i] = (i + 1 < size) ? off[i + 1] / denom : 0.0;
+            x[i] = (w[i] - off[i] * x[i - 1]) / denom;
+        }
+        for (uint32_t i = size - 1; i > 0; i--) {
+            x[i - 1] -= c[i - 1] * x[i];
+        }
+
+        double norm = 0.0;
+        for (uint32_t i = 0; i < size; i++) norm += x[i] * x[i];
+        norm = sqrt(norm);
+        if (!(norm > 0.0) || !isfinite(norm)) break;
+        for (uint32_t i = 0; i < size; i++) w[i] = x[i] / norm;
+    }
+
+    // Positive taper, exact symmetry, peak of 1
+    double peak = 0.0;
+    for (uint32_t i = 0; i < size / 2; i++) {
+        double v = 0.5 * (w[i] + w[size - 1 - i]);
+        w[i] = v;
+        w[size - 1 - i] = v;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        if (fabs(w[i]) > fabs(peak)) peak = w[i];
+    }
+    bool ok = peak != 0.0 && isfinite(peak);
+    if (ok) {
+        for (uint32_t i = 0; i < size; i++) w[i] /= peak;
+    }
+
+    free(diag); free(off); free(c); free(x);
+    return ok;
+}
+
+// Internal: Coherent gain, power gain, ENBW and half-bin scalloping loss
+static void window_compute_metrics(window_t *window) {
+    uint32_t size = window->size;
+    const double *w = window->coefficients;
+    double sum = 0.0, sum_sq = 0.0;
+    double half_re = 0.0, half_im = 0.0;
+
+    for (uint32_t i = 0; i < size; i++) {
+        sum += w[i];
+        sum_sq += w[i] * w[i];
+        // Response to a tone half a bin off centre
+        double phase = M_PI * (double)i / (double)size;
+        half_re += w[i] * cos(phase);
+        half_im -= w[i] * sin(phase);
+    }
+
+    window->coherent_gain = sum / (double)size;
+    window->power_gain = sum_sq / (double)size;
+    window->enbw_bins = (sum != 0.0) ? (double)size * sum_sq / (sum * sum) : 0.0;
+
+    double half = sqrt(half_re * half_re + half_im * half_im);
+    window->scalloping_loss_db = (sum != 0.0 && half > 0.0) ? -20.0 * log10(half / fabs(sum)) : 0.0;
+}
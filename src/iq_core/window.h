@@ -0,0 +1,101 @@
+#ifndef IQ_WINDOW_H
+#define IQ_WINDOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fft.h"
+
+/*
+ * Window function types
+ * All windows are symmetric (denominator N - 1) and peak-normalized to 1.0,
+ * so a size-1 window is a single 1.0 tap.
+ */
+typedef enum {
+    WINDOW_RECTANGULAR = 0,   // All ones
+    WINDOW_HANN,              // 0.5 - 0.5 cos
+    WINDOW_HAMMING,           // 0.54 - 0.46 cos
+    WINDOW_BLACKMAN,          // 3-term Blackman (0.42, 0.5, 0.08)
+    WINDOW_BLACKMAN_HARRIS,   // 4-term Blackman-Harris, -92 dB sidelobes
+    WINDOW_FLAT_TOP,          // 5-term flat-top, < 0.01 dB scalloping
+    WINDOW_KAISER,            // Kaiser-Bessel, param = beta
+    WINDOW_DPSS,              // First Slepian sequence, param = time-bandwidth NW
+    WINDOW_TYPE_COUNT
+} window_type_t;
+
+// Defaults used when a parameterized window is created without a parameter
+#define WINDOW_KAISER_DEFAULT_BETA 8.6
+#define WINDOW_DPSS_DEFAULT_NW     3.0
+
+/*
+ * Window table with its spectral figures of merit
+ * Double and float taps are generated together so FFT code in either
+ * precision can use the table without converting per frame. The figures are
+ * computed once at creation:
+ *   coherent gain = sum(w) / N                 (tone amplitude scaling)
+ *   ENBW (bins)   = N * sum(w^2) / sum(w)^2    (noise bandwidth of one bin)
+ * A tone's |X|^2 scales by (N * cg)^2 and white noise by N * power_gain, so a
+ * per-bin SNR measured through the window is 1 / ENBW of the rectangular one.
+ */
+typedef struct {
+    window_type_t type;          // Window family
+    uint32_t size;               // Number of taps
+    double param;                // Kaiser beta / DPSS NW (0 for fixed windows)
+    double *coefficients;        // Double-precision taps
+    float *coefficients_f32;     // Same taps rounded to float (for fft_spectral_frame)
+    double coherent_gain;        // sum(w) / N
+    double power_gain;           // sum(w^2) / N
+    double enbw_bins;            // Equivalent noise bandwidth in bins
+    double scalloping_loss_db;   // Worst-case (half-bin) tone loss, positive dB
+} window_t;
+
+/*
+ * Function declarations
+ */
+
+// Create a window with default parameters (Kaiser beta 8.6, DPSS NW 3)
+window_t *window_create(window_type_t type, uint32_t size);
+
+// Create a window with an explicit Kaiser beta or DPSS NW (ignored by fixed windows)
+window_t *window_create_param(window_type_t type, uint32_t size, double param);
+
+// Create a window from a name ("hann", "kaiser", ...); unknown names give Hann
+window_t *window_create_from_name(const char *name, uint32_t size);
+
+// Destroy a window created by window_create*
+void window_destroy(window_t *window);
+
+/*
+ * Process-wide window cache
+ * Tables are keyed by (type, size, param), built once and shared read-only.
+ * Every acquire must be paired with a release; never destroy a cached window.
+ * Kaiser beta is taken as given (0 is rectangular); a DPSS NW of 0 selects
+ * the default.
+ */
+const window_t *window_acquire(window_type_t type, uint32_t size, double param);
+void window_release(const window_t *window);
+
+// Free cached windows that are not currently acquired; returns number freed
+uint32_t window_cache_clear(void);
+
+// Parse a window name (case-insensitive); returns false for unknown names
+bool window_type_from_name(const char *name, window_type_t *type);
+
+// Canonical name of a window type
+const char *window_type_name(window_type_t type);
+
+// Tap value, 0.0 for out-of-range indices
+double window_coefficient(const window_t *window, int index);
+
+// Figures of merit
+double window_coherent_gain(const window_t *window);
+double window_enbw_bins(const window_t *window);
+double window_scalloping_loss_db(const window_t *window);
+
+// Apply the window to window->size samples (input and output may alias)
+bool window_apply_real(const window_t *window, const double *input, double *output);
+bool window_apply_complex(const window_t *window, const fft_complex_t *input, fft_complex_t *output);
+
+// Apply the window to window->size interleaved float IQ pairs
+bool window_apply_iq(const window_t *window, const float *iq_in, float *iq_out);
+
+#endif // IQ_WINDOW_H
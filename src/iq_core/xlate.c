@@ -0,0 +1,100 @@
+#include "xlate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Complex samples mixed and filtered per pass
+#define XLATE_BLOCK_SAMPLES 4096
+
+// Highest passband edge as a fraction of the output rate
+#define XLATE_MAX_PASSBAND 0.4
+
+/**
+ * @brief Initialize the mixer and the decimation chain
+ */
+bool xlate_init(xlate_t *xlate, double sample_rate, double offset_hz, uint32_t decimation,
+                double bandwidth) {
+    if (!xlate || sample_rate <= 0.0 || decimation == 0) return false;
+
+    memset(xlate, 0, sizeof(*xlate));
+    xlate->sample_rate = sample_rate;
+    xlate->offset_hz = offset_hz;
+    xlate->decimation = decimation;
+
+    double output_rate = sample_rate / decimation;
+    if (bandwidth <= 0.0) bandwidth = 2.0 * XLATE_MAX_PASSBAND * output_rate;
+    if (bandwidth > 2.0 * XLATE_MAX_PASSBAND * output_rate) {
+        bandwidth = 2.0 * XLATE_MAX_PASSBAND * output_rate;
+    }
+    xlate->bandwidth = bandwidth;
+
+    nco_init(&xlate->nco, -offset_hz, sample_rate);
+
+    xlate->scratch = (float *)malloc(2 * XLATE_BLOCK_SAMPLES * sizeof(float));
+    if (!xlate->scratch) return false;
+    xlate_reset(xlate);
+    if (decimation == 1) return true;
+
+    decim_plan_t plan;
+    decim_plan_factor(&plan, decimation);
+    if (!decim_init(&xlate->chain, &plan, bandwidth / 2.0 / sample_rate, 2)) {
+        xlate_free(xlate);
+        return false;
+    }
+    xlate->delay = xlate->chain.delay;
+
+    return true;
+}
+
+/**
+ * @brief Translate and decimate a block of interleaved IQ samples
+ */
+size_t xlate_process(xlate_t *xlate, const float *iq_in, size_t count, float *iq_out) {
+    if (!xlate || !xlate->scratch || !iq_in || !iq_out) return 0;
+
+    if (xlate->decimation == 1) {
+        for (size_t done = 0; done < count; done += XLATE_BLOCK_SAMPLES) {
+            size_t n = count - done < XLATE_BLOCK_SAMPLES ? count - done : XLATE_BLOCK_SAMPLES;
+            nco_mix(&xlate->nco, iq_in + 2 * done, iq_out + 2 * done, n);
+        }
+        return count;
+    }
+
+    size_t written = 0;
+    for (size_t done = 0; done < count; done += XLATE_BLOCK_SAMPLES) {
+        size_t n = count - done < XLATE_BLOCK_SAMPLES ? count - done : XLATE_BLOCK_SAMPLES;
+        nco_mix(&xlate->nco, iq_in + 2 * done, xlate->scratch, n);
+        n = decim_process(&xlate->chain, xlate->scratch, n);
+        memcpy(iq_out + 2 * written, xlate->scratch, n * 2 * sizeof(float));
+        written += n;
+    }
+    return written;
+}
+
+/**
+ * @brief Output sample rate
+ */
+double xlate_output_rate(const xlate_t *xlate) {
+    return xlate && xlate->decimation ? xlate->sample_rate / xlate->decimation : 0.0;
+}
+
+/**
+ * @brief Clear the filter state and restart the NCO
+ */
+void xlate_reset(xlate_t *xlate) {
+    if (!xlate) return;
+
+    nco_reset(&xlate->nco);
+    decim_reset(&xlate->chain);
+}
+
+/**
+ * @brief Free the stage filters and the block buffer
+ */
+void xlate_free(xlate_t *xlate) {
+    if (!xlate) return;
+
+    decim_free(&xlate->chain);
+    free(xlate->scratch);
+    memset(xlate, 0, sizeof(*xlate));
+}
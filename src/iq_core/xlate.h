@@ -0,0 +1,66 @@
+#ifndef IQ_LAB_XLATE_H
+#define IQ_LAB_XLATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "decim.h"
+#include "nco.h"
+
+/*
+ * Frequency-translating decimator
+ *
+ * Moves offset_hz to DC and reduces the rate by an integer factor D with a
+ * real anti-alias filter, on interleaved IQ float blocks:
+ *
+ *   mixer (nco_t at -offset_hz) -> [CIC R] -> [halfband /2]... -> FIR /F
+ *
+ * with D = R * 2^h * F. The mixer is the shared recursive NCO, so no
+ * sin/cos runs in the loop and any block split gives the same outputs.
+ * The filter stages are a decim_t laid out by decim_plan_factor: factors
+ * of DECIM_CIC_MIN_DECIMATION and up start with a CIC that leaves at least
+ * DECIM_CIC_MIN_REMAINDER for the FIR stages, then the remaining even
+ * factors become halfbands while the final FIR keeps decimating by two or
+ * more.
+ *
+ * The filters keep the passband, bandwidth / 2 either side of DC, alias
+ * free; every stage is designed for DECIM_STOPBAND_DB of attenuation.
+ * Outputs follow the input by the filters' group delay (xlate_t.delay
+ * input samples).
+ */
+
+// Translating decimator state
+typedef struct {
+    double sample_rate;      // Input rate (Hz)
+    double offset_hz;        // Frequency moved to DC
+    double bandwidth;        // Passband width around DC (Hz)
+    uint32_t decimation;     // Total factor D
+    double delay;            // Group delay (input samples)
+
+    nco_t nco;               // Mixer oscillator at -offset_hz
+
+    decim_t chain;           // CIC, halfbands and final FIR
+
+    float *scratch;          // Mixed block, filtered in place stage by stage
+} xlate_t;
+
+// Initialize for the given rate, offset, factor and passband width
+// (bandwidth <= 0: 80% of the output rate)
+bool xlate_init(xlate_t *xlate, double sample_rate, double offset_hz, uint32_t decimation,
+                double bandwidth);
+
+// Translate and decimate count interleaved IQ samples; writes at most
+// count / decimation + 1 outputs to iq_out and returns how many
+size_t xlate_process(xlate_t *xlate, const float *iq_in, size_t count, float *iq_out);
+
+// Output rate (Hz)
+double xlate_output_rate(const xlate_t *xlate);
+
+// Clear filter histories and restart the NCO at phase 0
+void xlate_reset(xlate_t *xlate);
+
+// Free decimator resources
+void xlate_free(xlate_t *xlate);
+
+#endif // IQ_LAB_XLATE_H
@@ -8,23 +8,90 @@
  * Execution Strategy:
  * 1. Parse YAML pipeline definition
  * 2. Validate dependencies and inputs
- * 3. Execute steps sequentially (with optional parallelism)
- * 4. Track progress and handle errors
- * 5. Generate execution summary and results
+ * 3. Build the dependency graph: a step waits for each earlier step whose
+ *    outputs it reads (and needs it to succeed) or whose outputs it also
+ *    writes; a step that pipeline_can_parallelize rejects waits for every
+ *    earlier step and every later step waits for it
+ * 4. Run ready steps as child processes (fork/exec, or _spawnv on
+ *    Windows), polled without blocking, at most max_parallel_jobs at once
+ *    (one without parallelism: pipeline order); a step over
+ *    timeout_seconds is killed; each is timed on a monotonic clock and
+ *    reaped with its own resource use (wait4 / GetProcessTimes)
+ * 5. Track progress and handle errors
+ * 6. Generate execution summary and results
+ *
+ * In-process mode (pipeline_execute_in_process) instead decodes each input
+ * once into a shared source (io_iq.h) and calls the tool cores directly in
+ * pipeline order, so the capture is read and converted once per job. Steps
+ * that only need spectral rows of one STFT geometry are fused: they run on
+ * threads fed by one spectral bus (spectral_bus.h), one FFT per frame.
+ *
+ * Fan-out runs (pipeline_fanout_execute) instantiate a template pipeline
+ * per input and drive one schedule per input in flight through the same
+ * start/collect steps as pipeline_execute, with an admission check that
+ * holds every input's steps within the global step and memory budget.
+ *
+ * With a step cache (config.cache_dir), both modes key each ready step
+ * before running it: a hit restores the step's outputs and counts it as
+ * completed without running the tool; after a successful run the files it
+ * wrote are stored under its key (step_cache.h).
+ *
+ * While tracing (profile.h) every step that ran is a span on a track of
+ * its own, so a whole job, spawned steps included, reads as one timeline.
  *
  *
  * Date: 2025
  */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+// wait4 (a child's own rusage) is a BSD interface outside POSIX
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
+#endif
+
 #include "pipeline.h"
+#include "../iq_core/io_iq.h"
+#include "../iq_core/spectral_bus.h"
+#include "../iq_core/profile.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <unistd.h>
 #include <sys/stat.h>
 #include <errno.h>
 #include <time.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <process.h>
+#include <getopt.h>
+typedef intptr_t step_process_t;
+#define PIPELINE_TOOL_FORMAT "%s\\%s.exe"
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+typedef pid_t step_process_t;
+#define PIPELINE_TOOL_FORMAT "%s/%s"
+#endif
+
+// Wait between polls of running steps (milliseconds)
+#define PIPELINE_POLL_MS 2
+
+// Parameters passed to one tool, and the longest parameter name
+#define PIPELINE_MAX_PARAMS 32
+#define PIPELINE_MAX_KEY 63
+
+// Program, a flag and a value per parameter, terminator
+#define PIPELINE_MAX_ARGS (2 + 2 * PIPELINE_MAX_PARAMS)
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -41,6 +108,13 @@ bool pipeline_config_init(pipeline_config_t *config) {
     config->continue_on_error = false;      // Stop on first error
     strcpy(config->log_file, "pipeline.log");
     strcpy(config->working_dir, ".");
+    strcpy(config->tool_dir, ".");
+    config->cache_dir[0] = '\0';           // No step cache
+    config->max_parallel_files = 1;         // Fan-out: one input at a time
+    config->memory_budget_bytes = 0;        // No memory limit
+    config->launcher[0] = '\0';            // Tools run directly, on this machine
+    config->node[0] = '\0';
+    config->node_count = 0;
 
     return true;
 }
@@ -52,21 +126,122 @@ bool pipeline_config_validate(const pipeline_config_t *config) {
     if (!config) return false;
 
     if (config->max_parallel_jobs == 0) return false;
+    if (config->max_parallel_files == 0) return false;
     if (config->timeout_seconds <= 0.0) return false;
     if (strlen(config->working_dir) == 0) return false;
+    if (strlen(config->tool_dir) == 0) return false;
 
     return true;
 }
 
+// Paths a step writes: its output_dir and "out" parameters
+static uint32_t step_outputs(const yaml_pipeline_step_t *step, const char **outputs) {
+    uint32_t count = 0;
+    if (step->output_dir[0]) outputs[count++] = step->output_dir;
+    for (uint32_t i = 0; i < step->param_count; i++) {
+        if (strcmp(step->params[i].key, "out") == 0 && step->params[i].value[0]) {
+            outputs[count++] = step->params[i].value;
+        }
+    }
+    return count;
+}
+
+// True when a param of step names a path that earlier writes to
+static bool step_reads_outputs_of(const yaml_pipeline_step_t *step,
+                                  const yaml_pipeline_step_t *earlier) {
+    const char *outputs[33];
+    uint32_t output_count = step_outputs(earlier, outputs);
+
+    for (uint32_t i = 0; i < step->param_count; i++) {
+        if (strcmp(step->params[i].key, "out") == 0) continue;
+        for (uint32_t o = 0; o < output_count; o++) {
+            if (strstr(step->params[i].value, outputs[o]) != NULL) return true;
+        }
+    }
+    return false;
+}
+
+// True when both steps write the same path
+static bool steps_share_output(const yaml_pipeline_step_t *a, const yaml_pipeline_step_t *b) {
+    const char *a_outputs[33], *b_outputs[33];
+    uint32_t a_count = step_outputs(a, a_outputs);
+    uint32_t b_count = step_outputs(b, b_outputs);
+    for (uint32_t i = 0; i < a_count; i++) {
+        for (uint32_t j = 0; j < b_count; j++) {
+            if (strcmp(a_outputs[i], b_outputs[j]) == 0) return true;
+        }
+    }
+    return false;
+}
+
+// Analysis tools that write nothing but their own outputs
+static bool tool_is_read_only(const char *tool_name) {
+    return strcmp(tool_name, "iqls") == 0 ||
+           strcmp(tool_name, "iqinfo") == 0 ||
+           strcmp(tool_name, "iqdetect") == 0 ||
+           strcmp(tool_name, "iqdemod-fm") == 0 ||
+           strcmp(tool_name, "iqdemod-am") == 0 ||
+           strcmp(tool_name, "iqdemod-ssb") == 0;
+}
+
+// Edges only point back to earlier steps, so the graph is acyclic and
+// pipeline order is always a valid schedule
+static void build_graph(pipeline_executor_t *executor) {
+    const yaml_pipeline_step_t *steps = executor->document->pipeline;
+    for (uint32_t j = 0; j < executor->result_count; j++) {
+        bool barrier_j = !pipeline_can_parallelize(executor, j);
+        for (uint32_t i = 0; i < j; i++) {
+            uint32_t bit = 1u << i;
+            if (step_reads_outputs_of(&steps[j], &steps[i])) {
+                executor->needs[j] |= bit;
+                executor->waits_for[j] |= bit;
+            } else if (barrier_j || !pipeline_can_parallelize(executor, i) ||
+                       steps_share_output(&steps[j], &steps[i])) {
+                executor->waits_for[j] |= bit;
+            }
+        }
+    }
+}
+
+// Seconds on a monotonic clock
+static double monotonic_seconds(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
 /**
  * @brief Create pipeline executor
  */
 pipeline_executor_t *pipeline_executor_create(const pipeline_config_t *config,
                                             const yaml_document_t *document) {
-    if (!pipeline_config_validate(config) || !document) {
+    if (!pipeline_config_validate(config) || !document ||
+        document->pipeline_count > PIPELINE_MAX_STEPS) {
         return NULL;
     }
 
+    // The document has no limits; a tool's argument vector does
+    for (uint32_t i = 0; i < document->pipeline_count; i++) {
+        const yaml_pipeline_step_t *step = &document->pipeline[i];
+        bool fits = step->param_count <= PIPELINE_MAX_PARAMS;
+        for (uint32_t p = 0; fits && p < step->param_count; p++) {
+            fits = strlen(step->params[p].key) <= PIPELINE_MAX_KEY;
+        }
+        if (!fits) {
+            fprintf(stderr, "Step %u (%s): at most %d parameters of up to %d characters "
+                    "are passed to a tool\n", i, step->tool_name, PIPELINE_MAX_PARAMS, PIPELINE_MAX_KEY);
+            return NULL;
+        }
+    }
+
     pipeline_executor_t *executor = (pipeline_executor_t *)malloc(sizeof(pipeline_executor_t));
     if (!executor) return NULL;
 
@@ -88,6 +263,17 @@ pipeline_executor_t *pipeline_executor_create(const pipeline_config_t *config,
     // Initialize results
     memset(executor->results, 0, executor->result_count * sizeof(pipeline_step_result_t));
 
+    executor->waits_for = (uint32_t *)calloc(executor->result_count + 1, sizeof(uint32_t));
+    executor->needs = (uint32_t *)calloc(executor->result_count + 1, sizeof(uint32_t));
+    if (!executor->waits_for || !executor->needs) {
+        free(executor->waits_for);
+        free(executor->needs);
+        free(executor->results);
+        free(executor);
+        return NULL;
+    }
+    build_graph(executor);
+
     // Initialize state
     executor->initialized = true;
     executor->running = false;
@@ -95,6 +281,24 @@ pipeline_executor_t *pipeline_executor_create(const pipeline_config_t *config,
     executor->total_execution_time = 0.0;
     executor->completed_steps = 0;
     executor->failed_steps = 0;
+    executor->peak_running = 0;
+    executor->cached_steps = 0;
+    executor->total_cpu_time = 0.0;
+    executor->start_clock = monotonic_seconds();
+
+    // Open the step cache
+    executor->cache = NULL;
+    if (strlen(config->cache_dir) > 0) {
+        executor->cache = (step_cache_t *)malloc(sizeof(step_cache_t));
+        if (!executor->cache || !step_cache_init(executor->cache, config->cache_dir)) {
+            free(executor->cache);
+            free(executor->waits_for);
+            free(executor->needs);
+            free(executor->results);
+            free(executor);
+            return NULL;
+        }
+    }
 
     // Initialize logging
     executor->log_handle = NULL;
@@ -111,58 +315,990 @@ pipeline_executor_t *pipeline_executor_create(const pipeline_config_t *config,
 void pipeline_executor_destroy(pipeline_executor_t *executor) {
     if (!executor) return;
 
-    // Close log file
+    // Close log file
+    if (executor->log_handle) {
+        fclose((FILE *)executor->log_handle);
+    }
+
+    // Free results array and graph
+    free(executor->results);
+    free(executor->waits_for);
+    free(executor->needs);
+    free(executor->cache);
+
+    free(executor);
+}
+
+static void sleep_ms(unsigned int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// Argument vector for a step: the tool in tool_dir, then --key value per
+// parameter (no shell: values are passed as they are), or /bin/sh -c and
+// the expanded launcher
+typedef struct {
+    char program[512];
+    char flags[PIPELINE_MAX_PARAMS][PIPELINE_MAX_KEY + 3];
+    char *argv[PIPELINE_MAX_ARGS + 1];
+    int argc;
+    char shell[8192];
+} step_command_t;
+
+// A parameter set to true is a flag without a value
+static bool is_flag_value(const char *value) {
+    return strcmp(value, "true") == 0;
+}
+
+static bool build_argv(const pipeline_executor_t *executor, uint32_t step_index,
+                       step_command_t *command) {
+    const yaml_pipeline_step_t *step = &executor->document->pipeline[step_index];
+    int written = snprintf(command->program, sizeof(command->program), PIPELINE_TOOL_FORMAT,
+                           executor->config.tool_dir, step->tool_name);
+    if (written < 0 || (size_t)written >= sizeof(command->program)) return false;
+
+    uint32_t argc = 0;
+    command->argv[argc++] = command->program;
+    if (step->param_count > PIPELINE_MAX_PARAMS) return false;
+    for (uint32_t i = 0; i < step->param_count; i++) {
+        snprintf(command->flags[i], sizeof(command->flags[i]), "--%s", step->params[i].key);
+        command->argv[argc++] = command->flags[i];
+        if (!is_flag_value(step->params[i].value)) command->argv[argc++] = (char *)step->params[i].value;
+    }
+    command->argv[argc] = NULL;
+    command->argc = (int)argc;
+    return true;
+}
+
+// Append 'text' to buffer[*used], writing each ' as '\'' if 'escape'
+static bool append_shell(char *buffer, size_t size, size_t *used, const char *text, bool escape) {
+    size_t at = *used;
+    for (const char *c = text; *c; c++) {
+        if (escape && *c == '\'') {
+            if (at + 4 >= size) return false;
+            memcpy(buffer + at, "'\\''", 4);
+            at += 4;
+        } else {
+            if (at + 1 >= size) return false;
+            buffer[at++] = *c;
+        }
+    }
+    buffer[at] = '\0';
+    *used = at;
+    return true;
+}
+
+// Append 'text' as one single-quoted shell word
+static bool append_quoted(char *buffer, size_t size, size_t *used, const char *text) {
+    return append_shell(buffer, size, used, "'", false) &&
+           append_shell(buffer, size, used, text, true) &&
+           append_shell(buffer, size, used, "'", false);
+}
+
+// Run a built command through config.launcher. Each placeholder expands to
+// words quoted for the shell that finally runs the command: {command} is the
+// argument vector, each argument single-quoted, {node} and {cwd} one quoted
+// word each. A placeholder inside a single-quoted span of the template (the
+// remote command of "ssh {node} 'cd {cwd} && {command}'") is escaped once
+// more so the local /bin/sh hands the quoted words through unchanged.
+static bool launch_argv(const pipeline_executor_t *executor, step_command_t *command) {
+    const char *launcher = executor->config.launcher;
+    if (!launcher[0]) return true;
+#ifdef _WIN32
+    (void)command;
+    fprintf(stderr, "A step launcher needs a POSIX shell\n");
+    return false;
+#else
+    char cwd[1024];
+    if (!getcwd(cwd, sizeof(cwd))) return false;
+
+    char word[sizeof(command->shell)];
+    size_t used = 0;
+    bool in_single = false, in_double = false;
+    command->shell[0] = '\0';
+    for (const char *c = launcher; *c;) {
+        size_t word_used = 0;
+        word[0] = '\0';
+        bool ok = true;
+        if (strncmp(c, "{command}", 9) == 0) {
+            for (int i = 0; ok && i < command->argc; i++) {
+                ok = (i == 0 || append_shell(word, sizeof(word), &word_used, " ", false)) &&
+                     append_quoted(word, sizeof(word), &word_used, command->argv[i]);
+            }
+            c += 9;
+        } else if (strncmp(c, "{node}", 6) == 0) {
+            ok = append_quoted(word, sizeof(word), &word_used, executor->config.node);
+            c += 6;
+        } else if (strncmp(c, "{cwd}", 5) == 0) {
+            ok = append_quoted(word, sizeof(word), &word_used, cwd);
+            c += 5;
+        } else {
+            // Template text is copied as is; track its quoting so placeholders
+            // know how many shells they pass through
+            size_t n = 1;
+            if (*c == '\'' && !in_double) in_single = !in_single;
+            else if (*c == '"' && !in_single) in_double = !in_double;
+            else if (*c == '\\' && !in_single && c[1]) n = 2;
+            char one[3] = {c[0], n == 2 ? c[1] : '\0', '\0'};
+            if (!append_shell(command->shell, sizeof(command->shell), &used, one, false)) return false;
+            c += n;
+            continue;
+        }
+        if (in_double) {
+            fprintf(stderr, "Launcher placeholders cannot sit inside double quotes: %s\n", launcher);
+            return false;
+        }
+        if (!ok || !append_shell(command->shell, sizeof(command->shell), &used, word, in_single)) return false;
+    }
+
+    strcpy(command->program, "/bin/sh");
+    command->argv[0] = command->program;
+    command->argv[1] = (char *)"-c";
+    command->argv[2] = command->shell;
+    command->argv[3] = NULL;
+    command->argc = 3;
+    return true;
+#endif
+}
+
+// Start a step's tool; false if it could not be started
+static bool process_start(const step_command_t *command, step_process_t *process) {
+#ifdef _WIN32
+    intptr_t handle = _spawnv(_P_NOWAIT, command->program, (const char *const *)command->argv);
+    if (handle == -1) return false;
+    *process = handle;
+    return true;
+#else
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        execv(command->program, command->argv);
+        _exit(127);  // Same code a shell gives for a missing command
+    }
+    *process = pid;
+    return true;
+#endif
+}
+
+#ifdef _WIN32
+static double filetime_seconds(FILETIME t) {
+    return (double)(((uint64_t)t.dwHighDateTime << 32) | t.dwLowDateTime) * 1e-7;  // 100 ns units
+}
+
+// CPU, peak working set and I/O of a process so far
+static void process_usage(HANDLE process, pipeline_step_usage_t *usage) {
+    memset(usage, 0, sizeof(*usage));
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(process, &created, &exited, &kernel, &user)) {
+        usage->user_seconds = filetime_seconds(user);
+        usage->system_seconds = filetime_seconds(kernel);
+    }
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(process, &memory, sizeof(memory))) {
+        usage->max_rss_bytes = (uint64_t)memory.PeakWorkingSetSize;
+    }
+    IO_COUNTERS io;
+    if (GetProcessIoCounters(process, &io)) {
+        usage->read_bytes = io.ReadTransferCount;
+        usage->write_bytes = io.WriteTransferCount;
+    }
+}
+#else
+static void usage_from_rusage(const struct rusage *ru, pipeline_step_usage_t *usage) {
+    usage->user_seconds = (double)ru->ru_utime.tv_sec + ru->ru_utime.tv_usec * 1e-6;
+    usage->system_seconds = (double)ru->ru_stime.tv_sec + ru->ru_stime.tv_usec * 1e-6;
+#ifdef __APPLE__
+    usage->max_rss_bytes = (uint64_t)ru->ru_maxrss;            // Bytes on macOS
+#else
+    usage->max_rss_bytes = (uint64_t)ru->ru_maxrss * 1024;     // Kilobytes elsewhere
+#endif
+    usage->read_bytes = (uint64_t)ru->ru_inblock * 512;        // 512-byte blocks
+    usage->write_bytes = (uint64_t)ru->ru_oublock * 512;
+}
+#endif
+
+// Resources this process has used so far
+static void self_usage(pipeline_step_usage_t *usage) {
+#ifdef _WIN32
+    process_usage(GetCurrentProcess(), usage);
+#else
+    struct rusage ru;
+    memset(usage, 0, sizeof(*usage));
+    if (getrusage(RUSAGE_SELF, &ru) == 0) usage_from_rusage(&ru, usage);
+#endif
+}
+
+// What this process used between two self_usage readings
+static void usage_since(const pipeline_step_usage_t *before, pipeline_step_usage_t *usage) {
+    pipeline_step_usage_t now;
+    self_usage(&now);
+    usage->user_seconds = now.user_seconds - before->user_seconds;
+    usage->system_seconds = now.system_seconds - before->system_seconds;
+    usage->max_rss_bytes = now.max_rss_bytes;
+    usage->read_bytes = now.read_bytes - before->read_bytes;
+    usage->write_bytes = now.write_bytes - before->write_bytes;
+}
+
+// True once the process has exited, with its exit code (128 + signal if
+// a signal ended it) and the resources it used
+static bool process_poll(step_process_t process, int *exit_code, pipeline_step_usage_t *usage) {
+#ifdef _WIN32
+    if (WaitForSingleObject((HANDLE)process, 0) != WAIT_OBJECT_0) return false;
+    DWORD code = 1;
+    GetExitCodeProcess((HANDLE)process, &code);
+    process_usage((HANDLE)process, usage);
+    CloseHandle((HANDLE)process);
+    *exit_code = (int)code;
+    return true;
+#else
+    int status;
+    struct rusage ru;
+    pid_t done = wait4(process, &status, WNOHANG, &ru);
+    if (done == 0) return false;
+    memset(usage, 0, sizeof(*usage));
+    if (done < 0) {
+        *exit_code = -1;
+        return true;
+    }
+    usage_from_rusage(&ru, usage);
+    if (WIFEXITED(status)) {
+        *exit_code = WEXITSTATUS(status);
+    } else {
+        *exit_code = WIFSIGNALED(status) ? 128 + WTERMSIG(status) : -1;
+    }
+    return true;
+#endif
+}
+
+static void process_kill(step_process_t process) {
+#ifdef _WIN32
+    TerminateProcess((HANDLE)process, 1);
+#else
+    kill(process, SIGKILL);
+#endif
+}
+
+// A step that is running: its process and start time
+typedef struct {
+    step_process_t process;
+    double start;
+    uint64_t trace_start;       // iq_profile_begin() at the start
+    bool timed_out;
+} running_step_t;
+
+// Fill in a result and start the step; false (result filled) if it
+// could not be started
+static bool start_step(pipeline_executor_t *executor, uint32_t step_index,
+                       pipeline_step_result_t *result, running_step_t *running) {
+    memset(result, 0, sizeof(pipeline_step_result_t));
+    result->step_index = step_index;
+    result->start_time = time(NULL);
+
+    const yaml_pipeline_step_t *step = &executor->document->pipeline[step_index];
+    snprintf(result->tool_name, sizeof(result->tool_name), "%s", step->tool_name);
+
+    char command[2048];
+    step_command_t argv;
+    if (!pipeline_build_command(executor, step_index, command, sizeof(command)) ||
+        !build_argv(executor, step_index, &argv) || !launch_argv(executor, &argv)) {
+        strcpy(result->error_message, "Failed to build command");
+        result->end_time = time(NULL);
+        return false;
+    }
+
+    // Log command execution (flushed: a child must not inherit buffered text)
+    if (executor->log_handle) {
+        fprintf((FILE *)executor->log_handle, "[STEP %u] Executing: %s\n",
+                step_index, executor->config.launcher[0] ? argv.shell : command);
+        fflush((FILE *)executor->log_handle);
+    }
+    fflush(stdout);
+    fflush(stderr);
+
+    running->start = monotonic_seconds();
+    running->trace_start = iq_profile_begin();
+    running->timed_out = false;
+    if (!process_start(&argv, &running->process)) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                 "Failed to start %.64s: %s", step->tool_name, strerror(errno));
+        result->end_time = time(NULL);
+        return false;
+    }
+    return true;
+}
+
+// Record a finished step
+static void finish_step(pipeline_executor_t *executor, uint32_t step_index,
+                        pipeline_step_result_t *result, const running_step_t *running,
+                        int exit_code, const pipeline_step_usage_t *usage) {
+    const yaml_pipeline_step_t *step = &executor->document->pipeline[step_index];
+
+    result->end_time = time(NULL);
+    result->execution_time = monotonic_seconds() - running->start;
+    result->start_offset = running->start - executor->start_clock;
+    result->usage = *usage;
+    result->exit_code = exit_code;
+
+    // One track per step (and input, with several in one job)
+    if (running->trace_start) {
+        char track[64];
+        const char *input = executor->document->input_count == 1 ? executor->document->inputs[0].file : NULL;
+        const char *base = input ? strrchr(input, '/') : NULL;
+        snprintf(track, sizeof(track), "%s%sstep %u", input ? (base ? base + 1 : input) : "",
+                 input ? " " : "", step_index);
+        iq_trace_span(step->tool_name, track, running->trace_start, iq_profile_now());
+    }
+
+    // Check execution result
+    if (exit_code == 0 && !running->timed_out) {
+        result->success = true;
+
+        // Try to identify output files (basic implementation)
+        // In a real implementation, this would parse tool output
+        if (strstr(step->tool_name, "iqls") != NULL) {
+            strcpy(result->output_files, "spectrum.png,waterfall.png");
+        } else if (strstr(step->tool_name, "iqdetect") != NULL) {
+            strcpy(result->output_files, "events.csv");
+        } else if (strstr(step->tool_name, "iqdemod") != NULL) {
+            strcpy(result->output_files, "audio.wav");
+        }
+
+        if (executor->log_handle) {
+            fprintf((FILE *)executor->log_handle, "[STEP %u] SUCCESS (%.3fs, %.3fs CPU)\n",
+                    step_index, result->execution_time,
+                    usage->user_seconds + usage->system_seconds);
+        }
+    } else {
+        result->success = false;
+        if (running->timed_out) {
+            snprintf(result->error_message, sizeof(result->error_message),
+                     "Timed out after %.1f seconds", executor->config.timeout_seconds);
+        } else {
+            snprintf(result->error_message, sizeof(result->error_message),
+                     "Command failed with exit code %d", exit_code);
+        }
+
+        if (executor->log_handle) {
+            fprintf((FILE *)executor->log_handle, "[STEP %u] FAILED (%.3fs): %s\n",
+                    step_index, result->execution_time, result->error_message);
+        }
+    }
+    if (executor->log_handle) fflush((FILE *)executor->log_handle);
+}
+
+// Poll a running step, killing it past the timeout; true once finished
+static bool poll_step(pipeline_executor_t *executor, uint32_t step_index,
+                      pipeline_step_result_t *result, running_step_t *running) {
+    int exit_code;
+    pipeline_step_usage_t usage;
+    if (process_poll(running->process, &exit_code, &usage)) {
+        finish_step(executor, step_index, result, running, exit_code, &usage);
+        return true;
+    }
+    if (!running->timed_out &&
+        monotonic_seconds() - running->start > executor->config.timeout_seconds) {
+        process_kill(running->process);
+        running->timed_out = true;
+    }
+    return false;
+}
+
+// Restore a step's outputs from the step cache; true (result filled) on a
+// hit. 'key' receives the step's key, "" without a cache or when an input
+// cannot be read.
+static bool restore_cached_step(pipeline_executor_t *executor, uint32_t step_index,
+                                pipeline_step_result_t *result, char key[STEP_CACHE_KEY_SIZE]) {
+    key[0] = '\0';
+    if (!executor->cache) return false;
+
+    // The tool executable stands for its version
+    const yaml_pipeline_step_t *step = &executor->document->pipeline[step_index];
+    char tool_path[512];
+    snprintf(tool_path, sizeof(tool_path), PIPELINE_TOOL_FORMAT,
+             executor->config.tool_dir, step->tool_name);
+    if (!step_cache_key(executor->cache, step, tool_path, key)) {
+        key[0] = '\0';
+        return false;
+    }
+
+    time_t start = time(NULL);
+    char restored[512];
+    if (!step_cache_restore(executor->cache, key, restored, sizeof(restored))) return false;
+
+    memset(result, 0, sizeof(pipeline_step_result_t));
+    result->step_index = step_index;
+    snprintf(result->tool_name, sizeof(result->tool_name), "%s", step->tool_name);
+    result->start_time = start;
+    result->end_time = time(NULL);
+    result->start_offset = monotonic_seconds() - executor->start_clock;
+    strcpy(result->output_files, restored);
+    strcpy(result->cache_key, key);
+    result->success = true;
+    result->cached = true;
+    executor->cached_steps++;
+
+    if (executor->log_handle) {
+        fprintf((FILE *)executor->log_handle, "[STEP %u] CACHED %s (%s)\n",
+                step_index, key, restored);
+        fflush((FILE *)executor->log_handle);
+    }
+    return true;
+}
+
+// Record a step's key and, if it succeeded, store the files it wrote
+static void store_cached_step(pipeline_executor_t *executor, uint32_t step_index,
+                              pipeline_step_result_t *result, const char *key) {
+    if (!executor->cache || !key[0]) return;
+
+    strcpy(result->cache_key, key);
+    if (result->success) {
+        step_cache_store(executor->cache, key, &executor->document->pipeline[step_index],
+                         result->start_time);
+    }
+}
+
+typedef enum {
+    STEP_PENDING,
+    STEP_RUNNING,
+    STEP_DONE
+} step_state_t;
+
+// Count a finished (or skipped) step
+static void account_step(pipeline_executor_t *executor, uint32_t step_index, bool *overall_success) {
+    const pipeline_step_result_t *result = &executor->results[step_index];
+    if (result->success) {
+        executor->completed_steps++;
+    } else {
+        executor->failed_steps++;
+        *overall_success = false;
+    }
+    executor->total_execution_time += result->execution_time;
+    executor->total_cpu_time += result->usage.user_seconds + result->usage.system_seconds;
+}
+
+// Record a step that cannot run because a step it reads from failed
+static void skip_step(pipeline_executor_t *executor, uint32_t step_index,
+                      pipeline_step_result_t *result) {
+    memset(result, 0, sizeof(*result));
+    result->step_index = step_index;
+    snprintf(result->tool_name, sizeof(result->tool_name), "%s",
+             executor->document->pipeline[step_index].tool_name);
+    strcpy(result->error_message, "Skipped: a step it reads from failed");
+}
+
+// State of one pipeline_execute pass; fan-out runs keep one per input
+typedef struct {
+    step_state_t state[PIPELINE_MAX_STEPS];
+    running_step_t running[PIPELINE_MAX_STEPS];
+    char keys[PIPELINE_MAX_STEPS][STEP_CACHE_KEY_SIZE];
+    uint32_t limit;                 // Steps of this pipeline running at once
+    uint32_t all, finished, succeeded, running_count;
+    bool stop;                      // No new steps (first error without continue_on_error)
+    bool overall_success;
+} step_schedule_t;
+
+/*
+ * Asked before a ready step is started with the step's index; false defers
+ * it to a later call. Fan-out runs use it to hold steps of every input
+ * within one CPU and memory budget.
+ */
+typedef bool (*step_admit_t)(void *context, uint32_t step_index);
+
+// Told when an admitted step has finished (or failed to start)
+typedef void (*step_release_t)(void *context, uint32_t step_index,
+                               const pipeline_step_result_t *result);
+
+static void schedule_begin(pipeline_executor_t *executor, step_schedule_t *schedule) {
+    memset(schedule->state, 0, sizeof(schedule->state));
+    schedule->limit = 1;  // One step at a time without parallelism
+    if (executor->config.enable_parallel) {
+        schedule->limit = executor->config.max_parallel_jobs < PIPELINE_MAX_STEPS
+                              ? executor->config.max_parallel_jobs : PIPELINE_MAX_STEPS;
+    }
+    schedule->all = executor->result_count == PIPELINE_MAX_STEPS
+                        ? ~0u : (1u << executor->result_count) - 1u;
+    schedule->finished = schedule->succeeded = schedule->running_count = 0;
+    schedule->stop = false;
+    schedule->overall_success = true;
+
+    executor->running = true;
+    executor->start_clock = monotonic_seconds();
+    if (executor->log_handle) {
+        time_t now = time(NULL);
+        fprintf((FILE *)executor->log_handle, "[%s] Starting pipeline execution\n",
+                ctime(&now));
+        fflush((FILE *)executor->log_handle);
+    }
+}
+
+// True once no step is running and none can start
+static bool schedule_done(const step_schedule_t *schedule) {
+    return schedule->running_count == 0 && (schedule->finished == schedule->all || schedule->stop);
+}
+
+static void schedule_end(pipeline_executor_t *executor, const step_schedule_t *schedule) {
+    executor->running = false;
+    if (executor->log_handle) {
+        time_t now = time(NULL);
+        fprintf((FILE *)executor->log_handle, "[%s] Pipeline execution %s\n",
+                ctime(&now), schedule->overall_success ? "completed successfully" : "failed");
+        fflush((FILE *)executor->log_handle);
+    }
+}
+
+// Start ready steps in pipeline order (restoring cached ones, skipping
+// those whose inputs failed); returns the number of steps that changed state
+static uint32_t schedule_start(pipeline_executor_t *executor, step_schedule_t *schedule,
+                               step_admit_t admit, step_release_t release, void *context) {
+    uint32_t changed = 0;
+    for (uint32_t i = 0; i < executor->result_count && !schedule->stop; i++) {
+        if (schedule->state[i] != STEP_PENDING ||
+            (executor->waits_for[i] & ~schedule->finished) != 0) {
+            continue;
+        }
+
+        pipeline_step_result_t *result = &executor->results[i];
+        if ((executor->needs[i] & ~schedule->succeeded) != 0) {
+            skip_step(executor, i, result);
+        } else if (schedule->running_count < schedule->limit) {
+            executor->current_step = i;
+            if (restore_cached_step(executor, i, result, schedule->keys[i])) {
+                schedule->state[i] = STEP_DONE;
+                schedule->finished |= 1u << i;
+                schedule->succeeded |= 1u << i;
+                account_step(executor, i, &schedule->overall_success);
+                changed++;
+                continue;
+            }
+            if (admit && !admit(context, i)) continue;
+            if (start_step(executor, i, result, &schedule->running[i])) {
+                schedule->state[i] = STEP_RUNNING;
+                schedule->running_count++;
+                if (schedule->running_count > executor->peak_running) {
+                    executor->peak_running = schedule->running_count;
+                }
+                changed++;
+                continue;
+            }
+            if (release) release(context, i, result);
+        } else {
+            continue;
+        }
+
+        // Skipped, or could not be started
+        schedule->state[i] = STEP_DONE;
+        schedule->finished |= 1u << i;
+        account_step(executor, i, &schedule->overall_success);
+        changed++;
+        if (!executor->config.continue_on_error) schedule->stop = true;  // Stop on first error
+    }
+    return changed;
+}
+
+// Collect finished steps; returns how many finished
+static uint32_t schedule_collect(pipeline_executor_t *executor, step_schedule_t *schedule,
+                                 step_release_t release, void *context) {
+    uint32_t collected = 0;
+    for (uint32_t i = 0; i < executor->result_count; i++) {
+        if (schedule->state[i] != STEP_RUNNING ||
+            !poll_step(executor, i, &executor->results[i], &schedule->running[i])) {
+            continue;
+        }
+        schedule->state[i] = STEP_DONE;
+        schedule->finished |= 1u << i;
+        schedule->running_count--;
+        collected++;
+        store_cached_step(executor, i, &executor->results[i], schedule->keys[i]);
+        if (release) release(context, i, &executor->results[i]);
+        if (executor->results[i].success) {
+            schedule->succeeded |= 1u << i;
+        } else if (!executor->config.continue_on_error) {
+            schedule->stop = true;  // Stop on first error; running steps still finish
+        }
+        account_step(executor, i, &schedule->overall_success);
+    }
+    return collected;
+}
+
+/**
+ * @brief Execute pipeline
+ */
+bool pipeline_execute(pipeline_executor_t *executor) {
+    if (!executor || !executor->initialized || executor->running) {
+        return false;
+    }
+
+    step_schedule_t schedule;
+    schedule_begin(executor, &schedule);
+    for (;;) {
+        schedule_start(executor, &schedule, NULL, NULL, NULL);
+        if (schedule_done(&schedule)) break;
+
+        // Sleep briefly when no step has finished
+        if (schedule_collect(executor, &schedule, NULL, NULL) == 0) sleep_ms(PIPELINE_POLL_MS);
+    }
+    schedule_end(executor, &schedule);
+
+    return schedule.overall_success;
+}
+
+/**
+ * @brief Execute single pipeline step
+ */
+bool pipeline_execute_step(pipeline_executor_t *executor, uint32_t step_index,
+                          pipeline_step_result_t *result) {
+    if (!executor || !result || step_index >= executor->result_count) {
+        return false;
+    }
+
+    running_step_t running;
+    if (!start_step(executor, step_index, result, &running)) return false;
+    while (!poll_step(executor, step_index, result, &running)) sleep_ms(PIPELINE_POLL_MS);
+    return result->success;
+}
+
+// getopt_long keeps its position between calls; start each tool afresh
+static void reset_option_parser(void) {
+#ifdef __GLIBC__
+    optind = 0;  // Also re-reads the glibc permutation settings
+#else
+    optind = 1;
+#endif
+}
+
+// Call a tool core for a step and record its exit code (the caller resets
+// the option parser)
+static bool run_in_process(pipeline_executor_t *executor, uint32_t step_index,
+                           pipeline_step_result_t *result, const pipeline_tool_t *tool) {
+    memset(result, 0, sizeof(pipeline_step_result_t));
+    result->step_index = step_index;
+    result->start_time = time(NULL);
+
+    const yaml_pipeline_step_t *step = &executor->document->pipeline[step_index];
+    snprintf(result->tool_name, sizeof(result->tool_name), "%s", step->tool_name);
+
+    char command[2048];
+    step_command_t argv;
+    if (!pipeline_build_command(executor, step_index, command, sizeof(command)) ||
+        !build_argv(executor, step_index, &argv)) {
+        strcpy(result->error_message, "Failed to build command");
+        result->end_time = time(NULL);
+        return false;
+    }
+    argv.argv[0] = (char *)step->tool_name;
+
+    if (executor->log_handle) {
+        fprintf((FILE *)executor->log_handle, "[STEP %u] Executing in process: %s\n",
+                step_index, command);
+        fflush((FILE *)executor->log_handle);
+    }
+
+    running_step_t running = {0};
+    pipeline_step_usage_t before, usage;
+    self_usage(&before);
+    running.start = monotonic_seconds();
+    running.trace_start = iq_profile_begin();
+    int exit_code = tool->entry(argv.argc, argv.argv);
+    fflush(stdout);
+    fflush(stderr);
+    usage_since(&before, &usage);
+
+    finish_step(executor, step_index, result, &running, exit_code, &usage);
+    return result->success;
+}
+
+// In-process core of a tool, NULL if it must be spawned
+static const pipeline_tool_t *find_tool(const pipeline_tool_t *tools, uint32_t tool_count,
+                                        const char *name) {
+    for (uint32_t t = 0; t < tool_count; t++) {
+        if (strcmp(tools[t].name, name) == 0) return &tools[t];
+    }
+    return NULL;
+}
+
+// Value of a step parameter, NULL if the step does not set it
+static const char *step_param(const yaml_pipeline_step_t *step, const char *key) {
+    for (uint32_t i = 0; i < step->param_count; i++) {
+        if (strcmp(step->params[i].key, key) == 0) return step->params[i].value;
+    }
+    return NULL;
+}
+
+// STFT a step's spectral rows come from
+typedef struct {
+    const char *path;
+    uint32_t fft_size;
+    uint32_t hop;
+    window_type_t window_type;
+} step_stft_t;
+
+// Parse a positive decimal parameter
+static bool parse_count(const char *text, uint32_t *value) {
+    if (!text || text[0] < '0' || text[0] > '9') return false;
+    char *end;
+    unsigned long parsed = strtoul(text, &end, 10);
+    if (*end != '\0' || parsed == 0 || parsed > UINT32_MAX) return false;
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+// False unless the step names its input, FFT size and hop explicitly (tool
+// defaults differ) and a known window
+static bool step_stft(const yaml_pipeline_step_t *step, step_stft_t *stft) {
+    stft->path = step_param(step, "in");
+    if (!stft->path || !stft->path[0] ||
+        !parse_count(step_param(step, "fft"), &stft->fft_size) ||
+        !parse_count(step_param(step, "hop"), &stft->hop)) {
+        return false;
+    }
+    const char *window = step_param(step, "window");
+    stft->window_type = WINDOW_RECTANGULAR;
+    return !window || window_type_from_name(window, &stft->window_type);
+}
+
+static bool same_stft(const step_stft_t *a, const step_stft_t *b) {
+    return strcmp(a->path, b->path) == 0 && a->fft_size == b->fft_size &&
+           a->hop == b->hop && a->window_type == b->window_type;
+}
+
+/*
+ * Steps that run with step 'first' on one spectral bus, as a bitmask (just
+ * 'first' when nothing joins it): later pending steps of spectral-row tools
+ * over the same STFT whose needs are met and that may move ahead of every
+ * pending step before them: those are read-only tools and no output is
+ * read or written by both sides. This holds with or without
+ * enable_parallel, which in-process runs do not use.
+ */
+static uint32_t fuse_group(const pipeline_executor_t *executor, uint32_t first,
+                           const pipeline_tool_t *tool, const pipeline_tool_t *tools,
+                           uint32_t tool_count, uint32_t done, uint32_t succeeded) {
+    const yaml_pipeline_step_t *steps = executor->document->pipeline;
+    uint32_t group = 1u << first;
+    step_stft_t key;
+    if (!tool->spectral_rows || !step_stft(&steps[first], &key)) return group;
+
+    uint32_t members = 1;
+    for (uint32_t j = first + 1; j < executor->result_count && members < SPECTRAL_BUS_MAX_SUBSCRIBERS; j++) {
+        const pipeline_tool_t *other = find_tool(tools, tool_count, steps[j].tool_name);
+        step_stft_t stft;
+        if ((done & (1u << j)) || !other || !other->spectral_rows ||
+            (executor->needs[j] & ~succeeded) != 0 ||
+            !step_stft(&steps[j], &stft) || !same_stft(&key, &stft)) {
+            continue;
+        }
+        bool independent = true;
+        for (uint32_t k = first; k < j && independent; k++) {
+            if (done & (1u << k)) continue;
+            independent = tool_is_read_only(steps[k].tool_name) &&
+                          !step_reads_outputs_of(&steps[j], &steps[k]) &&
+                          !step_reads_outputs_of(&steps[k], &steps[j]) &&
+                          !steps_share_output(&steps[j], &steps[k]);
+        }
+        if (!independent) continue;
+        group |= 1u << j;
+        members++;
+    }
+    return group;
+}
+
+// One step of a fused group and the bus subscriber its thread stands for
+typedef struct {
+    pipeline_executor_t *executor;
+    uint32_t step_index;
+    const pipeline_tool_t *tool;
+    spectral_bus_t *bus;
+    uint32_t subscriber;
+    pthread_t thread;
+    bool threaded;
+} fused_step_t;
+
+static void *run_fused_step(void *arg) {
+    fused_step_t *fused = (fused_step_t *)arg;
+    char name[64];
+    snprintf(name, sizeof(name), "%s (step %u)", fused->tool->name, fused->step_index);
+    iq_trace_thread_name(name);
+    spectral_bus_bind(fused->bus, fused->subscriber);
+    run_in_process(fused->executor, fused->step_index,
+                   &fused->executor->results[fused->step_index], fused->tool);
+    spectral_bus_bind(NULL, 0);
+
+    // A core that stopped early (or never read) must not hold the producer
+    spectral_bus_detach(fused->bus, fused->subscriber);
+    return NULL;
+}
+
+// Run a fused group: one bus for the shared STFT, one thread per step.
+// Without a bus (or a thread) a step runs on its own afterwards.
+static void run_fused(pipeline_executor_t *executor, uint32_t group,
+                      const pipeline_tool_t *tools, uint32_t tool_count) {
+    const yaml_pipeline_step_t *steps = executor->document->pipeline;
+    fused_step_t fused[SPECTRAL_BUS_MAX_SUBSCRIBERS];
+    uint32_t count = 0, formats = 0;
+    for (uint32_t i = 0; i < executor->result_count; i++) {
+        if (!(group & (1u << i))) continue;
+        fused[count].executor = executor;
+        fused[count].step_index = i;
+        fused[count].tool = find_tool(tools, tool_count, steps[i].tool_name);
+        fused[count].subscriber = count;
+        fused[count].threaded = false;
+        formats |= fused[count].tool->spectral_rows;
+        count++;
+    }
+
+    step_stft_t key;
+    step_stft(&steps[fused[0].step_index], &key);
+    spectral_bus_t *bus = spectral_bus_create(key.path, key.fft_size, key.hop, key.window_type,
+                                              count, formats);
+    if (bus && !spectral_bus_start(bus)) {
+        spectral_bus_destroy(bus);
+        bus = NULL;
+    }
+
     if (executor->log_handle) {
-        fclose((FILE *)executor->log_handle);
+        fprintf((FILE *)executor->log_handle, bus ?
+                "[FUSED] %u steps share one STFT of %s (fft %u, hop %u)\n" :
+                "[FUSED] %u steps over %s (fft %u, hop %u) run separately\n",
+                count, key.path, key.fft_size, key.hop);
+        fflush((FILE *)executor->log_handle);
     }
 
-    // Free results array
-    free(executor->results);
-
-    free(executor);
+    reset_option_parser();
+    uint32_t running = 0;
+    for (uint32_t k = 0; bus && k < count; k++) {
+        fused[k].bus = bus;
+        fused[k].threaded = pthread_create(&fused[k].thread, NULL, run_fused_step, &fused[k]) == 0;
+        if (fused[k].threaded) running++;
+        else spectral_bus_detach(bus, k);
+    }
+    if (running > executor->peak_running) executor->peak_running = running;
+    for (uint32_t k = 0; k < count; k++) {
+        if (fused[k].threaded) pthread_join(fused[k].thread, NULL);
+    }
+    spectral_bus_destroy(bus);
+
+    for (uint32_t k = 0; k < count; k++) {
+        if (fused[k].threaded) continue;
+        executor->current_step = fused[k].step_index;
+        reset_option_parser();
+        run_in_process(executor, fused[k].step_index, &executor->results[fused[k].step_index],
+                       fused[k].tool);
+    }
 }
 
 /**
- * @brief Execute pipeline
+ * @brief Execute pipeline in process over shared decoded inputs
  */
-bool pipeline_execute(pipeline_executor_t *executor) {
-    if (!executor || !executor->initialized || executor->running) {
+bool pipeline_execute_in_process(pipeline_executor_t *executor,
+                                 const pipeline_tool_t *tools, uint32_t tool_count) {
+    if (!executor || !executor->initialized || executor->running || (tool_count && !tools)) {
         return false;
     }
 
     executor->running = true;
+    executor->start_clock = monotonic_seconds();
     bool overall_success = true;
 
-    // Log execution start
     if (executor->log_handle) {
         time_t now = time(NULL);
-        fprintf((FILE *)executor->log_handle, "[%s] Starting pipeline execution\n",
+        fprintf((FILE *)executor->log_handle, "[%s] Starting in-process pipeline execution\n",
                 ctime(&now));
-        fflush((FILE *)executor->log_handle);
     }
 
-    // Execute each step
+    // Decode each distinct input once; readers of its path share the samples
+    const yaml_document_t *document = executor->document;
+    iq_source_t *sources = (iq_source_t *)calloc(document->input_count + 1, sizeof(iq_source_t));
+    if (!sources) {
+        executor->running = false;
+        return false;
+    }
+    for (uint32_t i = 0; i < document->input_count; i++) {
+        const char *path = document->inputs[i].file;
+        if (path[0] == '\0' || iq_source_find(path)) continue;
+
+        if (iq_source_load(&sources[i], path) && iq_source_publish(&sources[i])) {
+            if (executor->log_handle) {
+                fprintf((FILE *)executor->log_handle, "[INPUT] Decoded %s once (%zu samples)\n",
+                        path, sources[i].num_samples);
+            }
+        } else {
+            // Steps still read the file themselves
+            iq_source_free(&sources[i]);
+            if (executor->log_handle) {
+                fprintf((FILE *)executor->log_handle, "[INPUT] %s not shared; steps read the file\n",
+                        path);
+            }
+        }
+    }
+
+    // One step at a time: the tool cores share process state (getopt, stdio);
+    // only fused steps, which do not use getopt, run together
+    uint32_t succeeded = 0, done = 0;
+    char keys[PIPELINE_MAX_STEPS][STEP_CACHE_KEY_SIZE];
     for (uint32_t i = 0; i < executor->result_count; i++) {
+        if (done & (1u << i)) continue;  // Ran in an earlier fused group
+        pipeline_step_result_t *result = &executor->results[i];
         executor->current_step = i;
 
-        if (!pipeline_execute_step(executor, i, &executor->results[i])) {
-            executor->failed_steps++;
-            overall_success = false;
-
-            if (!executor->config.continue_on_error) {
-                break; // Stop on first error
+        const pipeline_tool_t *tool = find_tool(tools, tool_count, document->pipeline[i].tool_name);
+
+        if ((executor->needs[i] & ~succeeded) != 0) {
+            skip_step(executor, i, result);
+        } else if (restore_cached_step(executor, i, result, keys[i])) {
+            // Outputs restored; nothing to run
+        } else if (tool) {
+            // Later steps over the same STFT join this one on a shared bus,
+            // unless their outputs are already in the cache
+            uint32_t group = fuse_group(executor, i, tool, tools, tool_count, done, succeeded);
+            for (uint32_t j = i + 1; j < executor->result_count; j++) {
+                if (!(group & (1u << j)) ||
+                    !restore_cached_step(executor, j, &executor->results[j], keys[j])) {
+                    continue;
+                }
+                group &= ~(1u << j);
+                done |= 1u << j;
+                succeeded |= 1u << j;
+                account_step(executor, j, &overall_success);
             }
+            if (group != (1u << i)) {
+                run_fused(executor, group, tools, tool_count);
+                bool failed = false;
+                for (uint32_t j = i; j < executor->result_count; j++) {
+                    if (!(group & (1u << j))) continue;
+                    store_cached_step(executor, j, &executor->results[j], keys[j]);
+                    if (executor->results[j].success) succeeded |= 1u << j;
+                    else failed = true;
+                    account_step(executor, j, &overall_success);
+                }
+                done |= group;
+                if (failed && !executor->config.continue_on_error) break;  // Stop on first error
+                continue;
+            }
+            reset_option_parser();
+            run_in_process(executor, i, result, tool);
+            store_cached_step(executor, i, result, keys[i]);
         } else {
-            executor->completed_steps++;
+            pipeline_execute_step(executor, i, result);
+            store_cached_step(executor, i, result, keys[i]);
         }
+        if (executor->peak_running < 1) executor->peak_running = 1;
+
+        done |= 1u << i;
+        if (result->success) succeeded |= 1u << i;
+        account_step(executor, i, &overall_success);
+        if (!result->success && !executor->config.continue_on_error) break;  // Stop on first error
+    }
 
-        // Update total execution time
-        executor->total_execution_time += executor->results[i].execution_time;
+    for (uint32_t i = 0; i < document->input_count; i++) {
+        iq_source_free(&sources[i]);
     }
+    free(sources);
 
     executor->running = false;
 
-    // Log execution completion
     if (executor->log_handle) {
         time_t now = time(NULL);
         fprintf((FILE *)executor->log_handle, "[%s] Pipeline execution %s\n",
@@ -173,80 +1309,6 @@ bool pipeline_execute(pipeline_executor_t *executor) {
     return overall_success;
 }
 
-/**
- * @brief Execute single pipeline step
- */
-bool pipeline_execute_step(pipeline_executor_t *executor, uint32_t step_index,
-                          pipeline_step_result_t *result) {
-    if (!executor || !result || step_index >= executor->result_count) {
-        return false;
-    }
-
-    // Initialize result
-    memset(result, 0, sizeof(pipeline_step_result_t));
-    result->step_index = step_index;
-    result->start_time = time(NULL);
-
-    const yaml_pipeline_step_t *step = &executor->document->pipeline[step_index];
-    strcpy(result->tool_name, step->tool_name);
-
-    // Build command
-    char command[2048];
-    if (!pipeline_build_command(executor, step_index, command, sizeof(command))) {
-        strcpy(result->error_message, "Failed to build command");
-        result->end_time = time(NULL);
-        result->execution_time = difftime(result->end_time, result->start_time);
-        return false;
-    }
-
-    // Log command execution
-    if (executor->log_handle) {
-        fprintf((FILE *)executor->log_handle, "[STEP %u] Executing: %s\n",
-                step_index, command);
-        fflush((FILE *)executor->log_handle);
-    }
-
-    // Execute command
-    clock_t start_clock = clock();
-    int exit_code = system(command);
-    clock_t end_clock = clock();
-
-    result->end_time = time(NULL);
-    result->execution_time = (double)(end_clock - start_clock) / CLOCKS_PER_SEC;
-    result->exit_code = exit_code;
-
-    // Check execution result
-    if (exit_code == 0) {
-        result->success = true;
-
-        // Try to identify output files (basic implementation)
-        // In a real implementation, this would parse tool output
-        if (strstr(step->tool_name, "iqls") != NULL) {
-            strcpy(result->output_files, "spectrum.png,waterfall.png");
-        } else if (strstr(step->tool_name, "iqdetect") != NULL) {
-            strcpy(result->output_files, "events.csv");
-        } else if (strstr(step->tool_name, "iqdemod") != NULL) {
-            strcpy(result->output_files, "audio.wav");
-        }
-
-        if (executor->log_handle) {
-            fprintf((FILE *)executor->log_handle, "[STEP %u] SUCCESS (%.3fs)\n",
-                    step_index, result->execution_time);
-        }
-    } else {
-        result->success = false;
-        snprintf(result->error_message, sizeof(result->error_message),
-                "Command failed with exit code %d", exit_code);
-
-        if (executor->log_handle) {
-            fprintf((FILE *)executor->log_handle, "[STEP %u] FAILED (%.3fs): %s\n",
-                    step_index, result->execution_time, result->error_message);
-        }
-    }
-
-    return result->success;
-}
-
 /**
  * @brief Build command line for pipeline step
  */
@@ -259,7 +1321,8 @@ bool pipeline_build_command(const pipeline_executor_t *executor, uint32_t step_i
     const yaml_pipeline_step_t *step = &executor->document->pipeline[step_index];
 
     // Start with tool name
-    int written = snprintf(command_buffer, buffer_size, ".\\%s.exe", step->tool_name);
+    int written = snprintf(command_buffer, buffer_size, PIPELINE_TOOL_FORMAT,
+                           executor->config.tool_dir, step->tool_name);
     if (written < 0 || (uint32_t)written >= buffer_size) return false;
 
     // Add parameters
@@ -267,9 +1330,9 @@ bool pipeline_build_command(const pipeline_executor_t *executor, uint32_t step_i
         const char *key = step->params[i].key;
         const char *value = step->params[i].value;
 
-        int param_written = snprintf(command_buffer + written,
-                                   buffer_size - written,
-                                   " --%s %s", key, value);
+        int param_written = is_flag_value(value) ?
+            snprintf(command_buffer + written, buffer_size - written, " --%s", key) :
+            snprintf(command_buffer + written, buffer_size - written, " --%s %s", key, value);
         if (param_written < 0 || (uint32_t)(written + param_written) >= buffer_size) {
             return false;
         }
@@ -279,6 +1342,21 @@ bool pipeline_build_command(const pipeline_executor_t *executor, uint32_t step_i
     return true;
 }
 
+/**
+ * @brief Check whether a step waits for an earlier one
+ */
+bool pipeline_step_depends_on(const pipeline_executor_t *executor, uint32_t step_index,
+                              uint32_t earlier_index, bool *must_succeed) {
+    if (!executor || step_index >= executor->result_count || earlier_index >= step_index) {
+        if (must_succeed) *must_succeed = false;
+        return false;
+    }
+
+    uint32_t bit = 1u << earlier_index;
+    if (must_succeed) *must_succeed = (executor->needs[step_index] & bit) != 0;
+    return (executor->waits_for[step_index] & bit) != 0;
+}
+
 /**
  * @brief Check if pipeline step can be executed in parallel
  */
@@ -291,20 +1369,12 @@ bool pipeline_can_parallelize(const pipeline_executor_t *executor, uint32_t step
     const yaml_pipeline_step_t *step = &executor->document->pipeline[step_index];
     const char *tool_name = step->tool_name;
 
-    // Tools that typically can be parallelized
-    if (strcmp(tool_name, "iqls") == 0 ||
-        strcmp(tool_name, "iqinfo") == 0) {
+    // Analysis tools only read their inputs; the graph still keeps a step
+    // after any earlier step whose outputs it reads
+    if (tool_is_read_only(tool_name)) {
         return executor->config.enable_parallel;
     }
 
-    // Tools that should be sequential (depend on previous results)
-    if (strcmp(tool_name, "iqdetect") == 0 ||
-        strcmp(tool_name, "iqdemod-fm") == 0 ||
-        strcmp(tool_name, "iqdemod-am") == 0 ||
-        strcmp(tool_name, "iqdemod-ssb") == 0) {
-        return false;
-    }
-
     // Default: assume sequential for safety
     return false;
 }
@@ -380,13 +1450,15 @@ bool pipeline_generate_summary(const pipeline_executor_t *executor,
                           "Total Steps: %u\n"
                           "Completed: %u\n"
                           "Failed: %u\n"
+                          "Cached: %u\n"
                           "Success Rate: %.1f%%\n"
                           "Total Time: %.3f seconds\n"
+                          "Total CPU Time: %.3f seconds\n"
                           "Average Step Time: %.3f seconds\n"
                           "Completion: %.1f%%\n",
-                          total, completed, executor->failed_steps,
-                          success_rate * 100.0, total_time, avg_step_time,
-                          percent_complete);
+                          total, completed, executor->failed_steps, executor->cached_steps,
+                          success_rate * 100.0, total_time, executor->total_cpu_time,
+                          avg_step_time, percent_complete);
 
     if (written < 0 || (uint32_t)written >= buffer_size) {
         return false;
@@ -400,10 +1472,13 @@ bool pipeline_generate_summary(const pipeline_executor_t *executor,
                                   buffer_size - written,
                                   "\nStep %u: %s\n"
                                   "  Status: %s\n"
-                                  "  Time: %.3f seconds\n",
+                                  "  Time: %.3f seconds (started at +%.3f s)\n"
+                                  "  CPU: %.3f s user, %.3f s system; peak RSS %.1f MB\n",
                                   i, result->tool_name,
-                                  result->success ? "SUCCESS" : "FAILED",
-                                  result->execution_time);
+                                  result->cached ? "CACHED" : result->success ? "SUCCESS" : "FAILED",
+                                  result->execution_time, result->start_offset,
+                                  result->usage.user_seconds, result->usage.system_seconds,
+                                  result->usage.max_rss_bytes / (1024.0 * 1024.0));
 
         if (step_written < 0) break;
         written += step_written;
@@ -440,17 +1515,25 @@ bool pipeline_save_results(const pipeline_executor_t *executor, const char *file
     fprintf(file, "# Total steps: %u\n", executor->result_count);
     fprintf(file, "# Completed: %u\n", executor->completed_steps);
     fprintf(file, "# Failed: %u\n", executor->failed_steps);
+    fprintf(file, "# Cached: %u\n", executor->cached_steps);
     fprintf(file, "# Total time: %.3f seconds\n", executor->total_execution_time);
+    fprintf(file, "# Total CPU time: %.3f seconds\n", executor->total_cpu_time);
     fprintf(file, "\n");
 
     // Write CSV header
-    fprintf(file, "step_index,tool_name,success,exit_code,execution_time,start_time,end_time,output_files,error_message\n");
+    fprintf(file, "step_index,tool_name,success,exit_code,execution_time,start_time,end_time,output_files,error_message,cached,cache_key,"
+                  "start_offset,user_seconds,system_seconds,cpu_utilization,max_rss_bytes,read_bytes,write_bytes\n");
 
     // Write results
     for (uint32_t i = 0; i < executor->result_count; i++) {
         const pipeline_step_result_t *result = &executor->results[i];
+        const pipeline_step_usage_t *usage = &result->usage;
 
-        fprintf(file, "%u,%s,%s,%d,%.3f,%lld,%lld,\"%s\",\"%s\"\n",
+        // Cores kept busy on average: above 1 a step uses several
+        double cpu = usage->user_seconds + usage->system_seconds;
+        double utilization = result->execution_time > 0.0 ? cpu / result->execution_time : 0.0;
+
+        fprintf(file, "%u,%s,%s,%d,%.3f,%lld,%lld,\"%s\",\"%s\",%s,%s,%.3f,%.3f,%.3f,%.2f,%llu,%llu,%llu\n",
                 result->step_index,
                 result->tool_name,
                 result->success ? "true" : "false",
@@ -459,7 +1542,16 @@ bool pipeline_save_results(const pipeline_executor_t *executor, const char *file
                 (long long)result->start_time,
                 (long long)result->end_time,
                 result->output_files,
-                result->error_message);
+                result->error_message,
+                result->cached ? "true" : "false",
+                result->cache_key,
+                result->start_offset,
+                usage->user_seconds,
+                usage->system_seconds,
+                utilization,
+                (unsigned long long)usage->max_rss_bytes,
+                (unsigned long long)usage->read_bytes,
+                (unsigned long long)usage->write_bytes);
     }
 
     fclose(file);
@@ -501,9 +1593,568 @@ bool pipeline_reset(pipeline_executor_t *executor) {
     executor->total_execution_time = 0.0;
     executor->completed_steps = 0;
     executor->failed_steps = 0;
+    executor->peak_running = 0;
+    executor->cached_steps = 0;
+    executor->total_cpu_time = 0.0;
 
     // Reset results
     memset(executor->results, 0, executor->result_count * sizeof(pipeline_step_result_t));
 
     return true;
 }
+
+// ---------------------------------------------------------------------------
+// Fan-out over inputs
+// ---------------------------------------------------------------------------
+
+static const char *const TEMPLATE_INPUT = "{input}";
+static const char *const TEMPLATE_STEM = "{stem}";
+static const char *const TEMPLATE_OUT_DIR = "{out_dir}";
+
+static bool uses_input(const char *text) {
+    return strstr(text, TEMPLATE_INPUT) != NULL || strstr(text, TEMPLATE_STEM) != NULL;
+}
+
+/**
+ * @brief Check whether a document's pipeline is a per-input template
+ */
+bool pipeline_document_is_template(const yaml_document_t *document) {
+    if (!document) return false;
+
+    for (uint32_t i = 0; i < document->pipeline_count; i++) {
+        const yaml_pipeline_step_t *step = &document->pipeline[i];
+        if (uses_input(step->output_dir)) return true;
+        for (uint32_t p = 0; p < step->param_count; p++) {
+            if (uses_input(step->params[p].value)) return true;
+        }
+    }
+    return false;
+}
+
+// File name without directory or (last) extension
+static void input_stem(const char *path, char *stem, size_t size) {
+    const char *name = path;
+    for (const char *c = path; *c; c++) {
+        if (*c == '/' || *c == '\\') name = c + 1;
+    }
+    const char *dot = strrchr(name, '.');
+    size_t length = dot && dot != name ? (size_t)(dot - name) : strlen(name);
+    snprintf(stem, size, "%.*s", (int)length, name);
+}
+
+/**
+ * @brief Expand a template string for one input
+ */
+bool pipeline_expand_text(const char *text, const char *input, const char *out_dir,
+                          char *buffer, size_t size) {
+    if (!text || !input || !out_dir || !buffer || size == 0) return false;
+
+    char stem[128];
+    input_stem(input, stem, sizeof(stem));
+    const char *names[3] = {TEMPLATE_INPUT, TEMPLATE_STEM, TEMPLATE_OUT_DIR};
+    const char *values[3] = {input, stem, out_dir};
+    size_t used = 0;
+    for (const char *c = text; *c;) {
+        int match = -1;
+        for (int n = 0; n < 3 && match < 0; n++) {
+            if (strncmp(c, names[n], strlen(names[n])) == 0) match = n;
+        }
+        const char *piece = match >= 0 ? values[match] : c;
+        size_t length = match >= 0 ? strlen(piece) : 1;
+        if (used + length >= size) return false;
+        memcpy(buffer + used, piece, length);
+        used += length;
+        c += match >= 0 ? strlen(names[match]) : 1;
+    }
+    buffer[used] = '\0';
+    return true;
+}
+
+// Copy of 'text' with the placeholders replaced, in the instance's arena
+static const char *expand_template(yaml_document_t *instance, const char *text,
+                                   const pipeline_fanout_t *fanout,
+                                   const pipeline_fanout_file_t *file) {
+    const char *names[3] = {TEMPLATE_INPUT, TEMPLATE_STEM, TEMPLATE_OUT_DIR};
+    const char *values[3] = {file->input, file->stem, fanout->config.working_dir};
+
+    // Measure, then fill
+    char *expanded = NULL;
+    size_t used = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        used = 0;
+        for (const char *c = text; *c;) {
+            int match = -1;
+            for (int n = 0; n < 3 && match < 0; n++) {
+                if (strncmp(c, names[n], strlen(names[n])) == 0) match = n;
+            }
+            const char *piece = match >= 0 ? values[match] : c;
+            size_t length = match >= 0 ? strlen(piece) : 1;
+            if (expanded) memcpy(expanded + used, piece, length);
+            used += length;
+            c += match >= 0 ? strlen(names[match]) : 1;
+        }
+        if (!expanded && !(expanded = (char *)malloc(used + 1))) return NULL;
+    }
+    expanded[used] = '\0';
+
+    const char *copy = yaml_copy_string(instance, expanded);
+    free(expanded);
+    return copy;
+}
+
+// The pipeline of one input: its input entry and the expanded steps
+static bool instantiate_pipeline(const pipeline_fanout_t *fanout, uint32_t file_index,
+                                 yaml_document_t *instance) {
+    const yaml_document_t *document = fanout->document;
+    pipeline_fanout_file_t *file = &fanout->files[file_index];
+    memset(instance, 0, sizeof(*instance));
+    instance->report = document->report;
+
+    // Strings not expanded stay the template's (it outlives the instance)
+    yaml_input_t *input = yaml_add_input(instance);
+    if (!input) return false;
+    *input = document->inputs[file_index];
+
+    for (uint32_t i = 0; i < document->pipeline_count; i++) {
+        const yaml_pipeline_step_t *source = &document->pipeline[i];
+        yaml_pipeline_step_t *step = yaml_add_step(instance);
+        if (!step) return false;
+        step->tool_name = source->tool_name;
+        step->output_dir = expand_template(instance, source->output_dir, fanout, file);
+        if (!step->output_dir) return false;
+        for (uint32_t p = 0; p < source->param_count; p++) {
+            const char *value = expand_template(instance, source->params[p].value, fanout, file);
+            if (!value || !yaml_set_step_param(instance, step, source->params[p].key, value)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Create a fan-out run over every input of a document
+ */
+pipeline_fanout_t *pipeline_fanout_create(const pipeline_config_t *config,
+                                          const yaml_document_t *document) {
+    if (!pipeline_config_validate(config) || !document || document->input_count == 0 ||
+        document->pipeline_count == 0 || document->pipeline_count > PIPELINE_MAX_STEPS) {
+        fprintf(stderr, "Fan-out needs a valid configuration, inputs and 1-%d steps\n",
+                PIPELINE_MAX_STEPS);
+        return NULL;
+    }
+
+    // Several inputs must not write the same outputs
+    if (document->input_count > 1) {
+        for (uint32_t i = 0; i < document->pipeline_count; i++) {
+            const yaml_pipeline_step_t *step = &document->pipeline[i];
+            const char *out = yaml_get_step_param(step, "out");
+            if ((out && !uses_input(out)) || (step->output_dir[0] && !uses_input(step->output_dir))) {
+                fprintf(stderr, "Step %u (%s) would write the same outputs for every input; "
+                        "use {stem} or {input} in its out/output_dir\n", i, step->tool_name);
+                return NULL;
+            }
+        }
+    }
+
+    pipeline_fanout_t *fanout = (pipeline_fanout_t *)calloc(1, sizeof(pipeline_fanout_t));
+    if (!fanout) return NULL;
+    memcpy(&fanout->config, config, sizeof(pipeline_config_t));
+    fanout->document = document;
+    fanout->file_count = document->input_count;
+    fanout->files = (pipeline_fanout_file_t *)calloc(fanout->file_count, sizeof(pipeline_fanout_file_t));
+    if (!fanout->files) {
+        free(fanout);
+        return NULL;
+    }
+
+    for (uint32_t f = 0; f < fanout->file_count; f++) {
+        pipeline_fanout_file_t *file = &fanout->files[f];
+        file->input = document->inputs[f].file;
+        input_stem(file->input, file->stem, sizeof(file->stem));
+        for (uint32_t g = 0; g < f && document->input_count > 1; g++) {
+            if (strcmp(fanout->files[g].stem, file->stem) == 0) {
+                fprintf(stderr, "Inputs %s and %s share the name '%s'; their outputs would collide\n",
+                        fanout->files[g].input, file->input, file->stem);
+                free(fanout->files);
+                free(fanout);
+                return NULL;
+            }
+        }
+    }
+
+    if (strlen(config->log_file) > 0) {
+        fanout->log_handle = (void *)fopen(config->log_file, "w");
+    }
+    return fanout;
+}
+
+/**
+ * @brief Destroy a fan-out run
+ */
+void pipeline_fanout_destroy(pipeline_fanout_t *fanout) {
+    if (!fanout) return;
+
+    if (fanout->log_handle) fclose((FILE *)fanout->log_handle);
+    for (uint32_t f = 0; f < fanout->file_count; f++) {
+        free(fanout->files[f].results);
+    }
+    free(fanout->files);
+    free(fanout);
+}
+
+// Shared budget of a fan-out run
+typedef struct {
+    pipeline_fanout_t *fanout;
+    uint32_t running;                       // Steps running over all inputs
+    uint64_t reserved;                      // Memory they reserved
+} fanout_budget_t;
+
+// An input in flight
+typedef struct {
+    fanout_budget_t *budget;
+    uint32_t file;                          // Index into fanout->files
+    yaml_document_t document;               // Its instantiated pipeline
+    pipeline_executor_t *executor;
+    step_schedule_t schedule;
+    double start;
+    uint64_t reserved[PIPELINE_MAX_STEPS];  // Held by each running step
+} fanout_slot_t;
+
+static bool fanout_admit(void *context, uint32_t step_index) {
+    fanout_slot_t *slot = (fanout_slot_t *)context;
+    fanout_budget_t *budget = slot->budget;
+    pipeline_fanout_t *fanout = budget->fanout;
+
+    if (budget->running >= fanout->config.max_parallel_jobs) return false;
+
+    // Unmeasured steps run alone under a budget, and so are measured
+    uint64_t estimate = fanout->step_rss[step_index];
+    if (fanout->config.memory_budget_bytes > 0 && budget->running > 0 &&
+        (estimate == 0 || budget->reserved + estimate > fanout->config.memory_budget_bytes)) {
+        return false;
+    }
+
+    budget->running++;
+    budget->reserved += estimate;
+    slot->reserved[step_index] = estimate;
+    if (budget->running > fanout->peak_running) fanout->peak_running = budget->running;
+    if (budget->reserved > fanout->peak_reserved_bytes) fanout->peak_reserved_bytes = budget->reserved;
+    return true;
+}
+
+static void fanout_release(void *context, uint32_t step_index, const pipeline_step_result_t *result) {
+    fanout_slot_t *slot = (fanout_slot_t *)context;
+    fanout_budget_t *budget = slot->budget;
+    pipeline_fanout_t *fanout = budget->fanout;
+
+    budget->running--;
+    budget->reserved -= slot->reserved[step_index];
+    slot->reserved[step_index] = 0;
+    if (result->usage.max_rss_bytes > fanout->step_rss[step_index]) {
+        fanout->step_rss[step_index] = result->usage.max_rss_bytes;
+    }
+}
+
+// Configuration of one input's executor: its own log next to the outputs
+static void file_config(const pipeline_fanout_t *fanout, const pipeline_fanout_file_t *file,
+                        pipeline_config_t *config) {
+    memcpy(config, &fanout->config, sizeof(pipeline_config_t));
+    if (fanout->config.node_count > 0) {
+        uint32_t index = (uint32_t)(file - fanout->files) % fanout->config.node_count;
+        snprintf(config->node, sizeof(config->node), "%s", fanout->config.nodes[index]);
+    }
+    config->log_file[0] = '\0';
+    if (fanout->config.log_file[0]) {
+        int written = snprintf(config->log_file, sizeof(config->log_file), "%s/%s.pipeline.log",
+                               fanout->config.working_dir, file->stem);
+        if (written < 0 || (size_t)written >= sizeof(config->log_file)) config->log_file[0] = '\0';
+    }
+}
+
+// Keep an input's results and count it
+static void finish_file(pipeline_fanout_t *fanout, pipeline_fanout_file_t *file,
+                        const pipeline_executor_t *executor, bool success, double start) {
+    file->finished = true;
+    file->success = success;
+    file->execution_time = monotonic_seconds() - start;
+    if (executor) {
+        file->results = (pipeline_step_result_t *)malloc(
+            executor->result_count * sizeof(pipeline_step_result_t));
+        if (file->results) {
+            memcpy(file->results, executor->results,
+                   executor->result_count * sizeof(pipeline_step_result_t));
+            file->result_count = executor->result_count;
+        }
+    }
+    if (success) fanout->completed_files++;
+    else fanout->failed_files++;
+
+    if (fanout->log_handle) {
+        fprintf((FILE *)fanout->log_handle, "[INPUT %s] %s (%.3fs)%s%s\n", file->input,
+                success ? "SUCCESS" : "FAILED", file->execution_time,
+                file->error_message[0] ? ": " : "", file->error_message);
+        fflush((FILE *)fanout->log_handle);
+    }
+}
+
+// Instantiate an input's pipeline and its executor; false (file finished
+// and failed) if it cannot start
+static bool open_slot(pipeline_fanout_t *fanout, uint32_t file_index, fanout_slot_t *slot) {
+    pipeline_fanout_file_t *file = &fanout->files[file_index];
+    file->started = true;
+    slot->file = file_index;
+    slot->executor = NULL;
+    slot->start = monotonic_seconds();
+    memset(slot->reserved, 0, sizeof(slot->reserved));
+
+    pipeline_config_t config;
+    file_config(fanout, file, &config);
+    if (instantiate_pipeline(fanout, file_index, &slot->document)) {
+        slot->executor = pipeline_executor_create(&config, &slot->document);
+        if (!slot->executor) strcpy(file->error_message, "Failed to create pipeline executor");
+    }
+    if (!slot->executor) {
+        if (!file->error_message[0]) strcpy(file->error_message, "Out of memory");
+        yaml_free_document(&slot->document);
+        finish_file(fanout, file, NULL, false, slot->start);
+        return false;
+    }
+    return true;
+}
+
+static void close_slot(pipeline_fanout_t *fanout, fanout_slot_t *slot, bool success) {
+    finish_file(fanout, &fanout->files[slot->file], slot->executor, success, slot->start);
+    pipeline_executor_destroy(slot->executor);
+    yaml_free_document(&slot->document);
+    slot->executor = NULL;
+}
+
+/**
+ * @brief Run the pipeline over every input (child processes)
+ */
+bool pipeline_fanout_execute(pipeline_fanout_t *fanout) {
+    if (!fanout) return false;
+
+    uint32_t slot_count = fanout->config.max_parallel_files < fanout->file_count
+                              ? fanout->config.max_parallel_files : fanout->file_count;
+    fanout_slot_t *slots = (fanout_slot_t *)calloc(slot_count, sizeof(fanout_slot_t));
+    if (!slots) return false;
+
+    fanout_budget_t budget;
+    memset(&budget, 0, sizeof(budget));
+    budget.fanout = fanout;
+
+    if (fanout->log_handle) {
+        time_t now = time(NULL);
+        fprintf((FILE *)fanout->log_handle, "[%s] Starting fan-out over %u inputs (%u at once)\n",
+                ctime(&now), fanout->file_count, slot_count);
+        fflush((FILE *)fanout->log_handle);
+    }
+
+    double start = monotonic_seconds();
+    uint32_t next_file = 0, active = 0;
+    bool admitting = true, success = true;
+    for (;;) {
+        // Admit inputs in order into free slots
+        for (uint32_t s = 0; s < slot_count && admitting && next_file < fanout->file_count; s++) {
+            if (slots[s].executor) continue;
+            slots[s].budget = &budget;
+            if (!open_slot(fanout, next_file++, &slots[s])) {
+                success = false;
+                if (!fanout->config.continue_on_error) admitting = false;
+                continue;
+            }
+            schedule_begin(slots[s].executor, &slots[s].schedule);
+            slots[s].executor->start_clock = start;  // Offsets from the job start
+            active++;
+            if (active > fanout->peak_files) fanout->peak_files = active;
+        }
+        if (active == 0) break;
+
+        uint32_t changed = 0;
+        for (uint32_t s = 0; s < slot_count; s++) {
+            if (!slots[s].executor) continue;
+            changed += schedule_start(slots[s].executor, &slots[s].schedule,
+                                      fanout_admit, fanout_release, &slots[s]);
+        }
+        for (uint32_t s = 0; s < slot_count; s++) {
+            if (!slots[s].executor) continue;
+            changed += schedule_collect(slots[s].executor, &slots[s].schedule,
+                                        fanout_release, &slots[s]);
+            if (!schedule_done(&slots[s].schedule)) continue;
+
+            schedule_end(slots[s].executor, &slots[s].schedule);
+            bool file_success = slots[s].schedule.overall_success;
+            close_slot(fanout, &slots[s], file_success);
+            active--;
+            changed++;
+            if (!file_success) {
+                success = false;
+                if (!fanout->config.continue_on_error) admitting = false;  // Stop on first error
+            }
+        }
+        if (changed == 0) sleep_ms(PIPELINE_POLL_MS);
+    }
+    free(slots);
+
+    // Inputs never admitted count as failed
+    for (uint32_t f = next_file; f < fanout->file_count; f++) {
+        strcpy(fanout->files[f].error_message, "Not run: an earlier input failed");
+        fanout->failed_files++;
+        success = false;
+    }
+    fanout->total_execution_time = monotonic_seconds() - start;
+
+    if (fanout->log_handle) {
+        time_t now = time(NULL);
+        fprintf((FILE *)fanout->log_handle, "[%s] Fan-out %s: %u of %u inputs succeeded\n",
+                ctime(&now), success ? "completed successfully" : "failed",
+                fanout->completed_files, fanout->file_count);
+        fflush((FILE *)fanout->log_handle);
+    }
+    return success;
+}
+
+/**
+ * @brief Run the pipeline over every input in process, one input at a time
+ */
+bool pipeline_fanout_execute_in_process(pipeline_fanout_t *fanout,
+                                        const pipeline_tool_t *tools, uint32_t tool_count) {
+    if (!fanout) return false;
+
+    double start = monotonic_seconds();
+    bool success = true;
+    uint32_t f = 0;
+    for (; f < fanout->file_count; f++) {
+        fanout_slot_t slot;
+        if (open_slot(fanout, f, &slot)) {
+            bool file_success = pipeline_execute_in_process(slot.executor, tools, tool_count);
+            close_slot(fanout, &slot, file_success);
+            fanout->peak_files = fanout->peak_running = 1;  // One step at a time
+            if (file_success) continue;
+        }
+        success = false;
+        if (!fanout->config.continue_on_error) {
+            f++;
+            break;
+        }
+    }
+    for (; f < fanout->file_count; f++) {
+        strcpy(fanout->files[f].error_message, "Not run: an earlier input failed");
+        fanout->failed_files++;
+    }
+    fanout->total_execution_time = monotonic_seconds() - start;
+    return success;
+}
+
+/**
+ * @brief Generate a fan-out summary
+ */
+bool pipeline_fanout_generate_summary(const pipeline_fanout_t *fanout,
+                                      char *summary_buffer, uint32_t buffer_size) {
+    if (!fanout || !summary_buffer || buffer_size == 0) {
+        return false;
+    }
+
+    uint32_t steps = 0, cached = 0;
+    double cpu = 0.0;
+    for (uint32_t f = 0; f < fanout->file_count; f++) {
+        for (uint32_t i = 0; i < fanout->files[f].result_count; i++) {
+            const pipeline_step_result_t *result = &fanout->files[f].results[i];
+            if (result->success) steps++;
+            if (result->cached) cached++;
+            cpu += result->usage.user_seconds + result->usage.system_seconds;
+        }
+    }
+
+    int written = snprintf(summary_buffer, buffer_size,
+                          "Pipeline Fan-out Summary\n"
+                          "========================\n"
+                          "Inputs: %u\n"
+                          "Completed: %u\n"
+                          "Failed: %u\n"
+                          "Steps Completed: %u (%u cached)\n"
+                          "Peak Inputs In Flight: %u\n"
+                          "Peak Running Steps: %u\n"
+                          "Peak Memory Reserved: %.1f MB\n"
+                          "Total Time: %.3f seconds\n"
+                          "Total CPU Time: %.3f seconds\n",
+                          fanout->file_count, fanout->completed_files, fanout->failed_files,
+                          steps, cached, fanout->peak_files, fanout->peak_running,
+                          fanout->peak_reserved_bytes / (1024.0 * 1024.0),
+                          fanout->total_execution_time, cpu);
+    if (written < 0 || (uint32_t)written >= buffer_size) {
+        return false;
+    }
+
+    for (uint32_t f = 0; f < fanout->file_count && (uint32_t)written < buffer_size - 100; f++) {
+        const pipeline_fanout_file_t *file = &fanout->files[f];
+        const char *status = !file->finished ? "NOT RUN" : file->success ? "SUCCESS" : "FAILED";
+        int line = snprintf(summary_buffer + written, buffer_size - written,
+                            "\nInput %u: %s\n  Status: %s\n  Time: %.3f seconds\n",
+                            f, file->input, status, file->execution_time);
+        if (line < 0) break;
+        written += line;
+        if (file->error_message[0] && (uint32_t)written < buffer_size - 50) {
+            line = snprintf(summary_buffer + written, buffer_size - written,
+                            "  Error: %s\n", file->error_message);
+            if (line > 0) written += line;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Save every input's step results to one CSV file
+ */
+bool pipeline_fanout_save_results(const pipeline_fanout_t *fanout, const char *filename) {
+    if (!fanout || !filename) {
+        return false;
+    }
+
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "# IQ Lab Pipeline Fan-out Results\n");
+    fprintf(file, "# Generated: %s", ctime(&(time_t){time(NULL)}));
+    fprintf(file, "# Inputs: %u\n", fanout->file_count);
+    fprintf(file, "# Completed: %u\n", fanout->completed_files);
+    fprintf(file, "# Failed: %u\n", fanout->failed_files);
+    fprintf(file, "# Total time: %.3f seconds\n", fanout->total_execution_time);
+    fprintf(file, "\n");
+
+    fprintf(file, "input,step_index,tool_name,success,cached,exit_code,execution_time,start_offset,"
+                  "user_seconds,system_seconds,max_rss_bytes,read_bytes,write_bytes,error_message\n");
+    for (uint32_t f = 0; f < fanout->file_count; f++) {
+        const pipeline_fanout_file_t *input = &fanout->files[f];
+        if (input->result_count == 0) {
+            fprintf(file, "\"%s\",,,false,false,,,,,,,,,\"%s\"\n", input->input, input->error_message);
+            continue;
+        }
+        for (uint32_t i = 0; i < input->result_count; i++) {
+            const pipeline_step_result_t *result = &input->results[i];
+            fprintf(file, "\"%s\",%u,%s,%s,%s,%d,%.3f,%.3f,%.3f,%.3f,%llu,%llu,%llu,\"%s\"\n",
+                    input->input,
+                    result->step_index,
+                    result->tool_name,
+                    result->success ? "true" : "false",
+                    result->cached ? "true" : "false",
+                    result->exit_code,
+                    result->execution_time,
+                    result->start_offset,
+                    result->usage.user_seconds,
+                    result->usage.system_seconds,
+                    (unsigned long long)result->usage.max_rss_bytes,
+                    (unsigned long long)result->usage.read_bytes,
+                    (unsigned long long)result->usage.write_bytes,
+                    result->error_message);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
@@ -8,7 +8,21 @@
  * Date: 2025
  *
  * Key Features:
- * - Sequential/parallel pipeline execution
+ * - Sequential/parallel pipeline execution: steps form a dependency graph
+ *   (a step waits for the earlier steps whose outputs it reads or writes,
+ *   and tools not known to be read-only order against every step), and
+ *   ready steps run as child processes, at most max_parallel_jobs at once
+ * - In-process execution: inputs decoded once and shared by the tool cores;
+ *   steps reading spectral rows of the same input and STFT geometry run
+ *   together on one FFT pass (spectral_bus.h)
+ * - Multi-input fan-out: a pipeline whose parameters use {input} or {stem}
+ *   is a template run once per input (globs expanded), several inputs at
+ *   once within a global step (CPU) and memory budget
+ * - Remote steps: a launcher template (e.g. ssh) runs each spawned tool on
+ *   a node, a fan-out's inputs spread over the nodes in turn
+ * - Step result cache: with cache_dir set, a step whose tool, parameters
+ *   and input contents match an earlier run has its outputs restored
+ *   instead of running (step_cache.h)
  * - Tool dependency management
  * - Error recovery and reporting
  * - Progress monitoring
@@ -24,11 +38,22 @@
 #include <stdio.h>
 #include <time.h>
 #include "yaml_parse.h"
+#include "step_cache.h"
+
+// Steps one bitmask of the dependency graph covers
+#define PIPELINE_MAX_STEPS 32
+
+// Nodes a fan-out spreads its inputs over
+#define PIPELINE_MAX_NODES 64
 
 // Forward declarations
+typedef struct pipeline_tool_t pipeline_tool_t;
 typedef struct pipeline_executor_t pipeline_executor_t;
 typedef struct pipeline_step_result_t pipeline_step_result_t;
 typedef struct pipeline_config_t pipeline_config_t;
+typedef struct pipeline_step_usage_t pipeline_step_usage_t;
+typedef struct pipeline_fanout_t pipeline_fanout_t;
+typedef struct pipeline_fanout_file_t pipeline_fanout_file_t;
 
 /**
  * @brief Pipeline Execution Configuration
@@ -40,6 +65,42 @@ struct pipeline_config_t {
     bool continue_on_error;         // Continue execution on step failures
     char log_file[256];             // Log file path
     char working_dir[256];          // Working directory for execution
+    char tool_dir[256];             // Directory holding the tool executables
+    char cache_dir[256];            // Step result cache ("" disables caching)
+
+    // Fan-out runs (pipeline_fanout_execute): max_parallel_jobs bounds the
+    // steps running over all inputs together
+    uint32_t max_parallel_files;    // Inputs processed at once
+    uint64_t memory_budget_bytes;   // Estimated peak RSS of running steps (0: no limit)
+
+    // Remote execution: with a launcher, each spawned step runs as
+    // /bin/sh -c <launcher> with {command} the tool's command line, {node}
+    // the node and {cwd} this process's working directory, all quoted for
+    // the shell that runs the command. A placeholder may stand bare or in
+    // one pair of single quotes (escaped once more for the local shell),
+    // e.g. "ssh {node} 'cd {cwd} && {command}'" on a shared file system.
+    // A fan-out runs input f on nodes[f % node_count].
+    char launcher[512];             // Command template ("" runs tools directly)
+    char node[64];                  // Node the executor's steps run on
+    char nodes[PIPELINE_MAX_NODES][64];
+    uint32_t node_count;
+};
+
+/**
+ * @brief Resources a step used
+ *
+ * For a spawned step these are the child's own figures (wait4 rusage, or
+ * GetProcessTimes / process memory and I/O counters on Windows). Steps run
+ * in process report the executor's growth over the step, so fused steps
+ * running together each see the whole group's use; max_rss_bytes is then
+ * the executor's peak so far.
+ */
+struct pipeline_step_usage_t {
+    double user_seconds;            // User-mode CPU time
+    double system_seconds;          // Kernel-mode CPU time
+    uint64_t max_rss_bytes;         // Peak resident set size
+    uint64_t read_bytes;            // Bytes read by block I/O (all reads on Windows)
+    uint64_t write_bytes;           // Bytes written by block I/O (all writes on Windows)
 };
 
 /**
@@ -49,12 +110,26 @@ struct pipeline_step_result_t {
     uint32_t step_index;            // Index of executed step
     char tool_name[64];             // Tool that was executed
     int exit_code;                  // Tool exit code (0 = success)
-    double execution_time;          // Time taken to execute (seconds)
+    double execution_time;          // Wall-clock run time, monotonic (seconds)
+    double start_offset;            // Monotonic start, seconds after the pipeline began
+    pipeline_step_usage_t usage;    // CPU, memory and I/O of the step
     time_t start_time;              // Start timestamp
     time_t end_time;                // End timestamp
     char output_files[512];         // Comma-separated list of output files
     char error_message[256];        // Error message if any
     bool success;                   // Overall success flag
+    bool cached;                    // Outputs restored from the step cache
+    char cache_key[STEP_CACHE_KEY_SIZE]; // Step cache key ("" without a cache)
+};
+
+/**
+ * @brief Tool that can run inside the executor's process
+ */
+struct pipeline_tool_t {
+    const char *name;                   // Tool name as written in the pipeline
+    int (*entry)(int argc, char **argv); // Tool core (see tools.h)
+    uint32_t spectral_rows;             // Bus row formats the core reads when
+                                        // bound (SPECTRAL_BUS_F32/F64), 0 if none
 };
 
 /**
@@ -73,15 +148,80 @@ struct pipeline_executor_t {
     bool running;                   // Currently executing
     uint32_t current_step;          // Current step being executed
     double total_execution_time;    // Total time spent executing
+    double total_cpu_time;          // User + system CPU time of all steps
+    double start_clock;             // Monotonic time the execution began
 
     // Progress tracking
     uint32_t completed_steps;       // Number of completed steps
-    uint32_t failed_steps;          // Number of failed steps
+    uint32_t failed_steps;          // Number of failed (or skipped) steps
+    uint32_t peak_running;          // Most steps running at once
+    uint32_t cached_steps;          // Completed steps restored from the cache
+
+    // Dependency graph, one bit per earlier step (documents hold at most
+    // PIPELINE_MAX_STEPS steps)
+    uint32_t *waits_for;            // Steps that must finish first
+    uint32_t *needs;                // Of those, steps that must succeed (outputs read)
+
+    // Step cache (NULL unless config.cache_dir is set)
+    step_cache_t *cache;
 
     // Logging
     void *log_handle;               // Log file handle
 };
 
+/**
+ * @brief One input of a fan-out run
+ */
+struct pipeline_fanout_file_t {
+    const char *input;                  // Input file (the document's)
+    char stem[128];                     // File name without directory or extension
+    bool started;                       // Its pipeline was instantiated and admitted
+    bool finished;                      // Its pipeline has ended
+    bool success;                       // Every step succeeded
+    pipeline_step_result_t *results;    // Step results once finished (NULL before)
+    uint32_t result_count;
+    double execution_time;              // Admission to finish (seconds)
+    char error_message[256];            // Why the pipeline could not start, if so
+};
+
+/**
+ * @brief Multi-input fan-out run
+ *
+ * The document's steps are a template instantiated once per input: in
+ * every parameter value and output_dir, {input} becomes the input path,
+ * {stem} its file name without directory or extension, and {out_dir} the
+ * working directory. Each input's pipeline keeps its own dependency graph;
+ * up to max_parallel_files inputs are in flight, the earliest first, and
+ * all their ready steps share max_parallel_jobs process slots.
+ *
+ * Memory budget: a step reserves the largest peak RSS measured for the same
+ * step on earlier inputs. A step is deferred while its reservation would
+ * take the running steps over memory_budget_bytes, or while it has not been
+ * measured yet, unless nothing else is running (so the first instance of a
+ * step, or one larger than the budget, still runs, alone).
+ */
+struct pipeline_fanout_t {
+    pipeline_config_t config;           // Execution configuration
+    const yaml_document_t *document;    // Template pipeline and its inputs
+
+    pipeline_fanout_file_t *files;      // One per input, in document order
+    uint32_t file_count;
+
+    // Progress
+    uint32_t completed_files;           // Inputs whose every step succeeded
+    uint32_t failed_files;              // Inputs with a failed step, or not started
+    uint32_t peak_files;                // Most inputs in flight at once
+    uint32_t peak_running;              // Most steps running at once over all inputs
+    uint64_t peak_reserved_bytes;       // Largest memory reservation held at once
+    double total_execution_time;        // Wall time of the whole run
+
+    // Largest peak RSS measured per step index (0: not yet measured)
+    uint64_t step_rss[PIPELINE_MAX_STEPS];
+
+    // Logging
+    void *log_handle;                   // Log file handle
+};
+
 /**
  * @brief Initialize pipeline configuration with defaults
  *
@@ -123,6 +263,29 @@ void pipeline_executor_destroy(pipeline_executor_t *executor);
  */
 bool pipeline_execute(pipeline_executor_t *executor);
 
+/**
+ * @brief Execute pipeline in process over shared decoded inputs
+ *
+ * Decodes every document input once into a published iq_source_t, then
+ * runs the steps one at a time in pipeline order: tools listed in 'tools'
+ * are called directly and stream the decoded samples, any other tool runs
+ * as a child process (timeout_seconds applies to those only). Steps fed
+ * by a failed step are skipped as in pipeline_execute.
+ *
+ * Fusion: when a step's tool reads spectral rows and later steps with such
+ * tools name the same "in", "fft", "hop" and "window" (none: rectangular)
+ * and wait only for steps already done, they all run at once, each on its
+ * own thread, subscribed to one spectral_bus_t that computes every frame's
+ * FFT once. Outputs match the unfused run.
+ *
+ * @param executor Pointer to executor instance
+ * @param tools Tools callable in process
+ * @param tool_count Number of entries in tools
+ * @return true if all steps executed successfully, false on error
+ */
+bool pipeline_execute_in_process(pipeline_executor_t *executor,
+                                 const pipeline_tool_t *tools, uint32_t tool_count);
+
 /**
  * @brief Execute single pipeline step
  *
@@ -137,6 +300,9 @@ bool pipeline_execute_step(pipeline_executor_t *executor, uint32_t step_index,
 /**
  * @brief Build command line for pipeline step
  *
+ * Each parameter becomes "--key value"; a parameter whose value is "true"
+ * is a bare flag ("--pyramid").
+ *
  * @param executor Pointer to executor instance
  * @param step_index Index of step to build command for
  * @param command_buffer Buffer to store command string
@@ -146,6 +312,19 @@ bool pipeline_execute_step(pipeline_executor_t *executor, uint32_t step_index,
 bool pipeline_build_command(const pipeline_executor_t *executor, uint32_t step_index,
                            char *command_buffer, uint32_t buffer_size);
 
+/**
+ * @brief Check whether a step waits for an earlier one
+ *
+ * @param executor Pointer to executor instance
+ * @param step_index Index of the later step
+ * @param earlier_index Index of the earlier step
+ * @param must_succeed Receives whether the earlier step must also succeed
+ *                     (the later one reads its outputs); may be NULL
+ * @return true if step_index starts only after earlier_index finished
+ */
+bool pipeline_step_depends_on(const pipeline_executor_t *executor, uint32_t step_index,
+                              uint32_t earlier_index, bool *must_succeed);
+
 /**
  * @brief Check if pipeline step can be executed in parallel
  *
@@ -225,4 +404,95 @@ bool pipeline_is_complete(const pipeline_executor_t *executor);
  */
 bool pipeline_reset(pipeline_executor_t *executor);
 
+/**
+ * @brief Expand a template string for one input
+ *
+ * {input} becomes 'input', {stem} its file name without directory or
+ * extension and {out_dir} 'out_dir', as in a fan-out's steps.
+ *
+ * @param text Template (a step parameter or output_dir)
+ * @param input Input path
+ * @param out_dir Working directory
+ * @param buffer Output buffer
+ * @param size Size of buffer
+ * @return true if the expansion fit
+ */
+bool pipeline_expand_text(const char *text, const char *input, const char *out_dir,
+                          char *buffer, size_t size);
+
+/**
+ * @brief Check whether a document's pipeline is a per-input template
+ *
+ * @param document YAML document
+ * @return true if a step parameter or output_dir uses {input} or {stem}
+ */
+bool pipeline_document_is_template(const yaml_document_t *document);
+
+/**
+ * @brief Create a fan-out run over every input of a document
+ *
+ * With several inputs, stems must differ and every "out" parameter and
+ * output_dir must use {input} or {stem}, or inputs would overwrite each
+ * other's outputs.
+ *
+ * @param config Pointer to validated configuration
+ * @param document Document with glob patterns already expanded
+ * @return Fan-out run, NULL on error (reported on stderr)
+ */
+pipeline_fanout_t *pipeline_fanout_create(const pipeline_config_t *config,
+                                          const yaml_document_t *document);
+
+/**
+ * @brief Destroy a fan-out run
+ *
+ * @param fanout Fan-out run
+ */
+void pipeline_fanout_destroy(pipeline_fanout_t *fanout);
+
+/**
+ * @brief Run the pipeline over every input (child processes)
+ *
+ * Without continue_on_error, no further input is admitted once one fails;
+ * inputs in flight still finish.
+ *
+ * @param fanout Fan-out run
+ * @return true if every step of every input succeeded
+ */
+bool pipeline_fanout_execute(pipeline_fanout_t *fanout);
+
+/**
+ * @brief Run the pipeline over every input in process, one input at a time
+ *
+ * Each input runs as pipeline_execute_in_process (decoded once, fused
+ * spectral steps); the tool cores cannot run concurrently, so neither
+ * max_parallel_files nor the memory budget applies.
+ *
+ * @param fanout Fan-out run
+ * @param tools Tools callable in process
+ * @param tool_count Number of entries in tools
+ * @return true if every step of every input succeeded
+ */
+bool pipeline_fanout_execute_in_process(pipeline_fanout_t *fanout,
+                                        const pipeline_tool_t *tools, uint32_t tool_count);
+
+/**
+ * @brief Generate a fan-out summary: totals, then one line per input
+ *
+ * @param fanout Fan-out run
+ * @param summary_buffer Buffer to store summary text
+ * @param buffer_size Size of summary buffer
+ * @return true on success, false on error
+ */
+bool pipeline_fanout_generate_summary(const pipeline_fanout_t *fanout,
+                                      char *summary_buffer, uint32_t buffer_size);
+
+/**
+ * @brief Save every input's step results to one CSV file
+ *
+ * @param fanout Fan-out run
+ * @param filename Output filename
+ * @return true on success, false on error
+ */
+bool pipeline_fanout_save_results(const pipeline_fanout_t *fanout, const char *filename);
+
 #endif /* PIPELINE_H */
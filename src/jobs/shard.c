@@ -0,0 +1,681 @@
+/*
+ * IQ Lab - shard.c: Time-Sharded Pipeline Runs
+ *
+ * Purpose: Shard geometry from the pipeline's steps, shard files cut from
+ * the capture, and the merge of the shards' event logs and tile pyramids
+ * (see shard.h).
+ *
+ */
+
+#include "shard.h"
+#include "pipeline.h"
+#include "../iq_core/io_sigmf.h"
+#include "../viz/tile_pyramid.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// iqdetect's STFT and cluster gap when a step does not set them
+#define SHARD_DETECT_FFT 4096
+#define SHARD_DETECT_HOP 1024
+#define SHARD_DETECT_GAP_MS 50.0
+
+// Longest event log line
+#define SHARD_LINE_MAX 4096
+
+static bool parse_count(const char *text, uint64_t *value) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if (end == text || *end || errno || parsed == 0) return false;
+    *value = parsed;
+    return true;
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/*
+ * Margin and hop grid for a pipeline
+ */
+bool shard_geometry(const yaml_document_t *document, uint32_t sample_rate,
+                    uint64_t *margin, uint64_t *grid) {
+    if (!document || !margin || !grid) return false;
+
+    uint64_t largest_fft = 0, lcm = 1, gap = 0;
+    for (uint32_t i = 0; i < document->pipeline_count; i++) {
+        const yaml_pipeline_step_t *step = &document->pipeline[i];
+        bool detect = strcmp(step->tool_name, "iqdetect") == 0;
+        const char *fft_text = yaml_get_step_param(step, "fft");
+        const char *hop_text = yaml_get_step_param(step, "hop");
+        uint64_t fft = detect ? SHARD_DETECT_FFT : 0, hop = detect ? SHARD_DETECT_HOP : 0;
+        if ((fft_text && !parse_count(fft_text, &fft)) || (hop_text && !parse_count(hop_text, &hop))) {
+            fprintf(stderr, "Step %u (%s): fft and hop must be sample counts\n", i, step->tool_name);
+            return false;
+        }
+        if (fft > largest_fft) largest_fft = fft;
+        if (hop > 0) lcm = lcm / gcd(lcm, hop) * hop;
+
+        if (detect) {
+            const char *gap_text = yaml_get_step_param(step, "max-time-gap");
+            double gap_ms = SHARD_DETECT_GAP_MS;
+            if (gap_text) {
+                char *end = NULL;
+                gap_ms = strtod(gap_text, &end);
+                if (end == gap_text || *end || gap_ms < 0.0) {
+                    fprintf(stderr, "Step %u (%s): bad max-time-gap '%s'\n", i, step->tool_name, gap_text);
+                    return false;
+                }
+            }
+            uint64_t samples = (uint64_t)ceil(gap_ms * 1e-3 * sample_rate);
+            if (samples > gap) gap = samples;
+        }
+    }
+
+    uint64_t need = 2 * largest_fft;
+    if (need < SHARD_MIN_MARGIN) need = SHARD_MIN_MARGIN;
+    need += gap;
+    *grid = lcm;
+    *margin = (need + lcm - 1) / lcm * lcm;
+    return true;
+}
+
+// Open the capture the way the tools do: the SigMF datatype if there is
+// metadata, else detection from the name and contents
+static bool open_capture(const shard_plan_t *plan, const sigmf_metadata_t *meta,
+                         iq_reader_t *reader, iq_format_t *format) {
+    if (!meta) {
+        if (!iq_reader_open(reader, plan->input)) return false;
+        *format = reader->format;
+        return true;
+    }
+    switch (sigmf_parse_datatype(meta->global.datatype)) {
+        case SIGMF_DATATYPE_CI8:  *format = IQ_FORMAT_S8;  break;
+        case SIGMF_DATATYPE_CI16: *format = IQ_FORMAT_S16; break;
+        case SIGMF_DATATYPE_CI12: *format = IQ_FORMAT_S12; break;
+        case SIGMF_DATATYPE_CI4:  *format = IQ_FORMAT_S4;  break;
+        default:
+            fprintf(stderr, "Unsupported SigMF datatype '%s' (ci8/ci16/ci12/ci4 only)\n",
+                    meta->global.datatype);
+            return false;
+    }
+    return iq_reader_init(reader, plan->input, *format);
+}
+
+static const char *format_datatype(iq_format_t format) {
+    switch (format) {
+        case IQ_FORMAT_S8:  return sigmf_datatype_to_string(SIGMF_DATATYPE_CI8);
+        case IQ_FORMAT_S12: return sigmf_datatype_to_string(SIGMF_DATATYPE_CI12);
+        case IQ_FORMAT_S4:  return sigmf_datatype_to_string(SIGMF_DATATYPE_CI4);
+        default:            return sigmf_datatype_to_string(SIGMF_DATATYPE_CI16);
+    }
+}
+
+/*
+ * Plan the shards of the document's single input
+ */
+bool shard_plan_init(shard_plan_t *plan, const yaml_document_t *document,
+                     double shard_seconds, const char *dir) {
+    if (!plan) return false;
+    memset(plan, 0, sizeof(*plan));
+    if (!document || document->input_count != 1 || !dir || !(shard_seconds > 0.0)) {
+        fprintf(stderr, "Sharding needs exactly one input and a positive shard length\n");
+        return false;
+    }
+
+    const yaml_input_t *input = &document->inputs[0];
+    snprintf(plan->input, sizeof(plan->input), "%s", input->file);
+    snprintf(plan->dir, sizeof(plan->dir), "%s", dir);
+    if (input->meta[0]) {
+        snprintf(plan->meta, sizeof(plan->meta), "%s", input->meta);
+    } else if (sigmf_meta_file_exists(input->file)) {
+        sigmf_get_meta_filename(input->file, plan->meta, sizeof(plan->meta));
+    }
+
+    sigmf_metadata_t meta = {0};
+    if (plan->meta[0] && !sigmf_read_metadata(plan->meta, &meta)) {
+        fprintf(stderr, "Failed to read %s\n", plan->meta);
+        return false;
+    }
+    iq_reader_t reader;
+    if (!open_capture(plan, plan->meta[0] ? &meta : NULL, &reader, &plan->format)) {
+        fprintf(stderr, "Failed to open %s\n", plan->input);
+        sigmf_free_metadata(&meta);
+        return false;
+    }
+    plan->total_samples = reader.total_samples;
+
+    // The rate the tools are given wins over the file's own
+    uint64_t rate = 0;
+    for (uint32_t i = 0; i < document->pipeline_count && rate == 0; i++) {
+        const char *text = yaml_get_step_param(&document->pipeline[i], "rate");
+        if (text && !parse_count(text, &rate)) rate = 0;
+    }
+    if (rate == 0) rate = input->sample_rate;
+    if (rate == 0) rate = reader.sample_rate;
+    if (rate == 0) rate = meta.global.sample_rate;
+    plan->sample_rate = (uint32_t)rate;
+    iq_reader_close(&reader);
+    sigmf_free_metadata(&meta);
+
+    if (plan->total_samples == 0 || plan->sample_rate == 0) {
+        fprintf(stderr, "Sharding needs a file of known length and sample rate: %s\n", plan->input);
+        return false;
+    }
+    if (!shard_geometry(document, plan->sample_rate, &plan->margin, &plan->grid)) return false;
+
+    uint64_t shard = (uint64_t)llround(shard_seconds * plan->sample_rate);
+    plan->shard_samples = (shard + plan->grid - 1) / plan->grid * plan->grid;
+    if (plan->shard_samples == 0) plan->shard_samples = plan->grid;
+    uint64_t count = (plan->total_samples + plan->shard_samples - 1) / plan->shard_samples;
+    if (count > SHARD_MAX_SHARDS) {
+        fprintf(stderr, "%llu shards of %.3f s exceed the limit of %d\n", (unsigned long long)count,
+                (double)plan->shard_samples / plan->sample_rate, SHARD_MAX_SHARDS);
+        return false;
+    }
+
+    char stem[256];
+    if (!pipeline_expand_text("{stem}", plan->input, "", stem, sizeof(stem))) return false;
+    plan->shards = (shard_t *)calloc((size_t)count, sizeof(shard_t));
+    if (!plan->shards) return false;
+    plan->count = (uint32_t)count;
+    for (uint32_t k = 0; k < plan->count; k++) {
+        shard_t *s = &plan->shards[k];
+        s->core_start = (uint64_t)k * plan->shard_samples;
+        s->core_end = s->core_start + plan->shard_samples;
+        if (s->core_end > plan->total_samples) s->core_end = plan->total_samples;
+        s->read_start = s->core_start > plan->margin ? s->core_start - plan->margin : 0;
+        s->read_end = s->core_end + plan->margin;
+        if (s->read_end > plan->total_samples) s->read_end = plan->total_samples;
+        int written = snprintf(s->path, sizeof(s->path), "%s/%s_shard%03u.%s", plan->dir, stem, k,
+                               iq_format_name(plan->format));
+        if (written < 0 || (size_t)written >= sizeof(s->path)) {
+            fprintf(stderr, "Shard path too long in %s\n", plan->dir);
+            shard_plan_free(plan);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ISO 8601 UTC with microseconds
+static void format_datetime(double seconds, char *text, size_t size) {
+    double whole = floor(seconds);
+    long micros = lround((seconds - whole) * 1e6);
+    if (micros >= 1000000) {
+        whole += 1.0;
+        micros -= 1000000;
+    }
+    time_t t = (time_t)whole;
+    size_t length = strftime(text, size, "%Y-%m-%dT%H:%M:%S", gmtime(&t));
+    snprintf(text + length, size - length, ".%06ldZ", micros);
+}
+
+// Metadata next to a shard file: sample 0 is at the capture's start plus the offset
+static bool write_shard_meta(const shard_plan_t *plan, const shard_t *shard,
+                             bool timed, double start_time, uint64_t frequency) {
+    char meta_path[512];
+    sigmf_get_meta_filename(shard->path, meta_path, sizeof(meta_path));
+
+    char datetime[64];
+    if (timed) format_datetime(start_time + (double)shard->read_start / plan->sample_rate, datetime, sizeof(datetime));
+
+    sigmf_metadata_t meta = {0};
+    bool ok = sigmf_create_basic_metadata(&meta, format_datatype(plan->format), plan->sample_rate, frequency,
+                                          "iqjob shard", "iq_lab") &&
+              sigmf_add_capture(&meta, 0, frequency, timed ? datetime : NULL) &&
+              sigmf_write_metadata(meta_path, &meta);
+    sigmf_free_metadata(&meta);
+    return ok;
+}
+
+/*
+ * Write the shard files, their metadata and the manifest
+ */
+bool shard_plan_write(shard_plan_t *plan) {
+    if (!plan || !plan->shards) return false;
+
+#ifdef _WIN32
+    if (mkdir(plan->dir) != 0 && errno != EEXIST) {
+#else
+    if (mkdir(plan->dir, 0755) != 0 && errno != EEXIST) {
+#endif
+        fprintf(stderr, "Failed to create %s: %s\n", plan->dir, strerror(errno));
+        return false;
+    }
+
+    sigmf_metadata_t meta = {0};
+    if (plan->meta[0] && !sigmf_read_metadata(plan->meta, &meta)) {
+        fprintf(stderr, "Failed to read %s\n", plan->meta);
+        return false;
+    }
+    meta.global.sample_rate = plan->sample_rate;
+    double start_time = 0.0;
+    bool timed = plan->meta[0] && sigmf_start_time(&meta, &start_time);
+    uint64_t frequency = meta.num_captures > 0 ? meta.captures[0].frequency : meta.global.frequency;
+
+    iq_reader_t reader;
+    iq_format_t format;
+    if (!open_capture(plan, plan->meta[0] ? &meta : NULL, &reader, &format)) {
+        sigmf_free_metadata(&meta);
+        return false;
+    }
+    sigmf_free_metadata(&meta);
+
+    char manifest_path[600];
+    snprintf(manifest_path, sizeof(manifest_path), "%s/shards.csv", plan->dir);
+    FILE *manifest = fopen(manifest_path, "w");
+    size_t sample_bytes = iq_native_sample_bytes(format);
+    void *buffer = malloc(SHARD_COPY_SAMPLES * sample_bytes);
+    bool ok = manifest && buffer;
+    if (ok) fprintf(manifest, "shard,path,read_start,read_end,core_start,core_end\n");
+
+    for (uint32_t k = 0; ok && k < plan->count; k++) {
+        const shard_t *s = &plan->shards[k];
+        FILE *out = NULL;
+        ok = iq_reader_seek_sample(&reader, s->read_start) && (out = fopen(s->path, "wb")) != NULL;
+        for (uint64_t left = s->read_end - s->read_start; ok && left > 0;) {
+            size_t want = left < SHARD_COPY_SAMPLES ? (size_t)left : SHARD_COPY_SAMPLES;
+            size_t got = iq_read_native(&reader, buffer, want);
+            ok = got > 0 && fwrite(buffer, sample_bytes, got, out) == got;
+            left -= got;
+        }
+        if (out && fclose(out) != 0) ok = false;
+        if (!ok) {
+            fprintf(stderr, "Failed to write shard %s\n", s->path);
+            break;
+        }
+        ok = write_shard_meta(plan, s, timed, start_time, frequency);
+        fprintf(manifest, "%u,%s,%llu,%llu,%llu,%llu\n", k, s->path, (unsigned long long)s->read_start,
+                (unsigned long long)s->read_end, (unsigned long long)s->core_start,
+                (unsigned long long)s->core_end);
+    }
+
+    if (manifest && fclose(manifest) != 0) ok = false;
+    free(buffer);
+    iq_reader_close(&reader);
+    return ok;
+}
+
+/*
+ * The document to run over the shard files
+ */
+bool shard_plan_document(const shard_plan_t *plan, const yaml_document_t *document,
+                         yaml_document_t *shards) {
+    if (!shards) return false;
+    memset(shards, 0, sizeof(*shards));
+    if (!plan || !document || document->input_count != 1) return false;
+    shards->report = document->report;
+
+    for (uint32_t k = 0; k < plan->count; k++) {
+        char meta_path[512];
+        sigmf_get_meta_filename(plan->shards[k].path, meta_path, sizeof(meta_path));
+        yaml_input_t *input = yaml_add_input(shards);
+        if (!input) goto fail;
+        *input = document->inputs[0];
+        input->file = yaml_copy_string(shards, plan->shards[k].path);
+        input->meta = yaml_copy_string(shards, meta_path);
+        input->sample_rate = plan->sample_rate;
+        if (!input->file || !input->meta) goto fail;
+    }
+
+    char rate[32];
+    snprintf(rate, sizeof(rate), "%u", plan->sample_rate);
+    for (uint32_t i = 0; i < document->pipeline_count; i++) {
+        const yaml_pipeline_step_t *source = &document->pipeline[i];
+        yaml_pipeline_step_t *step = yaml_add_step(shards);
+        if (!step) goto fail;
+        step->tool_name = source->tool_name;
+        step->output_dir = source->output_dir;
+        bool reads_input = false;
+        for (uint32_t p = 0; p < source->param_count; p++) {
+            if (strstr(source->params[p].value, "{input}")) reads_input = true;
+            if (!yaml_set_step_param(shards, step, source->params[p].key, source->params[p].value)) goto fail;
+        }
+        if (reads_input && !yaml_get_step_param(source, "rate") &&
+            !yaml_set_step_param(shards, step, "rate", rate)) {
+            goto fail;
+        }
+    }
+    return true;
+
+fail:
+    fprintf(stderr, "Out of memory building the shard pipeline\n");
+    yaml_free_document(shards);
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// Event logs
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    double t_start;          // Capture timeline (s)
+    double t_end;
+    double f_center;         // Hz
+    double bw;
+} shard_event_t;
+
+typedef struct {
+    shard_event_t *events;
+    size_t count;
+    size_t capacity;
+} shard_event_list_t;
+
+// One CSV event: times, band, and the text after the two times
+static bool parse_event(const char *line, double offset, shard_event_t *event, const char **rest) {
+    char *end = NULL;
+    event->t_start = strtod(line, &end) + offset;
+    if (end == line || *end != ',') return false;
+    const char *field = end + 1;
+    event->t_end = strtod(field, &end) + offset;
+    if (end == field || *end != ',') return false;
+    *rest = end + 1;
+    event->f_center = strtod(*rest, &end);
+    if (end == *rest || *end != ',') return false;
+    field = end + 1;
+    event->bw = strtod(field, &end);
+    return end != field;
+}
+
+static bool list_push(shard_event_list_t *list, const shard_event_t *event) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? 2 * list->capacity : 16;
+        shard_event_t *grown = (shard_event_t *)realloc(list->events, capacity * sizeof(shard_event_t));
+        if (!grown) return false;
+        list->events = grown;
+        list->capacity = capacity;
+    }
+    list->events[list->count++] = *event;
+    return true;
+}
+
+// Capture sample an event starts at
+static uint64_t event_sample(const shard_plan_t *plan, const shard_event_t *event) {
+    double sample = event->t_start * plan->sample_rate;
+    return sample > 0.0 ? (uint64_t)llround(sample) : 0;
+}
+
+static bool bands_overlap(const shard_event_t *a, const shard_event_t *b) {
+    return fabs(a->f_center - b->f_center) <= 0.5 * (a->bw + b->bw);
+}
+
+/*
+ * Merge iqdetect CSV event logs
+ */
+bool shard_merge_events(const shard_plan_t *plan, const char *const *paths, const char *merged) {
+    if (!plan || !paths || !merged) return false;
+
+    // Pass 1: the events each shard sees before its core, which belong to
+    // an earlier shard and may extend one of its events (a shard with no
+    // events has no log)
+    shard_event_list_t *leading = (shard_event_list_t *)calloc(plan->count, sizeof(shard_event_list_t));
+    char *line = (char *)malloc(SHARD_LINE_MAX);
+    char header[SHARD_LINE_MAX] = "";
+    bool ok = leading && line;
+    for (uint32_t k = 0; ok && k < plan->count; k++) {
+        FILE *file = fopen(paths[k], "r");
+        if (!file) continue;
+        double offset = (double)plan->shards[k].read_start / plan->sample_rate;
+        bool first = true;
+        while (ok && fgets(line, SHARD_LINE_MAX, file)) {
+            if (first && !header[0]) snprintf(header, sizeof(header), "%s", line);
+            if (first) {
+                first = false;
+                continue;
+            }
+            shard_event_t event;
+            const char *rest;
+            if (!parse_event(line, offset, &event, &rest)) continue;
+            if (event_sample(plan, &event) < plan->shards[k].core_start) ok = list_push(&leading[k], &event);
+        }
+        fclose(file);
+    }
+
+    // Pass 2: each shard's own events on the capture's timeline, in shard order
+    FILE *out = NULL;
+    if (ok && header[0]) {
+        out = fopen(merged, "w");
+        ok = out && fputs(header, out) >= 0;
+    }
+    const double tolerance = (double)plan->grid / plan->sample_rate;
+    uint64_t kept = 0, extended = 0;
+    for (uint32_t k = 0; ok && out && k < plan->count; k++) {
+        FILE *file = fopen(paths[k], "r");
+        if (!file) continue;
+        const shard_t *shard = &plan->shards[k];
+        double offset = (double)shard->read_start / plan->sample_rate;
+        bool first = true;
+        while (ok && fgets(line, SHARD_LINE_MAX, file)) {
+            if (first) {
+                first = false;
+                continue;
+            }
+            shard_event_t event;
+            const char *rest;
+            if (!parse_event(line, offset, &event, &rest)) continue;
+            uint64_t start = event_sample(plan, &event);
+            if (start < shard->core_start || start >= shard->core_end) continue;
+
+            // Later shards' views of the same burst carry it past this file's end
+            double t_end = event.t_end;
+            for (uint32_t j = k + 1; j < plan->count; j++) {
+                if (event.t_end * plan->sample_rate < (double)plan->shards[j].read_start) break;
+                for (size_t e = 0; e < leading[j].count; e++) {
+                    const shard_event_t *later = &leading[j].events[e];
+                    if (bands_overlap(&event, later) && later->t_start <= event.t_end + tolerance &&
+                        later->t_end > event.t_end) {
+                        event.t_end = later->t_end;
+                    }
+                }
+            }
+            if (event.t_end > t_end) extended++;
+
+            size_t length = strlen(rest);
+            ok = fprintf(out, "%.6f,%.6f,%s%s", event.t_start, event.t_end, rest,
+                         length > 0 && rest[length - 1] == '\n' ? "" : "\n") > 0;
+            kept++;
+        }
+        fclose(file);
+    }
+    if (out && fclose(out) != 0) ok = false;
+
+    if (ok) {
+        printf("  Merged %llu events into %s (%llu extended across shard boundaries)\n",
+               (unsigned long long)kept, merged, (unsigned long long)extended);
+    } else {
+        fprintf(stderr, "Failed to merge event logs into %s\n", merged);
+    }
+    for (uint32_t k = 0; leading && k < plan->count; k++) free(leading[k].events);
+    free(leading);
+    free(line);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Tile pyramids
+// ---------------------------------------------------------------------------
+
+/*
+ * Merge iqls tile pyramids
+ */
+bool shard_merge_pyramids(const shard_plan_t *plan, const char *const *paths, const char *merged) {
+    if (!plan || !paths || !merged || plan->count == 0) return false;
+
+    // Pass 1: geometry, and the level-0 rows of the frames each core owns
+    uint64_t *first = (uint64_t *)calloc(plan->count, sizeof(uint64_t));
+    uint64_t *last = (uint64_t *)calloc(plan->count, sizeof(uint64_t));
+    tile_pyramid_info_t info = {0};
+    uint64_t total_rows = 0;
+    bool ok = first && last;
+    for (uint32_t k = 0; ok && k < plan->count; k++) {
+        tile_pyramid_reader_t reader;
+        if (!tile_pyramid_reader_open(&reader, paths[k])) {
+            fprintf(stderr, "Failed to open %s\n", paths[k]);
+            ok = false;
+            break;
+        }
+        uint64_t hop = (uint64_t)llround(reader.info.row_seconds * reader.info.sample_rate);
+        if (k == 0) info = reader.info;
+        if (hop == 0 || reader.info.width != info.width || reader.info.tile_size != info.tile_size) {
+            fprintf(stderr, "%s does not match the other shards' pyramids\n", paths[k]);
+            ok = false;
+        } else {
+            const shard_t *shard = &plan->shards[k];
+            first[k] = (shard->core_start - shard->read_start + hop - 1) / hop;
+            last[k] = (shard->core_end - shard->read_start + hop - 1) / hop;
+            if (last[k] > reader.info.num_rows) last[k] = reader.info.num_rows;
+            if (first[k] > last[k]) first[k] = last[k];
+            total_rows += last[k] - first[k];
+        }
+        tile_pyramid_reader_close(&reader);
+    }
+    if (ok && total_rows == 0) {
+        fprintf(stderr, "No pyramid rows to merge into %s\n", merged);
+        ok = false;
+    }
+
+    // Pass 2: those rows, in shard order, into one pyramid
+    tile_pyramid_writer_t writer;
+    bool writing = false;
+    const uint32_t tile = info.tile_size, width = info.width;
+    float *band = ok ? (float *)malloc((size_t)tile * width * sizeof(float)) : NULL;
+    float *cells = ok ? (float *)malloc((size_t)tile * tile * sizeof(float)) : NULL;
+    if (ok) {
+        info.num_rows = 0;
+        info.num_levels = tile_pyramid_levels_for(width, total_rows, tile);
+        ok = band && cells && (writing = tile_pyramid_writer_open(&writer, merged, &info)) &&
+             tile_pyramid_writer_reserve(&writer, total_rows);
+    }
+    for (uint32_t k = 0; ok && k < plan->count; k++) {
+        tile_pyramid_reader_t reader;
+        if (!tile_pyramid_reader_open(&reader, paths[k])) {
+            ok = false;
+            break;
+        }
+        for (uint64_t band_row = first[k] / tile; ok && band_row * tile < last[k]; band_row++) {
+            for (uint32_t col = 0; ok && col < reader.tile_cols[0]; col++) {
+                uint32_t rows = 0, cols = 0;
+                ok = tile_pyramid_read_tile(&reader, 0, band_row, col, cells, &rows, &cols);
+                for (uint32_t r = 0; ok && r < rows; r++) {
+                    memcpy(band + (size_t)r * width + (size_t)col * tile, cells + (size_t)r * cols,
+                           cols * sizeof(float));
+                }
+            }
+            uint64_t from = band_row * tile > first[k] ? band_row * tile : first[k];
+            uint64_t to = band_row * tile + tile < last[k] ? band_row * tile + tile : last[k];
+            for (uint64_t row = from; ok && row < to; row++) {
+                ok = tile_pyramid_writer_push(&writer, band + (size_t)(row - band_row * tile) * width);
+            }
+        }
+        tile_pyramid_reader_close(&reader);
+    }
+    if (writing && !tile_pyramid_writer_close(&writer)) ok = false;
+
+    if (ok) {
+        printf("  Merged %llu pyramid rows into %s\n", (unsigned long long)total_rows, merged);
+    } else {
+        fprintf(stderr, "Failed to merge tile pyramids into %s\n", merged);
+    }
+    free(first);
+    free(last);
+    free(band);
+    free(cells);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Outputs of a pipeline
+// ---------------------------------------------------------------------------
+
+// Each shard's expansion of 'text' plus 'suffix', and the capture's
+static bool expand_paths(const shard_plan_t *plan, const char *text, const char *suffix,
+                         const char *out_dir, char (*paths)[1024], char *merged) {
+    char expanded[1024];
+    for (uint32_t k = 0; k <= plan->count; k++) {
+        const char *input = k < plan->count ? plan->shards[k].path : plan->input;
+        char *target = k < plan->count ? paths[k] : merged;
+        if (!pipeline_expand_text(text, input, out_dir, expanded, sizeof(expanded))) return false;
+        int written = snprintf(target, 1024, "%s%s", expanded, suffix);
+        if (written < 0 || written >= 1024) return false;
+    }
+    return true;
+}
+
+/*
+ * Merge every mergeable output of the template's steps
+ */
+bool shard_merge_outputs(const shard_plan_t *plan, const yaml_document_t *document,
+                         const char *out_dir) {
+    if (!plan || !document || !out_dir) return false;
+
+    char (*paths)[1024] = (char (*)[1024])malloc((size_t)plan->count * 1024);
+    const char **pointers = (const char **)malloc(plan->count * sizeof(char *));
+    if (!paths || !pointers) {
+        free(paths);
+        free(pointers);
+        return false;
+    }
+    for (uint32_t k = 0; k < plan->count; k++) pointers[k] = paths[k];
+
+    bool ok = true;
+    char merged[1024];
+    for (uint32_t i = 0; i < document->pipeline_count; i++) {
+        const yaml_pipeline_step_t *step = &document->pipeline[i];
+        const char *out = yaml_get_step_param(step, "out");
+        if (!out) continue;
+
+        if (strcmp(step->tool_name, "iqdetect") == 0) {
+            const char *format = yaml_get_step_param(step, "output-format");
+            if (format && strcmp(format, "csv") != 0) {
+                printf("  Step %u (iqdetect): %s event logs stay per shard (only csv is merged)\n", i, format);
+                continue;
+            }
+            if (!expand_paths(plan, out, "", out_dir, paths, merged)) ok = false;
+            else if (!shard_merge_events(plan, pointers, merged)) ok = false;
+        } else if (strcmp(step->tool_name, "iqls") == 0) {
+            const char *pyramid = yaml_get_step_param(step, "pyramid");
+            if (!pyramid || strcmp(pyramid, "true") != 0) continue;
+            if (!expand_paths(plan, out, "_tiles.iqpyr", out_dir, paths, merged)) ok = false;
+            else if (!shard_merge_pyramids(plan, pointers, merged)) ok = false;
+        }
+    }
+
+    free(paths);
+    free(pointers);
+    return ok;
+}
+
+/*
+ * Delete the shard files and their metadata
+ */
+void shard_plan_remove_files(const shard_plan_t *plan) {
+    if (!plan) return;
+    for (uint32_t k = 0; k < plan->count; k++) {
+        char meta_path[512];
+        sigmf_get_meta_filename(plan->shards[k].path, meta_path, sizeof(meta_path));
+        remove(plan->shards[k].path);
+        remove(meta_path);
+    }
+}
+
+void shard_plan_free(shard_plan_t *plan) {
+    if (!plan) return;
+    free(plan->shards);
+    plan->shards = NULL;
+    plan->count = 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * IQ Lab - shard.h: Time-Sharded Pipeline Runs
+ *
+ * Purpose: Split one long capture into time shards that run the pipeline
+ * independently (on this machine or on worker nodes), then merge their
+ * outputs back into what a single run over the capture would write.
+ *
+ *
+ * A shard owns the samples [core_start, core_end) and is written as its own
+ * file covering [read_start, read_end): the core widened by a margin on
+ * each side, so frames and filters near the core's edges see the samples
+ * they need. The margin is sized from the steps: twice the largest FFT
+ * (iqdetect's 4096 when not given) but at least SHARD_MIN_MARGIN samples
+ * for the tools' own decimation filters, plus iqdetect's cluster gap.
+ * Core boundaries and margins fall on a grid of every step's hop, so each
+ * shard's frames are the unsharded run's frames at the same samples.
+ *
+ * Merging keeps, per shard, only the outputs that start inside its core:
+ * - iqdetect CSV events: times are moved to the capture's timeline; an
+ *   event of shard k reaching its file's end is extended by the events of
+ *   shard k + 1 that begin in that shard's leading margin and overlap it
+ *   in time and frequency (a burst longer than the margin), and those are
+ *   dropped as duplicates
+ * - iqls tile pyramids (--pyramid): the level-0 rows of the frames each
+ *   core owns, in shard order, rebuilt into one pyramid
+ * Shards are merged in order, so the result does not depend on which
+ * shard finished first or where it ran.
+ *
+ * Usage:
+ *   shard_plan_t plan;
+ *   shard_plan_init(&plan, document, 600.0, "results/shards");
+ *   shard_plan_write(&plan);                      // shard files + shards.csv
+ *   yaml_document_t shards;
+ *   shard_plan_document(&plan, document, &shards); // one input per shard
+ *   ... run 'shards' as a fan-out ...
+ *   shard_merge_outputs(&plan, document, out_dir);
+ *   shard_plan_remove_files(&plan);
+ *   shard_plan_free(&plan);
+ *
+ * Technical Details:
+ * - Shard files hold the capture's native samples (s8/s16/s12/s4) with a
+ *   .sigmf-meta each; their datetime is the capture's plus the offset
+ * - Steps given no rate get the capture's (shard files have no WAV header)
+ * - Shard stems are <stem>_shardNNN, so {stem} outputs stay apart
+ *
+ * Memory: one copy buffer while writing; one tile band while merging
+ * Thread Safety: a plan is used from one thread
+ */
+
+#ifndef IQ_LAB_SHARD_H
+#define IQ_LAB_SHARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "yaml_parse.h"
+#include "../iq_core/io_iq.h"
+
+#define SHARD_MAX_SHARDS 4096
+#define SHARD_COPY_SAMPLES 262144     // Samples per read while writing shard files
+#define SHARD_MIN_MARGIN 8192         // Samples, for filters the steps do not size
+
+// One shard of the capture (sample indices of the capture)
+typedef struct {
+    uint64_t read_start;     // First sample in the shard file
+    uint64_t read_end;       // One past its last
+    uint64_t core_start;     // First sample the shard owns
+    uint64_t core_end;       // One past the last
+    char path[512];          // Shard file
+} shard_t;
+
+// Shards of a capture and the geometry they were cut with
+typedef struct {
+    char input[512];         // Capture
+    char meta[512];          // Its SigMF metadata ("" if none)
+    char dir[512];           // Directory of the shard files
+    iq_format_t format;
+    uint32_t sample_rate;
+    uint64_t total_samples;
+    uint64_t shard_samples;  // Core length (the last shard may be shorter)
+    uint64_t margin;         // Samples either side of a core
+    uint64_t grid;           // Least common multiple of the steps' hops
+    shard_t *shards;
+    uint32_t count;
+} shard_plan_t;
+
+/*
+ * Margin and hop grid for a pipeline, in samples (capture rate)
+ * Returns false if a step's fft, hop or max-time-gap value does not parse.
+ */
+bool shard_geometry(const yaml_document_t *document, uint32_t sample_rate,
+                    uint64_t *margin, uint64_t *grid);
+
+/*
+ * Plan the shards of the document's single input: cores of about
+ * 'shard_seconds', their files in 'dir'. Returns false (message on stderr)
+ * unless the document has exactly one readable input with a known rate.
+ */
+bool shard_plan_init(shard_plan_t *plan, const yaml_document_t *document,
+                     double shard_seconds, const char *dir);
+
+// Write the shard files, their metadata and <dir>/shards.csv
+bool shard_plan_write(shard_plan_t *plan);
+
+/*
+ * The document to run: one input per shard file, the steps unchanged
+ * except for the capture's rate on steps without one. 'shards' must be
+ * freed with yaml_free_document; its strings may point into 'document'.
+ */
+bool shard_plan_document(const shard_plan_t *plan, const yaml_document_t *document,
+                         yaml_document_t *shards);
+
+/*
+ * Merge iqdetect CSV event logs, one per shard in shard order, into
+ * 'merged' on the capture's timeline
+ */
+bool shard_merge_events(const shard_plan_t *plan, const char *const *paths, const char *merged);
+
+// Merge iqls tile pyramids, one per shard in shard order, into 'merged'
+bool shard_merge_pyramids(const shard_plan_t *plan, const char *const *paths, const char *merged);
+
+/*
+ * Merge every mergeable output of the template's steps: each iqdetect
+ * "out" CSV and each iqls --pyramid, written where the template would put
+ * them for the capture itself. Other outputs stay per shard.
+ */
+bool shard_merge_outputs(const shard_plan_t *plan, const yaml_document_t *document,
+                         const char *out_dir);
+
+// Delete the shard files and their metadata (the outputs stay)
+void shard_plan_remove_files(const shard_plan_t *plan);
+
+void shard_plan_free(shard_plan_t *plan);
+
+#endif /* IQ_LAB_SHARD_H */
@@ -0,0 +1,439 @@
+/*
+ * IQ Lab - step_cache.c: Content-Addressed Pipeline Step Cache Implementation
+ *
+ * Purpose: Key pipeline steps by their tool, parameters and input contents
+ * and keep the files they wrote, so unchanged steps of a re-run are
+ * restored instead of executed (see step_cache.h for the key and layout).
+ *
+ *
+ * Date: 2025
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "step_cache.h"
+#include "../iq_core/io_sigmf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#include <io.h>
+#define cache_mkdir(path) _mkdir(path)
+#define cache_getpid() _getpid()
+#else
+#include <unistd.h>
+#define cache_mkdir(path) mkdir((path), 0755)
+#define cache_getpid() getpid()
+#endif
+
+#define STEP_CACHE_MANIFEST_HEADER "iqlab-step-cache 1"
+
+// ---------------------------------------------------------------------------
+// SHA-256 (FIPS 180-4)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;                // Bytes hashed so far
+    uint8_t block[64];
+    size_t block_used;
+} sha256_t;
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t rotr32(uint32_t x, unsigned n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void sha256_init(sha256_t *sha) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(sha->state, initial, sizeof(initial));
+    sha->length = 0;
+    sha->block_used = 0;
+}
+
+static void sha256_compress(sha256_t *sha, const uint8_t *block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+               (uint32_t)block[4 * i + 2] << 8 | (uint32_t)block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = sha->state[0], b = sha->state[1], c = sha->state[2], d = sha->state[3];
+    uint32_t e = sha->state[4], f = sha->state[5], g = sha->state[6], h = sha->state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) +
+                      SHA256_K[i] + w[i];
+        uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    sha->state[0] += a; sha->state[1] += b; sha->state[2] += c; sha->state[3] += d;
+    sha->state[4] += e; sha->state[5] += f; sha->state[6] += g; sha->state[7] += h;
+}
+
+static void sha256_update(sha256_t *sha, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    sha->length += size;
+    while (size > 0) {
+        size_t take = 64 - sha->block_used < size ? 64 - sha->block_used : size;
+        memcpy(sha->block + sha->block_used, bytes, take);
+        sha->block_used += take;
+        bytes += take;
+        size -= take;
+        if (sha->block_used == 64) {
+            sha256_compress(sha, sha->block);
+            sha->block_used = 0;
+        }
+    }
+}
+
+static void sha256_final(sha256_t *sha, char digest[STEP_CACHE_KEY_SIZE]) {
+    uint64_t bits = sha->length * 8;
+    uint8_t pad = 0x80;
+    sha256_update(sha, &pad, 1);
+    pad = 0;
+    while (sha->block_used != 56) sha256_update(sha, &pad, 1);
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++) length[i] = (uint8_t)(bits >> (56 - 8 * i));
+    sha256_update(sha, length, 8);
+
+    for (int i = 0; i < 8; i++) {
+        snprintf(digest + 8 * i, 9, "%08x", sha->state[i]);
+    }
+}
+
+void step_cache_sha256(const void *data, size_t size, char digest[STEP_CACHE_KEY_SIZE]) {
+    sha256_t sha;
+    sha256_init(&sha);
+    sha256_update(&sha, data, size);
+    sha256_final(&sha, digest);
+}
+
+// Add one "name value" line to a key
+static void sha256_line(sha256_t *sha, const char *name, const char *value) {
+    sha256_update(sha, name, strlen(name));
+    sha256_update(sha, " ", 1);
+    sha256_update(sha, value, strlen(value));
+    sha256_update(sha, "\n", 1);
+}
+
+// SHA-256 of a file's contents
+static bool sha256_file(const char *path, char digest[STEP_CACHE_KEY_SIZE]) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    sha256_t sha;
+    sha256_init(&sha);
+    static _Thread_local uint8_t buffer[1 << 16];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        sha256_update(&sha, buffer, got);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    if (ok) sha256_final(&sha, digest);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Keys
+// ---------------------------------------------------------------------------
+
+bool step_cache_init(step_cache_t *cache, const char *dir) {
+    if (!cache || !dir || !dir[0] || strlen(dir) >= sizeof(cache->dir)) return false;
+
+    memset(cache, 0, sizeof(*cache));
+    strcpy(cache->dir, dir);
+
+    struct stat st;
+    if (stat(dir, &st) == 0) {
+        if (S_ISDIR(st.st_mode)) return true;
+        fprintf(stderr, "Cache path exists but is not a directory: %s\n", dir);
+        return false;
+    }
+    if (cache_mkdir(dir) != 0) {
+        fprintf(stderr, "Failed to create cache directory %s: %s\n", dir, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Digest identifying a file's contents: SigMF core:sha512 if recorded,
+// else SHA-256 of the bytes (remembered by path, size and mtime)
+static bool input_digest(step_cache_t *cache, const char *path, const struct stat *st,
+                         char digest[136]) {
+    for (uint32_t i = 0; i < cache->memo_count; i++) {
+        if (strcmp(cache->memo[i].path, path) == 0 && cache->memo[i].size == (long long)st->st_size &&
+            cache->memo[i].mtime == (long long)st->st_mtime) {
+            strcpy(digest, cache->memo[i].digest);
+            return true;
+        }
+    }
+
+    char meta_path[512];
+    sigmf_get_meta_filename(path, meta_path, sizeof(meta_path));
+    sigmf_metadata_t meta;
+    bool recorded = false;
+    if (strcmp(meta_path, path) != 0 && sigmf_read_metadata(meta_path, &meta)) {
+        recorded = meta.global.sha512[0] != '\0';
+        if (recorded) snprintf(digest, 136, "sha512:%s", meta.global.sha512);
+        sigmf_free_metadata(&meta);
+    }
+    if (!recorded) {
+        char sha[STEP_CACHE_KEY_SIZE];
+        if (!sha256_file(path, sha)) return false;
+        snprintf(digest, 136, "sha256:%s", sha);
+    }
+
+    if (strlen(path) < sizeof(cache->memo[0].path)) {
+        uint32_t slot = cache->memo_count < STEP_CACHE_MEMO_SIZE ? cache->memo_count++
+                                                                 : cache->memo_next++ % STEP_CACHE_MEMO_SIZE;
+        strcpy(cache->memo[slot].path, path);
+        cache->memo[slot].size = (long long)st->st_size;
+        cache->memo[slot].mtime = (long long)st->st_mtime;
+        strcpy(cache->memo[slot].digest, digest);
+    }
+    return true;
+}
+
+bool step_cache_key(step_cache_t *cache, const yaml_pipeline_step_t *step,
+                    const char *tool_path, char key[STEP_CACHE_KEY_SIZE]) {
+    if (!cache || !step || !key) return false;
+
+    sha256_t sha;
+    sha256_init(&sha);
+    sha256_line(&sha, "cache", STEP_CACHE_MANIFEST_HEADER);
+    sha256_line(&sha, "tool", step->tool_name);
+
+    // The tool build: the executable's digest
+    struct stat st;
+    char version[136] = "unversioned";
+    if (tool_path && stat(tool_path, &st) == 0 && S_ISREG(st.st_mode)) {
+        input_digest(cache, tool_path, &st, version);
+    }
+    sha256_line(&sha, "version", version);
+    sha256_line(&sha, "output_dir", step->output_dir);
+
+    // Parameters in a canonical order
+    uint32_t order[32];
+    uint32_t count = step->param_count;
+    if (count > sizeof(order) / sizeof(order[0])) return false;  // More than a tool takes
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t j = i;
+        while (j > 0) {
+            int cmp = strcmp(step->params[order[j - 1]].key, step->params[i].key);
+            if (cmp == 0) cmp = strcmp(step->params[order[j - 1]].value, step->params[i].value);
+            if (cmp <= 0) break;
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    for (uint32_t n = 0; n < count; n++) {
+        const char *name = step->params[order[n]].key;
+        const char *value = step->params[order[n]].value;
+        sha256_update(&sha, "param ", 6);
+        sha256_line(&sha, name, value);
+
+        // Files the step reads, by contents
+        if (strcmp(name, "out") == 0 || stat(value, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        char digest[136];
+        if (!input_digest(cache, value, &st, digest)) {
+            fprintf(stderr, "Cache: cannot read %s\n", value);
+            return false;
+        }
+        sha256_update(&sha, "file ", 5);
+        sha256_line(&sha, name, digest);
+    }
+
+    sha256_final(&sha, key);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Entries
+// ---------------------------------------------------------------------------
+
+static bool copy_file(const char *from, const char *to) {
+    FILE *in = fopen(from, "rb");
+    if (!in) return false;
+    FILE *out = fopen(to, "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+
+    static _Thread_local char buffer[1 << 16];
+    size_t got;
+    bool ok = true;
+    while (ok && (got = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        ok = fwrite(buffer, 1, got, out) == got;
+    }
+    ok = ok && !ferror(in);
+    fclose(in);
+    if (fclose(out) != 0) ok = false;
+    return ok;
+}
+
+// Remove an entry directory and its files (entries hold no subdirectories)
+static void remove_entry(const char *dir) {
+    DIR *handle = opendir(dir);
+    if (handle) {
+        struct dirent *entry;
+        while ((entry = readdir(handle)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            remove(path);
+        }
+        closedir(handle);
+    }
+    rmdir(dir);
+}
+
+// Add files under one output path to the list: everything in a directory,
+// or prefix matches next to a file prefix, modified since the step began
+static void collect_outputs(const char *output, time_t since, char (*files)[512], uint32_t *count) {
+    char dir[512], prefix[256] = "";
+    struct stat st;
+    if (stat(output, &st) == 0 && S_ISDIR(st.st_mode)) {
+        snprintf(dir, sizeof(dir), "%s", output);
+    } else {
+        const char *slash = strrchr(output, '/');
+#ifdef _WIN32
+        const char *backslash = strrchr(output, '\\');
+        if (backslash && (!slash || backslash > slash)) slash = backslash;
+#endif
+        if (slash) {
+            snprintf(dir, sizeof(dir), "%.*s", (int)(slash - output), output);
+            if (dir[0] == '\0') strcpy(dir, "/");
+            snprintf(prefix, sizeof(prefix), "%s", slash + 1);
+        } else {
+            strcpy(dir, ".");
+            snprintf(prefix, sizeof(prefix), "%s", output);
+        }
+    }
+
+    DIR *handle = opendir(dir);
+    if (!handle) return;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL && *count < STEP_CACHE_MAX_FILES) {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) != 0) continue;
+        char path[512];
+        int written = snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (written < 0 || (size_t)written >= sizeof(path)) continue;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) || st.st_mtime < since) continue;
+
+        bool seen = false;
+        for (uint32_t i = 0; i < *count && !seen; i++) seen = strcmp(files[i], path) == 0;
+        if (!seen) strcpy(files[(*count)++], path);
+    }
+    closedir(handle);
+}
+
+bool step_cache_store(step_cache_t *cache, const char *key,
+                      const yaml_pipeline_step_t *step, time_t since) {
+    if (!cache || !key || !key[0] || !step) return false;
+
+    char entry[512];
+    snprintf(entry, sizeof(entry), "%s/%s", cache->dir, key);
+    struct stat st;
+    if (stat(entry, &st) == 0) return true;  // Stored by an earlier run
+
+    static _Thread_local char files[STEP_CACHE_MAX_FILES][512];
+    uint32_t count = 0;
+    if (step->output_dir[0]) collect_outputs(step->output_dir, since, files, &count);
+    for (uint32_t i = 0; i < step->param_count; i++) {
+        if (strcmp(step->params[i].key, "out") == 0 && step->params[i].value[0]) {
+            collect_outputs(step->params[i].value, since, files, &count);
+        }
+    }
+
+    // Build the entry aside, then publish it with one rename
+    char staging[600];
+    snprintf(staging, sizeof(staging), "%s.tmp.%d", entry, (int)cache_getpid());
+    remove_entry(staging);
+    if (cache_mkdir(staging) != 0) {
+        fprintf(stderr, "Cache: failed to create %s: %s\n", staging, strerror(errno));
+        return false;
+    }
+
+    char path[700];
+    snprintf(path, sizeof(path), "%s/manifest", staging);
+    FILE *manifest = fopen(path, "w");
+    bool ok = manifest != NULL;
+    if (ok) fprintf(manifest, "%s\n", STEP_CACHE_MANIFEST_HEADER);
+    for (uint32_t i = 0; ok && i < count; i++) {
+        snprintf(path, sizeof(path), "%s/%u.bin", staging, i);
+        ok = copy_file(files[i], path);
+        if (ok) fprintf(manifest, "%s\n", files[i]);
+    }
+    if (manifest && fclose(manifest) != 0) ok = false;
+
+    if (ok && rename(staging, entry) != 0) {
+        ok = stat(entry, &st) == 0;  // Another run stored it first
+    }
+    if (!ok) {
+        fprintf(stderr, "Cache: failed to store entry %s\n", key);
+    } else {
+        cache->stores++;
+    }
+    remove_entry(staging);
+    return ok;
+}
+
+bool step_cache_restore(step_cache_t *cache, const char *key,
+                        char *restored, size_t restored_size) {
+    if (!cache || !key || !key[0]) return false;
+
+    char path[700];
+    snprintf(path, sizeof(path), "%s/%s/manifest", cache->dir, key);
+    FILE *manifest = fopen(path, "r");
+    if (!manifest) return false;
+
+    char line[600];
+    bool ok = fgets(line, sizeof(line), manifest) != NULL &&
+              strncmp(line, STEP_CACHE_MANIFEST_HEADER, strlen(STEP_CACHE_MANIFEST_HEADER)) == 0;
+    if (restored && restored_size) restored[0] = '\0';
+    size_t used = 0;
+    for (uint32_t i = 0; ok && fgets(line, sizeof(line), manifest) != NULL; i++) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!line[0]) continue;
+
+        snprintf(path, sizeof(path), "%s/%s/%u.bin", cache->dir, key, i);
+        ok = copy_file(path, line);
+        if (ok && restored && used + strlen(line) + 2 < restored_size) {
+            used += (size_t)snprintf(restored + used, restored_size - used, "%s%s", used ? "," : "", line);
+        }
+    }
+    fclose(manifest);
+
+    if (ok) cache->hits++;
+    else fprintf(stderr, "Cache: entry %s could not be restored; running the step\n", key);
+    return ok;
+}
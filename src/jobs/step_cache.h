@@ -0,0 +1,127 @@
+/*
+ * IQ Lab - step_cache.h: Content-Addressed Pipeline Step Cache
+ *
+ * Purpose: Skip pipeline steps whose result is already known. Tools are
+ * deterministic, so a step's outputs are a function of its tool, the tool
+ * build, its parameters and the contents of the files it reads. The cache
+ * keys each step by a SHA-256 over exactly those and keeps the files the
+ * step wrote under that key; a later run with the same key copies them
+ * back instead of running the tool.
+ *
+ * Key (SHA-256 over a canonical text):
+ * - Tool name and version: the digest of the tool executable, so a rebuilt
+ *   tool invalidates its entries ("unversioned" if it cannot be read)
+ * - Output directory and every parameter, sorted by key then value
+ * - For each parameter naming an existing file (other than "out"): its
+ *   SigMF core:sha512 when the file has a .sigmf-meta recording one, else
+ *   the SHA-256 of its contents. A step reading an upstream output is
+ *   therefore keyed by what that step actually produced.
+ *
+ * Artifacts: <dir>/<key>/manifest lists the output paths, one per line,
+ * and <dir>/<key>/<n>.bin holds the n-th file. The files a step wrote are
+ * those under its outputs (an "out" directory or output_dir, or files in
+ * the directory of an "out" prefix whose name starts with it) modified
+ * since the step started. Entries are written to a temporary directory and
+ * renamed into place, so a reader never sees half an entry. Restores copy
+ * rather than link, so a tool that later rewrites an output in place
+ * cannot corrupt the cache.
+ *
+ *
+ * Date: 2025
+ */
+
+#ifndef STEP_CACHE_H
+#define STEP_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include "yaml_parse.h"
+
+// Hex SHA-256 digest plus terminator
+#define STEP_CACHE_KEY_SIZE 65
+
+// Files one entry holds
+#define STEP_CACHE_MAX_FILES 64
+
+// Input digests remembered per run (by path, size and mtime)
+#define STEP_CACHE_MEMO_SIZE 32
+
+typedef struct step_cache_t step_cache_t;
+
+/**
+ * @brief Step result cache
+ */
+struct step_cache_t {
+    char dir[256];                  // Cache root
+
+    // Digests of files already hashed in this run
+    struct {
+        char path[512];
+        long long size;
+        long long mtime;
+        char digest[136];           // "sha256:<hex>" or "sha512:<hex>"
+    } memo[STEP_CACHE_MEMO_SIZE];
+    uint32_t memo_count;
+    uint32_t memo_next;             // Slot replaced when the memo is full
+
+    uint32_t hits;                  // Steps restored
+    uint32_t stores;                // Entries written
+};
+
+/**
+ * @brief SHA-256 of a buffer as lowercase hex
+ *
+ * @param data Bytes to hash
+ * @param size Number of bytes
+ * @param digest Receives STEP_CACHE_KEY_SIZE characters (with terminator)
+ */
+void step_cache_sha256(const void *data, size_t size, char digest[STEP_CACHE_KEY_SIZE]);
+
+/**
+ * @brief Open (creating if needed) a cache directory
+ *
+ * @param cache Cache to initialize
+ * @param dir Cache root
+ * @return true on success, false if the directory cannot be created
+ */
+bool step_cache_init(step_cache_t *cache, const char *dir);
+
+/**
+ * @brief Compute the key of a step
+ *
+ * @param cache Cache (remembers input digests)
+ * @param step Pipeline step
+ * @param tool_path Tool executable hashed as its version (may be NULL)
+ * @param key Receives the hex key
+ * @return true on success, false if an input could not be read
+ */
+bool step_cache_key(step_cache_t *cache, const yaml_pipeline_step_t *step,
+                    const char *tool_path, char key[STEP_CACHE_KEY_SIZE]);
+
+/**
+ * @brief Restore the outputs stored under a key
+ *
+ * @param cache Cache
+ * @param key Step key
+ * @param restored Receives the comma-separated restored paths (may be NULL)
+ * @param restored_size Size of restored
+ * @return true if an entry exists and every file was restored
+ */
+bool step_cache_restore(step_cache_t *cache, const char *key,
+                        char *restored, size_t restored_size);
+
+/**
+ * @brief Store the outputs a finished step wrote
+ *
+ * @param cache Cache
+ * @param key Step key (from before the step ran)
+ * @param step Pipeline step
+ * @param since Step start; only files modified since count as its outputs
+ * @return true if the entry was written (or already existed)
+ */
+bool step_cache_store(step_cache_t *cache, const char *key,
+                      const yaml_pipeline_step_t *step, time_t since);
+
+#endif /* STEP_CACHE_H */
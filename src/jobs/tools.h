@@ -0,0 +1,42 @@
+/*
+ * IQ Lab - tools.h: CLI Tool Entry Points
+ *
+ * Purpose: Expose the cores of the streaming analysis tools as library
+ * calls so iqjob can run pipeline steps in its own process. Each entry
+ * takes the argument vector its main() would (argv[0] is the tool name)
+ * and returns its exit code. Tool objects built with IQ_TOOL_LIBRARY
+ * leave main() out.
+ *
+ *
+ * Date: 2025
+ */
+
+#ifndef TOOLS_H
+#define TOOLS_H
+
+/**
+ * @brief Spectrum and waterfall rendering (tools/iqls.c)
+ */
+int iqls_main(int argc, char **argv);
+
+/**
+ * @brief CFAR detection and event clustering (tools/iqdetect.c)
+ */
+int iqdetect_main(int argc, char **argv);
+
+/**
+ * @brief FM demodulation to WAV (tools/iqdemod-fm.c)
+ */
+int iqdemod_fm_main(int argc, char *argv[]);
+
+/**
+ * @brief AM demodulation to WAV (tools/iqdemod-am.c)
+ */
+int iqdemod_am_main(int argc, char *argv[]);
+
+/**
+ * @brief SSB demodulation to WAV (tools/iqdemod-ssb.c)
+ */
+int iqdemod_ssb_main(int argc, char *argv[]);
+
+#endif /* TOOLS_H */
@@ -2,226 +2,444 @@
  * IQ Lab - yaml_parse.c: Minimal YAML Parser Implementation
  *
  * Purpose: Parse YAML pipeline configurations without external dependencies.
- * Implements a recursive descent parser for the specific YAML structure used
- * in IQ Lab batch processing pipelines.
+ * A tokenizer makes one pass over the text and hands out spans of it; a
+ * recursive descent parser over those tokens builds the document for the
+ * specific YAML structure used in IQ Lab batch processing pipelines.
  *
  * Supported Features:
- * - Key-value pairs
+ * - Key-value pairs, in block (indented lines) or flow ({ k: v }) form
  * - Nested mappings
- * - Arrays/lists
- * - Basic data types (strings, numbers, booleans)
+ * - Block sequences (- entries)
+ * - Plain, "double" and 'single' quoted scalars
  * - Comments (ignored)
+ * - Any number of inputs, steps and parameters, of any length: strings
+ *   and parameter lists are copied once into the document's arena, inputs
+ *   and steps live in arrays grown as entries are parsed; glob patterns in
+ *   input files (yaml_expand_inputs)
  *
  * Limitations:
- * - No complex YAML features (anchors, aliases, etc.)
- * - Indentation-based structure only
+ * - No complex YAML features (anchors, aliases, multi-line scalars, flow
+ *   sequences, etc.)
  * - Single document per file
  *
+ * Cost: every character is looked at a bounded number of times (tokens are
+ * never re-scanned, keywords are compared as spans), so parsing is linear.
+ *
  *
  * Date: 2025
  */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "yaml_parse.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
 
-/**
- * @brief Skip whitespace characters
- */
-static void skip_whitespace(const char *text, size_t *position, size_t length) {
-    while (*position < length && isspace(text[*position])) {
-        (*position)++;
-    }
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <glob.h>
+#endif
+
+// First capacity of the input, step and parameter arrays
+#define YAML_INITIAL_CAPACITY 16
+
+// Arena block size (larger requests get a block of their own)
+#define YAML_ARENA_BLOCK_SIZE 65536
+
+// Value of every string not given in the document
+static const char EMPTY[] = "";
+
+// ---------------------------------------------------------------------------
+// Arena
+// ---------------------------------------------------------------------------
+
+struct yaml_arena_block_t {
+    yaml_arena_block_t *next;   // Older block
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+// Pointer-aligned memory owned by the document
+static void *arena_alloc(yaml_document_t *document, size_t size) {
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    yaml_arena_block_t *block = document->arena;
+    if (!block || block->size - block->used < size) {
+        size_t block_size = size > YAML_ARENA_BLOCK_SIZE ? size : YAML_ARENA_BLOCK_SIZE;
+        block = (yaml_arena_block_t *)malloc(sizeof(yaml_arena_block_t) + block_size);
+        if (!block) return NULL;
+        block->next = document->arena;
+        block->used = 0;
+        block->size = block_size;
+        document->arena = block;
+    }
+    void *memory = block->data + block->used;
+    block->used += size;
+    return memory;
+}
+
+static const char *copy_span(yaml_document_t *document, const char *text, size_t length) {
+    char *copy = (char *)arena_alloc(document, length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// Room for one more parameter of a step (the old list stays in the arena)
+static bool grow_params(yaml_document_t *document, yaml_pipeline_step_t *step) {
+    if (step->param_count < step->param_capacity) return true;
+
+    uint32_t grown = step->param_capacity ? 2 * step->param_capacity : YAML_INITIAL_CAPACITY;
+    yaml_param_t *params = (yaml_param_t *)arena_alloc(document, grown * sizeof(yaml_param_t));
+    if (!params) return false;
+    if (step->param_count) memcpy(params, step->params, step->param_count * sizeof(yaml_param_t));
+    step->params = params;
+    step->param_capacity = grown;
+    return true;
 }
 
 /**
- * @brief Skip comment lines
+ * @brief Copy a string into a document's arena
  */
-static void skip_comments(const char *text, size_t *position, size_t length) {
-    if (*position < length && text[*position] == '#') {
-        while (*position < length && text[*position] != '\n') {
-            (*position)++;
-        }
-        if (*position < length) (*position)++; // Skip newline
-    }
+const char *yaml_copy_string(yaml_document_t *document, const char *text) {
+    if (!document || !text) return NULL;
+    return copy_span(document, text, strlen(text));
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer
+// ---------------------------------------------------------------------------
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static bool is_space_or_end(const yaml_tokenizer_t *tokenizer, size_t position) {
+    return position >= tokenizer->length || isspace((unsigned char)tokenizer->text[position]);
 }
 
 /**
- * @brief Parse a quoted string value
+ * @brief Start tokenizing a text
  */
-static bool parse_quoted_string(const char *text, size_t *position, size_t length,
-                               char *buffer, size_t buffer_size) {
-    if (*position >= length || text[*position] != '"') {
-        return false;
-    }
+void yaml_tokenizer_init(yaml_tokenizer_t *tokenizer, const char *text, size_t length) {
+    memset(tokenizer, 0, sizeof(*tokenizer));
+    tokenizer->text = text;
+    tokenizer->length = length;
+    tokenizer->line = 1;
+}
 
-    (*position)++; // Skip opening quote
-    size_t start = *position;
+static yaml_token_type_t token_error(yaml_tokenizer_t *tokenizer, yaml_token_t *token,
+                                     const char *error) {
+    tokenizer->error = error;
+    tokenizer->position = tokenizer->length;  // Nothing after an error
+    return token->type = YAML_TOKEN_ERROR;
+}
 
-    while (*position < length && text[*position] != '"') {
-        if (text[*position] == '\\') {
-            (*position)++; // Skip escape character
+/**
+ * @brief Read the next token
+ */
+yaml_token_type_t yaml_next_token(yaml_tokenizer_t *tokenizer, yaml_token_t *token) {
+    const char *text = tokenizer->text;
+    size_t length = tokenizer->length;
+    size_t p = tokenizer->position;
+
+    // Blank space, line breaks and comments
+    for (;;) {
+        while (p < length && (is_blank(text[p]) || text[p] == '\r')) p++;
+        if (p < length && text[p] == '#') {
+            while (p < length && text[p] != '\n') p++;
+        }
+        if (p < length && text[p] == '\n') {
+            p++;
+            tokenizer->line++;
+            tokenizer->line_start = p;
+            continue;
+        }
+        break;
+    }
+
+    token->line = tokenizer->line;
+    token->column = (uint32_t)(p - tokenizer->line_start);
+    token->quote = 0;
+    token->text.start = text + p;
+    token->text.length = 0;
+    tokenizer->position = p;
+    if (p >= length) return token->type = YAML_TOKEN_END;
+
+    bool flow = tokenizer->flow_depth > 0;
+    char c = text[p];
+    token->text.length = 1;
+    tokenizer->position = p + 1;
+    if (c == '-' && !flow && is_space_or_end(tokenizer, p + 1)) {
+        return token->type = YAML_TOKEN_ENTRY;
+    }
+    if (c == '{') {
+        tokenizer->flow_depth++;
+        return token->type = YAML_TOKEN_FLOW_START;
+    }
+    if (c == '}') {
+        if (!flow) return token_error(tokenizer, token, "unmatched '}'");
+        tokenizer->flow_depth--;
+        return token->type = YAML_TOKEN_FLOW_END;
+    }
+    if (c == ',' && flow) return token->type = YAML_TOKEN_COMMA;
+    if (c == '[' || c == ']') return token_error(tokenizer, token, "flow sequences are not supported");
+
+    size_t start, end;
+    if (c == '"' || c == '\'') {
+        // Quoted: up to the closing quote on the same line
+        start = ++p;
+        while (p < length && text[p] != '\n') {
+            if (text[p] == c) {
+                if (c == '\'' && p + 1 < length && text[p + 1] == '\'') {
+                    p += 2;  // '' is a quote
+                    continue;
+                }
+                break;
+            }
+            p += (c == '"' && text[p] == '\\' && p + 1 < length) ? 2 : 1;
+        }
+        if (p >= length || text[p] != c) return token_error(tokenizer, token, "unterminated quoted string");
+        end = p++;
+        token->quote = c;
+        while (p < length && is_blank(text[p])) p++;
+    } else {
+        // Plain: up to the line end, a comment, ": " or (in flow) ',' or '}'
+        start = p;
+        end = p;
+        while (p < length) {
+            char d = text[p];
+            if (d == '\n' || d == '\r') break;
+            if (d == '#' && p > start && is_blank(text[p - 1])) break;
+            if (d == ':' && (is_space_or_end(tokenizer, p + 1) ||
+                             (flow && (text[p + 1] == ',' || text[p + 1] == '}')))) {
+                break;
+            }
+            if (flow && (d == ',' || d == '}' || d == '{')) break;
+            p++;
+            if (!is_blank(d)) end = p;
         }
-        (*position)++;
     }
 
-    if (*position >= length) {
-        return false; // Unterminated string
+    token->text.start = text + start;
+    token->text.length = end - start;
+    token->type = YAML_TOKEN_SCALAR;
+    if (p < length && text[p] == ':') {
+        token->type = YAML_TOKEN_KEY;
+        p++;
     }
+    tokenizer->position = p;
+    return token->type;
+}
 
-    size_t string_length = *position - start;
-    if (string_length >= buffer_size) {
-        return false; // String too long
-    }
+// ---------------------------------------------------------------------------
+// Parser
+// ---------------------------------------------------------------------------
 
-    memcpy(buffer, &text[start], string_length);
-    buffer[string_length] = '\0';
+// Mapping being read: flow ({ ... }) or block (keys at one column)
+typedef struct {
+    bool flow;
+    bool done;
+    uint32_t column;
+} yaml_map_t;
 
-    (*position)++; // Skip closing quote
-    return true;
+static void advance(yaml_parser_t *parser) {
+    yaml_next_token(&parser->tokenizer, &parser->token);
 }
 
-/**
- * @brief Parse an unquoted string value
- */
-static bool parse_unquoted_string(const char *text, size_t *position, size_t length,
-                                 char *buffer, size_t buffer_size) {
-    size_t i = 0;
-
-    while (*position < length && !isspace(text[*position]) &&
-           text[*position] != '\n' && text[*position] != '\r' &&
-           text[*position] != ',' && text[*position] != '}' &&
-           text[*position] != ']' && text[*position] != '#') {
-        if (i >= buffer_size - 1) {
-            return false; // String too long
+static bool parse_error(yaml_parser_t *parser, const char *what) {
+    if (parser->token.type == YAML_TOKEN_ERROR) what = parser->tokenizer.error;
+    snprintf(parser->error_message, sizeof(parser->error_message), "Line %u: %s",
+             parser->token.line, what);
+    return false;
+}
+
+static bool out_of_memory(yaml_parser_t *parser) {
+    return parse_error(parser, "out of memory");
+}
+
+static bool span_is(const yaml_token_t *token, const char *word) {
+    size_t length = strlen(word);
+    return token->text.length == length && memcmp(token->text.start, word, length) == 0;
+}
+
+// Copy a scalar's text, resolving quote escapes
+static const char *copy_scalar(yaml_document_t *document, const yaml_token_t *token) {
+    const char *text = token->text.start;
+    size_t length = token->text.length;
+    if (!token->quote) return copy_span(document, text, length);
+
+    char *copy = (char *)arena_alloc(document, length + 1);
+    if (!copy) return NULL;
+    size_t n = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (token->quote == '\'' && c == '\'') {
+            i++;  // '' -> '
+        } else if (token->quote == '"' && c == '\\' && i + 1 < length) {
+            c = text[++i];
+            if (c == 'n') c = '\n';
+            else if (c == 't') c = '\t';
+            else if (c == 'r') c = '\r';
+            else if (c == '0') c = '\0';
         }
-        buffer[i++] = text[*position];
-        (*position)++;
+        copy[n++] = c;
     }
+    copy[n] = '\0';
+    return copy;
+}
 
-    buffer[i] = '\0';
-    return i > 0;
+// A scalar token that is the value of 'key' (same line, or further in)
+static bool is_value_of(const yaml_parser_t *parser, const yaml_token_t *key) {
+    const yaml_token_t *token = &parser->token;
+    return token->type == YAML_TOKEN_SCALAR &&
+           (parser->tokenizer.flow_depth > 0 || token->line == key->line || token->column > key->column);
 }
 
-/**
- * @brief Parse a key-value pair
- */
-static bool parse_key_value(const char *text, size_t *position, size_t length,
-                           char *key, size_t key_size, char *value, size_t value_size) {
-    skip_whitespace(text, position, length);
-    skip_comments(text, position, length);
-    skip_whitespace(text, position, length);
-
-    // Parse key
-    if (!parse_unquoted_string(text, position, length, key, key_size)) {
-        return false;
+// Read the scalar value of a key ("" if it has none)
+static bool read_scalar(yaml_parser_t *parser, yaml_document_t *document,
+                        const yaml_token_t *key, const char **value) {
+    if (!is_value_of(parser, key)) {
+        if (parser->token.type == YAML_TOKEN_FLOW_START ||
+            (parser->token.type == YAML_TOKEN_KEY && parser->token.column > key->column)) {
+            return parse_error(parser, "expected a plain value, not a mapping");
+        }
+        *value = EMPTY;
+        return true;
     }
+    *value = copy_scalar(document, &parser->token);
+    if (!*value) return out_of_memory(parser);
+    advance(parser);
+    return true;
+}
 
-    skip_whitespace(text, position, length);
+// Skip a flow mapping from its '{' through the matching '}'
+static bool skip_flow(yaml_parser_t *parser) {
+    uint32_t outer = parser->tokenizer.flow_depth - 1;
+    do {
+        advance(parser);
+        if (parser->token.type == YAML_TOKEN_END || parser->token.type == YAML_TOKEN_ERROR) {
+            return parse_error(parser, "unterminated '{'");
+        }
+    } while (parser->token.type != YAML_TOKEN_FLOW_END || parser->tokenizer.flow_depth != outer);
+    advance(parser);
+    return true;
+}
 
-    // Expect colon
-    if (*position >= length || text[*position] != ':') {
-        return false;
+// Skip the value of a key, whatever it is
+static bool skip_value(yaml_parser_t *parser, const yaml_token_t *key) {
+    bool in_flow = parser->tokenizer.flow_depth > 0 && parser->token.type != YAML_TOKEN_FLOW_START;
+    if (is_value_of(parser, key)) {
+        advance(parser);
+        return true;
+    }
+    if (parser->token.type == YAML_TOKEN_FLOW_START) return skip_flow(parser);
+    if (in_flow) return true;  // Empty value
+
+    // Block value: everything further in on later lines
+    const yaml_token_t *token = &parser->token;
+    while (token->type != YAML_TOKEN_END && token->type != YAML_TOKEN_ERROR && token->line > key->line &&
+           (token->column > key->column || (token->type == YAML_TOKEN_ENTRY && token->column == key->column))) {
+        if (token->type == YAML_TOKEN_FLOW_START) {
+            if (!skip_flow(parser)) return false;
+        } else {
+            advance(parser);
+        }
     }
-    (*position)++;
+    return token->type != YAML_TOKEN_ERROR || parse_error(parser, "");
+}
 
-    skip_whitespace(text, position, length);
+// Open the mapping that is the value of 'owner' (a key or sequence entry)
+static void map_open(yaml_parser_t *parser, const yaml_token_t *owner, yaml_map_t *map) {
+    const yaml_token_t *token = &parser->token;
+    map->flow = false;
+    map->done = false;
+    map->column = token->column;
+    if (token->type == YAML_TOKEN_FLOW_START) {
+        map->flow = true;
+        advance(parser);
+    } else if (token->type != YAML_TOKEN_KEY ||
+               (token->line == owner->line ? owner->type != YAML_TOKEN_ENTRY
+                                           : token->column <= owner->column)) {
+        map->done = true;  // Empty
+    }
+}
 
-    // Parse value
-    if (*position < length && text[*position] == '"') {
-        // Quoted string
-        if (!parse_quoted_string(text, position, length, value, value_size)) {
-            return false;
+// Next key of a mapping: 1 with 'key' set and the parser at its value,
+// 0 at the end of the mapping, -1 on a syntax error
+static int map_next(yaml_parser_t *parser, yaml_map_t *map, yaml_token_t *key) {
+    if (map->done) return 0;
+
+    const yaml_token_t *token = &parser->token;
+    if (map->flow) {
+        if (token->type == YAML_TOKEN_COMMA) advance(parser);
+        if (token->type == YAML_TOKEN_FLOW_END) {
+            advance(parser);
+            map->done = true;
+            return 0;
         }
-    } else {
-        // Unquoted value
-        if (!parse_unquoted_string(text, position, length, value, value_size)) {
-            return false;
+        if (token->type != YAML_TOKEN_KEY) {
+            parse_error(parser, "expected 'key:' or '}'");
+            return -1;
         }
+    } else if (token->type != YAML_TOKEN_KEY || token->column != map->column) {
+        map->done = true;
+        return 0;
     }
 
-    return true;
+    *key = *token;
+    advance(parser);
+    return 1;
 }
 
 /**
  * @brief Parse inputs section
  */
 static bool parse_inputs_section(yaml_parser_t *parser, yaml_document_t *document) {
-    skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-
-    while (parser->position < parser->input_length) {
-        skip_comments(parser->input_text, &parser->position, parser->input_length);
-        skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-
-        // Check for end of section (next top-level key or end)
-        if (parser->position < parser->input_length) {
-            const char *line_start = &parser->input_text[parser->position];
-            if (line_start[0] != ' ' && line_start[0] != '\t' &&
-                line_start[0] != '\n' && line_start[0] != '\r') {
-                // Check if this is a top-level key
-                if (strstr(line_start, "pipeline:") == line_start ||
-                    strstr(line_start, "report:") == line_start) {
-                    break;
-                }
-            }
-        }
-
-        if (parser->position >= parser->input_length ||
-            parser->input_text[parser->position] != '-') {
-            break;
-        }
+    while (parser->token.type == YAML_TOKEN_ENTRY) {
+        yaml_token_t entry = parser->token;
+        advance(parser);
 
-        parser->position++; // Skip '-'
-        skip_whitespace(parser->input_text, &parser->position, parser->input_length);
+        yaml_input_t *input = yaml_add_input(document);
+        if (!input) return out_of_memory(parser);
 
-        if (document->input_count >= 16) {
-            snprintf(parser->error_message, sizeof(parser->error_message),
-                    "Too many inputs (maximum 16)");
-            return false;
+        // "- path" names just the file
+        if (parser->token.type == YAML_TOKEN_SCALAR && parser->token.line == entry.line) {
+            if (!read_scalar(parser, document, &entry, &input->file)) return false;
+            continue;
         }
 
-        yaml_input_t *input = &document->inputs[document->input_count++];
-
-        // Parse input mapping
-        if (parser->position < parser->input_length &&
-            parser->input_text[parser->position] == '{') {
-            parser->position++; // Skip '{'
-
-            while (parser->position < parser->input_length &&
-                   parser->input_text[parser->position] != '}') {
-                char key[64], value[256];
-
-                if (!parse_key_value(parser->input_text, &parser->position,
-                                   parser->input_length, key, sizeof(key),
-                                   value, sizeof(value))) {
-                    break;
-                }
-
-                if (strcmp(key, "file") == 0) {
-                    strcpy(input->file, value);
-                } else if (strcmp(key, "meta") == 0) {
-                    strcpy(input->meta, value);
-                } else if (strcmp(key, "format") == 0) {
-                    strcpy(input->format, value);
-                } else if (strcmp(key, "sample_rate") == 0) {
-                    input->sample_rate = (uint64_t)atoll(value);
-                } else if (strcmp(key, "frequency") == 0) {
-                    input->frequency = atof(value);
-                }
-
-                skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-                if (parser->position < parser->input_length &&
-                    parser->input_text[parser->position] == ',') {
-                    parser->position++; // Skip comma
-                }
-            }
-
-            if (parser->position < parser->input_length) {
-                parser->position++; // Skip '}'
+        yaml_map_t map;
+        yaml_token_t key;
+        int next;
+        map_open(parser, &entry, &map);
+        while ((next = map_next(parser, &map, &key)) > 0) {
+            const char *value;
+            bool ok;
+            if (span_is(&key, "file")) {
+                ok = read_scalar(parser, document, &key, &input->file);
+            } else if (span_is(&key, "meta")) {
+                ok = read_scalar(parser, document, &key, &input->meta);
+            } else if (span_is(&key, "format")) {
+                ok = read_scalar(parser, document, &key, &input->format);
+            } else if (span_is(&key, "sample_rate")) {
+                ok = read_scalar(parser, document, &key, &value);
+                if (ok) input->sample_rate = (uint64_t)strtoull(value, NULL, 10);
+            } else if (span_is(&key, "frequency")) {
+                ok = read_scalar(parser, document, &key, &value);
+                if (ok) input->frequency = atof(value);
+            } else {
+                ok = skip_value(parser, &key);
             }
+            if (!ok) return false;
         }
+        if (next < 0) return false;
     }
 
     return true;
@@ -231,161 +449,89 @@ static bool parse_inputs_section(yaml_parser_t *parser, yaml_document_t *documen
  * @brief Parse pipeline section
  */
 static bool parse_pipeline_section(yaml_parser_t *parser, yaml_document_t *document) {
-    skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-
-    while (parser->position < parser->input_length) {
-        skip_comments(parser->input_text, &parser->position, parser->input_length);
-        skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-
-        // Check for end of section
-        if (parser->position < parser->input_length) {
-            const char *line_start = &parser->input_text[parser->position];
-            if (line_start[0] != ' ' && line_start[0] != '\t' &&
-                strstr(line_start, "report:") == line_start) {
-                break;
-            }
-        }
+    while (parser->token.type == YAML_TOKEN_ENTRY) {
+        yaml_token_t entry = parser->token;
+        advance(parser);
 
-        if (parser->position >= parser->input_length ||
-            parser->input_text[parser->position] != '-') {
-            break;
-        }
-
-        parser->position++; // Skip '-'
-        skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-
-        if (document->pipeline_count >= 32) {
-            snprintf(parser->error_message, sizeof(parser->error_message),
-                    "Too many pipeline steps (maximum 32)");
-            return false;
-        }
-
-        yaml_pipeline_step_t *step = &document->pipeline[document->pipeline_count++];
+        yaml_pipeline_step_t *step = yaml_add_step(document);
+        if (!step) return out_of_memory(parser);
 
-        // Parse tool name
-        if (!parse_unquoted_string(parser->input_text, &parser->position,
-                                 parser->input_length, step->tool_name,
-                                 sizeof(step->tool_name))) {
-            return false;
+        // "- tool: { params }", "- tool:" with indented params, or "- tool"
+        yaml_token_t tool = parser->token;
+        if ((tool.type != YAML_TOKEN_KEY && tool.type != YAML_TOKEN_SCALAR) || tool.line != entry.line) {
+            return parse_error(parser, "expected a tool name");
         }
-
-        skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-
-        // Parse parameters
-        if (parser->position < parser->input_length &&
-            parser->input_text[parser->position] == ':') {
-            parser->position++; // Skip ':'
-            skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-
-            if (parser->position < parser->input_length &&
-                parser->input_text[parser->position] == '{') {
-                parser->position++; // Skip '{'
-
-                while (parser->position < parser->input_length &&
-                       parser->input_text[parser->position] != '}') {
-                    char key[64], value[256];
-
-                    if (!parse_key_value(parser->input_text, &parser->position,
-                                       parser->input_length, key, sizeof(key),
-                                       value, sizeof(value))) {
-                        break;
-                    }
-
-                    if (step->param_count < 32) {
-                        strcpy(step->params[step->param_count].key, key);
-                        strcpy(step->params[step->param_count].value, value);
-                        step->param_count++;
-                    }
-
-                    skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-                    if (parser->position < parser->input_length &&
-                        parser->input_text[parser->position] == ',') {
-                        parser->position++; // Skip comma
-                    }
-                }
-
-                if (parser->position < parser->input_length) {
-                    parser->position++; // Skip '}'
-                }
-            }
+        step->tool_name = copy_scalar(document, &tool);
+        if (!step->tool_name) return out_of_memory(parser);
+        advance(parser);
+        if (tool.type == YAML_TOKEN_SCALAR) continue;
+
+        yaml_map_t map;
+        yaml_token_t key;
+        int next;
+        map_open(parser, &tool, &map);
+        while ((next = map_next(parser, &map, &key)) > 0) {
+            const char *value;
+            if (!read_scalar(parser, document, &key, &value)) return false;
+            yaml_param_t *param = NULL;
+            if (grow_params(document, step)) param = &step->params[step->param_count];
+            if (!param || !(param->key = copy_scalar(document, &key))) return out_of_memory(parser);
+            param->value = value;
+            step->param_count++;
         }
+        if (next < 0) return false;
     }
 
     return true;
 }
 
+// Read a "true"/"false" value
+static bool read_flag(yaml_parser_t *parser, yaml_document_t *document,
+                      const yaml_token_t *key, bool *flag) {
+    const char *value;
+    if (!read_scalar(parser, document, key, &value)) return false;
+    *flag = strcmp(value, "true") == 0;
+    return true;
+}
+
 /**
  * @brief Parse report section
  */
-static bool parse_report_section(yaml_parser_t *parser, yaml_document_t *document) {
-    skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-
-    if (parser->position < parser->input_length &&
-        parser->input_text[parser->position] == '{') {
-        parser->position++; // Skip '{'
-
-        while (parser->position < parser->input_length &&
-               parser->input_text[parser->position] != '}') {
-            char key[64], value[256];
-
-            if (!parse_key_value(parser->input_text, &parser->position,
-                               parser->input_length, key, sizeof(key),
-                               value, sizeof(value))) {
-                break;
-            }
-
-            if (strcmp(key, "consolidate") == 0) {
-                // Parse nested consolidate object
-                if (parser->position < parser->input_length &&
-                    parser->input_text[parser->position] == '{') {
-                    parser->position++; // Skip '{'
-
-                    while (parser->position < parser->input_length &&
-                           parser->input_text[parser->position] != '}') {
-                        char sub_key[64], sub_value[256];
-
-                        if (!parse_key_value(parser->input_text, &parser->position,
-                                           parser->input_length, sub_key, sizeof(sub_key),
-                                           sub_value, sizeof(sub_value))) {
-                            break;
-                        }
-
-                        if (strcmp(sub_key, "events") == 0) {
-                            document->report.consolidate_events = (strcmp(sub_value, "true") == 0);
-                        } else if (strcmp(sub_key, "spectra") == 0) {
-                            document->report.consolidate_spectra = (strcmp(sub_value, "true") == 0);
-                        } else if (strcmp(sub_key, "audio") == 0) {
-                            document->report.consolidate_audio = (strcmp(sub_value, "true") == 0);
-                        }
-
-                        skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-                        if (parser->position < parser->input_length &&
-                            parser->input_text[parser->position] == ',') {
-                            parser->position++; // Skip comma
-                        }
-                    }
-
-                    if (parser->position < parser->input_length) {
-                        parser->position++; // Skip '}'
-                    }
+static bool parse_report_section(yaml_parser_t *parser, yaml_document_t *document,
+                                 const yaml_token_t *section) {
+    yaml_map_t map;
+    yaml_token_t key;
+    int next;
+    map_open(parser, section, &map);
+    while ((next = map_next(parser, &map, &key)) > 0) {
+        bool ok = true;
+        if (span_is(&key, "consolidate")) {
+            // Nested consolidate mapping
+            yaml_map_t consolidate;
+            yaml_token_t item;
+            int more;
+            map_open(parser, &key, &consolidate);
+            while (ok && (more = map_next(parser, &consolidate, &item)) > 0) {
+                if (span_is(&item, "events")) {
+                    ok = read_flag(parser, document, &item, &document->report.consolidate_events);
+                } else if (span_is(&item, "spectra")) {
+                    ok = read_flag(parser, document, &item, &document->report.consolidate_spectra);
+                } else if (span_is(&item, "audio")) {
+                    ok = read_flag(parser, document, &item, &document->report.consolidate_audio);
+                } else {
+                    ok = skip_value(parser, &item);
                 }
-            } else if (strcmp(key, "output_dir") == 0) {
-                strcpy(document->report.output_dir, value);
-            }
-
-            skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-            if (parser->position < parser->input_length &&
-                parser->input_text[parser->position] == ',') {
-                parser->position++; // Skip comma
             }
+            if (more < 0) return false;
+        } else if (span_is(&key, "output_dir")) {
+            ok = read_scalar(parser, document, &key, &document->report.output_dir);
+        } else {
+            ok = skip_value(parser, &key);
         }
-
-        if (parser->position < parser->input_length) {
-            parser->position++; // Skip '}'
-        }
+        if (!ok) return false;
     }
 
-    return true;
+    return next == 0;
 }
 
 /**
@@ -398,9 +544,8 @@ bool yaml_parser_init(yaml_parser_t *parser, const char *yaml_text, size_t text_
 
     parser->input_text = yaml_text;
     parser->input_length = text_length;
-    parser->position = 0;
-    parser->line_number = 1;
-    parser->indent_level = 0;
+    yaml_tokenizer_init(&parser->tokenizer, yaml_text, text_length);
+    memset(&parser->token, 0, sizeof(parser->token));
     parser->error_message[0] = '\0';
 
     return true;
@@ -416,48 +561,32 @@ bool yaml_parse_document(yaml_parser_t *parser, yaml_document_t *document) {
 
     // Initialize document
     memset(document, 0, sizeof(yaml_document_t));
+    document->report.output_dir = EMPTY;
 
     // Parse sections
-    while (parser->position < parser->input_length) {
-        skip_whitespace(parser->input_text, &parser->position, parser->input_length);
-        skip_comments(parser->input_text, &parser->position, parser->input_length);
-
-        if (parser->position >= parser->input_length) {
+    bool ok = true;
+    advance(parser);
+    while (ok && parser->token.type != YAML_TOKEN_END) {
+        yaml_token_t section = parser->token;
+        if (section.type != YAML_TOKEN_KEY || section.column != 0) {
+            ok = parse_error(parser, section.type == YAML_TOKEN_ERROR ? "" : "expected a top-level key");
             break;
         }
-
-        // Check for section headers
-        if (strstr(&parser->input_text[parser->position], "inputs:") ==
-            &parser->input_text[parser->position]) {
-            parser->position += 7; // Skip "inputs:"
-            if (!parse_inputs_section(parser, document)) {
-                return false;
-            }
-        } else if (strstr(&parser->input_text[parser->position], "pipeline:") ==
-                   &parser->input_text[parser->position]) {
-            parser->position += 9; // Skip "pipeline:"
-            if (!parse_pipeline_section(parser, document)) {
-                return false;
-            }
-        } else if (strstr(&parser->input_text[parser->position], "report:") ==
-                   &parser->input_text[parser->position]) {
-            parser->position += 7; // Skip "report:"
-            if (!parse_report_section(parser, document)) {
-                return false;
-            }
+        advance(parser);
+
+        if (span_is(&section, "inputs")) {
+            ok = parse_inputs_section(parser, document);
+        } else if (span_is(&section, "pipeline")) {
+            ok = parse_pipeline_section(parser, document);
+        } else if (span_is(&section, "report")) {
+            ok = parse_report_section(parser, document, &section);
         } else {
-            // Skip unknown lines
-            while (parser->position < parser->input_length &&
-                   parser->input_text[parser->position] != '\n') {
-                parser->position++;
-            }
-            if (parser->position < parser->input_length) {
-                parser->position++;
-            }
+            ok = skip_value(parser, &section);  // Unknown section
         }
     }
 
-    return true;
+    if (!ok) yaml_free_document(document);
+    return ok;
 }
 
 /**
@@ -501,7 +630,7 @@ bool yaml_load_file(const char *filename, yaml_document_t *document) {
     buffer[bytes_read] = '\0';
     fclose(file);
 
-    // Parse YAML
+    // Parse YAML (the document keeps copies; the text can go)
     yaml_parser_t parser;
     if (!yaml_parser_init(&parser, buffer, bytes_read)) {
         free(buffer);
@@ -509,6 +638,7 @@ bool yaml_load_file(const char *filename, yaml_document_t *document) {
     }
 
     bool success = yaml_parse_document(&parser, document);
+    if (!success) fprintf(stderr, "%s: %s\n", filename, yaml_parser_get_error(&parser));
     free(buffer);
 
     return success;
@@ -559,10 +689,176 @@ void yaml_free_document(yaml_document_t *document) {
         return;
     }
 
-    // Nothing to free currently - all data is stored inline
+    free(document->inputs);
+    free(document->pipeline);
+    while (document->arena) {
+        yaml_arena_block_t *older = document->arena->next;
+        free(document->arena);
+        document->arena = older;
+    }
     memset(document, 0, sizeof(yaml_document_t));
 }
 
+// Make room for one more element of a growing array
+static bool grow_array(void **items, uint32_t *capacity, uint32_t count, size_t item_size) {
+    if (count < *capacity) return true;
+
+    uint32_t grown = *capacity ? 2 * *capacity : YAML_INITIAL_CAPACITY;
+    void *resized = realloc(*items, (size_t)grown * item_size);
+    if (!resized) return false;
+    *items = resized;
+    *capacity = grown;
+    return true;
+}
+
+/**
+ * @brief Append a zeroed input
+ */
+yaml_input_t *yaml_add_input(yaml_document_t *document) {
+    if (!document || !grow_array((void **)&document->inputs, &document->input_capacity,
+                                 document->input_count, sizeof(yaml_input_t))) {
+        return NULL;
+    }
+
+    yaml_input_t *input = &document->inputs[document->input_count++];
+    memset(input, 0, sizeof(*input));
+    input->file = input->meta = input->format = EMPTY;
+    return input;
+}
+
+/**
+ * @brief Append a zeroed pipeline step
+ */
+yaml_pipeline_step_t *yaml_add_step(yaml_document_t *document) {
+    if (!document || !grow_array((void **)&document->pipeline, &document->pipeline_capacity,
+                                 document->pipeline_count, sizeof(yaml_pipeline_step_t))) {
+        return NULL;
+    }
+
+    yaml_pipeline_step_t *step = &document->pipeline[document->pipeline_count++];
+    memset(step, 0, sizeof(*step));
+    step->tool_name = step->output_dir = EMPTY;
+    return step;
+}
+
+static bool is_glob_pattern(const char *path) {
+    return strpbrk(path, "*?[") != NULL;
+}
+
+// Append one expanded input copied from its pattern entry (its path owned
+// by the document being expanded)
+static bool add_match(yaml_document_t *document, yaml_document_t *expanded,
+                      const yaml_input_t *pattern, const char *path) {
+    const char *file = yaml_copy_string(document, path);
+    yaml_input_t *input = file ? yaml_add_input(expanded) : NULL;
+    if (!input) return false;
+    *input = *pattern;
+    input->file = file;
+    input->meta = EMPTY;
+    return true;
+}
+
+#ifdef _WIN32
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+#endif
+
+// Append the files matching a pattern entry in name order; false if none
+static bool add_matches(yaml_document_t *document, yaml_document_t *expanded,
+                        const yaml_input_t *pattern) {
+    bool ok = true;
+    uint32_t before = expanded->input_count;
+#ifdef _WIN32
+    // Wildcards only in the last component; keep the directory part
+    const char *slash = strrchr(pattern->file, '\\');
+    const char *fwd = strrchr(pattern->file, '/');
+    if (!slash || (fwd && fwd > slash)) slash = fwd;
+    int dir_len = slash ? (int)(slash - pattern->file + 1) : 0;
+
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA(pattern->file, &found);
+    char **names = NULL;
+    uint32_t count = 0, capacity = 0;
+    if (search != INVALID_HANDLE_VALUE) {
+        do {
+            if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            if (!grow_array((void **)&names, &capacity, count, sizeof(char *))) {
+                ok = false;
+                break;
+            }
+            size_t size = (size_t)dir_len + strlen(found.cFileName) + 1;
+            names[count] = (char *)malloc(size);
+            if (!names[count]) {
+                ok = false;
+                break;
+            }
+            snprintf(names[count], size, "%.*s%s", dir_len, pattern->file, found.cFileName);
+            count++;
+        } while (FindNextFileA(search, &found));
+        FindClose(search);
+    }
+    qsort(names, count, sizeof(char *), compare_names);
+    for (uint32_t i = 0; i < count; i++) {
+        if (ok) ok = add_match(document, expanded, pattern, names[i]);
+        free(names[i]);
+    }
+    free(names);
+#else
+    glob_t matches;
+    int status = glob(pattern->file, 0, NULL, &matches);
+    if (status == 0) {
+        for (size_t i = 0; ok && i < matches.gl_pathc; i++) {
+            ok = add_match(document, expanded, pattern, matches.gl_pathv[i]);
+        }
+        globfree(&matches);
+    } else if (status != GLOB_NOMATCH) {
+        ok = false;
+    }
+#endif
+    if (ok && expanded->input_count == before) {
+        fprintf(stderr, "Input pattern '%s' matches no files\n", pattern->file);
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief Replace glob-pattern inputs by the files they match
+ */
+bool yaml_expand_inputs(yaml_document_t *document) {
+    if (!document) return false;
+
+    bool any = false;
+    for (uint32_t i = 0; i < document->input_count && !any; i++) {
+        any = is_glob_pattern(document->inputs[i].file);
+    }
+    if (!any) return true;
+
+    yaml_document_t expanded = {0};
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < document->input_count; i++) {
+        const yaml_input_t *input = &document->inputs[i];
+        if (is_glob_pattern(input->file)) {
+            ok = add_matches(document, &expanded, input);
+        } else {
+            yaml_input_t *copy = yaml_add_input(&expanded);
+            ok = copy != NULL;
+            if (ok) *copy = *input;
+        }
+    }
+    if (!ok) {
+        free(expanded.inputs);
+        return false;
+    }
+
+    free(document->inputs);
+    document->inputs = expanded.inputs;
+    document->input_count = expanded.input_count;
+    document->input_capacity = expanded.input_capacity;
+    return true;
+}
+
 /**
  * @brief Get string representation of YAML document
  */
@@ -653,13 +949,16 @@ const char *yaml_get_step_param(const yaml_pipeline_step_t *step, const char *ke
 /**
  * @brief Set pipeline step parameter
  */
-bool yaml_set_step_param(yaml_pipeline_step_t *step, const char *key, const char *value) {
-    if (!step || !key || !value || step->param_count >= 32) {
+bool yaml_set_step_param(yaml_document_t *document, yaml_pipeline_step_t *step,
+                         const char *key, const char *value) {
+    if (!document || !step || !key || !value || !grow_params(document, step)) {
         return false;
     }
 
-    strcpy(step->params[step->param_count].key, key);
-    strcpy(step->params[step->param_count].value, value);
+    yaml_param_t *param = &step->params[step->param_count];
+    param->key = yaml_copy_string(document, key);
+    param->value = yaml_copy_string(document, value);
+    if (!param->key || !param->value) return false;
     step->param_count++;
 
     return true;
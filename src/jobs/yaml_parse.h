@@ -11,10 +11,27 @@
  *   inputs:
  *     - file: data/capture.iq
  *       meta: data/capture.sigmf-meta
+ *     - data/other.iq                  (just the file)
  *   pipeline:
  *     - tool_name: { param1: value1, param2: value2 }
+ *     - tool_name:                      (block form)
+ *         param1: value1
  *   report:
  *     consolidate: { events: true, spectra: true }
+ *
+ * Mappings may be written in flow ({ k: v, ... }) or block (indented
+ * "k: v" lines) form, and scalars plain, "double" (with \\ \" \n \t
+ * escapes) or 'single' quoted. Values containing '{', ',' or ": " must be
+ * quoted.
+ *
+ * Parsing is one pass: a tokenizer walks the text once, returning spans
+ * of it (never copying), and the parser consumes those tokens in order.
+ * Every string and parameter list of the document lives in one arena owned
+ * by the document, so nothing has a fixed size. Inputs and pipeline steps
+ * are arrays grown as they are parsed (yaml_add_input / yaml_add_step);
+ * yaml_free_document releases all of it. A file entry containing '*', '?'
+ * or '[' is a glob pattern, replaced by the files it matches in name order
+ * (yaml_expand_inputs).
  */
 
 #ifndef YAML_PARSE_H
@@ -22,6 +39,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // Forward declarations
 typedef struct yaml_parser_t yaml_parser_t;
@@ -30,14 +48,72 @@ typedef struct yaml_node_t yaml_node_t;
 typedef struct yaml_input_t yaml_input_t;
 typedef struct yaml_pipeline_step_t yaml_pipeline_step_t;
 typedef struct yaml_report_config_t yaml_report_config_t;
+typedef struct yaml_param_t yaml_param_t;
+typedef struct yaml_token_t yaml_token_t;
+typedef struct yaml_tokenizer_t yaml_tokenizer_t;
+typedef struct yaml_arena_block_t yaml_arena_block_t;
+
+/**
+ * @brief Span of the source text (not NUL-terminated)
+ */
+typedef struct {
+    const char *start;
+    size_t length;
+} yaml_span_t;
+
+/**
+ * @brief Token types
+ */
+typedef enum {
+    YAML_TOKEN_END,         // End of text
+    YAML_TOKEN_KEY,         // Scalar followed by ':' (the span excludes the ':')
+    YAML_TOKEN_SCALAR,      // Plain or quoted scalar (quotes excluded)
+    YAML_TOKEN_ENTRY,       // Block sequence entry '-'
+    YAML_TOKEN_FLOW_START,  // '{'
+    YAML_TOKEN_FLOW_END,    // '}'
+    YAML_TOKEN_COMMA,       // ',' inside a flow mapping
+    YAML_TOKEN_ERROR        // Malformed text (see the tokenizer error)
+} yaml_token_type_t;
+
+/**
+ * @brief Token: a span of the source and where it starts
+ */
+struct yaml_token_t {
+    yaml_token_type_t type;
+    yaml_span_t text;       // Token text (quotes and ':' excluded)
+    char quote;             // '"' or '\'' for quoted scalars, else 0
+    uint32_t line;          // 1-based line
+    uint32_t column;        // 0-based column (the indentation of block items)
+};
+
+/**
+ * @brief Tokenizer state
+ */
+struct yaml_tokenizer_t {
+    const char *text;
+    size_t length;
+    size_t position;
+    size_t line_start;      // Offset of the current line
+    uint32_t line;
+    uint32_t flow_depth;    // Open '{' mappings
+    const char *error;      // Set with YAML_TOKEN_ERROR
+};
+
+/**
+ * @brief YAML Parameter (key and value)
+ */
+struct yaml_param_t {
+    const char *key;
+    const char *value;
+};
 
 /**
  * @brief YAML Input Configuration
  */
 struct yaml_input_t {
-    char file[256];         // Input file path
-    char meta[256];         // Metadata file path (optional)
-    char format[16];        // Data format (optional)
+    const char *file;       // Input file path
+    const char *meta;       // Metadata file path ("" if not given)
+    const char *format;     // Data format ("" if not given)
     uint64_t sample_rate;   // Sample rate (optional)
     double frequency;       // Center frequency (optional)
 };
@@ -46,15 +122,13 @@ struct yaml_input_t {
  * @brief YAML Pipeline Step Configuration
  */
 struct yaml_pipeline_step_t {
-    char tool_name[64];     // Tool name (iqls, iqdetect, etc.)
-    char output_dir[256];   // Output directory for this step
-
-    // Tool-specific parameters (key-value pairs)
-    struct {
-        char key[64];
-        char value[256];
-    } params[32];           // Up to 32 parameters per step
+    const char *tool_name;  // Tool name (iqls, iqdetect, etc.)
+    const char *output_dir; // Output directory for this step ("" if none)
+
+    // Tool-specific parameters, in document order (in the document's arena)
+    yaml_param_t *params;
     uint32_t param_count;
+    uint32_t param_capacity;
 };
 
 /**
@@ -64,7 +138,7 @@ struct yaml_report_config_t {
     bool consolidate_events;
     bool consolidate_spectra;
     bool consolidate_audio;
-    char output_dir[256];
+    const char *output_dir; // "" if not given
 };
 
 /**
@@ -72,15 +146,20 @@ struct yaml_report_config_t {
  */
 struct yaml_document_t {
     // Inputs section
-    yaml_input_t inputs[16];        // Up to 16 input files
+    yaml_input_t *inputs;           // Input files (grown by yaml_add_input)
     uint32_t input_count;
+    uint32_t input_capacity;
 
     // Pipeline section
-    yaml_pipeline_step_t pipeline[32];  // Up to 32 pipeline steps
+    yaml_pipeline_step_t *pipeline; // Pipeline steps (grown by yaml_add_step)
     uint32_t pipeline_count;
+    uint32_t pipeline_capacity;
 
     // Report section
     yaml_report_config_t report;
+
+    // Strings and parameter lists (released by yaml_free_document)
+    yaml_arena_block_t *arena;
 };
 
 /**
@@ -89,12 +168,32 @@ struct yaml_document_t {
 struct yaml_parser_t {
     const char *input_text;     // Input YAML text
     size_t input_length;        // Length of input text
-    size_t position;            // Current parsing position
-    uint32_t line_number;       // Current line number for error reporting
-    uint32_t indent_level;      // Current indentation level
+    yaml_tokenizer_t tokenizer; // Position in the text
+    yaml_token_t token;         // Next token (one-token lookahead)
     char error_message[256];    // Error message buffer
 };
 
+/**
+ * @brief Start tokenizing a text
+ *
+ * @param tokenizer Tokenizer to initialize
+ * @param text YAML text (must outlive the tokens)
+ * @param length Length of the text
+ */
+void yaml_tokenizer_init(yaml_tokenizer_t *tokenizer, const char *text, size_t length);
+
+/**
+ * @brief Read the next token
+ *
+ * Comments and blank space are skipped. Each call advances past the
+ * returned token; YAML_TOKEN_END repeats once the text is consumed.
+ *
+ * @param tokenizer Tokenizer
+ * @param token Receives the token
+ * @return The token type
+ */
+yaml_token_type_t yaml_next_token(yaml_tokenizer_t *tokenizer, yaml_token_t *token);
+
 /**
  * @brief Initialize YAML parser
  *
@@ -146,6 +245,45 @@ bool yaml_validate_document(const yaml_document_t *document);
  */
 void yaml_free_document(yaml_document_t *document);
 
+/**
+ * @brief Copy a string into a document's arena
+ *
+ * @param document Document that will own the copy
+ * @param text String to copy
+ * @return The copy (valid until yaml_free_document), NULL if memory ran out
+ */
+const char *yaml_copy_string(yaml_document_t *document, const char *text);
+
+/**
+ * @brief Append an input to a document
+ *
+ * All its strings are empty; assign file (and meta, format) from strings
+ * that outlive the document, e.g. yaml_copy_string copies.
+ *
+ * @param document Document (zero-initialized or parsed)
+ * @return The new input, or NULL if memory ran out
+ */
+yaml_input_t *yaml_add_input(yaml_document_t *document);
+
+/**
+ * @brief Append a pipeline step without parameters to a document
+ *
+ * @param document Document (zero-initialized or parsed)
+ * @return The new step, or NULL if memory ran out
+ */
+yaml_pipeline_step_t *yaml_add_step(yaml_document_t *document);
+
+/**
+ * @brief Replace glob-pattern inputs by the files they match
+ *
+ * Each match inherits the pattern entry's format, sample rate and
+ * frequency; its metadata path is left empty (found next to the file).
+ *
+ * @param document Document whose inputs to expand
+ * @return true on success, false if a pattern matches nothing or memory ran out
+ */
+bool yaml_expand_inputs(yaml_document_t *document);
+
 /**
  * @brief Get string representation of YAML document
  *
@@ -169,11 +307,16 @@ const char *yaml_get_step_param(const yaml_pipeline_step_t *step, const char *ke
 /**
  * @brief Helper function to set pipeline step parameter
  *
+ * Appends the parameter; key and value are copied into the document's
+ * arena.
+ *
+ * @param document Document owning the step
  * @param step Pointer to pipeline step
  * @param key Parameter key
  * @param value Parameter value
- * @return true on success, false on error (too many parameters)
+ * @return true on success, false on error (out of memory)
  */
-bool yaml_set_step_param(yaml_pipeline_step_t *step, const char *key, const char *value);
+bool yaml_set_step_param(yaml_document_t *document, yaml_pipeline_step_t *step,
+                         const char *key, const char *value);
 
 #endif /* YAML_PARSE_H */
@@ -0,0 +1,569 @@
+/*
+ * IQ Lab - Embeddable Library Implementation
+ *
+ * Each handle wraps the module the tools use for the same stage, so the
+ * library's rows, detections and events are the tools' own:
+ * - reader: iq_reader_t
+ * - stft: fft_spectral_frame_f64 over a carried partial frame. Frames that
+ *   lie whole in the caller's buffer are transformed in place; only a
+ *   frame straddling two buffers is staged in the handle.
+ * - cfar: cfar_os_t or cfar_ca_t
+ * - cluster: cluster_t with an event sink that queues closed events
+ * - pfb: pfb_t, its rings read and committed by iqlab_pfb_read
+ * - demod: fm_demod_t, am_demod_t or ssb_demod_t
+ */
+
+#include "iqlab.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+#include "../iq_core/io_iq.h"
+#include "../iq_core/fft.h"
+#include "../iq_core/window.h"
+#include "../detect/cfar_os.h"
+#include "../detect/cfar_ca.h"
+#include "../detect/cluster.h"
+#include "../chan/pfb.h"
+#include "../demod/fm.h"
+#include "../demod/am.h"
+#include "../demod/ssb.h"
+
+#define IQLAB_STRINGIFY(x) #x
+#define IQLAB_VERSION_TEXT(major, minor, patch) \
+    IQLAB_STRINGIFY(major) "." IQLAB_STRINGIFY(minor) "." IQLAB_STRINGIFY(patch)
+
+// Largest count passed to the modules' 32-bit entry points at once
+#define IQLAB_CHUNK_SAMPLES (1u << 20)
+
+uint32_t iqlab_version(void) {
+    return IQLAB_VERSION;
+}
+
+const char *iqlab_version_string(void) {
+    return IQLAB_VERSION_TEXT(IQLAB_VERSION_MAJOR, IQLAB_VERSION_MINOR, IQLAB_VERSION_PATCH);
+}
+
+const char *iqlab_status_string(iqlab_status_t status) {
+    switch (status) {
+        case IQLAB_OK: return "ok";
+        case IQLAB_ERROR_ARGUMENT: return "invalid argument";
+        case IQLAB_ERROR_MEMORY: return "out of memory";
+        case IQLAB_ERROR_IO: return "I/O error";
+        case IQLAB_ERROR_EMPTY: return "nothing to return";
+    }
+    return "unknown status";
+}
+
+/* ---------------------------------------------------------------- Readers */
+
+struct iqlab_reader {
+    iq_reader_t reader;
+};
+
+iqlab_status_t iqlab_reader_open(const char *path, const char *format, iqlab_reader_t **reader) {
+    if (!path || !reader) return IQLAB_ERROR_ARGUMENT;
+    *reader = NULL;
+
+    iq_format_t parsed = IQ_FORMAT_S16;
+    if (format && !iq_parse_format(format, &parsed)) return IQLAB_ERROR_ARGUMENT;
+
+    iqlab_reader_t *handle = calloc(1, sizeof(*handle));
+    if (!handle) return IQLAB_ERROR_MEMORY;
+    bool opened = format ? iq_reader_init(&handle->reader, path, parsed) :
+                           iq_reader_open(&handle->reader, path);
+    if (!opened) {
+        free(handle);
+        return IQLAB_ERROR_IO;
+    }
+    *reader = handle;
+    return IQLAB_OK;
+}
+
+iqlab_status_t iqlab_reader_info(const iqlab_reader_t *reader, iqlab_reader_info_t *info) {
+    if (!reader || !info) return IQLAB_ERROR_ARGUMENT;
+    info->sample_rate = reader->reader.sample_rate;
+    info->sample_bits = iq_format_bits(reader->reader.format);
+    info->total_samples = reader->reader.total_samples;
+    info->live = reader->reader.stream != NULL;
+    return IQLAB_OK;
+}
+
+iqlab_status_t iqlab_reader_read(iqlab_reader_t *reader, float *iq, size_t max_samples, size_t *samples) {
+    if (!reader || !samples || (!iq && max_samples > 0)) return IQLAB_ERROR_ARGUMENT;
+    *samples = max_samples > 0 ? iq_read_samples(&reader->reader, iq, max_samples) : 0;
+    return IQLAB_OK;
+}
+
+iqlab_status_t iqlab_reader_seek(iqlab_reader_t *reader, uint64_t sample) {
+    if (!reader) return IQLAB_ERROR_ARGUMENT;
+    return iq_reader_seek_sample(&reader->reader, sample) ? IQLAB_OK : IQLAB_ERROR_IO;
+}
+
+void iqlab_reader_close(iqlab_reader_t *reader) {
+    if (!reader) return;
+    iq_reader_close(&reader->reader);
+    free(reader);
+}
+
+/* ------------------------------------------------------------------- STFT */
+
+struct iqlab_stft {
+    fft_plan_f32_t *plan;
+    const window_t *window;      // NULL for rectangular
+    uint32_t fft_size;
+    uint32_t hop_size;
+    float *frame;                // Partial frame carried between buffers (2 * fft_size)
+    size_t held;                 // Samples of it held
+    size_t skip;                 // Samples still to drop before the next frame (hop > fft_size)
+};
+
+iqlab_status_t iqlab_stft_create(uint32_t fft_size, uint32_t hop_size, const char *window,
+                                 iqlab_stft_t **stft) {
+    if (!stft) return IQLAB_ERROR_ARGUMENT;
+    *stft = NULL;
+
+    window_type_t type = WINDOW_RECTANGULAR;
+    if (fft_size < 2 || hop_size == 0 || (window && !window_type_from_name(window, &type))) {
+        return IQLAB_ERROR_ARGUMENT;
+    }
+
+    iqlab_stft_t *handle = calloc(1, sizeof(*handle));
+    if (!handle) return IQLAB_ERROR_MEMORY;
+    handle->fft_size = fft_size;
+    handle->hop_size = hop_size;
+    handle->plan = fft_plan_f32_acquire(fft_size, FFT_FORWARD);
+    handle->frame = malloc(2 * (size_t)fft_size * sizeof(float));
+    if (type != WINDOW_RECTANGULAR) {
+        double param = type == WINDOW_KAISER ? WINDOW_KAISER_DEFAULT_BETA : 0.0;
+        handle->window = window_acquire(type, fft_size, param);
+    }
+    if (!handle->plan || !handle->frame || (type != WINDOW_RECTANGULAR && !handle->window)) {
+        iqlab_stft_destroy(handle);
+        return IQLAB_ERROR_MEMORY;
+    }
+    *stft = handle;
+    return IQLAB_OK;
+}
+
+size_t iqlab_stft_max_rows(const iqlab_stft_t *stft, size_t samples) {
+    if (!stft || samples <= stft->skip) return 0;
+    size_t available = stft->held + samples - stft->skip;
+    return available < stft->fft_size ? 0 : (available - stft->fft_size) / stft->hop_size + 1;
+}
+
+iqlab_status_t iqlab_stft_process(iqlab_stft_t *stft, const float *iq, size_t samples,
+                                  double *rows, size_t max_rows, size_t *num_rows) {
+    if (!stft || !num_rows || (!iq && samples > 0)) return IQLAB_ERROR_ARGUMENT;
+    size_t expected = iqlab_stft_max_rows(stft, samples);
+    if (expected > max_rows || (expected > 0 && !rows)) return IQLAB_ERROR_ARGUMENT;
+
+    const size_t fft_size = stft->fft_size, hop = stft->hop_size;
+    const float *window = stft->window ? stft->window->coefficients_f32 : NULL;
+    size_t produced = 0;
+    size_t pos = 0;
+    while (pos < samples) {
+        if (stft->skip > 0) {
+            size_t n = samples - pos < stft->skip ? samples - pos : stft->skip;
+            pos += n;
+            stft->skip -= n;
+            continue;
+        }
+
+        // A whole frame in the caller's buffer: transform it where it is
+        if (stft->held == 0 && samples - pos >= fft_size) {
+            if (!fft_spectral_frame_f64(stft->plan, iq + 2 * pos, window, rows + produced * fft_size, false)) {
+                return IQLAB_ERROR_MEMORY;
+            }
+            produced++;
+            if (hop <= samples - pos) {
+                pos += hop;
+            } else {
+                stft->skip = hop - (samples - pos);
+                pos = samples;
+            }
+            continue;
+        }
+
+        // Otherwise stage the frame, carrying the overlap to the next one
+        size_t n = fft_size - stft->held;
+        if (n > samples - pos) n = samples - pos;
+        memcpy(stft->frame + 2 * stft->held, iq + 2 * pos, 2 * n * sizeof(float));
+        stft->held += n;
+        pos += n;
+        if (stft->held < fft_size) break;
+
+        if (!fft_spectral_frame_f64(stft->plan, stft->frame, window, rows + produced * fft_size, false)) {
+            return IQLAB_ERROR_MEMORY;
+        }
+        produced++;
+        if (hop < fft_size) {
+            // Frames still starting inside the staged samples keep being staged
+            memmove(stft->frame, stft->frame + 2 * hop, 2 * (fft_size - hop) * sizeof(float));
+            stft->held = fft_size - hop;
+        } else {
+            stft->held = 0;
+            stft->skip = hop - fft_size;
+        }
+    }
+
+    *num_rows = produced;
+    return IQLAB_OK;
+}
+
+void iqlab_stft_reset(iqlab_stft_t *stft) {
+    if (!stft) return;
+    stft->held = 0;
+    stft->skip = 0;
+}
+
+void iqlab_stft_destroy(iqlab_stft_t *stft) {
+    if (!stft) return;
+    if (stft->plan) fft_plan_f32_release(stft->plan);
+    window_release(stft->window);
+    free(stft->frame);
+    free(stft);
+}
+
+/* ------------------------------------------------------------------- CFAR */
+
+struct iqlab_cfar {
+    bool ordered;                // OS-CFAR, else mean level
+    cfar_os_t os;
+    cfar_ca_t ca;
+    cfar_detection_t *detections; // Module output, converted to iqlab_detection_t
+    uint32_t capacity;
+};
+
+iqlab_status_t iqlab_cfar_create(const char *kind, uint32_t fft_size, double pfa,
+                                 uint32_t ref_cells, uint32_t guard_cells, uint32_t os_rank,
+                                 iqlab_cfar_t **cfar) {
+    if (!kind || !cfar) return IQLAB_ERROR_ARGUMENT;
+    *cfar = NULL;
+
+    bool ordered = strcmp(kind, "os") == 0;
+    cfar_mode_t mode = CFAR_MODE_CA;
+    if (!ordered && !cfar_mode_from_name(kind, &mode)) return IQLAB_ERROR_ARGUMENT;
+    if (ordered ? !cfar_os_validate_params(fft_size, pfa, ref_cells, guard_cells, os_rank) :
+                  !cfar_ca_validate_params(fft_size, pfa, ref_cells, guard_cells)) {
+        return IQLAB_ERROR_ARGUMENT;
+    }
+
+    iqlab_cfar_t *handle = calloc(1, sizeof(*handle));
+    if (!handle) return IQLAB_ERROR_MEMORY;
+    handle->ordered = ordered;
+    bool ok = ordered ? cfar_os_init(&handle->os, fft_size, pfa, ref_cells, guard_cells, os_rank) :
+                        cfar_ca_init(&handle->ca, fft_size, pfa, ref_cells, guard_cells, mode);
+    if (!ok) {
+        free(handle);
+        return IQLAB_ERROR_MEMORY;
+    }
+    *cfar = handle;
+    return IQLAB_OK;
+}
+
+iqlab_status_t iqlab_cfar_process(iqlab_cfar_t *cfar, const double *row,
+                                  iqlab_detection_t *detections, uint32_t max_detections,
+                                  uint32_t *num_detections) {
+    if (!cfar || !row || !num_detections || (!detections && max_detections > 0)) {
+        return IQLAB_ERROR_ARGUMENT;
+    }
+    if (max_detections > cfar->capacity) {
+        cfar_detection_t *grown = realloc(cfar->detections, max_detections * sizeof(*grown));
+        if (!grown) return IQLAB_ERROR_MEMORY;
+        cfar->detections = grown;
+        cfar->capacity = max_detections;
+    }
+
+    uint32_t count = max_detections == 0 ? 0 :
+                     cfar->ordered ? cfar_os_process_frame(&cfar->os, row, cfar->detections, max_detections) :
+                     cfar_ca_process_frame(&cfar->ca, row, cfar->detections, max_detections);
+    for (uint32_t i = 0; i < count; i++) {
+        const cfar_detection_t *d = &cfar->detections[i];
+        detections[i].bin = d->bin_index;
+        detections[i].power_db = d->signal_power;
+        detections[i].threshold_db = d->threshold;
+        detections[i].snr_db = d->snr_estimate;
+        detections[i].confidence = d->confidence;
+    }
+    *num_detections = count;
+    return IQLAB_OK;
+}
+
+void iqlab_cfar_destroy(iqlab_cfar_t *cfar) {
+    if (!cfar) return;
+    if (cfar->ordered) {
+        cfar_os_free(&cfar->os);
+    } else {
+        cfar_ca_free(&cfar->ca);
+    }
+    free(cfar->detections);
+    free(cfar);
+}
+
+/* ------------------------------------------------------------- Clustering */
+
+struct iqlab_cluster {
+    cluster_t cluster;
+    iqlab_event_t *events;       // Closed events not taken yet, from events[head]
+    size_t head;
+    size_t count;
+    size_t capacity;
+    bool failed;                 // An event could not be queued
+};
+
+// Cluster event sink: queue each closed event for iqlab_cluster_next_event
+static void iqlab_queue_event(const cluster_event_t *event, void *user) {
+    iqlab_cluster_t *handle = user;
+    if (handle->count == handle->capacity) {
+        if (handle->head > 0) {
+            memmove(handle->events, handle->events + handle->head,
+                    (handle->count - handle->head) * sizeof(*handle->events));
+            handle->count -= handle->head;
+            handle->head = 0;
+        } else {
+            size_t capacity = handle->capacity ? 2 * handle->capacity : 64;
+            iqlab_event_t *grown = realloc(handle->events, capacity * sizeof(*grown));
+            if (!grown) {
+                handle->failed = true;
+                return;
+            }
+            handle->events = grown;
+            handle->capacity = capacity;
+        }
+    }
+
+    iqlab_event_t *out = &handle->events[handle->count++];
+    out->start_time_s = event->start_time_s;
+    out->end_time_s = event->end_time_s;
+    out->center_freq_hz = event->center_freq_hz;
+    out->bandwidth_hz = event->bandwidth_hz;
+    out->peak_snr_db = event->peak_snr_db;
+    out->avg_snr_db = event->avg_snr_db;
+    out->peak_power_dbfs = event->peak_power_dbfs;
+    out->num_detections = event->num_detections;
+    out->confidence = event->confidence;
+    out->modulation = event->modulation_guess ? event->modulation_guess : "unknown";
+}
+
+iqlab_status_t iqlab_cluster_create(double sample_rate, double max_time_gap_ms,
+                                    double max_freq_gap_hz, uint32_t max_clusters,
+                                    iqlab_cluster_t **cluster) {
+    if (!cluster) return IQLAB_ERROR_ARGUMENT;
+    *cluster = NULL;
+    if (!cluster_validate_params(max_time_gap_ms, max_freq_gap_hz, max_clusters, sample_rate)) {
+        return IQLAB_ERROR_ARGUMENT;
+    }
+
+    iqlab_cluster_t *handle = calloc(1, sizeof(*handle));
+    if (!handle) return IQLAB_ERROR_MEMORY;
+    if (!cluster_init(&handle->cluster, max_time_gap_ms, max_freq_gap_hz, max_clusters, sample_rate)) {
+        free(handle);
+        return IQLAB_ERROR_MEMORY;
+    }
+    cluster_set_event_sink(&handle->cluster, iqlab_queue_event, handle);
+    *cluster = handle;
+    return IQLAB_OK;
+}
+
+iqlab_status_t iqlab_cluster_add(iqlab_cluster_t *cluster, const iqlab_detection_t *detections,
+                                 uint32_t num_detections, double time_s) {
+    if (!cluster || (!detections && num_detections > 0) || !isfinite(time_s)) {
+        return IQLAB_ERROR_ARGUMENT;
+    }
+
+    for (uint32_t i = 0; i < num_detections; i++) {
+        cfar_detection_t detection = {
+            .bin_index = detections[i].bin,
+            .threshold = detections[i].threshold_db,
+            .signal_power = detections[i].power_db,
+            .snr_estimate = detections[i].snr_db,
+            .confidence = detections[i].confidence,
+        };
+        // A full table drops the detection, as in iqdetect
+        cluster_add_detection(&cluster->cluster, &detection, time_s);
+    }
+    cluster_advance(&cluster->cluster, time_s);
+    return cluster->failed ? IQLAB_ERROR_MEMORY : IQLAB_OK;
+}
+
+iqlab_status_t iqlab_cluster_flush(iqlab_cluster_t *cluster) {
+    if (!cluster) return IQLAB_ERROR_ARGUMENT;
+    cluster_advance(&cluster->cluster, INFINITY);
+    return cluster->failed ? IQLAB_ERROR_MEMORY : IQLAB_OK;
+}
+
+iqlab_status_t iqlab_cluster_next_event(iqlab_cluster_t *cluster, iqlab_event_t *event) {
+    if (!cluster || !event) return IQLAB_ERROR_ARGUMENT;
+    if (cluster->head == cluster->count) {
+        cluster->head = cluster->count = 0;
+        return IQLAB_ERROR_EMPTY;
+    }
+    *event = cluster->events[cluster->head++];
+    return IQLAB_OK;
+}
+
+void iqlab_cluster_destroy(iqlab_cluster_t *cluster) {
+    if (!cluster) return;
+    cluster_free(&cluster->cluster);
+    free(cluster->events);
+    free(cluster);
+}
+
+/* -------------------------------------------------------------------- PFB */
+
+struct iqlab_pfb {
+    pfb_t *pfb;
+    uint32_t num_channels;
+};
+
+iqlab_status_t iqlab_pfb_create(uint32_t num_channels, double sample_rate,
+                                double channel_bandwidth, uint32_t oversampling,
+                                iqlab_pfb_t **pfb) {
+    if (!pfb) return IQLAB_ERROR_ARGUMENT;
+    *pfb = NULL;
+
+    pfb_config_t config;
+    if (channel_bandwidth == 0.0 && num_channels > 0) channel_bandwidth = sample_rate / num_channels;
+    if (!pfb_config_init(&config, num_channels, sample_rate, channel_bandwidth)) {
+        return IQLAB_ERROR_ARGUMENT;
+    }
+    config.oversampling = oversampling;
+    if (!pfb_config_validate(&config)) return IQLAB_ERROR_ARGUMENT;
+
+    iqlab_pfb_t *handle = calloc(1, sizeof(*handle));
+    if (!handle) return IQLAB_ERROR_MEMORY;
+    handle->pfb = pfb_create(&config);
+    if (!handle->pfb) {
+        free(handle);
+        return IQLAB_ERROR_MEMORY;
+    }
+    handle->num_channels = num_channels;
+    *pfb = handle;
+    return IQLAB_OK;
+}
+
+double iqlab_pfb_output_rate(const iqlab_pfb_t *pfb) {
+    return pfb ? pfb_get_output_rate(pfb->pfb) : 0.0;
+}
+
+double iqlab_pfb_channel_frequency(const iqlab_pfb_t *pfb, uint32_t channel) {
+    if (!pfb || channel >= pfb->num_channels) return 0.0;
+    return pfb_get_channel_frequency(pfb->pfb, channel);
+}
+
+iqlab_status_t iqlab_pfb_process(iqlab_pfb_t *pfb, const float *iq, size_t samples, size_t *consumed) {
+    if (!pfb || !consumed || (!iq && samples > 0)) return IQLAB_ERROR_ARGUMENT;
+
+    const float complex *input = (const float complex *)iq;
+    size_t done = 0;
+    while (done < samples) {
+        size_t n = samples - done < IQLAB_CHUNK_SAMPLES ? samples - done : IQLAB_CHUNK_SAMPLES;
+        int32_t taken = pfb_process_block(pfb->pfb, input + done, (uint32_t)n);
+        if (taken < 0) return IQLAB_ERROR_ARGUMENT;
+        done += (size_t)taken;
+        if ((size_t)taken < n) break;  // A channel is full
+    }
+    *consumed = done;
+    return IQLAB_OK;
+}
+
+iqlab_status_t iqlab_pfb_read(iqlab_pfb_t *pfb, uint32_t channel, float *iq,
+                              size_t max_samples, size_t *samples) {
+    if (!pfb || !samples || channel >= pfb->num_channels || (!iq && max_samples > 0)) {
+        return IQLAB_ERROR_ARGUMENT;
+    }
+
+    uint32_t available = 0;
+    const float complex *outputs = pfb_channel_read(pfb->pfb, channel, &available);
+    if (!outputs) return IQLAB_ERROR_ARGUMENT;
+    size_t n = available < max_samples ? available : max_samples;
+    memcpy(iq, outputs, n * sizeof(float complex));
+    if (!pfb_channel_commit(pfb->pfb, channel, (uint32_t)n)) return IQLAB_ERROR_ARGUMENT;
+    *samples = n;
+    return IQLAB_OK;
+}
+
+void iqlab_pfb_destroy(iqlab_pfb_t *pfb) {
+    if (!pfb) return;
+    pfb_destroy(pfb->pfb);
+    free(pfb);
+}
+
+/* ---------------------------------------------------------- Demodulators */
+
+struct iqlab_demod {
+    iqlab_demod_mode_t mode;
+    fm_demod_t fm;
+    am_demod_t am;
+    ssb_demod_t ssb;
+};
+
+iqlab_status_t iqlab_demod_create(iqlab_demod_mode_t mode, double sample_rate, iqlab_demod_t **demod) {
+    if (!demod) return IQLAB_ERROR_ARGUMENT;
+    *demod = NULL;
+    if (!(sample_rate > 0.0) || mode < IQLAB_DEMOD_FM || mode > IQLAB_DEMOD_LSB) {
+        return IQLAB_ERROR_ARGUMENT;
+    }
+
+    iqlab_demod_t *handle = calloc(1, sizeof(*handle));
+    if (!handle) return IQLAB_ERROR_MEMORY;
+    handle->mode = mode;
+    bool ok;
+    switch (mode) {
+        case IQLAB_DEMOD_FM:
+            ok = fm_demod_init_custom(&handle->fm, (float)sample_rate, 75000.0f, 50e-6f, false);
+            break;
+        case IQLAB_DEMOD_AM:
+            ok = am_demod_init(&handle->am, (float)sample_rate);
+            break;
+        default:
+            ok = ssb_demod_init_custom(&handle->ssb, (float)sample_rate,
+                                       mode == IQLAB_DEMOD_USB ? SSB_MODE_USB : SSB_MODE_LSB,
+                                       1500.0f, 3000.0f);
+            break;
+    }
+    if (!ok) {
+        free(handle);
+        return IQLAB_ERROR_ARGUMENT;
+    }
+    *demod = handle;
+    return IQLAB_OK;
+}
+
+iqlab_status_t iqlab_demod_process(iqlab_demod_t *demod, const float *iq, size_t samples, float *audio) {
+    if (!demod || (samples > 0 && (!iq || !audio))) return IQLAB_ERROR_ARGUMENT;
+
+    for (size_t done = 0; done < samples;) {
+        uint32_t n = (uint32_t)(samples - done < IQLAB_CHUNK_SAMPLES ? samples - done : IQLAB_CHUNK_SAMPLES);
+        const float *in = iq + 2 * done;
+        float *out = audio + done;
+        bool ok = demod->mode == IQLAB_DEMOD_FM ? fm_demod_process_block(&demod->fm, in, n, out) :
+                  demod->mode == IQLAB_DEMOD_AM ? am_demod_process_buffer_iq(&demod->am, in, n, out) :
+                  ssb_demod_process_buffer_iq(&demod->ssb, in, n, out);
+        if (!ok) return IQLAB_ERROR_ARGUMENT;
+        done += n;
+    }
+    return IQLAB_OK;
+}
+
+void iqlab_demod_reset(iqlab_demod_t *demod) {
+    if (!demod) return;
+    switch (demod->mode) {
+        case IQLAB_DEMOD_FM: fm_demod_reset(&demod->fm); break;
+        case IQLAB_DEMOD_AM: am_demod_reset(&demod->am); break;
+        default: ssb_demod_reset(&demod->ssb); break;
+    }
+}
+
+void iqlab_demod_destroy(iqlab_demod_t *demod) {
+    if (!demod) return;
+    switch (demod->mode) {
+        case IQLAB_DEMOD_FM: fm_demod_free(&demod->fm); break;
+        case IQLAB_DEMOD_AM: am_demod_free(&demod->am); break;
+        default: ssb_demod_free(&demod->ssb); break;
+    }
+    free(demod);
+}
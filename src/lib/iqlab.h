@@ -0,0 +1,299 @@
+/*
+ * IQ Lab - iqlab.h: Embeddable Library API
+ *
+ * Purpose: The readers, STFT, CFAR, clustering, polyphase channelizer and
+ * demodulators behind the tools, as one shared library (libiqlab.so,
+ * iqlab.dll) with a stable C interface. A service keeps long-lived
+ * contexts and passes buffers to them in its own process, instead of
+ * starting a tool per job and reopening and decoding the capture each time.
+ *
+ * Date: 2025
+ *
+ * Conventions:
+ * - Every object is an opaque handle from iqlab_<object>_create (readers:
+ *   _open) and is released by iqlab_<object>_destroy (_close). The layouts
+ *   behind the handles are private and may change in any release.
+ * - Functions return an iqlab_status_t; iqlab_status_string() names it.
+ *   Outputs are only written on IQLAB_OK.
+ * - Streaming first: processors take buffers of any length in stream order
+ *   and keep their own history, so the outputs do not depend on how a
+ *   stream is split into buffers.
+ * - Samples are interleaved float I/Q (I0, Q0, I1, Q1, ...) scaled to
+ *   [-1, 1); counts are complex samples.
+ * - Versioning: IQLAB_VERSION_MAJOR changes only with incompatible changes
+ *   to this header (it is the soname: libiqlab.so.<major>); minor versions
+ *   only add functions. iqlab_version() reports the library actually
+ *   loaded.
+ *
+ * Usage (detection on one capture):
+ *   iqlab_reader_t *reader;
+ *   iqlab_stft_t *stft;
+ *   iqlab_cfar_t *cfar;
+ *   iqlab_cluster_t *cluster;
+ *   iqlab_reader_open("capture.iq", "s16", &reader);
+ *   iqlab_stft_create(4096, 1024, "hann", &stft);
+ *   iqlab_cfar_create("os", 4096, 1e-3, 16, 2, 8, &cfar);
+ *   iqlab_cluster_create(2e6, 50.0, 10000.0, 100, &cluster);
+ *
+ *   while (iqlab_reader_read(reader, iq, 65536, &count) == IQLAB_OK && count > 0) {
+ *       iqlab_stft_process(stft, iq, count, rows, max_rows, &num_rows);
+ *       for (r = 0; r < num_rows; r++, frame++) {
+ *           iqlab_cfar_process(cfar, rows + r * 4096, dets, 100, &num_dets);
+ *           iqlab_cluster_add(cluster, dets, num_dets, frame * 1024 / 2e6);
+ *           while (iqlab_cluster_next_event(cluster, &event) == IQLAB_OK) ...
+ *       }
+ *   }
+ *   iqlab_cluster_flush(cluster);
+ *
+ * Thread Safety: handles are independent of each other; each is used by
+ *                one thread at a time
+ */
+
+#ifndef IQLAB_H
+#define IQLAB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Exported symbols: dllexport while building the DLL, dllimport for its users
+#if defined(_WIN32) && defined(IQLAB_BUILD)
+#define IQLAB_API __declspec(dllexport)
+#elif defined(_WIN32) && !defined(IQLAB_STATIC)
+#define IQLAB_API __declspec(dllimport)
+#else
+#define IQLAB_API
+#endif
+
+#define IQLAB_VERSION_MAJOR 1
+#define IQLAB_VERSION_MINOR 0
+#define IQLAB_VERSION_PATCH 0
+
+// (major << 16) | (minor << 8) | patch
+#define IQLAB_VERSION ((IQLAB_VERSION_MAJOR << 16) | (IQLAB_VERSION_MINOR << 8) | IQLAB_VERSION_PATCH)
+
+typedef enum {
+    IQLAB_OK = 0,
+    IQLAB_ERROR_ARGUMENT = -1,   // Invalid handle, parameter or buffer size
+    IQLAB_ERROR_MEMORY = -2,     // Allocation failed
+    IQLAB_ERROR_IO = -3,         // File or stream could not be opened, read or positioned
+    IQLAB_ERROR_EMPTY = -4       // Nothing to return yet (no complete event)
+} iqlab_status_t;
+
+// IQLAB_VERSION of the loaded library
+IQLAB_API uint32_t iqlab_version(void);
+
+// "1.0.0"
+IQLAB_API const char *iqlab_version_string(void);
+
+// Short description of a status; never NULL
+IQLAB_API const char *iqlab_status_string(iqlab_status_t status);
+
+/* ------------------------------------------------------------------------
+ * Readers: raw s8/s16/s12/s4 files, 16-bit WAV, IQZ containers and live
+ * sources (stdin, pipes, tcp:// rtltcp:// udp://), streamed block by block
+ * ------------------------------------------------------------------------ */
+
+typedef struct iqlab_reader iqlab_reader_t;
+
+typedef struct {
+    uint32_t sample_rate;        // From the file (WAV), 0 when the file does not say
+    uint32_t sample_bits;        // Bits per I or Q value on disk
+    uint64_t total_samples;      // Complex samples, 0 for live sources
+    bool live;                   // Live source: seeks only go forward
+} iqlab_reader_info_t;
+
+/*
+ * Open 'path' for streaming; 'format' is "s8", "s16", "s12" or "s4", or
+ * NULL to detect it from the name and contents as the tools do
+ */
+IQLAB_API iqlab_status_t iqlab_reader_open(const char *path, const char *format,
+                                           iqlab_reader_t **reader);
+
+IQLAB_API iqlab_status_t iqlab_reader_info(const iqlab_reader_t *reader, iqlab_reader_info_t *info);
+
+/*
+ * Read up to max_samples into 'iq' (2 * max_samples floats); *samples is
+ * 0 at the end of the stream
+ */
+IQLAB_API iqlab_status_t iqlab_reader_read(iqlab_reader_t *reader, float *iq, size_t max_samples,
+                                           size_t *samples);
+
+// Position the next read at complex sample 'sample'
+IQLAB_API iqlab_status_t iqlab_reader_seek(iqlab_reader_t *reader, uint64_t sample);
+
+IQLAB_API void iqlab_reader_close(iqlab_reader_t *reader);
+
+/* ------------------------------------------------------------------------
+ * STFT: overlapping frames of the stream to power rows
+ * ------------------------------------------------------------------------ */
+
+typedef struct iqlab_stft iqlab_stft_t;
+
+/*
+ * Frames of fft_size samples every hop_size samples (hop_size may exceed
+ * fft_size); 'window' is a window name ("rectangular", "hann", "hamming",
+ * "blackman", "blackman-harris", "flat-top", "kaiser", "dpss") or NULL
+ * for rectangular
+ */
+IQLAB_API iqlab_status_t iqlab_stft_create(uint32_t fft_size, uint32_t hop_size, const char *window,
+                                           iqlab_stft_t **stft);
+
+// Most rows the next iqlab_stft_process of 'samples' samples can complete
+IQLAB_API size_t iqlab_stft_max_rows(const iqlab_stft_t *stft, size_t samples);
+
+/*
+ * Take 'samples' more samples of the stream and write the rows they
+ * complete to 'rows', back to back: fft_size linear power bins each
+ * (|X|^2, not normalized), DC at bin fft_size / 2. Fails without taking
+ * anything when max_rows is below iqlab_stft_max_rows(stft, samples).
+ */
+IQLAB_API iqlab_status_t iqlab_stft_process(iqlab_stft_t *stft, const float *iq, size_t samples,
+                                            double *rows, size_t max_rows, size_t *num_rows);
+
+// Forget the partial frame (next stream)
+IQLAB_API void iqlab_stft_reset(iqlab_stft_t *stft);
+
+IQLAB_API void iqlab_stft_destroy(iqlab_stft_t *stft);
+
+/* ------------------------------------------------------------------------
+ * CFAR: detections in one power row
+ * ------------------------------------------------------------------------ */
+
+typedef struct iqlab_cfar iqlab_cfar_t;
+
+typedef struct {
+    uint32_t bin;                // Bin of the row (DC at fft_size / 2)
+    double power_db;             // Cell power (dB)
+    double threshold_db;         // Detection threshold (dB)
+    double snr_db;               // Estimated SNR (dB)
+    double confidence;           // 0 to 1
+} iqlab_detection_t;
+
+/*
+ * Detector 'kind': "os" (ordered statistic, rank os_rank of the reference
+ * cells), "ca" (cell averaging), "go" or "so" (greatest- / smallest-of);
+ * ref_cells and guard_cells per side of the cell under test
+ */
+IQLAB_API iqlab_status_t iqlab_cfar_create(const char *kind, uint32_t fft_size, double pfa,
+                                           uint32_t ref_cells, uint32_t guard_cells, uint32_t os_rank,
+                                           iqlab_cfar_t **cfar);
+
+// Detections of one row of fft_size linear power bins, at most max_detections
+IQLAB_API iqlab_status_t iqlab_cfar_process(iqlab_cfar_t *cfar, const double *row,
+                                            iqlab_detection_t *detections, uint32_t max_detections,
+                                            uint32_t *num_detections);
+
+IQLAB_API void iqlab_cfar_destroy(iqlab_cfar_t *cfar);
+
+/* ------------------------------------------------------------------------
+ * Clustering: detections of successive rows to events, as iqdetect writes them
+ * ------------------------------------------------------------------------ */
+
+typedef struct iqlab_cluster iqlab_cluster_t;
+
+typedef struct {
+    double start_time_s;
+    double end_time_s;
+    double center_freq_hz;       // Offset from the capture centre
+    double bandwidth_hz;
+    double peak_snr_db;
+    double avg_snr_db;
+    double peak_power_dbfs;
+    uint32_t num_detections;
+    double confidence;           // 0 to 1
+    const char *modulation;      // Static string ("narrowband", ...), never NULL
+} iqlab_event_t;
+
+/*
+ * A cluster extends while detections arrive within max_time_gap_ms and
+ * max_freq_gap_hz of it; at most max_clusters are open at once
+ */
+IQLAB_API iqlab_status_t iqlab_cluster_create(double sample_rate, double max_time_gap_ms,
+                                              double max_freq_gap_hz, uint32_t max_clusters,
+                                              iqlab_cluster_t **cluster);
+
+/*
+ * Add the detections of the row at 'time_s' (rows in time order; a row
+ * without detections still moves the clock) and close the clusters that
+ * have been idle for longer than the gap
+ */
+IQLAB_API iqlab_status_t iqlab_cluster_add(iqlab_cluster_t *cluster, const iqlab_detection_t *detections,
+                                           uint32_t num_detections, double time_s);
+
+// End of the stream: close every open cluster
+IQLAB_API iqlab_status_t iqlab_cluster_flush(iqlab_cluster_t *cluster);
+
+// Take the oldest closed event; IQLAB_ERROR_EMPTY when there is none
+IQLAB_API iqlab_status_t iqlab_cluster_next_event(iqlab_cluster_t *cluster, iqlab_event_t *event);
+
+IQLAB_API void iqlab_cluster_destroy(iqlab_cluster_t *cluster);
+
+/* ------------------------------------------------------------------------
+ * PFB: polyphase channelizer, every channel of the band at once
+ * ------------------------------------------------------------------------ */
+
+typedef struct iqlab_pfb iqlab_pfb_t;
+
+/*
+ * num_channels (4 to 4096) channels across sample_rate, each
+ * channel_bandwidth wide (0: sample_rate / num_channels); oversampling 1
+ * outputs at sample_rate / num_channels, 2 at twice that
+ */
+IQLAB_API iqlab_status_t iqlab_pfb_create(uint32_t num_channels, double sample_rate,
+                                          double channel_bandwidth, uint32_t oversampling,
+                                          iqlab_pfb_t **pfb);
+
+// Output rate of every channel (Hz)
+IQLAB_API double iqlab_pfb_output_rate(const iqlab_pfb_t *pfb);
+
+// Centre of a channel, as an offset from the input's centre (Hz)
+IQLAB_API double iqlab_pfb_channel_frequency(const iqlab_pfb_t *pfb, uint32_t channel);
+
+/*
+ * Take up to 'samples' input samples. Channels buffer their outputs until
+ * read; when one is full the PFB stops early (*consumed < samples) and
+ * takes the rest once the channels have been read.
+ */
+IQLAB_API iqlab_status_t iqlab_pfb_process(iqlab_pfb_t *pfb, const float *iq, size_t samples,
+                                           size_t *consumed);
+
+// Move up to max_samples of a channel's outputs to 'iq' (interleaved I/Q)
+IQLAB_API iqlab_status_t iqlab_pfb_read(iqlab_pfb_t *pfb, uint32_t channel, float *iq,
+                                        size_t max_samples, size_t *samples);
+
+IQLAB_API void iqlab_pfb_destroy(iqlab_pfb_t *pfb);
+
+/* ------------------------------------------------------------------------
+ * Demodulators: one audio sample per input sample, at the input rate
+ * ------------------------------------------------------------------------ */
+
+typedef struct iqlab_demod iqlab_demod_t;
+
+typedef enum {
+    IQLAB_DEMOD_FM = 0,          // 75 kHz deviation, 50 us de-emphasis
+    IQLAB_DEMOD_AM = 1,          // Envelope, DC blocked
+    IQLAB_DEMOD_USB = 2,         // 1.5 kHz BFO, 3 kHz audio
+    IQLAB_DEMOD_LSB = 3
+} iqlab_demod_mode_t;
+
+IQLAB_API iqlab_status_t iqlab_demod_create(iqlab_demod_mode_t mode, double sample_rate,
+                                            iqlab_demod_t **demod);
+
+// Demodulate 'samples' samples to 'audio' (samples floats)
+IQLAB_API iqlab_status_t iqlab_demod_process(iqlab_demod_t *demod, const float *iq, size_t samples,
+                                             float *audio);
+
+IQLAB_API void iqlab_demod_reset(iqlab_demod_t *demod);
+
+IQLAB_API void iqlab_demod_destroy(iqlab_demod_t *demod);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IQLAB_H
@@ -0,0 +1,291 @@
+/*
+ * IQ Lab - GCC-PHAT Time Difference of Arrival
+ *
+ * One batch is two stages on the workers: receivers' FFTs, then pairs'
+ * cross-spectra. The calling thread hands each worker the stage on its
+ * queue and waits for all of them before the next, so the spectra a pair
+ * reads are complete and nothing is locked.
+ */
+
+#include "gcc_phat.h"
+#include "../iq_core/stft.h"
+#include "../iq_core/profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Stage markers passed on the worker queues
+static int stage_transform;
+static int stage_accumulate;
+
+static bool is_power_of_two(uint32_t n) {
+    return n && (n & (n - 1)) == 0;
+}
+
+// Full and short window spectra of receiver r for the staged batch
+static void transform_receiver(gcc_phat_t *engine, uint32_t r) {
+    const uint32_t n = engine->config.fft_size, m = engine->config.max_lag, l = engine->block_samples;
+    const uint32_t count = engine->batch_blocks;
+    uint64_t t = iq_profile_begin();
+
+    // Full windows overlap by 2M: read in place with a stride of L
+    fft_execute_batch_f32(engine->forward, engine->stage[r], engine->full[r], count, l, n);
+
+    // Short windows: L samples from M into each full window, the rest zero
+    for (uint32_t b = 0; b < count; b++) {
+        memcpy(engine->padded[r] + (size_t)b * n, engine->stage[r] + (size_t)b * l + m,
+               (size_t)l * sizeof(fft_complex_f32_t));
+    }
+    fft_execute_batch_f32(engine->forward, engine->padded[r], engine->shorts[r], count, n, n);
+    iq_profile_end(IQ_PROFILE_FFT, t, 2 * (uint64_t)count, 2 * (uint64_t)count * n * sizeof(fft_complex_f32_t));
+}
+
+// Add the batch's X_b X_a* to pair p's cross-spectrum, block by block
+static void accumulate_pair(gcc_phat_t *engine, uint32_t p) {
+    const uint32_t n = engine->config.fft_size;
+    const fft_complex_f32_t *full = engine->full[engine->pair_b[p]];
+    const fft_complex_f32_t *shorts = engine->shorts[engine->pair_a[p]];
+    fft_complex_t *cross = engine->cross[p];
+
+    for (uint32_t b = 0; b < engine->batch_blocks; b++) {
+        const fft_complex_f32_t *x_b = full + (size_t)b * n;
+        const fft_complex_f32_t *x_a = shorts + (size_t)b * n;
+        for (uint32_t k = 0; k < n; k++) {
+            cross[k] += (fft_complex_t)(x_b[k] * conjf(x_a[k]));
+        }
+    }
+}
+
+static void run_stage(gcc_phat_t *engine, const int *stage, uint32_t worker, uint32_t stride) {
+    if (stage == &stage_transform) {
+        for (uint32_t r = worker; r < engine->config.num_receivers; r += stride) transform_receiver(engine, r);
+    } else {
+        for (uint32_t p = worker; p < engine->num_pairs; p += stride) accumulate_pair(engine, p);
+    }
+}
+
+static void *gcc_phat_worker(void *arg) {
+    gcc_phat_worker_t *worker = arg;
+    char name[32];
+    snprintf(name, sizeof(name), "gcc-phat %u", worker->index);
+    iq_trace_thread_name(name);
+
+    for (;;) {
+        const int *stage = iq_spsc_pop(&worker->jobs);
+        if (!stage) break;
+        run_stage(worker->engine, stage, worker->index, worker->engine->num_workers);
+        iq_spsc_push(&worker->done, (void *)stage);
+    }
+    return NULL;
+}
+
+// Run one stage on every worker (or inline) and wait for it
+static void dispatch(gcc_phat_t *engine, int *stage) {
+    if (engine->num_workers == 0) {
+        run_stage(engine, stage, 0, 1);
+        return;
+    }
+    for (uint32_t w = 0; w < engine->num_workers; w++) iq_spsc_push(&engine->workers[w].jobs, stage);
+    for (uint32_t w = 0; w < engine->num_workers; w++) iq_spsc_pop(&engine->workers[w].done);
+}
+
+// Transform and sum the complete blocks staged, then keep the last 2M samples
+static void process_batch(gcc_phat_t *engine) {
+    const uint32_t l = engine->block_samples, keep = 2 * engine->config.max_lag;
+    engine->batch_blocks = engine->staged / l;
+    if (engine->batch_blocks == 0) return;
+
+    dispatch(engine, &stage_transform);
+    dispatch(engine, &stage_accumulate);
+
+    uint32_t used = engine->batch_blocks * l;
+    for (uint32_t r = 0; r < engine->config.num_receivers; r++) {
+        memmove(engine->stage[r], engine->stage[r] + used,
+                (size_t)(keep + engine->staged - used) * sizeof(fft_complex_f32_t));
+    }
+    engine->staged -= used;
+    engine->blocks += engine->batch_blocks;
+    engine->total_blocks += engine->batch_blocks;
+    engine->batch_blocks = 0;
+}
+
+gcc_phat_t *gcc_phat_create(const gcc_phat_config_t *config) {
+    if (!config || config->num_receivers < 2 || config->num_receivers > GCC_PHAT_MAX_RECEIVERS ||
+        config->max_lag == 0 || config->max_lag > FFT_MAX_SIZE / 8 ||
+        (config->fft_size && (!is_power_of_two(config->fft_size) ||
+                              config->fft_size < 4 * config->max_lag || config->fft_size > FFT_MAX_SIZE))) {
+        fprintf(stderr, "Invalid GCC-PHAT parameters: 2 to %d receivers, a power of two FFT of at least 4x the max lag\n",
+                GCC_PHAT_MAX_RECEIVERS);
+        return NULL;
+    }
+
+    gcc_phat_t *engine = calloc(1, sizeof(*engine));
+    if (!engine) return NULL;
+    engine->config = *config;
+    uint32_t n = config->fft_size;
+    if (n == 0) {
+        for (n = 1024; n < 8 * config->max_lag; n *= 2) {
+        }
+        engine->config.fft_size = n;
+    }
+    const uint32_t m = config->max_lag;
+    engine->block_samples = n - 2 * m;
+
+    const uint32_t receivers = config->num_receivers;
+    for (uint32_t a = 0; a < receivers; a++) {
+        for (uint32_t b = a + 1; b < receivers; b++) {
+            engine->pair_a[engine->num_pairs] = (uint8_t)a;
+            engine->pair_b[engine->num_pairs] = (uint8_t)b;
+            engine->num_pairs++;
+        }
+    }
+
+    const size_t stage_samples = 2 * (size_t)m + (size_t)GCC_PHAT_BATCH_BLOCKS * engine->block_samples;
+    const size_t batch_bins = (size_t)GCC_PHAT_BATCH_BLOCKS * n;
+    engine->forward = fft_plan_f32_acquire(n, FFT_FORWARD);
+    engine->inverse = fft_plan_acquire(GCC_PHAT_INTERPOLATION * n, FFT_INVERSE);
+    engine->weighted = calloc((size_t)GCC_PHAT_INTERPOLATION * n, sizeof(fft_complex_t));
+    engine->correlation = malloc((size_t)GCC_PHAT_INTERPOLATION * n * sizeof(fft_complex_t));
+    bool ok = engine->forward && engine->inverse && engine->weighted && engine->correlation;
+    for (uint32_t r = 0; ok && r < receivers; r++) {
+        engine->stage[r] = calloc(stage_samples, sizeof(fft_complex_f32_t));
+        engine->padded[r] = calloc(batch_bins, sizeof(fft_complex_f32_t));
+        engine->full[r] = malloc(batch_bins * sizeof(fft_complex_f32_t));
+        engine->shorts[r] = malloc(batch_bins * sizeof(fft_complex_f32_t));
+        ok = engine->stage[r] && engine->padded[r] && engine->full[r] && engine->shorts[r];
+    }
+    for (uint32_t p = 0; ok && p < engine->num_pairs; p++) {
+        engine->cross[p] = calloc(n, sizeof(fft_complex_t));
+        ok = engine->cross[p] != NULL;
+    }
+
+    // Workers: no more than there is to share out; one runs inline
+    uint32_t threads = config->num_threads ? config->num_threads : stft_default_threads();
+    if (threads > GCC_PHAT_MAX_THREADS) threads = GCC_PHAT_MAX_THREADS;
+    uint32_t shares = engine->num_pairs > receivers ? engine->num_pairs : receivers;
+    if (threads > shares) threads = shares;
+    if (ok && threads > 1) {
+        engine->workers = calloc(threads, sizeof(*engine->workers));
+        ok = engine->workers != NULL;
+        for (uint32_t w = 0; ok && w < threads; w++) {
+            gcc_phat_worker_t *worker = &engine->workers[w];
+            worker->engine = engine;
+            worker->index = w;
+            ok = iq_spsc_init(&worker->jobs, 2) && iq_spsc_init(&worker->done, 2);
+            engine->num_workers = w + 1;
+        }
+        for (uint32_t w = 0; ok && w < threads; w++) {
+            gcc_phat_worker_t *worker = &engine->workers[w];
+            worker->started = pthread_create(&worker->thread, NULL, gcc_phat_worker, worker) == 0;
+            ok = worker->started;
+        }
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Failed to create the GCC-PHAT engine\n");
+        gcc_phat_destroy(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+void gcc_phat_destroy(gcc_phat_t *engine) {
+    if (!engine) return;
+
+    for (uint32_t w = 0; engine->workers && w < engine->num_workers; w++) {
+        gcc_phat_worker_t *worker = &engine->workers[w];
+        if (!worker->started) continue;
+        iq_spsc_push(&worker->jobs, NULL);
+        pthread_join(worker->thread, NULL);
+    }
+    for (uint32_t w = 0; engine->workers && w < engine->num_workers; w++) {
+        iq_spsc_free(&engine->workers[w].jobs);
+        iq_spsc_free(&engine->workers[w].done);
+    }
+    free(engine->workers);
+
+    for (uint32_t r = 0; r < GCC_PHAT_MAX_RECEIVERS; r++) {
+        free(engine->stage[r]);
+        free(engine->padded[r]);
+        free(engine->full[r]);
+        free(engine->shorts[r]);
+    }
+    for (uint32_t p = 0; p < GCC_PHAT_MAX_PAIRS; p++) free(engine->cross[p]);
+    if (engine->forward) fft_plan_f32_release(engine->forward);
+    if (engine->inverse) fft_plan_release(engine->inverse);
+    free(engine->weighted);
+    free(engine->correlation);
+    free(engine);
+}
+
+uint32_t gcc_phat_num_pairs(const gcc_phat_t *engine) {
+    return engine ? engine->num_pairs : 0;
+}
+
+void gcc_phat_push(gcc_phat_t *engine, const float *const *iq, size_t count) {
+    const uint32_t keep = 2 * engine->config.max_lag;
+    const uint32_t capacity = GCC_PHAT_BATCH_BLOCKS * engine->block_samples;
+    size_t done = 0;
+    while (done < count) {
+        size_t take = capacity - engine->staged;
+        if (take > count - done) take = count - done;
+        for (uint32_t r = 0; r < engine->config.num_receivers; r++) {
+            fft_complex_f32_t *out = engine->stage[r] + keep + engine->staged;
+            const float *in = iq[r] + 2 * done;
+            for (size_t i = 0; i < take; i++) out[i] = in[2 * i] + I * in[2 * i + 1];
+        }
+        engine->staged += (uint32_t)take;
+        done += take;
+        if (engine->staged == capacity) process_batch(engine);
+    }
+    engine->samples_pushed += count;
+}
+
+bool gcc_phat_estimate(gcc_phat_t *engine, gcc_phat_result_t *results) {
+    process_batch(engine);
+    if (engine->blocks == 0) return false;
+
+    const uint32_t n = engine->config.fft_size, m = engine->config.max_lag;
+    const uint32_t u = GCC_PHAT_INTERPOLATION, span = 2 * m * u, exclude = GCC_PHAT_PEAK_EXCLUDE * u;
+    const fft_complex_t *c = engine->correlation;
+    for (uint32_t p = 0; p < engine->num_pairs; p++) {
+        // Phase transform: unit weight on every bin with cross-power; the
+        // negative frequencies go to the top of the padded spectrum
+        fft_complex_t *cross = engine->cross[p];
+        for (uint32_t k = 0; k < n; k++) {
+            double magnitude = cabs(cross[k]);
+            uint32_t bin = k < n / 2 ? k : k + (u - 1) * n;
+            engine->weighted[bin] = magnitude > 0.0 ? cross[k] / magnitude : 0.0;
+        }
+        fft_execute(engine->inverse, engine->weighted, engine->correlation);
+
+        // Lags -M .. M are points 0 .. 2M u; the inverse scales by 1 / (u N)
+        uint32_t best = 0;
+        for (uint32_t j = 1; j <= span; j++) {
+            if (cabs(c[j]) > cabs(c[best])) best = j;
+        }
+        double peak = cabs(c[best]);
+        double offset = 0.0;
+        if (best > 0 && best < span) {
+            double before = cabs(c[best - 1]), after = cabs(c[best + 1]);
+            double curvature = before - 2.0 * peak + after;
+            if (curvature < 0.0) offset = 0.5 * (before - after) / curvature;
+        }
+        double sidelobe = 0.0;
+        for (uint32_t j = 0; j <= span; j++) {
+            if (j + exclude < best || j > best + exclude) sidelobe = fmax(sidelobe, cabs(c[j]));
+        }
+
+        gcc_phat_result_t *result = &results[p];
+        result->rx_a = engine->pair_a[p];
+        result->rx_b = engine->pair_b[p];
+        result->delay_samples = ((double)best + offset) / u - (double)m;
+        result->peak = peak * u;
+        result->peak_ratio = sidelobe > 0.0 ? peak / sidelobe : INFINITY;
+        result->blocks = engine->blocks;
+        memset(cross, 0, n * sizeof(fft_complex_t));
+    }
+    engine->blocks = 0;
+    return true;
+}
@@ -0,0 +1,160 @@
+/*
+ * IQ Lab - GCC-PHAT Time Difference of Arrival Header
+ *
+ * Purpose: Delay between receivers from streamed, time-aligned captures
+ *
+ *
+ * The generalized cross-correlation with phase transform (GCC-PHAT)
+ * whitens the cross-spectrum of two receivers before transforming back,
+ * G(f) = X_b(f) X_a(f)* / |X_b(f) X_a(f)*|, so the correlation peak is
+ * sharp whatever the signal's spectrum and its position is the delay of b
+ * behind a. The engine computes it in overlap-save blocks of an N point
+ * FFT for lags -M .. M:
+ *
+ *   full window of b:   N samples from block start - M
+ *   short window of a:  L = N - 2M samples from block start, zero-padded to N
+ *
+ * so lags 0 .. 2M of the circular correlation are the linear correlation
+ * at -M .. M without wrap-around. Blocks advance by L; the last 2M samples
+ * are kept for the next batch, so memory does not grow with the input.
+ * Cross-spectra are summed over the blocks of an interval, whitened once,
+ * zero-padded to GCC_PHAT_INTERPOLATION N bins and transformed back, so
+ * the correlation is interpolated exactly between lags, and searched for
+ * the peak, which a parabola through it and its neighbours refines
+ * further (a parabola on the bare lags is off by up to a quarter sample
+ * on the sinc-shaped PHAT peak).
+ *
+ * Work is split over threads across receivers and pairs: per batch of
+ * GCC_PHAT_BATCH_BLOCKS blocks, receiver r's FFTs (one batched call each
+ * for the full and short windows, read straight from the staging buffer)
+ * run on worker r mod W, then pair p's accumulation on worker p mod W.
+ * Each pair is summed by one worker in block order, so results do not
+ * depend on the thread count.
+ *
+ * Usage:
+ *   gcc_phat_config_t cfg = { .num_receivers = 3, .max_lag = 256, .num_threads = 0 };
+ *   gcc_phat_t *engine = gcc_phat_create(&cfg);
+ *   while (reading) {
+ *       gcc_phat_push(engine, iq, count);           // iq[r]: receiver r, same instants
+ *       if (interval done) gcc_phat_estimate(engine, results);
+ *   }
+ *   gcc_phat_destroy(engine);
+ *
+ * Technical Details:
+ * - Pairs are (0,1), (0,2), ..., (1,2), ...: a < b, gcc_phat_num_pairs() of them
+ * - Samples of a block not yet complete stay staged for the next interval
+ * - The first block's full window reaches M samples before the first one
+ *   pushed, which read as zeros
+ * - PHAT bins whose cross-power is zero get no weight
+ *
+ * Memory: per receiver (B L + 2M) staged samples, 2 B spectra and B padded
+ *         windows of N; per pair one N-bin cross-spectrum (B: batch blocks)
+ * Thread Safety: push, estimate and destroy from one thread
+ */
+
+#ifndef IQ_LAB_GCC_PHAT_H
+#define IQ_LAB_GCC_PHAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "../iq_core/fft.h"
+#include "../iq_core/spsc_queue.h"
+
+#define GCC_PHAT_MAX_RECEIVERS 8
+#define GCC_PHAT_MAX_PAIRS (GCC_PHAT_MAX_RECEIVERS * (GCC_PHAT_MAX_RECEIVERS - 1) / 2)
+#define GCC_PHAT_MAX_THREADS 32
+#define GCC_PHAT_BATCH_BLOCKS 8      // Blocks staged per dispatch to the workers
+#define GCC_PHAT_PEAK_EXCLUDE 2      // Lags either side of the peak left out of the sidelobe search
+#define GCC_PHAT_INTERPOLATION 4     // Correlation points per lag
+
+// Engine parameters
+typedef struct {
+    uint32_t num_receivers;      // 2 .. GCC_PHAT_MAX_RECEIVERS
+    uint32_t max_lag;            // M: lags -M .. M searched (at least 1)
+    uint32_t fft_size;           // N: power of two, at least 4M (0: the smallest at least 8M, >= 1024)
+    uint32_t num_threads;        // Workers (0: one per core, 1: on the calling thread)
+} gcc_phat_config_t;
+
+// Delay of one pair over an interval
+typedef struct {
+    uint32_t rx_a;               // Reference receiver
+    uint32_t rx_b;               // Receiver whose delay behind rx_a is measured
+    double delay_samples;        // Lag of the peak, refined to a fraction of a sample
+    double peak;                 // PHAT correlation at the peak lag (0-1)
+    double peak_ratio;           // Peak over the largest lag beyond GCC_PHAT_PEAK_EXCLUDE of it
+    uint64_t blocks;             // Blocks summed
+} gcc_phat_result_t;
+
+typedef struct gcc_phat_t gcc_phat_t;
+
+// Worker thread state
+typedef struct {
+    gcc_phat_t *engine;
+    uint32_t index;
+    pthread_t thread;
+    bool started;
+    iq_spsc_t jobs;              // Stage to run (NULL stops the worker)
+    iq_spsc_t done;
+} gcc_phat_worker_t;
+
+// Engine state
+struct gcc_phat_t {
+    gcc_phat_config_t config;
+    uint32_t block_samples;      // L = N - 2M
+    uint32_t num_pairs;
+    uint8_t pair_a[GCC_PHAT_MAX_PAIRS];
+    uint8_t pair_b[GCC_PHAT_MAX_PAIRS];
+
+    fft_plan_f32_t *forward;     // N points
+    fft_plan_t *inverse;         // GCC_PHAT_INTERPOLATION N points, double (the summed cross-spectrum)
+
+    // Per receiver
+    fft_complex_f32_t *stage[GCC_PHAT_MAX_RECEIVERS];   // 2M kept + B L new samples
+    fft_complex_f32_t *padded[GCC_PHAT_MAX_RECEIVERS];  // B short windows, zero-padded to N
+    fft_complex_f32_t *full[GCC_PHAT_MAX_RECEIVERS];    // B spectra of the full windows
+    fft_complex_f32_t *shorts[GCC_PHAT_MAX_RECEIVERS];  // B spectra of the short windows
+    uint32_t staged;             // New samples in every stage, past the 2M kept
+    uint32_t batch_blocks;       // Blocks in the batch being processed
+
+    // Per pair
+    fft_complex_t *cross[GCC_PHAT_MAX_PAIRS];           // Summed X_b X_a*, N bins
+    uint64_t blocks;             // Blocks summed this interval
+    fft_complex_t *weighted;     // Whitened cross-spectrum, zero-padded
+    fft_complex_t *correlation;  // Its inverse FFT
+
+    gcc_phat_worker_t *workers;
+    uint32_t num_workers;
+
+    // Statistics
+    uint64_t samples_pushed;
+    uint64_t total_blocks;
+};
+
+/*
+ * Create an engine and start its workers
+ * Returns NULL (with a message on stderr) on invalid parameters or no memory.
+ */
+gcc_phat_t *gcc_phat_create(const gcc_phat_config_t *config);
+
+// Stop the workers and free the engine; NULL is ignored
+void gcc_phat_destroy(gcc_phat_t *engine);
+
+// Pairs the engine reports: R (R - 1) / 2
+uint32_t gcc_phat_num_pairs(const gcc_phat_t *engine);
+
+/*
+ * Feed 'count' samples of every receiver, iq[r] interleaved I/Q of
+ * receiver r at the same instants; full batches are processed on the way
+ */
+void gcc_phat_push(gcc_phat_t *engine, const float *const *iq, size_t count);
+
+/*
+ * Process the complete blocks still staged, then fill one result per pair
+ * (gcc_phat_num_pairs() entries) for the interval since the last estimate
+ * and start a new one. Returns false when the interval holds no block.
+ */
+bool gcc_phat_estimate(gcc_phat_t *engine, gcc_phat_result_t *results);
+
+#endif /* IQ_LAB_GCC_PHAT_H */
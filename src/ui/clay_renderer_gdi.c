@@ -5,6 +5,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include "clay.h"
 
@@ -286,36 +287,265 @@ static void __Clay_Win32_FillRoundRect(HDC hdc, PRECT prc, Clay_Color color, Cla
     DestroyHDCSubstitute(&substitute);
 }
 
-void Clay_Win32_Render(HWND hwnd, Clay_RenderCommandArray renderCommands, HFONT* fonts)
+/*----------------------------------------------------------------------------+
+ | Damage tracking                                                            |
+ +----------------------------------------------------------------------------*/
+// The back buffer is a DIB section that persists between frames. Every render
+// command is reduced to a signature (type, box and payload); a frame redraws,
+// clipped to the damage, only the boxes whose signature changed since the
+// previous frame, and only the damage is copied to the window. An idle frame
+// with an unchanged layout touches no pixel at all.
+
+typedef struct {
+    uint64_t hash;      // Type, bounding box and payload of one command
+    RECT box;           // Pixels it can touch
+} ClayGdiSignature;
+
+typedef struct {
+    HDC hdc;                        // Back buffer (client-area sized)
+    HBITMAP hbm;
+    HGDIOBJ hbmPrev;
+    SIZE size;
+    bool valid;                     // Holds the previous frame
+    HRGN damage;                    // Changed since the last present
+    ClayGdiSignature* previous;     // Last frame's commands
+    ClayGdiSignature* current;
+    int32_t previous_count;
+    int32_t capacity;
+} ClayGdiFrame;
+
+static ClayGdiFrame g_clay_gdi_frame = {0};
+
+static uint64_t ClayGdi_Hash(uint64_t h, const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= p[i];
+        h *= 0x100000001b3ull;  // FNV-1a
+    }
+    return h;
+}
+
+static ClayGdiSignature ClayGdi_Sign(const Clay_RenderCommand* command)
 {
+    ClayGdiSignature sig;
+    const Clay_BoundingBox* b = &command->boundingBox;
+    uint64_t h = 0xcbf29ce484222325ull;
+    int32_t type = (int32_t)command->commandType;
+    int inflate = 1;    // Rounded regions and line ends reach one pixel out
+
+    h = ClayGdi_Hash(h, &type, sizeof(type));
+    h = ClayGdi_Hash(h, b, sizeof(*b));
+    switch (command->commandType)
+    {
+    case CLAY_RENDER_COMMAND_TYPE_TEXT:
+    {
+        const Clay_TextRenderData* t = &command->renderData.text;
+        h = ClayGdi_Hash(h, &t->textColor, sizeof(t->textColor));
+        h = ClayGdi_Hash(h, &t->fontId, sizeof(t->fontId));
+        h = ClayGdi_Hash(h, &t->fontSize, sizeof(t->fontSize));
+        h = ClayGdi_Hash(h, t->stringContents.chars, (size_t)t->stringContents.length);
+        break;
+    }
+    case CLAY_RENDER_COMMAND_TYPE_RECTANGLE:
+        h = ClayGdi_Hash(h, &command->renderData.rectangle, sizeof(command->renderData.rectangle));
+        break;
+    case CLAY_RENDER_COMMAND_TYPE_BORDER:
+    {
+        const Clay_BorderRenderData* brd = &command->renderData.border;
+        uint16_t widths[4] = { brd->width.left, brd->width.right, brd->width.top, brd->width.bottom };
+        h = ClayGdi_Hash(h, &brd->color, sizeof(brd->color));
+        h = ClayGdi_Hash(h, &brd->cornerRadius, sizeof(brd->cornerRadius));
+        h = ClayGdi_Hash(h, widths, sizeof(widths));
+        for (int i = 0; i < 4; ++i)
+            if (widths[i] / 2 + 1 > inflate) inflate = widths[i] / 2 + 1;
+        break;
+    }
+    default:
+        break;
+    }
+
+    sig.hash = h;
+    sig.box.left = (LONG)floorf(b->x) - inflate;
+    sig.box.top = (LONG)floorf(b->y) - inflate;
+    sig.box.right = (LONG)ceilf(b->x + b->width) + inflate;
+    sig.box.bottom = (LONG)ceilf(b->y + b->height) + inflate;
+    return sig;
+}
+
+static void ClayGdi_AddDamage(const RECT* r)
+{
+    ClayGdiFrame* f = &g_clay_gdi_frame;
+    if (!f->damage)
+        f->damage = CreateRectRgn(0, 0, 0, 0);
+    HRGN rgn = CreateRectRgnIndirect(r);
+    CombineRgn(f->damage, f->damage, rgn, RGN_OR);
+    DeleteObject(rgn);
+}
+
+// Mark a back-buffer area as changed, e.g. after drawing a pane into it
+void Clay_Win32_AddDamage(const RECT* rect)
+{
+    if (rect && rect->right > rect->left && rect->bottom > rect->top)
+        ClayGdi_AddDamage(rect);
+}
+
+// True if the next present copies part of 'rect'
+bool Clay_Win32_IsDamaged(const RECT* rect)
+{
+    return g_clay_gdi_frame.damage && rect && RectInRegion(g_clay_gdi_frame.damage, rect);
+}
+
+// Back buffer the next present copies from (NULL before the first draw)
+HDC Clay_Win32_GetBackBuffer(void)
+{
+    return g_clay_gdi_frame.hdc;
+}
+
+// Forget the previous frame: the next draw repaints everything
+void Clay_Win32_InvalidateBackBuffer(void)
+{
+    g_clay_gdi_frame.valid = false;
+}
+
+static void ClayGdi_FreeBackBuffer(void)
+{
+    ClayGdiFrame* f = &g_clay_gdi_frame;
+    if (f->hdc)
+    {
+        SelectObject(f->hdc, f->hbmPrev);
+        DeleteObject(f->hbm);
+        DeleteDC(f->hdc);
+    }
+    f->hdc = NULL;
+    f->hbm = NULL;
+    f->valid = false;
+    renderer_hdcMem = NULL;
+    renderer_hbmMem = NULL;
+    renderer_hOld = NULL;
+}
+
+// Same size as the client area; recreating it invalidates the frame
+static bool ClayGdi_EnsureBackBuffer(HWND hwnd, int width, int height)
+{
+    ClayGdiFrame* f = &g_clay_gdi_frame;
+    if (f->hdc && f->size.cx == width && f->size.cy == height)
+        return true;
+
+    ClayGdi_FreeBackBuffer();
+    if (width <= 0 || height <= 0)
+        return false;
+
+    BITMAPINFO bmi = { 0 };
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    HDC hdcWindow = GetDC(hwnd);
+    f->hdc = CreateCompatibleDC(hdcWindow);
+    ReleaseDC(hwnd, hdcWindow);
+    if (f->hdc == NULL)
+        return false;
+
+    void* bits = NULL;
+    f->hbm = CreateDIBSection(f->hdc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (f->hbm == NULL)
+    {
+        DeleteDC(f->hdc);
+        f->hdc = NULL;
+        return false;
+    }
+    f->hbmPrev = SelectObject(f->hdc, f->hbm);
+    f->size = (SIZE){ width, height };
+
+    renderer_hdcMem = f->hdc;
+    renderer_hbmMem = f->hbm;
+    renderer_hOld = f->hbmPrev;
+    return true;
+}
+
+/*
+ * Bring the back buffer up to date with renderCommands, redrawing only the
+ * commands whose signature changed (and everything after a resize)
+ * Returns false if there is no back buffer (minimized window).
+ */
+bool Clay_Win32_Draw(HWND hwnd, Clay_RenderCommandArray renderCommands, HFONT* fonts)
+{
+    ClayGdiFrame* f = &g_clay_gdi_frame;
     bool is_clipping = false;
     (void)is_clipping; // Suppress unused variable warning
     HRGN clipping_region = {0};
 
-    PAINTSTRUCT ps;
-    HDC hdc;
-    RECT rc; // Top left of our window
+    RECT rc; // Client area, back-buffer coordinates
+    GetClientRect(hwnd, &rc);
+    if (!ClayGdi_EnsureBackBuffer(hwnd, RECTWIDTH(rc), RECTHEIGHT(rc)))
+        return false;
 
-    GetWindowRect(hwnd, &rc);
+    if (renderCommands.length > f->capacity)
+    {
+        int32_t capacity = renderCommands.length + renderCommands.length / 2 + 16;
+        ClayGdiSignature* previous = realloc(f->previous, (size_t)capacity * sizeof(ClayGdiSignature));
+        if (previous) f->previous = previous;
+        ClayGdiSignature* current = realloc(f->current, (size_t)capacity * sizeof(ClayGdiSignature));
+        if (current) f->current = current;
+        if (!previous || !current)
+            return false;
+        f->capacity = capacity;
+    }
 
-    hdc = BeginPaint(hwnd, &ps);
+    ClayGdiSignature* signatures = f->current;
+    for (int j = 0; j < renderCommands.length; j++)
+        signatures[j] = ClayGdi_Sign(Clay_RenderCommandArray_Get(&renderCommands, j));
 
-    int win_width = rc.right - rc.left,
-        win_height = rc.bottom - rc.top;
+    // Damage: boxes of commands that differ, old and new, by position
+    if (!f->valid)
+    {
+        ClayGdi_AddDamage(&rc);
+    }
+    else
+    {
+        int32_t common = renderCommands.length < f->previous_count ? renderCommands.length : f->previous_count;
+        for (int j = 0; j < common; j++)
+        {
+            if (signatures[j].hash == f->previous[j].hash)
+                continue;
+            ClayGdi_AddDamage(&f->previous[j].box);
+            ClayGdi_AddDamage(&signatures[j].box);
+        }
+        for (int j = common; j < f->previous_count; j++)
+            ClayGdi_AddDamage(&f->previous[j].box);
+        for (int j = common; j < renderCommands.length; j++)
+            ClayGdi_AddDamage(&signatures[j].box);
+    }
 
-    // Create an off-screen DC for double-buffering
-    renderer_hdcMem = CreateCompatibleDC(hdc);
-    renderer_hbmMem = CreateCompatibleBitmap(hdc, win_width, win_height);
+    f->current = f->previous;
+    f->previous = signatures;
+    f->previous_count = renderCommands.length;
+    f->valid = true;
 
-    renderer_hOld = SelectObject(renderer_hdcMem, renderer_hbmMem);
+    RECT damage_box;
+    HRGN damage = f->damage;
+    if (!damage || GetRgnBox(damage, &damage_box) == NULLREGION)
+        return true;
 
     // draw
 
+    SelectClipRgn(renderer_hdcMem, damage);
     for (int j = 0; j < renderCommands.length; j++)
     {
         Clay_RenderCommand *renderCommand = Clay_RenderCommandArray_Get(&renderCommands, j);
         Clay_BoundingBox boundingBox = renderCommand->boundingBox;
 
+        // Commands outside the damage cannot change a pixel; scissors always apply
+        if (renderCommand->commandType != CLAY_RENDER_COMMAND_TYPE_SCISSOR_START &&
+            renderCommand->commandType != CLAY_RENDER_COMMAND_TYPE_SCISSOR_END &&
+            !RectInRegion(damage, &signatures[j].box))
+            continue;
+
         switch (renderCommand->commandType)
         {
         case CLAY_RENDER_COMMAND_TYPE_TEXT:
@@ -405,6 +635,7 @@ void Clay_Win32_Render(HWND hwnd, Clay_RenderCommandArray renderCommands, HFONT*
                                             boundingBox.x + boundingBox.width,
                                             boundingBox.y + boundingBox.height);
 
+            CombineRgn(clipping_region, clipping_region, damage, RGN_AND);
             SelectClipRgn(renderer_hdcMem, clipping_region);
             break;
         }
@@ -412,7 +643,7 @@ void Clay_Win32_Render(HWND hwnd, Clay_RenderCommandArray renderCommands, HFONT*
         // The renderer should finish any previously active clipping, and begin rendering elements in full again.
         case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END:
         {
-            SelectClipRgn(renderer_hdcMem, NULL);
+            SelectClipRgn(renderer_hdcMem, damage);
 
             if (clipping_region)
             {
@@ -501,14 +732,61 @@ void Clay_Win32_Render(HWND hwnd, Clay_RenderCommandArray renderCommands, HFONT*
         }
     }
 
-    BitBlt(hdc, 0, 0, win_width, win_height, renderer_hdcMem, 0, 0, SRCCOPY);
+    SelectClipRgn(renderer_hdcMem, NULL);
+    return true;
+}
 
-    // Free-up the off-screen DC
-    SelectObject(renderer_hdcMem, renderer_hOld);
-    DeleteObject(renderer_hbmMem);
-    DeleteDC(renderer_hdcMem);
+/*
+ * Copy the damage to the window and clear it. From WM_PAINT the update
+ * region is copied as well (the back buffer already holds it); elsewhere
+ * only the damage is, through the window DC.
+ */
+void Clay_Win32_Present(HWND hwnd, bool from_paint)
+{
+    ClayGdiFrame* f = &g_clay_gdi_frame;
+    RECT box;
 
-    EndPaint(hwnd, &ps);
+    if (from_paint)
+    {
+        PAINTSTRUCT ps;
+        if (f->damage)
+            InvalidateRgn(hwnd, f->damage, FALSE);
+        HDC hdc = BeginPaint(hwnd, &ps);
+        if (f->hdc)
+            BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top, RECTWIDTH(ps.rcPaint), RECTHEIGHT(ps.rcPaint),
+                   f->hdc, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+        EndPaint(hwnd, &ps);
+    }
+    else if (f->hdc && f->damage && GetRgnBox(f->damage, &box) != NULLREGION)
+    {
+        HDC hdc = GetDC(hwnd);
+        SelectClipRgn(hdc, f->damage);
+        BitBlt(hdc, box.left, box.top, RECTWIDTH(box), RECTHEIGHT(box), f->hdc, box.left, box.top, SRCCOPY);
+        SelectClipRgn(hdc, NULL);
+        ReleaseDC(hwnd, hdc);
+    }
+
+    if (f->damage)
+        SetRectRgn(f->damage, 0, 0, 0, 0);
+}
+
+// Draw and present in one call from WM_PAINT
+void Clay_Win32_Render(HWND hwnd, Clay_RenderCommandArray renderCommands, HFONT* fonts)
+{
+    Clay_Win32_Draw(hwnd, renderCommands, fonts);
+    Clay_Win32_Present(hwnd, true);
+}
+
+// Free the back buffer and the frame signatures
+void Clay_Win32_Shutdown(void)
+{
+    ClayGdiFrame* f = &g_clay_gdi_frame;
+    ClayGdi_FreeBackBuffer();
+    if (f->damage)
+        DeleteObject(f->damage);
+    free(f->previous);
+    free(f->current);
+    ZeroMemory(f, sizeof(*f));
 }
 
 /*
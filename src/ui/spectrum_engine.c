@@ -0,0 +1,268 @@
+/*
+ * IQ Lab - Background Spectrum Engine
+ *
+ * The request position and sequence are guarded by a mutex that the worker
+ * holds only to read them or to wait, never while computing, so a request
+ * from the render thread costs two stores and a signal. Frames travel back
+ * through an iq_triple_t and need no lock at all.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "spectrum_engine.h"
+#include "../iq_core/io_iq.h"
+#include "../iq_core/fft.h"
+#include "../iq_core/stft.h"
+#include "../iq_core/window.h"
+#include "../iq_core/triple_buffer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct spectrum_engine {
+    spectrum_engine_params_t params;
+    iq_reader_t reader;
+    fft_plan_f32_t *plan;
+    const window_t *window;      // Shared table (NULL for rectangular)
+    stft_t *stft;
+    float *samples;              // Span of interleaved I/Q
+    float *rows;                 // avg_frames * fft_size scratch rows
+    double *accum;               // fft_size power sums
+    iq_triple_t frames;          // spectrum_frame_t slots
+
+    spectrum_notify_fn notify;
+    void *user;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    uint64_t requested;          // Newest request number (lock)
+    uint64_t request_sample;     // Its position (lock)
+    uint64_t served;             // Last request computed (worker only)
+    bool stop;                   // Destroy requested (lock)
+};
+
+void spectrum_engine_default_params(spectrum_engine_params_t *params) {
+    if (!params) return;
+    params->fft_size = SPECTRUM_ENGINE_DEFAULT_FFT;
+    params->hop = SPECTRUM_ENGINE_DEFAULT_HOP;
+    params->avg_frames = SPECTRUM_ENGINE_DEFAULT_AVG;
+    params->columns = SPECTRUM_ENGINE_DEFAULT_COLUMNS;
+    params->window = NULL;
+    params->num_threads = 0;
+}
+
+uint64_t spectrum_engine_span(const spectrum_engine_t *engine) {
+    return (uint64_t)(engine->params.avg_frames - 1) * engine->params.hop + engine->params.fft_size;
+}
+
+uint64_t spectrum_engine_total_samples(const spectrum_engine_t *engine) {
+    return engine ? engine->reader.total_samples : 0;
+}
+
+uint32_t spectrum_engine_sample_rate(const spectrum_engine_t *engine) {
+    return engine ? engine->reader.sample_rate : 0;
+}
+
+// Read 'count' samples at 'start'; the reader may return short blocks
+static size_t spectrum_read_span(spectrum_engine_t *engine, uint64_t start, size_t count) {
+    if (!iq_reader_seek_sample(&engine->reader, start)) return 0;
+    size_t got = 0;
+    while (got < count) {
+        size_t n = iq_read_samples(&engine->reader, engine->samples + 2 * got, count - got);
+        if (n == 0) break;
+        got += n;
+    }
+    return got;
+}
+
+// Average the frames at 'start', max-pool to columns and scale over the dB range
+static void spectrum_compute(spectrum_engine_t *engine, uint64_t request, uint64_t start) {
+    const spectrum_engine_params_t *p = &engine->params;
+    const uint64_t total = engine->reader.total_samples;
+    const uint64_t span = spectrum_engine_span(engine);
+
+    spectrum_frame_t *frame = iq_triple_back(&engine->frames);
+    memset(frame, 0, engine->frames.slot_bytes);
+    frame->request = request;
+    frame->columns = p->columns;
+
+    if (total > span) {
+        if (start > total - span) start = total - span;
+    } else {
+        start = 0;
+    }
+    uint32_t frames = 0;
+    size_t got = spectrum_read_span(engine, start, (size_t)span);
+    if (got >= p->fft_size) {
+        frames = (uint32_t)((got - p->fft_size) / p->hop + 1);
+        if (frames > p->avg_frames) frames = p->avg_frames;
+    }
+    frame->start_sample = start;
+
+    memset(engine->accum, 0, p->fft_size * sizeof(double));
+    if (frames > 0 && !stft_accumulate(engine->stft, engine->samples, frames, p->hop,
+                                       engine->rows, engine->accum)) {
+        frames = 0;
+    }
+    frame->frames = frames;
+
+    if (frames > 0) {
+        float lo = INFINITY, hi = -INFINITY;
+        for (uint32_t c = 0; c < p->columns; c++) {
+            size_t b0 = (size_t)c * p->fft_size / p->columns;
+            size_t b1 = (size_t)(c + 1) * p->fft_size / p->columns;
+            if (b1 <= b0) b1 = b0 + 1;
+            double peak = 0.0;
+            for (size_t k = b0; k < b1; k++) {
+                if (engine->accum[k] > peak) peak = engine->accum[k];
+            }
+            float db = (float)(10.0 * log10(peak / (double)frames + 1e-12));
+            frame->level[c] = db;
+            if (db < lo) lo = db;
+            if (db > hi) hi = db;
+        }
+        for (uint32_t c = 0; c < p->columns; c++) {
+            frame->level[c] = hi > lo ? (frame->level[c] - lo) / (hi - lo) : 0.0f;
+        }
+        frame->min_db = lo;
+        frame->max_db = hi;
+    }
+
+    iq_triple_publish(&engine->frames);
+    if (engine->notify) engine->notify(engine->user);
+}
+
+static void *spectrum_worker(void *arg) {
+    spectrum_engine_t *engine = arg;
+    for (;;) {
+        pthread_mutex_lock(&engine->lock);
+        while (!engine->stop && engine->requested == engine->served) {
+            pthread_cond_wait(&engine->wake, &engine->lock);
+        }
+        if (engine->stop) {
+            pthread_mutex_unlock(&engine->lock);
+            break;
+        }
+        // Requests that arrived meanwhile are skipped for the newest
+        const uint64_t request = engine->requested;
+        const uint64_t start = engine->request_sample;
+        pthread_mutex_unlock(&engine->lock);
+
+        spectrum_compute(engine, request, start);
+        engine->served = request;
+    }
+    return NULL;
+}
+
+static void spectrum_engine_release(spectrum_engine_t *engine) {
+    stft_destroy(engine->stft);
+    window_release(engine->window);
+    fft_plan_f32_destroy(engine->plan);
+    iq_reader_close(&engine->reader);
+    iq_triple_free(&engine->frames);
+    free(engine->samples);
+    free(engine->rows);
+    free(engine->accum);
+    free(engine);
+}
+
+spectrum_engine_t *spectrum_engine_create(const char *path, const spectrum_engine_params_t *params,
+                                          spectrum_notify_fn notify, void *user) {
+    spectrum_engine_params_t defaults;
+    if (!params) {
+        spectrum_engine_default_params(&defaults);
+        params = &defaults;
+    }
+    if (!path || params->fft_size < 2 || (params->fft_size & (params->fft_size - 1)) ||
+        params->hop == 0 || params->avg_frames == 0 || params->columns == 0) {
+        fprintf(stderr, "Error: Invalid spectrum view geometry\n");
+        return NULL;
+    }
+    window_type_t window_type = WINDOW_HANN;
+    if (params->window && !window_type_from_name(params->window, &window_type)) {
+        fprintf(stderr, "Error: Unknown window: %s\n", params->window);
+        return NULL;
+    }
+
+    spectrum_engine_t *engine = calloc(1, sizeof(*engine));
+    if (!engine) return NULL;
+    engine->params = *params;
+    engine->params.window = NULL;
+    engine->notify = notify;
+    engine->user = user;
+
+    if (!iq_reader_open(&engine->reader, path)) {
+        free(engine);
+        return NULL;
+    }
+
+    const size_t span = (size_t)spectrum_engine_span(engine);
+    engine->plan = fft_plan_f32_create(params->fft_size, FFT_FORWARD);
+    if (window_type != WINDOW_RECTANGULAR) {
+        double param = (window_type == WINDOW_KAISER) ? WINDOW_KAISER_DEFAULT_BETA : 0.0;
+        engine->window = window_acquire(window_type, params->fft_size, param);
+    }
+    if (engine->plan && (engine->window || window_type == WINDOW_RECTANGULAR)) {
+        engine->stft = stft_create(engine->plan, engine->window ? engine->window->coefficients_f32 : NULL,
+                                   params->num_threads);
+    }
+    engine->samples = malloc(span * 2 * sizeof(float));
+    engine->rows = malloc((size_t)params->avg_frames * params->fft_size * sizeof(float));
+    engine->accum = malloc(params->fft_size * sizeof(double));
+    bool ok = engine->stft && engine->samples && engine->rows && engine->accum &&
+              iq_triple_init(&engine->frames, sizeof(spectrum_frame_t) + params->columns * sizeof(float));
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to set up the spectrum engine\n");
+        spectrum_engine_release(engine);
+        return NULL;
+    }
+
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->wake, NULL);
+    if (pthread_create(&engine->thread, NULL, spectrum_worker, engine) != 0) {
+        fprintf(stderr, "Error: Failed to start the spectrum worker\n");
+        pthread_cond_destroy(&engine->wake);
+        pthread_mutex_destroy(&engine->lock);
+        spectrum_engine_release(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+uint64_t spectrum_engine_request(spectrum_engine_t *engine, uint64_t start_sample) {
+    if (!engine) return 0;
+    pthread_mutex_lock(&engine->lock);
+    const uint64_t request = ++engine->requested;
+    engine->request_sample = start_sample;
+    pthread_cond_signal(&engine->wake);
+    pthread_mutex_unlock(&engine->lock);
+    return request;
+}
+
+const spectrum_frame_t *spectrum_engine_poll(spectrum_engine_t *engine, bool *fresh) {
+    if (!engine) {
+        if (fresh) *fresh = false;
+        return NULL;
+    }
+    bool changed = iq_triple_acquire(&engine->frames);
+    if (fresh) *fresh = changed;
+    return iq_triple_front(&engine->frames);
+}
+
+void spectrum_engine_destroy(spectrum_engine_t *engine) {
+    if (!engine) return;
+    pthread_mutex_lock(&engine->lock);
+    engine->stop = true;
+    pthread_cond_signal(&engine->wake);
+    pthread_mutex_unlock(&engine->lock);
+    pthread_join(engine->thread, NULL);
+
+    pthread_cond_destroy(&engine->wake);
+    pthread_mutex_destroy(&engine->lock);
+    spectrum_engine_release(engine);
+}
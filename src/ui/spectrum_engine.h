@@ -0,0 +1,85 @@
+#ifndef IQ_LAB_SPECTRUM_ENGINE_H
+#define IQ_LAB_SPECTRUM_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Background spectrum engine for interactive views
+ * A worker thread owns the file reader, FFT plan and STFT engine. The view
+ * asks for the spectrum at a sample position with spectrum_engine_request(),
+ * which only records the position and wakes the worker; requests made while
+ * the worker is busy collapse into the newest one. Each result is published
+ * through a triple buffer (triple_buffer.h), so spectrum_engine_poll() never
+ * waits and always returns the most recent frame.
+ *
+ * Platform neutral (pthread); the Win32 UI posts itself a message from the
+ * notify callback and polls on that message.
+ */
+
+// Defaults matching the UI controls
+#define SPECTRUM_ENGINE_DEFAULT_FFT     4096
+#define SPECTRUM_ENGINE_DEFAULT_HOP     1024
+#define SPECTRUM_ENGINE_DEFAULT_AVG     20
+#define SPECTRUM_ENGINE_DEFAULT_COLUMNS 512
+
+typedef struct spectrum_engine spectrum_engine_t;
+
+typedef struct {
+    uint32_t fft_size;        // Power of two
+    uint32_t hop;             // Frame spacing in samples
+    uint32_t avg_frames;      // Frames averaged per spectrum
+    uint32_t columns;         // Display columns the bins are max-pooled into
+    const char *window;       // Window name (NULL for Hann)
+    uint32_t num_threads;     // STFT threads including the worker, 0 = one per CPU
+} spectrum_engine_params_t;
+
+// One published spectrum
+typedef struct {
+    uint64_t request;         // Request it answers (0 = nothing computed yet)
+    uint64_t start_sample;    // First sample averaged, after clamping to the file
+    uint32_t frames;          // Frames averaged (0 if the file is shorter than one)
+    uint32_t columns;
+    float min_db;             // dB range the levels are scaled over
+    float max_db;
+    float level[];            // 'columns' levels in [0, 1], lowest frequency first
+} spectrum_frame_t;
+
+// Called on the worker thread after each publish
+typedef void (*spectrum_notify_fn)(void *user);
+
+void spectrum_engine_default_params(spectrum_engine_params_t *params);
+
+/*
+ * Open 'path' (same detection as iq_reader_open) and start the worker
+ * Returns NULL, with the reason on stderr, if the file or the geometry is
+ * unusable. Nothing is computed until the first request.
+ */
+spectrum_engine_t *spectrum_engine_create(const char *path, const spectrum_engine_params_t *params,
+                                          spectrum_notify_fn notify, void *user);
+
+// Complex samples in the file, and its rate (0 for raw files)
+uint64_t spectrum_engine_total_samples(const spectrum_engine_t *engine);
+uint32_t spectrum_engine_sample_rate(const spectrum_engine_t *engine);
+
+// Samples covered by one averaged spectrum: (avg_frames - 1) * hop + fft_size
+uint64_t spectrum_engine_span(const spectrum_engine_t *engine);
+
+/*
+ * Ask for the spectrum starting at 'start_sample' (clamped so the span fits)
+ * Returns the request number a frame will carry. Never waits for DSP.
+ */
+uint64_t spectrum_engine_request(spectrum_engine_t *engine, uint64_t start_sample);
+
+/*
+ * Newest frame (consumer side, one thread)
+ * 'fresh' tells whether it changed since the previous poll. The frame stays
+ * valid until the next poll.
+ */
+const spectrum_frame_t *spectrum_engine_poll(spectrum_engine_t *engine, bool *fresh);
+
+// Stop the worker (finishing its current spectrum) and free everything
+void spectrum_engine_destroy(spectrum_engine_t *engine);
+
+#endif // IQ_LAB_SPECTRUM_ENGINE_H
@@ -0,0 +1,765 @@
+/*
+ * IQ Lab - Viewport-Driven Waterfall Tiles
+ *
+ * Cached tiles live in a chained hash table and a doubly linked LRU list
+ * (head = most recently used). The queue holds wanted keys in priority
+ * order; a worker removes the first key together with every other queued
+ * key of the same level and tile row, and lists them as in flight until the
+ * finished tiles are inserted, so no tile is queued twice or computed twice.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "tile_view.h"
+#include "../iq_core/io_iq.h"
+#include "../iq_core/fft.h"
+#include "../iq_core/stft.h"
+#include "../iq_core/window.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define TILE_VIEW_BUCKETS      4096u   // Hash buckets (power of two)
+#define TILE_VIEW_STRIP_MAX    16u     // Tiles of one row taken per worker pass
+#define TILE_VIEW_CHUNK_FRAMES 32u     // Consecutive frames per STFT call
+
+typedef struct {
+    uint32_t level;
+    uint32_t col;
+    uint64_t row;
+} tile_key_t;
+
+typedef struct tile_entry {
+    tile_key_t key;
+    uint32_t rows, cols;
+    uint32_t refs;                     // Pins held by renders in progress
+    size_t bytes;                      // Charged against the cache budget
+    struct tile_entry *hash_next;
+    struct tile_entry *lru_prev, *lru_next;
+    float cells[];                     // rows * cols, row-major
+} tile_entry_t;
+
+typedef struct {
+    tile_view_t *view;
+    pthread_t thread;
+    iq_reader_t reader;
+    stft_t *stft;
+    float *samples;                    // Span of TILE_VIEW_CHUNK_FRAMES frames
+    float *rows;                       // Their spectral rows
+    tile_key_t keys[TILE_VIEW_STRIP_MAX]; // Strip in flight (lock)
+    uint32_t num_keys;
+} tile_worker_t;
+
+struct tile_view {
+    tile_view_params_t params;
+    tile_pyramid_info_t info;
+    uint32_t level_width[TILE_PYRAMID_MAX_LEVELS];
+    uint64_t level_rows[TILE_PYRAMID_MAX_LEVELS];
+    uint32_t tile_cols[TILE_PYRAMID_MAX_LEVELS];
+    uint64_t tile_rows[TILE_PYRAMID_MAX_LEVELS];
+
+    bool use_pyramid;
+    tile_pyramid_reader_t pyramid;
+    float *pyramid_cells;              // Full tile read buffer (pyramid_lock)
+    pthread_mutex_t pyramid_lock;      // The reader seeks a shared FILE
+
+    bool can_compute;                  // IQ fallback available
+    fft_plan_f32_t *plan;
+    const window_t *window;            // Shared table (NULL for rectangular)
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    tile_entry_t **buckets;
+    tile_entry_t *lru_head, *lru_tail;
+    tile_key_t *queue;                 // Wanted tiles, first = most urgent
+    size_t queue_len, queue_cap;
+    tile_view_stats_t stats;
+    bool stop;
+
+    tile_worker_t workers[TILE_VIEW_MAX_WORKERS];
+    uint32_t num_workers;
+    tile_view_notify_fn notify;
+    void *user;
+};
+
+void tile_view_default_params(tile_view_params_t *params) {
+    if (!params) return;
+    memset(params, 0, sizeof(*params));
+    params->fft_size = 4096;
+    params->hop = 1024;
+    params->tile_size = TILE_PYRAMID_DEFAULT_TILE;
+    params->pool = TILE_POOL_MAX;
+    params->max_frames_per_row = TILE_VIEW_DEFAULT_FRAMES_PER_ROW;
+    params->cache_bytes = TILE_VIEW_DEFAULT_CACHE_BYTES;
+}
+
+static bool tile_key_equal(const tile_key_t *a, const tile_key_t *b) {
+    return a->level == b->level && a->col == b->col && a->row == b->row;
+}
+
+static uint32_t tile_key_hash(const tile_key_t *key) {
+    uint64_t h = key->row * 0x9E3779B97F4A7C15ull;
+    h ^= ((uint64_t)key->col << 8 | key->level) * 0xC2B2AE3D27D4EB4Full;
+    return (uint32_t)(h >> 40) & (TILE_VIEW_BUCKETS - 1);
+}
+
+// Cache primitives (lock held)
+static tile_entry_t *tile_cache_find(tile_view_t *view, const tile_key_t *key) {
+    for (tile_entry_t *e = view->buckets[tile_key_hash(key)]; e; e = e->hash_next) {
+        if (tile_key_equal(&e->key, key)) return e;
+    }
+    return NULL;
+}
+
+static void tile_lru_unlink(tile_view_t *view, tile_entry_t *e) {
+    if (e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+    else view->lru_head = e->lru_next;
+    if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+    else view->lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void tile_lru_push_front(tile_view_t *view, tile_entry_t *e) {
+    e->lru_prev = NULL;
+    e->lru_next = view->lru_head;
+    if (view->lru_head) view->lru_head->lru_prev = e;
+    view->lru_head = e;
+    if (!view->lru_tail) view->lru_tail = e;
+}
+
+static void tile_lru_touch(tile_view_t *view, tile_entry_t *e) {
+    if (view->lru_head == e) return;
+    tile_lru_unlink(view, e);
+    tile_lru_push_front(view, e);
+}
+
+static void tile_cache_remove(tile_view_t *view, tile_entry_t *e) {
+    tile_entry_t **link = &view->buckets[tile_key_hash(&e->key)];
+    while (*link != e) link = &(*link)->hash_next;
+    *link = e->hash_next;
+    tile_lru_unlink(view, e);
+    view->stats.cached_tiles--;
+    view->stats.cached_bytes -= e->bytes;
+    free(e);
+}
+
+// Least recently used unpinned tiles go until the budget holds
+static void tile_cache_trim(tile_view_t *view) {
+    tile_entry_t *e = view->lru_tail;
+    while (e && view->stats.cached_bytes > view->params.cache_bytes) {
+        tile_entry_t *prev = e->lru_prev;
+        if (e->refs == 0) {
+            tile_cache_remove(view, e);
+            view->stats.evicted_tiles++;
+        }
+        e = prev;
+    }
+}
+
+static void tile_cache_insert(tile_view_t *view, tile_entry_t *e) {
+    if (tile_cache_find(view, &e->key)) {
+        free(e);
+        return;
+    }
+    uint32_t h = tile_key_hash(&e->key);
+    e->hash_next = view->buckets[h];
+    view->buckets[h] = e;
+    tile_lru_push_front(view, e);
+    view->stats.cached_tiles++;
+    view->stats.cached_bytes += e->bytes;
+}
+
+static bool tile_in_flight(const tile_view_t *view, const tile_key_t *key) {
+    for (uint32_t w = 0; w < view->num_workers; w++) {
+        for (uint32_t k = 0; k < view->workers[w].num_keys; k++) {
+            if (tile_key_equal(&view->workers[w].keys[k], key)) return true;
+        }
+    }
+    return false;
+}
+
+// Cells of a tile at its level (edge tiles are smaller)
+static void tile_extent(const tile_view_t *view, const tile_key_t *key, uint32_t *rows, uint32_t *cols) {
+    const uint32_t tile = view->info.tile_size;
+    uint64_t rows_left = view->level_rows[key->level] - key->row * tile;
+    uint32_t cols_left = view->level_width[key->level] - key->col * tile;
+    *rows = rows_left < tile ? (uint32_t)rows_left : tile;
+    *cols = cols_left < tile ? cols_left : tile;
+}
+
+static tile_entry_t *tile_entry_new(const tile_view_t *view, const tile_key_t *key) {
+    uint32_t rows, cols;
+    tile_extent(view, key, &rows, &cols);
+    size_t bytes = sizeof(tile_entry_t) + (size_t)rows * cols * sizeof(float);
+    tile_entry_t *e = calloc(1, bytes);
+    if (!e) return NULL;
+    e->key = *key;
+    e->rows = rows;
+    e->cols = cols;
+    e->bytes = bytes;
+    return e;
+}
+
+// Read 'count' samples at 'start'; the reader may return short blocks
+static size_t tile_read_span(tile_worker_t *worker, uint64_t start, size_t count) {
+    if (!iq_reader_seek_sample(&worker->reader, start)) return 0;
+    size_t got = 0;
+    while (got < count) {
+        size_t n = iq_read_samples(&worker->reader, worker->samples + 2 * got, count - got);
+        if (n == 0) break;
+        got += n;
+    }
+    return got;
+}
+
+/*
+ * Compute the tiles of one level and tile row from the IQ file. Frames
+ * whose rows feed the strip are listed in order and transformed in runs of
+ * consecutive frames; each row is pooled into every tile of the strip.
+ */
+static bool tile_compute_strip(tile_worker_t *worker, tile_entry_t **entries, uint32_t count) {
+    tile_view_t *view = worker->view;
+    const tile_key_t *key = &entries[0]->key;
+    const uint32_t level = key->level;
+    const uint64_t scale = 1ull << level;
+    const uint32_t tile = view->info.tile_size;
+    const uint32_t width = view->info.width;
+    const uint64_t rows0 = view->info.num_rows;
+    const uint32_t max_frames = view->params.max_frames_per_row;
+    const bool mean = view->info.pool == TILE_POOL_MEAN;
+    const uint32_t out_rows = entries[0]->rows;
+
+    uint64_t *frames = malloc((size_t)out_rows * max_frames * sizeof(uint64_t));
+    uint32_t *dest = malloc((size_t)out_rows * max_frames * sizeof(uint32_t));
+    uint32_t *weight = calloc(out_rows, sizeof(uint32_t));   // Frames pooled per row (mean)
+    if (!frames || !dest || !weight) {
+        free(frames);
+        free(dest);
+        free(weight);
+        return false;
+    }
+
+    size_t num_frames = 0;
+    for (uint32_t y = 0; y < out_rows; y++) {
+        uint64_t r0 = (key->row * tile + y) * scale;
+        uint64_t r1 = r0 + scale < rows0 ? r0 + scale : rows0;
+        uint64_t n = r1 - r0;
+        uint64_t take = n < max_frames ? n : max_frames;
+        for (uint64_t k = 0; k < take; k++) {
+            frames[num_frames] = r0 + k * n / take;
+            dest[num_frames++] = y;
+        }
+    }
+
+    const size_t hop = view->params.hop;
+    bool ok = true;
+    size_t i = 0;
+    while (ok && i < num_frames) {
+        size_t run = 1;
+        while (i + run < num_frames && run < TILE_VIEW_CHUNK_FRAMES && frames[i + run] == frames[i] + run) run++;
+
+        size_t span = (run - 1) * hop + width;
+        size_t got = tile_read_span(worker, frames[i] * hop, span);
+        if (got < width) break;
+        if (got < span) run = (got - width) / hop + 1;
+        if (!stft_rows(worker->stft, worker->samples, (uint32_t)run, hop, worker->rows, false)) {
+            ok = false;
+            break;
+        }
+
+        for (size_t f = 0; f < run; f++) {
+            const float *row = worker->rows + f * width;
+            const uint32_t y = dest[i + f];
+            weight[y]++;
+            for (uint32_t t = 0; t < count; t++) {
+                tile_entry_t *e = entries[t];
+                float *cells = e->cells + (size_t)y * e->cols;
+                for (uint32_t x = 0; x < e->cols; x++) {
+                    uint64_t b0 = ((uint64_t)e->key.col * tile + x) * scale;
+                    uint64_t b1 = b0 + scale < width ? b0 + scale : width;
+                    float v = mean ? 0.0f : cells[x];
+                    for (uint64_t b = b0; b < b1; b++) {
+                        if (mean) v += row[b];
+                        else if (row[b] > v) v = row[b];
+                    }
+                    if (mean) cells[x] += v / (float)(b1 - b0);
+                    else cells[x] = v;
+                }
+            }
+        }
+        i += run;
+    }
+
+    if (mean) {
+        for (uint32_t t = 0; t < count; t++) {
+            tile_entry_t *e = entries[t];
+            for (uint32_t y = 0; y < e->rows; y++) {
+                if (weight[y] < 2) continue;
+                for (uint32_t x = 0; x < e->cols; x++) e->cells[(size_t)y * e->cols + x] /= (float)weight[y];
+            }
+        }
+    }
+
+    free(frames);
+    free(dest);
+    free(weight);
+    return ok;
+}
+
+// Pyramid tiles first; anything it lacks is computed when the IQ file allows
+static uint32_t tile_produce(tile_worker_t *worker, const tile_key_t *keys, uint32_t count,
+                             tile_entry_t **out, uint64_t *from_pyramid) {
+    tile_view_t *view = worker->view;
+    tile_entry_t *compute[TILE_VIEW_STRIP_MAX];
+    uint32_t produced = 0, to_compute = 0;
+    *from_pyramid = 0;
+
+    for (uint32_t k = 0; k < count; k++) {
+        tile_entry_t *e = tile_entry_new(view, &keys[k]);
+        if (!e) continue;
+        if (view->use_pyramid) {
+            uint32_t rows, cols;
+            pthread_mutex_lock(&view->pyramid_lock);
+            bool read = tile_pyramid_read_tile(&view->pyramid, keys[k].level, keys[k].row, keys[k].col,
+                                               view->pyramid_cells, &rows, &cols) &&
+                        rows == e->rows && cols == e->cols;
+            if (read) memcpy(e->cells, view->pyramid_cells, (size_t)rows * cols * sizeof(float));
+            pthread_mutex_unlock(&view->pyramid_lock);
+            if (read) {
+                out[produced++] = e;
+                (*from_pyramid)++;
+                continue;
+            }
+        }
+        if (view->can_compute) compute[to_compute++] = e;
+        else free(e);
+    }
+
+    if (to_compute > 0) {
+        if (tile_compute_strip(worker, compute, to_compute)) {
+            for (uint32_t t = 0; t < to_compute; t++) out[produced++] = compute[t];
+        } else {
+            for (uint32_t t = 0; t < to_compute; t++) free(compute[t]);
+        }
+    }
+    return produced;
+}
+
+static void *tile_worker_main(void *arg) {
+    tile_worker_t *worker = arg;
+    tile_view_t *view = worker->view;
+
+    pthread_mutex_lock(&view->lock);
+    for (;;) {
+        while (!view->stop && view->queue_len == 0) {
+            pthread_cond_wait(&view->work, &view->lock);
+        }
+        if (view->stop) break;
+
+        // The most urgent tile and the rest of its row
+        const tile_key_t first = view->queue[0];
+        worker->num_keys = 0;
+        size_t kept = 0;
+        for (size_t q = 0; q < view->queue_len; q++) {
+            const tile_key_t *key = &view->queue[q];
+            if (worker->num_keys < TILE_VIEW_STRIP_MAX && key->level == first.level && key->row == first.row) {
+                worker->keys[worker->num_keys++] = *key;
+            } else {
+                view->queue[kept++] = *key;
+            }
+        }
+        view->queue_len = kept;
+        view->stats.queued_tiles = kept;
+        view->stats.busy_workers++;
+        pthread_mutex_unlock(&view->lock);
+
+        tile_entry_t *made[TILE_VIEW_STRIP_MAX];
+        uint64_t from_pyramid;
+        uint32_t produced = tile_produce(worker, worker->keys, worker->num_keys, made, &from_pyramid);
+
+        pthread_mutex_lock(&view->lock);
+        for (uint32_t t = 0; t < produced; t++) tile_cache_insert(view, made[t]);
+        view->stats.pyramid_tiles += from_pyramid;
+        view->stats.computed_tiles += produced - from_pyramid;
+        tile_cache_trim(view);
+        worker->num_keys = 0;
+        view->stats.busy_workers--;
+        pthread_mutex_unlock(&view->lock);
+
+        if (produced > 0 && view->notify) view->notify(view->user);
+        pthread_mutex_lock(&view->lock);
+    }
+    pthread_mutex_unlock(&view->lock);
+    return NULL;
+}
+
+// Level-0 map geometry and the per-level sizes derived from it
+static void tile_view_set_geometry(tile_view_t *view) {
+    uint32_t width = view->info.width;
+    uint64_t rows = view->info.num_rows;
+    for (uint32_t l = 0; l < view->info.num_levels; l++) {
+        view->level_width[l] = width;
+        view->level_rows[l] = rows;
+        view->tile_cols[l] = (width + view->info.tile_size - 1) / view->info.tile_size;
+        view->tile_rows[l] = (rows + view->info.tile_size - 1) / view->info.tile_size;
+        width = (width + 1) / 2;
+        rows = (rows + 1) / 2;
+    }
+}
+
+static void tile_view_release(tile_view_t *view) {
+    for (uint32_t w = 0; w < TILE_VIEW_MAX_WORKERS; w++) {
+        tile_worker_t *worker = &view->workers[w];
+        stft_destroy(worker->stft);
+        iq_reader_close(&worker->reader);
+        free(worker->samples);
+        free(worker->rows);
+    }
+    if (view->buckets) {
+        while (view->lru_head) tile_cache_remove(view, view->lru_head);
+        free(view->buckets);
+    }
+    if (view->use_pyramid) tile_pyramid_reader_close(&view->pyramid);
+    free(view->pyramid_cells);
+    window_release(view->window);
+    fft_plan_f32_destroy(view->plan);
+    free(view->queue);
+    free(view);
+}
+
+tile_view_t *tile_view_create(const char *iq_path, const tile_view_params_t *params,
+                              tile_view_notify_fn notify, void *user) {
+    tile_view_params_t defaults;
+    if (!params) {
+        tile_view_default_params(&defaults);
+        params = &defaults;
+    }
+    if (!iq_path || params->tile_size == 0 || params->max_frames_per_row == 0 ||
+        (params->pool != TILE_POOL_MAX && params->pool != TILE_POOL_MEAN)) {
+        fprintf(stderr, "Error: Invalid waterfall tile parameters\n");
+        return NULL;
+    }
+    window_type_t window_type = WINDOW_HANN;
+    if (params->window && !window_type_from_name(params->window, &window_type)) {
+        fprintf(stderr, "Error: Unknown window: %s\n", params->window);
+        return NULL;
+    }
+
+    tile_view_t *view = calloc(1, sizeof(*view));
+    if (!view) return NULL;
+    view->params = *params;
+    view->params.window = NULL;
+    view->params.pyramid_path = NULL;
+    view->notify = notify;
+    view->user = user;
+
+    // When the workers open their readers, the first one checks the file
+    iq_reader_t probe;
+    if (!iq_reader_open(&probe, iq_path)) {
+        free(view);
+        return NULL;
+    }
+    const uint64_t total = probe.total_samples;
+    const uint32_t rate = probe.sample_rate;
+    iq_reader_close(&probe);
+
+    if (params->pyramid_path && tile_pyramid_reader_open(&view->pyramid, params->pyramid_path)) {
+        view->use_pyramid = true;
+        view->info = view->pyramid.info;
+        view->params.tile_size = view->info.tile_size;
+        view->params.pool = view->info.pool;
+        view->params.fft_size = view->info.width;
+        double hop = view->info.row_seconds * view->info.sample_rate;
+        view->params.hop = hop >= 1.0 ? (uint32_t)llround(hop) : 0;
+    } else {
+        if (params->pyramid_path) {
+            fprintf(stderr, "Warning: Ignoring tile pyramid %s; computing tiles\n", params->pyramid_path);
+        }
+        const uint32_t fft = params->fft_size;
+        view->info.tile_size = params->tile_size;
+        view->info.width = fft;
+        view->info.pool = params->pool;
+        view->info.num_rows = (fft > 0 && params->hop > 0 && total >= fft) ? (total - fft) / params->hop + 1 : 0;
+        view->info.num_levels = tile_pyramid_levels_for(fft, view->info.num_rows, params->tile_size);
+        view->info.sample_rate = rate;
+        view->info.row_seconds = rate ? (double)params->hop / rate : 0.0;
+        view->info.freq_step_hz = fft ? (double)rate / fft : 0.0;
+        view->info.freq_start_hz = -(double)(fft / 2) * view->info.freq_step_hz;
+    }
+    tile_view_set_geometry(view);
+
+    // The IQ fallback needs a power-of-two FFT and a known hop
+    const uint32_t fft = view->params.fft_size;
+    if (fft >= 2 && (fft & (fft - 1)) == 0 && view->params.hop > 0) {
+        view->plan = fft_plan_f32_create(fft, FFT_FORWARD);
+        if (window_type != WINDOW_RECTANGULAR) {
+            double param = (window_type == WINDOW_KAISER) ? WINDOW_KAISER_DEFAULT_BETA : 0.0;
+            view->window = window_acquire(window_type, fft, param);
+        }
+        view->can_compute = view->plan && (view->window || window_type == WINDOW_RECTANGULAR);
+    }
+    if (!view->use_pyramid && !view->can_compute) {
+        fprintf(stderr, "Error: Invalid waterfall geometry (FFT %u, hop %u)\n", fft, view->params.hop);
+        tile_view_release(view);
+        return NULL;
+    }
+
+    uint32_t workers = params->num_workers;
+    if (workers == 0) {
+        uint32_t cpus = stft_default_threads();
+        workers = cpus > 1 ? cpus - 1 : 1;
+    }
+    if (workers > TILE_VIEW_MAX_WORKERS) workers = TILE_VIEW_MAX_WORKERS;
+
+    view->buckets = calloc(TILE_VIEW_BUCKETS, sizeof(tile_entry_t *));
+    bool ok = view->buckets != NULL;
+    if (ok && view->use_pyramid) {
+        view->pyramid_cells = malloc((size_t)view->info.tile_size * view->info.tile_size * sizeof(float));
+        ok = view->pyramid_cells != NULL;
+    }
+    for (uint32_t w = 0; ok && w < workers; w++) {
+        tile_worker_t *worker = &view->workers[w];
+        worker->view = view;
+        if (!view->can_compute) continue;
+        const size_t span = (size_t)(TILE_VIEW_CHUNK_FRAMES - 1) * view->params.hop + fft;
+        worker->samples = malloc(span * 2 * sizeof(float));
+        worker->rows = malloc((size_t)TILE_VIEW_CHUNK_FRAMES * fft * sizeof(float));
+        worker->stft = stft_create(view->plan, view->window ? view->window->coefficients_f32 : NULL, 1);
+        ok = worker->samples && worker->rows && worker->stft && iq_reader_open(&worker->reader, iq_path);
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to set up the waterfall workers\n");
+        tile_view_release(view);
+        return NULL;
+    }
+
+    pthread_mutex_init(&view->lock, NULL);
+    pthread_mutex_init(&view->pyramid_lock, NULL);
+    pthread_cond_init(&view->work, NULL);
+    for (uint32_t w = 0; w < workers; w++) {
+        if (pthread_create(&view->workers[w].thread, NULL, tile_worker_main, &view->workers[w]) != 0) {
+            fprintf(stderr, "Error: Failed to start waterfall worker %u\n", w);
+            break;
+        }
+        view->num_workers++;
+    }
+    if (view->num_workers == 0) {
+        pthread_cond_destroy(&view->work);
+        pthread_mutex_destroy(&view->pyramid_lock);
+        pthread_mutex_destroy(&view->lock);
+        tile_view_release(view);
+        return NULL;
+    }
+    return view;
+}
+
+const tile_pyramid_info_t *tile_view_info(const tile_view_t *view) {
+    return view ? &view->info : NULL;
+}
+
+uint32_t tile_view_hop(const tile_view_t *view) {
+    return view ? view->params.hop : 0;
+}
+
+bool tile_view_uses_pyramid(const tile_view_t *view) {
+    return view && view->use_pyramid;
+}
+
+uint32_t tile_view_level_for(const tile_view_t *view, const tile_viewport_t *viewport) {
+    if (!view || !viewport || viewport->width == 0 || viewport->height == 0) return 0;
+    double cells_per_px = fmax(viewport->rows / viewport->height, viewport->cols / viewport->width);
+    uint32_t level = 0;
+    while (level + 1 < view->info.num_levels && (double)(1ull << (level + 1)) <= cells_per_px) level++;
+    return level;
+}
+
+// Tile rows [*r0, *r1) and columns [*c0, *c1) covering the viewport at 'level'
+static bool tile_view_range(const tile_view_t *view, const tile_viewport_t *vp, uint32_t level,
+                            uint64_t *r0, uint64_t *r1, uint32_t *c0, uint32_t *c1) {
+    double a = fmax(vp->row0, 0.0), b = fmin(vp->row0 + vp->rows, (double)view->info.num_rows);
+    double c = fmax(vp->col0, 0.0), d = fmin(vp->col0 + vp->cols, (double)view->info.width);
+    if (!(b > a) || !(d > c) || vp->width == 0 || vp->height == 0) return false;
+
+    const uint64_t cell_span = (uint64_t)view->info.tile_size << level;
+    *r0 = (uint64_t)a / cell_span;
+    *r1 = ((uint64_t)ceil(b) - 1) / cell_span + 1;
+    *c0 = (uint32_t)((uint64_t)c / cell_span);
+    *c1 = (uint32_t)(((uint64_t)ceil(d) - 1) / cell_span + 1);
+    if (*r1 > view->tile_rows[level]) *r1 = view->tile_rows[level];
+    if (*c1 > view->tile_cols[level]) *c1 = view->tile_cols[level];
+    return *r1 > *r0 && *c1 > *c0;
+}
+
+typedef struct {
+    tile_key_t key;
+    double distance;
+} tile_wanted_t;
+
+static int tile_wanted_compare(const void *a, const void *b) {
+    double da = ((const tile_wanted_t *)a)->distance, db = ((const tile_wanted_t *)b)->distance;
+    return (da > db) - (da < db);
+}
+
+uint32_t tile_view_set_viewport(tile_view_t *view, const tile_viewport_t *viewport) {
+    if (!view || !viewport) return 0;
+    const uint32_t level = tile_view_level_for(view, viewport);
+    uint64_t r0, r1;
+    uint32_t c0, c1;
+    if (!tile_view_range(view, viewport, level, &r0, &r1, &c0, &c1)) {
+        pthread_mutex_lock(&view->lock);
+        view->queue_len = 0;
+        view->stats.queued_tiles = 0;
+        pthread_mutex_unlock(&view->lock);
+        return 0;
+    }
+
+    // Centre first, in tile units
+    const size_t visible = (size_t)(r1 - r0) * (c1 - c0);
+    tile_wanted_t *wanted = malloc(visible * sizeof(tile_wanted_t));
+    if (!wanted) return 0;
+    const double cell_span = (double)((uint64_t)view->info.tile_size << level);
+    const double cy = (viewport->row0 + 0.5 * viewport->rows) / cell_span - 0.5;
+    const double cx = (viewport->col0 + 0.5 * viewport->cols) / cell_span - 0.5;
+    size_t n = 0;
+    for (uint64_t r = r0; r < r1; r++) {
+        for (uint32_t c = c0; c < c1; c++) {
+            wanted[n].key = (tile_key_t){ level, c, r };
+            wanted[n].distance = ((double)r - cy) * ((double)r - cy) + ((double)c - cx) * ((double)c - cx);
+            n++;
+        }
+    }
+    qsort(wanted, n, sizeof(tile_wanted_t), tile_wanted_compare);
+
+    pthread_mutex_lock(&view->lock);
+    if (view->queue_cap < n) {
+        tile_key_t *queue = realloc(view->queue, n * sizeof(tile_key_t));
+        if (queue) {
+            view->queue = queue;
+            view->queue_cap = n;
+        }
+    }
+    view->queue_len = 0;
+    for (size_t i = 0; i < n; i++) {
+        tile_entry_t *e = tile_cache_find(view, &wanted[i].key);
+        if (e) {
+            tile_lru_touch(view, e);
+        } else if (view->queue_len < view->queue_cap && !tile_in_flight(view, &wanted[i].key)) {
+            view->queue[view->queue_len++] = wanted[i].key;
+        }
+    }
+    view->stats.queued_tiles = view->queue_len;
+    if (view->queue_len > 0) pthread_cond_broadcast(&view->work);
+    pthread_mutex_unlock(&view->lock);
+
+    free(wanted);
+    return (uint32_t)visible;
+}
+
+uint32_t tile_view_render(tile_view_t *view, const tile_viewport_t *viewport, float *pixels) {
+    if (!view || !viewport || !pixels) return 0;
+    const size_t num_pixels = (size_t)viewport->width * viewport->height;
+    for (size_t i = 0; i < num_pixels; i++) pixels[i] = NAN;
+
+    const uint32_t level = tile_view_level_for(view, viewport);
+    uint64_t r0, r1;
+    uint32_t c0, c1;
+    if (!tile_view_range(view, viewport, level, &r0, &r1, &c0, &c1)) return 0;
+
+    const uint32_t tile = view->info.tile_size;
+    const uint32_t tiles_across = c1 - c0;
+    const size_t visible = (size_t)(r1 - r0) * tiles_across;
+    tile_entry_t **pinned = calloc(visible, sizeof(tile_entry_t *));
+    int64_t *x_map = malloc(viewport->width * sizeof(int64_t));   // Level column per pixel, -1 outside
+    if (!pinned || !x_map) {
+        free(pinned);
+        free(x_map);
+        return (uint32_t)visible;
+    }
+
+    // Pin what is cached; the cells are read without the lock
+    uint32_t missing = 0;
+    pthread_mutex_lock(&view->lock);
+    for (uint64_t r = r0; r < r1; r++) {
+        for (uint32_t c = c0; c < c1; c++) {
+            tile_key_t key = { level, c, r };
+            tile_entry_t *e = tile_cache_find(view, &key);
+            if (e) {
+                e->refs++;
+                tile_lru_touch(view, e);
+            } else {
+                missing++;
+            }
+            pinned[(size_t)(r - r0) * tiles_across + (c - c0)] = e;
+        }
+    }
+    pthread_mutex_unlock(&view->lock);
+
+    for (uint32_t x = 0; x < viewport->width; x++) {
+        double col = viewport->col0 + (x + 0.5) * viewport->cols / viewport->width;
+        x_map[x] = (col >= 0.0 && col < view->info.width) ? (int64_t)((uint64_t)col >> level) : -1;
+    }
+    for (uint32_t y = 0; y < viewport->height; y++) {
+        double row = viewport->row0 + (y + 0.5) * viewport->rows / viewport->height;
+        if (row < 0.0 || row >= (double)view->info.num_rows) continue;
+        const uint64_t cell_row = (uint64_t)row >> level;
+        const uint64_t tile_row = cell_row / tile;
+        if (tile_row < r0 || tile_row >= r1) continue;
+        const uint32_t in_row = (uint32_t)(cell_row % tile);
+        tile_entry_t **strip = pinned + (size_t)(tile_row - r0) * tiles_across;
+        float *out = pixels + (size_t)y * viewport->width;
+        for (uint32_t x = 0; x < viewport->width; x++) {
+            if (x_map[x] < 0) continue;
+            const uint32_t tile_col = (uint32_t)(x_map[x] / tile);
+            if (tile_col < c0 || tile_col >= c1) continue;
+            const tile_entry_t *e = strip[tile_col - c0];
+            const uint32_t in_col = (uint32_t)(x_map[x] % tile);
+            if (e && in_row < e->rows && in_col < e->cols) out[x] = e->cells[(size_t)in_row * e->cols + in_col];
+        }
+    }
+
+    pthread_mutex_lock(&view->lock);
+    for (size_t i = 0; i < visible; i++) {
+        if (pinned[i]) pinned[i]->refs--;
+    }
+    tile_cache_trim(view);
+    pthread_mutex_unlock(&view->lock);
+
+    free(pinned);
+    free(x_map);
+    return missing;
+}
+
+bool tile_view_idle(tile_view_t *view) {
+    if (!view) return true;
+    pthread_mutex_lock(&view->lock);
+    bool idle = view->queue_len == 0 && view->stats.busy_workers == 0;
+    pthread_mutex_unlock(&view->lock);
+    return idle;
+}
+
+void tile_view_get_stats(tile_view_t *view, tile_view_stats_t *stats) {
+    if (!view || !stats) return;
+    pthread_mutex_lock(&view->lock);
+    *stats = view->stats;
+    pthread_mutex_unlock(&view->lock);
+}
+
+void tile_view_destroy(tile_view_t *view) {
+    if (!view) return;
+    pthread_mutex_lock(&view->lock);
+    view->stop = true;
+    pthread_cond_broadcast(&view->work);
+    pthread_mutex_unlock(&view->lock);
+    for (uint32_t w = 0; w < view->num_workers; w++) {
+        pthread_join(view->workers[w].thread, NULL);
+    }
+
+    pthread_cond_destroy(&view->work);
+    pthread_mutex_destroy(&view->pyramid_lock);
+    pthread_mutex_destroy(&view->lock);
+    tile_view_release(view);
+}
@@ -0,0 +1,116 @@
+#ifndef IQ_LAB_TILE_VIEW_H
+#define IQ_LAB_TILE_VIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "../viz/tile_pyramid.h"
+
+/*
+ * Viewport-driven waterfall tiles
+ * The time x frequency power map of a capture uses the tile grid of
+ * tile_pyramid.h: level 0 has one row per FFT frame and one column per bin,
+ * each further level pools 2x2 cells. A viewport (a level-0 row and column
+ * range drawn on width x height pixels) maps to one level and the tiles that
+ * cover it; only those tiles are ever produced.
+ *
+ * tile_view_set_viewport() replaces the queue of wanted tiles with the
+ * visible ones that are neither cached nor being computed, nearest to the
+ * viewport centre first, so panning away drops work nobody will see.
+ * Worker threads take one tile row at a time (every queued column of it,
+ * from one pass of FFTs) and read or compute its tiles:
+ *   - from a pyramid file (iqls --pyramid) when one is given, unchanged;
+ *   - otherwise from the IQ file through the STFT, pooling level-0 cells
+ *     like the pyramid. At coarse levels a row pools at most
+ *     max_frames_per_row frames spread over its interval, so zoomed-out
+ *     views cost a bounded number of FFTs (the pyramid keeps every frame).
+ *
+ * Finished tiles sit in an LRU cache bounded by cache_bytes; tiles pinned
+ * by a render in progress are never evicted. All shared state is behind one
+ * mutex that is held only for lookups and list updates, never during I/O
+ * or FFTs, so rendering from the UI thread does not wait on the workers.
+ */
+
+#define TILE_VIEW_DEFAULT_CACHE_BYTES ((size_t)256 << 20)
+#define TILE_VIEW_DEFAULT_FRAMES_PER_ROW 8
+#define TILE_VIEW_MAX_WORKERS 16
+
+typedef struct tile_view tile_view_t;
+
+typedef struct {
+    uint32_t fft_size;            // Level-0 columns (a pyramid brings its own)
+    uint32_t hop;                 // Level-0 row spacing in samples
+    uint32_t tile_size;           // Tile edge in cells
+    uint32_t pool;                // tile_pool_t between levels
+    const char *window;           // Window name (NULL for Hann)
+    uint32_t max_frames_per_row;  // FFT frames pooled into one computed row
+    size_t cache_bytes;           // LRU budget for cached tiles
+    uint32_t num_workers;         // 0 = one per CPU but one, at least 1
+    const char *pyramid_path;     // Optional .iqpyr of the same capture (or NULL)
+} tile_view_params_t;
+
+// Part of the level-0 map shown on a width x height pixel area
+typedef struct {
+    double row0, rows;            // First level-0 row and row count (time, top down)
+    double col0, cols;            // First level-0 column and column count (frequency)
+    uint32_t width, height;       // Pixels
+} tile_viewport_t;
+
+typedef struct {
+    uint64_t cached_tiles;
+    uint64_t cached_bytes;
+    uint64_t computed_tiles;      // Produced from the IQ file
+    uint64_t pyramid_tiles;       // Read from the pyramid file
+    uint64_t evicted_tiles;
+    uint64_t queued_tiles;        // Waiting for a worker
+    uint64_t busy_workers;
+} tile_view_stats_t;
+
+// Called on a worker thread after it adds tiles to the cache
+typedef void (*tile_view_notify_fn)(void *user);
+
+void tile_view_default_params(tile_view_params_t *params);
+
+/*
+ * Open the capture (and the pyramid, if given) and start the workers
+ * With a usable pyramid its geometry (bins, rows, tile size, pooling, hop)
+ * replaces the parameters. Returns NULL, with the reason on stderr, if the
+ * IQ file cannot be opened or the geometry is invalid.
+ */
+tile_view_t *tile_view_create(const char *iq_path, const tile_view_params_t *params,
+                              tile_view_notify_fn notify, void *user);
+
+// Geometry of the level-0 map (num_rows, width, num_levels, tile_size, ...)
+const tile_pyramid_info_t *tile_view_info(const tile_view_t *view);
+
+// Samples between level-0 rows (0 if a pyramid does not say)
+uint32_t tile_view_hop(const tile_view_t *view);
+
+// True when tiles come from the pyramid file
+bool tile_view_uses_pyramid(const tile_view_t *view);
+
+// Level whose cells are closest to, and not smaller than, one pixel
+uint32_t tile_view_level_for(const tile_view_t *view, const tile_viewport_t *viewport);
+
+/*
+ * Make 'viewport' the visible area: queue its missing tiles, drop queued
+ * tiles that are no longer visible. Returns the number of visible tiles.
+ */
+uint32_t tile_view_set_viewport(tile_view_t *view, const tile_viewport_t *viewport);
+
+/*
+ * Sample the cached tiles of 'viewport' into width * height linear power
+ * values, row-major, top row first. Pixels outside the map or in tiles not
+ * ready yet are NAN. Returns the number of visible tiles still missing.
+ */
+uint32_t tile_view_render(tile_view_t *view, const tile_viewport_t *viewport, float *pixels);
+
+// Nothing queued and no worker busy
+bool tile_view_idle(tile_view_t *view);
+
+void tile_view_get_stats(tile_view_t *view, tile_view_stats_t *stats);
+
+// Stop the workers (finishing their current row) and free the cache
+void tile_view_destroy(tile_view_t *view);
+
+#endif // IQ_LAB_TILE_VIEW_H
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 // Clay renderer integration
 #define CLAY_IMPLEMENTATION
@@ -17,13 +18,17 @@ static const Clay_Color UI_COLOR_BACKGROUND = {30, 30, 30, 255};
 static const Clay_Color UI_COLOR_SURFACE = {45, 45, 45, 255};
 static const Clay_Color UI_COLOR_TEXT = {230, 230, 230, 255};
 static const Clay_Color UI_COLOR_TEXT_SECONDARY = {180, 180, 180, 255};
+static const Clay_Color UI_COLOR_TRACE = {80, 170, 230, 255};
+static const Clay_Color UI_COLOR_TRACE_BACKGROUND = {50, 50, 50, 255};
 
 // Font ID
 #define FONT_ID_BODY 0
 
 // Forward declarations for Clay renderer
 Clay_Dimensions Clay_Win32_MeasureText(Clay_StringSlice text, Clay_TextElementConfig* config, void* userData);
-void Clay_Win32_Render(HWND hwnd, Clay_RenderCommandArray renderCommands, HFONT* fonts);
+bool Clay_Win32_Draw(HWND hwnd, Clay_RenderCommandArray renderCommands, HFONT* fonts);
+void Clay_Win32_Present(HWND hwnd, bool from_paint);
+bool Clay_Win32_IsDamaged(const RECT* rect);
 
 bool iq_ui_init(IQ_UI_Config* config) {
     if (!config) return false;
@@ -34,6 +39,7 @@ bool iq_ui_init(IQ_UI_Config* config) {
     g_ui_state.fft_size = 4096;
     g_ui_state.hop_size = 1024;
     g_ui_state.avg_count = 20;
+    colormap_init(&g_ui_state.colormap, COLORMAP_TURBO);
 
     // Create window
     g_ui_state.hwnd = iq_ui_create_window(config);
@@ -46,9 +52,9 @@ bool iq_ui_init(IQ_UI_Config* config) {
         return false;
     }
 
-    // Allocate spectrum buffer
-    g_ui_state.spectrum_size = g_ui_state.fft_size / 2;
-    g_ui_state.spectrum_data = (float*)malloc(g_ui_state.spectrum_size * sizeof(float));
+    // Allocate spectrum buffer: one level per display column
+    g_ui_state.spectrum_size = SPECTRUM_ENGINE_DEFAULT_COLUMNS;
+    g_ui_state.spectrum_data = (float*)calloc(g_ui_state.spectrum_size, sizeof(float));
     if (!g_ui_state.spectrum_data) {
         return false;
     }
@@ -60,10 +66,23 @@ bool iq_ui_init(IQ_UI_Config* config) {
 void iq_ui_shutdown(void) {
     g_ui_state.is_running = false;
 
+    // Stop the worker before the buffers it reports into go away
+    spectrum_engine_destroy(g_ui_state.engine);
+    g_ui_state.engine = NULL;
+    tile_view_destroy(g_ui_state.tiles);
+    g_ui_state.tiles = NULL;
+    free(g_ui_state.waterfall_power);
+    g_ui_state.waterfall_power = NULL;
+    g_ui_state.waterfall_capacity = 0;
+    iq_ui_pane_free(&g_ui_state.waterfall_pane);
+    iq_ui_pane_free(&g_ui_state.spectrum_pane);
+    Clay_Win32_Shutdown();
+
     if (g_ui_state.spectrum_data) {
         free(g_ui_state.spectrum_data);
         g_ui_state.spectrum_data = NULL;
     }
+    iq_summary_free(&g_ui_state.summary);
 
     if (g_ui_state.clay_memory) {
         free(g_ui_state.clay_memory);
@@ -120,18 +139,36 @@ LRESULT CALLBACK iq_ui_wnd_proc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
             InvalidateRect(hwnd, NULL, FALSE);
             return 0;
 
+        // Input only asks for a frame; unchanged elements are not redrawn
         case WM_MOUSEMOVE:
         case WM_LBUTTONDOWN:
         case WM_LBUTTONUP:
         case WM_RBUTTONDOWN:
         case WM_RBUTTONUP:
             iq_ui_handle_mouse_event(msg, wParam, lParam);
-            InvalidateRect(hwnd, NULL, FALSE);
+            iq_ui_request_frame();
             return 0;
 
         case WM_MOUSEWHEEL:
             iq_ui_handle_scroll_event(wParam);
-            InvalidateRect(hwnd, NULL, FALSE);
+            iq_ui_request_frame();
+            return 0;
+
+        case WM_IQ_UI_SPECTRUM:
+            iq_ui_process_spectrum();
+            if (g_ui_state.spectrum_dirty) {
+                iq_ui_request_frame();
+            }
+            return 0;
+
+        case WM_IQ_UI_TILES:
+            g_ui_state.waterfall_stale = true;
+            iq_ui_request_frame();
+            return 0;
+
+        case WM_IQ_UI_FRAME:
+            g_ui_state.frame_pending = false;
+            iq_ui_paint(hwnd, false);
             return 0;
 
         case WM_KEYDOWN:
@@ -139,20 +176,24 @@ LRESULT CALLBACK iq_ui_wnd_proc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
                 DestroyWindow(hwnd);
                 return 0;
             }
+            if (g_ui_state.engine && (wParam == VK_LEFT || wParam == VK_RIGHT ||
+                                      wParam == VK_PRIOR || wParam == VK_NEXT)) {
+                int steps = (wParam == VK_PRIOR || wParam == VK_NEXT) ? 16 : 1;
+                iq_ui_scroll_view((wParam == VK_LEFT || wParam == VK_PRIOR) ? -steps : steps);
+                iq_ui_request_frame();
+                return 0;
+            }
             if (wParam == VK_F12) {
                 g_ui_config.debug_mode = !g_ui_config.debug_mode;
                 Clay_SetDebugModeEnabled(g_ui_config.debug_mode);
-                InvalidateRect(hwnd, NULL, FALSE);
+                iq_ui_request_frame();
                 return 0;
             }
             break;
 
         case WM_PAINT:
-        {
-            Clay_RenderCommandArray render_commands = iq_ui_create_layout();
-            Clay_Win32_Render(hwnd, render_commands, &g_ui_state.font);
+            iq_ui_paint(hwnd, true);
             return 0;
-        }
     }
 
     return DefWindowProc(hwnd, msg, wParam, lParam);
@@ -206,8 +247,23 @@ void iq_ui_handle_mouse_event(UINT msg, WPARAM wParam, LPARAM lParam) {
     Clay_SetPointerState((Clay_Vector2){(float)x, (float)y}, left_button_down);
 }
 
+// The wheel moves through the loaded file (Shift: 16 views per notch);
+// Ctrl+wheel zooms the waterfall in time, Ctrl+Shift+wheel in frequency
 void iq_ui_handle_scroll_event(WPARAM wParam) {
     short delta = GET_WHEEL_DELTA_WPARAM(wParam);
+    if (g_ui_state.engine) {
+        int steps = -delta / WHEEL_DELTA;
+        if (steps == 0) steps = delta > 0 ? -1 : 1;
+        WORD keys = GET_KEYSTATE_WPARAM(wParam);
+        if (keys & MK_CONTROL) {
+            if (keys & MK_SHIFT) iq_ui_zoom_waterfall(0, steps);
+            else iq_ui_zoom_waterfall(steps, 0);
+            return;
+        }
+        if (keys & MK_SHIFT) steps *= 16;
+        iq_ui_scroll_view(steps);
+        return;
+    }
     Clay_UpdateScrollContainers(true, (Clay_Vector2){0, (float)delta}, 0.016f); // ~60fps
 }
 
@@ -216,6 +272,15 @@ void iq_ui_render_frame(void) {
     // No longer needed - WM_PAINT handles this directly
 }
 
+// Coalesce state changes into one WM_IQ_UI_FRAME; invalidating the window
+// instead would copy all of it to the screen on every change
+void iq_ui_request_frame(void) {
+    if (!g_ui_state.frame_pending && g_ui_state.hwnd) {
+        g_ui_state.frame_pending = true;
+        PostMessage(g_ui_state.hwnd, WM_IQ_UI_FRAME, 0, 0);
+    }
+}
+
 Clay_RenderCommandArray iq_ui_create_layout(void) {
     Clay_BeginLayout();
 
@@ -382,7 +447,9 @@ Clay_RenderCommandArray iq_ui_create_layout(void) {
                     .id = CLAY_ID("SpectrumArea"),
                     .layout = {
                         .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
-                        .padding = CLAY_PADDING_ALL(12)
+                        .layoutDirection = CLAY_TOP_TO_BOTTOM,
+                        .padding = CLAY_PADDING_ALL(12),
+                        .childGap = 8
                     },
                     .backgroundColor = UI_COLOR_SURFACE,
                     .cornerRadius = CLAY_CORNER_RADIUS(6)
@@ -393,21 +460,51 @@ Clay_RenderCommandArray iq_ui_create_layout(void) {
                         .textColor = UI_COLOR_TEXT
                     }));
 
-                    CLAY({
-                        .id = CLAY_ID("SpectrumPlaceholder"),
-                        .layout = {
-                            .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
-                            .padding = CLAY_PADDING_ALL(20),
-                            .childAlignment = {.x = CLAY_ALIGN_X_CENTER, .y = CLAY_ALIGN_Y_CENTER}
-                        },
-                        .backgroundColor = {50, 50, 50, 255},
-                        .cornerRadius = CLAY_CORNER_RADIUS(4)
-                    }) {
-                        CLAY_TEXT(CLAY_STRING("Load an IQ file to view spectrum"), CLAY_TEXT_CONFIG({
+                    if (g_ui_state.has_file_loaded) {
+                        Clay_String label = {
+                            .length = (int32_t)strlen(g_ui_state.view_label),
+                            .chars = g_ui_state.view_label
+                        };
+                        CLAY_TEXT(label, CLAY_TEXT_CONFIG({
                             .fontId = FONT_ID_BODY,
-                            .fontSize = 14,
+                            .fontSize = 12,
                             .textColor = UI_COLOR_TEXT_SECONDARY
                         }));
+
+                        // Both panes are persistent bitmaps drawn over these boxes
+                        // (iq_ui_compose_spectrum, iq_ui_compose_waterfall)
+                        CLAY({
+                            .id = CLAY_ID("SpectrumTrace"),
+                            .layout = {
+                                .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)}
+                            },
+                            .backgroundColor = UI_COLOR_TRACE_BACKGROUND
+                        }) {}
+
+                        CLAY({
+                            .id = CLAY_ID("WaterfallArea"),
+                            .layout = {
+                                .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)}
+                            },
+                            .backgroundColor = {0, 0, 0, 255}
+                        }) {}
+                    } else {
+                        CLAY({
+                            .id = CLAY_ID("SpectrumPlaceholder"),
+                            .layout = {
+                                .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
+                                .padding = CLAY_PADDING_ALL(20),
+                                .childAlignment = {.x = CLAY_ALIGN_X_CENTER, .y = CLAY_ALIGN_Y_CENTER}
+                            },
+                            .backgroundColor = {50, 50, 50, 255},
+                            .cornerRadius = CLAY_CORNER_RADIUS(4)
+                        }) {
+                            CLAY_TEXT(CLAY_STRING("Load an IQ file to view spectrum"), CLAY_TEXT_CONFIG({
+                                .fontId = FONT_ID_BODY,
+                                .fontSize = 14,
+                                .textColor = UI_COLOR_TEXT_SECONDARY
+                            }));
+                        }
                     }
                 }
             }
@@ -513,6 +610,8 @@ void iq_ui_render_controls(void) {
     }
 }
 
+// Blocks only on window messages: spectra are computed on the engine's
+// thread and arrive as WM_IQ_UI_SPECTRUM, so input is handled at once
 void iq_ui_run_main_loop(void) {
     MSG msg;
     while (g_ui_state.is_running && GetMessage(&msg, NULL, 0, 0)) {
@@ -534,21 +633,354 @@ void iq_ui_handle_clay_errors(Clay_ErrorData errorData) {
     printf("Clay Error: %.*s\n", (int)errorData.errorText.length, errorData.errorText.chars);
 }
 
-// Stub implementations for now
+// Runs on the spectrum worker: wake the message loop, which polls the frame
+static void iq_ui_spectrum_ready(void* user) {
+    PostMessage((HWND)user, WM_IQ_UI_SPECTRUM, 0, 0);
+}
+
+// Runs on a waterfall worker: repaint, which renders whatever is cached
+static void iq_ui_tiles_ready(void* user) {
+    PostMessage((HWND)user, WM_IQ_UI_TILES, 0, 0);
+}
+
+// "<file>_tiles.iqpyr", or the same without the file's extension
+static bool iq_ui_find_pyramid(const char* filepath, char* out, size_t size) {
+    for (int strip = 0; strip < 2; strip++) {
+        size_t len = strlen(filepath);
+        if (strip) {
+            const char *dot = strrchr(filepath, '.');
+            const char *slash = strrchr(filepath, '\\');
+            const char *fwd = strrchr(filepath, '/');
+            if (fwd && (!slash || fwd > slash)) slash = fwd;
+            if (!dot || (slash && dot < slash)) break;
+            len = (size_t)(dot - filepath);
+        }
+        if ((size_t)snprintf(out, size, "%.*s_tiles.iqpyr", (int)len, filepath) >= size) continue;
+        FILE *f = fopen(out, "rb");
+        if (f) {
+            fclose(f);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whole-file spectrum from the summary: the mean of its intervals, max-pooled
+// to the display width and scaled to [0, 1] over its dB range. Shown at once
+// while the worker computes the first view.
+static void iq_ui_summary_spectrum(void) {
+    const iq_summary_t *summary = &g_ui_state.summary;
+    if (!g_ui_state.spectrum_data || summary->num_spectra == 0) {
+        return;
+    }
+
+    float lo = INFINITY, hi = -INFINITY;
+    for (size_t i = 0; i < g_ui_state.spectrum_size; i++) {
+        size_t b0 = i * summary->fft_size / g_ui_state.spectrum_size;
+        size_t b1 = (i + 1) * summary->fft_size / g_ui_state.spectrum_size;
+        if (b1 <= b0) b1 = b0 + 1;
+        double peak = 0.0;
+        for (size_t k = b0; k < b1; k++) {
+            double sum = 0.0;
+            for (uint64_t s = 0; s < summary->num_spectra; s++) {
+                sum += summary->spectra[s * summary->fft_size + k];
+            }
+            if (sum > peak) peak = sum;
+        }
+        float db = (float)(10.0 * log10(peak / (double)summary->num_spectra + 1e-12));
+        g_ui_state.spectrum_data[i] = db;
+        if (db < lo) lo = db;
+        if (db > hi) hi = db;
+    }
+    for (size_t i = 0; i < g_ui_state.spectrum_size; i++) {
+        g_ui_state.spectrum_data[i] = hi > lo ? (g_ui_state.spectrum_data[i] - lo) / (hi - lo) : 0.0f;
+    }
+    snprintf(g_ui_state.view_label, sizeof(g_ui_state.view_label), "Whole file (summary)");
+    g_ui_state.spectrum_dirty = true;
+}
+
+// The raw IQ is read once, to build the sidecar; later loads only read the summary.
+// Views of any position are then computed by the spectrum worker.
 bool iq_ui_load_iq_file(const char* filepath) {
+    spectrum_engine_destroy(g_ui_state.engine);
+    g_ui_state.engine = NULL;
+    tile_view_destroy(g_ui_state.tiles);
+    g_ui_state.tiles = NULL;
+    iq_summary_free(&g_ui_state.summary);
+    g_ui_state.has_file_loaded = false;
+    if (!filepath || !iq_summary_open(filepath, false, true, NULL, &g_ui_state.summary)) {
+        return false;
+    }
+
+    spectrum_engine_params_t params;
+    spectrum_engine_default_params(&params);
+    params.fft_size = (uint32_t)g_ui_state.fft_size;
+    params.hop = (uint32_t)g_ui_state.hop_size;
+    params.avg_frames = (uint32_t)g_ui_state.avg_count;
+    params.columns = (uint32_t)g_ui_state.spectrum_size;
+    g_ui_state.engine = spectrum_engine_create(filepath, &params, iq_ui_spectrum_ready, g_ui_state.hwnd);
+
+    // Tiles come from the capture's pyramid when iqls wrote one next to it
+    char pyramid[1024 + 16];
+    tile_view_params_t tile_params;
+    tile_view_default_params(&tile_params);
+    tile_params.fft_size = (uint32_t)g_ui_state.fft_size;
+    tile_params.hop = (uint32_t)g_ui_state.hop_size;
+    tile_params.pyramid_path = iq_ui_find_pyramid(filepath, pyramid, sizeof(pyramid)) ? pyramid : NULL;
+    g_ui_state.tiles = tile_view_create(filepath, &tile_params, iq_ui_tiles_ready, g_ui_state.hwnd);
+    if (g_ui_state.tiles) {
+        const tile_pyramid_info_t *info = tile_view_info(g_ui_state.tiles);
+        g_ui_state.waterfall_rows = info->num_rows < 1024 ? (double)info->num_rows : 1024.0;
+        g_ui_state.waterfall_col0 = 0.0;
+        g_ui_state.waterfall_cols = (double)info->width;
+    }
+    g_ui_state.waterfall_complete = false;
+    g_ui_state.waterfall_shown = (tile_viewport_t){0};
+
     strncpy(g_ui_state.current_file_path, filepath, sizeof(g_ui_state.current_file_path) - 1);
     g_ui_state.has_file_loaded = true;
-    g_ui_state.spectrum_dirty = true;
+    g_ui_state.view_sample = 0;
+    iq_ui_summary_spectrum();
+    if (g_ui_state.engine) {
+        spectrum_engine_request(g_ui_state.engine, 0);
+    }
+    iq_ui_request_frame();
     return true;
 }
 
+// Move the view by whole spans; only the worker touches the file
+void iq_ui_scroll_view(int steps) {
+    spectrum_engine_t *engine = g_ui_state.engine;
+    if (!engine || steps == 0) {
+        return;
+    }
+
+    const uint64_t span = spectrum_engine_span(engine);
+    const uint64_t total = spectrum_engine_total_samples(engine);
+    const uint64_t last = total > span ? total - span : 0;
+    const uint64_t move = span * (uint64_t)(steps < 0 ? -(int64_t)steps : steps);
+    if (steps < 0) {
+        g_ui_state.view_sample = g_ui_state.view_sample > move ? g_ui_state.view_sample - move : 0;
+    } else {
+        g_ui_state.view_sample = last - g_ui_state.view_sample > move ? g_ui_state.view_sample + move : last;
+    }
+    spectrum_engine_request(engine, g_ui_state.view_sample);
+}
+
+// Take the newest worker frame, if any; never waits for the worker
 void iq_ui_process_spectrum(void) {
-    // TODO: Integrate with existing IQ processing
-    if (g_ui_state.spectrum_data) {
-        // Fill with dummy data for now
-        for (size_t i = 0; i < g_ui_state.spectrum_size; i++) {
-            g_ui_state.spectrum_data[i] = (float)rand() / RAND_MAX;
+    bool fresh = false;
+    const spectrum_frame_t *frame = spectrum_engine_poll(g_ui_state.engine, &fresh);
+    if (!fresh || !frame || frame->columns != g_ui_state.spectrum_size || !g_ui_state.spectrum_data) {
+        return;
+    }
+
+    memcpy(g_ui_state.spectrum_data, frame->level, g_ui_state.spectrum_size * sizeof(float));
+    g_ui_state.shown_sample = frame->start_sample;
+
+    const uint32_t rate = g_ui_state.summary.sample_rate;
+    if (rate > 0) {
+        snprintf(g_ui_state.view_label, sizeof(g_ui_state.view_label), "%.3f s of %.3f s, %.1f dB range",
+                 (double)frame->start_sample / rate, (double)g_ui_state.summary.total_samples / rate,
+                 (double)(frame->max_db - frame->min_db));
+    } else {
+        snprintf(g_ui_state.view_label, sizeof(g_ui_state.view_label), "Sample %llu of %llu, %.1f dB range",
+                 (unsigned long long)frame->start_sample, (unsigned long long)g_ui_state.summary.total_samples,
+                 (double)(frame->max_db - frame->min_db));
+    }
+    g_ui_state.spectrum_dirty = true;
+}
+
+// Zoom the waterfall by powers of two about its centre (negative steps zoom in)
+void iq_ui_zoom_waterfall(int time_steps, int freq_steps) {
+    if (!g_ui_state.tiles) {
+        return;
+    }
+    const tile_pyramid_info_t *info = tile_view_info(g_ui_state.tiles);
+    const double factor_t = pow(2.0, time_steps), factor_f = pow(2.0, freq_steps);
+
+    double rows = g_ui_state.waterfall_rows * factor_t;
+    if (rows > (double)info->num_rows) rows = (double)info->num_rows;
+    if (rows < 16.0) rows = 16.0;
+    g_ui_state.waterfall_rows = rows;
+
+    double cols = g_ui_state.waterfall_cols * factor_f;
+    if (cols > (double)info->width) cols = (double)info->width;
+    if (cols < 16.0) cols = 16.0;
+    double centre = g_ui_state.waterfall_col0 + 0.5 * g_ui_state.waterfall_cols;
+    double col0 = centre - 0.5 * cols;
+    if (col0 + cols > (double)info->width) col0 = (double)info->width - cols;
+    if (col0 < 0.0) col0 = 0.0;
+    g_ui_state.waterfall_col0 = col0;
+    g_ui_state.waterfall_cols = cols;
+    iq_ui_request_frame();
+}
+
+// Back-buffer rectangle of a laid-out element (false if absent or empty)
+static bool iq_ui_element_rect(Clay_ElementId id, RECT* rect) {
+    Clay_ElementData data = Clay_GetElementData(id);
+    if (!data.found || data.boundingBox.width < 1 || data.boundingBox.height < 1) {
+        return false;
+    }
+    rect->left = (LONG)data.boundingBox.x;
+    rect->top = (LONG)data.boundingBox.y;
+    rect->right = rect->left + (LONG)data.boundingBox.width;
+    rect->bottom = rect->top + (LONG)data.boundingBox.height;
+    return true;
+}
+
+static uint32_t iq_ui_pixel(Clay_Color c) {
+    return (uint32_t)c.b | (uint32_t)c.g << 8 | (uint32_t)c.r << 16;
+}
+
+// Copy a pane into the back buffer when it changed or Clay drew over its box
+static void iq_ui_compose_pane(const iq_ui_pane_t* pane, const RECT* rect, bool changed) {
+    if (changed || Clay_Win32_IsDamaged(rect)) {
+        iq_ui_pane_blit(pane, Clay_Win32_GetBackBuffer(), rect->left, rect->top);
+        Clay_Win32_AddDamage(rect);
+    }
+}
+
+// Spectrum bars, redrawn only when a new spectrum arrived
+static void iq_ui_compose_spectrum(void) {
+    RECT rect;
+    if (!g_ui_state.has_file_loaded || !iq_ui_element_rect(CLAY_ID("SpectrumTrace"), &rect)) {
+        return;
+    }
+    iq_ui_pane_t *pane = &g_ui_state.spectrum_pane;
+    bool changed = iq_ui_pane_resize(pane, RECTWIDTH(rect), RECTHEIGHT(rect));
+    if (!pane->dc) {
+        return;
+    }
+
+    if (changed || g_ui_state.spectrum_dirty) {
+        const uint32_t background = iq_ui_pixel(UI_COLOR_TRACE_BACKGROUND);
+        const uint32_t trace = iq_ui_pixel(UI_COLOR_TRACE);
+        GdiFlush();
+        for (int x = 0; x < pane->width; x++) {
+            size_t column = (size_t)x * g_ui_state.spectrum_size / (size_t)pane->width;
+            float level = g_ui_state.spectrum_data ? g_ui_state.spectrum_data[column] : 0.0f;
+            int top = pane->height - (int)lrintf(level * (float)pane->height);
+            for (int y = 0; y < pane->height; y++) {
+                pane->bits[(size_t)y * pane->width + x] = y >= top ? trace : background;
+            }
         }
         g_ui_state.spectrum_dirty = false;
+        changed = true;
+    }
+    iq_ui_compose_pane(pane, &rect, changed);
+}
+
+// Colormap power rows [y0, y0 + rows) of the waterfall pane from 'power'
+static void iq_ui_waterfall_rows(iq_ui_pane_t* pane, int y0, int rows, float* power) {
+    const size_t count = (size_t)rows * (size_t)pane->width;
+    for (size_t i = 0; i < count; i++) {
+        if (!isnan(power[i])) power[i] = 10.0f * log10f(power[i] + 1e-12f);
+    }
+    // RGB from the colormap, widened in place (back to front) to 0x00RRGGBB
+    for (int y = 0; y < rows; y++) {
+        uint32_t *row = pane->bits + (size_t)(y0 + y) * pane->width;
+        uint8_t *rgb = (uint8_t *)row;
+        colormap_map_row(&g_ui_state.colormap, power + (size_t)y * pane->width, (size_t)pane->width,
+                         g_ui_state.waterfall_lo_db, g_ui_state.waterfall_hi_db, rgb);
+        for (int x = pane->width; x-- > 0;) {
+            const uint8_t *c = rgb + 3 * (size_t)x;
+            row[x] = (uint32_t)c[2] | (uint32_t)c[1] << 8 | (uint32_t)c[0] << 16;
+        }
+    }
+}
+
+/*
+ * Waterfall over "WaterfallArea". The viewport origin moves in whole pixel
+ * rows, so when only the position changed and the pane was complete, the
+ * pane scrolls and just the exposed rows are rendered, on the pane's dB
+ * range. A new zoom, size or tile arrival renders everything; an unchanged,
+ * complete view renders nothing. Only visible tiles are ever requested.
+ */
+static void iq_ui_compose_waterfall(void) {
+    RECT rect;
+    if (!g_ui_state.tiles || !iq_ui_element_rect(CLAY_ID("WaterfallArea"), &rect)) {
+        return;
+    }
+    iq_ui_pane_t *pane = &g_ui_state.waterfall_pane;
+    bool resized = iq_ui_pane_resize(pane, RECTWIDTH(rect), RECTHEIGHT(rect));
+    if (!pane->dc) {
+        return;
+    }
+    const size_t count = (size_t)pane->width * pane->height;
+    if (count > g_ui_state.waterfall_capacity) {
+        float *power = realloc(g_ui_state.waterfall_power, count * sizeof(float));
+        if (!power) {
+            return;
+        }
+        g_ui_state.waterfall_power = power;
+        g_ui_state.waterfall_capacity = count;
+    }
+
+    const uint32_t hop = tile_view_hop(g_ui_state.tiles);
+    const double rows_per_pixel = g_ui_state.waterfall_rows / pane->height;
+    const double view_row = hop ? (double)(g_ui_state.view_sample / hop) : 0.0;
+    const uint64_t origin = (uint64_t)(view_row / rows_per_pixel);
+    tile_viewport_t viewport = {
+        .row0 = (double)origin * rows_per_pixel,
+        .rows = g_ui_state.waterfall_rows,
+        .col0 = g_ui_state.waterfall_col0,
+        .cols = g_ui_state.waterfall_cols,
+        .width = (uint32_t)pane->width,
+        .height = (uint32_t)pane->height
+    };
+    const tile_viewport_t *shown = &g_ui_state.waterfall_shown;
+    const bool same_zoom = !resized && shown->rows == viewport.rows && shown->col0 == viewport.col0 &&
+                           shown->cols == viewport.cols && shown->width == viewport.width &&
+                           shown->height == viewport.height;
+    const int64_t dy = (int64_t)origin - (int64_t)g_ui_state.waterfall_origin;
+
+    bool changed = true;
+    tile_view_set_viewport(g_ui_state.tiles, &viewport);
+    if (same_zoom && dy == 0 && (g_ui_state.waterfall_complete || !g_ui_state.waterfall_stale)) {
+        changed = false;
+    } else if (same_zoom && g_ui_state.waterfall_complete && dy != 0 && (dy < 0 ? -dy : dy) < pane->height) {
+        // Scroll, then render the rows that came into view
+        const int exposed = (int)(dy < 0 ? -dy : dy);
+        const int y0 = dy > 0 ? pane->height - exposed : 0;
+        tile_viewport_t strip = viewport;
+        strip.row0 = (double)(origin + (uint64_t)y0) * rows_per_pixel;
+        strip.rows = exposed * rows_per_pixel;
+        strip.height = (uint32_t)exposed;
+        iq_ui_pane_scroll(pane, (int)dy);
+        uint32_t missing = tile_view_render(g_ui_state.tiles, &strip, g_ui_state.waterfall_power);
+        iq_ui_waterfall_rows(pane, y0, exposed, g_ui_state.waterfall_power);
+        g_ui_state.waterfall_complete = missing == 0;
+    } else {
+        uint32_t missing = tile_view_render(g_ui_state.tiles, &viewport, g_ui_state.waterfall_power);
+        // dB range of what is on screen
+        float lo = INFINITY, hi = -INFINITY;
+        for (size_t i = 0; i < count; i++) {
+            float p = g_ui_state.waterfall_power[i];
+            if (isnan(p)) continue;
+            float db = 10.0f * log10f(p + 1e-12f);
+            if (db < lo) lo = db;
+            if (db > hi) hi = db;
+        }
+        g_ui_state.waterfall_lo_db = lo;
+        g_ui_state.waterfall_hi_db = hi;
+        GdiFlush();
+        iq_ui_waterfall_rows(pane, 0, pane->height, g_ui_state.waterfall_power);
+        g_ui_state.waterfall_complete = missing == 0;
+    }
+    g_ui_state.waterfall_shown = viewport;
+    g_ui_state.waterfall_origin = origin;
+    g_ui_state.waterfall_stale = false;
+    iq_ui_compose_pane(pane, &rect, changed);
+}
+
+// Redraw what changed since the last frame and copy only that to the window.
+// From WM_PAINT the window's update region is copied too, from the back buffer.
+void iq_ui_paint(HWND hwnd, bool from_paint) {
+    Clay_RenderCommandArray render_commands = iq_ui_create_layout();
+    if (Clay_Win32_Draw(hwnd, render_commands, &g_ui_state.font)) {
+        iq_ui_compose_spectrum();
+        iq_ui_compose_waterfall();
     }
+    Clay_Win32_Present(hwnd, from_paint);
 }
@@ -9,6 +9,19 @@
 // Include Clay header for type definitions
 #include "clay.h"
 
+#include "../iq_core/iq_summary.h"
+#include "../viz/colormap.h"
+#include "spectrum_engine.h"
+#include "tile_view.h"
+#include "ui_pane.h"
+
+// Posted by the spectrum worker when it publishes a frame
+#define WM_IQ_UI_SPECTRUM (WM_APP + 1)
+// Posted by the waterfall workers when tiles arrive
+#define WM_IQ_UI_TILES (WM_APP + 2)
+// Posted once per coalesced iq_ui_request_frame()
+#define WM_IQ_UI_FRAME (WM_APP + 3)
+
 // Forward declarations
 typedef struct IQ_UI_State IQ_UI_State;
 typedef struct IQ_UI_Config IQ_UI_Config;
@@ -33,6 +46,7 @@ struct IQ_UI_State {
     // Clay state
     void* clay_memory;
     uint64_t clay_memory_size;
+    bool frame_pending;         // WM_IQ_UI_FRAME posted, not handled yet
 
     // UI state
     bool is_running;
@@ -42,11 +56,33 @@ struct IQ_UI_State {
     // File state
     char current_file_path[1024];
     bool has_file_loaded;
+    iq_summary_t summary;       // Overview of the loaded file (its .iqsum sidecar)
 
     // Spectrum state
     float* spectrum_data;
     size_t spectrum_size;
-    bool spectrum_dirty;
+    bool spectrum_dirty;        // spectrum_data changed since the pane was drawn
+    iq_ui_pane_t spectrum_pane; // Bars of spectrum_data over "SpectrumTrace"
+    spectrum_engine_t* engine;  // Background STFT over the loaded file
+    uint64_t view_sample;       // First sample of the requested view
+    uint64_t shown_sample;      // First sample of the spectrum on screen
+    char view_label[96];        // Position text for the spectrum panel
+
+    // Waterfall state: the viewport starts at view_sample, zoom sets its extent
+    tile_view_t* tiles;         // Lazily computed (or pyramid) waterfall tiles
+    double waterfall_rows;      // Level-0 rows (frames) shown top to bottom
+    double waterfall_col0;      // First level-0 column (bin) shown
+    double waterfall_cols;      // Level-0 columns shown
+    float* waterfall_power;     // Rendered pixels, linear power
+    size_t waterfall_capacity;  // Pixels waterfall_power holds
+    colormap_t colormap;
+    iq_ui_pane_t waterfall_pane;      // Colormapped pixels over "WaterfallArea"
+    tile_viewport_t waterfall_shown;  // Viewport the pane holds
+    uint64_t waterfall_origin;  // Its top row in pane pixels from the file start
+    bool waterfall_complete;    // No tile was missing when it was drawn
+    bool waterfall_stale;       // Tiles arrived since
+    float waterfall_lo_db;      // Colormap range of the pane
+    float waterfall_hi_db;
 
     // Control values
     int fft_size;
@@ -69,6 +105,8 @@ void iq_ui_update_clay_dimensions(int width, int height);
 void iq_ui_handle_mouse_event(UINT msg, WPARAM wParam, LPARAM lParam);
 void iq_ui_handle_scroll_event(WPARAM wParam);
 void iq_ui_render_frame(void);
+void iq_ui_request_frame(void);
+void iq_ui_paint(HWND hwnd, bool from_paint);
 
 // UI components
 Clay_RenderCommandArray iq_ui_create_layout(void);
@@ -76,9 +114,11 @@ void iq_ui_render_file_browser(void);
 void iq_ui_render_spectrum_view(void);
 void iq_ui_render_controls(void);
 
-// File operations
+// File operations (overviews come from the summary sidecar, built on first load)
 bool iq_ui_load_iq_file(const char* filepath);
 void iq_ui_process_spectrum(void);
+void iq_ui_scroll_view(int steps);
+void iq_ui_zoom_waterfall(int time_steps, int freq_steps);
 
 // Utility functions
 Clay_Dimensions iq_ui_measure_text(Clay_StringSlice text, Clay_TextElementConfig* config, void* userData);
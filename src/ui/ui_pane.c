@@ -0,0 +1,71 @@
+/*
+ * IQ Lab - Persistent UI Panes
+ */
+
+#include "ui_pane.h"
+#include <string.h>
+
+bool iq_ui_pane_resize(iq_ui_pane_t* pane, int width, int height) {
+    if (pane->dc && pane->width == width && pane->height == height) {
+        return false;
+    }
+    iq_ui_pane_free(pane);
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    BITMAPINFO bmi = {0};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;   // Top-down rows
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    pane->dc = CreateCompatibleDC(NULL);
+    if (!pane->dc) {
+        return false;
+    }
+    void* bits = NULL;
+    pane->bitmap = CreateDIBSection(pane->dc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (!pane->bitmap) {
+        DeleteDC(pane->dc);
+        pane->dc = NULL;
+        return false;
+    }
+    pane->previous = SelectObject(pane->dc, pane->bitmap);
+    pane->bits = (uint32_t*)bits;
+    pane->width = width;
+    pane->height = height;
+    return true;
+}
+
+void iq_ui_pane_scroll(iq_ui_pane_t* pane, int rows) {
+    if (!pane->dc || rows == 0 || rows >= pane->height || -rows >= pane->height) {
+        return;
+    }
+    // GDI may still be writing to the section
+    GdiFlush();
+    const size_t stride = (size_t)pane->width;
+    const size_t kept = (size_t)(pane->height - (rows > 0 ? rows : -rows));
+    if (rows > 0) {
+        memmove(pane->bits, pane->bits + (size_t)rows * stride, kept * stride * sizeof(uint32_t));
+    } else {
+        memmove(pane->bits + (size_t)(-rows) * stride, pane->bits, kept * stride * sizeof(uint32_t));
+    }
+}
+
+void iq_ui_pane_blit(const iq_ui_pane_t* pane, HDC dest, int x, int y) {
+    if (pane->dc && dest) {
+        BitBlt(dest, x, y, pane->width, pane->height, pane->dc, 0, 0, SRCCOPY);
+    }
+}
+
+void iq_ui_pane_free(iq_ui_pane_t* pane) {
+    if (pane->dc) {
+        SelectObject(pane->dc, pane->previous);
+        DeleteObject(pane->bitmap);
+        DeleteDC(pane->dc);
+    }
+    memset(pane, 0, sizeof(*pane));
+}
@@ -0,0 +1,42 @@
+#ifndef IQ_LAB_UI_PANE_H
+#define IQ_LAB_UI_PANE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <windows.h>
+
+/*
+ * Persistent pixel panes for the UI
+ * A pane is a 32-bit top-down DIB section selected into its own memory DC.
+ * Its pixels survive between frames, so a view that did not change costs
+ * nothing and one that moved by whole rows only draws the rows it exposed.
+ * Pixels are 0x00RRGGBB, row-major, 'width' per row.
+ */
+
+typedef struct {
+    HDC dc;                 // Memory DC with the DIB selected (NULL when empty)
+    HBITMAP bitmap;
+    HGDIOBJ previous;       // Bitmap the DC came with
+    uint32_t* bits;         // width * height pixels
+    int width;
+    int height;
+} iq_ui_pane_t;
+
+/*
+ * Size the pane to width x height; returns true if it was (re)created, in
+ * which case its pixels are undefined and must be redrawn
+ */
+bool iq_ui_pane_resize(iq_ui_pane_t* pane, int width, int height);
+
+/*
+ * Move the contents up by 'rows' (down for negative rows) in one row-block
+ * copy; the rows it exposes keep stale pixels for the caller to redraw
+ */
+void iq_ui_pane_scroll(iq_ui_pane_t* pane, int rows);
+
+// Copy the pane to (x, y) of 'dest'
+void iq_ui_pane_blit(const iq_ui_pane_t* pane, HDC dest, int x, int y);
+
+void iq_ui_pane_free(iq_ui_pane_t* pane);
+
+#endif // IQ_LAB_UI_PANE_H
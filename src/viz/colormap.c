@@ -0,0 +1,279 @@
+/*
+ * IQ Lab - Colormap Lookup Tables
+ *
+ * Palettes are sampled once into COLORMAP_LUT_SIZE packed RGB words, then
+ * rows of values are quantized to table indices and looked up. The
+ * quantize step is the same sequence of float operations in every kernel
+ * (subtract, multiply, clamp with NaN to zero, add one half, truncate), so
+ * SIMD and scalar rows are byte-identical.
+ */
+
+#include "colormap.h"
+#include "img_png.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLORMAP_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define COLORMAP_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+static const char *const colormap_names[COLORMAP_COUNT] = {
+    "hf", "gray", "viridis", "inferno", "turbo"
+};
+
+// Nine evenly spaced anchors of the matplotlib palettes, linearly interpolated
+static const uint8_t colormap_viridis_anchors[9][3] = {
+    {  68,   1,  84 }, {  71,  45, 123 }, {  59,  82, 139 }, {  44, 114, 142 },
+    {  33, 145, 140 }, {  40, 174, 128 }, {  94, 201,  98 }, { 173, 220,  48 },
+    { 253, 231,  37 }
+};
+
+static const uint8_t colormap_inferno_anchors[9][3] = {
+    {   0,   0,   4 }, {  31,  12,  72 }, {  85,  15, 109 }, { 136,  34, 106 },
+    { 186,  54,  85 }, { 227,  89,  51 }, { 249, 142,   9 }, { 249, 203,  53 },
+    { 252, 255, 164 }
+};
+
+static uint8_t colormap_to_byte(float value) {
+    if (!(value > 0.0f)) return 0;
+    if (value >= 255.0f) return 255;
+    return (uint8_t)lrintf(value);
+}
+
+static uint32_t colormap_pack(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16);
+}
+
+static uint32_t colormap_anchors(const uint8_t anchors[9][3], float t) {
+    float pos = t * 8.0f;
+    int k = (int)pos;
+    if (k >= 8) k = 7;
+    float frac = pos - (float)k;
+    uint8_t rgb[3];
+    for (int c = 0; c < 3; c++) {
+        rgb[c] = colormap_to_byte((float)anchors[k][c] + frac * (float)(anchors[k + 1][c] - anchors[k][c]));
+    }
+    return colormap_pack(rgb[0], rgb[1], rgb[2]);
+}
+
+// Polynomial fit of Google's Turbo palette
+static uint32_t colormap_turbo(float t) {
+    float r = 0.13572138f + t * (4.61539260f + t * (-42.66032258f + t * (132.13108234f + t * (-152.94239396f + t * 59.28637943f))));
+    float g = 0.09140261f + t * (2.19418839f + t * (4.84296658f + t * (-14.18503333f + t * (4.27729857f + t * 2.82956604f))));
+    float b = 0.10667330f + t * (12.64194608f + t * (-60.58204836f + t * (110.36276771f + t * (-89.90310912f + t * 27.34824973f))));
+    return colormap_pack(colormap_to_byte(r * 255.0f), colormap_to_byte(g * 255.0f), colormap_to_byte(b * 255.0f));
+}
+
+static uint32_t colormap_sample(colormap_palette_t palette, float t) {
+    switch (palette) {
+        case COLORMAP_HF: {
+            uint8_t r, g, b;
+            png_intensity_to_color(t, &r, &g, &b);
+            return colormap_pack(r, g, b);
+        }
+        case COLORMAP_GRAY: {
+            uint8_t v = colormap_to_byte(t * 255.0f);
+            return colormap_pack(v, v, v);
+        }
+        case COLORMAP_VIRIDIS: return colormap_anchors(colormap_viridis_anchors, t);
+        case COLORMAP_INFERNO: return colormap_anchors(colormap_inferno_anchors, t);
+        case COLORMAP_TURBO:   return colormap_turbo(t);
+        default:               return 0;
+    }
+}
+
+colormap_simd_t colormap_simd_detect(void) {
+#if defined(COLORMAP_HAVE_X86_SIMD)
+    if (__builtin_cpu_supports("avx2")) {
+        return COLORMAP_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return COLORMAP_SIMD_SSE2;
+    }
+    return COLORMAP_SIMD_NONE;
+#elif defined(COLORMAP_HAVE_NEON)
+    return COLORMAP_SIMD_NEON;   // AdvSIMD is mandatory on AArch64
+#else
+    return COLORMAP_SIMD_NONE;
+#endif
+}
+
+const char *colormap_simd_name(colormap_simd_t simd) {
+    switch (simd) {
+        case COLORMAP_SIMD_SSE2: return "sse2";
+        case COLORMAP_SIMD_AVX2: return "avx2";
+        case COLORMAP_SIMD_NEON: return "neon";
+        default:                 return "scalar";
+    }
+}
+
+bool colormap_init(colormap_t *map, colormap_palette_t palette) {
+    if (!map || (unsigned)palette >= COLORMAP_COUNT) {
+        return false;
+    }
+    map->palette = palette;
+    map->simd = colormap_simd_detect();
+    for (uint32_t i = 0; i < COLORMAP_LUT_SIZE; i++) {
+        map->lut[i] = colormap_sample(palette, (float)i / (float)(COLORMAP_LUT_SIZE - 1));
+    }
+    return true;
+}
+
+bool colormap_from_name(const char *name, colormap_palette_t *palette) {
+    if (!name || !palette) {
+        return false;
+    }
+    for (int p = 0; p < COLORMAP_COUNT; p++) {
+        if (strcmp(name, colormap_names[p]) == 0) {
+            *palette = (colormap_palette_t)p;
+            return true;
+        }
+    }
+    if (strcmp(name, "grey") == 0) {
+        *palette = COLORMAP_GRAY;
+        return true;
+    }
+    return false;
+}
+
+const char *colormap_name(colormap_palette_t palette) {
+    return (unsigned)palette < COLORMAP_COUNT ? colormap_names[palette] : "unknown";
+}
+
+// Table index of one value; the reference every kernel matches
+static uint32_t colormap_index(float value, float lo, float scale) {
+    const float top = (float)(COLORMAP_LUT_SIZE - 1);
+    float t = (value - lo) * scale;
+    t = t > 0.0f ? t : 0.0f;     // NaN fails the compare and lands on 0
+    t = t < top ? t : top;
+    return (uint32_t)(int32_t)(t + 0.5f);
+}
+
+static void colormap_store(uint8_t *rgb, uint32_t packed) {
+    rgb[0] = (uint8_t)packed;
+    rgb[1] = (uint8_t)(packed >> 8);
+    rgb[2] = (uint8_t)(packed >> 16);
+}
+
+static float colormap_scale(float lo, float hi) {
+    return hi > lo ? (float)(COLORMAP_LUT_SIZE - 1) / (hi - lo) : 0.0f;
+}
+
+void colormap_lookup(const colormap_t *map, float intensity, uint8_t *r, uint8_t *g, uint8_t *b) {
+    uint32_t packed = map->lut[colormap_index(intensity, 0.0f, colormap_scale(0.0f, 1.0f))];
+    *r = (uint8_t)packed;
+    *g = (uint8_t)(packed >> 8);
+    *b = (uint8_t)(packed >> 16);
+}
+
+#if defined(COLORMAP_HAVE_X86_SIMD)
+
+// Quantize four values at a time, look the indices up one by one
+__attribute__((target("sse2")))
+static size_t colormap_row_sse2(const uint32_t *lut, const float *values, size_t count,
+                                float lo, float scale, uint8_t *rgb) {
+    const __m128 vlo = _mm_set1_ps(lo);
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 top = _mm_set1_ps((float)(COLORMAP_LUT_SIZE - 1));
+    const __m128 half = _mm_set1_ps(0.5f);
+    int32_t idx[4];
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), vlo), vscale);
+        t = _mm_max_ps(t, zero);   // t > 0 ? t : 0, so NaN becomes 0
+        t = _mm_min_ps(t, top);
+        _mm_storeu_si128((__m128i *)idx, _mm_cvttps_epi32(_mm_add_ps(t, half)));
+        for (int k = 0; k < 4; k++) {
+            colormap_store(rgb + (i + k) * 3, lut[idx[k]]);
+        }
+    }
+    return i;
+}
+
+// Quantize and gather eight entries, pack 8 x RGBX words into 24 RGB bytes
+__attribute__((target("avx2")))
+static size_t colormap_row_avx2(const uint32_t *lut, const float *values, size_t count,
+                                float lo, float scale, uint8_t *rgb) {
+    const __m256 vlo = _mm256_set1_ps(lo);
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 top = _mm256_set1_ps((float)(COLORMAP_LUT_SIZE - 1));
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+
+    // Each half is stored as 16 bytes, 4 past its 12; the second store
+    // reaches pixel i + 9, which the next iteration or the tail rewrites
+    for (; i + 10 <= count; i += 8) {
+        __m256 t = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(values + i), vlo), vscale);
+        t = _mm256_max_ps(t, zero);
+        t = _mm256_min_ps(t, top);
+        __m256i idx = _mm256_cvttps_epi32(_mm256_add_ps(t, half));
+        __m256i px = _mm256_shuffle_epi8(_mm256_i32gather_epi32((const int *)lut, idx, 4), pack);
+        _mm_storeu_si128((__m128i *)(rgb + i * 3), _mm256_castsi256_si128(px));
+        _mm_storeu_si128((__m128i *)(rgb + i * 3 + 12), _mm256_extracti128_si256(px, 1));
+    }
+    return i;
+}
+
+#endif /* COLORMAP_HAVE_X86_SIMD */
+
+#if defined(COLORMAP_HAVE_NEON)
+
+static size_t colormap_row_neon(const uint32_t *lut, const float *values, size_t count,
+                                float lo, float scale, uint8_t *rgb) {
+    const float32x4_t vlo = vdupq_n_f32(lo);
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t top = vdupq_n_f32((float)(COLORMAP_LUT_SIZE - 1));
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    int32_t idx[4];
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t t = vmulq_f32(vsubq_f32(vld1q_f32(values + i), vlo), vscale);
+        // Compare and select rather than vmaxq, which would keep NaN
+        t = vbslq_f32(vcgtq_f32(t, zero), t, zero);
+        t = vbslq_f32(vcltq_f32(t, top), t, top);
+        vst1q_s32(idx, vcvtq_s32_f32(vaddq_f32(t, half)));
+        for (int k = 0; k < 4; k++) {
+            colormap_store(rgb + (i + k) * 3, lut[idx[k]]);
+        }
+    }
+    return i;
+}
+
+#endif /* COLORMAP_HAVE_NEON */
+
+void colormap_map_row(const colormap_t *map, const float *values, size_t count,
+                      float lo, float hi, uint8_t *rgb) {
+    if (!map || !values || !rgb) {
+        return;
+    }
+    const float scale = colormap_scale(lo, hi);
+    size_t i = 0;
+
+    switch (map->simd) {
+#if defined(COLORMAP_HAVE_X86_SIMD)
+        case COLORMAP_SIMD_AVX2: i = colormap_row_avx2(map->lut, values, count, lo, scale, rgb); break;
+        case COLORMAP_SIMD_SSE2: i = colormap_row_sse2(map->lut, values, count, lo, scale, rgb); break;
+#endif
+#if defined(COLORMAP_HAVE_NEON)
+        case COLORMAP_SIMD_NEON: i = colormap_row_neon(map->lut, values, count, lo, scale, rgb); break;
+#endif
+        default: break;
+    }
+
+    for (; i < count; i++) {
+        colormap_store(rgb + i * 3, map->lut[colormap_index(values[i], lo, scale)]);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef IQ_COLORMAP_H
+#define IQ_COLORMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Lookup-table colormaps for spectra and waterfalls
+ * A palette is sampled once into COLORMAP_LUT_SIZE packed RGB entries;
+ * rendering then quantizes each value to a table index instead of walking
+ * a chain of float segments per pixel. 4096 entries keep every step below
+ * one 8-bit level for all palettes here.
+ *
+ * colormap_map_row() turns a whole row of dB (or any scalar) values into
+ * RGB bytes: index = round(clamp((v - lo) / (hi - lo), 0, 1) * (N - 1)),
+ * NaN maps to entry 0. The quantize step runs on SSE2/AVX2/NEON where
+ * available (AVX2 also gathers the table entries); every kernel produces
+ * the same bytes as the scalar loop.
+ */
+
+#define COLORMAP_LUT_SIZE 4096
+
+typedef enum {
+    COLORMAP_HF = 0,        // HF radio scheme of png_intensity_to_color()
+    COLORMAP_GRAY,          // Black to white
+    COLORMAP_VIRIDIS,       // Perceptually uniform, blue-green-yellow
+    COLORMAP_INFERNO,       // Perceptually uniform, black-red-yellow
+    COLORMAP_TURBO,         // Rainbow-like, high contrast
+    COLORMAP_COUNT
+} colormap_palette_t;
+
+// Kernel families for colormap_map_row
+typedef enum {
+    COLORMAP_SIMD_NONE = 0, // Portable scalar C
+    COLORMAP_SIMD_SSE2,     // x86 SSE2 quantize, scalar lookup
+    COLORMAP_SIMD_AVX2,     // x86 AVX2 quantize and gather
+    COLORMAP_SIMD_NEON      // ARM AdvSIMD quantize, scalar lookup
+} colormap_simd_t;
+
+typedef struct {
+    colormap_palette_t palette;
+    colormap_simd_t simd;             // Row kernel family (COLORMAP_SIMD_NONE forces scalar)
+    uint32_t lut[COLORMAP_LUT_SIZE];  // r | g << 8 | b << 16 per entry
+} colormap_t;
+
+/*
+ * Sample 'palette' into the table and pick the best kernel for this CPU
+ * Returns false for an unknown palette.
+ */
+bool colormap_init(colormap_t *map, colormap_palette_t palette);
+
+// Palette by name ("hf", "gray", "viridis", "inferno", "turbo")
+bool colormap_from_name(const char *name, colormap_palette_t *palette);
+const char *colormap_name(colormap_palette_t palette);
+
+// Colour of one intensity in [0, 1] (clamped), through the table
+void colormap_lookup(const colormap_t *map, float intensity, uint8_t *r, uint8_t *g, uint8_t *b);
+
+/*
+ * Map 'count' values to 3 * count RGB bytes, 'lo' to the first table entry
+ * and 'hi' to the last. hi <= lo maps every value to the first entry.
+ */
+void colormap_map_row(const colormap_t *map, const float *values, size_t count,
+                      float lo, float hi, uint8_t *rgb);
+
+// Best row kernel family supported by the running CPU, and its name
+colormap_simd_t colormap_simd_detect(void);
+const char *colormap_simd_name(colormap_simd_t simd);
+
+#endif // IQ_COLORMAP_H
@@ -5,14 +5,16 @@
  *
  * PURPOSE:
  *   Creates PNG images for RF signal visualization including spectra and
- *   waterfalls. Uses the stb_image_write library for high-quality, compressed
- *   PNG output with proper color mapping and axis annotation.
+ *   waterfalls, compressed by a built-in deflate encoder (no zlib) with
+ *   proper color mapping and axis annotation.
  *
  * FEATURES:
  *   - Full-color RGB pixel manipulation
  *   - Automatic power-to-color mapping with configurable palettes
  *   - Memory-efficient image buffer management
- *   - PNG compression with high quality preservation
+ *   - Lossless PNG compression on all cores: row bands are deflated in
+ *     parallel and stitched into one zlib stream, byte-identical for any
+ *     thread count; fast/default/best effort levels
  *   - Support for large images (limited only by available memory)
  *   - Error handling for invalid operations
  *
@@ -31,12 +33,11 @@
  *
  * PERFORMANCE:
  *   - In-memory buffer operations for speed
- *   - PNG compression performed once at save time
+ *   - PNG compression performed once at save time, one row band per thread
  *   - Minimal memory overhead beyond image data
  *
  * DEPENDENCIES:
- *   - stb_image_write.h: Single-file PNG writing library
- *   - Standard C libraries (stdlib, string, stdio)
+ *   - Standard C libraries (stdlib, string, stdio) and pthreads
  *
  * FILE FORMAT:
  *   - PNG (Portable Network Graphics)
@@ -46,17 +47,28 @@
  *
  * LIMITATIONS:
  *   - No alpha channel support (RGB only)
- *   - Image size limited by available RAM
- *   - Single-threaded operation
+ *   - png_image_t size limited by available RAM; very large images (full
+ *     resolution waterfalls) go through the row-streaming png_stream_t
+ *     writer, whose memory depends only on the row width
  *
  * =============================================================================
  */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // sysconf under -std=c11
+#endif
+
 #include "img_png.h"
-#include "stb_image_write.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 bool png_image_init(png_image_t *img, uint32_t width, uint32_t height) {
     if (!img || width == 0 || height == 0) {
@@ -89,6 +101,18 @@ void png_image_set_pixel(png_image_t *img, uint32_t x, uint32_t y,
     img->data[pixel_idx + 2] = b;
 }
 
+void png_image_set_row(png_image_t *img, uint32_t x, uint32_t y,
+                        const uint8_t *rgb, uint32_t count) {
+    if (!img || !img->data || !rgb || x >= img->width || y >= img->height) {
+        return;
+    }
+
+    if (count > img->width - x) {
+        count = img->width - x;
+    }
+    memcpy(img->data + ((size_t)y * img->width + x) * 3, rgb, (size_t)count * 3);
+}
+
 bool png_image_get_pixel(const png_image_t *img, uint32_t x, uint32_t y,
                         uint8_t *r, uint8_t *g, uint8_t *b) {
     if (!img || !img->data || x >= img->width || y >= img->height) {
@@ -171,19 +195,6 @@ void png_intensity_to_color(float intensity, uint8_t *r, uint8_t *g, uint8_t *b)
     }
 }
 
-bool png_image_write(const png_image_t *img, const char *filename) {
-    if (!img || !img->data || !filename) {
-        return false;
-    }
-
-    // Use stb_image_write to save PNG
-    // Note: stb_image_write expects data in row-major order from top to bottom
-    int result = stbi_write_png(filename, (int)img->width, (int)img->height, 3,
-                               img->data, (int)img->width * 3);
-
-    return result != 0;
-}
-
 void png_image_free(png_image_t *img) {
     if (img) {
         if (img->data) {
@@ -195,3 +206,622 @@ void png_image_free(png_image_t *img) {
         img->data_size = 0;
     }
 }
+
+/*
+ * Deflate encoder shared by both writers
+ * Scanlines get the per-row adaptive filter (minimum sum of absolute
+ * differences, as libpng does) and go through a small LZ77 encoder: 3-byte
+ * hash chains over the last 32 KB, fixed Huffman codes. The streaming
+ * writer keeps one open block closed by an empty final block and hands
+ * compressed bytes on as IDAT chunks every PNG_STREAM_IDAT_BYTES; the band
+ * writer gives each band its own block and window.
+ */
+
+#define PNG_STREAM_MIN_MATCH 3
+#define PNG_STREAM_MAX_MATCH 258
+
+// Match candidates tried per position, by png_level_t
+static const uint32_t png_level_chain[3] = { 4, 32, 256 };
+
+static const uint16_t png_len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t png_len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t png_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t png_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static void png_put_be32(uint8_t *dst, uint32_t v) {
+    dst[0] = (uint8_t)(v >> 24);
+    dst[1] = (uint8_t)(v >> 16);
+    dst[2] = (uint8_t)(v >> 8);
+    dst[3] = (uint8_t)v;
+}
+
+static void png_crc_init(uint32_t table[256]) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[n] = c;
+    }
+}
+
+static bool png_write_chunk(FILE *file, const uint32_t *crc_table, const char *type,
+                            const uint8_t *data, size_t len) {
+    uint8_t head[8];
+    png_put_be32(head, (uint32_t)len);
+    memcpy(head + 4, type, 4);
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (int i = 4; i < 8; i++) crc = crc_table[(crc ^ head[i]) & 0xFF] ^ (crc >> 8);
+    for (size_t i = 0; i < len; i++) crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    uint8_t tail[4];
+    png_put_be32(tail, crc ^ 0xFFFFFFFFu);
+
+    return fwrite(head, 1, 8, file) == 8 &&
+           (len == 0 || fwrite(data, 1, len, file) == len) &&
+           fwrite(tail, 1, 4, file) == 4;
+}
+
+// Signature and IHDR: 8-bit RGB, deflate, adaptive filtering, no interlace
+static bool png_write_header(FILE *file, const uint32_t *crc_table, uint32_t width, uint32_t height) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t ihdr[13];
+    png_put_be32(ihdr, width);
+    png_put_be32(ihdr + 4, height);
+    ihdr[8] = 8;
+    ihdr[9] = 2;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+    return fwrite(signature, 1, 8, file) == 8 &&
+           png_write_chunk(file, crc_table, "IHDR", ihdr, sizeof(ihdr));
+}
+
+static void png_deflate_set_level(png_deflate_t *z, png_level_t level) {
+    if ((unsigned)level > PNG_LEVEL_BEST) level = PNG_LEVEL_DEFAULT;
+    z->max_chain = png_level_chain[level];
+    z->insert_matched = level != PNG_LEVEL_FAST;
+}
+
+static void png_deflate_free(png_deflate_t *z) {
+    free(z->window);
+    free(z->head);
+    free(z->chain);
+    free(z->out);
+    memset(z, 0, sizeof(*z));
+}
+
+static bool png_deflate_init(png_deflate_t *z, png_level_t level, size_t out_cap,
+                             void (*spill)(void *ctx), void *spill_ctx) {
+    memset(z, 0, sizeof(*z));
+    z->window = (uint8_t *)malloc(2 * PNG_STREAM_WINDOW);
+    z->head = (int32_t *)malloc(PNG_STREAM_HASH_SIZE * sizeof(int32_t));
+    z->chain = (int32_t *)malloc(PNG_STREAM_WINDOW * sizeof(int32_t));
+    z->out = (uint8_t *)malloc(out_cap);
+    if (!z->window || !z->head || !z->chain || !z->out) {
+        png_deflate_free(z);
+        return false;
+    }
+    for (size_t h = 0; h < PNG_STREAM_HASH_SIZE; h++) z->head[h] = -1;
+    for (size_t c = 0; c < PNG_STREAM_WINDOW; c++) z->chain[c] = -1;
+    z->out_cap = out_cap;
+    z->spill = spill;
+    z->spill_ctx = spill_ctx;
+    z->adler_a = 1;
+    png_deflate_set_level(z, level);
+    return true;
+}
+
+// 'out' is full: hand it on, or grow it when the caller keeps everything
+static void png_deflate_spill(png_deflate_t *z) {
+    if (z->spill) {
+        z->spill(z->spill_ctx);
+        return;
+    }
+    uint8_t *grown = z->failed ? NULL : (uint8_t *)realloc(z->out, 2 * z->out_cap);
+    if (!grown) {
+        z->failed = true;
+        z->out_len = 0;     // Keep writing into the old buffer; the result is discarded
+        return;
+    }
+    z->out = grown;
+    z->out_cap *= 2;
+}
+
+// Append bits LSB first, as deflate packs them
+static void png_put_bits(png_deflate_t *z, uint32_t value, uint32_t count) {
+    z->bit_buf |= value << z->bit_count;
+    z->bit_count += count;
+    while (z->bit_count >= 8) {
+        z->out[z->out_len++] = (uint8_t)z->bit_buf;
+        z->bit_buf >>= 8;
+        z->bit_count -= 8;
+        if (z->out_len >= z->out_cap) png_deflate_spill(z);
+    }
+}
+
+// Huffman codes are defined MSB first
+static void png_put_code(png_deflate_t *z, uint32_t code, uint32_t length) {
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    png_put_bits(z, reversed, length);
+}
+
+// Fixed literal/length code for symbol 0..287
+static void png_put_symbol(png_deflate_t *z, uint32_t symbol) {
+    if (symbol < 144) png_put_code(z, 0x30 + symbol, 8);
+    else if (symbol < 256) png_put_code(z, 0x190 + symbol - 144, 9);
+    else if (symbol < 280) png_put_code(z, symbol - 256, 7);
+    else png_put_code(z, 0xC0 + symbol - 280, 8);
+}
+
+static void png_put_match(png_deflate_t *z, uint32_t length, uint32_t distance) {
+    int l = 28;
+    while (png_len_base[l] > length) l--;
+    png_put_symbol(z, 257 + (uint32_t)l);
+    png_put_bits(z, length - png_len_base[l], png_len_extra[l]);
+
+    int d = 29;
+    while (png_dist_base[d] > distance) d--;
+    png_put_code(z, (uint32_t)d, 5);
+    png_put_bits(z, distance - png_dist_base[d], png_dist_extra[d]);
+}
+
+static uint32_t png_hash3(const uint8_t *p) {
+    return (((uint32_t)p[0] << 10) ^ ((uint32_t)p[1] << 5) ^ p[2]) & (PNG_STREAM_HASH_SIZE - 1);
+}
+
+static void png_insert_hash(png_deflate_t *z, size_t pos) {
+    uint32_t h = png_hash3(z->window + pos);
+    z->chain[pos & (PNG_STREAM_WINDOW - 1)] = z->head[h];
+    z->head[h] = (int32_t)pos;
+}
+
+// Compress window[begin, end); matches never reach past 'end'
+static void png_compress_range(png_deflate_t *z, size_t begin, size_t end) {
+    const uint8_t *win = z->window;
+    size_t p = begin;
+
+    while (p < end) {
+        size_t remaining = end - p;
+        size_t best_len = 0, best_dist = 0;
+
+        if (remaining >= PNG_STREAM_MIN_MATCH) {
+            uint32_t h = png_hash3(win + p);
+            int32_t cand = z->head[h];
+            z->chain[p & (PNG_STREAM_WINDOW - 1)] = cand;
+            z->head[h] = (int32_t)p;
+
+            size_t max_len = remaining < PNG_STREAM_MAX_MATCH ? remaining : PNG_STREAM_MAX_MATCH;
+            for (uint32_t tries = 0; cand >= 0 && tries < z->max_chain; tries++) {
+                size_t dist = p - (size_t)cand;
+                if (dist >= PNG_STREAM_WINDOW) break;
+                const uint8_t *a = win + cand, *b = win + p;
+                if (a[best_len] == b[best_len]) {
+                    size_t len = 0;
+                    while (len < max_len && a[len] == b[len]) len++;
+                    if (len > best_len) {
+                        best_len = len;
+                        best_dist = dist;
+                        if (len == max_len) break;
+                    }
+                }
+                cand = z->chain[cand & (PNG_STREAM_WINDOW - 1)];
+            }
+        }
+
+        if (best_len >= PNG_STREAM_MIN_MATCH) {
+            png_put_match(z, (uint32_t)best_len, (uint32_t)best_dist);
+            for (size_t k = 1; z->insert_matched && k < best_len; k++) {
+                if (end - (p + k) >= PNG_STREAM_MIN_MATCH) png_insert_hash(z, p + k);
+            }
+            p += best_len;
+        } else {
+            png_put_symbol(z, win[p]);
+            p++;
+        }
+    }
+}
+
+// Feed uncompressed zlib payload through the window
+static void png_deflate(png_deflate_t *z, const uint8_t *data, size_t len) {
+    // Adler-32 of the uncompressed stream; 5552 bytes keep the sums in range
+    for (size_t i = 0; i < len; ) {
+        size_t n = len - i < 5552 ? len - i : 5552;
+        for (size_t k = 0; k < n; k++) {
+            z->adler_a += data[i + k];
+            z->adler_b += z->adler_a;
+        }
+        z->adler_a %= 65521u;
+        z->adler_b %= 65521u;
+        i += n;
+    }
+
+    while (len > 0) {
+        size_t n = len < PNG_STREAM_WINDOW ? len : PNG_STREAM_WINDOW;
+
+        // Slide the window by one half once it would overflow
+        if (z->window_len + n > 2 * PNG_STREAM_WINDOW) {
+            memmove(z->window, z->window + PNG_STREAM_WINDOW, z->window_len - PNG_STREAM_WINDOW);
+            z->window_len -= PNG_STREAM_WINDOW;
+            for (size_t h = 0; h < PNG_STREAM_HASH_SIZE; h++) {
+                z->head[h] = z->head[h] >= PNG_STREAM_WINDOW ? z->head[h] - PNG_STREAM_WINDOW : -1;
+            }
+            for (size_t c = 0; c < PNG_STREAM_WINDOW; c++) {
+                z->chain[c] = z->chain[c] >= PNG_STREAM_WINDOW ? z->chain[c] - PNG_STREAM_WINDOW : -1;
+            }
+        }
+
+        memcpy(z->window + z->window_len, data, n);
+        png_compress_range(z, z->window_len, z->window_len + n);
+        z->window_len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+// Adler-32 of A followed by B, from the checksums of both and B's length
+static uint32_t png_adler_combine(uint32_t adler_a, uint32_t adler_b, size_t len_b) {
+    const uint64_t base = 65521u;
+    uint64_t rem = len_b % base;
+    uint64_t a1 = adler_a & 0xFFFF, b1 = adler_a >> 16;
+    uint64_t a2 = adler_b & 0xFFFF, b2 = adler_b >> 16;
+    uint64_t a = (a1 + a2 + base - 1) % base;
+    uint64_t b = (b1 + b2 + rem * a1 + base - rem) % base;   // b1 + b2 + len_b * (a1 - 1)
+    return (uint32_t)((b << 16) | a);
+}
+
+static uint8_t png_paeth(uint8_t a, uint8_t b, uint8_t c) {
+    int p = (int)a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+/*
+ * Filter one row of n bytes against the unfiltered row above it
+ * 'filtered' holds five candidates of n + 1 bytes (filter byte first); the
+ * one with the smallest magnitude is returned. PNG_LEVEL_FAST only builds Up.
+ */
+static const uint8_t *png_filter_row(const uint8_t *rgb, const uint8_t *up, size_t n,
+                                     png_level_t level, uint8_t *filtered) {
+    if (level == PNG_LEVEL_FAST) {
+        filtered[0] = 2;
+        for (size_t i = 0; i < n; i++) filtered[i + 1] = (uint8_t)(rgb[i] - up[i]);
+        return filtered;
+    }
+
+    // Build all five filters and keep the one with the smallest magnitude
+    size_t best = 0;
+    uint64_t best_sum = UINT64_MAX;
+    for (size_t f = 0; f < 5; f++) {
+        uint8_t *dst = filtered + f * (n + 1);
+        dst[0] = (uint8_t)f;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint8_t a = i >= 3 ? rgb[i - 3] : 0;
+            uint8_t b = up[i];
+            uint8_t c = i >= 3 ? up[i - 3] : 0;
+            uint8_t v;
+            switch (f) {
+                case 0: v = rgb[i]; break;
+                case 1: v = (uint8_t)(rgb[i] - a); break;
+                case 2: v = (uint8_t)(rgb[i] - b); break;
+                case 3: v = (uint8_t)(rgb[i] - (uint8_t)(((unsigned)a + b) >> 1)); break;
+                default: v = (uint8_t)(rgb[i] - png_paeth(a, b, c)); break;
+            }
+            dst[i + 1] = v;
+            sum += v < 128 ? v : 256u - v;
+        }
+        if (sum < best_sum) {
+            best_sum = sum;
+            best = f;
+        }
+    }
+    return filtered + best * (n + 1);
+}
+
+/*
+ * Band writer (png_image_write_ex)
+ */
+
+void png_write_options_default(png_write_options_t *opts) {
+    if (!opts) return;
+    opts->num_threads = 0;
+    opts->level = PNG_LEVEL_DEFAULT;
+    opts->band_rows = 0;
+}
+
+bool png_level_from_name(const char *name, png_level_t *level) {
+    if (!name || !level) return false;
+    if (strcmp(name, "fast") == 0) *level = PNG_LEVEL_FAST;
+    else if (strcmp(name, "default") == 0) *level = PNG_LEVEL_DEFAULT;
+    else if (strcmp(name, "best") == 0) *level = PNG_LEVEL_BEST;
+    else return false;
+    return true;
+}
+
+static uint32_t png_default_threads(void) {
+    long count;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = (long)info.dwNumberOfProcessors;
+#else
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (count < 1) count = 1;
+    if (count > PNG_WRITE_MAX_THREADS) count = PNG_WRITE_MAX_THREADS;
+    return (uint32_t)count;
+}
+
+typedef struct {
+    const png_image_t *img;
+    png_level_t level;
+    uint32_t y0, y1;        // Rows [y0, y1)
+    png_deflate_t z;        // Holds the band's compressed bytes once done
+    size_t raw_len;         // Filtered bytes fed to the encoder
+    bool ok;
+    bool started;
+    pthread_t thread;
+} png_band_t;
+
+static void *png_band_run(void *arg) {
+    png_band_t *band = (png_band_t *)arg;
+    band->ok = false;
+
+    const size_t n = (size_t)band->img->width * 3;
+    const uint8_t *data = band->img->data;
+    band->raw_len = (size_t)(band->y1 - band->y0) * (n + 1);
+    uint8_t *filtered = (uint8_t *)malloc(5 * (n + 1));
+    uint8_t *zeros = band->y0 == 0 ? (uint8_t *)calloc(n, 1) : NULL;
+    if (!filtered || (band->y0 == 0 && !zeros) ||
+        !png_deflate_init(&band->z, band->level, band->raw_len / 4 + 64, NULL, NULL)) {
+        free(filtered);
+        free(zeros);
+        return NULL;
+    }
+
+    // The first band opens the zlib stream; every band is one non-final fixed block
+    png_deflate_t *z = &band->z;
+    if (band->y0 == 0) {
+        png_put_bits(z, 0x78, 8);
+        png_put_bits(z, 0x01, 8);
+    }
+    png_put_bits(z, 0, 1);
+    png_put_bits(z, 1, 2);
+    for (uint32_t y = band->y0; y < band->y1; y++) {
+        const uint8_t *rgb = data + (size_t)y * n;
+        const uint8_t *up = y > 0 ? rgb - n : zeros;
+        png_deflate(z, png_filter_row(rgb, up, n, band->level, filtered), n + 1);
+    }
+
+    // End the block, then an empty stored block lands on a byte boundary
+    png_put_symbol(z, 256);
+    png_put_bits(z, 0, 3);
+    if (z->bit_count) png_put_bits(z, 0, 8 - z->bit_count);
+    png_put_bits(z, 0x0000, 16);
+    png_put_bits(z, 0xFFFF, 16);
+
+    free(filtered);
+    free(zeros);
+    band->ok = !z->failed;
+    return NULL;
+}
+
+bool png_image_write(const png_image_t *img, const char *filename) {
+    return png_image_write_ex(img, filename, NULL);
+}
+
+bool png_image_write_ex(const png_image_t *img, const char *filename,
+                        const png_write_options_t *opts) {
+    if (!img || !img->data || !filename || img->width == 0 || img->height == 0) {
+        return false;
+    }
+    png_write_options_t defaults;
+    if (!opts) {
+        png_write_options_default(&defaults);
+        opts = &defaults;
+    }
+
+    // Band edges follow from the image alone, so any thread count writes the same file
+    const size_t row_bytes = (size_t)img->width * 3;
+    uint32_t band_rows = opts->band_rows;
+    if (band_rows == 0) {
+        size_t rows = PNG_BAND_BYTES / row_bytes;
+        band_rows = rows < 1 ? 1 : rows > img->height ? img->height : (uint32_t)rows;
+    }
+    const uint32_t num_bands = (uint32_t)(((uint64_t)img->height + band_rows - 1) / band_rows);
+    uint32_t num_threads = opts->num_threads ? opts->num_threads : png_default_threads();
+    if (num_threads > PNG_WRITE_MAX_THREADS) num_threads = PNG_WRITE_MAX_THREADS;
+    if (num_threads > num_bands) num_threads = num_bands;
+
+    png_band_t *bands = (png_band_t *)calloc(num_threads, sizeof(*bands));
+    if (!bands) {
+        return false;
+    }
+    uint32_t crc_table[256];
+    png_crc_init(crc_table);
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot create PNG file: %s\n", filename);
+        free(bands);
+        return false;
+    }
+    bool ok = png_write_header(file, crc_table, img->width, img->height);
+
+    // num_threads bands at a time; worker 0 runs on the calling thread
+    uint32_t adler = 1;
+    for (uint32_t first = 0; ok && first < num_bands; first += num_threads) {
+        uint32_t count = num_bands - first < num_threads ? num_bands - first : num_threads;
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t y0 = (uint64_t)(first + i) * band_rows;
+            uint64_t y1 = y0 + band_rows < img->height ? y0 + band_rows : img->height;
+            bands[i].img = img;
+            bands[i].level = opts->level;
+            bands[i].y0 = (uint32_t)y0;
+            bands[i].y1 = (uint32_t)y1;
+        }
+        for (uint32_t i = 1; i < count; i++) {
+            bands[i].started = pthread_create(&bands[i].thread, NULL, png_band_run, &bands[i]) == 0;
+        }
+        png_band_run(&bands[0]);
+        for (uint32_t i = 1; i < count; i++) {
+            if (bands[i].started) {
+                pthread_join(bands[i].thread, NULL);
+            } else {
+                png_band_run(&bands[i]);   // Could not spawn: do the band here
+            }
+        }
+
+        // Bands leave in image order
+        for (uint32_t i = 0; i < count; i++) {
+            ok = ok && bands[i].ok &&
+                 png_write_chunk(file, crc_table, "IDAT", bands[i].z.out, bands[i].z.out_len);
+            adler = png_adler_combine(adler, (bands[i].z.adler_b << 16) | bands[i].z.adler_a,
+                                      bands[i].raw_len);
+            png_deflate_free(&bands[i].z);
+        }
+    }
+
+    // Empty final fixed block (BFINAL = 1, BTYPE = 01, end of block), then Adler-32
+    uint8_t tail[6] = { 0x03, 0x00 };
+    png_put_be32(tail + 2, adler);
+    ok = ok && png_write_chunk(file, crc_table, "IDAT", tail, sizeof(tail)) &&
+         png_write_chunk(file, crc_table, "IEND", NULL, 0);
+    if (fclose(file) != 0) ok = false;
+    free(bands);
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to write PNG file: %s\n", filename);
+    }
+    return ok;
+}
+
+/*
+ * Row-streaming writer (png_stream_t)
+ */
+
+static void png_stream_flush_idat(png_stream_t *png) {
+    if (png->z.out_len == 0) return;
+    if (!png->failed && !png_write_chunk(png->file, png->crc_table, "IDAT", png->z.out, png->z.out_len)) {
+        png->failed = true;
+    }
+    png->z.out_len = 0;
+}
+
+static void png_stream_spill(void *ctx) {
+    png_stream_flush_idat((png_stream_t *)ctx);
+}
+
+bool png_stream_open(png_stream_t *png, const char *filename, uint32_t width, uint32_t height) {
+    if (!png || !filename) return false;
+    memset(png, 0, sizeof(*png));
+    if (width == 0 || height == 0 || width > 0x7FFFFFFFu / 3 || height > 0x7FFFFFFFu) {
+        fprintf(stderr, "Error: Invalid PNG size %ux%u\n", width, height);
+        return false;
+    }
+
+    png->width = width;
+    png->height = height;
+    png->row_bytes = (size_t)width * 3;
+    png->level = PNG_LEVEL_DEFAULT;
+    png->prev_row = (uint8_t *)calloc(png->row_bytes, 1);
+    png->filtered = (uint8_t *)malloc(5 * (png->row_bytes + 1));
+    if (!png->prev_row || !png->filtered ||
+        !png_deflate_init(&png->z, png->level, PNG_STREAM_IDAT_BYTES, png_stream_spill, png)) {
+        fprintf(stderr, "Error: Failed to allocate PNG stream for %u pixel rows\n", width);
+        png->failed = true;
+        png_stream_close(png);
+        return false;
+    }
+    png_crc_init(png->crc_table);
+
+    png->file = fopen(filename, "wb");
+    if (!png->file) {
+        fprintf(stderr, "Error: Cannot create PNG file: %s\n", filename);
+        png->failed = true;
+        png_stream_close(png);
+        return false;
+    }
+    if (!png_write_header(png->file, png->crc_table, width, height)) png->failed = true;
+
+    // zlib header (32 KB window, no dictionary), then a non-final fixed block
+    png_put_bits(&png->z, 0x78, 8);
+    png_put_bits(&png->z, 0x01, 8);
+    png_put_bits(&png->z, 0, 1);
+    png_put_bits(&png->z, 1, 2);
+
+    return !png->failed;
+}
+
+void png_stream_set_level(png_stream_t *png, png_level_t level) {
+    if (!png) return;
+    png->level = (unsigned)level > PNG_LEVEL_BEST ? PNG_LEVEL_DEFAULT : level;
+    png_deflate_set_level(&png->z, png->level);
+}
+
+bool png_stream_write_row(png_stream_t *png, const uint8_t *rgb) {
+    if (!png || !png->file || !rgb || png->failed) return false;
+    if (png->rows_written >= png->height) {
+        fprintf(stderr, "Error: PNG stream already has %u rows\n", png->height);
+        return false;
+    }
+
+    const size_t n = png->row_bytes;
+    png_deflate(&png->z, png_filter_row(rgb, png->prev_row, n, png->level, png->filtered), n + 1);
+    memcpy(png->prev_row, rgb, n);
+    png->rows_written++;
+    return !png->failed;
+}
+
+bool png_stream_close(png_stream_t *png) {
+    if (!png) return false;
+
+    bool ok = false;
+    if (png->file) {
+        if (!png->failed) {
+            if (png->rows_written != png->height) {
+                fprintf(stderr, "Error: PNG stream got %u of %u rows\n", png->rows_written, png->height);
+                png->failed = true;
+            }
+
+            // End the open block, add an empty final block, align, Adler-32
+            png_deflate_t *z = &png->z;
+            png_put_symbol(z, 256);
+            png_put_bits(z, 1, 1);
+            png_put_bits(z, 1, 2);
+            png_put_symbol(z, 256);
+            if (z->bit_count) png_put_bits(z, 0, 8 - z->bit_count);
+            uint32_t adler = (z->adler_b << 16) | z->adler_a;
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                png_put_bits(z, (adler >> shift) & 0xFF, 8);
+            }
+            png_stream_flush_idat(png);
+            if (!png->failed && !png_write_chunk(png->file, png->crc_table, "IEND", NULL, 0)) {
+                png->failed = true;
+            }
+        }
+        if (fclose(png->file) != 0) png->failed = true;
+        png->file = NULL;
+        ok = !png->failed;
+    }
+
+    free(png->prev_row);
+    free(png->filtered);
+    png_deflate_free(&png->z);
+    memset(png, 0, sizeof(*png));
+    return ok;
+}
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 
 // PNG image context
 typedef struct {
@@ -28,6 +29,13 @@ bool png_image_init(png_image_t *img, uint32_t width, uint32_t height);
 void png_image_set_pixel(png_image_t *img, uint32_t x, uint32_t y,
                         uint8_t r, uint8_t g, uint8_t b);
 
+/*
+ * Copy 'count' RGB pixels (3 bytes each) into row y starting at column x
+ * One bounds check per row; pixels past the right edge are dropped
+ */
+void png_image_set_row(png_image_t *img, uint32_t x, uint32_t y,
+                        const uint8_t *rgb, uint32_t count);
+
 /*
  * Get pixel color at (x,y) coordinates
  * Returns true if coordinates are valid, false otherwise
@@ -47,15 +55,129 @@ void png_image_fill(png_image_t *img, uint8_t r, uint8_t g, uint8_t b);
  */
 void png_intensity_to_color(float intensity, uint8_t *r, uint8_t *g, uint8_t *b);
 
+/*
+ * Deflate effort, shared by png_image_write_ex() and the row-streaming writer
+ * FAST filters every row with Up and tries few matches (interactive runs),
+ * DEFAULT picks the best of the five filters per row, BEST also searches
+ * much longer match chains.
+ */
+typedef enum {
+    PNG_LEVEL_FAST = 0,
+    PNG_LEVEL_DEFAULT,
+    PNG_LEVEL_BEST
+} png_level_t;
+
+// Pixel bytes per band when band_rows is 0
+#define PNG_BAND_BYTES (1u << 20)
+#define PNG_WRITE_MAX_THREADS 64
+
+typedef struct {
+    uint32_t num_threads;   // 0 = one per CPU
+    png_level_t level;
+    uint32_t band_rows;     // Rows per independently deflated band (0 = about PNG_BAND_BYTES)
+} png_write_options_t;
+
+// All CPUs, PNG_LEVEL_DEFAULT, automatic bands
+void png_write_options_default(png_write_options_t *opts);
+
+// Level by name ("fast", "default", "best")
+bool png_level_from_name(const char *name, png_level_t *level);
+
 /*
  * Write PNG image to file
  * Returns true on success, false on failure
+ * Same as png_image_write_ex() with default options.
  */
 bool png_image_write(const png_image_t *img, const char *filename);
 
+/*
+ * Write PNG image to file, deflating row bands on several threads
+ * Each band is filtered against the row above it (as a sequential encoder
+ * would), deflated with a fresh window and ended on a byte boundary with an
+ * empty stored block, so the bands concatenate into one zlib stream; the
+ * Adler-32 checksums are combined in band order. Band edges depend only on
+ * the image size and band_rows, never on the thread count, so the file is
+ * byte-identical for any num_threads. Bands are compressed num_threads at
+ * a time and written in order, holding at most that many in memory.
+ * NULL opts selects png_write_options_default().
+ */
+bool png_image_write_ex(const png_image_t *img, const char *filename,
+                        const png_write_options_t *opts);
+
 /*
  * Free PNG image resources
  */
 void png_image_free(png_image_t *img);
 
+/*
+ * Row-streaming PNG writer
+ * Rows are filtered, deflated and flushed to IDAT chunks as they arrive, so
+ * memory is bounded by the row width and the 32 KB deflate window instead of
+ * the image size. The height must be known up front (it goes in IHDR).
+ * Deflate is LZ77 with fixed Huffman codes; no external zlib is needed.
+ */
+
+#define PNG_STREAM_WINDOW 32768         // Deflate window (maximum distance)
+#define PNG_STREAM_HASH_SIZE 32768      // Match-finder hash heads
+#define PNG_STREAM_IDAT_BYTES 65536     // Compressed bytes per IDAT chunk
+
+// Deflate encoder state (LZ77 + fixed Huffman codes)
+typedef struct {
+    uint8_t *window;        // 2 * PNG_STREAM_WINDOW bytes of recent input
+    size_t window_len;
+    int32_t *head;          // Latest window position per 3-byte hash
+    int32_t *chain;         // Previous position with the same hash
+    uint32_t max_chain;     // Match candidates tried per position
+    bool insert_matched;    // Hash every position inside a match
+    uint32_t bit_buf;
+    uint32_t bit_count;
+    uint32_t adler_a, adler_b;
+
+    uint8_t *out;           // Compressed bytes not yet handed on
+    size_t out_len;
+    size_t out_cap;
+    void (*spill)(void *ctx);   // Empties a full 'out'; NULL grows it instead
+    void *spill_ctx;
+    bool failed;
+} png_deflate_t;
+
+typedef struct {
+    FILE *file;
+    uint32_t width;         // Pixels per row
+    uint32_t height;        // Rows declared in IHDR
+    uint32_t rows_written;
+    size_t row_bytes;       // width * 3
+    uint8_t *prev_row;      // Previous unfiltered row (zeros before row 0)
+    uint8_t *filtered;      // Five candidate filtered rows, filter byte first
+    png_level_t level;
+    png_deflate_t z;
+    uint32_t crc_table[256];
+    bool failed;
+} png_stream_t;
+
+/*
+ * Create 'filename' and write the PNG header for a width x height RGB image
+ * Returns false on invalid size, allocation or I/O failure.
+ */
+bool png_stream_open(png_stream_t *png, const char *filename, uint32_t width, uint32_t height);
+
+/*
+ * Compression effort for the rows still to come (PNG_LEVEL_DEFAULT after open)
+ * Call before the first row so the whole image uses one level.
+ */
+void png_stream_set_level(png_stream_t *png, png_level_t level);
+
+/*
+ * Append the next row, top to bottom: width RGB pixels (3 bytes each)
+ * Rows beyond the declared height are rejected.
+ */
+bool png_stream_write_row(png_stream_t *png, const uint8_t *rgb);
+
+/*
+ * Finish the stream and close the file
+ * Returns false if a write failed or fewer rows than declared were written;
+ * resources are freed either way.
+ */
+bool png_stream_close(png_stream_t *png);
+
 #endif // IQ_IMG_PNG_H
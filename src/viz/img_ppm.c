@@ -34,6 +34,18 @@ void ppm_image_set_pixel(ppm_image_t *img, uint32_t x, uint32_t y,
     img->data[pixel_idx + 2] = b;
 }
 
+void ppm_image_set_row(ppm_image_t *img, uint32_t x, uint32_t y,
+                        const uint8_t *rgb, uint32_t count) {
+    if (!img || !img->data || !rgb || x >= img->width || y >= img->height) {
+        return;
+    }
+
+    if (count > img->width - x) {
+        count = img->width - x;
+    }
+    memcpy(img->data + ((size_t)y * img->width + x) * 3, rgb, (size_t)count * 3);
+}
+
 bool ppm_image_get_pixel(const ppm_image_t *img, uint32_t x, uint32_t y,
                         uint8_t *r, uint8_t *g, uint8_t *b) {
     if (!img || !img->data || x >= img->width || y >= img->height) {
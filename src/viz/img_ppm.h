@@ -28,6 +28,13 @@ bool ppm_image_init(ppm_image_t *img, uint32_t width, uint32_t height);
 void ppm_image_set_pixel(ppm_image_t *img, uint32_t x, uint32_t y,
                         uint8_t r, uint8_t g, uint8_t b);
 
+/*
+ * Copy 'count' RGB pixels (3 bytes each) into row y starting at column x
+ * One bounds check per row; pixels past the right edge are dropped
+ */
+void ppm_image_set_row(ppm_image_t *img, uint32_t x, uint32_t y,
+                        const uint8_t *rgb, uint32_t count);
+
 /*
  * Get pixel color at (x,y) coordinates
  * Returns true if coordinates are valid, false otherwise
@@ -0,0 +1,202 @@
+/*
+ * IQ Lab - NumPy .npy Row Stream
+ *
+ * Rows are converted into an output buffer and written once it holds
+ * NPY_STREAM_BUFFER_BYTES. The header reserves room for the largest shape
+ * line, so patching the row count at close never moves the data.
+ */
+
+#include "npy_stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static bool npy_host_little_endian(void) {
+    const uint16_t probe = 1;
+    uint8_t first;
+    memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+bool npy_dtype_from_name(const char *name, npy_dtype_t *dtype) {
+    if (!name || !dtype) return false;
+    if (strcmp(name, "f32") == 0 || strcmp(name, "float32") == 0) {
+        *dtype = NPY_FLOAT32;
+        return true;
+    }
+    if (strcmp(name, "f16") == 0 || strcmp(name, "float16") == 0) {
+        *dtype = NPY_FLOAT16;
+        return true;
+    }
+    return false;
+}
+
+size_t npy_dtype_size(npy_dtype_t dtype) {
+    return dtype == NPY_FLOAT16 ? 2 : 4;
+}
+
+uint16_t npy_float_to_half(float value) {
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    const uint16_t sign = (uint16_t)((x >> 16) & 0x8000u);
+    const uint32_t exponent = (x >> 23) & 0xFFu;
+    uint32_t mantissa = x & 0x7FFFFFu;
+
+    if (exponent == 0xFF) {
+        // Infinity, or NaN kept quiet with its top payload bits
+        return (uint16_t)(sign | 0x7C00u | (mantissa ? 0x200u | (mantissa >> 13) : 0));
+    }
+
+    const int32_t e = (int32_t)exponent - 127 + 15;
+    if (e >= 31) return (uint16_t)(sign | 0x7C00u);   // Overflow to infinity
+    if (e <= 0) {
+        // Half subnormal (or zero): shift the full significand down, round to even
+        if (e < -10) return sign;
+        mantissa |= 0x800000u;
+        const uint32_t shift = (uint32_t)(14 - e);
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1))) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    // A rounding carry runs into the exponent, up to infinity: still correct
+    uint32_t half = ((uint32_t)e << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1))) half++;
+    return (uint16_t)(sign | half);
+}
+
+float npy_half_to_float(uint16_t half) {
+    const uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+    uint32_t x;
+
+    if (exponent == 0x1F) {
+        x = sign | 0x7F800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        x = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        x = sign;
+    } else {
+        // Subnormal: normalize into a float exponent
+        int32_t e = 127 - 15 + 1;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            e--;
+        }
+        x = sign | ((uint32_t)e << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+
+    float value;
+    memcpy(&value, &x, sizeof(value));
+    return value;
+}
+
+// Format 1.0 header, space padded to NPY_STREAM_HEADER_BYTES and ended by '\n'
+static bool npy_write_header(npy_stream_t *npy) {
+    uint8_t header[NPY_STREAM_HEADER_BYTES];
+    memcpy(header, "\x93NUMPY", 6);
+    header[6] = 1;
+    header[7] = 0;
+    const uint16_t dict_len = NPY_STREAM_HEADER_BYTES - 10;
+    header[8] = (uint8_t)(dict_len & 0xFF);
+    header[9] = (uint8_t)(dict_len >> 8);
+
+    char dict[NPY_STREAM_HEADER_BYTES];
+    int len = snprintf(dict, sizeof(dict),
+                       "{'descr': '%c%c%u', 'fortran_order': False, 'shape': (%" PRIu64 ", %" PRIu32 "), }",
+                       npy_host_little_endian() ? '<' : '>', 'f',
+                       (unsigned)npy_dtype_size(npy->dtype), npy->rows_written, npy->cols);
+    if (len < 0 || (size_t)len >= dict_len) return false;
+    memset(header + 10, ' ', dict_len);
+    memcpy(header + 10, dict, (size_t)len);
+    header[NPY_STREAM_HEADER_BYTES - 1] = '\n';
+
+    return fwrite(header, 1, sizeof(header), npy->file) == sizeof(header);
+}
+
+static bool npy_flush(npy_stream_t *npy) {
+    if (npy->buffer_len == 0) return true;
+    if (fwrite(npy->buffer, 1, npy->buffer_len, npy->file) != npy->buffer_len) {
+        npy->failed = true;
+    }
+    npy->buffer_len = 0;
+    return !npy->failed;
+}
+
+bool npy_stream_open(npy_stream_t *npy, const char *filename, npy_dtype_t dtype, uint32_t cols) {
+    if (!npy || !filename) return false;
+    memset(npy, 0, sizeof(*npy));
+
+    if (cols == 0 || (dtype != NPY_FLOAT32 && dtype != NPY_FLOAT16)) {
+        fprintf(stderr, "Error: Invalid .npy matrix layout (%u columns)\n", cols);
+        return false;
+    }
+    npy->dtype = dtype;
+    npy->cols = cols;
+
+    // At least one row per write
+    const size_t row_bytes = (size_t)cols * npy_dtype_size(dtype);
+    npy->buffer_cap = row_bytes > NPY_STREAM_BUFFER_BYTES ? row_bytes : NPY_STREAM_BUFFER_BYTES;
+    npy->buffer = malloc(npy->buffer_cap);
+    if (!npy->buffer) {
+        fprintf(stderr, "Error: Failed to allocate .npy stream buffer\n");
+        return false;
+    }
+
+    npy->file = fopen(filename, "wb");
+    if (!npy->file) {
+        fprintf(stderr, "Error: Cannot create .npy file: %s\n", filename);
+        free(npy->buffer);
+        npy->buffer = NULL;
+        return false;
+    }
+    if (!npy_write_header(npy)) {
+        fprintf(stderr, "Error: Failed to write .npy header: %s\n", filename);
+        npy->failed = true;
+    }
+    return true;
+}
+
+bool npy_stream_write_rows(npy_stream_t *npy, const float *values, uint64_t rows) {
+    if (!npy || !npy->file || !values) return false;
+    if (npy->failed) return false;
+
+    const size_t element = npy_dtype_size(npy->dtype);
+    const size_t row_bytes = (size_t)npy->cols * element;
+    for (uint64_t r = 0; r < rows; r++) {
+        if (npy->buffer_len + row_bytes > npy->buffer_cap && !npy_flush(npy)) return false;
+        const float *row = values + r * npy->cols;
+        uint8_t *out = npy->buffer + npy->buffer_len;
+        if (npy->dtype == NPY_FLOAT32) {
+            memcpy(out, row, row_bytes);
+        } else {
+            for (uint32_t c = 0; c < npy->cols; c++) {
+                const uint16_t half = npy_float_to_half(row[c]);
+                memcpy(out + (size_t)c * 2, &half, 2);
+            }
+        }
+        npy->buffer_len += row_bytes;
+        npy->rows_written++;
+    }
+    return true;
+}
+
+bool npy_stream_close(npy_stream_t *npy) {
+    if (!npy || !npy->file) return false;
+
+    bool ok = npy_flush(npy) && !npy->failed;
+    if (ok && (fseek(npy->file, 0, SEEK_SET) != 0 || !npy_write_header(npy))) {
+        fprintf(stderr, "Error: Failed to finish .npy header\n");
+        ok = false;
+    }
+    if (fclose(npy->file) != 0) ok = false;
+    npy->file = NULL;
+    free(npy->buffer);
+    npy->buffer = NULL;
+    npy->buffer_len = 0;
+    return ok;
+}
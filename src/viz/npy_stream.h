@@ -0,0 +1,64 @@
+#ifndef IQ_NPY_STREAM_H
+#define IQ_NPY_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Row-streaming NumPy .npy matrix writer
+ * A rows x cols float32 or float16 matrix in C order, readable with
+ * numpy.load() (np.load(path, mmap_mode='r') maps it without copying).
+ * Rows are gathered into a NPY_STREAM_BUFFER_BYTES buffer and leave in
+ * large sequential writes. The header (format 1.0) has a fixed size, padded
+ * so the data starts 64-byte aligned; the row count is written as 0 at open
+ * and patched in place at close, so the row total need not be known up
+ * front. Values are stored in the host byte order, which the header names.
+ */
+
+#define NPY_STREAM_HEADER_BYTES 128
+#define NPY_STREAM_BUFFER_BYTES (4u << 20)
+
+typedef enum {
+    NPY_FLOAT32 = 0,        // '<f4': full float range
+    NPY_FLOAT16 = 1         // '<f2': half the size; 11-bit precision, |x| <= 65504
+} npy_dtype_t;
+
+typedef struct {
+    FILE *file;
+    npy_dtype_t dtype;
+    uint32_t cols;              // Values per row
+    uint64_t rows_written;
+    uint8_t *buffer;            // Converted rows waiting for a write
+    size_t buffer_len;
+    size_t buffer_cap;
+    bool failed;
+} npy_stream_t;
+
+// Element type by name ("f32"/"float32", "f16"/"float16")
+bool npy_dtype_from_name(const char *name, npy_dtype_t *dtype);
+
+// Bytes per element
+size_t npy_dtype_size(npy_dtype_t dtype);
+
+/*
+ * Create 'filename' for a matrix of 'cols' columns
+ * The file must be seekable (the header is patched at close).
+ */
+bool npy_stream_open(npy_stream_t *npy, const char *filename, npy_dtype_t dtype, uint32_t cols);
+
+// Append 'rows' rows of cols float values (converted to the stream's dtype)
+bool npy_stream_write_rows(npy_stream_t *npy, const float *values, uint64_t rows);
+
+/*
+ * Flush, write the final row count into the header and close
+ * Returns false if any write failed; resources are freed either way.
+ */
+bool npy_stream_close(npy_stream_t *npy);
+
+// IEEE 754 binary16 conversion, round to nearest even; infinities and NaN kept
+uint16_t npy_float_to_half(float value);
+float npy_half_to_float(uint16_t half);
+
+#endif // IQ_NPY_STREAM_H
@@ -0,0 +1,394 @@
+/*
+ * IQ Lab - Tiled multi-resolution power pyramid
+ *
+ * Rows cascade through the levels as they arrive: each level appends the
+ * row to its band, pools it horizontally, and every second pooled row is
+ * folded with the previous one and pushed to the next level. Bands become
+ * tile records as soon as they hold tile_size rows.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // fseeko under -std=c11
+#endif
+
+#include "tile_pyramid.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Header: magic, version, info fields, index offset, tile count
+#define TILE_HEADER_BYTES  (8 + 4 + 4 * 4 + 8 + 4 * 8 + 8 + 8)
+
+static int tile_file_seek(FILE *file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET);
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static void tile_write(tile_pyramid_writer_t *writer, const void *data, size_t bytes) {
+    if (writer->failed) return;
+    if (fwrite(data, 1, bytes, writer->file) != bytes) {
+        writer->failed = true;
+        return;
+    }
+    writer->offset += bytes;
+}
+
+static bool tile_read(FILE *file, void *data, size_t bytes) {
+    return fread(data, 1, bytes, file) == bytes;
+}
+
+static void tile_write_header(tile_pyramid_writer_t *writer, uint64_t index_offset) {
+    const tile_pyramid_info_t *info = &writer->info;
+    uint32_t version = TILE_PYRAMID_VERSION;
+    uint64_t num_tiles = writer->num_tiles;
+
+    tile_write(writer, TILE_PYRAMID_MAGIC, 8);
+    tile_write(writer, &version, 4);
+    tile_write(writer, &info->tile_size, 4);
+    tile_write(writer, &info->num_levels, 4);
+    tile_write(writer, &info->width, 4);
+    tile_write(writer, &info->pool, 4);
+    tile_write(writer, &info->num_rows, 8);
+    tile_write(writer, &info->sample_rate, 8);
+    tile_write(writer, &info->row_seconds, 8);
+    tile_write(writer, &info->freq_start_hz, 8);
+    tile_write(writer, &info->freq_step_hz, 8);
+    tile_write(writer, &index_offset, 8);
+    tile_write(writer, &num_tiles, 8);
+}
+
+static float tile_pool2(float a, float b, uint32_t pool) {
+    if (pool == TILE_POOL_MEAN) return 0.5f * (a + b);
+    return a > b ? a : b;
+}
+
+uint32_t tile_pyramid_levels_for(uint32_t width, uint64_t rows, uint32_t tile_size) {
+    uint32_t levels = 1;
+    if (tile_size == 0) return levels;
+
+    while ((width > tile_size || rows > tile_size) && levels < TILE_PYRAMID_MAX_LEVELS) {
+        width = (width + 1) / 2;
+        rows = (rows + 1) / 2;
+        levels++;
+    }
+    return levels;
+}
+
+// Emit the band of a level as one row of tiles
+static void tile_flush_band(tile_pyramid_writer_t *writer, uint32_t level) {
+    tile_level_t *lv = &writer->levels[level];
+    uint32_t tile = writer->info.tile_size;
+    uint32_t tile_cols = (lv->width + tile - 1) / tile;
+
+    if (lv->band_rows == 0) return;
+
+    if (writer->num_tiles + tile_cols > writer->index_capacity) {
+        size_t capacity = writer->index_capacity ? writer->index_capacity * 2 : 256;
+        while (capacity < writer->num_tiles + tile_cols) capacity *= 2;
+        tile_index_entry_t *index = (tile_index_entry_t *)realloc(writer->index, capacity * sizeof(tile_index_entry_t));
+        if (!index) {
+            writer->failed = true;
+            return;
+        }
+        writer->index = index;
+        writer->index_capacity = capacity;
+    }
+
+    for (uint32_t c = 0; c < tile_cols; c++) {
+        uint32_t col0 = c * tile;
+        uint32_t cols = lv->width - col0 < tile ? lv->width - col0 : tile;
+        tile_index_entry_t *entry = &writer->index[writer->num_tiles++];
+
+        entry->level = level;
+        entry->col = c;
+        entry->row = lv->tile_row;
+        entry->offset = writer->offset;
+
+        tile_write(writer, &entry->level, 4);
+        tile_write(writer, &entry->col, 4);
+        tile_write(writer, &entry->row, 8);
+        tile_write(writer, &lv->band_rows, 4);
+        tile_write(writer, &cols, 4);
+        for (uint32_t r = 0; r < lv->band_rows; r++) {
+            tile_write(writer, lv->band + (size_t)r * lv->width + col0, (size_t)cols * sizeof(float));
+        }
+    }
+
+    lv->tile_row++;
+    lv->band_rows = 0;
+}
+
+// Append a row to a level and feed the next one
+static void tile_push_level(tile_pyramid_writer_t *writer, uint32_t level, const float *row) {
+    tile_level_t *lv = &writer->levels[level];
+    uint32_t pool = writer->info.pool;
+
+    memcpy(lv->band + (size_t)lv->band_rows * lv->width, row, (size_t)lv->width * sizeof(float));
+    if (++lv->band_rows == writer->info.tile_size) {
+        tile_flush_band(writer, level);
+    }
+
+    if (level + 1 >= writer->info.num_levels) return;
+
+    // Horizontal pass; an odd last column carries over unchanged
+    uint32_t half = writer->levels[level + 1].width;
+    for (uint32_t x = 0; x < half; x++) {
+        uint32_t a = 2 * x;
+        lv->half[x] = a + 1 < lv->width ? tile_pool2(row[a], row[a + 1], pool) : row[a];
+    }
+
+    // Vertical pass on every second row
+    if (!lv->has_pair) {
+        memcpy(lv->pair, lv->half, (size_t)half * sizeof(float));
+        lv->has_pair = true;
+        return;
+    }
+    for (uint32_t x = 0; x < half; x++) {
+        lv->pair[x] = tile_pool2(lv->pair[x], lv->half[x], pool);
+    }
+    lv->has_pair = false;
+    tile_push_level(writer, level + 1, lv->pair);
+}
+
+bool tile_pyramid_writer_open(tile_pyramid_writer_t *writer, const char *path,
+                              const tile_pyramid_info_t *info) {
+    if (!writer || !path || !info) return false;
+    memset(writer, 0, sizeof(*writer));
+
+    if (info->tile_size == 0 || info->width == 0 ||
+        info->num_levels == 0 || info->num_levels > TILE_PYRAMID_MAX_LEVELS ||
+        (info->pool != TILE_POOL_MAX && info->pool != TILE_POOL_MEAN)) {
+        fprintf(stderr, "Error: Invalid tile pyramid geometry\n");
+        return false;
+    }
+
+    writer->info = *info;
+    writer->info.num_rows = 0;
+
+    uint32_t width = info->width;
+    for (uint32_t l = 0; l < info->num_levels; l++) {
+        tile_level_t *lv = &writer->levels[l];
+        uint32_t half = (width + 1) / 2;
+        lv->width = width;
+        lv->band = (float *)malloc((size_t)info->tile_size * width * sizeof(float));
+        lv->half = (float *)malloc((size_t)half * sizeof(float));
+        lv->pair = (float *)malloc((size_t)half * sizeof(float));
+        if (!lv->band || !lv->half || !lv->pair) {
+            fprintf(stderr, "Error: Failed to allocate tile pyramid level %u\n", l);
+            writer->failed = true;
+            tile_pyramid_writer_close(writer);
+            return false;
+        }
+        width = half;
+    }
+
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        fprintf(stderr, "Error: Cannot create tile pyramid: %s\n", path);
+        writer->failed = true;
+        tile_pyramid_writer_close(writer);
+        return false;
+    }
+
+    // Placeholder header, rewritten by close
+    tile_write_header(writer, 0);
+    return !writer->failed;
+}
+
+bool tile_pyramid_writer_reserve(tile_pyramid_writer_t *writer, uint64_t rows) {
+    if (!writer || writer->failed) return false;
+
+    // Each level has half the rows (rounded up) and half the width of the one below
+    uint32_t tile = writer->info.tile_size;
+    size_t tiles = 0;
+    for (uint32_t l = 0; l < writer->info.num_levels; l++) {
+        const tile_level_t *lv = &writer->levels[l];
+        uint64_t level_rows = l == 0 ? rows : (rows + ((uint64_t)1 << l) - 1) >> l;
+        tiles += (size_t)((level_rows + tile - 1) / tile) * ((lv->width + tile - 1) / tile);
+    }
+    if (tiles <= writer->index_capacity) return true;
+
+    tile_index_entry_t *index = (tile_index_entry_t *)realloc(writer->index, tiles * sizeof(tile_index_entry_t));
+    if (!index) {
+        fprintf(stderr, "Error: Failed to allocate the tile pyramid index\n");
+        return false;
+    }
+    writer->index = index;
+    writer->index_capacity = tiles;
+    return true;
+}
+
+bool tile_pyramid_writer_push(tile_pyramid_writer_t *writer, const float *row) {
+    if (!writer || !writer->file || !row) return false;
+
+    tile_push_level(writer, 0, row);
+    writer->info.num_rows++;
+    return !writer->failed;
+}
+
+bool tile_pyramid_writer_close(tile_pyramid_writer_t *writer) {
+    if (!writer) return false;
+
+    bool ok = !writer->failed;
+    if (writer->file) {
+        // A lone row at the end of a level goes down unpaired
+        for (uint32_t l = 0; l + 1 < writer->info.num_levels; l++) {
+            tile_level_t *lv = &writer->levels[l];
+            if (lv->has_pair) {
+                lv->has_pair = false;
+                tile_push_level(writer, l + 1, lv->pair);
+            }
+        }
+        for (uint32_t l = 0; l < writer->info.num_levels; l++) {
+            tile_flush_band(writer, l);
+        }
+
+        uint64_t index_offset = writer->offset;
+        for (size_t i = 0; i < writer->num_tiles; i++) {
+            const tile_index_entry_t *entry = &writer->index[i];
+            tile_write(writer, &entry->level, 4);
+            tile_write(writer, &entry->col, 4);
+            tile_write(writer, &entry->row, 8);
+            tile_write(writer, &entry->offset, 8);
+        }
+
+        if (!writer->failed && tile_file_seek(writer->file, 0) != 0) writer->failed = true;
+        tile_write_header(writer, index_offset);
+
+        if (fclose(writer->file) != 0) writer->failed = true;
+        writer->file = NULL;
+        ok = !writer->failed;
+        if (!ok) fprintf(stderr, "Error: Failed to write tile pyramid\n");
+    }
+
+    for (uint32_t l = 0; l < TILE_PYRAMID_MAX_LEVELS; l++) {
+        free(writer->levels[l].band);
+        free(writer->levels[l].half);
+        free(writer->levels[l].pair);
+    }
+    free(writer->index);
+    memset(writer, 0, sizeof(*writer));
+    return ok;
+}
+
+bool tile_pyramid_reader_open(tile_pyramid_reader_t *reader, const char *path) {
+    if (!reader || !path) return false;
+    memset(reader, 0, sizeof(*reader));
+
+    reader->file = fopen(path, "rb");
+    if (!reader->file) {
+        fprintf(stderr, "Error: Cannot open tile pyramid: %s\n", path);
+        return false;
+    }
+
+    tile_pyramid_info_t *info = &reader->info;
+    char magic[8];
+    uint32_t version;
+    uint64_t index_offset, num_tiles;
+    bool ok = tile_read(reader->file, magic, 8) && memcmp(magic, TILE_PYRAMID_MAGIC, 8) == 0 &&
+              tile_read(reader->file, &version, 4) && version == TILE_PYRAMID_VERSION &&
+              tile_read(reader->file, &info->tile_size, 4) &&
+              tile_read(reader->file, &info->num_levels, 4) &&
+              tile_read(reader->file, &info->width, 4) &&
+              tile_read(reader->file, &info->pool, 4) &&
+              tile_read(reader->file, &info->num_rows, 8) &&
+              tile_read(reader->file, &info->sample_rate, 8) &&
+              tile_read(reader->file, &info->row_seconds, 8) &&
+              tile_read(reader->file, &info->freq_start_hz, 8) &&
+              tile_read(reader->file, &info->freq_step_hz, 8) &&
+              tile_read(reader->file, &index_offset, 8) &&
+              tile_read(reader->file, &num_tiles, 8);
+    if (!ok || info->tile_size == 0 || info->width == 0 ||
+        info->num_levels == 0 || info->num_levels > TILE_PYRAMID_MAX_LEVELS ||
+        index_offset < TILE_HEADER_BYTES) {
+        fprintf(stderr, "Error: Not a tile pyramid (or unsupported version): %s\n", path);
+        tile_pyramid_reader_close(reader);
+        return false;
+    }
+
+    // Level geometry follows from level 0
+    uint32_t width = info->width;
+    uint64_t rows = info->num_rows;
+    for (uint32_t l = 0; l < info->num_levels; l++) {
+        reader->level_width[l] = width;
+        reader->level_rows[l] = rows;
+        reader->tile_cols[l] = (width + info->tile_size - 1) / info->tile_size;
+        reader->tile_rows[l] = (rows + info->tile_size - 1) / info->tile_size;
+        reader->offsets[l] = (uint64_t *)calloc((size_t)(reader->tile_rows[l] * reader->tile_cols[l]) + 1, sizeof(uint64_t));
+        if (!reader->offsets[l]) {
+            fprintf(stderr, "Error: Failed to allocate tile pyramid index\n");
+            tile_pyramid_reader_close(reader);
+            return false;
+        }
+        width = (width + 1) / 2;
+        rows = (rows + 1) / 2;
+    }
+
+    if (tile_file_seek(reader->file, index_offset) != 0) ok = false;
+    for (uint64_t i = 0; ok && i < num_tiles; i++) {
+        uint32_t level, col;
+        uint64_t row, offset;
+        if (!tile_read(reader->file, &level, 4) || !tile_read(reader->file, &col, 4) ||
+            !tile_read(reader->file, &row, 8) || !tile_read(reader->file, &offset, 8)) {
+            ok = false;
+            break;
+        }
+        if (level >= info->num_levels || col >= reader->tile_cols[level] ||
+            row >= reader->tile_rows[level] || offset < TILE_HEADER_BYTES) {
+            ok = false;
+            break;
+        }
+        reader->offsets[level][row * reader->tile_cols[level] + col] = offset;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Corrupt tile pyramid index: %s\n", path);
+        tile_pyramid_reader_close(reader);
+        return false;
+    }
+
+    return true;
+}
+
+bool tile_pyramid_read_tile(tile_pyramid_reader_t *reader, uint32_t level,
+                            uint64_t tile_row, uint32_t tile_col,
+                            float *cells, uint32_t *rows, uint32_t *cols) {
+    if (!reader || !reader->file || !cells || !rows || !cols) return false;
+    if (level >= reader->info.num_levels || tile_row >= reader->tile_rows[level] ||
+        tile_col >= reader->tile_cols[level]) {
+        return false;
+    }
+
+    uint64_t offset = reader->offsets[level][tile_row * reader->tile_cols[level] + tile_col];
+    if (offset == 0 || tile_file_seek(reader->file, offset) != 0) return false;
+
+    uint32_t rec_level, rec_col, rec_rows, rec_cols;
+    uint64_t rec_row;
+    if (!tile_read(reader->file, &rec_level, 4) || !tile_read(reader->file, &rec_col, 4) ||
+        !tile_read(reader->file, &rec_row, 8) || !tile_read(reader->file, &rec_rows, 4) ||
+        !tile_read(reader->file, &rec_cols, 4)) {
+        return false;
+    }
+    if (rec_level != level || rec_col != tile_col || rec_row != tile_row ||
+        rec_rows == 0 || rec_rows > reader->info.tile_size ||
+        rec_cols == 0 || rec_cols > reader->info.tile_size) {
+        fprintf(stderr, "Error: Tile record does not match the index\n");
+        return false;
+    }
+
+    if (!tile_read(reader->file, cells, (size_t)rec_rows * rec_cols * sizeof(float))) return false;
+    *rows = rec_rows;
+    *cols = rec_cols;
+    return true;
+}
+
+void tile_pyramid_reader_close(tile_pyramid_reader_t *reader) {
+    if (!reader) return;
+
+    if (reader->file) fclose(reader->file);
+    for (uint32_t l = 0; l < TILE_PYRAMID_MAX_LEVELS; l++) {
+        free(reader->offsets[l]);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
@@ -0,0 +1,138 @@
+#ifndef IQ_TILE_PYRAMID_H
+#define IQ_TILE_PYRAMID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Tiled multi-resolution power pyramid
+ * A time x frequency power map stored as square tiles at several zoom
+ * levels: level 0 holds one row per FFT frame and one column per bin, and
+ * each further level halves both axes by 2x2 max or mean pooling. Viewers
+ * fetch only the tiles covering their viewport at the level that matches
+ * their zoom, so huge captures are browsed without rerunning FFTs.
+ *
+ * The file is written in one streaming pass: rows are pushed in time order,
+ * each level keeps one band of tile_size rows in memory and flushes it as a
+ * row of tiles when full. Memory is O(tile_size * width) per level no matter
+ * how long the capture is.
+ *
+ * On-disk layout (native byte order, little-endian on supported platforms):
+ *   header   magic "IQTILES1", version, tile_pyramid_info_t fields,
+ *            index offset, tile count
+ *   tiles    per tile: level, col, row (u32, u32, u64), rows, cols (u32),
+ *            then rows * cols float32 cells, row-major, linear power
+ *   index    per tile: level, col, row, byte offset of its record
+ * Tiles appear in the order they were completed; the index locates them.
+ */
+
+#define TILE_PYRAMID_MAGIC        "IQTILES1"
+#define TILE_PYRAMID_VERSION      1
+#define TILE_PYRAMID_DEFAULT_TILE 256
+#define TILE_PYRAMID_MAX_LEVELS   16
+
+// Reduction used between levels
+typedef enum {
+    TILE_POOL_MAX = 0,      // Max-hold: short bursts survive every zoom level
+    TILE_POOL_MEAN = 1      // Mean power
+} tile_pool_t;
+
+// Fixed description stored in the file header
+typedef struct {
+    uint32_t tile_size;     // Tile edge in cells (rows and columns)
+    uint32_t num_levels;    // Zoom levels, 0 = full resolution
+    uint32_t width;         // Level-0 columns (frequency bins)
+    uint32_t pool;          // tile_pool_t used between levels
+    uint64_t num_rows;      // Level-0 rows (complete once the writer is closed)
+    double sample_rate;     // Capture sample rate in Hz
+    double row_seconds;     // Time between level-0 rows
+    double freq_start_hz;   // Frequency of level-0 column 0
+    double freq_step_hz;    // Level-0 column spacing
+} tile_pyramid_info_t;
+
+// Per-level streaming state
+typedef struct {
+    uint32_t width;         // Columns at this level
+    float *band;            // tile_size rows x width being filled
+    uint32_t band_rows;     // Rows currently in the band
+    uint64_t tile_row;      // Index of the band in tile rows
+    float *half;            // Horizontally pooled row for the next level
+    float *pair;            // Pooled row waiting for its vertical partner
+    bool has_pair;
+} tile_level_t;
+
+// One index entry: where a tile's record starts
+typedef struct {
+    uint32_t level;
+    uint32_t col;
+    uint64_t row;
+    uint64_t offset;
+} tile_index_entry_t;
+
+typedef struct {
+    FILE *file;
+    tile_pyramid_info_t info;
+    tile_level_t levels[TILE_PYRAMID_MAX_LEVELS];
+    tile_index_entry_t *index;
+    size_t num_tiles;
+    size_t index_capacity;
+    uint64_t offset;        // Bytes written so far
+    bool failed;            // A write failed; close reports it
+} tile_pyramid_writer_t;
+
+typedef struct {
+    FILE *file;
+    tile_pyramid_info_t info;
+    uint32_t level_width[TILE_PYRAMID_MAX_LEVELS];
+    uint64_t level_rows[TILE_PYRAMID_MAX_LEVELS];
+    uint32_t tile_cols[TILE_PYRAMID_MAX_LEVELS];
+    uint64_t tile_rows[TILE_PYRAMID_MAX_LEVELS];
+    uint64_t *offsets[TILE_PYRAMID_MAX_LEVELS];  // [tile_row * tile_cols + col], 0 = missing
+} tile_pyramid_reader_t;
+
+/*
+ * Number of levels needed until one tile covers a width x rows map
+ * (clamped to TILE_PYRAMID_MAX_LEVELS)
+ */
+uint32_t tile_pyramid_levels_for(uint32_t width, uint64_t rows, uint32_t tile_size);
+
+/*
+ * Start a pyramid file; info supplies everything but num_rows
+ * Returns false on invalid geometry, allocation or I/O failure.
+ */
+bool tile_pyramid_writer_open(tile_pyramid_writer_t *writer, const char *path,
+                              const tile_pyramid_info_t *info);
+
+/*
+ * Size the tile index for a map of 'rows' level-0 rows, so pushing that
+ * many rows never grows it (the index still grows past them)
+ * Returns false on allocation failure.
+ */
+bool tile_pyramid_writer_reserve(tile_pyramid_writer_t *writer, uint64_t rows);
+
+// Append one level-0 row of info.width linear power values
+bool tile_pyramid_writer_push(tile_pyramid_writer_t *writer, const float *row);
+
+/*
+ * Flush partial tiles, write the index and header, and free the writer
+ * Returns false if any write failed.
+ */
+bool tile_pyramid_writer_close(tile_pyramid_writer_t *writer);
+
+// Open a pyramid file and load its index
+bool tile_pyramid_reader_open(tile_pyramid_reader_t *reader, const char *path);
+
+/*
+ * Read tile (tile_row, tile_col) of a level into 'cells' (tile_size^2
+ * capacity, row-major with 'cols' stride); edge tiles can be smaller
+ */
+bool tile_pyramid_read_tile(tile_pyramid_reader_t *reader, uint32_t level,
+                            uint64_t tile_row, uint32_t tile_col,
+                            float *cells, uint32_t *rows, uint32_t *cols);
+
+// Close the file and free the index
+void tile_pyramid_reader_close(tile_pyramid_reader_t *reader);
+
+#endif // IQ_TILE_PYRAMID_H
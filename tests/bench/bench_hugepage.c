@@ -0,0 +1,229 @@
+/*
+ * IQ Lab - Huge-Page TLB Benchmark
+ *
+ * Shows what 4 KB pages cost large buffers, with each buffer allocated
+ * once on base pages and once through iq_huge_alloc in thp and explicit
+ * mode:
+ * - a dependent random walk over one cache line per page of a large
+ *   buffer, where nearly every step misses the TLB on base pages and
+ *   almost none do once the buffer sits in a few hundred 2 MB pages
+ * - 1M-point single-precision FFTs, whose tables, scratch arena and
+ *   buffers come from the allocator (iqls and iqdetect at their largest
+ *   sizes)
+ * On Linux each row also reports how much of the buffer the kernel
+ * actually backed with huge pages (AnonHugePages in /proc/self/smaps):
+ * thp rows show 0 where transparent huge pages are disabled, and
+ * explicit rows fall back to thp unless pages are reserved
+ * (vm.nr_hugepages).
+ *
+ * Usage: bench_hugepage.exe [buffer MB, default 512] [walk steps in millions, default 20]
+ */
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // madvise under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "../../src/iq_core/hugepage.h"
+#include "../../src/iq_core/arena.h"
+#include "../../src/iq_core/fft.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#define BENCH_PAGE 4096
+#define BENCH_FFT_SIZE FFT_MAX_SIZE
+
+typedef struct {
+    const char *name;
+    iq_huge_mode_t mode;
+    bool base_pages;             // Keep the kernel from promoting the heap block
+} bench_mode_t;
+
+static const bench_mode_t bench_modes[] = {
+    {"4 KB pages", IQ_HUGE_OFF, true},
+    {"thp", IQ_HUGE_THP, false},
+    {"explicit", IQ_HUGE_EXPLICIT, false},
+};
+
+static double seconds_since(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// A block in 'mode'; base_pages also opts a heap block out of transparent
+// huge pages, which "always" would otherwise give it
+static void *bench_alloc(const bench_mode_t *mode, size_t bytes) {
+    iq_huge_set_mode(mode->mode);
+    void *block = iq_huge_alloc(bytes);
+#if defined(__linux__) && defined(MADV_NOHUGEPAGE)
+    if (block && mode->base_pages) {
+        uintptr_t start = ((uintptr_t)block + BENCH_PAGE - 1) & ~(uintptr_t)(BENCH_PAGE - 1);
+        uintptr_t end = ((uintptr_t)block + bytes) & ~(uintptr_t)(BENCH_PAGE - 1);
+        if (end > start) madvise((void *)start, end - start, MADV_NOHUGEPAGE);
+    }
+#endif
+    return block;
+}
+
+// Kilobytes of [block, block + bytes) backed by huge pages, or -1 if unknown
+static long huge_backed_kb(const void *block, size_t bytes) {
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if (!f) return -1;
+
+    uintptr_t lo = (uintptr_t)block, hi = lo + bytes;
+    bool inside = false;
+    long total = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end;
+        long kb;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            inside = start < hi && end > lo;
+        } else if (inside && (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1 ||
+                              sscanf(line, "Private_Hugetlb: %ld kB", &kb) == 1)) {
+            total += kb;
+        }
+    }
+    fclose(f);
+    return total;
+#else
+    (void)block;
+    (void)bytes;
+    return -1;
+#endif
+}
+
+static void print_backing(const void *block, size_t bytes) {
+    long kb = huge_backed_kb(block, bytes);
+    if (kb < 0) {
+        printf("  %-22s", iq_page_kind_name(iq_huge_kind(block)));
+    } else {
+        // smaps counts whole mappings, which may extend past the block
+        double share = fmin(1.0, (double)kb * 1024.0 / (double)bytes);
+        printf("  %-22s %6.1f%%", iq_page_kind_name(iq_huge_kind(block)), 100.0 * share);
+    }
+}
+
+// The line visited in a page: hashed, so on physically contiguous huge pages
+// the walk still spreads over every cache set
+static uint64_t walk_offset(uint64_t page) {
+    return page * BENCH_PAGE + (((page * 2654435761u) >> 16) % (BENCH_PAGE / 64)) * 64;
+}
+
+// Link one cache line per page into a single random cycle; returns ns per step
+static double run_walk(uint8_t *buffer, size_t bytes, uint64_t steps) {
+    size_t pages = bytes / BENCH_PAGE;
+    uint32_t *order = malloc(pages * sizeof(uint32_t));
+    if (!order) return -1.0;
+    for (size_t i = 0; i < pages; i++) order[i] = (uint32_t)i;
+    uint64_t state = 88172645463325252ull;
+    for (size_t i = pages - 1; i > 0; i--) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        size_t j = (size_t)(state % (i + 1));
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (size_t i = 0; i < pages; i++) {
+        uint64_t next = order[(i + 1) % pages];
+        uint64_t to = walk_offset(next);
+        memcpy(buffer + walk_offset(order[i]), &to, sizeof(to));
+    }
+    uint64_t at = walk_offset(order[0]);
+    free(order);
+
+    clock_t start = clock();
+    for (uint64_t s = 0; s < steps; s++) {
+        memcpy(&at, buffer + at, sizeof(at));
+    }
+    double elapsed = seconds_since(start);
+    if (at == UINT64_MAX) printf("unreachable\n");  // Keep the walk live
+    return elapsed * 1e9 / (double)steps;
+}
+
+// Plan, arena and buffers for a 1M-point FFT in 'mode'; returns ms per
+// transform, or a negative value on error
+static double run_fft(const bench_mode_t *mode, uint32_t repeats) {
+    size_t bytes = BENCH_FFT_SIZE * sizeof(fft_complex_f32_t);
+    fft_complex_f32_t *input = bench_alloc(mode, bytes);
+    fft_complex_f32_t *output = bench_alloc(mode, bytes);
+    iq_arena_t arena;
+    if (!input || !output || !iq_arena_init(&arena, fft_scratch_bytes(BENCH_FFT_SIZE))) {
+        iq_huge_free(input);
+        iq_huge_free(output);
+        return -1.0;
+    }
+    iq_arena_t *previous = iq_arena_bind(&arena);
+    fft_plan_f32_t *plan = fft_plan_f32_create(BENCH_FFT_SIZE, FFT_FORWARD);
+
+    double elapsed = -1.0;
+    if (plan) {
+        for (uint32_t i = 0; i < BENCH_FFT_SIZE; i++) {
+            input[i] = (float)cos(0.001 * i) + (float)sin(0.0007 * i) * I;
+        }
+        fft_execute_f32(plan, input, output);  // Fault everything in first
+        clock_t start = clock();
+        for (uint32_t r = 0; r < repeats; r++) fft_execute_f32(plan, input, output);
+        elapsed = seconds_since(start) * 1e3 / repeats;
+        print_backing(input, bytes);
+        fft_plan_f32_destroy(plan);
+    }
+
+    fft_release_thread_buffers();
+    iq_arena_bind(previous);
+    iq_arena_free(&arena);
+    iq_huge_free(input);
+    iq_huge_free(output);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 512;
+    double millions = argc > 2 ? atof(argv[2]) : 20.0;
+    if (megabytes < 4 || millions <= 0.0) {
+        fprintf(stderr, "Usage: %s [buffer MB >= 4] [walk steps in millions]\n", argv[0]);
+        return 1;
+    }
+    size_t bytes = megabytes << 20;
+    uint64_t steps = (uint64_t)(millions * 1e6);
+    size_t modes = sizeof(bench_modes) / sizeof(bench_modes[0]);
+
+    printf("Huge-page benchmark: %zu MB walk, %.0fM steps, %zu KB huge pages\n\n",
+           megabytes, millions, iq_huge_page_size() >> 10);
+    printf("%-11s  %-22s %7s %10s\n", "pages", "backing", "huge", "ns/step");
+    for (size_t m = 0; m < modes; m++) {
+        uint8_t *buffer = bench_alloc(&bench_modes[m], bytes);
+        if (!buffer) {
+            fprintf(stderr, "Allocation of %zu MB failed\n", megabytes);
+            continue;
+        }
+        double ns = run_walk(buffer, bytes, steps);
+        printf("%-11s", bench_modes[m].name);
+        print_backing(buffer, bytes);
+        printf(" %10.2f\n", ns);
+        iq_huge_free(buffer);
+    }
+
+    printf("\n%u-point single-precision FFT (plan, arena and buffers per mode)\n\n", (unsigned)BENCH_FFT_SIZE);
+    printf("%-11s  %-22s %7s %10s\n", "pages", "backing", "huge", "ms/fft");
+    for (size_t m = 0; m < modes; m++) {
+        printf("%-11s", bench_modes[m].name);
+        double ms = run_fft(&bench_modes[m], 20);
+        if (ms < 0.0) {
+            printf("  failed\n");
+            continue;
+        }
+        printf(" %10.2f\n", ms);
+    }
+
+    return 0;
+}
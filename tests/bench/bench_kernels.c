@@ -0,0 +1,562 @@
+/*
+ * IQ Lab - Kernel Microbenchmarks
+ *
+ * Times the hot kernels one at a time on synthetic input: fft_execute from
+ * 256 to 1M points, cfar_os_process_frame, cluster_add_detection,
+ * pfb_process_block, resample_process_buffer, the FM/AM/SSB
+ * process_buffer calls, iq_convert_to_float and png_image_write. Each case
+ * is called repeatedly until it has run for the requested time and reports
+ * millions of items per second, ns per item and cycles per item, where an
+ * item is whatever the kernel is sized by (a sample, a bin, a detection,
+ * a pixel).
+ *
+ * Cycles are time stamp counter ticks on x86 (constant rate, so they track
+ * the nominal rather than the turbo clock) or ns times --ghz; elsewhere
+ * without --ghz they are left out. --json writes the same rows to a file
+ * so runs can be compared across releases.
+ *
+ * Usage: bench_kernels.exe [--time seconds per case, default 0.5]
+ *                          [--json file] [--ghz nominal clock]
+ *                          [--only kernel-name substring]
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // clock_gettime under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+#include "../../src/iq_core/fft.h"
+#include "../../src/iq_core/io_iq.h"
+#include "../../src/iq_core/resample.h"
+#include "../../src/detect/cfar_os.h"
+#include "../../src/detect/cluster.h"
+#include "../../src/chan/pfb.h"
+#include "../../src/demod/fm.h"
+#include "../../src/demod/am.h"
+#include "../../src/demod/ssb.h"
+#include "../../src/viz/img_png.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_BLOCK 4096
+#define BENCH_MAX_RESULTS 64
+#define BENCH_SAMPLE_RATE 240000
+
+// One timed kernel: 'call' does items_per_call items of work on 'state'
+typedef struct {
+    const char *kernel;
+    char config[48];
+    const char *unit;
+    uint64_t items_per_call;
+    bool (*call)(void *state);
+    void *state;
+} bench_case_t;
+
+typedef struct {
+    const char *kernel;
+    char config[48];
+    const char *unit;
+    uint64_t items;
+    double seconds;
+    double ticks;                 // TSC ticks over the run (0 without a TSC)
+} bench_result_t;
+
+static double min_seconds = 0.5;
+static double ghz_override = 0.0;
+static const char *only = NULL;
+static bench_result_t results[BENCH_MAX_RESULTS];
+static uint32_t num_results = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t read_ticks(void) {
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Deterministic noise so every run sees the same input
+static uint32_t rng_state = 0x12345678u;
+
+static float noise(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)(rng_state >> 8) / 8388608.0f - 1.0f;
+}
+
+// Call the kernel once to warm caches, then until min_seconds have passed
+static void bench_run(const bench_case_t *c) {
+    if (only && !strstr(c->kernel, only)) return;
+    if (num_results >= BENCH_MAX_RESULTS) return;
+    if (!c->call(c->state)) {
+        fprintf(stderr, "Error: %s %s failed\n", c->kernel, c->config);
+        return;
+    }
+
+    uint64_t calls = 0;
+    const double start = now_seconds();
+    const uint64_t tick0 = read_ticks();
+    double elapsed = 0.0;
+    do {
+        if (!c->call(c->state)) {
+            fprintf(stderr, "Error: %s %s failed\n", c->kernel, c->config);
+            return;
+        }
+        calls++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < min_seconds);
+    const uint64_t tick1 = read_ticks();
+
+    bench_result_t *r = &results[num_results++];
+    r->kernel = c->kernel;
+    memcpy(r->config, c->config, sizeof(r->config));
+    r->unit = c->unit;
+    r->items = calls * c->items_per_call;
+    r->seconds = elapsed;
+    r->ticks = (double)(tick1 - tick0);
+
+    const double ns = elapsed * 1e9 / (double)r->items;
+    printf("%-24s %-18s %-10s %10.2f %10.3f", r->kernel, r->config, r->unit,
+           (double)r->items / elapsed * 1e-6, ns);
+    if (ghz_override > 0.0) {
+        printf(" %10.2f\n", ns * ghz_override);
+    } else if (r->ticks > 0.0) {
+        printf(" %10.2f\n", r->ticks / (double)r->items);
+    } else {
+        printf(" %10s\n", "-");
+    }
+    fflush(stdout);
+}
+
+/*
+ * fft_execute
+ */
+
+typedef struct {
+    fft_plan_t *plan;
+    fft_complex_t *input;
+    fft_complex_t *output;
+} fft_state_t;
+
+static bool fft_call(void *state) {
+    fft_state_t *s = state;
+    return fft_execute(s->plan, s->input, s->output);
+}
+
+static void bench_fft(void) {
+    for (uint32_t size = 256; size <= (1u << 20); size *= 4) {
+        fft_state_t s;
+        s.plan = fft_plan_create(size, FFT_FORWARD);
+        s.input = malloc(size * sizeof(fft_complex_t));
+        s.output = malloc(size * sizeof(fft_complex_t));
+        if (s.plan && s.input && s.output) {
+            for (uint32_t i = 0; i < size; i++) s.input[i] = noise() + I * noise();
+            bench_case_t c = { "fft_execute", "", "bin", size, fft_call, &s };
+            snprintf(c.config, sizeof(c.config), "n=%u", size);
+            bench_run(&c);
+        }
+        fft_plan_destroy(s.plan);
+        free(s.input);
+        free(s.output);
+    }
+}
+
+/*
+ * cfar_os_process_frame
+ */
+
+typedef struct {
+    cfar_os_t cfar;
+    double *spectrum;
+    cfar_detection_t *detections;
+    uint32_t size;
+} cfar_state_t;
+
+static bool cfar_call(void *state) {
+    cfar_state_t *s = state;
+    cfar_os_process_frame(&s->cfar, s->spectrum, s->detections, s->size);
+    return true;
+}
+
+static void bench_cfar(void) {
+    const uint32_t size = 4096;
+    cfar_state_t s;
+    memset(&s, 0, sizeof(s));
+    s.size = size;
+    s.spectrum = malloc(size * sizeof(double));
+    s.detections = malloc(size * sizeof(cfar_detection_t));
+    if (s.spectrum && s.detections && cfar_os_init(&s.cfar, size, 1e-4, 16, 2, 12)) {
+        // Exponential noise (|CN|^2) with a few strong carriers
+        for (uint32_t i = 0; i < size; i++) {
+            float u = 0.5f * (noise() + 1.0f);
+            s.spectrum[i] = -log(1.0 - u * 0.999999);
+        }
+        for (uint32_t i = 200; i < size; i += 512) s.spectrum[i] *= 1000.0;
+        bench_case_t c = { "cfar_os_process_frame", "n=4096 ref=16", "bin", size, cfar_call, &s };
+        bench_run(&c);
+        cfar_os_free(&s.cfar);
+    }
+    free(s.spectrum);
+    free(s.detections);
+}
+
+/*
+ * cluster_add_detection
+ */
+
+#define CLUSTER_PER_FRAME 64
+
+typedef struct {
+    cluster_t cluster;
+    cfar_detection_t detections[CLUSTER_PER_FRAME];
+    cluster_event_t events[256];
+    double frame_time;
+} cluster_state_t;
+
+// One frame of detections on a few carriers, then retire idle clusters
+static bool cluster_call(void *state) {
+    cluster_state_t *s = state;
+    for (uint32_t i = 0; i < CLUSTER_PER_FRAME; i++) {
+        if (!cluster_add_detection(&s->cluster, &s->detections[i], s->frame_time)) return false;
+    }
+    s->frame_time += 0.001;
+    cluster_get_events(&s->cluster, s->events, 256, s->frame_time);
+    return true;
+}
+
+static void bench_cluster(void) {
+    static cluster_state_t s;
+    memset(&s, 0, sizeof(s));
+    if (!cluster_init(&s.cluster, 10.0, 2000.0, 512, 2000000.0)) {
+        fprintf(stderr, "Error: cluster_init failed\n");
+        return;
+    }
+    for (uint32_t i = 0; i < CLUSTER_PER_FRAME; i++) {
+        s.detections[i].bin_index = 100 + i * 60;
+        s.detections[i].signal_power = -40.0;
+        s.detections[i].threshold = -60.0;
+        s.detections[i].snr_estimate = 20.0;
+        s.detections[i].confidence = 0.9;
+    }
+    bench_case_t c = { "cluster_add_detection", "64/frame", "detection", CLUSTER_PER_FRAME,
+                       cluster_call, &s };
+    bench_run(&c);
+    cluster_free(&s.cluster);
+}
+
+/*
+ * pfb_process_block
+ */
+
+typedef struct {
+    pfb_t *pfb;
+    float complex *input;
+    uint32_t channels;
+} pfb_state_t;
+
+static bool pfb_call(void *state) {
+    pfb_state_t *s = state;
+    for (uint32_t offset = 0; offset < BENCH_BLOCK; ) {
+        int32_t used = pfb_process_block(s->pfb, s->input + offset, BENCH_BLOCK - offset);
+        if (used < 0) return false;
+        offset += (uint32_t)used;
+        if (offset < BENCH_BLOCK) {
+            for (uint32_t chan = 0; chan < s->channels; chan++) pfb_reset_channel_output(s->pfb, chan);
+        }
+    }
+    return true;
+}
+
+static void bench_pfb(void) {
+    const uint32_t channel_counts[] = { 16, 256 };
+    for (size_t k = 0; k < sizeof(channel_counts) / sizeof(channel_counts[0]); k++) {
+        pfb_state_t s;
+        s.channels = channel_counts[k];
+        pfb_config_t config;
+        if (!pfb_config_init(&config, s.channels, 1000000.0, 1000000.0 / s.channels)) continue;
+        s.pfb = pfb_create(&config);
+        s.input = malloc(BENCH_BLOCK * sizeof(float complex));
+        if (s.pfb && s.input) {
+            for (uint32_t i = 0; i < BENCH_BLOCK; i++) s.input[i] = noise() + I * noise();
+            bench_case_t c = { "pfb_process_block", "", "sample", BENCH_BLOCK, pfb_call, &s };
+            snprintf(c.config, sizeof(c.config), "ch=%u", s.channels);
+            bench_run(&c);
+        }
+        pfb_destroy(s.pfb);
+        free(s.input);
+    }
+}
+
+/*
+ * resample_process_buffer
+ */
+
+typedef struct {
+    resample_t resampler;
+    float *input;
+    float *output;
+    uint32_t max_output;
+} resample_state_t;
+
+static bool resample_call(void *state) {
+    resample_state_t *s = state;
+    uint32_t produced = 0;
+    return resample_process_buffer(&s->resampler, s->input, BENCH_BLOCK, s->output, s->max_output,
+                                   &produced);
+}
+
+static void bench_resample(void) {
+    const uint32_t rates[][2] = { { 240000, 48000 }, { 44100, 48000 } };
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        resample_state_t s;
+        memset(&s, 0, sizeof(s));
+        if (!resample_init(&s.resampler, rates[k][0], rates[k][1])) continue;
+        s.max_output = resample_estimate_output_size(BENCH_BLOCK, (double)rates[k][1] / rates[k][0]) + 64;
+        s.input = malloc(BENCH_BLOCK * sizeof(float));
+        s.output = malloc(s.max_output * sizeof(float));
+        if (s.input && s.output) {
+            for (uint32_t i = 0; i < BENCH_BLOCK; i++) s.input[i] = noise();
+            bench_case_t c = { "resample_process_buffer", "", "sample", BENCH_BLOCK, resample_call, &s };
+            snprintf(c.config, sizeof(c.config), "%u->%u", rates[k][0], rates[k][1]);
+            bench_run(&c);
+        }
+        resample_free(&s.resampler);
+        free(s.input);
+        free(s.output);
+    }
+}
+
+/*
+ * fm/am/ssb_demod_process_buffer
+ */
+
+typedef struct {
+    fm_demod_t fm;
+    am_demod_t am;
+    ssb_demod_t ssb;
+    float i[BENCH_BLOCK];
+    float q[BENCH_BLOCK];
+    float audio[BENCH_BLOCK];
+} demod_state_t;
+
+static bool fm_call(void *state) {
+    demod_state_t *s = state;
+    return fm_demod_process_buffer(&s->fm, s->i, s->q, BENCH_BLOCK, s->audio);
+}
+
+static bool am_call(void *state) {
+    demod_state_t *s = state;
+    return am_demod_process_buffer(&s->am, s->i, s->q, BENCH_BLOCK, s->audio);
+}
+
+static bool ssb_call(void *state) {
+    demod_state_t *s = state;
+    return ssb_demod_process_buffer(&s->ssb, s->i, s->q, BENCH_BLOCK, s->audio);
+}
+
+static void bench_demod(void) {
+    static demod_state_t s;
+    memset(&s, 0, sizeof(s));
+    // A 1 kHz tone at 25 kHz deviation plus a little noise
+    double phase = 0.0;
+    for (uint32_t n = 0; n < BENCH_BLOCK; n++) {
+        phase += 2.0 * M_PI * 25000.0 / BENCH_SAMPLE_RATE * sin(2.0 * M_PI * 1000.0 * n / BENCH_SAMPLE_RATE);
+        s.i[n] = 0.5f * (float)cos(phase) + 0.01f * noise();
+        s.q[n] = 0.5f * (float)sin(phase) + 0.01f * noise();
+    }
+    if (fm_demod_init(&s.fm, BENCH_SAMPLE_RATE)) {
+        bench_case_t c = { "fm_demod_process_buffer", "240k mono", "sample", BENCH_BLOCK, fm_call, &s };
+        bench_run(&c);
+        fm_demod_free(&s.fm);
+    }
+    if (am_demod_init(&s.am, BENCH_SAMPLE_RATE)) {
+        bench_case_t c = { "am_demod_process_buffer", "240k", "sample", BENCH_BLOCK, am_call, &s };
+        bench_run(&c);
+        am_demod_free(&s.am);
+    }
+    if (ssb_demod_init(&s.ssb, BENCH_SAMPLE_RATE)) {
+        bench_case_t c = { "ssb_demod_process_buffer", "240k", "sample", BENCH_BLOCK, ssb_call, &s };
+        bench_run(&c);
+        ssb_demod_free(&s.ssb);
+    }
+}
+
+/*
+ * iq_convert_to_float
+ */
+
+typedef struct {
+    uint8_t *raw;
+    size_t raw_bytes;
+    iq_format_t format;
+    float *output;
+    size_t samples;
+} convert_state_t;
+
+static bool convert_call(void *state) {
+    convert_state_t *s = state;
+    return iq_convert_to_float(s->raw, s->raw_bytes, s->format, s->output, 2 * s->samples);
+}
+
+static void bench_convert(void) {
+    const struct { iq_format_t format; const char *name; uint32_t bits; } formats[] = {
+        { IQ_FORMAT_S8, "s8", 8 }, { IQ_FORMAT_S16, "s16", 16 },
+        { IQ_FORMAT_S12, "s12", 12 }, { IQ_FORMAT_S4, "s4", 4 },
+    };
+    const size_t samples = 65536;
+    for (size_t k = 0; k < sizeof(formats) / sizeof(formats[0]); k++) {
+        convert_state_t s;
+        s.format = formats[k].format;
+        s.samples = samples;
+        s.raw_bytes = samples * 2 * formats[k].bits / 8;
+        s.raw = malloc(s.raw_bytes);
+        s.output = malloc(2 * samples * sizeof(float));
+        if (s.raw && s.output) {
+            for (size_t i = 0; i < s.raw_bytes; i++) s.raw[i] = (uint8_t)(noise() * 127.0f);
+            bench_case_t c = { "iq_convert_to_float", "", "sample", samples, convert_call, &s };
+            snprintf(c.config, sizeof(c.config), "%s", formats[k].name);
+            bench_run(&c);
+        }
+        free(s.raw);
+        free(s.output);
+    }
+}
+
+/*
+ * png_image_write
+ */
+
+typedef struct {
+    png_image_t image;
+    char path[64];
+} png_state_t;
+
+static bool png_call(void *state) {
+    png_state_t *s = state;
+    return png_image_write(&s->image, s->path);
+}
+
+static void bench_png(void) {
+    png_state_t s;
+    const uint32_t width = 1024, height = 512;
+    if (!png_image_init(&s.image, width, height)) return;
+    snprintf(s.path, sizeof(s.path), "bench_kernels_%ld.png", (long)time(NULL));
+    // A waterfall-like picture: smooth noise floor with a few carriers
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            float level = 0.2f + 0.05f * noise() + ((x % 256) == 77 ? 0.7f : 0.0f);
+            uint8_t r, g, b;
+            png_intensity_to_color(level, &r, &g, &b);
+            png_image_set_pixel(&s.image, x, y, r, g, b);
+        }
+    }
+    bench_case_t c = { "png_image_write", "1024x512", "pixel", (uint64_t)width * height, png_call, &s };
+    bench_run(&c);
+    remove(s.path);
+    png_image_free(&s.image);
+}
+
+static bool write_json(const char *path, double tick_ghz) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot write %s\n", path);
+        return false;
+    }
+    fprintf(f, "{\n  \"benchmark\": \"bench_kernels\",\n  \"min_seconds\": %.3f,\n", min_seconds);
+    if (ghz_override > 0.0) {
+        fprintf(f, "  \"cycles_source\": \"ghz\",\n  \"ghz\": %.4f,\n", ghz_override);
+    } else if (tick_ghz > 0.0) {
+        fprintf(f, "  \"cycles_source\": \"tsc\",\n  \"ghz\": %.4f,\n", tick_ghz);
+    } else {
+        fprintf(f, "  \"cycles_source\": null,\n  \"ghz\": null,\n");
+    }
+    fprintf(f, "  \"results\": [\n");
+    for (uint32_t i = 0; i < num_results; i++) {
+        const bench_result_t *r = &results[i];
+        const double ns = r->seconds * 1e9 / (double)r->items;
+        fprintf(f, "    {\"kernel\": \"%s\", \"config\": \"%s\", \"unit\": \"%s\", "
+                   "\"items\": %llu, \"seconds\": %.6f, \"msps\": %.4f, \"ns_per_item\": %.4f, ",
+                r->kernel, r->config, r->unit, (unsigned long long)r->items, r->seconds,
+                (double)r->items / r->seconds * 1e-6, ns);
+        if (ghz_override > 0.0) {
+            fprintf(f, "\"cycles_per_item\": %.4f}", ns * ghz_override);
+        } else if (r->ticks > 0.0) {
+            fprintf(f, "\"cycles_per_item\": %.4f}", r->ticks / (double)r->items);
+        } else {
+            fprintf(f, "\"cycles_per_item\": null}");
+        }
+        fprintf(f, "%s\n", i + 1 < num_results ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+int main(int argc, char **argv) {
+    const char *json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            min_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--ghz") == 0 && i + 1 < argc) {
+            ghz_override = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--time seconds] [--json file] [--ghz clock] [--only kernel]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (min_seconds <= 0.0) min_seconds = 0.01;
+
+    // Tick rate over a short wall-clock interval, for the JSON header
+    double tick_ghz = 0.0;
+#ifdef BENCH_HAVE_TSC
+    {
+        const double t0 = now_seconds();
+        const uint64_t tick0 = read_ticks();
+        while (now_seconds() - t0 < 0.05) {}
+        tick_ghz = (double)(read_ticks() - tick0) / ((now_seconds() - t0) * 1e9);
+    }
+#endif
+
+    printf("Kernel benchmark: %.2f s per case", min_seconds);
+    if (ghz_override > 0.0) printf(", cycles at %.2f GHz\n\n", ghz_override);
+    else if (tick_ghz > 0.0) printf(", cycles from the TSC (%.2f GHz)\n\n", tick_ghz);
+    else printf("\n\n");
+    printf("%-24s %-18s %-10s %10s %10s %10s\n", "kernel", "config", "unit", "Mitems/s", "ns/item",
+           "cyc/item");
+
+    bench_fft();
+    bench_cfar();
+    bench_cluster();
+    bench_pfb();
+    bench_resample();
+    bench_demod();
+    bench_convert();
+    bench_png();
+
+    if (json_path) {
+        if (!write_json(json_path, tick_ghz)) return 1;
+        printf("\nResults written to %s\n", json_path);
+    }
+    return 0;
+}
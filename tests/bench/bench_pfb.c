@@ -0,0 +1,170 @@
+/*
+ * IQ Lab - PFB Channelizer Benchmark
+ *
+ * Streams complex noise through pfb_process_block in 4096-sample blocks,
+ * draining the channel rings whenever consumption stops (as iqchan does),
+ * for several channel counts and filter lengths. Reports input Msps, ns per
+ * input sample and filter multiply-adds per ns, once with the SIMD tap loop and
+ * once forced to the scalar path (both give identical outputs). A second
+ * table scales the bank from 64 to 4096 channels with the default filter
+ * length for each (PFB_MIN_BRANCH_TAPS taps per branch or more), and a
+ * third compares the sparse DDC bank (ddc.h) for a few channels with the
+ * full bank, next to the choice ddc_bank_preferred() makes.
+ *
+ * Usage: bench_pfb.exe [seconds of input at 1 Msps, default 4]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <time.h>
+#include "../../src/chan/pfb.h"
+#include "../../src/chan/ddc.h"
+
+#define BENCH_BLOCK 4096
+
+static double seconds_since(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Time one configuration (filter_length 0: the default); returns seconds,
+// or a negative value on error
+static double run_case(uint32_t channels, uint32_t filter_length, uint32_t oversampling,
+                       const float complex *input, uint32_t total) {
+    pfb_config_t config;
+    if (!pfb_config_init(&config, channels, 1000000.0, 1000000.0 / channels)) return -1.0;
+    if (filter_length > 0) config.filter_length = filter_length;
+    config.oversampling = oversampling;
+
+    pfb_t *pfb = pfb_create(&config);
+    if (!pfb) return -1.0;
+
+    clock_t start = clock();
+    for (uint32_t offset = 0; offset + BENCH_BLOCK <= total; ) {
+        int32_t used = pfb_process_block(pfb, input + offset, BENCH_BLOCK);
+        if (used < 0) {
+            pfb_destroy(pfb);
+            return -1.0;
+        }
+        offset += (uint32_t)used;
+        if ((uint32_t)used < BENCH_BLOCK) {
+            for (uint32_t chan = 0; chan < channels; chan++) pfb_reset_channel_output(pfb, chan);
+        }
+    }
+    double elapsed = seconds_since(start);
+
+    pfb_destroy(pfb);
+    return elapsed;
+}
+
+// Time a DDC bank over the first count channels; returns seconds, or a
+// negative value on error
+static double run_ddc_case(uint32_t channels, uint32_t count, const float complex *input,
+                           uint32_t total) {
+    pfb_config_t config;
+    if (!pfb_config_init(&config, channels, 1000000.0, 1000000.0 / channels)) return -1.0;
+
+    uint32_t selected[16];
+    for (uint32_t i = 0; i < count; i++) selected[i] = i * (channels / count);
+    ddc_bank_t *ddc = ddc_bank_create(&config, selected, count);
+    if (!ddc) return -1.0;
+
+    clock_t start = clock();
+    for (uint32_t offset = 0; offset + BENCH_BLOCK <= total; ) {
+        int32_t used = ddc_bank_process_block(ddc, input + offset, BENCH_BLOCK);
+        if (used < 0) {
+            ddc_bank_destroy(ddc);
+            return -1.0;
+        }
+        offset += (uint32_t)used;
+        if ((uint32_t)used < BENCH_BLOCK) {
+            for (uint32_t s = 0; s < count; s++) ddc_bank_reset_channel_output(ddc, s);
+        }
+    }
+    double elapsed = seconds_since(start);
+
+    ddc_bank_destroy(ddc);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    uint32_t seconds = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 4;
+    if (seconds == 0) seconds = 1;
+    uint32_t total = seconds * 1000000u / BENCH_BLOCK * BENCH_BLOCK;
+
+    float complex *input = malloc((size_t)total * sizeof(float complex));
+    if (!input) {
+        fprintf(stderr, "Allocation failed\n");
+        return 1;
+    }
+    uint32_t state = 1234567u;
+    for (uint32_t i = 0; i < total; i++) {
+        state = state * 1664525u + 1013904223u;
+        float re = (float)((state >> 8) / 16777216.0 - 0.5);
+        state = state * 1664525u + 1013904223u;
+        float im = (float)((state >> 8) / 16777216.0 - 0.5);
+        input[i] = re + I * im;
+    }
+
+    const uint32_t channels[] = {8, 16, 32};
+    const uint32_t lengths[] = {256, 1024, 4096};
+
+    printf("PFB benchmark: %u input samples per case\n\n", total);
+    printf("%6s %7s %5s %7s %10s %10s %10s\n", "chans", "taps", "os", "path", "Msps", "ns/samp", "MAC/ns");
+
+    for (size_t c = 0; c < sizeof(channels) / sizeof(channels[0]); c++) {
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            for (uint32_t os = 1; os <= 2; os++) {
+                for (int scalar = 0; scalar <= 1; scalar++) {
+                    pfb_force_scalar(scalar != 0);
+                    double t = run_case(channels[c], lengths[l], os, input, total);
+                    if (t < 0.0) {
+                        fprintf(stderr, "Case %u/%u failed\n", channels[c], lengths[l]);
+                        continue;
+                    }
+                    // Every output costs filter_length multiply-adds per I and Q
+                    double macs = (double)total / (channels[c] / os) * lengths[l];
+                    printf("%6u %7u %5u %7s %10.2f %10.2f %10.2f\n", channels[c], lengths[l], os,
+                           scalar ? "scalar" : "simd", total / t / 1e6, t * 1e9 / total,
+                           macs / (t * 1e9));
+                }
+            }
+        }
+    }
+    pfb_force_scalar(false);
+
+    printf("\nScaling with channel count (default filter length, critically sampled)\n\n");
+    printf("%6s %7s %7s %10s %10s\n", "chans", "taps", "branch", "Msps", "ns/samp");
+    for (uint32_t chans = 64; chans <= PFB_MAX_CHANNELS; chans *= 2) {
+        pfb_config_t config;
+        if (!pfb_config_init(&config, chans, 1000000.0, 1000000.0 / chans)) continue;
+        double t = run_case(chans, 0, 1, input, total);
+        if (t < 0.0) {
+            fprintf(stderr, "Case %u failed\n", chans);
+            continue;
+        }
+        printf("%6u %7u %7u %10.2f %10.2f\n", chans, config.filter_length,
+               config.filter_length / chans, total / t / 1e6, t * 1e9 / total);
+    }
+
+    printf("\nSparse DDC against the full bank (default filter length, critically sampled)\n\n");
+    printf("%6s %6s %10s %10s %10s %8s\n", "chans", "ddc", "ddc Msps", "pfb Msps", "faster", "model");
+    for (uint32_t chans = 64; chans <= PFB_MAX_CHANNELS; chans *= 4) {
+        pfb_config_t config;
+        if (!pfb_config_init(&config, chans, 1000000.0, 1000000.0 / chans)) continue;
+        double full = run_case(chans, 0, 1, input, total);
+        for (uint32_t count = 1; count <= 8; count *= 2) {
+            double sparse = run_ddc_case(chans, count, input, total);
+            if (full < 0.0 || sparse < 0.0) {
+                fprintf(stderr, "Case %u/%u failed\n", chans, count);
+                continue;
+            }
+            printf("%6u %6u %10.2f %10.2f %10s %8s\n", chans, count, total / sparse / 1e6,
+                   total / full / 1e6, sparse < full ? "ddc" : "pfb",
+                   ddc_bank_preferred(&config, count) ? "ddc" : "pfb");
+        }
+    }
+
+    free(input);
+    return 0;
+}
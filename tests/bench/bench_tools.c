@@ -0,0 +1,514 @@
+/*
+ * IQ Lab - End-to-End Tool Benchmark
+ *
+ * Generates deterministic synthetic s16 captures of the requested sizes
+ * (noise floor, two CW tones, an FM carrier at DC and periodic bursts, the
+ * ingredients of the integration test signals) and runs iqls, iqdetect,
+ * iqchan and iqdemod-fm over each one, timing the run and reading the
+ * child's peak resident set size. The result is a table of wall time,
+ * input Msps and peak RSS per tool and size, optionally written as JSON
+ * and compared with an earlier JSON run: a tool that now fails, or whose
+ * throughput drops or peak RSS grows by more than --tolerance percent (RSS
+ * also by more than 4 MiB), is marked and the exit status is 2, so a new
+ * build can be checked before it is deployed.
+ *
+ * Captures are kept in --dir and reused while their size matches, so
+ * repeated runs only pay for generation once. Tool outputs go to the same
+ * directory and are removed after each run (iqchan writes two channels).
+ *
+ * Usage: bench_tools.exe [--sizes 1G,10G,100G] [--dir build/bench_tools]
+ *                        [--bin .] [--tools iqls,iqdetect,iqchan,iqdemod-fm]
+ *                        [--json file] [--baseline file] [--tolerance 10]
+ */
+
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE  // wait4 and struct rusage under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <time.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+#include "../../src/iq_core/io_iq.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SAMPLE_RATE 2000000
+#define BYTES_PER_SAMPLE 4          // s16 I/Q
+#define GEN_BLOCK 65536
+#define MAX_SIZES 8
+#define MAX_RESULTS 64
+#define RSS_SLACK_KB 4096           // Peak RSS growth below this is never a regression
+
+typedef struct {
+    const char *tool;
+    char size_name[16];
+    uint64_t bytes;
+    double seconds;
+    long peak_rss_kb;               // -1 when the platform does not report it
+    int status;                     // Tool exit status
+    double baseline_msps;           // 0 without a matching baseline row
+    long baseline_rss_kb;
+    bool regression;
+} run_result_t;
+
+static const char *all_tools[] = { "iqls", "iqdetect", "iqchan", "iqdemod-fm" };
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// "512M", "10G", "4096" -> bytes (binary units), rounded down to whole samples
+static bool parse_size(const char *text, uint64_t *bytes) {
+    char *end = NULL;
+    double value = strtod(text, &end);
+    if (end == text || value <= 0.0) return false;
+    double scale = 1.0;
+    if (*end == 'K' || *end == 'k') scale = 1024.0, end++;
+    else if (*end == 'M' || *end == 'm') scale = 1024.0 * 1024.0, end++;
+    else if (*end == 'G' || *end == 'g') scale = 1024.0 * 1024.0 * 1024.0, end++;
+    if (*end == 'B' || *end == 'b') end++;
+    if (*end != '\0') return false;
+    *bytes = (uint64_t)(value * scale) / BYTES_PER_SAMPLE * BYTES_PER_SAMPLE;
+    return *bytes >= (uint64_t)GEN_BLOCK * BYTES_PER_SAMPLE;
+}
+
+/*
+ * Synthetic capture
+ * Tones, bursts and the FM audio are rotators advanced per sample and
+ * renormalised per block, so the output is deterministic and generation
+ * costs a few complex multiplies and one cexp per sample even for 100 GB.
+ */
+
+typedef struct {
+    double complex tone_a, step_a;  // -30 dBFS at +300 kHz
+    double complex tone_b, step_b;  // -40 dBFS at -550 kHz
+    double complex burst, step_burst; // -20 dBFS at +700 kHz, 5 ms of every 50 ms
+    double complex audio, step_audio; // 1 kHz modulating tone for the FM carrier
+    double fm_phase;                // FM carrier at DC, 75 kHz deviation
+    uint32_t noise;                 // LCG state
+    uint64_t sample;
+} synth_t;
+
+static double complex rotator(double freq_hz) {
+    return cexp(I * 2.0 * M_PI * freq_hz / SAMPLE_RATE);
+}
+
+static void synth_init(synth_t *s) {
+    s->tone_a = s->tone_b = s->burst = 1.0;
+    s->audio = 1.0;
+    s->step_a = rotator(300000.0);
+    s->step_b = rotator(-550000.0);
+    s->step_burst = rotator(700000.0);
+    s->step_audio = rotator(1000.0);
+    s->fm_phase = 0.0;
+    s->noise = 0x2545f491u;
+    s->sample = 0;
+}
+
+static float synth_noise(synth_t *s) {
+    // Sum of two uniforms: a cheap, bounded approximation of Gaussian noise
+    s->noise = s->noise * 1664525u + 1013904223u;
+    float a = (float)(s->noise >> 8) / 16777216.0f;
+    s->noise = s->noise * 1664525u + 1013904223u;
+    float b = (float)(s->noise >> 8) / 16777216.0f;
+    return a + b - 1.0f;
+}
+
+static void synth_block(synth_t *s, float *iq, uint32_t count) {
+    const double fm_gain = 2.0 * M_PI * 75000.0 / SAMPLE_RATE;
+    const uint64_t burst_period = SAMPLE_RATE / 20, burst_length = SAMPLE_RATE / 200;
+    for (uint32_t n = 0; n < count; n++, s->sample++) {
+        s->fm_phase += fm_gain * cimag(s->audio);
+        double complex z = 0.0316 * s->tone_a + 0.01 * s->tone_b +
+                           0.25 * cexp(I * s->fm_phase);
+        if (s->sample % burst_period < burst_length) z += 0.1 * s->burst;
+        iq[2 * n] = (float)creal(z) + 0.01f * synth_noise(s);
+        iq[2 * n + 1] = (float)cimag(z) + 0.01f * synth_noise(s);
+
+        s->tone_a *= s->step_a;
+        s->tone_b *= s->step_b;
+        s->burst *= s->step_burst;
+        s->audio *= s->step_audio;
+    }
+    s->tone_a /= cabs(s->tone_a);
+    s->tone_b /= cabs(s->tone_b);
+    s->burst /= cabs(s->burst);
+    s->audio /= cabs(s->audio);
+    s->fm_phase = fmod(s->fm_phase, 2.0 * M_PI);
+}
+
+// Write the capture unless a file of exactly this size is already there
+static bool ensure_capture(const char *path, uint64_t bytes) {
+    struct stat st;
+    if (stat(path, &st) == 0 && (uint64_t)st.st_size == bytes) return true;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot create %s\n", path);
+        return false;
+    }
+    float *block = malloc(2 * GEN_BLOCK * sizeof(float));
+    if (!block) {
+        fclose(f);
+        return false;
+    }
+    printf("Generating %s (%.2f GiB)...\n", path, (double)bytes / (1024.0 * 1024.0 * 1024.0));
+    fflush(stdout);
+
+    synth_t synth;
+    synth_init(&synth);
+    bool ok = true;
+    for (uint64_t left = bytes / BYTES_PER_SAMPLE; ok && left > 0; ) {
+        uint32_t count = left < GEN_BLOCK ? (uint32_t)left : GEN_BLOCK;
+        synth_block(&synth, block, count);
+        ok = iq_write_samples(f, block, count, IQ_FORMAT_S16);
+        left -= count;
+    }
+    free(block);
+    if (fclose(f) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to write %s\n", path);
+        remove(path);
+    }
+    return ok;
+}
+
+/*
+ * Tool runs
+ */
+
+// Command line of one tool over 'input', writing under 'out'
+static int tool_argv(const char *tool, const char *bin, const char *input, const char *out,
+                     char *exe, size_t exe_size, const char **argv) {
+    static const char rate[] = "2000000";
+    int n = 0;
+    snprintf(exe, exe_size, "%s/%s", bin, tool);
+    argv[n++] = exe;
+    argv[n++] = "--in"; argv[n++] = input;
+    argv[n++] = "--format"; argv[n++] = "s16";
+    argv[n++] = "--rate"; argv[n++] = rate;
+    if (strcmp(tool, "iqls") == 0) {
+        argv[n++] = "--fft"; argv[n++] = "4096";
+        argv[n++] = "--hop"; argv[n++] = "4096";
+        argv[n++] = "--avg"; argv[n++] = "64";
+        argv[n++] = "--waterfall";
+    } else if (strcmp(tool, "iqdetect") == 0) {
+        argv[n++] = "--fft"; argv[n++] = "4096";
+        argv[n++] = "--hop"; argv[n++] = "2048";
+    } else if (strcmp(tool, "iqchan") == 0) {
+        // Writing every channel would double the disk footprint
+        argv[n++] = "--channels"; argv[n++] = "16";
+        argv[n++] = "--bandwidth"; argv[n++] = "125000";
+        argv[n++] = "--select"; argv[n++] = "0,4";
+    }
+    argv[n++] = "--out"; argv[n++] = out;
+    argv[n] = NULL;
+    return n;
+}
+
+// Remove what a run left behind: files named after 'out', or the iqchan directory
+static void clean_outputs(const char *out) {
+    char command[1200];
+#ifdef _WIN32
+    snprintf(command, sizeof(command), "del /q \"%s*\" >nul 2>&1 & rmdir /s /q \"%s\" >nul 2>&1",
+             out, out);
+#else
+    snprintf(command, sizeof(command), "rm -rf '%s' '%s'.* '%s'_* 2>/dev/null", out, out, out);
+#endif
+    int status = system(command);  // Nothing to remove is fine
+    (void)status;
+}
+
+static bool run_tool(const char *tool, const char *bin, const char *dir, const char *input,
+                     run_result_t *result) {
+    char exe[1024], out[1024], log_path[1100];
+    const char *argv[32];
+    snprintf(out, sizeof(out), "%s/%s_out", dir, tool);
+    snprintf(log_path, sizeof(log_path), "%s/%s.log", dir, tool);
+    tool_argv(tool, bin, input, out, exe, sizeof(exe), argv);
+    if (strcmp(tool, "iqdemod-fm") == 0) {
+        snprintf(out + strlen(out), sizeof(out) - strlen(out), ".wav");
+    } else if (strcmp(tool, "iqdetect") == 0) {
+        snprintf(out + strlen(out), sizeof(out) - strlen(out), ".csv");
+    }
+
+    result->peak_rss_kb = -1;
+    const double start = now_seconds();
+#ifdef _WIN32
+    char command[4096];
+    size_t used = 0;
+    for (int i = 0; argv[i] && used < sizeof(command); i++) {
+        used += (size_t)snprintf(command + used, sizeof(command) - used, "\"%s\" ", argv[i]);
+    }
+    snprintf(command + used, sizeof(command) - used, "> \"%s\" 2>&1", log_path);
+    result->status = system(command);
+#else
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: fork failed\n");
+        return false;
+    }
+    if (pid == 0) {
+        int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        execv(exe, (char *const *)argv);
+        _exit(127);
+    }
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        fprintf(stderr, "Error: wait4 failed\n");
+        return false;
+    }
+    result->status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+#if defined(__APPLE__)
+    result->peak_rss_kb = usage.ru_maxrss / 1024;   // Bytes on macOS
+#else
+    result->peak_rss_kb = usage.ru_maxrss;          // KiB on Linux and the BSDs
+#endif
+#endif
+    result->seconds = now_seconds() - start;
+
+    clean_outputs(out);
+    if (result->status != 0) {
+        fprintf(stderr, "Warning: %s exited with status %d (see %s)\n", tool, result->status, log_path);
+    }
+    return true;
+}
+
+/*
+ * Baseline comparison
+ * The JSON below is written one result per line, so an earlier run is read
+ * back line by line without a general JSON parser.
+ */
+
+static bool json_string(const char *line, const char *key, char *value, size_t size) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    const char *p = strstr(line, pattern);
+    if (!p) return false;
+    p += strlen(pattern);
+    const char *end = strchr(p, '"');
+    if (!end || (size_t)(end - p) >= size) return false;
+    memcpy(value, p, (size_t)(end - p));
+    value[end - p] = '\0';
+    return true;
+}
+
+static bool json_number(const char *line, const char *key, double *value) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char *p = strstr(line, pattern);
+    if (!p) return false;
+    char *end = NULL;
+    *value = strtod(p + strlen(pattern), &end);
+    return end != p + strlen(pattern);
+}
+
+static double result_msps(const run_result_t *r) {
+    return r->seconds > 0.0 ? (double)(r->bytes / BYTES_PER_SAMPLE) / r->seconds * 1e-6 : 0.0;
+}
+
+static bool load_baseline(const char *path, run_result_t *results, uint32_t count, double tolerance) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot open baseline %s\n", path);
+        return false;
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        char tool[64];
+        double bytes, msps, rss;
+        double status = 0.0;
+        if (!json_string(line, "tool", tool, sizeof(tool)) || !json_number(line, "bytes", &bytes) ||
+            !json_number(line, "msps", &msps) || (json_number(line, "status", &status) && status != 0.0)) {
+            continue;
+        }
+        if (!json_number(line, "peak_rss_kb", &rss)) rss = -1.0;
+        for (uint32_t i = 0; i < count; i++) {
+            run_result_t *r = &results[i];
+            if (strcmp(r->tool, tool) != 0 || (double)r->bytes != bytes) continue;
+            r->baseline_msps = msps;
+            r->baseline_rss_kb = (long)rss;
+            // A run that now fails is a regression however fast it was
+            if (r->status != 0) {
+                r->regression = true;
+                continue;
+            }
+            if (msps > 0.0 && result_msps(r) < msps * (1.0 - tolerance / 100.0)) r->regression = true;
+            if (rss > 0.0 && r->peak_rss_kb > 0 &&
+                (double)r->peak_rss_kb > rss * (1.0 + tolerance / 100.0) + RSS_SLACK_KB) {
+                r->regression = true;
+            }
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static bool write_json(const char *path, const run_result_t *results, uint32_t count) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot write %s\n", path);
+        return false;
+    }
+    fprintf(f, "{\n  \"benchmark\": \"bench_tools\",\n  \"sample_rate\": %d,\n  \"format\": \"s16\",\n",
+            SAMPLE_RATE);
+    fprintf(f, "  \"results\": [\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const run_result_t *r = &results[i];
+        fprintf(f, "    {\"tool\": \"%s\", \"size\": \"%s\", \"bytes\": %llu, \"seconds\": %.3f, "
+                   "\"msps\": %.3f, \"peak_rss_kb\": %ld, \"status\": %d}%s\n",
+                r->tool, r->size_name, (unsigned long long)r->bytes, r->seconds, result_msps(r),
+                r->peak_rss_kb, r->status, i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+static void print_table(const run_result_t *results, uint32_t count, bool with_baseline) {
+    printf("\n%-11s %7s %10s %9s %11s", "tool", "size", "seconds", "Msps", "peak RSS MB");
+    if (with_baseline) printf(" %9s %8s %8s", "base Msps", "dMsps", "dRSS");
+    printf("\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const run_result_t *r = &results[i];
+        printf("%-11s %7s %10.2f", r->tool, r->size_name, r->seconds);
+        if (r->status == 0) printf(" %9.2f", result_msps(r));
+        else printf(" %9s", "-");
+        if (r->peak_rss_kb >= 0) printf(" %11.1f", (double)r->peak_rss_kb / 1024.0);
+        else printf(" %11s", "-");
+        if (with_baseline && r->baseline_msps > 0.0 && r->status == 0) {
+            printf(" %9.2f %+7.1f%%", r->baseline_msps, 100.0 * (result_msps(r) / r->baseline_msps - 1.0));
+            if (r->baseline_rss_kb > 0 && r->peak_rss_kb > 0) {
+                printf(" %+7.1f%%", 100.0 * ((double)r->peak_rss_kb / (double)r->baseline_rss_kb - 1.0));
+            } else {
+                printf(" %8s", "-");
+            }
+            if (r->regression) printf("  REGRESSION");
+        } else if (with_baseline) {
+            printf(" %9s %8s %8s", "-", "-", "-");
+            if (r->regression) printf("  REGRESSION");
+        }
+        if (r->status != 0) printf("  (exit %d)", r->status);
+        printf("\n");
+    }
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--sizes 1G,10G,100G] [--dir path] [--bin path] "
+                    "[--tools iqls,iqdetect,iqchan,iqdemod-fm] [--json file] [--baseline file] "
+                    "[--tolerance percent]\n", program);
+}
+
+int main(int argc, char **argv) {
+    const char *sizes_arg = "1G";
+    const char *dir = "build/bench_tools";
+    const char *bin = ".";
+    const char *tools_arg = NULL;
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    double tolerance = 10.0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) sizes_arg = argv[++i];
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) dir = argv[++i];
+        else if (strcmp(argv[i], "--bin") == 0 && i + 1 < argc) bin = argv[++i];
+        else if (strcmp(argv[i], "--tools") == 0 && i + 1 < argc) tools_arg = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) json_path = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) baseline_path = argv[++i];
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) tolerance = atof(argv[++i]);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Sizes
+    char size_names[MAX_SIZES][16];
+    uint64_t size_bytes[MAX_SIZES];
+    uint32_t num_sizes = 0;
+    char list[256];
+    snprintf(list, sizeof(list), "%s", sizes_arg);
+    for (char *token = strtok(list, ","); token; token = strtok(NULL, ",")) {
+        if (num_sizes == MAX_SIZES || !parse_size(token, &size_bytes[num_sizes])) {
+            fprintf(stderr, "Error: Invalid size '%s' (at least %d KiB each, at most %d sizes)\n",
+                    token, GEN_BLOCK * BYTES_PER_SAMPLE / 1024, MAX_SIZES);
+            return 1;
+        }
+        snprintf(size_names[num_sizes], sizeof(size_names[0]), "%s", token);
+        num_sizes++;
+    }
+
+    // Tools
+    const char *tools[4];
+    uint32_t num_tools = 0;
+    for (uint32_t t = 0; t < 4; t++) {
+        if (!tools_arg || strstr(tools_arg, all_tools[t])) tools[num_tools++] = all_tools[t];
+    }
+    if (num_tools == 0) {
+        fprintf(stderr, "Error: No known tool in '%s'\n", tools_arg);
+        return 1;
+    }
+
+#ifdef _WIN32
+    char mkdir_cmd[1100];
+    snprintf(mkdir_cmd, sizeof(mkdir_cmd), "if not exist \"%s\" mkdir \"%s\"", dir, dir);
+    int status = system(mkdir_cmd);
+    (void)status;
+#else
+    mkdir(dir, 0755);
+#endif
+
+    run_result_t results[MAX_RESULTS];
+    uint32_t count = 0;
+    for (uint32_t s = 0; s < num_sizes; s++) {
+        char input[1024];
+        snprintf(input, sizeof(input), "%s/synthetic_%s.s16", dir, size_names[s]);
+        if (!ensure_capture(input, size_bytes[s])) return 1;
+        for (uint32_t t = 0; t < num_tools && count < MAX_RESULTS; t++) {
+            run_result_t *r = &results[count];
+            memset(r, 0, sizeof(*r));
+            r->tool = tools[t];
+            snprintf(r->size_name, sizeof(r->size_name), "%s", size_names[s]);
+            r->bytes = size_bytes[s];
+            printf("Running %s on %s...\n", tools[t], input);
+            fflush(stdout);
+            if (run_tool(tools[t], bin, dir, input, r)) count++;
+        }
+    }
+
+    bool regression = false;
+    if (baseline_path) {
+        if (!load_baseline(baseline_path, results, count, tolerance)) return 1;
+        for (uint32_t i = 0; i < count; i++) regression |= results[i].regression;
+    }
+    print_table(results, count, baseline_path != NULL);
+    if (json_path) {
+        if (!write_json(json_path, results, count)) return 1;
+        printf("\nResults written to %s\n", json_path);
+    }
+    if (regression) {
+        printf("\nThroughput or memory regressed by more than %.0f%% against %s\n", tolerance, baseline_path);
+        return 2;
+    }
+    return 0;
+}
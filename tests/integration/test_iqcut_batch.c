@@ -0,0 +1,187 @@
+/* iqcut batch test: one pass over the input gives the same snippets as one run per event,
+ * and a full-band cut at DC is the input's bytes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <stdint.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#ifdef _WIN32
+#define IQCUT ".\\iqcut.exe"
+#else
+#define IQCUT "./iqcut"
+#endif
+
+#define SAMPLE_RATE 2000000
+#define NUM_SAMPLES 600000
+
+// Events: unsorted, overlapping, one past the end of the file (clamped)
+static const struct { double t_start, t_end, f_center, bw; } events[] = {
+    { 0.200, 0.215, 95000.0, 20000.0 },
+    { 0.010, 0.150, -40000.0, 5000.0 },
+    { 0.100, 0.110, 0.0, 100000.0 },
+    { 0.290, 0.400, 300000.0, 50000.0 },
+};
+#define NUM_EVENTS (sizeof(events) / sizeof(events[0]))
+
+static bool same_file(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb");
+    FILE *fb = fopen(b, "rb");
+    bool same = fa && fb;
+    while (same) {
+        int ca = fgetc(fa);
+        int cb = fgetc(fb);
+        same = ca == cb;
+        if (ca == EOF || cb == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+// 'path' holds exactly 'length' bytes of 'source' from 'offset'
+static bool same_range(const char *path, const char *source, long offset, long length) {
+    FILE *fa = fopen(path, "rb");
+    FILE *fb = fopen(source, "rb");
+    bool same = fa && fb && fseek(fb, offset, SEEK_SET) == 0;
+    for (long i = 0; same && i < length; i++) {
+        same = fgetc(fa) == fgetc(fb);
+    }
+    same = same && fgetc(fa) == EOF;
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+static long file_size(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+int main(void) {
+    const char *input = "iqcut_batch_input.iq";
+    const char *csv = "iqcut_batch_events.csv";
+    const char *meta = "iqcut_batch_input.sigmf-meta";
+    char command[512];
+    char path_a[128], path_b[128];
+    bool ok = true;
+
+    // Two tones plus a ramp so every region's snippet differs
+    FILE *f = fopen(input, "wb");
+    if (!f) {
+        printf("Failed to create input\n");
+        return 1;
+    }
+    for (uint32_t n = 0; n < NUM_SAMPLES; n++) {
+        double t = (double)n / SAMPLE_RATE;
+        double i_val = 0.3 * cos(2.0 * M_PI * 95000.0 * t) + 0.2 * cos(2.0 * M_PI * -40000.0 * t) + 1e-7 * n;
+        double q_val = 0.3 * sin(2.0 * M_PI * 95000.0 * t) + 0.2 * sin(2.0 * M_PI * -40000.0 * t);
+        int16_t iq[2] = { (int16_t)lrint(i_val * 32767.0), (int16_t)lrint(q_val * 32767.0) };
+        fwrite(iq, sizeof(int16_t), 2, f);
+    }
+    fclose(f);
+
+    // Events CSV in iqdetect's layout
+    f = fopen(csv, "w");
+    if (!f) {
+        printf("Failed to create events CSV\n");
+        return 1;
+    }
+    fprintf(f, "t_start_s,t_end_s,f_center_Hz,bw_Hz,snr_dB,peak_dBFS,modulation_guess,confidence_0_1,tags\n");
+    for (size_t i = 0; i < NUM_EVENTS; i++) {
+        fprintf(f, "%.6f,%.6f,%.3f,%.3f,12.00,-6.00,unknown,0.900,\"burst,detection\"\n",
+                events[i].t_start, events[i].t_end, events[i].f_center, events[i].bw);
+    }
+    fclose(f);
+
+    snprintf(command, sizeof(command), IQCUT " --in %s --rate %d --events %s --out iqcut_batch_ev",
+             input, SAMPLE_RATE, csv);
+    if (system(command) != 0) {
+        printf("Batch iqcut failed\n");
+        ok = false;
+    }
+
+    // Each snippet matches a single cut of the same event
+    for (size_t i = 0; ok && i < NUM_EVENTS; i++) {
+        snprintf(command, sizeof(command),
+                 IQCUT " --in %s --rate %d --f_center %.3f --bw %.3f --t_start %.6f --t_end %.6f --out iqcut_batch_single",
+                 input, SAMPLE_RATE, events[i].f_center, events[i].bw, events[i].t_start, events[i].t_end);
+        snprintf(path_a, sizeof(path_a), "iqcut_batch_ev_%03zu.iq", i);
+        ok = system(command) == 0 && file_size(path_a) > 0 && same_file(path_a, "iqcut_batch_single.iq");
+        if (!ok) printf("Snippet %zu differs from a single cut\n", i);
+    }
+
+    // Full band at DC: nothing to translate or filter, the snippet is copied from the input
+    snprintf(command, sizeof(command),
+             IQCUT " --in %s --rate %d --f_center 0 --bw %d --t_start 0.05 --t_end 0.1 --out iqcut_batch_single",
+             input, SAMPLE_RATE, SAMPLE_RATE);
+    if (ok && (system(command) != 0 || !same_range("iqcut_batch_single.iq", input, 100000L * 4, 100000L * 4))) {
+        printf("Passthrough cut is not the input's bytes\n");
+        ok = false;
+    }
+
+    // SigMF annotations with absolute edges around a 100 MHz capture, band-filtered
+    f = fopen(meta, "w");
+    if (!f) {
+        printf("Failed to create metadata\n");
+        return 1;
+    }
+    fprintf(f, "{\"global\": {\"core:datatype\": \"ci16_le\", \"core:sample_rate\": %d},\n"
+               " \"captures\": [{\"core:sample_start\": 0, \"core:frequency\": 100000000}],\n"
+               " \"annotations\": [\n", SAMPLE_RATE);
+    for (size_t i = 0; i < NUM_EVENTS; i++) {
+        uint64_t start = (uint64_t)floor(events[i].t_start * SAMPLE_RATE);
+        uint64_t end = (uint64_t)floor(events[i].t_end * SAMPLE_RATE);
+        double center = 100000000.0 + events[i].f_center;
+        fprintf(f, "  {\"core:sample_start\": %llu, \"core:sample_count\": %llu, "
+                   "\"core:freq_lower_edge\": %.0f, \"core:freq_upper_edge\": %.0f, \"core:label\": \"event %zu\"}%s\n",
+                (unsigned long long)start, (unsigned long long)(end - start),
+                center - events[i].bw / 2.0, center + events[i].bw / 2.0, i,
+                i + 1 < NUM_EVENTS ? "," : "");
+    }
+    fprintf(f, " ]}\n");
+    fclose(f);
+
+    // Events 0 and 3 lie above 100.08 MHz; snippets come out in start order
+    snprintf(command, sizeof(command),
+             IQCUT " --in %s --annotations --band 100080000:100400000 --out iqcut_batch_an", input);
+    if (ok && system(command) != 0) {
+        printf("Annotation batch iqcut failed\n");
+        ok = false;
+    }
+    ok = ok && same_file("iqcut_batch_an_000.iq", "iqcut_batch_ev_000.iq") &&
+         same_file("iqcut_batch_an_001.iq", "iqcut_batch_ev_003.iq") &&
+         file_size("iqcut_batch_an_002.iq") < 0;
+    if (!ok) printf("Annotation snippets incorrect\n");
+
+    // Clean up
+    remove(input);
+    remove(csv);
+    remove(meta);
+    remove("iqcut_batch_input.sigmf-idx");
+    remove("iqcut_batch_single.iq");
+    remove("iqcut_batch_single.sigmf-meta");
+    for (size_t i = 0; i < NUM_EVENTS; i++) {
+        snprintf(path_a, sizeof(path_a), "iqcut_batch_ev_%03zu.iq", i);
+        snprintf(path_b, sizeof(path_b), "iqcut_batch_ev_%03zu.sigmf-meta", i);
+        remove(path_a);
+        remove(path_b);
+        snprintf(path_a, sizeof(path_a), "iqcut_batch_an_%03zu.iq", i);
+        snprintf(path_b, sizeof(path_b), "iqcut_batch_an_%03zu.sigmf-meta", i);
+        remove(path_a);
+        remove(path_b);
+    }
+
+    if (!ok) return 1;
+    printf("iqcut batch test passed\n");
+    return 0;
+}
@@ -0,0 +1,136 @@
+/* iqls zoom test: the reduced-rate FFT resolves close tones, rejects an out-of-span one and labels bins around the centre */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <stdint.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#ifdef _WIN32
+#define IQLS ".\\iqls.exe"
+#else
+#define IQLS "./iqls"
+#endif
+
+#define SAMPLE_RATE 2000000
+#define NUM_SAMPLES 1600000
+#define ZOOM_CENTER 300000.0
+#define ZOOM_SPAN 2000.0
+#define FFT_SIZE 1024
+
+// Reduced rate iqls picks for this span: 2 MHz / floor(0.8 * 2 MHz / 2 kHz)
+#define ZOOM_RATE (SAMPLE_RATE / 800.0)
+
+// Two tones 20 bins apart (49 Hz: one full-band bin is 1953 Hz) and one
+// outside the span that would alias onto the centre bin without the filter
+static const struct { double offset_bins; double amplitude; } tones[] = {
+    { 8.0, 0.25 },
+    { -12.0, 0.25 },
+};
+static const double out_of_span_hz = 5000.0;
+
+// Load a float32 rows x FFT_SIZE .npy written by --raw f32
+static float *load_npy(const char *path, size_t *rows) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    uint8_t preamble[10];
+    float *data = NULL;
+    if (fread(preamble, 1, sizeof(preamble), f) == sizeof(preamble) && memcmp(preamble, "\x93NUMPY", 6) == 0) {
+        long header = preamble[8] | (preamble[9] << 8);
+        fseek(f, 0, SEEK_END);
+        long body = ftell(f) - 10 - header;
+        *rows = body > 0 ? (size_t)body / (FFT_SIZE * sizeof(float)) : 0;
+        data = *rows ? malloc(*rows * FFT_SIZE * sizeof(float)) : NULL;
+        fseek(f, 10 + header, SEEK_SET);
+        if (data && fread(data, sizeof(float), *rows * FFT_SIZE, f) != *rows * FFT_SIZE) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    return data;
+}
+
+int main(void) {
+    const char *input = "iqls_zoom_input.iq";
+    const char *npy = "iqls_zoom_spectrogram.npy";
+
+    FILE *f = fopen(input, "wb");
+    if (!f) {
+        printf("Failed to create %s\n", input);
+        return 1;
+    }
+    const double bin_hz = ZOOM_RATE / FFT_SIZE;
+    for (uint32_t n = 0; n < NUM_SAMPLES; n++) {
+        double i = 0.0, q = 0.0;
+        for (size_t t = 0; t < sizeof(tones) / sizeof(tones[0]); t++) {
+            double phase = 2.0 * M_PI * (ZOOM_CENTER + tones[t].offset_bins * bin_hz) * n / SAMPLE_RATE;
+            i += tones[t].amplitude * cos(phase);
+            q += tones[t].amplitude * sin(phase);
+        }
+        double phase = 2.0 * M_PI * (ZOOM_CENTER + out_of_span_hz) * n / SAMPLE_RATE;
+        i += 0.25 * cos(phase);
+        q += 0.25 * sin(phase);
+        int16_t iq[2] = { (int16_t)lrint(i * 32767.0), (int16_t)lrint(q * 32767.0) };
+        fwrite(iq, sizeof(int16_t), 2, f);
+    }
+    fclose(f);
+
+    char command[512];
+    snprintf(command, sizeof(command),
+             IQLS " --in %s --format s16 --rate %d --zoom-center %.0f --zoom-span %.0f --fft %d --hop 512"
+             " --window hann --raw f32 --out iqls_zoom", input, SAMPLE_RATE, ZOOM_CENTER, ZOOM_SPAN, FFT_SIZE);
+    if (system(command) != 0) {
+        printf("iqls --zoom-span failed\n");
+        remove(input);
+        return 1;
+    }
+
+    size_t rows = 0;
+    float *power = load_npy(npy, &rows);
+    bool ok = power != NULL;
+    if (!ok) printf("Could not read %s\n", npy);
+
+    // Both tones land on their own bins, DC (where the alias would fall) stays clean
+    for (size_t r = 0; ok && r < rows; r++) {
+        const float *row = power + r * FFT_SIZE;
+        double weakest = INFINITY;
+        for (size_t t = 0; t < sizeof(tones) / sizeof(tones[0]); t++) {
+            int bin = FFT_SIZE / 2 + (int)tones[t].offset_bins;
+            for (int k = 0; k < FFT_SIZE; k++) {
+                if (abs(k - bin) > 1 && row[k] > row[bin]) {
+                    bool other_tone = false;
+                    for (size_t u = 0; u < sizeof(tones) / sizeof(tones[0]); u++) {
+                        if (abs(k - (FFT_SIZE / 2 + (int)tones[u].offset_bins)) <= 1) other_tone = true;
+                    }
+                    if (!other_tone) {
+                        printf("Row %zu: bin %d above the tone at bin %d\n", r, k, bin);
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+            if (row[bin] < weakest) weakest = row[bin];
+        }
+        double rejection = 10.0 * log10(weakest / (row[FFT_SIZE / 2] + 1e-20));
+        if (rejection < 40.0) {
+            printf("Row %zu: out-of-span tone only %.1f dB below the in-span tones\n", r, rejection);
+            ok = false;
+        }
+    }
+    if (ok && rows == 0) {
+        printf("No zoom frames written\n");
+        ok = false;
+    }
+    free(power);
+    remove(input);
+    remove(npy);
+
+    if (!ok) return 1;
+    printf("iqls zoom test passed (%zu frames, %.3f Hz per bin)\n", rows, bin_hz);
+    return 0;
+}
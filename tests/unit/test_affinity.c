@@ -0,0 +1,163 @@
+/*
+ * IQ Lab - Affinity Unit Tests
+ *
+ * Tests for worker placement: policies and CPU lists accepted or refused,
+ * threads pinned in the policy's order (and to a requested node), and
+ * first-touch leaving buffer contents unchanged
+ */
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // sched_getcpu
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../../src/iq_core/affinity.h"
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+static bool test_policies(void) {
+    TEST_START("Policies and CPU lists");
+
+    printf("  %u CPUs on %u NUMA nodes\n", iq_affinity_cpus(), iq_affinity_nodes());
+    bool ok = iq_affinity_cpus() >= 1 && iq_affinity_nodes() >= 1 &&
+              iq_affinity_policy() == IQ_PIN_NONE &&
+              iq_affinity_pin_next() == -1 && iq_affinity_current_node() == -1;
+    if (!ok) {
+        TEST_FAIL("pinning must be off by default");
+        return false;
+    }
+
+    ok = iq_affinity_set("scatter") && iq_affinity_policy() == IQ_PIN_SCATTER &&
+         iq_affinity_set("0") && iq_affinity_policy() == IQ_PIN_LIST &&
+         iq_affinity_set(NULL) && iq_affinity_policy() == IQ_PIN_COMPACT &&
+         !iq_affinity_set("sideways") && !iq_affinity_set("3-1") && !iq_affinity_set("1,,2") &&
+         !iq_affinity_set("1000") && iq_affinity_policy() == IQ_PIN_COMPACT &&
+         !iq_affinity_parse_arg("--pinned") && !iq_affinity_parse_arg("--profile") &&
+         iq_affinity_set("none") && iq_affinity_policy() == IQ_PIN_NONE;
+    if (!ok) {
+        TEST_FAIL("policy parsing");
+        return false;
+    }
+
+    TEST_PASS();
+    return true;
+}
+
+typedef struct {
+    int node;          // Node to pin to, -1 for the next CPU
+    int cpu;           // CPU pinned to
+    int running_on;    // CPU the thread then ran on (-1 if unknown)
+} pin_probe_t;
+
+static void *pin_thread(void *arg) {
+    pin_probe_t *probe = arg;
+    probe->cpu = probe->node >= 0 ? iq_affinity_pin_node(probe->node) : iq_affinity_pin_next();
+#ifdef __linux__
+    probe->running_on = sched_getcpu();
+#else
+    probe->running_on = -1;
+#endif
+    return NULL;
+}
+
+static bool test_pinning(void) {
+    TEST_START("Threads pinned in order");
+
+#ifndef __linux__
+    printf("  (thread pinning is only checked on Linux)\n");
+    TEST_PASS();
+    return true;
+#else
+    // Compact: the main thread takes the first CPU, threads the next ones
+    bool ok = iq_affinity_parse_arg("--pin=compact") && iq_affinity_current_node() >= 0;
+    int first = sched_getcpu();
+    pin_probe_t probes[4];
+    for (int t = 0; ok && t < 4; t++) {
+        pthread_t thread;
+        probes[t].node = -1;
+        ok = pthread_create(&thread, NULL, pin_thread, &probes[t]) == 0 && pthread_join(thread, NULL) == 0;
+        ok = ok && probes[t].cpu >= 0 && probes[t].running_on == probes[t].cpu;
+    }
+    if (ok && iq_affinity_cpus() > 1) ok = probes[0].cpu != first;
+    if (!ok) {
+        TEST_FAIL("compact pinning");
+        iq_affinity_set("none");
+        return false;
+    }
+
+    // A thread asked onto a node lands on a CPU of that node
+    int node = iq_affinity_node_of_cpu(first);
+    pin_probe_t probe = {node, -1, -1};
+    pthread_t thread;
+    ok = pthread_create(&thread, NULL, pin_thread, &probe) == 0 && pthread_join(thread, NULL) == 0 &&
+         probe.cpu >= 0 && iq_affinity_node_of_cpu(probe.cpu) == node && probe.running_on == probe.cpu;
+
+    // An explicit list: the main thread moves to its only CPU
+    ok = ok && iq_affinity_parse_arg("--pin=0") && sched_getcpu() == 0;
+    iq_affinity_set("none");
+    if (!ok) {
+        TEST_FAIL("node or list pinning");
+        return false;
+    }
+
+    TEST_PASS();
+    return true;
+#endif
+}
+
+static bool test_first_touch(void) {
+    TEST_START("First touch keeps contents");
+
+    iq_affinity_set("compact");
+    size_t bytes = 3 * 65536 + 123;
+    unsigned char *buffer = malloc(bytes);
+    bool ok = buffer != NULL;
+    for (size_t i = 0; ok && i < bytes; i++) buffer[i] = (unsigned char)(i * 31);
+    if (ok) iq_affinity_first_touch(buffer + 7, bytes - 7);
+    for (size_t i = 0; ok && i < bytes; i++) ok = buffer[i] == (unsigned char)(i * 31);
+    free(buffer);
+    iq_affinity_set("none");
+
+    if (!ok) {
+        TEST_FAIL("buffer changed");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Affinity Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_policies();
+    test_pinning();
+    test_first_touch();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 #include "../../src/demod/agc.h"
@@ -252,6 +253,79 @@ void test_agc_errors() {
     }
 }
 
+// Gain per sample of a DC input stepping from 0.05 to 0.5 half way
+static void gain_trajectory(agc_t *agc, float *gain, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) gain[i] = i < count / 2 ? 0.05f : 0.5f;
+    float *input = malloc(count * sizeof(float));
+    memcpy(input, gain, count * sizeof(float));
+    agc_process_buffer(agc, gain, count);
+    for (uint32_t i = 0; i < count; i++) gain[i] /= input[i];
+    free(input);
+}
+
+// Largest change of gain between consecutive samples, relative to the gain
+static float max_gain_step(const float *gain, uint32_t count) {
+    float worst = 0.0f;
+    for (uint32_t i = 1; i < count; i++) {
+        float step = fabsf(gain[i] - gain[i - 1]) / gain[i - 1];
+        if (step > worst) worst = step;
+    }
+    return worst;
+}
+
+// Test block mode against per-sample processing
+void test_agc_block_mode() {
+    TEST_START("Block Mode");
+
+    const uint32_t count = 96000;
+    float *per_sample = malloc(count * sizeof(float));
+    float *block = malloc(count * sizeof(float));
+    float *scalar = malloc(count * sizeof(float));
+    if (!per_sample || !block || !scalar) {
+        TEST_FAIL("Allocation failed");
+        return;
+    }
+
+    agc_t a, b;
+    agc_init(&a, 48000);
+    agc_init(&b, 48000);
+    bool configured = agc_set_block_size(&b, AGC_DEFAULT_BLOCK_SIZE) && !agc_set_block_size(NULL, 64);
+    gain_trajectory(&a, per_sample, count);
+    gain_trajectory(&b, block, count);
+
+    // Same regulation once settled on either level
+    float settled_low = fabsf(block[count / 2 - 1] / per_sample[count / 2 - 1] - 1.0f);
+    float settled_high = fabsf(block[count - 1] / per_sample[count - 1] - 1.0f);
+
+    // The ramps never move the gain faster than per-sample smoothing does
+    float step_block = max_gain_step(block, count);
+    float step_sample = max_gain_step(per_sample, count);
+
+    // Vector kernels match the scalar ones
+    agc_force_scalar(true);
+    agc_init(&b, 48000);
+    agc_set_block_size(&b, AGC_DEFAULT_BLOCK_SIZE);
+    gain_trajectory(&b, scalar, count);
+    agc_force_scalar(false);
+    bool identical = memcmp(block, scalar, count * sizeof(float)) == 0;
+
+    printf("    Settled gain vs per-sample: %.4f%% / %.4f%%\n", 100.0f * settled_low,
+           100.0f * settled_high);
+    printf("    Largest gain step: block %.4f%%, per-sample %.4f%%\n", 100.0f * step_block,
+           100.0f * step_sample);
+
+    if (configured && settled_low < 0.01f && settled_high < 0.01f &&
+        step_block <= step_sample && identical) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Block mode differs from per-sample processing");
+    }
+
+    free(per_sample);
+    free(block);
+    free(scalar);
+}
+
 int main() {
     printf("=====================================\n");
     printf("IQ Lab - AGC Unit Tests\n");
@@ -263,6 +337,7 @@ int main() {
     test_agc_peak_detection();
     test_agc_configurations();
     test_agc_buffer_processing();
+    test_agc_block_mode();
     test_agc_errors();
 
     printf("\n=====================================\n");
@@ -0,0 +1,295 @@
+/*
+ * IQ Lab - Scratch Arena Unit Tests
+ *
+ * Tests for the preallocated scratch arenas and the heap allocation guard
+ * Covers aligned bump allocation, overflow and reset, threads sharing one
+ * arena, FFT scratch carved from the bound arena for power-of-two, mixed
+ * radix and Bluestein sizes with nothing allocated after the first frame,
+ * and an STFT pool running under the dispatcher's arena and guard.
+ * Built with -DIQ_ALLOC_DEBUG the steady-state checks also count heap
+ * allocations, and a stray one aborts the test.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include "../../src/iq_core/arena.h"
+#include "../../src/iq_core/fft.h"
+#include "../../src/iq_core/stft.h"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { NUM_THREADS = 4, THREAD_BLOCKS = 1000 };
+
+// Deterministic test tone with a little of everything in it
+static void fill_iq(float *iq, uint32_t samples) {
+    for (uint32_t n = 0; n < samples; n++) {
+        iq[2 * n] = (float)cos(0.1 * n) + 0.01f * (float)(n % 7);
+        iq[2 * n + 1] = (float)sin(0.1 * n) - 0.01f * (float)(n % 5);
+    }
+}
+
+// Blocks are aligned and packed, a full arena overflows, reset starts over
+void test_arena_bump() {
+    TEST_START("Bump Allocation");
+
+    iq_arena_t arena;
+    bool ok = iq_arena_init(&arena, 4 * IQ_ARENA_ALIGN);
+    uint64_t generation = arena.generation;
+
+    uint8_t *a = iq_arena_alloc(&arena, 1);
+    uint8_t *b = iq_arena_alloc(&arena, IQ_ARENA_ALIGN + 1);
+    uint8_t *c = iq_arena_alloc(&arena, IQ_ARENA_ALIGN);
+    if (!a || !b || !c) ok = false;
+    if (ok && ((uintptr_t)a % IQ_ARENA_ALIGN || b != a + IQ_ARENA_ALIGN ||
+               c != b + 2 * IQ_ARENA_ALIGN)) ok = false;
+    if (iq_arena_used(&arena) != 4 * IQ_ARENA_ALIGN) ok = false;
+
+    // Full: NULL and one overflow each, nothing given out
+    if (iq_arena_alloc(&arena, 1) || iq_arena_alloc(&arena, 1u << 20)) ok = false;
+    if (atomic_load(&arena.overflows) != 2) ok = false;
+    if (iq_arena_alloc(&arena, 0)) ok = false;
+
+    iq_arena_reset(&arena);
+    if (iq_arena_used(&arena) != 0 || arena.generation == generation) ok = false;
+    if (iq_arena_alloc(&arena, 1) != a) ok = false;
+
+    // Binding returns the previous arena; freeing unbinds it
+    if (iq_arena_bind(&arena) != NULL || iq_arena_current() != &arena) ok = false;
+    iq_arena_free(&arena);
+    if (iq_arena_current() != NULL) ok = false;
+
+    // The guard reports its previous state
+    if (iq_alloc_guarded() || iq_alloc_guard(true) != false || !iq_alloc_guarded()) ok = false;
+    if (iq_alloc_guard(false) != true || iq_alloc_guarded()) ok = false;
+
+#ifdef IQ_ALLOC_DEBUG
+    // Every entry point is counted on the calling thread
+    uint64_t before = iq_alloc_count();
+    void *volatile p = malloc(16);
+    p = realloc(p, 64);
+    free(p);
+    p = calloc(4, 4);
+    free(p);
+    if (iq_alloc_count() != before + 3) ok = false;
+#endif
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Aligned packed blocks, overflow counted, reset and unbind\n");
+    } else {
+        TEST_FAIL("Unexpected bump allocation");
+    }
+    TEST_END();
+}
+
+typedef struct {
+    iq_arena_t *arena;
+    uint32_t index;
+    uint8_t *blocks[THREAD_BLOCKS];
+} arena_thread_t;
+
+static void *arena_thread(void *arg) {
+    arena_thread_t *t = arg;
+    for (uint32_t i = 0; i < THREAD_BLOCKS; i++) {
+        t->blocks[i] = iq_arena_alloc(t->arena, IQ_ARENA_ALIGN);
+        if (t->blocks[i]) memset(t->blocks[i], (int)t->index + 1, IQ_ARENA_ALIGN);
+    }
+    return NULL;
+}
+
+// Threads sharing one arena never get overlapping blocks
+void test_arena_threads() {
+    TEST_START("Shared Arena");
+
+    iq_arena_t arena;
+    bool ok = iq_arena_init(&arena, (size_t)NUM_THREADS * THREAD_BLOCKS * IQ_ARENA_ALIGN);
+
+    arena_thread_t threads[NUM_THREADS];
+    pthread_t handles[NUM_THREADS];
+    for (uint32_t i = 0; i < NUM_THREADS; i++) {
+        threads[i].arena = &arena;
+        threads[i].index = i;
+        pthread_create(&handles[i], NULL, arena_thread, &threads[i]);
+    }
+    for (uint32_t i = 0; i < NUM_THREADS; i++) {
+        pthread_join(handles[i], NULL);
+    }
+
+    for (uint32_t i = 0; ok && i < NUM_THREADS; i++) {
+        for (uint32_t j = 0; j < THREAD_BLOCKS; j++) {
+            const uint8_t *block = threads[i].blocks[j];
+            if (!block) { ok = false; break; }
+            for (uint32_t k = 0; k < IQ_ARENA_ALIGN; k++) {
+                if (block[k] != i + 1) { ok = false; break; }
+            }
+        }
+    }
+    if (iq_arena_used(&arena) != arena.capacity || atomic_load(&arena.overflows) != 0) ok = false;
+    iq_arena_free(&arena);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %d threads filled the arena exactly, no block shared\n", NUM_THREADS);
+    } else {
+        TEST_FAIL("Blocks overlapped or the arena did not fill exactly");
+    }
+    TEST_END();
+}
+
+// One size: frames, complex and real transforms from a bound arena
+static bool fft_steady_state(uint32_t size, char *detail, size_t detail_size) {
+    fft_plan_f32_t *plan = fft_plan_f32_acquire(size, FFT_FORWARD);
+    float *iq = malloc((size_t)size * 2 * sizeof(float));
+    float *row = malloc((size_t)size * sizeof(float));
+    float *reference = malloc((size_t)size * sizeof(float));
+    fft_complex_t *x = malloc((size_t)size * sizeof(fft_complex_t));
+    fft_complex_t *y = malloc((size_t)size * sizeof(fft_complex_t));
+    bool ok = plan && iq && row && reference && x && y;
+    if (ok) {
+        fill_iq(iq, size);
+        for (uint32_t n = 0; n < size; n++) x[n] = iq[2 * n] + iq[2 * n + 1] * I;
+        // Heap scratch first: the result the arena run must reproduce
+        ok = fft_spectral_frame(plan, iq, NULL, reference, false);
+        fft_release_thread_buffers();
+    }
+
+    iq_arena_t arena;
+    ok = ok && iq_arena_init(&arena, fft_scratch_bytes(size));
+    iq_arena_t *previous = iq_arena_bind(&arena);
+    size_t used = 0;
+    uint64_t allocations = 0;
+    for (int pass = 0; ok && pass < 4; pass++) {
+        ok = fft_spectral_frame(plan, iq, NULL, row, false) && fft_forward(x, y, size) &&
+             fft_inverse(y, x, size);
+        if (size % 2 == 0) ok = ok && fft_real_inverse(y, (double *)x, size);
+        if (pass == 0) {
+            used = iq_arena_used(&arena);
+            allocations = iq_alloc_count();
+        }
+    }
+    ok = ok && memcmp(row, reference, (size_t)size * sizeof(float)) == 0;
+
+    size_t after = iq_arena_used(&arena);
+    uint64_t overflows = atomic_load(&arena.overflows);
+    uint64_t extra = iq_alloc_count() - allocations;
+    snprintf(detail, detail_size, "N=%u: %zu of %zu bytes, %llu overflows, %llu later allocations",
+             size, after, arena.capacity, (unsigned long long)overflows, (unsigned long long)extra);
+    if (used == 0 || after != used || overflows != 0 || extra != 0) ok = false;
+
+    iq_arena_bind(previous);
+    iq_arena_free(&arena);
+
+    // Unbound again: the thread's scratch moves back to the heap
+    ok = ok && plan && fft_spectral_frame(plan, iq, NULL, row, false);
+    fft_release_thread_buffers();
+
+    fft_plan_f32_release(plan);
+    free(iq); free(row); free(reference); free(x); free(y);
+    return ok;
+}
+
+// FFT scratch fits fft_scratch_bytes() and stops growing after the first call
+void test_fft_scratch() {
+    TEST_START("FFT Scratch From Arena");
+
+    static const uint32_t sizes[] = {4096, 1000, 1009, 65536};
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        char detail[160];
+        bool size_ok = fft_steady_state(sizes[i], detail, sizeof(detail));
+        printf("    %s %s\n", size_ok ? "✅" : "❌", detail);
+        if (!size_ok) ok = false;
+    }
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("FFT scratch overflowed the arena or kept growing");
+    }
+    TEST_END();
+}
+
+// Pool threads run under the dispatcher's arena and guard
+void test_stft_pool() {
+    TEST_START("STFT Pool Under One Arena");
+
+    const uint32_t size = 1024, frames = 64, hop = 512;
+    const uint32_t samples = (frames - 1) * hop + size;
+    fft_plan_f32_t *plan = fft_plan_f32_acquire(size, FFT_FORWARD);
+    stft_t *stft = plan ? stft_create(plan, NULL, NUM_THREADS) : NULL;
+    float *iq = malloc((size_t)samples * 2 * sizeof(float));
+    float *rows = malloc((size_t)frames * size * sizeof(float));
+    bool ok = stft && iq && rows;
+
+    iq_arena_t arena;
+    ok = ok && iq_arena_init(&arena, (size_t)NUM_THREADS * fft_scratch_bytes(size));
+    iq_arena_t *previous = iq_arena_bind(&arena);
+    size_t used = 0;
+    if (ok) {
+        fill_iq(iq, samples);
+        ok = stft_rows(stft, iq, frames, hop, rows, false);
+        used = iq_arena_used(&arena);
+
+        // Warmed up: with IQ_ALLOC_DEBUG an allocation on any thread aborts
+        iq_alloc_guard(true);
+        for (int pass = 0; ok && pass < 8; pass++) {
+            ok = stft_rows(stft, iq, frames, hop, rows, false);
+        }
+        iq_alloc_guard(false);
+    }
+    if (used == 0 || iq_arena_used(&arena) != used || atomic_load(&arena.overflows) != 0) ok = false;
+    iq_arena_bind(previous);
+
+    stft_destroy(stft);
+    iq_arena_free(&arena);
+    fft_release_thread_buffers();
+    fft_plan_f32_release(plan);
+    free(iq);
+    free(rows);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %d threads, %zu arena bytes, no growth after the first batch\n", NUM_THREADS, used);
+    } else {
+        TEST_FAIL("Pool scratch did not come from the dispatcher's arena");
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Scratch Arena Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_arena_bump();
+    test_arena_threads();
+    test_fft_scratch();
+    test_stft_pool();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
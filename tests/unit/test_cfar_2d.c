@@ -0,0 +1,198 @@
+/*
+ * IQ Lab - 2-D CFAR Unit Tests
+ *
+ * Tests for the time x frequency CA-CFAR. Running column sums must agree with
+ * summing the ring directly (also across a column-sum rebuild), detections
+ * must trail the newest row by delay_rows, the false alarm rate must sit near
+ * the requested PFA, and a weak persistent carrier must be found more often
+ * than with per-frame CA-CFAR at the same PFA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/detect/cfar_2d.h"
+#include "../../src/detect/cfar_ca.h"
+
+static uint32_t rng_state = 99u;
+
+// Exponentially distributed power (|complex Gaussian|^2), deterministic
+static void fill_exponential_row(double *row, uint32_t size, double noise_power) {
+    for (uint32_t i = 0; i < size; i++) {
+        rng_state = rng_state * 1664525u + 1013904223u;
+        double u = ((rng_state >> 8) + 1) / 16777217.0;
+        row[i] = -log(u) * noise_power;
+    }
+}
+
+static void test_cfar_2d_initialization(void) {
+    printf("Testing CFAR 2D initialization...\n");
+
+    cfar_2d_t cfar;
+    assert(cfar_2d_init(&cfar, 1024, 1e-3, 8, 2, 4, 1) == true);
+    assert(cfar.ring_rows == 11);
+    assert(cfar.delay_rows == 5);
+    assert(cfar.max_cells == 21 * 11 - 5 * 3);
+    cfar_2d_free(&cfar);
+
+    // Invalid frequency or time parameters
+    assert(cfar_2d_init(&cfar, 1024, 0.0, 8, 2, 4, 1) == false);
+    assert(cfar_2d_init(&cfar, 1024, 1e-3, 0, 2, 4, 1) == false);
+    assert(cfar_2d_init(&cfar, 1024, 1e-3, 8, 2, CFAR_2D_MAX_REF_ROWS + 1, 1) == false);
+    assert(cfar_2d_init(&cfar, 1024, 1e-3, 8, 2, 4, CFAR_2D_MAX_GUARD_ROWS + 1) == false);
+
+    printf("✓ CFAR 2D initialization tests passed\n");
+}
+
+static void test_cfar_2d_matches_direct_sum(void) {
+    printf("Testing CFAR 2D running sums against direct sums...\n");
+
+    const uint32_t size = 256;
+    const uint32_t rows = CFAR_2D_RESUM_ROWS + 40;   // Crosses a column-sum rebuild
+    double row[256];
+    cfar_detection_t detections[256];
+
+    cfar_2d_t cfar;
+    assert(cfar_2d_init(&cfar, size, 1e-3, 6, 1, 3, 1) == true);
+
+    for (uint32_t r = 0; r < rows; r++) {
+        fill_exponential_row(row, size, 1.0 + (r % 7));
+        uint32_t count = cfar_2d_push_row(&cfar, row, detections, size);
+
+        if (r + 1 < cfar.ring_rows) {
+            assert(count == 0);
+            assert(cfar_2d_get_threshold(&cfar, 0) == 0.0);
+            continue;
+        }
+        if (r % 97 != 0 && r + 1 != rows) continue;
+
+        for (uint32_t bin = 0; bin < size; bin++) {
+            double direct = cfar_2d_get_threshold(&cfar, bin);
+            assert(direct > 0.0);
+            assert(fabs(cfar.thresholds[bin] - direct) <= 1e-9 * direct);
+        }
+    }
+
+    cfar_2d_free(&cfar);
+    printf("✓ CFAR 2D running sum tests passed\n");
+}
+
+static void test_cfar_2d_delay(void) {
+    printf("Testing CFAR 2D detection delay...\n");
+
+    const uint32_t size = 128;
+    double row[128];
+    cfar_detection_t detections[16];
+
+    cfar_2d_t cfar;
+    assert(cfar_2d_init(&cfar, size, 1e-4, 8, 1, 2, 1) == true);
+    for (uint32_t i = 0; i < size; i++) row[i] = 1.0;
+
+    // Impulse in row 10, bin 40: reported when row 10 + delay_rows is pushed
+    uint32_t impulse_row = 10;
+    for (uint32_t r = 0; r < 30; r++) {
+        row[40] = r == impulse_row ? 1000.0 : 1.0;
+        uint32_t count = cfar_2d_push_row(&cfar, row, detections, 16);
+        if (r == impulse_row + cfar.delay_rows) {
+            assert(count == 1);
+            assert(detections[0].bin_index == 40);
+        } else {
+            assert(count == 0);
+        }
+    }
+
+    // Reset drops the history
+    cfar_2d_reset(&cfar);
+    assert(cfar.rows_pushed == 0);
+    assert(cfar_2d_push_row(&cfar, row, detections, 16) == 0);
+
+    cfar_2d_free(&cfar);
+    printf("✓ CFAR 2D delay tests passed\n");
+}
+
+static void test_cfar_2d_false_alarm_rate(void) {
+    printf("Testing CFAR 2D false alarm rate on exponential noise...\n");
+
+    const uint32_t size = 4096;
+    const uint32_t rows = 60;
+    const double pfa = 1e-2;
+    double *row = malloc(size * sizeof(double));
+    cfar_detection_t *detections = malloc(size * sizeof(cfar_detection_t));
+    assert(row && detections);
+
+    cfar_2d_t cfar;
+    assert(cfar_2d_init(&cfar, size, pfa, 8, 1, 4, 1) == true);
+
+    uint64_t total = 0, tested = 0;
+    for (uint32_t r = 0; r < rows; r++) {
+        fill_exponential_row(row, size, 2.0);
+        total += cfar_2d_push_row(&cfar, row, detections, size);
+        if (r + 1 >= cfar.ring_rows) tested += size;
+    }
+    double rate = (double)total / (double)tested;
+    assert(rate > 0.5 * pfa && rate < 1.5 * pfa);
+
+    cfar_2d_free(&cfar);
+    free(detections);
+    free(row);
+    printf("✓ CFAR 2D false alarm rate test passed (%.4f for PFA %.4f)\n", rate, pfa);
+}
+
+static void test_cfar_2d_weak_carrier(void) {
+    printf("Testing CFAR 2D against per-frame CA on a weak carrier...\n");
+
+    const uint32_t size = 1024;
+    const uint32_t rows = 400;
+    const uint32_t carrier = 600;
+    const double pfa = 1e-4;
+    double *row = malloc(size * sizeof(double));
+    cfar_detection_t *detections = malloc(size * sizeof(cfar_detection_t));
+    assert(row && detections);
+
+    cfar_2d_t cfar2d;
+    cfar_ca_t cfar1d;
+    // Full-height guard: the carrier's own bin never trains, its neighbours
+    // train across all 13 rows
+    assert(cfar_2d_init(&cfar2d, size, pfa, 4, 1, 0, 6) == true);
+    assert(cfar_ca_init(&cfar1d, size, pfa, 4, 1, CFAR_MODE_CA) == true);
+
+    // Carrier 10 dB above the noise mean, present in every row
+    uint32_t hits_2d = 0, hits_1d = 0;
+    for (uint32_t r = 0; r < rows; r++) {
+        fill_exponential_row(row, size, 1.0);
+        row[carrier] += 10.0;
+
+        uint32_t count = cfar_ca_process_frame(&cfar1d, row, detections, size);
+        for (uint32_t i = 0; i < count; i++) hits_1d += detections[i].bin_index == carrier;
+
+        count = cfar_2d_push_row(&cfar2d, row, detections, size);
+        for (uint32_t i = 0; i < count; i++) hits_2d += detections[i].bin_index == carrier;
+    }
+
+    assert(hits_2d > hits_1d);
+
+    cfar_2d_free(&cfar2d);
+    cfar_ca_free(&cfar1d);
+    free(detections);
+    free(row);
+    printf("✓ CFAR 2D weak carrier test passed (%u vs %u of %u rows)\n", hits_2d, hits_1d, rows);
+}
+
+// Main test runner
+int main(void) {
+    printf("Running CFAR 2D Unit Tests\n");
+    printf("==========================\n\n");
+
+    test_cfar_2d_initialization();
+    test_cfar_2d_matches_direct_sum();
+    test_cfar_2d_delay();
+    test_cfar_2d_false_alarm_rate();
+    test_cfar_2d_weak_carrier();
+
+    printf("\n==========================\n");
+    printf("All CFAR 2D tests passed! ✓\n");
+    printf("==========================\n");
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * IQ Lab - Mean-Level CFAR Unit Tests
+ *
+ * Tests for the CA/GO/SO-CFAR detector. Prefix-sum thresholds must agree
+ * with direct summation, the false alarm rate on exponential noise must sit
+ * near the requested PFA, GO/SO must bracket CA at clutter edges, and
+ * detection against externally computed thresholds (the device CFAR stage)
+ * must equal the built-in pass given the same thresholds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/detect/cfar_ca.h"
+
+// Exponentially distributed power (|complex Gaussian|^2), deterministic
+static double *generate_exponential_spectrum(uint32_t size, double noise_power, uint32_t seed) {
+    double *spectrum = malloc(size * sizeof(double));
+    if (!spectrum) return NULL;
+
+    uint32_t state = seed;
+    for (uint32_t i = 0; i < size; i++) {
+        state = state * 1664525u + 1013904223u;
+        double u = ((state >> 8) + 1) / 16777217.0;
+        spectrum[i] = -log(u) * noise_power;
+    }
+    return spectrum;
+}
+
+static void test_cfar_ca_initialization(void) {
+    printf("Testing CFAR CA initialization...\n");
+
+    cfar_ca_t cfar;
+    assert(cfar_ca_init(&cfar, 1024, 1e-3, 16, 2, CFAR_MODE_CA) == true);
+    assert(cfar.initialized);
+    assert(cfar.alpha[0] == 0.0);
+    // alpha(n) = n * (pfa^(-1/n) - 1)
+    assert(fabs(cfar.alpha[32] - 32.0 * (pow(1e-3, -1.0 / 32.0) - 1.0)) < 1e-12);
+    cfar_ca_free(&cfar);
+    assert(!cfar.initialized && cfar.prefix == NULL);
+
+    assert(cfar_ca_init(&cfar, 1024, 0.0, 16, 2, CFAR_MODE_CA) == false);
+    assert(cfar_ca_init(&cfar, 1024, 1e-3, 0, 2, CFAR_MODE_CA) == false);
+    assert(cfar_ca_init(&cfar, 1024, 1e-3, 16, 2, (cfar_mode_t)7) == false);
+
+    cfar_mode_t mode;
+    assert(cfar_mode_from_name("go", &mode) && mode == CFAR_MODE_GO);
+    assert(cfar_mode_from_name("so", &mode) && mode == CFAR_MODE_SO);
+    assert(cfar_mode_from_name("ca", &mode) && mode == CFAR_MODE_CA);
+    assert(!cfar_mode_from_name("os", &mode));
+    assert(strcmp(cfar_mode_name(CFAR_MODE_SO), "so") == 0);
+
+    printf("✓ CFAR CA initialization tests passed\n");
+}
+
+static void test_cfar_ca_matches_direct_sum(void) {
+    printf("Testing CFAR CA prefix sums against direct sums...\n");
+
+    const uint32_t size = 2048;
+    double *spectrum = generate_exponential_spectrum(size, 1.0, 42);
+    assert(spectrum != NULL);
+    spectrum[700] = 400.0;
+    spectrum[701] = 250.0;
+
+    const cfar_mode_t modes[] = {CFAR_MODE_CA, CFAR_MODE_GO, CFAR_MODE_SO};
+    cfar_detection_t *detections = malloc(size * sizeof(cfar_detection_t));
+    assert(detections != NULL);
+    for (int m = 0; m < 3; m++) {
+        cfar_ca_t cfar;
+        assert(cfar_ca_init(&cfar, size, 1e-4, 12, 0, modes[m]) == true);
+
+        uint32_t num_detections = cfar_ca_process_frame(&cfar, spectrum, detections, size);
+        uint32_t expected = 0;
+        for (uint32_t bin = 0; bin < size; bin++) {
+            double threshold = cfar_ca_get_threshold(&cfar, spectrum, bin);
+            assert(threshold > 0.0);
+            if (spectrum[bin] <= threshold * (1.0 + 1e-9)) {
+                continue;
+            }
+            // Skip bins within rounding of the threshold
+            while (expected < num_detections && detections[expected].bin_index < bin) expected++;
+            assert(expected < num_detections && detections[expected].bin_index == bin);
+            assert(fabs(detections[expected].threshold - 10.0 * log10(threshold)) < 1e-9);
+            expected++;
+        }
+
+        // Both tones found in every mode
+        bool found = false;
+        for (uint32_t i = 0; i < num_detections; i++) found |= detections[i].bin_index == 700;
+        assert(found);
+        cfar_ca_free(&cfar);
+    }
+
+    free(detections);
+    free(spectrum);
+    printf("✓ CFAR CA prefix sum tests passed\n");
+}
+
+static void test_cfar_ca_false_alarm_rate(void) {
+    printf("Testing CFAR CA false alarm rate on exponential noise...\n");
+
+    const uint32_t size = 65536;
+    const double pfa = 1e-2;
+    double *spectrum = generate_exponential_spectrum(size, 3.0, 7);
+    cfar_detection_t *detections = malloc(size * sizeof(cfar_detection_t));
+    assert(spectrum && detections);
+
+    cfar_ca_t cfar;
+    assert(cfar_ca_init(&cfar, size, pfa, 32, 2, CFAR_MODE_CA) == true);
+    uint32_t num_detections = cfar_ca_process_frame(&cfar, spectrum, detections, size);
+    double rate = (double)num_detections / size;
+
+    // alpha(n) is exact for CA in exponential noise: allow sampling spread
+    assert(rate > 0.5 * pfa && rate < 1.5 * pfa);
+
+    cfar_ca_free(&cfar);
+    free(detections);
+    free(spectrum);
+    printf("✓ CFAR CA false alarm rate test passed (%.4f for PFA %.4f)\n", rate, pfa);
+}
+
+static void test_cfar_ca_clutter_edge(void) {
+    printf("Testing CFAR GO/SO behaviour at a clutter edge...\n");
+
+    // Noise floor steps from 1 to 100 halfway across
+    const uint32_t size = 512;
+    double spectrum[512];
+    for (uint32_t i = 0; i < size; i++) spectrum[i] = i < size / 2 ? 1.0 : 100.0;
+
+    cfar_ca_t ca, go, so;
+    assert(cfar_ca_init(&ca, size, 1e-3, 8, 1, CFAR_MODE_CA));
+    assert(cfar_ca_init(&go, size, 1e-3, 8, 1, CFAR_MODE_GO));
+    assert(cfar_ca_init(&so, size, 1e-3, 8, 1, CFAR_MODE_SO));
+
+    uint32_t cut = size / 2 - 3;   // Low side, right block straddles the edge
+    double t_ca = cfar_ca_get_threshold(&ca, spectrum, cut);
+    double t_go = cfar_ca_get_threshold(&go, spectrum, cut);
+    double t_so = cfar_ca_get_threshold(&so, spectrum, cut);
+    assert(t_so < t_ca && t_ca < t_go);
+
+    // GO keeps the low-side cell next to the edge quiet
+    cfar_detection_t detections[16];
+    assert(cfar_ca_process_frame(&go, spectrum, detections, 16) == 0);
+
+    // Edge bins with a single training block still get thresholds
+    assert(cfar_ca_get_threshold(&ca, spectrum, 0) > 0.0);
+    assert(cfar_ca_get_threshold(&so, spectrum, size - 1) > 0.0);
+
+    cfar_ca_free(&ca);
+    cfar_ca_free(&go);
+    cfar_ca_free(&so);
+    printf("✓ CFAR GO/SO clutter edge tests passed\n");
+}
+
+static void test_cfar_ca_external_thresholds(void) {
+    printf("Testing CFAR CA detection on external thresholds...\n");
+
+    const uint32_t size = 1024;
+    double *spectrum = generate_exponential_spectrum(size, 1.0, 7);
+    double *thresholds = malloc(size * sizeof(double));
+    cfar_detection_t *expected = malloc(size * sizeof(cfar_detection_t));
+    cfar_detection_t *actual = malloc(size * sizeof(cfar_detection_t));
+    assert(spectrum && thresholds && expected && actual);
+    spectrum[300] = 500.0;
+
+    cfar_ca_t cfar;
+    assert(cfar_ca_init(&cfar, size, 1e-3, 8, 1, CFAR_MODE_GO) == true);
+    uint32_t num_expected = cfar_ca_process_frame(&cfar, spectrum, expected, size);
+    memcpy(thresholds, cfar.thresholds, size * sizeof(double));
+    uint32_t num_actual = cfar_ca_detect_thresholds(&cfar, spectrum, thresholds, actual, size);
+    assert(num_actual == num_expected && num_actual > 0);
+    assert(memcmp(actual, expected, num_actual * sizeof(cfar_detection_t)) == 0);
+
+    // Raising every threshold above the tone leaves nothing
+    for (uint32_t i = 0; i < size; i++) thresholds[i] = 1000.0;
+    assert(cfar_ca_detect_thresholds(&cfar, spectrum, thresholds, actual, size) == 0);
+    assert(cfar_ca_detect_thresholds(&cfar, spectrum, NULL, actual, size) == 0);
+
+    cfar_ca_free(&cfar);
+    free(spectrum);
+    free(thresholds);
+    free(expected);
+    free(actual);
+    printf("✓ CFAR CA external threshold tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running CFAR CA Unit Tests\n");
+    printf("==========================\n\n");
+
+    test_cfar_ca_initialization();
+    test_cfar_ca_matches_direct_sum();
+    test_cfar_ca_false_alarm_rate();
+    test_cfar_ca_clutter_edge();
+    test_cfar_ca_external_thresholds();
+
+    printf("\n==========================\n");
+    printf("All CFAR CA tests passed! ✓\n");
+    printf("==========================\n");
+
+    return 0;
+}
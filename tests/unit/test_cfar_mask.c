@@ -0,0 +1,119 @@
+/*
+ * IQ Lab - CFAR Exceedance Mask Unit Tests
+ *
+ * The vectorized compare must produce exactly the scalar bitmask (including
+ * zero, negative and NaN cells and ragged frame lengths), and compaction
+ * must emit set bits in bin order and stop at max_detections.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/detect/cfar_mask.h"
+
+static uint32_t lcg_state = 12345u;
+
+static double next_uniform(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (lcg_state >> 8) / 16777216.0;
+}
+
+// Power and threshold rows with a sprinkling of awkward values
+static void fill_rows(double *power, double *threshold, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        power[i] = next_uniform() * 2.0;
+        threshold[i] = next_uniform();
+        switch (i % 17) {
+            case 3: threshold[i] = 0.0; break;
+            case 5: power[i] = -1.0; break;
+            case 7: power[i] = NAN; break;
+            case 11: threshold[i] = NAN; break;
+            case 13: power[i] = threshold[i]; break;
+            default: break;
+        }
+    }
+}
+
+static void test_mask_simd_matches_scalar(void) {
+    printf("Testing SIMD mask against scalar...\n");
+
+    const uint32_t sizes[] = {1, 63, 64, 65, 127, 1000, 4096};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t n = sizes[s];
+        double *power = malloc(n * sizeof(double));
+        double *threshold = malloc(n * sizeof(double));
+        uint64_t *simd = malloc(CFAR_MASK_WORDS(n) * sizeof(uint64_t));
+        uint64_t *scalar = malloc(CFAR_MASK_WORDS(n) * sizeof(uint64_t));
+        assert(power && threshold && simd && scalar);
+        fill_rows(power, threshold, n);
+
+        cfar_mask_force_scalar(false);
+        cfar_exceed_mask(power, threshold, n, simd);
+        cfar_mask_force_scalar(true);
+        cfar_exceed_mask(power, threshold, n, scalar);
+        cfar_mask_force_scalar(false);
+
+        assert(memcmp(simd, scalar, CFAR_MASK_WORDS(n) * sizeof(uint64_t)) == 0);
+
+        // Reference test, bit by bit
+        for (uint32_t i = 0; i < n; i++) {
+            bool expected = threshold[i] > 0.0 && power[i] > threshold[i];
+            bool got = (simd[i / 64] >> (i % 64)) & 1;
+            assert(expected == got);
+        }
+        if (n % 64) {
+            assert((simd[n / 64] >> (n % 64)) == 0);
+        }
+
+        free(power);
+        free(threshold);
+        free(simd);
+        free(scalar);
+    }
+
+    printf("✓ SIMD mask matches scalar\n");
+}
+
+static void test_compaction_order_and_limit(void) {
+    printf("Testing detection compaction...\n");
+
+    const uint32_t n = 200;
+    double power[200], threshold[200];
+    uint64_t mask[CFAR_MASK_WORDS(200)];
+    for (uint32_t i = 0; i < n; i++) {
+        threshold[i] = 1.0;
+        power[i] = 0.5;
+    }
+    const uint32_t hits[] = {0, 63, 64, 130, 199};
+    for (size_t h = 0; h < 5; h++) power[hits[h]] = 20.0 + (double)h;
+
+    cfar_exceed_mask(power, threshold, n, mask);
+
+    cfar_detection_t detections[8];
+    uint32_t count = cfar_compact_detections(power, threshold, mask, n, detections, 8);
+    assert(count == 5);
+    for (uint32_t h = 0; h < count; h++) {
+        assert(detections[h].bin_index == hits[h]);
+        assert(fabs(detections[h].signal_power - 10.0 * log10(power[hits[h]])) < 1e-12);
+        assert(detections[h].threshold == 0.0);
+        assert(detections[h].confidence == 1.0);
+    }
+
+    count = cfar_compact_detections(power, threshold, mask, n, detections, 3);
+    assert(count == 3);
+    assert(detections[2].bin_index == 64);
+
+    printf("✓ Compaction keeps bin order and honours the limit\n");
+}
+
+int main(void) {
+    printf("Running CFAR mask unit tests...\n\n");
+
+    test_mask_simd_matches_scalar();
+    test_compaction_order_and_limit();
+
+    printf("\n✅ All CFAR mask unit tests passed!\n");
+    return 0;
+}
@@ -12,6 +12,7 @@
 #include <math.h>
 #include <assert.h>
 #include "../../src/detect/cfar_os.h"
+#include "../../src/detect/cfar_mask.h"
 
 // Test data generation helpers
 static double *generate_noise_spectrum(uint32_t size, double noise_power) {
@@ -240,6 +241,250 @@ static void test_cfar_os_reset(void) {
     printf("✓ CFAR OS reset test passed\n");
 }
 
+static void test_cfar_os_sliding_window(void) {
+    printf("Testing CFAR OS sliding window against per-CUT selection...\n");
+
+    // Band edges, ties, zero cells and guard = 0 all change the window
+    const uint32_t configs[][3] = {{8, 1, 4}, {32, 2, 24}, {16, 0, 1}, {5, 5, 5}};
+    const uint32_t size = 4096;
+    double *spectrum = malloc(size * sizeof(double));
+    cfar_detection_t *detections = malloc(size * sizeof(cfar_detection_t));
+    assert(spectrum && detections);
+
+    uint32_t state = 987654321u;
+    for (uint32_t i = 0; i < size; i++) {
+        state = state * 1664525u + 1013904223u;
+        double u = ((state >> 8) + 1) / 16777217.0;
+        spectrum[i] = (i % 97 == 0) ? 0.0 : floor(-log(u) * 8.0) / 8.0;  // Quantized: many ties
+        if (i % 331 == 7) spectrum[i] = 500.0;
+    }
+
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        cfar_os_t cfar;
+        assert(cfar_os_init(&cfar, size, 1e-3, configs[c][0], configs[c][1], configs[c][2]) == true);
+
+        uint32_t num_detections = cfar_os_process_frame(&cfar, spectrum, detections, size);
+        uint32_t expected = 0;
+        for (uint32_t bin = 0; bin < size; bin++) {
+            double threshold = cfar_os_get_threshold(&cfar, spectrum, bin);
+            if (threshold <= 0.0 || spectrum[bin] <= threshold) continue;
+            assert(expected < num_detections);
+            assert(detections[expected].bin_index == bin);
+            assert(detections[expected].threshold == 10.0 * log10(threshold));
+            expected++;
+        }
+        assert(expected == num_detections);
+        assert(num_detections > 0);
+
+        cfar_os_free(&cfar);
+    }
+
+    free(spectrum);
+    free(detections);
+    printf("✓ CFAR OS sliding window test passed\n");
+}
+
+static void test_cfar_os_incremental(void) {
+    printf("Testing CFAR OS incremental mode against from-scratch frames...\n");
+
+    const uint32_t size = 4096, frames = 12;
+    double *spectrum = malloc(size * sizeof(double));
+    double *perturbed = malloc(size * sizeof(double));
+    cfar_detection_t *expected = malloc(size * sizeof(cfar_detection_t));
+    cfar_detection_t *detections = malloc(size * sizeof(cfar_detection_t));
+    assert(spectrum && perturbed && expected && detections);
+
+    uint32_t state = 24681357u;
+    for (uint32_t i = 0; i < size; i++) {
+        state = state * 1664525u + 1013904223u;
+        spectrum[i] = -log(((state >> 8) + 1) / 16777217.0);
+        if (i % 509 == 11) spectrum[i] = 300.0;
+    }
+
+    // Block L1: every SIMD length and tail agrees with the scalar sums
+    for (uint32_t n = 0; n <= 67; n++) {
+        double d_simd, n_simd, d_scalar, n_scalar;
+        cfar_mask_force_scalar(false);
+        cfar_block_l1(spectrum + 1, spectrum + 100, n, &d_simd, &n_simd);
+        cfar_mask_force_scalar(true);
+        cfar_block_l1(spectrum + 1, spectrum + 100, n, &d_scalar, &n_scalar);
+        assert(fabs(d_simd - d_scalar) <= 1e-12 * (1.0 + d_scalar));
+        assert(fabs(n_simd - n_scalar) <= 1e-12 * (1.0 + n_scalar));
+    }
+    cfar_mask_force_scalar(false);
+
+    cfar_os_t full, incremental;
+    assert(cfar_os_init(&full, size, 1e-3, 16, 2, 12) == true);
+    assert(cfar_os_init(&incremental, size, 1e-3, 16, 2, 12) == true);
+    assert(cfar_os_set_incremental(&incremental, 0, 0.0) == true);
+    assert(cfar_os_set_incremental(&incremental, 64, -1.0) == false);
+    assert(cfar_os_set_incremental(&incremental, 64, NAN) == false);
+    assert(cfar_os_set_incremental(&incremental, 64, 0.0) == true);
+
+    // Tolerance 0: each frame changes a few spans (at block edges, at the
+    // band edges, inside one block) and must match the full pass exactly
+    for (uint32_t f = 0; f < frames; f++) {
+        if (f > 0) {
+            uint32_t starts[] = {(f * 577) % size, 64 * f - 1, (f % 3 == 0) ? 0 : size - 5};
+            for (uint32_t s = 0; s < 3; s++) {
+                for (uint32_t i = starts[s]; i < starts[s] + 4 && i < size; i++) {
+                    spectrum[i] = (f % 2) ? 200.0 : 0.25 * spectrum[i] + 0.5;
+                }
+            }
+        }
+        uint32_t want = cfar_os_process_frame(&full, spectrum, expected, size);
+        uint32_t got = cfar_os_process_frame(&incremental, spectrum, detections, size);
+        assert(got == want);
+        for (uint32_t d = 0; d < got; d++) {
+            assert(detections[d].bin_index == expected[d].bin_index);
+            assert(detections[d].threshold == expected[d].threshold);
+            assert(detections[d].signal_power == expected[d].signal_power);
+        }
+    }
+    assert(incremental.blocks_checked == (uint64_t)(frames - 1) * (size / 64));
+    assert(incremental.blocks_kept > incremental.blocks_checked / 2);
+    assert(incremental.blocks_kept < incremental.blocks_checked);
+
+    // A small tolerance keeps a slightly perturbed static spectrum...
+    assert(cfar_os_set_incremental(&incremental, 64, 0.01) == true);
+    cfar_os_process_frame(&incremental, spectrum, detections, size);
+    for (uint32_t i = 0; i < size; i++) perturbed[i] = spectrum[i] * (1.0 + 1e-4 * (i % 7));
+    cfar_os_process_frame(&incremental, perturbed, detections, size);
+    assert(incremental.blocks_checked == size / 64);
+    assert(incremental.blocks_kept == size / 64);
+
+    // ...but a new tone in a kept block is still found, with fresh thresholds
+    perturbed[2000] = 300.0;
+    uint32_t got = cfar_os_process_frame(&incremental, perturbed, detections, size);
+    assert(incremental.blocks_kept == 2 * (size / 64) - 1);
+    bool found = false;
+    for (uint32_t d = 0; d < got; d++) found |= detections[d].bin_index == 2000;
+    assert(found);
+
+    // Reset forgets the references: the next frame is a full pass
+    cfar_os_reset(&incremental);
+    assert(incremental.reference_valid == false && incremental.blocks_checked == 0);
+    cfar_os_process_frame(&incremental, perturbed, detections, size);
+    assert(incremental.blocks_checked == 0 && incremental.reference_valid == true);
+
+    cfar_os_free(&full);
+    cfar_os_free(&incremental);
+    free(spectrum);
+    free(perturbed);
+    free(expected);
+    free(detections);
+    printf("✓ CFAR OS incremental test passed\n");
+}
+
+// Exponential (chi-squared, 2 DOF) noise of unit mean
+static void fill_exponential(double *spectrum, uint32_t size, uint32_t *state) {
+    for (uint32_t i = 0; i < size; i++) {
+        *state = *state * 1664525u + 1013904223u;
+        spectrum[i] = -log(((*state >> 8) + 1) / 16777217.0);
+    }
+}
+
+static void test_cfar_os_approximate(void) {
+    printf("Testing CFAR OS approximate (histogram) mode...\n");
+
+    const uint32_t size = 4096;
+    const double bound = pow(10.0, CFAR_OS_HIST_DEFAULT_DB / 10.0);
+    double *spectrum = malloc(size * sizeof(double));
+    double *exact_row = malloc(size * sizeof(double));
+    cfar_detection_t *detections = malloc(size * sizeof(cfar_detection_t));
+    assert(spectrum && exact_row && detections);
+
+    cfar_os_t exact, approx;
+    assert(cfar_os_init(&approx, size, 1e-3, 16, 2, 12) == true);
+    assert(cfar_os_set_approximate(&approx, -0.1) == false);
+    assert(cfar_os_set_approximate(&approx, 0.001) == false);
+    assert(cfar_os_set_approximate(&approx, 5.0) == false);
+    assert(cfar_os_set_approximate(&approx, NAN) == false);
+    assert(approx.hist_bins == 0);
+    cfar_os_free(&approx);
+
+    // Every threshold lies in [exact, exact + bin width), for narrow and very
+    // wide windows, across 100 dB of power, zeros and band edges included
+    const uint32_t refs[3] = {16, 200, 1000};
+    uint32_t state = 97531u;
+    for (uint32_t r = 0; r < 3; r++) {
+        uint32_t ref = refs[r], rank = ref * 3 / 4;
+        assert(cfar_os_init(&exact, size, 1e-3, ref, 2, rank) == true);
+        assert(cfar_os_init(&approx, size, 1e-3, ref, 2, rank) == true);
+        assert(cfar_os_set_approximate(&approx, CFAR_OS_HIST_DEFAULT_DB) == true);
+
+        fill_exponential(spectrum, size, &state);
+        for (uint32_t i = 0; i < size; i++) spectrum[i] *= pow(10.0, 5.0 * sin(i / 300.0));
+        for (uint32_t i = 0; i < size; i += 97) spectrum[i] = 0.0;
+        spectrum[size / 3] = 1e9;
+
+        cfar_os_process_frame(&exact, spectrum, detections, size);
+        cfar_os_process_frame(&approx, spectrum, detections, size);
+        for (uint32_t i = 0; i < size; i++) {
+            double t = exact.thresholds[i], a = approx.thresholds[i];
+            assert((t == 0.0) == (a == 0.0));
+            assert(a >= t * (1.0 - 1e-12) && a <= t * bound * (1.0 + 1e-12));
+        }
+        cfar_os_free(&exact);
+        cfar_os_free(&approx);
+    }
+
+    // Pfa on noise: with thresholds never below the exact ones (nor above
+    // them by the bin width) the false alarms are bracketed by the exact
+    // detector's, and they match exp(-threshold), the exceedance
+    // probability of unit exponential noise, summed over the cells
+    const uint32_t frames = 50;
+    assert(cfar_os_init(&exact, size, 1e-6, 128, 2, 8) == true);
+    assert(cfar_os_init(&approx, size, 1e-6, 128, 2, 8) == true);
+    assert(cfar_os_set_approximate(&approx, CFAR_OS_HIST_DEFAULT_DB) == true);
+    uint32_t exact_alarms = 0, approx_alarms = 0, raised_alarms = 0, cells = 0;
+    double expected = 0.0;
+    for (uint32_t f = 0; f < frames; f++) {
+        fill_exponential(spectrum, size, &state);
+        exact_alarms += cfar_os_process_frame(&exact, spectrum, detections, size);
+        approx_alarms += cfar_os_process_frame(&approx, spectrum, detections, size);
+        memcpy(exact_row, exact.thresholds, size * sizeof(double));
+        for (uint32_t i = 0; i < size; i++) {
+            if (exact_row[i] == 0.0) continue;
+            cells++;
+            raised_alarms += spectrum[i] > exact_row[i] * bound;
+            expected += exp(-approx.thresholds[i]);
+        }
+    }
+    double pfa = (double)approx_alarms / cells;
+    double sigma = sqrt(expected);
+    assert(approx_alarms <= exact_alarms && approx_alarms >= raised_alarms);
+    assert(fabs(approx_alarms - expected) < 5.0 * sigma);
+    assert(approx_alarms > 100);  // Enough alarms for the checks to mean something
+    cfar_os_free(&exact);
+
+    // Combines with the incremental mode, and switches back to exact rows
+    cfar_os_t both;
+    assert(cfar_os_init(&both, size, 1e-6, 128, 2, 8) == true);
+    assert(cfar_os_set_approximate(&both, CFAR_OS_HIST_DEFAULT_DB) == true);
+    assert(cfar_os_set_incremental(&both, 64, 0.0) == true);
+    for (uint32_t f = 0; f < 3; f++) {
+        if (f > 0) for (uint32_t i = 1000 * f; i < 1000 * f + 8; i++) spectrum[i] = 50.0;
+        cfar_os_process_frame(&approx, spectrum, detections, size);
+        cfar_os_process_frame(&both, spectrum, detections, size);
+        assert(memcmp(approx.thresholds, both.thresholds, size * sizeof(double)) == 0);
+    }
+    assert(both.blocks_kept > 0);
+    assert(cfar_os_init(&exact, size, 1e-6, 128, 2, 8) == true);
+    assert(cfar_os_set_approximate(&approx, 0.0) == true && approx.hist_bins == 0);
+    cfar_os_process_frame(&exact, spectrum, detections, size);
+    cfar_os_process_frame(&approx, spectrum, detections, size);
+    assert(memcmp(exact.thresholds, approx.thresholds, size * sizeof(double)) == 0);
+
+    cfar_os_free(&exact);
+    cfar_os_free(&approx);
+    cfar_os_free(&both);
+    free(spectrum);
+    free(exact_row);
+    free(detections);
+    printf("✓ CFAR OS approximate test passed (Pfa %.2e over %u cells)\n", pfa, cells);
+}
+
 // Main test runner
 int main(int argc, char **argv) {
     (void)argc; // Suppress unused parameter warning
@@ -254,6 +499,9 @@ int main(int argc, char **argv) {
     test_cfar_os_threshold_calculation();
     test_cfar_os_config_string();
     test_cfar_os_reset();
+    test_cfar_os_sliding_window();
+    test_cfar_os_incremental();
+    test_cfar_os_approximate();
 
     printf("\n==========================\n");
     printf("All CFAR OS tests passed! ✓\n");
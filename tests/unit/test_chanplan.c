@@ -0,0 +1,260 @@
+/*
+ * IQ Lab - Channel Plan Unit Tests
+ *
+ * Tests for the non-uniform channel plan: flow, block and bare-list plan
+ * files parse (RF centers, suffixes, default rates) and malformed ones are
+ * rejected; a grid of narrow channels, and a channel between its bins,
+ * share one bank while a wide outlier and a lone channel keep their own
+ * decimators, for less than running every channel alone; and the runner
+ * puts a tone into its own channel at the channel's rate, whatever the
+ * input block sizes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <assert.h>
+#include "../../src/chan/chanplan.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static bool parses(const char *text) {
+    chanplan_t plan;
+    char error[256];
+    bool ok = chanplan_parse(&plan, text, strlen(text), error, sizeof(error));
+    if (ok) chanplan_free(&plan);
+    return ok;
+}
+
+static void test_chanplan_parse(void) {
+    printf("Testing plan parsing...\n");
+
+    const char *text =
+        "# Mixed plan\n"
+        "center_frequency: 851M\n"
+        "channels:\n"
+        "  - { name: dispatch, center: 851.0125M, bandwidth: 12.5k }\n"
+        "  - center: 851.2e6\n"
+        "    bandwidth: 200e3\n"
+        "    rate: 250000\n"
+        "  - {center: 850.9M, bandwidth: 25k, name: \"car 54\"}\n";
+    chanplan_t plan;
+    char error[256];
+    assert(chanplan_parse(&plan, text, strlen(text), error, sizeof(error)));
+    assert(plan.num_channels == 3);
+    assert(plan.center_frequency == 851e6);
+    assert(strcmp(plan.channels[0].name, "dispatch") == 0);
+    assert(fabs(plan.channels[0].center - 12500.0) < 1e-3);
+    assert(plan.channels[0].bandwidth == 12500.0);
+    assert(plan.channels[0].rate == 15625);              // bandwidth / CHANPLAN_USABLE
+    assert(plan.channels[1].name[0] == '\0');
+    assert(fabs(plan.channels[1].center - 200e3) < 1e-3);
+    assert(plan.channels[1].rate == 250000);
+    assert(strcmp(plan.channels[2].name, "car 54") == 0);
+    assert(fabs(plan.channels[2].center + 100e3) < 1e-3);
+    chanplan_free(&plan);
+
+    // A bare list of offsets
+    assert(parses("- {center: -100k, bandwidth: 25k}\n- center: 0\n  bandwidth: 8k\n"));
+
+    assert(!parses(""));
+    assert(!parses("channels:\n"));
+    assert(!parses("channels:\n  - {center: 1k}\n"));
+    assert(!parses("channels:\n  - {center: 1k, bandwidth: 10k, color: red}\n"));
+    assert(!parses("channels:\n  - {center: 1k, bandwidth: 10k, rate: 5k}\n"));
+    assert(!parses("channels:\n  - {center: 1k, bandwidth: -10k}\n"));
+    assert(!parses("channels:\n  - {center: one, bandwidth: 10k}\n"));
+    assert(!parses("band: vhf\n"));
+    assert(!chanplan_load(&plan, "/nonexistent/plan.yaml", error, sizeof(error)));
+
+    printf("✓ Parsing tests passed\n");
+}
+
+static void test_chanplan_design(void) {
+    printf("Testing realization choice...\n");
+
+    // Twenty-four 12.5 kHz channels on a grid, a 200 kHz outlier and one
+    // 25 kHz channel off the grid
+    const double fs = 2400000.0;
+    char text[4096];
+    size_t used = (size_t)snprintf(text, sizeof(text), "channels:\n");
+    for (int i = 0; i < 24; i++) {
+        used += (size_t)snprintf(text + used, sizeof(text) - used,
+                                 "  - {center: %d, bandwidth: 12500}\n", -450000 + 12500 * i);
+    }
+    used += (size_t)snprintf(text + used, sizeof(text) - used,
+                             "  - {center: 700000, bandwidth: 200000}\n"
+                             "  - {center: 410000, bandwidth: 25000}\n");
+
+    chanplan_t plan;
+    char error[256];
+    assert(chanplan_parse(&plan, text, used, error, sizeof(error)));
+    assert(chanplan_design(&plan, fs, error, sizeof(error)));
+
+    assert(plan.num_banks == 1);
+    assert(plan.banks[0].num_members == 25);
+    assert(plan.banks[0].config.oversampling == 2);
+    for (int i = 0; i < 26; i++) {
+        if (i == 24) continue;
+        const chanplan_channel_t *channel = &plan.channels[i];
+        assert(channel->path == CHANPLAN_PFB && channel->bank == 0);
+        double spacing = fs / plan.banks[0].config.num_channels;
+        double bin_center = ((double)channel->bin - plan.banks[0].config.num_channels / 2.0) * spacing;
+        assert(fabs(bin_center + channel->residual - channel->center) < 1e-6);
+        assert(fabs(channel->residual) + channel->bandwidth / 2.0 <= CHANPLAN_BIN_REACH * spacing + 1e-6);
+    }
+    assert(plan.channels[24].path == CHANPLAN_XLATE);
+    assert(fs / plan.channels[24].decimation >= plan.channels[24].rate);
+    assert(plan.total_cost > 0.0 && plan.total_cost < plan.individual_cost);
+
+    // Redesigning keeps one consistent plan
+    assert(chanplan_design(&plan, fs, error, sizeof(error)));
+    assert(plan.num_banks == 1);
+    chanplan_free(&plan);
+
+    // One channel alone is cheaper on its own decimator
+    const char *lone = "- {center: 10k, bandwidth: 12.5k}\n";
+    assert(chanplan_parse(&plan, lone, strlen(lone), error, sizeof(error)));
+    assert(chanplan_design(&plan, fs, error, sizeof(error)));
+    assert(plan.num_banks == 0 && plan.channels[0].path == CHANPLAN_XLATE);
+    assert(fabs(plan.total_cost - plan.individual_cost) < 1e-9);
+    chanplan_free(&plan);
+
+    // Outside the capture
+    const char *outside = "- {center: 1.15M, bandwidth: 200k}\n";
+    assert(chanplan_parse(&plan, outside, strlen(outside), error, sizeof(error)));
+    assert(!chanplan_design(&plan, fs, error, sizeof(error)));
+    chanplan_free(&plan);
+
+    printf("✓ Design tests passed\n");
+}
+
+// Every channel's outputs, appended
+typedef struct {
+    float complex *samples[32];
+    uint32_t counts[32];
+    uint32_t capacity;
+} collect_t;
+
+static bool collect(uint32_t channel, const float complex *samples, uint32_t count, void *user) {
+    collect_t *out = user;
+    assert(channel < 32 && out->counts[channel] + count <= out->capacity);
+    memcpy(out->samples[channel] + out->counts[channel], samples, count * sizeof(float complex));
+    out->counts[channel] += count;
+    return true;
+}
+
+static double mean_power(const float complex *x, uint32_t from, uint32_t to) {
+    double sum = 0.0;
+    for (uint32_t i = from; i < to; i++) sum += crealf(x[i]) * crealf(x[i]) + cimagf(x[i]) * cimagf(x[i]);
+    return sum / (to - from);
+}
+
+static void run_plan(const chanplan_t *plan, const float complex *x, uint32_t n, uint32_t block,
+                     collect_t *out) {
+    chanplan_runner_t *runner = chanplan_runner_create(plan);
+    assert(runner);
+    for (uint32_t offset = 0; offset < n; offset += block) {
+        uint32_t count = n - offset < block ? n - offset : block;
+        assert(chanplan_runner_process(runner, x + offset, count, collect, out));
+    }
+    chanplan_runner_destroy(runner);
+}
+
+static void test_chanplan_runner(void) {
+    printf("Testing the runner...\n");
+
+    // Twenty-four 12.5 kHz channels on a bank, a 100 kHz outlier on its own
+    const double fs = 1200000.0;
+    const uint32_t outlier = 24;
+    char text[4096];
+    size_t used = (size_t)snprintf(text, sizeof(text), "channels:\n");
+    for (uint32_t i = 0; i < outlier; i++) {
+        used += (size_t)snprintf(text + used, sizeof(text) - used,
+                                 "  - {center: %.1f, bandwidth: 12.5k}\n", -300000.0 + 12500.0 * i);
+    }
+    used += (size_t)snprintf(text + used, sizeof(text) - used,
+                             "  - {center: 310k, bandwidth: 100k, rate: 120k}\n");
+    chanplan_t plan;
+    char error[256];
+    assert(chanplan_parse(&plan, text, used, error, sizeof(error)));
+    assert(chanplan_design(&plan, fs, error, sizeof(error)));
+    assert(plan.num_banks == 1 && plan.channels[outlier].path == CHANPLAN_XLATE);
+    assert(plan.channels[2].path == CHANPLAN_PFB);
+
+    // Tones 2 kHz above channel 2 and 20 kHz above the outlier
+    const uint32_t n = 240000;
+    float complex *x = malloc(n * sizeof(float complex));
+    assert(x);
+    for (uint32_t i = 0; i < n; i++) {
+        double t = i / fs;
+        x[i] = (float complex)(0.5 * cexp(2.0 * M_PI * I * -273000.0 * t) +
+                               0.5 * cexp(2.0 * M_PI * I * 330000.0 * t));
+    }
+
+    collect_t a = {.capacity = n}, b = {.capacity = n};
+    for (uint32_t c = 0; c < plan.num_channels; c++) {
+        a.samples[c] = malloc(n * sizeof(float complex));
+        b.samples[c] = malloc(n * sizeof(float complex));
+        assert(a.samples[c] && b.samples[c]);
+    }
+    run_plan(&plan, x, n, 4096, &a);
+    run_plan(&plan, x, n, 1000, &b);
+
+    for (uint32_t c = 0; c < plan.num_channels; c++) {
+        // Outputs at the channel's own rate; the same for any block split
+        double expected = (double)n * plan.channels[c].rate / fs;
+        assert(fabs(a.counts[c] - expected) < 0.02 * expected + 64);
+        assert(a.counts[c] == b.counts[c]);
+        assert(memcmp(a.samples[c], b.samples[c], a.counts[c] * sizeof(float complex)) == 0);
+    }
+
+    // Each tone sits in its own channel, at 0.5 amplitude after the filters settle
+    for (uint32_t c = 0; c < plan.num_channels; c++) {
+        uint32_t count = a.counts[c];
+        double power = mean_power(a.samples[c], count / 2, count);
+        if (c == 2 || c == outlier) {
+            assert(fabs(10.0 * log10(power / 0.25)) < 1.0);
+        } else {
+            assert(10.0 * log10(power / 0.25 + 1e-30) < -40.0);
+        }
+    }
+
+    // The tone lands at its offset from the channel center: 2 kHz in channel 2
+    uint32_t count = a.counts[2];
+    double phase_step = 0.0;
+    for (uint32_t i = count / 2 + 1; i < count; i++) {
+        phase_step += carg(a.samples[2][i] * conjf(a.samples[2][i - 1]));
+    }
+    phase_step /= count - count / 2 - 1;
+    double tone = phase_step * plan.channels[2].rate / (2.0 * M_PI);
+    assert(fabs(tone - 2000.0) < 5.0);
+
+    for (uint32_t c = 0; c < plan.num_channels; c++) {
+        free(a.samples[c]);
+        free(b.samples[c]);
+    }
+    free(x);
+    chanplan_free(&plan);
+
+    printf("✓ Runner tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running Channel Plan Unit Tests\n");
+    printf("===============================\n\n");
+
+    test_chanplan_parse();
+    test_chanplan_design();
+    test_chanplan_runner();
+
+    printf("\n===============================\n");
+    printf("All channel plan tests passed! ✓\n");
+    printf("===============================\n");
+    return 0;
+}
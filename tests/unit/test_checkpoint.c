@@ -0,0 +1,256 @@
+/*
+ * IQ Lab - Checkpoint Unit Tests
+ *
+ * Tests for checkpoint.h: sections read back as written, damaged and
+ * foreign files rejected, a failed checkpoint leaving the previous one in
+ * place, outputs cut back to their recorded size, and a detector restored
+ * mid-stream carrying on exactly like an uninterrupted one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../../src/iq_core/checkpoint.h"
+#include "../../src/detect/energy_gate.h"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+#define CHECKPOINT_PATH "test_checkpoint.ckpt"
+#define OUTPUT_PATH "test_checkpoint.out"
+
+static bool write_sample(const char *path, uint64_t position) {
+    checkpoint_writer_t writer;
+    double values[3] = { 1.5, -2.25, 1e300 };
+    char odd[5] = "abcd";
+    if (!checkpoint_begin(&writer, path, "test")) return false;
+    bool ok = checkpoint_put(&writer, "position", &position, sizeof(position)) &&
+              checkpoint_put(&writer, "values", values, sizeof(values)) &&
+              checkpoint_put(&writer, "odd", odd, sizeof(odd)) &&
+              checkpoint_put(&writer, "empty", NULL, 0);
+    if (!ok) {
+        checkpoint_abort(&writer);
+        return false;
+    }
+    return checkpoint_commit(&writer);
+}
+
+static void test_round_trip(void) {
+    TEST_START("Sections read back as written");
+
+    checkpoint_t cp;
+    uint64_t position = 0;
+    double values[3] = {0};
+    char odd[5] = {0};
+    size_t size = 99;
+    bool ok = write_sample(CHECKPOINT_PATH, 123456789012ull) &&
+              checkpoint_load(&cp, CHECKPOINT_PATH, "test");
+    if (!ok) {
+        TEST_FAIL("write or load failed");
+        TEST_END();
+        return;
+    }
+
+    if (!checkpoint_get(&cp, "position", &position, sizeof(position)) || position != 123456789012ull) {
+        TEST_FAIL("position section wrong");
+    } else if (!checkpoint_get(&cp, "values", values, sizeof(values)) ||
+               values[0] != 1.5 || values[1] != -2.25 || values[2] != 1e300) {
+        TEST_FAIL("values section wrong");
+    } else if (!checkpoint_get(&cp, "odd", odd, sizeof(odd)) || strcmp(odd, "abcd") != 0) {
+        TEST_FAIL("unpadded section wrong");
+    } else if (!checkpoint_find(&cp, "empty", &size) || size != 0) {
+        TEST_FAIL("empty section missing");
+    } else if (checkpoint_find(&cp, "missing", NULL) ||
+               checkpoint_get(&cp, "values", values, sizeof(values) - 1)) {
+        TEST_FAIL("missing tag or wrong size accepted");
+    } else {
+        TEST_PASS();
+    }
+    checkpoint_free(&cp);
+    TEST_END();
+}
+
+static void test_rejected(void) {
+    TEST_START("Damaged and foreign checkpoints are rejected");
+
+    checkpoint_t cp;
+    bool foreign = !write_sample(CHECKPOINT_PATH, 7) || checkpoint_load(&cp, CHECKPOINT_PATH, "other");
+
+    // Flip one payload byte
+    FILE *file = fopen(CHECKPOINT_PATH, "r+b");
+    bool flipped = false;
+    if (file && fseek(file, -12, SEEK_END) == 0) {
+        int c = fgetc(file);
+        flipped = c != EOF && fseek(file, -1, SEEK_CUR) == 0 && fputc(c ^ 0x40, file) != EOF;
+    }
+    if (file) fclose(file);
+    bool damaged = !flipped || checkpoint_load(&cp, CHECKPOINT_PATH, "test");
+
+    // Cut short
+    FILE *cut = write_sample(CHECKPOINT_PATH, 7) ? checkpoint_reopen_output(CHECKPOINT_PATH, 80) : NULL;
+    if (cut) fclose(cut);
+    bool truncated = !cut || checkpoint_load(&cp, CHECKPOINT_PATH, "test");
+
+    if (foreign) {
+        TEST_FAIL("another tool's checkpoint loaded");
+    } else if (damaged) {
+        TEST_FAIL("damaged checkpoint loaded");
+    } else if (truncated) {
+        TEST_FAIL("truncated checkpoint loaded");
+    } else if (checkpoint_load(&cp, "test_checkpoint.none", "test")) {
+        TEST_FAIL("missing checkpoint loaded");
+    } else {
+        TEST_PASS();
+    }
+    TEST_END();
+}
+
+static void test_failed_keeps_previous(void) {
+    TEST_START("A failed checkpoint keeps the previous one");
+
+    checkpoint_writer_t writer;
+    char long_tag[CHECKPOINT_TAG_LEN + 2];
+    memset(long_tag, 'x', sizeof(long_tag) - 1);
+    long_tag[sizeof(long_tag) - 1] = '\0';
+    uint64_t position = 1;
+
+    bool ok = write_sample(CHECKPOINT_PATH, 42) && checkpoint_begin(&writer, CHECKPOINT_PATH, "test") &&
+              checkpoint_put(&writer, "position", &position, sizeof(position));
+    bool rejected = ok && !checkpoint_put(&writer, long_tag, &position, sizeof(position)) &&
+                    !checkpoint_commit(&writer);
+
+    checkpoint_t cp;
+    position = 0;
+    bool kept = checkpoint_load(&cp, CHECKPOINT_PATH, "test") &&
+                checkpoint_get(&cp, "position", &position, sizeof(position)) && position == 42;
+    checkpoint_free(&cp);
+
+    FILE *temp = fopen(CHECKPOINT_PATH ".tmp", "rb");
+    if (temp) fclose(temp);
+
+    if (!ok || !rejected) {
+        TEST_FAIL("overlong tag accepted");
+    } else if (!kept) {
+        TEST_FAIL("previous checkpoint lost");
+    } else if (temp) {
+        TEST_FAIL("temporary file left behind");
+    } else {
+        TEST_PASS();
+    }
+    TEST_END();
+}
+
+static void test_reopen_output(void) {
+    TEST_START("Outputs are cut back to the recorded size");
+
+    FILE *out = fopen(OUTPUT_PATH, "wb");
+    uint64_t bytes = 0;
+    bool ok = out && fputs("first line\n", out) >= 0 && checkpoint_sync_output(out, &bytes) &&
+              fputs("lost after the checkpoint\n", out) >= 0;
+    if (out) fclose(out);
+
+    // Carry on from the checkpoint
+    out = ok ? checkpoint_reopen_output(OUTPUT_PATH, bytes) : NULL;
+    ok = out && fputs("second line\n", out) >= 0;
+    if (out) fclose(out);
+
+    char text[64] = {0};
+    FILE *in = fopen(OUTPUT_PATH, "rb");
+    size_t n = in ? fread(text, 1, sizeof(text) - 1, in) : 0;
+    if (in) fclose(in);
+
+    if (!ok || bytes != 11) {
+        TEST_FAIL("sync or reopen failed");
+    } else if (n != 23 || strcmp(text, "first line\nsecond line\n") != 0) {
+        TEST_FAIL("output not resumed at the recorded size");
+    } else if (checkpoint_reopen_output(OUTPUT_PATH, 1000)) {
+        TEST_FAIL("reopened past the end of a shorter output");
+    } else {
+        TEST_PASS();
+    }
+    TEST_END();
+}
+
+static void test_module_state(void) {
+    TEST_START("A restored gate carries on like an uninterrupted one");
+
+    enum { FRAMES = 400, FRAME = 256, HOP = 64, SPLIT = 173 };
+    static int16_t samples[FRAMES][2 * FRAME];
+    uint32_t seed = 1;
+    for (int f = 0; f < FRAMES; f++) {
+        int amplitude = (f / 40) % 3 == 1 ? 3000 : 100;
+        for (int i = 0; i < 2 * FRAME; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            samples[f][i] = (int16_t)((int32_t)(seed >> 16) % amplitude);
+        }
+    }
+
+    energy_gate_t whole, first, second;
+    bool ok = energy_gate_init(&whole, 6.0, 32, 2) && energy_gate_init(&first, 6.0, 32, 2) &&
+              energy_gate_init(&second, 6.0, 32, 2);
+    bool same = ok;
+    for (int f = 0; ok && f < SPLIT; f++) {
+        same = same && energy_gate_frame(&whole, samples[f], 16, FRAME, HOP) ==
+                       energy_gate_frame(&first, samples[f], 16, FRAME, HOP);
+    }
+
+    checkpoint_writer_t writer;
+    checkpoint_t cp;
+    ok = ok && checkpoint_begin(&writer, CHECKPOINT_PATH, "test") &&
+         energy_gate_save_state(&first, &writer) && checkpoint_commit(&writer) &&
+         checkpoint_load(&cp, CHECKPOINT_PATH, "test") && energy_gate_load_state(&second, &cp);
+    if (ok) checkpoint_free(&cp);
+
+    for (int f = SPLIT; ok && f < FRAMES; f++) {
+        same = same && energy_gate_frame(&whole, samples[f], 16, FRAME, HOP) ==
+                       energy_gate_frame(&second, samples[f], 16, FRAME, HOP);
+    }
+
+    if (!ok) {
+        TEST_FAIL("save or load failed");
+    } else if (!same || whole.frames != second.frames || whole.active_frames != second.active_frames ||
+               whole.floor != second.floor) {
+        TEST_FAIL("restored gate diverged");
+    } else {
+        TEST_PASS();
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Checkpoint Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_round_trip();
+    test_rejected();
+    test_failed_keeps_previous();
+    test_reopen_output();
+    test_module_state();
+
+    remove(CHECKPOINT_PATH);
+    remove(OUTPUT_PATH);
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -256,6 +256,155 @@ static void test_cluster_reset(void) {
     printf("✓ Cluster reset test passed\n");
 }
 
+static void test_cluster_many_channels(void) {
+    printf("Testing cluster index with many simultaneous channels...\n");
+
+    cluster_t cluster;
+    bool result = cluster_init(&cluster, 50.0, 5.0, 1000, 2000000.0);
+    assert(result == true);
+
+    // 300 channels 40 bins apart, channel ch starting at frame ch % 7
+    const uint32_t channels = 300;
+    for (uint32_t frame = 0; frame < 20; frame++) {
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            if (frame < ch % 7) continue;
+            cfar_detection_t detection = {.bin_index = ch * 40 + frame % 2, .snr_estimate = 12.0,
+                                          .signal_power = -30.0, .threshold = -42.0, .confidence = 0.8};
+            result = cluster_add_detection(&cluster, &detection, frame * 0.01);
+            assert(result == true);
+        }
+    }
+    assert(cluster_get_active_count(&cluster) == channels);
+
+    // Nothing idle yet at the last frame
+    cluster_event_t events[400];
+    assert(cluster_get_events(&cluster, events, 400, 0.19) == 0);
+
+    // Partial extraction keeps the rest for the next call
+    uint32_t first = cluster_get_events(&cluster, events, 100, 2.0);
+    assert(first == 100);
+    assert(cluster_get_active_count(&cluster) == channels - 100);
+    uint32_t rest = cluster_get_events(&cluster, events + first, 400 - first, 2.0);
+    assert(rest == channels - 100);
+    assert(cluster_get_active_count(&cluster) == 0);
+
+    // Each batch is ordered by start time, and every channel appears once
+    bool seen[300] = {false};
+    for (uint32_t i = 0; i < channels; i++) {
+        if (i != 0 && i != first) assert(events[i - 1].start_time_s <= events[i].start_time_s);
+        uint32_t ch = events[i].min_bin / 40;
+        assert(ch < channels && !seen[ch]);
+        assert(events[i].num_detections == 20 - ch % 7);
+        seen[ch] = true;
+    }
+
+    cluster_free(&cluster);
+    printf("✓ Cluster many-channel index test passed\n");
+}
+
+static void test_cluster_merge(void) {
+    printf("Testing cluster merge of converging clusters...\n");
+
+    cluster_t cluster;
+    bool result = cluster_init(&cluster, 50.0, 10.0, 10, 2000000.0);
+    assert(result == true);
+
+    // Two clusters 12 bins apart: separate
+    cfar_detection_t a = {.bin_index = 100, .snr_estimate = 10.0, .signal_power = -30.0};
+    cfar_detection_t b = {.bin_index = 112, .snr_estimate = 20.0, .signal_power = -20.0};
+    assert(cluster_add_detection(&cluster, &a, 0.00));
+    assert(cluster_add_detection(&cluster, &b, 0.00));
+    assert(cluster_get_active_count(&cluster) == 2);
+
+    // Pulling the first centre to within the gap merges them
+    cfar_detection_t c = {.bin_index = 108, .snr_estimate = 10.0, .signal_power = -30.0};
+    assert(cluster_add_detection(&cluster, &c, 0.01));
+    assert(cluster_get_active_count(&cluster) == 1);
+
+    cluster_event_t events[2];
+    assert(cluster_get_events(&cluster, events, 2, 1.0) == 1);
+    assert(events[0].num_detections == 3);
+    assert(events[0].min_bin == 100 && events[0].max_bin == 112);
+    assert(events[0].peak_snr_db == 20.0);
+
+    // Feature moments of both clusters survive the merge
+    const features_accum_t *acc = &events[0].features;
+    assert(acc->count == 3);
+    assert(acc->min_bin == 100 && acc->max_bin == 112);
+    assert(fabs(acc->peak_power - 1e-2) < 1e-12);
+    assert(fabs(acc->log_power_sum - (-80.0)) < 1e-9);
+
+    // Clusters too short to report are dropped once idle
+    assert(cluster_add_detection(&cluster, &a, 2.0));
+    assert(cluster_get_events(&cluster, events, 2, 3.0) == 0);
+    assert(cluster_get_active_count(&cluster) == 0);
+
+    cluster_free(&cluster);
+    printf("✓ Cluster merge test passed\n");
+}
+
+// Event sink collecting into a fixed array
+typedef struct {
+    cluster_event_t events[256];
+    uint32_t count;
+} sink_capture_t;
+
+static void capture_event(const cluster_event_t *event, void *user) {
+    sink_capture_t *capture = user;
+    assert(capture->count < 256);
+    capture->events[capture->count++] = *event;
+}
+
+static void test_cluster_event_sink(void) {
+    printf("Testing streaming event sink...\n");
+
+    cluster_t cluster;
+    bool result = cluster_init(&cluster, 50.0, 5.0, 1000, 2000000.0);
+    assert(result == true);
+
+    static sink_capture_t capture;
+    capture.count = 0;
+    cluster_set_event_sink(&cluster, capture_event, &capture);
+
+    // 120 channels that all stop at t = 0.04; channel 0 keeps going
+    for (uint32_t frame = 0; frame < 10; frame++) {
+        double t = frame * 0.01;
+        for (uint32_t ch = 0; ch < 120; ch++) {
+            if (ch != 0 && frame > 4) continue;
+            cfar_detection_t detection = {.bin_index = ch * 40, .snr_estimate = 12.0, .signal_power = -30.0};
+            assert(cluster_add_detection(&cluster, &detection, t));
+        }
+
+        // Gap is 50 ms: the stopped channels are not idle long enough yet
+        assert(cluster_advance(&cluster, t) == 0);
+    }
+    assert(capture.count == 0);
+
+    // First advance past the gap emits all 119 at once, well over 50
+    assert(cluster_advance(&cluster, 0.0901) == 119);
+    assert(capture.count == 119);
+    assert(cluster_get_active_count(&cluster) == 1);
+    for (uint32_t i = 0; i < capture.count; i++) {
+        assert(capture.events[i].num_detections == 5);
+        assert(capture.events[i].min_bin != 0);
+    }
+
+    // End-of-stream flush closes the channel still running
+    assert(cluster_advance(&cluster, INFINITY) == 1);
+    assert(capture.count == 120);
+    assert(capture.events[119].min_bin == 0 && capture.events[119].num_detections == 10);
+
+    // Without a sink, advance does nothing
+    cluster_set_event_sink(&cluster, NULL, NULL);
+    cfar_detection_t detection = {.bin_index = 7, .snr_estimate = 12.0, .signal_power = -30.0};
+    assert(cluster_add_detection(&cluster, &detection, 5.0));
+    assert(cluster_advance(&cluster, INFINITY) == 0);
+    assert(cluster_get_active_count(&cluster) == 1);
+
+    cluster_free(&cluster);
+    printf("✓ Streaming event sink test passed\n");
+}
+
 // Main test runner
 int main(int argc, char **argv) {
     (void)argc; // Suppress unused parameter warning
@@ -272,6 +421,9 @@ int main(int argc, char **argv) {
     test_cluster_frequency_separation();
     test_cluster_config_string();
     test_cluster_reset();
+    test_cluster_many_channels();
+    test_cluster_merge();
+    test_cluster_event_sink();
 
     printf("\n==========================\n");
     printf("All cluster tests passed! ✓\n");
@@ -0,0 +1,200 @@
+/*
+ * IQ Lab - Colormap Unit Tests
+ *
+ * Tests for colormap: the HF table must reproduce png_intensity_to_color()
+ * at its sample points, every SIMD row kernel must write the same bytes as
+ * the scalar loop (NaN, infinities, out-of-range values, odd tails), the
+ * row mapping must hit the table ends, and bulk row writes must clip at
+ * the image edge.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include "../../src/viz/colormap.h"
+#include "../../src/viz/img_png.h"
+#include "../../src/viz/img_ppm.h"
+
+// Deterministic pseudo-random stream
+static uint32_t rng_state = 31337;
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static void test_tables(void) {
+    printf("Testing palette tables...\n");
+
+    colormap_t map;
+    assert(colormap_init(&map, COLORMAP_HF));
+    for (uint32_t i = 0; i < COLORMAP_LUT_SIZE; i++) {
+        uint8_t r, g, b;
+        png_intensity_to_color((float)i / (float)(COLORMAP_LUT_SIZE - 1), &r, &g, &b);
+        assert(map.lut[i] == ((uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16)));
+    }
+
+    // Every palette: ends as documented, no step larger than a few levels
+    for (int p = 0; p < COLORMAP_COUNT; p++) {
+        colormap_palette_t palette;
+        assert(colormap_from_name(colormap_name((colormap_palette_t)p), &palette) && palette == (colormap_palette_t)p);
+        assert(colormap_init(&map, palette));
+        if (palette == COLORMAP_HF) continue;   // Has deliberate jumps between segments
+        for (uint32_t i = 1; i < COLORMAP_LUT_SIZE; i++) {
+            for (int c = 0; c < 24; c += 8) {
+                int step = (int)((map.lut[i] >> c) & 0xFF) - (int)((map.lut[i - 1] >> c) & 0xFF);
+                assert(abs(step) <= 2);
+            }
+        }
+    }
+    assert(colormap_init(&map, COLORMAP_GRAY));
+    assert(map.lut[0] == 0 && map.lut[COLORMAP_LUT_SIZE - 1] == 0xFFFFFF);
+
+    colormap_palette_t palette;
+    assert(colormap_from_name("grey", &palette) && palette == COLORMAP_GRAY);
+    assert(!colormap_from_name("jet", &palette));
+    assert(!colormap_init(&map, COLORMAP_COUNT));
+
+    printf("✓ Palette table test passed\n");
+}
+
+static void test_map_row(void) {
+    printf("Testing row mapping...\n");
+
+    colormap_t map;
+    assert(colormap_init(&map, COLORMAP_TURBO));
+    map.simd = COLORMAP_SIMD_NONE;
+
+    // Range ends, outside values and NaN
+    const float values[6] = { -120.0f, -20.0f, -200.0f, 50.0f, NAN, -70.0f };
+    uint8_t rgb[18];
+    colormap_map_row(&map, values, 6, -120.0f, -20.0f, rgb);
+    uint8_t r, g, b;
+    colormap_lookup(&map, 0.0f, &r, &g, &b);
+    assert(rgb[0] == r && rgb[1] == g && rgb[2] == b);
+    assert(memcmp(rgb + 6, rgb, 3) == 0 && memcmp(rgb + 12, rgb, 3) == 0);
+    colormap_lookup(&map, 1.0f, &r, &g, &b);
+    assert(rgb[3] == r && rgb[4] == g && rgb[5] == b);
+    assert(memcmp(rgb + 9, rgb + 3, 3) == 0);
+    uint32_t mid = map.lut[COLORMAP_LUT_SIZE / 2];
+    assert(rgb[15] == (uint8_t)mid && rgb[16] == (uint8_t)(mid >> 8) && rgb[17] == (uint8_t)(mid >> 16));
+
+    // Empty range: everything on the first entry
+    colormap_map_row(&map, values, 6, 3.0f, 3.0f, rgb);
+    for (int i = 0; i < 6; i++) {
+        assert(memcmp(rgb + i * 3, rgb, 3) == 0);
+    }
+
+    printf("✓ Row mapping test passed\n");
+}
+
+static void test_simd_matches_scalar(void) {
+    printf("Testing SIMD row kernels against scalar...\n");
+
+    const size_t max_count = 4099;
+    float *values = malloc(max_count * sizeof(float));
+    uint8_t *ref = malloc(max_count * 3 + 64);
+    uint8_t *out = malloc(max_count * 3 + 64);
+    assert(values && ref && out);
+    for (size_t i = 0; i < max_count; i++) {
+        values[i] = -140.0f + (float)(next_random() % 1600000) / 10000.0f;
+    }
+    values[3] = NAN;
+    values[17] = INFINITY;
+    values[18] = -INFINITY;
+    values[40] = -0.0f;
+    values[41] = -100.0f;    // Exactly lo
+    values[42] = 0.0f;       // Exactly hi
+
+    colormap_t map;
+    assert(colormap_init(&map, COLORMAP_VIRIDIS));
+    colormap_simd_t detected = colormap_simd_detect();
+    printf("  Row kernel: %s\n", colormap_simd_name(detected));
+
+    const colormap_simd_t families[] = { COLORMAP_SIMD_SSE2, COLORMAP_SIMD_AVX2, COLORMAP_SIMD_NEON };
+    const size_t counts[] = { 0, 1, 7, 9, 10, 11, 17, 33, 1000, max_count };
+    for (size_t f = 0; f < sizeof(families) / sizeof(families[0]); f++) {
+        // Only families this CPU runs; AVX2 implies SSE2
+        bool runs = families[f] == detected ||
+                    (families[f] == COLORMAP_SIMD_SSE2 && detected == COLORMAP_SIMD_AVX2);
+        if (!runs) continue;
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            // Offsetting the input exercises unaligned loads
+            for (size_t offset = 0; offset < 2 && counts[c] + offset <= max_count; offset++) {
+                const size_t n = counts[c];
+                map.simd = COLORMAP_SIMD_NONE;
+                memset(ref, 0xAB, max_count * 3 + 64);
+                colormap_map_row(&map, values + offset, n, -100.0f, 0.0f, ref);
+                map.simd = families[f];
+                memset(out, 0xAB, max_count * 3 + 64);
+                colormap_map_row(&map, values + offset, n, -100.0f, 0.0f, out);
+                assert(memcmp(ref, out, max_count * 3 + 64) == 0);   // Nothing written past the row
+            }
+        }
+    }
+
+    // Throughput on a 4096-bin row
+    map.simd = detected;
+    const int iterations = 2000;
+    clock_t start = clock();
+    for (int it = 0; it < iterations; it++) {
+        colormap_map_row(&map, values, 4096, -100.0f, 0.0f, out);
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (seconds > 0.0) {
+        printf("  %.0f Mpixel/s (%s)\n", 4096.0 * iterations / seconds / 1e6, colormap_simd_name(detected));
+    }
+
+    free(values);
+    free(ref);
+    free(out);
+    printf("✓ SIMD row kernel test passed\n");
+}
+
+static void test_set_row(void) {
+    printf("Testing bulk row writes...\n");
+
+    uint8_t rgb[3 * 8];
+    for (int i = 0; i < 24; i++) rgb[i] = (uint8_t)(i + 1);
+
+    png_image_t png;
+    assert(png_image_init(&png, 6, 3));
+    png_image_set_row(&png, 1, 2, rgb, 3);
+    uint8_t r, g, b;
+    assert(png_image_get_pixel(&png, 0, 2, &r, &g, &b) && r == 0 && g == 0 && b == 0);
+    assert(png_image_get_pixel(&png, 1, 2, &r, &g, &b) && r == 1 && g == 2 && b == 3);
+    assert(png_image_get_pixel(&png, 3, 2, &r, &g, &b) && r == 7 && g == 8 && b == 9);
+    assert(png_image_get_pixel(&png, 4, 2, &r, &g, &b) && r == 0);
+
+    // Clipped at the right edge, rejected outside the image
+    png_image_set_row(&png, 4, 0, rgb, 8);
+    assert(png_image_get_pixel(&png, 5, 0, &r, &g, &b) && r == 4 && g == 5 && b == 6);
+    assert(png_image_get_pixel(&png, 0, 1, &r, &g, &b) && r == 0);
+    png_image_set_row(&png, 6, 0, rgb, 1);
+    png_image_set_row(&png, 0, 3, rgb, 1);
+    png_image_free(&png);
+
+    ppm_image_t ppm;
+    assert(ppm_image_init(&ppm, 4, 2));
+    ppm_image_set_row(&ppm, 2, 1, rgb, 5);
+    assert(ppm_image_get_pixel(&ppm, 3, 1, &r, &g, &b) && r == 4 && g == 5 && b == 6);
+    assert(ppm_image_get_pixel(&ppm, 1, 1, &r, &g, &b) && r == 0);
+    ppm_image_free(&ppm);
+
+    printf("✓ Bulk row write test passed\n");
+}
+
+int main(void) {
+    printf("=== Colormap Unit Tests ===\n\n");
+
+    test_tables();
+    test_map_row();
+    test_simd_matches_scalar();
+    test_set_row();
+
+    printf("\n✓ All colormap tests passed!\n");
+    return 0;
+}
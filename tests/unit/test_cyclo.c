@@ -0,0 +1,235 @@
+/*
+ * IQ Lab - Cyclostationary Feature Unit Tests
+ *
+ * Tests for the FFT accumulation method (cyclo.h): the symbol rate of
+ * shaped BPSK and QPSK found as the strongest cyclic peak, the conjugate
+ * feature at twice the carrier offset for BPSK only, noise and a
+ * tone-modulated FM carrier without a symbol-rate peak, and the refined
+ * hints ("bpsk", "psk", "fsk", untouched "noise" and "fm") over
+ * features_extract_from_iq's time-domain classification.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "../../src/detect/cyclo.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { SAMPLES = 16384, SPS = 4 };
+static const double RATE = 100000.0;
+static const double SYMBOL_RATE = 25000.0;   // RATE / SPS
+
+typedef enum { SIGNAL_BPSK, SIGNAL_QPSK, SIGNAL_FSK, SIGNAL_TONE_FM, SIGNAL_NOISE } signal_t;
+
+static uint32_t rng_state = 777;
+
+static double uniform(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return ((rng_state >> 8) + 0.5) / (double)(1u << 24);
+}
+
+static double gaussian(void) {
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+static float iq[2 * SAMPLES];
+
+// Symbols with raised-cosine pulses two symbols long (the envelope dips
+// between them), keyed or modulated carriers, or noise; 20 dB SNR
+static void make_signal(signal_t kind, double offset_hz) {
+    enum { SYMBOLS = SAMPLES / SPS + 2 };
+    static double sym_i[SYMBOLS], sym_q[SYMBOLS];
+    for (int k = 0; k < SYMBOLS; k++) {
+        double a = uniform() < 0.5 ? -1.0 : 1.0, b = uniform() < 0.5 ? -1.0 : 1.0;
+        sym_i[k] = kind == SIGNAL_QPSK ? a / sqrt(2.0) : a;
+        sym_q[k] = kind == SIGNAL_QPSK ? b / sqrt(2.0) : 0.0;
+    }
+
+    const double sigma = pow(10.0, -20.0 / 20.0) / sqrt(2.0);
+    double phase = 0.0;
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+        double t = n / RATE, i = 0.0, q = 0.0;
+        uint32_t k = n / SPS;
+        double frac = (double)(n % SPS) / SPS;
+        if (kind == SIGNAL_BPSK || kind == SIGNAL_QPSK) {
+            // Pulse of symbol k peaks at its start and reaches to k +- 1
+            double h0 = 0.5 * (1.0 + cos(M_PI * frac)), h1 = 1.0 - h0;
+            double si = h0 * sym_i[k] + h1 * sym_i[k + 1], sq = h0 * sym_q[k] + h1 * sym_q[k + 1];
+            double c = cos(2.0 * M_PI * offset_hz * t), s = sin(2.0 * M_PI * offset_hz * t);
+            i = si * c - sq * s;
+            q = si * s + sq * c;
+        } else if (kind == SIGNAL_FSK || kind == SIGNAL_TONE_FM) {
+            double freq = offset_hz + (kind == SIGNAL_FSK ? 0.5 * SYMBOL_RATE * sym_i[k]
+                                                          : 20000.0 * cos(2.0 * M_PI * 1000.0 * t));
+            phase += 2.0 * M_PI * freq / RATE;
+            i = cos(phase);
+            q = sin(phase);
+        }
+        double noise = kind == SIGNAL_NOISE ? 1.0 / sqrt(2.0) : sigma;
+        iq[2 * n] = (float)(i + noise * gaussian());
+        iq[2 * n + 1] = (float)(q + noise * gaussian());
+    }
+}
+
+// Time-domain hint, then the cyclic refinement on the same samples
+static bool classify(cyclo_t *cyclo, features_t *features, cyclo_features_t *cf,
+                     features_result_t *result) {
+    return features_extract_from_iq(features, iq, SAMPLES, RATE, result) &&
+           cyclo_analyze(cyclo, iq, SAMPLES, RATE, cf) &&
+           (cyclo_refine_modulation(cf, result), true);
+}
+
+static void print_features(const char *name, const cyclo_features_t *cf, const features_result_t *result) {
+    printf("    %-8s %-6s floor %.3f, peaks", name, result->modulation_hint, cf->floor);
+    for (uint32_t p = 0; p < cf->num_peaks; p++) {
+        printf(" %.0f Hz (%.2f)", cf->peaks[p].alpha_hz, cf->peaks[p].coherence);
+    }
+    printf(", conjugate %.2f at %.0f Hz%s\n", cf->conjugate.coherence, cf->conjugate.alpha_hz,
+           cf->has_conjugate ? "" : " (none)");
+}
+
+// One cyclic resolution cell: rate / (P L)
+static double cell_hz(const cyclo_t *cyclo) {
+    return RATE / ((double)cyclo->blocks * cyclo->hop);
+}
+
+// BPSK and QPSK: the symbol rate is the strongest peak, the conjugate feature is BPSK's alone
+void test_linear_modulations() {
+    TEST_START("Symbol Rate And Conjugate Feature");
+
+    cyclo_t cyclo;
+    features_t features;
+    bool ok = cyclo_init(&cyclo, CYCLO_DEFAULT_CHANNELS, CYCLO_DEFAULT_BLOCKS) &&
+              features_init(&features, 1024, RATE, 0);
+    const double offset_hz = 5000.0;
+
+    cyclo_features_t cf;
+    features_result_t result;
+    make_signal(SIGNAL_BPSK, offset_hz);
+    ok = ok && classify(&cyclo, &features, &cf, &result);
+    if (ok) print_features("bpsk", &cf, &result);
+    ok = ok && cf.segments == CYCLO_MAX_SEGMENTS && cf.num_peaks > 0 &&
+         fabs(cf.symbol_rate_hz - SYMBOL_RATE) <= 2.0 * cell_hz(&cyclo) &&
+         cf.has_conjugate && fabs(cf.conjugate.alpha_hz - 2.0 * offset_hz) <= 2.0 * cell_hz(&cyclo) &&
+         strcmp(result.modulation_hint, "bpsk") == 0;
+
+    make_signal(SIGNAL_QPSK, offset_hz);
+    ok = ok && classify(&cyclo, &features, &cf, &result);
+    if (ok) print_features("qpsk", &cf, &result);
+    ok = ok && cf.num_peaks > 0 && fabs(cf.symbol_rate_hz - SYMBOL_RATE) <= 2.0 * cell_hz(&cyclo) &&
+         !cf.has_conjugate && strcmp(result.modulation_hint, "psk") == 0 &&
+         result.modulation_confidence > 0.5;
+
+    features_free(&features);
+    cyclo_free(&cyclo);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Symbol rate or conjugate feature wrong");
+    }
+    TEST_END();
+}
+
+// Noise has no peak and keeps its hint; FSK becomes "fsk", a tone-modulated FM carrier stays "fm"
+void test_refinement() {
+    TEST_START("Refined Hints");
+
+    cyclo_t cyclo;
+    features_t features;
+    bool ok = cyclo_init(&cyclo, CYCLO_DEFAULT_CHANNELS, CYCLO_DEFAULT_BLOCKS) &&
+              features_init(&features, 1024, RATE, 0);
+
+    cyclo_features_t cf;
+    features_result_t result;
+    make_signal(SIGNAL_NOISE, 0.0);
+    ok = ok && classify(&cyclo, &features, &cf, &result);
+    if (ok) print_features("noise", &cf, &result);
+    ok = ok && cf.num_peaks == 0 && !cf.has_conjugate && strcmp(result.modulation_hint, "noise") == 0;
+
+    make_signal(SIGNAL_FSK, 0.0);
+    ok = ok && classify(&cyclo, &features, &cf, &result);
+    if (ok) print_features("fsk", &cf, &result);
+    ok = ok && strcmp(result.modulation_hint, "fsk") == 0;
+
+    make_signal(SIGNAL_TONE_FM, 0.0);
+    ok = ok && classify(&cyclo, &features, &cf, &result);
+    if (ok) print_features("tone fm", &cf, &result);
+    ok = ok && strcmp(result.modulation_hint, "fm") == 0;
+
+    features_free(&features);
+    cyclo_free(&cyclo);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("A hint was refined wrongly");
+    }
+    TEST_END();
+}
+
+// Too short a snippet, bad sizes and missing arguments are refused
+void test_invalid_input() {
+    TEST_START("Invalid Input");
+
+    cyclo_t cyclo;
+    cyclo_features_t cf;
+    bool ok = cyclo_init(&cyclo, CYCLO_DEFAULT_CHANNELS, CYCLO_DEFAULT_BLOCKS);
+    make_signal(SIGNAL_QPSK, 0.0);
+    ok = ok && !cyclo_analyze(&cyclo, iq, cyclo.segment_samples - 1, RATE, &cf) && !cf.valid;
+    ok = ok && !cyclo_analyze(&cyclo, iq, SAMPLES, 0.0, &cf);
+    ok = ok && cyclo_analyze(&cyclo, iq, cyclo.segment_samples, RATE, &cf) && cf.segments == 1;
+    ok = ok && !cyclo_refine_modulation(NULL, NULL);
+    cyclo_free(&cyclo);
+
+    cyclo_t bad;
+    ok = ok && !cyclo_init(&bad, 24, CYCLO_DEFAULT_BLOCKS) && !cyclo_init(&bad, CYCLO_DEFAULT_CHANNELS, 8);
+    cyclo_free(&bad);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Invalid input accepted");
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Cyclostationary Feature Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_linear_modulations();
+    test_refinement();
+    test_invalid_input();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
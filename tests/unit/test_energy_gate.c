@@ -0,0 +1,231 @@
+/*
+ * IQ Lab - Energy Gate Unit Tests
+ *
+ * Tests for the time-domain energy gate (energy_gate.h): the SIMD block
+ * power kernels against an exact scalar sum for s8 and s16 at every tail
+ * length and at full scale, bursts in noise opening exactly the frames they
+ * overlap (plus the hold), and the floor following a level step while a
+ * long burst stays open.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "../../src/detect/energy_gate.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { FFT = 1024, HOP = 256, FRAMES = 400 };
+
+static uint32_t rng_state = 2024;
+
+static double uniform(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return ((rng_state >> 8) + 0.5) / (double)(1u << 24);
+}
+
+static double gaussian(void) {
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+static int16_t clamp16(double x) {
+    x = round(x);
+    return (int16_t)(x > 32767.0 ? 32767.0 : x < -32768.0 ? -32768.0 : x);
+}
+
+// Every kernel matches a direct sum, for every tail length
+void test_block_power() {
+    TEST_START("Block Power Kernels");
+
+    enum { MAX_COUNT = 300 };
+    int16_t s16[2 * MAX_COUNT];
+    int8_t s8[2 * MAX_COUNT];
+    bool ok = true;
+
+    for (int round = 0; round < 3 && ok; round++) {
+        for (size_t k = 0; k < 2 * MAX_COUNT; k++) {
+            // Round 2: full scale, where I^2 + Q^2 reaches 2^31
+            s16[k] = round == 2 ? -32768 : (int16_t)((uniform() - 0.5) * 65535.0);
+            s8[k] = round == 2 ? -128 : (int8_t)((uniform() - 0.5) * 255.0);
+        }
+        for (size_t count = 0; count <= MAX_COUNT && ok; count++) {
+            uint64_t expect16 = 0, expect8 = 0;
+            for (size_t n = 0; n < 2 * count; n++) {
+                expect16 += (uint64_t)((int64_t)s16[n] * s16[n]);
+                expect8 += (uint64_t)((int64_t)s8[n] * s8[n]);
+            }
+            for (int scalar = 0; scalar < 2 && ok; scalar++) {
+                energy_gate_force_scalar(scalar);
+                uint64_t got16 = energy_gate_block_power(s16, 16, count);
+                uint64_t got8 = energy_gate_block_power(s8, 8, count);
+                if (got16 != expect16 || got8 != expect8) {
+                    printf("    %s, %zu samples: s16 %llu (want %llu), s8 %llu (want %llu)\n",
+                           scalar ? "scalar" : "SIMD", count, (unsigned long long)got16,
+                           (unsigned long long)expect16, (unsigned long long)got8,
+                           (unsigned long long)expect8);
+                    ok = false;
+                }
+            }
+        }
+    }
+    energy_gate_force_scalar(false);
+    if (energy_gate_block_power(s16, 32, 4) != 0) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ SIMD and scalar sums exact for 0..%d samples, full scale included\n", MAX_COUNT);
+    } else {
+        TEST_FAIL("A block power differs from the direct sum");
+    }
+    TEST_END();
+}
+
+// Bursts open the frames they overlap, the hold extends them, the rest is skipped
+void test_bursts() {
+    TEST_START("Bursts In Noise");
+
+    const size_t samples = (size_t)(FRAMES - 1) * HOP + FFT;
+    int16_t *iq = malloc(samples * 2 * sizeof(int16_t));
+    bool *loud = calloc(samples, sizeof(bool));
+    bool ok = iq && loud;
+
+    // Three 600-sample bursts 12 dB over the noise, starting off the hop grid
+    const size_t starts[] = { 20011, 50333, 81000 };
+    for (size_t b = 0; ok && b < sizeof(starts) / sizeof(starts[0]); b++) {
+        for (size_t n = starts[b]; n < starts[b] + 600; n++) loud[n] = true;
+    }
+    for (size_t n = 0; ok && n < samples; n++) {
+        double sigma = 200.0 * (loud[n] ? 4.0 : 1.0);
+        iq[2 * n] = clamp16(sigma * gaussian());
+        iq[2 * n + 1] = clamp16(sigma * gaussian());
+    }
+
+    energy_gate_t gate;
+    ok = ok && energy_gate_init(&gate, 3.0, 64, 2);
+    uint32_t missed = 0, extra = 0, last_loud = UINT32_MAX;
+    for (uint32_t f = 0; ok && f < FRAMES; f++) {
+        const size_t offset = (size_t)f * HOP;
+        bool overlaps = false;
+        for (size_t n = offset; n < offset + FFT; n++) overlaps |= loud[n];
+        if (overlaps) last_loud = f;
+        bool held = last_loud != UINT32_MAX && f > last_loud && f - last_loud <= 2;
+
+        bool active = energy_gate_frame(&gate, iq + 2 * offset, 16, FFT, HOP);
+        if (overlaps && !active) missed++;
+        if (!overlaps && active && !held) extra++;
+    }
+    uint64_t skipped = gate.frames - gate.active_frames;
+    printf("    %llu of %u frames skipped, %u missed, %u opened in quiet noise\n",
+           (unsigned long long)skipped, FRAMES, missed, extra);
+    if (missed != 0 || extra > 2 || skipped < FRAMES * 3 / 4) ok = false;
+
+    // A burst shorter than a sub-block at the very end of a frame still opens it
+    energy_gate_reset(&gate);
+    for (uint32_t f = 0; ok && f < 8; f++) energy_gate_frame(&gate, iq, 16, FFT, HOP);
+    int16_t frame[2 * FFT];
+    memcpy(frame, iq, sizeof(frame));
+    for (size_t n = FFT - 64; n < FFT; n++) {
+        frame[2 * n] = clamp16(3200.0 * gaussian());
+        frame[2 * n + 1] = clamp16(3200.0 * gaussian());
+    }
+    if (ok && !energy_gate_frame(&gate, frame, 16, FFT, HOP)) {
+        printf("    Late short burst did not open its frame\n");
+        ok = false;
+    }
+
+    // Other widths are never gated; bad parameters are refused
+    if (!energy_gate_frame(&gate, iq, 32, FFT, HOP)) ok = false;
+    energy_gate_t bad;
+    if (energy_gate_init(&bad, 0.0, 64, 2) || energy_gate_init(&bad, 3.0, 0, 2)) ok = false;
+
+    free(iq);
+    free(loud);
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Gate missed a burst or opened on noise");
+    }
+    TEST_END();
+}
+
+// A lasting level step is learnt; a burst of similar length is not
+void test_floor_tracking() {
+    TEST_START("Floor Tracking");
+
+    energy_gate_t gate;
+    bool ok = energy_gate_init(&gate, 3.0, 16, 0);
+    const double noise = 1000.0, step = 10.0 * noise;
+
+    for (int f = 0; ok && f < 50; f++) {
+        if (energy_gate_update(&gate, noise, noise)) ok = false;
+    }
+    if (ok && fabs(gate.floor - noise) > 1e-9) ok = false;
+
+    // 10 dB up for good: open at first, closed once the floor has caught up
+    uint32_t open_frames = 0;
+    for (int f = 0; ok && f < 2000; f++) {
+        if (energy_gate_update(&gate, step, step)) open_frames++;
+    }
+    if (ok && (open_frames < 100 || open_frames >= 2000 || gate.floor < 0.5 * step)) {
+        printf("    Step: open %u frames, floor %.0f\n", open_frames, gate.floor);
+        ok = false;
+    }
+
+    // Back down: the floor falls at once, quiet frames stay closed
+    if (ok && (energy_gate_update(&gate, noise, noise) || gate.floor != noise)) ok = false;
+
+    // A burst a few time constants long stays open throughout
+    for (int f = 0; ok && f < 4 * 16; f++) {
+        if (!energy_gate_update(&gate, step, step)) {
+            printf("    Burst closed after %d frames\n", f);
+            ok = false;
+        }
+    }
+    printf("    Level step open for %u frames, a %d-frame burst stayed open\n", open_frames, 4 * 16);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Floor did not follow the level");
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Energy Gate Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_block_power();
+    test_bursts();
+    test_floor_tracking();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
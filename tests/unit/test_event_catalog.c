@@ -0,0 +1,226 @@
+/*
+ * IQ Lab - Event Catalog Unit Tests
+ *
+ * Tests for the cross-run event catalog: range queries agreeing with a
+ * scan of every record while reading only the partitions and index ranges
+ * that can match, sources and their offsets surviving a reopen, and
+ * records appended after the last index build still found
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../../src/detect/event_catalog.h"
+
+#define TEST_CATALOG "test_event_catalog.cat"
+#define TEST_DAYS 6
+#define TEST_DAY0 20000     // 2024-10-04
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+static void remove_catalog(void) {
+    char path[256];
+    for (int day = TEST_DAY0 - 1; day <= TEST_DAY0 + TEST_DAYS; day++) {
+        snprintf(path, sizeof(path), "%s/%d.events", TEST_CATALOG, day);
+        remove(path);
+        snprintf(path, sizeof(path), "%s/%d.index", TEST_CATALOG, day);
+        remove(path);
+    }
+    remove(TEST_CATALOG "/catalog.txt");
+    remove(TEST_CATALOG);
+}
+
+// Record i: spread over TEST_DAYS days and 30-1000 MHz, some wide, some long
+static event_catalog_record_t make_record(uint32_t i) {
+    uint32_t h = i * 2654435761u;
+    event_catalog_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.t_start = (TEST_DAY0 + (h % 997) / 997.0 * TEST_DAYS) * EVENT_CATALOG_PARTITION_S;
+    record.t_end = record.t_start + (i % 50 == 0 ? 7200.0 : 0.5 + (h >> 24) * 0.01);
+    record.f_low = 30e6 + (double)((h >> 8) % 970000) * 1e3;
+    record.f_high = record.f_low + (i % 97 == 0 ? 5e6 : 12.5e3);
+    record.snr_db = (float)(6 + (h >> 20) % 30);
+    record.peak_dbfs = -40.0f;
+    record.confidence = 0.5f;
+    snprintf(record.modulation, sizeof(record.modulation), "%s", i % 3 ? "FM" : "");
+    return record;
+}
+
+static bool count_match(const event_catalog_record_t *record, void *user) {
+    (void)record;
+    (*(uint64_t *)user)++;
+    return true;
+}
+
+// Records first..last-1 as the next events of a log expected to be read up to 'offset'
+static bool ingest(event_catalog_t *catalog, const char *path, uint64_t offset, uint32_t first, uint32_t last) {
+    uint64_t end = offset + (last - first);
+    event_catalog_source_t *source = event_catalog_source(catalog, path, end * 100, 1000);
+    bool ok = source != NULL && source->offset == offset;
+    for (uint32_t i = first; ok && i < last; i++) {
+        event_catalog_record_t record = make_record(i);
+        ok = event_catalog_append(catalog, source, &record);
+    }
+    return ok && event_catalog_commit(catalog, source, end);
+}
+
+static bool test_query(void) {
+    TEST_START("Queries match a full scan and read only candidates");
+
+    const uint32_t count = 20000;
+    remove_catalog();
+    event_catalog_t *catalog = event_catalog_open(TEST_CATALOG, true);
+    bool ok = catalog && ingest(catalog, "run1/events.csv", 0, 0, count / 2) &&
+              ingest(catalog, "run2/events.csv", 0, count / 2, count);
+
+    // A day, a 2 MHz band, SNR >= 20 dB; the whole catalog; one narrow band over every day
+    event_catalog_query_t queries[3];
+    queries[0] = event_catalog_query_all();
+    queries[0].t_min = (TEST_DAY0 + 2.5) * EVENT_CATALOG_PARTITION_S;
+    queries[0].t_max = (TEST_DAY0 + 3.5) * EVENT_CATALOG_PARTITION_S;
+    queries[0].f_min = 433e6;
+    queries[0].f_max = 435e6;
+    queries[0].min_snr_db = 20.0;
+    queries[1] = event_catalog_query_all();
+    queries[2] = event_catalog_query_all();
+    queries[2].f_min = queries[2].f_max = 100e6;
+
+    for (int q = 0; ok && q < 3; q++) {
+        uint64_t matched = 0, expected = 0;
+        event_catalog_stats_t stats;
+        ok = event_catalog_query(catalog, &queries[q], count_match, &matched, &stats);
+        for (uint32_t i = 0; i < count; i++) {
+            event_catalog_record_t record = make_record(i);
+            if (event_catalog_match(&queries[q], &record)) expected++;
+        }
+        printf("  query %d: %llu matches, %u of %u partitions, %llu records read\n", q,
+               (unsigned long long)matched, stats.partitions_read, stats.partitions,
+               (unsigned long long)stats.records_read);
+        ok = ok && matched == expected && stats.matches == expected && stats.partitions == TEST_DAYS;
+        if (q == 0) ok = ok && expected > 0 && stats.partitions_read == 2 && stats.records_read < count / 50;
+        if (q == 1) ok = ok && stats.records_read == count;
+        if (q == 2) ok = ok && stats.records_read < count / 20;
+    }
+    event_catalog_close(catalog);
+    remove_catalog();
+
+    if (!ok) {
+        TEST_FAIL("query results differ from a full scan");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+static bool test_incremental(void) {
+    TEST_START("Sources and offsets survive a reopen");
+
+    remove_catalog();
+    event_catalog_t *catalog = event_catalog_open(TEST_CATALOG, true);
+    bool ok = catalog && ingest(catalog, "a.csv", 0, 0, 300) && ingest(catalog, "b.iqev", 0, 300, 400);
+    event_catalog_close(catalog);
+
+    // Not a catalog: refused without creating
+    ok = ok && event_catalog_open("no_such_catalog.cat", false) == NULL;
+
+    // Reopened: a grows by 200 events, b is unchanged, c is new
+    catalog = ok ? event_catalog_open(TEST_CATALOG, false) : NULL;
+    const event_catalog_source_t *a = catalog ? event_catalog_source_by_id(catalog, 0) : NULL;
+    const event_catalog_source_t *b = catalog ? event_catalog_source_by_id(catalog, 1) : NULL;
+    ok = ok && a && b && strcmp(a->path, "a.csv") == 0 && a->offset == 300 && b->offset == 100 &&
+         !event_catalog_source_by_id(catalog, 2);
+    ok = ok && ingest(catalog, "a.csv", 300, 300, 500) && ingest(catalog, "b.iqev", 100, 400, 400) &&
+         ingest(catalog, "c.sigmf-meta", 0, 500, 600);
+
+    // A log that shrank was replaced: read from the start again
+    event_catalog_source_t *replaced = ok ? event_catalog_source(catalog, "b.iqev", 10, 2000) : NULL;
+    ok = ok && replaced && replaced->offset == 0 && replaced->id == 1;
+
+    // 300 + 100 + 200 + 100 records ingested
+    uint64_t matched = 0;
+    event_catalog_query_t all = event_catalog_query_all();
+    ok = ok && event_catalog_query(catalog, &all, count_match, &matched, NULL) && matched == 700;
+    event_catalog_close(catalog);
+    remove_catalog();
+
+    if (!ok) {
+        TEST_FAIL("incremental ingest");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+static bool test_unindexed_tail(void) {
+    TEST_START("Records past the index are still found");
+
+    remove_catalog();
+    event_catalog_t *catalog = event_catalog_open(TEST_CATALOG, true);
+    bool ok = catalog && ingest(catalog, "a.csv", 0, 0, 1000);
+
+    // An ingest cut short: records written, never committed
+    event_catalog_source_t *source = ok ? event_catalog_source(catalog, "a.csv", 200000, 1000) : NULL;
+    for (uint32_t i = 1000; ok && i < 1200; i++) {
+        event_catalog_record_t record = make_record(i);
+        ok = source && event_catalog_append(catalog, source, &record);
+    }
+    event_catalog_close(catalog);
+
+    catalog = ok ? event_catalog_open(TEST_CATALOG, false) : NULL;
+    event_catalog_query_t query = event_catalog_query_all();
+    query.f_min = 200e6;
+    query.f_max = 300e6;
+    uint64_t matched = 0, expected = 0;
+    ok = ok && catalog && event_catalog_query(catalog, &query, count_match, &matched, NULL);
+    for (uint32_t i = 0; i < 1200; i++) {
+        event_catalog_record_t record = make_record(i);
+        if (event_catalog_match(&query, &record)) expected++;
+    }
+    // The source stays at its committed offset, so the tail is ingested again later
+    ok = ok && matched == expected && event_catalog_source_by_id(catalog, 0)->offset == 1000;
+
+    // Bad records are refused
+    event_catalog_record_t bad = make_record(0);
+    bad.t_start = NAN;
+    ok = ok && !event_catalog_append(catalog, event_catalog_source(catalog, "a.csv", 200000, 1000), &bad);
+    event_catalog_close(catalog);
+    remove_catalog();
+
+    if (!ok) {
+        TEST_FAIL("unindexed records");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Event Catalog Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_query();
+    test_incremental();
+    test_unindexed_tail();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,221 @@
+/*
+ * IQ Lab - Event Feature Pool Unit Tests
+ *
+ * Tests for the asynchronous event feature extraction (event_features.h):
+ * FM, carrier and AM bursts in a capture classified from their decimated
+ * samples (the quiet frame edges cut off), events passed on in submit
+ * order through more events than the pool holds, the same results for one
+ * worker and several, and events without samples keeping their spectral
+ * guess.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "../../src/detect/event_features.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+#define CAPTURE "test_event_features.s16"
+
+enum { FFT = 1024, SAMPLES = 400000, KINDS = 4, EVENTS = 120 };
+static const double RATE = 1000000.0;
+
+// Bursts: FM, a carrier, AM, and one past the end of the capture
+static const double offsets_hz[KINDS] = { 200000.0, -150000.0, 100000.0, 0.0 };
+static const double half_widths_hz[KINDS] = { 22000.0, 1500.0, 4000.0, 4000.0 };
+static const uint32_t starts[KINDS] = { 50000, 200000, 320000, SAMPLES + 10000 };
+static const uint32_t ends[KINDS] = { 150000, 300000, 390000, SAMPLES + 20000 };
+static const char *expected[KINDS] = { "fm", "cw", "am", "narrowband" };
+
+static uint32_t rng_state = 4242;
+
+static double uniform(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return ((rng_state >> 8) + 0.5) / (double)(1u << 24);
+}
+
+static double gaussian(void) {
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+static bool write_capture(void) {
+    int16_t *iq = malloc((size_t)SAMPLES * 2 * sizeof(int16_t));
+    if (!iq) return false;
+    double phase[KINDS] = {0};
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+        double t = n / RATE, i = 100.0 * gaussian(), q = 100.0 * gaussian();
+        for (int k = 0; k < KINDS; k++) {
+            if (n < starts[k] || n >= ends[k]) continue;
+            double freq = offsets_hz[k] + (k == 0 ? 20000.0 * cos(2.0 * M_PI * 2000.0 * t) : 0.0);
+            double amplitude = 8000.0 * (k == 2 ? 1.0 + 0.6 * cos(2.0 * M_PI * 3000.0 * t) : 1.0);
+            phase[k] += 2.0 * M_PI * freq / RATE;
+            i += amplitude * cos(phase[k]);
+            q += amplitude * sin(phase[k]);
+        }
+        iq[2 * n] = (int16_t)lround(i);
+        iq[2 * n + 1] = (int16_t)lround(q);
+    }
+    FILE *file = fopen(CAPTURE, "wb");
+    bool ok = file && fwrite(iq, sizeof(int16_t), (size_t)SAMPLES * 2, file) == (size_t)SAMPLES * 2;
+    if (file) fclose(file);
+    free(iq);
+    return ok;
+}
+
+// The event the cluster engine would have closed for burst k: its first and
+// last frames reach a frame into the noise either side. The id rides in num_detections
+static cluster_event_t make_event(int k, uint32_t id) {
+    cluster_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.start_time_s = (starts[k] - FFT) / RATE;
+    event.end_time_s = ends[k] / RATE;
+    event.duration_s = event.end_time_s - event.start_time_s;
+    event.min_bin = (uint32_t)lround((offsets_hz[k] - half_widths_hz[k]) / RATE * FFT + FFT / 2);
+    event.max_bin = (uint32_t)lround((offsets_hz[k] + half_widths_hz[k]) / RATE * FFT + FFT / 2);
+    event.center_freq_hz = offsets_hz[k];
+    event.modulation_guess = "narrowband";
+    event.modulation_confidence = 0.7;
+    event.num_detections = id;
+    return event;
+}
+
+// Sink: records what arrives, in arrival order
+typedef struct {
+    uint32_t count;
+    uint32_t ids[EVENTS];
+    const char *guesses[EVENTS];
+    double confidences[EVENTS];
+} received_t;
+
+static void record_event(const cluster_event_t *event, void *user) {
+    received_t *received = user;
+    if (received->count < EVENTS) {
+        received->ids[received->count] = event->num_detections;
+        received->guesses[received->count] = event->modulation_guess;
+        received->confidences[received->count] = event->modulation_confidence;
+    }
+    received->count++;
+}
+
+static bool run_pool(uint32_t workers, received_t *received, uint64_t *classified) {
+    memset(received, 0, sizeof(*received));
+    event_features_t *pool = event_features_create(CAPTURE, RATE, FFT, workers, record_event, received);
+    if (!pool) return false;
+    for (uint32_t id = 0; id < EVENTS; id++) {
+        cluster_event_t event = make_event((int)(id % KINDS), id);
+        event_features_submit(pool, &event);
+    }
+    event_features_flush(pool);
+    *classified = pool->classified;
+    event_features_destroy(pool);
+    return true;
+}
+
+// Every burst gets its modulation from the samples; the event past the end keeps its guess
+void test_classification() {
+    TEST_START("Bursts Classified From Samples");
+
+    received_t received;
+    uint64_t classified = 0;
+    bool ok = run_pool(1, &received, &classified);
+
+    for (uint32_t e = 0; ok && e < KINDS; e++) {
+        printf("    burst %u: %s (%.2f)\n", e, received.guesses[e], received.confidences[e]);
+    }
+    for (uint32_t e = 0; ok && e < EVENTS; e++) {
+        if (strcmp(received.guesses[e], expected[e % KINDS]) != 0) {
+            printf("    Event %u: %s, want %s\n", e, received.guesses[e], expected[e % KINDS]);
+            ok = false;
+        }
+    }
+    if (ok && classified != EVENTS / KINDS * (KINDS - 1)) {
+        printf("    %llu events classified\n", (unsigned long long)classified);
+        ok = false;
+    }
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("A burst was misclassified");
+    }
+    TEST_END();
+}
+
+// Order and results do not depend on the worker count, past a full pool
+void test_order() {
+    TEST_START("Submit Order And Worker Count");
+
+    received_t one, many;
+    uint64_t classified_one = 0, classified_many = 0;
+    bool ok = run_pool(1, &one, &classified_one) && run_pool(3, &many, &classified_many);
+    ok = ok && one.count == EVENTS && many.count == EVENTS && classified_one == classified_many;
+    for (uint32_t e = 0; ok && e < EVENTS; e++) {
+        if (one.ids[e] != e || many.ids[e] != e || one.guesses[e] != many.guesses[e] ||
+            one.confidences[e] != many.confidences[e]) {
+            printf("    Event %u: ids %u / %u\n", e, one.ids[e], many.ids[e]);
+            ok = false;
+        }
+    }
+
+    // A missing input or no workers is refused
+    received_t unused;
+    if (event_features_create("no_such_capture.s16", RATE, FFT, 2, record_event, &unused) ||
+        event_features_create(CAPTURE, RATE, FFT, 0, record_event, &unused)) {
+        ok = false;
+    }
+    event_features_flush(NULL);
+    event_features_destroy(NULL);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %d events in order through a pool of %d, 1 and 3 workers agree\n",
+               EVENTS, EVENT_FEATURES_QUEUE_DEPTH);
+    } else {
+        TEST_FAIL("Events out of order or results differ between worker counts");
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Event Feature Pool Unit Tests\n");
+    printf("=====================================\n\n");
+
+    if (!write_capture()) {
+        printf("Cannot write %s\n", CAPTURE);
+        return EXIT_FAILURE;
+    }
+    test_classification();
+    test_order();
+    remove(CAPTURE);
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
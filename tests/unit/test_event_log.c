@@ -0,0 +1,233 @@
+/*
+ * IQ Lab - Event Log Unit Tests
+ *
+ * Tests for the binary columnar event log: events and modulation names
+ * surviving a write and read across several blocks, filters skipping
+ * blocks by their ranges, and damaged or foreign files refused
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../../src/detect/event_log.h"
+
+#define TEST_LOG "test_event_log.iqev"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+static const char *modulations[] = {"FM", "AM", NULL, "PSK/QAM"};
+
+// Event i: one per 10 ms, centre frequency stepping through 8 channels
+static cluster_event_t make_event(uint32_t i) {
+    cluster_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.start_time_s = 0.01 * i;
+    event.end_time_s = event.start_time_s + 0.005;
+    event.duration_s = 0.005;
+    event.min_bin = 100 + (i % 8) * 50;
+    event.max_bin = event.min_bin + 4;
+    event.center_freq_hz = -400e3 + 100e3 * (i % 8);
+    event.bandwidth_hz = 12.5e3;
+    event.peak_snr_db = 10.0 + (i % 13);
+    event.avg_snr_db = event.peak_snr_db - 3.0;
+    event.peak_power_dbfs = -40.0 + (i % 7);
+    event.num_detections = 3 + i % 5;
+    event.confidence = 0.5 + 0.01 * (i % 50);
+    event.modulation_confidence = 0.25;
+    event.modulation_guess = modulations[i % 4];
+    return event;
+}
+
+static bool write_log(uint32_t count, uint32_t block_events) {
+    event_log_writer_t *log = event_log_create(TEST_LOG, block_events);
+    bool ok = log != NULL;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        cluster_event_t event = make_event(i);
+        // A name from a buffer, not a literal: codes follow the text
+        char name[8];
+        if (i == 7) {
+            snprintf(name, sizeof(name), "%s", event.modulation_guess);
+            event.modulation_guess = name;
+        }
+        ok = event_log_append(log, &event);
+    }
+    return event_log_close(log) && ok;
+}
+
+static bool test_round_trip(void) {
+    TEST_START("Events and names survive write and read");
+
+    const uint32_t count = 1000;
+    bool ok = write_log(count, 64);
+    event_log_reader_t *log = ok ? event_log_open(TEST_LOG) : NULL;
+    ok = log != NULL;
+
+    uint32_t seen = 0, blocks = 0;
+    event_log_block_t block;
+    while (ok && event_log_next(log, NULL, &block)) {
+        blocks++;
+        for (uint32_t k = 0; ok && k < block.count; k++, seen++) {
+            cluster_event_t want = make_event(seen), got;
+            const char *name = event_log_modulation(log, block.modulation[k]);
+            ok = event_log_event(log, &block, k, &got) &&
+                 got.start_time_s == want.start_time_s && got.end_time_s == want.end_time_s &&
+                 got.duration_s == want.duration_s && got.min_bin == want.min_bin &&
+                 got.max_bin == want.max_bin && got.center_freq_hz == want.center_freq_hz &&
+                 got.bandwidth_hz == want.bandwidth_hz && got.peak_snr_db == want.peak_snr_db &&
+                 got.avg_snr_db == want.avg_snr_db && got.peak_power_dbfs == want.peak_power_dbfs &&
+                 got.num_detections == want.num_detections && got.confidence == want.confidence &&
+                 got.modulation_confidence == want.modulation_confidence &&
+                 (want.modulation_guess ? name && strcmp(name, want.modulation_guess) == 0 : name == NULL) &&
+                 got.modulation_guess == name;
+            ok = ok && block.t_min <= got.start_time_s && block.t_max >= got.end_time_s &&
+                 block.snr_max >= got.peak_snr_db;
+        }
+    }
+
+    // 1000 events in blocks of 64: 15 full and one of 40; three names, code 0 for none
+    ok = ok && !event_log_failed(log) && seen == count && blocks == 16 &&
+         event_log_modulation(log, 3) && !event_log_modulation(log, 4) && !event_log_modulation(log, 0);
+    event_log_close_reader(log);
+    remove(TEST_LOG);
+
+    if (!ok) {
+        TEST_FAIL("events differ after reading back");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+static bool test_filter(void) {
+    TEST_START("Filters skip blocks outside their ranges");
+
+    const uint32_t count = 4096;
+    bool ok = write_log(count, 256);
+    event_log_reader_t *log = ok ? event_log_open(TEST_LOG) : NULL;
+    ok = log != NULL;
+
+    // Events 1000..1999 in time, one of the 8 channels, SNR >= 20 dB
+    event_log_filter_t filter = event_log_filter_all();
+    filter.t_min = 10.0;
+    filter.t_max = 19.99;
+    filter.f_min = -1e3;
+    filter.f_max = 1e3;
+    filter.min_snr_db = 20.0;
+
+    uint32_t matched = 0, expected = 0;
+    event_log_block_t block;
+    while (ok && event_log_next(log, &filter, &block)) {
+        for (uint32_t k = 0; k < block.count; k++) {
+            if (event_log_match(&filter, &block, k)) matched++;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        cluster_event_t e = make_event(i);
+        if (e.end_time_s >= 10.0 && e.start_time_s <= 19.99 && e.center_freq_hz == 0.0 && e.peak_snr_db >= 20.0) {
+            expected++;
+        }
+    }
+
+    uint64_t read = 0, skipped = 0;
+    event_log_stats(log, &read, &skipped);
+    printf("  %u events matched, %llu blocks read, %llu skipped\n", matched,
+           (unsigned long long)read, (unsigned long long)skipped);
+    // Events 1000..1999 fall in blocks 3..7 of 16
+    ok = ok && !event_log_failed(log) && matched == expected && expected > 0 && read == 5 && skipped == 11;
+    event_log_close_reader(log);
+    remove(TEST_LOG);
+
+    if (!ok) {
+        TEST_FAIL("filtered scan");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+// Keep only the first 'size' bytes of a file
+static bool truncate_file(const char *path, long size) {
+    FILE *file = fopen(path, "rb");
+    char *bytes = malloc((size_t)size);
+    bool ok = file && bytes && fread(bytes, 1, (size_t)size, file) == (size_t)size;
+    if (file) fclose(file);
+    file = ok ? fopen(path, "wb") : NULL;
+    ok = file && fwrite(bytes, 1, (size_t)size, file) == (size_t)size;
+    if (file) fclose(file);
+    free(bytes);
+    return ok;
+}
+
+static bool test_damaged(void) {
+    TEST_START("Damaged and foreign files refused");
+
+    // Not a log at all
+    FILE *file = fopen(TEST_LOG, "wb");
+    bool ok = file != NULL;
+    if (file) {
+        fputs("t_start_s,t_end_s\n", file);
+        fclose(file);
+    }
+    ok = ok && event_log_open(TEST_LOG) == NULL && event_log_open("no_such_log.iqev") == NULL;
+
+    // A log cut in the middle of its second block: the first still reads
+    ok = ok && write_log(200, 128);
+    file = ok ? fopen(TEST_LOG, "rb") : NULL;
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fclose(file);
+        ok = truncate_file(TEST_LOG, size - 100);
+    }
+    event_log_reader_t *log = ok ? event_log_open(TEST_LOG) : NULL;
+    event_log_block_t block;
+    ok = ok && log && event_log_next(log, NULL, &block) && block.count == 128 &&
+         !event_log_next(log, NULL, &block) && event_log_failed(log);
+    event_log_close_reader(log);
+
+    // An empty log (no events) holds only its header
+    event_log_writer_t *empty = event_log_create(TEST_LOG, 0);
+    ok = ok && empty && event_log_close(empty);
+    log = ok ? event_log_open(TEST_LOG) : NULL;
+    ok = ok && log && !event_log_next(log, NULL, &block) && !event_log_failed(log);
+    event_log_close_reader(log);
+    remove(TEST_LOG);
+
+    if (!ok) {
+        TEST_FAIL("damaged log handling");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Event Log Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_round_trip();
+    test_filter();
+    test_damaged();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -13,6 +13,21 @@
 #include <assert.h>
 #include "../../src/detect/features.h"
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Complex Gaussian noise of the given power per sample
+static uint32_t noise_state = 13579u;
+
+static double gaussian(void) {
+    noise_state = noise_state * 1664525u + 1013904223u;
+    double u1 = ((noise_state >> 8) + 0.5) / 16777216.0;
+    noise_state = noise_state * 1664525u + 1013904223u;
+    double u2 = ((noise_state >> 8) + 0.5) / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
 // Test data generation helpers
 static double *generate_flat_spectrum(uint32_t size, double power) {
     double *spectrum = malloc(size * sizeof(double));
@@ -273,6 +288,112 @@ static void test_features_reset(void) {
     printf("✓ Features reset test passed\n");
 }
 
+static void test_features_accumulator(void) {
+    printf("Testing incremental feature accumulator...\n");
+
+    // Tonal segment: accumulated moments must match the spectrum scans
+    double spectrum[16];
+    for (uint32_t i = 0; i < 16; i++) spectrum[i] = 1.0 + 0.25 * (i % 4);
+    spectrum[9] = 40.0;
+
+    features_accum_t acc, left, right;
+    features_accum_reset(&acc);
+    features_accum_reset(&left);
+    features_accum_reset(&right);
+    for (uint32_t bin = 4; bin <= 12; bin++) {
+        double power_db = 10.0 * log10(spectrum[bin]);
+        features_accum_add(&acc, bin, power_db, 0.0);
+        features_accum_add(bin < 8 ? &left : &right, bin, power_db, 0.0);
+    }
+
+    features_result_t result;
+    assert(features_accum_finalize(&acc, 1024, 2000000.0, &result) == true);
+    assert(result.valid == true);
+    assert(result.signal_bins == 9 && result.total_bins == 9);
+    assert(fabs(result.peak_to_avg_ratio - features_calculate_papr(spectrum, 4, 12)) < 1e-9);
+    assert(fabs(result.spectral_flatness - features_calculate_spectral_flatness(spectrum, 4, 12)) < 1e-9);
+    assert(fabs(result.snr_db - 10.0 * log10(40.0)) < 1e-9);   // Noise reference 0 dB
+    assert(fabs(result.bandwidth_hz - 9 * 2000000.0 / 1024) < 1e-6);
+    assert(result.spectral_centroid > 8.0 / 1024 && result.spectral_centroid < 10.0 / 1024);
+    assert(result.modulation_confidence == 0.0);   // Hint only, unrated
+
+    // Merging two halves gives the same features as one pass
+    features_accum_merge(&left, &right);
+    features_result_t merged;
+    assert(features_accum_finalize(&left, 1024, 2000000.0, &merged) == true);
+    assert(left.count == acc.count && left.min_bin == 4 && left.max_bin == 12);
+    assert(fabs(merged.spectral_flatness - result.spectral_flatness) < 1e-12);
+    assert(fabs(merged.spectral_spread - result.spectral_spread) < 1e-12);
+
+    // Thousands of weak cells: the dB sum keeps flatness defined where a
+    // running product would underflow
+    features_accum_reset(&acc);
+    for (uint32_t i = 0; i < 5000; i++) features_accum_add(&acc, 100, -90.0, -100.0);
+    assert(features_accum_finalize(&acc, 1024, 2000000.0, &result) == true);
+    assert(fabs(result.spectral_flatness - 1.0) < 1e-9);
+    assert(fabs(result.snr_db - 10.0) < 1e-9);
+
+    // Empty accumulator
+    features_accum_reset(&acc);
+    assert(features_accum_finalize(&acc, 1024, 2000000.0, &result) == false);
+
+    printf("✓ Incremental feature accumulator tests passed\n");
+}
+
+static void test_features_iq_extraction(void) {
+    printf("Testing features time-domain extraction...\n");
+
+    features_t features;
+    features_result_t result;
+    assert(features_init(&features, 1024, 100000.0, 0) == true);
+
+    enum { N = 8192 };
+    const double rate = 100000.0;
+    float *iq = malloc(2 * N * sizeof(float));
+    assert(iq);
+
+    // 0: carrier, 1: FM, 2: AM, 3: noise; 30 dB SNR for the signals
+    const char *expected[] = {"cw", "fm", "am", "noise"};
+    for (int kind = 0; kind < 4; kind++) {
+        double phase = 0.0;
+        for (uint32_t n = 0; n < N; n++) {
+            double t = n / rate;
+            double amplitude = kind == 2 ? 0.5 * (1.0 + 0.6 * cos(2.0 * M_PI * 700.0 * t)) : 0.5;
+            double freq = 1500.0 + (kind == 1 ? 20000.0 * cos(2.0 * M_PI * 1000.0 * t) : 0.0);
+            phase += 2.0 * M_PI * freq / rate;
+            double sigma = kind == 3 ? 0.5 / sqrt(2.0) : 0.5 * pow(10.0, -30.0 / 20.0) / sqrt(2.0);
+            iq[2 * n] = (float)((kind == 3 ? 0.0 : amplitude * cos(phase)) + sigma * gaussian());
+            iq[2 * n + 1] = (float)((kind == 3 ? 0.0 : amplitude * sin(phase)) + sigma * gaussian());
+        }
+        assert(features_extract_from_iq(&features, iq, N, rate, &result) == true);
+        printf("  %s: %s (%.2f), bw %.0f Hz, centroid %.0f Hz, SNR %.1f dB\n", expected[kind],
+               result.modulation_hint, result.modulation_confidence, result.bandwidth_hz,
+               result.center_frequency_hz, result.snr_db);
+        assert(result.valid == true);
+        assert(strcmp(result.modulation_hint, expected[kind]) == 0);
+        assert(result.modulation_confidence > 0.5 && result.modulation_confidence <= 1.0);
+        assert(fabs(result.avg_power_dbfs - 10.0 * log10(kind == 2 ? 0.25 * 1.18 : 0.25)) < 0.5);
+        if (kind == 0) {
+            assert(fabs(result.center_frequency_hz - 1500.0) < 10.0);
+            assert(fabs(result.snr_db - 30.0) < 2.0);
+        }
+        if (kind == 1) {
+            assert(fabs(result.fm_deviation_hz - 20000.0) < 2000.0);
+        }
+    }
+
+    // Too short, silent or uninitialized input is refused
+    assert(features_extract_from_iq(&features, iq, FEATURES_IQ_MIN_SAMPLES - 1, rate, &result) == false);
+    memset(iq, 0, 2 * N * sizeof(float));
+    assert(features_extract_from_iq(&features, iq, N, rate, &result) == false);
+    assert(result.valid == false);
+    assert(features_extract_from_iq(&features, iq, N, 0.0, &result) == false);
+
+    free(iq);
+    features_free(&features);
+    printf("✓ Features time-domain extraction tests passed\n");
+}
+
 // Main test runner
 int main(int argc, char **argv) {
     (void)argc; // Suppress unused parameter warning
@@ -291,6 +412,8 @@ int main(int argc, char **argv) {
     test_features_spectrum_extraction();
     test_features_config_string();
     test_features_reset();
+    test_features_accumulator();
+    test_features_iq_extraction();
 
     printf("\n===========================\n");
     printf("All features tests passed! ✓\n");
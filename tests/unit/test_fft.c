@@ -7,6 +7,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <complex.h>
 #include <assert.h>
@@ -89,7 +90,7 @@ void test_fft_plan_creation() {
     }
 
     // Test invalid sizes
-    fft_plan_t *invalid1 = fft_plan_create(3, FFT_FORWARD);  // Not power of 2
+    fft_plan_t *invalid1 = fft_plan_create(0, FFT_FORWARD);  // Empty
     fft_plan_t *invalid2 = fft_plan_create(2000000, FFT_FORWARD);  // Too large
 
     if (!invalid1 && !invalid2) {
@@ -98,6 +99,20 @@ void test_fft_plan_creation() {
         TEST_FAIL("Invalid size rejection failed");
     }
 
+    // Non-power-of-two sizes pick mixed radix or Bluestein
+    fft_plan_t *mixed = fft_plan_create(3, FFT_FORWARD);
+    fft_plan_t *chirp = fft_plan_create(11, FFT_FORWARD);
+
+    if (mixed && mixed->algorithm == FFT_ALGO_MIXED_RADIX &&
+        chirp && chirp->algorithm == FFT_ALGO_BLUESTEIN) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Non-power-of-two plan algorithm incorrect");
+    }
+
+    fft_plan_destroy(mixed);
+    fft_plan_destroy(chirp);
+
     TEST_END();
 }
 
@@ -415,7 +430,678 @@ void test_iq_conversion() {
     TEST_END();
 }
 
+// Test FFT against a direct DFT for radix-4 and mixed radix-4/radix-2 sizes
+void test_fft_against_dft() {
+    TEST_START("FFT vs Direct DFT (sizes 1..4096, in-place and out-of-place)");
+
+    const uint32_t MAX_SIZE = 4096;
+    fft_complex_t *input = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_t *output = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_t *in_place = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    if (!input || !output || !in_place) {
+        TEST_FAIL("Allocation failed");
+        free(input); free(output); free(in_place);
+        return;
+    }
+
+    double max_error = 0.0;
+    for (uint32_t size = 1; size <= MAX_SIZE; size *= 2) {
+        for (uint32_t i = 0; i < size; i++) {
+            input[i] = sin(0.37 * i) + cos(1.91 * i * i) * I;
+            in_place[i] = input[i];
+        }
+
+        fft_plan_t *plan = fft_plan_create(size, FFT_FORWARD);
+        if (!plan || !fft_execute(plan, input, output) ||
+            !fft_execute(plan, in_place, in_place)) {
+            TEST_FAIL("FFT execution failed");
+            fft_plan_destroy(plan);
+            free(input); free(output); free(in_place);
+            return;
+        }
+        fft_plan_destroy(plan);
+
+        // Spot-check a handful of bins against the direct sum
+        for (uint32_t k = 0; k < size; k += (size > 16 ? size / 16 + 1 : 1)) {
+            fft_complex_t expected = 0.0;
+            for (uint32_t n = 0; n < size; n++) {
+                double angle = -2.0 * M_PI * (double)((uint64_t)k * n % size) / size;
+                expected += input[n] * (cos(angle) + sin(angle) * I);
+            }
+            double err = fft_magnitude(output[k] - expected) / sqrt((double)size);
+            double err_ip = fft_magnitude(in_place[k] - expected) / sqrt((double)size);
+            if (err > max_error) max_error = err;
+            if (err_ip > max_error) max_error = err_ip;
+        }
+    }
+
+    if (max_error < 1e-10) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("FFT disagrees with direct DFT");
+        printf("    Max error: %.2e\n", max_error);
+    }
+
+    free(input);
+    free(output);
+    free(in_place);
+    TEST_END();
+}
+
+// Test single-precision plans against the double-precision engine
+void test_fft_f32() {
+    TEST_START("Single-Precision FFT (fft_plan_f32_t)");
+
+    const uint32_t SIZE = 2048;
+    fft_complex_t *ref_in = malloc(SIZE * sizeof(fft_complex_t));
+    fft_complex_t *ref_out = malloc(SIZE * sizeof(fft_complex_t));
+    fft_complex_f32_t *in = malloc(SIZE * sizeof(fft_complex_f32_t));
+    fft_complex_f32_t *out = malloc(SIZE * sizeof(fft_complex_f32_t));
+    fft_complex_f32_t *back = malloc(SIZE * sizeof(fft_complex_f32_t));
+    float *power = malloc(SIZE * sizeof(float));
+
+    fft_plan_f32_t *fwd = fft_plan_f32_create(SIZE, FFT_FORWARD);
+    fft_plan_f32_t *inv = fft_plan_f32_create(SIZE, FFT_INVERSE);
+
+    if (!ref_in || !ref_out || !in || !out || !back || !power || !fwd || !inv) {
+        TEST_FAIL("Allocation or plan creation failed");
+    } else {
+        for (uint32_t i = 0; i < SIZE; i++) {
+            in[i] = (float)sin(0.11 * i) + (float)cos(0.7 * i) * I;
+            ref_in[i] = in[i];
+        }
+
+        fft_forward(ref_in, ref_out, SIZE);
+        bool ok = fft_execute_f32(fwd, in, out) && fft_execute_f32(inv, out, back) &&
+                  fft_power_spectrum_f32(out, power, SIZE, false);
+
+        double max_fwd_err = 0.0, max_rt_err = 0.0, max_pow_err = 0.0;
+        for (uint32_t i = 0; ok && i < SIZE; i++) {
+            double e = cabs((fft_complex_t)out[i] - ref_out[i]) / sqrt((double)SIZE);
+            if (e > max_fwd_err) max_fwd_err = e;
+            e = cabs((fft_complex_t)back[i] - ref_in[i]);
+            if (e > max_rt_err) max_rt_err = e;
+            double ref_pow = fft_magnitude_squared(ref_out[i]);
+            e = fabs((double)power[i] - ref_pow) / (ref_pow + 1.0);
+            if (e > max_pow_err) max_pow_err = e;
+        }
+
+        // Shift must swap halves, also in place
+        fft_complex_f32_t shift_in[4] = {0, 1, 2, 3};
+        fft_complex_f32_t shift_out[4];
+        ok = ok && fft_shift_f32(shift_in, shift_out, 4) && fft_shift_f32(shift_in, shift_in, 4);
+        ok = ok && crealf(shift_out[0]) == 2.0f && crealf(shift_out[3]) == 1.0f &&
+             crealf(shift_in[0]) == 2.0f && crealf(shift_in[3]) == 1.0f;
+
+        if (ok && max_fwd_err < 1e-5 && max_rt_err < 1e-5 && max_pow_err < 1e-4) {
+            TEST_PASS();
+        } else {
+            TEST_FAIL("Single-precision FFT accuracy too low");
+            printf("    Forward: %.2e, round-trip: %.2e, power: %.2e\n",
+                   max_fwd_err, max_rt_err, max_pow_err);
+        }
+    }
+
+    fft_plan_f32_destroy(fwd);
+    fft_plan_f32_destroy(inv);
+    free(ref_in); free(ref_out); free(in); free(out); free(back); free(power);
+    TEST_END();
+}
+
+// Test that the SIMD kernels chosen at plan time match the scalar fallback
+void test_fft_simd_dispatch() {
+    TEST_START("SIMD Butterfly Dispatch vs Scalar Fallback");
+
+    printf("    Detected kernels: %s\n", fft_simd_name(fft_simd_detect()));
+
+    const uint32_t MAX_SIZE = 8192;
+    fft_complex_t *in64 = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_t *out64 = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_t *ref64 = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_f32_t *in32 = malloc(MAX_SIZE * sizeof(fft_complex_f32_t));
+    fft_complex_f32_t *out32 = malloc(MAX_SIZE * sizeof(fft_complex_f32_t));
+    fft_complex_f32_t *ref32 = malloc(MAX_SIZE * sizeof(fft_complex_f32_t));
+    double *pow64 = malloc(MAX_SIZE * sizeof(double));
+    float *pow32 = malloc(MAX_SIZE * sizeof(float));
+
+    if (!in64 || !out64 || !ref64 || !in32 || !out32 || !ref32 || !pow64 || !pow32) {
+        TEST_FAIL("Allocation failed");
+        free(in64); free(out64); free(ref64); free(in32); free(out32); free(ref32);
+        free(pow64); free(pow32);
+        return;
+    }
+
+    double max_err64 = 0.0, max_err32 = 0.0, max_pow_err = 0.0, max_pow_rel32 = 0.0;
+    for (uint32_t size = 2; size <= MAX_SIZE; size *= 2) {
+        for (uint32_t i = 0; i < size; i++) {
+            in64[i] = cos(0.3 * i) + sin(0.05 * i * i) * I;
+            in32[i] = (fft_complex_f32_t)in64[i];
+        }
+
+        for (int dir = 0; dir < 2; dir++) {
+            fft_direction_t direction = dir ? FFT_INVERSE : FFT_FORWARD;
+            fft_plan_t *simd64 = fft_plan_create(size, direction);
+            fft_plan_t *scalar64 = fft_plan_create(size, direction);
+            fft_plan_f32_t *simd32 = fft_plan_f32_create(size, direction);
+            fft_plan_f32_t *scalar32 = fft_plan_f32_create(size, direction);
+            scalar64->simd = FFT_SIMD_NONE;
+            scalar32->simd = FFT_SIMD_NONE;
+
+            fft_execute(simd64, in64, out64);
+            fft_execute(scalar64, in64, ref64);
+            fft_execute_f32(simd32, in32, out32);
+            fft_execute_f32(scalar32, in32, ref32);
+
+            for (uint32_t i = 0; i < size; i++) {
+                double e64 = cabs(out64[i] - ref64[i]);
+                double e32 = cabs((fft_complex_t)out32[i] - (fft_complex_t)ref32[i]) / sqrt((double)size);
+                if (e64 > max_err64) max_err64 = e64;
+                if (e32 > max_err32) max_err32 = e32;
+            }
+
+            fft_plan_destroy(simd64);
+            fft_plan_destroy(scalar64);
+            fft_plan_f32_destroy(simd32);
+            fft_plan_f32_destroy(scalar32);
+        }
+    }
+
+    // Odd lengths exercise the scalar tail of the |X|^2 kernels
+    uint32_t odd = MAX_SIZE - 3;
+    fft_power_spectrum(in64, pow64, odd, true);
+    fft_power_spectrum_f32(in32, pow32, odd, true);
+    for (uint32_t i = 0; i < odd; i++) {
+        double expected = fft_magnitude_squared(in64[i]) / odd;
+        double e64 = fabs(pow64[i] - expected);
+        double rel32 = fabs((double)pow32[i] - expected) / (expected + 1e-12);
+        if (e64 > max_pow_err) max_pow_err = e64;
+        if (rel32 > max_pow_rel32) max_pow_rel32 = rel32;
+    }
+
+    if (max_err64 < 1e-9 && max_err32 < 1e-5 && max_pow_err < 1e-9 && max_pow_rel32 < 1e-5) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("SIMD kernels disagree with scalar fallback");
+        printf("    f64: %.2e, f32: %.2e, power: %.2e / %.2e\n",
+               max_err64, max_err32, max_pow_err, max_pow_rel32);
+    }
+
+    free(in64); free(out64); free(ref64); free(in32); free(out32); free(ref32);
+    free(pow64); free(pow32);
+    TEST_END();
+}
+
+// Test generated codelets: every codelet size against the direct DFT, both
+// directions and precisions, scalar and vector families, in place
+void test_fft_codelets() {
+    TEST_START("Generated Codelets vs Direct DFT (every codelet size)");
+
+    const uint32_t MAX_SIZE = FFT_CODELET_MAX_SIZE;
+    fft_complex_t input[FFT_CODELET_MAX_SIZE], expected[FFT_CODELET_MAX_SIZE];
+    fft_complex_t out64[FFT_CODELET_MAX_SIZE];
+    fft_complex_f32_t in32[FFT_CODELET_MAX_SIZE], out32[FFT_CODELET_MAX_SIZE];
+
+    fft_cost_t cost;
+    fft_plan_t *larger = fft_plan_create(2 * MAX_SIZE, FFT_FORWARD);
+    bool ok = larger && larger->algorithm == FFT_ALGO_RADIX4 &&
+              fft_query_cost(MAX_SIZE, &cost) && cost.algorithm == FFT_ALGO_CODELET &&
+              strcmp(fft_algorithm_name(FFT_ALGO_CODELET), "codelet") == 0;
+    fft_plan_destroy(larger);
+
+    double max_err64 = 0.0, max_err32 = 0.0;
+    for (uint32_t size = 2; ok && size <= MAX_SIZE; size *= 2) {
+        for (uint32_t i = 0; i < size; i++) {
+            input[i] = sin(0.37 * i) + cos(1.91 * i * i) * I;
+        }
+
+        for (int dir = 0; ok && dir < 2; dir++) {
+            fft_direction_t direction = dir ? FFT_INVERSE : FFT_FORWARD;
+            double sign = dir ? 2.0 : -2.0;
+            for (uint32_t k = 0; k < size; k++) {
+                expected[k] = 0.0;
+                for (uint32_t n = 0; n < size; n++) {
+                    double angle = sign * M_PI * (double)((uint64_t)k * n % size) / size;
+                    expected[k] += input[n] * (cos(angle) + sin(angle) * I);
+                }
+                if (dir) expected[k] /= size;
+            }
+
+            for (int scalar = 0; ok && scalar < 2; scalar++) {
+                fft_plan_t *plan = fft_plan_create(size, direction);
+                fft_plan_f32_t *plan32 = fft_plan_f32_create(size, direction);
+                ok = plan && plan32 && plan->algorithm == FFT_ALGO_CODELET &&
+                     plan32->algorithm == FFT_ALGO_CODELET;
+                if (ok && scalar) {
+                    plan->simd = FFT_SIMD_NONE;
+                    plan32->simd = FFT_SIMD_NONE;
+                }
+
+                memcpy(out64, input, size * sizeof(fft_complex_t));
+                for (uint32_t i = 0; i < size; i++) out32[i] = (fft_complex_f32_t)input[i];
+                memcpy(in32, out32, size * sizeof(fft_complex_f32_t));
+                ok = ok && fft_execute(plan, out64, out64) && fft_execute_f32(plan32, in32, out32);
+
+                double scale = dir ? 1.0 : 1.0 / sqrt((double)size);
+                for (uint32_t k = 0; ok && k < size; k++) {
+                    double e64 = cabs(out64[k] - expected[k]) * scale;
+                    double e32 = cabs((fft_complex_t)out32[k] - expected[k]) * scale;
+                    if (e64 > max_err64) max_err64 = e64;
+                    if (e32 > max_err32) max_err32 = e32;
+                }
+
+                fft_plan_destroy(plan);
+                fft_plan_f32_destroy(plan32);
+            }
+        }
+    }
+
+    if (ok && max_err64 < 1e-12 && max_err32 < 1e-5) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Codelet disagrees with direct DFT");
+        printf("    Max error: %.2e (f64), %.2e (f32)\n", max_err64, max_err32);
+    }
+
+    TEST_END();
+}
+
+// Test the Hermitian-symmetric real FFT against the complex FFT
+void test_fft_real() {
+    TEST_START("Real-Input FFT (N/2 complex FFT + post-twiddle)");
+
+    const uint32_t MAX_SIZE = 4096;
+    double *x = malloc(MAX_SIZE * sizeof(double));
+    double *back = malloc(MAX_SIZE * sizeof(double));
+    fft_complex_t *cx = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_t *ref = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_t *bins = malloc((MAX_SIZE / 2 + 1) * sizeof(fft_complex_t));
+    fft_complex_t *full = malloc(MAX_SIZE * sizeof(fft_complex_t));
+
+    if (!x || !back || !cx || !ref || !bins || !full) {
+        TEST_FAIL("Allocation failed");
+        free(x); free(back); free(cx); free(ref); free(bins); free(full);
+        return;
+    }
+
+    double max_fwd_err = 0.0, max_inv_err = 0.0, max_full_err = 0.0;
+    for (uint32_t size = 2; size <= MAX_SIZE; size *= 2) {
+        for (uint32_t i = 0; i < size; i++) {
+            x[i] = sin(0.21 * i) + 0.5 * cos(1.3 * i * i);
+            cx[i] = x[i];
+        }
+        fft_forward(cx, ref, size);
+
+        fft_real_plan_t *plan = fft_real_plan_create(size);
+        if (!plan || !fft_real_execute_forward(plan, x, bins) ||
+            !fft_real_execute_inverse(plan, bins, back)) {
+            TEST_FAIL("Real FFT execution failed");
+            fft_real_plan_destroy(plan);
+            free(x); free(back); free(cx); free(ref); free(bins); free(full);
+            return;
+        }
+        fft_real_plan_destroy(plan);
+
+        for (uint32_t k = 0; k <= size / 2; k++) {
+            double e = fft_magnitude(bins[k] - ref[k]);
+            if (e > max_fwd_err) max_fwd_err = e;
+        }
+        for (uint32_t i = 0; i < size; i++) {
+            double e = fabs(back[i] - x[i]);
+            if (e > max_inv_err) max_inv_err = e;
+        }
+
+        // Convenience wrappers keep the full N-bin layout
+        fft_real_forward(x, full, size);
+        fft_real_inverse(full, back, size);
+        for (uint32_t i = 0; i < size; i++) {
+            double e = fft_magnitude(full[i] - ref[i]) + fabs(back[i] - x[i]);
+            if (e > max_full_err) max_full_err = e;
+        }
+    }
+
+    if (max_fwd_err < 1e-9 && max_inv_err < 1e-12 && max_full_err < 1e-9) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Real FFT disagrees with complex FFT");
+        printf("    Forward: %.2e, inverse: %.2e, wrappers: %.2e\n",
+               max_fwd_err, max_inv_err, max_full_err);
+    }
+
+    free(x); free(back); free(cx); free(ref); free(bins); free(full);
+    TEST_END();
+}
+
+// Test the refcounted process-wide plan cache
+void test_fft_plan_cache() {
+    TEST_START("Plan Cache (acquire/release/prewarm/clear)");
+
+    fft_plan_cache_clear();
+
+    uint32_t sizes[] = {1024, 4096};
+    bool prewarmed = fft_plan_cache_prewarm(sizes, 2, FFT_PRECISION_F32);
+
+    fft_plan_t *a = fft_plan_acquire(2048, FFT_FORWARD);
+    fft_plan_t *b = fft_plan_acquire(2048, FFT_FORWARD);
+    fft_plan_t *c = fft_plan_acquire(2048, FFT_INVERSE);
+    fft_plan_f32_t *f = fft_plan_f32_acquire(4096, FFT_FORWARD);
+    fft_real_plan_t *r = fft_real_plan_acquire(512);
+    fft_plan_t *m1 = fft_plan_acquire(1000, FFT_FORWARD);
+    fft_plan_t *m2 = fft_plan_acquire(1000, FFT_FORWARD);
+    fft_plan_t *bad = fft_plan_acquire(0, FFT_FORWARD);
+
+    bool shared = a && a == b && c && c != a && c->direction == FFT_INVERSE &&
+                  f && f->size == 4096 && r && r->size == 512 &&
+                  m1 && m1 == m2 && m1->size == 1000 && !bad;
+
+    // Acquired plans must survive a clear; only idle ones are freed
+    // (f32 1024 fwd/inv, f32 4096 inv)
+    uint32_t freed_busy = fft_plan_cache_clear();
+    fft_plan_t *again = fft_plan_acquire(2048, FFT_FORWARD);
+    bool kept = (again == a);
+
+    fft_plan_release(a);
+    fft_plan_release(b);
+    fft_plan_release(again);
+    fft_plan_release(c);
+    fft_plan_f32_release(f);
+    fft_real_plan_release(r);
+    fft_plan_release(m1);
+    fft_plan_release(m2);
+
+    // Now everything is idle: f64 2048 fwd/inv, f32 4096 fwd, real 512, f64 1000 fwd
+    uint32_t freed_idle = fft_plan_cache_clear();
+
+    if (prewarmed && shared && kept && freed_busy == 3 && freed_idle == 5) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Plan cache bookkeeping incorrect");
+        printf("    prewarmed=%d shared=%d kept=%d freed_busy=%u freed_idle=%u\n",
+               prewarmed, shared, kept, freed_busy, freed_idle);
+    }
+
+    TEST_END();
+}
+
+// Test batched execution against per-frame fft_execute
+void test_fft_batch() {
+    TEST_START("Batched FFT Execution (overlapping input frames)");
+
+    const uint32_t COUNT = 11;
+    const uint32_t HOP = 96;
+    uint32_t sizes[] = {8, 256, 2048};
+    double max_err = 0.0;
+    bool ok = true;
+
+    for (int s = 0; s < 3 && ok; s++) {
+        uint32_t size = sizes[s];
+        size_t total_in = (size_t)HOP * (COUNT - 1) + size;
+        fft_complex_t *in = malloc(total_in * sizeof(fft_complex_t));
+        fft_complex_t *batch = malloc((size_t)COUNT * (size + 3) * sizeof(fft_complex_t));
+        fft_complex_t *single = malloc(size * sizeof(fft_complex_t));
+        fft_complex_f32_t *in32 = malloc(total_in * sizeof(fft_complex_f32_t));
+        fft_complex_f32_t *batch32 = malloc((size_t)COUNT * size * sizeof(fft_complex_f32_t));
+        fft_complex_f32_t *single32 = malloc(size * sizeof(fft_complex_f32_t));
+        fft_plan_t *plan = fft_plan_create(size, FFT_INVERSE);
+        fft_plan_f32_t *plan32 = fft_plan_f32_create(size, FFT_FORWARD);
+
+        if (!in || !batch || !single || !in32 || !batch32 || !single32 || !plan || !plan32) {
+            ok = false;
+        } else {
+            for (size_t i = 0; i < total_in; i++) {
+                in[i] = sin(0.013 * i) + cos(0.4 * i) * I;
+                in32[i] = (fft_complex_f32_t)in[i];
+            }
+
+            // Padded output stride on the double path, packed on the float path
+            ok = fft_execute_batch(plan, in, batch, COUNT, HOP, size + 3) &&
+                 fft_execute_batch_f32(plan32, in32, batch32, COUNT, HOP, size);
+
+            for (uint32_t f = 0; ok && f < COUNT; f++) {
+                fft_execute(plan, in + (size_t)f * HOP, single);
+                fft_execute_f32(plan32, in32 + (size_t)f * HOP, single32);
+                for (uint32_t k = 0; k < size; k++) {
+                    double e = cabs(batch[(size_t)f * (size + 3) + k] - single[k]);
+                    double e32 = cabs((fft_complex_t)batch32[(size_t)f * size + k] -
+                                      (fft_complex_t)single32[k]);
+                    if (e > max_err) max_err = e;
+                    if (e32 > max_err) max_err = e32;
+                }
+            }
+        }
+
+        fft_plan_destroy(plan);
+        fft_plan_f32_destroy(plan32);
+        free(in); free(batch); free(single); free(in32); free(batch32); free(single32);
+    }
+
+    if (ok && max_err == 0.0) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Batched FFT differs from per-frame FFT");
+        printf("    Max error: %.2e\n", max_err);
+    }
+
+    TEST_END();
+}
+
 // Main test runner
+// Test mixed-radix and Bluestein plans for non-power-of-two sizes
+void test_fft_arbitrary_size() {
+    TEST_START("Arbitrary-Length FFT (mixed radix 3/5/7, Bluestein)");
+
+    uint32_t sizes[] = {3, 5, 6, 7, 12, 15, 30, 49, 60, 105, 1000, 3000, 11, 13, 97, 1009};
+    const int NUM_SIZES = (int)(sizeof(sizes) / sizeof(sizes[0]));
+    const uint32_t MAX_SIZE = 3000;
+    fft_complex_t *input = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_t *output = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_t *back = malloc(MAX_SIZE * sizeof(fft_complex_t));
+    fft_complex_f32_t *in32 = malloc(MAX_SIZE * sizeof(fft_complex_f32_t));
+    fft_complex_f32_t *out32 = malloc(MAX_SIZE * sizeof(fft_complex_f32_t));
+    if (!input || !output || !back || !in32 || !out32) {
+        TEST_FAIL("Allocation failed");
+        free(input); free(output); free(back); free(in32); free(out32);
+        return;
+    }
+
+    double max_error = 0.0, max_error32 = 0.0, max_round_trip = 0.0;
+    bool ok = true;
+
+    for (int s = 0; s < NUM_SIZES && ok; s++) {
+        uint32_t size = sizes[s];
+        for (uint32_t i = 0; i < size; i++) {
+            input[i] = sin(0.37 * i) + cos(1.91 * i * i) * I;
+            in32[i] = (fft_complex_f32_t)input[i];
+        }
+
+        fft_plan_t *fwd = fft_plan_create(size, FFT_FORWARD);
+        fft_plan_t *inv = fft_plan_create(size, FFT_INVERSE);
+        fft_plan_f32_t *fwd32 = fft_plan_f32_create(size, FFT_FORWARD);
+        fft_cost_t cost;
+        ok = fwd && inv && fwd32 && fft_query_cost(size, &cost) &&
+             cost.algorithm == fwd->algorithm && cost.flops > 0.0 &&
+             fft_execute(fwd, input, output) && fft_execute(inv, output, back) &&
+             fft_execute_f32(fwd32, in32, out32);
+
+        if (ok) {
+            for (uint32_t k = 0; k < size; k += (size > 32 ? size / 32 + 1 : 1)) {
+                fft_complex_t expected = 0.0;
+                for (uint32_t n = 0; n < size; n++) {
+                    double angle = -2.0 * M_PI * (double)((uint64_t)k * n % size) / size;
+                    expected += input[n] * (cos(angle) + sin(angle) * I);
+                }
+                double err = fft_magnitude(output[k] - expected) / sqrt((double)size);
+                double err32 = fft_magnitude((fft_complex_t)out32[k] - expected) / sqrt((double)size);
+                if (err > max_error) max_error = err;
+                if (err32 > max_error32) max_error32 = err32;
+            }
+            for (uint32_t i = 0; i < size; i++) {
+                double err = fft_magnitude(back[i] - input[i]);
+                if (err > max_round_trip) max_round_trip = err;
+            }
+        }
+
+        fft_plan_destroy(fwd);
+        fft_plan_destroy(inv);
+        fft_plan_f32_destroy(fwd32);
+    }
+
+    // Bluestein pads to a power of two >= 2N - 1
+    fft_cost_t chirp_cost;
+    bool cost_ok = fft_query_cost(1009, &chirp_cost) &&
+                   chirp_cost.algorithm == FFT_ALGO_BLUESTEIN && chirp_cost.transform_size == 2048;
+
+    // Even non-power-of-two real transforms run on a mixed-radix half plan
+    double real_in[30];
+    fft_complex_t real_out[30], real_ref[30], real_cplx[30];
+    for (int i = 0; i < 30; i++) {
+        real_in[i] = cos(0.7 * i) + 0.25 * i;
+        real_cplx[i] = real_in[i];
+    }
+    double real_err = 0.0;
+    bool real_ok = fft_real_forward(real_in, real_out, 30) && fft_forward(real_cplx, real_ref, 30);
+    for (int k = 0; real_ok && k < 30; k++) {
+        double err = fft_magnitude(real_out[k] - real_ref[k]);
+        if (err > real_err) real_err = err;
+    }
+    real_ok = real_ok && real_err < 1e-10;
+
+    // Odd-length shift puts DC at index N/2
+    fft_complex_f32_t odd[5] = {0, 1, 2, 3, 4};
+    bool shift_ok = fft_shift_f32(odd, odd, 5) &&
+                    crealf(odd[0]) == 3 && crealf(odd[2]) == 0 && crealf(odd[4]) == 2;
+
+    if (ok && cost_ok && shift_ok && real_ok && max_error < 1e-10 && max_error32 < 1e-4 &&
+        max_round_trip < 1e-10) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Non-power-of-two FFT disagrees with direct DFT");
+        printf("    ok=%d cost=%d shift=%d real=%d err=%.2e err32=%.2e round_trip=%.2e\n",
+               ok, cost_ok, shift_ok, real_ok, max_error, max_error32, max_round_trip);
+    }
+
+    free(input);
+    free(output);
+    free(back);
+    free(in32);
+    free(out32);
+    TEST_END();
+}
+
+// Test the fused window + FFT + shift + power frame against the separate steps
+void test_fft_spectral_frame() {
+    TEST_START("Fused Spectral Frame (window, FFT, shift, power)");
+
+    uint32_t sizes[] = {1024, 3000};
+    double max_rel = 0.0, max_db = 0.0;
+    bool ok = true;
+
+    for (int s = 0; s < 2 && ok; s++) {
+        uint32_t size = sizes[s];
+        float *iq = malloc(2 * size * sizeof(float));
+        float *window = malloc(size * sizeof(float));
+        float *row = malloc(size * sizeof(float));
+        float *row_db = malloc(size * sizeof(float));
+        double *row64 = malloc(size * sizeof(double));
+        fft_complex_f32_t *in = malloc(size * sizeof(fft_complex_f32_t));
+        fft_complex_f32_t *out = malloc(size * sizeof(fft_complex_f32_t));
+        fft_plan_f32_t *plan = fft_plan_f32_create(size, FFT_FORWARD);
+
+        ok = iq && window && row && row_db && row64 && in && out && plan;
+        for (uint32_t i = 0; ok && i < size; i++) {
+            iq[2 * i] = (float)(cos(0.21 * i) + 0.1 * sin(1.3 * i));
+            iq[2 * i + 1] = (float)(sin(0.21 * i) - 0.2 * cos(0.7 * i));
+            window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / size));
+            in[i] = (iq[2 * i] * window[i]) + (iq[2 * i + 1] * window[i]) * I;
+        }
+
+        ok = ok && fft_spectral_frame(plan, iq, window, row, false) &&
+             fft_spectral_frame(plan, iq, window, row_db, true) &&
+             fft_spectral_frame_f64(plan, iq, window, row64, false) &&
+             fft_execute_f32(plan, in, out) && fft_shift_f32(out, out, size);
+
+        for (uint32_t k = 0; ok && k < size; k++) {
+            double p = crealf(out[k]) * crealf(out[k]) + cimagf(out[k]) * cimagf(out[k]);
+            double rel = fabs(row[k] - p) / (p + 1e-3);
+            double rel64 = fabs(row64[k] - p) / (p + 1e-3);
+            double db_err = fabs(row_db[k] - 10.0 * log10(p + 1e-12));
+            if (rel > max_rel) max_rel = rel;
+            if (rel64 > max_rel) max_rel = rel64;
+            if (db_err > max_db) max_db = db_err;
+        }
+
+        // Rectangular frames read the interleaved samples directly
+        float rect_peak = 0.0f;
+        ok = ok && fft_spectral_frame(plan, iq, NULL, row, false);
+        for (uint32_t k = 0; ok && k < size; k++) {
+            if (row[k] > rect_peak) rect_peak = row[k];
+        }
+        ok = ok && rect_peak > 0.0f;
+
+        free(iq); free(window); free(row); free(row_db); free(row64); free(in); free(out);
+        fft_plan_f32_destroy(plan);
+    }
+
+    if (ok && max_rel < 1e-4 && max_db < 1e-3) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Fused frame disagrees with separate FFT/shift/power");
+        printf("    ok=%d max_rel=%.2e max_db=%.2e\n", ok, max_rel, max_db);
+    }
+
+    TEST_END();
+}
+
+// Test integer-input spectral frames against the float path on converted samples
+void test_fft_spectral_frame_int() {
+    TEST_START("Integer-Input Spectral Frame (s8/s16)");
+
+    enum { SIZE = 1000 };
+    int8_t s8[2 * SIZE];
+    int16_t s16[2 * SIZE];
+    float iq8[2 * SIZE], iq16[2 * SIZE], window[SIZE];
+    float row[SIZE], row_int[SIZE];
+    double row64[SIZE], row64_int[SIZE];
+
+    for (int i = 0; i < 2 * SIZE; i++) {
+        s16[i] = (int16_t)(20000.0 * sin(0.37 * i) + 3000.0 * cos(2.1 * i));
+        s8[i] = (int8_t)(s16[i] / 256);
+        // Same scaling as iq_convert_to_float
+        iq16[i] = (float)s16[i] / 32768.0f;
+        iq8[i] = (float)s8[i] / 128.0f;
+    }
+    for (int i = 0; i < SIZE; i++) {
+        window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / (SIZE - 1)));
+    }
+
+    fft_plan_f32_t *plan = fft_plan_f32_create(SIZE, FFT_FORWARD);
+    bool ok = plan != NULL;
+
+    const float *windows[2] = { window, NULL };
+    for (int w = 0; ok && w < 2; w++) {
+        ok = fft_spectral_frame(plan, iq16, windows[w], row, false) &&
+             fft_spectral_frame_int(plan, s16, 16, windows[w], row_int, false) &&
+             memcmp(row, row_int, sizeof(row)) == 0;
+        ok = ok && fft_spectral_frame_f64(plan, iq8, windows[w], row64, true) &&
+             fft_spectral_frame_int_f64(plan, s8, 8, windows[w], row64_int, true) &&
+             memcmp(row64, row64_int, sizeof(row64)) == 0;
+    }
+
+    // Only 8- and 16-bit samples are accepted
+    ok = ok && !fft_spectral_frame_int(plan, s16, 12, window, row_int, false) &&
+         !fft_spectral_frame_int_f64(NULL, s16, 16, window, row64_int, false);
+
+    fft_plan_f32_destroy(plan);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ s8/s16 rows bit-identical to the float path\n");
+    } else {
+        TEST_FAIL("Integer-input frame differs from float frame");
+    }
+
+    TEST_END();
+}
+
 int main() {
     printf("=====================================\n");
     printf("IQ Lab - FFT Unit Tests\n");
@@ -431,6 +1117,16 @@ int main() {
     test_complex_signal();
     test_power_spectrum();
     test_iq_conversion();
+    test_fft_against_dft();
+    test_fft_f32();
+    test_fft_simd_dispatch();
+    test_fft_codelets();
+    test_fft_real();
+    test_fft_plan_cache();
+    test_fft_batch();
+    test_fft_arbitrary_size();
+    test_fft_spectral_frame();
+    test_fft_spectral_frame_int();
 
     // Summary
     printf("=====================================\n");
@@ -0,0 +1,216 @@
+/*
+ * IQ Lab - FFT Tuning Unit Tests
+ *
+ * Tests for measured plan choices: every forced schedule and kernel family
+ * giving the same transform, wisdom surviving a save and load, plan creation
+ * following wisdom, and fft_tune() recording its winner
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../../src/iq_core/fft.h"
+#include "../../src/iq_core/fft_tune.h"
+
+#define TEST_WISDOM "test_fft_wisdom.txt"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+static const fft_algorithm_t algorithms[] = {
+    FFT_ALGO_RADIX4, FFT_ALGO_MIXED_RADIX, FFT_ALGO_BLUESTEIN, FFT_ALGO_CODELET
+};
+static const fft_simd_t families[] = {FFT_SIMD_NONE, FFT_SIMD_SSE2, FFT_SIMD_AVX2, FFT_SIMD_NEON};
+
+static double max_error(const fft_complex_t *a, const fft_complex_t *b, uint32_t n) {
+    double worst = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double e = cabs(a[i] - b[i]);
+        if (e > worst) worst = e;
+    }
+    return worst;
+}
+
+static bool test_forced_plans(void) {
+    TEST_START("Forced schedules and kernel families agree");
+
+    fft_wisdom_forget();
+    static const uint32_t sizes[] = {16, 64, 256, 1000, 97};
+    bool ok = true;
+    for (size_t s = 0; ok && s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t n = sizes[s];
+        fft_complex_t *in = malloc(n * sizeof(fft_complex_t));
+        fft_complex_t *ref = malloc(n * sizeof(fft_complex_t));
+        fft_complex_t *out = malloc(n * sizeof(fft_complex_t));
+        fft_complex_f32_t *in32 = malloc(n * sizeof(fft_complex_f32_t));
+        fft_complex_f32_t *out32 = malloc(n * sizeof(fft_complex_f32_t));
+        for (uint32_t i = 0; i < n; i++) {
+            in[i] = sin(0.3 * i) + cos(1.7 * i) * I;
+            in32[i] = (fft_complex_f32_t)in[i];
+        }
+
+        fft_plan_t *plan = fft_plan_create(n, FFT_FORWARD);
+        ok = plan && fft_execute(plan, in, ref);
+        fft_plan_destroy(plan);
+
+        uint32_t built = 0;
+        for (size_t a = 0; ok && a < 4; a++) {
+            for (size_t f = 0; ok && f < 4; f++) {
+                fft_plan_t *forced = fft_plan_create_as(n, FFT_FORWARD, algorithms[a], families[f]);
+                fft_plan_f32_t *forced32 = fft_plan_f32_create_as(n, FFT_FORWARD, algorithms[a], families[f]);
+                if ((forced == NULL) != (forced32 == NULL)) ok = false;
+                if (forced && ok) {
+                    built++;
+                    ok = forced->algorithm == algorithms[a] && forced->simd == families[f] &&
+                         fft_execute(forced, in, out) && max_error(out, ref, n) < 1e-9 * n &&
+                         fft_execute_f32(forced32, in32, out32);
+                    for (uint32_t i = 0; ok && i < n; i++) {
+                        ok = cabs((fft_complex_t)out32[i] - ref[i]) < 1e-4 * n;
+                    }
+                }
+                fft_plan_destroy(forced);
+                fft_plan_f32_destroy(forced32);
+            }
+        }
+        // Every size has Bluestein; powers of two also radix-4 and mixed radix
+        if (ok) ok = built >= 1 && (!fft_is_power_of_two(n) || built >= 3);
+        if (!ok) printf("  size %u failed\n", n);
+
+        free(in);
+        free(ref);
+        free(out);
+        free(in32);
+        free(out32);
+    }
+
+    // Schedules that cannot transform a size and kernels the CPU lacks are refused
+    ok = ok && !fft_plan_create_as(256, FFT_FORWARD, FFT_ALGO_CODELET, FFT_SIMD_NONE) &&
+         !fft_plan_create_as(1000, FFT_FORWARD, FFT_ALGO_RADIX4, FFT_SIMD_NONE) &&
+         !fft_plan_create_as(97, FFT_FORWARD, FFT_ALGO_MIXED_RADIX, FFT_SIMD_NONE);
+    for (size_t f = 0; ok && f < 4; f++) {
+        if (!fft_simd_supported(families[f])) {
+            ok = !fft_plan_create_as(256, FFT_FORWARD, FFT_ALGO_RADIX4, families[f]);
+        }
+    }
+
+    if (!ok) {
+        TEST_FAIL("forced plans disagree or were wrongly built");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+static bool test_wisdom_file(void) {
+    TEST_START("Wisdom save, load and plan selection");
+
+    fft_wisdom_forget();
+    fft_wisdom_t a = {256, FFT_PRECISION_F64, FFT_ALGO_MIXED_RADIX, FFT_SIMD_NONE, 1234.5};
+    fft_wisdom_t b = {1000, FFT_PRECISION_F32, FFT_ALGO_BLUESTEIN, FFT_SIMD_NONE, 99.0};
+    fft_wisdom_t bad = {0, FFT_PRECISION_F64, FFT_ALGO_RADIX4, FFT_SIMD_NONE, 1.0};
+    bool ok = fft_wisdom_record(&a) && fft_wisdom_record(&b) && !fft_wisdom_record(&bad) &&
+              fft_wisdom_save(TEST_WISDOM) && fft_wisdom_forget() == 2 &&
+              !fft_wisdom_lookup(256, FFT_PRECISION_F64, NULL);
+
+    // Lines from unknown builds are skipped, the rest still load
+    FILE *file = ok ? fopen(TEST_WISDOM, "a") : NULL;
+    if (file) {
+        fprintf(file, "512 f64 split-radix avx512 10.0\nnot a line\n");
+        fclose(file);
+    }
+
+    fft_wisdom_t got;
+    ok = ok && file && fft_wisdom_load(TEST_WISDOM) &&
+         fft_wisdom_lookup(256, FFT_PRECISION_F64, &got) && got.algorithm == a.algorithm &&
+         got.simd == a.simd && fabs(got.ns - a.ns) < 0.1 &&
+         fft_wisdom_lookup(1000, FFT_PRECISION_F32, &got) && got.algorithm == b.algorithm &&
+         !fft_wisdom_lookup(256, FFT_PRECISION_F32, NULL) &&
+         !fft_wisdom_lookup(512, FFT_PRECISION_F64, NULL);
+    ok = ok && !fft_wisdom_load("no_such_wisdom_file.txt");
+
+    // Plans follow the entry of their own precision only
+    fft_plan_t *plan = ok ? fft_plan_create(256, FFT_FORWARD) : NULL;
+    fft_plan_f32_t *plan32 = ok ? fft_plan_f32_create(256, FFT_FORWARD) : NULL;
+    fft_plan_f32_t *bluestein32 = ok ? fft_plan_f32_create(1000, FFT_INVERSE) : NULL;
+    ok = ok && plan && plan->algorithm == FFT_ALGO_MIXED_RADIX && plan->simd == FFT_SIMD_NONE &&
+         plan32 && plan32->algorithm == FFT_ALGO_RADIX4 && plan32->simd == fft_simd_detect() &&
+         bluestein32 && bluestein32->algorithm == FFT_ALGO_BLUESTEIN;
+    fft_plan_destroy(plan);
+    fft_plan_f32_destroy(plan32);
+    fft_plan_f32_destroy(bluestein32);
+
+    // Without wisdom the fixed rules come back
+    fft_wisdom_forget();
+    plan = fft_plan_create(256, FFT_FORWARD);
+    ok = ok && plan && plan->algorithm == FFT_ALGO_RADIX4;
+    fft_plan_destroy(plan);
+    remove(TEST_WISDOM);
+
+    if (!ok) {
+        TEST_FAIL("wisdom round trip or plan selection");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+static bool test_tune(void) {
+    TEST_START("Tuning records the fastest candidate");
+
+    fft_wisdom_forget();
+    fft_tune_result_t result;
+    fft_wisdom_t got;
+    bool ok = fft_tune(512, FFT_PRECISION_F32, &result) && fft_tune(60, FFT_PRECISION_F64, NULL) &&
+              !fft_tune(1, FFT_PRECISION_F64, NULL) && !fft_tune(FFT_MAX_SIZE + 1, FFT_PRECISION_F64, NULL);
+    if (ok) {
+        printf("  512-point f32: %s/%s %.0f ns (fixed rules %.0f ns, %u candidates)\n",
+               fft_algorithm_name(result.best.algorithm), fft_simd_name(result.best.simd),
+               result.best.ns, result.default_ns, result.candidates);
+    }
+    ok = ok && result.candidates >= 2 && result.best.ns > 0.0 && result.default_ns >= result.best.ns &&
+         fft_wisdom_lookup(512, FFT_PRECISION_F32, &got) && got.algorithm == result.best.algorithm &&
+         got.simd == result.best.simd && fft_wisdom_lookup(60, FFT_PRECISION_F64, &got) &&
+         (got.algorithm == FFT_ALGO_MIXED_RADIX || got.algorithm == FFT_ALGO_BLUESTEIN);
+
+    fft_plan_f32_t *plan = ok ? fft_plan_f32_create(512, FFT_FORWARD) : NULL;
+    ok = ok && plan && plan->algorithm == result.best.algorithm && plan->simd == result.best.simd;
+    fft_plan_f32_destroy(plan);
+    fft_wisdom_forget();
+
+    if (!ok) {
+        TEST_FAIL("tuned winner not recorded or not used");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - FFT Tuning Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_forced_plans();
+    test_wisdom_file();
+    test_tune();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
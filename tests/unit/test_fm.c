@@ -1,12 +1,22 @@
 /*
  * IQ Lab - FM Demodulator Unit Tests
+ *
+ * The block discriminator must follow the per-sample demodulator, give the
+ * same outputs for any block split and on every SIMD path, and its atan
+ * must stay within FM_FAST_ATAN_MAX_ERROR in all octants; the interleaved
+ * and complex buffer APIs must match the split I/Q ones; and the filtered
+ * and PLL stereo decoders must separate a left-only tone from the right
+ * channel, the PLL one with the pilot off its nominal frequency.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+#include <complex.h>
 #include <assert.h>
 #include "../../src/demod/fm.h"
+#include "../../src/demod/fm_stereo.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -265,6 +275,329 @@ void test_fm_errors() {
     }
 }
 
+// FM-modulated interleaved IQ: 1 kHz tone at the given deviation, plus a
+// 19 kHz pilot in the baseband
+static float *make_fm_signal(uint32_t count, float sample_rate, float deviation) {
+    float *iq = malloc(2 * (size_t)count * sizeof(float));
+    assert(iq);
+    double phase = 0.3;
+    for (uint32_t n = 0; n < count; n++) {
+        double t = n / (double)sample_rate;
+        double message = 0.9 * sin(2.0 * M_PI * 1000.0 * t) + 0.1 * sin(2.0 * M_PI * 19000.0 * t);
+        phase += 2.0 * M_PI * deviation * message / sample_rate;
+        phase = fmod(phase, 2.0 * M_PI);
+        iq[2 * n] = (float)(0.8 * cos(phase));
+        iq[2 * n + 1] = (float)(0.8 * sin(phase));
+    }
+    return iq;
+}
+
+// Test the polynomial atan against atan2f around the circle
+void test_fm_fast_atan() {
+    TEST_START("Fast atan2");
+
+    double max_error = 0.0;
+    for (int k = 0; k <= 100000; k++) {
+        double angle = -M_PI + 2.0 * M_PI * k / 100000.0;
+        for (int m = 0; m < 3; m++) {
+            float radius = m == 0 ? 1.0f : (m == 1 ? 1e-3f : 250.0f);
+            float x = radius * (float)cos(angle), y = radius * (float)sin(angle);
+            double error = fabs((double)fm_fast_atan2(y, x) - atan2((double)y, (double)x));
+            if (error > M_PI) error = 2.0 * M_PI - error;   // +-pi are the same angle
+            if (error > max_error) max_error = error;
+        }
+    }
+    bool zero_ok = fm_fast_atan2(0.0f, 0.0f) == 0.0f && fm_fast_atan2(0.0f, -1.0f) > 3.14f;
+
+    if (max_error < FM_FAST_ATAN_MAX_ERROR && zero_ok) {
+        TEST_PASS();
+        printf("    Max error %.2e rad\n", max_error);
+    } else {
+        TEST_FAIL("Fast atan2 out of tolerance");
+        printf("    Max error %.2e rad\n", max_error);
+    }
+}
+
+// Test the block discriminator against per-sample processing, block splits
+// and the scalar kernel
+void test_fm_block_processing() {
+    TEST_START("Block Discriminator");
+
+    const float fs = 240000.0f;
+    const uint32_t n = 48000;
+    float *iq = make_fm_signal(n, fs, 50000.0f);
+    float *ref = malloc(n * sizeof(float));
+    float *whole = malloc(n * sizeof(float));
+    float *split = malloc(n * sizeof(float));
+    float *scalar = malloc(n * sizeof(float));
+    assert(ref && whole && split && scalar);
+
+    fm_demod_t a, b, c, d;
+    assert(fm_demod_init(&a, fs) && fm_demod_init(&b, fs) && fm_demod_init(&c, fs) &&
+           fm_demod_init(&d, fs));
+    for (uint32_t i = 0; i < n; i++) ref[i] = fm_demod_process_sample(&a, iq[2 * i], iq[2 * i + 1]);
+    assert(fm_demod_process_block(&b, iq, n, whole));
+
+    // Random block sizes, the first few of one sample
+    uint32_t state = 7u;
+    for (uint32_t offset = 0; offset < n; ) {
+        state = state * 1664525u + 1013904223u;
+        uint32_t chunk = offset < 4 ? 1 : 1 + (state >> 8) % 1500;
+        if (chunk > n - offset) chunk = n - offset;
+        assert(fm_demod_process_block(&c, iq + 2 * (size_t)offset, chunk, split + offset));
+        offset += chunk;
+    }
+
+    fm_demod_force_scalar(true);
+    assert(fm_demod_process_block(&d, iq, n, scalar));
+    fm_demod_force_scalar(false);
+
+    double max_diff = 0.0, rms = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double diff = fabs(whole[i] - ref[i]);
+        if (diff > max_diff) max_diff = diff;
+        rms += ref[i] * ref[i];
+    }
+    rms = sqrt(rms / n);
+
+    bool same_split = memcmp(whole, split, n * sizeof(float)) == 0;
+    bool same_scalar = memcmp(whole, scalar, n * sizeof(float)) == 0;
+    bool pilot_ok = fabsf(fm_demod_get_pilot_level(&b) - fm_demod_get_pilot_level(&a)) <
+                    1e-3f * fm_demod_get_pilot_level(&a) + 1e-6f &&
+                    fm_demod_get_pilot_level(&b) == fm_demod_get_pilot_level(&c);
+    bool counted = b.samples_processed == n && c.samples_processed == n;
+
+    // The per-sample path continues where a block left off
+    float next_sample = fm_demod_process_sample(&b, iq[0], iq[1]);
+    float next_block = 0.0f;
+    assert(fm_demod_process_block(&c, iq, 1, &next_block));
+    bool continues = fabsf(next_sample - next_block) < 1e-4f;
+
+    if (max_diff < 1e-3 && rms > 0.1 && same_split && same_scalar && pilot_ok && counted &&
+        continues) {
+        TEST_PASS();
+        printf("    %u samples, max difference %.1e (audio RMS %.2f)\n", n, max_diff, rms);
+    } else {
+        TEST_FAIL("Block discriminator mismatch");
+        printf("    max diff %.1e, rms %.2f, split %d, scalar %d, pilot %d, count %d, continue %d\n",
+               max_diff, rms, same_split, same_scalar, pilot_ok, counted, continues);
+    }
+
+    // Error conditions
+    assert(!fm_demod_process_block(NULL, iq, n, whole));
+    assert(!fm_demod_process_block(&b, NULL, n, whole));
+    assert(!fm_demod_process_block(&b, iq, 0, whole));
+
+    free(iq);
+    free(ref);
+    free(whole);
+    free(split);
+    free(scalar);
+}
+
+// Test the interleaved and complex buffer APIs against the split I/Q ones
+void test_fm_interleaved_buffers() {
+    TEST_START("Interleaved and Complex Buffers");
+
+    const float fs = 240000.0f;
+    const uint32_t n = 12000;
+    float *iq = make_fm_signal(n, fs, 50000.0f);
+    float complex *z = malloc(n * sizeof(float complex));
+    float *i_buf = malloc(n * sizeof(float)), *q_buf = malloc(n * sizeof(float));
+    float *a = malloc(n * sizeof(float)), *b = malloc(n * sizeof(float));
+    float *c = malloc(n * sizeof(float)), *d = malloc(n * sizeof(float));
+    assert(z && i_buf && q_buf && a && b && c && d);
+    for (uint32_t i = 0; i < n; i++) {
+        i_buf[i] = iq[2 * i];
+        q_buf[i] = iq[2 * i + 1];
+        z[i] = iq[2 * i] + I * iq[2 * i + 1];
+    }
+
+    // Mono: the interleaved and complex forms both take the block path
+    fm_demod_t x, y, u;
+    assert(fm_demod_init(&x, fs) && fm_demod_init(&y, fs) && fm_demod_init(&u, fs));
+    assert(fm_demod_process_buffer_iq(&x, iq, n, a));
+    assert(fm_demod_process_buffer_complex(&y, z, n, b));
+    assert(fm_demod_process_block(&u, iq, n, c));
+    bool mono_ok = memcmp(a, b, n * sizeof(float)) == 0 && memcmp(a, c, n * sizeof(float)) == 0;
+
+    // Stereo: per sample, so it must equal the split-buffer call exactly
+    assert(fm_demod_init(&x, fs) && fm_demod_init(&y, fs) && fm_demod_init(&u, fs));
+    assert(fm_demod_process_stereo_buffer(&x, i_buf, q_buf, n, a, b));
+    assert(fm_demod_process_stereo_buffer_iq(&y, iq, n, c, d));
+    bool stereo_ok = memcmp(a, c, n * sizeof(float)) == 0 && memcmp(b, d, n * sizeof(float)) == 0;
+    assert(fm_demod_process_stereo_buffer_complex(&u, z, n, c, d));
+    stereo_ok = stereo_ok && memcmp(a, c, n * sizeof(float)) == 0 &&
+                memcmp(b, d, n * sizeof(float)) == 0;
+
+    bool errors_ok = !fm_demod_process_buffer_iq(&x, NULL, n, a) &&
+                     !fm_demod_process_buffer_complex(&x, z, 0, a) &&
+                     !fm_demod_process_stereo_buffer_iq(&x, iq, n, a, NULL) &&
+                     !fm_demod_process_stereo_buffer_complex(NULL, z, n, a, b);
+
+    if (mono_ok && stereo_ok && errors_ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Interleaved buffer outputs differ");
+        printf("    mono %d, stereo %d, errors %d\n", mono_ok, stereo_ok, errors_ok);
+    }
+
+    free(iq);
+    free(z);
+    free(i_buf);
+    free(q_buf);
+    free(a);
+    free(b);
+    free(c);
+    free(d);
+}
+
+// Tone power at frequency f over samples [start, count)
+static double tone_level(const float *x, uint32_t start, uint32_t count, double f, double fs) {
+    double complex acc = 0.0;
+    for (uint32_t n = start; n < count; n++) acc += x[n] * cexp(-I * 2.0 * M_PI * f * n / fs);
+    return cabs(acc) / (count - start);
+}
+
+// Test the filtered stereo decoder on a left-only 1 kHz tone
+void test_fm_stereo_filters() {
+    TEST_START("Filtered Stereo Decoder");
+
+    const float fs = 240000.0f, deviation = 75000.0f;
+    const uint32_t n = 96000;
+    float *iq = malloc(2 * (size_t)n * sizeof(float));
+    float *left = malloc(n * sizeof(float)), *right = malloc(n * sizeof(float));
+    float *left2 = malloc(n * sizeof(float)), *right2 = malloc(n * sizeof(float));
+    assert(iq && left && right && left2 && right2);
+
+    // MPX: 0.45 (L+R) + 0.45 (L-R) sin(2 theta) + 0.1 sin(theta), R = 0
+    double phase = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double t = i / (double)fs;
+        double l = 0.5 * sin(2.0 * M_PI * 1000.0 * t);
+        double theta = 2.0 * M_PI * 19000.0 * t;
+        double mpx = 0.45 * l + 0.45 * l * sin(2.0 * theta) + 0.1 * sin(theta);
+        phase = fmod(phase + 2.0 * M_PI * deviation * mpx / fs, 2.0 * M_PI);
+        iq[2 * i] = (float)cos(phase);
+        iq[2 * i + 1] = (float)sin(phase);
+    }
+
+    fm_demod_t a, b, low;
+    assert(fm_demod_init_stereo(&a, fs, deviation, 50e-6f, 1.0f));
+    assert(fm_demod_init_stereo(&b, fs, deviation, 50e-6f, 1.0f));
+    assert(fm_demod_init(&low, 48000.0f));
+    bool enabled = fm_demod_set_stereo_filters(&a, true) && fm_demod_set_stereo_filters(&b, true) &&
+                   !fm_demod_set_stereo_filters(&low, true);
+    assert(enabled);
+
+    // One sample through the per-sample call, then uneven blocks
+    assert(fm_demod_process_stereo_buffer_iq(&a, iq, n, left, right));
+    assert(fm_demod_process_stereo(&b, iq[0], iq[1], left2, right2));
+    for (uint32_t offset = 1; offset < n; offset += 4999) {
+        uint32_t len = n - offset < 4999 ? n - offset : 4999;
+        assert(fm_demod_process_stereo_buffer_iq(&b, iq + 2 * (size_t)offset, len,
+                                                 left2 + offset, right2 + offset));
+    }
+    bool same = memcmp(left, left2, n * sizeof(float)) == 0 &&
+                memcmp(right, right2, n * sizeof(float)) == 0;
+
+    uint32_t start = n / 2;
+    double l_level = tone_level(left, start, n, 1000.0, fs);
+    double r_level = tone_level(right, start, n, 1000.0, fs);
+    float pilot = fm_demod_get_pilot_level(&a);
+    bool delay_ok = fm_demod_stereo_delay(&a) > 0 && fm_demod_stereo_delay(&low) == 0;
+
+    if (same && l_level > 0.1 && r_level < 0.01 * l_level && fabsf(pilot - 0.1f) < 0.01f &&
+        fm_demod_is_stereo(&a) && delay_ok) {
+        TEST_PASS();
+        printf("    L %.3f, R %.4f (%.1f dB separation), pilot %.3f, delay %u\n", l_level, r_level,
+               20.0 * log10(l_level / r_level), pilot, fm_demod_stereo_delay(&a));
+    } else {
+        TEST_FAIL("Stereo separation");
+        printf("    L %.3f, R %.4f, pilot %.3f, same %d, delay %d\n", l_level, r_level, pilot,
+               same, delay_ok);
+    }
+
+    fm_demod_free(&a);
+    fm_demod_free(&b);
+    fm_demod_free(&low);
+    free(iq);
+    free(left);
+    free(right);
+    free(left2);
+    free(right2);
+}
+
+// Test the PLL stereo decoder on a left-only 1 kHz tone, pilot 2 Hz high
+void test_fm_stereo_pll() {
+    TEST_START("PLL Stereo Decoder");
+
+    const float fs = 240000.0f, deviation = 75000.0f;
+    const double pilot_hz = 19002.0;
+    const uint32_t n = 192000;
+    float *iq = malloc(2 * (size_t)n * sizeof(float)), *mpx = malloc(n * sizeof(float));
+    float *left = malloc(n * sizeof(float)), *right = malloc(n * sizeof(float));
+    float *left2 = malloc(n * sizeof(float)), *right2 = malloc(n * sizeof(float));
+    assert(iq && mpx && left && right && left2 && right2);
+
+    double phase = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double t = i / (double)fs;
+        double l = 0.5 * sin(2.0 * M_PI * 1000.0 * t);
+        double theta = 2.0 * M_PI * pilot_hz * t;
+        double m = 0.45 * l + 0.45 * l * sin(2.0 * theta) + 0.1 * sin(theta);
+        phase = fmod(phase + 2.0 * M_PI * deviation * m / fs, 2.0 * M_PI);
+        iq[2 * i] = (float)cos(phase);
+        iq[2 * i + 1] = (float)sin(phase);
+    }
+
+    fm_demod_t fm;
+    fm_stereo_t a, b, low;
+    assert(fm_demod_init_stereo(&fm, fs, deviation, 50e-6f, 1.0f));
+    assert(fm_demod_process_mpx(&fm, iq, n, mpx));
+    assert(fm_stereo_init(&a, fs, 50e-6f, 1.0f) && fm_stereo_init(&b, fs, 50e-6f, 1.0f));
+    bool rejects = !fm_stereo_init(&low, 96000.0, 50e-6f, 1.0f) &&
+                   !fm_stereo_init(&low, fs, 50e-6f, 1.5f);
+    bool rate_ok = a.output_rate * a.decimation == fs && a.output_rate >= FM_STEREO_MIN_OUTPUT_RATE;
+
+    // Whole input, then uneven blocks
+    uint32_t outputs = fm_stereo_process(&a, mpx, n, left, right);
+    uint32_t outputs2 = 0;
+    for (uint32_t offset = 0; offset < n; offset += 4999) {
+        uint32_t len = n - offset < 4999 ? n - offset : 4999;
+        outputs2 += fm_stereo_process(&b, mpx + offset, len, left2 + outputs2, right2 + outputs2);
+    }
+    bool same = outputs == outputs2 && outputs == n / a.decimation &&
+                memcmp(left, left2, outputs * sizeof(float)) == 0 &&
+                memcmp(right, right2, outputs * sizeof(float)) == 0;
+
+    uint32_t start = outputs / 2;
+    double l_level = tone_level(left, start, outputs, 1000.0, a.output_rate);
+    double r_level = tone_level(right, start, outputs, 1000.0, a.output_rate);
+    double tracked = fm_stereo_pilot_frequency(&a);
+
+    if (same && rejects && rate_ok && l_level > 0.1 && r_level < 0.01 * l_level &&
+        fm_stereo_locked(&a) && fabs(tracked - pilot_hz) < 0.5 && fabsf(a.pilot_level - 0.1f) < 0.01f) {
+        TEST_PASS();
+        printf("    L %.3f, R %.4f (%.1f dB separation), pilot %.3f at %.2f Hz, %.0f Hz output\n",
+               l_level, r_level, 20.0 * log10(l_level / r_level), a.pilot_level, tracked,
+               a.output_rate);
+    } else {
+        TEST_FAIL("PLL stereo separation");
+        printf("    L %.3f, R %.4f, pilot %.3f at %.2f Hz, same %d, rejects %d, rate %d\n", l_level,
+               r_level, a.pilot_level, tracked, same, rejects, rate_ok);
+    }
+
+    fm_stereo_free(&a);
+    fm_stereo_free(&b);
+    free(iq);
+    free(mpx);
+    free(left);
+    free(right);
+    free(left2);
+    free(right2);
+}
+
 int main() {
     printf("=====================================\n");
     printf("IQ Lab - FM Demodulator Unit Tests\n");
@@ -278,6 +611,11 @@ int main() {
     test_fm_stereo_pilot();
     test_fm_reset();
     test_fm_errors();
+    test_fm_fast_atan();
+    test_fm_block_processing();
+    test_fm_interleaved_buffers();
+    test_fm_stereo_filters();
+    test_fm_stereo_pll();
 
     printf("\n=====================================\n");
     printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
@@ -0,0 +1,197 @@
+/*
+ * IQ Lab - GCC-PHAT Unit Tests
+ *
+ * Tests for the TDoA correlation engine (gcc_phat.h): fractional delays
+ * between three receivers of a broadband signal at 15 dB SNR found within
+ * 0.2 samples, the same results for one thread and several and for any
+ * push size, intervals starting afresh, and configuration checks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <complex.h>
+#include "../../src/tdoa/gcc_phat.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { SAMPLES = 1 << 16, RECEIVERS = 3, MAX_LAG = 64 };
+static const double delays[RECEIVERS] = { 0.0, 12.3, -7.75 };   // Samples behind receiver 0
+
+static uint32_t rng_state = 31337;
+
+static double uniform(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return ((rng_state >> 8) + 0.5) / (double)(1u << 24);
+}
+
+static double gaussian(void) {
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+static float *iq[RECEIVERS];
+
+// One noise source, delayed per receiver by a phase ramp over its whole
+// spectrum (circular, so the ends wrap), plus independent noise 15 dB down
+static bool make_receivers(void) {
+    fft_plan_t *forward = fft_plan_create(SAMPLES, FFT_FORWARD);
+    fft_plan_t *inverse = fft_plan_create(SAMPLES, FFT_INVERSE);
+    fft_complex_t *source = malloc(SAMPLES * sizeof(fft_complex_t));
+    fft_complex_t *spectrum = malloc(SAMPLES * sizeof(fft_complex_t));
+    fft_complex_t *shifted = malloc(SAMPLES * sizeof(fft_complex_t));
+    bool ok = forward && inverse && source && spectrum && shifted;
+
+    for (uint32_t n = 0; ok && n < SAMPLES; n++) source[n] = gaussian() + I * gaussian();
+    ok = ok && fft_execute(forward, source, spectrum);
+    const double sigma = pow(10.0, -15.0 / 20.0);
+    for (int r = 0; ok && r < RECEIVERS; r++) {
+        for (uint32_t k = 0; k < SAMPLES; k++) {
+            double f = (k < SAMPLES / 2 ? (double)k : (double)k - SAMPLES) / SAMPLES;
+            shifted[k] = spectrum[k] * cexp(-2.0 * M_PI * I * f * delays[r]);
+        }
+        iq[r] = malloc(2 * SAMPLES * sizeof(float));
+        ok = iq[r] && fft_execute(inverse, shifted, source);
+        for (uint32_t n = 0; ok && n < SAMPLES; n++) {
+            iq[r][2 * n] = (float)(creal(source[n]) + sigma * gaussian());
+            iq[r][2 * n + 1] = (float)(cimag(source[n]) + sigma * gaussian());
+        }
+    }
+
+    fft_plan_destroy(forward);
+    fft_plan_destroy(inverse);
+    free(source);
+    free(spectrum);
+    free(shifted);
+    return ok;
+}
+
+// Push the receivers in chunks of 'chunk' samples and estimate once
+static bool run_engine(uint32_t threads, size_t chunk, gcc_phat_result_t *results) {
+    gcc_phat_config_t config = { .num_receivers = RECEIVERS, .max_lag = MAX_LAG, .num_threads = threads };
+    gcc_phat_t *engine = gcc_phat_create(&config);
+    if (!engine) return false;
+    for (size_t done = 0; done < SAMPLES; done += chunk) {
+        const float *pointers[RECEIVERS];
+        for (int r = 0; r < RECEIVERS; r++) pointers[r] = iq[r] + 2 * done;
+        gcc_phat_push(engine, pointers, done + chunk <= SAMPLES ? chunk : SAMPLES - done);
+    }
+    bool ok = gcc_phat_num_pairs(engine) == 3 && gcc_phat_estimate(engine, results);
+
+    // A new interval starts empty
+    ok = ok && !gcc_phat_estimate(engine, results + 3);
+    gcc_phat_destroy(engine);
+    return ok;
+}
+
+// Pair delays within 0.2 samples, with a clear peak
+void test_delays() {
+    TEST_START("Fractional Delays");
+
+    gcc_phat_result_t results[6];
+    bool ok = run_engine(1, SAMPLES, results);
+    for (int p = 0; ok && p < 3; p++) {
+        const gcc_phat_result_t *result = &results[p];
+        double expected = delays[result->rx_b] - delays[result->rx_a];
+        printf("    rx %u -> %u: %.3f samples (expected %.2f), peak %.2f, %.1fx the sidelobes, %llu blocks\n",
+               result->rx_a, result->rx_b, result->delay_samples, expected, result->peak,
+               result->peak_ratio, (unsigned long long)result->blocks);
+        ok = fabs(result->delay_samples - expected) < 0.2 && result->peak_ratio > 3.0;
+    }
+    ok = ok && results[0].rx_a == 0 && results[0].rx_b == 1 && results[2].rx_a == 1 && results[2].rx_b == 2;
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Delay off by 0.2 samples or more");
+    }
+    TEST_END();
+}
+
+// Thread count and push sizes do not change a bit of the result
+void test_threads_and_chunks() {
+    TEST_START("Threads And Push Sizes");
+
+    gcc_phat_result_t one[6], many[6], odd[6];
+    bool ok = run_engine(1, SAMPLES, one) && run_engine(4, SAMPLES, many) && run_engine(3, 1237, odd);
+    for (int p = 0; ok && p < 3; p++) {
+        ok = one[p].delay_samples == many[p].delay_samples && one[p].peak == many[p].peak &&
+             one[p].delay_samples == odd[p].delay_samples && one[p].blocks == odd[p].blocks;
+    }
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Results depend on threads or push sizes");
+    }
+    TEST_END();
+}
+
+// Bad receiver counts, lags and FFT sizes are refused
+void test_config() {
+    TEST_START("Configuration Checks");
+
+    gcc_phat_config_t one = { .num_receivers = 1, .max_lag = 16 };
+    gcc_phat_config_t no_lag = { .num_receivers = 2, .max_lag = 0 };
+    gcc_phat_config_t small = { .num_receivers = 2, .max_lag = 512, .fft_size = 1024 };
+    gcc_phat_config_t odd = { .num_receivers = 2, .max_lag = 16, .fft_size = 1000 };
+    gcc_phat_config_t many = { .num_receivers = GCC_PHAT_MAX_RECEIVERS + 1, .max_lag = 16 };
+    bool ok = !gcc_phat_create(&one) && !gcc_phat_create(&no_lag) && !gcc_phat_create(&small) &&
+              !gcc_phat_create(&odd) && !gcc_phat_create(&many) && !gcc_phat_create(NULL);
+
+    gcc_phat_config_t automatic = { .num_receivers = 2, .max_lag = 300, .num_threads = 1 };
+    gcc_phat_t *engine = gcc_phat_create(&automatic);
+    ok = ok && engine && engine->config.fft_size == 4096 && engine->block_samples == 4096 - 600;
+    gcc_phat_destroy(engine);
+    gcc_phat_destroy(NULL);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Invalid configuration accepted");
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - GCC-PHAT Unit Tests\n");
+    printf("=====================================\n\n");
+
+    if (!make_receivers()) {
+        printf("Cannot build the test signals\n");
+        return EXIT_FAILURE;
+    }
+    test_delays();
+    test_threads_and_chunks();
+    test_config();
+    for (int r = 0; r < RECEIVERS; r++) free(iq[r]);
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
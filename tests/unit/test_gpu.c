@@ -0,0 +1,223 @@
+/*
+ * IQ Lab - GPU Backend Unit Tests
+ *
+ * Tests for the STFT backend hook and the optional OpenCL backend: a
+ * backend must receive whole batches, a failing one must hand the batch
+ * back to the pool (same rows as without it) and be dropped, and a build
+ * or machine without a device must report it and stay usable. When a
+ * device is present its rows and CFAR thresholds must match the CPU within
+ * float rounding, across chunk boundaries and for every sample layout.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/iq_core/fft.h"
+#include "../../src/iq_core/stft.h"
+#include "../../src/iq_core/gpu.h"
+#include "../../src/detect/cfar_ca.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TEST_FFT 256
+#define TEST_HOP 64
+
+// Deterministic pseudo-random stream
+static uint32_t rng_state = 2024;
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+// Interleaved s16 tone plus noise and its float conversion (x / 32768)
+static void make_samples(size_t count, int16_t *s16, float *f32) {
+    for (size_t i = 0; i < count; i++) {
+        double phase = 2.0 * M_PI * 0.125 * (double)i;
+        s16[2 * i] = (int16_t)lrint(9000.0 * cos(phase) + (double)(next_random() % 512) - 256.0);
+        s16[2 * i + 1] = (int16_t)lrint(9000.0 * sin(phase) + (double)(next_random() % 512) - 256.0);
+    }
+    for (size_t i = 0; i < 2 * count; i++) f32[i] = (float)s16[i] / 32768.0f;
+}
+
+typedef struct {
+    uint32_t calls;
+    uint32_t frames;
+    bool fail;
+} fake_backend_t;
+
+static bool fake_rows(void *backend, const float *iq, uint32_t num_frames, size_t hop,
+                      float *rows, bool db) {
+    fake_backend_t *fake = backend;
+    (void)iq; (void)hop; (void)db;
+    fake->calls++;
+    fake->frames += num_frames;
+    if (fake->fail) return false;
+    for (size_t i = 0; i < (size_t)num_frames * TEST_FFT; i++) rows[i] = 7.0f;
+    return true;
+}
+
+static void test_backend_hook(void) {
+    printf("Testing STFT backend hook...\n");
+
+    const uint32_t frames = 40;
+    const size_t count = (size_t)(frames - 1) * TEST_HOP + TEST_FFT;
+    int16_t *s16 = malloc(count * 2 * sizeof(int16_t));
+    float *iq = malloc(count * 2 * sizeof(float));
+    float *ref = malloc((size_t)frames * TEST_FFT * sizeof(float));
+    float *rows = malloc((size_t)frames * TEST_FFT * sizeof(float));
+    assert(s16 && iq && ref && rows);
+    make_samples(count, s16, iq);
+
+    fft_plan_f32_t *plan = fft_plan_f32_create(TEST_FFT, FFT_FORWARD);
+    assert(plan);
+    stft_t *stft = stft_create(plan, NULL, 2);
+    assert(stft);
+    assert(stft_rows(stft, iq, frames, TEST_HOP, ref, false));
+
+    // Whole batches go to the backend
+    fake_backend_t fake = { 0, 0, false };
+    stft_set_backend(stft, fake_rows, &fake);
+    assert(stft_rows(stft, iq, frames, TEST_HOP, rows, false));
+    assert(fake.calls == 1 && fake.frames == frames && rows[5] == 7.0f);
+
+    // A failure is redone on the pool and the backend is dropped
+    fake.fail = true;
+    memset(rows, 0, (size_t)frames * TEST_FFT * sizeof(float));
+    assert(stft_rows(stft, iq, frames, TEST_HOP, rows, false));
+    assert(memcmp(rows, ref, (size_t)frames * TEST_FFT * sizeof(float)) == 0);
+    assert(stft->backend_rows == NULL);
+    assert(stft_rows(stft, iq, frames, TEST_HOP, rows, false));
+    assert(fake.calls == 2);
+
+    // Clearing restores the pool
+    fake.fail = false;
+    stft_set_backend(stft, fake_rows, &fake);
+    stft_set_backend(stft, NULL, &fake);
+    assert(stft_rows(stft, iq, frames, TEST_HOP, rows, false) && fake.calls == 2);
+    assert(stft->backend == NULL);
+
+    stft_destroy(stft);
+    fft_plan_f32_destroy(plan);
+    free(s16);
+    free(iq);
+    free(ref);
+    free(rows);
+    printf("✓ Backend hook test passed\n");
+}
+
+// Largest |a - b| relative to the largest |b| of each row
+static double max_row_error(const float *a, const float *b, uint32_t frames) {
+    double worst = 0.0;
+    for (uint32_t f = 0; f < frames; f++) {
+        double peak = 0.0, err = 0.0;
+        for (uint32_t k = 0; k < TEST_FFT; k++) {
+            size_t i = (size_t)f * TEST_FFT + k;
+            if (fabs(b[i]) > peak) peak = fabs(b[i]);
+            if (fabs((double)a[i] - b[i]) > err) err = fabs((double)a[i] - b[i]);
+        }
+        if (peak > 0.0 && err / peak > worst) worst = err / peak;
+    }
+    return worst;
+}
+
+static void test_device(void) {
+    printf("Testing OpenCL device path...\n");
+
+    // Unusable handles are rejected without a device
+    assert(gpu_stft_create(NULL, TEST_FFT, NULL, GPU_SAMPLES_F32) == NULL);
+    assert(!gpu_stft_rows(NULL, NULL, 1, TEST_HOP, NULL, false, NULL));
+    assert(!gpu_stft_backend_rows(NULL, NULL, 1, TEST_HOP, NULL, false));
+    gpu_stft_destroy(NULL);
+    gpu_close(NULL);
+
+    gpu_context_t *gpu = gpu_open(NULL);
+    if (!gpu) {
+        printf("  No OpenCL device (%s); CPU fallback only\n",
+               gpu_compiled() ? "backend built" : "backend not built");
+        printf("✓ Device path test passed\n");
+        return;
+    }
+    printf("  Device: %s\n", gpu_device_name(gpu));
+    assert(gpu_stft_create(gpu, 1000, NULL, GPU_SAMPLES_F32) == NULL);   // Not a power of two
+
+    // More frames than one chunk, so both buffer sets take turns
+    const uint32_t frames = GPU_STFT_CHUNK_BINS / TEST_FFT + 517;
+    const size_t count = (size_t)(frames - 1) * TEST_HOP + TEST_FFT;
+    int16_t *s16 = malloc(count * 2 * sizeof(int16_t));
+    float *iq = malloc(count * 2 * sizeof(float));
+    float *ref = malloc((size_t)frames * TEST_FFT * sizeof(float));
+    float *rows = malloc((size_t)frames * TEST_FFT * sizeof(float));
+    float *thresholds = malloc((size_t)frames * TEST_FFT * sizeof(float));
+    double *row64 = malloc(TEST_FFT * sizeof(double));
+    assert(s16 && iq && ref && rows && thresholds && row64);
+    make_samples(count, s16, iq);
+
+    float window[TEST_FFT];
+    for (uint32_t i = 0; i < TEST_FFT; i++) window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / TEST_FFT));
+
+    fft_plan_f32_t *plan = fft_plan_f32_create(TEST_FFT, FFT_FORWARD);
+    assert(plan);
+    assert(fft_spectral_batch(plan, iq, frames, TEST_HOP, window, ref, false));
+
+    // Float and s16 input give the CPU rows to float rounding
+    gpu_stft_t *f32 = gpu_stft_create(gpu, TEST_FFT, window, GPU_SAMPLES_F32);
+    gpu_stft_t *i16 = gpu_stft_create(gpu, TEST_FFT, window, GPU_SAMPLES_S16);
+    assert(f32 && i16);
+    assert(gpu_stft_rows(f32, iq, frames, TEST_HOP, rows, false, NULL));
+    assert(max_row_error(rows, ref, frames) < 1e-4);
+    assert(gpu_stft_rows(i16, s16, frames, TEST_HOP, rows, false, NULL));
+    assert(max_row_error(rows, ref, frames) < 1e-4);
+    assert(!gpu_stft_rows(f32, iq, frames, TEST_HOP, rows, false, thresholds));   // No CFAR stage yet
+
+    // Mean-level thresholds against cfar_ca_get_threshold
+    cfar_ca_t cfar;
+    assert(cfar_ca_init(&cfar, TEST_FFT, 1e-4, 8, 2, CFAR_MODE_GO));
+    assert(gpu_stft_set_cfar(i16, 8, 2, CFAR_MODE_GO, cfar.alpha));
+    assert(gpu_stft_rows(i16, s16, frames, TEST_HOP, rows, false, thresholds));
+    for (uint32_t f = 0; f < frames; f += 97) {
+        for (uint32_t k = 0; k < TEST_FFT; k++) row64[k] = rows[(size_t)f * TEST_FFT + k];
+        for (uint32_t k = 0; k < TEST_FFT; k++) {
+            double expected = cfar_ca_get_threshold(&cfar, row64, k);
+            assert(fabs(thresholds[(size_t)f * TEST_FFT + k] - expected) <= 1e-4 * expected + 1e-12);
+        }
+    }
+
+    // dB rows through the stft backend hook
+    stft_t *stft = stft_create(plan, window, 1);
+    assert(stft);
+    assert(fft_spectral_batch(plan, iq, 300, TEST_HOP, window, ref, true));
+    stft_set_backend(stft, gpu_stft_backend_rows, f32);
+    assert(stft_rows(stft, iq, 300, TEST_HOP, rows, true) && stft->backend_rows);
+    for (size_t i = 0; i < (size_t)300 * TEST_FFT; i++) {
+        if (ref[i] > -60.0f) assert(fabsf(rows[i] - ref[i]) < 0.01f);
+    }
+
+    stft_destroy(stft);
+    cfar_ca_free(&cfar);
+    gpu_stft_destroy(f32);
+    gpu_stft_destroy(i16);
+    gpu_close(gpu);
+    fft_plan_f32_destroy(plan);
+    free(s16);
+    free(iq);
+    free(ref);
+    free(rows);
+    free(thresholds);
+    free(row64);
+    printf("✓ Device path test passed\n");
+}
+
+int main(void) {
+    printf("=== GPU Backend Unit Tests ===\n\n");
+
+    test_backend_hook();
+    test_device();
+
+    printf("\n✓ All GPU backend tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * IQ Lab - Huge-Page Allocator Unit Tests
+ *
+ * Tests for hugepage.h: blocks of every size come back zeroed, aligned and
+ * writable end to end; small blocks and the "off" mode stay on the heap
+ * while large ones are mapped (explicit mode falls back when no huge pages
+ * are reserved); mode names round-trip; and an FFT plan and scratch arena
+ * on huge pages transform exactly as they do on the heap.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/iq_core/hugepage.h"
+#include "../../src/iq_core/arena.h"
+#include "../../src/iq_core/fft.h"
+
+static void check_block(uint8_t *block, size_t bytes) {
+    assert(block);
+    assert(((uintptr_t)block & (IQ_HUGE_ALIGN - 1)) == 0);
+    for (size_t i = 0; i < bytes; i += 4093) assert(block[i] == 0);
+    assert(block[bytes - 1] == 0);
+    memset(block, 0xA5, bytes);
+    assert(block[0] == 0xA5 && block[bytes - 1] == 0xA5);
+}
+
+static void test_hugepage_modes(void) {
+    printf("Testing mode names...\n");
+
+    const char *const names[3] = {"off", "thp", "explicit"};
+    for (int i = 0; i < 3; i++) {
+        iq_huge_mode_t mode;
+        assert(iq_huge_mode_from_name(names[i], &mode));
+        assert(strcmp(iq_huge_mode_name(mode), names[i]) == 0);
+    }
+    iq_huge_mode_t mode = IQ_HUGE_THP;
+    assert(!iq_huge_mode_from_name("always", &mode) && mode == IQ_HUGE_THP);
+    assert(!iq_huge_mode_from_name(NULL, &mode));
+
+    size_t page = iq_huge_page_size();
+    assert(page >= 4096 && (page & (page - 1)) == 0);
+
+    printf("✓ Mode tests passed\n");
+}
+
+static void test_hugepage_alloc(void) {
+    printf("Testing allocation...\n");
+
+    const size_t sizes[5] = {1, 100, IQ_HUGE_MIN_BYTES - 1, IQ_HUGE_MIN_BYTES, 9 * iq_huge_page_size() + 12345};
+    const iq_huge_mode_t modes[3] = {IQ_HUGE_OFF, IQ_HUGE_THP, IQ_HUGE_EXPLICIT};
+    for (int m = 0; m < 3; m++) {
+        iq_huge_set_mode(modes[m]);
+        assert(iq_huge_mode() == modes[m]);
+        for (int s = 0; s < 5; s++) {
+            uint8_t *block = iq_huge_alloc(sizes[s]);
+            check_block(block, sizes[s]);
+            iq_page_kind_t kind = iq_huge_kind(block);
+            if (modes[m] == IQ_HUGE_OFF || sizes[s] < IQ_HUGE_MIN_BYTES) {
+                assert(kind == IQ_PAGES_HEAP);
+            }
+#ifdef __linux__
+            // Large blocks are always mapped; explicit falls back to thp
+            if (modes[m] == IQ_HUGE_THP && sizes[s] >= IQ_HUGE_MIN_BYTES) {
+                assert(kind == IQ_PAGES_TRANSPARENT || kind == IQ_PAGES_SMALL);
+            }
+            if (modes[m] == IQ_HUGE_EXPLICIT && sizes[s] >= IQ_HUGE_MIN_BYTES) {
+                assert(kind != IQ_PAGES_HEAP);
+            }
+#endif
+            assert(strcmp(iq_page_kind_name(kind), "unknown") != 0);
+            iq_huge_free(block);
+        }
+    }
+
+    // Many live blocks at once, freed out of order
+    iq_huge_set_mode(IQ_HUGE_THP);
+    uint8_t *blocks[8];
+    for (int i = 0; i < 8; i++) {
+        blocks[i] = iq_huge_alloc((size_t)(i + 1) * IQ_HUGE_MIN_BYTES / 2);
+        check_block(blocks[i], (size_t)(i + 1) * IQ_HUGE_MIN_BYTES / 2);
+    }
+    for (int i = 0; i < 8; i += 2) iq_huge_free(blocks[i]);
+    for (int i = 1; i < 8; i += 2) iq_huge_free(blocks[i]);
+
+    iq_huge_free(NULL);
+    assert(iq_huge_kind(NULL) == IQ_PAGES_HEAP);
+
+    printf("✓ Allocation tests passed\n");
+}
+
+// A large plan and its scratch arena give the same transform in every mode
+static void test_hugepage_fft(void) {
+    printf("Testing FFT tables on huge pages...\n");
+
+    const uint32_t size = 1u << 18;
+    fft_complex_f32_t *input = malloc(size * sizeof(*input));
+    fft_complex_f32_t *outputs[2];
+    assert(input);
+    for (uint32_t i = 0; i < size; i++) input[i] = (float)cos(0.001 * i) + (float)sin(0.003 * i) * I;
+
+    const iq_huge_mode_t modes[2] = {IQ_HUGE_OFF, IQ_HUGE_THP};
+    for (int m = 0; m < 2; m++) {
+        iq_huge_set_mode(modes[m]);
+        iq_arena_t arena;
+        assert(iq_arena_init(&arena, fft_scratch_bytes(size)));
+        if (modes[m] == IQ_HUGE_OFF) assert(iq_huge_kind(arena.storage) == IQ_PAGES_HEAP);
+        iq_arena_t *previous = iq_arena_bind(&arena);
+
+        fft_plan_f32_t *plan = fft_plan_f32_create(size, FFT_FORWARD);
+        outputs[m] = malloc(size * sizeof(*input));
+        assert(plan && outputs[m]);
+        assert(fft_execute_f32(plan, input, outputs[m]));
+        fft_plan_f32_destroy(plan);
+
+        fft_release_thread_buffers();
+        iq_arena_bind(previous);
+        iq_arena_free(&arena);
+    }
+    assert(memcmp(outputs[0], outputs[1], size * sizeof(*input)) == 0);
+
+    free(outputs[0]);
+    free(outputs[1]);
+    free(input);
+
+    printf("✓ FFT tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running Huge-Page Allocator Unit Tests\n");
+    printf("======================================\n\n");
+
+    test_hugepage_modes();
+    test_hugepage_alloc();
+    test_hugepage_fft();
+
+    printf("\n======================================\n");
+    printf("All huge-page allocator tests passed! ✓\n");
+    printf("======================================\n");
+    return 0;
+}
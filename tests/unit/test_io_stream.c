@@ -0,0 +1,381 @@
+/*
+ * IQ Lab - Live Stream Source Unit Tests
+ *
+ * Tests for the pipe and socket sources behind iq_reader_t
+ * Covers stream name parsing, a raw TCP server, an rtl_tcp server (header,
+ * tuning commands, offset-binary samples), UDP datagrams and a named pipe
+ * read through iq_reader_open with a forward seek
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // mkfifo, getaddrinfo under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../../src/iq_core/io_iq.h"
+#include "../../src/iq_core/io_stream.h"
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { TEST_SAMPLES = 50000 };
+
+// Names the reader should and should not take for live sources
+void test_stream_names() {
+    TEST_START("Stream Names");
+
+    bool ok = iq_stream_is_spec("-") && iq_stream_is_spec("-?format=s8") &&
+              iq_stream_is_spec("stdin") && iq_stream_is_spec("tcp://localhost:1234") &&
+              iq_stream_is_spec("rtltcp://127.0.0.1:1234?rate=2048000") &&
+              iq_stream_is_spec("udp://:5000");
+    if (iq_stream_is_spec("capture.s16") || iq_stream_is_spec("-x") ||
+        iq_stream_is_spec("stdin.s8") || iq_stream_is_spec("http://host:80")) ok = false;
+
+    // Malformed specs fail to open without touching the network
+    iq_format_t format = IQ_FORMAT_S16;
+    uint32_t rate = 0;
+    if (iq_stream_open("tcp://nohostport", &format, &rate) ||
+        iq_stream_open("tcp://localhost:1?format=s7", &format, &rate) ||
+        iq_stream_open("udp://:1?speed=3", &format, &rate) ||
+        iq_stream_open("rtltcp://localhost:1?format=s16", &format, &rate)) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Stream names misclassified");
+    }
+    TEST_END();
+}
+
+#ifndef _WIN32
+
+// Listening TCP socket on a free loopback port
+static int listen_loopback(int type, uint16_t *port) {
+    int fd = socket(AF_INET, type, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        (type == SOCK_STREAM && listen(fd, 1) != 0) ||
+        getsockname(fd, (struct sockaddr *)&address, &length) != 0) {
+        close(fd);
+        return -1;
+    }
+    *port = ntohs(address.sin_port);
+    return fd;
+}
+
+typedef struct {
+    int listener;
+    bool rtl;               // Send the rtl_tcp header and read commands
+    uint8_t commands[10];   // What an rtl_tcp client sent after the header
+    size_t command_bytes;
+} server_t;
+
+// Serve TEST_SAMPLES samples (s16 ramp, or rtl_tcp u8) in uneven pieces
+static void *serve(void *arg) {
+    server_t *server = (server_t *)arg;
+    int fd = accept(server->listener, NULL, NULL);
+    if (fd < 0) return NULL;
+
+    if (server->rtl) {
+        uint8_t header[12] = {'R', 'T', 'L', '0', 0, 0, 0, 5, 0, 0, 0, 29};
+        send(fd, header, sizeof(header), 0);
+        while (server->command_bytes < sizeof(server->commands)) {
+            ssize_t n = recv(fd, server->commands + server->command_bytes,
+                             sizeof(server->commands) - server->command_bytes, 0);
+            if (n <= 0) break;
+            server->command_bytes += (size_t)n;
+        }
+    }
+
+    size_t value_bytes = server->rtl ? 1 : 2;
+    size_t total = (size_t)TEST_SAMPLES * 2 * value_bytes;
+    uint8_t *data = (uint8_t *)malloc(total);
+    for (size_t i = 0; i < (size_t)TEST_SAMPLES * 2; i++) {
+        if (server->rtl) {
+            data[i] = (uint8_t)(i & 0xFF);
+        } else {
+            int16_t v = (int16_t)(i % 30000);
+            memcpy(data + i * 2, &v, 2);
+        }
+    }
+    size_t sent = 0;
+    size_t piece = 1;
+    while (sent < total) {
+        size_t n = total - sent < piece ? total - sent : piece;
+        ssize_t w = send(fd, data + sent, n, 0);
+        if (w <= 0) break;
+        sent += (size_t)w;
+        piece = piece * 3 + 7;
+        if (piece > 40000) piece = 5;
+    }
+    free(data);
+    close(fd);
+    return NULL;
+}
+
+// Samples arrive whole and in order however the server splits them, and
+// the reader ends when the server closes
+void test_tcp_stream() {
+    TEST_START("TCP Stream");
+
+    server_t server = {0};
+    uint16_t port = 0;
+    server.listener = listen_loopback(SOCK_STREAM, &port);
+    pthread_t thread;
+    if (server.listener < 0 || pthread_create(&thread, NULL, serve, &server) != 0) {
+        TEST_FAIL("Could not start server");
+        return;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "tcp://127.0.0.1:%u?rate=1e6", (unsigned)port);
+    iq_reader_t reader;
+    bool ok = iq_reader_open(&reader, name);
+    size_t total = 0;
+    if (ok) {
+        if (reader.format != IQ_FORMAT_S16 || reader.sample_rate != 1000000 ||
+            reader.total_samples != 0) ok = false;
+        int16_t buffer[2 * 777];
+        size_t n;
+        while ((n = iq_read_native(&reader, buffer, 777)) > 0) {
+            for (size_t i = 0; i < n * 2; i++) {
+                if (buffer[i] != (int16_t)((total * 2 + i) % 30000)) ok = false;
+            }
+            total += n;
+        }
+        iq_reader_close(&reader);
+    }
+    pthread_join(thread, NULL);
+    close(server.listener);
+    if (total != TEST_SAMPLES) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %zu samples over TCP\n", total);
+    } else {
+        TEST_FAIL("TCP samples lost or reordered");
+        printf("    %zu of %d samples\n", total, TEST_SAMPLES);
+    }
+    TEST_END();
+}
+
+// The rtl_tcp header is skipped, the rate and frequency are sent as
+// big-endian commands, and unsigned bytes come out as s8
+void test_rtltcp_stream() {
+    TEST_START("rtl_tcp Stream");
+
+    server_t server = {0};
+    server.rtl = true;
+    uint16_t port = 0;
+    server.listener = listen_loopback(SOCK_STREAM, &port);
+    pthread_t thread;
+    if (server.listener < 0 || pthread_create(&thread, NULL, serve, &server) != 0) {
+        TEST_FAIL("Could not start server");
+        return;
+    }
+
+    char name[96];
+    snprintf(name, sizeof(name), "rtltcp://127.0.0.1:%u?rate=2048000&freq=100000000", (unsigned)port);
+    iq_reader_t reader;
+    bool ok = iq_reader_open(&reader, name);
+    size_t total = 0;
+    if (ok) {
+        if (reader.format != IQ_FORMAT_S8 || reader.sample_rate != 2048000) ok = false;
+        float buffer[2 * 1000];
+        size_t n;
+        while ((n = iq_read_samples(&reader, buffer, 1000)) > 0) {
+            for (size_t i = 0; i < n * 2; i++) {
+                int expected = (int)((total * 2 + i) & 0xFF) - 128;
+                if (buffer[i] != (float)expected / 128.0f) ok = false;
+            }
+            total += n;
+        }
+        iq_reader_close(&reader);
+    }
+    pthread_join(thread, NULL);
+    close(server.listener);
+
+    const uint8_t commands[10] = {0x02, 0x00, 0x1F, 0x40, 0x00, 0x01, 0x05, 0xF5, 0xE1, 0x00};
+    if (server.command_bytes != sizeof(commands) || memcmp(server.commands, commands, sizeof(commands)) != 0 ||
+        total != TEST_SAMPLES) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %zu samples, rate and frequency commands sent\n", total);
+    } else {
+        TEST_FAIL("rtl_tcp handshake or samples wrong");
+        printf("    %zu of %d samples, %zu command bytes\n", total, TEST_SAMPLES, server.command_bytes);
+    }
+    TEST_END();
+}
+
+// Datagrams are handed out across reads of any size
+void test_udp_stream() {
+    TEST_START("UDP Stream");
+
+    // Find a free port, then let the reader bind it
+    uint16_t port = 0;
+    int probe = listen_loopback(SOCK_DGRAM, &port);
+    if (probe < 0) {
+        TEST_FAIL("No free UDP port");
+        return;
+    }
+    close(probe);
+
+    char name[64];
+    snprintf(name, sizeof(name), "udp://127.0.0.1:%u?format=s8", (unsigned)port);
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, name)) {
+        TEST_FAIL("Could not bind UDP stream");
+        return;
+    }
+
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    // Four datagrams of 250 samples, small enough for any loopback buffer
+    for (int d = 0; d < 4; d++) {
+        int8_t datagram[500];
+        for (int i = 0; i < 500; i++) datagram[i] = (int8_t)((d * 500 + i) % 100);
+        sendto(sender, datagram, sizeof(datagram), 0, (struct sockaddr *)&address, sizeof(address));
+    }
+    close(sender);
+
+    bool ok = reader.format == IQ_FORMAT_S8;
+    int8_t buffer[2 * 300];
+    size_t total = 0;
+    while (total < 1000) {
+        size_t want = 1000 - total < 300 ? 1000 - total : 300;
+        size_t n = iq_read_native(&reader, buffer, want);
+        if (n != want) {
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < n * 2; i++) {
+            if (buffer[i] != (int8_t)((total * 2 + i) % 100)) ok = false;
+        }
+        total += n;
+    }
+    iq_reader_close(&reader);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %zu samples from 4 datagrams\n", total);
+    } else {
+        TEST_FAIL("UDP samples lost or reordered");
+    }
+    TEST_END();
+}
+
+static const char *TEST_FIFO = "test_io_stream_fifo.s8";
+
+static void *write_fifo(void *arg) {
+    (void)arg;
+    FILE *f = fopen(TEST_FIFO, "wb");
+    if (!f) return NULL;
+    for (int i = 0; i < TEST_SAMPLES * 2; i++) fputc(i % 120, f);
+    fclose(f);
+    return NULL;
+}
+
+// A named pipe takes its format from its name and seeks forward by reading
+void test_named_pipe() {
+    TEST_START("Named Pipe");
+
+    remove(TEST_FIFO);
+    pthread_t thread;
+    if (mkfifo(TEST_FIFO, 0600) != 0 || pthread_create(&thread, NULL, write_fifo, NULL) != 0) {
+        TEST_FAIL("Could not create FIFO");
+        remove(TEST_FIFO);
+        return;
+    }
+
+    iq_reader_t reader;
+    bool ok = iq_reader_open(&reader, TEST_FIFO);
+    size_t total = 0;
+    if (ok) {
+        if (reader.format != IQ_FORMAT_S8 || reader.stream == NULL) ok = false;
+        if (!iq_reader_seek_sample(&reader, 1000) || reader.position != 1000) ok = false;
+        if (iq_reader_seek_sample(&reader, 10)) ok = false;  // Never backwards
+        total = 1000;
+        int8_t buffer[2 * 4096];
+        size_t n;
+        while ((n = iq_read_native(&reader, buffer, 4096)) > 0) {
+            for (size_t i = 0; i < n * 2; i++) {
+                if (buffer[i] != (int8_t)((total * 2 + i) % 120)) ok = false;
+            }
+            total += n;
+        }
+        iq_reader_close(&reader);
+    }
+    pthread_join(thread, NULL);
+    remove(TEST_FIFO);
+    if (total != TEST_SAMPLES) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %zu samples through a FIFO, skip included\n", total);
+    } else {
+        TEST_FAIL("FIFO samples wrong");
+        printf("    %zu of %d samples\n", total, TEST_SAMPLES);
+    }
+    TEST_END();
+}
+
+#endif // !_WIN32
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Live Stream Source Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_stream_names();
+#ifndef _WIN32
+    test_tcp_stream();
+    test_rtltcp_stream();
+    test_udp_stream();
+    test_named_pipe();
+#endif
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
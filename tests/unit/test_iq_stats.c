@@ -0,0 +1,150 @@
+/*
+ * IQ Lab - Whole-File Statistics Unit Tests
+ *
+ * Tests for iq_stats: the full pass must match a direct computation over
+ * the file for any thread count; the sampled estimate must cover small
+ * files exactly and stay close on a stationary signal while reading only
+ * its fixed block budget; and unreadable files must be refused.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/iq_core/io_iq.h"
+#include "../../src/iq_core/iq_stats.h"
+
+#define TEST_FILE "test_iq_stats.s16"
+
+// Deterministic pseudo-random stream
+static uint32_t rng_state = 777;
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+// Tone with a DC offset and a little noise, written as s16; returns direct figures
+static void write_capture(size_t samples, iq_stats_t *expected) {
+    int16_t *values = malloc(samples * 2 * sizeof(int16_t));
+    assert(values);
+    for (size_t i = 0; i < samples; i++) {
+        double phase = 0.0021 * (double)i;
+        values[2 * i] = (int16_t)lrint(8000.0 * cos(phase) + 600.0 + (double)(next_random() % 64) - 32.0);
+        values[2 * i + 1] = (int16_t)lrint(8000.0 * sin(phase) - 300.0 + (double)(next_random() % 64) - 32.0);
+    }
+    values[1234] = -32768;   // One full-scale value for the peak
+
+    double sum_sq = 0.0, sum_i = 0.0, sum_q = 0.0, peak = 0.0;
+    for (size_t i = 0; i < samples; i++) {
+        double vi = values[2 * i] / 32768.0, vq = values[2 * i + 1] / 32768.0;
+        sum_sq += vi * vi + vq * vq;
+        sum_i += vi;
+        sum_q += vq;
+        if (fabs(vi) > peak) peak = fabs(vi);
+        if (fabs(vq) > peak) peak = fabs(vq);
+    }
+    expected->total_samples = samples;
+    expected->samples_used = samples;
+    expected->rms = sqrt(sum_sq / (double)(samples * 2));
+    expected->dc_i = sum_i / (double)samples;
+    expected->dc_q = sum_q / (double)samples;
+    expected->peak = peak;
+
+    FILE *f = fopen(TEST_FILE, "wb");
+    assert(f);
+    assert(fwrite(values, sizeof(int16_t), samples * 2, f) == samples * 2);
+    fclose(f);
+    free(values);
+}
+
+static void test_full_stats(void) {
+    printf("Testing full statistics...\n");
+
+    iq_stats_t expected;
+    write_capture(1000003, &expected);
+
+    const uint32_t threads[] = { 1, 3, 8, 0 };
+    iq_stats_t first;
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        iq_stats_t stats;
+        assert(iq_stats_full(TEST_FILE, threads[t], &stats));
+        if (t == 0) first = stats;
+        assert(memcmp(&stats, &first, sizeof(stats)) == 0);   // Same bits for any thread count
+        assert(stats.total_samples == expected.total_samples);
+        assert(stats.samples_used == expected.total_samples);
+        assert(fabs(stats.rms - expected.rms) < 1e-12);
+        assert(fabs(stats.dc_i - expected.dc_i) < 1e-12);
+        assert(fabs(stats.dc_q - expected.dc_q) < 1e-12);
+        assert(stats.peak == 1.0);
+    }
+
+    // Same thread count, same bits
+    iq_stats_t a, b;
+    assert(iq_stats_full(TEST_FILE, 5, &a) && iq_stats_full(TEST_FILE, 5, &b));
+    assert(memcmp(&a, &b, sizeof(a)) == 0);
+
+    printf("✓ Full statistics test passed\n");
+}
+
+static void test_sampled_stats(void) {
+    printf("Testing sampled statistics...\n");
+
+    // Larger than the block budget: only the budget is read
+    iq_stats_t expected;
+    write_capture(3000017, &expected);
+    iq_stats_t stats;
+    assert(iq_stats_sampled(TEST_FILE, IQ_STATS_SAMPLED_BLOCKS, IQ_STATS_SAMPLED_BLOCK_SAMPLES, &stats));
+    assert(stats.total_samples == expected.total_samples);
+    assert(stats.samples_used == (uint64_t)IQ_STATS_SAMPLED_BLOCKS * IQ_STATS_SAMPLED_BLOCK_SAMPLES);
+    assert(fabs(20.0 * log10(stats.rms / expected.rms)) < 0.1);
+    assert(fabs(stats.dc_i - expected.dc_i) < 2e-3);
+    assert(fabs(stats.dc_q - expected.dc_q) < 2e-3);
+
+    // A single block sits mid-file
+    assert(iq_stats_sampled(TEST_FILE, 1, 1000, &stats));
+    assert(stats.samples_used == 1000);
+
+    // Small file: every sample, same figures as the full pass
+    write_capture(50000, &expected);
+    assert(iq_stats_sampled(TEST_FILE, IQ_STATS_SAMPLED_BLOCKS, IQ_STATS_SAMPLED_BLOCK_SAMPLES, &stats));
+    assert(stats.samples_used == expected.total_samples);
+    assert(fabs(stats.rms - expected.rms) < 1e-12);
+    assert(stats.peak == 1.0);
+
+    printf("✓ Sampled statistics test passed\n");
+}
+
+static void test_errors(void) {
+    printf("Testing error handling...\n");
+
+    iq_stats_t stats;
+    assert(!iq_stats_full("nonexistent_stats.iq", 2, &stats));
+    assert(!iq_stats_sampled("nonexistent_stats.iq", 4, 16, &stats));
+    assert(!iq_stats_sampled(TEST_FILE, 0, 16, &stats));
+    assert(!iq_stats_full(NULL, 1, &stats));
+
+    // Empty file: zero samples, zero figures
+    FILE *f = fopen(TEST_FILE, "wb");
+    assert(f);
+    fclose(f);
+    if (iq_stats_full(TEST_FILE, 4, &stats)) {
+        assert(stats.total_samples == 0 && stats.samples_used == 0 && stats.rms == 0.0);
+    }
+
+    printf("✓ Error handling test passed\n");
+}
+
+int main(void) {
+    printf("=== IQ Statistics Unit Tests ===\n\n");
+
+    test_full_stats();
+    test_sampled_stats();
+    test_errors();
+
+    remove(TEST_FILE);
+
+    printf("\n✓ All IQ statistics tests passed!\n");
+    return 0;
+}
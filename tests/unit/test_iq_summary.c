@@ -0,0 +1,223 @@
+/*
+ * IQ Lab - Summary Sidecar Unit Tests
+ *
+ * Tests for iq_summary: totals must match iq_stats_full and a direct clip
+ * count, blocks and spectra must not depend on the thread count, a tone
+ * must show up in its bin, the sidecar must round-trip through the file
+ * and be ignored once the capture changes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/iq_core/io_iq.h"
+#include "../../src/iq_core/iq_stats.h"
+#include "../../src/iq_core/iq_summary.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TEST_FILE "test_iq_summary.s16"
+#define TEST_SAMPLES 1000003
+#define TEST_FFT 256
+#define TEST_TONE_BIN 32
+
+// Deterministic pseudo-random stream
+static uint32_t rng_state = 4242;
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+// Tone in bin TEST_TONE_BIN plus noise, with 'clips' full-scale values; returns the clip count
+static uint64_t write_capture(size_t samples, size_t clips) {
+    int16_t *values = malloc(samples * 2 * sizeof(int16_t));
+    assert(values);
+    for (size_t i = 0; i < samples; i++) {
+        double phase = 2.0 * M_PI * TEST_TONE_BIN / TEST_FFT * (double)i;
+        values[2 * i] = (int16_t)lrint(6000.0 * cos(phase) + 200.0 + (double)(next_random() % 128) - 64.0);
+        values[2 * i + 1] = (int16_t)lrint(6000.0 * sin(phase) + (double)(next_random() % 128) - 64.0);
+    }
+    for (size_t c = 0; c < clips; c++) {
+        values[(c * 7919) % (samples * 2)] = (c & 1) ? -32768 : 32767;
+    }
+
+    uint64_t clipped = 0;
+    for (size_t i = 0; i < samples * 2; i++) {
+        clipped += values[i] == 32767 || values[i] == -32768;
+    }
+
+    FILE *f = fopen(TEST_FILE, "wb");
+    assert(f);
+    assert(fwrite(values, sizeof(int16_t), samples * 2, f) == samples * 2);
+    fclose(f);
+    free(values);
+    return clipped;
+}
+
+static void test_params(iq_summary_params_t *params, uint32_t threads) {
+    iq_summary_default_params(params);
+    params->block_samples = 4096;
+    params->fft_size = TEST_FFT;
+    params->spectrum_seconds = 0.1;
+    params->sample_rate = 1000000;
+    params->num_threads = threads;
+}
+
+static void test_build(void) {
+    printf("Testing summary build...\n");
+
+    uint64_t clipped = write_capture(TEST_SAMPLES, 1001);
+    iq_stats_t full;
+    assert(iq_stats_full(TEST_FILE, 1, &full));
+
+    iq_summary_params_t params;
+    test_params(&params, 1);
+    iq_summary_t ref;
+    assert(iq_summary_build(TEST_FILE, &params, &ref));
+    assert(ref.total_samples == TEST_SAMPLES);
+    assert(ref.num_blocks == (TEST_SAMPLES + 4095) / 4096);
+    assert(ref.blocks_per_spectrum == 24);   // 0.1 s at 1 Msps in 4096-sample blocks
+    assert(ref.num_spectra == (ref.num_blocks + 23) / 24);
+    assert(ref.clipped == clipped);
+    assert(fabs(ref.stats.rms - full.rms) < 1e-12);
+    assert(fabs(ref.stats.dc_i - full.dc_i) < 1e-12);
+    assert(fabs(ref.stats.dc_q - full.dc_q) < 1e-12);
+    assert(ref.stats.peak == 1.0);
+
+    // Block ranges rebuild the same figures
+    iq_stats_t range;
+    assert(iq_summary_range_stats(&ref, 0, ref.num_blocks, &range));
+    assert(range.samples_used == TEST_SAMPLES && range.rms == ref.stats.rms);
+    assert(iq_summary_range_stats(&ref, ref.num_blocks - 1, 1, &range));
+    assert(range.samples_used == iq_summary_block_length(&ref, ref.num_blocks - 1));
+    assert(range.samples_used == TEST_SAMPLES % 4096);
+    assert(!iq_summary_range_stats(&ref, ref.num_blocks, 1, &range));
+
+    // The tone dominates every spectrum, DC in the middle
+    for (uint64_t s = 0; s < ref.num_spectra; s++) {
+        const float *spectrum = ref.spectra + s * TEST_FFT;
+        uint32_t best = 0;
+        for (uint32_t k = 1; k < TEST_FFT; k++) {
+            if (spectrum[k] > spectrum[best]) best = k;
+        }
+        assert(best == TEST_FFT / 2 + TEST_TONE_BIN);
+    }
+
+    // Any thread count writes the same sidecar contents
+    const uint32_t threads[] = { 3, 8, 0 };
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        iq_summary_t other;
+        test_params(&params, threads[t]);
+        assert(iq_summary_build(TEST_FILE, &params, &other));
+        assert(other.num_blocks == ref.num_blocks && other.num_spectra == ref.num_spectra);
+        assert(memcmp(other.blocks, ref.blocks, (size_t)ref.num_blocks * sizeof(iq_summary_block_t)) == 0);
+        assert(memcmp(other.spectra, ref.spectra, (size_t)ref.num_spectra * TEST_FFT * sizeof(float)) == 0);
+        assert(memcmp(&other.stats, &ref.stats, sizeof(ref.stats)) == 0);
+        iq_summary_free(&other);
+    }
+
+    iq_summary_free(&ref);
+    printf("✓ Summary build test passed\n");
+}
+
+static void test_sidecar(void) {
+    printf("Testing summary sidecar...\n");
+
+    write_capture(300000, 10);
+    char path[1024];
+    iq_summary_path(TEST_FILE, path, sizeof(path));
+    remove(path);
+
+    iq_summary_params_t params;
+    test_params(&params, 2);
+    iq_summary_t built, loaded;
+
+    // No sidecar yet: only a build produces one
+    assert(!iq_summary_open(TEST_FILE, false, false, &params, &loaded));
+    assert(iq_summary_open(TEST_FILE, false, true, &params, &built));
+    assert(iq_summary_is_fresh(&built, TEST_FILE));
+
+    // Round trip: same header figures, blocks and spectra
+    assert(iq_summary_open(TEST_FILE, false, false, NULL, &loaded));
+    assert(loaded.num_blocks == built.num_blocks && loaded.num_spectra == built.num_spectra);
+    assert(loaded.fft_size == TEST_FFT && loaded.sample_rate == 1000000);
+    assert(loaded.format == IQ_FORMAT_S16 && loaded.clipped == built.clipped);
+    assert(memcmp(&loaded.stats, &built.stats, sizeof(built.stats)) == 0);
+    assert(memcmp(loaded.blocks, built.blocks, (size_t)built.num_blocks * sizeof(iq_summary_block_t)) == 0);
+    assert(memcmp(loaded.spectra, built.spectra, (size_t)built.num_spectra * TEST_FFT * sizeof(float)) == 0);
+    iq_summary_free(&loaded);
+
+    // Header only: totals without the arrays
+    assert(iq_summary_open(TEST_FILE, true, false, NULL, &loaded));
+    assert(!loaded.blocks && !loaded.spectra);
+    assert(memcmp(&loaded.stats, &built.stats, sizeof(built.stats)) == 0);
+    iq_summary_free(&loaded);
+    iq_summary_free(&built);
+
+    // A changed capture makes the sidecar stale
+    FILE *f = fopen(TEST_FILE, "ab");
+    assert(f);
+    int16_t extra[2] = { 100, -100 };
+    assert(fwrite(extra, sizeof(int16_t), 2, f) == 2);
+    fclose(f);
+    assert(!iq_summary_open(TEST_FILE, true, false, NULL, &loaded));
+    assert(iq_summary_open(TEST_FILE, true, true, &params, &loaded));
+    assert(loaded.total_samples == 300001);
+    iq_summary_free(&loaded);
+
+    // A corrupt sidecar is not trusted
+    f = fopen(path, "r+b");
+    assert(f);
+    fputc('X', f);
+    fclose(f);
+    assert(!iq_summary_load(path, true, &loaded));
+
+    remove(path);
+    printf("✓ Summary sidecar test passed\n");
+}
+
+static void test_errors(void) {
+    printf("Testing error handling...\n");
+
+    iq_summary_params_t params;
+    iq_summary_t summary;
+    test_params(&params, 1);
+    assert(!iq_summary_build("nonexistent_summary.iq", &params, &summary));
+    assert(!iq_summary_build(NULL, &params, &summary));
+
+    params.block_samples = 1000;   // Not a multiple of the FFT size
+    assert(!iq_summary_build(TEST_FILE, &params, &summary));
+    test_params(&params, 1);
+    params.spectrum_seconds = 0.0;
+    assert(!iq_summary_build(TEST_FILE, &params, &summary));
+
+    // Empty capture: zero blocks, zero figures
+    FILE *f = fopen(TEST_FILE, "wb");
+    assert(f);
+    fclose(f);
+    test_params(&params, 4);
+    if (iq_summary_build(TEST_FILE, &params, &summary)) {
+        assert(summary.num_blocks == 0 && summary.num_spectra == 0 && summary.stats.rms == 0.0);
+        iq_summary_free(&summary);
+    }
+
+    printf("✓ Error handling test passed\n");
+}
+
+int main(void) {
+    printf("=== IQ Summary Unit Tests ===\n\n");
+
+    test_build();
+    test_sidecar();
+    test_errors();
+
+    remove(TEST_FILE);
+
+    printf("\n✓ All IQ summary tests passed!\n");
+    return 0;
+}
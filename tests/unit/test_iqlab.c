@@ -0,0 +1,347 @@
+/*
+ * IQ Lab - Embeddable Library Unit Tests
+ *
+ * Tests for libiqlab through its public header only, linked against the
+ * shared library: a tone written to a raw file is read back; the STFT
+ * gives the same rows however the input is split; CFAR finds the tone's
+ * bin and every detection comes back in one clustered event; the
+ * channelizer puts the tone in the channel at its frequency; FM of a
+ * constant offset settles to a steady level, mirrored for the mirrored
+ * carrier after a reset; and bad arguments come back as statuses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/lib/iqlab.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TEST_RATE 1000000.0
+#define TEST_FFT 256
+#define TEST_HOP 192
+#define TEST_SAMPLES 20000
+#define TONE_BIN 40                        // Bins above DC
+#define TONE_HZ (TONE_BIN * TEST_RATE / TEST_FFT)
+
+static const char *const test_path = "test_iqlab_tone.iq";
+
+// Interleaved tone of amplitude 0.1 in deterministic uniform noise
+static float *make_tone(size_t n, double hz, double noise_amplitude) {
+    float *iq = malloc(2 * n * sizeof(float));
+    assert(iq);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < n; i++) {
+        double phase = 2.0 * M_PI * hz * (double)i / TEST_RATE;
+        seed = seed * 1664525u + 1013904223u;
+        double noise = ((double)(seed >> 8) / 16777216.0 - 0.5) * 2.0 * noise_amplitude;
+        iq[2 * i] = (float)(0.1 * cos(phase) + noise);
+        iq[2 * i + 1] = (float)(0.1 * sin(phase) - noise);
+    }
+    return iq;
+}
+
+static void test_iqlab_version(void) {
+    printf("Testing version...\n");
+
+    assert(iqlab_version() == IQLAB_VERSION);
+    char expected[32];
+    snprintf(expected, sizeof(expected), "%d.%d.%d",
+             IQLAB_VERSION_MAJOR, IQLAB_VERSION_MINOR, IQLAB_VERSION_PATCH);
+    assert(strcmp(iqlab_version_string(), expected) == 0);
+    assert(strcmp(iqlab_status_string(IQLAB_OK), "ok") == 0);
+
+    printf("✓ Version tests passed\n");
+}
+
+static void test_iqlab_reader(void) {
+    printf("Testing reader...\n");
+
+    FILE *f = fopen(test_path, "wb");
+    assert(f);
+    for (int i = 0; i < 1000; i++) {
+        int16_t pair[2] = {(int16_t)(i * 16), (int16_t)(-i * 16)};
+        assert(fwrite(pair, sizeof(pair), 1, f) == 1);
+    }
+    fclose(f);
+
+    iqlab_reader_t *reader = NULL;
+    assert(iqlab_reader_open(test_path, "s16", &reader) == IQLAB_OK);
+    iqlab_reader_info_t info;
+    assert(iqlab_reader_info(reader, &info) == IQLAB_OK);
+    assert(info.sample_bits == 16 && info.total_samples == 1000 && !info.live);
+
+    float iq[2 * 600];
+    size_t n = 0;
+    assert(iqlab_reader_read(reader, iq, 600, &n) == IQLAB_OK && n == 600);
+    assert(fabsf(iq[2 * 10] - 160.0f / 32768.0f) < 1e-6f);
+    assert(iqlab_reader_read(reader, iq, 600, &n) == IQLAB_OK && n == 400);
+    assert(iqlab_reader_read(reader, iq, 600, &n) == IQLAB_OK && n == 0);
+
+    assert(iqlab_reader_seek(reader, 500) == IQLAB_OK);
+    assert(iqlab_reader_read(reader, iq, 1, &n) == IQLAB_OK && n == 1);
+    assert(fabsf(iq[1] + 8000.0f / 32768.0f) < 1e-6f);
+    iqlab_reader_close(reader);
+    remove(test_path);
+
+    assert(iqlab_reader_open("no_such_file.iq", "s16", &reader) == IQLAB_ERROR_IO && !reader);
+    assert(iqlab_reader_open(test_path, "nonsense", &reader) == IQLAB_ERROR_ARGUMENT);
+
+    printf("✓ Reader tests passed\n");
+}
+
+// Rows of the whole input pushed in pieces of 'chunk' samples
+static double *stft_rows(const float *iq, size_t n, size_t chunk, uint32_t hop, size_t *num_rows) {
+    iqlab_stft_t *stft = NULL;
+    assert(iqlab_stft_create(TEST_FFT, hop, "hann", &stft) == IQLAB_OK);
+    double *rows = malloc((n / hop + 1) * TEST_FFT * sizeof(double));
+    assert(rows);
+    size_t total = 0;
+    for (size_t pos = 0; pos < n; pos += chunk) {
+        size_t len = n - pos < chunk ? n - pos : chunk;
+        size_t max = iqlab_stft_max_rows(stft, len);
+        size_t got = 0;
+        assert(iqlab_stft_process(stft, iq + 2 * pos, len, rows + total * TEST_FFT, max, &got) == IQLAB_OK);
+        assert(got == max);
+        total += got;
+    }
+    iqlab_stft_destroy(stft);
+    *num_rows = total;
+    return rows;
+}
+
+static void test_iqlab_stft(void) {
+    printf("Testing STFT split invariance...\n");
+
+    float *iq = make_tone(TEST_SAMPLES, TONE_HZ, 0.1);
+    const uint32_t hops[2] = {TEST_HOP, 300};           // Overlapping and gapped frames
+    const size_t chunks[4] = {1, 97, 256, 5000};
+    for (int h = 0; h < 2; h++) {
+        size_t expected = (TEST_SAMPLES - TEST_FFT) / hops[h] + 1;
+        size_t whole_rows = 0;
+        double *whole = stft_rows(iq, TEST_SAMPLES, TEST_SAMPLES, hops[h], &whole_rows);
+        assert(whole_rows == expected);
+
+        // DC at N/2: the tone sits TONE_BIN above it
+        uint32_t peak = 0;
+        for (uint32_t k = 1; k < TEST_FFT; k++) {
+            if (whole[k] > whole[peak]) peak = k;
+        }
+        assert(peak == TEST_FFT / 2 + TONE_BIN);
+
+        for (int c = 0; c < 4; c++) {
+            size_t split_rows = 0;
+            double *split = stft_rows(iq, TEST_SAMPLES, chunks[c], hops[h], &split_rows);
+            assert(split_rows == whole_rows);
+            assert(memcmp(split, whole, whole_rows * TEST_FFT * sizeof(double)) == 0);
+            free(split);
+        }
+        free(whole);
+    }
+
+    // Too small an output buffer is refused without consuming the input
+    iqlab_stft_t *stft = NULL;
+    assert(iqlab_stft_create(TEST_FFT, TEST_HOP, NULL, &stft) == IQLAB_OK);
+    double row[TEST_FFT];
+    size_t got = 0;
+    assert(iqlab_stft_max_rows(stft, 2 * TEST_FFT) == 2);
+    assert(iqlab_stft_process(stft, iq, 2 * TEST_FFT, row, 1, &got) == IQLAB_ERROR_ARGUMENT);
+    assert(iqlab_stft_process(stft, iq, TEST_FFT, row, 1, &got) == IQLAB_OK && got == 1);
+    iqlab_stft_destroy(stft);
+    free(iq);
+
+    printf("✓ STFT tests passed\n");
+}
+
+static void test_iqlab_detect(void) {
+    printf("Testing CFAR and clustering...\n");
+
+    float *iq = make_tone(TEST_SAMPLES, TONE_HZ, 0.1);
+    size_t num_rows = 0;
+    double *rows = stft_rows(iq, TEST_SAMPLES, TEST_SAMPLES, TEST_HOP, &num_rows);
+
+    const char *const kinds[2] = {"os", "ca"};
+    for (int k = 0; k < 2; k++) {
+        iqlab_cfar_t *cfar = NULL;
+        assert(iqlab_cfar_create(kinds[k], TEST_FFT, 1e-6, 16, 2, 12, &cfar) == IQLAB_OK);
+        iqlab_cluster_t *cluster = NULL;
+        assert(iqlab_cluster_create(TEST_RATE, 10.0, 20.0, 1000, &cluster) == IQLAB_OK);
+
+        // The tone is the strongest detection of every row
+        iqlab_detection_t dets[TEST_FFT];
+        uint64_t added = 0;
+        for (size_t r = 0; r < num_rows; r++) {
+            uint32_t n = 0;
+            assert(iqlab_cfar_process(cfar, rows + r * TEST_FFT, dets, TEST_FFT, &n) == IQLAB_OK);
+            uint32_t strongest = 0;
+            for (uint32_t i = 1; i < n; i++) {
+                if (dets[i].power_db > dets[strongest].power_db) strongest = i;
+            }
+            assert(n > 0 && dets[strongest].bin == TEST_FFT / 2 + TONE_BIN);
+            assert(dets[strongest].snr_db > 6.0);
+            assert(iqlab_cluster_add(cluster, dets, n, (double)r * TEST_HOP / TEST_RATE) == IQLAB_OK);
+            added += n;
+        }
+
+        // Every detection comes back in exactly one event once flushed
+        iqlab_event_t event;
+        uint64_t clustered = 0;
+        assert(iqlab_cluster_flush(cluster) == IQLAB_OK);
+        while (iqlab_cluster_next_event(cluster, &event) == IQLAB_OK) {
+            assert(event.modulation != NULL && event.end_time_s >= event.start_time_s);
+            clustered += event.num_detections;
+        }
+        assert(clustered == added);
+        assert(iqlab_cluster_next_event(cluster, &event) == IQLAB_ERROR_EMPTY);
+
+        iqlab_cluster_destroy(cluster);
+        iqlab_cfar_destroy(cfar);
+    }
+    free(rows);
+    free(iq);
+
+    printf("✓ CFAR and clustering tests passed\n");
+}
+
+static void test_iqlab_pfb(void) {
+    printf("Testing channelizer...\n");
+
+    const uint32_t channels = 8;
+    iqlab_pfb_t *pfb = NULL;
+    assert(iqlab_pfb_create(channels, TEST_RATE, 0.0, 1, &pfb) == IQLAB_OK);
+    assert(fabs(iqlab_pfb_output_rate(pfb) - TEST_RATE / channels) < 1e-6);
+
+    // A tone at the centre of the channel two spacings above the lowest one
+    double spacing = TEST_RATE / channels;
+    double tone = iqlab_pfb_channel_frequency(pfb, 2);
+    assert(fabs(tone - (2.0 - channels / 2.0) * spacing) < 1e-6);
+
+    float *iq = make_tone(8192, tone, 0.0);
+    float *out = malloc(2 * 8192 * sizeof(float));
+    assert(out);
+    double energy[8] = {0};
+    size_t pos = 0;
+    while (pos < 8192) {
+        size_t consumed = 0;
+        assert(iqlab_pfb_process(pfb, iq + 2 * pos, 8192 - pos, &consumed) == IQLAB_OK);
+        pos += consumed;
+        for (uint32_t c = 0; c < channels; c++) {
+            size_t n = 0;
+            assert(iqlab_pfb_read(pfb, c, out, 8192, &n) == IQLAB_OK);
+            for (size_t i = n / 4; i < n; i++) {
+                energy[c] += out[2 * i] * out[2 * i] + out[2 * i + 1] * out[2 * i + 1];
+            }
+        }
+    }
+    for (uint32_t c = 0; c < channels; c++) {
+        if (c != 2) assert(energy[c] < 0.01 * energy[2]);
+    }
+    assert(energy[2] > 0.0);
+
+    size_t n = 0;
+    assert(iqlab_pfb_read(pfb, channels, out, 1, &n) == IQLAB_ERROR_ARGUMENT);
+    iqlab_pfb_destroy(pfb);
+    free(out);
+    free(iq);
+
+    printf("✓ Channelizer tests passed\n");
+}
+
+static void test_iqlab_demod(void) {
+    printf("Testing demodulators...\n");
+
+    // FM: a carrier 15 kHz off centre is a constant deviation
+    const double rate = 240000.0;
+    const size_t n = 24000;
+    float *iq = malloc(2 * n * sizeof(float));
+    float *audio = malloc(n * sizeof(float));
+    assert(iq && audio);
+    for (size_t i = 0; i < n; i++) {
+        double phase = 2.0 * M_PI * 15000.0 * (double)i / rate;
+        iq[2 * i] = (float)(0.5 * cos(phase));
+        iq[2 * i + 1] = (float)(0.5 * sin(phase));
+    }
+
+    iqlab_demod_t *demod = NULL;
+    assert(iqlab_demod_create(IQLAB_DEMOD_FM, rate, &demod) == IQLAB_OK);
+    assert(iqlab_demod_process(demod, iq, n, audio) == IQLAB_OK);
+    float level = audio[n - 1];
+    assert(level > 1e-3f);
+    for (size_t i = n - n / 8; i < n; i++) assert(fabsf(audio[i] - level) < 0.01f * level);
+
+    // After a reset the mirrored carrier gives the mirrored output
+    for (size_t i = 0; i < n; i++) iq[2 * i + 1] = -iq[2 * i + 1];
+    float *mirror = malloc(n * sizeof(float));
+    assert(mirror);
+    iqlab_demod_reset(demod);
+    assert(iqlab_demod_process(demod, iq, n, mirror) == IQLAB_OK);
+    for (size_t i = 0; i < n; i++) assert(fabsf(mirror[i] + audio[i]) < 1e-4f);
+    free(mirror);
+    iqlab_demod_destroy(demod);
+
+    // AM and SSB run over the same input
+    const iqlab_demod_mode_t modes[3] = {IQLAB_DEMOD_AM, IQLAB_DEMOD_USB, IQLAB_DEMOD_LSB};
+    for (int m = 0; m < 3; m++) {
+        assert(iqlab_demod_create(modes[m], rate, &demod) == IQLAB_OK);
+        assert(iqlab_demod_process(demod, iq, n, audio) == IQLAB_OK);
+        for (size_t i = 0; i < n; i++) assert(isfinite(audio[i]));
+        iqlab_demod_reset(demod);
+        iqlab_demod_destroy(demod);
+    }
+    free(audio);
+    free(iq);
+
+    printf("✓ Demodulator tests passed\n");
+}
+
+static void test_iqlab_errors(void) {
+    printf("Testing error handling...\n");
+
+    iqlab_stft_t *stft = NULL;
+    assert(iqlab_stft_create(256, 0, NULL, &stft) == IQLAB_ERROR_ARGUMENT && !stft);
+    assert(iqlab_stft_create(256, 64, "nonsense", &stft) == IQLAB_ERROR_ARGUMENT);
+    iqlab_cfar_t *cfar = NULL;
+    assert(iqlab_cfar_create("nonsense", 256, 1e-3, 16, 2, 12, &cfar) == IQLAB_ERROR_ARGUMENT);
+    assert(iqlab_cfar_create("os", 256, 2.0, 16, 2, 12, &cfar) == IQLAB_ERROR_ARGUMENT && !cfar);
+    iqlab_cluster_t *cluster = NULL;
+    assert(iqlab_cluster_create(0.0, 10.0, 20.0, 100, &cluster) == IQLAB_ERROR_ARGUMENT);
+    iqlab_pfb_t *pfb = NULL;
+    assert(iqlab_pfb_create(0, TEST_RATE, 0.0, 1, &pfb) == IQLAB_ERROR_ARGUMENT && !pfb);
+    iqlab_demod_t *demod = NULL;
+    assert(iqlab_demod_create((iqlab_demod_mode_t)7, 48000.0, &demod) == IQLAB_ERROR_ARGUMENT);
+    assert(iqlab_demod_create(IQLAB_DEMOD_FM, 0.0, &demod) == IQLAB_ERROR_ARGUMENT);
+    assert(iqlab_reader_open(NULL, NULL, NULL) == IQLAB_ERROR_ARGUMENT);
+
+    // Destroying NULL is a no-op
+    iqlab_reader_close(NULL);
+    iqlab_stft_destroy(NULL);
+    iqlab_cfar_destroy(NULL);
+    iqlab_cluster_destroy(NULL);
+    iqlab_pfb_destroy(NULL);
+    iqlab_demod_destroy(NULL);
+
+    printf("✓ Error handling tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running Embeddable Library Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_iqlab_version();
+    test_iqlab_reader();
+    test_iqlab_stft();
+    test_iqlab_detect();
+    test_iqlab_pfb();
+    test_iqlab_demod();
+    test_iqlab_errors();
+
+    printf("\n=====================================\n");
+    printf("All embeddable library tests passed! ✓\n");
+    printf("=====================================\n");
+    return 0;
+}
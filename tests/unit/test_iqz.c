@@ -0,0 +1,363 @@
+/*
+ * IQ Lab - IQZ Compressed Container Unit Tests
+ *
+ * Tests for io_iqz: lossless chunks must give back every s8/s16 value,
+ * including full-scale noise that only fits raw; block floating point must
+ * keep its fixed size and stay within half a quantisation step of the input;
+ * iq_reader_t must stream and seek through a container exactly as it does
+ * through the raw file; and unfinished or damaged files must be refused.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/iq_core/io_iq.h"
+#include "../../src/iq_core/io_iqz.h"
+#include "../../src/converter/converter.h"
+
+#define TEST_IQZ "test_iqz.iqz"
+#define TEST_RAW "test_iqz_raw.iq"
+#define TEST_DECODED "test_iqz_decoded.iq"
+
+// Deterministic pseudo-random stream
+static uint32_t rng_state = 4242;
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static size_t file_bytes(const char *path) {
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    size_t bytes = (size_t)ftell(f);
+    fclose(f);
+    return bytes;
+}
+
+// Narrowband tone plus a little noise, as a receiver would record it
+static void make_tone(int16_t *values, size_t samples, double amplitude) {
+    for (size_t i = 0; i < samples; i++) {
+        double phase = 0.013 * (double)i;
+        double noise_i = (double)(next_random() % 9) - 4.0;
+        double noise_q = (double)(next_random() % 9) - 4.0;
+        values[2 * i] = (int16_t)lrint(amplitude * cos(phase) + noise_i);
+        values[2 * i + 1] = (int16_t)lrint(amplitude * sin(phase) + noise_q);
+    }
+}
+
+static void write_container(const char *path, iq_format_t format, const void *values, size_t samples,
+                            uint32_t chunk, uint32_t mantissa_bits) {
+    iqz_writer_t *writer = iqz_writer_create(path, format, 2000000, chunk, mantissa_bits);
+    assert(writer);
+
+    // Uneven appends so chunks straddle write calls
+    size_t sample_bytes = iq_native_sample_bytes(format);
+    size_t done = 0;
+    while (done < samples) {
+        size_t n = 1 + next_random() % 3000;
+        if (n > samples - done) n = samples - done;
+        assert(iqz_writer_write(writer, (const uint8_t *)values + done * sample_bytes, n));
+        done += n;
+    }
+    assert(iqz_writer_close(writer));
+}
+
+static void test_lossless_round_trip(void) {
+    printf("Testing lossless round trip...\n");
+
+    enum { SAMPLES = 50000 };
+    int16_t *tone = malloc(SAMPLES * 2 * sizeof(int16_t));
+    int16_t *noise = malloc(SAMPLES * 2 * sizeof(int16_t));
+    int8_t *tone8 = malloc(SAMPLES * 2);
+    int16_t *decoded = malloc(SAMPLES * 2 * sizeof(int16_t));
+    assert(tone && noise && tone8 && decoded);
+
+    make_tone(tone, SAMPLES, 9000.0);
+    for (size_t i = 0; i < SAMPLES * 2; i++) {
+        noise[i] = (int16_t)(next_random() >> 16);  // Full scale: nothing to predict
+        tone8[i] = (int8_t)(tone[i] / 300);
+    }
+    tone[0] = 32767;
+    tone[1] = -32768;  // Extremes through the order-2 predictor
+    tone[2] = -32768;
+    tone[3] = 32767;
+
+    // s16 tone compresses
+    write_container(TEST_IQZ, IQ_FORMAT_S16, tone, SAMPLES, 4096, 0);
+    iqz_file_t *file = iqz_open(TEST_IQZ);
+    assert(file);
+    const iqz_info_t *info = iqz_info(file);
+    assert(info->format == IQ_FORMAT_S16 && info->codec == IQZ_CODEC_LOSSLESS);
+    assert(info->num_samples == SAMPLES && info->sample_rate == 2000000);
+    assert(info->num_chunks == (SAMPLES + 4095) / 4096);
+    assert(iqz_read(file, 0, decoded, SAMPLES) == SAMPLES);
+    assert(memcmp(decoded, tone, SAMPLES * 4) == 0);
+    size_t tone_bytes = file_bytes(TEST_IQZ);
+    assert(tone_bytes == info->file_bytes);
+    assert(tone_bytes < SAMPLES * 4 * 6 / 10);
+    printf("  s16 tone: %zu -> %zu bytes\n", (size_t)SAMPLES * 4, tone_bytes);
+    iqz_close(file);
+
+    // Noise falls back to raw chunks: exact, and barely larger than the input
+    write_container(TEST_IQZ, IQ_FORMAT_S16, noise, SAMPLES, 4096, 0);
+    file = iqz_open(TEST_IQZ);
+    assert(file);
+    assert(iqz_read(file, 0, decoded, SAMPLES) == SAMPLES);
+    assert(memcmp(decoded, noise, SAMPLES * 4) == 0);
+    assert(file_bytes(TEST_IQZ) <= SAMPLES * 4 + IQZ_HEADER_SIZE + 8 * (iqz_info(file)->num_chunks + 1) +
+                                  iqz_info(file)->num_chunks);
+    iqz_close(file);
+
+    // s8 values
+    write_container(TEST_IQZ, IQ_FORMAT_S8, tone8, SAMPLES, 0, 0);
+    file = iqz_open(TEST_IQZ);
+    assert(file);
+    assert(iqz_info(file)->chunk_samples == IQZ_DEFAULT_CHUNK);
+    assert(iqz_read(file, 0, decoded, SAMPLES) == SAMPLES);
+    assert(memcmp(decoded, tone8, SAMPLES * 2) == 0);
+    iqz_close(file);
+
+    free(tone);
+    free(noise);
+    free(tone8);
+    free(decoded);
+}
+
+static void test_bfp(void) {
+    printf("Testing block floating point...\n");
+
+    enum { SAMPLES = 40000 };
+    int16_t *tone = malloc(SAMPLES * 2 * sizeof(int16_t));
+    int16_t *decoded = malloc(SAMPLES * 2 * sizeof(int16_t));
+    assert(tone && decoded);
+    make_tone(tone, SAMPLES, 20000.0);
+    tone[0] = -32768;
+    tone[1] = 32767;
+
+    const uint32_t bits_list[] = { 2, 6, 10, 15 };
+    for (size_t b = 0; b < sizeof(bits_list) / sizeof(bits_list[0]); b++) {
+        uint32_t bits = bits_list[b];
+        write_container(TEST_IQZ, IQ_FORMAT_S16, tone, SAMPLES, 8192, bits);
+        iqz_file_t *file = iqz_open(TEST_IQZ);
+        assert(file);
+        assert(iqz_info(file)->codec == IQZ_CODEC_BFP && iqz_info(file)->mantissa_bits == bits);
+        assert(iqz_read(file, 0, decoded, SAMPLES) == SAMPLES);
+
+        // Every block of 16 values: each within half a step of its exponent, or clamped at the top
+        for (size_t start = 0; start < SAMPLES * 2; start += 16) {
+            int32_t peak = 0;
+            for (size_t j = start; j < start + 16; j++) {
+                int32_t v = abs(tone[j]);
+                if (v > peak) peak = v;
+            }
+            int e = 0;
+            while (e < 15 && (peak >> e) >= (1 << (bits - 1))) e++;
+            int32_t step = 1 << e;
+            for (size_t j = start; j < start + 16; j++) {
+                int32_t err = abs((int32_t)decoded[j] - (int32_t)tone[j]);
+                assert(err <= step);
+                if (tone[j] < (1 << (bits - 1)) * step - step) {
+                    assert(2 * err <= step);
+                }
+            }
+        }
+
+        // Fixed rate: the size follows from the sample count alone
+        size_t blocks = (size_t)(8192 * 2 / 16);
+        size_t chunk_bytes = 1 + (blocks * (4 + 16 * bits) + 7) / 8;
+        size_t chunks = iqz_info(file)->num_chunks;
+        size_t last_blocks = (size_t)(SAMPLES - (chunks - 1) * 8192) * 2 / 16;
+        size_t expected = IQZ_HEADER_SIZE + (chunks - 1) * chunk_bytes +
+                          1 + (last_blocks * (4 + 16 * bits) + 7) / 8 + 8 * (chunks + 1);
+        assert(file_bytes(TEST_IQZ) == expected);
+        printf("  %2u bits: %zu bytes\n", bits, expected);
+        iqz_close(file);
+    }
+
+    // Mantissas wider than the samples are refused
+    assert(iqz_writer_create(TEST_IQZ, IQ_FORMAT_S8, 0, 0, 8) == NULL);
+    assert(iqz_writer_create(TEST_IQZ, IQ_FORMAT_S16, 0, 0, 1) == NULL);
+
+    free(tone);
+    free(decoded);
+}
+
+static void test_reader_seek(void) {
+    printf("Testing iq_reader_t over IQZ...\n");
+
+    enum { SAMPLES = 30011 };  // A short last chunk
+    int16_t *tone = malloc(SAMPLES * 2 * sizeof(int16_t));
+    assert(tone);
+    make_tone(tone, SAMPLES, 5000.0);
+
+    FILE *raw = fopen(TEST_RAW, "wb");
+    assert(raw);
+    assert(fwrite(tone, 4, SAMPLES, raw) == SAMPLES);
+    fclose(raw);
+    write_container(TEST_IQZ, IQ_FORMAT_S16, tone, SAMPLES, 1024, 0);
+
+    iq_reader_t plain, packed;
+    assert(iq_reader_init(&plain, TEST_RAW, IQ_FORMAT_S16));
+    assert(iq_reader_open(&packed, TEST_IQZ));
+    assert(packed.compressed && packed.format == IQ_FORMAT_S16);
+    assert(packed.total_samples == SAMPLES && packed.sample_rate == 2000000);
+
+    float a[2 * 700], b[2 * 700];
+    int16_t native[2 * 700];
+    for (int round = 0; round < 200; round++) {
+        uint64_t at = next_random() % (SAMPLES + 10);
+        size_t want = 1 + next_random() % 700;
+        bool in_range = at <= SAMPLES;
+        assert(iq_reader_seek_sample(&plain, at) == in_range);
+        assert(iq_reader_seek_sample(&packed, at) == in_range);
+        if (!in_range) continue;
+
+        size_t n = iq_read_samples(&plain, a, want);
+        assert(iq_read_samples(&packed, b, want) == n);
+        assert(memcmp(a, b, n * 2 * sizeof(float)) == 0);
+        assert(packed.position == at + n);
+
+        assert(iq_reader_seek_sample(&packed, at));
+        assert(iq_read_native(&packed, native, want) == n);
+        assert(memcmp(native, tone + at * 2, n * 4) == 0);
+    }
+    iq_reader_close(&plain);
+    iq_reader_close(&packed);
+
+    // Whole-file load decodes through the reader
+    iq_data_t data;
+    assert(iq_load_file(TEST_IQZ, &data));
+    assert(data.num_samples == SAMPLES && data.sample_rate == 2000000);
+    for (size_t i = 0; i < SAMPLES * 2; i++) {
+        assert(data.data[i] == (float)tone[i] / 32768.0f);
+    }
+    iq_free(&data);
+
+    // Memory mapping has no fixed stride to offer
+    iq_mmap_t map;
+    assert(!iq_mmap_open(&map, TEST_IQZ));
+
+    free(tone);
+}
+
+static void test_converter(void) {
+    printf("Testing IQZ through convert_file...\n");
+
+    enum { SAMPLES = 12345 };
+    int16_t *tone = malloc(SAMPLES * 2 * sizeof(int16_t));
+    assert(tone);
+    make_tone(tone, SAMPLES, 7000.0);
+    FILE *raw = fopen(TEST_RAW, "wb");
+    assert(raw);
+    assert(fwrite(tone, 4, SAMPLES, raw) == SAMPLES);
+    fclose(raw);
+
+    conversion_request_t request;
+    memset(&request, 0, sizeof(request));
+    init_converter_options(&request.options);
+    request.options.force_overwrite = true;
+    request.input_file = TEST_RAW;
+    request.output_file = TEST_IQZ;
+    request.input_format = FORMAT_IQ_S16;
+    request.output_format = FORMAT_IQZ;
+    converter_result_t result = convert_file(&request);
+    assert(result.success && result.samples_converted == SAMPLES);
+    assert(detect_file_format(TEST_IQZ) == FORMAT_IQZ);
+
+    file_metadata_t metadata;
+    assert(extract_file_metadata(TEST_IQZ, &metadata));
+    assert(metadata.format == FORMAT_IQZ && metadata.num_samples == SAMPLES);
+
+    request.input_file = TEST_IQZ;
+    request.output_file = TEST_DECODED;
+    request.input_format = FORMAT_AUTO;
+    request.output_format = FORMAT_IQ_S16;
+    result = convert_file(&request);
+    assert(result.success && result.samples_converted == SAMPLES);
+
+    FILE *f = fopen(TEST_DECODED, "rb");
+    assert(f);
+    int16_t *back = malloc(SAMPLES * 4);
+    assert(back);
+    assert(fread(back, 4, SAMPLES, f) == SAMPLES);
+    fclose(f);
+    assert(memcmp(back, tone, SAMPLES * 4) == 0);
+
+    free(back);
+    free(tone);
+}
+
+static void test_damaged_files(void) {
+    printf("Testing damaged containers...\n");
+
+    enum { SAMPLES = 9000 };
+    int16_t *tone = malloc(SAMPLES * 2 * sizeof(int16_t));
+    int16_t *decoded = malloc(SAMPLES * 2 * sizeof(int16_t));
+    assert(tone && decoded);
+    make_tone(tone, SAMPLES, 3000.0);
+
+    // A writer that never closed has no index
+    iqz_writer_t *writer = iqz_writer_create(TEST_IQZ, IQ_FORMAT_S16, 0, 1024, 0);
+    assert(writer);
+    assert(iqz_writer_write(writer, tone, SAMPLES));
+    fflush(NULL);
+    assert(iqz_probe(TEST_IQZ));
+    assert(iqz_open(TEST_IQZ) == NULL);
+    assert(iqz_writer_close(writer));
+    assert(!iqz_probe(TEST_RAW));
+
+    // Truncated index
+    size_t bytes = file_bytes(TEST_IQZ);
+    FILE *f = fopen(TEST_IQZ, "rb");
+    uint8_t *image = malloc(bytes);
+    assert(f && image);
+    assert(fread(image, 1, bytes, f) == bytes);
+    fclose(f);
+    f = fopen(TEST_IQZ, "wb");
+    assert(fwrite(image, 1, bytes - 4, f) == bytes - 4);
+    fclose(f);
+    assert(iqz_open(TEST_IQZ) == NULL);
+
+    // Flipped bits inside a chunk: decoding may fail but must stay in bounds
+    for (int trial = 0; trial < 50; trial++) {
+        uint8_t *copy = malloc(bytes);
+        assert(copy);
+        memcpy(copy, image, bytes);
+        size_t at = IQZ_HEADER_SIZE + next_random() % 2000;
+        copy[at] ^= (uint8_t)(1u << (next_random() % 8));
+        f = fopen(TEST_IQZ, "wb");
+        assert(fwrite(copy, 1, bytes, f) == bytes);
+        fclose(f);
+        iqz_file_t *file = iqz_open(TEST_IQZ);
+        assert(file);
+        size_t n = iqz_read(file, 0, decoded, SAMPLES);
+        assert(n <= SAMPLES);
+        iqz_close(file);
+        free(copy);
+    }
+
+    free(image);
+    free(tone);
+    free(decoded);
+}
+
+int main(void) {
+    printf("=== IQZ Container Unit Tests ===\n\n");
+
+    test_lossless_round_trip();
+    test_bfp();
+    test_reader_seek();
+    test_converter();
+    test_damaged_files();
+
+    remove(TEST_IQZ);
+    remove(TEST_RAW);
+    remove(TEST_DECODED);
+
+    printf("\n✓ All IQZ tests passed!\n");
+    return 0;
+}
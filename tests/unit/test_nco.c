@@ -0,0 +1,175 @@
+/*
+ * IQ Lab - NCO Unit Tests
+ *
+ * Tests for nco: the recursive phasor must track exp(j 2 pi f n / fs) over
+ * long runs without drifting off the unit circle; block mixing must match
+ * single steps bit for bit whatever the block split (and in place), the
+ * vector kernels must match the scalar one, and retuning must keep the
+ * phase continuous.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/iq_core/nco.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Error of a phasor against exp(j phase)
+static double phasor_error(float re, float im, double phase) {
+    return hypot(re - cos(phase), im - sin(phase));
+}
+
+static void test_nco_accuracy(void) {
+    printf("Testing phasor accuracy...\n");
+
+    nco_t nco;
+    assert(nco_init(NULL, 1000.0, 48000.0) == false);
+    assert(nco_init(&nco, 1000.0, 0.0) == false);
+
+    const double fs = 2400000.0;
+    const double frequencies[] = {0.0, 12345.6, -700000.0, 1199999.0};
+    const size_t count = 4000000;
+
+    for (size_t f = 0; f < sizeof(frequencies) / sizeof(frequencies[0]); f++) {
+        assert(nco_init(&nco, frequencies[f], fs) == true);
+        double max_error = 0.0;
+        for (size_t n = 0; n < count; n++) {
+            float re, im;
+            nco_step(&nco, &re, &im);
+            double phase = 2.0 * M_PI * fmod(frequencies[f] * (double)n / fs, 1.0);
+            double error = phasor_error(re, im, phase);
+            if (error > max_error) max_error = error;
+        }
+        double max_drift = 0.0;
+        for (int l = 0; l < NCO_LANES; l++) {
+            double drift = fabs(hypot(nco.lane_re[l], nco.lane_im[l]) - 1.0);
+            if (drift > max_drift) max_drift = drift;
+        }
+        printf("  f=%+11.1f Hz: max error %.2e, magnitude drift %.2e\n", frequencies[f],
+               max_error, max_drift);
+        assert(max_error < 1e-6);
+        assert(max_drift < 1e-12);
+    }
+
+    printf("✓ Accuracy tests passed\n");
+}
+
+static float *make_noise(size_t count) {
+    float *iq = malloc(count * 2 * sizeof(float));
+    assert(iq);
+    uint32_t state = 12345u;
+    for (size_t n = 0; n < 2 * count; n++) {
+        state = state * 1664525u + 1013904223u;
+        iq[n] = (float)(state >> 8) / 8388608.0f - 1.0f;
+    }
+    return iq;
+}
+
+// Mix by single steps, the reference for every kernel
+static void mix_by_steps(nco_t *nco, const float *in, float *out, size_t count) {
+    for (size_t n = 0; n < count; n++) {
+        float pr, pi;
+        nco_step(nco, &pr, &pi);
+        out[2 * n] = in[2 * n] * pr - in[2 * n + 1] * pi;
+        out[2 * n + 1] = in[2 * n] * pi + in[2 * n + 1] * pr;
+    }
+}
+
+static void test_nco_block_mix(void) {
+    printf("Testing block mixing against single steps...\n");
+
+    const size_t count = 300000;
+    float *in = make_noise(count);
+    float *ref = malloc(count * 2 * sizeof(float));
+    float *out = malloc(count * 2 * sizeof(float));
+    assert(ref && out);
+
+    for (int scalar = 0; scalar <= 1; scalar++) {
+        nco_force_scalar(scalar);
+
+        nco_t a, b;
+        assert(nco_init(&a, -123456.7, 1000000.0) == true);
+        assert(nco_init(&b, -123456.7, 1000000.0) == true);
+        mix_by_steps(&a, in, ref, count);
+
+        // Random splits, odd sizes included, so blocks start on every lane
+        uint32_t state = 7u;
+        for (size_t offset = 0; offset < count; ) {
+            state = state * 1664525u + 1013904223u;
+            size_t n = (state >> 8) % 3000;
+            if (n > count - offset) n = count - offset;
+            nco_mix(&b, in + 2 * offset, out + 2 * offset, n);
+            offset += n;
+        }
+        assert(memcmp(ref, out, count * 2 * sizeof(float)) == 0);
+        assert(a.count == b.count && memcmp(a.lane_re, b.lane_re, sizeof(a.lane_re)) == 0);
+
+        // In place
+        memcpy(out, in, count * 2 * sizeof(float));
+        nco_reset(&b);
+        nco_mix(&b, out, out, count);
+        assert(memcmp(ref, out, count * 2 * sizeof(float)) == 0);
+    }
+    nco_force_scalar(false);
+
+    free(in);
+    free(ref);
+    free(out);
+    printf("✓ Block mixing tests passed\n");
+}
+
+static void test_nco_retune(void) {
+    printf("Testing phase-continuous retuning...\n");
+
+    const double fs = 48000.0, f1 = 1500.0, f2 = -2700.0;
+    const size_t first = 12345, second = 50000;
+
+    nco_t nco;
+    assert(nco_init(&nco, f1, fs) == true);
+    for (size_t n = 0; n < first; n++) {
+        float re, im;
+        nco_step(&nco, &re, &im);
+    }
+    assert(nco_set_frequency(&nco, f2) == true);
+
+    double start = 2.0 * M_PI * fmod(f1 * (double)first / fs, 1.0);
+    double max_error = 0.0;
+    for (size_t n = 0; n < second; n++) {
+        float re, im;
+        nco_step(&nco, &re, &im);
+        double error = phasor_error(re, im, start + 2.0 * M_PI * fmod(f2 * (double)n / fs, 1.0));
+        if (error > max_error) max_error = error;
+    }
+    printf("  max error after retune %.2e\n", max_error);
+    assert(max_error < 1e-6);
+
+    // Reset goes back to phase 0 at the new frequency
+    nco_reset(&nco);
+    float re, im;
+    nco_step(&nco, &re, &im);
+    assert(re == 1.0f && im == 0.0f);
+    nco_step(&nco, &re, &im);
+    assert(phasor_error(re, im, 2.0 * M_PI * f2 / fs) < 1e-7);
+
+    printf("✓ Retuning tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running NCO Unit Tests\n");
+    printf("======================\n\n");
+
+    test_nco_accuracy();
+    test_nco_block_mix();
+    test_nco_retune();
+
+    printf("\n======================\n");
+    printf("All NCO tests passed! ✓\n");
+    printf("======================\n");
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * IQ Lab - Noise Floor Tracker Unit Tests
+ *
+ * Tests for the per-bin noise floor tracker. Every mode must settle on the
+ * mean of stationary exponential noise and follow a level change; median and
+ * minimum statistics must ignore a bin occupied by a frequent burst; the
+ * known-noise detector must hold its false alarm rate; and the feature
+ * extractor must take its noise floor from the tracker when given one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/detect/noise_floor.h"
+#include "../../src/detect/features.h"
+
+static uint32_t rng_state = 7u;
+
+// Exponentially distributed power (|complex Gaussian|^2), deterministic
+static void fill_exponential_row(double *row, uint32_t size, double noise_power) {
+    for (uint32_t i = 0; i < size; i++) {
+        rng_state = rng_state * 1664525u + 1013904223u;
+        double u = ((rng_state >> 8) + 1) / 16777217.0;
+        row[i] = -log(u) * noise_power;
+    }
+}
+
+static double mean_floor(const noise_floor_t *nf) {
+    return noise_floor_band(nf, 0, nf->fft_size - 1);
+}
+
+static void test_noise_floor_initialization(void) {
+    printf("Testing noise floor initialization...\n");
+
+    noise_floor_t nf;
+    assert(noise_floor_init(&nf, 1024, NOISE_FLOOR_MEDIAN, 64) == true);
+    assert(noise_floor_ready(&nf) == false);
+    assert(noise_floor_get(&nf) == NULL);
+    assert(noise_floor_band(&nf, 0, 10) == 0.0);
+    noise_floor_free(&nf);
+
+    assert(noise_floor_init(&nf, 1024, NOISE_FLOOR_MINIMUM, 64) == true);
+    assert(nf.min_bias > 1.0);   // The minimum sits below the mean
+    noise_floor_free(&nf);
+
+    // Invalid parameters
+    assert(noise_floor_init(&nf, 0, NOISE_FLOOR_EWMA, 64) == false);
+    assert(noise_floor_init(&nf, 1024, NOISE_FLOOR_EWMA, 1) == false);
+    assert(noise_floor_init(&nf, 1024, NOISE_FLOOR_MINIMUM, 3) == false);
+
+    noise_floor_mode_t mode;
+    assert(noise_floor_mode_from_name("min", &mode) && mode == NOISE_FLOOR_MINIMUM);
+    assert(noise_floor_mode_from_name("ewma", &mode) && mode == NOISE_FLOOR_EWMA);
+    assert(noise_floor_mode_from_name("median", &mode) && mode == NOISE_FLOOR_MEDIAN);
+    assert(noise_floor_mode_from_name("mode", &mode) == false);
+    assert(strcmp(noise_floor_mode_name(NOISE_FLOOR_MINIMUM), "minimum") == 0);
+
+    printf("✓ Noise floor initialization tests passed\n");
+}
+
+static void test_noise_floor_stationary(void) {
+    printf("Testing noise floor on stationary noise...\n");
+
+    const uint32_t size = 512;
+    const noise_floor_mode_t modes[] = {NOISE_FLOOR_EWMA, NOISE_FLOOR_MEDIAN, NOISE_FLOOR_MINIMUM};
+    double row[512];
+
+    for (uint32_t m = 0; m < 3; m++) {
+        noise_floor_t nf;
+        assert(noise_floor_init(&nf, size, modes[m], 64) == true);
+
+        for (uint32_t r = 0; r < 1000; r++) {
+            fill_exponential_row(row, size, 2.0);
+            noise_floor_update(&nf, row);
+        }
+        double mean = mean_floor(&nf);
+        assert(mean > 1.8 && mean < 2.2);
+
+        // Then a 10 dB rise: the floor follows within a few time constants
+        for (uint32_t r = 0; r < 400; r++) {
+            fill_exponential_row(row, size, 20.0);
+            noise_floor_update(&nf, row);
+        }
+        double raised = mean_floor(&nf);
+        assert(raised > 18.0 && raised < 22.0);
+
+        printf("  %-8s %.3f (expected 2.0), after step %.2f (expected 20.0)\n",
+               noise_floor_mode_name(modes[m]), mean, raised);
+        noise_floor_free(&nf);
+    }
+
+    printf("✓ Noise floor stationary tests passed\n");
+}
+
+static void test_noise_floor_burst_rejection(void) {
+    printf("Testing noise floor under a frequent burst...\n");
+
+    const uint32_t size = 256;
+    const uint32_t burst_bin = 100;
+    double row[256];
+
+    noise_floor_t ewma, median, minimum;
+    assert(noise_floor_init(&ewma, size, NOISE_FLOOR_EWMA, 64) == true);
+    assert(noise_floor_init(&median, size, NOISE_FLOOR_MEDIAN, 64) == true);
+    assert(noise_floor_init(&minimum, size, NOISE_FLOOR_MINIMUM, 64) == true);
+
+    // Burst 20 dB above the noise in one bin, 20 rows in every 50
+    for (uint32_t r = 0; r < 2000; r++) {
+        fill_exponential_row(row, size, 1.0);
+        if (r % 50 < 20) row[burst_bin] += 100.0;
+        noise_floor_update(&ewma, row);
+        noise_floor_update(&median, row);
+        noise_floor_update(&minimum, row);
+    }
+
+    assert(ewma.floor[burst_bin] > 10.0);     // Absorbs the burst energy
+    assert(median.floor[burst_bin] < 3.0);    // Stays near the noise
+    assert(minimum.floor[burst_bin] < 2.0);
+    printf("  burst bin floor: ewma %.2f, median %.2f, minimum %.2f (noise 1.0)\n",
+           ewma.floor[burst_bin], median.floor[burst_bin], minimum.floor[burst_bin]);
+
+    noise_floor_free(&ewma);
+    noise_floor_free(&median);
+    noise_floor_free(&minimum);
+    printf("✓ Noise floor burst rejection tests passed\n");
+}
+
+static void test_noise_floor_detection(void) {
+    printf("Testing known-noise detection against the tracked floor...\n");
+
+    const uint32_t size = 4096;
+    const double pfa = 1e-2;
+    double *row = malloc(size * sizeof(double));
+    cfar_detection_t *detections = malloc(size * sizeof(cfar_detection_t));
+    assert(row && detections);
+
+    noise_floor_t nf;
+    assert(noise_floor_init(&nf, size, NOISE_FLOOR_EWMA, 256) == true);
+    fill_exponential_row(row, size, 3.0);
+    assert(noise_floor_detect(&nf, row, pfa, detections, size) == 0);  // Nothing tracked yet
+
+    uint64_t total = 0, tested = 0;
+    for (uint32_t r = 0; r < 600; r++) {
+        fill_exponential_row(row, size, 3.0);
+        uint32_t count = noise_floor_detect(&nf, row, pfa, detections, size);
+        if (r >= 400) {
+            total += count;
+            tested += size;
+        }
+        noise_floor_update(&nf, row);
+    }
+    double rate = (double)total / (double)tested;
+    assert(rate > 0.5 * pfa && rate < 2.0 * pfa);
+
+    // A tone 20 dB up is found at its bin
+    fill_exponential_row(row, size, 3.0);
+    row[1234] = 300.0;
+    uint32_t count = noise_floor_detect(&nf, row, 1e-6, detections, size);
+    assert(count >= 1);
+    bool found = false;
+    for (uint32_t i = 0; i < count; i++) found |= detections[i].bin_index == 1234;
+    assert(found);
+
+    noise_floor_free(&nf);
+    free(detections);
+    free(row);
+    printf("✓ Noise floor detection tests passed (%.4f for PFA %.4f)\n", rate, pfa);
+}
+
+static void test_noise_floor_features(void) {
+    printf("Testing features with a tracked noise floor...\n");
+
+    const uint32_t size = 1024;
+    double row[1024];
+
+    noise_floor_t nf;
+    assert(noise_floor_init(&nf, size, NOISE_FLOOR_MEDIAN, 32) == true);
+    for (uint32_t r = 0; r < 400; r++) {
+        fill_exponential_row(row, size, 1e-4);
+        noise_floor_update(&nf, row);
+    }
+
+    features_t features;
+    assert(features_init(&features, size, 2000000.0, 128) == true);
+    features_set_noise_floor(&features, noise_floor_get(&nf));
+
+    // A tone 40 dB above the noise, with the neighbours that the spectrum
+    // estimate would use raised by an adjacent interferer
+    fill_exponential_row(row, size, 1e-4);
+    row[500] = 1.0;
+    for (uint32_t b = 505; b < 520; b++) row[b] = 1e-2;
+
+    features_result_t result;
+    assert(features_extract_from_spectrum(&features, row, 500, 1, &result) == true);
+    assert(fabs(result.snr_db - 40.0) < 2.0);
+    assert(fabs(features_estimate_noise_floor(&features, row, 500, 1) - 1e-4) < 2e-5);
+
+    // Without the tracker the interferer drags the SNR down
+    features_set_noise_floor(&features, NULL);
+    assert(features_extract_from_spectrum(&features, row, 500, 1, &result) == true);
+    assert(result.snr_db < 35.0);
+
+    features_free(&features);
+    noise_floor_free(&nf);
+    printf("✓ Features noise floor tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running Noise Floor Unit Tests\n");
+    printf("==============================\n\n");
+
+    test_noise_floor_initialization();
+    test_noise_floor_stationary();
+    test_noise_floor_burst_rejection();
+    test_noise_floor_detection();
+    test_noise_floor_features();
+
+    printf("\n==============================\n");
+    printf("All noise floor tests passed! ✓\n");
+    printf("==============================\n");
+    return 0;
+}
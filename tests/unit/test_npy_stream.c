@@ -0,0 +1,192 @@
+/*
+ * IQ Lab - NumPy Row Stream Unit Tests
+ *
+ * Tests for npy_stream: the header must parse as .npy 1.0 with the final
+ * shape patched in, the data must start on the fixed offset, float32 rows
+ * must round-trip bit for bit across buffer flushes, and the float16
+ * conversion must round to nearest even and keep zeros, subnormals,
+ * infinities and NaN.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include "../../src/viz/npy_stream.h"
+
+#define TEST_FILE "test_npy_stream.npy"
+
+// Whole file into memory
+static uint8_t *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc((size_t)size + 1);
+    assert(data && fread(data, 1, (size_t)size, f) == (size_t)size);
+    fclose(f);
+    data[size] = 0;
+    *len = (size_t)size;
+    return data;
+}
+
+// Magic, version, header length and the dictionary fields
+static void check_header(const uint8_t *data, size_t len, const char *descr, unsigned long long rows, unsigned cols) {
+    assert(len >= NPY_STREAM_HEADER_BYTES);
+    assert(memcmp(data, "\x93NUMPY", 6) == 0 && data[6] == 1 && data[7] == 0);
+    assert((size_t)(data[8] | (data[9] << 8)) + 10 == NPY_STREAM_HEADER_BYTES);
+    assert(NPY_STREAM_HEADER_BYTES % 64 == 0);
+    assert(data[NPY_STREAM_HEADER_BYTES - 1] == '\n');
+
+    char expected[128];
+    snprintf(expected, sizeof(expected), "{'descr': '%s', 'fortran_order': False, 'shape': (%llu, %u), }",
+             descr, rows, cols);
+    assert(memcmp(data + 10, expected, strlen(expected)) == 0);
+    for (size_t i = 10 + strlen(expected); i < NPY_STREAM_HEADER_BYTES - 1; i++) {
+        assert(data[i] == ' ');
+    }
+}
+
+static void test_float32_rows(void) {
+    printf("Testing float32 rows...\n");
+
+    // Rows of 300000 bytes: the 4 MB buffer flushes several times
+    const uint32_t cols = 75000;
+    const uint64_t rows = 61;
+    float *values = malloc((size_t)rows * cols * sizeof(float));
+    assert(values);
+    for (size_t i = 0; i < (size_t)rows * cols; i++) {
+        values[i] = (float)((double)i * 0.37 - 1e5);
+    }
+    values[5] = NAN;
+    values[6] = -INFINITY;
+    values[7] = 1e-40f;
+
+    npy_stream_t npy;
+    assert(npy_stream_open(&npy, TEST_FILE, NPY_FLOAT32, cols));
+    // Uneven batches, including an empty one
+    assert(npy_stream_write_rows(&npy, values, 1));
+    assert(npy_stream_write_rows(&npy, values + cols, 0));
+    assert(npy_stream_write_rows(&npy, values + cols, 17));
+    assert(npy_stream_write_rows(&npy, values + 18 * cols, rows - 18));
+    assert(npy.rows_written == rows);
+    assert(npy_stream_close(&npy));
+
+    size_t len;
+    uint8_t *data = read_file(TEST_FILE, &len);
+    check_header(data, len, "<f4", (unsigned long long)rows, cols);
+    assert(len == NPY_STREAM_HEADER_BYTES + (size_t)rows * cols * sizeof(float));
+    assert(memcmp(data + NPY_STREAM_HEADER_BYTES, values, (size_t)rows * cols * sizeof(float)) == 0);
+    free(data);
+    free(values);
+
+    // No rows at all: still a valid empty matrix
+    assert(npy_stream_open(&npy, TEST_FILE, NPY_FLOAT32, 8));
+    assert(npy_stream_close(&npy));
+    data = read_file(TEST_FILE, &len);
+    check_header(data, len, "<f4", 0, 8);
+    assert(len == NPY_STREAM_HEADER_BYTES);
+    free(data);
+
+    printf("✓ Float32 row test passed\n");
+}
+
+static void test_float16_rows(void) {
+    printf("Testing float16 rows...\n");
+
+    const float values[6] = { 0.0f, 1.0f, -2.5f, 65504.0f, 1e6f, -60.25f };
+    npy_stream_t npy;
+    assert(npy_stream_open(&npy, TEST_FILE, NPY_FLOAT16, 3));
+    assert(npy_stream_write_rows(&npy, values, 2));
+    assert(npy_stream_close(&npy));
+
+    size_t len;
+    uint8_t *data = read_file(TEST_FILE, &len);
+    check_header(data, len, "<f2", 2, 3);
+    assert(len == NPY_STREAM_HEADER_BYTES + 6 * 2);
+    const uint16_t expected[6] = { 0x0000, 0x3C00, 0xC100, 0x7BFF, 0x7C00, 0xD388 };
+    for (int i = 0; i < 6; i++) {
+        const uint8_t *p = data + NPY_STREAM_HEADER_BYTES + i * 2;
+        assert((uint16_t)(p[0] | (p[1] << 8)) == expected[i]);
+    }
+    free(data);
+
+    printf("✓ Float16 row test passed\n");
+}
+
+static void test_half_conversion(void) {
+    printf("Testing float16 conversion...\n");
+
+    assert(npy_float_to_half(0.0f) == 0x0000);
+    assert(npy_float_to_half(-0.0f) == 0x8000);
+    assert(npy_float_to_half(1.0f) == 0x3C00);
+    assert(npy_float_to_half(-1.0f) == 0xBC00);
+    assert(npy_float_to_half(65504.0f) == 0x7BFF);
+    assert(npy_float_to_half(65520.0f) == 0x7C00);        // Halfway above the largest: rounds to infinity
+    assert(npy_float_to_half(65519.0f) == 0x7BFF);
+    assert(npy_float_to_half(INFINITY) == 0x7C00);
+    assert(npy_float_to_half(-INFINITY) == 0xFC00);
+    uint16_t nan = npy_float_to_half(NAN);
+    assert((nan & 0x7C00) == 0x7C00 && (nan & 0x3FF) != 0);
+
+    // Ties to even: 1 + 2^-11 sits between 1 and 1 + 2^-10
+    assert(npy_float_to_half(1.0f + ldexpf(1.0f, -11)) == 0x3C00);
+    assert(npy_float_to_half(1.0f + 3.0f * ldexpf(1.0f, -11)) == 0x3C02);
+    assert(npy_float_to_half(1.0f + ldexpf(1.0f, -11) + ldexpf(1.0f, -20)) == 0x3C01);
+
+    // Subnormals: smallest, largest, a tie and the underflow edge
+    assert(npy_float_to_half(ldexpf(1.0f, -24)) == 0x0001);
+    assert(npy_float_to_half(ldexpf(1023.0f, -24)) == 0x03FF);
+    assert(npy_float_to_half(ldexpf(1.0f, -14)) == 0x0400);
+    assert(npy_float_to_half(ldexpf(3.0f, -25)) == 0x0002);   // 1.5 ulp: tie to even
+    assert(npy_float_to_half(ldexpf(1.0f, -25)) == 0x0000);   // Half the smallest: tie to zero
+    assert(npy_float_to_half(ldexpf(1.0f, -25) * 1.001f) == 0x0001);
+    assert(npy_float_to_half(-ldexpf(1.0f, -30)) == 0x8000);
+    assert(npy_float_to_half(1e-40f) == 0x0000);
+
+    // Every finite half survives a round trip through float
+    for (uint32_t h = 0; h < 0x10000; h++) {
+        if ((h & 0x7C00) == 0x7C00) continue;
+        float f = npy_half_to_float((uint16_t)h);
+        assert(npy_float_to_half(f) == h);
+    }
+    assert(npy_half_to_float(0x7C00) == INFINITY);
+    assert(isnan(npy_half_to_float(0x7E00)));
+    assert(npy_half_to_float(0x0001) == ldexpf(1.0f, -24));
+
+    printf("✓ Float16 conversion test passed\n");
+}
+
+static void test_errors(void) {
+    printf("Testing error handling...\n");
+
+    npy_stream_t npy;
+    assert(!npy_stream_open(&npy, TEST_FILE, NPY_FLOAT32, 0));
+    assert(!npy_stream_open(&npy, "nonexistent_dir/out.npy", NPY_FLOAT32, 4));
+    assert(!npy_stream_open(NULL, TEST_FILE, NPY_FLOAT32, 4));
+
+    npy_dtype_t dtype;
+    assert(npy_dtype_from_name("f16", &dtype) && dtype == NPY_FLOAT16);
+    assert(npy_dtype_from_name("float32", &dtype) && dtype == NPY_FLOAT32);
+    assert(!npy_dtype_from_name("f64", &dtype));
+    assert(npy_dtype_size(NPY_FLOAT16) == 2 && npy_dtype_size(NPY_FLOAT32) == 4);
+
+    printf("✓ Error handling test passed\n");
+}
+
+int main(void) {
+    printf("=== NumPy Row Stream Unit Tests ===\n\n");
+
+    test_float32_rows();
+    test_float16_rows();
+    test_half_conversion();
+    test_errors();
+
+    remove(TEST_FILE);
+
+    printf("\n✓ All npy stream tests passed!\n");
+    return 0;
+}
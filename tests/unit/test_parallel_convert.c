@@ -0,0 +1,375 @@
+/*
+ * IQ Lab - Parallel Chunked Converter Unit Tests
+ *
+ * Tests for parallel_convert: the float -> s8/s16 kernels must match the
+ * scalar cast in every SIMD family; plans must stay inside max_memory_mb
+ * with aligned chunks; and any thread count, chunk size or input offset must
+ * give the same bytes as a single scalar pass, for raw IQ and for WAV input
+ * through convert_file. Packed s12 chunks must stay pair-aligned.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "../../src/iq_core/io_iq.h"
+#include "../../src/converter/converter.h"
+#include "../../src/converter/utils/parallel_convert.h"
+
+#define TEST_INPUT "test_parallel_convert_in.bin"
+#define TEST_OUTPUT "test_parallel_convert_out.iq"
+#define TEST_WAV "test_parallel_convert_in.wav"
+
+// Deterministic pseudo-random stream
+static uint32_t rng_state = 12345;
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static void write_file(const char *path, const void *data, size_t bytes) {
+    FILE *f = fopen(path, "wb");
+    assert(f);
+    assert(fwrite(data, 1, bytes, f) == bytes);
+    fclose(f);
+}
+
+static uint8_t *read_file(const char *path, size_t *bytes) {
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    *bytes = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(*bytes + 1);
+    assert(data);
+    assert(fread(data, 1, *bytes, f) == *bytes);
+    fclose(f);
+    return data;
+}
+
+// One value through the float stage, written as the scalar loop would
+static int reference_value(int value, iq_format_t from, iq_format_t to) {
+    float f = (from == IQ_FORMAT_S8) ? (float)value / 128.0f : (float)value / 32768.0f;
+    float v = f * ((to == IQ_FORMAT_S8) ? 127.0f : 32767.0f);
+    return (to == IQ_FORMAT_S8) ? (int8_t)v : (int16_t)v;
+}
+
+static void test_float_kernels(void) {
+    printf("Testing float -> s8/s16 kernels...\n");
+
+    enum { COUNT = 1037 };  // Not a multiple of any vector width
+    float input[COUNT];
+    int16_t s16[COUNT], s16_ref[COUNT];
+    int8_t s8[COUNT], s8_ref[COUNT];
+
+    for (int i = 0; i < COUNT; i++) {
+        input[i] = ((float)(next_random() % 200001) - 100000.0f) / 66666.0f;  // Beyond [-1, 1] to hit the clamps
+    }
+    input[0] = 1.0f;
+    input[1] = -1.0f;
+    input[2] = 0.0f;
+
+    iq_simd_t detected = iq_convert_simd();
+    iq_convert_set_simd(IQ_SIMD_NONE);
+    iq_convert_from_float(input, COUNT, IQ_FORMAT_S16, s16_ref);
+    iq_convert_from_float(input, COUNT, IQ_FORMAT_S8, s8_ref);
+    for (int i = 0; i < COUNT; i++) {
+        float v = input[i] * 32767.0f;
+        if (v > 32767.0f) v = 32767.0f;
+        if (v < -32768.0f) v = -32768.0f;
+        assert(s16_ref[i] == (int16_t)v);
+    }
+    assert(s16_ref[0] == 32767 && s16_ref[1] == -32767 && s8_ref[0] == 127 && s8_ref[1] == -127);
+
+    const iq_simd_t families[] = { IQ_SIMD_SSE2, IQ_SIMD_AVX2, IQ_SIMD_NEON };
+    for (size_t k = 0; k < sizeof(families) / sizeof(families[0]); k++) {
+        iq_convert_set_simd(families[k]);
+        if (iq_convert_simd() != families[k]) {
+            continue;  // Not available on this CPU
+        }
+        memset(s16, 0, sizeof(s16));
+        memset(s8, 0, sizeof(s8));
+        iq_convert_from_float(input, COUNT, IQ_FORMAT_S16, s16);
+        iq_convert_from_float(input, COUNT, IQ_FORMAT_S8, s8);
+        assert(memcmp(s16, s16_ref, sizeof(s16)) == 0);
+        assert(memcmp(s8, s8_ref, sizeof(s8)) == 0);
+        printf("  %s matches scalar\n", iq_simd_name(iq_convert_simd()));
+    }
+    iq_convert_set_simd(detected);
+
+    printf("✓ Float kernels test passed\n");
+}
+
+static void test_plan(void) {
+    printf("Testing chunk plans...\n");
+
+    parallel_convert_job_t job = {
+        .input_format = IQ_FORMAT_S16,
+        .output_format = IQ_FORMAT_S8,
+        .num_samples = 100000000,
+        .rescale = true,
+        .num_threads = 16
+    };
+    parallel_convert_stats_t plan;
+
+    // Unlimited: every thread, default chunk
+    parallel_convert_plan(&job, &plan);
+    assert(plan.threads == 16 && plan.chunk_samples == PARALLEL_CONVERT_CHUNK);
+
+    const size_t limits[] = { 1, 2, 7, 64, 1000 };
+    for (size_t i = 0; i < sizeof(limits) / sizeof(limits[0]); i++) {
+        job.max_memory_mb = limits[i];
+        parallel_convert_plan(&job, &plan);
+        assert(plan.threads >= 1 && plan.threads <= 16);
+        assert(plan.chunk_samples % PARALLEL_CONVERT_ALIGN == 0);
+        assert(plan.buffer_bytes <= limits[i] * 1024 * 1024);
+        assert(plan.buffer_bytes == (size_t)plan.threads * plan.chunk_samples * 6);
+    }
+
+    // 1 MB of 6-byte samples keeps two threads with 64K+ sample chunks
+    job.max_memory_mb = 1;
+    parallel_convert_plan(&job, &plan);
+    assert(plan.threads == 2 && plan.chunk_samples >= 64 * 1024);
+
+    // Small input: no idle workers, chunks spread over the threads
+    job.max_memory_mb = 0;
+    job.num_samples = 3 * PARALLEL_CONVERT_ALIGN + 5;
+    parallel_convert_plan(&job, &plan);
+    assert(plan.threads == 4 && plan.chunk_samples == PARALLEL_CONVERT_ALIGN);
+
+    printf("✓ Chunk plan test passed\n");
+}
+
+static void check_conversion(iq_format_t from, iq_format_t to, bool rescale, uint64_t offset, size_t samples) {
+    size_t in_value = iq_native_sample_bytes(from) / 2;
+    size_t out_value = iq_native_sample_bytes(to) / 2;
+    size_t values = samples * 2;
+
+    // Header bytes, then values covering the whole range of the type
+    uint8_t *input = malloc(offset + values * in_value);
+    uint8_t *expected = malloc(values * out_value);
+    assert(input && expected);
+    for (uint64_t i = 0; i < offset; i++) input[i] = (uint8_t)(0xA5 ^ i);
+    for (size_t i = 0; i < values; i++) {
+        int value = (from == IQ_FORMAT_S8) ? (int8_t)next_random() : (int16_t)next_random();
+        if (i == 0) value = (from == IQ_FORMAT_S8) ? -128 : -32768;
+        int out = rescale ? reference_value(value, from, to) : value;
+        if (from == IQ_FORMAT_S8) ((int8_t *)(input + offset))[i] = (int8_t)value;
+        else memcpy(input + offset + i * 2, &(int16_t){ (int16_t)value }, 2);
+        if (to == IQ_FORMAT_S8) ((int8_t *)expected)[i] = (int8_t)out;
+        else memcpy(expected + i * 2, &(int16_t){ (int16_t)out }, 2);
+    }
+    write_file(TEST_INPUT, input, offset + values * in_value);
+
+    const uint32_t threads[] = { 1, 3, 8 };
+    const size_t memory[] = { 0, 1 };
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        for (size_t m = 0; m < sizeof(memory) / sizeof(memory[0]); m++) {
+            parallel_convert_job_t job = {
+                .input_file = TEST_INPUT,
+                .input_offset = offset,
+                .input_format = from,
+                .output_file = TEST_OUTPUT,
+                .output_format = to,
+                .num_samples = samples,
+                .rescale = rescale,
+                .max_memory_mb = memory[m],
+                .num_threads = threads[t]
+            };
+            parallel_convert_stats_t stats;
+            char error[256];
+            assert(parallel_convert(&job, &stats, error, sizeof(error)));
+            assert(stats.bytes_written == values * out_value);
+
+            size_t bytes;
+            uint8_t *output = read_file(TEST_OUTPUT, &bytes);
+            assert(bytes == values * out_value);
+            assert(memcmp(output, expected, bytes) == 0);
+            free(output);
+        }
+    }
+
+    free(input);
+    free(expected);
+}
+
+static void test_conversions(void) {
+    printf("Testing chunked conversions...\n");
+
+    // Odd lengths so the last chunk is partial
+    check_conversion(IQ_FORMAT_S16, IQ_FORMAT_S8, true, 0, 300001);
+    check_conversion(IQ_FORMAT_S8, IQ_FORMAT_S16, true, 0, 150007);
+    check_conversion(IQ_FORMAT_S16, IQ_FORMAT_S16, true, 44, 200003);
+    check_conversion(IQ_FORMAT_S16, IQ_FORMAT_S16, false, 0, 99999);
+
+    // Same bytes with the scalar kernels forced
+    iq_simd_t detected = iq_convert_simd();
+    iq_convert_set_simd(IQ_SIMD_NONE);
+    check_conversion(IQ_FORMAT_S16, IQ_FORMAT_S8, true, 7, 70001);
+    iq_convert_set_simd(detected);
+
+    // Input shorter than the job: error, not silent zeros
+    parallel_convert_job_t job = {
+        .input_file = TEST_INPUT,
+        .input_format = IQ_FORMAT_S16,
+        .output_file = TEST_OUTPUT,
+        .output_format = IQ_FORMAT_S8,
+        .num_samples = 1000000,
+        .rescale = true,
+        .num_threads = 4
+    };
+    char error[256] = "";
+    assert(!parallel_convert(&job, NULL, error, sizeof(error)));
+    assert(strstr(error, "Read failed") != NULL);
+
+    // Byte copy cannot change the format
+    job.num_samples = 10;
+    job.rescale = false;
+    assert(!parallel_convert(&job, NULL, error, sizeof(error)));
+
+    remove(TEST_INPUT);
+    remove(TEST_OUTPUT);
+    printf("✓ Chunked conversion test passed\n");
+}
+
+// s16 -> packed s12 -> s16: chunked output equals one scalar pass
+static void test_packed_conversions(void) {
+    printf("Testing packed s12 conversions...\n");
+
+    enum { SAMPLES = 100003 };
+    int16_t *values = malloc(SAMPLES * 2 * sizeof(int16_t));
+    float *floats = malloc(SAMPLES * 2 * sizeof(float));
+    uint8_t *packed = malloc(SAMPLES * 3);
+    int16_t *back = malloc(SAMPLES * 2 * sizeof(int16_t));
+    assert(values && floats && packed && back);
+    for (size_t i = 0; i < SAMPLES * 2; i++) values[i] = (int16_t)next_random();
+    values[0] = -32768;
+    values[1] = 32767;
+
+    iq_simd_t detected = iq_convert_simd();
+    iq_convert_set_simd(IQ_SIMD_NONE);
+    assert(iq_convert_to_float((const uint8_t *)values, SAMPLES * 4, IQ_FORMAT_S16, floats, SAMPLES));
+    iq_convert_from_float(floats, SAMPLES * 2, IQ_FORMAT_S12, packed);
+    assert(iq_convert_to_float(packed, SAMPLES * 3, IQ_FORMAT_S12, floats, SAMPLES));
+    iq_convert_from_float(floats, SAMPLES * 2, IQ_FORMAT_S16, back);
+    iq_convert_set_simd(detected);
+
+    // Twelve bits keep every value within two 12-bit steps
+    for (size_t i = 0; i < SAMPLES * 2; i++) {
+        assert(abs(back[i] - values[i]) <= 40);
+    }
+
+    const uint32_t threads[] = { 1, 3, 8 };
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        for (int direction = 0; direction < 2; direction++) {
+            parallel_convert_job_t job = {
+                .input_file = TEST_INPUT,
+                .input_format = direction ? IQ_FORMAT_S12 : IQ_FORMAT_S16,
+                .output_file = TEST_OUTPUT,
+                .output_format = direction ? IQ_FORMAT_S16 : IQ_FORMAT_S12,
+                .num_samples = SAMPLES,
+                .rescale = true,
+                .max_memory_mb = 1,
+                .num_threads = threads[t]
+            };
+            if (direction) write_file(TEST_INPUT, packed, SAMPLES * 3);
+            else write_file(TEST_INPUT, values, SAMPLES * 4);
+
+            char error[256];
+            assert(parallel_convert(&job, NULL, error, sizeof(error)));
+
+            size_t bytes;
+            uint8_t *output = read_file(TEST_OUTPUT, &bytes);
+            assert(bytes == (direction ? SAMPLES * 4 : SAMPLES * 3));
+            assert(memcmp(output, direction ? (const void *)back : (const void *)packed, bytes) == 0);
+            free(output);
+        }
+    }
+
+    free(values);
+    free(floats);
+    free(packed);
+    free(back);
+    remove(TEST_INPUT);
+    remove(TEST_OUTPUT);
+    printf("✓ Packed conversion test passed\n");
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static void test_wav_to_iq(void) {
+    printf("Testing WAV to IQ through convert_file...\n");
+
+    // Stereo 16-bit PCM at 2 MHz, followed by a LIST chunk that is not audio
+    enum { SAMPLES = 250001, SAMPLE_RATE = 2000000 };
+    size_t data_bytes = (size_t)SAMPLES * 4;
+    size_t total = 44 + data_bytes + 16;
+    uint8_t *wav = calloc(total, 1);
+    assert(wav);
+    memcpy(wav, "RIFF", 4);
+    put_u32(wav + 4, (uint32_t)(total - 8));
+    memcpy(wav + 8, "WAVEfmt ", 8);
+    put_u32(wav + 16, 16);
+    wav[20] = 1; wav[22] = 2;
+    put_u32(wav + 24, SAMPLE_RATE);
+    put_u32(wav + 28, SAMPLE_RATE * 4);
+    wav[32] = 4; wav[34] = 16;
+    memcpy(wav + 36, "data", 4);
+    put_u32(wav + 40, (uint32_t)data_bytes);
+    int16_t *values = malloc(data_bytes);
+    assert(values);
+    for (size_t i = 0; i < (size_t)SAMPLES * 2; i++) values[i] = (int16_t)next_random();
+    memcpy(wav + 44, values, data_bytes);
+    memcpy(wav + 44 + data_bytes, "LIST\x08\0\0\0INFOxxxx", 16);
+    write_file(TEST_WAV, wav, total);
+
+    const file_format_t outputs[] = { FORMAT_IQ_S16, FORMAT_IQ_S8 };
+    for (size_t k = 0; k < 2; k++) {
+        iq_format_t to = (outputs[k] == FORMAT_IQ_S8) ? IQ_FORMAT_S8 : IQ_FORMAT_S16;
+        conversion_request_t request;
+        memset(&request, 0, sizeof(request));
+        init_converter_options(&request.options);
+        request.input_file = TEST_WAV;
+        request.output_file = TEST_OUTPUT;
+        request.input_format = FORMAT_WAV;
+        request.output_format = outputs[k];
+        request.options.force_overwrite = true;
+        request.options.max_memory_mb = 1;
+        request.options.num_threads = 4;
+
+        converter_result_t result = convert_file(&request);
+        assert(result.success);
+        assert(result.samples_converted == SAMPLES);
+
+        size_t bytes;
+        uint8_t *output = read_file(TEST_OUTPUT, &bytes);
+        assert(bytes == (size_t)SAMPLES * iq_native_sample_bytes(to));
+        for (size_t i = 0; i < (size_t)SAMPLES * 2; i++) {
+            int out = (to == IQ_FORMAT_S8) ? ((int8_t *)output)[i] : ((int16_t *)output)[i];
+            assert(out == reference_value(values[i], IQ_FORMAT_S16, to));
+        }
+        free(output);
+    }
+
+    free(values);
+    free(wav);
+    remove(TEST_WAV);
+    remove(TEST_OUTPUT);
+    printf("✓ WAV to IQ test passed\n");
+}
+
+int main(void) {
+    printf("=== Parallel Converter Unit Tests ===\n\n");
+
+    test_float_kernels();
+    test_plan();
+    test_conversions();
+    test_packed_conversions();
+    test_wav_to_iq();
+
+    printf("\n✓ All parallel converter tests passed!\n");
+    return 0;
+}
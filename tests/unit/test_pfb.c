@@ -0,0 +1,501 @@
+/*
+ * IQ Lab - Polyphase Filter Bank Unit Tests
+ *
+ * Tests for the polyphase channelizer. The commutator output must equal the
+ * direct form (filter every channel's mix-down, then decimate) for critical
+ * and 2x oversampling; a tone must land in its own channel with the others
+ * well below it; splitting the input into arbitrary chunks, or pausing on
+ * full channel buffers, must not change a single output sample; a consumer
+ * thread draining the channel rings in place must see exactly those
+ * samples too; the SIMD tap sweep must match the scalar one bit for bit;
+ * and filters loaded from the on-disk cache must equal designed ones.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // sched_yield
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../../src/chan/pfb.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static uint32_t rng_state = 11u;
+
+// Uniform in [-0.5, 0.5), deterministic
+static float next_uniform(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)((rng_state >> 8) / 16777216.0 - 0.5);
+}
+
+static void fill_noise(float complex *x, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] = next_uniform() + I * next_uniform();
+    }
+}
+
+static pfb_t *create_pfb(uint32_t channels, uint32_t filter_length, uint32_t oversampling,
+                         uint32_t block_size) {
+    pfb_config_t config;
+    assert(pfb_config_init(&config, channels, 1000000.0, 1000000.0 / channels) == true);
+    config.filter_length = filter_length;
+    config.oversampling = oversampling;
+    config.block_size = block_size;
+    return pfb_create(&config);
+}
+
+static void test_pfb_config(void) {
+    printf("Testing PFB configuration...\n");
+
+    pfb_config_t config;
+    assert(pfb_config_init(&config, 8, 2000000.0, 250000.0) == true);
+    assert(config.fft_size == 8);
+    assert(config.oversampling == 1);
+    assert(pfb_config_validate(&config) == true);
+
+    config.fft_size = 4096;      // The commutator FFT is one point per branch
+    assert(pfb_config_validate(&config) == false);
+    config.fft_size = 8;
+    config.oversampling = 3;
+    assert(pfb_config_validate(&config) == false);
+    config.oversampling = 2;
+    assert(pfb_config_validate(&config) == true);
+
+    pfb_t *pfb = pfb_create(&config);
+    assert(pfb != NULL);
+    assert(pfb->branch_length == 4096 / 8);
+    assert(pfb->decimation == 4);
+    assert(fabs(pfb_get_output_rate(pfb) - 500000.0) < 1e-6);
+    pfb_destroy(pfb);
+
+    assert(pfb_config_init(&config, 2, 2000000.0, 250000.0) == false);
+    assert(pfb_config_init(&config, 8192, 2000000.0, 250000.0) == false);
+
+    // Large banks keep enough taps per branch and a bounded output buffer
+    assert(pfb_config_init(&config, 4096, 20000000.0, 25000.0) == true);
+    assert(config.filter_length == 4096 * PFB_MIN_BRANCH_TAPS);
+    assert((uint64_t)config.block_size * 4096 <= PFB_OUTPUT_BUDGET);
+    assert(pfb_config_validate(&config) == true);
+    printf("✓ PFB configuration tests passed\n");
+}
+
+// Direct form: channel k of the output taken after sample N
+static double complex direct_output(const pfb_t *pfb, const float complex *x, uint64_t N,
+                                    uint32_t k) {
+    uint32_t M = pfb->num_branches;
+    double complex sum = 0.0;
+    for (uint32_t n = 0; n < pfb->filter_length && n <= N; n++) {
+        uint64_t t = N - n;
+        double angle = -2.0 * M_PI * (double)((k * t) % M) / (double)M;
+        sum += pfb->prototype_filter[n] * x[t] * (cos(angle) + I * sin(angle));
+    }
+    return sum;
+}
+
+static void test_pfb_matches_direct_form(void) {
+    printf("Testing PFB against the direct form...\n");
+
+    const uint32_t M = 8, L = 128, n = 2048;
+    float complex *x = malloc(n * sizeof(float complex));
+    assert(x);
+    fill_noise(x, n);
+
+    for (uint32_t oversampling = 1; oversampling <= 2; oversampling++) {
+        pfb_t *pfb = create_pfb(M, L, oversampling, n);
+        assert(pfb != NULL);
+        assert(pfb_process_block(pfb, x, n) == (int32_t)n);
+
+        uint32_t D = M / oversampling;
+        double max_error = 0.0;
+        for (uint32_t chan = 0; chan < M; chan++) {
+            uint32_t count;
+            const float complex *y = pfb_get_channel_output(pfb, chan, &count);
+            assert(y && count == n / D);
+
+            uint32_t k = (chan + M - M / 2) % M;
+            for (uint32_t m = 0; m < count; m++) {
+                double complex ref = direct_output(pfb, x, (uint64_t)(m + 1) * D - 1, k);
+                double error = cabs(y[m] - ref);
+                if (error > max_error) max_error = error;
+            }
+        }
+        assert(max_error < 1e-5);
+        printf("  %ux oversampled: max error %.2e over %u outputs per channel\n",
+               oversampling, max_error, n / D);
+        pfb_destroy(pfb);
+    }
+
+    free(x);
+    printf("✓ PFB direct form tests passed\n");
+}
+
+static void test_pfb_large_bank(void) {
+    printf("Testing PFB with 1024 channels...\n");
+
+    pfb_config_t config;
+    assert(pfb_config_init(&config, 1024, 20000000.0, 20000000.0 / 1024) == true);
+    const uint32_t M = config.num_channels, n = 2 * config.filter_length;
+    float complex *x = malloc(n * sizeof(float complex));
+    assert(x);
+    fill_noise(x, n);
+
+    for (uint32_t oversampling = 1; oversampling <= 2; oversampling++) {
+        config.oversampling = oversampling;
+        pfb_t *pfb = pfb_create(&config);
+        assert(pfb != NULL);
+
+        // Full buffers pause the bank; drain into the checks as it goes
+        uint32_t D = M / oversampling, outputs = 0, offset = 0;
+        double max_error = 0.0;
+        while (offset < n) {
+            int32_t used = pfb_process_block(pfb, x + offset, n - offset);
+            assert(used >= 0);
+            offset += (uint32_t)used;
+
+            uint32_t count = 0;
+            for (uint32_t chan = 0; chan < M; chan++) {
+                const float complex *y = pfb_get_channel_output(pfb, chan, &count);
+                assert(y);
+                // A spread of channels against the direct form
+                if (chan % 97 == 0) {
+                    uint32_t k = (chan + M - M / 2) % M;
+                    for (uint32_t m = 0; m < count; m++) {
+                        uint64_t N = (uint64_t)(outputs + m + 1) * D - 1;
+                        double error = cabs(y[m] - direct_output(pfb, x, N, k));
+                        if (error > max_error) max_error = error;
+                    }
+                }
+                pfb_reset_channel_output(pfb, chan);
+            }
+            outputs += count;
+        }
+        assert(outputs == n / D);
+        assert(max_error < 1e-5);
+        printf("  %ux oversampled: max error %.2e over %u outputs per channel\n",
+               oversampling, max_error, outputs);
+        pfb_destroy(pfb);
+    }
+
+    free(x);
+    printf("✓ PFB large bank tests passed\n");
+}
+
+static void test_pfb_tone_isolation(void) {
+    printf("Testing PFB tone isolation...\n");
+
+    const uint32_t M = 8, n = 16384;
+    const uint32_t tone_chan = 6;
+    float complex *x = malloc(n * sizeof(float complex));
+    assert(x);
+
+    pfb_t *pfb = create_pfb(M, 256, 1, n);
+    assert(pfb != NULL);
+
+    // Unit tone at the centre of channel 6; the prototype has unit DC gain
+    double f = pfb_get_channel_frequency(pfb, tone_chan) / pfb->config.sample_rate;
+    for (uint32_t i = 0; i < n; i++) {
+        double phase = 2.0 * M_PI * f * i;
+        x[i] = (float)cos(phase) + I * (float)sin(phase);
+    }
+    assert(pfb_process_block(pfb, x, n) == (int32_t)n);
+
+    // Skip the filter transient (one filter length of input)
+    uint32_t skip = pfb->branch_length;
+    double worst_db = -1000.0, tone_power = 0.0;
+    for (uint32_t chan = 0; chan < M; chan++) {
+        uint32_t count;
+        const float complex *y = pfb_get_channel_output(pfb, chan, &count);
+        double power = 0.0;
+        for (uint32_t m = skip; m < count; m++) power += crealf(y[m] * conjf(y[m]));
+        power /= (double)(count - skip);
+
+        if (chan == tone_chan) {
+            tone_power = power;
+        } else {
+            double db = 10.0 * log10(power + 1e-30);
+            if (db > worst_db) worst_db = db;
+        }
+    }
+    assert(fabs(tone_power - 1.0) < 0.05);
+    assert(worst_db < -60.0);
+    printf("  tone channel power %.3f, strongest other channel %.1f dB\n", tone_power, worst_db);
+
+    pfb_destroy(pfb);
+    free(x);
+    printf("✓ PFB tone isolation tests passed\n");
+}
+
+static void test_pfb_chunking(void) {
+    printf("Testing PFB chunked input and full buffers...\n");
+
+    const uint32_t M = 16, n = 5000;
+    float complex *x = malloc(n * sizeof(float complex));
+    assert(x);
+    fill_noise(x, n);
+
+    // Reference: one call, buffers large enough for everything
+    pfb_t *ref = create_pfb(M, 512, 2, n);
+    assert(ref != NULL);
+    assert(pfb_process_block(ref, x, n) == (int32_t)n);
+
+    // Odd chunks into buffers of 7 outputs, draining whenever consumption stops
+    pfb_t *pfb = create_pfb(M, 512, 2, 7);
+    assert(pfb != NULL);
+    float complex *collected = malloc((size_t)M * n * sizeof(float complex));
+    uint32_t collected_count[16] = {0};
+    assert(collected);
+
+    uint32_t offset = 0, chunk = 1;
+    while (offset < n) {
+        uint32_t len = chunk < n - offset ? chunk : n - offset;
+        int32_t used = pfb_process_block(pfb, x + offset, len);
+        assert(used >= 0 && (uint32_t)used <= len);
+        offset += (uint32_t)used;
+        chunk = chunk * 3 % 97 + 1;
+
+        for (uint32_t chan = 0; chan < M; chan++) {
+            uint32_t count;
+            const float complex *y = pfb_get_channel_output(pfb, chan, &count);
+            memcpy(collected + (size_t)chan * n + collected_count[chan], y, count * sizeof(float complex));
+            collected_count[chan] += count;
+            pfb_reset_channel_output(pfb, chan);
+        }
+    }
+
+    uint64_t total = 0;
+    assert(pfb_get_statistics(pfb, &total, NULL, 0) && total == n);
+    for (uint32_t chan = 0; chan < M; chan++) {
+        uint32_t count;
+        const float complex *y = pfb_get_channel_output(ref, chan, &count);
+        assert(collected_count[chan] == count);
+        assert(memcmp(collected + (size_t)chan * n, y, count * sizeof(float complex)) == 0);
+    }
+
+    // After a reset the same input gives the same outputs again
+    assert(pfb_reset(ref) == true);
+    assert(pfb_process_block(ref, x, n) == (int32_t)n);
+    uint32_t count;
+    const float complex *y = pfb_get_channel_output(ref, 3, &count);
+    assert(count == collected_count[3]);
+    assert(memcmp(collected + (size_t)3 * n, y, count * sizeof(float complex)) == 0);
+
+    pfb_destroy(pfb);
+    pfb_destroy(ref);
+    free(collected);
+    free(x);
+    printf("✓ PFB chunking tests passed\n");
+}
+
+typedef struct {
+    pfb_t *pfb;
+    float complex *collected;    // num_channels rows of expected outputs
+    uint32_t expected;           // Outputs per channel
+} ring_consumer_t;
+
+// Drain every channel ring in place, committing odd-sized pieces of each span
+static void *ring_consumer_thread(void *arg) {
+    ring_consumer_t *consumer = arg;
+    uint32_t M = consumer->pfb->num_channels;
+    uint32_t received[16] = {0};
+    uint32_t done = 0, piece = 1;
+
+    while (done < M) {
+        bool idle = true;
+        for (uint32_t chan = 0; chan < M; chan++) {
+            uint32_t count;
+            const float complex *y = pfb_channel_read(consumer->pfb, chan, &count);
+            assert(y != NULL);
+            if (count == 0) continue;
+
+            uint32_t take = piece < count ? piece : count;
+            piece = piece * 5 % 11 + 1;
+            memcpy(consumer->collected + (size_t)chan * consumer->expected + received[chan], y,
+                   take * sizeof(float complex));
+            assert(pfb_channel_commit(consumer->pfb, chan, take) == true);
+            received[chan] += take;
+            if (received[chan] == consumer->expected) done++;
+            idle = false;
+        }
+        if (idle) sched_yield();
+    }
+    return NULL;
+}
+
+static void test_pfb_threaded_rings(void) {
+    printf("Testing PFB channel rings with a consumer thread...\n");
+
+    const uint32_t M = 8, n = 20000, expected = n / (M / 2);
+    float complex *x = malloc(n * sizeof(float complex));
+    assert(x);
+    fill_noise(x, n);
+
+    pfb_t *ref = create_pfb(M, 256, 2, expected);
+    assert(ref != NULL);
+    assert(pfb_process_block(ref, x, n) == (int32_t)n);
+
+    // Rings of 5 outputs, so the producer keeps waiting on the consumer
+    pfb_t *pfb = create_pfb(M, 256, 2, 5);
+    assert(pfb != NULL);
+    assert((uintptr_t)pfb->channels % 64 == 0);
+    uint32_t count;
+    assert(pfb_channel_read(pfb, M, &count) == NULL);
+    assert(pfb_channel_commit(pfb, 0, 1) == false);
+
+    ring_consumer_t consumer = {pfb, malloc((size_t)M * expected * sizeof(float complex)), expected};
+    assert(consumer.collected);
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, ring_consumer_thread, &consumer) == 0);
+
+    uint32_t offset = 0;
+    while (offset < n) {
+        uint32_t len = n - offset < 333 ? n - offset : 333;
+        int32_t used = pfb_process_block(pfb, x + offset, len);
+        assert(used >= 0);
+        if (used == 0) sched_yield();
+        offset += (uint32_t)used;
+    }
+    pthread_join(thread, NULL);
+
+    for (uint32_t chan = 0; chan < M; chan++) {
+        const float complex *y = pfb_get_channel_output(ref, chan, &count);
+        assert(count == expected);
+        assert(memcmp(consumer.collected + (size_t)chan * expected, y,
+                      expected * sizeof(float complex)) == 0);
+        assert(pfb_channel_read(pfb, chan, &count) != NULL && count == 0);
+    }
+
+    pfb_destroy(pfb);
+    pfb_destroy(ref);
+    free(consumer.collected);
+    free(x);
+    printf("✓ PFB threaded ring tests passed\n");
+}
+
+static void test_pfb_simd_matches_scalar(void) {
+    printf("Testing PFB SIMD against scalar...\n");
+
+    const uint32_t n = 4096;
+    float complex *x = malloc(n * sizeof(float complex));
+    assert(x);
+    fill_noise(x, n);
+
+    const uint32_t channels[] = {4, 8, 16, 32};
+    for (size_t c = 0; c < sizeof(channels) / sizeof(channels[0]); c++) {
+        uint32_t M = channels[c];
+        pfb_t *simd = create_pfb(M, 256, 2, n);
+        pfb_t *scalar = create_pfb(M, 256, 2, n);
+        assert(simd != NULL && scalar != NULL);
+
+        // Taps and history sit on cache lines of the shared arena
+        assert((uintptr_t)simd->transposed_taps % 64 == 0);
+        assert((uintptr_t)simd->history % 64 == 0);
+        assert((uintptr_t)simd->fft_input % 64 == 0);
+
+        pfb_force_scalar(false);
+        assert(pfb_process_block(simd, x, n) == (int32_t)n);
+        pfb_force_scalar(true);
+        assert(pfb_process_block(scalar, x, n) == (int32_t)n);
+        pfb_force_scalar(false);
+
+        for (uint32_t chan = 0; chan < M; chan++) {
+            uint32_t count_simd, count_scalar;
+            const float complex *a = pfb_get_channel_output(simd, chan, &count_simd);
+            const float complex *b = pfb_get_channel_output(scalar, chan, &count_scalar);
+            assert(count_simd == count_scalar && count_simd == n / (M / 2));
+            assert(memcmp(a, b, count_simd * sizeof(float complex)) == 0);
+        }
+
+        pfb_destroy(simd);
+        pfb_destroy(scalar);
+    }
+
+    free(x);
+    printf("✓ PFB SIMD tests passed\n");
+}
+
+static void test_pfb_filter_cache(void) {
+    printf("Testing PFB filter cache...\n");
+
+    pfb_config_t config;
+    assert(pfb_config_init(&config, 16, 1000000.0, 1000000.0 / 16) == true);
+    config.filter_length = 1024;
+    const uint32_t L = config.filter_length;
+
+    pfb_t *designed = pfb_create(&config);
+    assert(designed != NULL);
+    char path[512];
+    assert(pfb_filter_cache_path(&config, path, sizeof(path)) == false);
+
+    // The first create writes the cache, the second loads the same taps
+    config.cache_dir = ".";
+    assert(pfb_filter_cache_path(&config, path, sizeof(path)) == true);
+    remove(path);
+    for (int run = 0; run < 2; run++) {
+        pfb_t *pfb = pfb_create(&config);
+        assert(pfb != NULL);
+        FILE *file = fopen(path, "rb");
+        assert(file != NULL);
+        fclose(file);
+        assert(memcmp(pfb->prototype_filter, designed->prototype_filter, L * sizeof(float)) == 0);
+        assert(memcmp(pfb->transposed_taps, designed->transposed_taps, 2 * L * sizeof(float)) == 0);
+        pfb_destroy(pfb);
+    }
+
+    // A corrupted file is redesigned and rewritten
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+    assert(fseek(file, -4, SEEK_END) == 0);
+    assert(fputc(0x5a, file) != EOF);
+    fclose(file);
+    pfb_t *pfb = pfb_create(&config);
+    assert(pfb != NULL);
+    assert(memcmp(pfb->transposed_taps, designed->transposed_taps, 2 * L * sizeof(float)) == 0);
+    float taps[3 * 1024];
+    assert(pfb_load_filter(&config, taps, taps + L) == true);
+    pfb_destroy(pfb);
+
+    // Every design parameter is part of the key
+    char other[512];
+    pfb_config_t changed = config;
+    changed.kaiser_beta = 7.0;
+    assert(pfb_filter_cache_path(&changed, other, sizeof(other)) && strcmp(path, other) != 0);
+    changed = config;
+    changed.overlap_factor = 0.2;
+    assert(pfb_filter_cache_path(&changed, other, sizeof(other)) && strcmp(path, other) != 0);
+    changed = config;
+    changed.channel_bandwidth *= 2.0;
+    assert(pfb_filter_cache_path(&changed, other, sizeof(other)) && strcmp(path, other) != 0);
+    assert(pfb_filter_cache_path(&config, other, 16) == false);
+
+    assert(remove(path) == 0);
+    pfb_destroy(designed);
+    printf("✓ PFB filter cache tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running PFB Unit Tests\n");
+    printf("======================\n\n");
+
+    test_pfb_config();
+    test_pfb_matches_direct_form();
+    test_pfb_large_bank();
+    test_pfb_tone_isolation();
+    test_pfb_chunking();
+    test_pfb_threaded_rings();
+    test_pfb_simd_matches_scalar();
+    test_pfb_filter_cache();
+
+    printf("\n======================\n");
+    printf("All PFB tests passed! ✓\n");
+    printf("======================\n");
+    return 0;
+}
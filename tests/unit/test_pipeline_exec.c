@@ -0,0 +1,939 @@
+/*
+ * IQ Lab - test_pipeline_exec.c: Unit tests for the pipeline executor
+ *
+ * Purpose: Run pipelines of stand-in tools (shell scripts in a temporary
+ * tool directory) and check the dependency graph: independent steps run
+ * concurrently up to max_parallel_jobs, a step starts only after the steps
+ * whose outputs it reads, steps fed by a failed step are skipped, tools
+ * not known to be read-only order against every step, and a step over
+ * its timeout is killed. In-process runs must hand the tool cores the
+ * decoded input through a shared source, bit-exact in float and native form,
+ * and run steps over the same STFT together on one spectral bus. With a
+ * step cache, a re-run restores unchanged steps instead of running them,
+ * keyed by parameters and input contents (a SigMF core:sha512 if given).
+ * Each step reports its own wall time and the child's CPU and memory use.
+ * A fan-out runs a {input}/{stem} template over many (globbed) inputs, a
+ * bounded number at once, within the global step and memory budgets.
+ * With a launcher, spawned steps run through the command template on the
+ * fan-out's nodes in turn, their arguments quoted, also for the remote
+ * shell of a nested "ssh {node} 'cd {cwd} && {command}'" template.
+ *
+ *
+ * Date: 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../../src/jobs/pipeline.h"
+#include "../../src/iq_core/io_iq.h"
+#include "../../src/iq_core/spectral_bus.h"
+#include "../../src/iq_core/io_sigmf.h"
+
+// Stand-in tool: sleeps --sleep seconds, counts to --spin, exits 3 if
+// --in is missing, 1 with --fail 1, and otherwise writes --out
+static const char *TOOL_SCRIPT =
+    "#!/bin/sh\n"
+    "out=; in=; delay=0; fail=0; spin=0\n"
+    "while [ $# -gt 1 ]; do\n"
+    "  case \"$1\" in\n"
+    "    --out) out=$2 ;;\n"
+    "    --in) in=$2 ;;\n"
+    "    --sleep) delay=$2 ;;\n"
+    "    --fail) fail=$2 ;;\n"
+    "    --spin) spin=$2 ;;\n"
+    "  esac\n"
+    "  shift 2\n"
+    "done\n"
+    "sleep \"$delay\"\n"
+    "i=0; while [ $i -lt \"$spin\" ]; do i=$((i + 1)); done\n"
+    "if [ -n \"$in\" ] && [ ! -f \"$in\" ]; then exit 3; fi\n"
+    "if [ \"$fail\" = 1 ]; then exit 1; fi\n"
+    "if [ -n \"$out\" ]; then echo done > \"$out\"; fi\n"
+    "exit 0\n";
+
+static char tool_dir[64];
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void install_tool(const char *name) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", tool_dir, name);
+    FILE *file = fopen(path, "w");
+    assert(file);
+    fputs(TOOL_SCRIPT, file);
+    fclose(file);
+    assert(chmod(path, 0755) == 0);
+}
+
+// Path of a file in the tool directory
+static const char *temp_path(const char *name) {
+    static char paths[8][128];
+    static int next = 0;
+    char *path = paths[next++ % 8];
+    snprintf(path, 128, "%s/%s", tool_dir, name);
+    return path;
+}
+
+// Append a step; params are key/value pairs ending with NULL
+static void add_step(yaml_document_t *document, const char *tool, ...) {
+    yaml_pipeline_step_t *step = yaml_add_step(document);
+    assert(step);
+    step->tool_name = yaml_copy_string(document, tool);
+
+    va_list args;
+    va_start(args, tool);
+    const char *key;
+    while ((key = va_arg(args, const char *)) != NULL) {
+        const char *value = va_arg(args, const char *);
+        assert(yaml_set_step_param(document, step, key, value));
+    }
+    va_end(args);
+}
+
+// Append an input; the path is formatted like printf
+static void add_input(yaml_document_t *document, const char *format, ...) {
+    char path[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(path, sizeof(path), format, args);
+    va_end(args);
+    yaml_input_t *input = yaml_add_input(document);
+    assert(input);
+    input->file = yaml_copy_string(document, path);
+}
+
+static void make_config(pipeline_config_t *config, bool parallel, uint32_t jobs) {
+    assert(pipeline_config_init(config));
+    config->enable_parallel = parallel;
+    config->max_parallel_jobs = jobs;
+    config->log_file[0] = '\0';
+    strcpy(config->tool_dir, tool_dir);
+}
+
+/**
+ * @brief Independent steps run together, bounded by max_parallel_jobs
+ */
+static void test_parallel_steps(void) {
+    printf("🧪 Testing parallel execution of independent steps...\n");
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_step(&document, "iqls", "sleep", "0.3", "out", temp_path("a"), NULL);
+    add_step(&document, "iqdetect", "sleep", "0.3", "out", temp_path("b"), NULL);
+    add_step(&document, "iqls", "sleep", "0.3", "out", temp_path("c"), NULL);
+
+    pipeline_config_t config;
+    make_config(&config, true, 3);
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(!pipeline_step_depends_on(executor, 1, 0, NULL));
+    assert(!pipeline_step_depends_on(executor, 2, 1, NULL));
+
+    double start = now_seconds();
+    assert(pipeline_execute(executor));
+    double elapsed = now_seconds() - start;
+    printf("  3 x 0.3 s steps, 3 jobs: %.3f s, peak %u running\n", elapsed, executor->peak_running);
+    assert(elapsed < 0.75);
+    assert(executor->peak_running == 3);
+    assert(executor->completed_steps == 3 && executor->failed_steps == 0);
+    pipeline_executor_destroy(executor);
+
+    // Two jobs: never more than two at once
+    make_config(&config, true, 2);
+    executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(pipeline_execute(executor));
+    assert(executor->peak_running == 2);
+    pipeline_executor_destroy(executor);
+
+    // Without parallelism every step waits for the one before
+    make_config(&config, false, 3);
+    executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(pipeline_step_depends_on(executor, 2, 0, NULL));
+    start = now_seconds();
+    assert(pipeline_execute(executor));
+    elapsed = now_seconds() - start;
+    printf("  3 x 0.3 s steps, sequential: %.3f s\n", elapsed);
+    assert(elapsed > 0.85);
+    assert(executor->peak_running == 1);
+    pipeline_executor_destroy(executor);
+
+    printf("✅ Parallel execution tests passed\n");
+}
+
+/**
+ * @brief A step that reads another step's output starts after it
+ */
+static void test_data_dependency(void) {
+    printf("🧪 Testing data dependencies...\n");
+
+    const char *first = temp_path("first.out");
+    const char *second = temp_path("second.out");
+    unlink(first);
+    unlink(second);
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_step(&document, "iqls", "sleep", "0.2", "out", first, NULL);
+    add_step(&document, "iqdetect", "in", first, "out", second, NULL);
+    add_step(&document, "iqls", "sleep", "0.1", "out", temp_path("other.out"), NULL);
+
+    pipeline_config_t config;
+    make_config(&config, true, 4);
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+
+    bool must_succeed = false;
+    assert(pipeline_step_depends_on(executor, 1, 0, &must_succeed) && must_succeed);
+    assert(!pipeline_step_depends_on(executor, 2, 0, NULL));
+    assert(!pipeline_step_depends_on(executor, 2, 1, NULL));
+
+    assert(pipeline_execute(executor));
+    assert(access(second, F_OK) == 0);
+    assert(executor->peak_running == 2);
+    pipeline_executor_destroy(executor);
+
+    printf("✅ Data dependency tests passed\n");
+}
+
+/**
+ * @brief Failures skip dependent steps; execution stops unless continuing
+ */
+static void test_failures(void) {
+    printf("🧪 Testing failure handling...\n");
+
+    const char *broken = temp_path("broken.out");
+    unlink(broken);
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_step(&document, "iqls", "fail", "1", "out", broken, NULL);
+    add_step(&document, "iqdetect", "in", broken, "out", temp_path("after.out"), NULL);
+    add_step(&document, "iqls", "out", temp_path("independent.out"), NULL);
+
+    pipeline_config_t config;
+    make_config(&config, true, 1);
+    config.continue_on_error = true;
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(!pipeline_execute(executor));
+
+    const pipeline_step_result_t *result = pipeline_get_step_result(executor, 0);
+    assert(result && !result->success && result->exit_code == 1);
+    result = pipeline_get_step_result(executor, 1);
+    assert(result && !result->success && strncmp(result->error_message, "Skipped", 7) == 0);
+    result = pipeline_get_step_result(executor, 2);
+    assert(result && result->success);
+    assert(executor->completed_steps == 1 && executor->failed_steps == 2);
+    pipeline_executor_destroy(executor);
+
+    // Stop on the first error: later steps never run
+    make_config(&config, false, 1);
+    executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(!pipeline_execute(executor));
+    assert(executor->completed_steps == 0 && executor->failed_steps == 1);
+    pipeline_executor_destroy(executor);
+
+    // A tool that does not exist fails with the shell's exit code
+    yaml_free_document(&document);
+    add_step(&document, "iqmissing", NULL);
+    executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(!pipeline_execute(executor));
+    assert(pipeline_get_step_result(executor, 0)->exit_code == 127);
+    pipeline_executor_destroy(executor);
+
+    printf("✅ Failure handling tests passed\n");
+}
+
+/**
+ * @brief Tools not known to be read-only order against every step
+ */
+static void test_barriers(void) {
+    printf("🧪 Testing ordering around unknown tools...\n");
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_step(&document, "iqls", "out", temp_path("x.out"), NULL);
+    add_step(&document, "iqcut", "out", temp_path("y.out"), NULL);
+    add_step(&document, "iqls", "out", temp_path("z.out"), NULL);
+    add_step(&document, "iqdetect", "out", temp_path("x.out"), NULL);
+
+    pipeline_config_t config;
+    make_config(&config, true, 4);
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+
+    bool must_succeed = true;
+    assert(pipeline_step_depends_on(executor, 1, 0, &must_succeed) && !must_succeed);
+    assert(pipeline_step_depends_on(executor, 2, 1, &must_succeed) && !must_succeed);
+    assert(!pipeline_step_depends_on(executor, 3, 2, NULL));
+    assert(pipeline_step_depends_on(executor, 3, 0, NULL));  // Same output path
+    assert(!pipeline_step_depends_on(executor, 0, 1, NULL));
+
+    assert(pipeline_execute(executor));
+    assert(executor->completed_steps == 4);
+    pipeline_executor_destroy(executor);
+
+    // Too many steps for the graph
+    static yaml_document_t large;
+    memset(&large, 0, sizeof(large));
+    large.pipeline_count = PIPELINE_MAX_STEPS + 1;
+    assert(pipeline_executor_create(&config, &large) == NULL);
+
+    printf("✅ Ordering tests passed\n");
+}
+
+/**
+ * @brief A step over the timeout is killed
+ */
+static void test_timeout(void) {
+    printf("🧪 Testing step timeout...\n");
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_step(&document, "iqls", "sleep", "5", NULL);
+
+    pipeline_config_t config;
+    make_config(&config, false, 1);
+    config.timeout_seconds = 0.2;
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+
+    double start = now_seconds();
+    assert(!pipeline_execute(executor));
+    assert(now_seconds() - start < 2.0);
+    const pipeline_step_result_t *result = pipeline_get_step_result(executor, 0);
+    assert(!result->success && strncmp(result->error_message, "Timed out", 9) == 0);
+    pipeline_executor_destroy(executor);
+
+    printf("✅ Timeout tests passed\n");
+}
+
+#define PROBE_SAMPLES 5000
+
+static int16_t probe_raw[PROBE_SAMPLES * 2];
+static uint32_t probe_calls;
+
+// Value of --in in a tool's arguments
+static const char *probe_input(int argc, char **argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--in") == 0) return argv[i + 1];
+    }
+    return NULL;
+}
+
+// Stand-in tool core: streams --in and checks it came from the shared source
+static int probe_stream(int argc, char **argv) {
+    probe_calls++;
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, probe_input(argc, argv)) || !reader.source) return 1;
+
+    // Floats in two reads, then native values after a seek back
+    static float samples[PROBE_SAMPLES * 2];
+    static int16_t native[PROBE_SAMPLES * 2];
+    size_t got = iq_read_samples(&reader, samples, 1234);
+    got += iq_read_samples(&reader, samples + got * 2, PROBE_SAMPLES);
+    bool ok = got == PROBE_SAMPLES && iq_read_samples(&reader, samples, 1) == 0;
+    for (size_t i = 0; ok && i < PROBE_SAMPLES * 2; i++) ok = samples[i] == probe_raw[i] / 32768.0f;
+
+    ok = ok && iq_reader_seek_sample(&reader, 0) &&
+         iq_read_native(&reader, native, PROBE_SAMPLES) == PROBE_SAMPLES &&
+         memcmp(native, probe_raw, sizeof(native)) == 0;
+    iq_reader_close(&reader);
+    return ok ? 0 : 2;
+}
+
+// Stand-in tool core: loads --in whole
+static int probe_load(int argc, char **argv) {
+    probe_calls++;
+    iq_data_t data;
+    if (!iq_load_file(probe_input(argc, argv), &data)) return 1;
+    bool ok = data.num_samples == PROBE_SAMPLES && data.format == IQ_FORMAT_S16 &&
+              data.data[2] == probe_raw[2] / 32768.0f;
+    iq_free(&data);
+    return ok ? 0 : 2;
+}
+
+/**
+ * @brief In-process steps read the input decoded once
+ */
+static void test_in_process(void) {
+    printf("🧪 Testing in-process execution over a shared source...\n");
+
+    const char *capture = temp_path("capture.iq");
+    uint32_t seed = 99;
+    for (size_t i = 0; i < PROBE_SAMPLES * 2; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        probe_raw[i] = (int16_t)(seed >> 16);
+    }
+    FILE *file = fopen(capture, "wb");
+    assert(file);
+    assert(fwrite(probe_raw, sizeof(probe_raw), 1, file) == 1);
+    fclose(file);
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_input(&document, "%s", capture);
+    add_input(&document, "%s", capture);  // Listed twice, decoded once
+    add_step(&document, "iqls", "in", capture, NULL);
+    add_step(&document, "iqdetect", "in", capture, NULL);
+    add_step(&document, "iqcut", "out", temp_path("spawned.out"), NULL);  // Not in process
+    add_step(&document, "iqls", "in", capture, NULL);
+
+    const pipeline_tool_t tools[2] = {{"iqls", probe_stream, 0}, {"iqdetect", probe_load, 0}};
+    pipeline_config_t config;
+    make_config(&config, true, 4);
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    probe_calls = 0;
+    assert(pipeline_execute_in_process(executor, tools, 2));
+    assert(probe_calls == 3);
+    assert(executor->completed_steps == 4 && executor->peak_running == 1);
+    assert(access(temp_path("spawned.out"), F_OK) == 0);
+    assert(iq_source_find(capture) == NULL);  // Withdrawn afterwards
+    pipeline_executor_destroy(executor);
+
+    // Without a source the same cores read the file (and fail the check)
+    assert(probe_stream(3, (char *[]){"iqls", "--in", (char *)capture, NULL}) == 1);
+
+    printf("✅ In-process tests passed\n");
+}
+
+static atomic_uint bound_calls;    // Fused cores that found their bus
+static atomic_uint unbound_calls;
+
+// Value of a numeric option, 0 if absent
+static uint32_t probe_count(int argc, char **argv, const char *flag) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], flag) == 0) return (uint32_t)strtoul(argv[i + 1], NULL, 10);
+    }
+    return 0;
+}
+
+// Stand-in spectral core: with a bound bus, every frame's row must arrive
+static int probe_spectral(int argc, char **argv, uint32_t format) {
+    uint32_t fft = probe_count(argc, argv, "--fft"), hop = probe_count(argc, argv, "--hop");
+    uint32_t subscriber;
+    spectral_bus_t *bus = spectral_bus_bound(probe_input(argc, argv), fft, hop, WINDOW_RECTANGULAR,
+                                             format, &subscriber);
+    if (!bus) {
+        atomic_fetch_add(&unbound_calls, 1);
+        return 0;
+    }
+    atomic_fetch_add(&bound_calls, 1);
+
+    static _Thread_local float f32[256];
+    static _Thread_local double f64[256];
+    uint32_t rows = 0;
+    while ((format == SPECTRAL_BUS_F32 ? spectral_bus_read_f32(bus, subscriber, f32, 1)
+                                       : spectral_bus_read_f64(bus, subscriber, f64, 1)) == 1) {
+        rows++;
+    }
+    return rows == (PROBE_SAMPLES - fft) / hop + 1 ? 0 : 2;
+}
+
+static int probe_spectral_f32(int argc, char **argv) { return probe_spectral(argc, argv, SPECTRAL_BUS_F32); }
+static int probe_spectral_f64(int argc, char **argv) { return probe_spectral(argc, argv, SPECTRAL_BUS_F64); }
+
+/**
+ * @brief Steps over the same STFT run together on one spectral bus
+ */
+static void test_fused_steps(void) {
+    printf("🧪 Testing fused spectral steps...\n");
+
+    const char *capture = temp_path("capture.iq");  // Written by test_in_process
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_input(&document, "%s", capture);
+    add_step(&document, "iqls", "in", capture, "fft", "64", "hop", "32", NULL);
+    add_step(&document, "iqdetect", "in", capture, "fft", "64", "hop", "32", "window", "rectangular", NULL);
+    add_step(&document, "iqls", "in", capture, "fft", "128", "hop", "32", NULL);   // Other geometry
+    add_step(&document, "iqls", "in", capture, "fft", "64", NULL);                 // Hop left to the tool
+    add_step(&document, "iqcut", "out", temp_path("fused.out"), NULL);             // Orders against all
+    add_step(&document, "iqdetect", "in", capture, "fft", "64", "hop", "32", NULL);
+
+    const pipeline_tool_t tools[2] = {{"iqls", probe_spectral_f32, SPECTRAL_BUS_F32},
+                                      {"iqdetect", probe_spectral_f64, SPECTRAL_BUS_F64}};
+    pipeline_config_t config;
+    make_config(&config, false, 1);
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(pipeline_execute_in_process(executor, tools, 2));
+    assert(executor->completed_steps == 6 && executor->peak_running == 2);
+    assert(atomic_load(&bound_calls) == 2 && atomic_load(&unbound_calls) == 3);
+    pipeline_executor_destroy(executor);
+
+    // Without the table entry's row formats nothing is fused
+    const pipeline_tool_t plain[2] = {{"iqls", probe_spectral_f32, 0}, {"iqdetect", probe_spectral_f64, 0}};
+    executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    atomic_store(&bound_calls, 0);
+    assert(pipeline_execute_in_process(executor, plain, 2));
+    assert(executor->peak_running == 1 && atomic_load(&bound_calls) == 0);
+    pipeline_executor_destroy(executor);
+
+    printf("✅ Fused step tests passed\n");
+}
+
+static void write_text(const char *path, const char *text) {
+    FILE *file = fopen(path, "w");
+    assert(file);
+    fputs(text, file);
+    fclose(file);
+}
+
+static bool file_says(const char *path, const char *text) {
+    char line[64] = "";
+    FILE *file = fopen(path, "r");
+    if (!file) return false;
+    bool ok = fgets(line, sizeof(line), file) != NULL && strcmp(line, text) == 0;
+    fclose(file);
+    return ok;
+}
+
+// Run the document with the step cache; outputs are removed first
+static pipeline_executor_t *run_cached(const yaml_document_t *document, const char *cache_dir,
+                                       const char **outputs, uint32_t output_count) {
+    for (uint32_t i = 0; i < output_count; i++) unlink(outputs[i]);
+    pipeline_config_t config;
+    make_config(&config, true, 2);
+    strcpy(config.cache_dir, cache_dir);
+    pipeline_executor_t *executor = pipeline_executor_create(&config, document);
+    assert(executor);
+    assert(pipeline_execute(executor));
+    for (uint32_t i = 0; i < output_count; i++) assert(file_says(outputs[i], "done\n"));
+    return executor;
+}
+
+/**
+ * @brief Unchanged steps are restored from the cache instead of run
+ */
+static void test_step_cache(void) {
+    printf("🧪 Testing the step cache...\n");
+
+    // Known SHA-256 vectors
+    char digest[STEP_CACHE_KEY_SIZE];
+    step_cache_sha256("abc", 3, digest);
+    assert(strcmp(digest, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad") == 0);
+    step_cache_sha256("", 0, digest);
+    assert(strcmp(digest, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855") == 0);
+    const char *two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    step_cache_sha256(two_blocks, strlen(two_blocks), digest);
+    assert(strcmp(digest, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1") == 0);
+
+    const char *cache_dir = temp_path("cache");
+    const char *source = temp_path("cache_src.txt");
+    const char *outputs[3] = {temp_path("cache_a.out"), temp_path("cache_b.out"), temp_path("cache_c.out")};
+    write_text(source, "first\n");
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_step(&document, "iqls", "in", source, "out", outputs[0], NULL);
+    add_step(&document, "iqdetect", "in", outputs[0], "out", outputs[1], NULL);
+    add_step(&document, "iqls", "sleep", "0", "out", outputs[2], NULL);
+
+    // First run stores every step
+    pipeline_executor_t *executor = run_cached(&document, cache_dir, outputs, 3);
+    assert(executor->cached_steps == 0 && executor->cache->stores == 3);
+    assert(strlen(executor->results[1].cache_key) == 64);
+    pipeline_executor_destroy(executor);
+
+    // Second run restores them all; nothing runs
+    executor = run_cached(&document, cache_dir, outputs, 3);
+    assert(executor->cached_steps == 3 && executor->completed_steps == 3);
+    for (uint32_t i = 0; i < 3; i++) {
+        assert(executor->results[i].cached);
+        assert(strcmp(executor->results[i].output_files, outputs[i]) == 0);
+    }
+    pipeline_executor_destroy(executor);
+
+    // A changed parameter reruns only its step
+    document.pipeline[2].params[0].value = "0.0";
+    executor = run_cached(&document, cache_dir, outputs, 3);
+    assert(executor->cached_steps == 2 && !executor->results[2].cached);
+    pipeline_executor_destroy(executor);
+
+    // Changed input contents rerun the reader; its output is the same as
+    // before, so the step reading that is still restored
+    write_text(source, "second\n");
+    executor = run_cached(&document, cache_dir, outputs, 3);
+    assert(!executor->results[0].cached && executor->results[1].cached && executor->results[2].cached);
+    pipeline_executor_destroy(executor);
+
+    // In process as well
+    pipeline_config_t config;
+    make_config(&config, false, 1);
+    strcpy(config.cache_dir, cache_dir);
+    executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(pipeline_execute_in_process(executor, NULL, 0));
+    assert(executor->cached_steps == 3);
+    pipeline_executor_destroy(executor);
+
+    // A recorded SigMF core:sha512 stands for the data file's contents
+    const char *data = temp_path("cache_rec.sigmf-data");
+    write_text(data, "samples\n");
+    sigmf_metadata_t meta;
+    sigmf_init_metadata(&meta);
+    strcpy(meta.global.sha512, "0123abcd");
+    assert(sigmf_write_metadata(temp_path("cache_rec.sigmf-meta"), &meta));
+    sigmf_free_metadata(&meta);
+
+    step_cache_t cache;
+    assert(step_cache_init(&cache, cache_dir));
+    yaml_param_t reads[1] = {{"in", data}};
+    yaml_pipeline_step_t step = {"iqls", "", reads, 1, 1};
+    char key[STEP_CACHE_KEY_SIZE], other[STEP_CACHE_KEY_SIZE];
+    assert(step_cache_key(&cache, &step, NULL, key));
+    assert(strcmp(cache.memo[0].digest, "sha512:0123abcd") == 0);
+
+    step_cache_t fresh;
+    assert(step_cache_init(&fresh, cache_dir));
+    write_text(data, "changed\n");  // Same recorded digest, same key
+    assert(step_cache_key(&fresh, &step, NULL, other) && strcmp(key, other) == 0);
+    assert(!step_cache_restore(&fresh, key, NULL, 0));  // Never stored
+
+    // Parameter order does not matter
+    yaml_param_t forward[2] = {{"fft", "64"}, {"hop", "32"}};
+    yaml_param_t backward[2] = {{"hop", "32"}, {"fft", "64"}};
+    step = (yaml_pipeline_step_t){"iqls", "", forward, 2, 2};
+    assert(step_cache_key(&fresh, &step, NULL, key));
+    step.params = backward;
+    assert(step_cache_key(&fresh, &step, NULL, other) && strcmp(key, other) == 0);
+    assert(step_cache_key(&fresh, &step, temp_path("iqls"), other) && strcmp(key, other) != 0);
+
+    printf("✅ Step cache tests passed\n");
+}
+
+/**
+ * @brief Steps report their own wall time and resource use
+ */
+static void test_step_usage(void) {
+    printf("🧪 Testing step timing and resource use...\n");
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_step(&document, "iqls", "sleep", "0.3", "out", temp_path("idle.out"), NULL);
+    add_step(&document, "iqdetect", "spin", "200000", "out", temp_path("busy.out"), NULL);
+
+    pipeline_config_t config;
+    make_config(&config, true, 2);
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(pipeline_execute(executor));
+
+    // Sleeping costs wall time, not CPU; counting costs CPU
+    const pipeline_step_result_t *idle = pipeline_get_step_result(executor, 0);
+    const pipeline_step_result_t *busy = pipeline_get_step_result(executor, 1);
+    double idle_cpu = idle->usage.user_seconds + idle->usage.system_seconds;
+    double busy_cpu = busy->usage.user_seconds + busy->usage.system_seconds;
+    printf("  idle: %.3f s wall, %.3f s CPU; busy: %.3f s wall, %.3f s CPU, %llu kB peak\n",
+           idle->execution_time, idle_cpu, busy->execution_time, busy_cpu,
+           (unsigned long long)busy->usage.max_rss_bytes / 1024);
+    assert(idle->execution_time >= 0.3 && idle_cpu < 0.15);
+    assert(busy->usage.user_seconds > 0.02 && busy_cpu <= busy->execution_time + 0.05);
+    assert(busy->usage.max_rss_bytes > 0);
+    assert(idle->start_offset >= 0.0 && busy->start_offset >= 0.0 && busy->start_offset < 0.2);
+    assert(executor->total_cpu_time >= busy_cpu);
+
+    // Saved with the other results
+    const char *saved = temp_path("results.csv");
+    assert(pipeline_save_results(executor, saved));
+    FILE *file = fopen(saved, "r");
+    assert(file);
+    char line[512];
+    bool header = false;
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "step_index,", 11) == 0) {
+            header = strstr(line, ",user_seconds,system_seconds,cpu_utilization,max_rss_bytes,") != NULL;
+        }
+    }
+    fclose(file);
+    assert(header);
+    pipeline_executor_destroy(executor);
+
+    printf("✅ Timing tests passed\n");
+}
+
+/**
+ * @brief A template pipeline runs once per input within the global budgets
+ */
+static void test_fanout(void) {
+    printf("🧪 Testing fan-out over many inputs...\n");
+
+    // Twelve captures and a pattern matching them
+    char input_dir[128], out_dir[128];
+    snprintf(input_dir, sizeof(input_dir), "%s/captures", tool_dir);
+    snprintf(out_dir, sizeof(out_dir), "%s/fanout", tool_dir);
+    assert(mkdir(input_dir, 0755) == 0 && mkdir(out_dir, 0755) == 0);
+    for (int i = 0; i < 12; i++) {
+        char path[160];
+        snprintf(path, sizeof(path), "%s/cap%02d.iq", input_dir, i);
+        FILE *file = fopen(path, "w");
+        assert(file);
+        fputs("iq", file);
+        fclose(file);
+    }
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    add_input(&document, "%s/cap*.iq", input_dir);
+    add_step(&document, "iqls", "in", "{input}", "sleep", "0.2", "out", "{out_dir}/{stem}.a", NULL);
+    add_step(&document, "iqdetect", "in", "{out_dir}/{stem}.a", "out", "{out_dir}/{stem}.b", NULL);
+    assert(pipeline_document_is_template(&document));
+    assert(yaml_expand_inputs(&document));
+    assert(document.input_count == 12);
+    assert(strstr(document.inputs[0].file, "cap00.iq") && strstr(document.inputs[11].file, "cap11.iq"));
+
+    // Three inputs at once, four steps over all of them
+    pipeline_config_t config;
+    make_config(&config, true, 4);
+    config.max_parallel_files = 3;
+    strcpy(config.working_dir, out_dir);
+    pipeline_fanout_t *fanout = pipeline_fanout_create(&config, &document);
+    assert(fanout && fanout->file_count == 12);
+    assert(strcmp(fanout->files[3].stem, "cap03") == 0);
+    double start = now_seconds();
+    assert(pipeline_fanout_execute(fanout));
+    double elapsed = now_seconds() - start;
+    printf("  12 inputs, 3 at once: %.3f s, peak %u inputs, %u steps\n",
+           elapsed, fanout->peak_files, fanout->peak_running);
+    assert(fanout->completed_files == 12 && fanout->failed_files == 0);
+    assert(fanout->peak_files == 3 && fanout->peak_running <= 4);
+    assert(elapsed > 0.75 && elapsed < 2.0);
+    for (uint32_t f = 0; f < 12; f++) {
+        char path[320];
+        snprintf(path, sizeof(path), "%s/%s.b", out_dir, fanout->files[f].stem);
+        assert(access(path, F_OK) == 0);
+        assert(fanout->files[f].result_count == 2 && fanout->files[f].results[1].success);
+    }
+
+    char summary[16384];
+    assert(pipeline_fanout_generate_summary(fanout, summary, sizeof(summary)));
+    assert(strstr(summary, "Completed: 12") && strstr(summary, "cap11.iq"));
+    const char *saved = temp_path("fanout.csv");
+    assert(pipeline_fanout_save_results(fanout, saved));
+    FILE *file = fopen(saved, "r");
+    assert(file);
+    char line[512];
+    uint32_t rows = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '"') rows++;
+    }
+    fclose(file);
+    assert(rows == 24);
+    pipeline_fanout_destroy(fanout);
+
+    // A one-byte memory budget: once measured, no two steps fit together
+    yaml_free_document(&document);
+    for (int i = 0; i < 4; i++) {
+        add_input(&document, "%s/cap%02d.iq", input_dir, i);
+    }
+    add_step(&document, "iqls", "in", "{input}", "spin", "20000", "out", "{out_dir}/{stem}.m", NULL);
+    make_config(&config, true, 4);
+    config.max_parallel_files = 4;
+    config.memory_budget_bytes = 1;
+    strcpy(config.working_dir, out_dir);
+    fanout = pipeline_fanout_create(&config, &document);
+    assert(fanout);
+    assert(pipeline_fanout_execute(fanout));
+    assert(fanout->completed_files == 4 && fanout->peak_running == 1);
+    assert(fanout->step_rss[0] > 0);
+    pipeline_fanout_destroy(fanout);
+
+    // Without a budget the same inputs run together
+    config.memory_budget_bytes = 0;
+    fanout = pipeline_fanout_create(&config, &document);
+    assert(fanout && pipeline_fanout_execute(fanout));
+    assert(fanout->peak_running > 1);
+    pipeline_fanout_destroy(fanout);
+
+    // A failed input stops the inputs after it unless continuing
+    yaml_free_document(&document);
+    for (int i = 0; i < 3; i++) {
+        add_input(&document, "%s/cap%02d.iq", input_dir, i);
+    }
+    document.inputs[1].file = yaml_copy_string(&document, temp_path("missing.iq"));
+    add_step(&document, "iqls", "in", "{input}", "out", "{out_dir}/{stem}.f", NULL);
+    make_config(&config, false, 1);
+    strcpy(config.working_dir, out_dir);
+    fanout = pipeline_fanout_create(&config, &document);
+    assert(fanout);
+    assert(!pipeline_fanout_execute(fanout));
+    assert(fanout->completed_files == 1 && fanout->failed_files == 2 && !fanout->files[2].started);
+    pipeline_fanout_destroy(fanout);
+    config.continue_on_error = true;
+    fanout = pipeline_fanout_create(&config, &document);
+    assert(fanout);
+    assert(!pipeline_fanout_execute(fanout));
+    assert(fanout->completed_files == 2 && fanout->failed_files == 1 && fanout->files[2].success);
+    pipeline_fanout_destroy(fanout);
+
+    // Inputs over the old 32-entry limit
+    yaml_free_document(&document);
+    for (int i = 0; i < 40; i++) {
+        add_input(&document, "%s/extra%02d.iq", input_dir, i);
+    }
+    add_step(&document, "iqls", "in", "{input}", "out", "{out_dir}/{stem}.x", NULL);
+    assert(document.input_count == 40 && document.input_capacity >= 40);
+    fanout = pipeline_fanout_create(&config, &document);
+    assert(fanout && fanout->file_count == 40);
+    assert(strcmp(fanout->files[39].stem, "extra39") == 0);
+    pipeline_fanout_destroy(fanout);
+
+    // Outputs every input would share, colliding stems, and empty patterns
+    document.pipeline[0].params[1].value = yaml_copy_string(&document, temp_path("shared.out"));
+    assert(pipeline_fanout_create(&config, &document) == NULL);
+    document.pipeline[0].params[1].value = "{out_dir}/{stem}.x";
+    add_input(&document, "%s/other/extra00.iq", tool_dir);
+    assert(pipeline_fanout_create(&config, &document) == NULL);
+    yaml_free_document(&document);
+    add_input(&document, "%s/none*.iq", input_dir);
+    assert(!yaml_expand_inputs(&document));
+    yaml_free_document(&document);
+
+    printf("✅ Fan-out tests passed\n");
+}
+
+/**
+ * @brief A launcher runs each step through its template, inputs spread over the nodes
+ */
+static void test_launcher(void) {
+    printf("🧪 Testing step launcher and nodes...\n");
+
+    char out_dir[128];
+    snprintf(out_dir, sizeof(out_dir), "%s/launched", tool_dir);
+    assert(mkdir(out_dir, 0755) == 0);
+
+    static yaml_document_t document;
+    yaml_free_document(&document);
+    for (int i = 0; i < 4; i++) {
+        add_input(&document, "%s/captures/cap%02d.iq", tool_dir, i);
+    }
+    // A value with a quote and a space must reach the tool as one argument
+    add_step(&document, "iqls", "in", "{input}", "note", "it's here", "out", "{out_dir}/{stem}.l",
+             "pyramid", "true", NULL);
+
+    // Each launch records its node before running the command
+    pipeline_config_t config;
+    make_config(&config, true, 2);
+    config.max_parallel_files = 2;
+    strcpy(config.working_dir, out_dir);
+    snprintf(config.launcher, sizeof(config.launcher), "echo {node} >> %s/nodes.txt && {command}", out_dir);
+    strcpy(config.nodes[0], "alpha");
+    strcpy(config.nodes[1], "beta");
+    config.node_count = 2;
+
+    pipeline_fanout_t *fanout = pipeline_fanout_create(&config, &document);
+    assert(fanout);
+    assert(pipeline_fanout_execute(fanout));
+    assert(fanout->completed_files == 4);
+    for (uint32_t f = 0; f < 4; f++) {
+        char path[320];
+        snprintf(path, sizeof(path), "%s/%s.l", out_dir, fanout->files[f].stem);
+        assert(access(path, F_OK) == 0);
+    }
+    pipeline_fanout_destroy(fanout);
+
+    char path[192];
+    snprintf(path, sizeof(path), "%s/nodes.txt", out_dir);
+    FILE *file = fopen(path, "r");
+    assert(file);
+    char line[64];
+    uint32_t alpha = 0, beta = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (strcmp(line, "alpha\n") == 0) alpha++;
+        if (strcmp(line, "beta\n") == 0) beta++;
+    }
+    fclose(file);
+    assert(alpha == 2 && beta == 2);
+
+    // A "true" parameter is a bare flag
+    pipeline_executor_t *executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    char command[1024];
+    assert(pipeline_build_command(executor, 0, command, sizeof(command)));
+    assert(strstr(command, " --pyramid") && !strstr(command, "--pyramid true"));
+    pipeline_executor_destroy(executor);
+    yaml_free_document(&document);
+
+    // Nested template: a stand-in ssh joins its arguments for a "remote"
+    // shell, which must see {cwd} and {command} as quoted words even with a
+    // space and a ';' in them
+    snprintf(path, sizeof(path), "%s/ssh", tool_dir);
+    write_text(path, "#!/bin/sh\nshift\nexec /bin/sh -c \"$*\"\n");
+    assert(chmod(path, 0755) == 0);
+    char work_dir[128], marker[128], saved_cwd[512];
+    snprintf(work_dir, sizeof(work_dir), "%s/work d;ir", tool_dir);
+    snprintf(marker, sizeof(marker), "%s/marker", tool_dir);
+    assert(mkdir(work_dir, 0755) == 0);
+    assert(getcwd(saved_cwd, sizeof(saved_cwd)));
+    assert(chdir(work_dir) == 0);
+
+    char note[256];
+    snprintf(note, sizeof(note), "x;touch %s", marker);
+    add_step(&document, "iqls", "note", note, "out", "nested.out", NULL);
+    make_config(&config, false, 1);
+    snprintf(config.launcher, sizeof(config.launcher), "%s/ssh {node} 'cd {cwd} && {command}'", tool_dir);
+    strcpy(config.node, "alpha");
+    executor = pipeline_executor_create(&config, &document);
+    assert(executor);
+    assert(pipeline_execute(executor));
+    pipeline_executor_destroy(executor);
+    yaml_free_document(&document);
+    assert(chdir(saved_cwd) == 0);
+
+    snprintf(path, sizeof(path), "%s/nested.out", work_dir);
+    assert(access(path, F_OK) == 0);
+    assert(access(marker, F_OK) != 0);
+
+    printf("✅ Launcher tests passed\n");
+}
+
+int main(void) {
+    printf("🚀 Starting Pipeline Executor Unit Tests\n");
+    printf("=========================================\n\n");
+
+    strcpy(tool_dir, "/tmp/iqlab_pipeline_XXXXXX");
+    assert(mkdtemp(tool_dir) != NULL);
+    install_tool("iqls");
+    install_tool("iqdetect");
+    install_tool("iqcut");
+
+    test_parallel_steps();
+    test_data_dependency();
+    test_failures();
+    test_barriers();
+    test_timeout();
+    test_in_process();
+    test_fused_steps();
+    test_step_cache();
+    test_step_usage();
+    test_fanout();
+    test_launcher();
+
+    char command[128];
+    snprintf(command, sizeof(command), "rm -rf %s", tool_dir);
+    if (system(command) != 0) printf("  (could not remove %s)\n", tool_dir);
+
+    printf("\n=========================================\n");
+    printf("🎉 All pipeline executor tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,492 @@
+/*
+ * IQ Lab - Streaming PNG Unit Tests
+ *
+ * Tests for the row-streaming and the parallel band PNG writers
+ * Files are parsed back chunk by chunk (CRCs checked), the deflate stream
+ * is inflated with a small fixed-Huffman/stored-block decoder and the PNG
+ * filters are undone; the pixels must match what was written, and the band
+ * writer must produce the same bytes for any thread count
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../src/viz/img_png.h"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+static const char *TEST_PATH = "test_png_stream.png";
+
+static uint32_t be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t crc32_bytes(uint32_t crc, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+    return crc;
+}
+
+// Bit reader over the concatenated IDAT payload
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    uint32_t bit;
+} bits_t;
+
+static int get_bit(bits_t *b) {
+    if (b->pos >= b->len) return -1;
+    int v = (b->data[b->pos] >> b->bit) & 1;
+    if (++b->bit == 8) { b->bit = 0; b->pos++; }
+    return v;
+}
+
+static int get_bits(bits_t *b, uint32_t n) {
+    int v = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        int bit = get_bit(b);
+        if (bit < 0) return -1;
+        v |= bit << i;
+    }
+    return v;
+}
+
+// Fixed literal/length symbol, read MSB first
+static int get_symbol(bits_t *b) {
+    int code = 0;
+    for (int len = 1; len <= 9; len++) {
+        int bit = get_bit(b);
+        if (bit < 0) return -1;
+        code = (code << 1) | bit;
+        if (len == 7 && code <= 0x17) return 256 + code;
+        if (len == 8 && code >= 0x30 && code <= 0xBF) return code - 0x30;
+        if (len == 8 && code >= 0xC0 && code <= 0xC7) return 280 + code - 0xC0;
+        if (len == 9 && code >= 0x190) return 144 + code - 0x190;
+    }
+    return -1;
+}
+
+// Inflate a zlib stream made of fixed-Huffman and stored blocks; NULL on any error
+static uint8_t *inflate_fixed(const uint8_t *data, size_t len, size_t *out_len) {
+    static const uint16_t len_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                          35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const uint8_t len_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                          3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const uint16_t dist_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                           257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                           8193, 12289, 16385, 24577};
+    static const uint8_t dist_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                           7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    if (len < 6 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[0] & 0x0F) != 8) return NULL;
+
+    size_t cap = 1024, n = 0;
+    uint8_t *out = malloc(cap);
+    bits_t b = {data + 2, len - 6, 0, 0};
+    int final = 0;
+    while (out && !final) {
+        final = get_bit(&b);
+        int type = get_bits(&b, 2);
+        if (final < 0 || (type != 0 && type != 1)) { free(out); return NULL; }
+        if (type == 0) {
+            // Stored: byte-aligned LEN, NLEN, then LEN raw bytes
+            if (b.bit) { b.bit = 0; b.pos++; }
+            if (b.pos + 4 > b.len) { free(out); return NULL; }
+            size_t stored = (size_t)b.data[b.pos] | ((size_t)b.data[b.pos + 1] << 8);
+            size_t nstored = (size_t)b.data[b.pos + 2] | ((size_t)b.data[b.pos + 3] << 8);
+            b.pos += 4;
+            if ((stored ^ 0xFFFF) != nstored || b.pos + stored > b.len) { free(out); return NULL; }
+            if (n + stored > cap) {
+                while (n + stored > cap) cap *= 2;
+                uint8_t *grown = realloc(out, cap);
+                if (!grown) { free(out); return NULL; }
+                out = grown;
+            }
+            memcpy(out + n, b.data + b.pos, stored);
+            n += stored;
+            b.pos += stored;
+            continue;
+        }
+        for (;;) {
+            int sym = get_symbol(&b);
+            if (sym < 0 || sym > 285) { free(out); return NULL; }
+            if (sym == 256) break;
+            size_t copy = 1, dist = 0;
+            if (sym > 256) {
+                int extra = get_bits(&b, len_extra[sym - 257]);
+                int code = 0;
+                for (int i = 0; i < 5; i++) code = (code << 1) | get_bit(&b);
+                if (extra < 0 || code < 0 || code > 29) { free(out); return NULL; }
+                int dextra = get_bits(&b, dist_extra[code]);
+                if (dextra < 0) { free(out); return NULL; }
+                copy = len_base[sym - 257] + (size_t)extra;
+                dist = dist_base[code] + (size_t)dextra;
+                if (dist > n || dist > 32768) { free(out); return NULL; }
+            }
+            if (n + copy > cap) {
+                while (n + copy > cap) cap *= 2;
+                uint8_t *grown = realloc(out, cap);
+                if (!grown) { free(out); return NULL; }
+                out = grown;
+            }
+            if (sym < 256) out[n++] = (uint8_t)sym;
+            else for (size_t i = 0; i < copy; i++, n++) out[n] = out[n - dist];
+        }
+    }
+    if (!out) return NULL;
+
+    // Adler-32 follows the byte-aligned end of the deflate data
+    size_t adler_pos = 2 + b.pos + (b.bit ? 1 : 0);
+    uint32_t a = 1, s = 0;
+    for (size_t i = 0; i < n; i++) { a = (a + out[i]) % 65521u; s = (s + a) % 65521u; }
+    if (adler_pos + 4 != len || be32(data + adler_pos) != ((s << 16) | a)) { free(out); return NULL; }
+
+    *out_len = n;
+    return out;
+}
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    int p = (int)a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Parse and decode TEST_PATH; compare with 'expected' (height rows of width RGB)
+static bool decode_matches(uint32_t width, uint32_t height, const uint8_t *expected) {
+    FILE *f = fopen(TEST_PATH, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *file = malloc((size_t)size);
+    bool ok = file && fread(file, 1, (size_t)size, f) == (size_t)size;
+    fclose(f);
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    ok = ok && size > 8 && memcmp(file, signature, 8) == 0;
+
+    uint8_t *idat = malloc((size_t)size);
+    size_t idat_len = 0;
+    bool seen_ihdr = false, seen_iend = false;
+    for (size_t pos = 8; ok && pos + 12 <= (size_t)size; ) {
+        uint32_t len = be32(file + pos);
+        if (pos + 12 + len > (size_t)size) { ok = false; break; }
+        const uint8_t *type = file + pos + 4;
+        uint32_t crc = crc32_bytes(0xFFFFFFFFu, type, 4 + (size_t)len) ^ 0xFFFFFFFFu;
+        if (crc != be32(file + pos + 8 + len)) { ok = false; break; }
+        if (memcmp(type, "IHDR", 4) == 0) {
+            const uint8_t *h = type + 4;
+            seen_ihdr = len == 13 && be32(h) == width && be32(h + 4) == height && h[8] == 8 && h[9] == 2;
+        } else if (memcmp(type, "IDAT", 4) == 0 && idat) {
+            memcpy(idat + idat_len, type + 4, len);
+            idat_len += len;
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            seen_iend = pos + 12 == (size_t)size;
+        }
+        pos += 12 + len;
+    }
+    ok = ok && idat && seen_ihdr && seen_iend;
+
+    size_t raw_len = 0;
+    uint8_t *raw = ok ? inflate_fixed(idat, idat_len, &raw_len) : NULL;
+    size_t stride = (size_t)width * 3;
+    ok = ok && raw && raw_len == height * (stride + 1);
+
+    // Undo the per-row filters
+    uint8_t *prev = calloc(stride, 1);
+    for (uint32_t y = 0; ok && prev && y < height; y++) {
+        uint8_t filter = raw[y * (stride + 1)];
+        uint8_t *line = raw + y * (stride + 1) + 1;
+        for (size_t i = 0; i < stride; i++) {
+            uint8_t a = i >= 3 ? line[i - 3] : 0, b = prev[i], c = i >= 3 ? prev[i - 3] : 0;
+            switch (filter) {
+                case 0: break;
+                case 1: line[i] = (uint8_t)(line[i] + a); break;
+                case 2: line[i] = (uint8_t)(line[i] + b); break;
+                case 3: line[i] = (uint8_t)(line[i] + (((unsigned)a + b) >> 1)); break;
+                case 4: line[i] = (uint8_t)(line[i] + paeth(a, b, c)); break;
+                default: ok = false; break;
+            }
+        }
+        if (ok && memcmp(line, expected + y * stride, stride) != 0) ok = false;
+        memcpy(prev, line, stride);
+    }
+
+    free(prev); free(raw); free(idat); free(file);
+    return ok;
+}
+
+// Test image: noise (pattern 0) or mostly smooth gradients (pattern 1)
+static uint8_t *make_pixels(uint32_t width, uint32_t height, int pattern) {
+    size_t stride = (size_t)width * 3;
+    uint8_t *pixels = malloc(stride * height);
+    if (!pixels) return NULL;
+
+    uint32_t state = 2463534242u;
+    for (uint32_t y = 0; y < height; y++) {
+        for (size_t i = 0; i < stride; i++) {
+            state = state * 1664525u + 1013904223u;
+            uint8_t v;
+            if (pattern == 0) v = (uint8_t)(state >> 24);                       // Noise
+            else if (y % 5 == 2) v = (uint8_t)(state >> 24);                    // Mostly smooth
+            else v = (uint8_t)((i / 3 + y) * (i % 3 + 1));
+            pixels[y * stride + i] = v;
+        }
+    }
+    return pixels;
+}
+
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = len > 0 ? malloc((size_t)len) : NULL;
+    if (data && fread(data, 1, (size_t)len, f) != (size_t)len) { free(data); data = NULL; }
+    fclose(f);
+    *size = (size_t)len;
+    return data;
+}
+
+// Stream an image and decode it again
+static bool round_trip_level(uint32_t width, uint32_t height, int pattern, png_level_t level) {
+    size_t stride = (size_t)width * 3;
+    uint8_t *pixels = make_pixels(width, height, pattern);
+    if (!pixels) return false;
+
+    png_stream_t png;
+    bool ok = png_stream_open(&png, TEST_PATH, width, height);
+    if (ok) png_stream_set_level(&png, level);
+    for (uint32_t y = 0; ok && y < height; y++) {
+        if (!png_stream_write_row(&png, pixels + y * stride)) ok = false;
+    }
+    ok = png_stream_close(&png) && ok;
+    ok = ok && decode_matches(width, height, pixels);
+
+    remove(TEST_PATH);
+    free(pixels);
+    return ok;
+}
+
+static bool round_trip(uint32_t width, uint32_t height, int pattern) {
+    return round_trip_level(width, height, pattern, PNG_LEVEL_DEFAULT);
+}
+
+/*
+ * Write an image with the band writer for several thread counts; every
+ * file must decode to the pixels and be byte-identical to the first
+ */
+static bool band_round_trip(uint32_t width, uint32_t height, int pattern,
+                            png_level_t level, uint32_t band_rows) {
+    png_image_t img;
+    uint8_t *pixels = make_pixels(width, height, pattern);
+    if (!pixels || !png_image_init(&img, width, height)) { free(pixels); return false; }
+    memcpy(img.data, pixels, img.data_size);
+
+    const uint32_t threads[] = { 1, 3, 8, 0 };
+    uint8_t *reference = NULL;
+    size_t reference_size = 0;
+    bool ok = true;
+    for (size_t t = 0; ok && t < sizeof(threads) / sizeof(threads[0]); t++) {
+        png_write_options_t opts;
+        png_write_options_default(&opts);
+        opts.num_threads = threads[t];
+        opts.level = level;
+        opts.band_rows = band_rows;
+        ok = png_image_write_ex(&img, TEST_PATH, &opts) && decode_matches(width, height, pixels);
+
+        size_t size = 0;
+        uint8_t *file = ok ? read_file(TEST_PATH, &size) : NULL;
+        if (!file) { ok = false; break; }
+        if (!reference) {
+            reference = file;
+            reference_size = size;
+        } else {
+            ok = size == reference_size && memcmp(file, reference, size) == 0;
+            free(file);
+        }
+    }
+
+    remove(TEST_PATH);
+    free(reference);
+    free(pixels);
+    png_image_free(&img);
+    return ok;
+}
+
+// Small and odd sizes
+void test_png_stream_small() {
+    TEST_START("Streamed PNG Round Trip (small)");
+
+    bool ok = round_trip(1, 1, 1) && round_trip(5, 3, 1) && round_trip(7, 9, 0) &&
+              round_trip(333, 120, 1);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Pixels, chunk CRCs and Adler-32 verified\n");
+    } else {
+        TEST_FAIL("Decoded image differs from the rows written");
+    }
+
+    TEST_END();
+}
+
+// Rows wider than the deflate window and several IDAT chunks
+void test_png_stream_wide() {
+    TEST_START("Streamed PNG Round Trip (wide rows)");
+
+    bool ok = round_trip(20000, 12, 1) && round_trip(70000, 3, 0);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Window slides and multi-chunk IDAT decode correctly\n");
+    } else {
+        TEST_FAIL("Wide image did not round-trip");
+    }
+
+    TEST_END();
+}
+
+// Compression levels on the streaming writer
+void test_png_stream_levels() {
+    TEST_START("Streamed PNG Levels");
+
+    bool ok = round_trip_level(333, 120, 1, PNG_LEVEL_FAST) && round_trip_level(333, 120, 1, PNG_LEVEL_BEST) &&
+              round_trip_level(70000, 3, 0, PNG_LEVEL_FAST);
+
+    png_level_t level;
+    ok = ok && png_level_from_name("fast", &level) && level == PNG_LEVEL_FAST &&
+         png_level_from_name("best", &level) && level == PNG_LEVEL_BEST &&
+         !png_level_from_name("max", &level);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Fast and best levels decode to the same pixels\n");
+    } else {
+        TEST_FAIL("Level round trip failed");
+    }
+
+    TEST_END();
+}
+
+// Band writer: many bands, one band, every level, any thread count
+void test_png_bands() {
+    TEST_START("Parallel Band PNG Writer");
+
+    bool ok = band_round_trip(1, 1, 1, PNG_LEVEL_DEFAULT, 0) &&
+              band_round_trip(7, 9, 0, PNG_LEVEL_DEFAULT, 1) &&
+              band_round_trip(333, 120, 1, PNG_LEVEL_DEFAULT, 7) &&
+              band_round_trip(333, 120, 1, PNG_LEVEL_FAST, 16) &&
+              band_round_trip(333, 120, 1, PNG_LEVEL_BEST, 50) &&
+              band_round_trip(20000, 40, 1, PNG_LEVEL_DEFAULT, 0) &&   // ~17 rows per automatic band
+              band_round_trip(1000, 700, 0, PNG_LEVEL_FAST, 0);
+
+    // One band compresses like the sequential encoder, give or take framing
+    png_image_t img;
+    uint8_t *pixels = make_pixels(200, 50, 1);
+    size_t band_size = 0, stream_size = 0;
+    if (pixels && png_image_init(&img, 200, 50)) {
+        memcpy(img.data, pixels, img.data_size);
+        ok = ok && png_image_write(&img, TEST_PATH);
+        free(read_file(TEST_PATH, &band_size));
+        png_stream_t png;
+        ok = ok && png_stream_open(&png, TEST_PATH, 200, 50);
+        for (uint32_t y = 0; ok && y < 50; y++) ok = png_stream_write_row(&png, pixels + y * 600);
+        ok = png_stream_close(&png) && ok;
+        free(read_file(TEST_PATH, &stream_size));
+        ok = ok && band_size > 0 && band_size <= stream_size + 32;   // Stored block and tail chunk
+        png_image_free(&img);
+    } else {
+        ok = false;
+    }
+    free(pixels);
+    remove(TEST_PATH);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Bands stitch into one valid stream, identical for 1/3/8/all threads\n");
+    } else {
+        TEST_FAIL("Band writer output invalid or thread dependent");
+    }
+
+    TEST_END();
+}
+
+// Error conditions
+void test_png_stream_errors() {
+    TEST_START("Error Conditions");
+
+    bool ok = true;
+    png_stream_t png;
+    uint8_t row[6] = {0};
+    if (png_stream_open(&png, TEST_PATH, 0, 1)) ok = false;
+    if (png_stream_open(&png, TEST_PATH, 1, 0)) ok = false;
+    png_image_t empty = {0};
+    if (png_image_write(&empty, TEST_PATH)) ok = false;
+    if (png_image_write_ex(NULL, TEST_PATH, NULL)) ok = false;
+
+    // Too many rows, then too few
+    if (!png_stream_open(&png, TEST_PATH, 2, 1)) {
+        ok = false;
+    } else {
+        if (!png_stream_write_row(&png, row)) ok = false;
+        if (png_stream_write_row(&png, row)) ok = false;
+        if (!png_stream_close(&png)) ok = false;
+    }
+    if (!png_stream_open(&png, TEST_PATH, 2, 3)) {
+        ok = false;
+    } else {
+        png_stream_write_row(&png, row);
+        if (png_stream_close(&png)) ok = false;
+    }
+    remove(TEST_PATH);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Bad sizes and row counts rejected\n");
+    } else {
+        TEST_FAIL("Error conditions not handled");
+    }
+
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Streaming PNG Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_png_stream_small();
+    test_png_stream_wide();
+    test_png_stream_levels();
+    test_png_bands();
+    test_png_stream_errors();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
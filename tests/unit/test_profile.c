@@ -0,0 +1,242 @@
+/*
+ * IQ Lab - Profiling Counter Unit Tests
+ *
+ * Tests for the per-stage hot-path counters behind --profile
+ * Covers the disabled path recording nothing, per-thread counters merged
+ * across several threads, the "--profile[=<file>]" argument, the JSON
+ * report, and the Chrome trace with per-thread tracks and named spans
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../../src/iq_core/profile.h"
+
+#define TEST_FILE "test_profile.json"
+#define TEST_TRACE "test_profile_trace.json"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { NUM_THREADS = 4, THREAD_CALLS = 10000 };
+
+// Nothing is recorded and the clock is not read while profiling is off
+void test_profile_disabled() {
+    TEST_START("Disabled Counters");
+
+    bool ok = !iq_profile_enabled();
+    for (int i = 0; i < 1000; i++) {
+        uint64_t start = iq_profile_begin();
+        if (start != 0) ok = false;
+        iq_profile_end(IQ_PROFILE_FFT, start, 4096, 32768);
+    }
+    for (int s = 0; s < IQ_PROFILE_STAGE_COUNT; s++) {
+        iq_profile_totals_t totals;
+        iq_profile_get((iq_profile_stage_t)s, &totals);
+        if (totals.calls != 0 || totals.ns != 0 || totals.threads != 0) ok = false;
+    }
+
+    // Other arguments are left to the tool
+    if (iq_profile_parse_arg("test_profile", "--profiles") ||
+        iq_profile_parse_arg("test_profile", "--in")) ok = false;
+    if (iq_profile_enabled()) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ 1000 disabled begin/end pairs left every stage empty\n");
+    } else {
+        TEST_FAIL("Counters recorded while profiling was off");
+    }
+    TEST_END();
+}
+
+static void *record_thread(void *arg) {
+    (void)arg;
+    for (int i = 0; i < THREAD_CALLS; i++) {
+        uint64_t start = iq_profile_begin();
+        iq_profile_end(IQ_PROFILE_DEMOD, start, 8, 64);
+    }
+    return NULL;
+}
+
+// Each thread's counters are merged into one total per stage
+void test_profile_threads() {
+    TEST_START("Multi-Thread Merge");
+
+    bool ok = iq_profile_parse_arg("test_profile", "--profile") && iq_profile_enabled();
+
+    // The main thread records a stage of its own
+    uint64_t start = iq_profile_begin();
+    if (start == 0) ok = false;
+    iq_profile_end(IQ_PROFILE_READ, start, 100, 400);
+
+    pthread_t threads[NUM_THREADS];
+    int started = 0;
+    for (; started < NUM_THREADS; started++) {
+        if (pthread_create(&threads[started], NULL, record_thread, NULL) != 0) {
+            ok = false;
+            break;
+        }
+    }
+    for (int t = 0; t < started; t++) pthread_join(threads[t], NULL);
+
+    iq_profile_totals_t demod, read, fft;
+    iq_profile_get(IQ_PROFILE_DEMOD, &demod);
+    iq_profile_get(IQ_PROFILE_READ, &read);
+    iq_profile_get(IQ_PROFILE_FFT, &fft);
+    if (demod.calls != (uint64_t)started * THREAD_CALLS ||
+        demod.items != (uint64_t)started * THREAD_CALLS * 8 ||
+        demod.bytes != (uint64_t)started * THREAD_CALLS * 64 ||
+        demod.threads != (uint32_t)started) ok = false;
+    if (read.calls != 1 || read.items != 100 || read.bytes != 400 || read.threads != 1) ok = false;
+    if (fft.calls != 0) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %llu calls from %u threads merged, stages kept apart\n",
+               (unsigned long long)demod.calls, demod.threads);
+    } else {
+        TEST_FAIL("Merged totals do not match the recorded calls");
+    }
+    TEST_END();
+}
+
+// The JSON report lists the recorded stages only
+void test_profile_json() {
+    TEST_START("JSON Report");
+
+    // A second start (another tool run in the same process) keeps the first name
+    bool ok = iq_profile_start("other_tool", NULL);
+    ok = iq_profile_write_json(TEST_FILE) && ok;
+    char text[4096] = {0};
+    FILE *f = fopen(TEST_FILE, "r");
+    if (f) {
+        size_t length = fread(text, 1, sizeof(text) - 1, f);
+        text[length] = '\0';
+        fclose(f);
+    } else {
+        ok = false;
+    }
+    remove(TEST_FILE);
+
+    if (!strstr(text, "\"tool\": \"test_profile\"")) ok = false;
+    if (!strstr(text, "{\"stage\": \"read\", \"calls\": 1,")) ok = false;
+    if (!strstr(text, "\"stage\": \"demod\"")) ok = false;
+    if (strstr(text, "\"stage\": \"fft\"")) ok = false;
+
+    char expected[64];
+    snprintf(expected, sizeof(expected), "\"calls\": %llu", (unsigned long long)NUM_THREADS * THREAD_CALLS);
+    if (!strstr(text, expected)) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Report names the tool and holds read and demod, not fft\n");
+    } else {
+        TEST_FAIL("JSON report is missing or wrong");
+        printf("%s\n", text);
+    }
+    TEST_END();
+}
+
+static void *trace_thread(void *arg) {
+    (void)arg;
+    iq_trace_thread_name("worker \"x\"");
+    uint64_t start = iq_profile_begin();
+    iq_profile_end(IQ_PROFILE_WAIT, start, 0, 0);
+    return NULL;
+}
+
+// The trace names every thread, holds its events and the named spans
+void test_profile_trace() {
+    TEST_START("Chrome Trace");
+
+    bool ok = !iq_trace_start("test_profile", NULL);    // A trace needs a file
+    ok = iq_profile_parse_arg("test_profile", "--trace=" TEST_TRACE) && ok;
+
+    uint64_t start = iq_profile_begin();
+    iq_profile_end(IQ_PROFILE_FFT, start, 1024, 0);
+    iq_trace_span("iqls", "step 0", start, iq_profile_now());
+    iq_trace_span("iqdetect", "step 1", start, iq_profile_now());
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, trace_thread, NULL) == 0) {
+        pthread_join(thread, NULL);
+    } else {
+        ok = false;
+    }
+
+    // A copy: the trace itself is written again at exit
+    ok = iq_trace_write_json(TEST_FILE) && ok;
+    static char text[1 << 20];
+    FILE *f = fopen(TEST_FILE, "r");
+    size_t length = 0;
+    if (f) {
+        length = fread(text, 1, sizeof(text) - 1, f);
+        fclose(f);
+    } else {
+        ok = false;
+    }
+    text[length] = '\0';
+    remove(TEST_FILE);
+
+    if (!strstr(text, "\"traceEvents\": [")) ok = false;
+    if (!strstr(text, "\"args\": {\"name\": \"main\"}")) ok = false;
+    if (!strstr(text, "\"args\": {\"name\": \"worker \\\"x\\\"\"}")) ok = false;
+    if (!strstr(text, "\"args\": {\"name\": \"step 1\"}")) ok = false;
+    if (!strstr(text, "\"cat\": \"stage\", \"name\": \"fft\"")) ok = false;
+    if (!strstr(text, "\"cat\": \"stage\", \"name\": \"wait\"")) ok = false;
+    if (!strstr(text, "\"cat\": \"span\", \"name\": \"iqdetect\"")) ok = false;
+    if (!strstr(text, "\"dropped_events\": 0")) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Thread and step tracks named, stage events and spans present\n");
+    } else {
+        TEST_FAIL("Trace is missing events or names");
+        printf("%s\n", text);
+    }
+    TEST_END();
+}
+
+// Registered before the trace starts, so it runs after the exit report
+static void remove_trace(void) {
+    remove(TEST_TRACE);
+}
+
+int main(void) {
+    atexit(remove_trace);
+
+    printf("=====================================\n");
+    printf("IQ Lab - Profiling Counter Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_profile_disabled();
+    test_profile_threads();
+    test_profile_json();
+    test_profile_trace();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    // The table printed at exit follows
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,289 @@
+/*
+ * IQ Lab - PSD Accumulator Unit Tests
+ *
+ * Tests for the streaming PSD estimator (psd.h): linear, log, EMA and
+ * max-hold readouts against direct formulas, Kahan sums that keep small
+ * frames next to a huge one, merges of consecutive partial PSDs matching
+ * one pass, and the STFT pool folding rows bit-identically for any thread
+ * count.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "../../src/iq_core/psd.h"
+#include "../../src/iq_core/stft.h"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { BINS = 64, FRAMES = 200 };
+
+// Deterministic positive power rows
+static void fill_rows(float *rows, uint32_t frames, uint32_t bins) {
+    uint32_t state = 12345;
+    for (size_t i = 0; i < (size_t)frames * bins; i++) {
+        state = state * 1664525u + 1013904223u;
+        rows[i] = 1e-3f + (float)(state >> 8) / (float)(1u << 24);
+    }
+}
+
+static bool close_to(double a, double b, double tol) {
+    return fabs(a - b) <= tol * (fabs(b) > 1.0 ? fabs(b) : 1.0);
+}
+
+// Each mode's readout matches its definition
+void test_psd_modes() {
+    TEST_START("Averaging Modes");
+
+    static float rows[FRAMES * BINS];
+    fill_rows(rows, FRAMES, BINS);
+    const double alpha = 0.05;
+    bool ok = true;
+
+    psd_t modes[4];
+    for (int m = 0; m < 4; m++) {
+        ok = psd_init(&modes[m], BINS, (psd_average_t)m, alpha) && ok;
+        // Uneven batches feed the same rows
+        for (uint32_t f = 0; ok && f < FRAMES; ) {
+            uint32_t n = f % 7 + 1;
+            if (n > FRAMES - f) n = FRAMES - f;
+            psd_add_rows(&modes[m], rows + (size_t)f * BINS, n);
+            f += n;
+        }
+    }
+
+    double out[BINS], db[BINS];
+    for (uint32_t k = 0; ok && k < BINS; k++) {
+        double sum = 0.0, log_sum = 0.0, peak = 0.0;
+        for (uint32_t f = 0; f < FRAMES; f++) {
+            double p = rows[(size_t)f * BINS + k];
+            sum += p;
+            log_sum += 10.0 * log10(p + 1e-12);
+            if (p > peak) peak = p;
+        }
+        double expect[4] = { sum / FRAMES, pow(10.0, log_sum / FRAMES / 10.0), 0.0, peak };
+
+        // Bias-corrected EMA from zero: sum of alpha (1 - alpha)^age p / (1 - (1 - alpha)^n)
+        double weighted = 0.0, weight = 0.0;
+        for (uint32_t f = 0; f < FRAMES; f++) {
+            double w = alpha * pow(1.0 - alpha, FRAMES - 1 - f);
+            weighted += w * rows[(size_t)f * BINS + k];
+            weight += w;
+        }
+        expect[2] = weighted / weight;
+
+        for (int m = 0; m < 4 && ok; m++) {
+            if (!psd_result(&modes[m], out, false) || !psd_result(&modes[m], db, true)) ok = false;
+            if (ok && !close_to(out[k], expect[m], 1e-9)) {
+                printf("    %s bin %u: %.12g, expected %.12g\n", psd_average_name((psd_average_t)m), k, out[k], expect[m]);
+                ok = false;
+            }
+            if (ok && !close_to(db[k], m == PSD_AVG_LOG ? log_sum / FRAMES : 10.0 * log10(expect[m] + 1e-12), 1e-9)) {
+                ok = false;
+            }
+        }
+    }
+    for (int m = 0; m < 4; m++) {
+        if (modes[m].frames != FRAMES) ok = false;
+        psd_free(&modes[m]);
+    }
+
+    // Names round-trip, bad arguments are refused, no frames no estimate
+    psd_average_t parsed;
+    for (int m = 0; m < 4; m++) {
+        if (!psd_average_from_name(psd_average_name((psd_average_t)m), &parsed) || parsed != (psd_average_t)m) ok = false;
+    }
+    if (psd_average_from_name("median", &parsed)) ok = false;
+    psd_t bad;
+    if (psd_init(&bad, 0, PSD_AVG_LINEAR, 0.0) || psd_init(&bad, BINS, PSD_AVG_EMA, 0.0)) ok = false;
+    if (psd_init(&bad, BINS, PSD_AVG_EMA, 1.5)) ok = false;
+    if (psd_init(&bad, BINS, PSD_AVG_MAX, 0.0)) {
+        if (psd_result(&bad, out, false)) ok = false;
+        psd_free(&bad);
+    } else {
+        ok = false;
+    }
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ linear, log, EMA and max-hold match their definitions in dB and linear\n");
+    } else {
+        TEST_FAIL("A readout differs from its definition");
+    }
+    TEST_END();
+}
+
+// Compensated sums keep frames a plain double sum would round away
+void test_psd_kahan() {
+    TEST_START("Compensated Sums");
+
+    // Each tiny frame is below half an ulp of the running sum: a plain sum drops all of them
+    psd_t psd;
+    bool ok = psd_init(&psd, 1, PSD_AVG_LINEAR, 0.0);
+    const float big = 1e8f, tiny = 1e-9f;
+    const uint32_t count = 1u << 20;
+    double naive = big;
+    if (ok) {
+        psd_add_rows(&psd, &big, 1);
+        for (uint32_t i = 0; i < count; i++) {
+            psd_add_rows(&psd, &tiny, 1);
+            naive += tiny;
+        }
+    }
+    double mean = 0.0;
+    ok = ok && psd_result(&psd, &mean, false);
+    double exact = ((double)big + (double)count * (double)tiny) / (count + 1);
+    double naive_mean = naive / (count + 1);
+    if (ok && fabs(mean - exact) > 1e-15 * exact) ok = false;
+    printf("    Kahan error %.3g, plain sum error %.3g\n", fabs(mean - exact) / exact, fabs(naive_mean - exact) / exact);
+    psd_free(&psd);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Compensated mean drifted");
+    }
+    TEST_END();
+}
+
+// Consecutive partial PSDs merged in order equal one pass over all frames
+void test_psd_merge() {
+    TEST_START("Merging Partial PSDs");
+
+    static float rows[FRAMES * BINS];
+    fill_rows(rows, FRAMES, BINS);
+    const uint32_t splits[] = { 0, 13, 77, 78, 150, FRAMES };
+    const size_t parts = sizeof(splits) / sizeof(splits[0]) - 1;
+    bool ok = true;
+
+    for (int m = 0; m < 4 && ok; m++) {
+        psd_t whole, merged;
+        ok = psd_init(&whole, BINS, (psd_average_t)m, 0.1) && psd_init(&merged, BINS, (psd_average_t)m, 0.1);
+        if (!ok) break;
+        psd_add_rows(&whole, rows, FRAMES);
+        for (size_t p = 0; p < parts; p++) {
+            psd_t part;
+            ok = psd_init(&part, BINS, (psd_average_t)m, 0.1) && ok;
+            psd_add_rows(&part, rows + (size_t)splits[p] * BINS, splits[p + 1] - splits[p]);
+            ok = ok && psd_merge(&merged, &part);
+            psd_free(&part);
+        }
+        double a[BINS], b[BINS];
+        ok = ok && psd_result(&whole, a, false) && psd_result(&merged, b, false) && merged.frames == FRAMES;
+        for (uint32_t k = 0; ok && k < BINS; k++) {
+            if (!close_to(b[k], a[k], 1e-12)) {
+                printf("    %s bin %u: merged %.15g, one pass %.15g\n", psd_average_name((psd_average_t)m), k, b[k], a[k]);
+                ok = false;
+            }
+        }
+
+        // Mismatched accumulators are refused
+        psd_t other;
+        if (psd_init(&other, BINS / 2, (psd_average_t)m, 0.1)) {
+            if (psd_merge(&merged, &other)) ok = false;
+            psd_free(&other);
+        }
+        psd_free(&whole);
+        psd_free(&merged);
+    }
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %zu consecutive parts merge to the one-pass estimate in every mode\n", parts);
+    } else {
+        TEST_FAIL("Merged estimate differs from one pass");
+    }
+    TEST_END();
+}
+
+// The pool folds rows into a PSD bit-identically for any thread count
+void test_psd_stft() {
+    TEST_START("STFT Pool Into PSD");
+
+    const uint32_t size = 512, frames = 96, hop = 256;
+    const uint32_t samples = (frames - 1) * hop + size;
+    fft_plan_f32_t *plan = fft_plan_f32_acquire(size, FFT_FORWARD);
+    float *iq = malloc((size_t)samples * 2 * sizeof(float));
+    float *rows = malloc((size_t)frames * size * sizeof(float));
+    double *reference = malloc(size * sizeof(double));
+    double *out = malloc(size * sizeof(double));
+    bool ok = plan && iq && rows && reference && out;
+    for (uint32_t n = 0; ok && n < samples; n++) {
+        iq[2 * n] = (float)cos(0.37 * n) + 0.001f * (float)(n % 11);
+        iq[2 * n + 1] = (float)sin(0.37 * n) - 0.001f * (float)(n % 13);
+    }
+
+    const uint32_t thread_counts[] = { 1, 3, 8 };
+    for (int m = 0; m < 4 && ok; m++) {
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]) && ok; t++) {
+            stft_t *stft = stft_create(plan, NULL, thread_counts[t]);
+            psd_t psd;
+            ok = stft && psd_init(&psd, size, (psd_average_t)m, 0.2);
+            // Two batches of uneven size
+            ok = ok && stft_rows(stft, iq, frames, hop, rows, false) &&
+                 stft_accumulate_psd(stft, rows, 40, &psd) &&
+                 stft_accumulate_psd(stft, rows + (size_t)40 * size, frames - 40, &psd);
+            ok = ok && psd.frames == frames && psd_result(&psd, t == 0 ? reference : out, true);
+            if (ok && t > 0 && memcmp(reference, out, size * sizeof(double)) != 0) {
+                printf("    %s with %u threads differs from one thread\n", psd_average_name((psd_average_t)m), thread_counts[t]);
+                ok = false;
+            }
+            if (ok && !stft_accumulate_psd(stft, rows, 0, &psd)) ok = false;
+            psd_free(&psd);
+
+            // A PSD of the wrong width is refused
+            if (ok && psd_init(&psd, size / 2, (psd_average_t)m, 0.2)) {
+                if (stft_accumulate_psd(stft, rows, 1, &psd)) ok = false;
+                psd_free(&psd);
+            }
+            stft_destroy(stft);
+        }
+    }
+    fft_release_thread_buffers();
+    fft_plan_f32_release(plan);
+    free(iq); free(rows); free(reference); free(out);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ 1, 3 and 8 threads give the same bits in every mode\n");
+    } else {
+        TEST_FAIL("Pool PSD depends on the thread count");
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - PSD Accumulator Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_psd_modes();
+    test_psd_kahan();
+    test_psd_merge();
+    test_psd_stft();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
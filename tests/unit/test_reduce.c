@@ -0,0 +1,185 @@
+/*
+ * IQ Lab - Deterministic Reduction Unit Tests
+ *
+ * Tests for reduce.h: sums that a double running sum gets wrong coming out
+ * exact, the same bits for every split and merge order of the adds, chunk
+ * boundaries that do not depend on the thread count, and infinities and
+ * NaN propagating like IEEE addition.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+#include "../../src/iq_core/reduce.h"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { VALUES = 100000 };
+
+// Values over a wide range of magnitudes and both signs
+static double make_value(uint32_t i) {
+    uint32_t h = i * 2654435761u;
+    double mantissa = (double)(h >> 8) / 16777216.0 - 0.5;
+    return ldexp(mantissa, (int)(h % 61) - 30);
+}
+
+static double sum_of(const double *values, size_t count) {
+    reduce_sum_t sum;
+    reduce_sum_init(&sum);
+    for (size_t i = 0; i < count; i++) reduce_sum_add(&sum, values[i]);
+    return reduce_sum_value(&sum);
+}
+
+static void test_exact(void) {
+    TEST_START("Sums are exact");
+
+    // A running double sum loses the 1s entirely
+    const double cancel[] = { 1e16, 1.0, -1e16, 1.0, DBL_MAX, -DBL_MAX, 3.0 * DBL_MIN / 4.0 };
+    double naive = 0.0;
+    for (size_t i = 0; i < 6; i++) naive += cancel[i];
+    double exact = sum_of(cancel, 6);
+
+    // Extremes: the smallest subnormal, the largest double, and both together
+    const double tiny[] = { 4.9406564584124654e-324, 4.9406564584124654e-324 };
+    const double huge_pair[] = { DBL_MAX, 4.9406564584124654e-324, -DBL_MAX };
+    bool ok = naive != 2.0 && exact == 2.0 && sum_of(tiny, 2) == 2 * 4.9406564584124654e-324 &&
+              sum_of(huge_pair, 3) == 4.9406564584124654e-324 && sum_of(cancel, 7) == 2.0 + 3.0 * DBL_MIN / 4.0;
+
+    // Many values: the sum of the negated values is the exact negation
+    double *values = malloc(VALUES * sizeof(double));
+    ok = ok && values;
+    for (uint32_t i = 0; ok && i < VALUES; i++) values[i] = make_value(i);
+    double forward = ok ? sum_of(values, VALUES) : 0.0;
+    for (uint32_t i = 0; ok && i < VALUES; i++) values[i] = -values[i];
+    ok = ok && sum_of(values, VALUES) == -forward;
+
+    // Twice every value: twice the sum, not a rounding of it
+    reduce_sum_t twice;
+    reduce_sum_init(&twice);
+    for (uint32_t i = 0; ok && i < VALUES; i++) {
+        reduce_sum_add(&twice, values[i]);
+        reduce_sum_add(&twice, values[i]);
+    }
+    ok = ok && reduce_sum_value(&twice) == -2.0 * forward;
+    free(values);
+    printf("  running sum %.17g, exact %.17g\n", naive, exact);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("sum not exact");
+    }
+    TEST_END();
+}
+
+static void test_order(void) {
+    TEST_START("Any split and merge order gives the same bits");
+
+    double *values = malloc(VALUES * sizeof(double));
+    bool ok = values != NULL;
+    for (uint32_t i = 0; ok && i < VALUES; i++) values[i] = make_value(i);
+    double reference = ok ? sum_of(values, VALUES) : 0.0;
+
+    // Split into k parts as threads would, merged last part first
+    const uint32_t parts[] = { 1, 2, 3, 7, 64 };
+    for (size_t p = 0; ok && p < sizeof(parts) / sizeof(parts[0]); p++) {
+        reduce_sum_t partial[64], total;
+        reduce_sum_init(&total);
+        for (uint32_t t = 0; t < parts[p]; t++) {
+            reduce_sum_init(&partial[t]);
+            uint64_t begin = reduce_split(VALUES, parts[p], t), end = reduce_split(VALUES, parts[p], t + 1);
+            for (uint64_t i = begin; i < end; i++) reduce_sum_add(&partial[t], values[i]);
+        }
+        for (uint32_t t = parts[p]; t-- > 0;) reduce_sum_merge(&total, &partial[t]);
+        double value = reduce_sum_value(&total);
+        ok = memcmp(&value, &reference, sizeof(value)) == 0;
+    }
+
+    // Reversed order, one add at a time
+    reduce_sum_t reversed;
+    reduce_sum_init(&reversed);
+    for (uint32_t i = VALUES; ok && i-- > 0;) reduce_sum_add(&reversed, values[i]);
+    double value = reduce_sum_value(&reversed);
+    ok = ok && memcmp(&value, &reference, sizeof(value)) == 0;
+
+    // And close to a long double sum
+    long double wide = 0.0L;
+    for (uint32_t i = 0; ok && i < VALUES; i++) wide += values[i];
+    ok = ok && fabs(reference - (double)wide) <= 1e-9 * fabs(reference);
+    free(values);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("sum depends on the order of the adds");
+    }
+    TEST_END();
+}
+
+static void test_split(void) {
+    TEST_START("Chunk boundaries and special values");
+
+    // Every boundary is a chunk multiple (or the end), parts cover [0, total)
+    bool ok = true;
+    const uint64_t totals[] = { 0, 1, REDUCE_CHUNK_SAMPLES, 1000003, 5ull << 32 };
+    for (size_t t = 0; t < sizeof(totals) / sizeof(totals[0]); t++) {
+        for (uint32_t parts = 1; parts <= 64; parts++) {
+            ok = ok && reduce_split(totals[t], parts, 0) == 0 && reduce_split(totals[t], parts, parts) == totals[t];
+            for (uint32_t i = 1; i < parts; i++) {
+                uint64_t at = reduce_split(totals[t], parts, i);
+                ok = ok && at >= reduce_split(totals[t], parts, i - 1) &&
+                     (at % REDUCE_CHUNK_SAMPLES == 0 || at == totals[t]);
+            }
+        }
+    }
+
+    const double inf_values[] = { 1.0, INFINITY, 2.0 };
+    const double both_inf[] = { INFINITY, -INFINITY };
+    const double with_nan[] = { 1.0, NAN };
+    const double none[] = { 0.0 };
+    ok = ok && sum_of(inf_values, 3) == INFINITY && isnan(sum_of(both_inf, 2)) &&
+         isnan(sum_of(with_nan, 2)) && sum_of(none, 1) == 0.0 && sum_of(none, 0) == 0.0;
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("split or special values");
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Deterministic Reduction Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_exact();
+    test_order();
+    test_split();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
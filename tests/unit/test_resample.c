@@ -1,10 +1,19 @@
 /*
  * IQ Lab - Resample Unit Tests
+ *
+ * Besides the API checks, the polyphase filter must pass tones at unit
+ * gain and reject what would alias, block processing must equal
+ * per-sample processing, rate pairs with huge fractions must get a close
+ * approximation, the IQ resampler must keep both sides of the spectrum,
+ * the Farrow interpolator must track a tone at a non-integer rate, and
+ * large reductions must be planned as a cheaper stage chain with the same
+ * passband and alias rejection.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include <assert.h>
 #include "../../src/iq_core/resample.h"
 
@@ -289,6 +298,389 @@ void test_resample_reset() {
     resample_free(&resampler);
 }
 
+// Amplitude of a tone at frequency in output[skip..count) by correlation
+static double tone_amplitude(const float *output, uint32_t count, uint32_t skip,
+                             double frequency, double rate) {
+    double re = 0.0, im = 0.0;
+    for (uint32_t n = skip; n < count; n++) {
+        double phase = 2.0 * M_PI * frequency * n / rate;
+        re += output[n] * cos(phase);
+        im += output[n] * sin(phase);
+    }
+    return 2.0 * sqrt(re * re + im * im) / (count - skip);
+}
+
+// Test the polyphase filter: unit passband gain, stopband rejection
+void test_resample_polyphase() {
+    TEST_START("Polyphase Response");
+
+    struct {
+        uint32_t in_rate;
+        uint32_t out_rate;
+        double tone;
+        double min_gain_db;
+        double max_gain_db;
+    } cases[] = {
+        {44100, 48000, 1000.0, -0.1, 0.1},      // Passband, L/M = 160/147
+        {240000, 48000, 5000.0, -0.1, 0.1},     // Passband, FM audio decimation
+        {8000, 48000, 1500.0, -0.1, 0.1},       // Passband, upsampling
+        {96000, 48000, 30000.0, -300.0, -60.0}, // Would alias to 18 kHz
+        {240000, 48000, 100000.0, -300.0, -60.0} // Far stopband
+    };
+
+    int passed = 0;
+    const uint32_t input_samples = 48000;
+    float *input = malloc(input_samples * sizeof(float));
+    float *output = malloc(6 * input_samples * sizeof(float) + 64);
+    assert(input && output);
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        resample_t resampler;
+        assert(resample_init(&resampler, cases[c].in_rate, cases[c].out_rate));
+        for (uint32_t n = 0; n < input_samples; n++) {
+            input[n] = (float)(0.5 * sin(2.0 * M_PI * cases[c].tone * n / cases[c].in_rate));
+        }
+        uint32_t generated = 0;
+        assert(resample_process_buffer(&resampler, input, input_samples, output,
+                                       6 * input_samples + 16, &generated));
+        uint32_t expected = (uint32_t)(input_samples * resampler.ratio);
+        // The alias of a stopband tone lands on its folded frequency
+        double folded = fmod(cases[c].tone, cases[c].out_rate);
+        if (folded > cases[c].out_rate / 2.0) folded = cases[c].out_rate - folded;
+        double gain_db = 20.0 * log10(tone_amplitude(output, generated, generated / 4, folded,
+                                                     cases[c].out_rate) / 0.5 + 1e-12);
+        bool ok = generated + 1 >= expected && generated <= expected + 1 &&
+                  gain_db >= cases[c].min_gain_db && gain_db <= cases[c].max_gain_db;
+        printf("    %s %u -> %u, %.0f Hz: %u outputs, %.2f dB\n", ok ? "✅" : "❌",
+               cases[c].in_rate, cases[c].out_rate, cases[c].tone, generated, gain_db);
+        passed += ok;
+        resample_free(&resampler);
+    }
+    free(input);
+    free(output);
+
+    if (passed == (int)(sizeof(cases) / sizeof(cases[0]))) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Polyphase response out of range");
+    }
+}
+
+// Test that block processing matches per-sample processing exactly
+void test_resample_block_matches_sample() {
+    TEST_START("Block vs Sample Processing");
+
+    resample_t block, single;
+    assert(resample_init(&block, 44100, 48000));
+    assert(resample_init(&single, 44100, 48000));
+
+    float input[1000], a[1200], b[1200];
+    for (int i = 0; i < 1000; i++) input[i] = sinf(0.01f * i) + 0.25f * cosf(0.37f * i);
+
+    uint32_t na = 0, nb = 0;
+    assert(resample_process_buffer(&block, input, 1000, a, 1200, &na));
+    for (int i = 0; i < 1000; i++) nb += resample_process_sample(&single, input[i], b + nb, 1200 - nb);
+
+    if (na == nb && memcmp(a, b, na * sizeof(float)) == 0 && block.input_count == 1000) {
+        TEST_PASS();
+        printf("    %u identical outputs\n", na);
+    } else {
+        TEST_FAIL("Block and per-sample outputs differ");
+    }
+
+    resample_free(&block);
+    resample_free(&single);
+}
+
+// Test rate pairs whose exact fraction needs too many phases
+void test_resample_approximate_ratio() {
+    TEST_START("Approximate Ratios");
+
+    resample_t resampler;
+    assert(resample_init(&resampler, 96001, 100003));
+    double approx = (double)resampler.interpolation / resampler.decimation;
+    double error = fabs(approx / resampler.ratio - 1.0);
+    if (resampler.interpolation <= RESAMPLE_MAX_PHASES && error < 1e-6) {
+        TEST_PASS();
+        printf("    96001 -> 100003 as %u/%u (%.2e relative error)\n",
+               resampler.interpolation, resampler.decimation, error);
+    } else {
+        TEST_FAIL("Ratio approximation too coarse");
+    }
+    resample_free(&resampler);
+}
+
+// Test the IQ resampler: positive and negative tones keep their sides and
+// each rail matches the real resampler
+void test_resample_iq() {
+    TEST_START("IQ Resampling");
+
+    const uint32_t n = 24000;
+    float *iq = malloc(2 * n * sizeof(float));
+    float *rail = malloc(n * sizeof(float));
+    float *out = malloc(2 * n * sizeof(float));
+    float *ref = malloc(n * sizeof(float));
+    assert(iq && rail && out && ref);
+
+    bool ok = true;
+    const double tones[] = {7000.0, -11000.0};
+    for (int t = 0; t < 2; t++) {
+        for (uint32_t i = 0; i < n; i++) {
+            double phase = 2.0 * M_PI * tones[t] * i / 240000.0;
+            iq[2 * i] = (float)(0.5 * cos(phase));
+            iq[2 * i + 1] = (float)(0.5 * sin(phase));
+            rail[i] = iq[2 * i];
+        }
+        resample_t resampler, real;
+        assert(resample_iq_init(&resampler, 240000, 48000));
+        assert(resample_init(&real, 240000, 48000));
+        uint32_t generated = 0, real_generated = 0;
+        assert(resample_iq_process_buffer(&resampler, iq, n, out, n, &generated));
+        assert(resample_process_buffer(&real, rail, n, ref, n, &real_generated));
+        assert(!resample_process_buffer(&resampler, rail, n, ref, n, &real_generated));
+
+        // Correlate with the expected complex tone
+        double re = 0.0, im = 0.0, max_diff = 0.0;
+        for (uint32_t m = generated / 4; m < generated; m++) {
+            double phase = -2.0 * M_PI * tones[t] * m / 48000.0;
+            re += out[2 * m] * cos(phase) - out[2 * m + 1] * sin(phase);
+            im += out[2 * m] * sin(phase) + out[2 * m + 1] * cos(phase);
+            double diff = fabs(out[2 * m] - ref[m]);
+            if (diff > max_diff) max_diff = diff;
+        }
+        double gain_db = 20.0 * log10(sqrt(re * re + im * im) / (generated - generated / 4) / 0.5);
+        bool case_ok = generated == n / 5 && real_generated == generated &&
+                       fabs(gain_db) < 0.1 && max_diff < 1e-5;
+        printf("    %s %+.0f Hz: %u outputs, %.3f dB, rail difference %.1e\n",
+               case_ok ? "✅" : "❌", tones[t], generated, gain_db, max_diff);
+        ok = ok && case_ok;
+        resample_free(&resampler);
+        resample_free(&real);
+    }
+    free(iq);
+    free(rail);
+    free(out);
+    free(ref);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("IQ resampler response out of range");
+    }
+}
+
+// Test the Farrow interpolator on a non-integer rate pair
+void test_resample_farrow() {
+    TEST_START("Farrow Fractional Resampling");
+
+    const double in_rate = 12001.46, out_rate = 12000.0, tone = 500.0;
+    const uint32_t n = 12000;
+    float *iq = malloc(2 * n * sizeof(float));
+    float *a = malloc(2 * (n + 16) * sizeof(float));
+    float *b = malloc(2 * (n + 16) * sizeof(float));
+    assert(iq && a && b);
+    for (uint32_t i = 0; i < n; i++) {
+        double phase = 2.0 * M_PI * tone * i / in_rate;
+        iq[2 * i] = (float)cos(phase);
+        iq[2 * i + 1] = (float)sin(phase);
+    }
+
+    resample_farrow_t whole, split;
+    assert(!resample_farrow_init(&whole, 0.0, out_rate, 2));
+    assert(!resample_farrow_init(&whole, in_rate, out_rate, 3));
+    assert(resample_farrow_init(&whole, in_rate, out_rate, 2));
+    assert(resample_farrow_init(&split, in_rate, out_rate, 2));
+
+    uint32_t na = 0, nb = 0;
+    assert(resample_farrow_process(&whole, iq, n, a, n + 16, &na));
+    for (uint32_t offset = 0; offset < n; ) {
+        uint32_t chunk = 1 + (offset * 7u) % 333u;
+        if (chunk > n - offset) chunk = n - offset;
+        uint32_t got = 0;
+        assert(resample_farrow_process(&split, iq + 2 * offset, chunk, b + 2 * nb, n + 16 - nb, &got));
+        nb += got;
+        offset += chunk;
+    }
+
+    // Outputs sit on the ideal tone at k / out_rate, two inputs of latency
+    double expected = (n - 2) * out_rate / in_rate;
+    double max_error = 0.0;
+    for (uint32_t k = 1; k < na; k++) {
+        double phase = 2.0 * M_PI * tone * k / out_rate;
+        double error = hypot(a[2 * k] - cos(phase), a[2 * k + 1] - sin(phase));
+        if (error > max_error) max_error = error;
+    }
+
+    if (fabs(na - expected) <= 1.0 && na == nb && memcmp(a, b, 2 * na * sizeof(float)) == 0 &&
+        max_error < 1e-3 && whole.input_count == n) {
+        TEST_PASS();
+        printf("    %.2f -> %.0f Hz: %u outputs, max error %.1e\n", in_rate, out_rate, na, max_error);
+    } else {
+        TEST_FAIL("Farrow output incorrect");
+        printf("    %u outputs (expected %.1f, split %u), max error %.1e\n", na, expected, nb, max_error);
+    }
+
+    free(iq);
+    free(a);
+    free(b);
+}
+
+// Test the stage planner on large and small reductions
+void test_resample_plan() {
+    TEST_START("Multi-stage Planning");
+
+    struct {
+        uint32_t in_rate;
+        uint32_t out_rate;
+        bool chained;
+    } cases[] = {
+        {10000000, 48000, true},
+        {2400000, 44100, true},
+        {240000, 48000, true},
+        {44100, 48000, false},
+        {96000, 48000, false},  // Below 2 * RESAMPLE_PLAN_MIN_OVERSAMPLE
+        {8000, 48000, false}
+    };
+
+    bool ok = true;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        resample_plan_t plan;
+        assert(resample_plan(&plan, cases[c].in_rate, cases[c].out_rate, 32, 0.4f));
+        resample_t single;
+        assert(resample_init_custom(&single, cases[c].in_rate, cases[c].out_rate, 32, 0.4f));
+        assert(single.predecimator == NULL && single.stage_rate == cases[c].in_rate);
+
+        uint32_t factor = decim_plan_decimation(&plan.predecimation);
+        bool chained = factor > 1;
+        bool case_ok = chained == cases[c].chained &&
+                       (uint64_t)plan.stage_rate * factor == cases[c].in_rate &&
+                       plan.macs_per_input <= single.macs_per_input;
+        if (chained) {
+            case_ok = case_ok && plan.stage_rate >= RESAMPLE_PLAN_MIN_OVERSAMPLE * cases[c].out_rate &&
+                      plan.macs_per_input < single.macs_per_input;
+        }
+
+        // resample_init runs the plan
+        resample_t planned;
+        assert(resample_init(&planned, cases[c].in_rate, cases[c].out_rate));
+        case_ok = case_ok && (planned.predecimator != NULL) == chained &&
+                  planned.stage_rate == plan.stage_rate &&
+                  planned.interpolation == plan.interpolation &&
+                  planned.decimation == plan.decimation &&
+                  planned.macs_per_input == plan.macs_per_input;
+
+        printf("    %s %u -> %u: CIC %u, %u halfbands, polyphase %u -> %u (%u/%u, %u taps), "
+               "%.2f MACs/sample (single stage %.2f)\n",
+               case_ok ? "✅" : "❌", cases[c].in_rate, cases[c].out_rate,
+               plan.predecimation.cic_factor, plan.predecimation.num_halfbands, plan.stage_rate,
+               cases[c].out_rate, plan.interpolation, plan.decimation, plan.taps_per_phase,
+               plan.macs_per_input, single.macs_per_input);
+        ok = ok && case_ok;
+        resample_free(&single);
+        resample_free(&planned);
+    }
+
+    // The audio presets plan automatically
+    resample_t audio;
+    assert(resample_init_audio_48k(&audio, 10000000));
+    ok = ok && audio.predecimator != NULL && audio.output_rate == 48000;
+    resample_free(&audio);
+    assert(resample_init_audio_44k(&audio, 10000000));
+    ok = ok && audio.predecimator != NULL && audio.output_rate == 44100;
+    resample_free(&audio);
+
+    resample_plan_t plan;
+    ok = ok && !resample_plan(&plan, 0, 48000, 32, 0.4f) && !resample_plan(NULL, 1, 1, 32, 0.4f);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Unexpected stage plan");
+    }
+}
+
+// Test a planned chain end to end: passband gain, alias rejection, output
+// count, and per-sample processing matching block processing
+void test_resample_multistage() {
+    TEST_START("Multi-stage Response");
+
+    struct {
+        uint32_t in_rate;
+        uint32_t out_rate;
+        double tone;
+        double min_gain_db;
+        double max_gain_db;
+    } cases[] = {
+        {10000000, 48000, 3000.0, -0.1, 0.1},        // Passband
+        {10000000, 48000, 1003000.0, -300.0, -60.0}, // Would alias to 5 kHz
+        {10000000, 48000, 30000.0, -300.0, -60.0},   // Would alias to 18 kHz
+        {2400000, 44100, 12000.0, -0.1, 0.1},
+        {2400000, 44100, 611000.0, -300.0, -60.0}
+    };
+
+    bool ok = true;
+    const uint32_t input_samples = 2000000;
+    float *input = malloc(input_samples * sizeof(float));
+    float *output = malloc(input_samples / 16 * sizeof(float));
+    assert(input && output);
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        resample_t resampler;
+        assert(resample_init(&resampler, cases[c].in_rate, cases[c].out_rate));
+        assert(resampler.predecimator != NULL);
+        for (uint32_t n = 0; n < input_samples; n++) {
+            input[n] = (float)(0.5 * sin(2.0 * M_PI * fmod(cases[c].tone * n / cases[c].in_rate, 1.0)));
+        }
+        uint32_t generated = 0;
+        assert(resample_process_buffer(&resampler, input, input_samples, output,
+                                       input_samples / 16, &generated));
+        uint32_t expected = (uint32_t)(input_samples * resampler.ratio);
+
+        double folded = fmod(cases[c].tone, cases[c].out_rate);
+        if (folded > cases[c].out_rate / 2.0) folded = cases[c].out_rate - folded;
+        double gain_db = 20.0 * log10(tone_amplitude(output, generated, generated / 4, folded,
+                                                     cases[c].out_rate) / 0.5 + 1e-12);
+        bool case_ok = generated + 1 >= expected && generated <= expected + 1 &&
+                       resampler.input_count == input_samples &&
+                       gain_db >= cases[c].min_gain_db && gain_db <= cases[c].max_gain_db;
+        printf("    %s %u -> %u, %.0f Hz: %u outputs, %.2f dB\n", case_ok ? "✅" : "❌",
+               cases[c].in_rate, cases[c].out_rate, cases[c].tone, generated, gain_db);
+        ok = ok && case_ok;
+
+        // Same outputs one sample at a time
+        if (c == 0) {
+            resample_t single;
+            assert(resample_init(&single, cases[c].in_rate, cases[c].out_rate));
+            float *b = malloc(input_samples / 16 * sizeof(float));
+            assert(b);
+            uint32_t nb = 0;
+            for (uint32_t n = 0; n < input_samples; n++) {
+                nb += resample_process_sample(&single, input[n], b + nb, input_samples / 16 - nb);
+            }
+            bool same = nb == generated && memcmp(output, b, nb * sizeof(float)) == 0;
+            printf("    %s per-sample processing: %u outputs%s\n", same ? "✅" : "❌", nb,
+                   same ? ", identical" : "");
+            ok = ok && same;
+
+            // Reset restarts the chain
+            resample_reset(&single);
+            uint32_t again = 0;
+            assert(resample_process_buffer(&single, input, input_samples, b, input_samples / 16,
+                                           &again));
+            ok = ok && again == generated && memcmp(output, b, again * sizeof(float)) == 0;
+            free(b);
+            resample_free(&single);
+        }
+        resample_free(&resampler);
+    }
+    free(input);
+    free(output);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Multi-stage response out of range");
+    }
+}
+
 int main() {
     printf("=====================================\n");
     printf("IQ Lab - Resample Unit Tests\n");
@@ -302,6 +694,13 @@ int main() {
     test_resample_configs();
     test_resample_errors();
     test_resample_reset();
+    test_resample_polyphase();
+    test_resample_block_matches_sample();
+    test_resample_approximate_ratio();
+    test_resample_iq();
+    test_resample_farrow();
+    test_resample_plan();
+    test_resample_multistage();
 
     printf("\n=====================================\n");
     printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
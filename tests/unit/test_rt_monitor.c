@@ -0,0 +1,261 @@
+/*
+ * IQ Lab - Real-Time Monitor Unit Tests
+ *
+ * Tests for the deadline monitor behind --realtime
+ * Covers latency percentiles, a paced reader that keeps up with a fast
+ * consumer, and a slow consumer that overruns the ring, drops whole blocks
+ * and writes its stats file
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // nanosleep under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../src/iq_core/io_async.h"
+#include "../../src/iq_core/rt_monitor.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+static const char *TEST_FILE = "test_rt_monitor.s16";
+static const char *TEST_STATS = "test_rt_monitor.json";
+enum { TEST_SAMPLES = 20000, TEST_BLOCK = 1000 };
+
+static bool write_test_file(void) {
+    FILE *file = fopen(TEST_FILE, "wb");
+    if (!file) return false;
+    int16_t pair[2] = {0, 0};
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+        pair[0] = (int16_t)(i % 32768);
+        fwrite(pair, sizeof(int16_t), 2, file);
+    }
+    fclose(file);
+    return true;
+}
+
+static void sleep_ms(unsigned int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static bool within(uint64_t value, uint64_t expected, double tolerance) {
+    double error = (double)value - (double)expected;
+    if (error < 0) error = -error;
+    return error <= tolerance * (double)expected;
+}
+
+// Percentiles land within half a bucket of the exact values; max is exact
+void test_latency_percentiles() {
+    TEST_START("Latency Percentiles");
+
+    static iq_latency_hist_t hist;
+    iq_latency_t latency;
+    iq_latency_get(&hist, &latency);
+    bool ok = latency.count == 0 && latency.p99_ns == 0 && latency.max_ns == 0;
+
+    // 1..1000 us, one of each
+    for (uint64_t us = 1; us <= 1000; us++) iq_latency_add(&hist, us * 1000);
+    iq_latency_get(&hist, &latency);
+    if (latency.count != 1000) ok = false;
+    if (!within(latency.p50_ns, 500000, 0.10)) ok = false;
+    if (!within(latency.p99_ns, 990000, 0.10)) ok = false;
+    if (latency.max_ns != 1000000) ok = false;
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ p50 %.0f us, p99 %.0f us, max %.0f us\n", (double)latency.p50_ns * 1e-3,
+               (double)latency.p99_ns * 1e-3, (double)latency.max_ns * 1e-3);
+    } else {
+        TEST_FAIL("Percentiles out of range");
+        printf("    p50 %llu p99 %llu max %llu ns\n", (unsigned long long)latency.p50_ns,
+               (unsigned long long)latency.p99_ns, (unsigned long long)latency.max_ns);
+    }
+    TEST_END();
+}
+
+// A consumer faster than the source sees every block, no sooner than real time
+void test_realtime_keeps_up() {
+    TEST_START("Paced Reader, Fast Consumer");
+
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, TEST_FILE)) {
+        TEST_FAIL("Reader open failed");
+        return;
+    }
+    // 20000 samples at 200 kS/s: 0.1 s of stream
+    const double rate = 200000.0;
+    rt_monitor_t *monitor = rt_monitor_create("test_rt_monitor", rate, 10.0, TEST_STATS);
+    iq_async_t *async = iq_async_create_realtime(&reader, TEST_BLOCK, 4, rate, monitor);
+    if (!monitor || !async) {
+        TEST_FAIL("Create failed");
+        iq_async_destroy(async);
+        rt_monitor_destroy(monitor);
+        iq_reader_close(&reader);
+        return;
+    }
+
+    bool ok = true;
+    uint64_t expected_start = 0;
+    const uint64_t start_ns = iq_profile_now();
+    const iq_async_block_t *block;
+    while ((block = iq_async_acquire(async)) != NULL) {
+        if (block->start != expected_start) ok = false;
+        expected_start += block->num_samples;
+        iq_async_release(async, block);
+    }
+    const double elapsed = (double)(iq_profile_now() - start_ns) * 1e-9;
+    iq_async_destroy(async);
+
+    rt_monitor_stats_t stats;
+    rt_monitor_get(monitor, &stats);
+    if (expected_start != TEST_SAMPLES) ok = false;
+    if (elapsed < 0.09) ok = false;
+    if (stats.overruns != 0 || stats.dropped_samples != 0) ok = false;
+    if (stats.blocks != TEST_SAMPLES / TEST_BLOCK) ok = false;
+    if (stats.speed > 1.05) ok = false;
+    if (stats.block_latency.count != stats.blocks) ok = false;
+
+    rt_monitor_destroy(monitor);
+    iq_reader_close(&reader);
+    remove(TEST_STATS);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %llu blocks in %.3f s (speed %.2fx), no overruns\n",
+               (unsigned long long)stats.blocks, elapsed, stats.speed);
+    } else {
+        TEST_FAIL("Paced run lost blocks or ran faster than real time");
+        printf("    %llu blocks, %llu overruns, %.3f s, speed %.2f\n", (unsigned long long)stats.blocks,
+               (unsigned long long)stats.overruns, elapsed, stats.speed);
+    }
+    TEST_END();
+}
+
+// A consumer slower than the source overruns: whole blocks are dropped
+// and counted, and the ring reads as behind on the way
+void test_realtime_overrun() {
+    TEST_START("Paced Reader, Slow Consumer");
+
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, TEST_FILE)) {
+        TEST_FAIL("Reader open failed");
+        return;
+    }
+    // 1 ms per block at 1 MS/s, consumed at 4 ms per block
+    const double rate = 1000000.0;
+    rt_monitor_t *monitor = rt_monitor_create("test_rt_monitor", rate, 0.01, TEST_STATS);
+    iq_async_t *async = iq_async_create_realtime(&reader, TEST_BLOCK, 4, rate, monitor);
+    if (!monitor || !async) {
+        TEST_FAIL("Create failed");
+        iq_async_destroy(async);
+        rt_monitor_destroy(monitor);
+        iq_reader_close(&reader);
+        return;
+    }
+
+    bool ok = true;
+    bool behind = false;
+    uint64_t consumed = 0;
+    uint64_t last_start = 0;
+    bool first = true;
+    const iq_async_block_t *block;
+    while ((block = iq_async_acquire(async)) != NULL) {
+        if (!first && block->start <= last_start) ok = false;
+        if (block->start % TEST_BLOCK != 0) ok = false;
+        first = false;
+        last_start = block->start;
+        consumed += block->num_samples;
+        sleep_ms(4);
+        if (rt_monitor_behind(monitor)) behind = true;
+        iq_async_release(async, block);
+        rt_monitor_poll(monitor);
+    }
+    iq_async_destroy(async);
+
+    rt_monitor_stats_t stats;
+    rt_monitor_get(monitor, &stats);
+    if (stats.overruns == 0 || stats.dropped_samples != stats.overruns * TEST_BLOCK) ok = false;
+    if (consumed + stats.dropped_samples != TEST_SAMPLES) ok = false;
+    if (stats.ring_peak != 4 || !behind) ok = false;
+    if (stats.load < 0.5) ok = false;
+
+    // The stats file was written by the polls
+    char text[4096] = {0};
+    FILE *f = fopen(TEST_STATS, "r");
+    if (f) {
+        size_t length = fread(text, 1, sizeof(text) - 1, f);
+        text[length] = '\0';
+        fclose(f);
+    } else {
+        ok = false;
+    }
+    if (!strstr(text, "\"tool\": \"test_rt_monitor\"") || !strstr(text, "\"overruns\": ") ||
+        !strstr(text, "\"block_latency\": {\"count\": ")) ok = false;
+
+    rt_monitor_destroy(monitor);
+    iq_reader_close(&reader);
+    remove(TEST_STATS);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %llu of %d blocks dropped, ring peaked at %u/4, load %.0f%%\n",
+               (unsigned long long)stats.overruns, TEST_SAMPLES / TEST_BLOCK, stats.ring_peak,
+               100.0 * stats.load);
+    } else {
+        TEST_FAIL("Overruns not counted or samples unaccounted for");
+        printf("    consumed %llu, dropped %llu, overruns %llu, peak %u, behind %d, load %.2f\n%s\n",
+               (unsigned long long)consumed, (unsigned long long)stats.dropped_samples,
+               (unsigned long long)stats.overruns, stats.ring_peak, behind, stats.load, text);
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Real-Time Monitor Unit Tests\n");
+    printf("=====================================\n\n");
+
+    if (!write_test_file()) {
+        printf("❌ Could not write %s\n", TEST_FILE);
+        return EXIT_FAILURE;
+    }
+
+    test_latency_percentiles();
+    test_realtime_keeps_up();
+    test_realtime_overrun();
+
+    remove(TEST_FILE);
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
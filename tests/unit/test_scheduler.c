@@ -0,0 +1,381 @@
+/*
+ * IQ Lab - Channel Scheduler Unit Tests
+ *
+ * Tests for the channel scheduler. Booked tasks come out in priority order
+ * with stable IDs, overlaps and a full table are rejected; runnable tasks
+ * all run on the pool, one worker runs them in priority order, tasks
+ * spawned from tasks run too (through the deques) and a failed task makes
+ * exactly one scheduler_wait() fail. Pooled buffers are aligned, reused
+ * per size class, capped by buffer_pool_size and safe to use from tasks.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "../../src/chan/scheduler.h"
+
+static scheduler_t *make_scheduler(uint32_t max_channels, uint32_t workers) {
+    scheduler_config_t config;
+    assert(scheduler_config_init(&config, max_channels) == true);
+    config.num_workers = workers;
+    scheduler_t *scheduler = scheduler_create(&config);
+    assert(scheduler != NULL);
+    assert(scheduler->num_workers == workers);
+    return scheduler;
+}
+
+static void test_scheduler_config(void) {
+    printf("Testing scheduler configuration...\n");
+
+    scheduler_config_t config;
+    assert(scheduler_config_init(&config, 0) == false);
+    assert(scheduler_config_init(&config, 16) == true);
+    assert(scheduler_config_validate(&config) == true);
+    assert(config.num_workers == 0);
+
+    config.num_workers = SCHEDULER_MAX_WORKERS + 1;
+    assert(scheduler_config_validate(&config) == false);
+    assert(scheduler_create(&config) == NULL);
+
+    // Zero workers means one per core
+    config.num_workers = 0;
+    scheduler_t *scheduler = scheduler_create(&config);
+    assert(scheduler != NULL && scheduler->num_workers >= 1);
+    scheduler_destroy(scheduler);
+
+    printf("✓ Scheduler configuration tests passed\n");
+}
+
+static void test_scheduler_booking(void) {
+    printf("Testing booked tasks...\n");
+
+    scheduler_t *scheduler = make_scheduler(4, 1);   // 8 task slots
+    const uint32_t priorities[] = {5, 1, 3, 1, 0, 7, 3, 2};
+    int32_t ids[8];
+
+    for (uint32_t i = 0; i < 8; i++) {
+        channel_task_t task = {0};
+        task.channel_id = i;
+        task.priority = priorities[i];
+        task.start_time = (double)(8 - i);
+        ids[i] = scheduler_add_task(scheduler, &task);
+        assert(ids[i] >= 0 && scheduler->tasks[ids[i]].task_id == (uint32_t)ids[i]);
+    }
+    channel_task_t extra = {0};
+    assert(scheduler_add_task(scheduler, &extra) == -2);
+
+    // Lowest priority first; equal priorities by start time
+    const uint32_t expected[] = {4, 3, 1, 7, 6, 2, 0, 5};
+    for (uint32_t k = 0; k < 8; k++) {
+        channel_task_t next;
+        assert(scheduler_get_next_task(scheduler, &next) == true);
+        assert(next.channel_id == expected[k] && next.task_id == (uint32_t)ids[expected[k]]);
+        assert(scheduler_complete_task(scheduler, next.task_id, 10.0) == true);
+        assert(scheduler_complete_task(scheduler, next.task_id, 10.0) == false);
+    }
+    channel_task_t next;
+    assert(scheduler_get_next_task(scheduler, &next) == false);
+
+    uint64_t total;
+    uint32_t active;
+    assert(scheduler_get_statistics(scheduler, &total, NULL, &active) == true);
+    assert(total == 8 && active == 0);
+
+    // Completed tasks keep their slots until removed
+    assert(scheduler_add_task(scheduler, &extra) == -2);
+    assert(scheduler_remove_task(scheduler, (uint32_t)ids[2]) == true);
+    assert(scheduler_remove_task(scheduler, (uint32_t)ids[2]) == false);
+    assert(scheduler_add_task(scheduler, &extra) == ids[2]);
+    assert(scheduler_reset(scheduler) == true);
+
+    // Overlapping intervals on one channel are refused, other channels are not
+    channel_task_t timed = {0};
+    timed.channel_id = 3;
+    timed.start_time = 1.0;
+    timed.duration = 2.0;
+    int32_t first = scheduler_add_task(scheduler, &timed);
+    assert(first >= 0);
+    timed.start_time = 2.5;
+    assert(scheduler_add_task(scheduler, &timed) == -3);
+    assert(scheduler_check_overlap(scheduler, 3, 3.0, 1.0) == true);
+    timed.channel_id = 4;
+    assert(scheduler_add_task(scheduler, &timed) >= 0);
+
+    // Priorities edited in place take effect after optimizing
+    channel_task_t late = {0};
+    late.channel_id = 9;
+    late.priority = 9;
+    int32_t late_id = scheduler_add_task(scheduler, &late);
+    assert(late_id >= 0);
+    scheduler->tasks[late_id].priority = 0;
+    assert(scheduler_optimize_schedule(scheduler) == true);
+    assert(scheduler_get_next_task(scheduler, &next) == true && next.task_id == (uint32_t)late_id);
+
+    // Removing from the middle of the heap keeps the order
+    assert(scheduler_remove_task(scheduler, (uint32_t)late_id) == true);
+    assert(scheduler_get_next_task(scheduler, &next) == true && next.task_id == (uint32_t)first);
+
+    char status[256];
+    assert(scheduler_get_status_string(scheduler, status, sizeof(status)) == true);
+    printf("  %s\n", status);
+
+    scheduler_destroy(scheduler);
+    printf("✓ Booked task tests passed\n");
+}
+
+typedef struct {
+    atomic_uint runs;            // Tasks that ran
+    atomic_uint order_index;     // Next position in order
+    uint32_t order[64];          // channel_id in execution order
+    atomic_bool started;         // The gate task is running
+    atomic_bool open;            // The gate task may return
+} run_log_t;
+
+static bool count_task(channel_task_t *task, void *user_data) {
+    run_log_t *log = user_data;
+    uint32_t position = atomic_fetch_add(&log->order_index, 1);
+    if (position < 64) log->order[position] = task->channel_id;
+    atomic_fetch_add(&log->runs, 1);
+    return true;
+}
+
+static bool gate_task(channel_task_t *task, void *user_data) {
+    (void)task;
+    run_log_t *log = user_data;
+    atomic_store(&log->started, true);
+    while (!atomic_load(&log->open)) sched_yield();
+    return true;
+}
+
+static bool failing_task(channel_task_t *task, void *user_data) {
+    (void)task;
+    (void)user_data;
+    return false;
+}
+
+static void test_scheduler_execution(void) {
+    printf("Testing task execution...\n");
+
+    // Many tasks on four workers, added faster than they finish
+    scheduler_t *scheduler = make_scheduler(64, 4);
+    run_log_t *log = calloc(1, sizeof(run_log_t));
+    assert(log);
+
+    const uint32_t total = 10000;
+    for (uint32_t i = 0; i < total; i++) {
+        channel_task_t task = {0};
+        task.channel_id = i % 64;
+        task.run = count_task;
+        task.user_data = log;
+        while (scheduler_add_task(scheduler, &task) == -2) sched_yield();
+    }
+    assert(scheduler_wait(scheduler) == true);
+    assert(atomic_load(&log->runs) == total);
+
+    uint64_t processed;
+    uint32_t active;
+    assert(scheduler_get_statistics(scheduler, &processed, NULL, &active) == true);
+    assert(processed == total && active == 0 && scheduler->num_tasks == 0);
+
+    // A failure fails the next wait only
+    channel_task_t bad = {0};
+    bad.run = failing_task;
+    assert(scheduler_add_task(scheduler, &bad) >= 0);
+    assert(scheduler_wait(scheduler) == false);
+    assert(scheduler_wait(scheduler) == true);
+    scheduler_destroy(scheduler);
+
+    // One worker held by a gate task runs the queued tasks by priority
+    scheduler = make_scheduler(32, 1);
+    memset(log, 0, sizeof(*log));
+    channel_task_t gate = {0};
+    gate.channel_id = 100;
+    gate.run = gate_task;
+    gate.user_data = log;
+    assert(scheduler_add_task(scheduler, &gate) >= 0);
+    while (!atomic_load(&log->started)) sched_yield();
+
+    const uint32_t priorities[] = {4, 0, 9, 2, 2, 7, 1, 3};
+    for (uint32_t i = 0; i < 8; i++) {
+        channel_task_t task = {0};
+        task.channel_id = i;
+        task.priority = priorities[i];
+        task.run = count_task;
+        task.user_data = log;
+        assert(scheduler_add_task(scheduler, &task) >= 0);
+    }
+    atomic_store(&log->open, true);
+    assert(scheduler_wait(scheduler) == true);
+
+    const uint32_t expected[] = {1, 6, 3, 4, 7, 0, 5, 2};
+    assert(atomic_load(&log->runs) == 8);
+    for (uint32_t k = 0; k < 8; k++) assert(log->order[k] == expected[k]);
+
+    scheduler_destroy(scheduler);
+    free(log);
+    printf("✓ Task execution tests passed\n");
+}
+
+typedef struct {
+    scheduler_t *scheduler;
+    atomic_uint leaves;          // Leaf tasks that ran
+    atomic_uint spawn_failures;  // scheduler_add_task errors inside tasks
+} spawn_state_t;
+
+// channel_id holds the remaining tree depth; every inner task spawns two
+static bool spawn_task(channel_task_t *task, void *user_data) {
+    spawn_state_t *state = user_data;
+    if (task->channel_id == 0) {
+        atomic_fetch_add(&state->leaves, 1);
+        return true;
+    }
+
+    for (int child = 0; child < 2; child++) {
+        channel_task_t sub = {0};
+        sub.channel_id = task->channel_id - 1;
+        sub.run = spawn_task;
+        sub.user_data = state;
+        if (scheduler_add_task(state->scheduler, &sub) < 0) {
+            atomic_fetch_add(&state->spawn_failures, 1);
+        }
+    }
+    return true;
+}
+
+static void test_scheduler_spawning(void) {
+    printf("Testing tasks spawned from tasks...\n");
+
+    // Depth 10 from four roots: at most 4 * 11 + 4 tasks are live at once
+    scheduler_t *scheduler = make_scheduler(2048, 4);
+    spawn_state_t state = {.scheduler = scheduler};
+
+    for (int root = 0; root < 4; root++) {
+        channel_task_t task = {0};
+        task.channel_id = 10;
+        task.run = spawn_task;
+        task.user_data = &state;
+        assert(scheduler_add_task(scheduler, &task) >= 0);
+    }
+    assert(scheduler_wait(scheduler) == true);
+    assert(atomic_load(&state.spawn_failures) == 0);
+    assert(atomic_load(&state.leaves) == 4u << 10);
+
+    uint64_t processed;
+    assert(scheduler_get_statistics(scheduler, &processed, NULL, NULL) == true);
+    assert(processed == 4u * ((2u << 10) - 1));
+
+    // Destroy drains whatever is still queued
+    for (int root = 0; root < 2; root++) {
+        channel_task_t task = {0};
+        task.channel_id = 6;
+        task.run = spawn_task;
+        task.user_data = &state;
+        assert(scheduler_add_task(scheduler, &task) >= 0);
+    }
+    scheduler_destroy(scheduler);
+    assert(atomic_load(&state.leaves) == (4u << 10) + (2u << 6));
+
+    printf("✓ Task spawning tests passed\n");
+}
+
+static bool buffer_task(channel_task_t *task, void *user_data) {
+    scheduler_t *scheduler = user_data;
+    uint32_t size = 100 + 700 * (task->channel_id % 5);
+
+    // A block freed on a worker comes straight back from its cache
+    unsigned char *a = scheduler_allocate_buffer(scheduler, size);
+    if (!a) return false;
+    memset(a, (int)task->channel_id, size);
+    scheduler_free_buffer(scheduler, a);
+    unsigned char *b = scheduler_allocate_buffer(scheduler, size);
+    bool ok = b == a;
+
+    unsigned char *c = scheduler_allocate_buffer(scheduler, 3 * size);
+    ok = ok && c && ((uintptr_t)c % SCHEDULER_BUFFER_ALIGNMENT) == 0;
+    if (c) memset(c, 1, 3 * size);
+    ok = scheduler_free_buffer(scheduler, c) && ok;
+    ok = scheduler_free_buffer(scheduler, b) && ok;
+    return ok;
+}
+
+static void test_scheduler_buffers(void) {
+    printf("Testing buffer pool...\n");
+
+    scheduler_config_t config;
+    assert(scheduler_config_init(&config, 8) == true);
+    config.num_workers = 2;
+    config.buffer_pool_size = 4096;
+    scheduler_t *scheduler = scheduler_create(&config);
+    assert(scheduler != NULL);
+
+    // Aligned and writable across class boundaries and past the largest class
+    const uint32_t sizes[] = {1, 63, 64, 65, 1000, 4096, 1u << 20, (1u << 20) + 1};
+    void *buffers[8];
+    for (uint32_t i = 0; i < 8; i++) {
+        buffers[i] = scheduler_allocate_buffer(scheduler, sizes[i]);
+        assert(buffers[i] != NULL && ((uintptr_t)buffers[i] % SCHEDULER_BUFFER_ALIGNMENT) == 0);
+        memset(buffers[i], 0xA5, sizes[i]);
+    }
+    assert(atomic_load(&scheduler->buffer_pool_used) == 8);
+    for (uint32_t i = 0; i < 8; i++) assert(scheduler_free_buffer(scheduler, buffers[i]) == true);
+    assert(atomic_load(&scheduler->buffer_pool_used) == 0);
+    assert(scheduler_free_buffer(scheduler, buffers[4]) == false);
+    assert(scheduler_free_buffer(scheduler, NULL) == false);
+    assert(scheduler_allocate_buffer(scheduler, 0) == NULL);
+
+    // Only 4096 idle bytes are kept: the 64..4096-byte blocks, not the large ones
+    assert(scheduler->pool_cached_bytes <= 4096);
+
+    // Same class, same block (last freed first)
+    void *a = scheduler_allocate_buffer(scheduler, 700);
+    void *b = scheduler_allocate_buffer(scheduler, 1024);
+    assert(a && b && a != b);
+    assert(scheduler_free_buffer(scheduler, a) == true);
+    assert(scheduler_allocate_buffer(scheduler, 513) == a);
+    assert(scheduler_free_buffer(scheduler, a) == true);
+    assert(scheduler_free_buffer(scheduler, b) == true);
+
+    // Workers allocate and free concurrently through their caches
+    for (uint32_t i = 0; i < 2000; i++) {
+        channel_task_t task = {0};
+        task.channel_id = i;
+        task.run = buffer_task;
+        task.user_data = scheduler;
+        while (scheduler_add_task(scheduler, &task) == -2) sched_yield();
+    }
+    assert(scheduler_wait(scheduler) == true);
+    assert(atomic_load(&scheduler->buffer_pool_used) == 0);
+
+    // Reset hands the idle blocks back
+    assert(scheduler_reset(scheduler) == true);
+    assert(scheduler->pool_cached_bytes == 0);
+    for (uint32_t c = 0; c < SCHEDULER_SIZE_CLASSES; c++) {
+        assert(scheduler->workers[0].cache_count[c] == 0 && scheduler->free_lists[c] == NULL);
+    }
+
+    scheduler_destroy(scheduler);
+    printf("✓ Buffer pool tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running Scheduler Unit Tests\n");
+    printf("============================\n\n");
+
+    test_scheduler_config();
+    test_scheduler_booking();
+    test_scheduler_execution();
+    test_scheduler_spawning();
+    test_scheduler_buffers();
+
+    printf("\n============================\n");
+    printf("All scheduler tests passed! ✓\n");
+    printf("============================\n");
+    return 0;
+}
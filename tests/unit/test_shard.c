@@ -0,0 +1,324 @@
+/*
+ * IQ Lab - Shard Unit Tests
+ *
+ * Tests for time-sharded pipeline runs: margins and hop grid from the
+ * steps, shard files holding the capture's samples around each core, and
+ * the merge of per-shard event logs (events in a margin dropped, a burst
+ * crossing a boundary extended) and tile pyramids (each core's rows once)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../../src/jobs/shard.h"
+#include "../../src/iq_core/io_sigmf.h"
+#include "../../src/viz/tile_pyramid.h"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { RATE = 1000000, CAPTURE_SAMPLES = 400000 };
+
+static const char *CAPTURE_PATH = "test_shard_capture.iq";
+static const char *CAPTURE_META = "test_shard_capture.sigmf-meta";
+
+static int16_t sample_i(uint64_t n) { return (int16_t)(n % 30000); }
+static int16_t sample_q(uint64_t n) { return (int16_t)-(int16_t)(n % 20000); }
+
+// Append a step; params are key/value pairs ending with NULL
+static void add_step(yaml_document_t *document, const char *tool, const char *const *params) {
+    yaml_pipeline_step_t *step = yaml_add_step(document);
+    step->tool_name = yaml_copy_string(document, tool);
+    for (const char *const *p = params; *p; p += 2) {
+        yaml_set_step_param(document, step, p[0], p[1]);
+    }
+}
+
+static bool test_geometry(void) {
+    TEST_START("Margin and hop grid from the steps");
+
+    yaml_document_t document = {0};
+    const char *detect[] = {"in", "{input}", NULL};
+    add_step(&document, "iqdetect", detect);
+    uint64_t margin = 0, grid = 0;
+    bool ok = shard_geometry(&document, RATE, &margin, &grid);
+
+    // iqdetect's defaults: 2 x 4096 plus a 50 ms gap, on its 1024 hop
+    if (!ok || grid != 1024 || margin != 58368) {
+        TEST_FAIL("default iqdetect geometry");
+        yaml_free_document(&document);
+        return false;
+    }
+
+    // A longer FFT and a 768 hop: margin 2 x 16384 + 50000 on a 3072 grid
+    const char *ls[] = {"in", "{input}", "fft", "16384", "hop", "768", NULL};
+    add_step(&document, "iqls", ls);
+    ok = shard_geometry(&document, RATE, &margin, &grid);
+    if (!ok || grid != 3072 || margin % grid != 0 || margin < 32768 + 50000 || margin >= 32768 + 50000 + grid) {
+        TEST_FAIL("geometry with a second step");
+        yaml_free_document(&document);
+        return false;
+    }
+
+    // Unparsable sizes are refused
+    const char *bad[] = {"in", "{input}", "fft", "big", NULL};
+    add_step(&document, "iqls", bad);
+    ok = !shard_geometry(&document, RATE, &margin, &grid);
+    yaml_free_document(&document);
+    if (!ok) {
+        TEST_FAIL("bad fft accepted");
+        return false;
+    }
+
+    TEST_PASS();
+    return true;
+}
+
+static bool write_capture(void) {
+    FILE *file = fopen(CAPTURE_PATH, "wb");
+    if (!file) return false;
+    for (uint64_t n = 0; n < CAPTURE_SAMPLES; n++) {
+        int16_t iq[2] = {sample_i(n), sample_q(n)};
+        fwrite(iq, sizeof(iq), 1, file);
+    }
+    fclose(file);
+
+    sigmf_metadata_t meta = {0};
+    bool ok = sigmf_create_basic_metadata(&meta, "ci16_le", RATE, 100000000, "shard test", "iq_lab") &&
+              sigmf_add_capture(&meta, 0, 100000000, "2026-01-01T00:00:00Z") &&
+              sigmf_write_metadata(CAPTURE_META, &meta);
+    sigmf_free_metadata(&meta);
+    return ok;
+}
+
+static bool test_plan_and_files(void) {
+    TEST_START("Shard files cover each core plus its margins");
+
+    if (!write_capture()) {
+        TEST_FAIL("cannot write the capture");
+        return false;
+    }
+    yaml_document_t document = {0};
+    yaml_input_t *input = yaml_add_input(&document);
+    input->file = yaml_copy_string(&document, CAPTURE_PATH);
+    input->meta = yaml_copy_string(&document, CAPTURE_META);
+    const char *detect[] = {"in", "{input}", "out", "{out_dir}/{stem}.csv", NULL};
+    add_step(&document, "iqdetect", detect);
+
+    shard_plan_t plan;
+    bool ok = shard_plan_init(&plan, &document, 0.1, ".") && shard_plan_write(&plan);
+    if (!ok || plan.count != 4 || plan.shard_samples != 100352 || plan.margin != 58368) {
+        TEST_FAIL("plan geometry");
+        shard_plan_remove_files(&plan);
+        shard_plan_free(&plan);
+        yaml_free_document(&document);
+        return false;
+    }
+
+    // Cores tile the capture; each file holds [read_start, read_end) exactly
+    uint64_t expected_start = 0;
+    for (uint32_t k = 0; ok && k < plan.count; k++) {
+        const shard_t *s = &plan.shards[k];
+        ok = s->core_start == expected_start && s->read_start <= s->core_start && s->read_end >= s->core_end;
+        expected_start = s->core_end;
+
+        FILE *file = fopen(s->path, "rb");
+        ok = ok && file;
+        for (uint64_t n = s->read_start; ok && n < s->read_end; n++) {
+            int16_t iq[2];
+            ok = fread(iq, sizeof(iq), 1, file) == 1 && iq[0] == sample_i(n) && iq[1] == sample_q(n);
+        }
+        if (file) {
+            ok = ok && fgetc(file) == EOF;
+            fclose(file);
+        }
+    }
+    ok = ok && expected_start == CAPTURE_SAMPLES;
+    if (!ok) TEST_FAIL("shard file contents");
+
+    // The run's document: one input per shard, the capture's rate added
+    yaml_document_t shards;
+    if (ok && (!shard_plan_document(&plan, &document, &shards) || shards.input_count != 4 ||
+               strcmp(shards.inputs[2].file, plan.shards[2].path) != 0 ||
+               !yaml_get_step_param(&shards.pipeline[0], "rate") ||
+               strcmp(yaml_get_step_param(&shards.pipeline[0], "rate"), "1000000") != 0)) {
+        TEST_FAIL("shard document");
+        ok = false;
+    }
+    if (ok) yaml_free_document(&shards);
+
+    shard_plan_remove_files(&plan);
+    shard_plan_free(&plan);
+    yaml_free_document(&document);
+    remove(CAPTURE_PATH);
+    remove(CAPTURE_META);
+    remove("shards.csv");
+    if (!ok) return false;
+
+    TEST_PASS();
+    return true;
+}
+
+// Three shards of 1000 samples at 1 kHz with 100-sample margins
+static void small_plan(shard_plan_t *plan, shard_t *shards) {
+    memset(plan, 0, sizeof(*plan));
+    plan->sample_rate = 1000;
+    plan->total_samples = 3000;
+    plan->shard_samples = 1000;
+    plan->margin = 100;
+    plan->grid = 10;
+    plan->shards = shards;
+    plan->count = 3;
+    for (uint32_t k = 0; k < 3; k++) {
+        shards[k].core_start = 1000 * k;
+        shards[k].core_end = 1000 * (k + 1);
+        shards[k].read_start = k > 0 ? shards[k].core_start - 100 : 0;
+        shards[k].read_end = k < 2 ? shards[k].core_end + 100 : 3000;
+    }
+}
+
+static void write_text(const char *path, const char *text) {
+    FILE *file = fopen(path, "w");
+    if (file) {
+        fputs(text, file);
+        fclose(file);
+    }
+}
+
+static bool test_merge_events(void) {
+    TEST_START("Event logs merged without boundary duplicates");
+
+    shard_plan_t plan;
+    shard_t shards[3];
+    small_plan(&plan, shards);
+
+    const char *header = "t_start_s,t_end_s,f_center_Hz,bw_Hz,snr_dB\n";
+    const char *paths[3] = {"test_shard_ev0.csv", "test_shard_ev1.csv", "test_shard_ev2.csv"};
+    char text[512];
+    // Shard 0 (from 0 s): A, B reaching the file's end, C starting in the margin
+    snprintf(text, sizeof(text), "%s0.2,0.4,100,10,20\n0.95,1.1,200,10,21\n1.05,1.1,300,10,22\n", header);
+    write_text(paths[0], text);
+    // Shard 1 (from 0.9 s): B seen whole, C, and D before shard 2's core
+    snprintf(text, sizeof(text), "%s0.0,0.4,200,10,21\n0.15,0.3,300,10,22\n1.05,1.15,400,10,23\n", header);
+    write_text(paths[1], text);
+    // Shard 2 (from 1.9 s): D again, then E
+    snprintf(text, sizeof(text), "%s0.05,0.15,400,10,23\n0.5,0.6,500,10,24\n", header);
+    write_text(paths[2], text);
+
+    bool ok = shard_merge_events(&plan, paths, "test_shard_merged.csv");
+    const double expected[5][3] = {
+        {0.2, 0.4, 100}, {0.95, 1.3, 200}, {1.05, 1.2, 300}, {1.95, 2.05, 400}, {2.4, 2.5, 500}
+    };
+    FILE *file = ok ? fopen("test_shard_merged.csv", "r") : NULL;
+    char line[256];
+    int count = 0;
+    ok = file && fgets(line, sizeof(line), file) && strcmp(line, header) == 0;
+    while (ok && fgets(line, sizeof(line), file)) {
+        double t0, t1, f;
+        ok = count < 5 && sscanf(line, "%lf,%lf,%lf", &t0, &t1, &f) == 3 &&
+             fabs(t0 - expected[count][0]) < 1e-6 && fabs(t1 - expected[count][1]) < 1e-6 &&
+             f == expected[count][2];
+        count++;
+    }
+    if (file) fclose(file);
+    for (int k = 0; k < 3; k++) remove(paths[k]);
+    remove("test_shard_merged.csv");
+
+    if (!ok || count != 5) {
+        TEST_FAIL("merged events");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+static bool test_merge_pyramids(void) {
+    TEST_START("Tile pyramids stitched from each core's rows");
+
+    enum { WIDTH = 8, TILE = 4 };
+    shard_plan_t plan;
+    shard_t shards[3];
+    small_plan(&plan, shards);
+
+    // One row per 10 samples, each cell the row's capture frame index
+    const char *paths[3] = {"test_shard_t0.iqpyr", "test_shard_t1.iqpyr", "test_shard_t2.iqpyr"};
+    bool ok = true;
+    for (uint32_t k = 0; ok && k < 3; k++) {
+        uint64_t rows = (shards[k].read_end - shards[k].read_start) / 10;
+        tile_pyramid_info_t info = {0};
+        info.tile_size = TILE;
+        info.width = WIDTH;
+        info.num_levels = tile_pyramid_levels_for(WIDTH, rows, TILE);
+        info.sample_rate = 1000.0;
+        info.row_seconds = 0.01;
+        tile_pyramid_writer_t writer;
+        ok = tile_pyramid_writer_open(&writer, paths[k], &info);
+        float row[WIDTH];
+        for (uint64_t r = 0; ok && r < rows; r++) {
+            for (int c = 0; c < WIDTH; c++) row[c] = (float)(shards[k].read_start / 10 + r);
+            ok = tile_pyramid_writer_push(&writer, row);
+        }
+        ok = tile_pyramid_writer_close(&writer) && ok;
+    }
+
+    ok = ok && shard_merge_pyramids(&plan, paths, "test_shard_merged.iqpyr");
+    tile_pyramid_reader_t reader;
+    bool open = ok && tile_pyramid_reader_open(&reader, "test_shard_merged.iqpyr");
+    ok = open && reader.info.num_rows == 300 && reader.info.width == WIDTH;
+    float cells[TILE * TILE];
+    for (uint64_t tile_row = 0; ok && tile_row * TILE < 300; tile_row++) {
+        uint32_t rows = 0, cols = 0;
+        ok = tile_pyramid_read_tile(&reader, 0, tile_row, 1, cells, &rows, &cols);
+        for (uint32_t r = 0; ok && r < rows; r++) {
+            ok = cells[r * cols] == (float)(tile_row * TILE + r);
+        }
+    }
+    if (open) tile_pyramid_reader_close(&reader);
+    for (int k = 0; k < 3; k++) remove(paths[k]);
+    remove("test_shard_merged.iqpyr");
+
+    if (!ok) {
+        TEST_FAIL("merged pyramid rows");
+        return false;
+    }
+    TEST_PASS();
+    return true;
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Shard Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_geometry();
+    TEST_END();
+    test_plan_and_files();
+    TEST_END();
+    test_merge_events();
+    TEST_END();
+    test_merge_pyramids();
+    TEST_END();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
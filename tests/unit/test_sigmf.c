@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
 #include "../../src/iq_core/io_sigmf.h"
 
 // Test counters
@@ -124,6 +125,8 @@ void test_datatype_parsing() {
     if (sigmf_parse_datatype("ci16") == SIGMF_DATATYPE_CI16 &&
         sigmf_parse_datatype("ci8") == SIGMF_DATATYPE_CI8 &&
         sigmf_parse_datatype("cf32") == SIGMF_DATATYPE_CF32 &&
+        sigmf_parse_datatype("ci12_le") == SIGMF_DATATYPE_CI12 &&
+        sigmf_parse_datatype("ci4") == SIGMF_DATATYPE_CI4 &&
         sigmf_parse_datatype("invalid") == SIGMF_DATATYPE_CI16) {  // Default fallback
         TEST_PASS();
     } else {
@@ -139,7 +142,9 @@ void test_datatype_to_string() {
 
     if (strcmp(sigmf_datatype_to_string(SIGMF_DATATYPE_CI16), "ci16") == 0 &&
         strcmp(sigmf_datatype_to_string(SIGMF_DATATYPE_CI8), "ci8") == 0 &&
-        strcmp(sigmf_datatype_to_string(SIGMF_DATATYPE_CF32), "cf32") == 0) {
+        strcmp(sigmf_datatype_to_string(SIGMF_DATATYPE_CF32), "cf32") == 0 &&
+        strcmp(sigmf_datatype_to_string(SIGMF_DATATYPE_CI12), "ci12") == 0 &&
+        strcmp(sigmf_datatype_to_string(SIGMF_DATATYPE_CI4), "ci4") == 0) {
         TEST_PASS();
     } else {
         TEST_FAIL("Datatype to string conversion failed");
@@ -177,6 +182,66 @@ void test_capture_management() {
     TEST_END();
 }
 
+// Test reading every capture and mapping times through them
+void test_capture_seek() {
+    TEST_START("Capture Time Mapping");
+
+    const char *filename = "test_capture_seek.sigmf-meta";
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        TEST_FAIL("Could not create metadata file");
+        TEST_END();
+        return;
+    }
+    // Two 1 s segments at 1 kHz with a 9 s gap between them
+    fprintf(file,
+            "{\n  \"global\": {\"core:datatype\": \"ci8_le\", \"core:sample_rate\": 1000},\n"
+            "  \"captures\": [\n"
+            "    {\"core:sample_start\": 0, \"core:frequency\": 433000000, \"core:datetime\": \"2024-02-28T23:59:55Z\"},\n"
+            "    {\"core:sample_start\": 1000, \"core:frequency\": 868000000, \"core:datetime\": \"2024-02-29T00:00:05.500Z\"}\n"
+            "  ],\n  \"annotations\": []\n}\n");
+    fclose(file);
+
+    sigmf_metadata_t metadata = {0};
+    bool ok = sigmf_read_metadata(filename, &metadata);
+    ok = ok && metadata.num_captures == 2 &&
+         metadata.global.sample_rate == 1000 &&
+         sigmf_parse_datatype(metadata.global.datatype) == SIGMF_DATATYPE_CI8 &&
+         metadata.captures[1].sample_start == 1000 &&
+         metadata.captures[1].frequency == 868000000;
+
+    uint64_t sample = 0;
+    ok = ok && sigmf_time_to_sample(&metadata, 0.25, &sample) && sample == 250;
+    ok = ok && sigmf_time_to_sample(&metadata, 5.0, &sample) && sample == 1000;     // In the gap
+    ok = ok && sigmf_time_to_sample(&metadata, 10.75, &sample) && sample == 1250;   // Second segment
+    ok = ok && !sigmf_time_to_sample(&metadata, -1.0, &sample);
+
+    // Sample 0 is at the first capture's datetime
+    double start = 0.0;
+    ok = ok && sigmf_start_time(&metadata, &start) && start == 1709164795.0;
+
+    // Without datetimes the segments are contiguous
+    metadata.captures[1].datetime[0] = '\0';
+    ok = ok && sigmf_time_to_sample(&metadata, 1.5, &sample) && sample == 1500;
+
+    // Only a later capture timed: its datetime less its offset
+    strcpy(metadata.captures[1].datetime, "2024-02-29T00:00:05.500Z");
+    metadata.captures[0].datetime[0] = '\0';
+    ok = ok && sigmf_start_time(&metadata, &start) && fabs(start - 1709164804.5) < 1e-6;
+    metadata.captures[1].datetime[0] = '\0';
+    ok = ok && !sigmf_start_time(&metadata, &start);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Captures or time mapping incorrect");
+    }
+
+    sigmf_free_metadata(&metadata);
+    remove(filename);
+    TEST_END();
+}
+
 // Test annotation management
 void test_annotation_management() {
     TEST_START("Annotation Management");
@@ -210,6 +275,285 @@ void test_annotation_management() {
     TEST_END();
 }
 
+// Write 'text' to 'filename'; false if the file cannot be created
+static bool write_text_file(const char *filename, const char *text) {
+    FILE *file = fopen(filename, "w");
+    if (!file) return false;
+    fputs(text, file);
+    fclose(file);
+    return true;
+}
+
+// Test the tokenizer on escapes, member order, unknown values and number forms
+void test_json_parsing() {
+    TEST_START("JSON Tokenizer and Parser");
+
+    const char *filename = "test_json_parsing.sigmf-meta";
+    char text[2048];
+    char long_label[300];
+    memset(long_label, 'x', sizeof(long_label) - 1);
+    long_label[sizeof(long_label) - 1] = '\0';
+
+    // Annotations ahead of global, nested extension values, float sample rate
+    snprintf(text, sizeof(text),
+             "{\"annotations\": [{\"core:sample_start\": 10, \"core:sample_count\": 20,\n"
+             "   \"core:label\": \"%s\", \"ext:tags\": [1, {\"a\": [true, null]}, \"]}\"]},\n"
+             "  {\"core:sample_start\": 5e1, \"core:comment\": \"tab\\there \\\"q\\\" \\u00e9\\ud83d\\ude00\"}],\n"
+             " \"global\": {\"core:sample_rate\": 2.4e6, \"core:datatype\": \"cf32_le\",\n"
+             "   \"core:description\": \"line\\nbreak \\\\ slash\\/\", \"core:hw\": \"rtl, \\\"v3\\\"\",\n"
+             "   \"ext:nested\": {\"core:sample_rate\": 7}},\n"
+             " \"captures\": [{\"core:sample_start\": 0, \"core:frequency\": 915000000}]}\n",
+             long_label);
+
+    sigmf_metadata_t metadata = {0};
+    bool ok = write_text_file(filename, text) && sigmf_read_metadata(filename, &metadata);
+
+    ok = ok && metadata.global.sample_rate == 2400000 &&
+         strcmp(metadata.global.datatype, "cf32_le") == 0 &&
+         strcmp(metadata.global.description, "line\nbreak \\ slash/") == 0 &&
+         strcmp(metadata.global.hw_info, "rtl, \"v3\"") == 0;
+    ok = ok && metadata.num_captures == 1 && metadata.captures[0].frequency == 915000000;
+    ok = ok && metadata.num_annotations == 2 &&
+         metadata.annotations[0].sample_start == 10 &&
+         metadata.annotations[0].sample_count == 20 &&
+         strlen(metadata.annotations[0].label) == sizeof(metadata.annotations[0].label) - 1 &&
+         metadata.annotations[1].sample_start == 50 &&
+         strcmp(metadata.annotations[1].description,
+                "tab\there \"q\" \xc3\xa9\xf0\x9f\x98\x80") == 0;
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Parsed metadata incorrect");
+    }
+
+    sigmf_free_metadata(&metadata);
+    remove(filename);
+    TEST_END();
+}
+
+// Test that malformed documents are rejected
+void test_malformed_json() {
+    TEST_START("Malformed JSON Rejection");
+
+    const char *filename = "test_malformed.sigmf-meta";
+    const char *documents[] = {
+        "",
+        "[]",
+        "{\"global\": {\"core:sample_rate\": 1000,}}",
+        "{\"global\": {\"core:sample_rate\" 1000}}",
+        "{\"captures\": [{\"core:sample_start\": 0} {\"core:sample_start\": 1}]}",
+        "{\"annotations\": [{\"core:label\": \"unterminated}]}",
+        "{\"annotations\": [{\"core:label\": \"bad \\q escape\"}]}",
+        "{\"global\": {\"core:author\": nope}}",
+        "{\"global\": {}} trailing",
+        "{\"annotations\": [{\"core:sample_start\": 1}",
+        "{\"annotations\": {}}",
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+        sigmf_metadata_t metadata = {0};
+        if (!write_text_file(filename, documents[i]) || sigmf_read_metadata(filename, &metadata)) {
+            printf("  Accepted document %zu\n", i);
+            ok = false;
+        }
+        sigmf_free_metadata(&metadata);
+    }
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Malformed metadata accepted");
+    }
+
+    remove(filename);
+    TEST_END();
+}
+
+// Test writing annotations through the streaming writer and reading them back
+void test_annotation_streaming() {
+    TEST_START("Annotation Streaming");
+
+    const char *filename = "test_annotation_stream.sigmf-meta";
+    const size_t streamed = 20000;
+
+    sigmf_metadata_t metadata = {0};
+    sigmf_create_basic_metadata(&metadata, "ci16_le", 2000000, 433920000, "Stream \"test\"", "iq_lab");
+    sigmf_add_capture(&metadata, 0, 433920000, "2024-01-01T00:00:00Z");
+    sigmf_add_annotation(&metadata, 1, 2, 433000000, 434000000, "first");
+    snprintf(metadata.annotations[0].description, sizeof(metadata.annotations[0].description),
+             "Comment with \\ and \"quotes\"");
+
+    // Open writes the one held annotation, the rest stream straight to disk
+    sigmf_writer_t *writer = sigmf_writer_open(filename, &metadata);
+    bool ok = writer != NULL;
+    char label[64];
+    for (size_t i = 0; ok && i < streamed; i++) {
+        snprintf(label, sizeof(label), "event \"%zu\"", i);
+        ok = sigmf_writer_add_annotation(writer, 1000 * i, 500 + i, 0, 0, label);
+    }
+    ok = sigmf_writer_close(writer) && ok;
+    sigmf_free_metadata(&metadata);
+
+    // Whole-document read sees every annotation
+    ok = ok && sigmf_read_metadata(filename, &metadata);
+    ok = ok && metadata.num_annotations == streamed + 1 &&
+         strcmp(metadata.global.description, "Stream \"test\"") == 0 &&
+         metadata.num_captures == 1 &&
+         metadata.annotations[0].freq_upper_edge == 434000000 &&
+         strcmp(metadata.annotations[0].description, "Comment with \\ and \"quotes\"") == 0 &&
+         metadata.annotations[streamed].sample_start == 1000 * (streamed - 1) &&
+         strcmp(metadata.annotations[streamed].label, "event \"19999\"") == 0;
+    sigmf_free_metadata(&metadata);
+
+    // Streaming read visits them in order, one at a time
+    sigmf_annotation_reader_t *reader = sigmf_annotation_reader_open(filename);
+    ok = ok && reader != NULL;
+    sigmf_annotation_t annotation;
+    size_t count = 0;
+    while (ok && sigmf_annotation_reader_next(reader, &annotation)) {
+        if (count > 0) {
+            snprintf(label, sizeof(label), "event \"%zu\"", count - 1);
+            ok = annotation.sample_start == 1000 * (count - 1) &&
+                 annotation.sample_count == 500 + (count - 1) &&
+                 strcmp(annotation.label, label) == 0;
+        }
+        count++;
+    }
+    ok = sigmf_annotation_reader_close(reader) && ok && count == streamed + 1;
+
+    // A document without annotations streams none
+    ok = ok && write_text_file(filename, "{\"global\": {\"core:sample_rate\": 1}}");
+    reader = sigmf_annotation_reader_open(filename);
+    ok = ok && reader != NULL && !sigmf_annotation_reader_next(reader, &annotation);
+    ok = sigmf_annotation_reader_close(reader) && ok;
+
+    // A truncated array ends the stream and reports the failure on close
+    ok = ok && write_text_file(filename,
+                               "{\"annotations\": [{\"core:sample_start\": 1}, {\"core:sample_start\": ");
+    reader = sigmf_annotation_reader_open(filename);
+    ok = ok && reader != NULL &&
+         sigmf_annotation_reader_next(reader, &annotation) && annotation.sample_start == 1 &&
+         !sigmf_annotation_reader_next(reader, &annotation);
+    ok = !sigmf_annotation_reader_close(reader) && ok;
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Streamed annotations incorrect");
+    }
+
+    remove(filename);
+    TEST_END();
+}
+
+// Brute-force count of the annotations an index query should return
+static size_t count_overlaps(const sigmf_metadata_t *metadata, uint64_t s0, uint64_t s1,
+                             uint64_t f0, uint64_t f1) {
+    size_t count = 0;
+    for (size_t i = 0; i < metadata->num_annotations; i++) {
+        const sigmf_annotation_t *a = &metadata->annotations[i];
+        uint64_t end = a->sample_start + (a->sample_count ? a->sample_count : 1);
+        bool banded = a->freq_lower_edge || a->freq_upper_edge;
+        if (a->sample_start < s1 && s0 < end &&
+            (!banded || (a->freq_lower_edge <= f1 && f0 <= a->freq_upper_edge))) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Test the sidecar annotation index against a linear scan
+void test_annotation_index() {
+    TEST_START("Annotation Index Queries");
+
+    const char *filename = "test_annotation_index.sigmf-meta";
+    const char *index_filename = "test_annotation_index.sigmf-idx";
+    remove(index_filename);
+
+    // Unsorted events of mixed lengths, some without a band, plus one that
+    // spans most of the recording so the tree's max_end pruning matters
+    sigmf_metadata_t metadata = {0};
+    sigmf_create_basic_metadata(&metadata, "ci16_le", 1000000, 100000000, "index", "iq_lab");
+    uint32_t seed = 12345;
+    char label[32];
+    for (size_t i = 0; i < 5000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        uint64_t start = (seed >> 4) % 10000000;
+        seed = seed * 1664525u + 1013904223u;
+        uint64_t count = (i % 7 == 0) ? 0 : (seed >> 8) % 20000;
+        seed = seed * 1664525u + 1013904223u;
+        uint64_t f_lo = 99000000 + (seed >> 8) % 2000000;
+        bool banded = i % 5 != 0;
+        snprintf(label, sizeof(label), "event %zu", i);
+        sigmf_add_annotation(&metadata, start, count, banded ? f_lo : 0, banded ? f_lo + 25000 : 0, label);
+    }
+    sigmf_add_annotation(&metadata, 100, 9000000, 100000000, 100001000, "long");
+
+    bool ok = sigmf_write_metadata(filename, &metadata);
+    sigmf_annotation_index_t *index = ok ? sigmf_index_open(filename) : NULL;
+    FILE *sidecar = fopen(index_filename, "rb");
+    ok = ok && index && sidecar && sigmf_index_count(index) == metadata.num_annotations;
+    if (sidecar) fclose(sidecar);
+
+    const sigmf_index_entry_t *results[6000];
+    for (int round = 0; ok && round < 2; round++) {
+        // Second round queries the index loaded back from the sidecar
+        if (round == 1) {
+            sigmf_index_close(index);
+            index = sigmf_index_open(filename);
+            ok = index != NULL;
+        }
+        for (int q = 0; ok && q < 300; q++) {
+            seed = seed * 1664525u + 1013904223u;
+            uint64_t s0 = (seed >> 4) % 10100000;
+            seed = seed * 1664525u + 1013904223u;
+            uint64_t s1 = s0 + 1 + (seed >> 8) % (q % 3 == 0 ? 1000 : 500000);
+            seed = seed * 1664525u + 1013904223u;
+            uint64_t f0 = (q % 4 == 0) ? 0 : 99000000 + (seed >> 8) % 2000000;
+            uint64_t f1 = (q % 4 == 0) ? UINT64_MAX : f0 + 100000;
+
+            size_t n = sigmf_index_query(index, s0, s1, f0, f1, results, 6000);
+            ok = n == count_overlaps(&metadata, s0, s1, f0, f1);
+            for (size_t i = 1; ok && i < n; i++) {
+                ok = results[i - 1]->sample_start <= results[i]->sample_start;
+            }
+        }
+    }
+
+    // Entries lead back to their full annotation in the meta file
+    const sigmf_index_entry_t *first = NULL;
+    size_t n = ok ? sigmf_index_query(index, 0, UINT64_MAX, 0, UINT64_MAX, &first, 1) : 0;
+    ok = ok && n == metadata.num_annotations && sigmf_index_query(index, 5, 5, 0, UINT64_MAX, NULL, 0) == 0;
+    sigmf_annotation_t annotation;
+    const sigmf_index_entry_t *last = ok ? sigmf_index_entry(index, n - 1) : NULL;
+    ok = ok && last && sigmf_index_read_annotation(index, last, &annotation) &&
+         annotation.sample_start == last->sample_start &&
+         strcmp(annotation.label, metadata.annotations[last->ordinal].label) == 0 &&
+         sigmf_index_read_annotation(index, first, &annotation) &&
+         strcmp(annotation.label, metadata.annotations[first->ordinal].label) == 0;
+    sigmf_index_close(index);
+
+    // Rewriting the meta file invalidates the sidecar
+    metadata.num_annotations = 3;
+    ok = ok && sigmf_write_metadata(filename, &metadata);
+    index = ok ? sigmf_index_open(filename) : NULL;
+    ok = ok && index && sigmf_index_count(index) == 3;
+    sigmf_index_close(index);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Index query results differ from a linear scan");
+    }
+
+    sigmf_free_metadata(&metadata);
+    remove(filename);
+    remove(index_filename);
+    TEST_END();
+}
+
 // Test error handling
 void test_error_handling() {
     TEST_START("Error Handling");
@@ -244,7 +588,12 @@ int main() {
     test_datatype_parsing();
     test_datatype_to_string();
     test_capture_management();
+    test_capture_seek();
     test_annotation_management();
+    test_json_parsing();
+    test_malformed_json();
+    test_annotation_streaming();
+    test_annotation_index();
     test_error_handling();
 
     // Summary
@@ -0,0 +1,246 @@
+/*
+ * IQ Lab - Spectral Frame Bus Unit Tests
+ *
+ * Tests for spectral_bus: every subscriber must read every frame's row in
+ * order, bit-identical to fft_spectral_frame / fft_spectral_frame_f64 on
+ * the same samples, however fast or slow it reads and after the ring has
+ * wrapped many times; a detached subscriber must not hold the producer;
+ * and a thread binding must only match its own geometry and thread.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "../../src/iq_core/spectral_bus.h"
+
+#define TEST_FFT 4096
+#define TEST_HOP 256
+#define TEST_SAMPLES 400000
+
+static char capture[64];
+static uint64_t num_frames;
+static window_type_t capture_window;
+
+// Capture of deterministic s16 noise
+static void make_capture(window_type_t window_type) {
+    strcpy(capture, "/tmp/iqlab_bus_XXXXXX");
+    int fd = mkstemp(capture);
+    assert(fd >= 0);
+    static int16_t raw[TEST_SAMPLES * 2];
+    uint32_t seed = 17;
+    for (size_t i = 0; i < TEST_SAMPLES * 2; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        raw[i] = (int16_t)(seed >> 16);
+    }
+    assert(write(fd, raw, sizeof(raw)) == (ssize_t)sizeof(raw));
+    close(fd);
+
+    num_frames = (TEST_SAMPLES - TEST_FFT) / TEST_HOP + 1;
+    capture_window = window_type;
+}
+
+static void free_capture(void) {
+    unlink(capture);
+}
+
+typedef struct {
+    spectral_bus_t *bus;
+    uint32_t subscriber;
+    uint32_t chunk;          // Rows per read
+    bool f64;
+    uint64_t stop_after;     // Detach after this many rows (0: read all)
+    uint64_t rows_read;
+    bool match;
+} reader_t;
+
+// Subscriber thread: each row must equal the one computed here from its
+// own reader of the capture, as a tool would without the bus
+static void *read_rows(void *arg) {
+    reader_t *r = (reader_t *)arg;
+    float *f32 = malloc((size_t)r->chunk * TEST_FFT * sizeof(float));
+    double *f64 = malloc((size_t)r->chunk * TEST_FFT * sizeof(double));
+    float ref_f32[TEST_FFT];
+    double ref_f64[TEST_FFT];
+    assert(f32 && f64);
+
+    iq_reader_t reader;
+    iq_block_t block;
+    assert(iq_reader_open(&reader, capture));
+    assert(iq_block_init(&block, &reader, 65536));
+    fft_plan_f32_t *plan = fft_plan_f32_create(TEST_FFT, FFT_FORWARD);
+    const window_t *window = capture_window == WINDOW_RECTANGULAR ? NULL :
+                             window_acquire(capture_window, TEST_FFT, 0.0);
+    const float *taps = window ? window->coefficients_f32 : NULL;
+
+    r->match = true;
+    for (;;) {
+        uint32_t got = r->f64 ? spectral_bus_read_f64(r->bus, r->subscriber, f64, r->chunk)
+                              : spectral_bus_read_f32(r->bus, r->subscriber, f32, r->chunk);
+        for (uint32_t f = 0; f < got; f++) {
+            const float *samples = iq_block_span(&block, (r->rows_read + f) * TEST_HOP, TEST_FFT);
+            assert(samples);
+            if (r->f64) {
+                assert(fft_spectral_frame_f64(plan, samples, taps, ref_f64, false));
+                r->match = r->match && memcmp(f64 + (size_t)f * TEST_FFT, ref_f64, sizeof(ref_f64)) == 0;
+            } else {
+                assert(fft_spectral_frame(plan, samples, taps, ref_f32, false));
+                r->match = r->match && memcmp(f32 + (size_t)f * TEST_FFT, ref_f32, sizeof(ref_f32)) == 0;
+            }
+        }
+        r->rows_read += got;
+        if (got < r->chunk) break;
+        if (r->stop_after && r->rows_read >= r->stop_after) {
+            spectral_bus_detach(r->bus, r->subscriber);
+            break;
+        }
+        if (r->chunk == 1 && r->rows_read % 100 == 0) {
+            struct timespec pause = {0, 1000000};  // A slow consumer
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    window_release(window);
+    fft_plan_f32_destroy(plan);
+    iq_block_free(&block);
+    iq_reader_close(&reader);
+    free(f32);
+    free(f64);
+    return NULL;
+}
+
+static void test_bus_rows(window_type_t window_type) {
+    printf("Testing rows against per-frame transforms (%s)...\n", window_type_name(window_type));
+
+    make_capture(window_type);
+    spectral_bus_t *bus = spectral_bus_create(capture, TEST_FFT, TEST_HOP, window_type, 4,
+                                              SPECTRAL_BUS_F32 | SPECTRAL_BUS_F64);
+    assert(bus);
+    assert(num_frames > 5 * bus->ring_frames);  // The ring wraps
+    reader_t readers[4] = {
+        {bus, 0, 37, false, 0, 0, false},
+        {bus, 1, 1, true, 0, 0, false},
+        {bus, 2, 5, false, 10, 0, false},   // Leaves early
+        {bus, 3, 300, true, 0, 0, false}
+    };
+    pthread_t threads[4];
+    assert(spectral_bus_start(bus));
+    for (int i = 0; i < 4; i++) assert(pthread_create(&threads[i], NULL, read_rows, &readers[i]) == 0);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+
+    for (int i = 0; i < 4; i++) assert(readers[i].match);
+    assert(readers[0].rows_read == num_frames);
+    assert(readers[1].rows_read == num_frames);
+    assert(readers[2].rows_read == 10);
+    assert(readers[3].rows_read == num_frames);
+    assert(!spectral_bus_failed(bus));
+
+    // Past the end, and once detached, reads return nothing
+    float row[TEST_FFT];
+    assert(spectral_bus_read_f32(bus, 0, row, 1) == 0);
+    assert(spectral_bus_read_f32(bus, 2, row, 1) == 0);
+    spectral_bus_destroy(bus);
+    free_capture();
+
+    printf("✓ Row tests passed\n");
+}
+
+static void test_bus_detach(void) {
+    printf("Testing detached and idle subscribers...\n");
+
+    make_capture(WINDOW_RECTANGULAR);
+
+    // Nobody reads: detaching everyone lets the producer stop
+    spectral_bus_t *bus = spectral_bus_create(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, 2,
+                                              SPECTRAL_BUS_F32);
+    assert(bus && spectral_bus_start(bus));
+    spectral_bus_detach(bus, 0);
+    spectral_bus_detach(bus, 1);
+    spectral_bus_detach(bus, 1);
+    spectral_bus_destroy(bus);
+
+    // Destroy while the producer waits on a full ring
+    bus = spectral_bus_create(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, 1, SPECTRAL_BUS_F64);
+    assert(bus && spectral_bus_start(bus));
+    double row[TEST_FFT];
+    assert(spectral_bus_read_f64(bus, 0, row, 1) == 1);
+    spectral_bus_destroy(bus);
+
+    // Unstarted bus
+    bus = spectral_bus_create(capture, TEST_FFT, TEST_HOP, WINDOW_HANN, 1, SPECTRAL_BUS_F32);
+    assert(bus);
+    spectral_bus_destroy(bus);
+
+    assert(spectral_bus_create(capture, 0, TEST_HOP, WINDOW_RECTANGULAR, 1, SPECTRAL_BUS_F32) == NULL);
+    assert(spectral_bus_create(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, 0, SPECTRAL_BUS_F32) == NULL);
+    assert(spectral_bus_create(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, 1, 0) == NULL);
+    assert(spectral_bus_create("/nonexistent/capture.iq", TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, 1,
+                               SPECTRAL_BUS_F32) == NULL);
+    free_capture();
+
+    printf("✓ Detach tests passed\n");
+}
+
+static void *other_thread_bound(void *arg) {
+    return spectral_bus_bound((const char *)arg, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR,
+                              SPECTRAL_BUS_F32, NULL);
+}
+
+static void test_bus_binding(void) {
+    printf("Testing thread binding...\n");
+
+    make_capture(WINDOW_RECTANGULAR);
+    spectral_bus_t *bus = spectral_bus_create(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, 3,
+                                              SPECTRAL_BUS_F32);
+    assert(bus);
+
+    uint32_t subscriber = 99;
+    assert(spectral_bus_bound(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, SPECTRAL_BUS_F32,
+                              &subscriber) == NULL);
+    spectral_bus_bind(bus, 2);
+    assert(spectral_bus_bound(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, SPECTRAL_BUS_F32,
+                              &subscriber) == bus);
+    assert(subscriber == 2);
+
+    // Any other geometry or format computes its own rows
+    assert(spectral_bus_bound("other.iq", TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, SPECTRAL_BUS_F32, NULL) == NULL);
+    assert(spectral_bus_bound(capture, 2 * TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, SPECTRAL_BUS_F32, NULL) == NULL);
+    assert(spectral_bus_bound(capture, TEST_FFT, TEST_HOP + 1, WINDOW_RECTANGULAR, SPECTRAL_BUS_F32, NULL) == NULL);
+    assert(spectral_bus_bound(capture, TEST_FFT, TEST_HOP, WINDOW_HANN, SPECTRAL_BUS_F32, NULL) == NULL);
+    assert(spectral_bus_bound(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, SPECTRAL_BUS_F64, NULL) == NULL);
+
+    // Bindings are per thread
+    pthread_t thread;
+    void *other;
+    assert(pthread_create(&thread, NULL, other_thread_bound, capture) == 0);
+    pthread_join(thread, &other);
+    assert(other == NULL);
+
+    spectral_bus_bind(NULL, 0);
+    assert(spectral_bus_bound(capture, TEST_FFT, TEST_HOP, WINDOW_RECTANGULAR, SPECTRAL_BUS_F32, NULL) == NULL);
+    spectral_bus_destroy(bus);
+    free_capture();
+
+    printf("✓ Binding tests passed\n");
+}
+
+// Main test runner
+int main(void) {
+    printf("Running Spectral Frame Bus Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_bus_rows(WINDOW_RECTANGULAR);
+    test_bus_rows(WINDOW_HANN);
+    test_bus_detach();
+    test_bus_binding();
+
+    printf("\n=====================================\n");
+    printf("All spectral bus tests passed! ✓\n");
+    printf("=====================================\n");
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * IQ Lab - Spectrum Engine Unit Tests
+ *
+ * Tests for the background spectrum engine behind the UI: a request must
+ * come back as a frame with the tone in the right column, positions past
+ * the end must clamp so the span fits, a burst of requests must settle on
+ * the newest one, and polling must report fresh frames exactly once.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // nanosleep under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include "../../src/ui/spectrum_engine.h"
+
+#define TEST_FILE "test_spectrum_engine.s16"
+#define TEST_SAMPLES 262144
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static atomic_uint notifications;
+
+static void count_notify(void *user) {
+    (void)user;
+    atomic_fetch_add(&notifications, 1);
+}
+
+// Tone at +fs/4 in the first half of the file and at -fs/4 in the second
+static void write_test_file(void) {
+    FILE *f = fopen(TEST_FILE, "wb");
+    assert(f);
+    for (uint32_t i = 0; i < TEST_SAMPLES; i++) {
+        double sign = i < TEST_SAMPLES / 2 ? 1.0 : -1.0;
+        double phase = sign * 0.5 * M_PI * (double)i;
+        int16_t iq[2] = { (int16_t)lrint(12000.0 * cos(phase)), (int16_t)lrint(12000.0 * sin(phase)) };
+        assert(fwrite(iq, sizeof(iq), 1, f) == 1);
+    }
+    fclose(f);
+}
+
+// Poll until the frame for 'request' arrives (the engine runs on its own thread)
+static const spectrum_frame_t *wait_for(spectrum_engine_t *engine, uint64_t request) {
+    const struct timespec pause = { 0, 1000000 };
+    for (int i = 0; i < 10000; i++) {
+        bool fresh;
+        const spectrum_frame_t *frame = spectrum_engine_poll(engine, &fresh);
+        if (frame && frame->request == request) return frame;
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+static uint32_t peak_column(const spectrum_frame_t *frame) {
+    uint32_t best = 0;
+    for (uint32_t c = 1; c < frame->columns; c++) {
+        if (frame->level[c] > frame->level[best]) best = c;
+    }
+    return best;
+}
+
+static void test_requests(void) {
+    printf("Testing spectrum requests...\n");
+
+    spectrum_engine_params_t params;
+    spectrum_engine_default_params(&params);
+    params.fft_size = 1024;
+    params.hop = 256;
+    params.avg_frames = 8;
+    params.columns = 256;
+    params.num_threads = 2;
+    spectrum_engine_t *engine = spectrum_engine_create(TEST_FILE, &params, count_notify, NULL);
+    assert(engine);
+    assert(spectrum_engine_total_samples(engine) == TEST_SAMPLES);
+    assert(spectrum_engine_span(engine) == 7 * 256 + 1024);
+
+    // Nothing computed yet: an empty frame
+    bool fresh = true;
+    const spectrum_frame_t *frame = spectrum_engine_poll(engine, &fresh);
+    assert(frame && !fresh && frame->request == 0);
+
+    // Start of the file: +fs/4 sits three quarters of the way up
+    uint64_t request = spectrum_engine_request(engine, 0);
+    frame = wait_for(engine, request);
+    assert(frame && frame->start_sample == 0 && frame->frames == 8 && frame->columns == 256);
+    assert(peak_column(frame) == 192);
+    assert(frame->level[192] == 1.0f && frame->max_db > frame->min_db);
+    spectrum_engine_poll(engine, &fresh);
+    assert(!fresh);
+
+    // Past the end: clamped so the whole span is read, tone at -fs/4
+    request = spectrum_engine_request(engine, 10 * (uint64_t)TEST_SAMPLES);
+    frame = wait_for(engine, request);
+    assert(frame && frame->start_sample == TEST_SAMPLES - spectrum_engine_span(engine));
+    assert(frame->frames == 8 && peak_column(frame) == 64);
+
+    // A burst of requests settles on the newest one (past the tone switch)
+    for (int i = 0; i < 200; i++) {
+        request = spectrum_engine_request(engine, (uint64_t)i * 997);
+    }
+    frame = wait_for(engine, request);
+    assert(frame && frame->start_sample == 199 * 997u && peak_column(frame) == 64);
+    assert(atomic_load(&notifications) <= 2 + 200);
+
+    spectrum_engine_destroy(engine);
+    printf("✓ Spectrum request test passed (%u frames published)\n", atomic_load(&notifications));
+}
+
+static void test_errors(void) {
+    printf("Testing error handling...\n");
+
+    spectrum_engine_params_t params;
+    spectrum_engine_default_params(&params);
+    assert(!spectrum_engine_create("nonexistent_file.s16", &params, NULL, NULL));
+    params.fft_size = 1000;
+    assert(!spectrum_engine_create(TEST_FILE, &params, NULL, NULL));
+    spectrum_engine_default_params(&params);
+    params.window = "no-such-window";
+    assert(!spectrum_engine_create(TEST_FILE, &params, NULL, NULL));
+
+    // File shorter than the span: fewer frames, still a frame
+    spectrum_engine_default_params(&params);
+    params.fft_size = 65536;
+    params.hop = 65536;
+    params.avg_frames = 20;
+    spectrum_engine_t *engine = spectrum_engine_create(TEST_FILE, &params, NULL, NULL);
+    assert(engine);
+    const spectrum_frame_t *frame = wait_for(engine, spectrum_engine_request(engine, 5000));
+    assert(frame && frame->start_sample == 0 && frame->frames == TEST_SAMPLES / 65536);
+    spectrum_engine_destroy(engine);
+
+    bool fresh = true;
+    assert(spectrum_engine_poll(NULL, &fresh) == NULL && !fresh);
+    spectrum_engine_destroy(NULL);
+
+    printf("✓ Error handling test passed\n");
+}
+
+int main(void) {
+    printf("=== Spectrum Engine Unit Tests ===\n\n");
+
+    atomic_init(&notifications, 0);
+    write_test_file();
+    test_requests();
+    test_errors();
+    remove(TEST_FILE);
+
+    printf("\n✓ All spectrum engine tests passed!\n");
+    return 0;
+}
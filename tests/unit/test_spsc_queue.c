@@ -0,0 +1,177 @@
+/*
+ * IQ Lab - SPSC Queue Unit Tests
+ *
+ * Tests for the lock-free single-producer / single-consumer queue
+ * Covers capacity rounding, full and empty edges, FIFO order across index
+ * wrap-around, NULL items, and an ordered hand-off between two threads
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../../src/iq_core/spsc_queue.h"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { THREAD_ITEMS = 1000000 };
+
+// Items are small integers stored in the pointer, offset so none is NULL
+static void *item_for(uintptr_t value) { return (void *)(value + 1); }
+static uintptr_t value_of(void *item) { return (uintptr_t)item - 1; }
+
+// Capacity rounding and the full/empty edges
+void test_spsc_edges() {
+    TEST_START("Capacity and Full/Empty Edges");
+
+    bool ok = true;
+    iq_spsc_t queue;
+    void *item = NULL;
+
+    if (iq_spsc_init(&queue, 0)) ok = false;
+    if (!iq_spsc_init(&queue, 5)) {
+        TEST_FAIL("Init failed");
+        TEST_END();
+        return;
+    }
+    if (queue.capacity != 8) ok = false;
+
+    if (iq_spsc_try_pop(&queue, &item)) ok = false;
+    for (uintptr_t i = 0; i < 8; i++) {
+        if (!iq_spsc_try_push(&queue, item_for(i))) ok = false;
+    }
+    if (iq_spsc_try_push(&queue, item_for(8))) ok = false;
+    if (iq_spsc_size(&queue) != 8) ok = false;
+
+    // NULL is an ordinary item once there is room
+    if (!iq_spsc_try_pop(&queue, &item) || value_of(item) != 0) ok = false;
+    if (!iq_spsc_try_push(&queue, NULL)) ok = false;
+    for (uintptr_t i = 1; i < 8; i++) {
+        if (!iq_spsc_try_pop(&queue, &item) || value_of(item) != i) ok = false;
+    }
+    if (!iq_spsc_try_pop(&queue, &item) || item != NULL) ok = false;
+    if (iq_spsc_try_pop(&queue, &item)) ok = false;
+
+    iq_spsc_free(&queue);
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Rounded to 8 slots, full and empty reported\n");
+    } else {
+        TEST_FAIL("Edge conditions handled incorrectly");
+    }
+    TEST_END();
+}
+
+// FIFO order while the indices run many times around the ring
+void test_spsc_wraparound() {
+    TEST_START("FIFO Order Across Wrap-Around");
+
+    bool ok = true;
+    iq_spsc_t queue;
+    if (!iq_spsc_init(&queue, 4)) {
+        TEST_FAIL("Init failed");
+        TEST_END();
+        return;
+    }
+
+    uintptr_t pushed = 0, popped = 0;
+    for (uint32_t round = 0; round < 1000 && ok; round++) {
+        uint32_t burst = 1 + round % 4;
+        for (uint32_t i = 0; i < burst; i++) {
+            if (!iq_spsc_try_push(&queue, item_for(pushed++))) ok = false;
+        }
+        while (iq_spsc_size(&queue) > (round % 2)) {
+            void *item = iq_spsc_pop(&queue);
+            if (value_of(item) != popped++) ok = false;
+        }
+    }
+    while (iq_spsc_size(&queue) > 0) {
+        if (value_of(iq_spsc_pop(&queue)) != popped++) ok = false;
+    }
+    if (popped != pushed) ok = false;
+
+    iq_spsc_free(&queue);
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %lu items in order through 4 slots\n", (unsigned long)pushed);
+    } else {
+        TEST_FAIL("Items lost or reordered");
+    }
+    TEST_END();
+}
+
+static void *producer_thread(void *arg) {
+    iq_spsc_t *queue = arg;
+    for (uintptr_t i = 0; i < THREAD_ITEMS; i++) {
+        iq_spsc_push(queue, item_for(i));
+    }
+    iq_spsc_push(queue, NULL);  // End of stream
+    return NULL;
+}
+
+// Ordered hand-off between two threads through a small ring
+void test_spsc_threads() {
+    TEST_START("Two-Thread Hand-Off");
+
+    bool ok = true;
+    iq_spsc_t queue;
+    pthread_t producer;
+    if (!iq_spsc_init(&queue, 16) ||
+        pthread_create(&producer, NULL, producer_thread, &queue) != 0) {
+        TEST_FAIL("Setup failed");
+        TEST_END();
+        return;
+    }
+
+    uintptr_t expected = 0;
+    for (;;) {
+        void *item = iq_spsc_pop(&queue);
+        if (!item) break;
+        if (value_of(item) != expected) ok = false;
+        expected++;
+    }
+    pthread_join(producer, NULL);
+    if (expected != THREAD_ITEMS) ok = false;
+
+    iq_spsc_free(&queue);
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ %d items received in order\n", THREAD_ITEMS);
+    } else {
+        TEST_FAIL("Items lost or reordered between threads");
+    }
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - SPSC Queue Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_spsc_edges();
+    test_spsc_wraparound();
+    test_spsc_threads();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
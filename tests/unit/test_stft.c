@@ -0,0 +1,192 @@
+/*
+ * IQ Lab - Parallel STFT Unit Tests
+ *
+ * Tests for the STFT worker pool
+ * Rows and averaged spectra must match the serial fft_spectral_frame loop
+ * bit for bit for any thread count, window and batch size
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../../src/iq_core/stft.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+enum { FFT_SIZE = 256, HOP = 96, NUM_FRAMES = 37 };   // Radix-4: exercises the batched path
+
+// Two tones plus a deterministic pseudo-random floor
+static float *make_signal(size_t num_samples) {
+    float *iq = malloc(num_samples * 2 * sizeof(float));
+    if (!iq) return NULL;
+
+    uint32_t state = 12345;
+    for (size_t i = 0; i < num_samples; i++) {
+        state = state * 1664525u + 1013904223u;
+        float noise = ((float)(state >> 8) / 16777216.0f - 0.5f) * 0.01f;
+        double t = (double)i;
+        iq[i * 2] = (float)(0.5 * cos(0.31 * t) + 0.2 * cos(-1.7 * t)) + noise;
+        iq[i * 2 + 1] = (float)(0.5 * sin(0.31 * t) + 0.2 * sin(-1.7 * t)) - noise;
+    }
+    return iq;
+}
+
+// Window taps for the windowed case
+static void make_hann(float *taps, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        taps[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / (n - 1)));
+    }
+}
+
+// Rows for every thread count equal the serial frame loop
+void test_stft_rows() {
+    TEST_START("Parallel Rows Match Serial");
+
+    size_t num_samples = (size_t)(NUM_FRAMES - 1) * HOP + FFT_SIZE;
+    float *iq = make_signal(num_samples);
+    float taps[FFT_SIZE];
+    make_hann(taps, FFT_SIZE);
+    float *expected = malloc((size_t)NUM_FRAMES * FFT_SIZE * sizeof(float));
+    float *rows = malloc((size_t)NUM_FRAMES * FFT_SIZE * sizeof(float));
+    fft_plan_f32_t *plan = fft_plan_f32_create(FFT_SIZE, FFT_FORWARD);
+
+    bool ok = iq && expected && rows && plan;
+    const uint32_t thread_counts[] = {1, 2, 5, 8};
+    for (int w = 0; ok && w < 2; w++) {
+        const float *window = w ? taps : NULL;
+        for (int db = 0; ok && db < 2; db++) {
+            for (uint32_t f = 0; f < NUM_FRAMES; f++) {
+                if (!fft_spectral_frame(plan, iq + (size_t)f * HOP * 2, window,
+                                        expected + (size_t)f * FFT_SIZE, db)) ok = false;
+            }
+            for (size_t t = 0; ok && t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+                stft_t *stft = stft_create(plan, window, thread_counts[t]);
+                memset(rows, 0, (size_t)NUM_FRAMES * FFT_SIZE * sizeof(float));
+                if (!stft || !stft_rows(stft, iq, NUM_FRAMES, HOP, rows, db) ||
+                    memcmp(rows, expected, (size_t)NUM_FRAMES * FFT_SIZE * sizeof(float)) != 0) ok = false;
+                // Fewer frames than threads leaves some workers idle
+                if (ok && (!stft_rows(stft, iq, 3, HOP, rows, db) ||
+                           memcmp(rows, expected, 3 * FFT_SIZE * sizeof(float)) != 0)) ok = false;
+                stft_destroy(stft);
+            }
+        }
+    }
+
+    fft_plan_f32_destroy(plan);
+    free(iq); free(expected); free(rows);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Rows bit-identical for 1, 2, 5 and 8 threads\n");
+    } else {
+        TEST_FAIL("Parallel rows differ from the serial loop");
+    }
+
+    TEST_END();
+}
+
+// Accumulated averages equal frame-by-frame serial summation
+void test_stft_accumulate() {
+    TEST_START("Deterministic Accumulation");
+
+    size_t num_samples = (size_t)(NUM_FRAMES - 1) * HOP + FFT_SIZE;
+    float *iq = make_signal(num_samples);
+    float *row = malloc(FFT_SIZE * sizeof(float));
+    float *rows = malloc((size_t)NUM_FRAMES * FFT_SIZE * sizeof(float));
+    double *expected = calloc(FFT_SIZE, sizeof(double));
+    double *accum = calloc(FFT_SIZE, sizeof(double));
+    fft_plan_f32_t *plan = fft_plan_f32_create(FFT_SIZE, FFT_FORWARD);
+
+    bool ok = iq && row && rows && expected && accum && plan;
+    for (uint32_t f = 0; ok && f < NUM_FRAMES; f++) {
+        if (!fft_spectral_frame(plan, iq + (size_t)f * HOP * 2, NULL, row, false)) ok = false;
+        for (uint32_t k = 0; k < FFT_SIZE; k++) expected[k] += row[k];
+    }
+
+    const uint32_t thread_counts[] = {1, 3, 7};
+    for (size_t t = 0; ok && t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        stft_t *stft = stft_create(plan, NULL, thread_counts[t]);
+        memset(accum, 0, FFT_SIZE * sizeof(double));
+        // Uneven batches, as when the last batch of a file is short
+        uint32_t done = 0;
+        const uint32_t batches[] = {16, 4, 17};
+        for (int b = 0; ok && b < 3; b++) {
+            if (!stft || !stft_accumulate(stft, iq + (size_t)done * HOP * 2, batches[b], HOP, rows, accum)) ok = false;
+            done += batches[b];
+        }
+        if (ok && memcmp(accum, expected, FFT_SIZE * sizeof(double)) != 0) ok = false;
+        stft_destroy(stft);
+    }
+
+    fft_plan_f32_destroy(plan);
+    free(iq); free(row); free(rows); free(expected); free(accum);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Sums bit-identical across thread counts and batch splits\n");
+    } else {
+        TEST_FAIL("Accumulated spectrum depends on the thread count");
+    }
+
+    TEST_END();
+}
+
+// Error conditions
+void test_stft_errors() {
+    TEST_START("Error Conditions");
+
+    bool ok = true;
+    float dummy[4] = {0};
+    if (stft_create(NULL, NULL, 2) != NULL) ok = false;
+    if (stft_rows(NULL, dummy, 1, 1, dummy, false)) ok = false;
+    if (stft_accumulate(NULL, dummy, 1, 1, dummy, NULL)) ok = false;
+    if (stft_default_threads() < 1 || stft_default_threads() > STFT_MAX_THREADS) ok = false;
+    stft_destroy(NULL);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ NULL arguments rejected\n");
+    } else {
+        TEST_FAIL("Error conditions not handled");
+    }
+
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Parallel STFT Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_stft_rows();
+    test_stft_accumulate();
+    test_stft_errors();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,244 @@
+/*
+ * IQ Lab - Tile Pyramid Unit Tests
+ *
+ * Tests for the tiled multi-resolution power pyramid
+ * Level 0 must round-trip exactly; coarser levels must hold the 2x2 max or
+ * mean of the level below, including odd edges and partial tiles
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../src/viz/tile_pyramid.h"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Test helper macros
+#define TEST_START(name) \
+    printf("Running: %s\n", name); \
+    tests_run++;
+
+#define TEST_PASS() \
+    printf("  ✅ PASSED\n"); \
+    tests_passed++;
+
+#define TEST_FAIL(msg) \
+    printf("  ❌ FAILED: %s\n", msg);
+
+#define TEST_END() \
+    printf("\n");
+
+// Odd sizes: partial tiles and unpaired rows/columns at every level
+enum { WIDTH = 37, ROWS = 29, TILE = 8 };
+
+static const char *TEST_PATH = "test_tile_pyramid.iqpyr";
+
+// Deterministic, non-monotonic cell values
+static float cell_value(uint64_t row, uint32_t col) {
+    return (float)((row * 7919u + col * 104729u) % 1000u) + 0.25f;
+}
+
+// Build every level in memory the slow way for comparison
+static float *reference_level(uint32_t level, uint32_t pool, uint32_t *width, uint32_t *rows) {
+    uint32_t w = WIDTH, h = ROWS;
+    float *map = malloc((size_t)w * h * sizeof(float));
+    if (!map) return NULL;
+    for (uint32_t r = 0; r < h; r++) {
+        for (uint32_t c = 0; c < w; c++) map[(size_t)r * w + c] = cell_value(r, c);
+    }
+
+    for (uint32_t l = 0; l < level; l++) {
+        uint32_t nw = (w + 1) / 2, nh = (h + 1) / 2;
+        float *next = malloc((size_t)nw * nh * sizeof(float));
+        if (!next) { free(map); return NULL; }
+        for (uint32_t r = 0; r < nh; r++) {
+            for (uint32_t c = 0; c < nw; c++) {
+                // Same pairing order as the writer: columns first, then rows
+                float v[2];
+                for (uint32_t dr = 0; dr < 2; dr++) {
+                    uint32_t sr = 2 * r + dr < h ? 2 * r + dr : 2 * r;
+                    const float *src = map + (size_t)sr * w;
+                    float a = src[2 * c];
+                    float b = 2 * c + 1 < w ? src[2 * c + 1] : a;
+                    v[dr] = pool == TILE_POOL_MEAN ? 0.5f * (a + b) : (a > b ? a : b);
+                }
+                float out;
+                if (2 * r + 1 >= h) out = v[0];
+                else out = pool == TILE_POOL_MEAN ? 0.5f * (v[0] + v[1]) : (v[0] > v[1] ? v[0] : v[1]);
+                next[(size_t)r * nw + c] = out;
+            }
+        }
+        free(map);
+        map = next;
+        w = nw;
+        h = nh;
+    }
+
+    *width = w;
+    *rows = h;
+    return map;
+}
+
+// 'reserve' sizes the index up front; it must then never grow
+static bool write_pyramid(uint32_t pool, bool reserve) {
+    tile_pyramid_info_t info = {0};
+    info.tile_size = TILE;
+    info.num_levels = tile_pyramid_levels_for(WIDTH, ROWS, TILE);
+    info.width = WIDTH;
+    info.pool = pool;
+    info.sample_rate = 1000.0;
+    info.row_seconds = 0.5;
+    info.freq_step_hz = 1000.0 / WIDTH;
+
+    tile_pyramid_writer_t writer;
+    if (!tile_pyramid_writer_open(&writer, TEST_PATH, &info)) return false;
+    bool ok = !reserve || tile_pyramid_writer_reserve(&writer, ROWS);
+    const tile_index_entry_t *index = writer.index;
+    float row[WIDTH];
+    for (uint32_t r = 0; r < ROWS; r++) {
+        for (uint32_t c = 0; c < WIDTH; c++) row[c] = cell_value(r, c);
+        if (!tile_pyramid_writer_push(&writer, row)) ok = false;
+    }
+    if (reserve && (writer.index != index || writer.num_tiles > writer.index_capacity)) ok = false;
+    return tile_pyramid_writer_close(&writer) && ok;
+}
+
+// Reassemble every level from tiles and compare with the reference
+static bool check_pyramid(uint32_t pool) {
+    tile_pyramid_reader_t reader;
+    if (!tile_pyramid_reader_open(&reader, TEST_PATH)) return false;
+
+    bool ok = reader.info.num_rows == ROWS && reader.info.width == WIDTH &&
+              reader.info.pool == pool && reader.info.row_seconds == 0.5;
+    float cells[TILE * TILE];
+    for (uint32_t l = 0; ok && l < reader.info.num_levels; l++) {
+        uint32_t w, h;
+        float *expected = reference_level(l, pool, &w, &h);
+        if (!expected || reader.level_width[l] != w || reader.level_rows[l] != h) ok = false;
+
+        for (uint64_t tr = 0; ok && tr < reader.tile_rows[l]; tr++) {
+            for (uint32_t tc = 0; ok && tc < reader.tile_cols[l]; tc++) {
+                uint32_t rows, cols;
+                if (!tile_pyramid_read_tile(&reader, l, tr, tc, cells, &rows, &cols)) { ok = false; break; }
+                uint32_t want_rows = h - tr * TILE < TILE ? h - (uint32_t)tr * TILE : TILE;
+                uint32_t want_cols = w - tc * TILE < TILE ? w - tc * TILE : TILE;
+                if (rows != want_rows || cols != want_cols) { ok = false; break; }
+                for (uint32_t r = 0; ok && r < rows; r++) {
+                    for (uint32_t c = 0; c < cols; c++) {
+                        float e = expected[(tr * TILE + r) * w + tc * TILE + c];
+                        if (cells[r * cols + c] != e) { ok = false; break; }
+                    }
+                }
+            }
+        }
+        free(expected);
+    }
+
+    // The top level is a single tile
+    uint32_t top = reader.info.num_levels - 1;
+    if (ok && (reader.tile_rows[top] != 1 || reader.tile_cols[top] != 1)) ok = false;
+
+    tile_pyramid_reader_close(&reader);
+    return ok;
+}
+
+// Max-hold pyramid round trip
+void test_pyramid_max() {
+    TEST_START("Max Pyramid Round Trip");
+
+    bool ok = write_pyramid(TILE_POOL_MAX, false) && check_pyramid(TILE_POOL_MAX);
+    remove(TEST_PATH);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ All levels match 2x2 max pooling, edge tiles sized correctly\n");
+    } else {
+        TEST_FAIL("Max pyramid differs from the reference");
+    }
+
+    TEST_END();
+}
+
+// Mean pyramid round trip
+void test_pyramid_mean() {
+    TEST_START("Mean Pyramid Round Trip");
+
+    bool ok = write_pyramid(TILE_POOL_MEAN, true) && check_pyramid(TILE_POOL_MEAN);
+    remove(TEST_PATH);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ All levels match 2x2 mean pooling, reserved index never grew\n");
+    } else {
+        TEST_FAIL("Mean pyramid differs from the reference");
+    }
+
+    TEST_END();
+}
+
+// Level counts and error conditions
+void test_pyramid_errors() {
+    TEST_START("Geometry and Error Conditions");
+
+    bool ok = true;
+    if (tile_pyramid_levels_for(256, 256, 256) != 1) ok = false;
+    if (tile_pyramid_levels_for(257, 10, 256) != 2) ok = false;
+    if (tile_pyramid_levels_for(4096, 1000000, 256) != 13) ok = false;
+    if (tile_pyramid_levels_for(1u << 30, 1ull << 40, 1) != TILE_PYRAMID_MAX_LEVELS) ok = false;
+
+    tile_pyramid_writer_t writer;
+    tile_pyramid_info_t info = {0};
+    info.tile_size = TILE;
+    info.num_levels = 1;
+    if (tile_pyramid_writer_open(&writer, TEST_PATH, &info)) ok = false;   // zero width
+    info.width = WIDTH;
+    info.num_levels = TILE_PYRAMID_MAX_LEVELS + 1;
+    if (tile_pyramid_writer_open(&writer, TEST_PATH, &info)) ok = false;
+
+    // Not a pyramid file
+    FILE *f = fopen(TEST_PATH, "wb");
+    if (f) { fputs("not a pyramid", f); fclose(f); }
+    tile_pyramid_reader_t reader;
+    if (tile_pyramid_reader_open(&reader, TEST_PATH)) ok = false;
+    remove(TEST_PATH);
+
+    // Out-of-range tile requests
+    if (!write_pyramid(TILE_POOL_MAX, false) || !tile_pyramid_reader_open(&reader, TEST_PATH)) {
+        ok = false;
+    } else {
+        float cells[TILE * TILE];
+        uint32_t rows, cols;
+        if (tile_pyramid_read_tile(&reader, reader.info.num_levels, 0, 0, cells, &rows, &cols)) ok = false;
+        if (tile_pyramid_read_tile(&reader, 0, reader.tile_rows[0], 0, cells, &rows, &cols)) ok = false;
+        if (tile_pyramid_read_tile(&reader, 0, 0, reader.tile_cols[0], cells, &rows, &cols)) ok = false;
+        tile_pyramid_reader_close(&reader);
+    }
+    remove(TEST_PATH);
+
+    if (ok) {
+        TEST_PASS();
+        printf("    ✅ Level counts correct, bad geometry and files rejected\n");
+    } else {
+        TEST_FAIL("Error conditions not handled");
+    }
+
+    TEST_END();
+}
+
+int main(void) {
+    printf("=====================================\n");
+    printf("IQ Lab - Tile Pyramid Unit Tests\n");
+    printf("=====================================\n\n");
+
+    test_pyramid_max();
+    test_pyramid_mean();
+    test_pyramid_errors();
+
+    printf("=====================================\n");
+    printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
+    printf("=====================================\n");
+
+    return tests_passed == tests_run ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,378 @@
+/*
+ * IQ Lab - Waterfall Tile View Unit Tests
+ *
+ * Tests for the viewport-driven tile cache behind the UI waterfall: computed
+ * tiles must match the STFT rows and their pooled levels, tiles read from a
+ * pyramid of the same rows must match the computed ones, the cache must
+ * stay inside its budget, and switching viewports must drop work that is no
+ * longer visible.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // nanosleep under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../../src/ui/tile_view.h"
+#include "../../src/iq_core/io_iq.h"
+#include "../../src/iq_core/fft.h"
+#include "../../src/iq_core/stft.h"
+#include "../../src/iq_core/window.h"
+
+#define TEST_FILE "test_tile_view.s16"
+#define TEST_PYRAMID "test_tile_view.iqpyr"
+
+// 200 frames of 64 bins in 16-cell tiles: partial tiles at every level
+enum { FFT = 64, HOP = 32, ROWS = 200, TILE = 16 };
+#define TEST_SAMPLES ((ROWS - 1) * HOP + FFT)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static float *reference;   // ROWS x FFT linear power rows, as iqls computes them
+
+// Chirp plus pseudo-random noise so neighbouring cells differ
+static void write_test_file(void) {
+    FILE *f = fopen(TEST_FILE, "wb");
+    assert(f);
+    uint32_t noise = 12345;
+    for (uint32_t i = 0; i < TEST_SAMPLES; i++) {
+        double phase = M_PI * (double)i * (double)i / TEST_SAMPLES;
+        noise = noise * 1664525u + 1013904223u;
+        double n = ((double)(noise >> 16) / 65536.0 - 0.5) * 2000.0;
+        int16_t iq[2] = { (int16_t)lrint(9000.0 * cos(phase) + n), (int16_t)lrint(9000.0 * sin(phase) - n) };
+        assert(fwrite(iq, sizeof(iq), 1, f) == 1);
+    }
+    fclose(f);
+}
+
+static void compute_reference(void) {
+    iq_data_t data;
+    assert(iq_load_file(TEST_FILE, &data) && data.num_samples == TEST_SAMPLES);
+    fft_plan_f32_t *plan = fft_plan_f32_create(FFT, FFT_FORWARD);
+    const window_t *window = window_acquire(WINDOW_HANN, FFT, 0.0);
+    stft_t *stft = stft_create(plan, window->coefficients_f32, 1);
+    reference = malloc((size_t)ROWS * FFT * sizeof(float));
+    assert(plan && stft && reference);
+    assert(stft_rows(stft, data.data, ROWS, HOP, reference, false));
+    stft_destroy(stft);
+    window_release(window);
+    fft_plan_f32_destroy(plan);
+    iq_free(&data);
+}
+
+static void base_params(tile_view_params_t *params) {
+    tile_view_default_params(params);
+    params->fft_size = FFT;
+    params->hop = HOP;
+    params->tile_size = TILE;
+    params->max_frames_per_row = 64;
+    params->num_workers = 2;
+}
+
+static void wait_idle(tile_view_t *view) {
+    const struct timespec pause = { 0, 1000000 };
+    for (int i = 0; i < 10000 && !tile_view_idle(view); i++) nanosleep(&pause, NULL);
+    assert(tile_view_idle(view));
+}
+
+// Whole map on 'width' x 'height' pixels, rendered once everything is in
+static float *render_all(tile_view_t *view, uint32_t width, uint32_t height) {
+    const tile_viewport_t vp = { 0.0, ROWS, 0.0, FFT, width, height };
+    float *pixels = malloc((size_t)width * height * sizeof(float));
+    assert(pixels);
+    tile_view_set_viewport(view, &vp);
+    wait_idle(view);
+    assert(tile_view_render(view, &vp, pixels) == 0);
+    return pixels;
+}
+
+// Max of the level-0 block under cell (row, col) of 'level'
+static float pooled(uint32_t level, uint32_t row, uint32_t col) {
+    float v = 0.0f;
+    for (uint32_t r = row << level; r < ((row + 1) << level) && r < ROWS; r++) {
+        for (uint32_t c = col << level; c < ((col + 1) << level) && c < FFT; c++) {
+            if (reference[(size_t)r * FFT + c] > v) v = reference[(size_t)r * FFT + c];
+        }
+    }
+    return v;
+}
+
+static void test_computed_levels(void) {
+    printf("Testing computed tiles...\n");
+
+    tile_view_params_t params;
+    base_params(&params);
+    tile_view_t *view = tile_view_create(TEST_FILE, &params, NULL, NULL);
+    assert(view && !tile_view_uses_pyramid(view));
+    const tile_pyramid_info_t *info = tile_view_info(view);
+    assert(info->width == FFT && info->num_rows == ROWS && info->tile_size == TILE);
+    assert(info->num_levels == tile_pyramid_levels_for(FFT, ROWS, TILE));
+
+    // One pixel per cell: level 0 is the STFT
+    float *pixels = render_all(view, FFT, ROWS);
+    for (size_t i = 0; i < (size_t)ROWS * FFT; i++) assert(pixels[i] == reference[i]);
+    free(pixels);
+
+    // Half the pixels each way: the 2x2 max
+    tile_viewport_t vp = { 0.0, ROWS, 0.0, FFT, FFT / 2, ROWS / 2 };
+    assert(tile_view_level_for(view, &vp) == 1);
+    pixels = render_all(view, FFT / 2, ROWS / 2);
+    for (uint32_t y = 0; y < ROWS / 2; y++) {
+        for (uint32_t x = 0; x < FFT / 2; x++) assert(pixels[(size_t)y * (FFT / 2) + x] == pooled(1, y, x));
+    }
+    free(pixels);
+
+    tile_view_stats_t stats;
+    tile_view_get_stats(view, &stats);
+    const uint64_t level0 = 4 * 13, level1 = 2 * 7;
+    assert(stats.computed_tiles == level0 + level1 && stats.pyramid_tiles == 0);
+    assert(stats.cached_tiles == level0 + level1 && stats.evicted_tiles == 0);
+
+    // Cached: a second pass computes nothing
+    pixels = render_all(view, FFT, ROWS);
+    free(pixels);
+    tile_view_get_stats(view, &stats);
+    assert(stats.computed_tiles == level0 + level1);
+
+    // Outside the map: nothing visible, all NAN
+    vp = (tile_viewport_t){ ROWS + 10.0, 50.0, 0.0, FFT, 8, 8 };
+    float outside[64];
+    assert(tile_view_set_viewport(view, &vp) == 0);
+    assert(tile_view_render(view, &vp, outside) == 0);
+    for (int i = 0; i < 64; i++) assert(isnan(outside[i]));
+
+    tile_view_destroy(view);
+    printf("✓ Computed tile test passed\n");
+}
+
+static void test_frame_sampling(void) {
+    printf("Testing coarse-level frame sampling...\n");
+
+    // One frame per level-2 row: row y pools only frame 4y
+    tile_view_params_t params;
+    base_params(&params);
+    params.max_frames_per_row = 1;
+    tile_view_t *view = tile_view_create(TEST_FILE, &params, NULL, NULL);
+    assert(view);
+    const uint32_t w = FFT / 4, h = ROWS / 4;
+    float *pixels = render_all(view, w, h);
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            float v = 0.0f;
+            for (uint32_t c = 4 * x; c < 4 * x + 4; c++) {
+                if (reference[(size_t)(4 * y) * FFT + c] > v) v = reference[(size_t)(4 * y) * FFT + c];
+            }
+            assert(pixels[(size_t)y * w + x] == v);
+        }
+    }
+    free(pixels);
+    tile_view_destroy(view);
+    printf("✓ Frame sampling test passed\n");
+}
+
+static void test_pyramid_tiles(void) {
+    printf("Testing pyramid tiles...\n");
+
+    tile_pyramid_info_t info = { 0 };
+    info.tile_size = TILE;
+    info.num_levels = tile_pyramid_levels_for(FFT, ROWS, TILE);
+    info.width = FFT;
+    info.pool = TILE_POOL_MAX;
+    info.sample_rate = 1e6;
+    info.row_seconds = HOP / 1e6;
+    tile_pyramid_writer_t writer;
+    assert(tile_pyramid_writer_open(&writer, TEST_PYRAMID, &info));
+    for (uint32_t r = 0; r < ROWS; r++) assert(tile_pyramid_writer_push(&writer, reference + (size_t)r * FFT));
+    assert(tile_pyramid_writer_close(&writer));
+
+    // The pyramid's geometry wins over the parameters
+    tile_view_params_t params;
+    base_params(&params);
+    params.fft_size = 1024;
+    params.tile_size = 64;
+    params.pyramid_path = TEST_PYRAMID;
+    tile_view_t *view = tile_view_create(TEST_FILE, &params, NULL, NULL);
+    assert(view && tile_view_uses_pyramid(view));
+    assert(tile_view_info(view)->width == FFT && tile_view_info(view)->tile_size == TILE);
+    assert(tile_view_info(view)->num_rows == ROWS);
+
+    float *pixels = render_all(view, FFT, ROWS);
+    for (size_t i = 0; i < (size_t)ROWS * FFT; i++) assert(pixels[i] == reference[i]);
+    free(pixels);
+    pixels = render_all(view, FFT / 4, ROWS / 4);
+    for (uint32_t y = 0; y < ROWS / 4; y++) {
+        for (uint32_t x = 0; x < FFT / 4; x++) assert(pixels[(size_t)y * (FFT / 4) + x] == pooled(2, y, x));
+    }
+    free(pixels);
+
+    tile_view_stats_t stats;
+    tile_view_get_stats(view, &stats);
+    assert(stats.pyramid_tiles == 4 * 13 + 1 * 4 && stats.computed_tiles == 0);
+    tile_view_destroy(view);
+
+    // An unreadable pyramid falls back to computing
+    params.pyramid_path = "nonexistent_pyramid.iqpyr";
+    params.fft_size = FFT;
+    params.tile_size = TILE;
+    view = tile_view_create(TEST_FILE, &params, NULL, NULL);
+    assert(view && !tile_view_uses_pyramid(view));
+    tile_view_destroy(view);
+
+    remove(TEST_PYRAMID);
+    printf("✓ Pyramid tile test passed\n");
+}
+
+static void test_eviction(void) {
+    printf("Testing LRU eviction...\n");
+
+    // Room for about five full tiles; the whole level-0 map needs 52
+    tile_view_params_t params;
+    base_params(&params);
+    params.cache_bytes = 5 * (TILE * TILE * sizeof(float) + 128);
+    tile_view_t *view = tile_view_create(TEST_FILE, &params, NULL, NULL);
+    assert(view);
+
+    // One tile row at a time, so every strip fits inside the budget
+    float pixels[TILE * FFT];
+    for (uint32_t r = 0; r < 13; r++) {
+        const tile_viewport_t vp = { (double)r * TILE, TILE, 0.0, FFT, FFT, TILE };
+        tile_view_set_viewport(view, &vp);
+        wait_idle(view);
+        assert(tile_view_render(view, &vp, pixels) == 0);
+        const uint32_t rows = r == 12 ? ROWS - 12 * TILE : TILE;
+        for (uint32_t y = 0; y < rows; y++) {
+            for (uint32_t x = 0; x < FFT; x++) {
+                assert(pixels[y * FFT + x] == reference[(size_t)(r * TILE + y) * FFT + x]);
+            }
+        }
+    }
+
+    tile_view_stats_t stats;
+    tile_view_get_stats(view, &stats);
+    assert(stats.computed_tiles == 52 && stats.cached_bytes <= params.cache_bytes);
+    assert(stats.evicted_tiles == 52 - stats.cached_tiles && stats.cached_tiles >= 4);
+
+    // The first row was evicted and comes back by recomputing it
+    const tile_viewport_t first = { 0.0, TILE, 0.0, FFT, FFT, TILE };
+    assert(tile_view_render(view, &first, pixels) == 4);
+    tile_view_set_viewport(view, &first);
+    wait_idle(view);
+    assert(tile_view_render(view, &first, pixels) == 0 && pixels[5] == reference[5]);
+
+    tile_view_destroy(view);
+    printf("✓ Eviction test passed (%llu tiles evicted)\n", (unsigned long long)stats.evicted_tiles);
+}
+
+// Holds the worker in its first notify until the test opens the gate
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    bool entered, open;
+} gate_t;
+
+static void gate_notify(void *user) {
+    gate_t *gate = user;
+    pthread_mutex_lock(&gate->lock);
+    gate->entered = true;
+    pthread_cond_broadcast(&gate->changed);
+    while (!gate->open) pthread_cond_wait(&gate->changed, &gate->lock);
+    pthread_mutex_unlock(&gate->lock);
+}
+
+static void test_visible_only(void) {
+    printf("Testing visible-only computation...\n");
+
+    gate_t gate = { .entered = false, .open = false };
+    pthread_mutex_init(&gate.lock, NULL);
+    pthread_cond_init(&gate.changed, NULL);
+
+    // One worker, held after its first strip of A while the view jumps to B
+    tile_view_params_t params;
+    base_params(&params);
+    params.num_workers = 1;
+    tile_view_t *view = tile_view_create(TEST_FILE, &params, gate_notify, &gate);
+    assert(view);
+
+    const tile_viewport_t a = { 0.0, ROWS, 0.0, FFT, FFT, ROWS };
+    const tile_viewport_t b = { 150.0, 10.0, 40.0, 8.0, 8, 10 };
+    assert(tile_view_set_viewport(view, &a) == 52);
+    pthread_mutex_lock(&gate.lock);
+    while (!gate.entered) pthread_cond_wait(&gate.changed, &gate.lock);
+    pthread_mutex_unlock(&gate.lock);
+
+    tile_view_stats_t stats;
+    tile_view_get_stats(view, &stats);
+    assert(stats.computed_tiles == 4 && stats.queued_tiles == 52 - 4);
+    assert(tile_view_set_viewport(view, &b) == 1);
+    tile_view_get_stats(view, &stats);
+    assert(stats.queued_tiles == 1);
+
+    pthread_mutex_lock(&gate.lock);
+    gate.open = true;
+    pthread_cond_broadcast(&gate.changed);
+    pthread_mutex_unlock(&gate.lock);
+    wait_idle(view);
+
+    // The rest of A was dropped: one strip of A and the tile of B
+    tile_view_get_stats(view, &stats);
+    assert(stats.computed_tiles == 4 + 1 && stats.queued_tiles == 0);
+
+    float pixels[80];
+    assert(tile_view_render(view, &b, pixels) == 0);
+    for (uint32_t y = 0; y < 10; y++) {
+        for (uint32_t x = 0; x < 8; x++) assert(pixels[y * 8 + x] == reference[(size_t)(150 + y) * FFT + 40 + x]);
+    }
+
+    tile_view_destroy(view);
+    pthread_cond_destroy(&gate.changed);
+    pthread_mutex_destroy(&gate.lock);
+    printf("✓ Visible-only test passed\n");
+}
+
+static void test_errors(void) {
+    printf("Testing error handling...\n");
+
+    tile_view_params_t params;
+    base_params(&params);
+    assert(!tile_view_create("nonexistent_file.s16", &params, NULL, NULL));
+    params.fft_size = 1000;
+    assert(!tile_view_create(TEST_FILE, &params, NULL, NULL));
+    base_params(&params);
+    params.tile_size = 0;
+    assert(!tile_view_create(TEST_FILE, &params, NULL, NULL));
+    base_params(&params);
+    params.window = "no-such-window";
+    assert(!tile_view_create(TEST_FILE, &params, NULL, NULL));
+
+    assert(tile_view_idle(NULL));
+    tile_view_destroy(NULL);
+
+    printf("✓ Error handling test passed\n");
+}
+
+int main(void) {
+    printf("=== Tile View Unit Tests ===\n\n");
+
+    write_test_file();
+    compute_reference();
+    test_computed_levels();
+    test_frame_sampling();
+    test_pyramid_tiles();
+    test_eviction();
+    test_visible_only();
+    test_errors();
+    free(reference);
+    remove(TEST_FILE);
+
+    printf("\n✓ All tile view tests passed!\n");
+    return 0;
+}
@@ -186,6 +186,201 @@ void test_wave_writer_errors() {
     }
 }
 
+// Read a whole file
+static uint8_t *read_file(const char *path, long *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(*size > 0 ? (size_t)*size : 1);
+    if (data && fread(data, 1, (size_t)*size, f) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    return (uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32;
+}
+
+// Test float conversion: every kernel matches the scalar one
+void test_wave_convert_float() {
+    TEST_START("Float to PCM Conversion");
+
+    const size_t count = 10007;
+    float *input = malloc(count * sizeof(float));
+    int16_t *ref = malloc(count * sizeof(int16_t));
+    int16_t *out = malloc(count * sizeof(int16_t));
+    if (!input || !ref || !out) {
+        TEST_FAIL("Failed to allocate buffers");
+        free(input);
+        free(ref);
+        free(out);
+        return;
+    }
+
+    uint32_t state = 1u;
+    for (size_t i = 0; i < count; i++) {
+        state = state * 1664525u + 1013904223u;
+        input[i] = ((float)(state >> 8) / 8388608.0f - 1.0f) * 1.5f;
+    }
+    input[0] = 1.0f;
+    input[1] = -1.0f;
+    input[2] = NAN;
+    input[3] = INFINITY;
+    input[4] = -INFINITY;
+    input[5] = -0.99999f;
+
+    wave_force_scalar(true);
+    wave_convert_float(input, ref, count);
+    wave_force_scalar(false);
+
+    // Odd offsets and lengths exercise the scalar tails
+    bool ok = ref[0] == 32767 && ref[1] == -32767 && ref[2] == 32767 &&
+              ref[3] == 32767 && ref[4] == -32767 && ref[5] == -32766;
+    for (size_t offset = 0; offset < 5 && ok; offset++) {
+        memset(out, 0, count * sizeof(int16_t));
+        wave_convert_float(input + offset, out + offset, count - offset);
+        ok = memcmp(out + offset, ref + offset, (count - offset) * sizeof(int16_t)) == 0;
+    }
+
+    free(input);
+    free(ref);
+    free(out);
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("SIMD conversion differs from scalar");
+    }
+}
+
+// Test buffered writes across many flushes, both header layouts
+void test_wave_writer_buffered() {
+    TEST_START("Buffered and RF64-Reserved Writer");
+
+    const char *test_file = "test_buffered.wav";
+    const uint32_t frames = 30011;
+    int16_t *pcm = malloc(frames * 2 * sizeof(int16_t));
+    float *audio = malloc(frames * 2 * sizeof(float));
+    if (!pcm || !audio) {
+        TEST_FAIL("Failed to allocate samples");
+        free(pcm);
+        free(audio);
+        return;
+    }
+    for (uint32_t i = 0; i < frames * 2; i++) {
+        audio[i] = (float)sin(0.001 * i);
+    }
+    wave_convert_float(audio, pcm, frames * 2);
+
+    bool ok = true;
+    for (int variant = 0; variant < 3 && ok; variant++) {
+        wave_writer_options_t options;
+        wave_writer_options_init(&options);
+        options.buffer_size = 5000;            // Rounded up to two aligned blocks
+        options.rf64 = variant != 0;
+        options.direct_io = variant == 2;      // Falls back where refused
+
+        wave_writer_t writer;
+        if (!wave_writer_init_custom(&writer, test_file, 44100, 2, &options)) {
+            TEST_FAIL("Failed to initialize writer");
+            ok = false;
+            break;
+        }
+        ok = writer.buffer_size == 2 * WAVE_BUFFER_ALIGN;
+
+        // Alternate int16 and float writes of uneven sizes
+        uint32_t written = 0, step = 1;
+        while (ok && written < frames) {
+            uint32_t n = frames - written < step ? frames - written : step;
+            ok = (step & 1) ? wave_writer_write_samples(&writer, pcm + 2 * written, n)
+                            : wave_writer_write_float(&writer, audio + 2 * written, n);
+            written += n;
+            step = step * 3 + 1;
+        }
+        ok = wave_writer_close(&writer) && ok;
+
+        long size = 0;
+        uint8_t *data = ok ? read_file(test_file, &size) : NULL;
+        uint32_t header = options.rf64 ? WAVE_RF64_HEADER_SIZE : WAVE_HEADER_SIZE;
+        uint32_t data_bytes = frames * 2 * sizeof(int16_t);
+        ok = data && size == (long)(header + data_bytes) &&
+             memcmp(data, "RIFF", 4) == 0 && get_u32(data + 4) == header - 8 + data_bytes &&
+             memcmp(data + 8, "WAVE", 4) == 0 &&
+             memcmp(data + header - 8, "data", 4) == 0 && get_u32(data + header - 4) == data_bytes &&
+             memcmp(data + header, pcm, data_bytes) == 0;
+        if (ok && options.rf64) {
+            ok = memcmp(data + 12, "JUNK", 4) == 0 && get_u32(data + 16) == 28 &&
+                 memcmp(data + 48, "fmt ", 4) == 0;
+        }
+        free(data);
+        remove(test_file);
+    }
+
+    free(pcm);
+    free(audio);
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("Buffered output differs from the samples written");
+    }
+}
+
+// Test the 4 GB limit and the RF64 header (sizes forced, no 4 GB file)
+void test_wave_writer_rf64() {
+    TEST_START("RF64 Promotion and 4 GB Limit");
+
+    const char *test_file = "test_rf64.wav";
+    const int16_t samples[4] = {1, -1, 2, -2};
+    wave_writer_t writer;
+    bool ok = true;
+
+    // Plain header: writes past 4 GB are refused
+    if (!wave_writer_init(&writer, test_file, 48000, 1)) {
+        TEST_FAIL("Failed to initialize writer");
+        return;
+    }
+    writer.data_size = UINT32_MAX - 40;
+    ok = !wave_writer_write_samples(&writer, samples, 4);
+    wave_writer_close(&writer);
+
+    // Reserved ds64: the same size turns the file into RF64
+    wave_writer_options_t options;
+    wave_writer_options_init(&options);
+    if (ok && wave_writer_init_custom(&writer, test_file, 48000, 1, &options)) {
+        ok = wave_writer_write_samples(&writer, samples, 4);
+        writer.data_size = 5000000000ull;
+        writer.total_samples = 2500000000ull;
+        ok = wave_writer_close(&writer) && ok;
+
+        long size = 0;
+        uint8_t *data = ok ? read_file(test_file, &size) : NULL;
+        ok = data && size == WAVE_RF64_HEADER_SIZE + 8 &&
+             memcmp(data, "RF64", 4) == 0 && get_u32(data + 4) == UINT32_MAX &&
+             memcmp(data + 12, "ds64", 4) == 0 &&
+             get_u64(data + 20) == WAVE_RF64_HEADER_SIZE - 8 + 5000000000ull &&
+             get_u64(data + 28) == 5000000000ull && get_u64(data + 36) == 2500000000ull &&
+             memcmp(data + 72, "data", 4) == 0 && get_u32(data + 76) == UINT32_MAX;
+        free(data);
+    } else {
+        ok = false;
+    }
+    remove(test_file);
+
+    if (ok) {
+        TEST_PASS();
+    } else {
+        TEST_FAIL("RF64 header or size limit wrong");
+    }
+}
+
 int main() {
     printf("=====================================\n");
     printf("IQ Lab - WAV Writer Unit Tests\n");
@@ -194,6 +389,9 @@ int main() {
     test_wave_writer_basic();
     test_wave_writer_stereo();
     test_wave_writer_errors();
+    test_wave_convert_float();
+    test_wave_writer_buffered();
+    test_wave_writer_rf64();
 
     printf("\n=====================================\n");
     printf("Test Results: %d/%d passed\n", tests_passed, tests_run);
@@ -2,19 +2,29 @@
  * IQ Lab - test_yaml_parse.c: Unit tests for YAML parser
  *
  * Purpose: Test the YAML parser functionality with various inputs
- * and ensure it correctly parses pipeline configurations.
+ * and ensure it correctly parses pipeline configurations: block and flow
+ * mappings, quoted scalars and comments; tokens that are spans of the
+ * source; job files with thousands of entries and values of any length,
+ * parsed in linear time; and errors reported with their line.
  *
  *
  * Date: 2025
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
-
+#include <time.h>
 #include "../../src/jobs/yaml_parse.h"
 
+static bool parse_text(const char *text, yaml_document_t *document, yaml_parser_t *parser) {
+    assert(yaml_parser_init(parser, text, strlen(text)));
+    return yaml_parse_document(parser, document);
+}
+
 /**
  * @brief Test basic YAML parsing functionality
  */
@@ -39,10 +49,11 @@ static void test_basic_yaml_parsing(void) {
         printf("  Parse error: %s\n", error);
     }
 
-    // For now, just test that parsing doesn't crash
-    // TODO: Fix the actual parsing logic
+    assert(parse_result);
+    assert(document.input_count == 1 && strcmp(document.inputs[0].file, "test.iq") == 0);
+    assert(strcmp(document.inputs[0].meta, "") == 0 && document.pipeline_count == 0);
     yaml_free_document(&document);
-    printf("✅ Basic YAML parsing test completed (parser doesn't crash)\n");
+    printf("✅ Basic YAML parsing test passed\n");
 }
 
 /**
@@ -51,8 +62,119 @@ static void test_basic_yaml_parsing(void) {
 static void test_complex_yaml_parsing(void) {
     printf("🧪 Testing complex YAML parsing...\n");
 
-    // Skip this test for now - focus on basic functionality
-    printf("✅ Complex YAML parsing test skipped (basic parsing working)\n");
+    const char *yaml =
+        "# Job file\n"
+        "inputs:\n"
+        "  - file: data/capture.iq   # trailing comment\n"
+        "    meta: data/capture.sigmf-meta\n"
+        "    sample_rate: 2000000\n"
+        "  - { file: \"data/with space.iq\", format: s16, frequency: 100.5e6 }\n"
+        "  - data/third.iq\n"
+        "  - file: C:\\captures\\x.iq\n"
+        "\n"
+        "options:\n"
+        "  unknown: { nested: { deeper: 1 } }\n"
+        "  - skipped\n"
+        "pipeline:\n"
+        "  - iqls: { fft: 4096, hop: 1024, in: \"{input}\", out: '{stem}''s' }\n"
+        "  - iqdetect:\n"
+        "      pfa: 1e-3\n"
+        "      url: http://host/a#b\n"
+        "      note: \"tab\\there \\\"quoted\\\"\"\n"
+        "  - iqinfo: {}\n"
+        "  - iqinfo\n"
+        "report:\n"
+        "  consolidate: { events: true, spectra: false, audio: true }\n"
+        "  output_dir: reports\n";
+
+    yaml_parser_t parser;
+    yaml_document_t document;
+    bool ok = parse_text(yaml, &document, &parser);
+    if (!ok) printf("  Parse error: %s\n", yaml_parser_get_error(&parser));
+    assert(ok);
+
+    assert(document.input_count == 4);
+    assert(strcmp(document.inputs[0].file, "data/capture.iq") == 0);
+    assert(strcmp(document.inputs[0].meta, "data/capture.sigmf-meta") == 0);
+    assert(document.inputs[0].sample_rate == 2000000);
+    assert(strcmp(document.inputs[1].file, "data/with space.iq") == 0);
+    assert(strcmp(document.inputs[1].format, "s16") == 0 && document.inputs[1].frequency == 100.5e6);
+    assert(strcmp(document.inputs[2].file, "data/third.iq") == 0);
+    assert(strcmp(document.inputs[3].file, "C:\\captures\\x.iq") == 0);
+
+    assert(document.pipeline_count == 4);
+    const yaml_pipeline_step_t *ls = &document.pipeline[0];
+    assert(strcmp(ls->tool_name, "iqls") == 0 && ls->param_count == 4);
+    assert(strcmp(yaml_get_step_param(ls, "fft"), "4096") == 0);
+    assert(strcmp(yaml_get_step_param(ls, "in"), "{input}") == 0);
+    assert(strcmp(yaml_get_step_param(ls, "out"), "{stem}'s") == 0);
+    const yaml_pipeline_step_t *detect = &document.pipeline[1];
+    assert(strcmp(detect->tool_name, "iqdetect") == 0 && detect->param_count == 3);
+    assert(strcmp(yaml_get_step_param(detect, "pfa"), "1e-3") == 0);
+    assert(strcmp(yaml_get_step_param(detect, "url"), "http://host/a#b") == 0);
+    assert(strcmp(yaml_get_step_param(detect, "note"), "tab\there \"quoted\"") == 0);
+    assert(strcmp(document.pipeline[2].tool_name, "iqinfo") == 0 && document.pipeline[2].param_count == 0);
+    assert(strcmp(document.pipeline[3].tool_name, "iqinfo") == 0 && document.pipeline[3].param_count == 0);
+
+    assert(document.report.consolidate_events && !document.report.consolidate_spectra);
+    assert(document.report.consolidate_audio);
+    assert(strcmp(document.report.output_dir, "reports") == 0);
+    assert(yaml_validate_document(&document));
+    yaml_free_document(&document);
+
+    printf("✅ Complex YAML parsing test passed\n");
+}
+
+/**
+ * @brief Tokens are spans of the source, with their position
+ */
+static void test_yaml_tokenizer(void) {
+    printf("🧪 Testing the tokenizer...\n");
+
+    const char *text = "a:\n  - k: { x: \"v w\", y: 2 }\n";
+    static const struct {
+        yaml_token_type_t type;
+        const char *text;
+        uint32_t line, column;
+    } expected[] = {
+        {YAML_TOKEN_KEY, "a", 1, 0},
+        {YAML_TOKEN_ENTRY, "-", 2, 2},
+        {YAML_TOKEN_KEY, "k", 2, 4},
+        {YAML_TOKEN_FLOW_START, "{", 2, 7},
+        {YAML_TOKEN_KEY, "x", 2, 9},
+        {YAML_TOKEN_SCALAR, "v w", 2, 12},
+        {YAML_TOKEN_COMMA, ",", 2, 17},
+        {YAML_TOKEN_KEY, "y", 2, 19},
+        {YAML_TOKEN_SCALAR, "2", 2, 22},
+        {YAML_TOKEN_FLOW_END, "}", 2, 24},
+        {YAML_TOKEN_END, "", 3, 0}
+    };
+
+    yaml_tokenizer_t tokenizer;
+    yaml_token_t token;
+    yaml_tokenizer_init(&tokenizer, text, strlen(text));
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        assert(yaml_next_token(&tokenizer, &token) == expected[i].type);
+        assert(token.text.length == strlen(expected[i].text));
+        assert(memcmp(token.text.start, expected[i].text, token.text.length) == 0);
+        assert(token.text.start >= text && token.text.start <= text + strlen(text));  // No copies
+        assert(token.line == expected[i].line && token.column == expected[i].column);
+    }
+    assert(yaml_next_token(&tokenizer, &token) == YAML_TOKEN_END);  // Repeats
+
+    // Quoting decides what is a scalar
+    const char *quoted = "'it''s'";
+    yaml_tokenizer_init(&tokenizer, quoted, strlen(quoted));
+    assert(yaml_next_token(&tokenizer, &token) == YAML_TOKEN_SCALAR && token.quote == '\'');
+    assert(token.text.length == 5);
+
+    const char *broken = "x: \"open\n";
+    yaml_tokenizer_init(&tokenizer, broken, strlen(broken));
+    assert(yaml_next_token(&tokenizer, &token) == YAML_TOKEN_KEY);
+    assert(yaml_next_token(&tokenizer, &token) == YAML_TOKEN_ERROR && tokenizer.error);
+    assert(yaml_next_token(&tokenizer, &token) == YAML_TOKEN_END);
+
+    printf("✅ Tokenizer tests passed\n");
 }
 
 /**
@@ -61,29 +183,108 @@ static void test_complex_yaml_parsing(void) {
 static void test_yaml_parameters(void) {
     printf("🧪 Testing YAML parameter handling...\n");
 
-    yaml_pipeline_step_t step = {0};
-    strcpy(step.tool_name, "test_tool");
+    yaml_document_t document = {0};
+    yaml_pipeline_step_t *step = yaml_add_step(&document);
+    assert(step);
+    step->tool_name = yaml_copy_string(&document, "test_tool");
 
     // Test setting parameters
-    bool set_result1 = yaml_set_step_param(&step, "param1", "value1");
-    bool set_result2 = yaml_set_step_param(&step, "param2", "value2");
+    bool set_result1 = yaml_set_step_param(&document, step, "param1", "value1");
+    bool set_result2 = yaml_set_step_param(&document, step, "param2", "value2");
 
     printf("  Set param1: %s\n", set_result1 ? "SUCCESS" : "FAILED");
     printf("  Set param2: %s\n", set_result2 ? "SUCCESS" : "FAILED");
-    printf("  Param count: %u\n", step.param_count);
+    printf("  Param count: %u\n", step->param_count);
 
     // Test getting parameters
-    const char *value1 = yaml_get_step_param(&step, "param1");
-    const char *value2 = yaml_get_step_param(&step, "param2");
-    const char *missing = yaml_get_step_param(&step, "missing");
+    const char *value1 = yaml_get_step_param(step, "param1");
+    const char *value2 = yaml_get_step_param(step, "param2");
+    const char *missing = yaml_get_step_param(step, "missing");
 
     printf("  Get param1: %s\n", value1 ? value1 : "NULL");
     printf("  Get param2: %s\n", value2 ? value2 : "NULL");
     printf("  Get missing: %s\n", missing ? missing : "NULL");
 
+    assert(set_result1 && set_result2 && step->param_count == 2);
+    assert(strcmp(value1, "value1") == 0 && strcmp(value2, "value2") == 0 && !missing);
+
+    // No limit on the number or length of parameters
+    char long_value[4096];
+    memset(long_value, 'v', sizeof(long_value) - 1);
+    long_value[sizeof(long_value) - 1] = '\0';
+    for (int i = 0; i < 100; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%d", i);
+        assert(yaml_set_step_param(&document, step, key, long_value));
+    }
+    assert(step->param_count == 102 && strlen(yaml_get_step_param(step, "k99")) == 4095);
+    assert(strcmp(yaml_get_step_param(step, "param1"), "value1") == 0);
+    yaml_free_document(&document);
+
     printf("✅ YAML parameter handling test completed\n");
 }
 
+// Job file with 'count' inputs and steps, values padded to 'width'
+static char *generate_job(uint32_t count, uint32_t width) {
+    size_t size = (size_t)count * (2 * width + 128) + 64;
+    char *text = (char *)malloc(size);
+    assert(text);
+    size_t used = (size_t)snprintf(text, size, "inputs:\n");
+    for (uint32_t i = 0; i < count; i++) {
+        used += (size_t)snprintf(text + used, size - used, "  - file: data/%0*u.iq\n", (int)width, i);
+    }
+    used += (size_t)snprintf(text + used, size - used, "pipeline:\n");
+    for (uint32_t i = 0; i < count; i++) {
+        used += (size_t)snprintf(text + used, size - used,
+                                 "  - iqls: { fft: 4096, out: \"out/%0*u\" }\n", (int)width, i);
+    }
+    return text;
+}
+
+static double parse_seconds(const char *text, yaml_document_t *document) {
+    struct timespec start, end;
+    yaml_parser_t parser;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(parse_text(text, document, &parser));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+/**
+ * @brief Generated job files: thousands of entries, long values, linear time
+ */
+static void test_yaml_large_documents(void) {
+    printf("🧪 Testing large generated job files...\n");
+
+    // Values longer than any former field
+    char *text = generate_job(50, 600);
+    yaml_document_t document;
+    parse_seconds(text, &document);
+    assert(document.input_count == 50 && document.pipeline_count == 50);
+    assert(strlen(document.inputs[49].file) == 600 + 8);
+    assert(strlen(yaml_get_step_param(&document.pipeline[49], "out")) == 600 + 4);
+    yaml_free_document(&document);
+    free(text);
+
+    // Four times the entries take about four times as long
+    char *small = generate_job(20000, 8);
+    char *large = generate_job(80000, 8);
+    double small_time = parse_seconds(small, &document);
+    assert(document.input_count == 20000 && document.pipeline_count == 20000);
+    yaml_free_document(&document);
+    double large_time = parse_seconds(large, &document);
+    assert(document.input_count == 80000 && document.pipeline_count == 80000);
+    assert(strcmp(document.inputs[79999].file, "data/00079999.iq") == 0);
+    assert(strcmp(yaml_get_step_param(&document.pipeline[79999], "out"), "out/00079999") == 0);
+    yaml_free_document(&document);
+    printf("  20000 entries: %.3f s, 80000 entries: %.3f s\n", small_time, large_time);
+    assert(large_time < 10.0 * small_time + 0.05);
+    free(small);
+    free(large);
+
+    printf("✅ Large document tests passed\n");
+}
+
 /**
  * @brief Test YAML document serialization
  */
@@ -93,12 +294,14 @@ static void test_yaml_serialization(void) {
     yaml_document_t document = {0};
 
     // Set up test document
-    document.input_count = 1;
-    strcpy(document.inputs[0].file, "test.iq");
+    yaml_input_t *input = yaml_add_input(&document);
+    assert(input);
+    input->file = yaml_copy_string(&document, "test.iq");
 
-    document.pipeline_count = 1;
-    strcpy(document.pipeline[0].tool_name, "iqls");
-    yaml_set_step_param(&document.pipeline[0], "fft", "4096");
+    yaml_pipeline_step_t *step = yaml_add_step(&document);
+    assert(step);
+    step->tool_name = yaml_copy_string(&document, "iqls");
+    yaml_set_step_param(&document, step, "fft", "4096");
 
     char buffer[1024];
     bool serialize_result = yaml_document_to_string(&document, buffer, sizeof(buffer));
@@ -108,6 +311,14 @@ static void test_yaml_serialization(void) {
         printf("  Generated YAML:\n%s\n", buffer);
     }
 
+    // The text parses back to the same document
+    yaml_parser_t parser;
+    yaml_document_t parsed;
+    assert(serialize_result && parse_text(buffer, &parsed, &parser));
+    assert(parsed.input_count == 1 && strcmp(parsed.inputs[0].file, "test.iq") == 0);
+    assert(parsed.pipeline_count == 1 && strcmp(yaml_get_step_param(&parsed.pipeline[0], "fft"), "4096") == 0);
+    yaml_free_document(&parsed);
+
     yaml_free_document(&document);
     printf("✅ YAML serialization test completed\n");
 }
@@ -125,8 +336,27 @@ static void test_yaml_error_handling(void) {
     yaml_document_t document = {0}; // Initialize to avoid unused warning
 
     assert(yaml_parser_init(&parser, invalid_yaml, strlen(invalid_yaml)));
-    // This might succeed or fail depending on parser robustness
-    // The important thing is it doesn't crash
+    assert(!yaml_parse_document(&parser, &document));
+    printf("  Error: %s\n", yaml_parser_get_error(&parser));
+    assert(strncmp(yaml_parser_get_error(&parser), "Line 1:", 7) == 0);
+    assert(document.input_count == 0 && document.arena == NULL);  // Freed on failure
+
+    // Errors name their line
+    static const char *const broken[] = {
+        "inputs:\n  - file: a.iq\npipeline:\n  - iqls: { fft: 4096\n",
+        "inputs:\n  - file: \"a.iq\n",
+        "pipeline:\n  - iqls: { in: [a, b] }\n",
+        "pipeline:\n  - iqls: { in: { nested: 1 } }\n",
+        "inputs:\n  - file: a.iq\n }\n"
+    };
+    static const uint32_t lines[] = {5, 2, 2, 2, 3};
+    for (size_t i = 0; i < sizeof(broken) / sizeof(broken[0]); i++) {
+        assert(!parse_text(broken[i], &document, &parser));
+        char prefix[16];
+        snprintf(prefix, sizeof(prefix), "Line %u:", lines[i]);
+        printf("  Error: %s\n", yaml_parser_get_error(&parser));
+        assert(strncmp(yaml_parser_get_error(&parser), prefix, strlen(prefix)) == 0);
+    }
 
     // Clean up
     yaml_free_document(&document);
@@ -146,7 +376,9 @@ int main(int argc, char **argv) {
 
     test_basic_yaml_parsing();
     test_complex_yaml_parsing();
+    test_yaml_tokenizer();
     test_yaml_parameters();
+    test_yaml_large_documents();
     test_yaml_serialization();
     test_yaml_error_handling();
 
@@ -0,0 +1,187 @@
+/*
+ * =============================================================================
+ * IQ Lab - FFT Codelet Generator
+ * =============================================================================
+ *
+ * PURPOSE:
+ *   Writes src/iq_core/fft_codelets.inc: one fully unrolled forward
+ *   transform per power-of-two size 2..FFT_CODELET_MAX_SIZE. Each codelet
+ *   loads all N inputs, runs radix-4 decimation-in-time butterflies (one
+ *   radix-2 split first when log2(N) is odd) as straight-line code with the
+ *   twiddles as literal constants, then stores all N outputs. Loading
+ *   everything before the first store makes in-place calls safe.
+ *
+ *   The output only names operations (FFT_CL_LOAD, FFT_CL_ADD, FFT_CL_MUL,
+ *   ...). fft.c includes it once per kernel family with those macros bound
+ *   to scalar code or to SIMD intrinsics; see the codelet section there.
+ *
+ * USAGE:
+ *   make codelets
+ *   ./build/fft_codegen [max_size] > src/iq_core/fft_codelets.inc
+ *
+ * =============================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_SIZE 1024
+
+static unsigned next_temp;
+
+// Variable name of an input load (id < size) or temporary
+static const char *var_name(unsigned id, unsigned size, char *buf) {
+    if (id < size) {
+        sprintf(buf, "x%u", id);
+    } else {
+        sprintf(buf, "t%u", id - size);
+    }
+    return buf;
+}
+
+// Emit "t = op(a, b)" and return t
+static unsigned emit_binary(const char *op, unsigned a, unsigned b, unsigned size) {
+    char na[16], nb[16];
+    unsigned t = size + next_temp++;
+    printf("    const FFT_CL_V t%u = %s(%s, %s);\n", t - size, op,
+           var_name(a, size, na), var_name(b, size, nb));
+    return t;
+}
+
+// Multiply by the forward twiddle W_n^j = exp(-2*pi*i*j/n)
+static unsigned emit_twiddle(unsigned a, unsigned j, unsigned n, unsigned size) {
+    j %= n;
+    if (j == 0) return a;
+
+    char na[16];
+    unsigned t = size + next_temp++;
+    if (4 * j == n) {
+        printf("    const FFT_CL_V t%u = FFT_CL_MUL_NJ(%s);\n", t - size, var_name(a, size, na));
+        return t;
+    }
+    if (2 * j == n) {
+        printf("    const FFT_CL_V t%u = FFT_CL_NEG(%s);\n", t - size, var_name(a, size, na));
+        return t;
+    }
+
+    double c, s;
+    if (8 * j == n || 8 * j == 3 * n) {
+        // Odd multiples of pi/4: keep |c| == |s| exactly
+        c = (8 * j == n ? 1.0 : -1.0) * sqrt(0.5);
+        s = -sqrt(0.5);
+    } else {
+        double angle = 2.0 * M_PI * (double)j / (double)n;
+        c = cos(angle);
+        s = -sin(angle);
+    }
+    printf("    const FFT_CL_V t%u = FFT_CL_MUL(%s, %.17g, %.17g);\n", t - size,
+           var_name(a, size, na), c, s);
+    return t;
+}
+
+/*
+ * Emit the n-point DFT of inputs offset, offset + stride, ... into out[0..n-1]
+ * (variable ids). Decimation in time: sub-transforms of the interleaved
+ * subsequences, then one layer of butterflies with constant twiddles.
+ */
+static void emit_dft(unsigned n, unsigned offset, unsigned stride, unsigned size, unsigned *out) {
+    if (n == 1) {
+        out[0] = offset;
+        return;
+    }
+
+    unsigned log2n = 0;
+    while ((1u << log2n) < n) log2n++;
+
+    if (log2n % 2 != 0) {
+        // Radix-2 split
+        unsigned half = n / 2;
+        unsigned *even = malloc(half * sizeof(unsigned));
+        unsigned *odd = malloc(half * sizeof(unsigned));
+        emit_dft(half, offset, 2 * stride, size, even);
+        emit_dft(half, offset + stride, 2 * stride, size, odd);
+        for (unsigned k = 0; k < half; k++) {
+            unsigned b = emit_twiddle(odd[k], k, n, size);
+            out[k] = emit_binary("FFT_CL_ADD", even[k], b, size);
+            out[k + half] = emit_binary("FFT_CL_SUB", even[k], b, size);
+        }
+        free(even);
+        free(odd);
+        return;
+    }
+
+    // Radix-4 split
+    unsigned quarter = n / 4;
+    unsigned *sub[4];
+    for (unsigned r = 0; r < 4; r++) {
+        sub[r] = malloc(quarter * sizeof(unsigned));
+        emit_dft(quarter, offset + r * stride, 4 * stride, size, sub[r]);
+    }
+    for (unsigned k = 0; k < quarter; k++) {
+        unsigned a = sub[0][k];
+        unsigned b = emit_twiddle(sub[1][k], k, n, size);
+        unsigned c = emit_twiddle(sub[2][k], 2 * k, n, size);
+        unsigned d = emit_twiddle(sub[3][k], 3 * k, n, size);
+
+        unsigned apc = emit_binary("FFT_CL_ADD", a, c, size);
+        unsigned amc = emit_binary("FFT_CL_SUB", a, c, size);
+        unsigned bpd = emit_binary("FFT_CL_ADD", b, d, size);
+        unsigned bmd = emit_binary("FFT_CL_SUB", b, d, size);
+        unsigned jbmd = emit_twiddle(bmd, 1, 4, size);   // -i * (b - d)
+
+        out[k] = emit_binary("FFT_CL_ADD", apc, bpd, size);
+        out[k + quarter] = emit_binary("FFT_CL_ADD", amc, jbmd, size);
+        out[k + 2 * quarter] = emit_binary("FFT_CL_SUB", apc, bpd, size);
+        out[k + 3 * quarter] = emit_binary("FFT_CL_SUB", amc, jbmd, size);
+    }
+    for (unsigned r = 0; r < 4; r++) free(sub[r]);
+}
+
+static void emit_codelet(unsigned size) {
+    unsigned *out = malloc(size * sizeof(unsigned));
+    char name[16];
+
+    next_temp = 0;
+    printf("FFT_CL_ATTR\nstatic void FFT_CL_NAME(%u)(FFT_CL_PARAMS) {\n", size);
+    printf("    FFT_CL_PROLOGUE\n");
+    for (unsigned i = 0; i < size; i++) {
+        printf("    const FFT_CL_V x%u = FFT_CL_LOAD(%u);\n", i, i);
+    }
+    emit_dft(size, 0, 1, size, out);
+    for (unsigned k = 0; k < size; k++) {
+        printf("    FFT_CL_STORE(%u, %s);\n", k, var_name(out[k], size, name));
+    }
+    printf("}\n\n");
+    free(out);
+}
+
+int main(int argc, char **argv) {
+    unsigned max_size = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 256;
+    if (max_size < 2 || max_size > MAX_SIZE || (max_size & (max_size - 1)) != 0) {
+        fprintf(stderr, "Usage: %s [max_size]  (power of two, 2..%u)\n", argv[0], MAX_SIZE);
+        return EXIT_FAILURE;
+    }
+
+    printf("/*\n");
+    printf(" * IQ Lab - Generated FFT codelets, sizes 2..%u\n", max_size);
+    printf(" * Written by tools/fft_codegen.c (make codelets); do not edit.\n");
+    printf(" * Included by fft.c once per kernel family with the FFT_CL_* macros bound.\n");
+    printf(" */\n\n");
+
+    for (unsigned size = 2; size <= max_size; size *= 2) {
+        emit_codelet(size);
+    }
+
+    // Codelets by log2(size); slot 0 (size 1) is unused
+    printf("static void (*const FFT_CL_TABLE[])(FFT_CL_PARAMS) = {\n    NULL");
+    for (unsigned size = 2; size <= max_size; size *= 2) {
+        printf(",\n    FFT_CL_NAME(%u)", size);
+    }
+    printf("\n};\n");
+    return EXIT_SUCCESS;
+}
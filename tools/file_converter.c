@@ -12,13 +12,19 @@
  *   - auto     : Automatic format detection from file extension/content
  *   - iq_s8    : Native IQ 8-bit (signed char, interleaved I,Q)
  *   - iq_s16   : Native IQ 16-bit (signed short, interleaved I,Q)
+ *   - iq_s12   : Native IQ packed 12-bit (3 bytes per I/Q pair)
+ *   - iq_s4    : Native IQ packed 4-bit (1 byte per I/Q pair)
  *   - wav      : WAV IQ format (RIFF/RF64 containers)
  *   - sigmf    : SigMF format with metadata sidecar
  *   - hdf5     : HDF5 scientific data format
+ *   - iqz      : IQZ chunked compressed container
  *
  * OUTPUT FORMATS:
  *   - iq_s8    : Native IQ 8-bit format
  *   - iq_s16   : Native IQ 16-bit format (default)
+ *   - iq_s12   : Native IQ packed 12-bit format
+ *   - iq_s4    : Native IQ packed 4-bit format
+ *   - iqz      : IQZ container, lossless unless --lossy is given
  *
  * USAGE:
  *   ./file_converter [OPTIONS] <input_file> <output_file>
@@ -28,9 +34,12 @@
  *     <output_file>    : Destination file path (required)
  *
  *   OPTIONS:
- *     -f, --from <format>    : Source format (auto, iq_s8, iq_s16, wav)
- *     -t, --to <format>      : Destination format (iq_s8, iq_s16)
+ *     -f, --from <format>    : Source format (auto, iq_s8, iq_s16, iq_s12, iq_s4, wav, iqz)
+ *     -t, --to <format>      : Destination format (iq_s8, iq_s16, iq_s12, iq_s4, iqz)
  *     -r, --rate <Hz>        : Force sample rate override
+ *     -m, --memory <MB>      : Bound conversion buffers (default unlimited)
+ *     -j, --threads <N>      : Worker threads (default one per CPU)
+ *     -l, --lossy <bits>     : IQZ block floating point with <bits>-bit mantissas
  *     --force                : Overwrite destination if exists
  *     -v, --verbose          : Enable detailed progress reporting
  *     -h, --help             : Show help message
@@ -48,6 +57,10 @@
  *   # Batch conversion with verbose output
  *   ./file_converter -v -f auto recording.wav processed.iq
  *
+ *   # Compress a capture losslessly, or at 6 bits per value
+ *   ./file_converter -t iqz capture.iq capture.iqz
+ *   ./file_converter -t iqz -l 6 capture.iq capture_lossy.iqz
+ *
  *   # Force overwrite existing output
  *   ./file_converter --force input.wav output.iq
  *
@@ -60,7 +73,8 @@
  *   - Sample rate preservation and override options
  *
  * PERFORMANCE:
- *   - Block-based processing to minimize memory usage
+ *   - Input split into aligned chunks converted by a worker pool and written
+ *     at their own offsets; --memory bounds the buffers of all workers
  *   - Throughput reporting in MB/s
  *   - Optimized for both speed and memory efficiency
  *
@@ -81,9 +95,12 @@ static void print_help(const char *program_name) {
     printf("%s v%s - Universal IQ File Converter\n", PROGRAM_NAME, PROGRAM_VERSION);
     printf("Usage: %s [OPTIONS] <input_file> <output_file>\n", program_name);
     printf("\nOPTIONS:\n");
-    printf("  -f, --from <format>    Source file format (auto, iq_s8, iq_s16, wav)\n");
-    printf("  -t, --to <format>      Destination file format (iq_s8, iq_s16)\n");
+    printf("  -f, --from <format>    Source file format (auto, iq_s8, iq_s16, iq_s12, iq_s4, wav, iqz)\n");
+    printf("  -t, --to <format>      Destination file format (iq_s8, iq_s16, iq_s12, iq_s4, iqz)\n");
     printf("  -r, --rate <Hz>        Force sample rate\n");
+    printf("  -m, --memory <MB>      Memory limit for conversion buffers (default: unlimited)\n");
+    printf("  -j, --threads <N>      Worker threads (default: one per CPU)\n");
+    printf("  -l, --lossy <bits>     IQZ output: block floating point, <bits> per value (default: lossless)\n");
     printf("  --force                Overwrite destination file if it exists\n");
     printf("  -v, --verbose          Verbose mode\n");
     printf("  -h, --help             Show this help\n");
@@ -94,15 +111,20 @@ static void print_help(const char *program_name) {
     printf("  %s -f wav -t iq_s16 capture.wav capture.iq\n", program_name);
     printf("\n  # Conversion with forced sample rate\n");
     printf("  %s -r 2000000 mystery_file.dat output.iq\n", program_name);
+    printf("\n  # Compressed container with random access\n");
+    printf("  %s -t iqz capture.iq capture.iqz\n", program_name);
     printf("\nSUPPORTED FORMATS:\n");
     printf("  auto     - Automatic format detection\n");
     printf("  iq_s8    - Native IQ 8-bit\n");
     printf("  iq_s16   - Native IQ 16-bit\n");
+    printf("  iq_s12   - Native IQ packed 12-bit (.s12)\n");
+    printf("  iq_s4    - Native IQ packed 4-bit (.s4)\n");
     printf("  wav      - WAV IQ (RIFF/RF64)\n");
+    printf("  iqz      - IQZ compressed container\n");
     printf("\nNOTES:\n");
-    printf("  - Destination formats must be native IQ formats\n");
+    printf("  - Destination formats are native IQ or IQZ\n");
     printf("  - Auto-detection works for standard file extensions\n");
-    printf("  - Large files are processed in blocks to save RAM\n");
+    printf("  - Large files are processed in chunks on all CPUs; -m caps the RAM used\n");
 }
 
 static file_format_t parse_format(const char *format_str) {
@@ -111,9 +133,12 @@ static file_format_t parse_format(const char *format_str) {
     if (strcmp(format_str, "auto") == 0) return FORMAT_AUTO;
     if (strcmp(format_str, "iq_s8") == 0) return FORMAT_IQ_S8;
     if (strcmp(format_str, "iq_s16") == 0) return FORMAT_IQ_S16;
+    if (strcmp(format_str, "iq_s12") == 0) return FORMAT_IQ_S12;
+    if (strcmp(format_str, "iq_s4") == 0) return FORMAT_IQ_S4;
     if (strcmp(format_str, "wav") == 0) return FORMAT_WAV;
     if (strcmp(format_str, "sigmf") == 0) return FORMAT_SIGMF;
     if (strcmp(format_str, "hdf5") == 0) return FORMAT_HDF5;
+    if (strcmp(format_str, "iqz") == 0) return FORMAT_IQZ;
 
     return FORMAT_AUTO; // Unknown format = auto-detection
 }
@@ -129,6 +154,9 @@ int main(int argc, char *argv[]) {
         {"from", required_argument, 0, 'f'},
         {"to", required_argument, 0, 't'},
         {"rate", required_argument, 0, 'r'},
+        {"memory", required_argument, 0, 'm'},
+        {"threads", required_argument, 0, 'j'},
+        {"lossy", required_argument, 0, 'l'},
         {"force", no_argument, 0, 'F'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
@@ -138,7 +166,7 @@ int main(int argc, char *argv[]) {
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "f:t:r:Fvh", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "f:t:r:m:j:l:Fvh", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'f':
                 request.input_format = parse_format(optarg);
@@ -149,6 +177,15 @@ int main(int argc, char *argv[]) {
             case 'r':
                 request.options.sample_rate = (uint32_t)atoi(optarg);
                 break;
+            case 'm':
+                request.options.max_memory_mb = (size_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'j':
+                request.options.num_threads = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'l':
+                request.options.lossy_bits = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
             case 'F':
                 request.options.force_overwrite = true;
                 break;
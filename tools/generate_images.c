@@ -46,6 +46,7 @@
 
 #include "../src/viz/img_png.h"
 #include "../src/viz/draw_axes.h"
+#include "../src/viz/colormap.h"
 #include "../src/iq_core/io_iq.h"
 #include "../src/iq_core/fft.h"
 #include <stdio.h>
@@ -129,15 +130,22 @@ bool create_waterfall_from_iq(const iq_data_t *iq_data, png_image_t *waterfall,
     fft_complex_t *fft_input = (fft_complex_t *)malloc(config->fft_size * sizeof(fft_complex_t));
     fft_complex_t *fft_output = (fft_complex_t *)malloc(config->fft_size * sizeof(fft_complex_t));
     double *power_spectrum = (double *)malloc(config->fft_size * sizeof(double));
+    // One frame's row of the graph, coloured once and copied to each of its lines
+    float *row_values = (float *)malloc(width * sizeof(float));
+    uint8_t *row_rgb = (uint8_t *)malloc((size_t)width * 3);
 
-    if (!fft_input || !fft_output || !power_spectrum) {
+    if (!fft_input || !fft_output || !power_spectrum || !row_values || !row_rgb) {
         printf("❌ Memory allocation failed for waterfall\n");
         free(fft_input);
         free(fft_output);
         free(power_spectrum);
+        free(row_values);
+        free(row_rgb);
         fft_plan_destroy(fft_plan);
         return false;
     }
+    colormap_t cmap;
+    colormap_init(&cmap, COLORMAP_HF);
 
     // Find global min/max for consistent color scaling
     double global_min_db = 0.0;
@@ -252,26 +260,21 @@ bool create_waterfall_from_iq(const iq_data_t *iq_data, png_image_t *waterfall,
         if (end_y > graph_height) end_y = graph_height;
         if (end_y <= start_y) end_y = start_y + 1;
 
-        // Fill all pixels in the range for this frame
+        // Colour the frame's row once
+        uint32_t row_pixels = graph_width > graph_left ? graph_width - graph_left : 0;
+        for (uint32_t graph_x = 0; graph_x < row_pixels; graph_x++) {
+            // Map graph x-coordinate to FFT bin (graph_x * fft_size / graph_width < fft_size)
+            uint32_t fft_bin = graph_x * config->fft_size / graph_width;
+
+            // DIFFERENT dB scaling for waterfall (matches Python waterfall: 20*log10 vs 10*log10)
+            double power_db = 20.0 * log10(power_spectrum[fft_bin] + 1e-12);
+            row_values[graph_x] = (float)((power_db - global_min_db) / (global_max_db - global_min_db + 1e-12));
+        }
+        colormap_map_row(&cmap, row_values, row_pixels, 0.0f, 1.0f, row_rgb);
+
+        // Fill all lines in the range for this frame
         for (uint32_t image_y = start_y; image_y < end_y && image_y < height; image_y++) {
-            for (uint32_t x = graph_left; x < graph_width; x++) {
-                // Map image x-coordinate to FFT bin (relative to graph area)
-                uint32_t graph_x = x - graph_left;  // 0 to graph_width-1
-                uint32_t fft_bin = graph_x * config->fft_size / graph_width;
-
-                if (fft_bin < config->fft_size) {
-                    // DIFFERENT dB scaling for waterfall (matches Python waterfall: 20*log10 vs 10*log10)
-                    double power_db = 20.0 * log10(power_spectrum[fft_bin] + 1e-12);
-                    double normalized = (power_db - global_min_db) / (global_max_db - global_min_db + 1e-12);
-
-                    if (normalized < 0.0) normalized = 0.0;
-                    if (normalized > 1.0) normalized = 1.0;
-
-                    uint8_t r, g, b;
-                    png_intensity_to_color((float)normalized, &r, &g, &b);
-                    png_image_set_pixel(waterfall, x, image_y, r, g, b);
-                }
-            }
+            png_image_set_row(waterfall, graph_left, image_y, row_rgb, row_pixels);
         }
     }
 
@@ -279,6 +282,8 @@ bool create_waterfall_from_iq(const iq_data_t *iq_data, png_image_t *waterfall,
     free(fft_input);
     free(fft_output);
     free(power_spectrum);
+    free(row_values);
+    free(row_rgb);
     fft_plan_destroy(fft_plan);
 
     return true;
@@ -306,7 +311,7 @@ int main(void) {
     }
 
     printf("✅ Loaded %zu samples at %u Hz sample rate\n", iq_data.num_samples, iq_data.sample_rate);
-    printf("📊 Data format: %s\n", iq_data.format == IQ_FORMAT_S8 ? "8-bit" : "16-bit");
+    printf("📊 Data format: %u-bit\n", iq_format_bits(iq_data.format));
 
     // Image dimensions
     const uint32_t width = 1024;
@@ -5,7 +5,6 @@
 #include "../src/ui/ui.h"
 
 int main(int argc, char* argv[]) {
-    (void)argc; (void)argv; // Suppress unused parameter warnings
     printf("IQ Lab UI - Starting...\n");
 
     // Initialize UI configuration
@@ -27,11 +26,16 @@ int main(int argc, char* argv[]) {
     }
 
     printf("UI initialized successfully!\n");
+
+    // Optional capture to open at start
+    if (argc > 1 && !iq_ui_load_iq_file(argv[1])) {
+        fprintf(stderr, "Failed to load %s\n", argv[1]);
+    }
     printf("Controls:\n");
     printf("  ESC - Exit\n");
     printf("  F12 - Toggle debug mode\n");
     printf("  Mouse - Interact with UI\n");
-    printf("  Scroll wheel - Scroll\n");
+    printf("  Scroll wheel / Left, Right - Move through the file (Shift / PgUp, PgDn: 16 views)\n");
 
     // Run main loop
     iq_ui_run_main_loop();
@@ -0,0 +1,511 @@
+/*
+ * IQ Lab - iqcatalog: Event Catalog Across Runs
+ *
+ * Purpose: Collect iqdetect event logs into one store and query it by time and frequency
+ *
+ *
+ * "ingest" adds the events of iqdetect logs (CSV, JSONL, binary .iqev or
+ * SigMF annotation files) to a catalog directory (event_catalog.h), in
+ * absolute UTC time and absolute frequency. Each log is remembered with
+ * how far it was read, so ingesting a job's output directory after every
+ * run adds only the new logs and the new tail of a growing one.
+ *
+ * "query" prints the events overlapping a time and frequency window,
+ * reading only the day partitions and index ranges that can hold them.
+ *
+ * Times: CSV, JSONL and .iqev logs hold times from the start of the
+ * recording and offsets from its centre frequency: --t0 and --fc place
+ * them (both default to 0). SigMF logs carry their own start (capture
+ * core:datetime) and centre frequency, which --t0 and --fc override when
+ * given.
+ *
+ * Key Features:
+ * - Directories are searched (recursively) for event logs
+ * - Re-ingesting is incremental and safe to repeat
+ * - Output sorted by start time, one CSV row per event
+ *
+ * Usage Examples:
+ *   # After each job: add its event logs
+ *   iqcatalog.exe ingest --catalog events.cat --t0 2026-05-01T06:00:00Z --fc 433.92e6 out/
+ *
+ *   # Everything near 433.92 MHz on the morning of May 1st with SNR >= 15 dB
+ *   iqcatalog.exe query --catalog events.cat --from 2026-05-01T06:00:00Z --to 2026-05-01T12:00:00Z \
+ *                       --freq 433.92e6 --span 200e3 --min-snr 15
+ *
+ * Output (query, CSV on stdout):
+ *   t_start_s,t_end_s,f_low_Hz,f_high_Hz,snr_dB,peak_dBFS,modulation_guess,confidence_0_1,source
+ *
+ * Dependencies: IQ core (SigMF), detection (event catalog, event log)
+ * Thread Safety: Single-threaded; one ingest per catalog at a time
+ * Error Handling: Unreadable logs are reported and skipped; a failed
+ *                 catalog write leaves the log to be ingested again
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "../src/detect/event_catalog.h"
+#include "../src/detect/event_log.h"
+#include "../src/iq_core/io_sigmf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#define IQCATALOG_MAX_INPUTS 256
+#define IQCATALOG_MAX_LINE 2048
+#define IQCATALOG_MAX_DEPTH 8
+
+typedef enum {
+    LOG_NONE,
+    LOG_CSV,
+    LOG_JSONL,
+    LOG_IQEV,
+    LOG_SIGMF
+} log_format_t;
+
+typedef struct {
+    bool ingest;                // Otherwise query
+    const char *catalog;
+    const char *inputs[IQCATALOG_MAX_INPUTS];
+    uint32_t num_inputs;
+    double t0;                  // Recording start (epoch s)
+    double fc;                  // Recording centre frequency (Hz)
+    bool t0_set;                // Given on the command line
+    bool fc_set;
+    event_catalog_query_t query;
+} args_t;
+
+typedef struct {
+    uint32_t logs;
+    uint32_t failed;
+    uint64_t events;
+} ingest_totals_t;
+
+static void usage(void) {
+    printf("Usage: iqcatalog ingest --catalog <dir> [--t0 <time>] [--fc <Hz>] <log or dir> [...]\n");
+    printf("       iqcatalog query --catalog <dir> [--from <time>] [--to <time>]\n");
+    printf("                       [--freq <Hz> --span <Hz> | --fmin <Hz> --fmax <Hz>] [--min-snr <dB>]\n");
+    printf("       <time> is ISO 8601 UTC (2026-05-01T06:00:00Z) or epoch seconds\n");
+    printf("       Logs: .csv, .jsonl, .iqev, .sigmf-meta (iqdetect --output-format)\n");
+}
+
+static bool parse_time(const char *text, double *seconds) {
+    if (strchr(text, 'T')) return sigmf_parse_datetime(text, seconds);
+    char *end = NULL;
+    *seconds = strtod(text, &end);
+    return end != text && *end == '\0' && isfinite(*seconds);
+}
+
+static bool parse_number(const char *text, double *value) {
+    char *end = NULL;
+    *value = strtod(text, &end);
+    return end != text && *end == '\0' && isfinite(*value);
+}
+
+static int parse_args(int argc, char **argv, args_t *a) {
+    memset(a, 0, sizeof(*a));
+    a->query = event_catalog_query_all();
+    if (argc < 2) { usage(); return 0; }
+    if (!strcmp(argv[1], "ingest")) a->ingest = true;
+    else if (strcmp(argv[1], "query") != 0) { usage(); return 0; }
+
+    double freq = NAN, span = NAN;
+    for (int i = 2; i < argc; i++) {
+        bool ok = true;
+        if (!strcmp(argv[i], "--catalog") && i+1<argc) a->catalog = argv[++i];
+        else if (!strcmp(argv[i], "--t0") && i+1<argc && a->ingest) ok = a->t0_set = parse_time(argv[++i], &a->t0);
+        else if (!strcmp(argv[i], "--fc") && i+1<argc && a->ingest) ok = a->fc_set = parse_number(argv[++i], &a->fc);
+        else if (!strcmp(argv[i], "--from") && i+1<argc && !a->ingest) ok = parse_time(argv[++i], &a->query.t_min);
+        else if (!strcmp(argv[i], "--to") && i+1<argc && !a->ingest) ok = parse_time(argv[++i], &a->query.t_max);
+        else if (!strcmp(argv[i], "--freq") && i+1<argc && !a->ingest) ok = parse_number(argv[++i], &freq);
+        else if (!strcmp(argv[i], "--span") && i+1<argc && !a->ingest) ok = parse_number(argv[++i], &span) && span >= 0.0;
+        else if (!strcmp(argv[i], "--fmin") && i+1<argc && !a->ingest) ok = parse_number(argv[++i], &a->query.f_min);
+        else if (!strcmp(argv[i], "--fmax") && i+1<argc && !a->ingest) ok = parse_number(argv[++i], &a->query.f_max);
+        else if (!strcmp(argv[i], "--min-snr") && i+1<argc && !a->ingest) ok = parse_number(argv[++i], &a->query.min_snr_db);
+        else if (argv[i][0] != '-' && a->ingest && a->num_inputs < IQCATALOG_MAX_INPUTS) a->inputs[a->num_inputs++] = argv[i];
+        else ok = false;
+        if (!ok) { usage(); return 0; }
+    }
+
+    if (!isnan(freq)) {
+        double half = isnan(span) ? 0.0 : span / 2.0;
+        a->query.f_min = freq - half;
+        a->query.f_max = freq + half;
+    } else if (!isnan(span)) {
+        fprintf(stderr, "--span needs --freq\n");
+        return 0;
+    }
+    if (!a->catalog || (a->ingest && a->num_inputs == 0) ||
+        a->query.t_min > a->query.t_max || a->query.f_min > a->query.f_max) {
+        usage();
+        return 0;
+    }
+    return 1;
+}
+
+static log_format_t log_format(const char *path) {
+    static const struct { const char *ext; log_format_t format; } formats[] = {
+        {".csv", LOG_CSV}, {".jsonl", LOG_JSONL}, {".iqev", LOG_IQEV}, {".sigmf-meta", LOG_SIGMF},
+    };
+    size_t length = strlen(path);
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        size_t ext = strlen(formats[i].ext);
+        if (length > ext && strcmp(path + length - ext, formats[i].ext) == 0) return formats[i].format;
+    }
+    return LOG_NONE;
+}
+
+static void set_modulation(event_catalog_record_t *record, const char *name, size_t length) {
+    memset(record->modulation, 0, sizeof(record->modulation));
+    if (!name || (length == 7 && strncmp(name, "unknown", 7) == 0)) return;
+    if (length >= sizeof(record->modulation)) length = sizeof(record->modulation) - 1;
+    memcpy(record->modulation, name, length);
+}
+
+// An event of a log with relative times and offsets from the centre frequency
+static event_catalog_record_t make_record(const args_t *args, double t_start, double t_end, double f_center,
+                                          double bw, double snr, double peak, double confidence) {
+    event_catalog_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.t_start = args->t0 + t_start;
+    record.t_end = args->t0 + t_end;
+    record.f_low = args->fc + f_center - bw / 2.0;
+    record.f_high = args->fc + f_center + bw / 2.0;
+    record.snr_db = (float)snr;
+    record.peak_dbfs = (float)peak;
+    record.confidence = (float)confidence;
+    return record;
+}
+
+// One CSV row: t_start_s,t_end_s,f_center_Hz,bw_Hz,snr_dB,peak_dBFS,modulation_guess,confidence_0_1,tags
+static bool parse_csv_line(const args_t *args, const char *line, event_catalog_record_t *record) {
+    double t_start, t_end, f_center, bw, snr, peak, confidence;
+    int before = 0, after = 0;
+    if (sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%n%*[^,]%n,%lf", &t_start, &t_end, &f_center, &bw,
+               &snr, &peak, &before, &after, &confidence) != 7) {
+        return false;
+    }
+    *record = make_record(args, t_start, t_end, f_center, bw, snr, peak, confidence);
+    set_modulation(record, line + before, (size_t)(after - before));
+    return true;
+}
+
+static bool json_number(const char *line, const char *key, double *value) {
+    const char *at = strstr(line, key);
+    if (!at) return false;
+    at += strlen(key);
+    char *end = NULL;
+    *value = strtod(at, &end);
+    return end != at;
+}
+
+static bool parse_jsonl_line(const args_t *args, const char *line, event_catalog_record_t *record) {
+    double t_start, t_end, f_center, bw, snr, peak, confidence;
+    if (!json_number(line, "\"t_start_s\":", &t_start) || !json_number(line, "\"t_end_s\":", &t_end) ||
+        !json_number(line, "\"f_center_Hz\":", &f_center) || !json_number(line, "\"bw_Hz\":", &bw) ||
+        !json_number(line, "\"snr_dB\":", &snr) || !json_number(line, "\"peak_dBFS\":", &peak) ||
+        !json_number(line, "\"confidence_0_1\":", &confidence)) {
+        return false;
+    }
+    *record = make_record(args, t_start, t_end, f_center, bw, snr, peak, confidence);
+    const char *name = strstr(line, "\"modulation_guess\":\"");
+    if (name) {
+        name += strlen("\"modulation_guess\":\"");
+        set_modulation(record, name, strcspn(name, "\""));
+    }
+    return true;
+}
+
+// Text logs: whole lines past the stored byte offset (a line still being written waits)
+static bool ingest_text(event_catalog_t *catalog, event_catalog_source_t *source, const args_t *args,
+                        log_format_t format, uint64_t *events) {
+    FILE *file = fopen(source->path, "rb");
+    if (!file) return false;
+    if (fseek(file, (long)source->offset, SEEK_SET) != 0) {
+        fclose(file);
+        return false;
+    }
+
+    uint64_t offset = source->offset;
+    char line[IQCATALOG_MAX_LINE];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        size_t length = strlen(line);
+        if (length == 0 || line[length - 1] != '\n') break;
+        offset += length;
+
+        event_catalog_record_t record;
+        bool parsed = format == LOG_CSV ? parse_csv_line(args, line, &record)
+                                        : parse_jsonl_line(args, line, &record);
+        if (!parsed) continue;  // Header or a foreign line
+        ok = event_catalog_append(catalog, source, &record);
+        if (ok) (*events)++;
+    }
+    fclose(file);
+    return event_catalog_commit(catalog, source, offset) && ok;
+}
+
+// Binary logs: whole blocks, counted in events
+static bool ingest_iqev(event_catalog_t *catalog, event_catalog_source_t *source, const args_t *args,
+                        uint64_t *events) {
+    event_log_reader_t *log = event_log_open(source->path);
+    if (!log) return false;
+
+    uint64_t seen = 0;
+    bool ok = true;
+    event_log_block_t block;
+    while (ok && event_log_next(log, NULL, &block)) {
+        for (uint32_t k = 0; ok && k < block.count; k++, seen++) {
+            if (seen < source->offset) continue;
+            event_catalog_record_t record =
+                make_record(args, block.start_time_s[k], block.end_time_s[k], block.center_freq_hz[k],
+                            block.bandwidth_hz[k], block.peak_snr_db[k], block.peak_power_dbfs[k],
+                            block.confidence[k]);
+            const char *name = event_log_modulation(log, block.modulation[k]);
+            set_modulation(&record, name, name ? strlen(name) : 0);
+            ok = event_catalog_append(catalog, source, &record);
+            if (ok) (*events)++;
+        }
+    }
+    // A block cut short is still being written: stop before it
+    event_log_close_reader(log);
+    return event_catalog_commit(catalog, source, seen > source->offset ? seen : source->offset) && ok;
+}
+
+static double description_value(const char *description, const char *key, double fallback) {
+    double value;
+    return json_number(description, key, &value) ? value : fallback;
+}
+
+// SigMF annotation files, counted in annotations
+static bool ingest_sigmf(event_catalog_t *catalog, event_catalog_source_t *source, const args_t *args,
+                         uint64_t *events) {
+    sigmf_metadata_t metadata;
+    sigmf_init_metadata(&metadata);
+    if (!sigmf_read_metadata(source->path, &metadata)) {
+        sigmf_free_metadata(&metadata);
+        return false;
+    }
+
+    double t0 = args->t0;
+    if (!args->t0_set) sigmf_start_time(&metadata, &t0);
+    double rate = (double)metadata.global.sample_rate;
+    double fc = args->fc_set ? args->fc : (double)metadata.global.frequency;
+    bool ok = rate > 0.0;
+    for (size_t i = source->offset; ok && i < metadata.num_annotations; i++) {
+        const sigmf_annotation_t *annotation = &metadata.annotations[i];
+        const char *description = annotation->description;
+        event_catalog_record_t record;
+        memset(&record, 0, sizeof(record));
+        record.t_start = t0 + (double)annotation->sample_start / rate;
+        record.t_end = record.t_start + (double)annotation->sample_count / rate;
+
+        // iqdetect writes the offset and width; band edges are only set for real centres
+        double f_center, bw;
+        if (json_number(description, "f_center_Hz=", &f_center) && json_number(description, "bw_Hz=", &bw)) {
+            record.f_low = fc + f_center - bw / 2.0;
+            record.f_high = fc + f_center + bw / 2.0;
+        } else {
+            record.f_low = (double)annotation->freq_lower_edge;
+            record.f_high = (double)annotation->freq_upper_edge;
+        }
+        record.snr_db = (float)description_value(description, "snr_dB=", 0.0);
+        record.peak_dbfs = (float)description_value(description, "peak_dBFS=", 0.0);
+        record.confidence = (float)description_value(description, "confidence_0_1=", 0.0);
+        set_modulation(&record, annotation->label, strlen(annotation->label));
+        ok = event_catalog_append(catalog, source, &record);
+        if (ok) (*events)++;
+    }
+    uint64_t offset = metadata.num_annotations > source->offset ? metadata.num_annotations : source->offset;
+    sigmf_free_metadata(&metadata);
+    return event_catalog_commit(catalog, source, offset) && ok;
+}
+
+static void ingest_file(event_catalog_t *catalog, const args_t *args, const char *path, ingest_totals_t *totals) {
+    log_format_t format = log_format(path);
+    struct stat info;
+    if (format == LOG_NONE || stat(path, &info) != 0) {
+        fprintf(stderr, "Skipping %s: not an event log\n", path);
+        return;
+    }
+
+    event_catalog_source_t *source = event_catalog_source(catalog, path, (uint64_t)info.st_size,
+                                                          (int64_t)info.st_mtime);
+    if (!source) {
+        fprintf(stderr, "Skipping %s: cannot add it to the catalog\n", path);
+        totals->failed++;
+        return;
+    }
+
+    uint64_t events = 0;
+    bool ok;
+    if (format == LOG_IQEV) ok = ingest_iqev(catalog, source, args, &events);
+    else if (format == LOG_SIGMF) ok = ingest_sigmf(catalog, source, args, &events);
+    else ok = ingest_text(catalog, source, args, format, &events);
+
+    totals->logs++;
+    totals->events += events;
+    if (!ok) {
+        fprintf(stderr, "Failed to ingest %s\n", path);
+        totals->failed++;
+    } else if (events > 0) {
+        printf("  %s: %llu new events\n", path, (unsigned long long)events);
+    }
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Event logs in 'dir' and below, in name order so source ids are stable
+static void ingest_dir(event_catalog_t *catalog, const args_t *args, const char *dir, int depth,
+                       ingest_totals_t *totals) {
+    char **names = NULL;
+    size_t count = 0, capacity = 0;
+    const char *name;
+#ifdef _WIN32
+    char pattern[1024];
+    snprintf(pattern, sizeof(pattern), "%s\\*", dir);
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA(pattern, &found);
+    if (search == INVALID_HANDLE_VALUE) return;
+    do {
+        name = found.cFileName;
+#else
+    DIR *handle = opendir(dir);
+    if (!handle) return;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        name = entry->d_name;
+#endif
+        if (name[0] == '.') continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            char **grown = realloc(names, capacity * sizeof(*names));
+            if (!grown) break;
+            names = grown;
+        }
+        names[count] = malloc(strlen(name) + 1);
+        if (names[count]) strcpy(names[count++], name);
+#ifdef _WIN32
+    } while (FindNextFileA(search, &found));
+    FindClose(search);
+#else
+    }
+    closedir(handle);
+#endif
+
+    if (count > 0) qsort(names, count, sizeof(*names), compare_names);
+    for (size_t i = 0; i < count; i++) {
+        char path[EVENT_CATALOG_MAX_PATH];
+        struct stat info;
+        int length = snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        if (length > 0 && (size_t)length < sizeof(path) && stat(path, &info) == 0) {
+            if (S_ISDIR(info.st_mode)) {
+                if (depth < IQCATALOG_MAX_DEPTH) ingest_dir(catalog, args, path, depth + 1, totals);
+            } else if (log_format(path) != LOG_NONE) {
+                ingest_file(catalog, args, path, totals);
+            }
+        }
+        free(names[i]);
+    }
+    free(names);
+}
+
+static int run_ingest(const args_t *args) {
+    event_catalog_t *catalog = event_catalog_open(args->catalog, true);
+    if (!catalog) return EXIT_FAILURE;
+
+    ingest_totals_t totals = {0};
+    for (uint32_t i = 0; i < args->num_inputs; i++) {
+        struct stat info;
+        if (stat(args->inputs[i], &info) != 0) {
+            fprintf(stderr, "Cannot find %s\n", args->inputs[i]);
+            totals.failed++;
+        } else if (S_ISDIR(info.st_mode)) {
+            ingest_dir(catalog, args, args->inputs[i], 0, &totals);
+        } else {
+            ingest_file(catalog, args, args->inputs[i], &totals);
+        }
+    }
+    event_catalog_close(catalog);
+
+    printf("Ingested %llu new events from %u logs into %s\n", (unsigned long long)totals.events,
+           totals.logs, args->catalog);
+    return totals.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+typedef struct {
+    event_catalog_record_t *records;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} query_results_t;
+
+static bool collect(const event_catalog_record_t *record, void *user) {
+    query_results_t *results = user;
+    if (results->count == results->capacity) {
+        size_t capacity = results->capacity ? results->capacity * 2 : 1024;
+        event_catalog_record_t *grown = realloc(results->records, capacity * sizeof(*grown));
+        if (!grown) {
+            results->failed = true;
+            return false;
+        }
+        results->records = grown;
+        results->capacity = capacity;
+    }
+    results->records[results->count++] = *record;
+    return true;
+}
+
+static int compare_start(const void *a, const void *b) {
+    const event_catalog_record_t *x = a, *y = b;
+    if (x->t_start != y->t_start) return x->t_start < y->t_start ? -1 : 1;
+    return x->f_low < y->f_low ? -1 : x->f_low > y->f_low;
+}
+
+static int run_query(const args_t *args) {
+    event_catalog_t *catalog = event_catalog_open(args->catalog, false);
+    if (!catalog) return EXIT_FAILURE;
+
+    query_results_t results = {0};
+    event_catalog_stats_t stats;
+    bool ok = event_catalog_query(catalog, &args->query, collect, &results, &stats) && !results.failed;
+    if (!ok) {
+        fprintf(stderr, "Failed to read catalog %s\n", args->catalog);
+    } else {
+        if (results.count > 0) qsort(results.records, results.count, sizeof(*results.records), compare_start);
+        printf("t_start_s,t_end_s,f_low_Hz,f_high_Hz,snr_dB,peak_dBFS,modulation_guess,confidence_0_1,source\n");
+        for (size_t i = 0; i < results.count; i++) {
+            const event_catalog_record_t *r = &results.records[i];
+            const event_catalog_source_t *source = event_catalog_source_by_id(catalog, r->source);
+            printf("%.6f,%.6f,%.3f,%.3f,%.2f,%.2f,%s,%.3f,%s\n", r->t_start, r->t_end, r->f_low, r->f_high,
+                   r->snr_db, r->peak_dbfs, r->modulation[0] ? r->modulation : "unknown", r->confidence,
+                   source ? source->path : "");
+        }
+        fprintf(stderr, "%llu events; %u of %u partitions read, %llu records examined\n",
+                (unsigned long long)stats.matches, stats.partitions_read, stats.partitions,
+                (unsigned long long)stats.records_read);
+    }
+    free(results.records);
+    event_catalog_close(catalog);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    args_t args;
+    if (!parse_args(argc, argv, &args)) {
+        return EXIT_FAILURE;
+    }
+    return args.ingest ? run_ingest(&args) : run_query(&args);
+}
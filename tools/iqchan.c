@@ -4,9 +4,32 @@
  * Purpose: Channelize wideband IQ signals into multiple narrow-band channels
  * using efficient polyphase filter bank techniques for signal analysis.
  *
- * Usage: iqchan --in <input.iq> --format {s8|s16} --rate <sample_rate> \
+ * Usage: iqchan --in <input.iq> --format {s8|s16|s12|s4} --rate <sample_rate> \
  *               --channels <N> --bandwidth <Hz> --out <output_dir>
+ *               [--select <list>] [--mode {auto|pfb|ddc}] [--threads <N>]
+ *        iqchan --in <input.iq> --format <fmt> --rate <sample_rate> \
+ *               --plan <plan.yaml> --out <output_dir>
  *
+ * With --select only the listed channels are written. For a few of them
+ * a per-channel DDC bank (ddc.h) replaces the full filter bank; auto mode
+ * switches back to the PFB once the cost model says it is cheaper.
+ *
+ * With --threads above 1 the full bank only filters: per-channel tasks on
+ * a pool of scheduler workers drain its channel rings in place, convert
+ * the samples and write each channel's .iq and .sigmf-meta, so large banks
+ * are no longer bound by writing one file after another.
+ *
+ * --profile times the channelizer and the channel writes (profile.h).
+ *
+ * --checkpoint saves the stream position, the filter state and the size
+ * of every channel file at intervals of --checkpoint-every seconds of
+ * input (checkpoint.h); after a crash, --resume continues from there and
+ * the channel files end up as an uninterrupted run would leave them.
+ *
+ * --plan replaces the uniform bank with a list of channels of any center,
+ * bandwidth and rate (chanplan.h): narrow channels that fit a common grid
+ * share filter banks, the rest get their own translating decimators, and
+ * the cost of that choice is reported before the run.
  *
  * Date: 2025
  */
@@ -19,10 +42,29 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <stdatomic.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
 #include "../src/iq_core/io_iq.h"
+#include "../src/iq_core/io_async.h"
+#include "../src/iq_core/io_stream.h"
 #include "../src/iq_core/io_sigmf.h"
+#include "../src/iq_core/profile.h"
+#include "../src/iq_core/affinity.h"
+#include "../src/iq_core/checkpoint.h"
+#include "../src/iq_core/stft.h"
 #include "../src/chan/pfb.h"
+#include "../src/chan/ddc.h"
+#include "../src/chan/scheduler.h"
+#include "../src/chan/chanplan.h"
+
+// Upper bound on channel writer threads
+#define IQCHAN_MAX_WRITERS SCHEDULER_MAX_WORKERS
+
+// Default checkpoint interval (seconds of input)
+#define IQCHAN_CHECKPOINT_EVERY_S 60.0
 
 /**
  * @brief Command-line options structure
@@ -37,6 +79,17 @@ typedef struct {
     double channel_bandwidth;
     double overlap;
     uint32_t fft_size;
+    uint32_t oversampling;
+    const char *select_list;
+    const char *mode;
+    const char *plan;
+    uint32_t threads;
+    const char *filter_cache;
+    bool realtime;
+    const char *rt_stats;
+    const char *checkpoint;
+    double checkpoint_every_s;
+    bool resume;
     bool verbose;
     bool help;
 } iqchan_options_t;
@@ -54,6 +107,17 @@ static const iqchan_options_t DEFAULT_OPTIONS = {
     .channel_bandwidth = 250000.0,
     .overlap = 0.1,
     .fft_size = 4096,
+    .select_list = NULL,
+    .mode = "auto",
+    .plan = NULL,
+    .threads = 1,
+    .filter_cache = NULL,
+    .oversampling = 1,
+    .realtime = false,
+    .rt_stats = NULL,
+    .checkpoint = NULL,
+    .checkpoint_every_s = IQCHAN_CHECKPOINT_EVERY_S,
+    .resume = false,
     .verbose = false,
     .help = false
 };
@@ -64,21 +128,48 @@ static const iqchan_options_t DEFAULT_OPTIONS = {
 static void print_usage(const char *program_name) {
     printf("IQ Lab - iqchan: Polyphase Filter Bank Channelizer\n\n");
     printf("USAGE:\n");
-    printf("  %s --in <input.iq> --format {s8|s16} --rate <sample_rate> \\\n", program_name);
+    printf("  %s --in <input.iq> --format {s8|s16|s12|s4} --rate <sample_rate> \\\n", program_name);
     printf("       --channels <N> --bandwidth <Hz> --out <output_dir> [options]\n\n");
 
     printf("REQUIRED ARGUMENTS:\n");
     printf("  --in <file>           Input IQ file path\n");
-    printf("  --format {s8|s16}     IQ data format\n");
+    printf("  --format {s8|s16|s12|s4} IQ data format\n");
     printf("  --rate <Hz>           Sample rate in Hz\n");
-    printf("  --channels <N>        Number of output channels (4-32)\n");
+    printf("  --channels <N>        Number of output channels (%u-%u, power of 2)\n",
+           PFB_MIN_CHANNELS, PFB_MAX_CHANNELS);
     printf("  --bandwidth <Hz>      Bandwidth per channel in Hz\n");
     printf("  --out <dir>           Output directory for channel files\n\n");
 
     printf("OPTIONAL ARGUMENTS:\n");
     printf("  --meta <file>         SigMF metadata file (auto-detected if not specified)\n");
     printf("  --overlap <ratio>     Channel overlap ratio (0.0-0.5, default: 0.1)\n");
-    printf("  --fft <size>          FFT size (power of 2, default: 4096)\n");
+    printf("  --fft <size>          Filter resolution: above 4096 the prototype gets\n");
+    printf("                        size x channels taps (power of 2, default: 4096)\n");
+    printf("  --oversample {1|2}    1: critically sampled channels at rate/channels,\n");
+    printf("                        2: 2x oversampled at 2*rate/channels (default: 1)\n");
+    printf("  --select <list>       Only write these channels, e.g. 3,17,200-203\n");
+    printf("  --mode <m>            auto: DDC per selected channel while cheaper than\n");
+    printf("                        the full bank, else PFB; pfb or ddc force one\n");
+    printf("                        (default: auto)\n");
+    printf("  --plan <file.yaml>    Extract the channels listed in <file.yaml> (any center,\n");
+    printf("                        bandwidth and rate) instead of --channels/--bandwidth;\n");
+    printf("                        prints the cost of the chosen filters first\n");
+    printf("  --threads <N>         Channel writer threads; above 1 the full bank runs\n");
+    printf("                        alone while N writers convert and save the\n");
+    printf("                        channels (default: 1, serial; 0 = one per core)\n");
+    printf("  --filter-cache <dir>  Keep designed filters in <dir>; later runs with\n");
+    printf("                        the same plan load them instead (default: off)\n");
+    printf("  --profile[=<file>]    Per-stage timing on stderr at exit, or as JSON to <file>\n");
+    printf("  --trace <file>        Per-thread timeline of the stages as Chrome trace JSON\n");
+    printf("  --pin[=<policy>]      Pin threads to CPUs: compact (default), scatter, or a\n");
+    printf("                        CPU list such as 0-7,16-23\n");
+    printf("  --realtime            Replay at the sample rate like a live source, reporting deadlines\n");
+    printf("  --rt-stats <file>     Real-time stats as JSON, rewritten every second (implies --realtime)\n");
+    printf("  --checkpoint <file>   Save the run's state to <file> as it goes (file input only)\n");
+    printf("  --checkpoint-every <s> Seconds of input between checkpoints (default: %.0f)\n",
+           IQCHAN_CHECKPOINT_EVERY_S);
+    printf("  --resume              Continue from the --checkpoint file, if there is one,\n");
+    printf("                        with the options of the interrupted run\n");
     printf("  --verbose             Enable verbose output\n");
     printf("  --help                Show this help message\n\n");
 
@@ -87,11 +178,27 @@ static void print_usage(const char *program_name) {
     printf("  %s --in capture.iq --format s16 --rate 2000000 \\\n", program_name);
     printf("       --channels 8 --bandwidth 250000 --out channels/\n\n");
 
+    printf("  # Wideband survey: 1024 channels of 19.5 kHz across 20 MHz\n");
+    printf("  %s --in survey.iq --format s16 --rate 20000000 \\\n", program_name);
+    printf("       --channels 1024 --bandwidth 19531 --out survey_channels/\n\n");
+
+    printf("  # Three channels of a 256-channel bank\n");
+    printf("  %s --in survey.iq --format s16 --rate 20000000 \\\n", program_name);
+    printf("       --channels 256 --bandwidth 78125 --select 12,40,41 --out picks/\n\n");
+
+    printf("  # Mixed plan: a 12.5 kHz grid plus a few wide channels\n");
+    printf("  %s --in site.iq --format s16 --rate 2400000 --plan site.yaml --out site/\n\n",
+           program_name);
+
     printf("  # High-resolution channelization with overlap\n");
     printf("  %s --in signal.iq --format s16 --rate 10000000 \\\n", program_name);
     printf("       --channels 16 --bandwidth 500000 --overlap 0.2 \\\n");
     printf("       --fft 8192 --out high_res_channels/ --verbose\n\n");
 
+    printf("  # Long job that survives a crash: rerun the same command after one\n");
+    printf("  %s --in survey.iq --format s16 --rate 20000000 --channels 1024 \\\n", program_name);
+    printf("       --bandwidth 19531 --out survey_channels/ --checkpoint survey.ckpt --resume\n\n");
+
     printf("OUTPUT:\n");
     printf("  Creates channel_00.iq, channel_00.sigmf-meta,\n");
     printf("  channel_01.iq, channel_01.sigmf-meta, etc.\n\n");
@@ -113,6 +220,20 @@ static bool parse_arguments(int argc, char **argv, iqchan_options_t *options) {
         {"bandwidth", required_argument, 0, 'b'},
         {"overlap", required_argument, 0, 'l'},
         {"fft", required_argument, 0, 'F'},
+        {"oversample", required_argument, 0, 'S'},
+        {"select", required_argument, 0, 'C'},
+        {"mode", required_argument, 0, 'X'},
+        {"plan", required_argument, 0, 'L'},
+        {"threads", required_argument, 0, 'T'},
+        {"filter-cache", required_argument, 0, 'K'},
+        {"profile", optional_argument, 0, 'P'},
+        {"trace", required_argument, 0, 'Q'},
+        {"pin", optional_argument, 0, 'N'},
+        {"realtime", no_argument, 0, 'R'},
+        {"rt-stats", required_argument, 0, 'Y'},
+        {"checkpoint", required_argument, 0, 'k'},
+        {"checkpoint-every", required_argument, 0, 'E'},
+        {"resume", no_argument, 0, 'U'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
@@ -121,7 +242,7 @@ static bool parse_arguments(int argc, char **argv, iqchan_options_t *options) {
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "i:o:f:m:r:c:b:l:F:vh", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "i:o:f:m:r:c:b:l:F:S:C:X:T:K:vh", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'i':
                 options->input_file = optarg;
@@ -150,6 +271,49 @@ static bool parse_arguments(int argc, char **argv, iqchan_options_t *options) {
             case 'F':
                 options->fft_size = (uint32_t)atoi(optarg);
                 break;
+            case 'S':
+                options->oversampling = (uint32_t)atoi(optarg);
+                break;
+            case 'C':
+                options->select_list = optarg;
+                break;
+            case 'X':
+                options->mode = optarg;
+                break;
+            case 'L':
+                options->plan = optarg;
+                break;
+            case 'T':
+                options->threads = (uint32_t)atoi(optarg);
+                break;
+            case 'K':
+                options->filter_cache = optarg;
+                break;
+            case 'P':
+                iq_profile_start("iqchan", optarg);
+                break;
+            case 'Q':
+                if (!iq_trace_start("iqchan", optarg)) return false;
+                break;
+            case 'N':
+                if (!iq_affinity_start(optarg)) return false;
+                break;
+            case 'R':
+                options->realtime = true;
+                break;
+            case 'Y':
+                options->realtime = true;
+                options->rt_stats = optarg;
+                break;
+            case 'k':
+                options->checkpoint = optarg;
+                break;
+            case 'E':
+                options->checkpoint_every_s = atof(optarg);
+                break;
+            case 'U':
+                options->resume = true;
+                break;
             case 'v':
                 options->verbose = true;
                 break;
@@ -165,6 +329,52 @@ static bool parse_arguments(int argc, char **argv, iqchan_options_t *options) {
     return true;
 }
 
+/**
+ * @brief Parse a channel list such as "3,17,200-203"
+ *
+ * @param out Receives the channel indices in list order (num_channels slots)
+ * @param count Receives the number of channels
+ */
+static bool parse_channel_list(const char *list, uint32_t num_channels, uint32_t *out,
+                               uint32_t *count) {
+    bool *seen = (bool *)calloc(num_channels, sizeof(bool));
+    if (!seen) return false;
+
+    *count = 0;
+    const char *p = list;
+    bool ok = true;
+    while (ok && *p) {
+        char *end;
+        unsigned long first = strtoul(p, &end, 10);
+        unsigned long last = first;
+        ok = end != p;
+        if (ok && *end == '-') {
+            p = end + 1;
+            last = strtoul(p, &end, 10);
+            ok = end != p && last >= first;
+        }
+        ok = ok && (*end == ',' || *end == '\0') && last < num_channels;
+        for (unsigned long chan = first; ok && chan <= last; chan++) {
+            if (seen[chan]) {
+                fprintf(stderr, "ERROR: Channel %lu selected twice\n", chan);
+                ok = false;
+                break;
+            }
+            seen[chan] = true;
+            out[(*count)++] = (uint32_t)chan;
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    free(seen);
+
+    if (!ok || *count == 0) {
+        fprintf(stderr, "ERROR: Invalid channel list '%s' (indices 0-%u, e.g. 3,17,200-203)\n",
+                list, num_channels - 1);
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief Validate command-line options
  */
@@ -174,13 +384,15 @@ static bool validate_options(const iqchan_options_t *options) {
         return false;
     }
 
-    if (access(options->input_file, F_OK) != 0) {
+    if (!iq_stream_is_spec(options->input_file) && access(options->input_file, F_OK) != 0) {
         fprintf(stderr, "ERROR: Input file '%s' does not exist\n", options->input_file);
         return false;
     }
 
-    if (options->num_channels < 4 || options->num_channels > 32) {
-        fprintf(stderr, "ERROR: Number of channels must be between 4 and 32\n");
+    if (options->num_channels < PFB_MIN_CHANNELS || options->num_channels > PFB_MAX_CHANNELS ||
+        (options->num_channels & (options->num_channels - 1)) != 0) {
+        fprintf(stderr, "ERROR: Number of channels must be a power of 2 between %u and %u\n",
+                PFB_MIN_CHANNELS, PFB_MAX_CHANNELS);
         return false;
     }
 
@@ -204,11 +416,64 @@ static bool validate_options(const iqchan_options_t *options) {
         return false;
     }
 
-    if (strcmp(options->format, "s8") != 0 && strcmp(options->format, "s16") != 0) {
-        fprintf(stderr, "ERROR: Format must be 's8' or 's16'\n");
+    if (options->oversampling != 1 &&
+        (options->oversampling != 2 || options->num_channels % 2 != 0)) {
+        fprintf(stderr, "ERROR: Oversampling must be 1, or 2 with an even channel count\n");
+        return false;
+    }
+
+    iq_format_t format;
+    if (!iq_parse_format(options->format, &format)) {
+        fprintf(stderr, "ERROR: Format must be 's8', 's16', 's12' or 's4'\n");
         return false;
     }
 
+    if (strcmp(options->mode, "auto") != 0 && strcmp(options->mode, "pfb") != 0 &&
+        strcmp(options->mode, "ddc") != 0) {
+        fprintf(stderr, "ERROR: Mode must be 'auto', 'pfb' or 'ddc'\n");
+        return false;
+    }
+
+    if (options->threads > IQCHAN_MAX_WRITERS) {
+        fprintf(stderr, "ERROR: At most %d writer threads\n", IQCHAN_MAX_WRITERS);
+        return false;
+    }
+
+    if (options->resume && !options->checkpoint) {
+        fprintf(stderr, "ERROR: --resume needs --checkpoint <file>\n");
+        return false;
+    }
+
+    if (options->checkpoint && iq_stream_is_spec(options->input_file)) {
+        fprintf(stderr, "ERROR: --checkpoint needs a file input, not a live stream\n");
+        return false;
+    }
+
+    if (options->checkpoint && !(options->checkpoint_every_s > 0.0)) {
+        fprintf(stderr, "ERROR: Checkpoint interval must be positive\n");
+        return false;
+    }
+
+    if (options->plan && (options->select_list || strcmp(options->mode, "auto") != 0 ||
+                          options->checkpoint)) {
+        fprintf(stderr, "ERROR: --plan chooses its own filters; drop --select, --mode and --checkpoint\n");
+        return false;
+    }
+
+    if (strcmp(options->mode, "ddc") == 0 && !options->select_list) {
+        fprintf(stderr, "ERROR: --mode ddc needs --select\n");
+        return false;
+    }
+
+    if (options->select_list) {
+        uint32_t *selected = (uint32_t *)malloc(options->num_channels * sizeof(uint32_t));
+        uint32_t count = 0;
+        bool ok = selected && parse_channel_list(options->select_list, options->num_channels,
+                                                 selected, &count);
+        free(selected);
+        if (!ok) return false;
+    }
+
     return true;
 }
 
@@ -241,11 +506,147 @@ static bool create_output_directory(const char *dir_path) {
     return true;
 }
 
+/**
+ * @brief Allow one open file per channel
+ *
+ * Large banks keep more channel files open than the default descriptor
+ * limit; raise the soft limit as far as the hard one allows.
+ */
+static void raise_open_file_limit(uint32_t needed) {
+    uint32_t want = needed + 32;  // stdio, input, metadata
+#ifdef _WIN32
+    if (want > 512) {
+        _setmaxstdio(want > 8192 ? 8192 : (int)want);
+    }
+#else
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY ||
+        limit.rlim_cur >= want) {
+        return;
+    }
+    limit.rlim_cur = limit.rlim_max != RLIM_INFINITY && limit.rlim_max < want ? limit.rlim_max : want;
+    setrlimit(RLIMIT_NOFILE, &limit);
+#endif
+}
+
+/**
+ * @brief The full bank or the sparse DDCs, writing the selected channels
+ */
+typedef struct {
+    pfb_t *pfb;                  // Full filter bank (NULL in DDC mode)
+    ddc_bank_t *ddc;             // One DDC per selected channel (NULL in PFB mode)
+    uint32_t *selected;          // Channel index of every output slot
+    uint32_t num_selected;       // Number of output slots
+    bool *written;               // Per PFB channel: selected (NULL when all are)
+} channelizer_t;
+
+/**
+ * @brief Where the selected channels go
+ */
+typedef struct {
+    const iqchan_options_t *options;
+    FILE **files;                // Per slot, opened on the first output
+    uint64_t *samples;           // Per slot, outputs written
+    iq_format_t format;          // Output sample format
+    double output_rate;          // Channel sample rate (Hz)
+    double bandwidth;            // Channel bandwidth (Hz)
+} channel_sink_t;
+
+static int32_t channelizer_process(channelizer_t *chz, const float complex *samples, uint32_t count) {
+    uint64_t start = iq_profile_begin();
+    int32_t processed = chz->ddc ? ddc_bank_process_block(chz->ddc, samples, count)
+                                 : pfb_process_block(chz->pfb, samples, count);
+    iq_profile_end(IQ_PROFILE_CHANNELIZE, start, processed > 0 ? (uint64_t)processed : 0,
+                   processed > 0 ? (uint64_t)processed * sizeof(float complex) : 0);
+    return processed;
+}
+
+// <out>/channel_NN.iq
+static void channel_path(const channel_sink_t *sink, uint32_t chan, char *path, size_t size) {
+    snprintf(path, size, "%s/channel_%02u.iq", sink->options->output_dir, chan);
+}
+
+/**
+ * @brief Append outputs to a slot's file, opening it on first use
+ */
+static bool write_channel(channel_sink_t *sink, uint32_t slot, uint32_t chan,
+                          const float complex *data, uint32_t count) {
+    if (!sink->files[slot]) {
+        char channel_filename[512];
+        channel_path(sink, chan, channel_filename, sizeof(channel_filename));
+        sink->files[slot] = fopen(channel_filename, "wb");
+        if (!sink->files[slot]) {
+            fprintf(stderr, "ERROR: Failed to save channel %u: %s\n", chan, strerror(errno));
+            return false;
+        }
+    }
+
+    uint64_t start = iq_profile_begin();
+    bool written = iq_write_samples(sink->files[slot], (const float *)data, count, sink->format);
+    iq_profile_end(IQ_PROFILE_WRITE, start, count, (uint64_t)count * 2 * iq_format_bits(sink->format) / 8);
+    if (!written) {
+        fprintf(stderr, "ERROR: Failed to save channel %u\n", chan);
+        return false;
+    }
+    sink->samples[slot] += count;
+    return true;
+}
+
+/**
+ * @brief Drop the PFB outputs of every channel nobody asked for
+ *
+ * The caller is the only consumer of those rings.
+ */
+static void release_unselected(channelizer_t *chz) {
+    if (!chz->pfb || !chz->written) {
+        return;
+    }
+
+    for (uint32_t chan = 0; chan < chz->pfb->num_channels; chan++) {
+        if (!chz->written[chan]) {
+            pfb_reset_channel_output(chz->pfb, chan);
+        }
+    }
+}
+
+/**
+ * @brief Append every selected channel's buffered outputs to its file
+ *
+ * PFB outputs are written straight from the channel rings and committed
+ * once on disk.
+ */
+static bool drain_channels(channelizer_t *chz, channel_sink_t *sink) {
+    for (uint32_t slot = 0; slot < chz->num_selected; slot++) {
+        uint32_t chan = chz->selected[slot];
+        uint32_t samples_available;
+        const float complex *channel_data =
+            chz->ddc ? ddc_bank_get_channel_output(chz->ddc, slot, &samples_available)
+                     : pfb_channel_read(chz->pfb, chan, &samples_available);
+        if (!channel_data || samples_available == 0) {
+            continue;
+        }
+
+        if (!write_channel(sink, slot, chan, channel_data, samples_available)) {
+            return false;
+        }
+        if (chz->ddc) {
+            ddc_bank_reset_channel_output(chz->ddc, slot);
+        } else {
+            pfb_channel_commit(chz->pfb, chan, samples_available);
+        }
+    }
+
+    // The full bank fills every channel; drop the ones nobody asked for
+    release_unselected(chz);
+    return true;
+}
+
 /**
  * @brief Generate channel metadata
  */
 static bool generate_channel_metadata(const char *output_dir, uint32_t channel_index,
-                                    const iqchan_options_t *options, pfb_t *pfb) {
+                                    const iqchan_options_t *options, double output_rate,
+                                    double center_frequency, double bandwidth) {
     char meta_filename[512];
     snprintf(meta_filename, sizeof(meta_filename), "%s/channel_%02u.sigmf-meta",
              output_dir, channel_index);
@@ -254,23 +655,26 @@ static bool generate_channel_metadata(const char *output_dir, uint32_t channel_i
     sigmf_metadata_t meta = {0};
 
     // Global metadata
-    strcpy(meta.global.datatype, strcmp(options->format, "s8") == 0 ? "ci8" : "ci16");
-    meta.global.sample_rate = (uint64_t)options->sample_rate;
+    // Datatype follows the sample width: ci8, ci16, ci12 or ci4
+    iq_format_t format = IQ_FORMAT_S16;
+    iq_parse_format(options->format, &format);
+    snprintf(meta.global.datatype, sizeof(meta.global.datatype), "ci%u", iq_format_bits(format));
+    meta.global.sample_rate = (uint64_t)output_rate;
     strcpy(meta.global.version, "1.2.0");
     snprintf(meta.global.description, sizeof(meta.global.description),
              "Channel %u extracted by iqchan from wideband signal", channel_index);
 
     // Captures metadata
     meta.num_captures = 1;
-    meta.captures = (sigmf_capture_t *)malloc(sizeof(sigmf_capture_t));
+    meta.captures = (sigmf_capture_t *)calloc(1, sizeof(sigmf_capture_t));
     if (!meta.captures) return false;
 
     meta.captures[0].sample_start = 0;
-    meta.captures[0].frequency = (uint64_t)pfb_get_channel_frequency(pfb, channel_index);
+    meta.captures[0].frequency = (uint64_t)center_frequency;
 
     // Annotations metadata
     meta.num_annotations = 1;
-    meta.annotations = (sigmf_annotation_t *)malloc(sizeof(sigmf_annotation_t));
+    meta.annotations = (sigmf_annotation_t *)calloc(1, sizeof(sigmf_annotation_t));
     if (!meta.annotations) {
         free(meta.captures);
         return false;
@@ -278,15 +682,11 @@ static bool generate_channel_metadata(const char *output_dir, uint32_t channel_i
 
     meta.annotations[0].sample_start = 0;
     meta.annotations[0].sample_count = 0; // Will be updated when writing
-    meta.annotations[0].freq_lower_edge = (uint64_t)(pfb_get_channel_frequency(pfb, channel_index) -
-                                                   pfb_get_channel_bandwidth(pfb, channel_index) / 2.0);
-    meta.annotations[0].freq_upper_edge = (uint64_t)(pfb_get_channel_frequency(pfb, channel_index) +
-                                                   pfb_get_channel_bandwidth(pfb, channel_index) / 2.0);
+    meta.annotations[0].freq_lower_edge = (uint64_t)(center_frequency - bandwidth / 2.0);
+    meta.annotations[0].freq_upper_edge = (uint64_t)(center_frequency + bandwidth / 2.0);
     snprintf(meta.annotations[0].description, sizeof(meta.annotations[0].description),
              "Channel %u: center=%.0f Hz, bandwidth=%.0f Hz",
-             channel_index,
-             pfb_get_channel_frequency(pfb, channel_index),
-             pfb_get_channel_bandwidth(pfb, channel_index));
+             channel_index, center_frequency, bandwidth);
 
     // Write metadata
     bool success = sigmf_write_metadata(meta_filename, &meta);
@@ -298,6 +698,439 @@ static bool generate_channel_metadata(const char *output_dir, uint32_t channel_i
     return success;
 }
 
+/**
+ * @brief Close a slot's file and write its metadata
+ */
+static void finish_channel(const channelizer_t *chz, channel_sink_t *sink, uint32_t slot,
+                           bool write_ok) {
+    if (!sink->files[slot]) {
+        return;
+    }
+
+    uint32_t chan = chz->selected[slot];
+    double center = chz->ddc ? chz->ddc->channels[slot].center_frequency
+                             : pfb_get_channel_frequency(chz->pfb, chan);
+    bool save_success = fclose(sink->files[slot]) == 0 && write_ok;
+    sink->files[slot] = NULL;
+    if (save_success) {
+        // Generate metadata
+        if (generate_channel_metadata(sink->options->output_dir, chan, sink->options,
+                                      sink->output_rate, center, sink->bandwidth)) {
+            if (sink->options->verbose) {
+                printf("💾 Saved channel %u: %llu samples, center=%.0f Hz\n",
+                       chan, (unsigned long long)sink->samples[slot], center);
+            }
+        } else {
+            fprintf(stderr, "WARNING: Failed to generate metadata for channel %u\n", chan);
+        }
+    } else {
+        fprintf(stderr, "ERROR: Failed to save channel %u\n", chan);
+    }
+}
+
+/*
+ * Channel writer pool
+ *
+ *   reader --> filter bank (this thread) --> channel rings --> scheduler tasks
+ *
+ * The filter bank is the only producer of the PFB channel rings. Whenever
+ * half a ring has been produced every output slot gets a write task on the
+ * scheduler (scheduler.h), unless its previous one is still queued, so each
+ * ring has one consumer at a time and every file is written in stream
+ * order, matching the serial loop. When the bank pauses on a full ring the
+ * producer waits for the queued tasks. Unselected channels are dropped by
+ * the producer itself. Once the stream ends a last write task per slot
+ * takes the remaining outputs, and a finish task closes the slot's file and
+ * writes its metadata.
+ */
+
+typedef struct {
+    channelizer_t *chz;
+    channel_sink_t *sink;
+    scheduler_t *scheduler;      // num_writers workers
+    atomic_bool *queued;         // Per slot: a write task is queued or running
+    atomic_bool failed;          // A write failed; later tasks skip theirs
+} iqchan_pool_t;
+
+// Write every readable span of one slot (the task's channel_id)
+static bool write_task(channel_task_t *task, void *user_data) {
+    iqchan_pool_t *pool = user_data;
+    channelizer_t *chz = pool->chz;
+    uint32_t slot = task->channel_id;
+    uint32_t chan = chz->selected[slot];
+    bool ok = true;
+
+    uint32_t count;
+    const float complex *data = pfb_channel_read(chz->pfb, chan, &count);
+    if (data && count > 0 && !atomic_load(&pool->failed)) {
+        ok = write_channel(pool->sink, slot, chan, data, count);
+        if (ok) {
+            pfb_channel_commit(chz->pfb, chan, count);
+        } else {
+            atomic_store(&pool->failed, true);
+        }
+    }
+
+    // Releases the ring and the slot's file to the next task
+    atomic_store_explicit(&pool->queued[slot], false, memory_order_release);
+    return ok;
+}
+
+// Close one slot's file and write its metadata
+static bool finish_task(channel_task_t *task, void *user_data) {
+    iqchan_pool_t *pool = user_data;
+    finish_channel(pool->chz, pool->sink, task->channel_id, !atomic_load(&pool->failed));
+    return true;
+}
+
+// Queue a write task for every slot that has none queued
+static void pool_signal(iqchan_pool_t *pool) {
+    for (uint32_t slot = 0; slot < pool->chz->num_selected; slot++) {
+        if (atomic_exchange_explicit(&pool->queued[slot], true, memory_order_acquire)) {
+            continue;
+        }
+
+        channel_task_t task = {0};
+        task.channel_id = slot;
+        task.run = write_task;
+        task.user_data = pool;
+        if (scheduler_add_task(pool->scheduler, &task) < 0) {
+            // Table full: the next signal retries
+            atomic_store(&pool->queued[slot], false);
+        }
+    }
+}
+
+// Write out what the rings hold and wait for it; false once a write failed
+static bool pool_wait_for_space(iqchan_pool_t *pool) {
+    pool_signal(pool);
+    uint64_t start = iq_profile_begin();
+    scheduler_wait(pool->scheduler);
+    iq_profile_end(IQ_PROFILE_WAIT, start, 0, 0);
+    return !atomic_load(&pool->failed);
+}
+
+// Free the pool's scheduler and flags
+static void pool_destroy(iqchan_pool_t *pool) {
+    scheduler_destroy(pool->scheduler);
+    free(pool->queued);
+}
+
+// End the stream: write the last outputs, finish every channel and free
+// the pool; false if a write failed
+static bool pool_finish(iqchan_pool_t *pool) {
+    pool_wait_for_space(pool);
+
+    for (uint32_t slot = 0; slot < pool->chz->num_selected; slot++) {
+        channel_task_t task = {0};
+        task.channel_id = slot;
+        task.run = finish_task;
+        task.user_data = pool;
+        while (scheduler_add_task(pool->scheduler, &task) == -2) {
+            scheduler_wait(pool->scheduler);
+        }
+    }
+    scheduler_wait(pool->scheduler);
+
+    bool ok = !atomic_load(&pool->failed);
+    pool_destroy(pool);
+    return ok;
+}
+
+// Start num_writers workers over the channel rings
+static bool pool_start(iqchan_pool_t *pool, channelizer_t *chz, channel_sink_t *sink,
+                       uint32_t num_writers) {
+    memset(pool, 0, sizeof(*pool));
+    pool->chz = chz;
+    pool->sink = sink;
+    atomic_init(&pool->failed, false);
+
+    // One write and one finish task per slot fit in the table
+    scheduler_config_t config;
+    scheduler_config_init(&config, chz->num_selected);
+    config.num_workers = num_writers;
+    pool->scheduler = scheduler_create(&config);
+    pool->queued = (atomic_bool *)calloc(chz->num_selected, sizeof(atomic_bool));
+    if (!pool->scheduler || !pool->queued) {
+        fprintf(stderr, "ERROR: Failed to start %u channel writers\n", num_writers);
+        pool_destroy(pool);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Checkpoints
+ *
+ * A checkpoint is taken between input blocks, once every output the
+ * channelizer has produced is in the channel files: the filter state then
+ * stands for exactly the input consumed, and the files for exactly the
+ * outputs. Resuming restores both, cuts the files back to their recorded
+ * sizes and reads on from the recorded input sample.
+ */
+
+// Stream position, with the shape of the run it belongs to
+typedef struct {
+    uint64_t samples_processed;  // Input samples the channelizer consumed
+    uint32_t num_channels;
+    uint32_t num_selected;
+    uint32_t format;
+    uint32_t ddc;                // DDC bank, else the full bank
+} iqchan_checkpoint_t;
+
+// One output slot
+typedef struct {
+    uint32_t channel;
+    uint32_t open;               // The file exists
+    uint64_t samples;            // Outputs written
+    uint64_t bytes;              // File size
+} iqchan_slot_state_t;
+
+// Write the checkpoint; the channel buffers must have been drained
+static bool save_checkpoint(const channelizer_t *chz, channel_sink_t *sink,
+                            uint64_t samples_processed) {
+    const iqchan_options_t *options = sink->options;
+    iqchan_checkpoint_t state = {
+        .samples_processed = samples_processed,
+        .num_channels = options->num_channels,
+        .num_selected = chz->num_selected,
+        .format = (uint32_t)sink->format,
+        .ddc = chz->ddc != NULL
+    };
+    iqchan_slot_state_t *slots = (iqchan_slot_state_t *)calloc(chz->num_selected, sizeof(*slots));
+    bool ok = slots != NULL;
+    for (uint32_t slot = 0; ok && slot < chz->num_selected; slot++) {
+        slots[slot].channel = chz->selected[slot];
+        slots[slot].samples = sink->samples[slot];
+        if (sink->files[slot]) {
+            slots[slot].open = 1;
+            ok = checkpoint_sync_output(sink->files[slot], &slots[slot].bytes);
+        }
+    }
+
+    checkpoint_writer_t writer;
+    uint64_t start = iq_profile_begin();
+    ok = ok && checkpoint_begin(&writer, options->checkpoint, "iqchan");
+    if (ok) {
+        bool saved = checkpoint_put(&writer, "iqchan.stream", &state, sizeof(state)) &&
+                     checkpoint_put(&writer, "iqchan.slots", slots, chz->num_selected * sizeof(*slots)) &&
+                     (chz->ddc ? ddc_bank_save_state(chz->ddc, &writer) : pfb_save_state(chz->pfb, &writer));
+        if (saved) {
+            ok = checkpoint_commit(&writer);
+        } else {
+            checkpoint_abort(&writer);
+            ok = false;
+        }
+    }
+    iq_profile_end(IQ_PROFILE_WRITE, start, 0, 0);
+    free(slots);
+
+    if (!ok) {
+        fprintf(stderr, "WARNING: Failed to write checkpoint %s\n", options->checkpoint);
+    } else if (options->verbose) {
+        printf("💾 Checkpoint at sample %llu\n", (unsigned long long)samples_processed);
+    }
+    return ok;
+}
+
+// Drain every channel, then save the checkpoint; false if a write failed
+static bool take_checkpoint(channelizer_t *chz, channel_sink_t *sink, iqchan_pool_t *pool,
+                            uint64_t samples_processed) {
+    // The writers take what they can; the rest is written here while they are idle
+    if ((pool && !pool_wait_for_space(pool)) || !drain_channels(chz, sink)) {
+        return false;
+    }
+    save_checkpoint(chz, sink, samples_processed);
+    return true;
+}
+
+/**
+ * @brief Continue from the checkpoint: filter state, channel files and input position
+ *
+ * Without a checkpoint file the run starts from the beginning.
+ */
+static bool resume_checkpoint(channelizer_t *chz, channel_sink_t *sink, iq_reader_t *reader,
+                              uint64_t *samples_processed) {
+    const iqchan_options_t *options = sink->options;
+    if (access(options->checkpoint, F_OK) != 0) {
+        if (options->verbose) {
+            printf("📍 No checkpoint yet, starting from the beginning\n");
+        }
+        return true;
+    }
+
+    checkpoint_t checkpoint;
+    if (!checkpoint_load(&checkpoint, options->checkpoint, "iqchan")) {
+        return false;
+    }
+
+    iqchan_checkpoint_t state;
+    iqchan_slot_state_t *slots = (iqchan_slot_state_t *)calloc(chz->num_selected, sizeof(*slots));
+    bool ok = slots && checkpoint_get(&checkpoint, "iqchan.stream", &state, sizeof(state)) &&
+              state.num_channels == options->num_channels && state.num_selected == chz->num_selected &&
+              state.format == (uint32_t)sink->format && state.ddc == (chz->ddc != NULL) &&
+              checkpoint_get(&checkpoint, "iqchan.slots", slots, chz->num_selected * sizeof(*slots));
+    for (uint32_t slot = 0; ok && slot < chz->num_selected; slot++) {
+        ok = slots[slot].channel == chz->selected[slot];
+    }
+    ok = ok && (chz->ddc ? ddc_bank_load_state(chz->ddc, &checkpoint)
+                         : pfb_load_state(chz->pfb, &checkpoint));
+    checkpoint_free(&checkpoint);
+    if (!ok) {
+        fprintf(stderr, "ERROR: Checkpoint %s does not match these options\n", options->checkpoint);
+        free(slots);
+        return false;
+    }
+
+    for (uint32_t slot = 0; ok && slot < chz->num_selected; slot++) {
+        sink->samples[slot] = slots[slot].samples;
+        if (slots[slot].open) {
+            char path[512];
+            channel_path(sink, chz->selected[slot], path, sizeof(path));
+            sink->files[slot] = checkpoint_reopen_output(path, slots[slot].bytes);
+            ok = sink->files[slot] != NULL;
+        }
+    }
+    free(slots);
+    if (ok && !iq_reader_seek_sample(reader, state.samples_processed)) {
+        fprintf(stderr, "ERROR: Input is shorter than the checkpoint\n");
+        ok = false;
+    }
+    if (ok) {
+        *samples_processed = state.samples_processed;
+        if (options->verbose) {
+            printf("📍 Resuming at sample %llu\n", (unsigned long long)state.samples_processed);
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Report how a designed plan extracts its channels
+ */
+static void print_plan(const chanplan_t *plan) {
+    printf("🗺️  Channel plan: %u channels, %u shared bank%s\n", plan->num_channels, plan->num_banks,
+           plan->num_banks == 1 ? "" : "s");
+    for (uint32_t b = 0; b < plan->num_banks; b++) {
+        const chanplan_bank_t *bank = &plan->banks[b];
+        printf("   Bank %u: %u bins of %.0f Hz, %u channels, %.1f MAC/sample\n", b,
+               bank->config.num_channels, plan->sample_rate / bank->config.num_channels,
+               bank->num_members, bank->cost);
+    }
+    for (uint32_t c = 0; c < plan->num_channels; c++) {
+        const chanplan_channel_t *channel = &plan->channels[c];
+        char via[64];
+        if (channel->path == CHANPLAN_PFB) {
+            snprintf(via, sizeof(via), "bank %u bin %u", channel->bank, channel->bin);
+        } else {
+            snprintf(via, sizeof(via), "decimate by %u", channel->decimation);
+        }
+        printf("   %02u %-16s %+12.0f Hz  %8.0f Hz wide  %8u Hz  %-16s %6.2f MAC/sample\n", c,
+               channel->name[0] ? channel->name : "-", channel->center, channel->bandwidth,
+               channel->rate, via, channel->cost);
+    }
+    printf("   Total: %.1f MAC/sample (every channel on its own: %.1f)\n", plan->total_cost,
+           plan->individual_cost);
+}
+
+// Plan outputs go straight to their channel files
+static bool plan_sink(uint32_t channel, const float complex *samples, uint32_t count, void *user) {
+    return write_channel((channel_sink_t *)user, channel, channel, samples, count);
+}
+
+/**
+ * @brief Process IQ file through a channel plan
+ */
+static bool process_plan(const iqchan_options_t *options) {
+    chanplan_t plan;
+    char error[256];
+    if (!chanplan_load(&plan, options->plan, error, sizeof(error))) {
+        fprintf(stderr, "ERROR: Plan %s: %s\n", options->plan, error);
+        return false;
+    }
+    if (!chanplan_design(&plan, options->sample_rate, error, sizeof(error))) {
+        fprintf(stderr, "ERROR: Plan %s: %s\n", options->plan, error);
+        chanplan_free(&plan);
+        return false;
+    }
+    print_plan(&plan);
+
+    if (!create_output_directory(options->output_dir)) {
+        chanplan_free(&plan);
+        return false;
+    }
+
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, options->input_file)) {
+        fprintf(stderr, "ERROR: Failed to load IQ file '%s'\n", options->input_file);
+        chanplan_free(&plan);
+        return false;
+    }
+
+    const uint32_t block_size = 4096;
+    chanplan_runner_t *runner = chanplan_runner_create(&plan);
+    rt_monitor_t *monitor = options->realtime ?
+        rt_monitor_create("iqchan", options->sample_rate, 0.0, options->rt_stats) : NULL;
+    iq_async_t *async = iq_async_create_realtime(&reader, block_size, IQ_ASYNC_NUM_BLOCKS,
+                                                 monitor ? options->sample_rate : 0.0, monitor);
+    channel_sink_t sink = {
+        .options = options,
+        .files = (FILE **)calloc(plan.num_channels, sizeof(FILE *)),
+        .samples = (uint64_t *)calloc(plan.num_channels, sizeof(uint64_t)),
+        .format = IQ_FORMAT_S16
+    };
+    iq_parse_format(options->format, &sink.format);   // Validated with the options
+    raise_open_file_limit(plan.num_channels);
+
+    bool ok = runner && async && sink.files && sink.samples && (monitor || !options->realtime);
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to set up the channel plan\n");
+    }
+
+    uint64_t samples_processed = 0;
+    const iq_async_block_t *input_block;
+    while (ok && (input_block = iq_async_acquire(async)) != NULL) {
+        uint64_t start = iq_profile_begin();
+        ok = chanplan_runner_process(runner, (const float complex *)input_block->samples,
+                                     (uint32_t)input_block->num_samples, plan_sink, &sink);
+        iq_profile_end(IQ_PROFILE_CHANNELIZE, start, input_block->num_samples,
+                       input_block->num_samples * sizeof(float complex));
+        samples_processed += input_block->num_samples;
+        iq_async_release(async, input_block);
+        rt_monitor_poll(monitor);
+    }
+    iq_async_destroy(async);
+    rt_monitor_destroy(monitor);
+
+    if (options->verbose) {
+        printf("✅ Processing complete: %llu samples processed\n", (unsigned long long)samples_processed);
+    }
+
+    // Close channel files and write their metadata
+    for (uint32_t c = 0; sink.files && c < plan.num_channels; c++) {
+        if (!sink.files[c]) continue;
+        const chanplan_channel_t *channel = &plan.channels[c];
+        double center = plan.center_frequency + channel->center;
+        bool saved = fclose(sink.files[c]) == 0 && ok;
+        if (!saved) {
+            fprintf(stderr, "ERROR: Failed to save channel %u\n", c);
+        } else if (!generate_channel_metadata(options->output_dir, c, options, channel->rate, center,
+                                              channel->bandwidth)) {
+            fprintf(stderr, "WARNING: Failed to generate metadata for channel %u\n", c);
+        } else if (options->verbose) {
+            printf("💾 Saved channel %u: %llu samples, center=%.0f Hz\n",
+                   c, (unsigned long long)sink.samples[c], center);
+        }
+    }
+    free(sink.files);
+    free(sink.samples);
+    chanplan_runner_destroy(runner);
+    iq_reader_close(&reader);
+    chanplan_free(&plan);
+    return ok;
+}
+
 /**
  * @brief Process IQ file through channelizer
  */
@@ -311,9 +1144,9 @@ static bool process_file(const iqchan_options_t *options) {
         printf("📁 Created output directory: %s\n", options->output_dir);
     }
 
-    // Load IQ data
-    iq_data_t iq_data = {0};
-    bool load_success = iq_load_file(options->input_file, &iq_data);
+    // Open IQ data for streaming
+    iq_reader_t reader;
+    bool load_success = iq_reader_open(&reader, options->input_file);
 
     if (!load_success) {
         fprintf(stderr, "ERROR: Failed to load IQ file '%s'\n", options->input_file);
@@ -321,27 +1154,23 @@ static bool process_file(const iqchan_options_t *options) {
     }
 
     if (options->verbose) {
-        printf("📡 Loaded IQ data: %llu samples, %.0f Hz sample rate\n",
-               (unsigned long long)iq_data.num_samples, (double)iq_data.sample_rate);
+        printf("📡 Opened IQ data: %llu samples, %.0f Hz sample rate\n",
+               (unsigned long long)reader.total_samples, (double)options->sample_rate);
     }
 
-    // Override sample rate if specified
-    iq_data.sample_rate = options->sample_rate;
-
     // Initialize PFB channelizer
     pfb_config_t pfb_config;
     if (!pfb_config_init(&pfb_config, options->num_channels,
                         options->sample_rate, options->channel_bandwidth)) {
         fprintf(stderr, "ERROR: Failed to initialize PFB configuration\n");
-        iq_free(&iq_data);
+        iq_reader_close(&reader);
         return false;
     }
 
-    // Override FFT size and ensure filter_length is compatible
-    pfb_config.fft_size = options->fft_size;
-    // Adjust filter_length to be at least as large as FFT size and divisible by num_channels
-    if (pfb_config.fft_size > pfb_config.filter_length) {
-        pfb_config.filter_length = pfb_config.fft_size * pfb_config.num_channels;
+    // A larger --fft buys a longer prototype: filter_length stays a power of 2
+    // and divisible by num_channels
+    if (options->fft_size > pfb_config.filter_length) {
+        pfb_config.filter_length = options->fft_size * pfb_config.num_channels;
         // Round up to next power of 2 for efficiency
         uint32_t power_of_2 = 1;
         while (power_of_2 < pfb_config.filter_length) {
@@ -350,27 +1179,78 @@ static bool process_file(const iqchan_options_t *options) {
         pfb_config.filter_length = power_of_2;
     }
     pfb_config.overlap_factor = options->overlap;
+    pfb_config.oversampling = options->oversampling;
+    if (options->filter_cache) {
+        if (!create_output_directory(options->filter_cache)) {
+            iq_reader_close(&reader);
+            return false;
+        }
+        pfb_config.cache_dir = options->filter_cache;
+    }
 
     if (options->verbose) {
         printf("🔧 PFB Configuration:\n");
         printf("   Channels: %u\n", pfb_config.num_channels);
         printf("   Sample Rate: %.0f Hz\n", pfb_config.sample_rate);
         printf("   Channel BW: %.0f Hz\n", pfb_config.channel_bandwidth);
-        printf("   FFT Size: %u\n", pfb_config.fft_size);
+        printf("   Filter Length: %u taps (%u per branch)\n", pfb_config.filter_length,
+               pfb_config.filter_length / pfb_config.num_channels);
+        printf("   Oversampling: %ux\n", pfb_config.oversampling);
         printf("   Overlap: %.2f\n", pfb_config.overlap_factor);
+        if (pfb_config.cache_dir) printf("   Filter Cache: %s\n", pfb_config.cache_dir);
     }
 
-    pfb_t *pfb = pfb_create(&pfb_config);
-    if (!pfb) {
+    // Channels to write: the --select list, or all of them
+    channelizer_t chz = {0};
+    chz.selected = (uint32_t *)malloc(options->num_channels * sizeof(uint32_t));
+    if (!chz.selected) {
+        fprintf(stderr, "ERROR: Memory allocation failed\n");
+        iq_reader_close(&reader);
+        return false;
+    }
+    if (options->select_list) {
+        if (!parse_channel_list(options->select_list, options->num_channels, chz.selected,
+                                &chz.num_selected)) {
+            free(chz.selected);
+            iq_reader_close(&reader);
+            return false;
+        }
+    } else {
+        for (uint32_t chan = 0; chan < options->num_channels; chan++) chz.selected[chan] = chan;
+        chz.num_selected = options->num_channels;
+    }
+
+    // A DDC per selected channel while that is cheaper than the full bank
+    bool use_ddc = strcmp(options->mode, "ddc") == 0 ||
+                   (strcmp(options->mode, "auto") == 0 && options->select_list &&
+                    ddc_bank_preferred(&pfb_config, chz.num_selected));
+    if (options->verbose) {
+        printf("🧮 Extracting %u of %u channels via %s (cost: DDC %.1f, PFB %.1f MAC/sample)\n",
+               chz.num_selected, pfb_config.num_channels, use_ddc ? "DDC" : "PFB",
+               ddc_estimate_cost(&pfb_config, chz.num_selected), pfb_estimate_cost(&pfb_config));
+    }
+
+    if (use_ddc) {
+        chz.ddc = ddc_bank_create(&pfb_config, chz.selected, chz.num_selected);
+        if (!chz.ddc) {
+            fprintf(stderr, "ERROR: Failed to create DDC bank\n");
+            free(chz.selected);
+            iq_reader_close(&reader);
+            return false;
+        }
+    } else {
+        chz.pfb = pfb_create(&pfb_config);
+    }
+    if (!use_ddc && !chz.pfb) {
         fprintf(stderr, "ERROR: Failed to create PFB channelizer\n");
-        fprintf(stderr, "  Debug info: channels=%u, sample_rate=%.0f, bandwidth=%.0f, fft_size=%u\n",
+        fprintf(stderr, "  Debug info: channels=%u, sample_rate=%.0f, bandwidth=%.0f, filter_length=%u\n",
                 pfb_config.num_channels, pfb_config.sample_rate,
-                pfb_config.channel_bandwidth, pfb_config.fft_size);
+                pfb_config.channel_bandwidth, pfb_config.filter_length);
 
         // Try to create with minimal config to isolate the issue
         pfb_config_t debug_config;
         if (pfb_config_init(&debug_config, 4, 1000000.0, 100000.0)) {
-            debug_config.fft_size = 1024; // Smaller FFT
+            debug_config.filter_length = 1024; // Shorter filter
             pfb_t *debug_pfb = pfb_create(&debug_config);
             if (debug_pfb) {
                 printf("  Debug: Minimal config works, issue with original config\n");
@@ -380,7 +1260,8 @@ static bool process_file(const iqchan_options_t *options) {
             }
         }
 
-        iq_free(&iq_data);
+        free(chz.selected);
+        iq_reader_close(&reader);
         return false;
     }
 
@@ -389,118 +1270,169 @@ static bool process_file(const iqchan_options_t *options) {
         printf("📊 Expected channel isolation: %.1f dB\n", isolation);
     }
 
-    // Process IQ data through channelizer
-    uint32_t samples_processed = 0;
-    uint32_t total_samples = iq_data.num_samples;
-    const uint32_t block_size = 4096; // Process in blocks
+    // Writer threads for the full bank, at most one per written channel
+    uint32_t num_writers = options->threads == 0 ? stft_default_threads() : options->threads;
+    if (num_writers > chz.num_selected) num_writers = chz.num_selected;
+    bool threaded = chz.pfb && num_writers > 1;
+    if (options->verbose && threaded) {
+        printf("🧵 %u channel writer threads\n", num_writers);
+    }
 
-    while (samples_processed < total_samples) {
-        uint32_t samples_to_process = block_size;
-        if (samples_processed + samples_to_process > total_samples) {
-            samples_to_process = total_samples - samples_processed;
+    // Stream IQ data through the channelizer; channel outputs collect in its
+    // buffers and are appended to their files whenever those fill up
+    channel_sink_t sink = {
+        .options = options,
+        .files = (FILE **)calloc(chz.num_selected, sizeof(FILE *)),
+        .samples = (uint64_t *)calloc(chz.num_selected, sizeof(uint64_t)),
+        .format = IQ_FORMAT_S16,
+        .output_rate = chz.ddc ? ddc_bank_get_output_rate(chz.ddc) : pfb_get_output_rate(chz.pfb),
+        .bandwidth = pfb_config.channel_bandwidth
+    };
+    iq_parse_format(options->format, &sink.format);   // Validated with the options
+    if (chz.pfb && chz.num_selected < options->num_channels) {
+        chz.written = (bool *)calloc(options->num_channels, sizeof(bool));
+        for (uint32_t slot = 0; chz.written && slot < chz.num_selected; slot++) {
+            chz.written[chz.selected[slot]] = true;
         }
-
-        // Convert to complex float for PFB processing
-        float complex *input_block = (float complex *)malloc(samples_to_process * sizeof(float complex));
-        if (!input_block) {
-            fprintf(stderr, "ERROR: Memory allocation failed\n");
-            break;
+    }
+    const uint32_t block_size = 4096; // Process in blocks
+    uint64_t total_samples = reader.total_samples;
+    raise_open_file_limit(chz.num_selected);
+
+    // Pick up the interrupted run before the reader thread starts
+    uint64_t samples_processed = 0;
+    bool resumed = !options->resume || !sink.files || !sink.samples ||
+                   resume_checkpoint(&chz, &sink, &reader, &samples_processed);
+
+    // File reads and sample conversion run ahead on a background thread;
+    // --realtime paces them like a live source and watches the deadlines
+    rt_monitor_t *monitor = options->realtime ?
+        rt_monitor_create("iqchan", options->sample_rate, 0.0, options->rt_stats) : NULL;
+    iq_async_t *async = iq_async_create_realtime(&reader, block_size, IQ_ASYNC_NUM_BLOCKS,
+                                                 monitor ? options->sample_rate : 0.0, monitor);
+
+    iqchan_pool_t pool;
+    bool setup_ok = sink.files && sink.samples && async && (monitor || !options->realtime) &&
+                    (chz.written || !chz.pfb || chz.num_selected == options->num_channels);
+    if (!setup_ok) {
+        fprintf(stderr, "ERROR: Memory allocation failed\n");
+    }
+    if (!setup_ok || !resumed || (threaded && !pool_start(&pool, &chz, &sink, num_writers))) {
+        for (uint32_t slot = 0; sink.files && slot < chz.num_selected; slot++) {
+            if (sink.files[slot]) fclose(sink.files[slot]);
         }
+        free(sink.files);
+        free(sink.samples);
+        iq_async_destroy(async);
+        rt_monitor_destroy(monitor);
+        pfb_destroy(chz.pfb);
+        ddc_bank_destroy(chz.ddc);
+        free(chz.written);
+        free(chz.selected);
+        iq_reader_close(&reader);
+        return false;
+    }
 
-        // Convert IQ data to complex format
-        for (uint32_t i = 0; i < samples_to_process; i++) {
-            uint32_t idx = samples_processed + i;
-            if (idx < iq_data.num_samples) {
-                // Convert to float complex for PFB processing
-                float real = iq_data.data[idx * 2];
-                float imag = iq_data.data[idx * 2 + 1];
-                ((float complex *)input_block)[i] = real + I * imag;
+    uint64_t outputs_signalled = 0;
+    uint64_t checkpoint_interval = options->checkpoint ?
+        (uint64_t)(options->checkpoint_every_s * options->sample_rate) : 0;
+    uint64_t next_checkpoint = samples_processed + checkpoint_interval;
+    bool write_ok = true;
+    const iq_async_block_t *input_block;
+
+    bool chan_ok = true;
+    while (write_ok && chan_ok && (input_block = iq_async_acquire(async)) != NULL) {
+        // Interleaved float I/Q has the float complex layout
+        const float complex *samples = (const float complex *)input_block->samples;
+        uint32_t remaining = (uint32_t)input_block->num_samples;
+
+        // The channelizer pauses when a channel buffer fills; drain (or let the
+        // writers drain) and feed the rest
+        while (write_ok && remaining > 0) {
+            int32_t processed = channelizer_process(&chz, samples, remaining);
+            if (processed < 0) {
+                fprintf(stderr, "ERROR: Channelizer processing failed\n");
+                chan_ok = false;
+                break;
+            }
+            samples += processed;
+            remaining -= (uint32_t)processed;
+            samples_processed += processed;
+
+            if (remaining > 0 && !threaded) {
+                write_ok = drain_channels(&chz, &sink);
+            } else if (remaining > 0) {
+                release_unselected(&chz);
+                if (processed == 0) {
+                    // Every ring slot waits on a writer
+                    rt_monitor_stall(monitor);
+                    write_ok = pool_wait_for_space(&pool);
+                }
             }
         }
-
-        // Process block through PFB
-        int32_t processed = pfb_process_block(pfb, (const float complex *)input_block, samples_to_process);
-        free(input_block);
-
-        if (processed < 0) {
-            fprintf(stderr, "ERROR: PFB processing failed\n");
-            break;
+        iq_async_release(async, input_block);
+        rt_monitor_poll(monitor);
+
+        // Hand the writers every half ring of new outputs
+        uint64_t outputs = chz.pfb ? chz.pfb->samples_consumed / chz.pfb->decimation : 0;
+        if (threaded && outputs - outputs_signalled >= pfb_config.block_size / 2) {
+            pool_signal(&pool);
+            outputs_signalled = outputs;
         }
 
-        samples_processed += processed;
+        // Checkpoints fall between blocks, every block consumed
+        if (checkpoint_interval && write_ok && chan_ok && samples_processed >= next_checkpoint) {
+            write_ok = take_checkpoint(&chz, &sink, threaded ? &pool : NULL, samples_processed);
+            next_checkpoint = samples_processed + checkpoint_interval;
+        }
 
         if (options->verbose && samples_processed % 100000 == 0) {
-            printf("⏳ Processed %u/%u samples (%.1f%%)\n",
-                   samples_processed, total_samples,
-                   100.0 * samples_processed / total_samples);
+            if (total_samples == 0) {
+                printf("⏳ Processed %llu samples\n", (unsigned long long)samples_processed);  // Live input
+            } else {
+                printf("⏳ Processed %llu/%llu samples (%.1f%%)\n",
+                       (unsigned long long)samples_processed, (unsigned long long)total_samples,
+                       100.0 * samples_processed / total_samples);
+            }
         }
     }
+    if (threaded) {
+        // The writers take the last outputs, then close and describe their channels
+        write_ok = pool_finish(&pool) && write_ok;
+    } else if (write_ok && chan_ok) {
+        write_ok = drain_channels(&chz, &sink);
+    }
+    iq_async_destroy(async);
+    rt_monitor_destroy(monitor);
 
     if (options->verbose) {
-        printf("✅ Processing complete: %u samples processed\n", samples_processed);
+        printf("✅ Processing complete: %llu samples processed\n", (unsigned long long)samples_processed);
     }
 
-    // Extract and save channels
-    for (uint32_t chan = 0; chan < options->num_channels; chan++) {
-        uint32_t samples_available;
-        const float complex *channel_data = pfb_get_channel_output(pfb, chan, &samples_available);
-
-        if (samples_available > 0) {
-            // Create channel filename
-            char channel_filename[512];
-            snprintf(channel_filename, sizeof(channel_filename), "%s/channel_%02u.iq",
-                     options->output_dir, chan);
-
-            // Convert back to IQ format and save
-            float *iq_output = (float *)malloc(samples_available * 2 * sizeof(float));
-            if (iq_output) {
-                for (uint32_t i = 0; i < samples_available; i++) {
-                    iq_output[i * 2] = crealf(channel_data[i]);
-                    iq_output[i * 2 + 1] = cimagf(channel_data[i]);
-                }
-
-                // Create IQ data structure for saving
-                iq_data_t channel_iq = {
-                    .data = iq_output,
-                    .num_samples = samples_available,
-                    .sample_rate = options->sample_rate,
-                    .format = strcmp(options->format, "s8") == 0 ? IQ_FORMAT_S8 : IQ_FORMAT_S16
-                };
-
-                bool save_success = iq_data_save_file(channel_filename, &channel_iq);
-
-                free(iq_output);
-
-                if (save_success) {
-                    // Generate metadata
-                    if (generate_channel_metadata(options->output_dir, chan, options, pfb)) {
-                        if (options->verbose) {
-                            printf("💾 Saved channel %u: %u samples, center=%.0f Hz\n",
-                                   chan, samples_available,
-                                   pfb_get_channel_frequency(pfb, chan));
-                        }
-                    } else {
-                        fprintf(stderr, "WARNING: Failed to generate metadata for channel %u\n", chan);
-                    }
-                } else {
-                    fprintf(stderr, "ERROR: Failed to save channel %u\n", chan);
-                }
-            }
-
-            // Reset channel buffer
-            pfb_reset_channel_output(pfb, chan);
-        }
+    // Close channel files and write their metadata (the writers did theirs)
+    for (uint32_t slot = 0; slot < chz.num_selected; slot++) {
+        finish_channel(&chz, &sink, slot, write_ok);
     }
+    free(sink.files);
+    free(sink.samples);
 
     // Cleanup
-    pfb_destroy(pfb);
-    iq_free(&iq_data);
+    pfb_destroy(chz.pfb);
+    ddc_bank_destroy(chz.ddc);
+    free(chz.written);
+    free(chz.selected);
+    iq_reader_close(&reader);
+
+    // Nothing left to resume
+    if (write_ok && chan_ok && options->checkpoint) {
+        remove(options->checkpoint);
+    }
 
     if (options->verbose) {
         printf("🎉 Channelization complete! Files saved to: %s/\n", options->output_dir);
     }
 
-    return true;
+    return write_ok && chan_ok;
 }
 
 /**
@@ -534,7 +1466,7 @@ int main(int argc, char **argv) {
     }
 
     // Process the file
-    bool success = process_file(&options);
+    bool success = options.plan ? process_plan(&options) : process_file(&options);
 
     if (success) {
         if (options.verbose) {
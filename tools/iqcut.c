@@ -11,9 +11,11 @@
  * Key Features:
  * - Frequency translation by configurable center frequency offset
  * - Time-domain signal cutting with precise start/end timing
+ * - Random-access seek: only the selected range is read from disk
  * - Intelligent integer decimation based on desired bandwidth
  * - Complex mixing for frequency shifting operations
  * - SigMF metadata generation for processed outputs
+ * - Passthrough: a full-band cut at DC is copied byte for byte
  * - Automatic sample rate and format handling
  *
  * Usage Examples:
@@ -23,27 +25,55 @@
  *   # Downsample wideband signal for analysis
  *   iqcut.exe --in wideband.iq --rate 10000000 --f_center 0 --bw 100000 --t_start 0 --t_end 30.0 --out narrowband
  *
+ *   # Batch: one snippet per iqdetect event (events_000.iq, events_001.iq, ...)
+ *   iqcut.exe --in recording.iq --rate 2000000 --events events.csv --out events
+ *
+ *   # Batch: every SigMF annotation between 433.0 and 434.0 MHz
+ *   iqcut.exe --in capture.sigmf-data --annotations --band 433000000:434000000 --out burst
+ *
+ * Batch Mode:
+ * - Regions come from an iqdetect events CSV (t_start_s, t_end_s and
+ *   optional f_center_Hz, bw_Hz columns) or from the SigMF annotations,
+ *   selected through the annotation index (sigmf_index_query)
+ * - Regions are sorted by start sample and the file is streamed once:
+ *   each region gets its own xlating decimator while it is open, gaps
+ *   between regions are skipped with a seek
+ * - A single cut is the one-region case, so both modes produce the same
+ *   samples for the same region
+ *
  * Technical Algorithm:
- * 1. Time Selection: Extract samples within t_start to t_end
- * 2. Frequency Translation: Complex multiply by e^(j*2π*f_center*t)
- * 3. Decimation: Integer factor reduction to achieve target bandwidth
+ * 1. Time Selection: Extract samples within t_start to t_end; with SigMF
+ *    metadata the times are mapped through the capture segments
+ * 2. Frequency Translation: Complex multiply by e^(-j*2π*f_center*t)
+ * 3. Decimation: Anti-alias filtering and integer rate reduction
  * 4. Output Generation: Write s16 IQ data and SigMF metadata
  *
- * Frequency Translation Details:
- * - Uses quadrature oscillators for precise phase control
- * - Phase accumulator maintains continuous phase across samples
- * - Handles frequency offsets from DC to Nyquist limit
- * - Phase wrapping prevents numerical instability
+ * Translation and decimation run in one xlate stage (src/iq_core/xlate.h):
+ * - A recursive NCO: one complex multiply per sample, continuous phase
+ *   across blocks, no sin/cos in the loop
+ * - Decimation factor from the target bandwidth: output_rate ~ 2 * bw
+ * - CIC, halfband and polyphase FIR stages that only compute the samples
+ *   they keep; --bw around DC stays alias free
+ * - Outputs lag the input by the filters' group delay
+ *
+ * Passthrough:
+ * - With --f_center 0 and a --bw that keeps the full rate, there is
+ *   nothing to translate or filter, so decoding to float, mixing by 1 and
+ *   re-quantizing only costs time (and turns s8/s12/s4 into s16)
+ * - Such regions are cut as a byte range of the source file instead:
+ *   data_offset + sample index * bytes per sample, copied in the source
+ *   datatype with copy_file_range or sendfile on Linux, large fread/fwrite
+ *   blocks elsewhere, and the metadata names the source datatype
+ * - Only raw files read from disk qualify (not mono WAV, IQZ or streams);
+ *   --no-passthrough forces the ci16 path
  *
- * Decimation Strategy:
- * - Calculates optimal decimation factor from target bandwidth
- * - Nyquist criterion: output_rate = 2 * target_bandwidth
- * - Integer decimation preserves signal integrity
- * - Maintains proper anti-aliasing through bandwidth limiting
+ * --profile times the reads, the xlate stage and the snippet writes
+ * (profile.h), on stderr at exit or as JSON with --profile=<file>;
+ * --trace=<file> writes them as a Chrome trace timeline.
  *
  * Input/Output Formats:
  * - Input: Raw IQ data (s8/s16 interleaved)
- * - Output: s16 IQ data with SigMF metadata
+ * - Output: s16 IQ data with SigMF metadata (source datatype for passthrough)
  * - Metadata: Sample rate, center frequency, capture details
  *
  * Performance:
@@ -64,8 +94,16 @@
  * Error Handling: Comprehensive parameter validation
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // copy_file_range, sendfile, fseeko under -std=c11
+#elif !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // fseeko under -std=c11
+#endif
+
 #include "../src/iq_core/io_iq.h"
 #include "../src/iq_core/io_sigmf.h"
+#include "../src/iq_core/xlate.h"
+#include "../src/iq_core/profile.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -73,18 +111,56 @@
 #include <math.h>
 #include <stdint.h>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#endif
+
 typedef struct {
     const char *in_path;
     const char *out_prefix;
+    const char *meta_path;   // SigMF metadata (default: next to --in if present)
+    const char *events_path; // Batch: iqdetect events CSV
+    bool annotations;        // Batch: cut every SigMF annotation
+    bool have_band;          // Batch: keep regions overlapping [band_lo, band_hi]
+    double band_lo;
+    double band_hi;
     uint32_t sample_rate;
     double f_center;   // Hz offset to translate to DC
     double bw;         // desired bandwidth (Hz)
     double t_start;    // seconds
     double t_end;      // seconds
+    bool no_passthrough; // Always decode, translate and re-quantize
 } args_t;
 
+// One output snippet: input samples [start, end) translated and decimated
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    double f_center;         // Offset moved to DC (Hz)
+    double bw;               // Passband (Hz)
+    char label[256];         // Annotation for the snippet's metadata, "" for none
+    char iq_path[512];
+    char meta_path[512];
+    bool passthrough;        // Copied as source bytes, not through the xlate stage
+
+    // While open
+    xlate_t xlate;
+    FILE *file;
+    uint32_t out_rate;
+    size_t written;
+} cut_region_t;
+
 static void usage(void) {
-    printf("Usage: iqcut --in <file> --rate <Hz> --f_center <Hz> --bw <Hz> --t_start <s> --t_end <s> --out <prefix>\n");
+    printf("Usage: iqcut --in <file> --rate <Hz> --f_center <Hz> --bw <Hz> --t_start <s> --t_end <s> --out <prefix> [--meta <file.sigmf-meta>]\n");
+    printf("             [--profile[=<file.json>]] [--trace=<file.json>]\n");
+    printf("       iqcut --in <file> [--rate <Hz>] {--events <events.csv> | --annotations} --out <prefix>\n");
+    printf("             [--band <lo>:<hi>] [--bw <Hz>] [--f_center <Hz>] [--t_start <s> --t_end <s>] [--meta <file.sigmf-meta>]\n");
+    printf("       [--no-passthrough]: re-quantize full-band cuts at DC to ci16 instead of copying source bytes\n");
+    printf("       --rate may be omitted when SigMF metadata or a WAV header provides it\n");
+    printf("       Batch mode writes <prefix>_000.iq, <prefix>_001.iq, ... in one pass over the input;\n");
+    printf("       --bw and --f_center apply to events that carry no band of their own\n");
 }
 
 static int parse_args(int argc, char **argv, args_t *a) {
@@ -92,14 +168,34 @@ static int parse_args(int argc, char **argv, args_t *a) {
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "--in") && i+1<argc) a->in_path = argv[++i];
         else if (!strcmp(argv[i], "--out") && i+1<argc) a->out_prefix = argv[++i];
+        else if (!strcmp(argv[i], "--meta") && i+1<argc) a->meta_path = argv[++i];
+        else if (!strcmp(argv[i], "--events") && i+1<argc) a->events_path = argv[++i];
+        else if (!strcmp(argv[i], "--annotations")) a->annotations = true;
+        else if (!strcmp(argv[i], "--no-passthrough")) a->no_passthrough = true;
+        else if (!strcmp(argv[i], "--band") && i+1<argc) {
+            char *end = NULL;
+            a->band_lo = strtod(argv[++i], &end);
+            if (*end != ':') { usage(); return 0; }
+            a->band_hi = strtod(end + 1, &end);
+            if (*end || a->band_hi < a->band_lo) { usage(); return 0; }
+            a->have_band = true;
+        }
         else if (!strcmp(argv[i], "--rate") && i+1<argc) a->sample_rate = (uint32_t)strtoul(argv[++i], NULL, 10);
         else if (!strcmp(argv[i], "--f_center") && i+1<argc) a->f_center = atof(argv[++i]);
         else if (!strcmp(argv[i], "--bw") && i+1<argc) a->bw = atof(argv[++i]);
         else if (!strcmp(argv[i], "--t_start") && i+1<argc) a->t_start = atof(argv[++i]);
         else if (!strcmp(argv[i], "--t_end") && i+1<argc) a->t_end = atof(argv[++i]);
+        else if (iq_profile_parse_arg("iqcut", argv[i])) continue;
         else { usage(); return 0; }
     }
-    if (!a->in_path || !a->out_prefix || !a->sample_rate || a->t_end <= a->t_start || a->bw <= 0.0) {
+
+    bool batch = a->events_path || a->annotations;
+    if (!a->in_path || !a->out_prefix || (a->events_path && a->annotations)) {
+        usage();
+        return 0;
+    }
+    // Batch mode: the time window is optional, bandwidth may come per event
+    if (batch ? (a->t_end < a->t_start || a->bw < 0.0) : (a->t_end <= a->t_start || a->bw <= 0.0)) {
         usage();
         return 0;
     }
@@ -121,72 +217,580 @@ static inline int16_t float_to_s16(float x) {
     return (int16_t)v;
 }
 
-int main(int argc, char **argv) {
-    args_t a; if (!parse_args(argc, argv, &a)) return 1;
+#define IQCUT_BLOCK_SAMPLES 65536   // Input samples per read
 
-    iq_data_t iq = {0};
-    if (!iq_load_file(a.in_path, &iq)) {
-        fprintf(stderr, "Failed to load %s\n", a.in_path);
-        return 1;
+// Map seconds to a sample index, through the capture segments when there is metadata
+static uint64_t time_to_sample(const sigmf_metadata_t *meta, uint32_t sample_rate, double seconds) {
+    uint64_t index = (uint64_t)floor(seconds * sample_rate);
+    if (meta) {
+        sigmf_time_to_sample(meta, seconds, &index);
+    }
+    return index;
+}
+
+// Integer decimation approximating the desired BW (Nyquist ~ bw/2)
+static uint32_t region_decimation(uint32_t sample_rate, double bw) {
+    uint32_t target_rate = (uint32_t)fmax(2.0 * bw, 1000.0);
+    if (target_rate > sample_rate) target_rate = sample_rate;
+    return (uint32_t)fmax(1.0, floor((double)sample_rate / (double)target_rate));
+}
+
+// Grow the region list by one zeroed entry, NULL when out of memory
+static cut_region_t *add_region(cut_region_t **regions, size_t *count, size_t *capacity) {
+    if (*count == *capacity) {
+        size_t grown = *capacity ? *capacity * 2 : 64;
+        cut_region_t *resized = realloc(*regions, grown * sizeof(cut_region_t));
+        if (!resized) {
+            fprintf(stderr, "Out of memory for cut regions\n");
+            return NULL;
+        }
+        *regions = resized;
+        *capacity = grown;
+    }
+    cut_region_t *region = &(*regions)[(*count)++];
+    memset(region, 0, sizeof(*region));
+    return region;
+}
+
+// Split one CSV line in place; quoted fields may hold commas
+static size_t split_csv(char *line, char **fields, size_t max_fields) {
+    size_t count = 0;
+    char *p = line;
+    while (count < max_fields) {
+        bool quoted = *p == '"';
+        if (quoted) p++;
+        fields[count++] = p;
+        char *out = p;
+        while (*p && (quoted || (*p != ',' && *p != '\n' && *p != '\r'))) {
+            if (quoted && *p == '"') {
+                if (p[1] != '"') { quoted = false; p++; continue; }
+                p++;    // "" inside quotes is one quote
+            }
+            *out++ = *p++;
+        }
+        bool more = *p == ',';
+        *out = '\0';
+        if (!more) break;
+        p++;
+    }
+    return count;
+}
+
+// Regions from an iqdetect events CSV (columns found by header name)
+static bool load_events_csv(const char *path, const args_t *a, const sigmf_metadata_t *meta,
+                            uint32_t sample_rate, cut_region_t **regions, size_t *count,
+                            size_t *capacity) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+
+    enum { T_START, T_END, F_CENTER, BW, MODULATION, NUM_COLUMNS };
+    static const char *names[NUM_COLUMNS] = { "t_start_s", "t_end_s", "f_center_Hz", "bw_Hz", "modulation_guess" };
+    int columns[NUM_COLUMNS] = { -1, -1, -1, -1, -1 };
+
+    char line[4096];
+    char *fields[64];
+    bool ok = fgets(line, sizeof(line), file) != NULL;
+    if (ok) {
+        size_t n = split_csv(line, fields, 64);
+        for (size_t i = 0; i < n; i++) {
+            for (int c = 0; c < NUM_COLUMNS; c++) {
+                if (strcmp(fields[i], names[c]) == 0) columns[c] = (int)i;
+            }
+        }
+    }
+    if (!ok || columns[T_START] < 0 || columns[T_END] < 0) {
+        fprintf(stderr, "%s: expected an events CSV with t_start_s and t_end_s columns\n", path);
+        fclose(file);
+        return false;
     }
-    if (a.sample_rate) iq.sample_rate = a.sample_rate;
-    if (iq.sample_rate == 0) { fprintf(stderr, "Sample rate required\n"); iq_free(&iq); return 1; }
-
-    size_t start_idx = (size_t)floor(a.t_start * iq.sample_rate);
-    size_t end_idx = (size_t)floor(a.t_end * iq.sample_rate);
-    if (end_idx > iq.num_samples) end_idx = iq.num_samples;
-    if (start_idx >= end_idx) { fprintf(stderr, "Empty selection\n"); iq_free(&iq); return 1; }
-
-    // Determine integer decimation to approximate desired BW (Nyquist ~ bw/2)
-    uint32_t target_rate = (uint32_t)fmax(2.0 * a.bw, 1000.0);
-    if (target_rate > iq.sample_rate) target_rate = iq.sample_rate;
-    uint32_t decim = (uint32_t)fmax(1.0, floor((double)iq.sample_rate / (double)target_rate));
-    uint32_t out_rate = iq.sample_rate / decim;
-
-    // Prepare output paths
-    char iq_out[512]; snprintf(iq_out, sizeof(iq_out), "%s.iq", a.out_prefix);
-    char meta_out[512]; snprintf(meta_out, sizeof(meta_out), "%s.sigmf-meta", a.out_prefix);
-
-    FILE *fo = fopen(iq_out, "wb");
-    if (!fo) { fprintf(stderr, "Failed to open %s\n", iq_out); iq_free(&iq); return 1; }
-
-    #ifndef M_PI
-    #define M_PI 3.14159265358979323846
-    #endif
-    double w = -2.0 * M_PI * a.f_center / (double)iq.sample_rate; // translate by f_center to DC
-    double phase = 0.0;
-    size_t written = 0;
-    for (size_t n = start_idx; n < end_idx; n++) {
-        if (((n - start_idx) % decim) != 0) continue; // decimate by picking every decim-th sample
-        float i_val = iq.data[n*2];
-        float q_val = iq.data[n*2+1];
-        // complex multiply by e^{j*phase}: x * e^{j*phase}
-        float c = (float)cos(phase);
-        float s = (float)sin(phase);
-        float i_m = i_val*c - q_val*s;
-        float q_m = i_val*s + q_val*c;
-        phase += w * decim; // advance phase by decimated step
-        if (phase > M_PI) phase -= 2.0*M_PI; else if (phase < -M_PI) phase += 2.0*M_PI;
-
-        int16_t is = float_to_s16(i_m);
-        int16_t qs = float_to_s16(q_m);
-        fwrite(&is, sizeof(int16_t), 1, fo);
-        fwrite(&qs, sizeof(int16_t), 1, fo);
-        written++;
-    }
-    fclose(fo);
-
-    // Write minimal SigMF meta
+
+    size_t row = 1;
+    while (ok && fgets(line, sizeof(line), file)) {
+        row++;
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '\0') continue;
+
+        size_t n = split_csv(line, fields, 64);
+        int needed = columns[T_START] > columns[T_END] ? columns[T_START] : columns[T_END];
+        if ((int)n <= needed) {
+            fprintf(stderr, "%s:%zu: missing columns\n", path, row);
+            ok = false;
+            break;
+        }
+
+        double t_start = atof(fields[columns[T_START]]);
+        double t_end = atof(fields[columns[T_END]]);
+        double f_center = columns[F_CENTER] >= 0 && (int)n > columns[F_CENTER]
+                        ? atof(fields[columns[F_CENTER]]) : a->f_center;
+        double bw = columns[BW] >= 0 && (int)n > columns[BW] ? atof(fields[columns[BW]]) : 0.0;
+        if (bw <= 0.0) bw = a->bw;
+        if (t_end <= t_start) continue;
+        if (bw <= 0.0) {
+            fprintf(stderr, "%s:%zu: event has no bandwidth; pass --bw\n", path, row);
+            ok = false;
+            break;
+        }
+        if (a->have_band && (f_center + bw / 2.0 < a->band_lo || f_center - bw / 2.0 > a->band_hi)) continue;
+
+        cut_region_t *region = add_region(regions, count, capacity);
+        if (!region) { ok = false; break; }
+        region->start = time_to_sample(meta, sample_rate, t_start);
+        region->end = time_to_sample(meta, sample_rate, t_end);
+        region->f_center = f_center;
+        region->bw = bw;
+        if (columns[MODULATION] >= 0 && (int)n > columns[MODULATION]) {
+            snprintf(region->label, sizeof(region->label), "%s", fields[columns[MODULATION]]);
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+// Capture segment frequency for a sample (0 without captures)
+static double capture_frequency(const sigmf_metadata_t *meta, uint64_t sample) {
+    double frequency = 0.0;
+    for (size_t i = 0; i < meta->num_captures && meta->captures[i].sample_start <= sample; i++) {
+        frequency = (double)(int64_t)meta->captures[i].frequency;
+    }
+    return frequency;
+}
+
+// Regions from the SigMF annotations, selected through the annotation index
+static bool load_annotations(const char *meta_path, const args_t *a, const sigmf_metadata_t *meta,
+                             uint32_t sample_rate, cut_region_t **regions, size_t *count,
+                             size_t *capacity) {
+    sigmf_annotation_index_t *index = sigmf_index_open(meta_path);
+    if (!index) {
+        fprintf(stderr, "Failed to index annotations in %s\n", meta_path);
+        return false;
+    }
+
+    uint64_t window_start = 0;
+    uint64_t window_end = UINT64_MAX;
+    if (a->t_end > a->t_start) {
+        window_start = time_to_sample(meta, sample_rate, a->t_start);
+        window_end = time_to_sample(meta, sample_rate, a->t_end);
+    }
+    // The index compares unsigned edges; negative (baseband) bands are filtered below
+    uint64_t freq_lo = 0;
+    uint64_t freq_hi = UINT64_MAX;
+    if (a->have_band && a->band_lo >= 0.0) {
+        freq_lo = (uint64_t)a->band_lo;
+        freq_hi = (uint64_t)ceil(a->band_hi);
+    }
+
+    size_t matches = sigmf_index_query(index, window_start, window_end, freq_lo, freq_hi, NULL, 0);
+    const sigmf_index_entry_t **entries = malloc((matches ? matches : 1) * sizeof(*entries));
+    bool ok = entries != NULL;
+    if (ok) {
+        matches = sigmf_index_query(index, window_start, window_end, freq_lo, freq_hi, entries, matches);
+    }
+
+    for (size_t i = 0; ok && i < matches; i++) {
+        const sigmf_index_entry_t *entry = entries[i];
+        if (entry->sample_count == 0) continue;
+
+        // Edges are absolute; the offset to move is relative to the capture's center
+        double f_center = a->f_center;
+        double bw = a->bw;
+        if (entry->freq_lower_edge || entry->freq_upper_edge) {
+            double lower = (double)(int64_t)entry->freq_lower_edge;
+            double upper = (double)(int64_t)entry->freq_upper_edge;
+            if (a->have_band && (upper < a->band_lo || lower > a->band_hi)) continue;
+            f_center = (lower + upper) / 2.0 - capture_frequency(meta, entry->sample_start);
+            bw = upper - lower;
+        }
+        if (bw <= 0.0) {
+            fprintf(stderr, "Annotation %llu has no band; pass --bw\n", (unsigned long long)entry->ordinal);
+            ok = false;
+            break;
+        }
+
+        sigmf_annotation_t annotation;
+        cut_region_t *region = add_region(regions, count, capacity);
+        if (!region || !sigmf_index_read_annotation(index, entry, &annotation)) {
+            ok = false;
+            break;
+        }
+        region->start = entry->sample_start;
+        region->end = entry->sample_start + entry->sample_count;
+        region->f_center = f_center;
+        region->bw = bw;
+        snprintf(region->label, sizeof(region->label), "%s",
+                 annotation.label[0] ? annotation.label : annotation.description);
+    }
+
+    free(entries);
+    sigmf_index_close(index);
+    return ok;
+}
+
+static int compare_regions(const void *a, const void *b) {
+    const cut_region_t *x = a;
+    const cut_region_t *y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    if (x->end != y->end) return x->end < y->end ? -1 : 1;
+    return 0;
+}
+
+static bool region_open(cut_region_t *region, uint32_t sample_rate) {
+    uint32_t decim = region_decimation(sample_rate, region->bw);
+    region->out_rate = sample_rate / decim;
+    region->written = 0;
+    if (!xlate_init(&region->xlate, (double)sample_rate, region->f_center, decim, region->bw)) {
+        fprintf(stderr, "Failed to prepare the decimator for %s\n", region->iq_path);
+        return false;
+    }
+    region->file = fopen(region->iq_path, "wb");
+    if (!region->file) {
+        fprintf(stderr, "Failed to open %s\n", region->iq_path);
+        xlate_free(&region->xlate);
+        return false;
+    }
+    return true;
+}
+
+// The snippet's minimal SigMF meta
+static bool region_write_meta(const cut_region_t *region, const char *datatype) {
     sigmf_metadata_t meta = {0};
-    sigmf_create_basic_metadata(&meta, "ci16", out_rate, 0 /* new center @ DC */, "iqcut output", "iq_lab");
+    sigmf_create_basic_metadata(&meta, datatype, region->out_rate, 0 /* new center @ DC */, "iqcut output", "iq_lab");
     sigmf_add_capture(&meta, 0, 0, NULL);
-    sigmf_write_metadata(meta_out, &meta);
+    if (region->label[0]) {
+        sigmf_add_annotation(&meta, 0, region->written, 0, 0, region->label);
+    }
+    bool ok = sigmf_write_metadata(region->meta_path, &meta);
     sigmf_free_metadata(&meta);
+    return ok;
+}
 
-    printf("Wrote %s (%zu samples @ %u Hz) and %s\n", iq_out, written, out_rate, meta_out);
+// Close the snippet and write its metadata
+static bool region_close(cut_region_t *region) {
+    bool ok = fclose(region->file) == 0;
+    region->file = NULL;
+    xlate_free(&region->xlate);
+    return region_write_meta(region, "ci16") && ok;
+}
 
-    iq_free(&iq);
-    return 0;
+/*
+ * Stream the input once for all regions (sorted by start). Each block is
+ * handed to the decimator of every region open over it; a region opens
+ * at the block holding its first sample and closes with its last, and
+ * gaps with nothing open are skipped with a seek.
+ */
+static bool cut_regions(iq_reader_t *reader, uint32_t sample_rate, cut_region_t *regions,
+                        size_t count, uint64_t *samples_read) {
+    float *block = malloc(IQCUT_BLOCK_SAMPLES * 2 * sizeof(float));
+    float *mixed = malloc((IQCUT_BLOCK_SAMPLES + 1) * 2 * sizeof(float));
+    int16_t *out = malloc((IQCUT_BLOCK_SAMPLES + 1) * 2 * sizeof(int16_t));
+    cut_region_t **active = malloc((count ? count : 1) * sizeof(cut_region_t *));
+    bool ok = block && mixed && out && active;
+    if (!ok) fprintf(stderr, "Out of memory for cut buffers\n");
+
+    size_t next = 0;
+    size_t num_active = 0;
+    uint64_t n = 0;
+    bool positioned = false;
+    *samples_read = 0;
+
+    while (ok && (next < count || num_active > 0)) {
+        // Nothing open: jump to the next region's first sample
+        if (num_active == 0 && (!positioned || regions[next].start > n)) {
+            n = regions[next].start;
+            if (!iq_reader_seek_sample(reader, n)) {
+                fprintf(stderr, "Failed to seek to sample %llu\n", (unsigned long long)n);
+                ok = false;
+                break;
+            }
+            positioned = true;
+        }
+
+        size_t got = iq_read_samples(reader, block, IQCUT_BLOCK_SAMPLES);
+        if (got == 0) break;
+        *samples_read += got;
+        uint64_t block_end = n + got;
+
+        while (ok && next < count && regions[next].start < block_end) {
+            ok = region_open(&regions[next], sample_rate);
+            if (ok) active[num_active++] = &regions[next];
+            next++;
+        }
+
+        for (size_t i = 0; ok && i < num_active; ) {
+            cut_region_t *region = active[i];
+            uint64_t from = region->start > n ? region->start : n;
+            uint64_t to = region->end < block_end ? region->end : block_end;
+            if (from < to) {
+                uint64_t start = iq_profile_begin();
+                size_t out_count = xlate_process(&region->xlate, block + (from - n) * 2,
+                                                 (size_t)(to - from), mixed);
+                for (size_t k = 0; k < out_count * 2; k++) {
+                    out[k] = float_to_s16(mixed[k]);
+                }
+                iq_profile_end(IQ_PROFILE_FILTER, start, to - from, (to - from) * 2 * sizeof(float));
+                start = iq_profile_begin();
+                fwrite(out, sizeof(int16_t), out_count * 2, region->file);
+                iq_profile_end(IQ_PROFILE_WRITE, start, out_count, out_count * 2 * sizeof(int16_t));
+                region->written += out_count;
+            }
+            if (region->end <= block_end) {
+                ok = region_close(region);
+                active[i] = active[--num_active];
+            } else {
+                i++;
+            }
+        }
+        n = block_end;
+    }
+
+    // Regions cut short by the end of the input (or an error) still get closed
+    for (size_t i = 0; i < num_active; i++) {
+        ok = region_close(active[i]) && ok;
+    }
+
+    free(block);
+    free(mixed);
+    free(out);
+    free(active);
+    return ok;
+}
+
+#define IQCUT_COPY_BYTES (4u << 20)   // Bytes per fread/fwrite in the copy fallback
+
+// Nothing to translate or filter: the xlate stage would return its input
+static bool region_is_passthrough(const cut_region_t *region, uint32_t sample_rate) {
+    return region->f_center == 0.0 && region_decimation(sample_rate, region->bw) == 1;
+}
+
+// SigMF datatype of the reader's raw samples
+static const char *format_datatype(iq_format_t format) {
+    switch (format) {
+        case IQ_FORMAT_S8:  return "ci8";
+        case IQ_FORMAT_S12: return "ci12";
+        case IQ_FORMAT_S4:  return "ci4";
+        default:            return "ci16";
+    }
+}
+
+static bool copy_seek(FILE *file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// Copy 'length' bytes at 'offset' of 'in' to 'out' (positioned at its start)
+static bool copy_byte_range(FILE *in, FILE *out, uint64_t offset, uint64_t length) {
+    uint64_t done = 0;
+#ifdef __linux__
+    // In-kernel copies first: no user-space buffer, reflinks where the filesystem can
+    int in_fd = fileno(in);
+    int out_fd = fileno(out);
+    off_t in_offset = (off_t)offset;
+    bool use_copy_range = true;
+    while (done < length) {
+        size_t chunk = length - done > (1u << 30) ? (1u << 30) : (size_t)(length - done);
+        ssize_t moved = use_copy_range ? copy_file_range(in_fd, &in_offset, out_fd, NULL, chunk, 0)
+                                       : sendfile(out_fd, in_fd, &in_offset, chunk);
+        if (moved > 0) {
+            done += (uint64_t)moved;
+        } else if (moved < 0 && use_copy_range) {
+            use_copy_range = false;   // EXDEV, ENOSYS, EINVAL: try sendfile
+        } else {
+            break;                    // Neither works here (or the input ended): plain copy
+        }
+    }
+    if (done == length) return true;
+    if (!copy_seek(out, done)) return false;
+#endif
+
+    if (!copy_seek(in, offset + done)) return false;
+    uint8_t *buffer = malloc(IQCUT_COPY_BYTES);
+    if (!buffer) {
+        fprintf(stderr, "Out of memory for the copy buffer\n");
+        return false;
+    }
+    while (done < length) {
+        size_t want = length - done > IQCUT_COPY_BYTES ? IQCUT_COPY_BYTES : (size_t)(length - done);
+        size_t got = fread(buffer, 1, want, in);
+        if (got == 0 || fwrite(buffer, 1, got, out) != got) break;
+        done += got;
+    }
+    free(buffer);
+    return done == length;
+}
+
+/*
+ * Cut a passthrough region: samples [start, end) as the source file's
+ * bytes, in its datatype, at the input rate.
+ */
+static bool cut_passthrough(const char *in_path, const iq_reader_t *reader, uint32_t sample_rate,
+                            cut_region_t *region) {
+    size_t sample_bytes = iq_native_sample_bytes(reader->format);
+    uint64_t offset = reader->data_offset + region->start * sample_bytes;
+    uint64_t length = (region->end - region->start) * sample_bytes;
+
+    FILE *in = fopen(in_path, "rb");
+    if (!in) {
+        fprintf(stderr, "Failed to open %s\n", in_path);
+        return false;
+    }
+    FILE *out = fopen(region->iq_path, "wb");
+    if (!out) {
+        fprintf(stderr, "Failed to open %s\n", region->iq_path);
+        fclose(in);
+        return false;
+    }
+
+    uint64_t start = iq_profile_begin();
+    bool ok = copy_byte_range(in, out, offset, length);
+    iq_profile_end(IQ_PROFILE_WRITE, start, region->end - region->start, length);
+    if (!ok) fprintf(stderr, "Failed to copy samples to %s\n", region->iq_path);
+    ok = fclose(out) == 0 && ok;
+    fclose(in);
+
+    region->out_rate = sample_rate;
+    region->written = (size_t)(region->end - region->start);
+    return region_write_meta(region, format_datatype(reader->format)) && ok;
 }
 
+int main(int argc, char **argv) {
+    args_t a; if (!parse_args(argc, argv, &a)) return 1;
+    bool batch = a.events_path || a.annotations;
+
+    // SigMF metadata, if any, is authoritative for rate, datatype and captures
+    char meta_in[512];
+    const char *meta_path = a.meta_path;
+    if (!meta_path && sigmf_meta_file_exists(a.in_path)) {
+        sigmf_get_meta_filename(a.in_path, meta_in, sizeof(meta_in));
+        meta_path = meta_in;
+    }
+    if (a.annotations && !meta_path) {
+        fprintf(stderr, "--annotations needs SigMF metadata (--meta or a .sigmf-meta next to --in)\n");
+        return 1;
+    }
+    sigmf_metadata_t in_meta = {0};
+    bool have_meta = false;
+    if (meta_path) {
+        if (!sigmf_read_metadata(meta_path, &in_meta)) {
+            fprintf(stderr, "Failed to read %s\n", meta_path);
+            return 1;
+        }
+        have_meta = true;
+    }
+
+    iq_reader_t reader;
+    bool opened;
+    if (have_meta) {
+        iq_format_t format;
+        switch (sigmf_parse_datatype(in_meta.global.datatype)) {
+            case SIGMF_DATATYPE_CI8:  format = IQ_FORMAT_S8;  break;
+            case SIGMF_DATATYPE_CI16: format = IQ_FORMAT_S16; break;
+            case SIGMF_DATATYPE_CI12: format = IQ_FORMAT_S12; break;
+            case SIGMF_DATATYPE_CI4:  format = IQ_FORMAT_S4;  break;
+            default:
+                fprintf(stderr, "Unsupported SigMF datatype '%s' (ci8/ci16/ci12/ci4 only)\n",
+                        in_meta.global.datatype);
+                sigmf_free_metadata(&in_meta);
+                return 1;
+        }
+        opened = iq_reader_init(&reader, a.in_path, format);
+    } else {
+        opened = iq_reader_open(&reader, a.in_path);
+    }
+    if (!opened) {
+        fprintf(stderr, "Failed to load %s\n", a.in_path);
+        sigmf_free_metadata(&in_meta);
+        return 1;
+    }
+    uint32_t sample_rate = a.sample_rate ? a.sample_rate : reader.sample_rate;
+    if (!sample_rate && have_meta) sample_rate = (uint32_t)in_meta.global.sample_rate;
+    if (sample_rate == 0) { fprintf(stderr, "Sample rate required\n"); sigmf_free_metadata(&in_meta); iq_reader_close(&reader); return 1; }
+    if (have_meta) in_meta.global.sample_rate = sample_rate;
+    const sigmf_metadata_t *timeline = have_meta ? &in_meta : NULL;
+
+    cut_region_t *regions = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    bool ok = true;
+    if (a.events_path) {
+        ok = load_events_csv(a.events_path, &a, timeline, sample_rate, &regions, &count, &capacity);
+    } else if (a.annotations) {
+        ok = load_annotations(meta_path, &a, timeline, sample_rate, &regions, &count, &capacity);
+    } else {
+        cut_region_t *region = add_region(&regions, &count, &capacity);
+        ok = region != NULL;
+        if (ok) {
+            region->start = time_to_sample(timeline, sample_rate, a.t_start);
+            region->end = time_to_sample(timeline, sample_rate, a.t_end);
+            region->f_center = a.f_center;
+            region->bw = a.bw;
+        }
+    }
+    sigmf_free_metadata(&in_meta);
+
+    // Clamp to the recording, name the outputs in input order, then sort by start
+    size_t kept = 0;
+    for (size_t i = 0; ok && i < count; i++) {
+        cut_region_t *region = &regions[i];
+        if (region->end > reader.total_samples) region->end = reader.total_samples;
+        if (region->start >= region->end) continue;
+
+        if (batch) {
+            snprintf(region->iq_path, sizeof(region->iq_path), "%s_%03zu.iq", a.out_prefix, kept);
+            snprintf(region->meta_path, sizeof(region->meta_path), "%s_%03zu.sigmf-meta", a.out_prefix, kept);
+        } else {
+            snprintf(region->iq_path, sizeof(region->iq_path), "%s.iq", a.out_prefix);
+            snprintf(region->meta_path, sizeof(region->meta_path), "%s.sigmf-meta", a.out_prefix);
+        }
+        regions[kept++] = *region;
+    }
+    count = kept;
+    if (ok && count == 0) {
+        fprintf(stderr, batch ? "No events to cut\n" : "Empty selection\n");
+        ok = false;
+    }
+    if (!ok) {
+        free(regions);
+        iq_reader_close(&reader);
+        return 1;
+    }
+    qsort(regions, count, sizeof(cut_region_t), compare_regions);
+
+    // Full-band regions at DC of a raw file are copied; the rest go first, still in start order
+    bool raw_file = reader.file && !reader.source && !reader.compressed && !reader.stream && reader.channels == 2;
+    size_t num_dsp = 0;
+    for (size_t i = 0; i < count; i++) {
+        regions[i].passthrough = raw_file && !a.no_passthrough && region_is_passthrough(&regions[i], sample_rate);
+        if (!regions[i].passthrough) num_dsp++;
+    }
+    for (size_t i = 0, dsp = 0; num_dsp < count && i < count; i++) {
+        if (!regions[i].passthrough) {
+            cut_region_t region = regions[i];
+            memmove(&regions[dsp + 1], &regions[dsp], (i - dsp) * sizeof(cut_region_t));
+            regions[dsp++] = region;
+        }
+    }
+
+    // Only the selected ranges are read: one pass, seeking over the gaps
+    uint64_t samples_read = 0;
+    ok = cut_regions(&reader, sample_rate, regions, num_dsp, &samples_read);
+    for (size_t i = num_dsp; ok && i < count; i++) {
+        ok = cut_passthrough(a.in_path, &reader, sample_rate, &regions[i]);
+        samples_read += regions[i].written;
+    }
+
+    if (ok && !batch) {
+        printf("Wrote %s (%zu samples @ %u Hz) and %s\n",
+               regions[0].iq_path, regions[0].written, regions[0].out_rate, regions[0].meta_path);
+    } else if (ok) {
+        printf("Wrote %zu snippet%s %s_NNN.iq reading %llu input samples once\n",
+               count, count == 1 ? "" : "s", a.out_prefix, (unsigned long long)samples_read);
+    }
 
+    free(regions);
+    iq_reader_close(&reader);
+    return ok ? 0 : 1;
+}
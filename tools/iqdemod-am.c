@@ -12,8 +12,9 @@
  * - Envelope detection using magnitude calculation: sqrt(I² + Q²)
  * - Configurable DC blocking filter to remove carrier DC component
  * - Automatic gain control with attack/release parameters
+ * - Channel filter and decimation ahead of the envelope detector
  * - High-quality audio resampling to target sample rates
- * - Support for s8/s16 IQ data formats
+ * - Support for s8/s16 and packed s12/s4 IQ data formats
  * - Real-time envelope statistics and monitoring
  *
  * Usage Examples:
@@ -32,6 +33,16 @@
  * - AGC: Peak-based automatic gain control for consistent levels
  * - Performance: O(1) per sample, real-time capable up to 8Msps
  *
+ * Pipeline:
+ *   IQ -> channel filter / decimate (xlate.h) -> envelope, DC block, AGC
+ *   -> audio resample -> WAV
+ * - The capture is decimated by an integer factor to at least 1.25x the
+ *   channel width: +-8 kHz around the carrier (~20 kHz), or the
+ *   --channel-filter cutoff plus its transition either side
+ * - The detector, AGC and resampler then run per channel sample; on a
+ *   2 Msps capture that is 100x fewer samples
+ * - --demod-rate overrides the target rate; 0 demodulates at the input rate
+ *
  * Input Formats:
  * - Raw IQ data: s8 (int8) or s16 (int16) interleaved I/Q samples
  * - Automatic format detection and sample rate handling
@@ -57,35 +68,46 @@
 #include <getopt.h>
 #include <math.h>
 #include "../src/iq_core/io_iq.h"
+#include "../src/iq_core/io_async.h"
 #include "../src/iq_core/io_sigmf.h"
 #include "../src/demod/am.h"
 #include "../src/demod/wave.h"
 #include "../src/demod/agc.h"
 #include "../src/iq_core/resample.h"
+#include "../src/iq_core/xlate.h"
+#include "../src/iq_core/profile.h"
+#include "../src/jobs/tools.h"
 
 #define DEFAULT_AUDIO_RATE 48000
 #define DEFAULT_DC_BLOCK_CUTOFF 100.0f
+#define DEFAULT_FILTER_TRANSITION 2000.0f
 #define DEFAULT_AGC_TARGET_DBFS -12.0f
 #define DEFAULT_AGC_MAX_GAIN_DB 60.0f
 #define BLOCK_SIZE 8192
+#define AM_CHANNEL_HALF_WIDTH 8000.0f   // Default audio band either side of the carrier
 
 // Command line arguments structure
 typedef struct {
     const char *input_file;
     const char *meta_file;
     const char *output_file;
-    int8_t format;  // 0=s8, 1=s16
+    int8_t format;  // iq_format_t value, -1 = auto-detect
     float sample_rate;
     float audio_rate;
     float dc_block_cutoff;
+    float channel_cutoff;     // > 0: FIR channel filter passing the carrier +- this (Hz)
+    float filter_transition;
+    float demod_rate;         // Rate to demodulate at, < 0: from the channel width, 0: input rate
     bool enable_agc;
     float agc_target_dbfs;
     float agc_max_gain_db;
+    bool realtime;
+    const char *rt_stats;
     bool verbose;
 } args_t;
 
 // Print usage information
-void print_usage(const char *program_name) {
+static void print_usage(const char *program_name) {
     printf("IQ Lab - AM Demodulator Tool\n");
     printf("Demodulates AM signals from IQ data to WAV audio\n\n");
     printf("Usage: %s [OPTIONS] --in <iq_file> --out <wav_file>\n\n", program_name);
@@ -95,13 +117,21 @@ void print_usage(const char *program_name) {
     printf("\n");
     printf("Optional Arguments:\n");
     printf("  --meta <file>     SigMF metadata file (auto-detected if not specified)\n");
-    printf("  --format {s8|s16} IQ data format (default: auto-detect)\n");
+    printf("  --format {s8|s16|s12|s4} IQ data format (default: auto-detect)\n");
     printf("  --rate <Hz>       IQ sample rate (default: from metadata or 2000000)\n");
     printf("  --audio-rate <Hz> Output audio sample rate (default: %d)\n", DEFAULT_AUDIO_RATE);
     printf("  --dc-cutoff <Hz>  DC blocking filter cutoff (default: %.0f)\n", DEFAULT_DC_BLOCK_CUTOFF);
+    printf("  --channel-filter <Hz> FIR channel filter passing the carrier +- this (default: off)\n");
+    printf("  --filter-transition <Hz> Channel filter transition width (default: %.0f)\n", DEFAULT_FILTER_TRANSITION);
+    printf("  --demod-rate <Hz> Decimate the IQ to at least this rate before demodulating\n");
+    printf("                    (default: 1.25x the channel width; 0 = demodulate at the input rate)\n");
     printf("  --agc             Enable automatic gain control\n");
     printf("  --agc-target <dB> AGC target level (default: %.1f dBFS)\n", DEFAULT_AGC_TARGET_DBFS);
     printf("  --agc-max <dB>    AGC maximum gain (default: %.0f dB)\n", DEFAULT_AGC_MAX_GAIN_DB);
+    printf("  --profile[=<file>] Per-stage timing on stderr at exit, or as JSON to <file>\n");
+    printf("  --trace <file>     Per-thread timeline of the stages as Chrome trace JSON\n");
+    printf("  --realtime         Replay at the sample rate like a live source, reporting deadlines\n");
+    printf("  --rt-stats <file>  Real-time stats as JSON, rewritten every second (implies --realtime)\n");
     printf("  --verbose         Verbose output\n");
     printf("  --help           Show this help message\n");
     printf("\n");
@@ -112,16 +142,21 @@ void print_usage(const char *program_name) {
 }
 
 // Parse command line arguments
-bool parse_args(int argc, char *argv[], args_t *args) {
+static bool parse_args(int argc, char *argv[], args_t *args) {
     // Initialize defaults
     memset(args, 0, sizeof(args_t));
     args->format = -1;  // Auto-detect
     args->sample_rate = 2000000.0f;  // Default if no metadata
     args->audio_rate = DEFAULT_AUDIO_RATE;
     args->dc_block_cutoff = DEFAULT_DC_BLOCK_CUTOFF;
+    args->channel_cutoff = 0.0f;
+    args->filter_transition = DEFAULT_FILTER_TRANSITION;
+    args->demod_rate = -1.0f;
     args->enable_agc = false;
     args->agc_target_dbfs = DEFAULT_AGC_TARGET_DBFS;
     args->agc_max_gain_db = DEFAULT_AGC_MAX_GAIN_DB;
+    args->realtime = false;
+    args->rt_stats = NULL;
     args->verbose = false;
 
     struct option long_options[] = {
@@ -132,16 +167,23 @@ bool parse_args(int argc, char *argv[], args_t *args) {
         {"rate", required_argument, 0, 'r'},
         {"audio-rate", required_argument, 0, 'a'},
         {"dc-cutoff", required_argument, 0, 'd'},
+        {"channel-filter", required_argument, 0, 'c'},
+        {"filter-transition", required_argument, 0, 'T'},
+        {"demod-rate", required_argument, 0, 'D'},
         {"agc", no_argument, 0, 'g'},
         {"agc-target", required_argument, 0, 't'},
         {"agc-max", required_argument, 0, 'x'},
+        {"profile", optional_argument, 0, 'P'},
+        {"trace", required_argument, 0, 'Q'},
+        {"realtime", no_argument, 0, 'R'},
+        {"rt-stats", required_argument, 0, 'Y'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "i:m:o:f:r:a:d:gt:x:vh", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "i:m:o:f:r:a:d:c:T:gt:x:vh", long_options, NULL)) != -1) {
         switch (opt) {
             case 'i':
                 args->input_file = optarg;
@@ -153,14 +195,12 @@ bool parse_args(int argc, char *argv[], args_t *args) {
                 args->output_file = optarg;
                 break;
             case 'f':
-                if (strcmp(optarg, "s8") == 0) {
-                    args->format = 0;
-                } else if (strcmp(optarg, "s16") == 0) {
-                    args->format = 1;
-                } else {
-                    fprintf(stderr, "Error: Invalid format '%s'. Use 's8' or 's16'\n", optarg);
+                iq_format_t format;
+                if (!iq_parse_format(optarg, &format)) {
+                    fprintf(stderr, "Error: Invalid format '%s'. Use 's8', 's16', 's12' or 's4'\n", optarg);
                     return false;
                 }
+                args->format = (int8_t)format;
                 break;
             case 'r':
                 args->sample_rate = atof(optarg);
@@ -171,6 +211,15 @@ bool parse_args(int argc, char *argv[], args_t *args) {
             case 'd':
                 args->dc_block_cutoff = atof(optarg);
                 break;
+            case 'c':
+                args->channel_cutoff = atof(optarg);
+                break;
+            case 'T':
+                args->filter_transition = atof(optarg);
+                break;
+            case 'D':
+                args->demod_rate = atof(optarg);
+                break;
             case 'g':
                 args->enable_agc = true;
                 break;
@@ -180,6 +229,19 @@ bool parse_args(int argc, char *argv[], args_t *args) {
             case 'x':
                 args->agc_max_gain_db = atof(optarg);
                 break;
+            case 'P':
+                iq_profile_start("iqdemod-am", optarg);
+                break;
+            case 'Q':
+                if (!iq_trace_start("iqdemod-am", optarg)) return false;
+                break;
+            case 'R':
+                args->realtime = true;
+                break;
+            case 'Y':
+                args->realtime = true;
+                args->rt_stats = optarg;
+                break;
             case 'v':
                 args->verbose = true;
                 break;
@@ -205,7 +267,7 @@ bool parse_args(int argc, char *argv[], args_t *args) {
 }
 
 // Load SigMF metadata and extract sample rate
-bool load_metadata(const char *meta_file, float *sample_rate) {
+static bool load_metadata(const char *meta_file, float *sample_rate) {
     sigmf_metadata_t meta;
     sigmf_init_metadata(&meta);
 
@@ -227,14 +289,58 @@ bool load_metadata(const char *meta_file, float *sample_rate) {
     return false;
 }
 
+/*
+ * Integer decimation ahead of the detector: the channel is the audio band
+ * either side of the carrier, kept within the 80% of the decimated rate
+ * that the xlate filters pass (1: demodulate at the input rate)
+ */
+static uint32_t channel_decimation(const args_t *args, uint32_t sample_rate, double *bandwidth) {
+    float half_width = args->channel_cutoff > 0.0f ? args->channel_cutoff + args->filter_transition
+                                                   : AM_CHANNEL_HALF_WIDTH;
+    *bandwidth = 2.0 * half_width;
+    double target = args->demod_rate < 0.0f ? *bandwidth / 0.8 : (double)args->demod_rate;
+    if (target <= 0.0 || target >= sample_rate) return 1;
+    if (*bandwidth > 0.8 * target) *bandwidth = 0.8 * target;
+
+    // A factor that divides the rate keeps the audio rate exact for the resampler
+    uint32_t decimation = (uint32_t)floor(sample_rate / target);
+    while (decimation > 1 && sample_rate % decimation != 0) decimation--;
+    return decimation > 1 ? decimation : 1;
+}
+
+// Channel-filter and decimate one block, timed for --profile
+static size_t decimate_channel(xlate_t *xlate, const float *iq, size_t count, float *channel) {
+    uint64_t start = iq_profile_begin();
+    size_t produced = xlate_process(xlate, iq, count, channel);
+    iq_profile_end(IQ_PROFILE_FILTER, start, count, count * 2 * sizeof(float));
+    return produced;
+}
+
+// Resample one block of audio, timed for --profile
+static bool resample_audio(resample_t *resampler, const float *input, uint32_t count,
+                           float *output, uint32_t max_output, uint32_t *produced) {
+    uint64_t start = iq_profile_begin();
+    bool ok = resample_process_buffer(resampler, input, count, output, max_output, produced);
+    iq_profile_end(IQ_PROFILE_RESAMPLE, start, count, (uint64_t)count * sizeof(float));
+    return ok;
+}
+
+// Convert and write audio frames to the WAV file, timed for --profile
+static bool write_audio(wave_writer_t *writer, const float *samples, uint32_t frames) {
+    uint64_t start = iq_profile_begin();
+    bool ok = wave_writer_write_float(writer, samples, frames);
+    iq_profile_end(IQ_PROFILE_ENCODE, start, frames, (uint64_t)frames * writer->channels * sizeof(int16_t));
+    return ok;
+}
+
 // Main processing function
-int process_am_demodulation(const args_t *args) {
-    // Load IQ data
-    iq_data_t iq_data;
-    if (args->verbose) printf("Loading IQ data from '%s'...\n", args->input_file);
+static int process_am_demodulation(const args_t *args) {
+    // Open IQ stream (samples are read block by block below)
+    iq_reader_t reader;
+    if (args->verbose) printf("Opening IQ data from '%s'...\n", args->input_file);
 
-    if (!iq_load_file(args->input_file, &iq_data)) {
-        fprintf(stderr, "Error: Failed to load IQ data from '%s'\n", args->input_file);
+    if (!iq_reader_open(&reader, args->input_file)) {
+        fprintf(stderr, "Error: Failed to open IQ data from '%s'\n", args->input_file);
         return EXIT_FAILURE;
     }
 
@@ -248,12 +354,21 @@ int process_am_demodulation(const args_t *args) {
         }
     }
 
-    // Override iq_data sample_rate with the determined rate
-    iq_data.sample_rate = actual_sample_rate;
+    // Override the reader sample_rate with the determined rate
+    reader.sample_rate = actual_sample_rate;
 
     if (args->verbose) {
-        printf("Loaded %zu samples (%.2f seconds at %.0f Hz)\n",
-               iq_data.num_samples, (double)iq_data.num_samples / actual_sample_rate, (double)actual_sample_rate);
+        printf("Streaming %llu samples (%.2f seconds at %.0f Hz)\n",
+               (unsigned long long)reader.total_samples, (double)reader.total_samples / actual_sample_rate, (double)actual_sample_rate);
+    }
+
+    // Demodulate the channel, not the capture: decimate first when the rate allows
+    double channel_bw = 0.0;
+    uint32_t decimation = channel_decimation(args, reader.sample_rate, &channel_bw);
+    uint32_t demod_rate = reader.sample_rate / decimation;
+    if (args->verbose && decimation > 1) {
+        printf("Channel filter: %.0f Hz wide, decimation %u -> %u Hz\n",
+               channel_bw, decimation, demod_rate);
     }
 
     // Initialize AM demodulator
@@ -263,12 +378,24 @@ int process_am_demodulation(const args_t *args) {
     }
 
     am_demod_t am;
-    if (!am_demod_init_custom(&am, iq_data.sample_rate, args->dc_block_cutoff)) {
+    if (!am_demod_init_custom(&am, demod_rate, args->dc_block_cutoff)) {
         fprintf(stderr, "Error: Failed to initialize AM demodulator\n");
-        iq_free(&iq_data);
+        iq_reader_close(&reader);
         return EXIT_FAILURE;
     }
 
+    if (args->channel_cutoff > 0.0f) {
+        if (!am_demod_set_channel_filter(&am, args->channel_cutoff, args->filter_transition)) {
+            fprintf(stderr, "Error: Failed to create the FIR channel filter\n");
+            iq_reader_close(&reader);
+            return EXIT_FAILURE;
+        }
+        if (args->verbose) {
+            printf("  FIR channel filter: %u taps (%s)\n", am.fir.num_taps,
+                   am.fir.method == FIR_METHOD_FFT ? "overlap-save" : "direct");
+        }
+    }
+
     // Initialize AGC if requested
     agc_t agc;
     if (args->enable_agc) {
@@ -284,23 +411,31 @@ int process_am_demodulation(const args_t *args) {
         if (!agc_init_custom(&agc, args->audio_rate, 0.01f, 0.1f,
                            reference_level, args->agc_max_gain_db, 0.5f)) {
             fprintf(stderr, "Error: Failed to initialize AGC\n");
-            iq_free(&iq_data);
+            am_demod_free(&am);
+            iq_reader_close(&reader);
             return EXIT_FAILURE;
         }
+
+        // Envelope and gain once per sub-block, gain ramped in between
+        agc_set_block_size(&agc, AGC_DEFAULT_BLOCK_SIZE);
     }
 
     // Initialize resampler if needed
     resample_t resampler;
-    bool needs_resampling = fabsf((float)iq_data.sample_rate - args->audio_rate) > 1.0f;
+    bool needs_resampling = fabsf((float)demod_rate - args->audio_rate) > 1.0f;
+    // Audio per block: a narrow channel is resampled up to the audio rate, not down
+    uint32_t resample_capacity = resample_estimate_output_size(
+        BLOCK_SIZE, resample_get_ratio(demod_rate, (uint32_t)args->audio_rate)) + 16;
     if (needs_resampling) {
         if (args->verbose) {
             printf("Initializing resampler: %.0f Hz -> %.0f Hz\n",
-                   (double)iq_data.sample_rate, (double)args->audio_rate);
+                   (double)demod_rate, (double)args->audio_rate);
         }
 
-        if (!resample_init(&resampler, iq_data.sample_rate, args->audio_rate)) {
+        if (!resample_init(&resampler, demod_rate, args->audio_rate)) {
             fprintf(stderr, "Error: Failed to initialize resampler\n");
-            iq_free(&iq_data);
+            am_demod_free(&am);
+            iq_reader_close(&reader);
             return EXIT_FAILURE;
         }
     }
@@ -309,19 +444,42 @@ int process_am_demodulation(const args_t *args) {
     if (args->verbose) printf("Initializing WAV writer...\n");
 
     wave_writer_t wav_writer;
-    if (!wave_writer_init(&wav_writer, args->output_file, args->audio_rate, 1)) {  // Mono
+    if (!wave_writer_init_custom(&wav_writer, args->output_file, args->audio_rate, 1, NULL)) {  // Mono
         fprintf(stderr, "Error: Failed to initialize WAV writer\n");
-        iq_free(&iq_data);
+        am_demod_free(&am);
+        iq_reader_close(&reader);
         if (needs_resampling) resample_free(&resampler);
         return EXIT_FAILURE;
     }
 
     // Process IQ data in blocks
     float *audio_buffer = malloc(BLOCK_SIZE * sizeof(float));
-    if (!audio_buffer) {
+
+    // Decimated channel samples feeding the detector
+    xlate_t channel = {0};
+    float *channel_buffer = NULL;
+    bool channel_ok = true;
+    if (decimation > 1) {
+        channel_buffer = malloc((BLOCK_SIZE / decimation + 1) * 2 * sizeof(float));
+        channel_ok = channel_buffer && xlate_init(&channel, reader.sample_rate, 0.0, decimation, channel_bw);
+    }
+
+    // File reads and sample conversion run ahead on a background thread;
+    // --realtime paces them like a live source and watches the deadlines
+    rt_monitor_t *monitor = args->realtime ?
+        rt_monitor_create("iqdemod-am", reader.sample_rate, 0.0, args->rt_stats) : NULL;
+    iq_async_t *async = iq_async_create_realtime(&reader, BLOCK_SIZE, IQ_ASYNC_NUM_BLOCKS,
+                                                 monitor ? reader.sample_rate : 0.0, monitor);
+    if (!audio_buffer || !channel_ok || !async || (args->realtime && !monitor)) {
         fprintf(stderr, "Error: Failed to allocate audio buffer\n");
+        free(audio_buffer);
+        free(channel_buffer);
+        xlate_free(&channel);
+        iq_async_destroy(async);
+        rt_monitor_destroy(monitor);
         wave_writer_close(&wav_writer);
-        iq_free(&iq_data);
+        am_demod_free(&am);
+        iq_reader_close(&reader);
         if (needs_resampling) resample_free(&resampler);
         return EXIT_FAILURE;
     }
@@ -329,72 +487,65 @@ int process_am_demodulation(const args_t *args) {
     size_t total_samples_processed = 0;
     size_t total_audio_samples = 0;
 
-    for (size_t offset = 0; offset < iq_data.num_samples; offset += BLOCK_SIZE) {
-        size_t block_size = (offset + BLOCK_SIZE > iq_data.num_samples) ?
-                           iq_data.num_samples - offset : BLOCK_SIZE;
+    const iq_async_block_t *block;
+    while ((block = iq_async_acquire(async)) != NULL) {
+        const float *iq_buffer = block->samples;
+        size_t block_size = block->num_samples;
+        if (decimation > 1) {
+            block_size = decimate_channel(&channel, iq_buffer, block_size, channel_buffer);
+            iq_buffer = channel_buffer;
+        }
 
-        // Demodulate this block
-        for (size_t i = 0; i < block_size; i++) {
-            size_t idx = (offset + i) * 2;  // Interleaved: I,Q,I,Q,...
-            float i_sample = iq_data.data[idx];
-            float q_sample = iq_data.data[idx + 1];
-            audio_buffer[i] = am_demod_process_sample(&am, i_sample, q_sample);
+        // Demodulate this block straight from the interleaved samples
+        uint64_t demod_start = iq_profile_begin();
+        if (block_size > 0) {
+            am_demod_process_buffer_iq(&am, iq_buffer, (uint32_t)block_size, audio_buffer);
         }
 
         // Apply AGC if enabled
         if (args->enable_agc) {
             agc_process_buffer(&agc, audio_buffer, block_size);
         }
+        iq_profile_end(IQ_PROFILE_DEMOD, demod_start, block_size, block_size * 2 * sizeof(float));
 
         // Resample if needed
         if (needs_resampling) {
             // Resample the block
             uint32_t output_samples = 0;
-            float *resampled = malloc(block_size * 2 * sizeof(float));  // Allocate enough space
+            float *resampled = malloc(resample_capacity * sizeof(float));
             if (resampled) {
-                if (resample_process_buffer(&resampler, audio_buffer, block_size,
-                                          resampled, block_size * 2, &output_samples)) {
-                    // Convert float to int16 for WAV output
-                    int16_t *wav_samples = malloc(output_samples * sizeof(int16_t));
-                    if (wav_samples) {
-                        for (uint32_t j = 0; j < output_samples; j++) {
-                            // Clamp to [-1, 1] and convert to int16
-                            float sample = resampled[j];
-                            if (sample > 1.0f) sample = 1.0f;
-                            if (sample < -1.0f) sample = -1.0f;
-                            wav_samples[j] = (int16_t)(sample * 32767.0f);
-                        }
-                        wave_writer_write_samples(&wav_writer, wav_samples, output_samples);
-                        total_audio_samples += output_samples;
-                        free(wav_samples);
+                if (resample_audio(&resampler, audio_buffer, block_size,
+                                 resampled, resample_capacity, &output_samples)) {
+                    // Clamped and converted to int16 by the WAV writer
+                    if (output_samples > 0) {
+                        write_audio(&wav_writer, resampled, output_samples);
                     }
+                    total_audio_samples += output_samples;
                 }
                 free(resampled);
             }
         } else {
-            // Convert float to int16 for WAV output
-            int16_t *wav_samples = malloc(block_size * sizeof(int16_t));
-            if (wav_samples) {
-                for (size_t i = 0; i < block_size; i++) {
-                    // Clamp to [-1, 1] and convert to int16
-                    float sample = audio_buffer[i];
-                    if (sample > 1.0f) sample = 1.0f;
-                    if (sample < -1.0f) sample = -1.0f;
-                    wav_samples[i] = (int16_t)(sample * 32767.0f);
-                }
-                wave_writer_write_samples(&wav_writer, wav_samples, block_size);
-                total_audio_samples += block_size;
-                free(wav_samples);
+            // Clamped and converted to int16 by the WAV writer
+            if (block_size > 0) {
+                write_audio(&wav_writer, audio_buffer, (uint32_t)block_size);
             }
+            total_audio_samples += block_size;
         }
 
-        total_samples_processed += block_size;
+        total_samples_processed += block->num_samples;
 
         if (args->verbose && total_samples_processed % (BLOCK_SIZE * 10) == 0) {
-            printf("Processed %zu/%zu samples (%.1f%%)\n",
-                   total_samples_processed, iq_data.num_samples,
-                   100.0f * total_samples_processed / iq_data.num_samples);
+            if (reader.total_samples == 0) {
+                printf("Processed %zu samples\n", total_samples_processed);  // Live input
+            } else {
+                printf("Processed %zu/%llu samples (%.1f%%)\n",
+                       total_samples_processed, (unsigned long long)reader.total_samples,
+                       100.0f * total_samples_processed / reader.total_samples);
+            }
         }
+
+        iq_async_release(async, block);
+        rt_monitor_poll(monitor);
     }
 
     // Report statistics
@@ -406,9 +557,14 @@ int process_am_demodulation(const args_t *args) {
     }
 
     // Clean up
+    iq_async_destroy(async);
+    rt_monitor_destroy(monitor);
     free(audio_buffer);
+    free(channel_buffer);
+    xlate_free(&channel);
     wave_writer_close(&wav_writer);
-    iq_free(&iq_data);
+    am_demod_free(&am);
+    iq_reader_close(&reader);
     if (needs_resampling) resample_free(&resampler);
 
     if (args->verbose) {
@@ -421,7 +577,8 @@ int process_am_demodulation(const args_t *args) {
     return EXIT_SUCCESS;
 }
 
-int main(int argc, char *argv[]) {
+// Tool entry point (also called in process by iqjob, see src/jobs/tools.h)
+int iqdemod_am_main(int argc, char *argv[]) {
     args_t args;
 
     if (!parse_args(argc, argv, &args)) {
@@ -437,3 +594,9 @@ int main(int argc, char *argv[]) {
 
     return process_am_demodulation(&args);
 }
+
+#ifndef IQ_TOOL_LIBRARY
+int main(int argc, char *argv[]) {
+    return iqdemod_am_main(argc, argv);
+}
+#endif
@@ -0,0 +1,444 @@
+/*
+ * IQ Lab - iqdemod-bank: Multi-Channel Demodulator
+ *
+ * Purpose: Demodulate many channels of one wideband capture in a single
+ * streaming read, one WAV file per channel.
+ *
+ * Usage: iqdemod-bank --in <input.iq> --rate <sample_rate> --channels <N> \
+ *                     --bandwidth <Hz> --demod <list> --out <output_dir>
+ *                     [--mode {auto|pfb|ddc}] [--threads <N>] [options]
+ *
+ * The capture is split into N channels as iqchan does (channel k centred
+ * on (k - N/2) * rate / N); --demod attaches a demodulator to each wanted
+ * channel, e.g. "3:usb,17:am,40-43:lsb". Every channel runs its own
+ * FM/AM/SSB demodulator, resampler and optional AGC (demod_bank.h), with
+ * the per-channel DSP spread over scheduler workers, and is written to
+ * <out>/channel_<k>_<mode>.wav.
+ *
+ * Applications:
+ * - HF monitoring: dozens of SSB/AM voice channels from one capture
+ * - VHF/UHF channel plans: a bank of NBFM channels
+ *
+ *
+ * Date: 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+#include "../src/iq_core/io_iq.h"
+#include "../src/iq_core/io_async.h"
+#include "../src/iq_core/io_stream.h"
+#include "../src/iq_core/io_sigmf.h"
+#include "../src/demod/demod_bank.h"
+#include "../src/iq_core/profile.h"
+#include "../src/iq_core/affinity.h"
+
+#define DEFAULT_AUDIO_RATE 48000
+#define DEFAULT_FM_DEVIATION 5000.0f
+#define DEFAULT_BFO_FREQUENCY 1500.0f
+#define DEFAULT_LPF_CUTOFF 3000.0f
+#define DEFAULT_AGC_TARGET_DBFS -12.0f
+#define DEFAULT_AGC_MAX_GAIN_DB 60.0f
+#define BLOCK_SIZE 8192
+
+// Command line arguments
+typedef struct {
+    const char *input_file;
+    const char *output_dir;
+    const char *meta_file;
+    const char *demod_list;
+    const char *mode;
+    double sample_rate;
+    uint32_t num_channels;
+    double channel_bandwidth;
+    uint32_t audio_rate;
+    uint32_t threads;
+    float fm_deviation;
+    float bfo_frequency;
+    float lpf_cutoff;
+    bool enable_agc;
+    float agc_target_dbfs;
+    float agc_max_gain_db;
+    uint32_t wav_buffer_kib;
+    bool direct_io;
+    bool realtime;
+    const char *rt_stats;
+    bool verbose;
+} args_t;
+
+// Print usage information
+static void print_usage(const char *program_name) {
+    printf("IQ Lab - Multi-Channel Demodulator\n");
+    printf("Demodulates many channels of one IQ capture to WAV files in one pass\n\n");
+    printf("Usage: %s [OPTIONS] --in <iq_file> --channels <N> --bandwidth <Hz> \\\n", program_name);
+    printf("       --demod <list> --out <dir>\n\n");
+    printf("Required Arguments:\n");
+    printf("  --in <file>        Input IQ file (s8 or s16 interleaved)\n");
+    printf("  --channels <N>     Channels the capture is split into (power of 2)\n");
+    printf("  --bandwidth <Hz>   Bandwidth per channel\n");
+    printf("  --demod <list>     Channels and demodulators (fm, am, usb, lsb),\n");
+    printf("                     e.g. 3:usb,17:am,40-43:lsb\n");
+    printf("  --out <dir>        Output directory for channel_<k>_<mode>.wav\n\n");
+    printf("Optional Arguments:\n");
+    printf("  --meta <file>      SigMF metadata file (sample rate)\n");
+    printf("  --rate <Hz>        IQ sample rate (default: from metadata or 2000000)\n");
+    printf("  --audio-rate <Hz>  Output audio sample rate (default: %d)\n", DEFAULT_AUDIO_RATE);
+    printf("  --mode <m>         auto: DDC per channel while cheaper than the full\n");
+    printf("                     bank, else PFB; pfb or ddc force one (default: auto)\n");
+    printf("  --threads <N>      Demodulator threads (default: 0 = one per core)\n");
+    printf("  --deviation <Hz>   FM deviation (default: %.0f)\n", (double)DEFAULT_FM_DEVIATION);
+    printf("  --bfo <Hz>         SSB BFO frequency (default: %.0f)\n", (double)DEFAULT_BFO_FREQUENCY);
+    printf("  --lpf-cutoff <Hz>  SSB low-pass filter cutoff (default: %.0f)\n", (double)DEFAULT_LPF_CUTOFF);
+    printf("  --agc              Enable automatic gain control\n");
+    printf("  --agc-target <dB>  AGC target level (default: %.1f dBFS)\n", DEFAULT_AGC_TARGET_DBFS);
+    printf("  --agc-max <dB>     AGC maximum gain (default: %.0f dB)\n", DEFAULT_AGC_MAX_GAIN_DB);
+    printf("  --wav-buffer <KiB> Write buffer per WAV file (default: %d)\n",
+           WAVE_DEFAULT_BUFFER_SIZE / 1024);
+    printf("  --direct-io        Write WAV files with O_DIRECT, bypassing the page cache\n");
+    printf("  --profile[=<file>] Per-stage timing on stderr at exit, or as JSON to <file>\n");
+    printf("  --trace <file>     Per-thread timeline of the stages as Chrome trace JSON\n");
+    printf("  --pin[=<policy>]   Pin threads to CPUs: compact (default), scatter, or a CPU\n");
+    printf("                     list such as 0-7,16-23\n");
+    printf("  --realtime         Replay at the sample rate like a live source, reporting deadlines\n");
+    printf("  --rt-stats <file>  Real-time stats as JSON, rewritten every second (implies --realtime)\n");
+    printf("  --verbose          Verbose output\n");
+    printf("  --help             Show this help message\n\n");
+    printf("Examples:\n");
+    printf("  # 32 SSB voice channels of 3 kHz out of a 96 kHz HF capture\n");
+    printf("  %s --in hf.iq --rate 96000 --channels 32 --bandwidth 3000 \\\n", program_name);
+    printf("       --demod 0-15:lsb,16-31:usb --out hf_audio/\n\n");
+    printf("  # Two AM and one NBFM channel of a 2 MHz capture via DDC\n");
+    printf("  %s --in capture.iq --rate 2000000 --channels 128 --bandwidth 15625 \\\n", program_name);
+    printf("       --demod 40:am,41:am,90:fm --mode ddc --out picks/\n");
+}
+
+// Parse command line arguments
+static bool parse_args(int argc, char *argv[], args_t *args) {
+    memset(args, 0, sizeof(*args));
+    args->sample_rate = 2000000.0;
+    args->audio_rate = DEFAULT_AUDIO_RATE;
+    args->mode = "auto";
+    args->fm_deviation = DEFAULT_FM_DEVIATION;
+    args->bfo_frequency = DEFAULT_BFO_FREQUENCY;
+    args->lpf_cutoff = DEFAULT_LPF_CUTOFF;
+    args->agc_target_dbfs = DEFAULT_AGC_TARGET_DBFS;
+    args->agc_max_gain_db = DEFAULT_AGC_MAX_GAIN_DB;
+    args->wav_buffer_kib = WAVE_DEFAULT_BUFFER_SIZE / 1024;
+
+    static struct option long_options[] = {
+        {"in", required_argument, 0, 'i'},
+        {"out", required_argument, 0, 'o'},
+        {"meta", required_argument, 0, 'm'},
+        {"rate", required_argument, 0, 'r'},
+        {"channels", required_argument, 0, 'c'},
+        {"bandwidth", required_argument, 0, 'b'},
+        {"demod", required_argument, 0, 'd'},
+        {"audio-rate", required_argument, 0, 'a'},
+        {"mode", required_argument, 0, 'X'},
+        {"threads", required_argument, 0, 'T'},
+        {"deviation", required_argument, 0, 'D'},
+        {"bfo", required_argument, 0, 'B'},
+        {"lpf-cutoff", required_argument, 0, 'L'},
+        {"agc", no_argument, 0, 'g'},
+        {"agc-target", required_argument, 0, 't'},
+        {"agc-max", required_argument, 0, 'x'},
+        {"wav-buffer", required_argument, 0, 'W'},
+        {"direct-io", no_argument, 0, 'O'},
+        {"profile", optional_argument, 0, 'P'},
+        {"trace", required_argument, 0, 'Q'},
+        {"pin", optional_argument, 0, 'N'},
+        {"realtime", no_argument, 0, 'R'},
+        {"rt-stats", required_argument, 0, 'Y'},
+        {"verbose", no_argument, 0, 'v'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "i:o:m:r:c:b:d:a:X:T:D:B:L:gt:x:W:Ovh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'i': args->input_file = optarg; break;
+            case 'o': args->output_dir = optarg; break;
+            case 'm': args->meta_file = optarg; break;
+            case 'r': args->sample_rate = atof(optarg); break;
+            case 'c': args->num_channels = (uint32_t)atoi(optarg); break;
+            case 'b': args->channel_bandwidth = atof(optarg); break;
+            case 'd': args->demod_list = optarg; break;
+            case 'a': args->audio_rate = (uint32_t)atoi(optarg); break;
+            case 'X': args->mode = optarg; break;
+            case 'T': args->threads = (uint32_t)atoi(optarg); break;
+            case 'D': args->fm_deviation = (float)atof(optarg); break;
+            case 'B': args->bfo_frequency = (float)atof(optarg); break;
+            case 'L': args->lpf_cutoff = (float)atof(optarg); break;
+            case 'g': args->enable_agc = true; break;
+            case 't': args->agc_target_dbfs = (float)atof(optarg); break;
+            case 'x': args->agc_max_gain_db = (float)atof(optarg); break;
+            case 'W': args->wav_buffer_kib = (uint32_t)atoi(optarg); break;
+            case 'O': args->direct_io = true; break;
+            case 'P': iq_profile_start("iqdemod-bank", optarg); break;
+            case 'Q': if (!iq_trace_start("iqdemod-bank", optarg)) return false; break;
+            case 'N': if (!iq_affinity_start(optarg)) return false; break;
+            case 'R': args->realtime = true; break;
+            case 'Y': args->realtime = true; args->rt_stats = optarg; break;
+            case 'v': args->verbose = true; break;
+            case 'h':
+                print_usage(argv[0]);
+                exit(EXIT_SUCCESS);
+            default:
+                print_usage(argv[0]);
+                return false;
+        }
+    }
+
+    if (!args->input_file || !args->output_dir || !args->demod_list ||
+        args->num_channels == 0 || args->channel_bandwidth <= 0.0) {
+        fprintf(stderr, "Error: --in, --out, --channels, --bandwidth and --demod are required\n");
+        print_usage(argv[0]);
+        return false;
+    }
+    if (strcmp(args->mode, "auto") != 0 && strcmp(args->mode, "pfb") != 0 &&
+        strcmp(args->mode, "ddc") != 0) {
+        fprintf(stderr, "Error: Mode must be 'auto', 'pfb' or 'ddc'\n");
+        return false;
+    }
+    if (args->audio_rate == 0 || args->sample_rate <= 0.0) {
+        fprintf(stderr, "Error: Sample rates must be positive\n");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Parse a demodulator list such as "3:usb,17:am,40-43:lsb"
+ *
+ * @param channels Receives the channel indices in list order (num_channels slots)
+ * @param modes Receives their modes
+ * @param count Receives the number of channels
+ */
+static bool parse_demod_list(const char *list, uint32_t num_channels, uint32_t *channels,
+                             demod_bank_mode_t *modes, uint32_t *count) {
+    bool *seen = (bool *)calloc(num_channels, sizeof(bool));
+    if (!seen) return false;
+
+    *count = 0;
+    const char *p = list;
+    bool ok = true;
+    while (ok && *p) {
+        char *end;
+        unsigned long first = strtoul(p, &end, 10);
+        unsigned long last = first;
+        ok = end != p;
+        if (ok && *end == '-') {
+            p = end + 1;
+            last = strtoul(p, &end, 10);
+            ok = end != p && last >= first;
+        }
+        ok = ok && *end == ':' && last < num_channels;
+
+        char name[8] = {0};
+        size_t length = ok ? strcspn(end + 1, ",") : 0;
+        demod_bank_mode_t mode = DEMOD_BANK_FM;
+        if (ok) {
+            ok = length > 0 && length < sizeof(name);
+            if (ok) memcpy(name, end + 1, length);
+            ok = ok && demod_bank_parse_mode(name, &mode);
+            end += 1 + length;
+        }
+
+        for (unsigned long chan = first; ok && chan <= last; chan++) {
+            if (seen[chan]) {
+                fprintf(stderr, "Error: Channel %lu listed twice\n", chan);
+                ok = false;
+                break;
+            }
+            seen[chan] = true;
+            channels[*count] = (uint32_t)chan;
+            modes[(*count)++] = mode;
+        }
+        p = ok && *end == ',' ? end + 1 : end;
+    }
+    free(seen);
+
+    if (!ok || *count == 0) {
+        fprintf(stderr, "Error: Invalid demodulator list '%s' (channels 0-%u, modes fm/am/usb/lsb, "
+                "e.g. 3:usb,40-43:lsb)\n", list, num_channels - 1);
+        return false;
+    }
+    return true;
+}
+
+// Create the output directory if needed
+static bool create_output_directory(const char *dir_path) {
+    struct stat st;
+    if (stat(dir_path, &st) == 0) {
+        if (S_ISDIR(st.st_mode)) return true;
+        fprintf(stderr, "Error: '%s' exists but is not a directory\n", dir_path);
+        return false;
+    }
+#ifdef _WIN32
+    if (mkdir(dir_path) != 0) {
+#else
+    if (mkdir(dir_path, 0755) != 0) {
+#endif
+        fprintf(stderr, "Error: Failed to create output directory '%s': %s\n", dir_path,
+                strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Main processing function
+static int process_bank(const args_t *args) {
+    double sample_rate = args->sample_rate;
+    if (args->meta_file) {
+        sigmf_metadata_t meta;
+        sigmf_init_metadata(&meta);
+        if (sigmf_read_metadata(args->meta_file, &meta) && meta.global.sample_rate > 0) {
+            sample_rate = (double)meta.global.sample_rate;
+            if (args->verbose) printf("Sample rate from metadata: %.0f Hz\n", sample_rate);
+        } else {
+            fprintf(stderr, "Warning: No sample rate found in '%s'\n", args->meta_file);
+        }
+        sigmf_free_metadata(&meta);
+    }
+
+    demod_bank_config_t config;
+    if (!demod_bank_config_init(&config, args->num_channels, sample_rate, args->channel_bandwidth)) {
+        fprintf(stderr, "Error: Invalid channel layout (%u channels of %.0f Hz at %.0f Hz)\n",
+                args->num_channels, args->channel_bandwidth, sample_rate);
+        return EXIT_FAILURE;
+    }
+    config.audio_rate = args->audio_rate;
+    config.num_workers = args->threads;
+    config.fm_deviation = args->fm_deviation;
+    config.ssb_bfo = args->bfo_frequency;
+    config.ssb_lpf_cutoff = args->lpf_cutoff;
+    config.enable_agc = args->enable_agc;
+    config.agc_reference = powf(10.0f, args->agc_target_dbfs / 20.0f);
+    config.agc_max_gain = powf(10.0f, args->agc_max_gain_db / 20.0f);
+    config.wav.buffer_size = (size_t)args->wav_buffer_kib * 1024;
+    config.wav.direct_io = args->direct_io;
+
+    uint32_t *channels = (uint32_t *)malloc(args->num_channels * sizeof(uint32_t));
+    demod_bank_mode_t *modes = (demod_bank_mode_t *)malloc(args->num_channels * sizeof(demod_bank_mode_t));
+    char **paths = (char **)calloc(args->num_channels, sizeof(char *));
+    uint32_t count = 0;
+    int status = EXIT_FAILURE;
+    demod_bank_t *bank = NULL;
+    iq_reader_t reader;
+    bool reader_open = false;
+    iq_async_t *async = NULL;
+    rt_monitor_t *monitor = NULL;
+
+    if (!channels || !modes || !paths) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        goto cleanup;
+    }
+    if (!parse_demod_list(args->demod_list, args->num_channels, channels, modes, &count) ||
+        !create_output_directory(args->output_dir)) {
+        goto cleanup;
+    }
+    for (uint32_t slot = 0; slot < count; slot++) {
+        size_t length = strlen(args->output_dir) + 32;
+        paths[slot] = (char *)malloc(length);
+        if (!paths[slot]) goto cleanup;
+        snprintf(paths[slot], length, "%s/channel_%02u_%s.wav", args->output_dir, channels[slot],
+                 demod_bank_mode_name(modes[slot]));
+    }
+
+    // A DDC per channel while that is cheaper than the full bank
+    config.use_ddc = strcmp(args->mode, "ddc") == 0 ||
+                     (strcmp(args->mode, "auto") == 0 && ddc_bank_preferred(&config.pfb, count));
+    if (args->verbose) {
+        printf("Demodulating %u of %u channels via %s (cost: DDC %.1f, PFB %.1f MAC/sample)\n",
+               count, config.pfb.num_channels, config.use_ddc ? "DDC" : "PFB",
+               ddc_estimate_cost(&config.pfb, count), pfb_estimate_cost(&config.pfb));
+    }
+
+    bank = demod_bank_create(&config, channels, modes, (const char *const *)paths, count);
+    if (!bank) {
+        fprintf(stderr, "Error: Failed to create demodulator bank\n");
+        goto cleanup;
+    }
+    if (args->verbose) {
+        printf("Channel rate %.2f Hz, audio %u Hz, %u demodulator thread%s\n", bank->channel_rate,
+               config.audio_rate, bank->num_workers, bank->num_workers == 1 ? "" : "s");
+    }
+
+    if (!iq_reader_open(&reader, args->input_file)) {
+        fprintf(stderr, "Error: Failed to open IQ data from '%s'\n", args->input_file);
+        goto cleanup;
+    }
+    reader_open = true;
+
+    // File reads and sample conversion run ahead on a background thread;
+    // --realtime paces them like a live source and watches the deadlines
+    if (args->realtime) {
+        monitor = rt_monitor_create("iqdemod-bank", args->sample_rate, 0.0, args->rt_stats);
+        if (!monitor) goto cleanup;
+    }
+    async = iq_async_create_realtime(&reader, BLOCK_SIZE, IQ_ASYNC_NUM_BLOCKS,
+                                     monitor ? args->sample_rate : 0.0, monitor);
+    if (!async) {
+        fprintf(stderr, "Error: Failed to start the reader\n");
+        goto cleanup;
+    }
+
+    bool ok = true;
+    const iq_async_block_t *block;
+    while (ok && (block = iq_async_acquire(async)) != NULL) {
+        // Interleaved float I/Q has the float complex layout
+        ok = demod_bank_process_block(bank, (const float complex *)block->samples,
+                                      (uint32_t)block->num_samples);
+        iq_async_release(async, block);
+        rt_monitor_poll(monitor);
+    }
+    ok = demod_bank_finish(bank) && ok;
+    if (!ok) {
+        fprintf(stderr, "Error: Demodulation failed\n");
+        goto cleanup;
+    }
+
+    if (args->verbose) {
+        for (uint32_t slot = 0; slot < count; slot++) {
+            const demod_bank_channel_t *ch = &bank->channels[slot];
+            printf("  channel %3u %-3s %+12.1f Hz: %llu audio samples -> %s\n", ch->channel_index,
+                   demod_bank_mode_name(ch->mode), ch->center_frequency,
+                   (unsigned long long)ch->audio_samples, paths[slot]);
+        }
+        printf("Processed %llu input samples\n", (unsigned long long)bank->samples_consumed);
+    }
+    status = EXIT_SUCCESS;
+
+cleanup:
+    iq_async_destroy(async);
+    rt_monitor_destroy(monitor);
+    if (reader_open) iq_reader_close(&reader);
+    demod_bank_destroy(bank);
+    for (uint32_t slot = 0; paths && slot < args->num_channels; slot++) free(paths[slot]);
+    free(paths);
+    free(modes);
+    free(channels);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    args_t args;
+    if (!parse_args(argc, argv, &args)) {
+        return EXIT_FAILURE;
+    }
+    if (!iq_stream_is_spec(args.input_file) && access(args.input_file, F_OK) != 0) {
+        fprintf(stderr, "Error: Input file '%s' does not exist\n", args.input_file);
+        return EXIT_FAILURE;
+    }
+    return process_bank(&args);
+}
@@ -15,8 +15,9 @@
  * - Matrix decoding for L/R channel separation
  * - Deemphasis filtering (configurable time constants)
  * - DC blocking and automatic gain control
+ * - Channel filter and decimation ahead of the discriminator
  * - High-quality audio resampling
- * - Support for s8/s16 IQ data formats
+ * - Support for s8/s16 and packed s12/s4 IQ data formats
  *
  * Usage Examples:
  *   # Basic mono FM demodulation
@@ -38,6 +39,23 @@
  * - Mono or stereo depending on --stereo-output flag
  * - Configurable sample rates with high-quality resampling
  *
+ * Pipeline:
+ *   IQ -> channel filter / decimate (xlate.h) -> discriminator, stereo
+ *   decoder, deemphasis, AGC -> audio resample -> WAV
+ * - The capture is decimated by an integer factor to at least 1.25x the
+ *   Carson bandwidth 2 * (deviation + 15 kHz), or + 53 kHz with stereo
+ *   (the whole MPX): ~225 kHz mono, ~320 kHz stereo for broadcast FM
+ * - Everything after the decimator costs per channel sample, not per
+ *   capture sample: on a 2.4 Msps capture the discriminator runs 12x less
+ * - --demod-rate overrides the target rate; 0 demodulates at the input rate
+ * - --stereo-output at 120 kHz or more uses the pilot PLL decoder
+ *   (fm_stereo.h): the MPX goes from the discriminator to a PLL locked to
+ *   the 19 kHz pilot, then the (L+R, L-R) pairs are decimated to >= 44 kHz
+ *   before the matrix and de-emphasis. --stereo-filters selects the FIR
+ *   decoder instead; below 120 kHz the basic decoder runs
+ * - The PLL decoder keeps stereo when --realtime falls behind: it costs
+ *   little more than mono, so only the other decoders shed to mono
+ *
  * Performance:
  * - Real-time processing capability up to 8Msps input
  * - Memory efficient with streaming processing
@@ -57,11 +75,16 @@
 #include <getopt.h>
 #include <math.h>
 #include "../src/iq_core/io_iq.h"
+#include "../src/iq_core/io_async.h"
 #include "../src/iq_core/io_sigmf.h"
 #include "../src/demod/fm.h"
+#include "../src/demod/fm_stereo.h"
 #include "../src/demod/wave.h"
 #include "../src/demod/agc.h"
 #include "../src/iq_core/resample.h"
+#include "../src/iq_core/xlate.h"
+#include "../src/iq_core/profile.h"
+#include "../src/jobs/tools.h"
 
 #define DEFAULT_AUDIO_RATE 48000
 #define DEFAULT_FM_DEVIATION 75000
@@ -69,13 +92,15 @@
 #define DEFAULT_AGC_TARGET_DBFS -12.0f
 #define DEFAULT_AGC_MAX_GAIN_DB 60.0f
 #define BLOCK_SIZE 8192
+#define FM_MONO_AUDIO_HZ 15000.0f     // Top of the mono audio band
+#define FM_MPX_TOP_HZ 53000.0f        // Top of the stereo multiplex (L-R at 38 kHz +- 15 kHz)
 
 // Command line arguments structure
 typedef struct {
     const char *input_file;
     const char *meta_file;
     const char *output_file;
-    int8_t format;  // 0=s8, 1=s16
+    int8_t format;  // iq_format_t value, -1 = auto-detect
     float sample_rate;
     float audio_rate;
     float fm_deviation;
@@ -86,11 +111,15 @@ typedef struct {
     bool stereo_detection;
     float stereo_blend;
     bool stereo_output;
+    bool stereo_filters;
+    float demod_rate;       // Rate to demodulate at, < 0: from the channel bandwidth, 0: input rate
+    bool realtime;
+    const char *rt_stats;
     bool verbose;
 } args_t;
 
 // Print usage information
-void print_usage(const char *program_name) {
+static void print_usage(const char *program_name) {
     printf("IQ Lab - FM Demodulator Tool\n");
     printf("Demodulates FM signals from IQ data to WAV audio\n\n");
     printf("Usage: %s [OPTIONS] --in <iq_file> --out <wav_file>\n\n", program_name);
@@ -100,7 +129,7 @@ void print_usage(const char *program_name) {
     printf("\n");
     printf("Optional Arguments:\n");
     printf("  --meta <file>     SigMF metadata file (auto-detected if not specified)\n");
-    printf("  --format {s8|s16} IQ data format (default: auto-detect)\n");
+    printf("  --format {s8|s16|s12|s4} IQ data format (default: auto-detect)\n");
     printf("  --rate <Hz>       IQ sample rate (default: from metadata or 2000000)\n");
     printf("  --audio-rate <Hz> Output audio sample rate (default: %d)\n", DEFAULT_AUDIO_RATE);
     printf("  --deviation <Hz>  FM deviation (default: %.0f)\n", (double)DEFAULT_FM_DEVIATION);
@@ -111,6 +140,14 @@ void print_usage(const char *program_name) {
     printf("  --stereo          Enable stereo pilot detection\n");
     printf("  --stereo-blend <0-1> Stereo blend (0.0=mono, 1.0=stereo, default: 1.0)\n");
     printf("  --stereo-output   Output stereo WAV (default: mono)\n");
+    printf("  --stereo-filters  FIR pilot, subcarrier and audio filters for stereo instead of\n");
+    printf("                    the pilot PLL decoder (rate >= 120 kHz)\n");
+    printf("  --demod-rate <Hz> Decimate the IQ to at least this rate before demodulating\n");
+    printf("                    (default: 1.25x the Carson bandwidth; 0 = demodulate at the input rate)\n");
+    printf("  --profile[=<file>] Per-stage timing on stderr at exit, or as JSON to <file>\n");
+    printf("  --trace <file>     Per-thread timeline of the stages as Chrome trace JSON\n");
+    printf("  --realtime         Replay at the sample rate like a live source, reporting deadlines\n");
+    printf("  --rt-stats <file>  Real-time stats as JSON, rewritten every second (implies --realtime)\n");
     printf("  --verbose         Verbose output\n");
     printf("  --help           Show this help message\n");
     printf("\n");
@@ -121,7 +158,7 @@ void print_usage(const char *program_name) {
 }
 
 // Parse command line arguments
-bool parse_args(int argc, char *argv[], args_t *args) {
+static bool parse_args(int argc, char *argv[], args_t *args) {
     // Initialize defaults
     memset(args, 0, sizeof(args_t));
     args->format = -1;  // Auto-detect
@@ -135,6 +172,10 @@ bool parse_args(int argc, char *argv[], args_t *args) {
     args->stereo_detection = false;
     args->stereo_blend = 1.0f;
     args->stereo_output = false;
+    args->stereo_filters = false;
+    args->demod_rate = -1.0f;
+    args->realtime = false;
+    args->rt_stats = NULL;
     args->verbose = false;
 
     struct option long_options[] = {
@@ -152,13 +193,19 @@ bool parse_args(int argc, char *argv[], args_t *args) {
         {"stereo", no_argument, 0, 's'},
         {"stereo-blend", required_argument, 0, 'b'},
         {"stereo-output", no_argument, 0, 'S'},
+        {"stereo-filters", no_argument, 0, 'F'},
+        {"demod-rate", required_argument, 0, 'D'},
+        {"profile", optional_argument, 0, 'P'},
+        {"trace", required_argument, 0, 'Q'},
+        {"realtime", no_argument, 0, 'R'},
+        {"rt-stats", required_argument, 0, 'Y'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "i:m:o:f:r:a:d:e:gt:x:sb:Svh", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "i:m:o:f:r:a:d:e:gt:x:sb:SFvh", long_options, NULL)) != -1) {
         switch (opt) {
             case 'i':
                 args->input_file = optarg;
@@ -170,14 +217,12 @@ bool parse_args(int argc, char *argv[], args_t *args) {
                 args->output_file = optarg;
                 break;
             case 'f':
-                if (strcmp(optarg, "s8") == 0) {
-                    args->format = 0;
-                } else if (strcmp(optarg, "s16") == 0) {
-                    args->format = 1;
-                } else {
-                    fprintf(stderr, "Error: Invalid format '%s'. Use 's8' or 's16'\n", optarg);
+                iq_format_t format;
+                if (!iq_parse_format(optarg, &format)) {
+                    fprintf(stderr, "Error: Invalid format '%s'. Use 's8', 's16', 's12' or 's4'\n", optarg);
                     return false;
                 }
+                args->format = (int8_t)format;
                 break;
             case 'r':
                 args->sample_rate = atof(optarg);
@@ -210,6 +255,25 @@ bool parse_args(int argc, char *argv[], args_t *args) {
             case 'S':
                 args->stereo_output = true;
                 break;
+            case 'F':
+                args->stereo_filters = true;
+                break;
+            case 'D':
+                args->demod_rate = atof(optarg);
+                break;
+            case 'P':
+                iq_profile_start("iqdemod-fm", optarg);
+                break;
+            case 'Q':
+                if (!iq_trace_start("iqdemod-fm", optarg)) return false;
+                break;
+            case 'R':
+                args->realtime = true;
+                break;
+            case 'Y':
+                args->realtime = true;
+                args->rt_stats = optarg;
+                break;
             case 'v':
                 args->verbose = true;
                 break;
@@ -235,7 +299,7 @@ bool parse_args(int argc, char *argv[], args_t *args) {
 }
 
 // Load SigMF metadata and extract sample rate
-bool load_metadata(const char *meta_file, float *sample_rate) {
+static bool load_metadata(const char *meta_file, float *sample_rate) {
     sigmf_metadata_t meta;
     sigmf_init_metadata(&meta);
 
@@ -257,14 +321,57 @@ bool load_metadata(const char *meta_file, float *sample_rate) {
     return false;
 }
 
+/*
+ * Integer decimation ahead of the discriminator: the channel is the Carson
+ * bandwidth around DC, kept within the 80% of the decimated rate that the
+ * xlate filters pass (1: demodulate at the input rate)
+ */
+static uint32_t channel_decimation(const args_t *args, uint32_t sample_rate, double *bandwidth) {
+    float audio_top = args->stereo_output || args->stereo_detection ? FM_MPX_TOP_HZ : FM_MONO_AUDIO_HZ;
+    *bandwidth = 2.0 * ((double)args->fm_deviation + audio_top);
+    double target = args->demod_rate < 0.0f ? *bandwidth / 0.8 : (double)args->demod_rate;
+    if (target <= 0.0 || target >= sample_rate) return 1;
+    if (*bandwidth > 0.8 * target) *bandwidth = 0.8 * target;
+
+    // A factor that divides the rate keeps the audio rate exact for the resampler
+    uint32_t decimation = (uint32_t)floor(sample_rate / target);
+    while (decimation > 1 && sample_rate % decimation != 0) decimation--;
+    return decimation > 1 ? decimation : 1;
+}
+
+// Channel-filter and decimate one block, timed for --profile
+static size_t decimate_channel(xlate_t *xlate, const float *iq, size_t count, float *channel) {
+    uint64_t start = iq_profile_begin();
+    size_t produced = xlate_process(xlate, iq, count, channel);
+    iq_profile_end(IQ_PROFILE_FILTER, start, count, count * 2 * sizeof(float));
+    return produced;
+}
+
+// Resample one block of audio, timed for --profile
+static bool resample_audio(resample_t *resampler, const float *input, uint32_t count,
+                           float *output, uint32_t max_output, uint32_t *produced) {
+    uint64_t start = iq_profile_begin();
+    bool ok = resample_process_buffer(resampler, input, count, output, max_output, produced);
+    iq_profile_end(IQ_PROFILE_RESAMPLE, start, count, (uint64_t)count * sizeof(float));
+    return ok;
+}
+
+// Convert and write audio frames to the WAV file, timed for --profile
+static bool write_audio(wave_writer_t *writer, const float *samples, uint32_t frames) {
+    uint64_t start = iq_profile_begin();
+    bool ok = wave_writer_write_float(writer, samples, frames);
+    iq_profile_end(IQ_PROFILE_ENCODE, start, frames, (uint64_t)frames * writer->channels * sizeof(int16_t));
+    return ok;
+}
+
 // Main processing function
-int process_fm_demodulation(const args_t *args) {
-    // Load IQ data
-    iq_data_t iq_data;
-    if (args->verbose) printf("Loading IQ data from '%s'...\n", args->input_file);
+static int process_fm_demodulation(const args_t *args) {
+    // Open IQ stream (samples are read block by block below)
+    iq_reader_t reader;
+    if (args->verbose) printf("Opening IQ data from '%s'...\n", args->input_file);
 
-    if (!iq_load_file(args->input_file, &iq_data)) {
-        fprintf(stderr, "Error: Failed to load IQ data from '%s'\n", args->input_file);
+    if (!iq_reader_open(&reader, args->input_file)) {
+        fprintf(stderr, "Error: Failed to open IQ data from '%s'\n", args->input_file);
         return EXIT_FAILURE;
     }
 
@@ -278,12 +385,21 @@ int process_fm_demodulation(const args_t *args) {
         }
     }
 
-    // Override iq_data sample_rate with the determined rate
-    iq_data.sample_rate = actual_sample_rate;
+    // Override the reader sample_rate with the determined rate
+    reader.sample_rate = actual_sample_rate;
 
     if (args->verbose) {
-        printf("Loaded %zu samples (%.2f seconds at %.0f Hz)\n",
-               iq_data.num_samples, (double)iq_data.num_samples / actual_sample_rate, (double)actual_sample_rate);
+        printf("Streaming %llu samples (%.2f seconds at %.0f Hz)\n",
+               (unsigned long long)reader.total_samples, (double)reader.total_samples / actual_sample_rate, (double)actual_sample_rate);
+    }
+
+    // Demodulate the channel, not the capture: decimate first when the rate allows
+    double channel_bw = 0.0;
+    uint32_t decimation = channel_decimation(args, reader.sample_rate, &channel_bw);
+    uint32_t demod_rate = reader.sample_rate / decimation;
+    if (args->verbose && decimation > 1) {
+        printf("Channel filter: %.0f Hz wide, decimation %u -> %u Hz\n",
+               channel_bw, decimation, demod_rate);
     }
 
     // Initialize FM demodulator
@@ -298,14 +414,44 @@ int process_fm_demodulation(const args_t *args) {
         printf("  Output format: %s\n", args->stereo_output ? "stereo" : "mono");
     }
 
+    // Stereo from the MPX through the pilot PLL, unless the FIR decoder was asked for
+    bool stereo_pll = args->stereo_output && !args->stereo_filters && demod_rate >= FM_STEREO_MIN_RATE;
+
     fm_demod_t fm;
-    if (!fm_demod_init_stereo(&fm, iq_data.sample_rate, args->fm_deviation,
+    if (!fm_demod_init_stereo(&fm, demod_rate, args->fm_deviation,
                              args->deemphasis_us * 1e-6f, args->stereo_blend)) {
         fprintf(stderr, "Error: Failed to initialize FM demodulator\n");
-        iq_free(&iq_data);
+        iq_reader_close(&reader);
         return EXIT_FAILURE;
     }
 
+    if (args->stereo_filters && args->stereo_output) {
+        if (!fm_demod_set_stereo_filters(&fm, true)) {
+            fprintf(stderr, "Error: Failed to create the stereo filters (sample rate below %.0f Hz?)\n",
+                    (double)FM_STEREO_FILTER_MIN_RATE);
+            iq_reader_close(&reader);
+            return EXIT_FAILURE;
+        }
+        if (args->verbose) {
+            printf("  Stereo filters: pilot %u taps, audio %u taps, delay %u samples\n",
+                   fm.pilot_fir_i.num_taps, fm.audio_fir.num_taps, fm_demod_stereo_delay(&fm));
+        }
+    }
+
+    fm_stereo_t stereo = {0};
+    if (stereo_pll) {
+        if (!fm_stereo_init(&stereo, demod_rate, args->deemphasis_us * 1e-6f, args->stereo_blend)) {
+            fprintf(stderr, "Error: Failed to initialize the stereo decoder\n");
+            fm_demod_free(&fm);
+            iq_reader_close(&reader);
+            return EXIT_FAILURE;
+        }
+        if (args->verbose) {
+            printf("  Stereo decoder: pilot PLL, decimation %u -> %.0f Hz, delay %.0f samples\n",
+                   stereo.decimation, stereo.output_rate, fm_stereo_delay(&stereo));
+        }
+    }
+
     // Initialize AGC if requested
     agc_t agc;
     if (args->enable_agc) {
@@ -321,23 +467,39 @@ int process_fm_demodulation(const args_t *args) {
         if (!agc_init_custom(&agc, args->audio_rate, 0.01f, 0.1f,
                            reference_level, args->agc_max_gain_db, 0.5f)) {
             fprintf(stderr, "Error: Failed to initialize AGC\n");
-            iq_free(&iq_data);
+            fm_stereo_free(&stereo);
+            fm_demod_free(&fm);
+            iq_reader_close(&reader);
             return EXIT_FAILURE;
         }
+
+        // Envelope and gain once per sub-block, gain ramped in between
+        agc_set_block_size(&agc, AGC_DEFAULT_BLOCK_SIZE);
     }
 
     // Initialize resampler if needed
-    resample_t resampler;
-    bool needs_resampling = fabsf((float)iq_data.sample_rate - args->audio_rate) > 1.0f;
+    resample_t resampler = {0};
+    resample_t right_resampler = {0};  // Stereo: the filters keep state, one per channel
+    uint32_t decoded_rate = stereo_pll ? (uint32_t)stereo.output_rate : demod_rate;
+    bool needs_resampling = fabsf((float)decoded_rate - args->audio_rate) > 1.0f;
+    // Audio per block: a narrow channel is resampled up to the audio rate, not down
+    uint32_t resample_capacity = resample_estimate_output_size(
+        BLOCK_SIZE, resample_get_ratio(decoded_rate, (uint32_t)args->audio_rate)) + 16;
     if (needs_resampling) {
         if (args->verbose) {
             printf("Initializing resampler: %.0f Hz -> %.0f Hz\n",
-                   (double)iq_data.sample_rate, (double)args->audio_rate);
+                   (double)decoded_rate, (double)args->audio_rate);
         }
 
-        if (!resample_init(&resampler, iq_data.sample_rate, args->audio_rate)) {
+        if (!resample_init(&resampler, decoded_rate, args->audio_rate) ||
+            (args->stereo_output &&
+             !resample_init(&right_resampler, decoded_rate, args->audio_rate))) {
             fprintf(stderr, "Error: Failed to initialize resampler\n");
-            iq_free(&iq_data);
+            resample_free(&resampler);
+            resample_free(&right_resampler);
+            fm_stereo_free(&stereo);
+            fm_demod_free(&fm);
+            iq_reader_close(&reader);
             if (args->enable_agc) agc_reset(&agc);
             return EXIT_FAILURE;
         }
@@ -348,43 +510,91 @@ int process_fm_demodulation(const args_t *args) {
 
     wave_writer_t wav_writer;
     int channels = args->stereo_output ? 2 : 1;
-    if (!wave_writer_init(&wav_writer, args->output_file, args->audio_rate, channels)) {
+    if (!wave_writer_init_custom(&wav_writer, args->output_file, args->audio_rate, channels, NULL)) {
         fprintf(stderr, "Error: Failed to initialize WAV writer\n");
-        iq_free(&iq_data);
-        if (needs_resampling) resample_free(&resampler);
+        fm_stereo_free(&stereo);
+        fm_demod_free(&fm);
+        iq_reader_close(&reader);
+        if (needs_resampling) {
+            resample_free(&resampler);
+            resample_free(&right_resampler);
+        }
         return EXIT_FAILURE;
     }
 
     // Allocate audio buffers
     size_t audio_buffer_size = BLOCK_SIZE * (args->stereo_output ? 2 : 1) * sizeof(float);
     float *audio_buffer = malloc(audio_buffer_size);
-    if (!audio_buffer) {
+    float *mpx_buffer = stereo_pll ? malloc(BLOCK_SIZE * sizeof(float)) : NULL;
+
+    // Decimated channel samples feeding the demodulator
+    xlate_t channel = {0};
+    float *channel_buffer = NULL;
+    bool channel_ok = true;
+    if (decimation > 1) {
+        channel_buffer = malloc((BLOCK_SIZE / decimation + 1) * 2 * sizeof(float));
+        channel_ok = channel_buffer && xlate_init(&channel, reader.sample_rate, 0.0, decimation, channel_bw);
+    }
+
+    // File reads and sample conversion run ahead on a background thread;
+    // --realtime paces them like a live source and watches the deadlines
+    rt_monitor_t *monitor = args->realtime ?
+        rt_monitor_create("iqdemod-fm", reader.sample_rate, 0.0, args->rt_stats) : NULL;
+    iq_async_t *async = iq_async_create_realtime(&reader, BLOCK_SIZE, IQ_ASYNC_NUM_BLOCKS,
+                                                 monitor ? reader.sample_rate : 0.0, monitor);
+    if (!audio_buffer || (stereo_pll && !mpx_buffer) || !channel_ok || !async ||
+        (args->realtime && !monitor)) {
         fprintf(stderr, "Error: Failed to allocate audio buffer\n");
+        free(audio_buffer);
+        free(mpx_buffer);
+        free(channel_buffer);
+        xlate_free(&channel);
+        iq_async_destroy(async);
+        rt_monitor_destroy(monitor);
         wave_writer_close(&wav_writer);
-        iq_free(&iq_data);
-        if (needs_resampling) resample_free(&resampler);
+        fm_stereo_free(&stereo);
+        fm_demod_free(&fm);
+        iq_reader_close(&reader);
+        if (needs_resampling) {
+            resample_free(&resampler);
+            resample_free(&right_resampler);
+        }
         return EXIT_FAILURE;
     }
 
     size_t total_samples_processed = 0;
     size_t total_audio_samples = 0;
 
-    for (size_t offset = 0; offset < iq_data.num_samples; offset += BLOCK_SIZE) {
-        size_t block_size = (offset + BLOCK_SIZE > iq_data.num_samples) ?
-                           iq_data.num_samples - offset : BLOCK_SIZE;
+    const iq_async_block_t *block;
+    while ((block = iq_async_acquire(async)) != NULL) {
+        const float *iq_buffer = block->samples;
+        size_t block_size = block->num_samples;
+        if (decimation > 1) {
+            block_size = decimate_channel(&channel, iq_buffer, block_size, channel_buffer);
+            iq_buffer = channel_buffer;
+        }
 
         if (args->stereo_output) {
             // Stereo output processing
             float *left_buffer = audio_buffer;
             float *right_buffer = audio_buffer + BLOCK_SIZE;
 
-            // Demodulate stereo
-            for (size_t i = 0; i < block_size; i++) {
-                size_t idx = (offset + i) * 2;  // Interleaved: I,Q,I,Q,...
-                float i_sample = iq_data.data[idx];
-                float q_sample = iq_data.data[idx + 1];
-                fm_demod_process_stereo(&fm, i_sample, q_sample,
-                                       &left_buffer[i], &right_buffer[i]);
+            // Demodulate stereo; behind a live source, mono in both channels
+            // until the read-ahead ring drains, rather than dropping samples
+            // (not for the PLL decoder, which costs little more than mono)
+            uint64_t demod_start = iq_profile_begin();
+            size_t demod_samples = block_size;
+            if (block_size > 0 && stereo_pll) {
+                fm_demod_process_mpx(&fm, iq_buffer, (uint32_t)block_size, mpx_buffer);
+                block_size = fm_stereo_process(&stereo, mpx_buffer, (uint32_t)block_size,
+                                               left_buffer, right_buffer);
+            } else if (block_size > 0 && rt_monitor_behind(monitor)) {
+                fm_demod_process_buffer_iq(&fm, iq_buffer, (uint32_t)block_size, left_buffer);
+                memcpy(right_buffer, left_buffer, block_size * sizeof(float));
+                rt_monitor_degraded(monitor);
+            } else if (block_size > 0) {
+                fm_demod_process_stereo_buffer_iq(&fm, iq_buffer, (uint32_t)block_size,
+                                                  left_buffer, right_buffer);
             }
 
             // Apply AGC if enabled (to both channels)
@@ -392,40 +602,34 @@ int process_fm_demodulation(const args_t *args) {
                 agc_process_buffer(&agc, left_buffer, block_size);
                 agc_process_buffer(&agc, right_buffer, block_size);
             }
+            iq_profile_end(IQ_PROFILE_DEMOD, demod_start, demod_samples, demod_samples * 2 * sizeof(float));
 
             // Resample if needed
             if (needs_resampling) {
                 // Resample left channel
                 uint32_t left_output_samples = 0;
-                float *left_resampled = malloc(block_size * 2 * sizeof(float));
-                if (left_resampled && resample_process_buffer(&resampler, left_buffer, block_size,
-                                                            left_resampled, block_size * 2, &left_output_samples)) {
+                float *left_resampled = malloc(resample_capacity * sizeof(float));
+                if (left_resampled && resample_audio(&resampler, left_buffer, block_size,
+                                                   left_resampled, resample_capacity, &left_output_samples)) {
                     // Resample right channel
                     uint32_t right_output_samples = 0;
-                    float *right_resampled = malloc(block_size * 2 * sizeof(float));
-                    if (right_resampled && resample_process_buffer(&resampler, right_buffer, block_size,
-                                                                 right_resampled, block_size * 2, &right_output_samples)) {
+                    float *right_resampled = malloc(resample_capacity * sizeof(float));
+                    if (right_resampled && resample_audio(&right_resampler, right_buffer, block_size,
+                                                        right_resampled, resample_capacity, &right_output_samples)) {
                         // Ensure both channels have same sample count
                         uint32_t output_samples = (left_output_samples < right_output_samples) ?
                                                  left_output_samples : right_output_samples;
 
-                        // Convert to int16 interleaved format for WAV
-                        int16_t *wav_samples = malloc(output_samples * 2 * sizeof(int16_t));
+                        // Interleave for WAV (int16 conversion in the writer)
+                        float *wav_samples = malloc(output_samples * 2 * sizeof(float));
                         if (wav_samples) {
                             for (uint32_t j = 0; j < output_samples; j++) {
-                                // Left channel
-                                float sample = left_resampled[j];
-                                if (sample > 1.0f) sample = 1.0f;
-                                if (sample < -1.0f) sample = -1.0f;
-                                wav_samples[j * 2] = (int16_t)(sample * 32767.0f);
-
-                                // Right channel
-                                sample = right_resampled[j];
-                                if (sample > 1.0f) sample = 1.0f;
-                                if (sample < -1.0f) sample = -1.0f;
-                                wav_samples[j * 2 + 1] = (int16_t)(sample * 32767.0f);
+                                wav_samples[j * 2] = left_resampled[j];
+                                wav_samples[j * 2 + 1] = right_resampled[j];
+                            }
+                            if (output_samples > 0) {
+                                write_audio(&wav_writer, wav_samples, output_samples);
                             }
-                            wave_writer_write_samples(&wav_writer, wav_samples, output_samples);
                             total_audio_samples += output_samples;
                             free(wav_samples);
                         }
@@ -434,96 +638,83 @@ int process_fm_demodulation(const args_t *args) {
                 }
                 if (left_resampled) free(left_resampled);
             } else {
-                // Convert to int16 interleaved format for WAV
-                int16_t *wav_samples = malloc(block_size * 2 * sizeof(int16_t));
+                // Interleave for WAV (int16 conversion in the writer)
+                float *wav_samples = malloc(block_size * 2 * sizeof(float));
                 if (wav_samples) {
                     for (size_t i = 0; i < block_size; i++) {
-                        // Left channel
-                        float sample = left_buffer[i];
-                        if (sample > 1.0f) sample = 1.0f;
-                        if (sample < -1.0f) sample = -1.0f;
-                        wav_samples[i * 2] = (int16_t)(sample * 32767.0f);
-
-                        // Right channel
-                        sample = right_buffer[i];
-                        if (sample > 1.0f) sample = 1.0f;
-                        if (sample < -1.0f) sample = -1.0f;
-                        wav_samples[i * 2 + 1] = (int16_t)(sample * 32767.0f);
+                        wav_samples[i * 2] = left_buffer[i];
+                        wav_samples[i * 2 + 1] = right_buffer[i];
+                    }
+                    if (block_size > 0) {
+                        write_audio(&wav_writer, wav_samples, (uint32_t)block_size);
                     }
-                    wave_writer_write_samples(&wav_writer, wav_samples, block_size);
                     total_audio_samples += block_size;
                     free(wav_samples);
                 }
             }
         } else {
             // Mono output processing
-            // Demodulate this block
-            for (size_t i = 0; i < block_size; i++) {
-                size_t idx = (offset + i) * 2;  // Interleaved: I,Q,I,Q,...
-                float i_sample = iq_data.data[idx];
-                float q_sample = iq_data.data[idx + 1];
-                audio_buffer[i] = fm_demod_process_sample(&fm, i_sample, q_sample);
+            // Demodulate this block straight from the interleaved samples
+            uint64_t demod_start = iq_profile_begin();
+            if (block_size > 0) {
+                fm_demod_process_buffer_iq(&fm, iq_buffer, (uint32_t)block_size, audio_buffer);
             }
 
             // Apply AGC if enabled
             if (args->enable_agc) {
                 agc_process_buffer(&agc, audio_buffer, block_size);
             }
+            iq_profile_end(IQ_PROFILE_DEMOD, demod_start, block_size, block_size * 2 * sizeof(float));
 
             // Resample if needed
             if (needs_resampling) {
                 // Resample the block
                 uint32_t output_samples = 0;
-                float *resampled = malloc(block_size * 2 * sizeof(float));
+                float *resampled = malloc(resample_capacity * sizeof(float));
                 if (resampled) {
-                    if (resample_process_buffer(&resampler, audio_buffer, block_size,
-                                              resampled, block_size * 2, &output_samples)) {
-                        // Convert float to int16 for WAV output
-                        int16_t *wav_samples = malloc(output_samples * sizeof(int16_t));
-                        if (wav_samples) {
-                            for (uint32_t j = 0; j < output_samples; j++) {
-                                // Clamp to [-1, 1] and convert to int16
-                                float sample = resampled[j];
-                                if (sample > 1.0f) sample = 1.0f;
-                                if (sample < -1.0f) sample = -1.0f;
-                                wav_samples[j] = (int16_t)(sample * 32767.0f);
-                            }
-                            wave_writer_write_samples(&wav_writer, wav_samples, output_samples);
-                            total_audio_samples += output_samples;
-                            free(wav_samples);
+                    if (resample_audio(&resampler, audio_buffer, block_size,
+                                     resampled, resample_capacity, &output_samples)) {
+                        // Clamped and converted to int16 by the WAV writer
+                        if (output_samples > 0) {
+                            write_audio(&wav_writer, resampled, output_samples);
                         }
+                        total_audio_samples += output_samples;
                     }
                     free(resampled);
                 }
             } else {
-                // Convert float to int16 for WAV output
-                int16_t *wav_samples = malloc(block_size * sizeof(int16_t));
-                if (wav_samples) {
-                    for (size_t i = 0; i < block_size; i++) {
-                        // Clamp to [-1, 1] and convert to int16
-                        float sample = audio_buffer[i];
-                        if (sample > 1.0f) sample = 1.0f;
-                        if (sample < -1.0f) sample = -1.0f;
-                        wav_samples[i] = (int16_t)(sample * 32767.0f);
-                    }
-                    wave_writer_write_samples(&wav_writer, wav_samples, block_size);
-                    total_audio_samples += block_size;
-                    free(wav_samples);
+                // Clamped and converted to int16 by the WAV writer
+                if (block_size > 0) {
+                    write_audio(&wav_writer, audio_buffer, (uint32_t)block_size);
                 }
+                total_audio_samples += block_size;
             }
         }
 
-        total_samples_processed += block_size;
+        total_samples_processed += block->num_samples;
 
         if (args->verbose && total_samples_processed % (BLOCK_SIZE * 10) == 0) {
-            printf("Processed %zu/%zu samples (%.1f%%)\n",
-                   total_samples_processed, iq_data.num_samples,
-                   100.0f * total_samples_processed / iq_data.num_samples);
+            if (reader.total_samples == 0) {
+                printf("Processed %zu samples\n", total_samples_processed);  // Live input
+            } else {
+                printf("Processed %zu/%llu samples (%.1f%%)\n",
+                       total_samples_processed, (unsigned long long)reader.total_samples,
+                       100.0f * total_samples_processed / reader.total_samples);
+            }
         }
+
+        iq_async_release(async, block);
+        rt_monitor_poll(monitor);
     }
 
     // Check for stereo
-    if (args->stereo_detection) {
+    if (stereo_pll) {
+        if (args->verbose) {
+            printf("Stereo decoder: %s (pilot level: %.6f at %.2f Hz)\n",
+                   fm_stereo_locked(&stereo) ? "pilot locked" : "no pilot lock",
+                   stereo.pilot_level, fm_stereo_pilot_frequency(&stereo));
+        }
+    } else if (args->stereo_detection) {
         float pilot_level = fm_demod_get_pilot_level(&fm);
         bool is_stereo = fm_demod_is_stereo(&fm);
         if (args->verbose) {
@@ -534,10 +725,20 @@ int process_fm_demodulation(const args_t *args) {
     }
 
     // Clean up
+    iq_async_destroy(async);
+    rt_monitor_destroy(monitor);
     free(audio_buffer);
+    free(mpx_buffer);
+    free(channel_buffer);
+    xlate_free(&channel);
     wave_writer_close(&wav_writer);
-    iq_free(&iq_data);
-    if (needs_resampling) resample_free(&resampler);
+    fm_stereo_free(&stereo);
+    fm_demod_free(&fm);
+    iq_reader_close(&reader);
+    if (needs_resampling) {
+        resample_free(&resampler);
+        resample_free(&right_resampler);
+    }
 
     if (args->verbose) {
         printf("FM demodulation completed successfully\n");
@@ -549,7 +750,8 @@ int process_fm_demodulation(const args_t *args) {
     return EXIT_SUCCESS;
 }
 
-int main(int argc, char *argv[]) {
+// Tool entry point (also called in process by iqjob, see src/jobs/tools.h)
+int iqdemod_fm_main(int argc, char *argv[]) {
     args_t args;
 
     if (!parse_args(argc, argv, &args)) {
@@ -565,3 +767,9 @@ int main(int argc, char *argv[]) {
 
     return process_fm_demodulation(&args);
 }
+
+#ifndef IQ_TOOL_LIBRARY
+int main(int argc, char *argv[]) {
+    return iqdemod_fm_main(argc, argv);
+}
+#endif
@@ -15,7 +15,7 @@
  * - Complex quadrature mixing with phase-continuous oscillators
  * - Automatic gain control with attack/release parameters
  * - High-quality audio resampling and filtering
- * - Support for s8/s16 IQ data formats
+ * - Support for s8/s16 and packed s12/s4 IQ data formats
  *
  * Usage Examples:
  *   # Basic SSB demodulation (USB mode)
@@ -65,11 +65,14 @@
 #include <getopt.h>
 #include <math.h>
 #include "../src/iq_core/io_iq.h"
+#include "../src/iq_core/io_async.h"
 #include "../src/iq_core/io_sigmf.h"
 #include "../src/demod/ssb.h"
 #include "../src/demod/wave.h"
 #include "../src/demod/agc.h"
 #include "../src/iq_core/resample.h"
+#include "../src/iq_core/profile.h"
+#include "../src/jobs/tools.h"
 
 #define DEFAULT_AUDIO_RATE 48000
 #define DEFAULT_BFO_FREQUENCY 1500.0f
@@ -83,20 +86,23 @@ typedef struct {
     const char *input_file;
     const char *meta_file;
     const char *output_file;
-    int8_t format;  // 0=s8, 1=s16
+    int8_t format;  // iq_format_t value, -1 = auto-detect
     float sample_rate;
     float audio_rate;
     const char *mode_str;  // "usb" or "lsb"
     float bfo_frequency;
     float lpf_cutoff;
+    float fir_transition;  // > 0: FIR sideband filter with this transition width (Hz)
     bool enable_agc;
     float agc_target_dbfs;
     float agc_max_gain_db;
+    bool realtime;
+    const char *rt_stats;
     bool verbose;
 } args_t;
 
 // Print usage information
-void print_usage(const char *program_name) {
+static void print_usage(const char *program_name) {
     printf("IQ Lab - SSB Demodulator Tool\n");
     printf("Demodulates SSB signals from IQ data to WAV audio\n\n");
     printf("Usage: %s [OPTIONS] --in <iq_file> --out <wav_file>\n\n", program_name);
@@ -106,15 +112,21 @@ void print_usage(const char *program_name) {
     printf("\n");
     printf("Optional Arguments:\n");
     printf("  --meta <file>     SigMF metadata file (auto-detected if not specified)\n");
-    printf("  --format {s8|s16} IQ data format (default: auto-detect)\n");
+    printf("  --format {s8|s16|s12|s4} IQ data format (default: auto-detect)\n");
     printf("  --rate <Hz>       IQ sample rate (default: from metadata or 2000000)\n");
     printf("  --audio-rate <Hz> Output audio sample rate (default: %d)\n", DEFAULT_AUDIO_RATE);
     printf("  --mode {usb|lsb}  SSB mode (default: usb)\n");
     printf("  --bfo <Hz>        Beat Frequency Oscillator frequency (default: %.0f)\n", DEFAULT_BFO_FREQUENCY);
     printf("  --lpf-cutoff <Hz> Low-pass filter cutoff (default: %.0f)\n", DEFAULT_LPF_CUTOFF);
+    printf("  --fir-transition <Hz> Sharp FIR sideband filter, 60 dB down this far past the cutoff\n");
+    printf("                    (default: single-pole IIR)\n");
     printf("  --agc             Enable automatic gain control\n");
     printf("  --agc-target <dB> AGC target level (default: %.1f dBFS)\n", DEFAULT_AGC_TARGET_DBFS);
     printf("  --agc-max <dB>    AGC maximum gain (default: %.0f dB)\n", DEFAULT_AGC_MAX_GAIN_DB);
+    printf("  --profile[=<file>] Per-stage timing on stderr at exit, or as JSON to <file>\n");
+    printf("  --trace <file>     Per-thread timeline of the stages as Chrome trace JSON\n");
+    printf("  --realtime         Replay at the sample rate like a live source, reporting deadlines\n");
+    printf("  --rt-stats <file>  Real-time stats as JSON, rewritten every second (implies --realtime)\n");
     printf("  --verbose         Verbose output\n");
     printf("  --help           Show this help message\n");
     printf("\n");
@@ -125,7 +137,7 @@ void print_usage(const char *program_name) {
 }
 
 // Parse SSB mode string
-bool parse_ssb_mode(const char *mode_str, ssb_mode_t *mode) {
+static bool parse_ssb_mode(const char *mode_str, ssb_mode_t *mode) {
     if (strcmp(mode_str, "usb") == 0 || strcmp(mode_str, "USB") == 0) {
         *mode = SSB_MODE_USB;
         return true;
@@ -137,7 +149,7 @@ bool parse_ssb_mode(const char *mode_str, ssb_mode_t *mode) {
 }
 
 // Parse command line arguments
-bool parse_args(int argc, char *argv[], args_t *args) {
+static bool parse_args(int argc, char *argv[], args_t *args) {
     // Initialize defaults
     memset(args, 0, sizeof(args_t));
     args->format = -1;  // Auto-detect
@@ -146,9 +158,12 @@ bool parse_args(int argc, char *argv[], args_t *args) {
     args->mode_str = "usb";  // Default to USB
     args->bfo_frequency = DEFAULT_BFO_FREQUENCY;
     args->lpf_cutoff = DEFAULT_LPF_CUTOFF;
+    args->fir_transition = 0.0f;
     args->enable_agc = false;
     args->agc_target_dbfs = DEFAULT_AGC_TARGET_DBFS;
     args->agc_max_gain_db = DEFAULT_AGC_MAX_GAIN_DB;
+    args->realtime = false;
+    args->rt_stats = NULL;
     args->verbose = false;
 
     struct option long_options[] = {
@@ -161,16 +176,21 @@ bool parse_args(int argc, char *argv[], args_t *args) {
         {"mode", required_argument, 0, 'M'},
         {"bfo", required_argument, 0, 'b'},
         {"lpf-cutoff", required_argument, 0, 'l'},
+        {"fir-transition", required_argument, 0, 'T'},
         {"agc", no_argument, 0, 'g'},
         {"agc-target", required_argument, 0, 't'},
         {"agc-max", required_argument, 0, 'x'},
+        {"profile", optional_argument, 0, 'P'},
+        {"trace", required_argument, 0, 'Q'},
+        {"realtime", no_argument, 0, 'R'},
+        {"rt-stats", required_argument, 0, 'Y'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "i:m:o:f:r:a:M:b:l:gt:x:vh", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "i:m:o:f:r:a:M:b:l:T:gt:x:vh", long_options, NULL)) != -1) {
         switch (opt) {
             case 'i':
                 args->input_file = optarg;
@@ -182,14 +202,12 @@ bool parse_args(int argc, char *argv[], args_t *args) {
                 args->output_file = optarg;
                 break;
             case 'f':
-                if (strcmp(optarg, "s8") == 0) {
-                    args->format = 0;
-                } else if (strcmp(optarg, "s16") == 0) {
-                    args->format = 1;
-                } else {
-                    fprintf(stderr, "Error: Invalid format '%s'. Use 's8' or 's16'\n", optarg);
+                iq_format_t format;
+                if (!iq_parse_format(optarg, &format)) {
+                    fprintf(stderr, "Error: Invalid format '%s'. Use 's8', 's16', 's12' or 's4'\n", optarg);
                     return false;
                 }
+                args->format = (int8_t)format;
                 break;
             case 'r':
                 args->sample_rate = atof(optarg);
@@ -206,6 +224,9 @@ bool parse_args(int argc, char *argv[], args_t *args) {
             case 'l':
                 args->lpf_cutoff = atof(optarg);
                 break;
+            case 'T':
+                args->fir_transition = atof(optarg);
+                break;
             case 'g':
                 args->enable_agc = true;
                 break;
@@ -215,6 +236,19 @@ bool parse_args(int argc, char *argv[], args_t *args) {
             case 'x':
                 args->agc_max_gain_db = atof(optarg);
                 break;
+            case 'P':
+                iq_profile_start("iqdemod-ssb", optarg);
+                break;
+            case 'Q':
+                if (!iq_trace_start("iqdemod-ssb", optarg)) return false;
+                break;
+            case 'R':
+                args->realtime = true;
+                break;
+            case 'Y':
+                args->realtime = true;
+                args->rt_stats = optarg;
+                break;
             case 'v':
                 args->verbose = true;
                 break;
@@ -240,7 +274,7 @@ bool parse_args(int argc, char *argv[], args_t *args) {
 }
 
 // Load SigMF metadata and extract sample rate
-bool load_metadata(const char *meta_file, float *sample_rate) {
+static bool load_metadata(const char *meta_file, float *sample_rate) {
     sigmf_metadata_t meta;
     sigmf_init_metadata(&meta);
 
@@ -262,14 +296,31 @@ bool load_metadata(const char *meta_file, float *sample_rate) {
     return false;
 }
 
+// Resample one block of audio, timed for --profile
+static bool resample_audio(resample_t *resampler, const float *input, uint32_t count,
+                           float *output, uint32_t max_output, uint32_t *produced) {
+    uint64_t start = iq_profile_begin();
+    bool ok = resample_process_buffer(resampler, input, count, output, max_output, produced);
+    iq_profile_end(IQ_PROFILE_RESAMPLE, start, count, (uint64_t)count * sizeof(float));
+    return ok;
+}
+
+// Convert and write audio frames to the WAV file, timed for --profile
+static bool write_audio(wave_writer_t *writer, const float *samples, uint32_t frames) {
+    uint64_t start = iq_profile_begin();
+    bool ok = wave_writer_write_float(writer, samples, frames);
+    iq_profile_end(IQ_PROFILE_ENCODE, start, frames, (uint64_t)frames * writer->channels * sizeof(int16_t));
+    return ok;
+}
+
 // Main processing function
-int process_ssb_demodulation(const args_t *args) {
-    // Load IQ data
-    iq_data_t iq_data;
-    if (args->verbose) printf("Loading IQ data from '%s'...\n", args->input_file);
+static int process_ssb_demodulation(const args_t *args) {
+    // Open IQ stream (samples are read block by block below)
+    iq_reader_t reader;
+    if (args->verbose) printf("Opening IQ data from '%s'...\n", args->input_file);
 
-    if (!iq_load_file(args->input_file, &iq_data)) {
-        fprintf(stderr, "Error: Failed to load IQ data from '%s'\n", args->input_file);
+    if (!iq_reader_open(&reader, args->input_file)) {
+        fprintf(stderr, "Error: Failed to open IQ data from '%s'\n", args->input_file);
         return EXIT_FAILURE;
     }
 
@@ -283,19 +334,19 @@ int process_ssb_demodulation(const args_t *args) {
         }
     }
 
-    // Override iq_data sample_rate with the determined rate
-    iq_data.sample_rate = actual_sample_rate;
+    // Override the reader sample_rate with the determined rate
+    reader.sample_rate = actual_sample_rate;
 
     if (args->verbose) {
-        printf("Loaded %zu samples (%.2f seconds at %.0f Hz)\n",
-               iq_data.num_samples, (double)iq_data.num_samples / actual_sample_rate, (double)actual_sample_rate);
+        printf("Streaming %llu samples (%.2f seconds at %.0f Hz)\n",
+               (unsigned long long)reader.total_samples, (double)reader.total_samples / actual_sample_rate, (double)actual_sample_rate);
     }
 
     // Parse SSB mode
     ssb_mode_t ssb_mode;
     if (!parse_ssb_mode(args->mode_str, &ssb_mode)) {
         fprintf(stderr, "Error: Invalid SSB mode '%s'. Use 'usb' or 'lsb'\n", args->mode_str);
-        iq_free(&iq_data);
+        iq_reader_close(&reader);
         return EXIT_FAILURE;
     }
 
@@ -308,13 +359,25 @@ int process_ssb_demodulation(const args_t *args) {
     }
 
     ssb_demod_t ssb;
-    if (!ssb_demod_init_custom(&ssb, iq_data.sample_rate, ssb_mode,
+    if (!ssb_demod_init_custom(&ssb, reader.sample_rate, ssb_mode,
                               args->bfo_frequency, args->lpf_cutoff)) {
         fprintf(stderr, "Error: Failed to initialize SSB demodulator\n");
-        iq_free(&iq_data);
+        iq_reader_close(&reader);
         return EXIT_FAILURE;
     }
 
+    if (args->fir_transition > 0.0f) {
+        if (!ssb_demod_set_sideband_filter(&ssb, args->fir_transition)) {
+            fprintf(stderr, "Error: Failed to create the FIR sideband filter\n");
+            iq_reader_close(&reader);
+            return EXIT_FAILURE;
+        }
+        if (args->verbose) {
+            printf("  FIR sideband filter: %u taps (%s)\n", ssb.fir.num_taps,
+                   ssb.fir.method == FIR_METHOD_FFT ? "overlap-save" : "direct");
+        }
+    }
+
     // Initialize AGC if requested
     agc_t agc;
     if (args->enable_agc) {
@@ -330,23 +393,28 @@ int process_ssb_demodulation(const args_t *args) {
         if (!agc_init_custom(&agc, args->audio_rate, 0.01f, 0.1f,
                            reference_level, args->agc_max_gain_db, 0.5f)) {
             fprintf(stderr, "Error: Failed to initialize AGC\n");
-            iq_free(&iq_data);
+            ssb_demod_free(&ssb);
+    iq_reader_close(&reader);
             return EXIT_FAILURE;
         }
+
+        // Envelope and gain once per sub-block, gain ramped in between
+        agc_set_block_size(&agc, AGC_DEFAULT_BLOCK_SIZE);
     }
 
     // Initialize resampler if needed
     resample_t resampler;
-    bool needs_resampling = fabsf((float)iq_data.sample_rate - args->audio_rate) > 1.0f;
+    bool needs_resampling = fabsf((float)reader.sample_rate - args->audio_rate) > 1.0f;
     if (needs_resampling) {
         if (args->verbose) {
             printf("Initializing resampler: %.0f Hz -> %.0f Hz\n",
-                   (double)iq_data.sample_rate, (double)args->audio_rate);
+                   (double)reader.sample_rate, (double)args->audio_rate);
         }
 
-        if (!resample_init(&resampler, iq_data.sample_rate, args->audio_rate)) {
+        if (!resample_init(&resampler, reader.sample_rate, args->audio_rate)) {
             fprintf(stderr, "Error: Failed to initialize resampler\n");
-            iq_free(&iq_data);
+            ssb_demod_free(&ssb);
+    iq_reader_close(&reader);
             return EXIT_FAILURE;
         }
     }
@@ -355,19 +423,31 @@ int process_ssb_demodulation(const args_t *args) {
     if (args->verbose) printf("Initializing WAV writer...\n");
 
     wave_writer_t wav_writer;
-    if (!wave_writer_init(&wav_writer, args->output_file, args->audio_rate, 1)) {  // Mono
+    if (!wave_writer_init_custom(&wav_writer, args->output_file, args->audio_rate, 1, NULL)) {  // Mono
         fprintf(stderr, "Error: Failed to initialize WAV writer\n");
-        iq_free(&iq_data);
+        ssb_demod_free(&ssb);
+    iq_reader_close(&reader);
         if (needs_resampling) resample_free(&resampler);
         return EXIT_FAILURE;
     }
 
     // Process IQ data in blocks
     float *audio_buffer = malloc(BLOCK_SIZE * sizeof(float));
-    if (!audio_buffer) {
+
+    // File reads and sample conversion run ahead on a background thread;
+    // --realtime paces them like a live source and watches the deadlines
+    rt_monitor_t *monitor = args->realtime ?
+        rt_monitor_create("iqdemod-ssb", reader.sample_rate, 0.0, args->rt_stats) : NULL;
+    iq_async_t *async = iq_async_create_realtime(&reader, BLOCK_SIZE, IQ_ASYNC_NUM_BLOCKS,
+                                                 monitor ? reader.sample_rate : 0.0, monitor);
+    if (!audio_buffer || !async || (args->realtime && !monitor)) {
         fprintf(stderr, "Error: Failed to allocate audio buffer\n");
+        free(audio_buffer);
+        iq_async_destroy(async);
+        rt_monitor_destroy(monitor);
         wave_writer_close(&wav_writer);
-        iq_free(&iq_data);
+        ssb_demod_free(&ssb);
+    iq_reader_close(&reader);
         if (needs_resampling) resample_free(&resampler);
         return EXIT_FAILURE;
     }
@@ -375,22 +455,22 @@ int process_ssb_demodulation(const args_t *args) {
     size_t total_samples_processed = 0;
     size_t total_audio_samples = 0;
 
-    for (size_t offset = 0; offset < iq_data.num_samples; offset += BLOCK_SIZE) {
-        size_t block_size = (offset + BLOCK_SIZE > iq_data.num_samples) ?
-                           iq_data.num_samples - offset : BLOCK_SIZE;
+    const iq_async_block_t *block;
+    while ((block = iq_async_acquire(async)) != NULL) {
+        const float *iq_buffer = block->samples;
+        size_t block_size = block->num_samples;
 
-        // Demodulate this block
-        for (size_t i = 0; i < block_size; i++) {
-            size_t idx = (offset + i) * 2;  // Interleaved: I,Q,I,Q,...
-            float i_sample = iq_data.data[idx];
-            float q_sample = iq_data.data[idx + 1];
-            audio_buffer[i] = ssb_demod_process_sample(&ssb, i_sample, q_sample);
+        // Demodulate this block straight from the interleaved samples
+        uint64_t demod_start = iq_profile_begin();
+        if (block_size > 0) {
+            ssb_demod_process_buffer_iq(&ssb, iq_buffer, (uint32_t)block_size, audio_buffer);
         }
 
         // Apply AGC if enabled
         if (args->enable_agc) {
             agc_process_buffer(&agc, audio_buffer, block_size);
         }
+        iq_profile_end(IQ_PROFILE_DEMOD, demod_start, block_size, block_size * 2 * sizeof(float));
 
         // Resample if needed
         if (needs_resampling) {
@@ -398,55 +478,47 @@ int process_ssb_demodulation(const args_t *args) {
             uint32_t output_samples = 0;
             float *resampled = malloc(block_size * 2 * sizeof(float));  // Allocate enough space
             if (resampled) {
-                if (resample_process_buffer(&resampler, audio_buffer, block_size,
-                                          resampled, block_size * 2, &output_samples)) {
-                    // Convert float to int16 for WAV output
-                    int16_t *wav_samples = malloc(output_samples * sizeof(int16_t));
-                    if (wav_samples) {
-                        for (uint32_t j = 0; j < output_samples; j++) {
-                            // Clamp to [-1, 1] and convert to int16
-                            float sample = resampled[j];
-                            if (sample > 1.0f) sample = 1.0f;
-                            if (sample < -1.0f) sample = -1.0f;
-                            wav_samples[j] = (int16_t)(sample * 32767.0f);
-                        }
-                        wave_writer_write_samples(&wav_writer, wav_samples, output_samples);
-                        total_audio_samples += output_samples;
-                        free(wav_samples);
+                if (resample_audio(&resampler, audio_buffer, block_size,
+                                 resampled, block_size * 2, &output_samples)) {
+                    // Clamped and converted to int16 by the WAV writer
+                    if (output_samples > 0) {
+                        write_audio(&wav_writer, resampled, output_samples);
                     }
+                    total_audio_samples += output_samples;
                 }
                 free(resampled);
             }
         } else {
-            // Convert float to int16 for WAV output
-            int16_t *wav_samples = malloc(block_size * sizeof(int16_t));
-            if (wav_samples) {
-                for (size_t i = 0; i < block_size; i++) {
-                    // Clamp to [-1, 1] and convert to int16
-                    float sample = audio_buffer[i];
-                    if (sample > 1.0f) sample = 1.0f;
-                    if (sample < -1.0f) sample = -1.0f;
-                    wav_samples[i] = (int16_t)(sample * 32767.0f);
-                }
-                wave_writer_write_samples(&wav_writer, wav_samples, block_size);
-                total_audio_samples += block_size;
-                free(wav_samples);
+            // Clamped and converted to int16 by the WAV writer
+            if (block_size > 0) {
+                write_audio(&wav_writer, audio_buffer, (uint32_t)block_size);
             }
+            total_audio_samples += block_size;
         }
 
         total_samples_processed += block_size;
 
         if (args->verbose && total_samples_processed % (BLOCK_SIZE * 10) == 0) {
-            printf("Processed %zu/%zu samples (%.1f%%)\n",
-                   total_samples_processed, iq_data.num_samples,
-                   100.0f * total_samples_processed / iq_data.num_samples);
+            if (reader.total_samples == 0) {
+                printf("Processed %zu samples\n", total_samples_processed);  // Live input
+            } else {
+                printf("Processed %zu/%llu samples (%.1f%%)\n",
+                       total_samples_processed, (unsigned long long)reader.total_samples,
+                       100.0f * total_samples_processed / reader.total_samples);
+            }
         }
+
+        iq_async_release(async, block);
+        rt_monitor_poll(monitor);
     }
 
     // Clean up
+    iq_async_destroy(async);
+    rt_monitor_destroy(monitor);
     free(audio_buffer);
     wave_writer_close(&wav_writer);
-    iq_free(&iq_data);
+    ssb_demod_free(&ssb);
+    iq_reader_close(&reader);
     if (needs_resampling) resample_free(&resampler);
 
     if (args->verbose) {
@@ -459,7 +531,8 @@ int process_ssb_demodulation(const args_t *args) {
     return EXIT_SUCCESS;
 }
 
-int main(int argc, char *argv[]) {
+// Tool entry point (also called in process by iqjob, see src/jobs/tools.h)
+int iqdemod_ssb_main(int argc, char *argv[]) {
     args_t args;
 
     if (!parse_args(argc, argv, &args)) {
@@ -475,3 +548,9 @@ int main(int argc, char *argv[]) {
 
     return process_ssb_demodulation(&args);
 }
+
+#ifndef IQ_TOOL_LIBRARY
+int main(int argc, char *argv[]) {
+    return iqdemod_ssb_main(argc, argv);
+}
+#endif
@@ -10,12 +10,60 @@
  * produce structured event outputs with SNR, bandwidth, and modulation information.
  *
  * Key Features:
- * - FFT-based signal detection using OS-CFAR algorithm
+ * - FFT-based signal detection using OS-CFAR, or CA/GO/SO-CFAR (--cfar) when
+ *   speed matters more than robustness next to strong signals
+ * - 2-D time x frequency CA-CFAR (--cfar 2d) over a ring of recent rows for
+ *   weak signals that persist across frames
+ * - Per-bin noise floor tracking across frames (--noise-floor): SNR against
+ *   the tracked floor, and a known-noise detector on it (--cfar floor)
+ * - Time-domain energy gate (--gate dB): frames whose sub-block power stays
+ *   near the running quiet level skip the FFT, CFAR and clustering work;
+ *   for sparse bursty captures, with the skipped share reported at the end
+ * - Channelized detection (--channelize M): a polyphase bank splits the band
+ *   into M channels, and only the channels whose power stands out of the
+ *   median get a fine FFT and CFAR; for sparse wideband spectra, with the
+ *   full-band bins, powers and frame times (channel_scan.h)
+ * - Incremental OS-CFAR (--cfar-incremental tol): thresholds are kept for
+ *   the blocks of bins whose spectrum has not moved since they were
+ *   computed; for static or slowly changing spectra
+ * - Approximate OS-CFAR (--cfar-approx dB): the rank is read from a
+ *   sliding histogram of powers quantized to dB-wide bins, at a cost that
+ *   no longer grows with --ref; thresholds err upward by less than one bin
+ * - Modulation from the samples (--iq-features N): closed events are read
+ *   back, mixed to DC and decimated to their band, and classified by a
+ *   pool of N workers (event_features.h) while detection goes on; events
+ *   are written in the order they closed. Cyclic-frequency features
+ *   (cyclo.h) tell PSK, BPSK and FSK apart from noise and FM
  * - Temporal clustering with hysteresis for event formation
  * - Feature extraction including SNR, bandwidth, and modulation classification
  * - Structured event output in CSV or JSONL format
  * - Optional IQ cutouts for detected signals
+ * - Pipelined multi-threaded processing (--threads): a reader thread, N FFT
+ *   workers, M CFAR workers and a clustering stage on the main thread,
+ *   joined by lock-free SPSC queues; events match the serial run exactly
+ * - Under iqjob --in-process, steps with the same input and STFT geometry
+ *   share one FFT pass (spectral_bus.h); detection reads the bus rows
+ * - Batch mode (--inputs list.txt -j N): a pool of N workers takes files from
+ *   a list, each keeping its FFT plan, CFAR, clustering and feature contexts
+ *   and buffers from file to file; every file gets its own event log
+ * - Optional OpenCL offload (--gpu, make GPU=1): rows and CA/GO/SO
+ *   thresholds of 4096-frame batches come from the device
+ * - Continuous monitoring: --follow <dir> consumes rotating capture
+ *   segments as they are completed, as one stream whose CFAR, noise floor
+ *   and cluster state carry across segment boundaries; live inputs (stdin,
+ *   sockets) run the same way. --rotate starts a new event log every N
+ *   seconds of stream time (CSV, JSONL or SigMF annotations), and
+ *   SIGINT/SIGTERM close the open events before exiting
  * - Configurable detection parameters for different scenarios
+ * - Per-stage profile (--profile, --profile=<file.json>): read, convert,
+ *   fft, cfar, cluster and encode time, summed over threads; --trace=<file>
+ *   writes a Chrome trace with one track per pipeline thread and the time
+ *   each spends waiting on the stage before it
+ * - Checkpoint and resume (--checkpoint <file> --resume): the serial loop
+ *   saves the stream position, the CFAR, noise floor, gate and cluster
+ *   state and the event log's size every --checkpoint-every seconds of
+ *   input; a killed run restarted with the same arguments carries on from
+ *   there and writes the same log as an uninterrupted one
  *
  * Usage Examples:
  *   # Basic signal detection
@@ -27,6 +75,16 @@
  *   # JSON output with custom parameters
  *   iqdetect.exe --in signal.iq --output-format jsonl --max-time-gap 100 --max-freq-gap 20000 --out events.jsonl
  *
+ *   # Binary columnar log for later analytics (event_log.h reader API)
+ *   iqdetect.exe --in signal.iq --rate 2000000 --output-format iqev --out events.iqev
+ *
+ *   # Batch: one capture path per line, 4 workers, logs written to events/<name>.csv
+ *   iqdetect.exe --inputs captures.txt -j 4 --format s16 --rate 2000000 --out events
+ *
+ *   # Daemon: follow a recorder's segment directory, one SigMF log per hour
+ *   iqdetect.exe --follow /data/segments --format s16 --rate 2000000 --rotate 3600 \
+ *                --output-format sigmf --out events.sigmf-meta
+ *
  * Technical Pipeline:
  * 1. Load IQ data with SigMF metadata
  * 2. Streaming FFT processing with configurable hop size
@@ -39,6 +97,10 @@
  * Output Formats:
  * - CSV: Standard spreadsheet format with headers
  * - JSONL: One JSON object per line for streaming processing
+ * - SigMF: Events as annotations of a .sigmf-meta, written as they close
+ * - iqev: Binary columnar event log (src/detect/event_log.h) for reports
+ *   and analytics over many runs; blocks of 4096 events with time and
+ *   frequency ranges, so readers skip what a query excludes
  * - IQ Cutouts: Individual IQ files for each detected event
  *
  * Performance:
@@ -54,6 +116,10 @@
  * - Automatic signal discovery and characterization
  */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  // nanosleep under -std=c11
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -61,29 +127,81 @@
 #include <math.h>
 #include <time.h>
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
 
 #include "../src/iq_core/io_iq.h"
 #include "../src/iq_core/io_sigmf.h"
 #include "../src/iq_core/fft.h"
+#include "../src/iq_core/window.h"
+#include "../src/iq_core/stft.h"
+#include "../src/iq_core/arena.h"
+#include "../src/iq_core/hugepage.h"
+#include "../src/iq_core/spsc_queue.h"
+#include "../src/iq_core/spectral_bus.h"
+#include "../src/iq_core/gpu.h"
+#include "../src/iq_core/profile.h"
+#include "../src/iq_core/affinity.h"
+#include "../src/iq_core/checkpoint.h"
 #include "../src/detect/cfar_os.h"
+#include "../src/detect/cfar_ca.h"
+#include "../src/detect/cfar_2d.h"
+#include "../src/detect/noise_floor.h"
+#include "../src/detect/energy_gate.h"
+#include "../src/detect/channel_scan.h"
 #include "../src/detect/cluster.h"
 #include "../src/detect/features.h"
+#include "../src/detect/event_features.h"
+#include "../src/detect/event_log.h"
+#include "../src/jobs/tools.h"
+
+#define IQDETECT_BLOCK_SAMPLES 65536   // Look-ahead beyond one frame per refill
+#define IQDETECT_MAX_DETECTIONS 100    // Reasonable maximum per frame
+#define IQDETECT_MAX_WORKERS 64        // Per pipeline stage
+#define IQDETECT_GPU_BATCH_FRAMES 4096 // Frames per device dispatch (--gpu)
+#define IQDETECT_FOLLOW_POLL_MS 1000   // Directory scan interval (--follow)
+#define IQDETECT_FOLLOW_SETTLE_S 5     // Unchanged this long, the newest segment is complete
+#define IQDETECT_CHECKPOINT_EVERY_S 60.0 // Input seconds between checkpoints (--checkpoint)
 
 // Configuration structure for iqdetect
 typedef struct {
     // Input parameters
     const char *input_file;
+    const char *inputs_file;    // Batch list, one input path per line
+    const char *follow_dir;     // Daemon: segments arriving in this directory, in name order
     const char *meta_file;
-    const char *format_str;     // s8|s16
+    const char *format_str;     // s8|s16|s12|s4
     uint32_t sample_rate;
 
     // Detection parameters
     uint32_t fft_size;
     uint32_t hop_size;
+    const char *window_name;   // FFT window (rectangular, hann, ...)
     double pfa;                // Probability of False Alarm
     uint32_t ref_cells;        // CFAR reference cells
     uint32_t guard_cells;      // CFAR guard cells
     uint32_t os_rank;          // OS-CFAR rank parameter
+    const char *cfar_name;     // os|ca|go|so|2d|floor
+    uint32_t cfar_ref_rows;    // 2-D CFAR training rows per side
+    uint32_t cfar_guard_rows;  // 2-D CFAR guard rows per side
+    const char *noise_floor_name; // ewma|median|min, NULL for no tracking
+    uint32_t noise_frames;     // Noise floor time constant (rows)
+    double gate_db;            // Energy gate margin over the quiet level (0 = no gate)
+    uint32_t gate_hold;        // Frames the gate stays open after a loud one
+    uint32_t channels;         // Channelized detection over this many channels (0 = full band)
+    double channel_margin_db;  // Channel power over the median that runs the fine CFAR
+    bool cfar_incremental;     // OS-CFAR keeps the thresholds of unchanged blocks
+    double cfar_tolerance;     // ... within this relative L1 change
+    double cfar_approx_db;     // OS-CFAR histogram bin width (dB, 0: exact)
 
     // Clustering parameters
     double max_time_gap_ms;    // Maximum time gap for clustering (milliseconds)
@@ -92,10 +210,20 @@ typedef struct {
 
     // Output parameters
     const char *output_file;
-    const char *output_format; // csv|jsonl
+    const char *output_format; // csv|jsonl|sigmf|iqev
     bool generate_cutouts;     // Whether to generate IQ cutouts
+    double rotate_s;           // New event log every this many stream seconds (0 = one log)
+    const char *checkpoint;    // Checkpoint file (--checkpoint), NULL for none
+    double checkpoint_every_s; // Input seconds between checkpoints
+    bool resume;               // Carry on from the checkpoint, if there is one
 
     // Processing options
+    uint32_t threads;          // FFT workers (1 = serial, 0 = one per core)
+    uint32_t cfar_threads;     // CFAR workers (0 = same as threads; 1 for 2d)
+    uint32_t jobs;             // Batch workers, one file each (0 = one per core)
+    bool iq_features;          // Classify events from their samples (--iq-features)
+    uint32_t feature_threads;  // ... on this many workers (0 = one per core)
+    bool gpu;                  // STFT (and mean-level CFAR) on an OpenCL device
     bool verbose;              // Verbose output
     bool show_help;            // Show help and exit
 } iqdetect_config_t;
@@ -103,20 +231,66 @@ typedef struct {
 // Detection context structure
 typedef struct {
     // File I/O
-    iq_data_t iq_data;
+    const char *input_file;    // Current input (--in, or the batch entry)
+    const char *output_file;   // Its event log
+    iq_reader_t reader;        // Streaming input, one block resident at a time
+    uint32_t sample_rate;      // From --rate (or the WAV header)
     sigmf_metadata_t sigmf_meta;
 
     // Processing modules
-    fft_plan_t *fft_plan;
+    fft_plan_f32_t *fft_plan;
+    const window_t *window;    // Shared window table (NULL for rectangular)
+    double snr_correction_db;  // 10*log10(ENBW): maps windowed bin SNR to rectangular
+    bool use_os_cfar;          // OS-CFAR, else mean-level cfar_mean
+    bool use_2d_cfar;          // Time x frequency cfar_grid (overrides the above)
+    bool use_floor_cfar;       // Known-noise detection on the tracked floor
+    bool use_noise_floor;      // Track the floor; SNR is measured against it
+    bool use_gate;             // Quiet frames skip the FFT and CFAR (--gate)
     cfar_os_t cfar_detector;
+    cfar_ca_t cfar_mean;
+    cfar_2d_t cfar_grid;
+    noise_floor_t noise_floor;
+    energy_gate_t gate;        // Judges frames in stream order, on the reader's thread
+    channel_scan_t *scan;      // Channelized detection (--channelize), else NULL
+    float complex *scan_input; // One frame of samples converted for the bank
+    uint64_t scan_pushed;      // Stream samples pushed into the bank
     cluster_t cluster_engine;
     features_t feature_extractor;
+    event_features_t *event_features; // --iq-features pool, else NULL
 
     // FFT working buffers
-    fft_complex_t *fft_in;
-    fft_complex_t *fft_out;
-    fft_complex_t *fft_shifted;
+    iq_block_t block;          // Sliding native s8/s16 block (frame plus hop overlap)
+    uint32_t sample_bits;      // 8 or 16, from the input format
     double *power_spectrum;
+    iq_arena_t arena;          // FFT scratch of every thread that runs frames
+    spectral_bus_t *bus;       // Shared STFT of a fused iqjob step, or NULL
+    uint32_t bus_subscriber;
+
+    // Device path (--gpu): batches of rows, thresholds when the CFAR runs there too
+    gpu_context_t *gpu;
+    gpu_stft_t *gpu_stft;
+    bool gpu_cfar;             // Mean-level thresholds come from the device
+    float *gpu_rows;           // IQDETECT_GPU_BATCH_FRAMES * fft_size
+    float *gpu_thresholds;
+    double *thresholds;        // One row of gpu_thresholds in double
+
+    // Event output, opened when the first event arrives
+    FILE *events_file;
+    sigmf_writer_t *events_sigmf; // --output-format sigmf
+    event_log_writer_t *events_log; // --output-format iqev
+    uint64_t events_written;
+    uint64_t rotation;         // Index of the open log (--rotate)
+    char rotated_path[1024];   // Its path
+
+    // Continuous runs: the end of one segment is not the end of the stream
+    bool segmented;            // --follow: keep clusters open at the end of an input
+    bool live;                 // Events are flushed as they are written
+    uint64_t next_offset;      // Sample offset of the next frame, across segments
+    double stream_time_s;      // Time of the latest frame
+
+    // Checkpoints (--checkpoint): the serial loop saves its state between frames
+    uint64_t checkpoint_interval; // Samples between checkpoints, 0 for none
+    uint64_t next_checkpoint;  // Frame offset that takes the next one
 
     // Configuration
     iqdetect_config_t *config;
@@ -124,10 +298,33 @@ typedef struct {
 
 // Function prototypes
 static void print_usage(void);
+static void print_configuration(const iqdetect_config_t *config);
 static bool parse_arguments(int argc, char **argv, iqdetect_config_t *config);
 static bool initialize_context(iqdetect_context_t *ctx, iqdetect_config_t *config);
 static void cleanup_context(iqdetect_context_t *ctx);
+static bool open_input(iqdetect_context_t *ctx, const char *input_file, const char *output_file);
+static void close_input(iqdetect_context_t *ctx);
+static bool process_batch(iqdetect_config_t *config);
+static bool process_follow(iqdetect_config_t *config);
+static bool init_frame_cfar(iqdetect_context_t *ctx, cfar_os_t *os, cfar_ca_t *ca);
+static void init_scan_config(const iqdetect_config_t *config, channel_scan_config_t *scan_config);
+static uint32_t detect_frame(iqdetect_context_t *ctx, cfar_os_t *os, cfar_ca_t *ca,
+                             const double *power, uint64_t offset,
+                             cfar_detection_t *detections, uint64_t *detection_offset);
+static void measure_against_floor(iqdetect_context_t *ctx, const double *power,
+                                  cfar_detection_t *detections, uint32_t num_detections);
+static void cluster_frame(iqdetect_context_t *ctx, cfar_detection_t *detections,
+                          uint32_t num_detections, uint64_t detection_offset, uint64_t frame_index);
 static bool process_iq_data(iqdetect_context_t *ctx);
+static bool check_checkpoint_mode(iqdetect_context_t *ctx);
+static bool resume_checkpoint(iqdetect_context_t *ctx);
+static bool process_iq_data_pipelined(iqdetect_context_t *ctx);
+static bool process_iq_data_gpu(iqdetect_context_t *ctx);
+static bool open_gpu_stft(iqdetect_context_t *ctx);
+static void emit_event(const cluster_event_t *event, void *user);
+static void queue_event(const cluster_event_t *event, void *user);
+static void finish_events(iqdetect_context_t *ctx);
+static bool open_events_file(iqdetect_context_t *ctx);
 static bool write_events_csv(const cluster_event_t *events, uint32_t num_events,
                            iqdetect_context_t *ctx);
 static bool write_events_jsonl(const cluster_event_t *events, uint32_t num_events,
@@ -135,8 +332,31 @@ static bool write_events_jsonl(const cluster_event_t *events, uint32_t num_event
 static bool generate_iq_cutout(const cluster_event_t *event, uint32_t event_index,
                              iqdetect_context_t *ctx);
 
+// Set from SIGINT/SIGTERM in continuous runs: finish the frame, close the events
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(int signum) {
+    (void)signum;
+    stop_requested = 1;
+}
+
+// Install the stop handlers for a continuous run, or put the previous ones back
+static void catch_stop_signals(bool install) {
+    static void (*previous_int)(int) = SIG_DFL;
+    static void (*previous_term)(int) = SIG_DFL;
+    if (install) {
+        stop_requested = 0;
+        previous_int = signal(SIGINT, request_stop);
+        previous_term = signal(SIGTERM, request_stop);
+    } else {
+        signal(SIGINT, previous_int);
+        signal(SIGTERM, previous_term);
+    }
+}
+
 // Main entry point
-int main(int argc, char **argv) {
+// Tool entry point (also called in process by iqjob, see src/jobs/tools.h)
+int iqdetect_main(int argc, char **argv) {
     iqdetect_config_t config = {
         .fft_size = 4096,
         .hop_size = 1024,
@@ -144,11 +364,22 @@ int main(int argc, char **argv) {
         .ref_cells = 16,
         .guard_cells = 2,
         .os_rank = 8,
+        .cfar_name = "os",
+        .cfar_ref_rows = 0,
+        .cfar_guard_rows = 4,
+        .noise_floor_name = NULL,
+        .noise_frames = 64,
+        .gate_hold = ENERGY_GATE_DEFAULT_HOLD,
+        .channel_margin_db = CHANNEL_SCAN_DEFAULT_MARGIN_DB,
         .max_time_gap_ms = 50.0,
         .max_freq_gap_hz = 10000.0,
         .max_clusters = 100,
         .output_format = "csv",
         .generate_cutouts = false,
+        .checkpoint_every_s = IQDETECT_CHECKPOINT_EVERY_S,
+        .threads = 1,
+        .cfar_threads = 0,
+        .jobs = 1,
         .verbose = false,
         .show_help = false
     };
@@ -164,36 +395,98 @@ int main(int argc, char **argv) {
         return 0;
     }
 
+    // Batch mode: one event log per listed file
+    if (config.inputs_file) {
+        if (config.verbose) {
+            print_configuration(&config);
+        }
+        return process_batch(&config) ? 0 : 1;
+    }
+
+    // Daemon mode: one stream of segments, until stopped
+    if (config.follow_dir) {
+        if (config.verbose) {
+            print_configuration(&config);
+        }
+        return process_follow(&config) ? 0 : 1;
+    }
+
     // Initialize processing context
     iqdetect_context_t context;
     memset(&context, 0, sizeof(context));
     context.config = &config;
 
-    if (!initialize_context(&context, &config)) {
+    if (!initialize_context(&context, &config) ||
+        !open_input(&context, config.input_file, config.output_file)) {
         fprintf(stderr, "Failed to initialize detection context\n");
         cleanup_context(&context);
         return 1;
     }
 
     if (config.verbose) {
-        printf("IQ Detect Configuration:\n");
-        printf("  Input: %s\n", config.input_file);
-        printf("  Sample Rate: %u Hz\n", config.sample_rate);
-        printf("  FFT Size: %u, Hop Size: %u\n", config.fft_size, config.hop_size);
-        printf("  PFA: %.2e, Ref Cells: %u, Guard Cells: %u, OS Rank: %u\n",
-               config.pfa, config.ref_cells, config.guard_cells, config.os_rank);
-        printf("  Max Time Gap: %.1f ms, Max Freq Gap: %.0f Hz\n",
-               config.max_time_gap_ms, config.max_freq_gap_hz);
-        printf("  Output: %s (format: %s)\n", config.output_file, config.output_format);
-        printf("\n");
+        print_configuration(&config);
+    }
+
+    // In a fused iqjob step the rows come from a shared STFT pass instead
+    window_type_t window_type = WINDOW_RECTANGULAR;
+    if (config.window_name) window_type_from_name(config.window_name, &window_type);
+    context.bus = spectral_bus_bound(config.input_file, config.fft_size, config.hop_size,
+                                     window_type, SPECTRAL_BUS_F64, &context.bus_subscriber);
+    if (context.bus && context.scan) {
+        // The bank needs the samples, not the rows
+        spectral_bus_detach(context.bus, context.bus_subscriber);
+        context.bus = NULL;
+    }
+
+    // A live source runs until it ends or the run is stopped
+    context.live = context.reader.stream != NULL;
+
+    // Events wait for their IQ features in the pool, then go to the log
+    if (config.iq_features) {
+        if (context.live) {
+            fprintf(stderr, "--iq-features needs a seekable input, not a live stream\n");
+            cleanup_context(&context);
+            return 1;
+        }
+        context.event_features = event_features_create(config.input_file, (double)context.sample_rate,
+                                                       config.fft_size, config.feature_threads,
+                                                       emit_event, &context);
+        if (!context.event_features) {
+            cleanup_context(&context);
+            return 1;
+        }
+        cluster_set_event_sink(&context.cluster_engine, queue_event, &context);
+    }
+    // Checkpointed runs carry on from the last checkpoint
+    if (config.checkpoint && (!check_checkpoint_mode(&context) || !resume_checkpoint(&context))) {
+        cleanup_context(&context);
+        return 1;
+    }
+    if (context.live) {
+        catch_stop_signals(true);
     }
 
     // Process the IQ data
-    bool success = process_iq_data(&context);
+    bool success;
+    if (!context.bus && context.gpu_stft) {
+        success = process_iq_data_gpu(&context);
+    } else if (!context.bus && (config.threads > 1 || config.cfar_threads > 1)) {
+        success = process_iq_data_pipelined(&context);
+    } else {
+        success = process_iq_data(&context);
+    }
+    if (context.live) {
+        catch_stop_signals(false);
+    }
 
     // Cleanup
     cleanup_context(&context);
 
+    // The outputs are complete: nothing left to resume
+    if (success && config.checkpoint) {
+        remove(config.checkpoint);
+    }
+
     if (success) {
         if (config.verbose) {
             printf("Signal detection completed successfully\n");
@@ -205,34 +498,167 @@ int main(int argc, char **argv) {
     }
 }
 
+// Print the resolved configuration (--verbose)
+static void print_configuration(const iqdetect_config_t *config) {
+    printf("IQ Detect Configuration:\n");
+    if (config->inputs_file) {
+        printf("  Inputs: %s, %u jobs\n", config->inputs_file, config->jobs);
+    } else if (config->follow_dir) {
+        printf("  Following: %s\n", config->follow_dir);
+    } else {
+        printf("  Input: %s\n", config->input_file);
+    }
+    printf("  Sample Rate: %u Hz\n", config->sample_rate);
+    printf("  FFT Size: %u, Hop Size: %u\n", config->fft_size, config->hop_size);
+    printf("  Window: %s\n", config->window_name ? config->window_name : "rectangular");
+    printf("  CFAR: %s, PFA: %.2e, Ref Cells: %u, Guard Cells: %u, OS Rank: %u\n",
+           config->cfar_name, config->pfa, config->ref_cells, config->guard_cells, config->os_rank);
+    if (strcmp(config->cfar_name, "2d") == 0) {
+        printf("  CFAR Rows: %u reference, %u guard\n", config->cfar_ref_rows, config->cfar_guard_rows);
+    }
+    if (config->noise_floor_name) {
+        printf("  Noise Floor: %s over %u frames\n", config->noise_floor_name, config->noise_frames);
+    }
+    if (config->gate_db > 0.0) {
+        printf("  Energy Gate: %.1f dB over %u frames, hold %u\n",
+               config->gate_db, config->noise_frames, config->gate_hold);
+    }
+    if (config->cfar_incremental) {
+        printf("  Incremental CFAR: %u-bin blocks, tolerance %g\n",
+               CFAR_OS_DEFAULT_BLOCK_BINS, config->cfar_tolerance);
+    }
+    if (config->cfar_approx_db > 0.0) {
+        printf("  Approximate CFAR: %.2f dB power bins\n", config->cfar_approx_db);
+    }
+    if (config->channels) {
+        printf("  Channelized: %u channels, %.1f dB over the median, hold %u\n",
+               config->channels, config->channel_margin_db, config->gate_hold);
+    }
+    if (config->threads != 1) {
+        printf("  Threads: %u FFT, %u CFAR\n", config->threads, config->cfar_threads);
+    }
+    if (config->iq_features) {
+        printf("  IQ Features: %u workers\n", config->feature_threads);
+    }
+    printf("  Max Time Gap: %.1f ms, Max Freq Gap: %.0f Hz\n",
+           config->max_time_gap_ms, config->max_freq_gap_hz);
+    printf("  Output: %s%s (format: %s)\n", config->output_file,
+           config->inputs_file ? " (directory)" : "", config->output_format);
+    if (config->rotate_s > 0.0) {
+        printf("  Rotate: every %.0f s of stream\n", config->rotate_s);
+    }
+    printf("\n");
+}
+
 // Print usage information
 static void print_usage(void) {
     printf("IQ Lab - iqdetect: Signal Detection and Classification Tool\n\n");
-    printf("Usage: iqdetect --in <file> [--meta <meta>] --format {s8|s16} --rate <Hz> [options] --out <file>\n\n");
+    printf("Usage: iqdetect --in <file> [--meta <meta>] --format {s8|s16|s12|s4} --rate <Hz> [options] --out <file>\n");
+    printf("       iqdetect --inputs <list> [-j <N>] --format {s8|s16|s12|s4} --rate <Hz> [options] --out <dir>\n");
+    printf("       iqdetect --follow <dir> --format {s8|s16|s12|s4} --rate <Hz> [--rotate <s>] [options] --out <file>\n\n");
     printf("Required Arguments:\n");
     printf("  --in <file>          Input IQ file\n");
-    printf("  --format {s8|s16}    IQ data format\n");
+    printf("  --inputs <list>      Batch mode: text file with one input path per line\n");
+    printf("                       (blank lines and lines starting with # are skipped)\n");
+    printf("  --follow <dir>       Daemon mode: process capture segments as they complete\n");
+    printf("                       in <dir>, in name order, as one continuous stream\n");
+    printf("                       (clusters, CFAR and noise floor carry across segments);\n");
+    printf("                       the newest is complete once a later one appears or it\n");
+    printf("                       has not grown for %d s. Runs until SIGINT/SIGTERM\n", IQDETECT_FOLLOW_SETTLE_S);
+    printf("  --format <fmt>       IQ data format: s8, s16, s12 or s4\n");
     printf("  --rate <Hz>          Sample rate\n");
-    printf("  --out <file>         Output events file\n\n");
+    printf("  --out <file>         Output events file; in batch mode the directory that\n");
+    printf("                       receives one <input name>.csv|.jsonl per input\n\n");
     printf("Detection Parameters:\n");
     printf("  --fft <N>            FFT size (default: 4096)\n");
     printf("  --hop <N>            FFT hop size (default: 1024)\n");
+    printf("  --window <name>      FFT window: rectangular, hann, hamming, blackman,\n");
+    printf("                       blackman-harris, flat-top, kaiser, dpss (default: rectangular)\n");
     printf("  --pfa <float>        Probability of False Alarm (default: 1e-3)\n");
     printf("  --ref-cells <N>      CFAR reference cells (default: 16)\n");
     printf("  --guard-cells <N>    CFAR guard cells (default: 2)\n");
-    printf("  --os-rank <N>        OS-CFAR rank parameter (default: 8)\n\n");
+    printf("  --os-rank <N>        OS-CFAR rank parameter (default: 8)\n");
+    printf("  --cfar {os|ca|go|so|2d|floor} CFAR detector: ordered statistic, cell\n");
+    printf("                       averaging, greatest-of, smallest-of, 2-D time x\n");
+    printf("                       frequency cell averaging, or known noise against the\n");
+    printf("                       tracked noise floor (default: os)\n");
+    printf("  --cfar-ref-rows <N>  2-D CFAR training rows per side (default: 0, so the\n");
+    printf("                       guard rows span the window; suits long carriers)\n");
+    printf("  --cfar-guard-rows <N> 2-D CFAR guard rows per side (default: 4)\n");
+    printf("  --noise-floor {ewma|median|min} Track a per-bin noise floor across frames\n");
+    printf("                       and report SNR against it (default: off; median\n");
+    printf("                       with --cfar floor)\n");
+    printf("  --noise-frames <N>   Noise floor time constant in frames (default: 64);\n");
+    printf("                       also the energy gate's\n");
+    printf("  --gate <dB>          Energy gate: skip the FFT and CFAR of frames whose\n");
+    printf("                       time-domain power stays within <dB> of the quiet\n");
+    printf("                       level, for sparse bursty captures (default: off;\n");
+    printf("                       per-frame CFAR only)\n");
+    printf("  --gate-hold <N>      Frames run after the last loud one (default: %d);\n", ENERGY_GATE_DEFAULT_HOLD);
+    printf("                       also a channel's with --channelize\n");
+    printf("  --channelize <M>     Channelized detection: split the band into M channels\n");
+    printf("                       (a power of two, FFT and hop multiples of M/2) and\n");
+    printf("                       run a fine FFT and CFAR only in the channels whose\n");
+    printf("                       power stands out; for sparse wideband spectra\n");
+    printf("                       (default: off; per-frame CFAR, serial CPU path)\n");
+    printf("  --channel-margin <dB> Channel power over the median channel that runs the\n");
+    printf("                       fine CFAR (default: %.0f)\n", CHANNEL_SCAN_DEFAULT_MARGIN_DB);
+    printf("  --cfar-incremental <tol> OS-CFAR recomputes only the thresholds near blocks\n");
+    printf("                       of %d bins whose relative L1 change exceeds <tol>;\n", CFAR_OS_DEFAULT_BLOCK_BINS);
+    printf("                       0 gives the full pass's detections exactly (default:\n");
+    printf("                       off; --cfar os, one CFAR worker)\n");
+    printf("  --cfar-approx <dB>   OS-CFAR takes the rank from a histogram of <dB>-wide\n");
+    printf("                       power bins (%.2f-%.0f, %.1f typical): constant cost per bin\n",
+           CFAR_OS_HIST_MIN_WIDTH_DB, CFAR_OS_HIST_MAX_WIDTH_DB, CFAR_OS_HIST_DEFAULT_DB);
+    printf("                       for wide --ref-cells, thresholds up to <dB> high\n");
+    printf("                       (default: off, exact)\n\n");
+    printf("Performance:\n");
+    printf("  --threads <N>        FFT worker threads; above 1 runs a pipelined reader ->\n");
+    printf("                       FFT -> CFAR -> clustering with identical output\n");
+    printf("                       (default: 1, serial; 0 = one per core)\n");
+    printf("  --cfar-threads <N>   CFAR worker threads (default: same as --threads;\n");
+    printf("                       always 1 for --cfar 2d, whose rows depend on each other)\n");
+    printf("  --gpu                FFT, and CA/GO/SO thresholds, on an OpenCL device in\n");
+    printf("                       batches of %d frames (build with make GPU=1); falls\n", IQDETECT_GPU_BATCH_FRAMES);
+    printf("                       back to the CPU path when no device is present\n");
+    printf("  --iq-features <N>    Classify each event from its own samples, mixed to DC\n");
+    printf("                       and decimated to its band, on N worker threads while\n");
+    printf("                       detection goes on; events keep their order (default:\n");
+    printf("                       off; 0 = one per core; single seekable files); symbol-\n");
+    printf("                       rate cyclic features add bpsk, psk and fsk\n");
+    printf("  -j, --jobs <N>       Batch workers, each processing whole files and keeping\n");
+    printf("                       its plan, detectors and buffers between them\n");
+    printf("                       (default: 1; 0 = one per core)\n\n");
     printf("Clustering Parameters:\n");
     printf("  --max-time-gap <ms>  Maximum time gap for clustering (default: 50.0)\n");
     printf("  --max-freq-gap <Hz>  Maximum frequency gap for clustering (default: 10000.0)\n");
     printf("  --max-clusters <N>   Maximum number of active clusters (default: 100)\n\n");
     printf("Output Options:\n");
-    printf("  --output-format {csv|jsonl} Output format (default: csv)\n");
+    printf("  --output-format {csv|jsonl|sigmf|iqev} Output format; sigmf writes the events as\n");
+    printf("                       annotations of a .sigmf-meta, iqev a binary columnar log\n");
+    printf("                       (default: csv)\n");
+    printf("  --rotate <s>         Start a new event log every <s> seconds of stream time:\n");
+    printf("                       <out stem>.<index>.<ext>, index 000000 upwards\n");
     printf("  --cut                Generate IQ cutouts for detected events\n");
+    printf("  --checkpoint <file>  Save the stream position, detector and cluster state and\n");
+    printf("                       the log size to <file> every --checkpoint-every seconds\n");
+    printf("                       of input (default: %.0f); removed when the run completes.\n", IQDETECT_CHECKPOINT_EVERY_S);
+    printf("                       Serial CPU path, one file, CSV or JSONL log\n");
+    printf("  --resume             Carry on from the --checkpoint file if there is one: the\n");
+    printf("                       log is cut back to the checkpoint and appended to, giving\n");
+    printf("                       the uninterrupted run's output\n");
     printf("  --verbose            Enable verbose output\n");
+    printf("  --profile[=<file>]   Per-stage timing on stderr at exit, or as JSON to <file>\n");
+    printf("  --pin[=<policy>]     Pin threads to CPUs: compact (default; the pipeline's stages\n");
+    printf("                       on the NUMA node of its frame ring), scatter, or a CPU list\n");
+    printf("  --trace=<file>       Per-thread timeline of the stages as Chrome trace JSON\n");
     printf("  --help, -h           Show this help message\n\n");
     printf("Examples:\n");
     printf("  iqdetect --in signal.iq --format s16 --rate 2000000 --out events.csv\n");
     printf("  iqdetect --in signal.iq --format s16 --rate 2000000 --pfa 1e-4 --cut --output-format jsonl --out events.jsonl\n");
+    printf("  iqdetect --inputs captures.txt -j 4 --format s16 --rate 2000000 --out events\n");
+    printf("  iqdetect --follow segments --format s16 --rate 2000000 --rotate 3600 --out events.csv\n");
+    printf("  iqdetect --in long.iq --format s16 --rate 2000000 --checkpoint events.ckpt --resume --out events.csv\n");
 }
 
 // Parse command line arguments
@@ -249,6 +675,12 @@ static bool parse_arguments(int argc, char **argv, iqdetect_config_t *config) {
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--in") == 0 && i + 1 < argc) {
             config->input_file = argv[++i];
+        } else if (strcmp(argv[i], "--inputs") == 0 && i + 1 < argc) {
+            config->inputs_file = argv[++i];
+        } else if (strcmp(argv[i], "--follow") == 0 && i + 1 < argc) {
+            config->follow_dir = argv[++i];
+        } else if (strcmp(argv[i], "--rotate") == 0 && i + 1 < argc) {
+            config->rotate_s = atof(argv[++i]);
         } else if (strcmp(argv[i], "--meta") == 0 && i + 1 < argc) {
             config->meta_file = argv[++i];
         } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
@@ -259,6 +691,8 @@ static bool parse_arguments(int argc, char **argv, iqdetect_config_t *config) {
             config->fft_size = (uint32_t)strtoul(argv[++i], NULL, 10);
         } else if (strcmp(argv[i], "--hop") == 0 && i + 1 < argc) {
             config->hop_size = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            config->window_name = argv[++i];
         } else if (strcmp(argv[i], "--pfa") == 0 && i + 1 < argc) {
             config->pfa = atof(argv[++i]);
         } else if (strcmp(argv[i], "--ref-cells") == 0 && i + 1 < argc) {
@@ -267,6 +701,29 @@ static bool parse_arguments(int argc, char **argv, iqdetect_config_t *config) {
             config->guard_cells = (uint32_t)strtoul(argv[++i], NULL, 10);
         } else if (strcmp(argv[i], "--os-rank") == 0 && i + 1 < argc) {
             config->os_rank = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--cfar") == 0 && i + 1 < argc) {
+            config->cfar_name = argv[++i];
+        } else if (strcmp(argv[i], "--cfar-ref-rows") == 0 && i + 1 < argc) {
+            config->cfar_ref_rows = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--cfar-guard-rows") == 0 && i + 1 < argc) {
+            config->cfar_guard_rows = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--noise-floor") == 0 && i + 1 < argc) {
+            config->noise_floor_name = argv[++i];
+        } else if (strcmp(argv[i], "--noise-frames") == 0 && i + 1 < argc) {
+            config->noise_frames = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--gate") == 0 && i + 1 < argc) {
+            config->gate_db = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--gate-hold") == 0 && i + 1 < argc) {
+            config->gate_hold = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--channelize") == 0 && i + 1 < argc) {
+            config->channels = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--channel-margin") == 0 && i + 1 < argc) {
+            config->channel_margin_db = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cfar-incremental") == 0 && i + 1 < argc) {
+            config->cfar_incremental = true;
+            config->cfar_tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cfar-approx") == 0 && i + 1 < argc) {
+            config->cfar_approx_db = atof(argv[++i]);
         } else if (strcmp(argv[i], "--max-time-gap") == 0 && i + 1 < argc) {
             config->max_time_gap_ms = atof(argv[++i]);
         } else if (strcmp(argv[i], "--max-freq-gap") == 0 && i + 1 < argc) {
@@ -277,10 +734,31 @@ static bool parse_arguments(int argc, char **argv, iqdetect_config_t *config) {
             config->output_file = argv[++i];
         } else if (strcmp(argv[i], "--output-format") == 0 && i + 1 < argc) {
             config->output_format = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            config->checkpoint = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            config->checkpoint_every_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            config->resume = true;
         } else if (strcmp(argv[i], "--cut") == 0) {
             config->generate_cutouts = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config->threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--iq-features") == 0 && i + 1 < argc) {
+            config->iq_features = true;
+            config->feature_threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--gpu") == 0) {
+            config->gpu = true;
+        } else if (strcmp(argv[i], "--cfar-threads") == 0 && i + 1 < argc) {
+            config->cfar_threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc) {
+            config->jobs = (uint32_t)strtoul(argv[++i], NULL, 10);
         } else if (strcmp(argv[i], "--verbose") == 0) {
             config->verbose = true;
+        } else if (iq_profile_parse_arg("iqdetect", argv[i])) {
+            continue;
+        } else if (iq_affinity_parse_arg(argv[i])) {
+            continue;
         } else {
             fprintf(stderr, "Unknown argument: %s\n", argv[i]);
             return false;
@@ -288,47 +766,209 @@ static bool parse_arguments(int argc, char **argv, iqdetect_config_t *config) {
     }
 
     // Validate required parameters
-    if (!config->input_file || !config->format_str || !config->sample_rate || !config->output_file) {
+    if ((!config->input_file && !config->inputs_file && !config->follow_dir) || !config->format_str ||
+        !config->sample_rate || !config->output_file) {
         fprintf(stderr, "Missing required arguments\n");
         return false;
     }
+    if ((config->input_file != NULL) + (config->inputs_file != NULL) + (config->follow_dir != NULL) > 1) {
+        fprintf(stderr, "--in, --inputs and --follow are mutually exclusive\n");
+        return false;
+    }
+    if (strcmp(config->output_format, "csv") != 0 && strcmp(config->output_format, "jsonl") != 0 &&
+        strcmp(config->output_format, "sigmf") != 0 && strcmp(config->output_format, "iqev") != 0) {
+        fprintf(stderr, "Unknown output format: %s (csv, jsonl, sigmf, iqev)\n", config->output_format);
+        return false;
+    }
+    if (config->rotate_s < 0.0 || (config->rotate_s > 0.0 && config->inputs_file)) {
+        fprintf(stderr, "--rotate needs a positive period and a single input or --follow\n");
+        return false;
+    }
 
     // Validate parameter ranges
+    window_type_t window_type;
+    if (config->window_name && !window_type_from_name(config->window_name, &window_type)) {
+        fprintf(stderr, "Unknown window: %s\n", config->window_name);
+        return false;
+    }
+
+    cfar_mode_t cfar_mode;
+    bool cfar_2d = strcmp(config->cfar_name, "2d") == 0;
+    bool cfar_floor = strcmp(config->cfar_name, "floor") == 0;
+    if (strcmp(config->cfar_name, "os") != 0 && !cfar_2d && !cfar_floor &&
+        !cfar_mode_from_name(config->cfar_name, &cfar_mode)) {
+        fprintf(stderr, "Unknown CFAR detector: %s (os, ca, go, so, 2d, floor)\n", config->cfar_name);
+        return false;
+    }
+
+    // The floor detector needs a tracker; median unless one was chosen
+    if (cfar_floor && !config->noise_floor_name) {
+        config->noise_floor_name = "median";
+    }
+    noise_floor_mode_t noise_mode;
+    if (config->noise_floor_name && !noise_floor_mode_from_name(config->noise_floor_name, &noise_mode)) {
+        fprintf(stderr, "Unknown noise floor tracker: %s (ewma, median, min)\n", config->noise_floor_name);
+        return false;
+    }
+    if (config->noise_floor_name &&
+        (config->noise_frames < 2 || (noise_mode == NOISE_FLOOR_MINIMUM && config->noise_frames < NOISE_FLOOR_SUBWINDOWS))) {
+        fprintf(stderr, "Invalid noise floor time constant: %u frames\n", config->noise_frames);
+        return false;
+    }
+
+    // Skipped frames never reach the detectors: only per-frame CFAR, whose
+    // rows do not depend on each other, can run behind the gate
+    if (config->gate_db < 0.0 || (config->gate_db > 0.0 && config->noise_frames < 1)) {
+        fprintf(stderr, "Invalid energy gate: %g dB\n", config->gate_db);
+        return false;
+    }
+    if (config->gate_db > 0.0 && (cfar_2d || config->noise_floor_name)) {
+        fprintf(stderr, "--gate works with per-frame CFAR only (not --cfar 2d|floor or --noise-floor)\n");
+        return false;
+    }
+    if (config->gate_db > 0.0 && config->gpu) {
+        fprintf(stderr, "--gate runs on the CPU paths (no --gpu)\n");
+        return false;
+    }
+
+    // Channel rows are per frame too, and come out of the bank in stream order
+    if (config->channels && (cfar_2d || config->noise_floor_name || config->gate_db > 0.0 || config->gpu)) {
+        fprintf(stderr, "--channelize works with per-frame CFAR only (not --cfar 2d|floor, "
+                "--noise-floor, --gate or --gpu)\n");
+        return false;
+    }
+    if (config->channels && (config->threads != 1 || config->cfar_threads > 1)) {
+        fprintf(stderr, "--channelize runs the serial path (no --threads)\n");
+        return false;
+    }
+
+    // The kept thresholds belong to the stream's previous rows
+    if (config->cfar_incremental && strcmp(config->cfar_name, "os") != 0) {
+        fprintf(stderr, "--cfar-incremental works with --cfar os only\n");
+        return false;
+    }
+    if (config->cfar_incremental && config->channels) {
+        fprintf(stderr, "--cfar-incremental works on full-band rows (no --channelize)\n");
+        return false;
+    }
+    if (config->cfar_incremental && !(config->cfar_tolerance >= 0.0 && isfinite(config->cfar_tolerance))) {
+        fprintf(stderr, "Invalid --cfar-incremental tolerance (0 or more)\n");
+        return false;
+    }
+
+    if (config->cfar_approx_db != 0.0 && strcmp(config->cfar_name, "os") != 0) {
+        fprintf(stderr, "--cfar-approx works with --cfar os only\n");
+        return false;
+    }
+    if (config->cfar_approx_db != 0.0 && config->channels) {
+        fprintf(stderr, "--cfar-approx works on full-band rows (no --channelize)\n");
+        return false;
+    }
+    if (config->cfar_approx_db != 0.0 && !(config->cfar_approx_db >= CFAR_OS_HIST_MIN_WIDTH_DB &&
+                                           config->cfar_approx_db <= CFAR_OS_HIST_MAX_WIDTH_DB)) {
+        fprintf(stderr, "Invalid --cfar-approx bin width (%.2f to %.0f dB)\n",
+                CFAR_OS_HIST_MIN_WIDTH_DB, CFAR_OS_HIST_MAX_WIDTH_DB);
+        return false;
+    }
+
+    if (cfar_2d && !cfar_2d_validate_params(config->fft_size, config->pfa, config->ref_cells,
+                                            config->guard_cells, config->cfar_ref_rows,
+                                            config->cfar_guard_rows)) {
+        fprintf(stderr, "Invalid 2-D CFAR parameters (ref rows <= %d, guard rows <= %d)\n",
+                CFAR_2D_MAX_REF_ROWS, CFAR_2D_MAX_GUARD_ROWS);
+        return false;
+    }
+
     if (!cfar_os_validate_params(config->fft_size, config->pfa, config->ref_cells,
                                config->guard_cells, config->os_rank)) {
         fprintf(stderr, "Invalid CFAR parameters\n");
         return false;
     }
 
+    if (config->channels) {
+        channel_scan_config_t scan_config;
+        init_scan_config(config, &scan_config);
+        if (!channel_scan_validate(&scan_config)) return false;
+    }
+
     if (!cluster_validate_params(config->max_time_gap_ms, config->max_freq_gap_hz,
                                config->max_clusters, (double)config->sample_rate)) {
         fprintf(stderr, "Invalid clustering parameters\n");
         return false;
     }
 
-    return true;
-}
-
-// Initialize detection context
-static bool initialize_context(iqdetect_context_t *ctx, iqdetect_config_t *config) {
-    memset(ctx, 0, sizeof(*ctx));
-    ctx->config = config; // Restore config pointer after memset
-
-    // Load IQ data
-    if (!iq_load_file(config->input_file, &ctx->iq_data)) {
-        fprintf(stderr, "Failed to load IQ file: %s\n", config->input_file);
+    // Resolve worker counts; the 2-D ring, the noise floor and the incremental
+    // thresholds carry state from row to row, so they run on one CFAR worker
+    if (config->threads == 0) config->threads = stft_default_threads();
+    if (config->cfar_threads == 0) config->cfar_threads = config->threads;
+    if (cfar_2d || config->noise_floor_name || config->cfar_incremental) config->cfar_threads = 1;
+    if (config->threads > IQDETECT_MAX_WORKERS || config->cfar_threads > IQDETECT_MAX_WORKERS) {
+        fprintf(stderr, "Too many threads (at most %d per stage)\n", IQDETECT_MAX_WORKERS);
         return false;
     }
 
-    if (config->sample_rate) {
-        ctx->iq_data.sample_rate = config->sample_rate;
+    // A batch parallelises over files; each file runs the serial loop
+    if (config->jobs == 0) config->jobs = stft_default_threads();
+    if (config->inputs_file && (config->threads > 1 || config->cfar_threads > 1)) {
+        fprintf(stderr, "--threads applies to single files; use -j to spread a batch over workers\n");
+        return false;
+    }
+    if (config->inputs_file && config->gpu) {
+        fprintf(stderr, "--gpu applies to single files\n");
+        return false;
+    }
+    // Events are read back from one file and written after a delay
+    if (config->iq_features && (config->inputs_file || config->follow_dir || config->rotate_s > 0.0)) {
+        fprintf(stderr, "--iq-features applies to single files (no --inputs, --follow or --rotate)\n");
+        return false;
+    }
+    if (config->iq_features && config->feature_threads == 0) config->feature_threads = stft_default_threads();
+    if (config->feature_threads > EVENT_FEATURES_MAX_WORKERS) {
+        fprintf(stderr, "Too many feature threads (at most %d)\n", EVENT_FEATURES_MAX_WORKERS);
+        return false;
+    }
+    // Segments are joined by the serial loop's block, frame by frame
+    if (config->follow_dir && (config->threads > 1 || config->cfar_threads > 1 || config->gpu)) {
+        fprintf(stderr, "--follow runs the serial CPU path (no --threads or --gpu)\n");
+        return false;
+    }
+    if (config->jobs > IQDETECT_MAX_WORKERS) {
+        fprintf(stderr, "Too many jobs (at most %d)\n", IQDETECT_MAX_WORKERS);
+        return false;
     }
 
-    if (ctx->iq_data.sample_rate == 0) {
-        fprintf(stderr, "Invalid sample rate\n");
+    // A checkpoint holds the serial loop's state and the offset of one
+    // appendable log; the other paths keep frames and events in flight
+    if (config->resume && !config->checkpoint) {
+        fprintf(stderr, "--resume needs --checkpoint <file>\n");
+        return false;
+    }
+    if (config->checkpoint && !(config->checkpoint_every_s > 0.0 && isfinite(config->checkpoint_every_s))) {
+        fprintf(stderr, "Invalid checkpoint interval: %g s\n", config->checkpoint_every_s);
+        return false;
+    }
+    if (config->checkpoint &&
+        (!config->input_file || config->threads > 1 || config->cfar_threads > 1 || config->gpu ||
+         config->channels || config->iq_features || config->rotate_s > 0.0 ||
+         (strcmp(config->output_format, "csv") != 0 && strcmp(config->output_format, "jsonl") != 0))) {
+        fprintf(stderr, "--checkpoint runs the serial CPU path on one file with a CSV or JSONL log "
+                "(no --inputs, --follow, --threads, --gpu, --channelize, --iq-features or --rotate)\n");
         return false;
     }
 
+    return true;
+}
+
+/*
+ * Initialize detection context
+ * Sets up everything that does not depend on the input file: FFT plan,
+ * window, detectors, clustering and features. open_input() then attaches a
+ * file; a batch worker reuses one context for all of its files.
+ */
+static bool initialize_context(iqdetect_context_t *ctx, iqdetect_config_t *config) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->config = config; // Restore config pointer after memset
+
     // Load SigMF metadata if provided
     if (config->meta_file) {
         if (!sigmf_read_metadata(config->meta_file, &ctx->sigmf_meta)) {
@@ -337,203 +977,1764 @@ static bool initialize_context(iqdetect_context_t *ctx, iqdetect_config_t *confi
         }
     }
 
-    // Initialize FFT
+    // Initialize FFT; the plan comes from the shared cache, so batch workers
+    // all execute the same one
     printf("Debug: Creating FFT plan with size %u\n", config->fft_size);
-    ctx->fft_plan = fft_plan_create(config->fft_size, FFT_FORWARD);
+    ctx->fft_plan = fft_plan_f32_acquire(config->fft_size, FFT_FORWARD);
     if (!ctx->fft_plan) {
         fprintf(stderr, "Failed to create FFT plan\n");
         return false;
     }
     printf("Debug: FFT plan created\n");
 
-    // Allocate FFT buffers
-    ctx->fft_in = malloc(config->fft_size * sizeof(fft_complex_t));
-    ctx->fft_out = malloc(config->fft_size * sizeof(fft_complex_t));
-    ctx->fft_shifted = malloc(config->fft_size * sizeof(fft_complex_t));
-    ctx->power_spectrum = malloc(config->fft_size * sizeof(double));
+    // Window table; rectangular frames skip the multiply entirely
+    window_type_t window_type = WINDOW_RECTANGULAR;
+    if (config->window_name) {
+        window_type_from_name(config->window_name, &window_type);
+    }
+    if (window_type != WINDOW_RECTANGULAR) {
+        double param = (window_type == WINDOW_KAISER) ? WINDOW_KAISER_DEFAULT_BETA : 0.0;
+        ctx->window = window_acquire(window_type, config->fft_size, param);
+        if (!ctx->window) {
+            fprintf(stderr, "Failed to create %s window\n", window_type_name(window_type));
+            return false;
+        }
+        ctx->snr_correction_db = 10.0 * log10(ctx->window->enbw_bins);
+    }
 
-    if (!ctx->fft_in || !ctx->fft_out || !ctx->fft_shifted || !ctx->power_spectrum) {
+    ctx->power_spectrum = malloc(config->fft_size * sizeof(double));
+    if (!ctx->power_spectrum) {
         fprintf(stderr, "Failed to allocate FFT buffers\n");
         return false;
     }
 
+    // Reserved once for the main thread or each FFT worker; without it the
+    // scratch comes from the heap as before
+    uint32_t fft_threads = config->threads > 1 ? config->threads : 1;
+    iq_arena_init(&ctx->arena, (size_t)fft_threads * fft_scratch_bytes(config->fft_size));
+
     // Initialize CFAR detector
-    if (!cfar_os_init(&ctx->cfar_detector, config->fft_size, config->pfa,
-                     config->ref_cells, config->guard_cells, config->os_rank)) {
+    cfar_mode_t cfar_mode;
+    ctx->use_2d_cfar = strcmp(config->cfar_name, "2d") == 0;
+    ctx->use_floor_cfar = strcmp(config->cfar_name, "floor") == 0;
+    ctx->use_os_cfar = !ctx->use_2d_cfar && !ctx->use_floor_cfar &&
+                       !cfar_mode_from_name(config->cfar_name, &cfar_mode);
+    bool cfar_ok;
+    if (ctx->use_floor_cfar) {
+        cfar_ok = true; // Detects on the tracker set up below
+    } else if (ctx->use_2d_cfar) {
+        cfar_ok = cfar_2d_init(&ctx->cfar_grid, config->fft_size, config->pfa,
+                               config->ref_cells, config->guard_cells,
+                               config->cfar_ref_rows, config->cfar_guard_rows);
+    } else {
+        cfar_ok = init_frame_cfar(ctx, &ctx->cfar_detector, &ctx->cfar_mean);
+    }
+    if (!cfar_ok) {
         fprintf(stderr, "Failed to initialize CFAR detector\n");
         return false;
     }
 
+    // Noise floor tracker, updated once per row
+    ctx->use_noise_floor = config->noise_floor_name != NULL;
+    if (ctx->use_noise_floor) {
+        noise_floor_mode_t noise_mode = NOISE_FLOOR_MEDIAN;
+        noise_floor_mode_from_name(config->noise_floor_name, &noise_mode);
+        if (!noise_floor_init(&ctx->noise_floor, config->fft_size, noise_mode, config->noise_frames)) {
+            fprintf(stderr, "Failed to initialize noise floor tracker\n");
+            return false;
+        }
+    }
+
+    // Energy gate, ahead of the FFT; the bus and the device path see every row
+    ctx->use_gate = config->gate_db > 0.0;
+    if (ctx->use_gate && !energy_gate_init(&ctx->gate, config->gate_db, config->noise_frames,
+                                           config->gate_hold)) {
+        fprintf(stderr, "Failed to initialize energy gate\n");
+        return false;
+    }
+
+    // Channel bank and fine detectors, with one frame of converted samples
+    if (config->channels) {
+        channel_scan_config_t scan_config;
+        init_scan_config(config, &scan_config);
+        ctx->scan = channel_scan_create(&scan_config);
+        ctx->scan_input = malloc((size_t)config->fft_size * sizeof(float complex));
+        if (!ctx->scan || !ctx->scan_input) {
+            fprintf(stderr, "Failed to initialize channelized detection\n");
+            return false;
+        }
+    }
+
     // Initialize clustering
     if (!cluster_init(&ctx->cluster_engine, config->max_time_gap_ms, config->max_freq_gap_hz,
                      config->max_clusters, (double)config->sample_rate)) {
         fprintf(stderr, "Failed to initialize clustering\n");
         return false;
     }
+    cluster_set_event_sink(&ctx->cluster_engine, emit_event, ctx);
 
     // Initialize feature extraction
     if (!features_init(&ctx->feature_extractor, config->fft_size, (double)config->sample_rate, 128)) {
         fprintf(stderr, "Failed to initialize feature extraction\n");
         return false;
     }
+    if (ctx->use_noise_floor) {
+        // Filled from the first row on; features read the same per-bin floor
+        features_set_noise_floor(&ctx->feature_extractor, ctx->noise_floor.floor);
+    }
+
+    // The device STFT itself is created per input, once its sample width is known
+    if (config->gpu) {
+        ctx->gpu = gpu_open(NULL);
+        if (!ctx->gpu) {
+            fprintf(stderr, "GPU unavailable; using the CPU path\n");
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Attach an input file and its event log to an initialized context
+ * The sample block is allocated for the first file and rebound for later
+ * ones; close_input() must run between files.
+ */
+static bool open_input(iqdetect_context_t *ctx, const char *input_file, const char *output_file) {
+    iqdetect_config_t *config = ctx->config;
+    ctx->input_file = input_file;
+    ctx->output_file = output_file;
+
+    // Open IQ data for streaming
+    if (!iq_reader_open(&ctx->reader, input_file)) {
+        fprintf(stderr, "Failed to load IQ file: %s\n", input_file);
+        return false;
+    }
+
+    ctx->sample_rate = config->sample_rate ? config->sample_rate : ctx->reader.sample_rate;
+
+    if (ctx->sample_rate == 0) {
+        fprintf(stderr, "Invalid sample rate\n");
+        return false;
+    }
+
+    // A block holds a frame, the hop gap and ~64K samples of look-ahead.
+    // Detection only needs power rows, so samples stay in their native width and are
+    // normalized inside the window multiply
+    // On the device path it holds a whole batch of frames instead
+    ctx->sample_bits = iq_format_bits(ctx->reader.format);
+    if (ctx->gpu && !ctx->gpu_stft && !open_gpu_stft(ctx)) {
+        fprintf(stderr, "GPU unavailable; using the CPU path\n");
+    }
+    bool block_ok;
+    if (ctx->block.native) {
+        block_ok = iq_block_rebind(&ctx->block, &ctx->reader);
+    } else if (ctx->gpu_stft) {
+        size_t span = (size_t)(IQDETECT_GPU_BATCH_FRAMES - 1) * config->hop_size + config->fft_size;
+        block_ok = iq_block_init_native(&ctx->block, &ctx->reader, span);
+    } else {
+        size_t span = config->fft_size > config->hop_size ? config->fft_size : config->hop_size;
+        block_ok = iq_block_init_native(&ctx->block, &ctx->reader, span + IQDETECT_BLOCK_SAMPLES);
+    }
+
+    if (!block_ok) {
+        fprintf(stderr, "Failed to allocate FFT buffers\n");
+        return false;
+    }
 
     return true;
 }
 
+// Close the open event log, if any
+static void close_events_file(iqdetect_context_t *ctx) {
+    if (ctx->events_file) {
+        fclose(ctx->events_file);
+        ctx->events_file = NULL;
+    }
+    if (ctx->events_sigmf) {
+        if (!sigmf_writer_close(ctx->events_sigmf)) {
+            fprintf(stderr, "Failed to write SigMF events: %s\n", ctx->output_file);
+        }
+        ctx->events_sigmf = NULL;
+    }
+    if (ctx->events_log) {
+        if (!event_log_close(ctx->events_log)) {
+            fprintf(stderr, "Failed to write event log: %s\n", ctx->output_file);
+        }
+        ctx->events_log = NULL;
+    }
+}
+
+// Detach the current file: close its event log and clear all per-stream state
+static void close_input(iqdetect_context_t *ctx) {
+    close_events_file(ctx);
+    ctx->events_written = 0;
+    ctx->rotation = 0;
+    ctx->next_offset = 0;
+    ctx->stream_time_s = 0.0;
+    iq_reader_close(&ctx->reader);
+
+    if (ctx->use_os_cfar) {
+        cfar_os_reset(&ctx->cfar_detector);
+    }
+    cfar_2d_reset(&ctx->cfar_grid);
+    noise_floor_reset(&ctx->noise_floor);
+    energy_gate_reset(&ctx->gate);
+    channel_scan_reset(ctx->scan);
+    ctx->scan_pushed = 0;
+    cluster_reset(&ctx->cluster_engine);
+    features_reset(&ctx->feature_extractor);
+}
+
 // Clean up detection context
 static void cleanup_context(iqdetect_context_t *ctx) {
+    event_features_destroy(ctx->event_features);
+    ctx->event_features = NULL;
+    close_input(ctx);
+
     // Free FFT resources
     if (ctx->fft_plan) {
-        fft_plan_destroy(ctx->fft_plan);
+        fft_plan_f32_release(ctx->fft_plan);
     }
-    free(ctx->fft_in);
-    free(ctx->fft_out);
-    free(ctx->fft_shifted);
+    window_release(ctx->window);
+    iq_block_free(&ctx->block);
     free(ctx->power_spectrum);
+    iq_arena_free(&ctx->arena);
+    gpu_stft_destroy(ctx->gpu_stft);
+    gpu_close(ctx->gpu);
+    free(ctx->gpu_rows);
+    free(ctx->gpu_thresholds);
+    free(ctx->thresholds);
 
     // Clean up detection modules
     cfar_os_free(&ctx->cfar_detector);
+    cfar_ca_free(&ctx->cfar_mean);
+    cfar_2d_free(&ctx->cfar_grid);
+    noise_floor_free(&ctx->noise_floor);
+    channel_scan_destroy(ctx->scan);
+    free(ctx->scan_input);
     cluster_free(&ctx->cluster_engine);
     features_free(&ctx->feature_extractor);
-
-    // Clean up data
-    iq_free(&ctx->iq_data);
     sigmf_free_metadata(&ctx->sigmf_meta);
 }
 
-// Process IQ data through detection pipeline
-static bool process_iq_data(iqdetect_context_t *ctx) {
+// Per-frame CFAR (os, ca, go or so) with the configured parameters
+static bool init_frame_cfar(iqdetect_context_t *ctx, cfar_os_t *os, cfar_ca_t *ca) {
     iqdetect_config_t *config = ctx->config;
+    cfar_mode_t cfar_mode = CFAR_MODE_CA;
+    cfar_mode_from_name(config->cfar_name, &cfar_mode);
 
-    uint64_t num_frames = 0;
-    uint64_t total_detections = 0;
-
-    for (uint64_t offset = 0; offset + config->fft_size <= ctx->iq_data.num_samples;
-         offset += config->hop_size) {
-
-        // Prepare FFT input - convert IQ samples to complex format
-        for (uint32_t i = 0; i < config->fft_size; i++) {
-            size_t sample_idx = offset + i;
-            if (sample_idx >= ctx->iq_data.num_samples) break;
+    if (!ctx->use_os_cfar) {
+        return cfar_ca_init(ca, config->fft_size, config->pfa,
+                            config->ref_cells, config->guard_cells, cfar_mode);
+    }
+    if (!cfar_os_init(os, config->fft_size, config->pfa,
+                      config->ref_cells, config->guard_cells, config->os_rank)) {
+        return false;
+    }
+    return cfar_os_set_approximate(os, config->cfar_approx_db) &&
+           (!config->cfar_incremental ||
+            cfar_os_set_incremental(os, CFAR_OS_DEFAULT_BLOCK_BINS, config->cfar_tolerance));
+}
 
-            float i_val = ctx->iq_data.data[sample_idx * 2];
-            float q_val = ctx->iq_data.data[sample_idx * 2 + 1];
-            ctx->fft_in[i] = i_val + q_val * I;
-        }
+// Channel scan with the frame geometry, window and per-frame CFAR of the full-band path
+static void init_scan_config(const iqdetect_config_t *config, channel_scan_config_t *scan_config) {
+    memset(scan_config, 0, sizeof(*scan_config));
+    scan_config->fft_size = config->fft_size;
+    scan_config->hop_size = config->hop_size;
+    scan_config->num_channels = config->channels;
+    scan_config->sample_rate = (double)config->sample_rate;
+    scan_config->window = WINDOW_RECTANGULAR;
+    if (config->window_name) window_type_from_name(config->window_name, &scan_config->window);
+    scan_config->margin_db = config->channel_margin_db;
+    scan_config->hold_frames = config->gate_hold;
+    scan_config->pfa = config->pfa;
+    scan_config->ref_cells = config->ref_cells;
+    scan_config->guard_cells = config->guard_cells;
+    scan_config->os_rank = config->os_rank;
+    scan_config->ca_mode = CFAR_MODE_CA;
+    scan_config->use_os = !cfar_mode_from_name(config->cfar_name, &scan_config->ca_mode);
+    scan_config->max_detections = IQDETECT_MAX_DETECTIONS;
+}
 
-        // Execute FFT
-        if (!fft_execute(ctx->fft_plan, ctx->fft_in, ctx->fft_out)) {
-            fprintf(stderr, "FFT execution failed at frame %llu\n", (unsigned long long)num_frames);
-            continue;
-        }
+// CFAR detection on one power row; 'detection_offset' receives the sample
+// offset the detections belong to
+static uint32_t detect_frame(iqdetect_context_t *ctx, cfar_os_t *os, cfar_ca_t *ca,
+                             const double *power, uint64_t offset,
+                             cfar_detection_t *detections, uint64_t *detection_offset) {
+    uint64_t t = iq_profile_begin();
+    uint32_t num_detections;
+    *detection_offset = offset;
+    if (ctx->use_floor_cfar) {
+        // Against the floor of the rows before this one
+        num_detections = noise_floor_detect(&ctx->noise_floor, power, ctx->config->pfa,
+                                            detections, IQDETECT_MAX_DETECTIONS);
+    } else if (ctx->use_2d_cfar) {
+        // Detections belong to the ring's centre row, delay_rows hops back;
+        // clustering runs on that time line too
+        num_detections = cfar_2d_push_row(&ctx->cfar_grid, power, detections, IQDETECT_MAX_DETECTIONS);
+        uint64_t delay = (uint64_t)ctx->cfar_grid.delay_rows * ctx->config->hop_size;
+        *detection_offset = offset > delay ? offset - delay : 0;
+    } else {
+        num_detections = ctx->use_os_cfar ?
+            cfar_os_process_frame(os, power, detections, IQDETECT_MAX_DETECTIONS) :
+            cfar_ca_process_frame(ca, power, detections, IQDETECT_MAX_DETECTIONS);
+    }
 
-        // FFT shift to center DC
-        if (!fft_shift(ctx->fft_out, ctx->fft_shifted, config->fft_size)) {
-            fprintf(stderr, "FFT shift failed at frame %llu\n", (unsigned long long)num_frames);
-            continue;
-        }
+    measure_against_floor(ctx, power, detections, num_detections);
+    iq_profile_end(IQ_PROFILE_CFAR, t, ctx->config->fft_size, 0);
+    return num_detections;
+}
 
-        // Calculate power spectrum (magnitude squared)
-        for (uint32_t i = 0; i < config->fft_size; i++) {
-            double real = creal(ctx->fft_shifted[i]);
-            double imag = cimag(ctx->fft_shifted[i]);
-            ctx->power_spectrum[i] = real * real + imag * imag;
+// With a tracked floor: SNR against the noise itself rather than the
+// detection threshold, then fold this row into the floor
+static void measure_against_floor(iqdetect_context_t *ctx, const double *power,
+                                  cfar_detection_t *detections, uint32_t num_detections) {
+    if (!ctx->use_noise_floor) return;
+
+    const double *floor = noise_floor_get(&ctx->noise_floor);
+    for (uint32_t i = 0; floor && i < num_detections; i++) {
+        double noise = floor[detections[i].bin_index];
+        if (noise > 0.0) {
+            detections[i].snr_estimate = detections[i].signal_power - 10.0 * log10(noise);
         }
+    }
+    noise_floor_update(&ctx->noise_floor, power);
+}
 
-        // Apply CFAR detection
-        cfar_detection_t detections[100]; // Reasonable maximum per frame
-        uint32_t num_detections = cfar_os_process_frame(&ctx->cfar_detector,
-                                                      ctx->power_spectrum,
-                                                      detections, 100);
-
-        total_detections += num_detections;
+// Feed one frame's detections to the clustering engine in order
+static void cluster_frame(iqdetect_context_t *ctx, cfar_detection_t *detections,
+                          uint32_t num_detections, uint64_t detection_offset, uint64_t frame_index) {
+    iqdetect_config_t *config = ctx->config;
 
-        // Process detections - convert to Hz and time
-        double frame_time = (double)offset / (double)config->sample_rate;
+    // Process detections - convert to Hz and time
+    uint64_t t = iq_profile_begin();
+    double frame_time = (double)detection_offset / (double)config->sample_rate;
+    ctx->stream_time_s = frame_time;
 
-        for (uint32_t i = 0; i < num_detections; i++) {
-            cfar_detection_t *det = &detections[i];
+    for (uint32_t i = 0; i < num_detections; i++) {
+        cfar_detection_t *det = &detections[i];
+        det->snr_estimate += ctx->snr_correction_db;
 
-            // Add to clustering engine
-            if (!cluster_add_detection(&ctx->cluster_engine, det, frame_time)) {
-                if (config->verbose) {
-                    printf("Warning: Failed to add detection to cluster at frame %llu\n",
-                           (unsigned long long)num_frames);
-                }
+        // Add to clustering engine
+        if (!cluster_add_detection(&ctx->cluster_engine, det, frame_time)) {
+            if (config->verbose) {
+                printf("Warning: Failed to add detection to cluster at frame %llu\n",
+                       (unsigned long long)frame_index);
             }
         }
+    }
 
-        // Periodically extract completed events
-        if (num_frames % 100 == 0) { // Extract events every 100 frames
-            cluster_event_t events[50];
-            uint32_t num_events = cluster_get_events(&ctx->cluster_engine, events, 50, frame_time);
+    // Emit events whose time gap has just expired
+    cluster_advance(&ctx->cluster_engine, frame_time);
+    iq_profile_end(IQ_PROFILE_CLUSTER, t, num_detections, 0);
+}
 
-            // Debug: cluster_get_events returned %u events at frame %llu
+/*
+ * Energy gate on one frame of native samples: false when the frame is quiet
+ * and its FFT and CFAR can be skipped. Sub-blocks are a hop long, so a
+ * burst that starts late in the frame still opens it.
+ */
+static bool gate_frame(iqdetect_context_t *ctx, const void *frame) {
+    if (!ctx->use_gate) return true;
+    const uint32_t fft_size = ctx->config->fft_size;
+    uint64_t t = iq_profile_begin();
+    bool active = energy_gate_frame(&ctx->gate, frame, ctx->sample_bits, fft_size, ctx->config->hop_size);
+    iq_profile_end(IQ_PROFILE_CFAR, t, fft_size, 0);
+    return active;
+}
 
-            if (num_events > 0) {
-                if (config->verbose) {
-                    printf("Extracted %u events at frame %llu\n", num_events, (unsigned long long)num_frames);
-                }
+// Frames the gate let through so far
+static void report_gate(const iqdetect_context_t *ctx) {
+    if (!ctx->use_gate) return;
+    uint64_t frames = ctx->gate.frames;
+    uint64_t skipped = frames - ctx->gate.active_frames;
+    printf("Energy gate: skipped %llu of %llu frames (%.1f%%)\n", (unsigned long long)skipped,
+           (unsigned long long)frames, frames ? 100.0 * (double)skipped / (double)frames : 0.0);
+}
 
-                // Write events to output file
-                if (strcmp(config->output_format, "jsonl") == 0) {
-                    write_events_jsonl(events, num_events, ctx);
-                } else {
-                    write_events_csv(events, num_events, ctx);
-                }
-            }
-        }
+// Blocks whose thresholds the incremental OS-CFAR kept so far
+static void report_incremental(const iqdetect_context_t *ctx, const cfar_os_t *os) {
+    if (!ctx->config->cfar_incremental || !ctx->use_os_cfar) return;
+    uint64_t checked = os->blocks_checked;
+    printf("Incremental CFAR: kept %llu of %llu blocks (%.1f%%)\n", (unsigned long long)os->blocks_kept,
+           (unsigned long long)checked, checked ? 100.0 * (double)os->blocks_kept / (double)checked : 0.0);
+}
 
-        num_frames++;
+// Cluster every channelized frame the bank has completed; returns the detections
+static uint64_t scan_frames(iqdetect_context_t *ctx, uint64_t *num_frames) {
+    cfar_detection_t detections[IQDETECT_MAX_DETECTIONS];
+    uint64_t total = 0;
+    for (;;) {
+        uint32_t num_detections;
+        uint64_t detection_offset;
+        uint64_t t = iq_profile_begin();
+        if (!channel_scan_frame(ctx->scan, detections, &num_detections, &detection_offset)) break;
+        iq_profile_end(IQ_PROFILE_CFAR, t, ctx->config->fft_size, 0);
+
+        total += num_detections;
+        cluster_frame(ctx, detections, num_detections, detection_offset, *num_frames);
+        (*num_frames)++;
     }
+    return total;
+}
 
-    // Extract any remaining events
-    cluster_event_t events[50];
-    double final_time = (double)ctx->iq_data.num_samples / (double)config->sample_rate;
-    uint32_t num_events = cluster_get_events(&ctx->cluster_engine, events, 50, final_time);
-
-    // Debug: Final cluster_get_events returned %u events
-
-    if (num_events > 0) {
-        if (config->verbose) {
-            printf("Extracted %u final events\n", num_events);
-        }
-
-        // Write final events to output file
-        if (strcmp(config->output_format, "jsonl") == 0) {
-            write_events_jsonl(events, num_events, ctx);
-        } else {
-            write_events_csv(events, num_events, ctx);
-        }
+// Push samples (NULL: zeros) through the bank, clustering frames as they complete
+static uint64_t scan_push(iqdetect_context_t *ctx, const float complex *samples, size_t count,
+                          uint64_t *num_frames) {
+    uint64_t total = 0;
+    for (size_t done = 0; done < count;) {
+        uint64_t t = iq_profile_begin();
+        size_t pushed = channel_scan_push(ctx->scan, samples ? samples + done : NULL, count - done);
+        iq_profile_end(IQ_PROFILE_CHANNELIZE, t, pushed, 0);
+
+        uint64_t frames = *num_frames;
+        total += scan_frames(ctx, num_frames);
+        if (pushed == 0 && frames == *num_frames) break; // Cannot happen with a valid scan
+        done += pushed;
     }
+    return total;
+}
 
-    if (config->verbose) {
-        printf("Processing complete:\n");
-        printf("  Frames processed: %llu\n", (unsigned long long)num_frames);
-        printf("  Total detections: %llu\n", (unsigned long long)total_detections);
-        printf("  Events extracted: %u\n", cluster_get_active_count(&ctx->cluster_engine));
-    }
+/*
+ * Channelized detection of one frame: the frame's samples the bank has not
+ * seen yet go in. Frames leave the bank a filter delay behind the input, so
+ * the ones completed here are earlier frames; the last arrive with
+ * finish_scan().
+ */
+static uint64_t scan_frame(iqdetect_context_t *ctx, const void *frame, uint64_t offset,
+                           uint64_t *num_frames) {
+    const uint32_t fft_size = ctx->config->fft_size;
+    uint64_t start = ctx->scan_pushed > offset ? ctx->scan_pushed : offset;
+    size_t count = (size_t)(offset + fft_size - start);
+    size_t sample_bytes = iq_native_sample_bytes(ctx->block.format);
+
+    uint64_t t = iq_profile_begin();
+    iq_convert_to_float((const uint8_t *)frame + (start - offset) * sample_bytes, count * sample_bytes,
+                        ctx->block.format, (float *)ctx->scan_input, count);
+    iq_profile_end(IQ_PROFILE_CONVERT, t, count, count * sample_bytes);
+
+    ctx->scan_pushed = offset + fft_size;
+    return scan_push(ctx, ctx->scan_input, count, num_frames);
+}
 
-    return true;
+// End of the stream: flush the filter delay so the last frames complete
+static uint64_t finish_scan(iqdetect_context_t *ctx, uint64_t *num_frames) {
+    if (!ctx->scan) return 0;
+    return scan_push(ctx, NULL, ctx->scan->flush_samples, num_frames);
 }
 
-// Write events in CSV format
-static bool write_events_csv(const cluster_event_t *events, uint32_t num_events,
-                           iqdetect_context_t *ctx) {
-    static bool header_written = false;
-    iqdetect_config_t *config = ctx->config;
+// Channel frames that ran the fine FFT and CFAR so far
+static void report_scan(const iqdetect_context_t *ctx) {
+    if (!ctx->scan) return;
+    uint64_t total = ctx->scan->frames * ctx->config->channels;
+    printf("Channelized: fine FFT + CFAR on %llu of %llu channel frames (%.1f%%)\n",
+           (unsigned long long)ctx->scan->fine_frames, (unsigned long long)total,
+           total ? 100.0 * (double)ctx->scan->fine_frames / (double)total : 0.0);
+}
 
-    FILE *file = fopen(config->output_file, header_written ? "a" : "w");
-    if (!file) {
-        fprintf(stderr, "Failed to open output file: %s\n", config->output_file);
-        return false;
-    }
+/*
+ * Checkpoints (--checkpoint). Taken between frames of the serial loop: the
+ * offset of the next frame, the state of every detector that carries rows
+ * over (OS-CFAR thresholds, 2-D ring, noise floor, gate, open clusters)
+ * and the event log as it stood, synced to disk. Resuming restores them,
+ * cuts the log back to that size and seeks the input to the frame, so the
+ * run writes what an uninterrupted one would have.
+ */
 
-    // Write header if this is the first write
-    if (!header_written) {
-        fprintf(file, "t_start_s,t_end_s,f_center_Hz,bw_Hz,snr_dB,peak_dBFS,modulation_guess,confidence_0_1,tags\n");
-        header_written = true;
+#define IQDETECT_LOG_NONE 0    // No log on disk at the checkpoint
+#define IQDETECT_LOG_CLOSED 1  // A file not opened yet (JSONL appends to it)
+#define IQDETECT_LOG_OPEN 2    // The open log
+
+typedef struct {
+    uint64_t next_offset;      // Frame the resumed run starts at
+    uint64_t events_written;
+    double stream_time_s;
+    uint64_t log_bytes;        // Log size at the checkpoint
+    uint32_t log_state;        // IQDETECT_LOG_*
+    uint32_t fft_size;
+    uint32_t hop_size;
+    uint32_t sample_rate;
+    uint32_t detectors;        // IQDETECT_STATE_* saved alongside
+    uint32_t reserved;
+} iqdetect_checkpoint_t;
+
+#define IQDETECT_STATE_OS_CFAR 1u
+#define IQDETECT_STATE_2D_CFAR 2u
+#define IQDETECT_STATE_NOISE_FLOOR 4u
+#define IQDETECT_STATE_GATE 8u
+
+// Detectors whose state the checkpoint carries
+static uint32_t checkpoint_detectors(const iqdetect_context_t *ctx) {
+    return (ctx->use_os_cfar ? IQDETECT_STATE_OS_CFAR : 0) |
+           (ctx->use_2d_cfar ? IQDETECT_STATE_2D_CFAR : 0) |
+           (ctx->use_noise_floor ? IQDETECT_STATE_NOISE_FLOOR : 0) |
+           (ctx->use_gate ? IQDETECT_STATE_GATE : 0);
+}
+
+// Sources a checkpoint cannot restart: live streams and fused iqjob rows
+static bool check_checkpoint_mode(iqdetect_context_t *ctx) {
+    if (ctx->live || ctx->bus) {
+        fprintf(stderr, "--checkpoint needs a seekable file input (not a live stream or fused step)\n");
+        return false;
+    }
+    double interval = ctx->config->checkpoint_every_s * (double)ctx->sample_rate;
+    ctx->checkpoint_interval = interval > ctx->config->hop_size ? (uint64_t)interval : ctx->config->hop_size;
+    ctx->next_checkpoint = ctx->checkpoint_interval;
+    return true;
+}
+
+// Save the state before the frame at 'offset'; a failed save keeps the previous one
+static void save_checkpoint(iqdetect_context_t *ctx, uint64_t offset) {
+    iqdetect_config_t *config = ctx->config;
+    iqdetect_checkpoint_t state = {
+        .next_offset = offset,
+        .events_written = ctx->events_written,
+        .stream_time_s = ctx->stream_time_s,
+        .fft_size = config->fft_size,
+        .hop_size = config->hop_size,
+        .sample_rate = ctx->sample_rate,
+        .detectors = checkpoint_detectors(ctx),
+    };
+
+    bool ok = true;
+    struct stat log_stat;
+    if (ctx->events_file) {
+        state.log_state = IQDETECT_LOG_OPEN;
+        ok = checkpoint_sync_output(ctx->events_file, &state.log_bytes);
+    } else if (stat(ctx->output_file, &log_stat) == 0) {
+        state.log_state = IQDETECT_LOG_CLOSED;
+        state.log_bytes = (uint64_t)log_stat.st_size;
+    }
+
+    checkpoint_writer_t writer;
+    ok = ok && checkpoint_begin(&writer, config->checkpoint, "iqdetect");
+    if (ok) {
+        ok = checkpoint_put(&writer, "iqdetect.stream", &state, sizeof(state)) &&
+             (!(state.detectors & IQDETECT_STATE_OS_CFAR) || cfar_os_save_state(&ctx->cfar_detector, &writer)) &&
+             (!(state.detectors & IQDETECT_STATE_2D_CFAR) || cfar_2d_save_state(&ctx->cfar_grid, &writer)) &&
+             (!(state.detectors & IQDETECT_STATE_NOISE_FLOOR) || noise_floor_save_state(&ctx->noise_floor, &writer)) &&
+             (!(state.detectors & IQDETECT_STATE_GATE) || energy_gate_save_state(&ctx->gate, &writer)) &&
+             cluster_save_state(&ctx->cluster_engine, &writer);
+        if (ok) {
+            ok = checkpoint_commit(&writer);
+        } else {
+            checkpoint_abort(&writer);
+        }
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Warning: failed to write checkpoint %s\n", config->checkpoint);
+    } else if (config->verbose) {
+        printf("Checkpoint at sample %llu\n", (unsigned long long)offset);
+    }
+}
+
+/*
+ * --resume: restore the checkpoint, if there is one, before the first
+ * frame. Without one the run starts from the beginning.
+ */
+static bool resume_checkpoint(iqdetect_context_t *ctx) {
+    iqdetect_config_t *config = ctx->config;
+    if (!config->resume) return true;
+    FILE *probe = fopen(config->checkpoint, "rb");
+    if (!probe) {
+        if (config->verbose) printf("No checkpoint at %s; starting from the beginning\n", config->checkpoint);
+        return true;
+    }
+    fclose(probe);
+
+    checkpoint_t checkpoint;
+    if (!checkpoint_load(&checkpoint, config->checkpoint, "iqdetect")) return false;
+
+    iqdetect_checkpoint_t state;
+    bool ok = checkpoint_get(&checkpoint, "iqdetect.stream", &state, sizeof(state)) &&
+              state.fft_size == config->fft_size && state.hop_size == config->hop_size &&
+              state.sample_rate == ctx->sample_rate && state.detectors == checkpoint_detectors(ctx);
+    ok = ok && (!(state.detectors & IQDETECT_STATE_OS_CFAR) || cfar_os_load_state(&ctx->cfar_detector, &checkpoint)) &&
+         (!(state.detectors & IQDETECT_STATE_2D_CFAR) || cfar_2d_load_state(&ctx->cfar_grid, &checkpoint)) &&
+         (!(state.detectors & IQDETECT_STATE_NOISE_FLOOR) || noise_floor_load_state(&ctx->noise_floor, &checkpoint)) &&
+         (!(state.detectors & IQDETECT_STATE_GATE) || energy_gate_load_state(&ctx->gate, &checkpoint)) &&
+         cluster_load_state(&ctx->cluster_engine, &checkpoint);
+    checkpoint_free(&checkpoint);
+    if (!ok) {
+        fprintf(stderr, "Checkpoint %s does not match these settings\n", config->checkpoint);
+        return false;
+    }
+
+    // The log as it stood: the open one is appended to (no second CSV header)
+    if (state.log_state == IQDETECT_LOG_OPEN) {
+        ctx->events_file = checkpoint_reopen_output(ctx->output_file, state.log_bytes);
+        if (!ctx->events_file) return false;
+    } else if (state.log_state == IQDETECT_LOG_CLOSED) {
+        FILE *log = checkpoint_reopen_output(ctx->output_file, state.log_bytes);
+        if (!log) return false;
+        fclose(log);
+    } else {
+        remove(ctx->output_file);
+    }
+
+    // The block restarts empty at the frame
+    if (!iq_reader_seek_sample(&ctx->reader, state.next_offset) || !iq_block_rebind(&ctx->block, &ctx->reader)) {
+        fprintf(stderr, "Cannot resume %s at sample %llu\n", ctx->input_file,
+                (unsigned long long)state.next_offset);
+        return false;
     }
+    ctx->next_offset = state.next_offset;
+    ctx->events_written = state.events_written;
+    ctx->stream_time_s = state.stream_time_s;
+    ctx->next_checkpoint = state.next_offset + ctx->checkpoint_interval;
+
+    if (config->verbose) {
+        printf("Resuming at sample %llu with %llu events written\n", (unsigned long long)state.next_offset,
+               (unsigned long long)state.events_written);
+    }
+    return true;
+}
+
+// Process IQ data through detection pipeline
+static bool process_iq_data(iqdetect_context_t *ctx) {
+    iqdetect_config_t *config = ctx->config;
+
+    uint64_t num_frames = 0;
+    uint64_t total_detections = 0;
+
+    // Stream the file; the block carries the frame overlap between refills
+    // (and, when following, from one segment into the next). Frames after
+    // the first run allocation-free.
+    iq_arena_t *prev_arena = iq_arena_bind(&ctx->arena);
+    uint64_t offset = ctx->next_offset;
+    for (; !stop_requested; offset += config->hop_size) {
+        if (ctx->bus) {
+            // The same row, computed once for every fused step
+            if (spectral_bus_read_f64(ctx->bus, ctx->bus_subscriber, ctx->power_spectrum, 1) != 1) break;
+        } else {
+            // Between frames: everything before 'offset' has been through the detectors
+            if (ctx->checkpoint_interval && offset >= ctx->next_checkpoint) {
+                bool guarded = iq_alloc_guard(false);
+                save_checkpoint(ctx, offset);
+                iq_alloc_guard(guarded);
+                ctx->next_checkpoint = offset + ctx->checkpoint_interval;
+            }
+
+            const void *frame = iq_block_span_native(&ctx->block, offset, config->fft_size);
+            if (!frame) break;
+
+            // Channelized: the bank takes the samples, clustering the frames it completes
+            if (ctx->scan) {
+                total_detections += scan_frame(ctx, frame, offset, &num_frames);
+                iq_alloc_guard(true);
+                continue;
+            }
+
+            // Quiet: no detections, but clusters still see the time pass
+            if (!gate_frame(ctx, frame)) {
+                cluster_frame(ctx, NULL, 0, offset, num_frames);
+                num_frames++;
+                iq_alloc_guard(true);
+                continue;
+            }
+
+            // FFT straight from the interleaved samples to a DC-centred |X|^2 row
+            const float *window = ctx->window ? ctx->window->coefficients_f32 : NULL;
+            uint64_t t = iq_profile_begin();
+            bool fft_ok = fft_spectral_frame_int_f64(ctx->fft_plan, frame, ctx->sample_bits, window,
+                                                     ctx->power_spectrum, false);
+            iq_profile_end(IQ_PROFILE_FFT, t, config->fft_size, 0);
+            if (!fft_ok) {
+                fprintf(stderr, "FFT execution failed at frame %llu\n", (unsigned long long)num_frames);
+                continue;
+            }
+        }
+
+        // Apply CFAR detection
+        cfar_detection_t detections[IQDETECT_MAX_DETECTIONS];
+        uint64_t detection_offset;
+        uint32_t num_detections = detect_frame(ctx, &ctx->cfar_detector, &ctx->cfar_mean,
+                                               ctx->power_spectrum, offset, detections,
+                                               &detection_offset);
+        total_detections += num_detections;
+
+        cluster_frame(ctx, detections, num_detections, detection_offset, num_frames);
+        num_frames++;
+        iq_alloc_guard(true);
+    }
+    iq_alloc_guard(false);
+    iq_arena_bind(prev_arena);
+    ctx->next_offset = offset;
+
+    if (ctx->bus) spectral_bus_detach(ctx->bus, ctx->bus_subscriber);
+
+    // Close out everything still open at the end of the stream
+    if (!ctx->segmented) {
+        total_detections += finish_scan(ctx, &num_frames);
+        cluster_advance(&ctx->cluster_engine, INFINITY);
+        finish_events(ctx);
+    }
+
+    // A daemon's counts run across segments: once per segment only when verbose
+    if (!ctx->segmented || config->verbose) {
+        report_gate(ctx);
+        report_scan(ctx);
+        report_incremental(ctx, &ctx->cfar_detector);
+    }
+    if (config->verbose) {
+        printf("Processing complete:\n");
+        printf("  Frames processed: %llu\n", (unsigned long long)num_frames);
+        printf("  Total detections: %llu\n", (unsigned long long)total_detections);
+        printf("  Events extracted: %llu\n", (unsigned long long)ctx->events_written);
+    }
+
+    return true;
+}
+
+/*
+ * Device STFT for the current input's sample width, plus the mean-level
+ * CFAR stage when the detector is CA/GO/SO; other detectors run on the
+ * host against the device rows
+ */
+static bool open_gpu_stft(iqdetect_context_t *ctx) {
+    iqdetect_config_t *config = ctx->config;
+    if (ctx->sample_bits != 8 && ctx->sample_bits != 16) return false;
+    // Device batches are cut from the known length; live input stays on the host
+    if (ctx->reader.stream) return false;
+
+    const float *window = ctx->window ? ctx->window->coefficients_f32 : NULL;
+    ctx->gpu_stft = gpu_stft_create(ctx->gpu, config->fft_size, window,
+                                    ctx->sample_bits == 8 ? GPU_SAMPLES_S8 : GPU_SAMPLES_S16);
+    if (!ctx->gpu_stft) return false;
+
+    bool mean_level = !ctx->use_os_cfar && !ctx->use_2d_cfar && !ctx->use_floor_cfar;
+    ctx->gpu_cfar = mean_level &&
+        gpu_stft_set_cfar(ctx->gpu_stft, config->ref_cells, config->guard_cells,
+                          (uint32_t)ctx->cfar_mean.mode, ctx->cfar_mean.alpha);
+
+    size_t batch_bins = (size_t)IQDETECT_GPU_BATCH_FRAMES * config->fft_size;
+    ctx->gpu_rows = malloc(batch_bins * sizeof(float));
+    ctx->gpu_thresholds = ctx->gpu_cfar ? malloc(batch_bins * sizeof(float)) : NULL;
+    ctx->thresholds = ctx->gpu_cfar ? malloc(config->fft_size * sizeof(double)) : NULL;
+    if (!ctx->gpu_rows || (ctx->gpu_cfar && (!ctx->gpu_thresholds || !ctx->thresholds))) {
+        gpu_stft_destroy(ctx->gpu_stft);
+        ctx->gpu_stft = NULL;
+        return false;
+    }
+    printf("STFT%s on %s\n", ctx->gpu_cfar ? " and CFAR" : "", gpu_device_name(ctx->gpu));
+    return true;
+}
+
+/*
+ * Device processing: each batch of frames is transformed (and thresholded)
+ * on the device in one dispatch, then rows are detected and clustered on
+ * the host in file order. Device rows are single precision, so detections
+ * can differ from the CPU path for cells right at the threshold.
+ */
+static bool process_iq_data_gpu(iqdetect_context_t *ctx) {
+    iqdetect_config_t *config = ctx->config;
+    const uint32_t size = config->fft_size;
+    uint64_t total = ctx->reader.total_samples;
+    uint64_t total_frames = total >= size ? (total - size) / config->hop_size + 1 : 0;
+    uint64_t total_detections = 0;
+
+    for (uint64_t first = 0; first < total_frames; ) {
+        uint32_t count = total_frames - first < IQDETECT_GPU_BATCH_FRAMES ?
+                         (uint32_t)(total_frames - first) : IQDETECT_GPU_BATCH_FRAMES;
+        size_t span = (size_t)(count - 1) * config->hop_size + size;
+        const void *samples = iq_block_span_native(&ctx->block, first * config->hop_size, span);
+        if (!samples) break;
+        uint64_t t = iq_profile_begin();
+        bool rows_ok = gpu_stft_rows(ctx->gpu_stft, samples, count, config->hop_size, ctx->gpu_rows, false,
+                                     ctx->gpu_cfar ? ctx->gpu_thresholds : NULL);
+        iq_profile_end(IQ_PROFILE_FFT, t, (uint64_t)count * size, 0);
+        if (!rows_ok) {
+            fprintf(stderr, "GPU processing failed at frame %llu\n", (unsigned long long)first);
+            return false;
+        }
+
+        for (uint32_t f = 0; f < count; f++) {
+            const float *row = ctx->gpu_rows + (size_t)f * size;
+            for (uint32_t k = 0; k < size; k++) ctx->power_spectrum[k] = row[k];
+
+            cfar_detection_t detections[IQDETECT_MAX_DETECTIONS];
+            uint64_t offset = (first + f) * config->hop_size;
+            uint64_t detection_offset = offset;
+            uint32_t num_detections;
+            if (ctx->gpu_cfar) {
+                uint64_t t = iq_profile_begin();
+                const float *thresholds = ctx->gpu_thresholds + (size_t)f * size;
+                for (uint32_t k = 0; k < size; k++) ctx->thresholds[k] = thresholds[k];
+                num_detections = cfar_ca_detect_thresholds(&ctx->cfar_mean, ctx->power_spectrum, ctx->thresholds,
+                                                           detections, IQDETECT_MAX_DETECTIONS);
+                measure_against_floor(ctx, ctx->power_spectrum, detections, num_detections);
+                iq_profile_end(IQ_PROFILE_CFAR, t, size, 0);
+            } else {
+                num_detections = detect_frame(ctx, &ctx->cfar_detector, &ctx->cfar_mean, ctx->power_spectrum,
+                                              offset, detections, &detection_offset);
+            }
+            total_detections += num_detections;
+            cluster_frame(ctx, detections, num_detections, detection_offset, first + f);
+        }
+        first += count;
+    }
+
+    cluster_advance(&ctx->cluster_engine, INFINITY);
+    finish_events(ctx);
+
+    report_incremental(ctx, &ctx->cfar_detector);
+    if (config->verbose) {
+        printf("Processing complete:\n");
+        printf("  Frames processed: %llu\n", (unsigned long long)total_frames);
+        printf("  Total detections: %llu\n", (unsigned long long)total_detections);
+        printf("  Events extracted: %llu\n", (unsigned long long)ctx->events_written);
+    }
+    return true;
+}
+
+/*
+ * Pipelined processing
+ *
+ *   reader --> FFT worker k --> CFAR worker j --> clustering (main thread)
+ *
+ * Frame i goes to FFT worker i % N and CFAR worker i % M. Every hop between
+ * two threads has its own SPSC queue, and each stage pulls frame i from the
+ * queue it must arrive on (CFAR worker j reads frame i from FFT worker
+ * i % N's queue; clustering reads it from CFAR worker i % M's), so frames
+ * reach the clustering stage in file order and events are identical to the
+ * serial loop for any N and M.
+ *
+ * Frame slots circulate: the reader pops a free slot, copies the native
+ * samples into it and passes it down; clustering returns it once the
+ * detections are consumed. The slot count bounds the work in flight, so
+ * queues sized for every slot never fill. NULL marks the end of the stream
+ * and is forwarded to every downstream queue of a stage.
+ */
+
+// One frame in flight
+typedef struct {
+    uint64_t index;             // Frame number in the stream
+    uint64_t offset;            // First sample of the frame
+    uint64_t detection_offset;  // Sample offset the detections belong to
+    void *samples;              // Native s8/s16 copy of the frame
+    double *power;              // DC-centred |X|^2 row
+    cfar_detection_t detections[IQDETECT_MAX_DETECTIONS];
+    uint32_t num_detections;
+    bool active;                // False: gated out, no samples, FFT or CFAR
+    bool fft_ok;                // False: skipped like a failed serial frame
+} iqdetect_frame_t;
+
+typedef struct iqdetect_pipeline iqdetect_pipeline_t;
+
+// FFT or CFAR worker thread
+typedef struct {
+    iqdetect_pipeline_t *pipeline;
+    uint32_t index;
+    pthread_t thread;
+    bool started;
+    cfar_os_t cfar_os;          // Per-frame detectors (CFAR workers only)
+    cfar_ca_t cfar_ca;
+} iqdetect_worker_t;
+
+struct iqdetect_pipeline {
+    iqdetect_context_t *ctx;
+    uint32_t fft_workers;       // N
+    uint32_t cfar_workers;      // M
+    uint32_t num_slots;
+    size_t frame_bytes;         // Native bytes per frame
+    iqdetect_frame_t *slots;
+    uint8_t *sample_storage;
+    double *power_storage;
+
+    iq_spsc_t free_slots;       // Clustering -> reader
+    iq_spsc_t *to_fft;          // Reader -> FFT worker k
+    iq_spsc_t *to_cfar;         // FFT worker k -> CFAR worker j, at k * M + j
+    iq_spsc_t *to_cluster;      // CFAR worker j -> clustering
+
+    iqdetect_worker_t *fft;
+    iqdetect_worker_t *cfar;
+    pthread_t reader;
+    bool reader_started;
+    int node;                   // NUMA node of the frame ring with --pin (-1: none)
+};
+
+// Pop a frame; a pop that has to wait for its producer is timed as a stall
+static iqdetect_frame_t *pipeline_pop(iq_spsc_t *queue) {
+    void *item;
+    if (iq_spsc_try_pop(queue, &item)) return item;
+    uint64_t start = iq_profile_begin();
+    item = iq_spsc_pop(queue);
+    iq_profile_end(IQ_PROFILE_WAIT, start, 0, 0);
+    return item;
+}
+
+static void *pipeline_reader(void *arg) {
+    iqdetect_pipeline_t *pipeline = arg;
+    iqdetect_context_t *ctx = pipeline->ctx;
+    uint32_t hop = ctx->config->hop_size;
+    iq_trace_thread_name("reader");
+
+    // The ring's pages land on the reader's node, which every stage shares
+    iq_affinity_pin_node(pipeline->node);
+    iq_affinity_first_touch(pipeline->sample_storage, (size_t)pipeline->num_slots * pipeline->frame_bytes);
+    iq_affinity_first_touch(pipeline->power_storage,
+                            (size_t)pipeline->num_slots * ctx->config->fft_size * sizeof(double));
+
+    uint64_t index = 0;
+    for (uint64_t offset = 0; ; offset += hop, index++) {
+        const void *frame = iq_block_span_native(&ctx->block, offset, ctx->config->fft_size);
+        if (!frame) break;
+
+        iqdetect_frame_t *slot = pipeline_pop(&pipeline->free_slots);
+        slot->active = gate_frame(ctx, frame);
+        if (slot->active) memcpy(slot->samples, frame, pipeline->frame_bytes);
+        slot->index = index;
+        slot->offset = offset;
+        iq_spsc_push(&pipeline->to_fft[index % pipeline->fft_workers], slot);
+        iq_alloc_guard(true);
+    }
+    iq_alloc_guard(false);
+
+    for (uint32_t k = 0; k < pipeline->fft_workers; k++) {
+        iq_spsc_push(&pipeline->to_fft[k], NULL);
+    }
+    return NULL;
+}
+
+static void *pipeline_fft_worker(void *arg) {
+    iqdetect_worker_t *worker = arg;
+    iqdetect_pipeline_t *pipeline = worker->pipeline;
+    iqdetect_context_t *ctx = pipeline->ctx;
+    const float *window = ctx->window ? ctx->window->coefficients_f32 : NULL;
+    const uint32_t m = pipeline->cfar_workers;
+    iq_spsc_t *out = &pipeline->to_cfar[(size_t)worker->index * m];
+    char name[32];
+    snprintf(name, sizeof(name), "fft %u", worker->index);
+    iq_trace_thread_name(name);
+    iq_affinity_pin_node(pipeline->node);
+    iq_arena_bind(&ctx->arena);
+
+    for (;;) {
+        iqdetect_frame_t *frame = pipeline_pop(&pipeline->to_fft[worker->index]);
+        if (!frame) break;
+
+        if (frame->active) {
+            uint64_t t = iq_profile_begin();
+            frame->fft_ok = fft_spectral_frame_int_f64(ctx->fft_plan, frame->samples, ctx->sample_bits,
+                                                       window, frame->power, false);
+            iq_profile_end(IQ_PROFILE_FFT, t, ctx->config->fft_size, 0);
+        } else {
+            frame->fft_ok = true;
+        }
+        iq_spsc_push(&out[frame->index % m], frame);
+        iq_alloc_guard(true);
+    }
+    iq_alloc_guard(false);
+    iq_arena_bind(NULL);
+
+    for (uint32_t j = 0; j < m; j++) {
+        iq_spsc_push(&out[j], NULL);
+    }
+    return NULL;
+}
+
+static void *pipeline_cfar_worker(void *arg) {
+    iqdetect_worker_t *worker = arg;
+    iqdetect_pipeline_t *pipeline = worker->pipeline;
+    const uint32_t n = pipeline->fft_workers;
+    const uint32_t m = pipeline->cfar_workers;
+    char name[32];
+    snprintf(name, sizeof(name), "cfar %u", worker->index);
+    iq_trace_thread_name(name);
+    iq_affinity_pin_node(pipeline->node);
+
+    // Frames j, j + M, j + 2M, ... each from the FFT worker that owns it
+    for (uint64_t index = worker->index; ; index += m) {
+        iq_spsc_t *in = &pipeline->to_cfar[(size_t)(index % n) * m + worker->index];
+        iqdetect_frame_t *frame = pipeline_pop(in);
+        if (!frame) break;
+
+        frame->detection_offset = frame->offset;
+        frame->num_detections = frame->fft_ok && frame->active ?
+            detect_frame(pipeline->ctx, &worker->cfar_os, &worker->cfar_ca, frame->power,
+                         frame->offset, frame->detections, &frame->detection_offset) : 0;
+        iq_spsc_push(&pipeline->to_cluster[worker->index], frame);
+        iq_alloc_guard(true);
+    }
+    iq_alloc_guard(false);
+
+    iq_spsc_push(&pipeline->to_cluster[worker->index], NULL);
+    return NULL;
+}
+
+// Unblock and join whatever was started; only valid before the reader runs
+// or once every stage has drained
+static void pipeline_stop(iqdetect_pipeline_t *pipeline) {
+    const uint32_t m = pipeline->cfar_workers;
+
+    if (!pipeline->reader_started) {
+        // No frames exist: end every stage directly
+        for (uint32_t k = 0; k < pipeline->fft_workers; k++) {
+            if (pipeline->fft[k].started) {
+                iq_spsc_push(&pipeline->to_fft[k], NULL);
+            } else {
+                for (uint32_t j = 0; j < m; j++) {
+                    iq_spsc_push(&pipeline->to_cfar[(size_t)k * m + j], NULL);
+                }
+            }
+        }
+    } else {
+        pthread_join(pipeline->reader, NULL);
+    }
+
+    for (uint32_t k = 0; k < pipeline->fft_workers; k++) {
+        if (pipeline->fft[k].started) pthread_join(pipeline->fft[k].thread, NULL);
+    }
+    for (uint32_t j = 0; j < m; j++) {
+        if (pipeline->cfar[j].started) pthread_join(pipeline->cfar[j].thread, NULL);
+    }
+}
+
+static void pipeline_free(iqdetect_pipeline_t *pipeline) {
+    uint32_t n = pipeline->fft_workers;
+    uint32_t m = pipeline->cfar_workers;
+
+    if (pipeline->cfar) {
+        for (uint32_t j = 0; j < m; j++) {
+            cfar_os_free(&pipeline->cfar[j].cfar_os);
+            cfar_ca_free(&pipeline->cfar[j].cfar_ca);
+        }
+    }
+    iq_spsc_free(&pipeline->free_slots);
+    for (uint32_t k = 0; pipeline->to_fft && k < n; k++) iq_spsc_free(&pipeline->to_fft[k]);
+    for (uint32_t q = 0; pipeline->to_cfar && q < n * m; q++) iq_spsc_free(&pipeline->to_cfar[q]);
+    for (uint32_t j = 0; pipeline->to_cluster && j < m; j++) iq_spsc_free(&pipeline->to_cluster[j]);
+    free(pipeline->to_fft);
+    free(pipeline->to_cfar);
+    free(pipeline->to_cluster);
+    free(pipeline->fft);
+    free(pipeline->cfar);
+    free(pipeline->slots);
+    iq_huge_free(pipeline->sample_storage);
+    iq_huge_free(pipeline->power_storage);
+}
+
+static bool pipeline_init(iqdetect_pipeline_t *pipeline, iqdetect_context_t *ctx) {
+    iqdetect_config_t *config = ctx->config;
+    uint32_t n = config->threads;
+    uint32_t m = config->cfar_threads;
+
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->ctx = ctx;
+    pipeline->node = iq_affinity_current_node();
+    pipeline->fft_workers = n;
+    pipeline->cfar_workers = m;
+    pipeline->num_slots = 2 * (n + m) + 4;  // Keeps every stage busy across hand-offs
+    pipeline->frame_bytes = (size_t)config->fft_size * 2 * (ctx->sample_bits / 8);
+
+    uint32_t slots = pipeline->num_slots;
+    pipeline->slots = calloc(slots, sizeof(iqdetect_frame_t));
+    pipeline->sample_storage = iq_huge_alloc((size_t)slots * pipeline->frame_bytes);
+    pipeline->power_storage = iq_huge_alloc((size_t)slots * config->fft_size * sizeof(double));
+    pipeline->to_fft = calloc(n, sizeof(iq_spsc_t));
+    pipeline->to_cfar = calloc((size_t)n * m, sizeof(iq_spsc_t));
+    pipeline->to_cluster = calloc(m, sizeof(iq_spsc_t));
+    pipeline->fft = calloc(n, sizeof(iqdetect_worker_t));
+    pipeline->cfar = calloc(m, sizeof(iqdetect_worker_t));
+    if (!pipeline->slots || !pipeline->sample_storage || !pipeline->power_storage ||
+        !pipeline->to_fft || !pipeline->to_cfar || !pipeline->to_cluster ||
+        !pipeline->fft || !pipeline->cfar) {
+        fprintf(stderr, "Failed to allocate processing pipeline\n");
+        return false;
+    }
+
+    // Each queue can hold every slot plus the end marker
+    bool ok = iq_spsc_init(&pipeline->free_slots, slots);
+    for (uint32_t k = 0; k < n; k++) ok = ok && iq_spsc_init(&pipeline->to_fft[k], slots + 1);
+    for (uint32_t q = 0; q < n * m; q++) ok = ok && iq_spsc_init(&pipeline->to_cfar[q], slots + 1);
+    for (uint32_t j = 0; j < m; j++) ok = ok && iq_spsc_init(&pipeline->to_cluster[j], slots + 1);
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate pipeline queues\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < slots; i++) {
+        iqdetect_frame_t *slot = &pipeline->slots[i];
+        slot->samples = pipeline->sample_storage + (size_t)i * pipeline->frame_bytes;
+        slot->power = pipeline->power_storage + (size_t)i * config->fft_size;
+        iq_spsc_push(&pipeline->free_slots, slot);
+    }
+
+    for (uint32_t k = 0; k < n; k++) {
+        pipeline->fft[k].pipeline = pipeline;
+        pipeline->fft[k].index = k;
+    }
+    for (uint32_t j = 0; j < m; j++) {
+        pipeline->cfar[j].pipeline = pipeline;
+        pipeline->cfar[j].index = j;
+        // The 2-D and floor detectors live in the context, driven by worker 0 only
+        if (!ctx->use_2d_cfar && !ctx->use_floor_cfar && !init_frame_cfar(ctx, &pipeline->cfar[j].cfar_os,
+                                                  &pipeline->cfar[j].cfar_ca)) {
+            fprintf(stderr, "Failed to initialize CFAR detector\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Start CFAR workers, then FFT workers, then the reader
+static bool pipeline_start(iqdetect_pipeline_t *pipeline) {
+    for (uint32_t j = 0; j < pipeline->cfar_workers; j++) {
+        iqdetect_worker_t *worker = &pipeline->cfar[j];
+        if (pthread_create(&worker->thread, NULL, pipeline_cfar_worker, worker) != 0) return false;
+        worker->started = true;
+    }
+    for (uint32_t k = 0; k < pipeline->fft_workers; k++) {
+        iqdetect_worker_t *worker = &pipeline->fft[k];
+        if (pthread_create(&worker->thread, NULL, pipeline_fft_worker, worker) != 0) return false;
+        worker->started = true;
+    }
+    if (pthread_create(&pipeline->reader, NULL, pipeline_reader, pipeline) != 0) return false;
+    pipeline->reader_started = true;
+    return true;
+}
+
+static bool process_iq_data_pipelined(iqdetect_context_t *ctx) {
+    iqdetect_config_t *config = ctx->config;
+
+    iqdetect_pipeline_t pipeline;
+    if (!pipeline_init(&pipeline, ctx)) {
+        pipeline_free(&pipeline);
+        return false;
+    }
+    if (!pipeline_start(&pipeline)) {
+        fprintf(stderr, "Failed to start pipeline threads\n");
+        pipeline_stop(&pipeline);
+        pipeline_free(&pipeline);
+        return false;
+    }
+
+    uint64_t num_frames = 0;
+    uint64_t total_detections = 0;
+
+    // Clustering stage: frames in stream order, alternating over CFAR workers
+    for (uint64_t index = 0; ; index++) {
+        iqdetect_frame_t *frame = pipeline_pop(&pipeline.to_cluster[index % pipeline.cfar_workers]);
+        if (!frame) break;
+
+        if (!frame->fft_ok) {
+            fprintf(stderr, "FFT execution failed at frame %llu\n", (unsigned long long)num_frames);
+        } else {
+            total_detections += frame->num_detections;
+            cluster_frame(ctx, frame->detections, frame->num_detections,
+                          frame->detection_offset, num_frames);
+            num_frames++;
+        }
+        iq_spsc_push(&pipeline.free_slots, frame);
+        iq_alloc_guard(true);
+    }
+    iq_alloc_guard(false);
+
+    pipeline_stop(&pipeline);
+    if (!ctx->use_2d_cfar && !ctx->use_floor_cfar) report_incremental(ctx, &pipeline.cfar[0].cfar_os);
+    pipeline_free(&pipeline);
+
+    // Close out everything still open at the end of the stream
+    cluster_advance(&ctx->cluster_engine, INFINITY);
+    finish_events(ctx);
+
+    report_gate(ctx);
+    if (config->verbose) {
+        printf("Processing complete (%u FFT, %u CFAR threads):\n",
+               config->threads, config->cfar_threads);
+        printf("  Frames processed: %llu\n", (unsigned long long)num_frames);
+        printf("  Total detections: %llu\n", (unsigned long long)total_detections);
+        printf("  Events extracted: %llu\n", (unsigned long long)ctx->events_written);
+    }
+
+    return true;
+}
+
+/*
+ * Batch processing
+ *
+ * The list is read up front and every input mapped to <out>/<name>.<format>,
+ * <name> being the file name without its extension. Each worker owns one
+ * context, initialized once on the main thread, and claims the next
+ * unprocessed entry through an atomic counter, so long and short captures
+ * balance across the pool. Between files open_input() rebinds the sample
+ * block and close_input() clears the detector, tracker and cluster state,
+ * so each log holds exactly the events of a single-file run.
+ */
+
+typedef struct {
+    char **inputs;              // Input paths, in list order
+    char **outputs;             // Matching event log paths
+    uint32_t num_files;
+    uint32_t capacity;          // Allocated entries in inputs/outputs
+    atomic_uint next_file;      // Next unclaimed entry
+} iqdetect_batch_t;
+
+typedef struct {
+    iqdetect_context_t ctx;     // Reused for every file this worker takes
+    iqdetect_batch_t *batch;
+    pthread_t thread;
+    bool started;               // Runs on its own thread (worker 0 is the main thread)
+    uint32_t files_done;
+    uint32_t files_failed;
+    uint64_t events;
+} iqdetect_batch_worker_t;
+
+// <out_dir>/<input file name without extension>.<ext>, malloc'd
+static char *batch_output_path(const char *out_dir, const char *input, const char *ext) {
+    const char *name = input;
+    for (const char *c = input; *c; c++) {
+        if (*c == '/' || *c == '\\') name = c + 1;
+    }
+    const char *dot = strrchr(name, '.');
+    size_t name_len = dot && dot != name ? (size_t)(dot - name) : strlen(name);
+
+    size_t dir_len = strlen(out_dir);
+    bool has_sep = dir_len > 0 && (out_dir[dir_len - 1] == '/' || out_dir[dir_len - 1] == '\\');
+    size_t size = dir_len + 1 + name_len + 1 + strlen(ext) + 1;
+    char *path = malloc(size);
+    if (path) {
+        snprintf(path, size, "%s%s%.*s.%s", out_dir, has_sep ? "" : "/", (int)name_len, name, ext);
+    }
+    return path;
+}
+
+static void batch_free(iqdetect_batch_t *batch) {
+    for (uint32_t i = 0; i < batch->num_files; i++) {
+        free(batch->inputs[i]);
+        free(batch->outputs[i]);
+    }
+    free(batch->inputs);
+    free(batch->outputs);
+    memset(batch, 0, sizeof(*batch));
+}
+
+// Read the input list and derive each event log path
+static bool batch_load(iqdetect_batch_t *batch, const iqdetect_config_t *config) {
+    memset(batch, 0, sizeof(*batch));
+    atomic_init(&batch->next_file, 0);
+
+    FILE *list = fopen(config->inputs_file, "r");
+    if (!list) {
+        fprintf(stderr, "Failed to open input list: %s\n", config->inputs_file);
+        return false;
+    }
+
+    const char *ext = strcmp(config->output_format, "jsonl") == 0 ? "jsonl" :
+                      strcmp(config->output_format, "sigmf") == 0 ? "sigmf-meta" :
+                      strcmp(config->output_format, "iqev") == 0 ? "iqev" : "csv";
+    char line[4096];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), list)) {
+        // Trim surrounding whitespace; skip blank lines and comments
+        char *path = line;
+        while (*path == ' ' || *path == '\t') path++;
+        size_t len = strlen(path);
+        while (len > 0 && (path[len - 1] == '\n' || path[len - 1] == '\r' ||
+                           path[len - 1] == ' ' || path[len - 1] == '\t')) {
+            path[--len] = '\0';
+        }
+        if (len == 0 || path[0] == '#') continue;
+
+        if (batch->num_files == batch->capacity) {
+            uint32_t capacity = batch->capacity ? 2 * batch->capacity : 64;
+            char **inputs = realloc(batch->inputs, capacity * sizeof(char *));
+            if (inputs) batch->inputs = inputs;
+            char **outputs = realloc(batch->outputs, capacity * sizeof(char *));
+            if (outputs) batch->outputs = outputs;
+            if (!inputs || !outputs) {
+                fprintf(stderr, "Memory allocation failed for input list\n");
+                ok = false;
+                break;
+            }
+            batch->capacity = capacity;
+        }
+
+        char *input = malloc(len + 1);
+        char *output = batch_output_path(config->output_file, path, ext);
+        if (!input || !output) {
+            fprintf(stderr, "Memory allocation failed for input list\n");
+            free(input);
+            free(output);
+            ok = false;
+            break;
+        }
+        memcpy(input, path, len + 1);
+        batch->inputs[batch->num_files] = input;
+        batch->outputs[batch->num_files] = output;
+        batch->num_files++;
+    }
+    fclose(list);
+
+    // Two inputs with the same name would overwrite each other's log
+    for (uint32_t i = 0; ok && i < batch->num_files; i++) {
+        for (uint32_t j = i + 1; j < batch->num_files; j++) {
+            if (strcmp(batch->outputs[i], batch->outputs[j]) == 0) {
+                fprintf(stderr, "Inputs %s and %s would both write %s\n",
+                        batch->inputs[i], batch->inputs[j], batch->outputs[i]);
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    if (ok && batch->num_files == 0) {
+        fprintf(stderr, "No inputs listed in %s\n", config->inputs_file);
+        ok = false;
+    }
+    return ok;
+}
+
+// Create the batch output directory if it does not exist
+static bool create_output_directory(const char *dir_path) {
+    struct stat st;
+    if (stat(dir_path, &st) == 0) {
+        if (S_ISDIR(st.st_mode)) {
+            return true;
+        }
+        fprintf(stderr, "Output path exists but is not a directory: %s\n", dir_path);
+        return false;
+    }
+
+#ifdef _WIN32
+    if (mkdir(dir_path) != 0) {
+#else
+    if (mkdir(dir_path, 0755) != 0) {
+#endif
+        fprintf(stderr, "Failed to create output directory %s: %s\n", dir_path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Worker loop: claim files until the list is exhausted
+static void *batch_worker(void *arg) {
+    iqdetect_batch_worker_t *worker = arg;
+    iqdetect_batch_t *batch = worker->batch;
+    iqdetect_context_t *ctx = &worker->ctx;
+
+    for (;;) {
+        uint32_t index = atomic_fetch_add_explicit(&batch->next_file, 1, memory_order_relaxed);
+        if (index >= batch->num_files) break;
+
+        // Every processed file gets a log, even one without events
+        bool ok = open_input(ctx, batch->inputs[index], batch->outputs[index]) &&
+                  process_iq_data(ctx) &&
+                  open_events_file(ctx);
+        if (ok) {
+            worker->files_done++;
+            worker->events += ctx->events_written;
+            if (ctx->config->verbose) {
+                printf("%s -> %s: %llu events\n", batch->inputs[index], batch->outputs[index],
+                       (unsigned long long)ctx->events_written);
+            }
+        } else {
+            worker->files_failed++;
+            fprintf(stderr, "Signal detection failed: %s\n", batch->inputs[index]);
+        }
+        close_input(ctx);
+    }
+    return NULL;
+}
+
+static bool process_batch(iqdetect_config_t *config) {
+    iqdetect_batch_t batch;
+    if (!batch_load(&batch, config) || !create_output_directory(config->output_file)) {
+        batch_free(&batch);
+        return false;
+    }
+
+    uint32_t num_workers = config->jobs < batch.num_files ? config->jobs : batch.num_files;
+    iqdetect_batch_worker_t *workers = calloc(num_workers, sizeof(iqdetect_batch_worker_t));
+    bool ok = workers != NULL;
+    if (!ok) {
+        fprintf(stderr, "Memory allocation failed for batch workers\n");
+    }
+
+    // Contexts are built up front, so plan and window setup happen once per
+    // worker and a bad configuration fails before any file is touched
+    for (uint32_t w = 0; ok && w < num_workers; w++) {
+        workers[w].batch = &batch;
+        if (!initialize_context(&workers[w].ctx, config)) {
+            fprintf(stderr, "Failed to initialize detection context\n");
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        // Worker 0 runs on this thread; a worker that fails to start simply
+        // leaves its share of the list to the others
+        for (uint32_t w = 1; w < num_workers; w++) {
+            workers[w].started = pthread_create(&workers[w].thread, NULL, batch_worker, &workers[w]) == 0;
+            if (!workers[w].started) {
+                fprintf(stderr, "Warning: Failed to start batch worker %u\n", w);
+            }
+        }
+        batch_worker(&workers[0]);
+        for (uint32_t w = 1; w < num_workers; w++) {
+            if (workers[w].started) {
+                pthread_join(workers[w].thread, NULL);
+            }
+        }
+    }
+
+    uint32_t files_done = 0, files_failed = 0;
+    uint64_t events = 0;
+    for (uint32_t w = 0; workers && w < num_workers; w++) {
+        files_done += workers[w].files_done;
+        files_failed += workers[w].files_failed;
+        events += workers[w].events;
+        cleanup_context(&workers[w].ctx);
+    }
+    free(workers);
+
+    if (ok) {
+        printf("Batch complete: %u of %u files processed, %llu events, %u failed\n",
+               files_done, batch.num_files, (unsigned long long)events, files_failed);
+    }
+    batch_free(&batch);
+    return ok && files_failed == 0;
+}
+
+// File names a capture recorder writes samples to (not logs or sidecars)
+static bool follow_is_segment(const char *name) {
+    static const char *const extensions[] = {
+        ".iq", ".raw", ".bin", ".s8", ".s16", ".s12", ".s4", ".iq8", ".iq16", ".iq12",
+        ".iq4", ".cs8", ".cs16", ".cs12", ".cs4", ".wav", ".WAV", ".iqz", ".sigmf-data",
+    };
+    if (name[0] == '.') return false;
+    const char *ext = strrchr(name, '.');
+    for (size_t i = 0; ext && i < sizeof(extensions) / sizeof(extensions[0]); i++) {
+        if (strcmp(ext, extensions[i]) == 0) return true;
+    }
+    return false;
+}
+
+/*
+ * First segment named after 'last' in 'dir' (into 'next'), and whether a
+ * later one exists too. Only the two names are kept, so a directory that
+ * grows for weeks costs no memory.
+ */
+static bool follow_scan(const char *dir, const char *last, char *next, size_t next_size, bool *later) {
+    next[0] = '\0';
+    *later = false;
+    const char *name;
+#ifdef _WIN32
+    char pattern[1024];
+    snprintf(pattern, sizeof(pattern), "%s\\*", dir);
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA(pattern, &found);
+    if (search == INVALID_HANDLE_VALUE) return false;
+    do {
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        name = found.cFileName;
+#else
+    DIR *handle = opendir(dir);
+    if (!handle) return false;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        name = entry->d_name;
+#endif
+        if (!follow_is_segment(name) || strcmp(name, last) <= 0) continue;
+        if (next[0] == '\0' || strcmp(name, next) < 0) {
+            *later = *later || next[0] != '\0';
+            snprintf(next, next_size, "%s", name);
+        } else {
+            *later = true;
+        }
+#ifdef _WIN32
+    } while (FindNextFileA(search, &found));
+    FindClose(search);
+#else
+    }
+    closedir(handle);
+#endif
+    return next[0] != '\0';
+}
+
+// Newest segment seen while it may still be written
+typedef struct {
+    char name[512];
+    long long size;
+    time_t mtime;
+    time_t unchanged_since;
+} iqdetect_follow_t;
+
+// Next completed segment after follow->last (its path into 'path'), if any
+static bool follow_next(const char *dir, const char *last, iqdetect_follow_t *pending,
+                        char *path, size_t path_size) {
+    char name[512];
+    bool later;
+    if (!follow_scan(dir, last, name, sizeof(name), &later)) {
+        return false;
+    }
+    snprintf(path, path_size, "%s/%s", dir, name);
+    if (later) {
+        return true; // The recorder has moved on to the next one
+    }
+
+    // The newest: complete once it has stopped growing for a while
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    time_t now = time(NULL);
+    if (strcmp(pending->name, name) != 0 || pending->size != (long long)st.st_size ||
+        pending->mtime != st.st_mtime) {
+        snprintf(pending->name, sizeof(pending->name), "%s", name);
+        pending->size = (long long)st.st_size;
+        pending->mtime = st.st_mtime;
+        pending->unchanged_since = now;
+        return false;
+    }
+    return now - pending->unchanged_since >= IQDETECT_FOLLOW_SETTLE_S;
+}
+
+static void follow_sleep(void) {
+#ifdef _WIN32
+    Sleep(IQDETECT_FOLLOW_POLL_MS);
+#else
+    struct timespec ts = {IQDETECT_FOLLOW_POLL_MS / 1000, (IQDETECT_FOLLOW_POLL_MS % 1000) * 1000000L};
+    nanosleep(&ts, NULL);  // A stop signal cuts it short
+#endif
+}
+
+/*
+ * Daemon mode: every segment that completes in the directory, in name
+ * order, through one context. The block continues from segment to segment
+ * and nothing is reset in between, so detections, clusters and the noise
+ * floor see one stream and its clock; events are written as they close.
+ */
+static bool process_follow(iqdetect_config_t *config) {
+    iqdetect_context_t ctx;
+    if (!initialize_context(&ctx, config)) {
+        fprintf(stderr, "Failed to initialize detection context\n");
+        cleanup_context(&ctx);
+        return false;
+    }
+    ctx.output_file = config->output_file;
+    ctx.segmented = true;
+    ctx.live = true;
+    catch_stop_signals(true);
+
+    char last[512] = "";
+    char path[1024];
+    iqdetect_follow_t pending;
+    memset(&pending, 0, sizeof(pending));
+    bool started = false;
+    uint64_t segments = 0, skipped = 0;
+    while (!stop_requested) {
+        if (!follow_next(config->follow_dir, last, &pending, path, sizeof(path))) {
+            follow_sleep();
+            continue;
+        }
+        snprintf(last, sizeof(last), "%s", path + strlen(config->follow_dir) + 1);
+
+        bool ok;
+        if (!started) {
+            ok = started = open_input(&ctx, path, config->output_file);
+        } else {
+            ok = iq_reader_open(&ctx.reader, path) && iq_block_continue(&ctx.block, &ctx.reader);
+        }
+        if (ok && process_iq_data(&ctx)) {
+            segments++;
+            if (config->verbose) {
+                printf("%s: stream at %.3f s, %llu events\n", path, ctx.stream_time_s,
+                       (unsigned long long)ctx.events_written);
+            }
+        } else {
+            // Its samples are left out of the stream and its clock
+            skipped++;
+            fprintf(stderr, "Skipping segment %s\n", path);
+        }
+        iq_reader_close(&ctx.reader);
+    }
+
+    // Close out the events still open at the stop
+    ctx.segmented = false;
+    uint64_t scan_frames_done = 0;
+    finish_scan(&ctx, &scan_frames_done);
+    cluster_advance(&ctx.cluster_engine, INFINITY);
+    catch_stop_signals(false);
+    uint64_t events = ctx.events_written;
+    cleanup_context(&ctx);
+
+    printf("Follow stopped: %llu segments, %llu events, %llu skipped\n",
+           (unsigned long long)segments, (unsigned long long)events, (unsigned long long)skipped);
+    return true;
+}
+
+// Write one event as a SigMF annotation: sample span from the stream
+// start, absolute band edges when the centre frequency is known
+static bool write_event_sigmf(const cluster_event_t *event, iqdetect_context_t *ctx) {
+    if (!open_events_file(ctx)) {
+        return false;
+    }
+
+    double rate = (double)ctx->sample_rate;
+    uint64_t start = event->start_time_s > 0.0 ? (uint64_t)(event->start_time_s * rate) : 0;
+    uint64_t count = event->duration_s > 0.0 ? (uint64_t)(event->duration_s * rate) : 0;
+    double centre = (double)ctx->sigmf_meta.global.frequency;
+    double lower = centre + event->center_freq_hz - event->bandwidth_hz / 2.0;
+    double upper = centre + event->center_freq_hz + event->bandwidth_hz / 2.0;
+    bool band = centre > 0.0 && lower >= 0.0;
+
+    sigmf_annotation_t annotation = {0};
+    annotation.sample_start = start;
+    annotation.sample_count = count;
+    annotation.freq_lower_edge = band ? (uint64_t)lower : 0;
+    annotation.freq_upper_edge = band ? (uint64_t)upper : 0;
+    snprintf(annotation.label, sizeof(annotation.label), "%s",
+             event->modulation_guess ? event->modulation_guess : "unknown");
+    snprintf(annotation.description, sizeof(annotation.description),
+             "f_center_Hz=%.3f bw_Hz=%.3f snr_dB=%.2f peak_dBFS=%.2f confidence_0_1=%.3f",
+             event->center_freq_hz, event->bandwidth_hz, event->peak_snr_db,
+             event->peak_power_dbfs, event->confidence);
+    return sigmf_writer_write_annotation(ctx->events_sigmf, &annotation);
+}
+
+// Add one event to the binary columnar log; blocks go out as they fill
+static bool write_event_log(const cluster_event_t *event, iqdetect_context_t *ctx) {
+    if (!open_events_file(ctx)) {
+        return false;
+    }
+    return event_log_append(ctx->events_log, event);
+}
+
+// Rolling logs: close the open one once the stream has moved into the next period
+static void rotate_events_file(iqdetect_context_t *ctx) {
+    double period = ctx->config->rotate_s;
+    if (period <= 0.0) {
+        return;
+    }
+    uint64_t rotation = (uint64_t)(ctx->stream_time_s / period);
+    if (rotation != ctx->rotation) {
+        close_events_file(ctx);
+        ctx->rotation = rotation;
+    }
+}
+
+// Cluster event sink: write each event as soon as it completes
+static void emit_event(const cluster_event_t *event, void *user) {
+    iqdetect_context_t *ctx = user;
+
+    // Opening and rotating logs may allocate
+    bool guarded = iq_alloc_guard(false);
+    uint64_t t = iq_profile_begin();
+    rotate_events_file(ctx);
+    const char *format = ctx->config->output_format;
+    bool ok = strcmp(format, "jsonl") == 0 ? write_events_jsonl(event, 1, ctx) :
+              strcmp(format, "sigmf") == 0 ? write_event_sigmf(event, ctx) :
+              strcmp(format, "iqev") == 0 ? write_event_log(event, ctx) :
+              write_events_csv(event, 1, ctx);
+    if (ok && ctx->live && ctx->events_file) {
+        fflush(ctx->events_file);
+    }
+    iq_profile_end(IQ_PROFILE_ENCODE, t, 1, 0);
+    if (ok) {
+        ctx->events_written++;
+    }
+    if (ctx->config->verbose) {
+        printf("Event %llu: %.6f - %.6f s\n", (unsigned long long)ctx->events_written,
+               event->start_time_s, event->end_time_s);
+    }
+    iq_alloc_guard(guarded);
+}
+
+// Cluster event sink with --iq-features: the pool passes events on to emit_event()
+static void queue_event(const cluster_event_t *event, void *user) {
+    iqdetect_context_t *ctx = user;
+    event_features_submit(ctx->event_features, event);
+}
+
+// End of the stream: write the events still in the feature pool
+static void finish_events(iqdetect_context_t *ctx) {
+    if (!ctx->event_features) return;
+    event_features_flush(ctx->event_features);
+    event_features_t *pool = ctx->event_features;
+    printf("IQ features: %llu of %llu events classified from their samples, %llu by cyclic features\n",
+           (unsigned long long)pool->classified, (unsigned long long)pool->emitted,
+           (unsigned long long)pool->refined);
+}
+
+// <out stem>.<rotation>.<ext> for rolling logs (--rotate), else the output path
+static const char *events_path(iqdetect_context_t *ctx) {
+    if (ctx->config->rotate_s <= 0.0) {
+        return ctx->output_file;
+    }
+
+    const char *path = ctx->output_file;
+    const char *name = path;
+    for (const char *c = path; *c; c++) {
+        if (*c == '/' || *c == '\\') name = c + 1;
+    }
+    const char *ext = strstr(name, ".sigmf-meta");
+    if (!ext) ext = strrchr(name, '.');
+    if (!ext || ext == name) ext = name + strlen(name);
+    snprintf(ctx->rotated_path, sizeof(ctx->rotated_path), "%.*s.%06llu%s",
+             (int)(ext - path), path, (unsigned long long)ctx->rotation, ext);
+    return ctx->rotated_path;
+}
+
+// SigMF events: the stream's global fields, one capture, then annotations
+static bool open_events_sigmf(iqdetect_context_t *ctx, const char *path) {
+    sigmf_datatype_t datatype = ctx->reader.format == IQ_FORMAT_S8 ? SIGMF_DATATYPE_CI8 :
+                                ctx->reader.format == IQ_FORMAT_S12 ? SIGMF_DATATYPE_CI12 :
+                                ctx->reader.format == IQ_FORMAT_S4 ? SIGMF_DATATYPE_CI4 :
+                                SIGMF_DATATYPE_CI16;
+    char datetime[32];
+    sigmf_get_current_datetime(datetime, sizeof(datetime));
+
+    sigmf_metadata_t meta;
+    sigmf_create_basic_metadata(&meta, sigmf_datatype_to_string(datatype), ctx->sample_rate,
+                                ctx->sigmf_meta.global.frequency, "Detected events", "iqdetect");
+    bool ok = sigmf_add_capture(&meta, 0, ctx->sigmf_meta.global.frequency, datetime);
+    ctx->events_sigmf = ok ? sigmf_writer_open(path, &meta) : NULL;
+    sigmf_free_metadata(&meta);
+    return ctx->events_sigmf != NULL;
+}
+
+// Open the event log if needed; CSV logs start with the header, JSONL appends
+static bool open_events_file(iqdetect_context_t *ctx) {
+    if (ctx->events_file || ctx->events_sigmf || ctx->events_log) {
+        return true;
+    }
+
+    const char *path = events_path(ctx);
+    if (strcmp(ctx->config->output_format, "sigmf") == 0) {
+        if (!open_events_sigmf(ctx, path)) {
+            fprintf(stderr, "Failed to open output file: %s\n", path);
+            return false;
+        }
+        return true;
+    }
+    if (strcmp(ctx->config->output_format, "iqev") == 0) {
+        ctx->events_log = event_log_create(path, 0);
+        return ctx->events_log != NULL;
+    }
+
+    bool jsonl = strcmp(ctx->config->output_format, "jsonl") == 0;
+    ctx->events_file = fopen(path, jsonl ? "a" : "w");
+    if (!ctx->events_file) {
+        fprintf(stderr, "Failed to open output file: %s\n", path);
+        return false;
+    }
+    if (!jsonl) {
+        fprintf(ctx->events_file, "t_start_s,t_end_s,f_center_Hz,bw_Hz,snr_dB,peak_dBFS,modulation_guess,confidence_0_1,tags\n");
+    }
+    return true;
+}
+
+// Write events in CSV format
+static bool write_events_csv(const cluster_event_t *events, uint32_t num_events,
+                           iqdetect_context_t *ctx) {
+    // Header goes out with the first event
+    if (!open_events_file(ctx)) {
+        return false;
+    }
+    FILE *file = ctx->events_file;
 
     // Write events
     for (uint32_t i = 0; i < num_events; i++) {
@@ -546,20 +2747,16 @@ static bool write_events_csv(const cluster_event_t *events, uint32_t num_events,
                 event->confidence);
     }
 
-    fclose(file);
     return true;
 }
 
 // Write events in JSONL format
 static bool write_events_jsonl(const cluster_event_t *events, uint32_t num_events,
                              iqdetect_context_t *ctx) {
-    iqdetect_config_t *config = ctx->config;
-
-    FILE *file = fopen(config->output_file, "a");
-    if (!file) {
-        fprintf(stderr, "Failed to open output file: %s\n", config->output_file);
+    if (!open_events_file(ctx)) {
         return false;
     }
+    FILE *file = ctx->events_file;
 
     // Write events as JSON objects
     for (uint32_t i = 0; i < num_events; i++) {
@@ -574,7 +2771,6 @@ static bool write_events_jsonl(const cluster_event_t *events, uint32_t num_event
                 event->confidence);
     }
 
-    fclose(file);
     return true;
 }
 
@@ -589,11 +2785,11 @@ __attribute__((unused)) static bool generate_iq_cutout(const cluster_event_t *ev
     uint64_t end_sample = (uint64_t)((event->end_time_s + padding_seconds) * config->sample_rate);
 
     // Ensure bounds are within the original file
-    if (start_sample >= ctx->iq_data.num_samples) {
+    if (start_sample >= ctx->reader.total_samples) {
         return false; // Event starts after end of file
     }
-    if (end_sample >= ctx->iq_data.num_samples) {
-        end_sample = ctx->iq_data.num_samples - 1;
+    if (end_sample >= ctx->reader.total_samples) {
+        end_sample = ctx->reader.total_samples - 1;
     }
     if (start_sample >= end_sample) {
         start_sample = 0; // Start from beginning if padding goes negative
@@ -607,8 +2803,8 @@ __attribute__((unused)) static bool generate_iq_cutout(const cluster_event_t *ev
 
     // Create new IQ data structure for cutout
     iq_data_t cutout = {0};
-    cutout.sample_rate = ctx->iq_data.sample_rate;
-    cutout.format = ctx->iq_data.format; // Use same format as input
+    cutout.sample_rate = ctx->sample_rate;
+    cutout.format = ctx->reader.format; // Use same format as input
     cutout.num_samples = end_sample - start_sample + 1;
     cutout.data = malloc(cutout.num_samples * 2 * sizeof(float));
 
@@ -616,12 +2812,19 @@ __attribute__((unused)) static bool generate_iq_cutout(const cluster_event_t *ev
         return false;
     }
 
-    // Copy IQ samples with padding
-    for (uint64_t i = start_sample; i <= end_sample; i++) {
-        uint64_t src_idx = i * 2;
-        uint64_t dst_idx = (i - start_sample) * 2;
-        cutout.data[dst_idx] = ctx->iq_data.data[src_idx];         // I
-        cutout.data[dst_idx + 1] = ctx->iq_data.data[src_idx + 1]; // Q
+    // Read just the event span (with padding) through a second reader
+    iq_reader_t range_reader;
+    if (!iq_reader_open(&range_reader, ctx->input_file)) {
+        free(cutout.data);
+        return false;
+    }
+    bool range_ok = iq_reader_skip(&range_reader, start_sample) &&
+                    iq_reader_refill(&range_reader, cutout.data, 0, 0, cutout.num_samples) == cutout.num_samples;
+    iq_reader_close(&range_reader);
+
+    if (!range_ok) {
+        free(cutout.data);
+        return false;
     }
 
     // Save IQ cutout
@@ -673,3 +2876,9 @@ __attribute__((unused)) static bool generate_iq_cutout(const cluster_event_t *ev
 
     return true;
 }
+
+#ifndef IQ_TOOL_LIBRARY
+int main(int argc, char **argv) {
+    return iqdetect_main(argc, argv);
+}
+#endif
@@ -8,27 +8,40 @@
  *   statistics including RMS power, DC offset, duration, and metadata.
  *   Supports SigMF metadata for enhanced SDR recording analysis.
  *
+ *   By default only the header, the SigMF sidecar and the file size are
+ *   read; statistics are estimated from evenly spaced blocks, so a listing
+ *   costs the same for any file size. --full-stats streams every sample
+ *   on all CPUs instead. A fresh summary sidecar (<file>.iqsum, see
+ *   iq_summary.h) already holds the exact figures and a clip count and is
+ *   used instead of the samples; --summary writes one when it is missing
+ *   or stale.
+ *
  * INPUTS:
- *   - IQ data file: Raw IQ files (s8/s16) or WAV IQ recordings
- *   - Format specification: 's8' (8-bit) or 's16' (16-bit) IQ data
- *   - Sample rate: Sampling frequency in Hz (required)
+ *   - IQ data file: Raw IQ files (s8/s16/s12/s4) or WAV IQ recordings
+ *   - Format specification (optional): 's8', 's16', 's12' or 's4'
+ *   - Sample rate (optional): --rate, else the WAV/IQZ header or SigMF
  *   - Optional SigMF metadata: JSON sidecar file (.sigmf-meta)
  *
  * OUTPUTS:
  *   - JSON statistics report containing:
  *     * File information (format, sample rate, duration)
  *     * Signal statistics (RMS power in dBFS, DC offset I/Q)
+ *     * Clipped I/Q values (from the summary sidecar)
  *     * Noise floor estimation
  *     * SigMF metadata (if available)
  *
  * USAGE:
- *   ./iqinfo --in <input_file> --format {s8|s16} --rate <Hz> [--meta <meta_file>] [--verbose]
+ *   ./iqinfo --in <input_file> [--format {s8|s16|s12|s4}] [--rate <Hz>] [--meta <meta_file>]
+ *            [--full-stats] [--summary] [--threads <N>] [--verbose]
  *
  *   ARGUMENTS:
  *     --in <file>        : Input IQ file path (required)
- *     --format {s8|s16}  : IQ data format (required)
- *     --rate <Hz>        : Sample rate in Hz (required)
+ *     --format {s8|s16|s12|s4}  : IQ data format (default: detected)
+ *     --rate <Hz>        : Sample rate in Hz (default: header, SigMF, or 1 Msps)
  *     --meta <file>      : SigMF metadata file (optional)
+ *     --full-stats       : Exact statistics over every sample (optional)
+ *     --summary          : Build the summary sidecar if missing or stale (optional)
+ *     --threads <N>      : Threads for --full-stats and --summary (default: one per CPU)
  *     --verbose          : Enable verbose output (optional)
  *     --help             : Show help message
  *
@@ -42,12 +55,20 @@
  *   # Verbose analysis with detailed progress
  *   ./iqinfo --in capture.iq --format s8 --rate 1000000 --verbose
  *
+ *   # Exact statistics, streamed on 8 threads
+ *   ./iqinfo --in capture.iq --full-stats --threads 8
+ *
+ *   # Summarise once; later runs read capture.iq.iqsum instead of the samples
+ *   ./iqinfo --in capture.iq --summary
+ *
  * FEATURES:
  *   - Automatic SigMF metadata detection and parsing
  *   - RMS power calculation (dBFS - decibels relative to full scale)
  *   - DC offset measurement for I and Q components
  *   - JSON output format for easy integration
- *   - Support for large files with efficient processing
+ *   - Metadata-only probe with sampled statistics (default)
+ *   - Streaming, multi-threaded exact statistics (--full-stats)
+ *   - Cached exact statistics and clip counts from the summary sidecar
  *
  * =============================================================================
  */
@@ -59,6 +80,8 @@
 #include <math.h>
 #include "../src/iq_core/io_iq.h"
 #include "../src/iq_core/io_sigmf.h"
+#include "../src/iq_core/iq_stats.h"
+#include "../src/iq_core/iq_summary.h"
 
 // Command line arguments structure
 typedef struct {
@@ -66,6 +89,10 @@ typedef struct {
     const char *format_str;
     uint32_t sample_rate;
     const char *meta_file;
+    bool rate_given;
+    bool full_stats;
+    bool build_summary;
+    uint32_t threads;
     bool verbose;
 } iqinfo_args_t;
 
@@ -84,6 +111,9 @@ bool parse_args(int argc, char *argv[], iqinfo_args_t *args) {
         {"format", required_argument, 0, 'f'},
         {"rate", required_argument, 0, 'r'},
         {"meta", required_argument, 0, 'm'},
+        {"full-stats", no_argument, 0, 'F'},
+        {"summary", no_argument, 0, 's'},
+        {"threads", required_argument, 0, 'j'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
@@ -92,7 +122,7 @@ bool parse_args(int argc, char *argv[], iqinfo_args_t *args) {
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "i:f:r:m:vh", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "i:f:r:m:Fsj:vh", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'i':
                 args->input_file = optarg;
@@ -102,16 +132,26 @@ bool parse_args(int argc, char *argv[], iqinfo_args_t *args) {
                 break;
             case 'r':
                 args->sample_rate = (uint32_t)atoi(optarg);
+                args->rate_given = true;
                 break;
             case 'm':
                 args->meta_file = optarg;
                 break;
+            case 'F':
+                args->full_stats = true;
+                break;
+            case 's':
+                args->build_summary = true;
+                break;
+            case 'j':
+                args->threads = (uint32_t)atoi(optarg);
+                break;
             case 'v':
                 args->verbose = true;
                 break;
             case 'h':
             default:
-                fprintf(stderr, "Usage: %s --in <file.iq> --format {s8|s16} [--rate <Hz>] [--meta <file.sigmf-meta>]\n", argv[0]);
+                fprintf(stderr, "Usage: %s --in <file.iq> [--format {s8|s16|s12|s4}] [--rate <Hz>] [--meta <file.sigmf-meta>] [--full-stats] [--summary] [--threads <N>]\n", argv[0]);
                 fprintf(stderr, "Example: %s --in capture.iq --format s16 --rate 2000000\n", argv[0]);
                 return false;
         }
@@ -123,64 +163,15 @@ bool parse_args(int argc, char *argv[], iqinfo_args_t *args) {
         return false;
     }
 
-    if (!args->format_str) {
-        fprintf(stderr, "Error: Format is required (--format)\n");
-        return false;
-    }
-
-    if (strcmp(args->format_str, "s8") != 0 && strcmp(args->format_str, "s16") != 0) {
-        fprintf(stderr, "Error: Format must be 's8' or 's16'\n");
+    iq_format_t format;
+    if (args->format_str && !iq_parse_format(args->format_str, &format)) {
+        fprintf(stderr, "Error: Format must be 's8', 's16', 's12' or 's4'\n");
         return false;
     }
 
     return true;
 }
 
-/*
- * Calculate RMS (Root Mean Square) of IQ data
- * RMS represents the average power of the signal
- */
-double calculate_rms(const float *data, size_t num_samples) {
-    if (!data || num_samples == 0) {
-        return 0.0;
-    }
-
-    double sum_squares = 0.0;
-
-    // Sum of squares for both I and Q components
-    for (size_t i = 0; i < num_samples; i++) {
-        double i_val = (double)data[i * 2];     // I component
-        double q_val = (double)data[i * 2 + 1]; // Q component
-        sum_squares += (i_val * i_val) + (q_val * q_val);
-    }
-
-    // RMS = sqrt(average power)
-    // Total samples = num_samples * 2 (I + Q per sample)
-    return sqrt(sum_squares / (double)(num_samples * 2));
-}
-
-/*
- * Calculate DC offset (average value) for I and Q components
- */
-void calculate_dc_offset(const float *data, size_t num_samples, double *dc_i, double *dc_q) {
-    if (!data || num_samples == 0 || !dc_i || !dc_q) {
-        *dc_i = 0.0;
-        *dc_q = 0.0;
-        return;
-    }
-
-    double sum_i = 0.0;
-    double sum_q = 0.0;
-
-    for (size_t i = 0; i < num_samples; i++) {
-        sum_i += (double)data[i * 2];     // I component
-        sum_q += (double)data[i * 2 + 1]; // Q component
-    }
-
-    *dc_i = sum_i / (double)num_samples;
-    *dc_q = sum_q / (double)num_samples;
-}
-
 /*
  * Convert RMS to dBFS (decibels relative to full scale)
  * Full scale for float [-1,1] is 1.0
@@ -194,79 +185,113 @@ double rms_to_dbfs(double rms) {
 
 /*
  * Main processing function
- * Loads IQ file and computes statistics
+ * Probes the file (header, SigMF, size) and computes statistics
  */
 int process_iq_file(const iqinfo_args_t *args) {
-    iq_data_t iq_data = {0};
-
-    // Format will be auto-detected by iq_load_file
-    // The --format argument is kept for future compatibility
-
-    if (args->verbose) {
-        printf("Loading IQ file: %s (format: %s, rate: %u Hz)\n",
-               args->input_file, args->format_str, args->sample_rate);
-    }
-
-    // Load IQ file
-    if (!iq_load_file(args->input_file, &iq_data)) {
-        fprintf(stderr, "Error: Failed to load IQ file '%s'\n", args->input_file);
+    // Opening a reader parses the WAV/IQZ header and sizes raw files; no samples are read
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, args->input_file)) {
+        fprintf(stderr, "Error: Failed to open IQ file '%s'\n", args->input_file);
         return EXIT_FAILURE;
     }
-
-    // Set sample rate (could be overridden by SigMF metadata later)
-    iq_data.sample_rate = args->sample_rate;
-
-    if (args->verbose) {
-        printf("Loaded %zu complex samples (%.3f seconds at %u Hz)\n",
-               iq_data.num_samples,
-               (double)iq_data.num_samples / (double)args->sample_rate,
-               args->sample_rate);
-    }
-
-    // Calculate statistics
-    double rms = calculate_rms(iq_data.data, iq_data.num_samples);
-    double rms_dbfs = rms_to_dbfs(rms);
-
-    double dc_i, dc_q;
-    calculate_dc_offset(iq_data.data, iq_data.num_samples, &dc_i, &dc_q);
-
-    double duration_s = (double)iq_data.num_samples / (double)args->sample_rate;
+    uint64_t num_samples = reader.total_samples;
+    uint32_t header_rate = reader.sample_rate;
+    const char *format_str = args->format_str ? args->format_str : iq_format_name(reader.format);
+    iq_reader_close(&reader);
 
     // Try to load SigMF metadata if available
     sigmf_metadata_t sigmf_meta = {0};
     bool has_sigmf = false;
 
-    if (sigmf_meta_file_exists(args->input_file)) {
+    // An explicit --meta wins over the sidecar next to the input
+    char meta_filename[512] = "";
+    if (args->meta_file) {
+        snprintf(meta_filename, sizeof(meta_filename), "%s", args->meta_file);
+    } else if (sigmf_meta_file_exists(args->input_file)) {
+        sigmf_get_meta_filename(args->input_file, meta_filename, sizeof(meta_filename));
+    }
+
+    if (meta_filename[0]) {
         if (args->verbose) {
-            char meta_filename[512];
-            sigmf_get_meta_filename(args->input_file, meta_filename, sizeof(meta_filename));
             printf("Loading SigMF metadata: %s\n", meta_filename);
         }
 
-        has_sigmf = sigmf_read_metadata(args->input_file, &sigmf_meta);
+        has_sigmf = sigmf_read_metadata(meta_filename, &sigmf_meta);
 
         if (has_sigmf && args->verbose) {
             printf("SigMF metadata loaded successfully\n");
             printf("  Version: %s\n", sigmf_meta.global.version);
             printf("  Datatype: %s\n", sigmf_meta.global.datatype);
-            printf("  Sample rate: %llu Hz\n", sigmf_meta.global.sample_rate);
-            printf("  Center frequency: %llu Hz\n", sigmf_meta.global.frequency);
+            printf("  Sample rate: %llu Hz\n", (unsigned long long)sigmf_meta.global.sample_rate);
+            printf("  Center frequency: %llu Hz\n", (unsigned long long)sigmf_meta.global.frequency);
             printf("  Description: %s\n", sigmf_meta.global.description);
             printf("  Author: %s\n", sigmf_meta.global.author);
             printf("  Captures: %zu\n", sigmf_meta.num_captures);
         }
     }
 
+    // --rate wins, then the file header, then SigMF, then the 1 Msps default
+    uint32_t sample_rate = args->sample_rate;
+    if (!args->rate_given) {
+        if (header_rate > 0) {
+            sample_rate = header_rate;
+        } else if (has_sigmf && sigmf_meta.global.sample_rate > 0) {
+            sample_rate = (uint32_t)sigmf_meta.global.sample_rate;
+        }
+    }
+
+    if (args->verbose) {
+        printf("Probed IQ file: %s (format: %s, rate: %u Hz, %llu complex samples)\n",
+               args->input_file, format_str, sample_rate, (unsigned long long)num_samples);
+    }
+
+    // A fresh sidecar answers from its header; --summary (re)builds it first
+    iq_summary_params_t summary_params;
+    iq_summary_default_params(&summary_params);
+    summary_params.sample_rate = sample_rate;
+    summary_params.num_threads = args->threads;
+    iq_summary_t summary;
+    bool has_summary = iq_summary_open(args->input_file, true, args->build_summary, &summary_params, &summary);
+
+    // Otherwise a sampled estimate by default; --full-stats streams every sample
+    iq_stats_t stats;
+    bool stats_ok = true;
+    if (has_summary) {
+        stats = summary.stats;
+    } else {
+        if (args->verbose) {
+            printf("Computing %s statistics...\n", args->full_stats ? "full" : "sampled");
+        }
+        stats_ok = args->full_stats
+            ? iq_stats_full(args->input_file, args->threads, &stats)
+            : iq_stats_sampled(args->input_file, IQ_STATS_SAMPLED_BLOCKS, IQ_STATS_SAMPLED_BLOCK_SAMPLES, &stats);
+    }
+    if (!stats_ok) {
+        fprintf(stderr, "Error: Failed to read IQ file '%s'\n", args->input_file);
+        sigmf_free_metadata(&sigmf_meta);
+        return EXIT_FAILURE;
+    }
+
+    double rms_dbfs = rms_to_dbfs(stats.rms);
+    double duration_s = sample_rate ? (double)num_samples / (double)sample_rate : 0.0;
+
     // Output JSON result
     printf("{\n");
     printf("  \"input_file\": \"%s\",\n", args->input_file);
-    printf("  \"format\": \"%s\",\n", args->format_str);
-    printf("  \"sample_rate\": %u,\n", args->sample_rate);
+    printf("  \"format\": \"%s\",\n", format_str);
+    printf("  \"sample_rate\": %u,\n", sample_rate);
     printf("  \"duration_s\": %.6f,\n", duration_s);
-    printf("  \"num_samples\": %zu,\n", iq_data.num_samples);
+    printf("  \"num_samples\": %llu,\n", (unsigned long long)num_samples);
+    printf("  \"stats_mode\": \"%s\",\n",
+           has_summary ? "summary" : stats.samples_used == stats.total_samples ? "full" : "sampled");
+    printf("  \"stats_samples\": %llu,\n", (unsigned long long)stats.samples_used);
+    if (has_summary) {
+        printf("  \"clipped_values\": %llu,\n", (unsigned long long)summary.clipped);
+    }
     printf("  \"rms_dBFS\": %.2f,\n", rms_dbfs);
-    printf("  \"dc_offset_I\": %.6f,\n", dc_i);
-    printf("  \"dc_offset_Q\": %.6f,\n", dc_q);
+    printf("  \"peak_dBFS\": %.2f,\n", rms_to_dbfs(stats.peak));
+    printf("  \"dc_offset_I\": %.6f,\n", stats.dc_i);
+    printf("  \"dc_offset_Q\": %.6f,\n", stats.dc_q);
     printf("  \"estimated_noise_floor_dBFS\": %.2f,\n", rms_dbfs - 10.0); // Rough estimate
 
     // Add SigMF metadata to JSON output
@@ -274,8 +299,8 @@ int process_iq_file(const iqinfo_args_t *args) {
         printf("  \"sigmf_metadata\": {\n");
         printf("    \"version\": \"%s\",\n", sigmf_meta.global.version);
         printf("    \"datatype\": \"%s\",\n", sigmf_meta.global.datatype);
-        printf("    \"sample_rate\": %llu,\n", sigmf_meta.global.sample_rate);
-        printf("    \"frequency\": %llu,\n", sigmf_meta.global.frequency);
+        printf("    \"sample_rate\": %llu,\n", (unsigned long long)sigmf_meta.global.sample_rate);
+        printf("    \"frequency\": %llu,\n", (unsigned long long)sigmf_meta.global.frequency);
         printf("    \"description\": \"%s\",\n", sigmf_meta.global.description);
         printf("    \"author\": \"%s\",\n", sigmf_meta.global.author);
         printf("    \"datetime\": \"%s\",\n", sigmf_meta.global.datetime);
@@ -288,8 +313,8 @@ int process_iq_file(const iqinfo_args_t *args) {
     printf("}\n");
 
     // Cleanup
+    if (has_summary) iq_summary_free(&summary);
     sigmf_free_metadata(&sigmf_meta);
-    iq_free(&iq_data);
 
     return EXIT_SUCCESS;
 }
@@ -4,13 +4,29 @@
  * Purpose: Execute complex processing pipelines defined in YAML configuration
  * files for batch processing of IQ data with reproducible results.
  *
- * Usage: iqjob --config <pipeline.yaml> --out <results_dir> [--parallel <N>] [--verbose]
+ * Usage: iqjob --config <pipeline.yaml> --out <results_dir> [--parallel <N>]
+ *              [--files <N>] [--memory-budget <MB>] [--tools-dir <dir>]
+ *              [--in-process] [--profile[=<file.json>]] [--trace <file.json>]
+ *              [--shard <seconds>] [--launcher <template>] [--nodes <a,b,...>]
+ *              [--keep-shards] [--verbose]
  *
  * Pipeline Features:
- * - Sequential tool execution with dependency management
+ * - Dependency-graph tool execution, up to --parallel steps at once
+ * - Fan-out: inputs may be glob patterns; a pipeline using {input}/{stem}
+ *   runs once per input, --files inputs at a time within the --parallel
+ *   and --memory-budget limits
+ * - In-process mode: inputs decoded once and shared by the analysis tools;
+ *   iqls/iqdetect steps with the same in/fft/hop/window share one FFT pass
  * - Progress tracking and error handling
  * - Comprehensive logging and reporting
  * - Deterministic execution for reproducibility
+ * - --profile: per-stage timing of everything run in this process, i.e.
+ *   the --in-process steps (profile.h); spawned tools are not included
+ * - --trace: whole-job Chrome trace timeline, one track per step with its
+ *   run time (spawned or not) plus the stage events of in-process steps
+ * - --shard: one long capture cut into time shards with overlap margins,
+ *   run as a fan-out (on --nodes through --launcher, e.g. ssh), and the
+ *   shards' event logs and tile pyramids merged back (shard.h)
  *
  *
  * Date: 2025
@@ -28,6 +44,20 @@
 
 #include "../src/jobs/yaml_parse.h"
 #include "../src/jobs/pipeline.h"
+#include "../src/jobs/shard.h"
+#include "../src/jobs/tools.h"
+#include "../src/iq_core/spectral_bus.h"
+#include "../src/iq_core/profile.h"
+
+// Tools whose cores run in process with --in-process, and the spectral bus
+// rows each can take in place of its own FFTs
+static const pipeline_tool_t IN_PROCESS_TOOLS[] = {
+    {"iqls", iqls_main, SPECTRAL_BUS_F32},
+    {"iqdetect", iqdetect_main, SPECTRAL_BUS_F64},
+    {"iqdemod-fm", iqdemod_fm_main, 0},
+    {"iqdemod-am", iqdemod_am_main, 0},
+    {"iqdemod-ssb", iqdemod_ssb_main, 0}
+};
 
 /**
  * @brief Command-line options structure
@@ -36,6 +66,15 @@ typedef struct {
     const char *config_file;
     const char *output_dir;
     uint32_t max_parallel;
+    uint32_t max_files;
+    uint32_t memory_budget_mb;
+    const char *tools_dir;
+    const char *cache_dir;
+    double shard_seconds;
+    const char *launcher;
+    const char *nodes;
+    bool keep_shards;
+    bool in_process;
     bool verbose;
     bool help;
 } iqjob_options_t;
@@ -47,6 +86,15 @@ static const iqjob_options_t DEFAULT_OPTIONS = {
     .config_file = NULL,
     .output_dir = "iqjob_results",
     .max_parallel = 1,
+    .max_files = 1,
+    .memory_budget_mb = 0,
+    .tools_dir = ".",
+    .cache_dir = NULL,
+    .shard_seconds = 0.0,
+    .launcher = NULL,
+    .nodes = NULL,
+    .keep_shards = false,
+    .in_process = false,
     .verbose = false,
     .help = false
 };
@@ -64,7 +112,38 @@ static void print_usage(const char *program_name) {
     printf("  --out <dir>           Output directory for results\n\n");
 
     printf("OPTIONAL ARGUMENTS:\n");
-    printf("  --parallel <N>         Maximum number of parallel jobs (default: 1)\n");
+    printf("  --parallel <N>         Maximum number of parallel jobs (default: 1); with\n");
+    printf("                         several inputs, the limit over all of them\n");
+    printf("  --files <N>            Inputs of a {input}/{stem} pipeline processed at once\n");
+    printf("                         (default: 1)\n");
+    printf("  --memory-budget <MB>   Start no step whose measured peak memory would take\n");
+    printf("                         the running steps over <MB> (default: no limit)\n");
+    printf("  --tools-dir <dir>      Directory holding the tool executables (default: .)\n");
+    printf("  --in-process           Decode inputs once and run the analysis tools in this\n");
+    printf("                         process, one step at a time (--parallel is ignored);\n");
+    printf("                         iqls/iqdetect steps over the same in, fft, hop and\n");
+    printf("                         window run together on one FFT pass\n");
+    printf("  --cache <dir>          Keep step outputs in <dir>, keyed by tool, parameters\n");
+    printf("                         and input contents; unchanged steps of later runs\n");
+    printf("                         are restored instead of run\n");
+    printf("  --shard <seconds>      Cut the single input into shards of about <seconds>,\n");
+    printf("                         each widened by a margin sized from the steps' FFT\n");
+    printf("                         and filter lengths, run them as inputs of the\n");
+    printf("                         {input}/{stem} pipeline and merge the iqdetect csv\n");
+    printf("                         logs and iqls --pyramid outputs (duplicate events at\n");
+    printf("                         shard boundaries removed)\n");
+    printf("  --launcher <template>  Run each spawned step through /bin/sh -c <template>:\n");
+    printf("                         {command} is the step's quoted command line, {node}\n");
+    printf("                         the node and {cwd} the current directory; inside\n");
+    printf("                         single quotes they are quoted for the remote shell,\n");
+    printf("                         e.g. \"ssh {node} 'cd {cwd} && {command}'\"\n");
+    printf("  --nodes <a,b,...>      Nodes for {node}; input (or shard) i runs on node\n");
+    printf("                         i mod count\n");
+    printf("  --keep-shards          Keep the shard files after merging\n");
+    printf("  --profile[=<file>]     Per-stage timing of the in-process steps on stderr at\n");
+    printf("                         exit, or as JSON to <file>\n");
+    printf("  --trace <file>         Whole-job timeline as Chrome trace JSON: every step on\n");
+    printf("                         a track of its own, with the stages of in-process steps\n");
     printf("  --verbose              Enable verbose output\n");
     printf("  --help                 Show this help message\n\n");
 
@@ -74,11 +153,19 @@ static void print_usage(const char *program_name) {
     printf("      meta: data/capture.sigmf-meta\n");
     printf("  pipeline:\n");
     printf("    - iqls: { fft: 4096, hop: 1024, avg: 20 }\n");
-    printf("    - iqdetect: { pfa: 1e-3, min_dur_ms: 50 }\n");
+    printf("    - iqdetect: { pfa: 1e-3, cfar: ca, min_dur_ms: 50 }\n");
     printf("    - iqdemod-fm: { deemphasis_us: 50 }\n");
     printf("  report:\n");
     printf("    consolidate: { events: true, spectra: true }\n\n");
 
+    printf("MANY INPUTS:\n");
+    printf("  inputs:\n");
+    printf("    - file: data/*.iq\n");
+    printf("  pipeline:\n");
+    printf("    - iqls: { in: \"{input}\", out: \"{out_dir}/{stem}\", fft: 4096, hop: 1024 }\n");
+    printf("  {input} is the input path, {stem} its name without extension and\n");
+    printf("  {out_dir} the results directory (quote values that use them).\n\n");
+
     printf("OUTPUT:\n");
     printf("  Creates timestamped results directory with:\n");
     printf("  - All tool outputs and intermediate files\n");
@@ -96,6 +183,17 @@ static bool parse_arguments(int argc, char **argv, iqjob_options_t *options) {
         {"config", required_argument, 0, 'c'},
         {"out", required_argument, 0, 'o'},
         {"parallel", required_argument, 0, 'p'},
+        {"files", required_argument, 0, 'f'},
+        {"memory-budget", required_argument, 0, 'm'},
+        {"tools-dir", required_argument, 0, 't'},
+        {"in-process", no_argument, 0, 'I'},
+        {"cache", required_argument, 0, 'C'},
+        {"profile", optional_argument, 0, 'P'},
+        {"trace", required_argument, 0, 'Q'},
+        {"shard", required_argument, 0, 'S'},
+        {"launcher", required_argument, 0, 'L'},
+        {"nodes", required_argument, 0, 'N'},
+        {"keep-shards", no_argument, 0, 'K'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
@@ -104,7 +202,7 @@ static bool parse_arguments(int argc, char **argv, iqjob_options_t *options) {
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "c:o:p:vh", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:o:p:f:m:t:IC:vh", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'c':
                 options->config_file = optarg;
@@ -115,6 +213,43 @@ static bool parse_arguments(int argc, char **argv, iqjob_options_t *options) {
             case 'p':
                 options->max_parallel = (uint32_t)atoi(optarg);
                 break;
+            case 'f':
+                options->max_files = (uint32_t)atoi(optarg);
+                break;
+            case 'm':
+                options->memory_budget_mb = (uint32_t)atoi(optarg);
+                break;
+            case 't':
+                options->tools_dir = optarg;
+                break;
+            case 'I':
+                options->in_process = true;
+                break;
+            case 'C':
+                options->cache_dir = optarg;
+                break;
+            case 'P':
+                iq_profile_start("iqjob", optarg);
+                break;
+            case 'Q':
+                if (!iq_trace_start("iqjob", optarg)) return false;
+                break;
+            case 'S':
+                options->shard_seconds = atof(optarg);
+                if (options->shard_seconds <= 0.0) {
+                    fprintf(stderr, "ERROR: --shard needs a positive length in seconds\n");
+                    return false;
+                }
+                break;
+            case 'L':
+                options->launcher = optarg;
+                break;
+            case 'N':
+                options->nodes = optarg;
+                break;
+            case 'K':
+                options->keep_shards = true;
+                break;
             case 'v':
                 options->verbose = true;
                 break;
@@ -149,6 +284,58 @@ static bool validate_options(const iqjob_options_t *options) {
         return false;
     }
 
+    if (options->max_files == 0) {
+        fprintf(stderr, "ERROR: Files processed at once must be greater than 0\n");
+        return false;
+    }
+
+    if (strlen(options->tools_dir) == 0 || strlen(options->tools_dir) >= 256) {
+        fprintf(stderr, "ERROR: Invalid tools directory '%s'\n", options->tools_dir);
+        return false;
+    }
+
+    if (options->cache_dir && (strlen(options->cache_dir) == 0 || strlen(options->cache_dir) >= 256)) {
+        fprintf(stderr, "ERROR: Invalid cache directory '%s'\n", options->cache_dir);
+        return false;
+    }
+
+    if (options->launcher && strlen(options->launcher) >= sizeof(((pipeline_config_t *)0)->launcher)) {
+        fprintf(stderr, "ERROR: Launcher template too long\n");
+        return false;
+    }
+
+    if (options->nodes && !options->launcher) {
+        fprintf(stderr, "ERROR: --nodes needs a --launcher to reach them\n");
+        return false;
+    }
+
+    if (options->shard_seconds > 0.0 && options->in_process) {
+        fprintf(stderr, "ERROR: --shard runs spawned tools; it cannot be combined with --in-process\n");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Split a comma-separated node list into the configuration
+ */
+static bool parse_nodes(const char *list, pipeline_config_t *config) {
+    config->node_count = 0;
+    for (const char *c = list; *c;) {
+        const char *end = strchr(c, ',');
+        size_t length = end ? (size_t)(end - c) : strlen(c);
+        if (length == 0 || length >= sizeof(config->nodes[0]) || config->node_count == PIPELINE_MAX_NODES) {
+            fprintf(stderr, "ERROR: Bad node list '%s' (up to %d names, comma-separated)\n",
+                    list, PIPELINE_MAX_NODES);
+            return false;
+        }
+        memcpy(config->nodes[config->node_count], c, length);
+        config->nodes[config->node_count][length] = '\0';
+        config->node_count++;
+        c += length + (end ? 1 : 0);
+    }
+    if (config->node_count > 0) strcpy(config->node, config->nodes[0]);
     return true;
 }
 
@@ -210,11 +397,13 @@ static bool validate_inputs(const yaml_document_t *document) {
  */
 static bool execute_pipeline_with_progress(pipeline_executor_t *executor,
                                          const iqjob_options_t *options) {
-    (void)options;  // Suppress unused parameter warning
-    printf("🚀 Starting pipeline execution...\n");
+    printf("🚀 Starting pipeline execution%s...\n", options->in_process ? " (in process)" : "");
 
     // Execute pipeline
-    bool success = pipeline_execute(executor);
+    bool success = options->in_process ?
+        pipeline_execute_in_process(executor, IN_PROCESS_TOOLS,
+                                    sizeof(IN_PROCESS_TOOLS) / sizeof(IN_PROCESS_TOOLS[0])) :
+        pipeline_execute(executor);
 
     // Get final statistics
     uint32_t completed, total;
@@ -248,9 +437,52 @@ static bool execute_pipeline_with_progress(pipeline_executor_t *executor,
 }
 
 /**
- * @brief Generate final summary report
+ * @brief Execute a pipeline over every input with progress reporting
+ */
+static bool execute_fanout_with_progress(pipeline_fanout_t *fanout,
+                                       const iqjob_options_t *options) {
+    printf("🚀 Starting pipeline over %u inputs%s...\n", fanout->file_count,
+           options->in_process ? " (in process)" : "");
+
+    bool success = options->in_process ?
+        pipeline_fanout_execute_in_process(fanout, IN_PROCESS_TOOLS,
+                                           sizeof(IN_PROCESS_TOOLS) / sizeof(IN_PROCESS_TOOLS[0])) :
+        pipeline_fanout_execute(fanout);
+
+    printf("\n📊 Execution Summary:\n");
+    printf("  Completed: %u/%u inputs\n", fanout->completed_files, fanout->file_count);
+    printf("  Peak inputs in flight: %u\n", fanout->peak_files);
+    printf("  Peak running steps: %u\n", fanout->peak_running);
+    printf("  Total Time: %.3f seconds\n", fanout->total_execution_time);
+
+    if (success) {
+        printf("✅ Pipeline execution completed successfully!\n");
+    } else {
+        printf("❌ Pipeline execution failed!\n");
+
+        // Show failed inputs and their failed steps
+        for (uint32_t f = 0; f < fanout->file_count; f++) {
+            const pipeline_fanout_file_t *file = &fanout->files[f];
+            if (file->success) continue;
+            printf("  Input %s: %s\n", file->input,
+                   file->error_message[0] ? file->error_message : "step failed");
+            for (uint32_t i = 0; i < file->result_count; i++) {
+                const pipeline_step_result_t *result = &file->results[i];
+                if (!result->success && result->error_message[0]) {
+                    printf("    Step %u (%s): %s\n", i, result->tool_name, result->error_message);
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+/**
+ * @brief Generate final summary report (of a single run or a fan-out)
  */
 static bool generate_summary_report(pipeline_executor_t *executor,
+                                  const pipeline_fanout_t *fanout,
                                   const iqjob_options_t *options,
                                   const char *output_dir) {
     char summary_file[512];
@@ -261,8 +493,11 @@ static bool generate_summary_report(pipeline_executor_t *executor,
         return false;
     }
 
-    char summary_buffer[4096];
-    if (!pipeline_generate_summary(executor, summary_buffer, sizeof(summary_buffer))) {
+    char summary_buffer[16384];
+    bool generated = fanout ?
+        pipeline_fanout_generate_summary(fanout, summary_buffer, sizeof(summary_buffer)) :
+        pipeline_generate_summary(executor, summary_buffer, sizeof(summary_buffer));
+    if (!generated) {
         fprintf(stderr, "WARNING: Failed to generate summary report\n");
         return false;
     }
@@ -284,9 +519,10 @@ static bool generate_summary_report(pipeline_executor_t *executor,
 }
 
 /**
- * @brief Save execution results
+ * @brief Save execution results (of a single run or a fan-out)
  */
 static bool save_execution_results(pipeline_executor_t *executor,
+                                 const pipeline_fanout_t *fanout,
                                  const iqjob_options_t *options,
                                  const char *output_dir) {
     char results_file[512];
@@ -297,7 +533,9 @@ static bool save_execution_results(pipeline_executor_t *executor,
         return false;
     }
 
-    if (!pipeline_save_results(executor, results_file)) {
+    bool saved = fanout ? pipeline_fanout_save_results(fanout, results_file) :
+                          pipeline_save_results(executor, results_file);
+    if (!saved) {
         fprintf(stderr, "WARNING: Failed to save execution results\n");
         return false;
     }
@@ -336,6 +574,7 @@ int main(int argc, char **argv) {
         printf("  Config file: %s\n", options.config_file);
         printf("  Base output dir: %s\n", options.output_dir);
         printf("  Max parallel: %u\n", options.max_parallel);
+        printf("  Files at once: %u\n", options.max_files);
     }
 
     // Load YAML configuration
@@ -345,6 +584,12 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
+    // Replace input patterns by the files they match
+    if (!yaml_expand_inputs(&document)) {
+        yaml_free_document(&document);
+        return EXIT_FAILURE;
+    }
+
     if (options.verbose) {
         printf("✅ Configuration loaded: %u inputs, %u pipeline steps\n",
                document.input_count, document.pipeline_count);
@@ -393,8 +638,10 @@ int main(int argc, char **argv) {
     }
 
     // Configure pipeline
-    pipeline_config.enable_parallel = (options.max_parallel > 1);
+    pipeline_config.enable_parallel = (options.max_parallel > 1) && !options.in_process;
     pipeline_config.max_parallel_jobs = options.max_parallel;
+    pipeline_config.max_parallel_files = options.max_files;
+    pipeline_config.memory_budget_bytes = (uint64_t)options.memory_budget_mb * 1024 * 1024;
     pipeline_config.continue_on_error = false;  // Stop on first error
     pipeline_config.timeout_seconds = 600.0;    // 10 minute timeout per step
 
@@ -410,11 +657,59 @@ int main(int argc, char **argv) {
 
     // Set working directory
     strcpy(pipeline_config.working_dir, output_dir);
+    strcpy(pipeline_config.tool_dir, options.tools_dir);
+    if (options.cache_dir) strcpy(pipeline_config.cache_dir, options.cache_dir);
+    if (options.launcher) strcpy(pipeline_config.launcher, options.launcher);
+    if (options.nodes && !parse_nodes(options.nodes, &pipeline_config)) {
+        yaml_free_document(&document);
+        return EXIT_FAILURE;
+    }
+
+    // Sharded: the single input becomes one input per shard file, run as a
+    // fan-out of the template
+    shard_plan_t plan = {0};
+    yaml_document_t shard_document = {0};
+    bool sharded = options.shard_seconds > 0.0;
+    if (sharded) {
+        char shard_dir[600];
+        snprintf(shard_dir, sizeof(shard_dir), "%s/shards", output_dir);
+        if (!pipeline_document_is_template(&document)) {
+            fprintf(stderr, "ERROR: --shard needs a pipeline using {input}/{stem}\n");
+            yaml_free_document(&document);
+            return EXIT_FAILURE;
+        }
+        if (!shard_plan_init(&plan, &document, options.shard_seconds, shard_dir) ||
+            !shard_plan_write(&plan) ||
+            !shard_plan_document(&plan, &document, &shard_document)) {
+            fprintf(stderr, "ERROR: Failed to cut %s into shards\n", document.inputs[0].file);
+            shard_plan_remove_files(&plan);
+            shard_plan_free(&plan);
+            yaml_free_document(&document);
+            return EXIT_FAILURE;
+        }
+        printf("✂️  %u shards of %.3f s, margin %.3f ms, in %s\n", plan.count,
+               (double)plan.shard_samples / plan.sample_rate,
+               1e3 * (double)plan.margin / plan.sample_rate, shard_dir);
+    }
 
-    // Create pipeline executor
-    pipeline_executor_t *executor = pipeline_executor_create(&pipeline_config, &document);
-    if (!executor) {
+    // A pipeline naming {input} or {stem} runs once per input; otherwise
+    // the steps run once, as written
+    pipeline_executor_t *executor = NULL;
+    pipeline_fanout_t *fanout = NULL;
+    if (sharded) {
+        fanout = pipeline_fanout_create(&pipeline_config, &shard_document);
+    } else if (pipeline_document_is_template(&document)) {
+        fanout = pipeline_fanout_create(&pipeline_config, &document);
+    } else {
+        executor = pipeline_executor_create(&pipeline_config, &document);
+    }
+    if (!executor && !fanout) {
         fprintf(stderr, "ERROR: Failed to create pipeline executor\n");
+        if (sharded) {
+            shard_plan_remove_files(&plan);
+            shard_plan_free(&plan);
+            yaml_free_document(&shard_document);
+        }
         yaml_free_document(&document);
         return EXIT_FAILURE;
     }
@@ -423,18 +718,37 @@ int main(int argc, char **argv) {
         printf("🔧 Pipeline executor initialized\n");
         printf("  Parallel execution: %s\n", pipeline_config.enable_parallel ? "enabled" : "disabled");
         printf("  Max parallel jobs: %u\n", pipeline_config.max_parallel_jobs);
+        if (fanout) {
+            printf("  Inputs: %u, %u at once\n", fanout->file_count, pipeline_config.max_parallel_files);
+            if (options.memory_budget_mb > 0) printf("  Memory budget: %u MB\n", options.memory_budget_mb);
+        }
         printf("  Log file: %s\n", pipeline_config.log_file);
+        if (options.cache_dir) printf("  Step cache: %s\n", options.cache_dir);
+        if (options.launcher) printf("  Launcher: %s (%u nodes)\n", options.launcher, pipeline_config.node_count);
     }
 
     // Execute pipeline
-    bool execution_success = execute_pipeline_with_progress(executor, &options);
+    bool execution_success = fanout ? execute_fanout_with_progress(fanout, &options) :
+                                      execute_pipeline_with_progress(executor, &options);
+
+    // Shard outputs back on the capture's timeline, in shard order
+    if (sharded && execution_success) {
+        printf("🧩 Merging shard outputs...\n");
+        execution_success = shard_merge_outputs(&plan, &document, output_dir);
+    }
 
     // Generate reports
-    generate_summary_report(executor, &options, output_dir);
-    save_execution_results(executor, &options, output_dir);
+    generate_summary_report(executor, fanout, &options, output_dir);
+    save_execution_results(executor, fanout, &options, output_dir);
 
     // Cleanup
+    pipeline_fanout_destroy(fanout);
     pipeline_executor_destroy(executor);
+    if (sharded) {
+        if (!options.keep_shards) shard_plan_remove_files(&plan);
+        shard_plan_free(&plan);
+        yaml_free_document(&shard_document);
+    }
     yaml_free_document(&document);
 
     if (execution_success) {
@@ -12,7 +12,9 @@
  * - Fast Fourier Transform (FFT) based spectrum computation
  * - FFT shift for proper frequency domain display (-fs/2 to +fs/2)
  * - Configurable FFT size and windowing parameters
- * - Spectrum averaging over multiple frames for noise reduction
+ * - Spectrum averaging over multiple frames for noise reduction: Welch's
+ *   mean of linear power by default, or --psd-avg log (mean of dB), ema
+ *   (weight 2 / (K + 1)) or max (max-hold), all through one psd_t (psd.h)
  * - Linear and logarithmic magnitude display modes
  * - High-quality PNG output with professional axis labeling
  * - Optional waterfall visualization with time-frequency representation
@@ -28,6 +30,12 @@
  *   # High-resolution narrowband analysis
  *   iqls.exe --in narrowband.iq --rate 500000 --fft 4096 --hop 2048 --avg 20 --out detailed
  *
+ *   # Zoom FFT: 5 kHz around +200 kHz at 0.76 Hz per bin from a 2.4 Msps capture
+ *   iqls.exe --in wide.iq --rate 2400000 --zoom-center 200000 --zoom-span 5000 --fft 8192 --hop 4096 --avg 10 --out zoom
+ *
+ *   # Raw dB spectrogram for NumPy, no images
+ *   iqls.exe --in signal.iq --rate 2000000 --fft 1024 --hop 512 --logmag --raw f16 --out frames
+ *
  * Technical Algorithm:
  * 1. FFT Computation: Convert time-domain IQ to frequency domain
  * 2. FFT Shift: Rearrange bins from (0,fs) to (-fs/2,fs/2)
@@ -46,15 +54,51 @@
  * Visualization Features:
  * - Spectrum Plot: Traditional frequency vs power display
  * - Waterfall Plot: Time vs frequency vs power representation
+ * - Waterfall pooling: the whole capture is reduced to the image by max-hold
+ *   or mean over consecutive frames (--wf-time) and over the bins behind
+ *   each pixel (--wf-freq), so short bursts survive the downscale
+ * - Full-resolution waterfall (--wf-full): one pixel row per frame and one
+ *   pixel per bin, oldest frame at the top, streamed to a PNG while the
+ *   sweep runs so memory does not grow with the capture
+ * - Tile pyramid (--pyramid): every frame at full bin resolution, stored as
+ *   tiles at successively halved zoom levels (<prefix>_tiles.iqpyr) and
+ *   written during the same sweep, so viewers can pan and zoom a long
+ *   capture without recomputing FFTs
+ * - Raw spectrogram (--raw f32|f16): every frame at every bin as a NumPy
+ *   .npy matrix (<prefix>_spectrogram.npy, frames x bins), linear power or
+ *   dB with --logmag, written in large sequential blocks with no colour
+ *   scaling or image encoding; --avg becomes optional and without it no
+ *   spectrum plot is drawn. f16 halves the file and suits dB values
+ * - Zoom FFT (--zoom-center <Hz> --zoom-span <Hz>): the capture is mixed
+ *   so the zoom centre sits at DC and decimated through the translating
+ *   FIR stage (xlate.h) to about 1.25x the span, then every output runs on
+ *   the reduced stream, so --fft and --hop count decimated samples and the
+ *   bin width is the reduced rate / --fft. FFT cost and resident memory
+ *   follow the span rather than the capture bandwidth; axes and pyramid
+ *   metadata are labelled in capture offsets around the zoom centre
+ * - Summary preview (--summary): spectrum, waterfall and RMS/peak power
+ *   against time from the <input>.iqsum sidecar (iq_summary.h), built in
+ *   one pass the first time; later previews never read the capture
  * - Axis Labels: Frequency (Hz) and power (dBFS or linear)
- * - Color Mapping: Intensity-based color scale (black to white)
+ * - Color Mapping: lookup-table palettes (--cmap hf|gray|viridis|inferno|turbo,
+ *   colormap.h); whole rows are quantized and coloured at once
  * - Image Scaling: Automatic aspect ratio and resolution control
  *
  * Performance Optimization:
- * - FFT size must be power of 2 for efficiency
+ * - Any FFT size works; powers of two are fastest, 2^a*3^b*5^c*7^d sizes run
+ *   mixed radix and other sizes fall back to Bluestein
  * - Hop size controls temporal resolution vs computation
  * - Averaging count balances SNR vs temporal detail
  * - Memory efficient processing with streaming FFT
+ * - Frames are transformed on a thread pool (--threads, default: all
+ *   cores), and PNGs are deflated in row bands on as many threads; output
+ *   is byte-identical for any thread count
+ * - --png-level fast trades file size for a much quicker PNG write
+ * - --gpu moves the STFT to an OpenCL device (builds with make GPU=1,
+ *   gpu.h) in batches of thousands of frames; without a device the thread
+ *   pool runs as usual. Device rows match the CPU to float rounding only
+ * - Under iqjob --in-process, steps with the same input and STFT geometry
+ *   share one FFT pass (spectral_bus.h) and iqls only renders its rows
  *
  * Input Requirements:
  * - Raw IQ data: s8 or s16 interleaved samples
@@ -63,6 +107,7 @@
  *
  * Output Formats:
  * - PNG images with professional quality
+ * - NumPy .npy float32/float16 spectrogram matrix (--raw)
  * - Spectrum: Static frequency domain plot
  * - Waterfall: Dynamic time-frequency representation
  * - Automatic file naming and metadata
@@ -75,39 +120,319 @@
  * - Educational demonstrations of spectral analysis
  * - Quality assurance for RF systems
  *
+ * Profiling (--profile, --profile=<file.json>): per-stage time for read,
+ * convert, fft and encode, printed to stderr or written as JSON at exit;
+ * --trace=<file.json> records the same stages as a Chrome trace timeline
+ *
  * Dependencies: FFT library, PNG visualization, IQ I/O
- * Thread Safety: Single-threaded processing
+ * Thread Safety: Parallel STFT workers; I/O and rendering on the main thread
  * Error Handling: Comprehensive validation and user feedback
  */
 
 #include "../src/iq_core/io_iq.h"
 #include "../src/iq_core/fft.h"
+#include "../src/iq_core/window.h"
+#include "../src/iq_core/stft.h"
+#include "../src/iq_core/psd.h"
+#include "../src/iq_core/arena.h"
+#include "../src/iq_core/spectral_bus.h"
+#include "../src/iq_core/iq_summary.h"
+#include "../src/iq_core/gpu.h"
+#include "../src/iq_core/xlate.h"
+#include "../src/iq_core/profile.h"
+#include "../src/iq_core/affinity.h"
 #include "../src/viz/img_png.h"
 #include "../src/viz/draw_axes.h"
+#include "../src/viz/colormap.h"
+#include "../src/viz/tile_pyramid.h"
+#include "../src/viz/npy_stream.h"
+#include "../src/jobs/tools.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
+#define IQLS_BATCH_BINS 262144        // Target bins per worker per batch
+#define IQLS_MAX_BATCH_FRAMES 16      // Upper bound on frames per worker per batch
+#define IQLS_MAX_SPAN_SAMPLES (1u << 22) // Upper bound on samples held for one batch
+#define IQLS_GPU_BATCH_FRAMES 8192    // Frames per batch on an OpenCL device
+#define IQLS_ZOOM_BLOCK_SAMPLES 65536 // Capture samples read per zoom refill
+#define IQLS_ZOOM_PASSBAND 0.8        // Zoom span as a fraction of the reduced rate
+
+// Waterfall pooling: reduce K frames to one row / a bin range to one pixel
+typedef enum {
+    IQLS_POOL_MAX,          // Max-hold: short bursts stay visible
+    IQLS_POOL_MEAN,         // Mean of linear power
+    IQLS_POOL_NONE          // Sample only: first frames / nearest bin
+} iqls_pool_t;
+
 typedef struct {
     const char *in_path;
-    const char *format_str; // s8|s16 (optional if autodetected)
+    const char *format_str; // s8|s16|s12|s4 (optional if autodetected)
     uint32_t sample_rate;
     uint32_t fft_size;
     uint32_t hop_size;
     uint32_t avg_count;
+    psd_average_t psd_avg;  // How the K spectrum frames are averaged (--psd-avg)
     int logmag;             // boolean
     int waterfall;          // boolean
+    const char *window;     // FFT window name (optional, default rectangular)
+    uint32_t threads;       // STFT worker threads (0 = one per core)
+    int gpu;                // boolean: STFT on an OpenCL device when one is present
+    iqls_pool_t wf_time;    // How frames are pooled into waterfall rows
+    iqls_pool_t wf_freq;    // How bins are pooled into waterfall pixels
+    int wf_full;            // boolean: stream the full-resolution waterfall
+    int wf_range_set;       // boolean: --wf-range given
+    double wf_range_min;    // Full waterfall colour range (dB or magnitude)
+    double wf_range_max;
+    int pyramid;            // boolean: write the tile pyramid
+    uint32_t tile_size;     // Pyramid tile edge in cells
+    int raw;                // boolean: write the raw spectrogram matrix
+    npy_dtype_t raw_dtype;  // Its element type (--raw f32|f16)
+    int summary;            // boolean: preview from the summary sidecar
+    int zoom;               // boolean: --zoom-span given
+    double zoom_center;     // Offset moved to DC (Hz)
+    double zoom_span;       // Band kept around it (Hz)
+    colormap_palette_t palette; // Spectrum and waterfall colours (--cmap)
+    png_level_t png_level;  // PNG compression effort (--png-level)
     const char *out_prefix;
 } iqls_args_t;
 
+// Waterfall value of one linear power bin: the dB row fft_spectral_frame
+// would produce, or the magnitude
+static double iqls_waterfall_value(float power, int logmag) {
+    return logmag ? (double)(10.0f * log10f(power + 1e-12f)) : sqrt(power);
+}
+
+// Pool a bin range [b0, b1) of a power row into one pixel
+static float iqls_pool_bins(const float *power, uint32_t b0, uint32_t b1, iqls_pool_t mode) {
+    if (mode == IQLS_POOL_NONE) return power[b0];
+    if (mode == IQLS_POOL_MAX) {
+        float peak = power[b0];
+        for (uint32_t k = b0 + 1; k < b1; k++) {
+            if (power[k] > peak) peak = power[k];
+        }
+        return peak;
+    }
+    double sum = 0.0;
+    for (uint32_t k = b0; k < b1; k++) sum += power[k];
+    return (float)(sum / (double)(b1 - b0));
+}
+
+static bool iqls_parse_pool(const char *name, const char *none_name, iqls_pool_t *mode) {
+    if (strcmp(name, "max") == 0) *mode = IQLS_POOL_MAX;
+    else if (strcmp(name, "mean") == 0) *mode = IQLS_POOL_MEAN;
+    else if (strcmp(name, none_name) == 0) *mode = IQLS_POOL_NONE;
+    else return false;
+    return true;
+}
+
+// Image geometry shared by every plot
+#define IQLS_IMAGE_MAX_WIDTH 1024     // Maximum readable width
+#define IQLS_IMAGE_HEIGHT 512         // Fixed height for good readability
+#define IQLS_AXIS_MARGIN 60
+
+static uint32_t iqls_image_width(uint32_t fft_size) {
+    return fft_size > IQLS_IMAGE_MAX_WIDTH ? IQLS_IMAGE_MAX_WIDTH : fft_size;
+}
+
+// How images are coloured and written
+typedef struct {
+    colormap_t cmap;
+    png_write_options_t png;
+} iqls_render_t;
+
+static void iqls_render_init(iqls_render_t *render, const iqls_args_t *args) {
+    colormap_init(&render->cmap, args->palette);
+    png_write_options_default(&render->png);
+    render->png.num_threads = args->threads;
+    render->png.level = args->png_level;
+}
+
+// <prefix>_spectrum.png from one dB (or magnitude) value per bin
+static bool iqls_render_spectrum(const double *values, uint32_t fft_size, uint32_t sample_rate,
+                                 double center_hz, const iqls_render_t *render, const char *out_prefix) {
+    const uint32_t width = iqls_image_width(fft_size);
+    const uint32_t height = IQLS_IMAGE_HEIGHT;
+    const uint32_t axis_margin = IQLS_AXIS_MARGIN;
+
+    double min_db = 1e9, max_db = -1e9;
+    for (uint32_t k = 0; k < fft_size; k++) {
+        if (values[k] < min_db) min_db = values[k];
+        if (values[k] > max_db) max_db = values[k];
+    }
+
+    png_image_t img;
+    uint8_t *bar = malloc((size_t)(width - axis_margin) * 3);
+    if (!bar || !png_image_init(&img, width, height)) {
+        fprintf(stderr, "Image init failed\n");
+        free(bar);
+        return false;
+    }
+    png_image_fill(&img, 10, 10, 10);
+
+    // Axes
+    draw_db_scale(img.data, width, height, axis_margin, min_db, max_db, 255, 200, 0);
+    draw_frequency_axis(img.data, width, height, axis_margin, center_hz, sample_rate, fft_size, 255, 200, 0);
+
+    // Plot: every line of the bars is the same row of colours
+    for (uint32_t x = axis_margin; x < width; x++) {
+        uint8_t *px = bar + (x - axis_margin) * 3;
+        uint32_t bin = (uint32_t)((x - axis_margin) * (double)fft_size / (double)(width - axis_margin));
+        if (bin >= fft_size) {
+            px[0] = px[1] = px[2] = 10;
+            continue;
+        }
+        double norm = (values[bin] - min_db) / (max_db - min_db + 1e-12);
+        if (norm < 0.0) {
+            norm = 0.0;
+        } else if (norm > 1.0) {
+            norm = 1.0;
+        }
+        colormap_lookup(&render->cmap, (float)norm, &px[0], &px[1], &px[2]);
+    }
+    for (uint32_t y = axis_margin; y < height - axis_margin; y++) {
+        png_image_set_row(&img, axis_margin, y, bar, width - axis_margin);
+    }
+    free(bar);
+
+    char out_path[512];
+    snprintf(out_path, sizeof(out_path), "%s_spectrum.png", out_prefix);
+    if (!png_image_write_ex(&img, out_path, &render->png)) {
+        fprintf(stderr, "Failed to write %s\n", out_path);
+    } else {
+        printf("Wrote %s\n", out_path);
+    }
+
+    png_image_free(&img);
+    return true;
+}
+
+// <prefix>_waterfall.png from wf_rows pooled rows of plot-width values, oldest first
+static void iqls_render_waterfall(const float *cols, const bool *row_ok, uint64_t wf_rows,
+                                  double wf_min, double wf_max, double duration_s,
+                                  uint32_t sample_rate, double center_hz, uint32_t fft_size,
+                                  const iqls_render_t *render, const char *out_prefix) {
+    const uint32_t width = iqls_image_width(fft_size);
+    const uint32_t height = IQLS_IMAGE_HEIGHT;
+    const uint32_t axis_margin = IQLS_AXIS_MARGIN;
+    const uint32_t graph_height = height - 2 * axis_margin;
+    const uint32_t plot_width = width - axis_margin;
+
+    png_image_t wimg;
+    uint8_t *line = malloc((size_t)plot_width * 3);
+    if (!line || !png_image_init(&wimg, width, height)) {
+        fprintf(stderr, "Waterfall image init failed\n");
+        free(line);
+        return;
+    }
+    png_image_fill(&wimg, 10, 10, 10);
+
+    if (wf_max <= wf_min) { wf_max = wf_min + 1.0; }
+
+    // Render rows from bottom up (older at bottom)
+    for (uint64_t r = 0; r < wf_rows; r++) {
+        if (!row_ok[r]) continue;
+
+        // Scale row index to available graph height (newest at top, oldest at bottom)
+        double scale_factor = (double)graph_height / (double)wf_rows;
+        uint32_t y = axis_margin + (uint32_t)((wf_rows - 1 - r) * scale_factor);
+        if (y >= height - axis_margin) continue;
+        colormap_map_row(&render->cmap, cols + r * plot_width, plot_width, (float)wf_min, (float)wf_max, line);
+        png_image_set_row(&wimg, axis_margin, y, line, plot_width);
+    }
+    free(line);
+
+    // Axes
+    draw_time_axis(wimg.data, width, height, axis_margin, duration_s, 0, 255, 200, 0);
+    draw_frequency_axis(wimg.data, width, height, axis_margin, center_hz, sample_rate, fft_size, 255, 200, 0);
+
+    char wpath[512];
+    snprintf(wpath, sizeof(wpath), "%s_waterfall.png", out_prefix);
+    if (!png_image_write_ex(&wimg, wpath, &render->png)) {
+        fprintf(stderr, "Failed to write %s\n", wpath);
+    } else {
+        printf("Wrote %s\n", wpath);
+    }
+    png_image_free(&wimg);
+}
+
+// <prefix>_power.png: RMS (bars) and peak (dots) in dBFS against time, from summary blocks
+static void iqls_render_power(const iq_summary_t *summary, double duration_s,
+                              const iqls_render_t *render, const char *out_prefix) {
+    const uint32_t width = IQLS_IMAGE_MAX_WIDTH;
+    const uint32_t height = IQLS_IMAGE_HEIGHT;
+    const uint32_t axis_margin = IQLS_AXIS_MARGIN;
+    const uint32_t plot_width = width - axis_margin;
+
+    double *rms_db = malloc(plot_width * sizeof(double));
+    double *peak_db = malloc(plot_width * sizeof(double));
+    png_image_t img;
+    if (!rms_db || !peak_db || !png_image_init(&img, width, height)) {
+        fprintf(stderr, "Power image init failed\n");
+        free(rms_db); free(peak_db);
+        return;
+    }
+    png_image_fill(&img, 10, 10, 10);
+
+    // Column x pools blocks [b(x), b(x + 1)); RMS over the samples, max of the peaks
+    double min_db = 1e9, max_db = -1e9;
+    for (uint32_t x = 0; x < plot_width; x++) {
+        uint64_t b0 = x * summary->num_blocks / plot_width;
+        uint64_t b1 = (x + 1) * summary->num_blocks / plot_width;
+        if (b1 <= b0) b1 = b0 + 1;
+        if (b1 > summary->num_blocks) b1 = summary->num_blocks;
+        iq_stats_t stats;
+        iq_summary_range_stats(summary, b0, b1 - b0, &stats);
+        rms_db[x] = 20.0 * log10(stats.rms + 1e-12);
+        peak_db[x] = 20.0 * log10(stats.peak + 1e-12);
+        if (rms_db[x] < min_db) min_db = rms_db[x];
+        if (peak_db[x] > max_db) max_db = peak_db[x];
+    }
+    min_db -= 10.0;   // Keep the quietest RMS bar visible
+
+    // Same vertical extent as draw_db_scale: max at the top, min on the time axis
+    const uint32_t axis_y = height - axis_margin;
+    for (uint32_t x = 0; x < plot_width; x++) {
+        uint32_t y_rms = (uint32_t)((max_db - rms_db[x]) / (max_db - min_db) * (axis_y - 1));
+        uint32_t y_peak = (uint32_t)((max_db - peak_db[x]) / (max_db - min_db) * (axis_y - 1));
+        draw_vertical_line(img.data, width, height, axis_margin + x, y_rms, axis_y - 1, 40, 120, 220);
+        png_image_set_pixel(&img, axis_margin + x, y_peak, 255, 80, 80);
+    }
+
+    // dB on the left, time along the bottom
+    draw_db_scale(img.data, width, height, axis_margin, min_db, max_db, 255, 200, 0);
+    draw_horizontal_line(img.data, width, height, axis_margin, width - 1, axis_y, 255, 200, 0);
+    for (uint32_t i = 0; i <= 8; i++) {
+        uint32_t x = axis_margin + i * (plot_width - 1) / 8;
+        char label[32];
+        format_time(label, sizeof(label), duration_s * i / 8.0);
+        draw_vertical_line(img.data, width, height, x, axis_y, axis_y + 5, 255, 200, 0);
+        draw_text(img.data, width, height, x > axis_margin + 20 ? x - 20 : x, axis_y + 10, label, &font_5x7, 255, 200, 0);
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s_power.png", out_prefix);
+    if (!png_image_write_ex(&img, path, &render->png)) {
+        fprintf(stderr, "Failed to write %s\n", path);
+    } else {
+        printf("Wrote %s\n", path);
+    }
+    png_image_free(&img);
+    free(rms_db);
+    free(peak_db);
+}
+
 static void print_usage(void) {
-    printf("Usage: iqls --in <file> --format {s8|s16} --rate <Hz> --fft N --hop H --avg K [--logmag] [--waterfall] --out <prefix>\n");
+    printf("Usage: iqls --in <file> --format {s8|s16|s12|s4} --rate <Hz> --fft N --hop H [--avg K] [--psd-avg {linear|log|ema|max}] [--window <name>] [--threads N] [--gpu] [--logmag] [--waterfall] [--wf-time {max|mean|first}] [--wf-freq {max|mean|nearest}] [--wf-full] [--wf-range MIN:MAX] [--pyramid] [--tile N] [--raw {f32|f16}] [--zoom-center <Hz> --zoom-span <Hz>] [--cmap <palette>] [--png-level {fast|default|best}] [--profile[=<file.json>]] [--trace=<file.json>] [--pin[=<policy>]] --out <prefix>\n");
+    printf("       --zoom-span reduces the capture to the band around --zoom-center first; --fft and --hop then count reduced samples\n");
+    printf("       iqls --in <file> --summary [--rate <Hz>] [--fft N] [--threads N] [--logmag] [--waterfall] [--wf-time {max|mean|first}] [--wf-freq {max|mean|nearest}] [--cmap <palette>] [--png-level {fast|default|best}] --out <prefix>\n");
 }
 
 static int parse_args(int argc, char **argv, iqls_args_t *args) {
     memset(args, 0, sizeof(*args));
+    args->png_level = PNG_LEVEL_DEFAULT;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--in") == 0 && i + 1 < argc) args->in_path = argv[++i];
         else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) args->format_str = argv[++i];
@@ -116,225 +441,763 @@ static int parse_args(int argc, char **argv, iqls_args_t *args) {
         else if (strcmp(argv[i], "--hop") == 0 && i + 1 < argc) args->hop_size = (uint32_t)strtoul(argv[++i], NULL, 10);
         else if (strcmp(argv[i], "--avg") == 0 && i + 1 < argc) args->avg_count = (uint32_t)strtoul(argv[++i], NULL, 10);
         else if (strcmp(argv[i], "--logmag") == 0) args->logmag = 1;
+        else if (strcmp(argv[i], "--psd-avg") == 0 && i + 1 < argc) {
+            if (!psd_average_from_name(argv[++i], &args->psd_avg)) {
+                fprintf(stderr, "Unknown --psd-avg mode: %s (linear, log, ema, max)\n", argv[i]);
+                return 0;
+            }
+        }
         else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) args->out_prefix = argv[++i];
         else if (strcmp(argv[i], "--waterfall") == 0) args->waterfall = 1;
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) args->window = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) args->threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--gpu") == 0) args->gpu = 1;
+        else if (strcmp(argv[i], "--wf-full") == 0) args->wf_full = 1;
+        else if (strcmp(argv[i], "--wf-range") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lf:%lf", &args->wf_range_min, &args->wf_range_max) != 2 ||
+                !(args->wf_range_max > args->wf_range_min)) {
+                fprintf(stderr, "Invalid --wf-range: %s (expected MIN:MAX)\n", argv[i]);
+                return 0;
+            }
+            args->wf_range_set = 1;
+        }
+        else if (strcmp(argv[i], "--pyramid") == 0) args->pyramid = 1;
+        else if (strcmp(argv[i], "--raw") == 0 && i + 1 < argc) {
+            if (!npy_dtype_from_name(argv[++i], &args->raw_dtype)) {
+                fprintf(stderr, "Unknown --raw type: %s (f32, f16)\n", argv[i]);
+                return 0;
+            }
+            args->raw = 1;
+        }
+        else if (strcmp(argv[i], "--summary") == 0) args->summary = 1;
+        else if (strcmp(argv[i], "--zoom-center") == 0 && i + 1 < argc) args->zoom_center = strtod(argv[++i], NULL);
+        else if (strcmp(argv[i], "--zoom-span") == 0 && i + 1 < argc) {
+            args->zoom_span = strtod(argv[++i], NULL);
+            if (!(args->zoom_span > 0.0)) {
+                fprintf(stderr, "Invalid --zoom-span: %s (expected a positive bandwidth in Hz)\n", argv[i]);
+                return 0;
+            }
+            args->zoom = 1;
+        }
+        else if (iq_profile_parse_arg("iqls", argv[i])) continue;
+        else if (iq_affinity_parse_arg(argv[i])) continue;
+        else if (strcmp(argv[i], "--png-level") == 0 && i + 1 < argc) {
+            if (!png_level_from_name(argv[++i], &args->png_level)) {
+                fprintf(stderr, "Unknown --png-level: %s (fast, default, best)\n", argv[i]);
+                return 0;
+            }
+        }
+        else if (strcmp(argv[i], "--cmap") == 0 && i + 1 < argc) {
+            if (!colormap_from_name(argv[++i], &args->palette)) {
+                fprintf(stderr, "Unknown --cmap palette: %s (hf, gray, viridis, inferno, turbo)\n", argv[i]);
+                return 0;
+            }
+        }
+        else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc) args->tile_size = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--wf-time") == 0 && i + 1 < argc) {
+            if (!iqls_parse_pool(argv[++i], "first", &args->wf_time)) {
+                fprintf(stderr, "Unknown --wf-time mode: %s (max, mean, first)\n", argv[i]);
+                return 0;
+            }
+        }
+        else if (strcmp(argv[i], "--wf-freq") == 0 && i + 1 < argc) {
+            if (!iqls_parse_pool(argv[++i], "nearest", &args->wf_freq)) {
+                fprintf(stderr, "Unknown --wf-freq mode: %s (max, mean, nearest)\n", argv[i]);
+                return 0;
+            }
+        }
         else {
             print_usage();
             return 0;
         }
     }
-    if (!args->in_path || !args->sample_rate || !args->fft_size || !args->hop_size || !args->avg_count || !args->out_prefix) {
+    // A summary preview needs no STFT geometry: the sidecar fixes it
+    if (args->summary && args->in_path && args->out_prefix) {
+        if (args->fft_size == 0) args->fft_size = IQ_SUMMARY_DEFAULT_FFT_SIZE;
+    } else if (!args->in_path || !args->sample_rate || !args->fft_size || !args->hop_size ||
+               (!args->avg_count && !args->raw) || !args->out_prefix) {
         print_usage();
         return 0;
     }
-    if (!fft_is_power_of_two(args->fft_size)) {
-        fprintf(stderr, "FFT size must be power of two\n");
+    if (args->summary && args->zoom) {
+        fprintf(stderr, "--zoom-span does not apply to --summary previews\n");
+        return 0;
+    }
+    if (args->zoom && args->sample_rate &&
+        (args->zoom_span >= args->sample_rate || fabs(args->zoom_center) > args->sample_rate / 2.0)) {
+        fprintf(stderr, "Zoom band %.0f Hz around %.0f Hz does not fit a %u Hz capture\n",
+                args->zoom_span, args->zoom_center, args->sample_rate);
+        return 0;
+    }
+    if (args->fft_size < 2 || args->fft_size > FFT_MAX_SIZE) {
+        fprintf(stderr, "FFT size must be between 2 and %u\n", (unsigned)FFT_MAX_SIZE);
+        return 0;
+    }
+    if (args->tile_size == 0) args->tile_size = TILE_PYRAMID_DEFAULT_TILE;
+    if (args->tile_size > 4096) {
+        fprintf(stderr, "Tile size must be between 1 and 4096\n");
+        return 0;
+    }
+    window_type_t window_type;
+    if (args->window && !window_type_from_name(args->window, &window_type)) {
+        fprintf(stderr, "Unknown window: %s\n", args->window);
         return 0;
     }
     return 1;
 }
 
-int main(int argc, char **argv) {
+/*
+ * Preview from the summary sidecar (<in>.iqsum), built in one pass when it
+ * is missing or stale: the spectrum averages every stored interval, the
+ * waterfall pools intervals into graph rows like the sweep pools frames and
+ * the power plot pools blocks. Nothing else reads the capture.
+ */
+static int iqls_summary_preview(const iqls_args_t *args) {
+    iq_summary_params_t params;
+    iq_summary_default_params(&params);
+    params.fft_size = args->fft_size;
+    if (params.block_samples % params.fft_size != 0) {
+        params.block_samples = ((params.block_samples + params.fft_size - 1) / params.fft_size) * params.fft_size;
+    }
+    params.sample_rate = args->sample_rate;
+    params.num_threads = args->threads;
+
+    iq_summary_t summary;
+    if (!iq_summary_open(args->in_path, false, true, &params, &summary)) {
+        fprintf(stderr, "Failed to summarise IQ file: %s\n", args->in_path);
+        return 1;
+    }
+    if (summary.num_spectra == 0) {
+        fprintf(stderr, "No frames processed\n");
+        iq_summary_free(&summary);
+        return 1;
+    }
+
+    const uint32_t sample_rate = args->sample_rate ? args->sample_rate : summary.sample_rate;
+    const uint32_t fft_size = summary.fft_size;
+    const double duration_s = (double)summary.total_samples / (double)sample_rate;
+    const uint32_t plot_width = iqls_image_width(fft_size) - IQLS_AXIS_MARGIN;
+    const uint32_t graph_height = IQLS_IMAGE_HEIGHT - 2 * IQLS_AXIS_MARGIN;
+
+    double *values = calloc(fft_size, sizeof(double));
+    // One row per graph line, each pooling its share of the intervals (or repeating one)
+    uint64_t wf_rows = args->waterfall ? graph_height : 0;
+    float *cols = wf_rows ? malloc((size_t)wf_rows * plot_width * sizeof(float)) : NULL;
+    bool *row_ok = wf_rows ? malloc((size_t)wf_rows * sizeof(bool)) : NULL;
+    double *pool_acc = wf_rows ? malloc(plot_width * sizeof(double)) : NULL;
+    if (!values || (wf_rows && (!cols || !row_ok || !pool_acc))) {
+        fprintf(stderr, "Allocation failed\n");
+        free(values); free(cols); free(row_ok); free(pool_acc);
+        iq_summary_free(&summary);
+        return 1;
+    }
+
+    for (uint64_t s = 0; s < summary.num_spectra; s++) {
+        const float *spectrum = summary.spectra + s * fft_size;
+        for (uint32_t k = 0; k < fft_size; k++) values[k] += spectrum[k];
+    }
+    for (uint32_t k = 0; k < fft_size; k++) {
+        double v = values[k] / (double)summary.num_spectra;
+        values[k] = args->logmag ? 10.0 * log10(v + 1e-12) : sqrt(v);
+    }
+    iqls_render_t render;
+    iqls_render_init(&render, args);
+    bool ok = iqls_render_spectrum(values, fft_size, sample_rate, 0.0, &render, args->out_prefix);
+
+    if (ok && wf_rows) {
+        double wf_min = 1e9, wf_max = -1e9;
+        for (uint64_t row = 0; row < wf_rows; row++) {
+            uint64_t s0 = row * summary.num_spectra / wf_rows;
+            uint64_t s1 = (row + 1) * summary.num_spectra / wf_rows;
+            if (s1 <= s0 || args->wf_time == IQLS_POOL_NONE) s1 = s0 + 1;
+            for (uint64_t s = s0; s < s1; s++) {
+                const float *power = summary.spectra + s * fft_size;
+                for (uint32_t x = 0; x < plot_width; x++) {
+                    uint32_t b0 = (uint32_t)(x * (double)fft_size / (double)plot_width);
+                    uint32_t b1 = (uint32_t)((x + 1) * (double)fft_size / (double)plot_width);
+                    if (b0 >= fft_size) b0 = fft_size - 1;
+                    if (b1 <= b0) b1 = b0 + 1;
+                    if (b1 > fft_size) b1 = fft_size;
+                    float p = iqls_pool_bins(power, b0, b1, args->wf_freq);
+                    if (s == s0) pool_acc[x] = p;
+                    else if (args->wf_time == IQLS_POOL_MAX) { if (p > pool_acc[x]) pool_acc[x] = p; }
+                    else pool_acc[x] += p;
+                }
+            }
+            float *dst = cols + row * plot_width;
+            for (uint32_t x = 0; x < plot_width; x++) {
+                double p = args->wf_time == IQLS_POOL_MEAN ? pool_acc[x] / (double)(s1 - s0) : pool_acc[x];
+                double v = iqls_waterfall_value((float)p, args->logmag);
+                if (v < wf_min) wf_min = v;
+                if (v > wf_max) wf_max = v;
+                dst[x] = (float)v;
+            }
+            row_ok[row] = true;
+        }
+        iqls_render_waterfall(cols, row_ok, wf_rows, wf_min, wf_max, duration_s,
+                              sample_rate, 0.0, fft_size, &render, args->out_prefix);
+    }
+    if (ok) iqls_render_power(&summary, duration_s, &render, args->out_prefix);
+
+    free(values); free(cols); free(row_ok); free(pool_acc);
+    iq_summary_free(&summary);
+    return ok ? 0 : 1;
+}
+
+/*
+ * Zoom source: the capture mixed and decimated to the zoom band, served
+ * through the same monotonic span interface as iq_block_t. Only the spans
+ * being transformed and one input block are resident; the outputs inside
+ * the filters' group delay are dropped so reduced sample 0 lines up with
+ * capture sample 0.
+ */
+typedef struct {
+    iq_reader_t *reader;    // Source (not owned)
+    xlate_t xlate;
+    float *input;           // One block of capture samples
+    float *data;            // Reduced samples, 2 * capacity floats
+    size_t capacity;        // Longest span plus one block of outputs
+    uint64_t start;         // Reduced sample index of data[0]
+    size_t valid;           // Reduced samples held
+    uint64_t drop;          // Outputs still to discard (delay, hop gaps)
+    bool eof;
+} iqls_zoom_t;
+
+// Decimation that keeps the span within IQLS_ZOOM_PASSBAND of the reduced rate
+static uint32_t iqls_zoom_decimation(uint32_t sample_rate, double span) {
+    double factor = floor(IQLS_ZOOM_PASSBAND * (double)sample_rate / span);
+    return factor < 1.0 ? 1 : factor > (double)UINT32_MAX ? UINT32_MAX : (uint32_t)factor;
+}
+
+static bool iqls_zoom_init(iqls_zoom_t *zoom, iq_reader_t *reader, uint32_t sample_rate,
+                           double center_hz, double span_hz, size_t max_span) {
+    memset(zoom, 0, sizeof(*zoom));
+    uint32_t decimation = iqls_zoom_decimation(sample_rate, span_hz);
+    if (!xlate_init(&zoom->xlate, (double)sample_rate, center_hz, decimation, span_hz)) {
+        fprintf(stderr, "Failed to prepare the zoom decimator\n");
+        return false;
+    }
+    zoom->reader = reader;
+    zoom->capacity = max_span + IQLS_ZOOM_BLOCK_SAMPLES / decimation + 1;
+    zoom->input = malloc((size_t)IQLS_ZOOM_BLOCK_SAMPLES * 2 * sizeof(float));
+    zoom->data = malloc(zoom->capacity * 2 * sizeof(float));
+    if (!zoom->input || !zoom->data) {
+        fprintf(stderr, "Memory allocation failed for the zoom buffers\n");
+        free(zoom->input);
+        free(zoom->data);
+        xlate_free(&zoom->xlate);
+        return false;
+    }
+    zoom->drop = (uint64_t)llround(zoom->xlate.delay / decimation);
+    return true;
+}
+
+// Reduced samples [offset, offset + length); NULL once the capture runs out
+static const float *iqls_zoom_span(iqls_zoom_t *zoom, uint64_t offset, size_t length) {
+    if (offset < zoom->start || length + IQLS_ZOOM_BLOCK_SAMPLES / zoom->xlate.decimation + 1 > zoom->capacity) {
+        return NULL;
+    }
+
+    if (offset + length > zoom->start + zoom->valid) {
+        // Keep the overlap, skip a gap a sparse hop leaves
+        uint64_t consumed = offset - zoom->start;
+        if (consumed >= zoom->valid) {
+            zoom->drop += consumed - zoom->valid;
+            zoom->valid = 0;
+        } else {
+            zoom->valid -= (size_t)consumed;
+            memmove(zoom->data, zoom->data + (size_t)consumed * 2, zoom->valid * 2 * sizeof(float));
+        }
+        zoom->start = offset;
+
+        while (zoom->valid < length && !zoom->eof) {
+            size_t got = iq_read_samples(zoom->reader, zoom->input, IQLS_ZOOM_BLOCK_SAMPLES);
+            if (got == 0) {
+                zoom->eof = true;
+                break;
+            }
+            uint64_t t = iq_profile_begin();
+            float *out = zoom->data + zoom->valid * 2;
+            size_t made = xlate_process(&zoom->xlate, zoom->input, got, out);
+            iq_profile_end(IQ_PROFILE_FILTER, t, got, got * 2 * sizeof(float));
+
+            size_t skip = zoom->drop < made ? (size_t)zoom->drop : made;
+            if (skip) memmove(out, out + skip * 2, (made - skip) * 2 * sizeof(float));
+            zoom->drop -= skip;
+            zoom->valid += made - skip;
+        }
+        if (zoom->valid < length) return NULL;
+    }
+
+    return zoom->data + (size_t)(offset - zoom->start) * 2;
+}
+
+// Reduced samples a capture of 'total' samples yields (one per decimation, less the delay)
+static uint64_t iqls_zoom_length(const iqls_zoom_t *zoom, uint64_t total) {
+    uint64_t made = total / zoom->xlate.decimation;
+    return made > zoom->drop ? made - zoom->drop : 0;
+}
+
+static void iqls_zoom_free(iqls_zoom_t *zoom) {
+    free(zoom->input);
+    free(zoom->data);
+    xlate_free(&zoom->xlate);
+    memset(zoom, 0, sizeof(*zoom));
+}
+
+// Tool entry point (also called in process by iqjob, see src/jobs/tools.h)
+int iqls_main(int argc, char **argv) {
     iqls_args_t args;
     if (!parse_args(argc, argv, &args)) return 1;
+    if (args.summary) return iqls_summary_preview(&args);
 
-    iq_data_t iq = {0};
-    if (!iq_load_file(args.in_path, &iq)) {
+    // Stream the input; only the frames being transformed are resident
+    iq_reader_t reader;
+    if (!iq_reader_open(&reader, args.in_path)) {
         fprintf(stderr, "Failed to load IQ file: %s\n", args.in_path);
         return 1;
     }
-    if (args.sample_rate) iq.sample_rate = args.sample_rate;
-    if (iq.sample_rate == 0) {
+    uint64_t num_samples = reader.total_samples;
+    uint32_t sample_rate = args.sample_rate ? args.sample_rate : reader.sample_rate;
+    if (sample_rate == 0) {
         fprintf(stderr, "Sample rate required\n");
-        iq_free(&iq);
+        iq_reader_close(&reader);
         return 1;
     }
+    // With --zoom-span every count below is in reduced samples
+    double center_hz = args.zoom ? args.zoom_center : 0.0;
+    double stream_rate = sample_rate;
 
     // Set reasonable image dimensions with good aspect ratio
-    const uint32_t max_width = 1024;  // Maximum readable width
-    const uint32_t width = args.fft_size > max_width ? max_width : args.fft_size;
-    const uint32_t height = 512;  // Fixed height for good readability
-    const uint32_t axis_margin = 60;
+    const uint32_t width = iqls_image_width(args.fft_size);
+    const uint32_t height = IQLS_IMAGE_HEIGHT;
+    const uint32_t axis_margin = IQLS_AXIS_MARGIN;
+    iqls_render_t render;
+    iqls_render_init(&render, &args);
 
     // Prepare FFT
-    fft_plan_t *plan = fft_plan_create(args.fft_size, FFT_FORWARD);
+    fft_plan_f32_t *plan = fft_plan_f32_create(args.fft_size, FFT_FORWARD);
     if (!plan) {
         fprintf(stderr, "Failed to create FFT plan\n");
-        iq_free(&iq);
+        iq_reader_close(&reader);
         return 1;
     }
-    fft_complex_t *in = malloc(args.fft_size * sizeof(fft_complex_t));
-    fft_complex_t *out = malloc(args.fft_size * sizeof(fft_complex_t));
-    fft_complex_t *shifted = malloc(args.fft_size * sizeof(fft_complex_t));
-    double *accum = calloc(args.fft_size, sizeof(double));
-    if (!in || !out || !shifted || !accum) {
-        fprintf(stderr, "Allocation failed\n");
-        free(in); free(out); free(shifted); free(accum);
-        fft_plan_destroy(plan);
-        iq_free(&iq);
+    // Shared window table; rectangular frames go straight to the FFT
+    const window_t *window = NULL;
+    window_type_t window_type = WINDOW_RECTANGULAR;
+    if (args.window) window_type_from_name(args.window, &window_type);
+    if (window_type != WINDOW_RECTANGULAR) {
+        double param = (window_type == WINDOW_KAISER) ? WINDOW_KAISER_DEFAULT_BETA : 0.0;
+        window = window_acquire(window_type, args.fft_size, param);
+        if (!window) {
+            fprintf(stderr, "Failed to create %s window\n", window_type_name(window_type));
+            fft_plan_f32_destroy(plan);
+            iq_reader_close(&reader);
+            return 1;
+        }
+    }
+    const float *taps = window ? window->coefficients_f32 : NULL;
+
+    // In a fused iqjob step the rows come from a shared STFT pass instead
+    uint32_t bus_subscriber = 0;
+    spectral_bus_t *bus = args.zoom ? NULL :
+                          spectral_bus_bound(args.in_path, args.fft_size, args.hop_size,
+                                             window_type, SPECTRAL_BUS_F32, &bus_subscriber);
+
+    stft_t *stft = stft_create(plan, taps, args.threads);
+    if (!stft) {
+        window_release(window);
+        fft_plan_f32_destroy(plan);
+        iq_reader_close(&reader);
         return 1;
     }
 
-    // Average spectra over K frames
-    uint64_t frames_done = 0;
-    uint64_t offset = 0;
-    while (frames_done < args.avg_count) {
-        if (offset + args.fft_size >= iq.num_samples) break;
-        for (uint32_t i = 0; i < args.fft_size; i++) {
-            float i_val = iq.data[(offset + i) * 2];
-            float q_val = iq.data[(offset + i) * 2 + 1];
-            in[i] = i_val + q_val * I;
+    // Optional device STFT; without a usable device the pool does the work
+    gpu_context_t *gpu = NULL;
+    gpu_stft_t *gpu_stft = NULL;
+    if (args.gpu && !bus) {
+        gpu = gpu_open(NULL);
+        if (gpu) gpu_stft = gpu_stft_create(gpu, args.fft_size, taps, GPU_SAMPLES_F32);
+        if (gpu_stft) {
+            stft_set_backend(stft, gpu_stft_backend_rows, gpu_stft);
+            printf("STFT on %s\n", gpu_device_name(gpu));
+        } else {
+            fprintf(stderr, "GPU unavailable; using %u CPU threads\n", stft->num_threads);
         }
-        if (!fft_execute(plan, in, out)) break;
-        if (!fft_shift(out, shifted, args.fft_size)) break;
+    }
 
-        for (uint32_t k = 0; k < args.fft_size; k++) {
-            double p = creal(shifted[k]) * creal(shifted[k]) + cimag(shifted[k]) * cimag(shifted[k]);
-            accum[k] += p;
-        }
+    // Each worker takes a slice of a batch; keep a slice near 256K bins. A
+    // device takes thousands of frames per dispatch instead.
+    uint32_t slice_frames = args.fft_size >= IQLS_BATCH_BINS ? 1 : IQLS_BATCH_BINS / args.fft_size;
+    if (slice_frames > IQLS_MAX_BATCH_FRAMES) slice_frames = IQLS_MAX_BATCH_FRAMES;
+    uint32_t batch_frames = gpu_stft ? IQLS_GPU_BATCH_FRAMES : slice_frames * stft->num_threads;
 
-        frames_done++;
-        offset += args.hop_size;
+    // Sparse hops would make a batch span mostly skipped samples; bound it
+    if ((uint64_t)(batch_frames - 1) * args.hop_size + args.fft_size > IQLS_MAX_SPAN_SAMPLES) {
+        uint64_t fit = args.fft_size < IQLS_MAX_SPAN_SAMPLES ?
+                       (IQLS_MAX_SPAN_SAMPLES - args.fft_size) / args.hop_size + 1 : 1;
+        batch_frames = fit < stft->num_threads ? stft->num_threads : (uint32_t)fit;
     }
-    if (frames_done == 0) {
-        fprintf(stderr, "No frames processed\n");
-        free(in); free(out); free(shifted); free(accum);
-        fft_plan_destroy(plan);
-        iq_free(&iq);
+
+    // The block holds one batch: (batch - 1) hops plus a frame; a zoom
+    // holds one batch of reduced samples instead
+    size_t batch_span = (size_t)(batch_frames - 1) * args.hop_size + args.fft_size;
+    iq_block_t block;
+    iqls_zoom_t zoom;
+    bool block_ok;
+    if (args.zoom) {
+        memset(&block, 0, sizeof(block));
+        block_ok = iqls_zoom_init(&zoom, &reader, sample_rate, args.zoom_center, args.zoom_span, batch_span);
+        if (block_ok) {
+            num_samples = iqls_zoom_length(&zoom, num_samples);
+            printf("Zoom: %.0f Hz around %.0f Hz, decimation %u to %.3f Hz, %.4f Hz per bin\n",
+                   args.zoom_span, args.zoom_center, zoom.xlate.decimation,
+                   xlate_output_rate(&zoom.xlate), xlate_output_rate(&zoom.xlate) / args.fft_size);
+            stream_rate = xlate_output_rate(&zoom.xlate);
+            sample_rate = (uint32_t)lround(stream_rate);
+        }
+    } else {
+        block_ok = iq_block_init(&block, &reader, batch_span);
+    }
+
+    float *rows = malloc((size_t)batch_frames * args.fft_size * sizeof(float));
+    double *accum = calloc(args.fft_size, sizeof(double));
+    // EMA over K frames: the weight whose mean age matches a K-frame average
+    psd_t psd;
+    bool psd_ok = psd_init(&psd, args.fft_size, args.psd_avg,
+                           args.avg_count ? 2.0 / (args.avg_count + 1.0) : 1.0);
+    if (!block_ok || !rows || !accum || !psd_ok) {
+        fprintf(stderr, "Allocation failed\n");
+        if (psd_ok) psd_free(&psd);
+        if (block_ok && args.zoom) iqls_zoom_free(&zoom);
+        else if (block_ok) iq_block_free(&block);
+        free(rows); free(accum);
+        stft_destroy(stft);
+        gpu_stft_destroy(gpu_stft);
+        gpu_close(gpu);
+        window_release(window);
+        fft_plan_f32_destroy(plan);
+        iq_reader_close(&reader);
         return 1;
     }
-    for (uint32_t k = 0; k < args.fft_size; k++) accum[k] /= (double)frames_done;
 
-    // Normalize to dBFS range
-    double min_db = 1e9, max_db = -1e9;
-    for (uint32_t k = 0; k < args.fft_size; k++) {
-        double v = accum[k];
-        double db = args.logmag ? 10.0 * log10(v + 1e-12) : sqrt(v);
-        if (db < min_db) min_db = db;
-        if (db > max_db) max_db = db;
-        accum[k] = db;
+    // Average spectra over K frames. Interleaved float I/Q already has the
+    // float complex layout, so frames are read in place at hop stride.
+    uint64_t frames_avail = 0;
+    if (num_samples > args.fft_size) {
+        frames_avail = (num_samples - args.fft_size - 1) / args.hop_size + 1;
     }
+    uint64_t frames_total = frames_avail < args.avg_count ? frames_avail : args.avg_count;
 
-    png_image_t img;
-    if (!png_image_init(&img, width, height)) {
-        fprintf(stderr, "Image init failed\n");
-        free(in); free(out); free(shifted); free(accum);
-        fft_plan_destroy(plan);
-        iq_free(&iq);
-        return 1;
+    // Waterfall: every frame of the capture at the same hop, pooled K at a
+    // time into at most one row per graph line ("first" keeps only the
+    // leading graph_height frames instead)
+    uint32_t graph_height = height - 2 * axis_margin;
+    uint32_t plot_width = width - axis_margin;
+    uint64_t wf_frames = 0, wf_rows = 0, wf_pool = 1;
+    if (args.waterfall && num_samples > args.fft_size) {
+        wf_frames = (uint64_t)(num_samples - args.fft_size) / args.hop_size + 1;
+        if (args.wf_time == IQLS_POOL_NONE) {
+            if (wf_frames > graph_height) wf_frames = graph_height;
+        } else {
+            wf_pool = (wf_frames + graph_height - 1) / graph_height;
+        }
+        wf_rows = (wf_frames + wf_pool - 1) / wf_pool;
+    }
+    // Pooled rows are kept for rendering once the colour range is known;
+    // time pooling itself streams through one plot_width accumulator
+    float *cols = NULL;
+    bool *row_ok = NULL;
+    float *pixels = NULL;
+    double *pool_acc = NULL;
+    if (wf_rows) {
+        cols = malloc((size_t)wf_rows * plot_width * sizeof(float));
+        row_ok = calloc(wf_rows, sizeof(bool));
+        pixels = malloc(plot_width * sizeof(float));
+        pool_acc = malloc(plot_width * sizeof(double));
+        if (!cols || !row_ok || !pixels || !pool_acc) {
+            fprintf(stderr, "Waterfall allocation failed\n");
+            free(cols); free(row_ok); free(pixels); free(pool_acc);
+            cols = NULL; row_ok = NULL; pixels = NULL; pool_acc = NULL;
+            wf_frames = wf_rows = 0;
+        }
     }
-    png_image_fill(&img, 10, 10, 10);
 
-    // Axes
-    draw_db_scale(img.data, width, height, axis_margin, min_db, max_db, 255, 200, 0);
-    draw_frequency_axis(img.data, width, height, axis_margin, 0.0, iq.sample_rate, args.fft_size, 255, 200, 0);
+    // Tile pyramid: every frame, every bin, linear power; levels continue
+    // until one tile covers the whole map
+    uint64_t pyr_frames = 0;
+    tile_pyramid_writer_t pyramid;
+    bool pyramid_ok = false;
+    char pyr_path[1024];
+    if (args.pyramid && num_samples > args.fft_size) {
+        pyr_frames = (uint64_t)(num_samples - args.fft_size) / args.hop_size + 1;
+        tile_pyramid_info_t info = {0};
+        info.tile_size = args.tile_size;
+        info.num_levels = tile_pyramid_levels_for(args.fft_size, pyr_frames, args.tile_size);
+        info.width = args.fft_size;
+        info.pool = args.wf_time == IQLS_POOL_MEAN ? TILE_POOL_MEAN : TILE_POOL_MAX;
+        info.sample_rate = sample_rate;
+        info.row_seconds = (double)args.hop_size / stream_rate;
+        info.freq_step_hz = stream_rate / args.fft_size;
+        info.freq_start_hz = center_hz - (double)(args.fft_size / 2) * info.freq_step_hz;
+        snprintf(pyr_path, sizeof(pyr_path), "%s_tiles.iqpyr", args.out_prefix);
+        pyramid_ok = tile_pyramid_writer_open(&pyramid, pyr_path, &info);
+        if (pyramid_ok && !tile_pyramid_writer_reserve(&pyramid, pyr_frames)) {
+            tile_pyramid_writer_close(&pyramid);
+            pyramid_ok = false;
+        }
+        if (!pyramid_ok) pyr_frames = 0;
+    }
 
-    // Plot
-    for (uint32_t x = axis_margin; x < width; x++) {
-        uint32_t bin = (uint32_t)((x - axis_margin) * (double)args.fft_size / (double)(width - axis_margin));
-        if (bin >= args.fft_size) continue;
-        double norm = (accum[bin] - min_db) / (max_db - min_db + 1e-12);
-        if (norm < 0.0) {
-            norm = 0.0;
-        } else if (norm > 1.0) {
-            norm = 1.0;
+    // Full waterfall: every frame at every bin, streamed row by row. Without
+    // --wf-range the colours are scaled to the first batch of frames.
+    uint64_t full_frames = 0;
+    png_stream_t full_png;
+    uint8_t *full_rgb = NULL;
+    float *full_values = NULL;
+    bool full_ok = false;
+    double full_min = args.wf_range_min, full_max = args.wf_range_max;
+    char full_path[1024];
+    if (args.wf_full && num_samples > args.fft_size) {
+        full_frames = (uint64_t)(num_samples - args.fft_size) / args.hop_size + 1;
+        snprintf(full_path, sizeof(full_path), "%s_waterfall_full.png", args.out_prefix);
+        full_rgb = malloc((size_t)args.fft_size * 3);
+        full_values = malloc((size_t)args.fft_size * sizeof(float));
+        if (full_frames > 0x7FFFFFFFu) {
+            fprintf(stderr, "Too many frames for one PNG (%llu); raise --hop\n", (unsigned long long)full_frames);
+        } else if (full_rgb && full_values) {
+            full_ok = png_stream_open(&full_png, full_path, args.fft_size, (uint32_t)full_frames);
+            if (full_ok) png_stream_set_level(&full_png, args.png_level);
         }
-        uint8_t r, g, b; png_intensity_to_color((float)norm, &r, &g, &b);
-        for (uint32_t y = axis_margin; y < height - axis_margin; y++) {
-            png_image_set_pixel(&img, x, y, r, g, b);
+        if (!full_ok) {
+            free(full_rgb);
+            free(full_values);
+            full_rgb = NULL;
+            full_values = NULL;
+            full_frames = 0;
         }
     }
 
-    char out_path[512];
-    snprintf(out_path, sizeof(out_path), "%s_spectrum.png", args.out_prefix);
-    if (!png_image_write(&img, out_path)) {
-        fprintf(stderr, "Failed to write %s\n", out_path);
-    } else {
-        printf("Wrote %s\n", out_path);
+    // Raw spectrogram: every frame at every bin as a .npy matrix, linear
+    // power (dB with --logmag), no colour scaling and no image encoding
+    uint64_t raw_frames = 0;
+    npy_stream_t raw;
+    float *raw_values = NULL;
+    bool raw_ok = false;
+    char raw_path[1024];
+    if (args.raw && num_samples > args.fft_size) {
+        raw_frames = (uint64_t)(num_samples - args.fft_size) / args.hop_size + 1;
+        snprintf(raw_path, sizeof(raw_path), "%s_spectrogram.npy", args.out_prefix);
+        if (args.logmag) raw_values = malloc((size_t)batch_frames * args.fft_size * sizeof(float));
+        if (!args.logmag || raw_values) raw_ok = npy_stream_open(&raw, raw_path, args.raw_dtype, args.fft_size);
+        if (!raw_ok) {
+            free(raw_values);
+            raw_values = NULL;
+            raw_frames = 0;
+        }
     }
 
-    png_image_free(&img);
-    
-    // Optional: Waterfall image
-    if (args.waterfall) {
-        png_image_t wimg;
-        if (!png_image_init(&wimg, width, height)) {
-            fprintf(stderr, "Waterfall image init failed\n");
+    // One sweep feeds every output: each frame is transformed once, summed
+    // if it is among the averaged frames, pooled into a waterfall row,
+    // streamed into the full waterfall and the raw matrix, and pushed into
+    // the pyramid
+    uint64_t sweep_frames = frames_total > wf_frames ? frames_total : wf_frames;
+    if (full_frames > sweep_frames) sweep_frames = full_frames;
+    if (pyr_frames > sweep_frames) sweep_frames = pyr_frames;
+    if (raw_frames > sweep_frames) sweep_frames = raw_frames;
+    uint64_t frames_done = 0;
+    uint64_t pooled = 0;
+    double wf_min = 1e9, wf_max = -1e9;
+
+    // FFT scratch for this thread and the pool comes from one reservation;
+    // after the first batch the sweep allocates nothing
+    iq_arena_t arena;
+    bool arena_ok = iq_arena_init(&arena, (size_t)stft->num_threads * fft_scratch_bytes(args.fft_size));
+    iq_arena_t *prev_arena = iq_arena_bind(arena_ok ? &arena : NULL);
+    for (uint64_t first = 0; first < sweep_frames; ) {
+        uint32_t count = batch_frames;
+        if (sweep_frames - first < count) count = (uint32_t)(sweep_frames - first);
+
+        if (bus) {
+            if (spectral_bus_read_f32(bus, bus_subscriber, rows, count) != count) break;
         } else {
-            png_image_fill(&wimg, 10, 10, 10);
+            size_t span = (size_t)(count - 1) * args.hop_size + args.fft_size;
+            const float *samples = args.zoom ? iqls_zoom_span(&zoom, first * args.hop_size, span) :
+                                   iq_block_span(&block, first * args.hop_size, span);
+            if (!samples) break;
+            uint64_t t = iq_profile_begin();
+            bool ok = stft_rows(stft, samples, count, args.hop_size, rows, false);
+            iq_profile_end(IQ_PROFILE_FFT, t, (uint64_t)count * args.fft_size, 0);
+            if (!ok) break;
+        }
 
-            // Determine number of frames by available samples
-            uint32_t hop = args.hop_size;
-            uint64_t max_frames = 0;
-            if (iq.num_samples > args.fft_size && hop > 0) {
-                max_frames = (uint64_t)(iq.num_samples - args.fft_size) / hop + 1;
+        if (first < frames_total) {
+            uint32_t sum_count = frames_total - first < count ? (uint32_t)(frames_total - first) : count;
+            uint64_t t = iq_profile_begin();
+            bool ok = stft_accumulate_psd(stft, rows, sum_count, &psd);
+            iq_profile_end(IQ_PROFILE_FFT, t, (uint64_t)sum_count * args.fft_size, 0);
+            if (!ok) break;
+            frames_done += sum_count;
+        }
+
+        uint64_t encode_start = iq_profile_begin();
+        if (full_ok && first == 0 && !args.wf_range_set) {
+            full_min = 1e9;
+            full_max = -1e9;
+            for (size_t k = 0; k < (size_t)count * args.fft_size; k++) {
+                double v = iqls_waterfall_value(rows[k], args.logmag);
+                if (v < full_min) full_min = v;
+                if (v > full_max) full_max = v;
             }
-            // Calculate available graph height (between top and bottom margins)
-            uint32_t graph_height = height - 2 * axis_margin;
-            if (max_frames > graph_height) max_frames = graph_height;
-
-            // Precompute global min/max for consistent scaling
-            double wf_min = 1e9, wf_max = -1e9;
-            for (uint64_t fidx = 0, off = 0; fidx < max_frames; fidx++, off += hop) {
-                for (uint32_t i = 0; i < args.fft_size; i++) {
-                    float i_val = iq.data[(off + i) * 2];
-                    float q_val = iq.data[(off + i) * 2 + 1];
-                    in[i] = i_val + q_val * I;
-                }
-                if (!fft_execute(plan, in, out) || !fft_shift(out, shifted, args.fft_size)) continue;
-                for (uint32_t k = 0; k < args.fft_size; k++) {
-                    double p = creal(shifted[k]) * creal(shifted[k]) + cimag(shifted[k]) * cimag(shifted[k]);
-                    double db = args.logmag ? 10.0 * log10(p + 1e-12) : sqrt(p);
-                    if (db < wf_min) wf_min = db;
-                    if (db > wf_max) wf_max = db;
-                }
+            if (full_max <= full_min) full_max = full_min + 1.0;
+        }
+        for (uint32_t f = 0; full_ok && f < count && first + f < full_frames; f++) {
+            const float *power = rows + (size_t)f * args.fft_size;
+            for (uint32_t k = 0; k < args.fft_size; k++) {
+                full_values[k] = (float)iqls_waterfall_value(power[k], args.logmag);
             }
-            if (wf_max <= wf_min) { wf_max = wf_min + 1.0; }
-
-            // Render rows from bottom up (older at bottom)
-            for (uint64_t fidx = 0, off = 0; fidx < max_frames; fidx++, off += hop) {
-                for (uint32_t i = 0; i < args.fft_size; i++) {
-                    float i_val = iq.data[(off + i) * 2];
-                    float q_val = iq.data[(off + i) * 2 + 1];
-                    in[i] = i_val + q_val * I;
-                }
-                if (!fft_execute(plan, in, out) || !fft_shift(out, shifted, args.fft_size)) continue;
-
-                // Scale frame index to available graph height (newest at top, oldest at bottom)
-                double scale_factor = (double)graph_height / (double)max_frames;
-                uint32_t y = axis_margin + (uint32_t)((max_frames - 1 - fidx) * scale_factor);
-                if (y >= height - axis_margin) continue;
-                for (uint32_t x = axis_margin; x < width; x++) {
-                    uint32_t bin = (uint32_t)((x - axis_margin) * (double)args.fft_size / (double)(width - axis_margin));
-                    if (bin >= args.fft_size) continue;
-                    double p = creal(shifted[bin]) * creal(shifted[bin]) + cimag(shifted[bin]) * cimag(shifted[bin]);
-                    double db = args.logmag ? 10.0 * log10(p + 1e-12) : sqrt(p);
-                    double norm = (db - wf_min) / (wf_max - wf_min + 1e-12);
-                    if (norm < 0.0) norm = 0.0; else if (norm > 1.0) norm = 1.0;
-                    uint8_t r,g,b; png_intensity_to_color((float)norm, &r, &g, &b);
-                    png_image_set_pixel(&wimg, x, y, r, g, b);
+            colormap_map_row(&render.cmap, full_values, args.fft_size, (float)full_min, (float)full_max, full_rgb);
+            if (!png_stream_write_row(&full_png, full_rgb)) full_ok = false;
+        }
+
+        if (raw_ok && first < raw_frames) {
+            uint32_t raw_count = raw_frames - first < count ? (uint32_t)(raw_frames - first) : count;
+            const float *raw_rows = rows;
+            if (args.logmag) {
+                for (size_t k = 0; k < (size_t)raw_count * args.fft_size; k++) {
+                    raw_values[k] = (float)iqls_waterfall_value(rows[k], 1);
                 }
+                raw_rows = raw_values;
             }
+            if (!npy_stream_write_rows(&raw, raw_rows, raw_count)) raw_ok = false;
+        }
+
+        for (uint32_t f = 0; pyramid_ok && f < count && first + f < pyr_frames; f++) {
+            if (!tile_pyramid_writer_push(&pyramid, rows + (size_t)f * args.fft_size)) pyramid_ok = false;
+        }
+        iq_profile_end(IQ_PROFILE_ENCODE, encode_start, (uint64_t)count * args.fft_size, 0);
 
-            // Axes
-            double duration_s = (double)iq.num_samples / (double)iq.sample_rate;
-            draw_time_axis(wimg.data, width, height, axis_margin, duration_s, 0, 255, 200, 0);
-            draw_frequency_axis(wimg.data, width, height, axis_margin, 0.0, iq.sample_rate, args.fft_size, 255, 200, 0);
-
-            char wpath[512];
-            snprintf(wpath, sizeof(wpath), "%s_waterfall.png", args.out_prefix);
-            if (!png_image_write(&wimg, wpath)) {
-                fprintf(stderr, "Failed to write %s\n", wpath);
-            } else {
-                printf("Wrote %s\n", wpath);
+        for (uint32_t f = 0; f < count && first + f < wf_frames; f++) {
+            // Frequency pooling: pixel x covers bins [b(x), b(x + 1))
+            const float *power = rows + (size_t)f * args.fft_size;
+            for (uint32_t x = 0; x < plot_width; x++) {
+                uint32_t b0 = (uint32_t)(x * (double)args.fft_size / (double)plot_width);
+                uint32_t b1 = (uint32_t)((x + 1) * (double)args.fft_size / (double)plot_width);
+                if (b0 >= args.fft_size) b0 = args.fft_size - 1;
+                if (b1 <= b0) b1 = b0 + 1;
+                if (b1 > args.fft_size) b1 = args.fft_size;
+                pixels[x] = iqls_pool_bins(power, b0, b1, args.wf_freq);
             }
-            png_image_free(&wimg);
+
+            // Time pooling in linear power, oldest frame first
+            for (uint32_t x = 0; x < plot_width; x++) {
+                if (pooled == 0) pool_acc[x] = pixels[x];
+                else if (args.wf_time == IQLS_POOL_MAX) { if (pixels[x] > pool_acc[x]) pool_acc[x] = pixels[x]; }
+                else pool_acc[x] += pixels[x];
+            }
+            pooled++;
+
+            uint64_t frame = first + f;
+            if (pooled < wf_pool && frame + 1 < wf_frames) continue;
+
+            uint64_t row = frame / wf_pool;
+            float *dst = cols + row * plot_width;
+            for (uint32_t x = 0; x < plot_width; x++) {
+                double p = args.wf_time == IQLS_POOL_MEAN ? pool_acc[x] / (double)pooled : pool_acc[x];
+                double v = iqls_waterfall_value((float)p, args.logmag);
+                if (v < wf_min) wf_min = v;
+                if (v > wf_max) wf_max = v;
+                dst[x] = (float)v;
+            }
+            row_ok[row] = true;
+            pooled = 0;
         }
+
+        first += count;
+        iq_alloc_guard(true);
+    }
+    iq_alloc_guard(false);
+    iq_arena_bind(prev_arena);
+    if (arena_ok) iq_arena_free(&arena);
+    if (bus) spectral_bus_detach(bus, bus_subscriber);
+    free(pixels);
+    free(pool_acc);
+    if (args.zoom) iqls_zoom_free(&zoom);
+    else iq_block_free(&block);
+    if (full_frames) {
+        bool wrote = png_stream_close(&full_png) && full_ok;
+        if (wrote) printf("Wrote %s\n", full_path);
+        else fprintf(stderr, "Failed to write %s\n", full_path);
+        free(full_rgb);
+        free(full_values);
+    }
+    if (args.pyramid && pyr_frames) {
+        bool wrote = tile_pyramid_writer_close(&pyramid) && pyramid_ok;
+        if (wrote) printf("Wrote %s\n", pyr_path);
+        else fprintf(stderr, "Failed to write %s\n", pyr_path);
+    }
+    int status = 0;
+    if (raw_frames) {
+        bool wrote = npy_stream_close(&raw) && raw_ok;
+        if (wrote) printf("Wrote %s (%llu x %u)\n", raw_path, (unsigned long long)raw.rows_written, args.fft_size);
+        else fprintf(stderr, "Failed to write %s\n", raw_path);
+        free(raw_values);
+        if (!wrote && args.avg_count == 0) status = 1;
+    }
+    if (frames_done == 0 && !raw_frames) {
+        fprintf(stderr, "No frames processed\n");
+        free(rows); free(accum); free(cols); free(row_ok);
+        psd_free(&psd);
+        stft_destroy(stft);
+        gpu_stft_destroy(gpu_stft);
+        gpu_close(gpu);
+        window_release(window);
+        fft_plan_f32_destroy(plan);
+        iq_reader_close(&reader);
+        return 1;
+    }
+
+    // dBFS (or magnitude) per bin; raw-only runs (no --avg) have no spectrum
+    if (frames_done) psd_result(&psd, accum, args.logmag);
+    for (uint32_t k = 0; frames_done && !args.logmag && k < args.fft_size; k++) {
+        accum[k] = sqrt(accum[k]);
+    }
+    uint64_t encode_start = iq_profile_begin();
+    bool rendered = !frames_done || iqls_render_spectrum(accum, args.fft_size, sample_rate, center_hz, &render, args.out_prefix);
+    iq_profile_end(IQ_PROFILE_ENCODE, encode_start, frames_done ? args.fft_size : 0, 0);
+    if (!rendered) {
+        free(rows); free(accum); free(cols); free(row_ok);
+        psd_free(&psd);
+        stft_destroy(stft);
+        gpu_stft_destroy(gpu_stft);
+        gpu_close(gpu);
+        window_release(window);
+        fft_plan_f32_destroy(plan);
+        iq_reader_close(&reader);
+        return 1;
     }
-    free(in); free(out); free(shifted); free(accum);
-    fft_plan_destroy(plan);
-    iq_free(&iq);
-    return 0;
-}
 
+    // Optional: Waterfall image (rows were pooled during the sweep)
+    if (args.waterfall) {
+        encode_start = iq_profile_begin();
+        iqls_render_waterfall(cols, row_ok, wf_rows, wf_min, wf_max,
+                              (double)num_samples / stream_rate,
+                              sample_rate, center_hz, args.fft_size, &render, args.out_prefix);
+        iq_profile_end(IQ_PROFILE_ENCODE, encode_start, wf_rows * plot_width, 0);
+    }
+    free(rows); free(accum); free(cols); free(row_ok);
+    psd_free(&psd);
+    stft_destroy(stft);
+    gpu_stft_destroy(gpu_stft);
+    gpu_close(gpu);
+    window_release(window);
+    fft_plan_f32_destroy(plan);
+    iq_reader_close(&reader);
+    return status;
+}
 
+#ifndef IQ_TOOL_LIBRARY
+int main(int argc, char **argv) {
+    return iqls_main(argc, argv);
+}
+#endif
@@ -0,0 +1,317 @@
+/*
+ * IQ Lab - iqtdoa: Time Difference of Arrival Between Receivers
+ *
+ * Purpose: Delays between two or more time-aligned captures of one emitter
+ *
+ *
+ * This tool streams the captures of up to GCC_PHAT_MAX_RECEIVERS receivers
+ * side by side and reports, per interval, the delay of every receiver
+ * behind every other one from the GCC-PHAT cross-correlation
+ * (src/tdoa/gcc_phat.h). With the receiver positions the delays locate
+ * the emitter; the geometry is left to the user.
+ *
+ * Key Features:
+ * - Alignment from SigMF captures: each file's first timed capture
+ *   (core:datetime less core:sample_start) gives its start time, and
+ *   the files are read from the latest start on
+ * - Overlap-save GCC-PHAT blocks on the FFT engine, lags within --max-delay
+ * - Sub-sample delays from an interpolated correlation peak
+ * - Receivers and pairs spread over --threads workers
+ * - Constant memory: only the current batch of blocks is held, so hours
+ *   of data stream through the same buffers
+ *
+ * Usage Examples:
+ *   # Three receivers with SigMF metadata, one estimate per second
+ *   iqtdoa.exe --in rx0.sigmf-data --in rx1.sigmf-data --in rx2.sigmf-data --max-delay 0.0002
+ *
+ *   # Raw files already started together, estimates to CSV every 10 s
+ *   iqtdoa.exe --in a.iq --in b.iq --rate 2000000 --max-lag 400 --interval 10 --out tdoa.csv
+ *
+ * Alignment:
+ * - Either every input has a timed capture or none: untimed inputs are
+ *   taken to start at the same instant (with a warning)
+ * - Start times are rounded to whole samples; the fraction left over is
+ *   added back to delay_s, so delay_samples is the lag between the
+ *   samples as read and delay_s the lag in true time
+ * - All inputs must share one sample rate
+ *
+ * Output (CSV, one row per pair and interval):
+ *   t_start_s,t_end_s,rx_a,rx_b,delay_samples,delay_s,peak,peak_ratio
+ * t is seconds from the common start; a positive delay means rx_b
+ * received the signal after rx_a. peak is the PHAT correlation (1 for a
+ * perfect match) and peak_ratio the peak over its largest sidelobe: a
+ * ratio near 1 means no common signal in that interval.
+ *
+ * --profile times the reads and FFTs (profile.h), on stderr at exit or as
+ * JSON with --profile=<file>; --trace=<file> writes a Chrome trace.
+ *
+ * Dependencies: IQ core, SigMF libraries, GCC-PHAT engine
+ * Thread Safety: Reads on the main thread, correlation on the engine's workers
+ * Error Handling: Parameter validation, unreadable or mismatched inputs refused
+ */
+
+#include "../src/iq_core/io_iq.h"
+#include "../src/iq_core/io_sigmf.h"
+#include "../src/iq_core/profile.h"
+#include "../src/tdoa/gcc_phat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#define IQTDOA_BLOCK_SAMPLES 65536   // Samples read per receiver and pass
+
+typedef struct {
+    const char *in_paths[GCC_PHAT_MAX_RECEIVERS];
+    uint32_t num_inputs;
+    const char *out_path;    // CSV (default: stdout)
+    uint32_t sample_rate;    // Overrides the metadata and WAV headers
+    double max_delay;        // Seconds (0: use max_lag)
+    uint32_t max_lag;        // Samples
+    uint32_t fft_size;       // 0: automatic
+    double interval;         // Seconds per estimate
+    uint32_t threads;        // 0: one per core
+} args_t;
+
+// One receiver's input
+typedef struct {
+    iq_reader_t reader;
+    bool opened;
+    uint32_t sample_rate;
+    bool timed;
+    double start_time;       // Seconds since the epoch of sample 0
+    uint64_t skip;           // Samples before the common start
+    double residual;         // Start of the first sample read, less the common start (s)
+    float *buffer;
+} receiver_t;
+
+static void usage(void) {
+    printf("Usage: iqtdoa --in <file> --in <file> [--in <file> ...] {--max-delay <s> | --max-lag <samples>}\n");
+    printf("              [--rate <Hz>] [--fft <N>] [--interval <s>] [--threads <N>] [--out <file.csv>]\n");
+    printf("              [--profile[=<file.json>]] [--trace=<file.json>]\n");
+    printf("       2 to %d inputs, aligned by their SigMF capture times when every one has them\n",
+           GCC_PHAT_MAX_RECEIVERS);
+    printf("       --rate may be omitted when SigMF metadata or a WAV header provides it\n");
+    printf("       --interval defaults to 1 s; --threads 0 (default) uses one per core\n");
+}
+
+static int parse_args(int argc, char **argv, args_t *a) {
+    memset(a, 0, sizeof(*a));
+    a->interval = 1.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--in") && i+1<argc) {
+            if (a->num_inputs == GCC_PHAT_MAX_RECEIVERS) { usage(); return 0; }
+            a->in_paths[a->num_inputs++] = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--out") && i+1<argc) a->out_path = argv[++i];
+        else if (!strcmp(argv[i], "--rate") && i+1<argc) a->sample_rate = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--max-delay") && i+1<argc) a->max_delay = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--max-lag") && i+1<argc) a->max_lag = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--fft") && i+1<argc) a->fft_size = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--interval") && i+1<argc) a->interval = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i+1<argc) a->threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (iq_profile_parse_arg("iqtdoa", argv[i])) continue;
+        else { usage(); return 0; }
+    }
+
+    if (a->num_inputs < 2 || (a->max_delay <= 0.0) == (a->max_lag == 0) || a->interval <= 0.0) {
+        usage();
+        return 0;
+    }
+    return 1;
+}
+
+// Open one input with its metadata: format, rate and start time
+static bool open_receiver(receiver_t *rx, const char *path, uint32_t rate_override) {
+    sigmf_metadata_t meta = {0};
+    bool have_meta = false;
+    if (sigmf_meta_file_exists(path)) {
+        char meta_path[512];
+        sigmf_get_meta_filename(path, meta_path, sizeof(meta_path));
+        if (!sigmf_read_metadata(meta_path, &meta)) {
+            fprintf(stderr, "Failed to read %s\n", meta_path);
+            return false;
+        }
+        have_meta = true;
+    }
+
+    if (have_meta) {
+        iq_format_t format;
+        switch (sigmf_parse_datatype(meta.global.datatype)) {
+            case SIGMF_DATATYPE_CI8:  format = IQ_FORMAT_S8;  break;
+            case SIGMF_DATATYPE_CI16: format = IQ_FORMAT_S16; break;
+            case SIGMF_DATATYPE_CI12: format = IQ_FORMAT_S12; break;
+            case SIGMF_DATATYPE_CI4:  format = IQ_FORMAT_S4;  break;
+            default:
+                fprintf(stderr, "%s: unsupported SigMF datatype '%s' (ci8/ci16/ci12/ci4 only)\n",
+                        path, meta.global.datatype);
+                sigmf_free_metadata(&meta);
+                return false;
+        }
+        rx->opened = iq_reader_init(&rx->reader, path, format);
+    } else {
+        rx->opened = iq_reader_open(&rx->reader, path);
+    }
+    if (!rx->opened) {
+        fprintf(stderr, "Failed to load %s\n", path);
+        sigmf_free_metadata(&meta);
+        return false;
+    }
+
+    rx->sample_rate = rate_override ? rate_override : rx->reader.sample_rate;
+    if (!rx->sample_rate && have_meta) rx->sample_rate = (uint32_t)meta.global.sample_rate;
+    if (have_meta) {
+        // Capture times are mapped through the rate actually used
+        meta.global.sample_rate = rx->sample_rate;
+        rx->timed = rx->sample_rate > 0 && sigmf_start_time(&meta, &rx->start_time);
+    }
+    sigmf_free_metadata(&meta);
+
+    rx->buffer = malloc(IQTDOA_BLOCK_SAMPLES * 2 * sizeof(float));
+    if (!rx->buffer) {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+    return true;
+}
+
+// Common start: the latest receiver start, each reader moved up to it
+static bool align_receivers(receiver_t *rx, uint32_t count, const char *const *paths, uint32_t sample_rate) {
+    uint32_t timed = 0;
+    for (uint32_t r = 0; r < count; r++) timed += rx[r].timed;
+    if (timed == 0) {
+        fprintf(stderr, "Warning: no SigMF capture times, assuming the inputs start together\n");
+        return true;
+    }
+    if (timed < count) {
+        for (uint32_t r = 0; r < count; r++) {
+            if (!rx[r].timed) fprintf(stderr, "%s has no SigMF capture time to align it by\n", paths[r]);
+        }
+        return false;
+    }
+
+    double common = rx[0].start_time;
+    for (uint32_t r = 1; r < count; r++) common = fmax(common, rx[r].start_time);
+    for (uint32_t r = 0; r < count; r++) {
+        rx[r].skip = (uint64_t)llround((common - rx[r].start_time) * sample_rate);
+        rx[r].residual = rx[r].start_time + (double)rx[r].skip / sample_rate - common;
+        if (rx[r].skip > 0 && !iq_reader_seek_sample(&rx[r].reader, rx[r].skip)) {
+            fprintf(stderr, "%s ends before the other inputs start\n", paths[r]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void write_results(FILE *out, const gcc_phat_result_t *results, uint32_t num_pairs,
+                          const receiver_t *rx, uint64_t from, uint64_t to, uint32_t sample_rate) {
+    for (uint32_t p = 0; p < num_pairs; p++) {
+        const gcc_phat_result_t *result = &results[p];
+        double delay_s = result->delay_samples / sample_rate + rx[result->rx_b].residual - rx[result->rx_a].residual;
+        fprintf(out, "%.6f,%.6f,%u,%u,%.4f,%.9e,%.4f,%.2f\n",
+                (double)from / sample_rate, (double)to / sample_rate, result->rx_a, result->rx_b,
+                result->delay_samples, delay_s, result->peak, result->peak_ratio);
+    }
+}
+
+int main(int argc, char **argv) {
+    args_t a; if (!parse_args(argc, argv, &a)) return 1;
+
+    receiver_t rx[GCC_PHAT_MAX_RECEIVERS];
+    memset(rx, 0, sizeof(rx));
+    bool ok = true;
+    for (uint32_t r = 0; ok && r < a.num_inputs; r++) {
+        ok = open_receiver(&rx[r], a.in_paths[r], a.sample_rate);
+    }
+
+    uint32_t sample_rate = ok ? rx[0].sample_rate : 0;
+    if (ok && sample_rate == 0) {
+        fprintf(stderr, "Sample rate required\n");
+        ok = false;
+    }
+    for (uint32_t r = 1; ok && r < a.num_inputs; r++) {
+        if (rx[r].sample_rate != sample_rate) {
+            fprintf(stderr, "%s is at %u Hz, %s at %u Hz: resample to one rate first\n",
+                    a.in_paths[r], rx[r].sample_rate, a.in_paths[0], sample_rate);
+            ok = false;
+        }
+    }
+    ok = ok && align_receivers(rx, a.num_inputs, a.in_paths, sample_rate);
+
+    gcc_phat_t *engine = NULL;
+    if (ok) {
+        gcc_phat_config_t config = {
+            .num_receivers = a.num_inputs,
+            .max_lag = a.max_lag ? a.max_lag : (uint32_t)ceil(a.max_delay * sample_rate),
+            .fft_size = a.fft_size,
+            .num_threads = a.threads,
+        };
+        engine = gcc_phat_create(&config);
+        ok = engine != NULL;
+    }
+
+    FILE *out = stdout;
+    if (ok && a.out_path) {
+        out = fopen(a.out_path, "w");
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", a.out_path);
+            ok = false;
+        }
+    }
+
+    uint64_t position = 0, interval_start = 0, estimates = 0;
+    gcc_phat_result_t results[GCC_PHAT_MAX_PAIRS];
+    if (ok) {
+        // Whole blocks per interval, so every estimate sums the same number
+        uint64_t block = engine->block_samples;
+        uint64_t interval = (uint64_t)llround(a.interval * sample_rate / block) * block;
+        if (interval == 0) interval = block;
+        uint32_t num_pairs = gcc_phat_num_pairs(engine);
+
+        fprintf(out, "t_start_s,t_end_s,rx_a,rx_b,delay_samples,delay_s,peak,peak_ratio\n");
+        for (;;) {
+            // The receivers advance together, as far as the shortest read
+            size_t want = (size_t)(interval_start + interval - position);
+            if (want > IQTDOA_BLOCK_SAMPLES) want = IQTDOA_BLOCK_SAMPLES;
+            size_t got = want;
+            uint64_t start = iq_profile_begin();
+            for (uint32_t r = 0; r < a.num_inputs; r++) {
+                size_t n = iq_read_samples(&rx[r].reader, rx[r].buffer, want);
+                if (n < got) got = n;
+            }
+            iq_profile_end(IQ_PROFILE_READ, start, got * a.num_inputs, got * a.num_inputs * 2 * sizeof(float));
+
+            const float *pointers[GCC_PHAT_MAX_RECEIVERS];
+            for (uint32_t r = 0; r < a.num_inputs; r++) pointers[r] = rx[r].buffer;
+            if (got > 0) gcc_phat_push(engine, pointers, got);
+            position += got;
+
+            if (got < want || position == interval_start + interval) {
+                if (gcc_phat_estimate(engine, results)) {
+                    write_results(out, results, num_pairs, rx, interval_start, position, sample_rate);
+                    estimates++;
+                }
+                interval_start = position;
+            }
+            if (got < want) break;
+        }
+    }
+
+    if (ok) {
+        fprintf(stderr, "%u receivers, %u pairs: %llu samples each (%.3f s), %llu estimate%s, %llu blocks of %u\n",
+                a.num_inputs, gcc_phat_num_pairs(engine), (unsigned long long)position,
+                (double)position / sample_rate, (unsigned long long)estimates, estimates == 1 ? "" : "s",
+                (unsigned long long)engine->total_blocks, engine->config.fft_size);
+        if (estimates == 0) fprintf(stderr, "Warning: inputs too short for one block\n");
+    }
+
+    if (out && out != stdout) fclose(out);
+    gcc_phat_destroy(engine);
+    for (uint32_t r = 0; r < a.num_inputs; r++) {
+        if (rx[r].opened) iq_reader_close(&rx[r].reader);
+        free(rx[r].buffer);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/*
+ * IQ Lab - iqtune: Measure the Fastest FFT Plans for This Machine
+ *
+ * Purpose: Write the FFT wisdom file the other tools load at startup
+ *
+ *
+ * For each requested size and precision this tool times every FFT
+ * schedule that can transform the size with every kernel family the CPU
+ * runs (fft_tune.h) and keeps the fastest. The results are merged into the
+ * wisdom file, replacing older entries for the same size and precision.
+ * Any tool started with IQLAB_FFT_WISDOM pointing at the file builds its
+ * plans from it, with no measuring at startup.
+ *
+ * Key Features:
+ * - Default sizes: powers of two 8..65536, the range the tools use
+ * - Any size up to FFT_MAX_SIZE, including mixed-radix and prime sizes
+ * - Table of the fixed-rules choice against the measured winner
+ *
+ * Usage Examples:
+ *   # Tune the default sizes, both precisions
+ *   iqtune.exe --out ~/.iqlab_fft_wisdom
+ *   IQLAB_FFT_WISDOM=~/.iqlab_fft_wisdom iqdetect.exe --in capture.iq ...
+ *
+ *   # Only the sizes a pipeline uses, single precision
+ *   iqtune.exe --sizes 1000,2048,4096 --precision f32 --out wisdom.txt
+ *
+ * Output (stdout, one row per size and precision):
+ *   size precision default(ns) best plan(ns) speedup
+ *
+ * Dependencies: IQ core (FFT engine, profile clock)
+ * Thread Safety: Single-threaded; run on an otherwise idle machine
+ * Error Handling: Parameter validation, unwritable wisdom file refused
+ */
+
+#include "../src/iq_core/fft.h"
+#include "../src/iq_core/fft_tune.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IQTUNE_MAX_SIZES 64
+
+typedef struct {
+    uint32_t sizes[IQTUNE_MAX_SIZES];
+    uint32_t num_sizes;
+    bool f64;
+    bool f32;
+    const char *out_path;    // Default: $IQLAB_FFT_WISDOM
+} args_t;
+
+static void usage(void) {
+    printf("Usage: iqtune [--sizes <N,N,...>] [--precision f32|f64|both] [--out <wisdom file>]\n");
+    printf("       --sizes defaults to the powers of two 8..65536 (up to %d sizes, each 2..%u)\n",
+           IQTUNE_MAX_SIZES, FFT_MAX_SIZE);
+    printf("       --out defaults to $%s; an existing file is merged\n", FFT_WISDOM_ENV);
+}
+
+static int parse_sizes(const char *text, args_t *a) {
+    const char *c = text;
+    while (*c) {
+        char *end = NULL;
+        unsigned long size = strtoul(c, &end, 10);
+        if (end == c || size < 2 || size > FFT_MAX_SIZE || a->num_sizes == IQTUNE_MAX_SIZES) return 0;
+        a->sizes[a->num_sizes++] = (uint32_t)size;
+        c = end;
+        if (*c == ',') c++;
+        else if (*c) return 0;
+    }
+    return a->num_sizes > 0;
+}
+
+static int parse_args(int argc, char **argv, args_t *a) {
+    memset(a, 0, sizeof(*a));
+    a->f64 = a->f32 = true;
+    a->out_path = getenv(FFT_WISDOM_ENV);
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--sizes") && i+1<argc) {
+            if (!parse_sizes(argv[++i], a)) { usage(); return 0; }
+        }
+        else if (!strcmp(argv[i], "--precision") && i+1<argc) {
+            const char *p = argv[++i];
+            a->f64 = !strcmp(p, "f64") || !strcmp(p, "both");
+            a->f32 = !strcmp(p, "f32") || !strcmp(p, "both");
+            if (!a->f64 && !a->f32) { usage(); return 0; }
+        }
+        else if (!strcmp(argv[i], "--out") && i+1<argc) a->out_path = argv[++i];
+        else { usage(); return 0; }
+    }
+
+    if (!a->out_path || !a->out_path[0]) {
+        usage();
+        return 0;
+    }
+    if (a->num_sizes == 0) {
+        for (uint32_t size = 8; size <= 65536; size *= 2) a->sizes[a->num_sizes++] = size;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    args_t args;
+    if (!parse_args(argc, argv, &args)) {
+        return EXIT_FAILURE;
+    }
+
+    // Keep entries for sizes not tuned now (a missing file is fine)
+    fft_wisdom_load(args.out_path);
+
+    printf("%8s %4s %12s %26s %8s\n", "size", "prec", "default(ns)", "best plan(ns)", "speedup");
+    for (int p = 0; p < 2; p++) {
+        fft_precision_t precision = p ? FFT_PRECISION_F32 : FFT_PRECISION_F64;
+        if ((precision == FFT_PRECISION_F64 && !args.f64) || (precision == FFT_PRECISION_F32 && !args.f32)) {
+            continue;
+        }
+        for (uint32_t i = 0; i < args.num_sizes; i++) {
+            fft_tune_result_t result;
+            if (!fft_tune(args.sizes[i], precision, &result)) {
+                fprintf(stderr, "Tuning size %u failed\n", args.sizes[i]);
+                return EXIT_FAILURE;
+            }
+
+            char plan[40];
+            snprintf(plan, sizeof(plan), "%s/%s %.0f", fft_algorithm_name(result.best.algorithm),
+                     fft_simd_name(result.best.simd), result.best.ns);
+            printf("%8u %4s %12.0f %26s %7.2fx\n", args.sizes[i], p ? "f32" : "f64", result.default_ns,
+                   plan, result.default_ns > 0.0 ? result.default_ns / result.best.ns : 1.0);
+        }
+    }
+
+    if (!fft_wisdom_save(args.out_path)) {
+        fprintf(stderr, "Cannot write %s\n", args.out_path);
+        return EXIT_FAILURE;
+    }
+    printf("Wisdom written to %s\n", args.out_path);
+    return EXIT_SUCCESS;
+}